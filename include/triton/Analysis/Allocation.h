@@ -23,6 +23,11 @@ getScratchConfigForCvtLayout(triton::gpu::ConvertLayoutOp op, unsigned &inVec,
                              unsigned &outVec);
 SmallVector<unsigned> getRepShapeForCvtLayout(triton::gpu::ConvertLayoutOp op);
 
+/// Returns the orders in which the source and the destination of a layout
+/// conversion between `srcLayout` and `dstLayout` access the scratch buffer.
+std::pair<SmallVector<unsigned>, SmallVector<unsigned>>
+getCvtOrder(Attribute srcLayout, Attribute dstLayout);
+
 } // namespace triton
 
 /// Modified from llvm-15.0: llvm/ADT/AddressRanges.h
@@ -135,6 +140,15 @@ public:
   /// Returns the size of total shared memory allocated
   size_t getSharedMemorySize() const { return sharedMemorySize; }
 
+  /// Returns the alignment the base of this allocation needs, i.e. the
+  /// largest alignment of its buffers.
+  size_t getAlignment() const {
+    size_t alignment = 1;
+    for (auto &bufferIter : bufferSet)
+      alignment = std::max(alignment, bufferIter.second.alignment);
+    return alignment;
+  }
+
 private:
   /// A class that represents a shared memory buffer
   struct BufferT {
@@ -22,6 +22,8 @@ namespace mlir {
 class AxisInfo {
 public:
   typedef SmallVector<int64_t> DimVectorT;
+  /// Inclusive bounds [min, max] of a set of signed integers
+  typedef std::pair<int64_t, int64_t> RangeT;
 
 public:
   /// Default constructor
@@ -31,10 +33,11 @@ public:
            DimVectorT knownConstancy)
       : AxisInfo(knownContiguity, knownDivisibility, knownConstancy, {}) {}
   AxisInfo(DimVectorT knownContiguity, DimVectorT knownDivisibility,
-           DimVectorT knownConstancy, std::optional<int64_t> knownConstantValue)
+           DimVectorT knownConstancy, std::optional<int64_t> knownConstantValue,
+           std::optional<RangeT> knownRange = std::nullopt)
       : contiguity(knownContiguity), divisibility(knownDivisibility),
         constancy(knownConstancy), constantValue(knownConstantValue),
-        rank(contiguity.size()) {
+        range(knownRange), rank(contiguity.size()) {
     assert(knownContiguity.size() == static_cast<size_t>(rank));
     assert(knownDivisibility.size() == static_cast<size_t>(rank));
     assert(knownConstancy.size() == static_cast<size_t>(rank));
@@ -54,6 +57,8 @@ public:
 
   std::optional<int64_t> getConstantValue() const { return constantValue; }
 
+  std::optional<RangeT> getRange() const { return range; }
+
   template <class T>
   static void
   initPessimisticStateFromFunc(int argNumber, T funcOp, DimVectorT *contiguity,
@@ -63,7 +68,8 @@ public:
     return (contiguity == other.contiguity) &&
            (divisibility == other.divisibility) &&
            (constancy == other.constancy) &&
-           (constantValue == other.constantValue) && (rank == other.rank);
+           (constantValue == other.constantValue) && (range == other.range) &&
+           (rank == other.rank);
   }
 
   /// The pessimistic value state of the contiguity is unknown.
@@ -75,6 +81,12 @@ public:
   /// The gcd of both arguments for each dimension
   static AxisInfo join(const AxisInfo &lhs, const AxisInfo &rhs);
 
+  /// Returns `range` if it fits in the signed integer type `type` (or its
+  /// element type), and std::nullopt otherwise, e.g. if the computation of
+  /// the range may have overflowed.
+  static std::optional<RangeT> fitRange(Type type,
+                                        std::optional<RangeT> range);
+
   void print(raw_ostream &os) const {
     auto print = [&](StringRef name, DimVectorT vec) {
       os << name << " = [";
@@ -89,6 +101,11 @@ public:
       os << *constantValue;
     else
       os << "<none>";
+    os << ", range = ";
+    if (range)
+      os << "[" << range->first << ", " << range->second << "]";
+    else
+      os << "<none>";
   }
 
 private:
@@ -153,6 +170,17 @@ private:
   /// The constant value of the lattice if we can infer it.
   std::optional<int64_t> constantValue;
 
+  /// The _range_ information bounds the values of
+  /// all the elements, as signed integers of the
+  /// type of the lattice. It is used to prove
+  /// comparisons, such as masks, always true or
+  /// always false.
+  /// For example
+  /// [8, 9, 10, 11]
+  /// [16, 17, 18, 19]
+  /// would have range [8, 19]
+  std::optional<RangeT> range;
+
   // number of dimensions of the lattice
   int rank{};
 };
@@ -215,6 +243,7 @@ public:
     AxisInfo::DimVectorT divisibility;
     AxisInfo::DimVectorT constancy;
     auto constantValue = getConstantValue(op, lhsInfo, rhsInfo);
+    auto range = getRange(op, lhsInfo, rhsInfo);
     for (auto d = 0; d < rank; ++d) {
       if (constantValue.has_value()) {
         contiguity.push_back(1);
@@ -227,7 +256,8 @@ public:
         divisibility.push_back(getDivisibility(op, lhsInfo, rhsInfo, d));
       }
     }
-    return AxisInfo(contiguity, divisibility, constancy, constantValue);
+    return AxisInfo(contiguity, divisibility, constancy, constantValue,
+                    AxisInfo::fitRange(op->getResultTypes()[0], range));
   }
 
 protected:
@@ -250,6 +280,11 @@ protected:
                                                   const AxisInfo &rhs) {
     return {};
   }
+
+  virtual std::optional<AxisInfo::RangeT>
+  getRange(OpTy op, const AxisInfo &lhs, const AxisInfo &rhs) {
+    return {};
+  }
 };
 
 class AxisInfoVisitorList {
@@ -313,8 +348,12 @@ public:
 /// do not have recursive functions.
 /// Since each function will be called multiple times, we need to
 /// calculate the axis info based on the axis info of all the callers.
-/// In the future, we can perform optimization using function cloning so that
-/// each call site will have unique axis info.
+/// The `triton-specialize-calls` pass clones `noinline` functions so that each
+/// call site gets unique axis info.
+///
+/// It can be cached by the pass manager through `Pass::getAnalysis`. Passes
+/// that rewrite some functions only can recompute them and preserve it, so
+/// the next passes don't run the whole analysis again.
 using AxisInfoMapT = DenseMap<Value, AxisInfo>;
 class ModuleAxisInfoAnalysis : public CallGraph<AxisInfoMapT> {
 public:
@@ -343,6 +382,14 @@ public:
     }
   }
 
+  explicit ModuleAxisInfoAnalysis(Operation *op)
+      : ModuleAxisInfoAnalysis(cast<ModuleOp>(op)) {}
+
+  /// Recomputes the axis info of the values of `funcOp` only. This is valid
+  /// only if the rewrite that made it stale didn't change the axis info of the
+  /// operands of its calls, which are propagated into their callees.
+  void recompute(FunctionOpInterface funcOp);
+
   AxisInfo *getAxisInfo(Value value) {
     auto funcOp =
         value.getParentRegion()->getParentOfType<FunctionOpInterface>();
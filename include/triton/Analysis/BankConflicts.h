@@ -0,0 +1,39 @@
+#ifndef TRITON_ANALYSIS_BANKCONFLICTS_H
+#define TRITON_ANALYSIS_BANKCONFLICTS_H
+
+#include "triton/Dialect/TritonGPU/IR/Dialect.h"
+#include <optional>
+
+namespace mlir {
+
+/// The shared memory accesses of a warp storing or loading a tensor.
+struct SharedAccessCost {
+  /// Wavefronts the accesses take. A wavefront serves one aligned 4-byte word
+  /// in each of the 32 banks, the lanes reading the same word share it.
+  unsigned wavefronts = 0;
+  /// Wavefronts taken past the first of each access by bank conflicts.
+  unsigned conflicts = 0;
+};
+
+/// Returns the cost of a warp storing or loading the distributed tensor
+/// `type` to or from shared memory with the layout `sharedEnc`, vectorized as
+/// the lowering of the conversions between them does. Returns std::nullopt if
+/// the layout of `type` has no linear layout.
+std::optional<SharedAccessCost>
+getSharedAccessCost(RankedTensorType type,
+                    triton::gpu::SharedEncodingAttr sharedEnc);
+
+/// Returns the shared layout of `order` that takes the fewest wavefronts to
+/// store the tensor from `writerType` and to load it in each of
+/// `readerTypes`, among the vector widths and swizzles that stay within a row
+/// of the tensor. The smallest swizzle is kept between equal costs. Returns
+/// null if one of the types can't be modeled.
+triton::gpu::SharedEncodingAttr
+chooseSharedEncoding(RankedTensorType writerType,
+                     ArrayRef<RankedTensorType> readerTypes,
+                     ArrayRef<unsigned> order,
+                     triton::gpu::CTALayoutAttr CTALayout);
+
+} // namespace mlir
+
+#endif // TRITON_ANALYSIS_BANKCONFLICTS_H
@@ -0,0 +1,103 @@
+#ifndef TRITON_ANALYSIS_COSTMODEL_H
+#define TRITON_ANALYSIS_COSTMODEL_H
+
+#include "mlir/Dialect/SCF/IR/SCF.h"
+#include "triton/Analysis/Allocation.h"
+#include "triton/Analysis/AxisInfo.h"
+#include "triton/Analysis/Utility.h"
+#include "triton/Dialect/TritonGPU/IR/Dialect.h"
+
+namespace mlir {
+
+/// The cost of a layout conversion through shared memory.
+struct ConvertLayoutCost {
+  /// Bytes written to and read from shared memory
+  int64_t sharedBytes = 0;
+  /// Shared memory wavefronts per warp access over the conflict-free number,
+  /// the worst of the stores and of the loads. It is 1 when the layouts aren't
+  /// modelled.
+  unsigned bankConflicts = 1;
+};
+
+/// Static estimates of the cost of one CTA of a TTGIR kernel, used to rank
+/// configs and layouts without running them. Operations in loops are counted
+/// once per iteration when the trip count is constant, and once otherwise.
+struct KernelCost {
+  /// Bytes loaded from and stored to global memory
+  int64_t globalLoadBytes = 0;
+  int64_t globalStoreBytes = 0;
+  /// Number of vector accesses of the global loads and stores, summed over the
+  /// threads of the CTA, given the vector widths proven by AxisInfo
+  int64_t globalLoadAccesses = 0;
+  int64_t globalStoreAccesses = 0;
+  /// Bytes written to and read from shared memory
+  int64_t sharedBytes = 0;
+  /// The worst bank conflict factor of the layout conversions
+  unsigned maxBankConflicts = 1;
+  /// Number of MMA instructions, and of floating point operations of dots
+  int64_t mmaCount = 0;
+  int64_t dotFlops = 0;
+  /// Number of barriers, including the ones the shared memory accesses of
+  /// scratch buffers will need
+  int64_t barrierCount = 0;
+  /// Whether some loops have a trip count that isn't known at compile time
+  bool hasDynamicLoops = false;
+  /// Estimate of the number of instructions the lowering to LLVM emits, which
+  /// unrolls each op over the elements of the threads: one per 32-bit
+  /// register of its results (see `getNumRegisters`). It is a code size, so
+  /// ops in loops are counted once, and the callees once per call.
+  int64_t llvmSize = 0;
+
+  /// Adds the cost of `other` run `count` times.
+  void add(const KernelCost &other, int64_t count);
+};
+
+/// Returns the number of iterations of `forOp`, or nothing if its bounds or
+/// its step aren't constant.
+std::optional<int64_t> getTripCount(scf::ForOp forOp);
+
+/// Returns an estimate of the number of CTAs that can be resident on an SM,
+/// as limited by shared memory and threads. Register usage isn't known before
+/// code generation, so it is not taken into account.
+int estimateOccupancy(int computeCapability, int numWarps, int threadsPerWarp,
+                      size_t sharedMemory);
+
+/// Module level cost model, based on the call graph: the cost of a function
+/// includes that of the functions it calls.
+class ModuleCostAnalysis : public CallGraph<KernelCost> {
+public:
+  explicit ModuleCostAnalysis(ModuleOp moduleOp);
+
+  KernelCost *getCost(FunctionOpInterface funcOp) {
+    return getFuncData(funcOp);
+  }
+
+  /// Returns the cost of `op`, or nothing if it doesn't go through shared
+  /// memory.
+  std::optional<ConvertLayoutCost>
+  getConvertLayoutCost(triton::gpu::ConvertLayoutOp op) const {
+    auto it = convertLayoutCosts.find(op);
+    if (it == convertLayoutCosts.end())
+      return std::nullopt;
+    return it->second;
+  }
+
+  /// Returns the shared memory used by the kernel, including its callees.
+  size_t getSharedMemorySize() { return allocation.getSharedMemorySize(); }
+
+  /// Returns the estimated occupancy of the kernel, see `estimateOccupancy`,
+  /// on the compute capability of the module (8.0 if it has none).
+  int getOccupancy();
+
+private:
+  void accumulate(Block *block, int64_t count, KernelCost &cost);
+  void accumulate(Operation *op, int64_t count, KernelCost &cost);
+
+  ModuleAxisInfoAnalysis axisInfoAnalysis;
+  ModuleAllocation allocation;
+  DenseMap<Operation *, ConvertLayoutCost> convertLayoutCosts;
+};
+
+} // namespace mlir
+
+#endif // TRITON_ANALYSIS_COSTMODEL_H
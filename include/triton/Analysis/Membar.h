@@ -10,12 +10,71 @@ namespace mlir {
 
 class OpBuilder;
 
+/// The number of warps that have to synchronize together before a shared
+/// memory access: they are consecutive and start at a multiple of it, which is
+/// a power of two. 1 means a warp-level barrier.
+using BarrierWarps = unsigned;
+/// The access doesn't depend on a previous one, or only on accesses of the
+/// same thread to the same addresses.
+constexpr BarrierWarps kNoBarrier = 0;
+/// A CTA-wide barrier is needed.
+constexpr BarrierWarps kCTABarrier = std::numeric_limits<unsigned>::max();
+
+/// Which thread accesses each address of a shared memory access: the accessing
+/// op reads or writes the shared memory tensor of type `type` in the
+/// distributed `layout`, each thread accessing the elements it owns. A null
+/// layout means the access may touch any address from any thread.
+struct AccessOwnership {
+  Type type;
+  Attribute layout;
+
+  bool operator==(const AccessOwnership &other) const {
+    return type == other.type && layout == other.layout;
+  }
+
+  bool operator<(const AccessOwnership &other) const {
+    return std::make_pair(type.getAsOpaquePointer(),
+                          layout.getAsOpaquePointer()) <
+           std::make_pair(other.type.getAsOpaquePointer(),
+                          other.layout.getAsOpaquePointer());
+  }
+};
+
 struct BlockInfo {
+  enum class AsyncCopy { None, Untracked, Tracked };
+
+  /// A shared memory access that hasn't been synced by a CTA-wide barrier.
+  struct Access {
+    Interval<size_t> interval;
+    AccessOwnership owner;
+    /// The largest groups of warps that synchronized after the access, or
+    /// kNoBarrier.
+    BarrierWarps syncedWarps = kNoBarrier;
+    /// Whether the access is the write of an async copy, and if so whether
+    /// an mbarrier tracks its completion.
+    AsyncCopy asyncCopy = AsyncCopy::None;
+
+    bool operator==(const Access &other) const {
+      return interval == other.interval && owner == other.owner &&
+             syncedWarps == other.syncedWarps && asyncCopy == other.asyncCopy;
+    }
+
+    bool operator<(const Access &other) const {
+      if (interval != other.interval)
+        return interval < other.interval;
+      if (!(owner == other.owner))
+        return owner < other.owner;
+      if (syncedWarps != other.syncedWarps)
+        return syncedWarps < other.syncedWarps;
+      return asyncCopy < other.asyncCopy;
+    }
+  };
+
   using BufferIdSetT = Allocation::BufferIdSetT;
-  using IntervalSetT = std::set<Interval<size_t>>;
+  using AccessSetT = std::set<Access>;
 
-  IntervalSetT syncReadIntervals;
-  IntervalSetT syncWriteIntervals;
+  AccessSetT syncReadIntervals;
+  AccessSetT syncWriteIntervals;
 
   BlockInfo() = default;
 
@@ -28,13 +87,13 @@ struct BlockInfo {
     return *this;
   }
 
+  /// Returns the barrier needed before the accesses of `other`, if they
+  /// follow the accesses of this BlockInfo object.
+  BarrierWarps getBarrierWarps(const BlockInfo &other) const;
+
   /// Returns true if intervals in two BlockInfo objects are intersected.
   bool isIntersected(const BlockInfo &other) const {
-    return /*RAW*/ isIntersected(syncWriteIntervals, other.syncReadIntervals) ||
-           /*WAR*/
-           isIntersected(syncReadIntervals, other.syncWriteIntervals) ||
-           /*WAW*/
-           isIntersected(syncWriteIntervals, other.syncWriteIntervals);
+    return getBarrierWarps(other) != kNoBarrier;
   }
 
   /// Clears the intervals because a barrier is inserted.
@@ -43,6 +102,45 @@ struct BlockInfo {
     syncWriteIntervals.clear();
   }
 
+  /// Marks the accesses as synced within each group of `warps` warps because
+  /// a barrier over these groups is inserted.
+  void sync(BarrierWarps warps) {
+    syncReadIntervals = synced(syncReadIntervals, warps);
+    syncWriteIntervals = synced(syncWriteIntervals, warps);
+  }
+
+  /// Marks the writes of the async copies issued so far as tracked, because
+  /// their threads arrive on an mbarrier once they complete.
+  void trackAsyncCopies() {
+    AccessSetT result;
+    for (auto access : syncWriteIntervals) {
+      if (access.asyncCopy == AsyncCopy::Untracked)
+        access.asyncCopy = AsyncCopy::Tracked;
+      result.insert(access);
+    }
+    syncWriteIntervals = std::move(result);
+  }
+
+  /// Drops the tracked writes of async copies because an mbarrier is waited
+  /// on. The copies are only read once the mbarrier they arrive on is waited
+  /// on, which makes them visible to the waiting threads.
+  void syncTrackedAsyncCopies() {
+    for (auto it = syncWriteIntervals.begin();
+         it != syncWriteIntervals.end();) {
+      if (it->asyncCopy == AsyncCopy::Tracked)
+        it = syncWriteIntervals.erase(it);
+      else
+        ++it;
+    }
+  }
+
+  /// Forgets which threads made the accesses, e.g. once the offsets of a
+  /// callee's accesses aren't the caller's.
+  void eraseOwnership() {
+    syncReadIntervals = withoutOwnership(syncReadIntervals);
+    syncWriteIntervals = withoutOwnership(syncWriteIntervals);
+  }
+
   /// Compares two BlockInfo objects.
   bool operator==(const BlockInfo &other) const {
     return syncReadIntervals == other.syncReadIntervals &&
@@ -52,13 +150,23 @@ struct BlockInfo {
   bool operator!=(const BlockInfo &other) const { return !(*this == other); }
 
 private:
-  bool isIntersected(const IntervalSetT &lhsIntervalSet,
-                     const IntervalSetT &rhsIntervalSet) const {
-    for (auto &lhs : lhsIntervalSet)
-      for (auto &rhs : rhsIntervalSet)
-        if (lhs.intersects(rhs))
-          return true;
-    return false;
+  static BarrierWarps getBarrierWarps(const AccessSetT &lhsAccessSet,
+                                      const AccessSetT &rhsAccessSet);
+
+  static AccessSetT synced(const AccessSetT &accessSet, BarrierWarps warps) {
+    AccessSetT result;
+    for (auto access : accessSet) {
+      access.syncedWarps = std::max(access.syncedWarps, warps);
+      result.insert(access);
+    }
+    return result;
+  }
+
+  static AccessSetT withoutOwnership(const AccessSetT &accessSet) {
+    AccessSetT result;
+    for (auto &access : accessSet)
+      result.insert({access.interval, {}, kNoBarrier, access.asyncCopy});
+    return result;
   }
 };
 
@@ -77,12 +185,22 @@ public:
   /// The following circumstances do not require a barrier:
   /// - WAW: not possible because overlapped memory allocation is not allowed.
   /// - RAR: no write is performed.
+  /// Blocked layouts converted to and from shared memory are accessed by the
+  /// threads owning their elements, so two such accesses to the same tensor
+  /// need no barrier if they use the same layout and it doesn't replicate
+  /// elements (each thread only reads its own writes), and only a warp-level
+  /// one if their layouts map each element to the same warp. Likewise, if
+  /// each element belongs to the same group of warps in both layouts, only
+  /// the warps of each group synchronize, with one named barrier per group;
+  /// this is only done if `useNamedBarriers` is set, and not in warp
+  /// specialized kernels, which use named barriers of their own.
   /// Temporary storage of operations such as Reduce are considered as both
   /// a shared memory read. If the temporary storage is written but not read,
   /// it is considered as the problem of the operation itself but not the membar
   /// analysis.
   MembarAnalysis() = default;
-  explicit MembarAnalysis(Allocation *allocation) : allocation(allocation) {}
+  explicit MembarAnalysis(Allocation *allocation, bool useNamedBarriers = false)
+      : allocation(allocation), useNamedBarriers(useNamedBarriers) {}
 
   /// Runs the membar analysis to the given operation, inserts a barrier if
   /// necessary.
@@ -113,10 +231,18 @@ private:
   /// Collects the successors of the terminator
   void visitTerminator(Operation *operation, SmallVector<Block *> &successors);
 
-  void insertBarrier(Operation *operation, OpBuilder *builder);
+  /// Returns which thread accesses each address when `operation` reads or
+  /// writes the shared memory tensor `value`.
+  AccessOwnership getOwnership(Operation *operation, Value value);
+
+  /// Inserts a barrier over groups of `warps` warps, or over the CTA if that
+  /// isn't possible, and returns the warps it synchronizes.
+  BarrierWarps insertBarrier(Operation *operation, OpBuilder *builder,
+                             BarrierWarps warps = kCTABarrier);
 
 private:
   Allocation *allocation = nullptr;
+  bool useNamedBarriers = false;
 };
 
 /// Postorder traversal on the callgraph to insert membar instructions
@@ -126,9 +252,11 @@ private:
 /// before and after function calls, but might be a bit conservative.
 class ModuleMembarAnalysis : public CallGraph<BlockInfo> {
 public:
-  ModuleMembarAnalysis(ModuleAllocation *moduleAllocation)
+  ModuleMembarAnalysis(ModuleAllocation *moduleAllocation,
+                       bool useNamedBarriers = false)
       : CallGraph<BlockInfo>(moduleAllocation->getModuleOp()),
-        moduleAllocation(moduleAllocation) {}
+        moduleAllocation(moduleAllocation),
+        useNamedBarriers(useNamedBarriers) {}
 
   void run() {
     walk<WalkOrder::PreOrder, WalkOrder::PostOrder>(
@@ -139,7 +267,7 @@ public:
           auto *allocation = moduleAllocation->getFuncData(funcOp);
           auto [it, inserted] = funcMap.try_emplace(funcOp, BlockInfo());
           if (inserted) {
-            MembarAnalysis analysis(allocation);
+            MembarAnalysis analysis(allocation, useNamedBarriers);
             analysis.run(funcMap);
           }
         });
@@ -147,6 +275,7 @@ public:
 
 private:
   ModuleAllocation *moduleAllocation;
+  bool useNamedBarriers;
 };
 
 } // namespace mlir
@@ -0,0 +1,47 @@
+#ifndef TRITON_ANALYSIS_REGISTERPRESSURE_H
+#define TRITON_ANALYSIS_REGISTERPRESSURE_H
+
+#include "mlir/IR/Operation.h"
+#include "llvm/ADT/DenseMap.h"
+
+namespace mlir {
+
+/// The number of 32-bit registers a thread can use on NVIDIA GPUs. Kernels
+/// needing more spill to local memory.
+constexpr unsigned kMaxRegistersPerThread = 255;
+
+/// Returns an estimate of the number of 32-bit registers a thread needs to
+/// hold a value of `type`: the elements it owns for distributed tensors, the
+/// base address for shared memory tensors. Elements narrower than 32 bits are
+/// packed, and only the first pointer of each contiguous vector is counted,
+/// as the others are folded into the addressing of the vector access.
+unsigned getNumRegisters(Type type);
+
+/// Estimates the registers used by each thread along a TTGIR function, from
+/// the liveness of its values. This is a lower bound of what code generation
+/// will need: temporaries of the lowering of each op aren't known at this
+/// level. Constants aren't counted, they are immediates or get rematerialized.
+class RegisterPressureAnalysis {
+public:
+  /// Analyzes the function `funcOp`.
+  explicit RegisterPressureAnalysis(Operation *funcOp);
+
+  /// Returns the registers holding the values live at `op`, including the
+  /// ones live across the ops it is nested in.
+  unsigned getRegisters(Operation *op) const { return pressure.lookup(op); }
+
+  /// Returns the largest number of registers live at `op` or at an operation
+  /// nested in it.
+  unsigned getMaxRegisters(Operation *op) const;
+
+  /// Returns the largest number of registers live in the function.
+  unsigned getMaxRegisters() const { return maxPressure; }
+
+private:
+  llvm::DenseMap<Operation *, unsigned> pressure;
+  unsigned maxPressure = 0;
+};
+
+} // namespace mlir
+
+#endif // TRITON_ANALYSIS_REGISTERPRESSURE_H
@@ -5,6 +5,7 @@
 #include "mlir/Analysis/SliceAnalysis.h"
 #include "triton/Dialect/Triton/IR/Dialect.h"
 #include "triton/Dialect/TritonGPU/IR/Dialect.h"
+#include "triton/Tools/LinearLayout.h"
 #include <algorithm>
 #include <numeric>
 #include <string>
@@ -62,6 +63,9 @@ public:
 
   bool isReduceWithinCTA();
 
+  // The number of CTAs of the cluster the reduction axis is split between.
+  unsigned getCTASplitNumOnReductionAxis();
+
   unsigned getAxis() { return axis; }
 
 private:
@@ -111,6 +115,9 @@ public:
   unsigned getAxisNumBlocks();
   // Return the number of blocks along non axis dim.
   unsigned getNonAxisNumBlocks();
+  // Return true if the blocks along axis dim are scanned one at a time,
+  // reusing the scratch space.
+  bool isChunked();
   // Return the size of the scratch space needed for scan lowering.
   unsigned getScratchSizeInBytes();
   // Return the number of elements of the scratch space needed for scan
@@ -140,6 +147,43 @@ private:
   SmallVector<Type> srcElementTypes;
 };
 
+// Helper for the lowering of sorts to bitonic networks. The elements two
+// steps of the network compare are `distance` apart along the axis, they are
+// exchanged within the registers of a thread, with shuffles across the lanes
+// of a warp, or through shared memory across warps.
+class SortLoweringHelper {
+public:
+  explicit SortLoweringHelper(triton::SortOp op) : sortOp(op) {
+    srcTy = op.getSrc().getType().cast<RankedTensorType>();
+  }
+  // Return true if the lowering of the sort op is supported.
+  bool isSupported();
+  // Return the number of contiguous elements per thread along axis dim.
+  unsigned getAxisSizePerThread();
+  // Return the number of threads per warp along axis dim.
+  unsigned getAxisNumThreadsPerWarp();
+  // Return the number of warps per CTA along axis dim.
+  unsigned getAxisNumWarps();
+  // Stride between contiguous threads along axis dim in the lane id.
+  unsigned getAxisLaneStride();
+  // Return true if elements `distance` apart along axis dim are owned by
+  // different lanes of the same warp.
+  bool isAcrossLanes(unsigned distance);
+  // Return true if elements `distance` apart along axis dim are owned by
+  // different warps.
+  bool isAcrossWarps(unsigned distance);
+  // Return the size of the scratch space needed for sort lowering.
+  unsigned getScratchSizeInBytes();
+
+  unsigned getAxis() { return sortOp.getAxis(); }
+  unsigned getAxisSize() { return srcTy.getDimSize(getAxis()); }
+  triton::gpu::BlockedEncodingAttr getEncoding();
+
+private:
+  triton::SortOp sortOp;
+  RankedTensorType srcTy;
+};
+
 bool maybeSharedAllocationOp(Operation *op);
 
 bool maybeAliasOp(Operation *op);
@@ -158,6 +202,26 @@ bool isMmaToDotShortcut(RankedTensorType srcTy, RankedTensorType dstTy);
 
 bool isMmaToMmaShortcut(RankedTensorType srcTy, RankedTensorType dstTy);
 
+// Return the number of sub-histograms `op` privatizes in shared memory, one
+// per warp unless they don't fit, or 0 if its warps count their bins with
+// ballots, which needs a power of two number of bins.
+unsigned getNumPrivatizedHistograms(triton::HistogramOp op);
+
+unsigned getHistogramScratchSizeInBytes(triton::HistogramOp op);
+
+// Return how to lower `op` with selects and shuffles within the warps, if the
+// linear layouts of its source and indices allow it.
+std::optional<triton::WarpLocalGather> getWarpLocalGather(triton::GatherOp op);
+
+// The gathers that aren't warp-local go through a copy of their source in
+// shared memory.
+unsigned getGatherScratchSizeInBytes(triton::GatherOp op);
+
+// Return how to convert between the distributed layouts of srcTy and dstTy
+// without leaving the warps, if their linear layouts allow it.
+std::optional<triton::WarpLocalConversion>
+getWarpLocalConversion(RankedTensorType srcTy, RankedTensorType dstTy);
+
 // Return true if the src and dst layout match.
 bool matchMmaV3AndDotOperandLayout(RankedTensorType srcTy,
                                    RankedTensorType dstTy);
@@ -1,6 +1,7 @@
 #ifndef TRITON_CONVERSION_NVGPU_TO_LLVM_PASS_H
 #define TRITON_CONVERSION_NVGPU_TO_LLVM_PASS_H
 
+#include <cstdint>
 #include <memory>
 
 namespace mlir {
@@ -11,6 +12,9 @@ template <typename T> class OperationPass;
 namespace triton {
 
 std::unique_ptr<OperationPass<ModuleOp>> createConvertNVGPUToLLVMPass();
+std::unique_ptr<OperationPass<ModuleOp>>
+createConvertNVGPUToLLVMPass(int32_t mbarrierSuspendTime,
+                             int32_t mbarrierBackoff);
 
 } // namespace triton
 
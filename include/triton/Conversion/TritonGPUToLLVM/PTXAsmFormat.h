@@ -5,6 +5,7 @@
 #include "triton/Dialect/Triton/IR/Dialect.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/StringRef.h"
+#include "llvm/Support/Allocator.h"
 #include <memory>
 #include <string>
 
@@ -73,7 +74,8 @@ struct PTXInstrExecution;
 // example, the PtxIOInstr for ld and st instructions.
 struct PTXBuilder {
   struct Operand {
-    std::string constraint;
+    // Interned, see `PTXBuilder::internConstraint`.
+    StringRef constraint;
     Value value;
     int idx{-1};
     llvm::SmallVector<Operand *> list;
@@ -178,10 +180,15 @@ struct PTXBuilder {
 
 private:
   Operand *newOperand() {
-    argArchive.emplace_back(std::make_unique<Operand>());
-    return argArchive.back().get();
+    argArchive.push_back(new (operandAllocator.Allocate()) Operand());
+    return argArchive.back();
   }
 
+  // Returns a copy of \param constraint that lives as long as the process.
+  // Kernels use a handful of distinct constraints, so they are interned
+  // rather than copied into each of their operands.
+  static StringRef internConstraint(StringRef constraint);
+
   void initOperand(Operand *opr);
 
   // Make the operands in argArchive follow the provided \param order.
@@ -190,23 +197,26 @@ private:
     // The order in argArchive is unnecessary when onlyAttachMLIRArgs=false, but
     // it does necessary when onlyAttachMLIRArgs is true for the $0, $1... are
     // determined by PTX code snippet passed from external.
-    sort(argArchive.begin(), argArchive.end(),
-         [&](std::unique_ptr<Operand> &a, std::unique_ptr<Operand> &b) {
-           auto ida = std::find(order.begin(), order.end(), a.get());
-           auto idb = std::find(order.begin(), order.end(), b.get());
-           assert(ida != order.end());
-           assert(idb != order.end());
-           return ida < idb;
-         });
+    sort(argArchive.begin(), argArchive.end(), [&](Operand *a, Operand *b) {
+      auto ida = std::find(order.begin(), order.end(), a);
+      auto idb = std::find(order.begin(), order.end(), b);
+      assert(ida != order.end());
+      assert(idb != order.end());
+      return ida < idb;
+    });
   }
 
   friend struct PTXInstr;
   friend struct PTXInstrCommon;
 
 protected:
-  llvm::SmallVector<std::unique_ptr<Operand>, 6> argArchive;
+  // The operands and executions are bump-allocated, as large kernels create
+  // hundreds of thousands of them; they are destroyed with the builder.
+  llvm::SpecificBumpPtrAllocator<Operand> operandAllocator;
+  llvm::SpecificBumpPtrAllocator<PTXInstrExecution> executionAllocator;
+  llvm::SmallVector<Operand *, 6> argArchive;
   llvm::SmallVector<std::unique_ptr<PTXInstrCommon>, 2> instrs;
-  llvm::SmallVector<std::unique_ptr<PTXInstrExecution>, 4> executions;
+  llvm::SmallVector<PTXInstrExecution *, 4> executions;
   int oprCounter{};
 };
 
@@ -241,8 +251,13 @@ protected:
   PTXInstrExecution &call(llvm::ArrayRef<Operand *> oprs,
                           bool onlyAttachMLIRArgs = false);
 
+  // Returns the instruction parts joined with ".", which is computed once for
+  // all the executions of the instruction.
+  StringRef getRepr() const;
+
   PTXBuilder *builder{};
   llvm::SmallVector<std::string, 4> instrParts;
+  mutable std::string repr;
 
   friend struct PTXInstrExecution;
 };
@@ -261,8 +276,10 @@ template <class ConcreteT> struct PTXInstrBase : public PTXInstrCommon {
   // code needed. e.g. `PTXInstr("add").o("s32", isS32).o("u32", !isS32);` will
   // get a `add.s32` if isS32 is true.
   ConcreteT &o(const std::string &suffix, bool predicate = true) {
-    if (predicate)
+    if (predicate) {
       instrParts.push_back(suffix);
+      repr.clear();
+    }
     return *static_cast<ConcreteT *>(this);
   }
 };
@@ -22,7 +22,9 @@ enum Target { NVVM, ROCDL, Default = NVVM };
 std::unique_ptr<OperationPass<ModuleOp>> createConvertTritonGPUToLLVMPass();
 std::unique_ptr<OperationPass<ModuleOp>>
 createConvertTritonGPUToLLVMPass(int32_t computeCapability, Target target,
-                                 mlir::triton::gpu::TMAMetadataTy *tmaMetadata);
+                                 mlir::triton::gpu::TMAMetadataTy *tmaMetadata,
+                                 bool fastMath = false,
+                                 int32_t rolledLoops = 0);
 
 } // namespace triton
 
@@ -0,0 +1,102 @@
+#ifndef TRITON_CONVERSION_TRITON_GPU_TO_LLVM_WARP_LOCAL_CONVERSION_H_
+#define TRITON_CONVERSION_TRITON_GPU_TO_LLVM_WARP_LOCAL_CONVERSION_H_
+
+#include "mlir/Dialect/LLVMIR/LLVMDialect.h"
+#include "mlir/Transforms/DialectConversion.h"
+#include "triton/Tools/LinearLayout.h"
+#include "llvm/ADT/STLFunctionalExtras.h"
+
+#include <map>
+
+namespace mlir {
+namespace triton {
+
+/// Returns the registers of the destination of the warp-local conversion
+/// `cvt` of the registers `vals` of its source. The registers of the
+/// destination are read from the registers of the same lane when possible,
+/// and from the other lanes with warp shuffles otherwise. The registers read
+/// from the same lane share their shuffles: values of 8 and 16 bits are packed
+/// into 32-bit words before being sent.
+///
+/// The shuffles are the backend's: `getThreadId` returns the id of the thread
+/// and `shflIdxSync(val, lane)` the value `val` of lane `lane`. Both are only
+/// called when the lanes exchange values.
+inline SmallVector<Value>
+convertWithinWarp(Location loc, ConversionPatternRewriter &rewriter,
+                  ArrayRef<Value> vals, const WarpLocalConversion &cvt,
+                  llvm::function_ref<Value()> getThreadId,
+                  llvm::function_ref<Value(Value, Value)> shflIdxSync) {
+  SmallVector<Value> outVals(cvt.srcRegisters.size());
+  if (cvt.isRegisterPermutation()) {
+    for (unsigned r = 0; r < outVals.size(); ++r)
+      outVals[r] = vals[cvt.srcRegisters[r]];
+    return outVals;
+  }
+  Type i32Ty = rewriter.getIntegerType(32);
+  auto i32Val = [&](int32_t value) -> Value {
+    return rewriter.create<LLVM::ConstantOp>(
+        loc, i32Ty, rewriter.getI32IntegerAttr(value));
+  };
+  // The lane the registers are read from, before the XOR with srcLanes
+  Value laneId = rewriter.create<LLVM::URemOp>(
+      loc, getThreadId(), i32Val(1u << cvt.laneBases.size()));
+  Value srcLaneBase = i32Val(0);
+  for (unsigned i = 0; i < cvt.laneBases.size(); ++i) {
+    Value bit = rewriter.create<LLVM::AndOp>(
+        loc, rewriter.create<LLVM::LShrOp>(loc, laneId, i32Val(i)), i32Val(1));
+    srcLaneBase = rewriter.create<LLVM::XOrOp>(
+        loc, srcLaneBase,
+        rewriter.create<LLVM::MulOp>(loc, bit, i32Val(cvt.laneBases[i])));
+  }
+  bool isLaneIdentity = true;
+  for (unsigned i = 0; i < cvt.laneBases.size(); ++i)
+    isLaneIdentity &= cvt.laneBases[i] == 1u << i;
+  std::map<unsigned, SmallVector<unsigned>> regsBySrcLane;
+  for (unsigned r = 0; r < outVals.size(); ++r)
+    regsBySrcLane[cvt.srcLanes[r]].push_back(r);
+  Type type = vals[0].getType();
+  unsigned bitWidth = type.isIntOrFloat() ? type.getIntOrFloatBitWidth() : 0;
+  unsigned packing = bitWidth == 8 || bitWidth == 16 ? 32 / bitWidth : 1;
+  Type packedTy = VectorType::get(packing, type);
+  for (auto &[srcLaneOffset, regs] : regsBySrcLane) {
+    if (isLaneIdentity && srcLaneOffset == 0) {
+      for (unsigned r : regs)
+        outVals[r] = vals[cvt.srcRegisters[r]];
+      continue;
+    }
+    Value srcLane =
+        rewriter.create<LLVM::XOrOp>(loc, srcLaneBase, i32Val(srcLaneOffset));
+    for (unsigned i = 0; i < regs.size(); i += packing) {
+      unsigned numPacked = std::min<unsigned>(packing, regs.size() - i);
+      if (numPacked == 1) {
+        Value val = vals[cvt.srcRegisters[regs[i]]];
+        // Pointers are shuffled as integers
+        if (type.isa<LLVM::LLVMPointerType>())
+          val = rewriter.create<LLVM::PtrToIntOp>(
+              loc, rewriter.getIntegerType(64), val);
+        val = shflIdxSync(val, srcLane);
+        if (type.isa<LLVM::LLVMPointerType>())
+          val = rewriter.create<LLVM::IntToPtrOp>(loc, type, val);
+        outVals[regs[i]] = val;
+        continue;
+      }
+      Value packed = rewriter.create<LLVM::UndefOp>(loc, packedTy);
+      for (unsigned j = 0; j < numPacked; ++j)
+        packed = rewriter.create<LLVM::InsertElementOp>(
+            loc, packedTy, packed, vals[cvt.srcRegisters[regs[i + j]]],
+            i32Val(j));
+      Value word = shflIdxSync(
+          rewriter.create<LLVM::BitcastOp>(loc, i32Ty, packed), srcLane);
+      packed = rewriter.create<LLVM::BitcastOp>(loc, packedTy, word);
+      for (unsigned j = 0; j < numPacked; ++j)
+        outVals[regs[i + j]] = rewriter.create<LLVM::ExtractElementOp>(
+            loc, type, packed, i32Val(j));
+    }
+  }
+  return outVals;
+}
+
+} // namespace triton
+} // namespace mlir
+
+#endif
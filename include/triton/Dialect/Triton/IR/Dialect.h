@@ -57,6 +57,18 @@ public:
   virtual LogicalResult
   verifyDotOpEncodingCompatibility(Operation *op, Attribute operandEncodingA,
                                    Attribute operandEncodingB) const = 0;
+
+  // Tries to compute the encoding of the result of a join, given the encoding
+  // of its operands.
+  virtual LogicalResult
+  inferJoinOpEncoding(Attribute srcEnc, Attribute &dstEnc,
+                      std::optional<Location> loc) const = 0;
+
+  // Tries to compute the encoding of the results of a split, given the
+  // encoding of its operand.
+  virtual LogicalResult
+  inferSplitOpEncoding(Attribute srcEnc, Attribute &dstEnc,
+                       std::optional<Location> loc) const = 0;
 };
 
 } // namespace triton
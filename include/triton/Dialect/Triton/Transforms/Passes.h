@@ -12,6 +12,20 @@ std::unique_ptr<Pass> createReorderBroadcastPass();
 std::unique_ptr<Pass>
 createRewriteTensorPointerPass(int computeCapability = 80);
 
+std::unique_ptr<Pass> createSpecializeCallsPass(int maxClones = 4);
+
+std::unique_ptr<Pass> createSplitKPass(int splitK = 1);
+
+std::unique_ptr<Pass> createMakePersistentPass(int groupSize = 0,
+                                               int numXcds = 1);
+
+std::unique_ptr<Pass>
+createFuseKernelsPass(const std::string &kernelName = "fused_kernel");
+
+std::unique_ptr<Pass> createNarrowOffsetsPass(int64_t maxNumel = 0);
+
+std::unique_ptr<Pass> createStrengthReducePointersPass();
+
 } // namespace triton
 
 #define GEN_PASS_REGISTRATION
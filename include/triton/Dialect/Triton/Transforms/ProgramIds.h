@@ -0,0 +1,35 @@
+#ifndef TRITON_DIALECT_TRITON_TRANSFORMS_PROGRAMIDS_H_
+#define TRITON_DIALECT_TRITON_TRANSFORMS_PROGRAMIDS_H_
+
+#include "mlir/IR/Builders.h"
+#include "triton/Dialect/Triton/IR/Dialect.h"
+
+#include <array>
+
+// Helpers of the passes that run the body of a kernel for other programs than
+// the one it was launched as, e.g. once per tile of its grid.
+
+namespace mlir {
+namespace triton {
+
+/// Whether the body of `funcOp` can run with remapped program ids: it returns
+/// nothing and has a single block. Calls are rejected, the callees would still
+/// see the program ids of the launch.
+bool canRemapProgramIds(FuncOp funcOp);
+
+/// Returns the program ids along x, y and z of the `index`-th program of
+/// `grid`, in the order of the launch, x first. With a positive `groupSize`,
+/// the ids are visited in groups of `groupSize` ids along x swept along y.
+std::array<Value, 3> getProgramIds(OpBuilder &builder, Location loc,
+                                   Value index, ArrayRef<Value> grid,
+                                   int groupSize = 0);
+
+/// Replaces the program ids and the numbers of programs read within `op` by
+/// `programIds` and `grid`.
+void replaceProgramIds(Operation *op, ArrayRef<Value> programIds,
+                       ArrayRef<Value> grid);
+
+} // namespace triton
+} // namespace mlir
+
+#endif // TRITON_DIALECT_TRITON_TRANSFORMS_PROGRAMIDS_H_
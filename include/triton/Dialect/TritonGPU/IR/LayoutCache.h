@@ -0,0 +1,60 @@
+#ifndef TRITON_DIALECT_TRITONGPU_IR_LAYOUTCACHE_H_
+#define TRITON_DIALECT_TRITONGPU_IR_LAYOUTCACHE_H_
+
+#include "mlir/IR/Attributes.h"
+#include "llvm/ADT/SmallVector.h"
+
+#include <map>
+#include <mutex>
+#include <shared_mutex>
+#include <tuple>
+
+namespace mlir {
+namespace triton {
+namespace gpu {
+
+// Memoizes the properties the layout queries of the dialect derive from the
+// encoding attributes, keyed by the query, the attribute and the shape of the
+// tensor for the queries that depend on it. The attributes are uniqued by the
+// context that owns the dialect, so they outlive the entries. Passes may run
+// on several functions at once, hence the lock.
+class LayoutCache {
+public:
+  enum class Query {
+    SizePerThread,
+    ContigPerThread,
+    UniqueContigPerThread,
+    ShapePerCTATile,
+  };
+
+  template <typename ComputeFn>
+  SmallVector<unsigned> get(Query query, Attribute layout,
+                            ArrayRef<int64_t> shape, ComputeFn compute) {
+    Key key(query, layout.getAsOpaquePointer(),
+            SmallVector<int64_t>(shape.begin(), shape.end()));
+    {
+      std::shared_lock<std::shared_mutex> lock(mutex);
+      auto it = entries.find(key);
+      if (it != entries.end())
+        return it->second;
+    }
+    // The computation may query the cache again, e.g. for the parent of a
+    // slice, so it runs without the lock.
+    SmallVector<unsigned> value = compute();
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    entries.try_emplace(std::move(key), value);
+    return value;
+  }
+
+private:
+  using Key = std::tuple<Query, const void *, SmallVector<int64_t>>;
+
+  std::map<Key, SmallVector<unsigned>> entries;
+  std::shared_mutex mutex;
+};
+
+} // namespace gpu
+} // namespace triton
+} // namespace mlir
+
+#endif // TRITON_DIALECT_TRITONGPU_IR_LAYOUTCACHE_H_
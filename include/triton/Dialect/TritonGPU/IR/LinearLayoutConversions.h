@@ -0,0 +1,32 @@
+#ifndef TRITON_DIALECT_TRITONGPU_IR_LINEARLAYOUTCONVERSIONS_H
+#define TRITON_DIALECT_TRITONGPU_IR_LINEARLAYOUTCONVERSIONS_H
+
+#include "mlir/IR/BuiltinTypes.h"
+#include "triton/Tools/LinearLayout.h"
+#include <optional>
+
+namespace mlir {
+namespace triton {
+namespace gpu {
+
+/// Returns the linear layout of the distributed tensor `type`, with the
+/// registers in the order of the values it is lowered to. Only the blocked
+/// layouts, the Ampere mma layouts and their slices in a single CTA, with
+/// power of two shapes, are supported; returns std::nullopt otherwise.
+std::optional<LinearLayout> toLinearLayout(RankedTensorType type);
+
+/// Whether reshaping a tensor of `srcType` to `dstType` leaves each element
+/// in the same register of the same thread, so that it lowers to a rename of
+/// the values even when the elements may not be reordered.
+bool isReshapeRename(RankedTensorType srcType, RankedTensorType dstType);
+
+/// Returns a blocked encoding of `dstShape` to which reshaping a tensor of
+/// `srcType` is a rename, or std::nullopt if there is none.
+std::optional<Attribute> inferReshapeRenameEncoding(RankedTensorType srcType,
+                                                    ArrayRef<int64_t> dstShape);
+
+} // namespace gpu
+} // namespace triton
+} // namespace mlir
+
+#endif // TRITON_DIALECT_TRITONGPU_IR_LINEARLAYOUTCONVERSIONS_H
@@ -1,6 +1,7 @@
 #ifndef TRITON_DIALECT_TRITONGPU_TRANSFORMS_PASSES_H_
 #define TRITON_DIALECT_TRITONGPU_TRANSFORMS_PASSES_H_
 
+#include "mlir/Dialect/LLVMIR/LLVMDialect.h"
 #include "mlir/Pass/Pass.h"
 #include "triton/Dialect/TritonNvidiaGPU/IR/Dialect.h"
 
@@ -10,7 +11,12 @@ namespace gpu {
 
 std::unique_ptr<Pass> createPipelinePass(int numStages = 3, int numWarps = 4,
                                          int numCTAs = 1,
-                                         int computeCapability = 80);
+                                         int computeCapability = 80,
+                                         bool asyncBarriers = false);
+
+std::unique_ptr<Pass> createPeelMaskedTailPass();
+
+std::unique_ptr<Pass> createHoistInvariantLoadsPass();
 
 std::unique_ptr<Pass> createAccelerateMatmulPass(int computeCapability = 80);
 
@@ -20,11 +26,12 @@ std::unique_ptr<Pass> createCanonicalizeLoopsPass();
 
 std::unique_ptr<Pass> createCoalescePass();
 
-std::unique_ptr<Pass> createReorderInstructionsPass();
+std::unique_ptr<Pass> createReorderInstructionsPass(bool schedule = false);
 
 std::unique_ptr<Pass> createDecomposeConversionsPass();
 
-std::unique_ptr<Pass> createRemoveLayoutConversionsPass();
+std::unique_ptr<Pass>
+createRemoveLayoutConversionsPass(bool globalAssignment = false);
 
 std::unique_ptr<Pass> createVerifier();
 
@@ -34,6 +41,11 @@ std::unique_ptr<Pass> createOptimizeEpiloguePass();
 
 std::unique_ptr<Pass> createOptimizeThreadLocalityPass();
 
+std::unique_ptr<Pass> createInstrumentBranchesPass();
+
+std::unique_ptr<Pass>
+createApplyBranchProfilePass(ArrayRef<int64_t> counts = {});
+
 } // namespace gpu
 } // namespace triton
 
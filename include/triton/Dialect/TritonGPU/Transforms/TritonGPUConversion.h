@@ -8,6 +8,8 @@
 #define TRITON_DIALECT_TRITONGPU_TRANSFORMS_TRITONGPUCONVERSION_H_
 
 #include "mlir/Transforms/DialectConversion.h"
+#include "llvm/ADT/SmallVector.h"
+#include <map>
 
 namespace mlir {
 
@@ -19,11 +21,18 @@ public:
   int getThreadsPerWarp() const { return threadsPerWarp; }
   int getNumCTAs() const { return numCTAs; }
 
+  // Gives the tensors of `shape` without an encoding the `encoding` instead of
+  // the default blocked one.
+  void setEncoding(ArrayRef<int64_t> shape, Attribute encoding) {
+    encodings[SmallVector<int64_t>(shape.begin(), shape.end())] = encoding;
+  }
+
 private:
   MLIRContext *context;
   int numWarps;
   int threadsPerWarp;
   int numCTAs;
+  std::map<SmallVector<int64_t>, Attribute> encodings;
 };
 
 class TritonGPUConversionTarget : public ConversionTarget {
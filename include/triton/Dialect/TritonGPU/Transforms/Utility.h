@@ -35,6 +35,16 @@ Operation *getFirstUser(Value v);
 /// Return the proper SharedEncodingAttr according to shape/order
 triton::gpu::SharedEncodingAttr getSharedEncoding(RankedTensorType tensorTy);
 
+/// Orders the dimensions of `shape` from the most to the least contiguous one.
+/// Dimensions of size 1, as left on the pointers of loads moved before their
+/// broadcast, come last so that they do not take the vectorized dimension.
+SmallVector<unsigned, 4> getContiguityOrder(ArrayRef<int64_t> contiguity,
+                                            ArrayRef<int64_t> shape);
+
+/// Attribute of the remainder loops left by the masked tail peeling. They run
+/// at most one iteration and aren't pipelined.
+constexpr static char kPeeledTailAttrName[] = "tt.peeled_tail";
+
 /* Dump Triton IR in graphviz dot format.
  *
  * You can override `onValue` and `onOperation` in a subclass to mark
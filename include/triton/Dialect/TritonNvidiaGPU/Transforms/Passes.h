@@ -24,8 +24,11 @@
 #ifndef TRITON_DIALECT_TRITONNVIDIAGPU_TRANSFORMS_PASSES_H_
 #define TRITON_DIALECT_TRITONNVIDIAGPU_TRANSFORMS_PASSES_H_
 
+#include "mlir/IR/BuiltinOps.h"
 #include "mlir/Pass/Pass.h"
 
+#include <array>
+
 namespace mlir {
 namespace triton {
 namespace nvidia_gpu {
@@ -38,6 +41,13 @@ struct ClusterInfo {
   int clusterDimZ;
 };
 
+/// Returns the cluster dimensions worth trying for the TTIR module `mod`: the
+/// splits of its largest dot over 2, 4, ..., `maxNumCTAs` CTAs that PlanCTA
+/// would pick and whose CTA tiles are still legal, the ones whose multicast
+/// saves the largest share of the operand loads first. Empty without dots.
+SmallVector<std::array<unsigned, 3>> proposeClusterDims(ModuleOp mod,
+                                                        unsigned maxNumCTAs);
+
 } // namespace nvidia_gpu
 } // namespace triton
 } // namespace mlir
@@ -52,7 +62,9 @@ std::unique_ptr<Pass> createTritonNvidiaGPUPlanCTAPass(
     mlir::triton::nvidia_gpu::ClusterInfo *clusterInfo = nullptr);
 
 std::unique_ptr<Pass>
-createTritonNvidiaGPUWSFeasibilityCheckingPass(int computeCapability = 90);
+createTritonNvidiaGPUWSFeasibilityCheckingPass(int computeCapability = 90,
+                                               int numStages = 3,
+                                               bool onlyIfProfitable = false);
 
 std::unique_ptr<Pass>
 createTritonNvidiaGPUWSDecomposingPass(int computeCapability = 90);
@@ -75,6 +87,8 @@ createTritonGPURewriteTensorPointerPass(int computeCapability = 80);
 
 std::unique_ptr<Pass> createTritonNvidiaGPUWSFixupMissingAttrs();
 
+std::unique_ptr<Pass> createTritonNvidiaGPUScheduleClusterBarriersPass();
+
 /// Generate the code for registering passes.
 #define GEN_PASS_REGISTRATION
 #include "triton/Dialect/TritonNvidiaGPU/Transforms/Passes.h.inc"
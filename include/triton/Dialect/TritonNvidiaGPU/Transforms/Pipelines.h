@@ -0,0 +1,83 @@
+#ifndef TRITON_DIALECT_TRITONNVIDIAGPU_TRANSFORMS_PIPELINES_H_
+#define TRITON_DIALECT_TRITONNVIDIAGPU_TRANSFORMS_PIPELINES_H_
+
+#include "triton/Dialect/TritonNvidiaGPU/Transforms/Passes.h"
+
+#include "mlir/Pass/PassManager.h"
+#include "mlir/Pass/PassOptions.h"
+
+namespace mlir {
+namespace triton {
+namespace nvidia_gpu {
+
+// The pass pipelines of the stages of the NVIDIA backend, shared by
+// `make_ttir`/`make_ttgir` in third_party/nvidia/backend/compiler.py and
+// triton-opt, e.g.
+//   triton-opt --triton-nvidia-ttgir-pipeline="num-warps=4 num-stages=3 cc=90"
+// The options mirror the fields of `CUDAOptions` of the same name.
+
+struct TTIRPipelineOptions : public PassPipelineOptions<TTIRPipelineOptions> {
+  Option<int64_t> maxNumel{*this, "max-numel",
+                           llvm::cl::desc("maximum number of elements of the "
+                                          "tensors the kernel accesses"),
+                           llvm::cl::init(0)};
+  Option<int> splitK{*this, "split-k",
+                     llvm::cl::desc("number of slices of the reductions"),
+                     llvm::cl::init(1)};
+  Option<bool> persistent{*this, "persistent",
+                          llvm::cl::desc("make the kernel persistent"),
+                          llvm::cl::init(false)};
+  Option<int> persistentGroupSize{
+      *this, "persistent-group-size",
+      llvm::cl::desc("group size of the persistent tile order"),
+      llvm::cl::init(0)};
+};
+
+struct TTGIRPipelineOptions
+    : public PassPipelineOptions<TTGIRPipelineOptions> {
+  Option<int> numWarps{*this, "num-warps", llvm::cl::init(4)};
+  Option<int> numCTAs{*this, "num-ctas", llvm::cl::init(1)};
+  Option<int> numStages{*this, "num-stages", llvm::cl::init(3)};
+  Option<int> computeCapability{*this, "cc", llvm::cl::init(80)};
+  Option<int64_t> maxNumel{*this, "max-numel", llvm::cl::init(0)};
+  Option<bool> globalLayoutAssignment{*this, "global-layout-assignment",
+                                      llvm::cl::init(false)};
+  Option<bool> optimizeEpilogue{*this, "optimize-epilogue",
+                                llvm::cl::init(false)};
+  Option<bool> asyncBarriers{*this, "async-barriers", llvm::cl::init(false)};
+  Option<bool> scheduleInstructions{*this, "schedule-instructions",
+                                    llvm::cl::init(false)};
+  Option<bool> warpSpecialization{
+      *this, "warp-specialization",
+      llvm::cl::desc("specialize the warps instead of pipelining the loops"),
+      llvm::cl::init(false)};
+  Option<bool> autoWarpSpecialization{
+      *this, "auto-warp-specialization",
+      llvm::cl::desc("with warp-specialization, only specialize the warps "
+                     "when the cost model expects a speedup"),
+      llvm::cl::init(false)};
+};
+
+void buildTTIRPipeline(OpPassManager &pm, const TTIRPipelineOptions &options);
+
+// The TTGIR stage runs in two parts, because whether the warps can be
+// specialized is only known once the layouts are assigned.
+// `buildTTGIRLayoutPipeline` converts to TTGIR and assigns the layouts; with
+// `warpSpecialization`, it checks whether the warps can be specialized, and
+// with `autoWarpSpecialization` also whether it's worth it.
+// `buildTTGIRSchedulePipeline` pipelines the loops, or specializes the warps
+// with `warpSpecialization`, and then schedules the kernel.
+void buildTTGIRLayoutPipeline(OpPassManager &pm,
+                              const TTGIRPipelineOptions &options,
+                              ClusterInfo *clusterInfo = nullptr);
+void buildTTGIRSchedulePipeline(OpPassManager &pm,
+                                const TTGIRPipelineOptions &options);
+
+// Registers `triton-nvidia-ttir-pipeline` and `triton-nvidia-ttgir-pipeline`
+void registerTritonNvidiaGPUPipelines();
+
+} // namespace nvidia_gpu
+} // namespace triton
+} // namespace mlir
+
+#endif // TRITON_DIALECT_TRITONNVIDIAGPU_TRANSFORMS_PIPELINES_H_
@@ -83,6 +83,10 @@ constexpr AgentId kDotAgentId = 1;
 
 bool isWSCandidateLoad(Operation *op);
 bool isWSSupported(ModuleOp m, int computeCapability);
+/// Returns whether specializing the warps of `m`, which `isWSSupported`, is
+/// likely faster than pipelining its loops in `numStages` stages, from the
+/// cost model and the register pressure of the kernel.
+bool isWSProfitable(ModuleOp m, int computeCapability, int numStages);
 
 LogicalResult getDependentValues(Value val, DenseSet<Value> &depSet,
                                  const DenseSet<Value> &stopSet = {});
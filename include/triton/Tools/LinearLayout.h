@@ -0,0 +1,133 @@
+#ifndef TRITON_TOOLS_LINEARLAYOUT_H
+#define TRITON_TOOLS_LINEARLAYOUT_H
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/SmallVector.h"
+#include <array>
+#include <cstdint>
+#include <optional>
+
+namespace mlir {
+namespace triton {
+
+/// A layout of a tensor over the registers, lanes and warps of a CTA, as a
+/// linear map over GF(2). Each bit of the index of a register, a lane or a
+/// warp is mapped to a basis: a vector of offsets in the tensor, one per
+/// dimension. The element held by register `reg` of lane `lane` in warp
+/// `warp` is the XOR of the bases of the bits set in the three indices. A
+/// zero basis means that the bit doesn't change the element, the data is
+/// replicated along it.
+///
+/// The distributed layouts of power of two shapes are linear, and having a
+/// single representation for all of them makes it possible to compare them.
+class LinearLayout {
+public:
+  enum class InDim : unsigned { Register = 0, Lane = 1, Warp = 2 };
+  static constexpr unsigned kNumInDims = 3;
+
+  using BasisT = llvm::SmallVector<int32_t, 4>;
+  using BasesT = llvm::SmallVector<BasisT>;
+
+  /// Builds the layout of a tensor of `shape` from the bases of each bit of
+  /// the indices of the registers, lanes and warps. The dimensions of the
+  /// tensor must be powers of two, and the offsets smaller than them.
+  LinearLayout(llvm::ArrayRef<int64_t> shape, BasesT registers, BasesT lanes,
+               BasesT warps);
+
+  llvm::ArrayRef<int64_t> getShape() const { return shape; }
+
+  unsigned getRank() const { return shape.size(); }
+
+  const BasesT &getBases(InDim inDim) const {
+    return bases[static_cast<unsigned>(inDim)];
+  }
+
+  /// Returns the number of bits of the index of `inDim`.
+  unsigned getNumBits(InDim inDim) const { return getBases(inDim).size(); }
+
+  unsigned getNumRegisters() const {
+    return 1u << getNumBits(InDim::Register);
+  }
+
+  /// Returns the offsets of the element held by register `reg` of lane
+  /// `lane` in warp `warp`.
+  BasisT apply(unsigned reg, unsigned lane, unsigned warp) const;
+
+  /// Returns the basis of `bit` of `inDim` as a single integer, the offsets
+  /// of each dimension being packed from the lowest bits up.
+  uint64_t getPackedBasis(InDim inDim, unsigned bit) const;
+
+  /// Returns the layout of the tensor reshaped to `newShape` without moving
+  /// its elements: each offset is flattened in row-major order and
+  /// unflattened in the new shape, which is linear as the dimensions are
+  /// powers of two.
+  LinearLayout reshape(llvm::ArrayRef<int64_t> newShape) const;
+
+  bool operator==(const LinearLayout &other) const {
+    return shape == other.shape && bases == other.bases;
+  }
+  bool operator!=(const LinearLayout &other) const {
+    return !(*this == other);
+  }
+
+private:
+  llvm::SmallVector<int64_t> shape;
+  std::array<BasesT, kNumInDims> bases;
+};
+
+/// A conversion between two layouts of a tensor where the elements don't
+/// leave their warp. Register `r` of lane `l` in the destination layout is
+/// read from register `srcRegisters[r]` of lane `srcLanes[r] ^ laneMap(l)`
+/// in the source layout, `laneMap(l)` being the XOR of `laneBases[i]` for
+/// each bit `i` set in `l`.
+struct WarpLocalConversion {
+  llvm::SmallVector<unsigned> srcRegisters;
+  llvm::SmallVector<unsigned> srcLanes;
+  llvm::SmallVector<unsigned> laneBases;
+  unsigned numSrcRegisters = 0;
+
+  /// Whether each lane only reads its own registers.
+  bool isRegisterPermutation() const;
+
+  /// Whether the registers of each lane are left unchanged: the two layouts
+  /// are the same.
+  bool isNoop() const;
+};
+
+/// Returns how to convert a tensor from the layout `src` to `dst` within each
+/// warp, with a permutation of the registers of each lane or with warp
+/// shuffles. Registers are read from the same lane when possible. Returns
+/// std::nullopt when a warp needs elements held by other warps.
+std::optional<WarpLocalConversion>
+getWarpLocalConversion(const LinearLayout &src, const LinearLayout &dst);
+
+/// A gather along an axis where the elements don't leave their warp. For an
+/// index `k` along the axis, register `r` of lane `l` in the result is read
+/// from register `srcRegisters[r] ^ indexRegMap(k)` of lane
+/// `srcLanes[r] ^ laneMap(l) ^ indexLaneMap(k)` in the source, the maps being
+/// the XOR of `laneBases`, `indexRegBases` and `indexLaneBases` for each bit
+/// set in `l` and `k`.
+struct WarpLocalGather {
+  llvm::SmallVector<unsigned> srcRegisters;
+  llvm::SmallVector<unsigned> srcLanes;
+  llvm::SmallVector<unsigned> laneBases;
+  llvm::SmallVector<unsigned> indexRegBases;
+  llvm::SmallVector<unsigned> indexLaneBases;
+  unsigned numSrcRegisters = 0;
+
+  /// Whether each lane only reads its own registers.
+  bool isThreadLocal() const;
+};
+
+/// Returns how to gather the elements of `src` along `axis` into a tensor
+/// whose indices have the layout `indices`, within each warp. Both tensors
+/// must have the same shape but along `axis`. Returns std::nullopt when a
+/// warp needs elements held by other warps.
+std::optional<WarpLocalGather> getWarpLocalGather(const LinearLayout &src,
+                                                  const LinearLayout &indices,
+                                                  unsigned axis);
+
+} // namespace triton
+} // namespace mlir
+
+#endif // TRITON_TOOLS_LINEARLAYOUT_H
@@ -5,12 +5,20 @@
 #include "mlir/Dialect/Tensor/IR/Tensor.h"
 #include "triton/Analysis/Alias.h"
 #include "triton/Dialect/TritonGPU/IR/Dialect.h"
+#include "triton/Tools/Sys/GetEnv.hpp"
 #include "llvm/ADT/SmallVector.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Support/MathExtras.h"
 
 #include <algorithm>
+#include <functional>
 #include <limits>
 #include <numeric>
 
+#define DEBUG_TYPE "allocate-shared-memory"
+#define DBGS() (llvm::dbgs() << "[" DEBUG_TYPE "]: ")
+#define LDBG(X) LLVM_DEBUG(DBGS() << X << "\n")
+
 using ::mlir::triton::gpu::BlockedEncodingAttr;
 using ::mlir::triton::gpu::DotOperandEncodingAttr;
 using ::mlir::triton::gpu::getContigPerThread;
@@ -34,7 +42,7 @@ namespace triton {
 // Bitwidth of pointers
 constexpr int kPtrBitWidth = 64;
 
-static std::pair<SmallVector<unsigned>, SmallVector<unsigned>>
+std::pair<SmallVector<unsigned>, SmallVector<unsigned>>
 getCvtOrder(Attribute srcLayout, Attribute dstLayout) {
   auto srcMmaLayout = srcLayout.dyn_cast<NvidiaMmaEncodingAttr>();
   auto srcDotLayout = srcLayout.dyn_cast<DotOperandEncodingAttr>();
@@ -79,6 +87,10 @@ SmallVector<unsigned> getRepShapeForCvtLayout(triton::gpu::ConvertLayoutOp op) {
     }
   }
 
+  // Conversions within the warps are lowered to shuffles
+  if (getWarpLocalConversion(srcTy, dstTy))
+    return {};
+
   assert(srcLayout && dstLayout && "Unexpected layout in getRepShape()");
 
   auto srcShapePerCTA = getShapePerCTA(srcTy);
@@ -251,12 +263,17 @@ private:
       unsigned bytes = helper.getScratchSizeInBytes();
       maybeAddScratchBuffer<BufferT::BufferKind::Scratch>(op, bytes,
                                                           scratchAlignment);
+    } else if (auto sortOp = dyn_cast<triton::SortOp>(op)) {
+      SortLoweringHelper helper(sortOp);
+      unsigned bytes = helper.getScratchSizeInBytes();
+      maybeAddScratchBuffer<BufferT::BufferKind::Scratch>(op, bytes,
+                                                          scratchAlignment);
     } else if (auto histogram = dyn_cast<triton::HistogramOp>(op)) {
-      auto dstTy = histogram.getResult().getType().cast<RankedTensorType>();
-      int threadsPerWarp = triton::gpu::TritonGPUDialect::getThreadsPerWarp(
-          op->getParentOfType<ModuleOp>());
-      auto bytes = std::max<int>(dstTy.getNumElements(), threadsPerWarp) *
-                   std::max<int>(8, dstTy.getElementTypeBitWidth()) / 8;
+      unsigned bytes = getHistogramScratchSizeInBytes(histogram);
+      maybeAddScratchBuffer<BufferT::BufferKind::Scratch>(op, bytes,
+                                                          scratchAlignment);
+    } else if (auto gather = dyn_cast<triton::GatherOp>(op)) {
+      unsigned bytes = getGatherScratchSizeInBytes(gather);
       maybeAddScratchBuffer<BufferT::BufferKind::Scratch>(op, bytes,
                                                           scratchAlignment);
     } else if (auto cvtLayout = dyn_cast<triton::gpu::ConvertLayoutOp>(op)) {
@@ -338,8 +355,12 @@ private:
       auto funcOp = dyn_cast<FunctionOpInterface>(callable);
       auto *funcAlloc = &(*funcAllocMap)[funcOp];
       auto bytes = funcAlloc->getSharedMemorySize();
-      maybeAddScratchBuffer<BufferT::BufferKind::Virtual>(op, bytes,
-                                                          scratchAlignment);
+      // The callee's offsets are relative to the base it is given, so the
+      // buffer needs the alignment of the callee's buffers: no less, or they
+      // end up misaligned, and no more, or it can't be packed as tightly
+      // between the caller's buffers.
+      maybeAddScratchBuffer<BufferT::BufferKind::Virtual>(
+          op, bytes, funcAlloc->getAlignment());
     }
   }
 
@@ -511,6 +532,93 @@ private:
       allocate(buffers, interference, bufferStart);
       buildInterferenceGraph(buffers, bufferStart, interference);
     } while (!interference.empty());
+
+    if (::triton::tools::getBoolEnv("TRITON_OPTIMAL_SMEM_ALLOCATION"))
+      computeOptimalOffsets(buffers);
+  }
+
+  /// Maximum number of placements tried by computeOptimalOffsets.
+  static constexpr size_t kMaxOptimalAllocationSteps = 1 << 16;
+
+  /// Looks for offsets using less shared memory than the heuristic ones, with
+  /// a branch and bound search over the placements of the buffers, largest
+  /// first: each buffer goes at offset 0 or right after a placed buffer whose
+  /// liveness overlaps its own, provided it doesn't overlap any of them. The
+  /// search is bounded by the heuristic allocation, and stops when it reaches
+  /// the largest amount of memory live at once or after
+  /// kMaxOptimalAllocationSteps placements, so the result is never worse.
+  void computeOptimalOffsets(const SmallVector<BufferT *> &buffers) {
+    size_t heuristicSize = allocation->sharedMemorySize;
+    // Liveness ranges are intervals, so the largest amount of memory live at
+    // once is reached at the start of one of them.
+    size_t lowerBound = 0;
+    for (auto x : buffers) {
+      size_t live = 0;
+      for (auto y : buffers)
+        if (bufferRange.lookup(y).contains(bufferRange.lookup(x).start()))
+          live += y->size;
+      lowerBound = std::max(lowerBound, live);
+    }
+    if (heuristicSize <= lowerBound)
+      return;
+
+    SmallVector<BufferT *> order = buffers;
+    llvm::stable_sort(order, [](BufferT *x, BufferT *y) {
+      return x->size > y->size;
+    });
+    size_t n = order.size();
+    // Buffers placed before each buffer whose liveness overlaps its own
+    SmallVector<SmallVector<unsigned>> interferes(n);
+    for (unsigned i = 0; i < n; ++i)
+      for (unsigned j = 0; j < i; ++j)
+        if (bufferRange.lookup(order[i]).intersects(
+                bufferRange.lookup(order[j])))
+          interferes[i].push_back(j);
+
+    SmallVector<size_t> offsets(n), bestOffsets;
+    size_t best = heuristicSize;
+    size_t steps = 0;
+    std::function<void(unsigned, size_t)> place = [&](unsigned i,
+                                                      size_t peak) {
+      if (i == n) {
+        best = peak;
+        bestOffsets = offsets;
+        return;
+      }
+      BufferT *buffer = order[i];
+      SmallVector<size_t> candidates = {0};
+      for (unsigned j : interferes[i])
+        candidates.push_back(offsets[j] + order[j]->size);
+      for (auto &candidate : candidates)
+        candidate = llvm::alignTo(candidate, buffer->alignment);
+      llvm::sort(candidates);
+      candidates.erase(std::unique(candidates.begin(), candidates.end()),
+                       candidates.end());
+      for (size_t offset : candidates) {
+        // Candidates are sorted, the next ones can only be worse
+        if (best <= lowerBound || steps >= kMaxOptimalAllocationSteps ||
+            std::max(peak, offset + buffer->size) >= best)
+          return;
+        bool fits = llvm::none_of(interferes[i], [&](unsigned j) {
+          return offset < offsets[j] + order[j]->size &&
+                 offsets[j] < offset + buffer->size;
+        });
+        if (!fits)
+          continue;
+        ++steps;
+        offsets[i] = offset;
+        place(i + 1, std::max(peak, offset + buffer->size));
+      }
+    };
+    place(0, 0);
+    LDBG("heuristic: " << heuristicSize << " bytes, search: " << best
+                       << " bytes, lower bound: " << lowerBound << " bytes ("
+                       << steps << " placements)");
+    if (bestOffsets.empty())
+      return;
+    for (unsigned i = 0; i < n; ++i)
+      order[i]->offset = bestOffsets[i];
+    allocation->sharedMemorySize = best;
   }
 
   /// Computes the initial shared memory offsets.
@@ -1,5 +1,7 @@
 #include "mlir/Analysis/DataFlowFramework.h"
 #include "mlir/Dialect/LLVMIR/LLVMDialect.h"
+#include "mlir/IR/TypeUtilities.h"
+#include "llvm/Support/CheckedArithmetic.h"
 #include "llvm/Support/raw_ostream.h"
 
 #include "triton/Analysis/AxisInfo.h"
@@ -128,7 +130,30 @@ AxisInfo AxisInfo::join(const AxisInfo &lhs, const AxisInfo &rhs) {
       rhs.getConstantValue().has_value() &&
       lhs.getConstantValue() == rhs.getConstantValue())
     constantValue = lhs.getConstantValue();
-  return AxisInfo(contiguity, divisibility, constancy, constantValue);
+  // Ranges aren't widened, so only keep them when both arguments agree, or
+  // the ranges of loop-carried values would grow with every visit of the loop
+  std::optional<RangeT> range;
+  if (lhs.getRange() == rhs.getRange())
+    range = lhs.getRange();
+  return AxisInfo(contiguity, divisibility, constancy, constantValue, range);
+}
+
+std::optional<AxisInfo::RangeT>
+AxisInfo::fitRange(Type type, std::optional<RangeT> range) {
+  if (!range)
+    return std::nullopt;
+  Type elemTy = getElementTypeOrSelf(type);
+  if (elemTy.isIndex())
+    return range;
+  if (!elemTy.isa<IntegerType>() || elemTy.isInteger(1))
+    return std::nullopt;
+  unsigned bitWidth = elemTy.getIntOrFloatBitWidth();
+  if (bitWidth >= 64)
+    return range;
+  int64_t max = (int64_t(1) << (bitWidth - 1)) - 1;
+  if (range->first < -max - 1 || range->second > max)
+    return std::nullopt;
+  return range;
 }
 
 //===----------------------------------------------------------------------===//
@@ -143,7 +168,15 @@ public:
   AxisInfo
   getAxisInfo(OpTy op,
               ArrayRef<const dataflow::Lattice<AxisInfo> *> operands) override {
-    return operands[0]->getValue();
+    AxisInfo opInfo = operands[0]->getValue();
+    auto range = opInfo.getRange();
+    // Zero extension changes the value of negative integers
+    if constexpr (std::is_same_v<OpTy, arith::ExtUIOp>)
+      if (range && range->first < 0)
+        range = std::nullopt;
+    return AxisInfo(opInfo.getContiguity(), opInfo.getDivisibility(),
+                    opInfo.getConstancy(), opInfo.getConstantValue(),
+                    AxisInfo::fitRange(op->getResultTypes()[0], range));
   }
 };
 
@@ -159,7 +192,8 @@ public:
     auto end = op.getEnd();
     return AxisInfo(/*contiguity=*/{end - start},
                     /*divisibility=*/{highestPowOf2Divisor(start)},
-                    /*constancy=*/{1});
+                    /*constancy=*/{1}, /*constantValue=*/std::nullopt,
+                    /*range=*/{{start, end - 1}});
   }
 };
 
@@ -175,19 +209,25 @@ public:
     auto boolAttr = op.getValue().template dyn_cast<BoolAttr>();
     if (intAttr || boolAttr) {
       int64_t value{};
-      if (intAttr)
+      std::optional<AxisInfo::RangeT> range;
+      if (intAttr) {
         value = intAttr.getValue().getZExtValue();
-      else
+        int64_t signedValue = intAttr.getValue().getSExtValue();
+        range = AxisInfo::fitRange(intAttr.getType(),
+                                   {{signedValue, signedValue}});
+      } else
         value = boolAttr.getValue() ? 1 : 0;
       return AxisInfo(/*contiguity=*/{1},
                       /*divisibility=*/{highestPowOf2Divisor(value)},
                       /*constancy=*/{1},
-                      /*knownConstantValue=*/{value});
+                      /*knownConstantValue=*/{value}, range);
     }
     // TODO: generalize to dense attr
     auto splatAttr = op.getValue().template dyn_cast<SplatElementsAttr>();
     if (splatAttr && splatAttr.getElementType().isIntOrIndex()) {
       int64_t value = splatAttr.template getSplatValue<APInt>().getZExtValue();
+      int64_t signedValue =
+          splatAttr.template getSplatValue<APInt>().getSExtValue();
       TensorType ty = splatAttr.getType().template cast<TensorType>();
       return AxisInfo(
           /*contiguity=*/AxisInfo::DimVectorT(ty.getRank(), 1),
@@ -195,7 +235,8 @@ public:
           AxisInfo::DimVectorT(ty.getRank(), highestPowOf2Divisor(value)),
           /*constancy=*/
           AxisInfo::DimVectorT(ty.getShape().begin(), ty.getShape().end()),
-          /*knownConstantValue=*/{value});
+          /*knownConstantValue=*/{value},
+          AxisInfo::fitRange(ty, {{signedValue, signedValue}}));
     }
     return AxisInfo();
   }
@@ -252,6 +293,25 @@ private:
     }
     return {};
   }
+
+  std::optional<AxisInfo::RangeT> getRange(OpTy op, const AxisInfo &lhs,
+                                           const AxisInfo &rhs) override {
+    auto lhsRange = lhs.getRange();
+    auto rhsRange = rhs.getRange();
+    if (!lhsRange || !rhsRange)
+      return {};
+    std::optional<int64_t> min, max;
+    if constexpr (std::is_same_v<OpTy, arith::SubIOp>) {
+      min = llvm::checkedSub(lhsRange->first, rhsRange->second);
+      max = llvm::checkedSub(lhsRange->second, rhsRange->first);
+    } else {
+      min = llvm::checkedAdd(lhsRange->first, rhsRange->first);
+      max = llvm::checkedAdd(lhsRange->second, rhsRange->second);
+    }
+    if (!min || !max)
+      return {};
+    return {{*min, *max}};
+  }
 };
 
 class MulIOpAxisInfoVisitor final : public BinaryOpVisitorImpl<arith::MulIOp> {
@@ -303,6 +363,25 @@ private:
       return {lhs.getConstantValue().value() * rhs.getConstantValue().value()};
     return {};
   }
+
+  std::optional<AxisInfo::RangeT> getRange(arith::MulIOp op,
+                                           const AxisInfo &lhs,
+                                           const AxisInfo &rhs) override {
+    auto lhsRange = lhs.getRange();
+    auto rhsRange = rhs.getRange();
+    if (!lhsRange || !rhsRange)
+      return {};
+    // The bounds of the product are products of the bounds of its operands
+    SmallVector<int64_t, 4> products;
+    for (int64_t lhsBound : {lhsRange->first, lhsRange->second})
+      for (int64_t rhsBound : {rhsRange->first, rhsRange->second}) {
+        auto product = llvm::checkedMul(lhsBound, rhsBound);
+        if (!product)
+          return {};
+        products.push_back(*product);
+      }
+    return {{*llvm::min_element(products), *llvm::max_element(products)}};
+  }
 };
 
 template <typename OpTy>
@@ -454,7 +533,8 @@ public:
       constancy.push_back(retTy.getShape()[d]);
     }
     return AxisInfo(contiguity, divisibility, constancy,
-                    operands[0]->getValue().getConstantValue());
+                    operands[0]->getValue().getConstantValue(),
+                    operands[0]->getValue().getRange());
   }
 };
 
@@ -519,7 +599,8 @@ public:
     divisibility.insert(divisibility.begin() + op.getAxis(), newDivisibility);
     constancy.insert(constancy.begin() + op.getAxis(), 1);
     return AxisInfo(contiguity, divisibility, constancy,
-                    operands[0]->getValue().getConstantValue());
+                    operands[0]->getValue().getConstantValue(),
+                    operands[0]->getValue().getRange());
   }
 };
 
@@ -548,7 +629,8 @@ public:
                                           : opInfo.getConstancy(d));
     }
     return AxisInfo(contiguity, divisibility, constancy,
-                    operands[0]->getValue().getConstantValue());
+                    operands[0]->getValue().getConstantValue(),
+                    operands[0]->getValue().getRange());
   }
 };
 
@@ -570,16 +652,26 @@ public:
 
     AxisInfo::DimVectorT contiguity, divisibility, constancy;
     std::optional<int64_t> constantValue;
+    bool isConstant = lhsInfo.getConstantValue().has_value() &&
+                      rhsInfo.getConstantValue().has_value();
+    // The ranges of the operands may decide the comparison, e.g. a mask that
+    // is always true within the bounds of a loop
+    std::optional<bool> rangeResult;
+    if (!isConstant && lhsInfo.getRange() && rhsInfo.getRange())
+      rangeResult = compareRanges(getPredicate(op), *lhsInfo.getRange(),
+                                  *rhsInfo.getRange());
     for (short d = 0; d < rank; ++d) {
       int64_t constHint = 1;
-      if (lhsInfo.getConstantValue().has_value() &&
-          rhsInfo.getConstantValue().has_value()) {
+      if (isConstant) {
         constHint = lhsInfo.getConstancy(d);
         constantValue =
             compare(getPredicate(op), lhsInfo.getConstantValue().value(),
                     rhsInfo.getConstantValue().value())
                 ? 1
                 : 0;
+      } else if (rangeResult.has_value()) {
+        constHint = shape[d];
+        constantValue = *rangeResult ? 1 : 0;
       } else {
         // Case 1: lhs and rhs are both partial constants
         constHint = gcd(lhsInfo.getConstancy(d), rhsInfo.getConstancy(d));
@@ -657,6 +749,53 @@ private:
     }
     llvm_unreachable("unknown comparison predicate");
   }
+
+  static std::optional<bool> compareRanges(arith::CmpIPredicate predicate,
+                                           AxisInfo::RangeT lhs,
+                                           AxisInfo::RangeT rhs) {
+    // Unsigned comparisons only agree with signed ones on non-negative values
+    bool isUnsigned = predicate == arith::CmpIPredicate::ult ||
+                      predicate == arith::CmpIPredicate::ule ||
+                      predicate == arith::CmpIPredicate::ugt ||
+                      predicate == arith::CmpIPredicate::uge;
+    if (isUnsigned && (lhs.first < 0 || rhs.first < 0))
+      return std::nullopt;
+    bool isDisjoint = lhs.second < rhs.first || rhs.second < lhs.first;
+    bool isSameValue = lhs.first == lhs.second && lhs == rhs;
+    switch (predicate) {
+    case arith::CmpIPredicate::eq:
+      if (isDisjoint || isSameValue)
+        return isSameValue;
+      break;
+    case arith::CmpIPredicate::ne:
+      if (isDisjoint || isSameValue)
+        return isDisjoint;
+      break;
+    case arith::CmpIPredicate::slt:
+    case arith::CmpIPredicate::ult:
+      if (lhs.second < rhs.first || lhs.first >= rhs.second)
+        return lhs.second < rhs.first;
+      break;
+    case arith::CmpIPredicate::sle:
+    case arith::CmpIPredicate::ule:
+      if (lhs.second <= rhs.first || lhs.first > rhs.second)
+        return lhs.second <= rhs.first;
+      break;
+    case arith::CmpIPredicate::sgt:
+    case arith::CmpIPredicate::ugt:
+      if (lhs.first > rhs.second || lhs.second <= rhs.first)
+        return lhs.first > rhs.second;
+      break;
+    case arith::CmpIPredicate::sge:
+    case arith::CmpIPredicate::uge:
+      if (lhs.first >= rhs.second || lhs.second < rhs.first)
+        return lhs.first >= rhs.second;
+      break;
+    default:
+      break;
+    }
+    return std::nullopt;
+  }
 };
 
 template <typename OpTy>
@@ -972,7 +1111,7 @@ void AxisInfoAnalysis::visitOperation(
     newConstancy = AxisInfo::DimVectorT(vals.begin(), vals.end());
   }
   curr = mlir::AxisInfo(newContiguity, newDivisibility, newConstancy,
-                        curr.getConstantValue());
+                        curr.getConstantValue(), curr.getRange());
   // join all lattice elements
   for (auto *result : results)
     propagateIfChanged(result, result->join(curr));
@@ -1002,14 +1141,33 @@ unsigned ModuleAxisInfoAnalysis::getPtrContiguity(Value ptr) {
 void AxisInfoAnalysis::visitForOpInductionVar(
     scf::ForOp op, ArrayRef<dataflow::Lattice<AxisInfo> *> argLattices) {
   auto lb = getLatticeElementFor(op, op.getLowerBound())->getValue();
+  auto ub = getLatticeElementFor(op, op.getUpperBound())->getValue();
   auto step = getLatticeElementFor(op, op.getStep())->getValue();
 
   AxisInfo::DimVectorT knownContiguity(1, 1);
   AxisInfo::DimVectorT knownDivisibility(1, 1);
   AxisInfo::DimVectorT knownConstancy(1, 1);
   knownDivisibility[0] = gcd(lb.getDivisibility(0), step.getDivisibility(0));
+  // The induction variable is in [lb, ub - 1] when the loop runs at all. With
+  // a constant lower bound and step, its last value is a whole number of
+  // steps away from the lower bound, which proves the masks of full tiles:
+  //   for k in range(0, 1024, 128): k + arange(0, 128) < 1024
+  std::optional<AxisInfo::RangeT> range;
+  auto lbRange = lb.getRange();
+  auto ubRange = ub.getRange();
+  auto stepRange = step.getRange();
+  if (lbRange && ubRange && stepRange && stepRange->first > 0 &&
+      ubRange->second > lbRange->first) {
+    int64_t max = ubRange->second - 1;
+    if (lbRange->first == lbRange->second &&
+        stepRange->first == stepRange->second)
+      max -= (max - lbRange->first) % stepRange->first;
+    range = {lbRange->first, max};
+  }
   auto inductionVar =
-      AxisInfo(knownContiguity, knownDivisibility, knownConstancy);
+      AxisInfo(knownContiguity, knownDivisibility, knownConstancy,
+               /*constantValue=*/std::nullopt,
+               AxisInfo::fitRange(op.getInductionVar().getType(), range));
   (void)argLattices[0]->join(inductionVar);
 }
 
@@ -1071,6 +1229,15 @@ void ModuleAxisInfoAnalysis::initialize(FunctionOpInterface funcOp) {
   });
 }
 
+void ModuleAxisInfoAnalysis::recompute(FunctionOpInterface funcOp) {
+  auto *axisInfoMap = getFuncData(funcOp);
+  if (!axisInfoMap)
+    return;
+  // `initialize` joins the new axis info with the existing one
+  axisInfoMap->clear();
+  initialize(funcOp);
+}
+
 void ModuleAxisInfoAnalysis::update(CallOpInterface callOp,
                                     FunctionOpInterface callee) {
   auto caller = callOp->getParentOfType<FunctionOpInterface>();
@@ -0,0 +1,144 @@
+#include "triton/Analysis/BankConflicts.h"
+#include "triton/Dialect/TritonGPU/IR/LinearLayoutConversions.h"
+#include "llvm/ADT/STLExtras.h"
+
+namespace mlir {
+
+using namespace triton;
+using namespace triton::gpu;
+
+namespace {
+
+constexpr unsigned kNumBanks = 32;
+constexpr unsigned kBankBytes = 4;
+// The widest vector a lane accesses shared memory with
+constexpr unsigned kMaxAccessBytes = 16;
+
+unsigned getElementBytes(RankedTensorType type) {
+  return std::max(type.getElementTypeBitWidth() / 8, 1u);
+}
+
+// Returns the offset in elements of `coords` in shared memory, as
+// getSwizzledSharedPtrs computes it: the vectors of a row are XORed with the
+// phase of the row.
+int64_t getSharedOffset(ArrayRef<int32_t> coords, ArrayRef<int64_t> shape,
+                        SharedEncodingAttr sharedEnc) {
+  ArrayRef<unsigned> order = sharedEnc.getOrder();
+  int64_t vec = sharedEnc.getVec();
+  int64_t col = coords[order[0]];
+  int64_t row = order.size() > 1 ? coords[order[1]] : 0;
+  int64_t phase = (row / sharedEnc.getPerPhase()) % sharedEnc.getMaxPhase();
+  int64_t offset = row * shape[order[0]] + ((col / vec) ^ phase) * vec +
+                   col % vec;
+  int64_t stride = shape[order[0]] * (order.size() > 1 ? shape[order[1]] : 1);
+  for (unsigned dim : llvm::drop_begin(order, 2)) {
+    offset += coords[dim] * stride;
+    stride *= shape[dim];
+  }
+  return offset;
+}
+
+SharedAccessCost getSharedAccessCost(const LinearLayout &layout,
+                                     RankedTensorType type,
+                                     SharedEncodingAttr sharedEnc) {
+  ArrayRef<unsigned> order = sharedEnc.getOrder();
+  unsigned elemBytes = getElementBytes(type);
+  // The accesses are vectorized along the rows of shared memory when the
+  // layout of the tensor has the same order
+  unsigned vec = 1;
+  if (llvm::equal(getOrder(type.getEncoding()), order))
+    vec = std::min(getUniqueContigPerThread(type.getEncoding(),
+                                            type.getShape())[order[0]],
+                   sharedEnc.getVec());
+  vec = std::max(std::min(vec, kMaxAccessBytes / elemBytes), 1u);
+  unsigned accessBytes = vec * elemBytes;
+  unsigned wordsPerAccess = (accessBytes + kBankBytes - 1) / kBankBytes;
+  // The lanes of accesses wider than a bank are served in phases that each
+  // cover 128 bytes
+  unsigned numLanes = 1u << layout.getNumBits(LinearLayout::InDim::Lane);
+  unsigned lanesPerPhase = std::max(numLanes / wordsPerAccess, 1u);
+
+  SharedAccessCost cost;
+  SmallVector<int64_t> words;
+  SmallVector<unsigned> wordsPerBank(kNumBanks);
+  for (unsigned reg = 0; reg < layout.getNumRegisters(); reg += vec) {
+    for (unsigned first = 0; first < numLanes; first += lanesPerPhase) {
+      words.clear();
+      for (unsigned lane = first; lane < first + lanesPerPhase; ++lane) {
+        int64_t byte = getSharedOffset(layout.apply(reg, lane, 0),
+                                       type.getShape(), sharedEnc) *
+                       elemBytes;
+        for (unsigned i = 0; i < wordsPerAccess; ++i)
+          words.push_back(byte / kBankBytes + i);
+      }
+      llvm::sort(words);
+      words.erase(std::unique(words.begin(), words.end()), words.end());
+      std::fill(wordsPerBank.begin(), wordsPerBank.end(), 0);
+      for (int64_t word : words)
+        ++wordsPerBank[word % kNumBanks];
+      unsigned wavefronts = *llvm::max_element(wordsPerBank);
+      cost.wavefronts += wavefronts;
+      cost.conflicts += wavefronts - 1;
+    }
+  }
+  return cost;
+}
+
+} // namespace
+
+std::optional<SharedAccessCost>
+getSharedAccessCost(RankedTensorType type, SharedEncodingAttr sharedEnc) {
+  std::optional<LinearLayout> layout = toLinearLayout(type);
+  if (!layout)
+    return std::nullopt;
+  return getSharedAccessCost(*layout, type, sharedEnc);
+}
+
+SharedEncodingAttr chooseSharedEncoding(RankedTensorType writerType,
+                                        ArrayRef<RankedTensorType> readerTypes,
+                                        ArrayRef<unsigned> order,
+                                        CTALayoutAttr CTALayout) {
+  SmallVector<RankedTensorType> types{writerType};
+  types.append(readerTypes.begin(), readerTypes.end());
+  SmallVector<LinearLayout> layouts;
+  for (RankedTensorType type : types) {
+    std::optional<LinearLayout> layout = toLinearLayout(type);
+    if (!layout)
+      return SharedEncodingAttr();
+    layouts.push_back(std::move(*layout));
+  }
+
+  unsigned elemBytes = getElementBytes(writerType);
+  int64_t rowSize = writerType.getShape()[order[0]];
+  unsigned maxVec = std::min<int64_t>(kMaxAccessBytes / elemBytes, rowSize);
+  // The rows of 1D tensors can't be swizzled
+  unsigned maxSwizzle = order.size() > 1 ? kNumBanks : 1;
+  SharedEncodingAttr best;
+  unsigned bestWavefronts = 0;
+  for (unsigned maxPhase = 1; maxPhase <= maxSwizzle; maxPhase *= 2) {
+    for (unsigned perPhase = 1; perPhase <= (maxPhase > 1 ? 8 : 1);
+         perPhase *= 2) {
+      for (unsigned vec = std::max(maxVec, 1u); vec >= 1; vec /= 2) {
+        // Swizzled vectors narrower than a bank would split the cp.async
+        // copies filling the buffer
+        if (maxPhase > 1 &&
+            (vec * elemBytes < kBankBytes || vec * maxPhase > rowSize))
+          continue;
+        auto sharedEnc =
+            SharedEncodingAttr::get(writerType.getContext(), vec, perPhase,
+                                    maxPhase, order, CTALayout, false);
+        unsigned wavefronts = 0;
+        for (auto [layout, type] : llvm::zip(layouts, types))
+          wavefronts +=
+              getSharedAccessCost(layout, type, sharedEnc).wavefronts;
+        if (!best || wavefronts < bestWavefronts) {
+          best = sharedEnc;
+          bestWavefronts = wavefronts;
+        }
+      }
+    }
+  }
+  return best;
+}
+
+} // namespace mlir
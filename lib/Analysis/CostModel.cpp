@@ -0,0 +1,364 @@
+#include "triton/Analysis/CostModel.h"
+#include "mlir/Dialect/GPU/IR/GPUDialect.h"
+#include "mlir/Dialect/SCF/IR/SCF.h"
+#include "mlir/IR/Matchers.h"
+#include "triton/Analysis/RegisterPressure.h"
+#include "triton/Dialect/Triton/IR/Types.h"
+#include "triton/Dialect/TritonNvidiaGPU/IR/Dialect.h"
+
+#include <numeric>
+
+namespace mlir {
+
+using namespace triton;
+using namespace triton::gpu;
+
+namespace {
+
+int64_t getNumElements(ArrayRef<int64_t> shape) {
+  return std::accumulate(shape.begin(), shape.end(), int64_t(1),
+                         std::multiplies{});
+}
+
+// The size of an element in memory, in bytes
+unsigned getElementBytes(Type elemTy) {
+  if (elemTy.isa<PointerType>())
+    return 8;
+  return std::max<unsigned>(8, elemTy.getIntOrFloatBitWidth()) / 8;
+}
+
+// Returns the coordinates of the first element held by each lane of the first
+// warp, or nothing for layouts other than blocked ones and their slices.
+std::optional<SmallVector<SmallVector<unsigned>>>
+getLaneCoordinates(Attribute layout, unsigned numLanes) {
+  if (auto blocked = layout.dyn_cast<BlockedEncodingAttr>()) {
+    auto threadsPerWarp = blocked.getThreadsPerWarp();
+    auto sizePerThread = blocked.getSizePerThread();
+    SmallVector<SmallVector<unsigned>> coords;
+    for (unsigned lane = 0; lane < numLanes; ++lane) {
+      SmallVector<unsigned> coord(threadsPerWarp.size());
+      unsigned remaining = lane;
+      for (unsigned dim : blocked.getOrder()) {
+        coord[dim] = remaining % threadsPerWarp[dim] * sizePerThread[dim];
+        remaining /= threadsPerWarp[dim];
+      }
+      coords.push_back(coord);
+    }
+    return coords;
+  }
+  if (auto slice = layout.dyn_cast<SliceEncodingAttr>()) {
+    auto coords = getLaneCoordinates(slice.getParent(), numLanes);
+    if (!coords)
+      return std::nullopt;
+    for (auto &coord : *coords)
+      coord.erase(coord.begin() + slice.getDim());
+    return coords;
+  }
+  return std::nullopt;
+}
+
+// Returns the number of shared memory wavefronts of the accesses of `vec`
+// elements of the lanes at `coords`, over the conflict-free number. The
+// scratch buffer of shape `paddedRepShape`, in `order`, holds `repShape`
+// elements.
+unsigned getBankConflicts(ArrayRef<SmallVector<unsigned>> coords,
+                          ArrayRef<unsigned> repShape,
+                          ArrayRef<unsigned> paddedRepShape,
+                          ArrayRef<unsigned> order, unsigned vec,
+                          unsigned elemBytes) {
+  constexpr unsigned kNumBanks = 32;
+  constexpr unsigned kBankBytes = 4;
+  SmallVector<int64_t> strides(order.size());
+  int64_t stride = 1;
+  for (unsigned dim : order) {
+    strides[dim] = stride;
+    stride *= paddedRepShape[dim];
+  }
+  // A warp access is served by phases of at most 128 bytes
+  unsigned accessBytes = vec * elemBytes;
+  unsigned numWords = std::max(1u, accessBytes / kBankBytes);
+  unsigned lanesPerPhase = std::max(1u, kNumBanks * kBankBytes / accessBytes);
+  unsigned worst = 1;
+  for (unsigned first = 0; first < coords.size(); first += lanesPerPhase) {
+    SmallVector<DenseSet<int64_t>> banks(kNumBanks);
+    unsigned last = std::min<unsigned>(first + lanesPerPhase, coords.size());
+    for (unsigned lane = first; lane < last; ++lane) {
+      int64_t offset = 0;
+      for (unsigned dim = 0; dim < coords[lane].size(); ++dim)
+        offset += coords[lane][dim] % repShape[dim] * strides[dim];
+      int64_t word = offset * elemBytes / kBankBytes;
+      for (unsigned i = 0; i < numWords; ++i)
+        banks[(word + i) % kNumBanks].insert(word + i);
+    }
+    for (auto &bank : banks)
+      worst = std::max<unsigned>(worst, bank.size());
+  }
+  return worst;
+}
+
+ConvertLayoutCost getCost(ConvertLayoutOp op, unsigned numLanes) {
+  auto srcTy = op.getSrc().getType().cast<RankedTensorType>();
+  auto dstTy = op.getType().cast<RankedTensorType>();
+  unsigned elemBytes = getElementBytes(srcTy.getElementType());
+  int64_t bytes = getNumElements(getShapePerCTA(srcTy)) * elemBytes;
+  ConvertLayoutCost cost;
+  // Conversions from and to shared memory read or write it once
+  if (srcTy.getEncoding().isa<SharedEncodingAttr>() ||
+      dstTy.getEncoding().isa<SharedEncodingAttr>()) {
+    cost.sharedBytes = bytes;
+    return cost;
+  }
+  unsigned inVec = 0;
+  unsigned outVec = 0;
+  auto paddedRepShape = getScratchConfigForCvtLayout(op, inVec, outVec);
+  if (paddedRepShape.empty())
+    return cost;
+  cost.sharedBytes = 2 * bytes;
+  auto repShape = getRepShapeForCvtLayout(op);
+  auto [inOrd, outOrd] = getCvtOrder(srcTy.getEncoding(), dstTy.getEncoding());
+  auto srcCoords = getLaneCoordinates(srcTy.getEncoding(), numLanes);
+  auto dstCoords = getLaneCoordinates(dstTy.getEncoding(), numLanes);
+  if (srcCoords)
+    cost.bankConflicts =
+        std::max(cost.bankConflicts,
+                 getBankConflicts(*srcCoords, repShape, paddedRepShape, outOrd,
+                                  inVec, elemBytes));
+  if (dstCoords)
+    cost.bankConflicts =
+        std::max(cost.bankConflicts,
+                 getBankConflicts(*dstCoords, repShape, paddedRepShape, outOrd,
+                                  outVec, elemBytes));
+  return cost;
+}
+
+// Returns the M, N and K of an MMA instruction of `layout`, or nothing if it
+// isn't an MMA layout.
+std::optional<std::array<int64_t, 3>> getMmaInstrShape(Attribute layout,
+                                                       unsigned bitWidth) {
+  if (auto mma = layout.dyn_cast<NvidiaMmaEncodingAttr>()) {
+    if (mma.isVolta())
+      return std::array<int64_t, 3>{16, 16, 4};
+    if (mma.isAmpere())
+      return std::array<int64_t, 3>{16, 8, 256 / bitWidth};
+    if (mma.isHopper())
+      return std::array<int64_t, 3>{64, mma.getInstrShape()[1],
+                                    256 / bitWidth};
+  }
+  if (auto mfma = layout.dyn_cast<MfmaEncodingAttr>()) {
+    int64_t nonKDim = mfma.getNonKDim();
+    return std::array<int64_t, 3>{nonKDim, nonKDim,
+                                  (nonKDim == 32 ? 128 : 256) / bitWidth};
+  }
+  return std::nullopt;
+}
+
+} // namespace
+
+std::optional<int64_t> getTripCount(scf::ForOp forOp) {
+  APInt lb, ub, step;
+  if (!matchPattern(forOp.getLowerBound(), m_ConstantInt(&lb)) ||
+      !matchPattern(forOp.getUpperBound(), m_ConstantInt(&ub)) ||
+      !matchPattern(forOp.getStep(), m_ConstantInt(&step)) ||
+      step.getSExtValue() <= 0)
+    return std::nullopt;
+  int64_t range = ub.getSExtValue() - lb.getSExtValue();
+  if (range <= 0)
+    return 0;
+  return (range + step.getSExtValue() - 1) / step.getSExtValue();
+}
+
+void KernelCost::add(const KernelCost &other, int64_t count) {
+  globalLoadBytes += other.globalLoadBytes * count;
+  globalStoreBytes += other.globalStoreBytes * count;
+  globalLoadAccesses += other.globalLoadAccesses * count;
+  globalStoreAccesses += other.globalStoreAccesses * count;
+  sharedBytes += other.sharedBytes * count;
+  maxBankConflicts = std::max(maxBankConflicts, other.maxBankConflicts);
+  mmaCount += other.mmaCount * count;
+  dotFlops += other.dotFlops * count;
+  barrierCount += other.barrierCount * count;
+  hasDynamicLoops |= other.hasDynamicLoops;
+  llvmSize += other.llvmSize;
+}
+
+int estimateOccupancy(int computeCapability, int numWarps, int threadsPerWarp,
+                      size_t sharedMemory) {
+  struct SMLimits {
+    size_t sharedMemory;
+    int threads;
+    int ctas;
+  };
+  SMLimits limits = {48 * 1024, 2048, 16};
+  if (computeCapability >= 90)
+    limits = {228 * 1024, 2048, 32};
+  else if (computeCapability == 89)
+    limits = {100 * 1024, 1536, 24};
+  else if (computeCapability == 86)
+    limits = {100 * 1024, 1536, 16};
+  else if (computeCapability >= 80)
+    limits = {164 * 1024, 2048, 32};
+  else if (computeCapability == 75)
+    limits = {64 * 1024, 1024, 16};
+  else if (computeCapability >= 70)
+    limits = {96 * 1024, 2048, 32};
+  int occupancy =
+      std::min(limits.ctas, limits.threads / (numWarps * threadsPerWarp));
+  if (sharedMemory > 0) {
+    // The driver reserves 1KB of shared memory per CTA since sm80
+    size_t perCTA = sharedMemory + (computeCapability >= 80 ? 1024 : 0);
+    occupancy = std::min<int64_t>(occupancy, limits.sharedMemory / perCTA);
+  }
+  return occupancy;
+}
+
+ModuleCostAnalysis::ModuleCostAnalysis(ModuleOp moduleOp)
+    : CallGraph<KernelCost>(moduleOp), axisInfoAnalysis(moduleOp),
+      allocation(moduleOp) {
+  // Callees first, so that their cost is known at their calls
+  walk<WalkOrder::PreOrder, WalkOrder::PostOrder>(
+      [](CallOpInterface callOp, FunctionOpInterface funcOp) {},
+      [&](FunctionOpInterface funcOp) {
+        auto [iter, inserted] = funcMap.try_emplace(funcOp, KernelCost{});
+        if (!inserted)
+          return;
+        KernelCost cost;
+        for (Block &block : funcOp.getFunctionBody())
+          accumulate(&block, 1, cost);
+        funcMap[funcOp] = cost;
+      });
+}
+
+int ModuleCostAnalysis::getOccupancy() {
+  ModuleOp moduleOp = getModuleOp();
+  auto computeCapability =
+      moduleOp->getAttrOfType<IntegerAttr>("triton_gpu.compute-capability");
+  return estimateOccupancy(
+      computeCapability ? computeCapability.getInt() : 80,
+      TritonGPUDialect::getNumWarps(moduleOp),
+      TritonGPUDialect::getThreadsPerWarp(moduleOp), getSharedMemorySize());
+}
+
+void ModuleCostAnalysis::accumulate(Block *block, int64_t count,
+                                    KernelCost &cost) {
+  for (Operation &op : *block) {
+    if (auto forOp = dyn_cast<scf::ForOp>(op)) {
+      auto tripCount = getTripCount(forOp);
+      if (!tripCount)
+        cost.hasDynamicLoops = true;
+      accumulate(forOp.getBody(), count * tripCount.value_or(1), cost);
+    } else if (isa<scf::IfOp, scf::WhileOp>(op)) {
+      // Both branches of an `if` are counted, as an upper bound
+      if (isa<scf::WhileOp>(op))
+        cost.hasDynamicLoops = true;
+      for (Region &region : op.getRegions())
+        for (Block &nested : region)
+          accumulate(&nested, count, cost);
+    } else {
+      accumulate(&op, count, cost);
+    }
+  }
+}
+
+void ModuleCostAnalysis::accumulate(Operation *op, int64_t count,
+                                    KernelCost &cost) {
+  ModuleOp moduleOp = getModuleOp();
+  int numLanes = TritonGPUDialect::getThreadsPerWarp(moduleOp);
+  auto funcOp = op->getParentOfType<FunctionOpInterface>();
+  // Stores have no results, so the operands count as well
+  int64_t size = 1;
+  for (Value value : op->getOperands())
+    if (value.getType().isa<RankedTensorType>())
+      size = std::max<int64_t>(size, getNumRegisters(value.getType()));
+  for (Type type : op->getResultTypes())
+    if (type.isa<RankedTensorType>())
+      size = std::max<int64_t>(size, getNumRegisters(type));
+  cost.llvmSize += size;
+
+  // Global memory accesses of `numElements` elements of `elemBits`, vectorized
+  // by `vec` elements
+  auto addGlobalAccess = [&](int64_t numElements, unsigned elemBits,
+                             unsigned vec, bool isStore) {
+    unsigned elemBytes = std::max(8u, elemBits) / 8;
+    vec = std::max(1u, std::min(vec, 128 / (elemBytes * 8)));
+    int64_t accesses = (numElements + vec - 1) / vec;
+    int64_t bytes = numElements * elemBytes;
+    if (isStore) {
+      cost.globalStoreBytes += bytes * count;
+      cost.globalStoreAccesses += accesses * count;
+    } else {
+      cost.globalLoadBytes += bytes * count;
+      cost.globalLoadAccesses += accesses * count;
+    }
+  };
+  auto addPointerAccess = [&](Value ptr, Value mask, bool isStore) {
+    auto tensorTy = ptr.getType().dyn_cast<RankedTensorType>();
+    if (!tensorTy) {
+      // A scalar, or a block pointer accessing a whole tile at once
+      if (auto ptrTy = ptr.getType().dyn_cast<PointerType>()) {
+        if (auto tileTy = ptrTy.getPointeeType().dyn_cast<RankedTensorType>())
+          addGlobalAccess(getNumElements(getShapePerCTA(tileTy)),
+                          tileTy.getElementTypeBitWidth(), 128, isStore);
+        else
+          addGlobalAccess(1, getPointeeBitWidth(ptrTy), 1, isStore);
+      }
+      return;
+    }
+    unsigned vec = axisInfoAnalysis.getPtrContiguity(ptr);
+    if (mask)
+      vec = std::min(vec, axisInfoAnalysis.getMaskAlignment(mask));
+    addGlobalAccess(getNumElements(getShapePerCTA(tensorTy)),
+                    getPointeeBitWidth(tensorTy), vec, isStore);
+  };
+
+  if (auto loadOp = dyn_cast<LoadOp>(op)) {
+    addPointerAccess(loadOp.getPtr(), loadOp.getMask(), /*isStore=*/false);
+  } else if (auto storeOp = dyn_cast<StoreOp>(op)) {
+    addPointerAccess(storeOp.getPtr(), storeOp.getMask(), /*isStore=*/true);
+  } else if (auto insertOp = dyn_cast<InsertSliceAsyncOp>(op)) {
+    addPointerAccess(insertOp.getSrc(), insertOp.getMask(), /*isStore=*/false);
+    auto srcTy = insertOp.getSrc().getType().cast<RankedTensorType>();
+    cost.sharedBytes += getNumElements(getShapePerCTA(srcTy)) *
+                        (std::max(8u, getPointeeBitWidth(srcTy)) / 8) * count;
+  } else if (auto cvtOp = dyn_cast<ConvertLayoutOp>(op)) {
+    ConvertLayoutCost cvtCost = getCost(cvtOp, numLanes);
+    if (cvtCost.sharedBytes > 0)
+      convertLayoutCosts[op] = cvtCost;
+    cost.sharedBytes += cvtCost.sharedBytes * count;
+    cost.maxBankConflicts =
+        std::max(cost.maxBankConflicts, cvtCost.bankConflicts);
+  } else if (isa<DotOp, nvidia_gpu::DotAsyncOp>(op)) {
+    // a, b, c -> d
+    auto aTy = op->getOperand(0).getType().cast<RankedTensorType>();
+    auto dTy = op->getResult(0).getType().cast<RankedTensorType>();
+    auto aShape = getShapePerCTA(aTy);
+    auto dShape = getShapePerCTA(dTy);
+    int64_t m = dShape[0], n = dShape[1], k = aShape[1];
+    cost.dotFlops += 2 * m * n * k * count;
+    unsigned bitWidth = aTy.getElementTypeBitWidth();
+    if (auto instr = getMmaInstrShape(dTy.getEncoding(), bitWidth))
+      cost.mmaCount +=
+          m * n * k / ((*instr)[0] * (*instr)[1] * (*instr)[2]) * count;
+    // wgmma reads its operands from shared memory
+    for (Value operand : op->getOperands().take_front(2)) {
+      auto operandTy = operand.getType().cast<RankedTensorType>();
+      if (operandTy.getEncoding().isa<SharedEncodingAttr>())
+        cost.sharedBytes += getNumElements(getShapePerCTA(operandTy)) *
+                            getElementBytes(operandTy.getElementType()) *
+                            count;
+    }
+  } else if (isa<mlir::gpu::BarrierOp>(op)) {
+    cost.barrierCount += count;
+  } else if (auto callOp = dyn_cast<CallOpInterface>(op)) {
+    auto callee = dyn_cast_or_null<FunctionOpInterface>(
+        callOp.resolveCallable());
+    if (KernelCost *calleeCost = callee ? getFuncData(callee) : nullptr)
+      cost.add(*calleeCost, count);
+  }
+  // The accesses of scratch buffers are separated by barriers
+  Allocation *funcAllocation = allocation.getFuncData(funcOp);
+  if (funcAllocation &&
+      funcAllocation->getBufferId(op) != Allocation::InvalidBufferId)
+    cost.barrierCount += count;
+}
+
+} // namespace mlir
@@ -14,6 +14,123 @@
 
 namespace mlir {
 
+namespace {
+
+/// Returns the linear ids of the warps owning each element along each
+/// dimension of `type` in the blocked `layout`, or an empty vector if some
+/// elements are owned by several warps.
+SmallVector<SmallVector<unsigned>> getWarpIds(RankedTensorType type,
+                                              Attribute layout) {
+  auto blocked = layout.cast<triton::gpu::BlockedEncodingAttr>();
+  auto shapePerCTA = triton::gpu::getShapePerCTA(type);
+  auto warpsPerCTA = blocked.getWarpsPerCTA();
+  auto order = blocked.getOrder();
+  SmallVector<unsigned> strides(shapePerCTA.size());
+  unsigned stride = 1;
+  for (unsigned d : order) {
+    strides[d] = stride;
+    stride *= warpsPerCTA[d];
+  }
+  SmallVector<SmallVector<unsigned>> warpIds(shapePerCTA.size());
+  for (unsigned d = 0; d < shapePerCTA.size(); ++d) {
+    unsigned warpTile =
+        blocked.getSizePerThread()[d] * blocked.getThreadsPerWarp()[d];
+    // The tensor is too small for the warps and is replicated across them
+    if (warpsPerCTA[d] > 1 && shapePerCTA[d] < warpTile * warpsPerCTA[d])
+      return {};
+    for (int64_t i = 0; i < shapePerCTA[d]; ++i)
+      warpIds[d].push_back(i / warpTile % warpsPerCTA[d] * strides[d]);
+  }
+  return warpIds;
+}
+
+/// Returns the smallest groups of warps that the blocked layouts `lhs` and
+/// `rhs` of `type` both map each element to (see BarrierWarps), or
+/// kCTABarrier.
+BarrierWarps getWarpGroupSize(RankedTensorType type, Attribute lhs,
+                              Attribute rhs) {
+  if (triton::gpu::getCTALayout(lhs) != triton::gpu::getCTALayout(rhs))
+    return kCTABarrier;
+  auto lhsWarpIds = getWarpIds(type, lhs);
+  auto rhsWarpIds = getWarpIds(type, rhs);
+  if (lhsWarpIds.empty() || rhsWarpIds.empty())
+    return kCTABarrier;
+  // The pairs of warps owning the same element in the two layouts
+  std::set<std::pair<unsigned, unsigned>> warpPairs = {{0, 0}};
+  for (unsigned d = 0; d < lhsWarpIds.size(); ++d) {
+    std::set<std::pair<unsigned, unsigned>> dimPairs;
+    for (unsigned i = 0; i < lhsWarpIds[d].size(); ++i)
+      dimPairs.insert({lhsWarpIds[d][i], rhsWarpIds[d][i]});
+    std::set<std::pair<unsigned, unsigned>> pairs;
+    for (auto [lhsWarp, rhsWarp] : warpPairs)
+      for (auto [lhsDimWarp, rhsDimWarp] : dimPairs)
+        pairs.insert({lhsWarp + lhsDimWarp, rhsWarp + rhsDimWarp});
+    warpPairs = std::move(pairs);
+  }
+  unsigned numWarps = triton::gpu::getNumWarpsPerCTA(lhs);
+  for (unsigned warps = 1; warps < numWarps; warps *= 2)
+    if (llvm::all_of(warpPairs, [&](auto pair) {
+          return pair.first / warps == pair.second / warps;
+        }))
+      return warps;
+  return kCTABarrier;
+}
+
+/// Returns true if the blocked `layout` of `type` maps each element to a
+/// single thread.
+bool isOwnedOnce(RankedTensorType type, Attribute layout) {
+  auto blocked = layout.cast<triton::gpu::BlockedEncodingAttr>();
+  auto shapePerCTA = triton::gpu::getShapePerCTA(type);
+  for (unsigned d = 0; d < shapePerCTA.size(); ++d)
+    if (shapePerCTA[d] < blocked.getSizePerThread()[d] *
+                             blocked.getThreadsPerWarp()[d] *
+                             blocked.getWarpsPerCTA()[d])
+      return false;
+  return true;
+}
+
+/// Returns the barrier needed before the access `cur` if it follows `prev`.
+BarrierWarps getAccessBarrierWarps(const BlockInfo::Access &prev,
+                                   const BlockInfo::Access &cur) {
+  if (!prev.interval.intersects(cur.interval))
+    return kNoBarrier;
+  // Different tensors, or tensors accessed by any thread, may place any
+  // element at any address.
+  if (prev.interval != cur.interval || !prev.owner.layout ||
+      !cur.owner.layout || prev.owner.type != cur.owner.type)
+    return kCTABarrier;
+  // Threads that own the same elements in both accesses only read their own
+  // writes, or only write what they have read.
+  auto type = prev.owner.type.cast<RankedTensorType>();
+  if (prev.owner.layout == cur.owner.layout &&
+      isOwnedOnce(type, prev.owner.layout))
+    return kNoBarrier;
+  auto warps = getWarpGroupSize(type, prev.owner.layout, cur.owner.layout);
+  // Groups of warps that synchronized since contain the smaller ones
+  return warps <= prev.syncedWarps ? kNoBarrier : warps;
+}
+
+} // namespace
+
+BarrierWarps BlockInfo::getBarrierWarps(const AccessSetT &lhsAccessSet,
+                                        const AccessSetT &rhsAccessSet) {
+  BarrierWarps warps = kNoBarrier;
+  for (auto &lhs : lhsAccessSet)
+    for (auto &rhs : rhsAccessSet) {
+      warps = std::max(warps, getAccessBarrierWarps(lhs, rhs));
+      if (warps == kCTABarrier)
+        return warps;
+    }
+  return warps;
+}
+
+BarrierWarps BlockInfo::getBarrierWarps(const BlockInfo &other) const {
+  auto raw = getBarrierWarps(syncWriteIntervals, other.syncReadIntervals);
+  auto war = getBarrierWarps(syncReadIntervals, other.syncWriteIntervals);
+  auto waw = getBarrierWarps(syncWriteIntervals, other.syncWriteIntervals);
+  return std::max({raw, war, waw});
+}
+
 void MembarAnalysis::run(FuncBlockInfoMapT &funcBlockInfoMap) {
   FunctionOpInterface funcOp =
       dyn_cast<FunctionOpInterface>(allocation->getOperation());
@@ -97,10 +214,45 @@ void MembarAnalysis::visitTerminator(Operation *op,
   llvm_unreachable("Unknown terminator encountered in membar analysis");
 }
 
-void MembarAnalysis::insertBarrier(Operation *op, OpBuilder *builder) {
+BarrierWarps MembarAnalysis::insertBarrier(Operation *op, OpBuilder *builder,
+                                           BarrierWarps warps) {
   OpBuilder::InsertionGuard g(*builder);
-  auto barrierOp = builder->create<gpu::BarrierOp>(op->getLoc());
-  if (auto optionalAgentId = getWSAgentId(op)) {
+  auto loc = op->getLoc();
+  auto mod = op->getParentOfType<ModuleOp>();
+  auto optionalAgentId = getWSAgentId(op);
+  if (warps == 1) {
+    // Lowered to bar.warp.sync, or to a CTA-wide barrier by backends that
+    // don't support it
+    auto barrierOp = builder->create<gpu::BarrierOp>(loc);
+    barrierOp->setAttr("warp_sync", builder->getUnitAttr());
+    return warps;
+  }
+  // Warp specialized kernels use the named barriers
+  bool isWarpSpecialized = optionalAgentId ||
+                           mod->hasAttr("async.num-agents") ||
+                           mod->hasAttr("triton_gpu.num-warp-groups-per-cta");
+  int numWarps = triton::gpu::TritonGPUDialect::getNumWarps(mod);
+  int numGroups = warps < (unsigned)numWarps ? numWarps / warps : 1;
+  if (useNamedBarriers && !isWarpSpecialized && numGroups > 1 &&
+      nameBarrierIdBegin + numGroups <= nameBarrierIdEnd) {
+    // The warps of each group synchronize on a named barrier of their own
+    int threadsPerWarp = triton::gpu::TritonGPUDialect::getThreadsPerWarp(mod);
+    Value warpId = builder->create<triton::nvidia_gpu::GetCanonicalWarpId>(
+        loc, builder->getI32Type());
+    Value groupSize = builder->create<arith::ConstantIntOp>(loc, warps, 32);
+    Value group = builder->create<arith::DivUIOp>(loc, warpId, groupSize);
+    Value barBegin =
+        builder->create<arith::ConstantIntOp>(loc, nameBarrierIdBegin, 32);
+    Value barId = builder->create<arith::AddIOp>(loc, group, barBegin);
+    Value numThreads =
+        builder->create<arith::ConstantIntOp>(loc, warps * threadsPerWarp, 32);
+    auto barrierOp = builder->create<triton::nvidia_gpu::NamedBarrierWaitOp>(
+        loc, barId, numThreads);
+    barrierOp->setAttr("warps_per_group", builder->getI32IntegerAttr(warps));
+    return warps;
+  }
+  auto barrierOp = builder->create<gpu::BarrierOp>(loc);
+  if (optionalAgentId) {
     int agentId = *optionalAgentId, roleId = 0;
     if (auto optionalRoleId = getWSRoleId(op))
       roleId = *optionalRoleId;
@@ -112,6 +264,26 @@ void MembarAnalysis::insertBarrier(Operation *op, OpBuilder *builder) {
     barrierOp->setAttr("bar_id", builder->getI64IntegerAttr(barId));
     barrierOp->setAttr("num_threads", builder->getI64IntegerAttr(numThreads));
   }
+  return kCTABarrier;
+}
+
+AccessOwnership MembarAnalysis::getOwnership(Operation *op, Value value) {
+  auto cvtOp = dyn_cast<triton::gpu::ConvertLayoutOp>(op);
+  if (!cvtOp)
+    return {};
+  // Only a tensor's own buffer is known to hold it from its first address,
+  // e.g. not a slice of it or a block argument that may be another tensor.
+  auto bufferIds = allocation->getBufferIds(value);
+  if (bufferIds.size() != 1 ||
+      *bufferIds.begin() != allocation->getBufferId(value))
+    return {};
+  // Blocked layouts are converted from and to shared memory one element at a
+  // time by the threads owning them.
+  Value other = value == cvtOp.getSrc() ? cvtOp.getResult() : cvtOp.getSrc();
+  auto layout = other.getType().cast<RankedTensorType>().getEncoding();
+  if (!layout.isa<triton::gpu::BlockedEncodingAttr>())
+    return {};
+  return {value.getType(), layout};
 }
 
 void MembarAnalysis::update(Operation *op, BlockInfo *blockInfo,
@@ -126,7 +298,17 @@ void MembarAnalysis::update(Operation *op, BlockInfo *blockInfo,
 
   if (isa<gpu::BarrierOp>(op)) {
     // If the current op is a barrier, we sync previous reads and writes
-    blockInfo->sync();
+    if (op->hasAttr("warp_sync"))
+      blockInfo->sync(1);
+    else
+      blockInfo->sync();
+    return;
+  }
+
+  if (isa<triton::nvidia_gpu::NamedBarrierWaitOp>(op) &&
+      op->hasAttr("warps_per_group")) {
+    // A barrier over groups of warps inserted by a previous visit
+    blockInfo->sync(op->getAttrOfType<IntegerAttr>("warps_per_group").getInt());
     return;
   }
 
@@ -140,6 +322,14 @@ void MembarAnalysis::update(Operation *op, BlockInfo *blockInfo,
     return;
   }
 
+  if (auto arriveOp = dyn_cast<triton::nvidia_gpu::MBarrierArriveOp>(op)) {
+    // The async copies of the thread arrive on the mbarrier once done
+    if (arriveOp.getTrackAsyncOp())
+      blockInfo->trackAsyncCopies();
+  } else if (isa<triton::nvidia_gpu::MBarrierWaitOp>(op)) {
+    blockInfo->syncTrackedAsyncCopies();
+  }
+
   BlockInfo curBlockInfo;
   if (isa<triton::CallOp>(op)) {
     // Inter-function dependencies
@@ -147,6 +337,8 @@ void MembarAnalysis::update(Operation *op, BlockInfo *blockInfo,
     if (auto callee =
             dyn_cast<FunctionOpInterface>(callOpInterface.resolveCallable())) {
       curBlockInfo = funcBlockInfoMap->lookup(callee);
+      // The intervals are the callee's
+      curBlockInfo.eraseOwnership();
     }
   } else {
     // Intra-function dependencies
@@ -159,11 +351,17 @@ void MembarAnalysis::update(Operation *op, BlockInfo *blockInfo,
             // FIXME(Keren): insert_slice and insert_slice_async are always
             // alias for now
             curBlockInfo.syncWriteIntervals.insert(
-                allocation->getAllocatedInterval(bufferId));
+                {allocation->getAllocatedInterval(bufferId),
+                 {},
+                 kNoBarrier,
+                 isa<triton::gpu::InsertSliceAsyncOp>(op)
+                     ? BlockInfo::AsyncCopy::Untracked
+                     : BlockInfo::AsyncCopy::None});
           } else {
             // ConvertLayoutOp: shared memory -> registers
             curBlockInfo.syncReadIntervals.insert(
-                allocation->getAllocatedInterval(bufferId));
+                {allocation->getAllocatedInterval(bufferId),
+                 getOwnership(op, value)});
           }
         }
       }
@@ -173,23 +371,28 @@ void MembarAnalysis::update(Operation *op, BlockInfo *blockInfo,
       auto bufferId = allocation->getBufferId(value);
       if (bufferId != Allocation::InvalidBufferId) {
         curBlockInfo.syncWriteIntervals.insert(
-            allocation->getAllocatedInterval(bufferId));
+            {allocation->getAllocatedInterval(bufferId),
+             getOwnership(op, value)});
       }
     }
     // Scratch buffer is considered as both shared memory write & read
     auto bufferId = allocation->getBufferId(op);
     if (bufferId != Allocation::InvalidBufferId) {
       curBlockInfo.syncWriteIntervals.insert(
-          allocation->getAllocatedInterval(bufferId));
+          {allocation->getAllocatedInterval(bufferId)});
       curBlockInfo.syncReadIntervals.insert(
-          allocation->getAllocatedInterval(bufferId));
+          {allocation->getAllocatedInterval(bufferId)});
     }
   }
 
-  if (blockInfo->isIntersected(curBlockInfo)) {
+  auto warps = blockInfo->getBarrierWarps(curBlockInfo);
+  if (warps != kNoBarrier) {
     builder->setInsertionPoint(op);
-    insertBarrier(op, builder);
-    blockInfo->sync();
+    warps = insertBarrier(op, builder, warps);
+    if (warps == kCTABarrier)
+      blockInfo->sync();
+    else
+      blockInfo->sync(warps);
   }
   // Update the region info, even if barrier is inserted, we have to maintain
   // the current op's read/write buffers.
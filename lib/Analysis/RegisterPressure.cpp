@@ -0,0 +1,120 @@
+#include "triton/Analysis/RegisterPressure.h"
+#include "mlir/Analysis/Liveness.h"
+#include "mlir/Dialect/Arith/IR/Arith.h"
+#include "triton/Dialect/Triton/IR/Types.h"
+#include "triton/Dialect/TritonGPU/IR/Dialect.h"
+
+namespace mlir {
+
+using namespace triton;
+using namespace triton::gpu;
+
+// Whether the number of elements per thread of `layout` is known. The mma
+// layouts without a version, in some tests, don't have one.
+static bool hasElemsPerThread(Attribute layout) {
+  if (auto mma = layout.dyn_cast<NvidiaMmaEncodingAttr>())
+    return mma.isVolta() || mma.isAmpere() || mma.isHopper();
+  if (auto dotOpEnc = layout.dyn_cast<DotOperandEncodingAttr>())
+    return hasElemsPerThread(dotOpEnc.getParent());
+  if (auto slice = layout.dyn_cast<SliceEncodingAttr>())
+    return hasElemsPerThread(slice.getParent());
+  return true;
+}
+
+unsigned getNumRegisters(Type type) {
+  auto getScalarRegisters = [](Type elemTy) -> unsigned {
+    if (elemTy.isa<PointerType>())
+      return 2;
+    if (elemTy.isIntOrFloat())
+      return std::max(1u, elemTy.getIntOrFloatBitWidth() / 32);
+    return 1;
+  };
+  auto tensorTy = type.dyn_cast<RankedTensorType>();
+  if (!tensorTy)
+    return getScalarRegisters(type);
+  Attribute layout = tensorTy.getEncoding();
+  if (!layout || layout.isa<SharedEncodingAttr>())
+    return 1;
+  if (!hasElemsPerThread(layout))
+    return 0;
+  Type elemTy = tensorTy.getElementType();
+  unsigned numElems = getTotalElemsPerThread(tensorTy);
+  // The operands of mma v2 are already counted in 32-bit words
+  if (auto dotOpEnc = layout.dyn_cast<DotOperandEncodingAttr>())
+    if (auto mma = dotOpEnc.getParent().dyn_cast<NvidiaMmaEncodingAttr>())
+      if (mma.isAmpere())
+        return numElems;
+  if (elemTy.isa<PointerType>()) {
+    auto contigPerThread =
+        getUniqueContigPerThread(layout, tensorTy.getShape());
+    unsigned contig = contigPerThread[getOrder(layout)[0]];
+    return std::max(1u, numElems / std::max(1u, contig)) * 2;
+  }
+  if (!elemTy.isIntOrFloat())
+    return numElems;
+  // Masks are held one per register
+  unsigned bitWidth = elemTy.isInteger(1)
+                          ? 32
+                          : std::max(8u, elemTy.getIntOrFloatBitWidth());
+  return (numElems * bitWidth + 31) / 32;
+}
+
+// Returns whether `value`, live at `op`, is live in the regions of `op`: it is
+// used in them, or after `op`. Values defined outside of a loop and used in it
+// are live in the whole loop.
+static bool isLiveInRegions(Value value, Operation *op,
+                            const Liveness &liveness) {
+  if (value.getDefiningOp() == op)
+    return false;
+  if (!liveness.isDeadAfter(value, op))
+    return true;
+  return llvm::any_of(value.getUsers(), [&](Operation *user) {
+    return op->isProperAncestor(user);
+  });
+}
+
+RegisterPressureAnalysis::RegisterPressureAnalysis(Operation *funcOp) {
+  Liveness liveness(funcOp);
+  // Values live in the regions of each op with regions
+  DenseMap<Operation *, Liveness::ValueSetT> liveAcross;
+  funcOp->walk<WalkOrder::PreOrder>([&](Operation *op) {
+    if (op == funcOp)
+      return;
+    Block *block = op->getBlock();
+    const LivenessBlockInfo *blockInfo = liveness.getLiveness(block);
+    if (!blockInfo)
+      return;
+    Liveness::ValueSetT live = blockInfo->currentlyLiveValues(op);
+    // The values live in the enclosing regions are live in all of them
+    Liveness::ValueSetT enclosing;
+    auto it = liveAcross.find(block->getParentOp());
+    if (it != liveAcross.end())
+      enclosing = it->second;
+    unsigned registers = 0;
+    for (Value value : live)
+      if (!enclosing.contains(value) &&
+          !value.getDefiningOp<arith::ConstantOp>())
+        registers += getNumRegisters(value.getType());
+    for (Value value : enclosing)
+      if (!value.getDefiningOp<arith::ConstantOp>())
+        registers += getNumRegisters(value.getType());
+    pressure[op] = registers;
+    maxPressure = std::max(maxPressure, registers);
+    if (op->getNumRegions() == 0)
+      return;
+    for (Value value : live)
+      if (isLiveInRegions(value, op, liveness))
+        enclosing.insert(value);
+    liveAcross[op] = std::move(enclosing);
+  });
+}
+
+unsigned RegisterPressureAnalysis::getMaxRegisters(Operation *op) const {
+  unsigned registers = 0;
+  op->walk([&](Operation *nested) {
+    registers = std::max(registers, pressure.lookup(nested));
+  });
+  return registers;
+}
+
+} // namespace mlir
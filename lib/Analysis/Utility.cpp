@@ -8,6 +8,7 @@
 #include "mlir/IR/Matchers.h"
 #include "triton/Dialect/Triton/IR/Dialect.h"
 #include "triton/Dialect/TritonGPU/IR/Dialect.h"
+#include "triton/Dialect/TritonGPU/IR/LinearLayoutConversions.h"
 #include "triton/Dialect/TritonNvidiaGPU/IR/Dialect.h"
 #include "triton/Tools/Sys/GetEnv.hpp"
 #include <deque>
@@ -169,8 +170,9 @@ bool ReduceOpHelper::isWarpSynchronous() {
 
 SmallVector<unsigned> ReduceOpHelper::getScratchConfig() {
   SmallVector<unsigned> smemShape;
-  // that case doesn't need inter-warp communication
-  if (isWarpSynchronous())
+  // that case doesn't need inter-warp communication, nor inter-CTA
+  // communication through the shared memory
+  if (isWarpSynchronous() && isReduceWithinCTA())
     return {0, 0};
 
   smemShape = convertType<unsigned>(getSrcShape());
@@ -191,21 +193,27 @@ unsigned ReduceOpHelper::getScratchSizeInBytes() {
 }
 
 bool ReduceOpHelper::isReduceWithinCTA() {
+  return getCTASplitNumOnReductionAxis() == 1;
+}
+
+unsigned ReduceOpHelper::getCTASplitNumOnReductionAxis() {
   auto axis = getAxis();
   auto srcLayout = getSrcLayout();
   auto CTASplitNum = mlir::triton::gpu::getCTASplitNum(srcLayout);
   assert(axis < CTASplitNum.size());
-  return CTASplitNum[axis] == 1;
+  return CTASplitNum[axis];
 }
 
 bool ReduceOpHelper::isSupportedLayout() {
-  // Layout optimization passes such as PlanCTAPass and
-  // RemoveLayoutConversionPass should avoid cross-CTA reduction
+  auto srcLayout = getSrcLayout();
+  // The CTAs of a cross-CTA reduction combine their partial reductions
+  // through distributed shared memory. Layout optimization passes such as
+  // PlanCTAPass and RemoveLayoutConversionPass should still avoid it for the
+  // other layouts.
   if (!isReduceWithinCTA()) {
-    return false;
+    return srcLayout.isa<triton::gpu::BlockedEncodingAttr>();
   }
 
-  auto srcLayout = getSrcLayout();
   if (srcLayout.isa<triton::gpu::BlockedEncodingAttr>()) {
     return true;
   }
@@ -298,13 +306,17 @@ bool ScanLoweringHelper::isSupported() {
   return true;
 }
 
+bool ScanLoweringHelper::isChunked() { return getAxisNumBlocks() > 1; }
+
 unsigned ScanLoweringHelper::getScratchSizeInElems() {
   auto mod = scanOp->getParentOfType<ModuleOp>();
   unsigned numWarps = triton::gpu::TritonGPUDialect::getNumWarps(mod);
   unsigned numNonAxisElementsPerWarp =
       getNonAxisNumThreadsPerWarp() * getNonAxisNumElementsPerThread();
+  // The chunked scans only keep the partial reductions of one axis block
+  unsigned numAxisBlocks = isChunked() ? 1 : getAxisNumBlocks();
   unsigned numElements = numWarps * numNonAxisElementsPerWarp *
-                         getAxisNumBlocks() * getNonAxisNumBlocks();
+                         numAxisBlocks * getNonAxisNumBlocks();
   return numElements;
 }
 
@@ -323,6 +335,65 @@ triton::gpu::BlockedEncodingAttr ScanLoweringHelper::getEncoding() {
   return srcEncoding.cast<triton::gpu::BlockedEncodingAttr>();
 }
 
+bool SortLoweringHelper::isSupported() {
+  // TODO: Support the following cases:
+  // 1. Sort on non-blocking encodings
+  // 2. Sort along an axis split across CTAs
+  if (!isa_and_nonnull<triton::gpu::BlockedEncodingAttr>(srcTy.getEncoding()))
+    return false;
+  if (triton::gpu::getCTASplitNum(getEncoding())[getAxis()] != 1)
+    return false;
+  // The contiguous elements of a thread must not wrap around the axis
+  return getAxisSize() >= getAxisSizePerThread();
+}
+
+triton::gpu::BlockedEncodingAttr SortLoweringHelper::getEncoding() {
+  return srcTy.getEncoding().cast<triton::gpu::BlockedEncodingAttr>();
+}
+
+unsigned SortLoweringHelper::getAxisSizePerThread() {
+  return getEncoding().getSizePerThread()[getAxis()];
+}
+
+unsigned SortLoweringHelper::getAxisNumThreadsPerWarp() {
+  return getEncoding().getThreadsPerWarp()[getAxis()];
+}
+
+unsigned SortLoweringHelper::getAxisNumWarps() {
+  return getEncoding().getWarpsPerCTA()[getAxis()];
+}
+
+unsigned SortLoweringHelper::getAxisLaneStride() {
+  auto threadsPerWarp = getEncoding().getThreadsPerWarp();
+  unsigned stride = 1;
+  for (unsigned dim : triton::gpu::getOrder(getEncoding())) {
+    if (dim == getAxis())
+      return stride;
+    stride *= threadsPerWarp[dim];
+  }
+  llvm_unreachable("Axis not found in order");
+}
+
+bool SortLoweringHelper::isAcrossLanes(unsigned distance) {
+  unsigned sizePerThread = getAxisSizePerThread();
+  return distance >= sizePerThread &&
+         distance < sizePerThread * getAxisNumThreadsPerWarp();
+}
+
+bool SortLoweringHelper::isAcrossWarps(unsigned distance) {
+  unsigned sizePerWarp = getAxisSizePerThread() * getAxisNumThreadsPerWarp();
+  return distance >= sizePerWarp && distance < sizePerWarp * getAxisNumWarps();
+}
+
+unsigned SortLoweringHelper::getScratchSizeInBytes() {
+  // The elements are only exchanged through shared memory across warps
+  unsigned sizePerWarp = getAxisSizePerThread() * getAxisNumThreadsPerWarp();
+  if (getAxisNumWarps() == 1 || getAxisSize() <= sizePerWarp)
+    return 0;
+  unsigned numElems = product<int64_t>(triton::gpu::getShapePerCTA(srcTy));
+  return numElems * ceil<unsigned>(srcTy.getElementTypeBitWidth(), 8);
+}
+
 unsigned ScanLoweringHelper::getAxisElementStride() {
   auto order = triton::gpu::getOrder(getEncoding());
   unsigned stride = 1;
@@ -435,6 +506,10 @@ bool supportMFMA(triton::DotOp op) {
   if (!supportMFMATypes(aElemTy, bElemTy))
     return false;
 
+  // Batched dots are only lowered to mma.sync on NVIDIA GPUs
+  if (aTy.getRank() != 2)
+    return false;
+
   auto aShape = aTy.getShape();
   auto bShape = bTy.getShape();
 
@@ -451,6 +526,9 @@ bool supportMMA(triton::DotOp op, int version) {
   // https://docs.nvidia.com/cuda/parallel-thread-execution/index.html#warp-level-matrix-fragment-mma-884-f16
   auto aElemTy = op.getA().getType().cast<RankedTensorType>().getElementType();
   auto bElemTy = op.getB().getType().cast<RankedTensorType>().getElementType();
+  // Batched dots are only lowered to mma.sync, one matrix at a time
+  if (op.getType().cast<RankedTensorType>().getRank() == 3 && version != 2)
+    return false;
   if (version == 3) {
     if (::triton::tools::getBoolEnv("DISABLE_MMA_V3"))
       return false;
@@ -526,6 +604,63 @@ bool isMmaToMmaShortcut(RankedTensorType srcTy, RankedTensorType dstTy) {
   return isMmaToMmaShortcut(srcTy.getEncoding(), dstTy.getEncoding());
 }
 
+// The shared memory the sub-histograms of the warps may take.
+static constexpr unsigned kMaxPrivatizedHistogramBytes = 32 * 1024;
+
+unsigned getNumPrivatizedHistograms(triton::HistogramOp op) {
+  auto dstTy = op.getResult().getType().cast<RankedTensorType>();
+  auto mod = op->getParentOfType<ModuleOp>();
+  int numWarps = triton::gpu::TritonGPUDialect::getNumWarps(mod);
+  int threadsPerWarp = triton::gpu::TritonGPUDialect::getThreadsPerWarp(mod);
+  int64_t numBins = dstTy.getDimSize(0);
+  // The ballots stop paying off once each thread owns several bins
+  if (llvm::isPowerOf2_64(numBins) && numBins <= numWarps * threadsPerWarp)
+    return 0;
+  int64_t binBytes = numBins * (dstTy.getElementTypeBitWidth() / 8);
+  return std::max<int64_t>(
+      1, std::min<int64_t>(numWarps, kMaxPrivatizedHistogramBytes / binBytes));
+}
+
+unsigned getHistogramScratchSizeInBytes(triton::HistogramOp op) {
+  auto dstTy = op.getResult().getType().cast<RankedTensorType>();
+  unsigned bytesPerBin = std::max<int>(8, dstTy.getElementTypeBitWidth()) / 8;
+  if (unsigned numCopies = getNumPrivatizedHistograms(op))
+    return numCopies * dstTy.getNumElements() * bytesPerBin;
+  int threadsPerWarp = triton::gpu::TritonGPUDialect::getThreadsPerWarp(
+      op->getParentOfType<ModuleOp>());
+  return std::max<int>(dstTy.getNumElements(), threadsPerWarp) * bytesPerBin;
+}
+
+std::optional<triton::WarpLocalConversion>
+getWarpLocalConversion(RankedTensorType srcTy, RankedTensorType dstTy) {
+  auto srcLayout = triton::gpu::toLinearLayout(srcTy);
+  auto dstLayout = triton::gpu::toLinearLayout(dstTy);
+  if (!srcLayout || !dstLayout)
+    return std::nullopt;
+  return triton::getWarpLocalConversion(*srcLayout, *dstLayout);
+}
+
+std::optional<triton::WarpLocalGather> getWarpLocalGather(triton::GatherOp op) {
+  auto srcLayout = triton::gpu::toLinearLayout(
+      op.getSrc().getType().cast<RankedTensorType>());
+  auto indicesLayout = triton::gpu::toLinearLayout(
+      op.getIndices().getType().cast<RankedTensorType>());
+  if (!srcLayout || !indicesLayout)
+    return std::nullopt;
+  return triton::getWarpLocalGather(*srcLayout, *indicesLayout, op.getAxis());
+}
+
+unsigned getGatherScratchSizeInBytes(triton::GatherOp op) {
+  if (getWarpLocalGather(op))
+    return 0;
+  auto srcTy = op.getSrc().getType().cast<RankedTensorType>();
+  Type elemTy = srcTy.getElementType();
+  unsigned bitWidth = elemTy.isa<triton::PointerType>()
+                          ? 64
+                          : std::max(8u, elemTy.getIntOrFloatBitWidth());
+  return srcTy.getNumElements() * (bitWidth / 8);
+}
+
 // For MMAV3 dotOperand layout matches mma operand for f16 and bf16 cases.
 bool matchMmaV3AndDotOperandLayout(RankedTensorType srcTy,
                                    RankedTensorType dstTy) {
@@ -549,7 +684,7 @@ bool isMmaToDotShortcut(RankedTensorType srcTy, RankedTensorType dstTy) {
   auto dstLayout = dstTy.getEncoding();
   auto mmaLayout = srcLayout.cast<triton::gpu::NvidiaMmaEncodingAttr>();
   auto dotOperandLayout = dstLayout.cast<triton::gpu::DotOperandEncodingAttr>();
-  return mmaLayout.getVersionMajor() == 2 &&
+  return mmaLayout.getVersionMajor() == 2 && srcTy.getRank() == 2 &&
          mmaLayout.getWarpsPerCTA()[1] == 1 &&
          dotOperandLayout.getOpIdx() == 0 &&
          dotOperandLayout.getParent() == mmaLayout &&
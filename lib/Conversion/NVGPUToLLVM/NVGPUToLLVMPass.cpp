@@ -38,15 +38,6 @@ const std::string Reg_Dealloc_Op = "setmaxnreg.dec.sync.aligned.u32 #regCount;";
 
 const std::string Mbarrier_Init_Op =
     "@$1 mbarrier.init.shared.b64 [$0], #count;";
-const std::string Mbarrier_Wait_Op =
-    "{                                                           \n"
-    ".reg .pred P1;                                              \n"
-    "LAB_WAIT:                                                   \n"
-    "mbarrier.try_wait.parity.shared.b64 P1, [$0], $1, 0x989680; \n"
-    "@P1 bra.uni DONE;                                           \n"
-    "bra.uni LAB_WAIT;                                           \n"
-    "DONE:                                                       \n"
-    "}                                                           \n";
 const std::string Named_Barrier_Arrive_Op = "bar.arrive $0, $1;";
 const std::string Named_Barrier_Wait_Op = "bar.sync $0, $1;";
 const std::string Sts64_Op = "st.shared.v2.b32 [$0], {$1, $2};";
@@ -443,6 +434,48 @@ public:
   }
 };
 
+class MBarrierWaitOpPattern
+    : public NVGPUOpPatternBase<ttn::MBarrierWaitOp, MBarrierWaitOpPattern> {
+public:
+  using Base = NVGPUOpPatternBase<ttn::MBarrierWaitOp, MBarrierWaitOpPattern>;
+
+  explicit MBarrierWaitOpPattern(mlir::MLIRContext *context,
+                                 int32_t suspendTime, int32_t backoff)
+      : Base(context), suspendTime(suspendTime), backoff(backoff) {}
+
+  OperandsAndConstraints
+  getOperandsAndConstraints(ttn::MBarrierWaitOp op) const {
+    OperandsAndConstraints operandsAndTypes;
+    operandsAndTypes.push_back({op.getMbarrier(), "r"});
+    operandsAndTypes.push_back({op.getPhase(), "r"});
+    return operandsAndTypes;
+  }
+
+  std::string getPtxAsm(ttn::MBarrierWaitOp op) const {
+    // The threads are suspended in try_wait until the phase completes or the
+    // hint expires, then back off before trying again so that they don't
+    // take the issue slots of the warps they wait for.
+    std::string ptxAsm = "{\n"
+                         ".reg .pred P1;\n"
+                         "LAB_WAIT:\n"
+                         "mbarrier.try_wait.parity.shared.b64 P1, [$0], $1";
+    if (suspendTime > 0)
+      ptxAsm += ", " + std::to_string(suspendTime);
+    ptxAsm += ";\n"
+              "@P1 bra.uni DONE;\n";
+    if (backoff > 0)
+      ptxAsm += "nanosleep.u32 " + std::to_string(backoff) + ";\n";
+    ptxAsm += "bra.uni LAB_WAIT;\n"
+              "DONE:\n"
+              "}\n";
+    return ptxAsm;
+  }
+
+private:
+  int32_t suspendTime;
+  int32_t backoff;
+};
+
 class TMALoadTiledOpPattern
     : public NVGPUOpPatternBase<ttn::TMALoadTiledOp, TMALoadTiledOpPattern> {
 public:
@@ -461,8 +494,8 @@ public:
     auto mcastMask = op.getMcastMask();
 
     auto dimSize = coords.size();
-    assert(dimSize == 2 || (dimSize == 4 && mcastMask == nullptr) &&
-                               "Does not support TMA configuration");
+    assert(dimSize >= 1 && dimSize <= 5 &&
+           "Does not support TMA configuration");
 
     operandsAndTypes.push_back({dst, "r"});
     operandsAndTypes.push_back({tmaDesc, "l"});
@@ -483,28 +516,30 @@ public:
     auto coords = op.getCoords();
     auto mcastMask = op.getMcastMask();
     auto dimSize = coords.size();
-    std::string ptxAsm;
-    if (dimSize == 2) {
-      if (mcastMask == nullptr) {
-        ptxAsm = "@$6 cp.async.bulk.tensor.2d.shared::cluster.global.mbarrier:"
-                 ":complete_tx"
-                 "::bytes.L2::cache_hint [$0], [$1, {$2, $3}], [$4], $5;";
-      } else {
-        ptxAsm = "@$7 cp.async.bulk.tensor.2d.shared::cluster.global.mbarrier::"
-                 "complete_tx::bytes.multicast::cluster.L2::cache_hint"
-                 " [$0], [$1, {$2, $3}], [$4], $5, $6;";
-      }
-    } else if (dimSize == 4) {
-      assert(mcastMask == nullptr && "Does not support multicast");
-      ptxAsm = "@$8 "
-               "cp.async.bulk.tensor.4d.shared::cluster.global.mbarrier:"
-               ":complete_tx"
-               "::bytes.L2::cache_hint [$0], [$1, {$2, $3, $4, $5}], "
-               "[$6], $7;";
-    } else {
+    if (dimSize < 1 || dimSize > 5) {
       llvm::errs() << "Unsupported dimSize " << dimSize << "\n";
       llvm_unreachable("");
     }
+    // Operands: dst, tmaDesc, coords..., mbarrier, [mcastMask], l2Desc, pred
+    unsigned mbarIdx = 2 + dimSize;
+    unsigned l2DescIdx = mbarIdx + (mcastMask ? 2 : 1);
+    unsigned predIdx = l2DescIdx + 1;
+    std::string coordsAsm;
+    for (unsigned i = 0; i < dimSize; ++i)
+      coordsAsm += (i ? ", $" : "$") + std::to_string(2 + i);
+    std::string ptxAsm =
+        "@$" + std::to_string(predIdx) + " cp.async.bulk.tensor." +
+        std::to_string(dimSize) +
+        "d.shared::cluster.global.mbarrier::complete_tx::bytes";
+    // The box is written at the same offset of the shared memory of every CTA
+    // of the mask
+    if (mcastMask)
+      ptxAsm += ".multicast::cluster";
+    ptxAsm += ".L2::cache_hint [$0], [$1, {" + coordsAsm + "}], [$" +
+              std::to_string(mbarIdx) + "], ";
+    if (mcastMask)
+      ptxAsm += "$" + std::to_string(mbarIdx + 1) + ", ";
+    ptxAsm += "$" + std::to_string(l2DescIdx) + ";";
     return ptxAsm;
   }
 };
@@ -524,7 +559,7 @@ public:
     auto coords = op.getCoords();
 
     auto dimSize = coords.size();
-    if (dimSize != 2 && dimSize != 3 && dimSize != 4) {
+    if (dimSize < 1 || dimSize > 5) {
       llvm::errs() << "Unsupported dimSize " << dimSize << "\n";
       llvm_unreachable("");
     }
@@ -541,21 +576,17 @@ public:
   std::string getPtxAsm(ttn::TMAStoreTiledOp op) const {
     auto coords = op.getCoords();
     auto dimSize = coords.size();
-    std::string ptxAsm;
-    if (dimSize == 2) {
-      ptxAsm = "@$4 cp.async.bulk.tensor.2d.global.shared::cta.bulk_group"
-               "[$0, {$2, $3}], [$1];";
-    } else if (dimSize == 3) {
-      ptxAsm = "@$5 cp.async.bulk.tensor.3d.global.shared::cta.bulk_group"
-               "[$0, {$2, $3, $4}], [$1];";
-    } else if (dimSize == 4) {
-      ptxAsm = "@$6 cp.async.bulk.tensor.4d.global.shared::cta.bulk_group"
-               "[$0, {$2, $3, $4, $5}], [$1];";
-    } else {
+    if (dimSize < 1 || dimSize > 5) {
       llvm::errs() << "Unsupported dimSize " << dimSize << "\n";
       llvm_unreachable("");
     }
-    return ptxAsm;
+    // Operands: tmaDesc, src, coords..., pred
+    std::string coordsAsm;
+    for (unsigned i = 0; i < dimSize; ++i)
+      coordsAsm += (i ? ", $" : "$") + std::to_string(2 + i);
+    return "@$" + std::to_string(2 + dimSize) + " cp.async.bulk.tensor." +
+           std::to_string(dimSize) +
+           "d.global.shared::cta.bulk_group[$0, {" + coordsAsm + "}], [$1];";
   }
 };
 
@@ -1073,6 +1104,10 @@ class ConvertNVGPUToLLVM : public ConvertNVGPUToLLVMBase<ConvertNVGPUToLLVM> {
 
 public:
   explicit ConvertNVGPUToLLVM() {}
+  ConvertNVGPUToLLVM(int32_t mbarrierSuspendTime, int32_t mbarrierBackoff) {
+    this->mbarrierSuspendTime = mbarrierSuspendTime;
+    this->mbarrierBackoff = mbarrierBackoff;
+  }
 
   void runOnOperation() override {
     MLIRContext *context = &getContext();
@@ -1094,8 +1129,8 @@ public:
 #undef POPULATE_NVGPU_OP
     patterns.add<NVGPUOpGenericPattern<ttn::MBarrierInitOp>>(
         context, Mbarrier_Init_Op, Constraints(), Constraints({"r", "b"}));
-    patterns.add<NVGPUOpGenericPattern<ttn::MBarrierWaitOp>>(
-        context, Mbarrier_Wait_Op, Constraints(), Constraints({"r", "r"}));
+    patterns.add<MBarrierWaitOpPattern>(context, mbarrierSuspendTime,
+                                        mbarrierBackoff);
     patterns.add<NVGPUOpGenericPattern<ttn::NamedBarrierArriveOp>>(
         context, Named_Barrier_Arrive_Op, Constraints(),
         Constraints({"r", "r"}));
@@ -1129,5 +1164,12 @@ std::unique_ptr<OperationPass<ModuleOp>> createConvertNVGPUToLLVMPass() {
   return std::make_unique<::ConvertNVGPUToLLVM>();
 }
 
+std::unique_ptr<OperationPass<ModuleOp>>
+createConvertNVGPUToLLVMPass(int32_t mbarrierSuspendTime,
+                             int32_t mbarrierBackoff) {
+  return std::make_unique<::ConvertNVGPUToLLVM>(mbarrierSuspendTime,
+                                                mbarrierBackoff);
+}
+
 } // namespace triton
 } // namespace mlir
@@ -37,6 +37,15 @@ struct BarrierOpConversion
   matchAndRewrite(mlir::gpu::BarrierOp op, OpAdaptor adaptor,
                   ConversionPatternRewriter &rewriter) const override {
     Location loc = op->getLoc();
+    if (op->hasAttr("warp_sync")) {
+      // Membar found that only threads of the same warp exchange data.
+      PTXBuilder ptxBuilder;
+      auto &barWarpSyncOp = *ptxBuilder.create<>("bar.warp.sync");
+      barWarpSyncOp(ptxBuilder.newConstantOperand(0xffffffff));
+      ptxBuilder.launch(rewriter, loc, void_ty(op->getContext()));
+      rewriter.eraseOp(op);
+      return success();
+    }
     if (op->hasAttr("bar_id")) {
       // llvm.nvvm.barrier0 doesn't support bar_id and num_threads attributes,
       // so we have to lower it to ptx manually.
@@ -1,6 +1,7 @@
 #include "PatternTritonGPUOpToLLVM.h"
 #include "Utility.h"
 
+#include "triton/Conversion/TritonGPUToLLVM/WarpLocalConversion.h"
 #include "triton/Dialect/TritonGPU/Transforms/Utility.h"
 #include "triton/Dialect/TritonNvidiaGPU/Transforms/Utility.h"
 
@@ -87,6 +88,8 @@ public:
       }
     }
     if (isaDistributedLayout(srcLayout) && isaDistributedLayout(dstLayout)) {
+      if (auto cvt = getWarpLocalConversion(srcTy, dstTy))
+        return lowerDistributedWithinWarp(op, adaptor, rewriter, *cvt);
       return lowerDistributedToDistributed(op, adaptor, rewriter);
     }
     if (srcLayout.isa<NvidiaMmaEncodingAttr>() &&
@@ -177,23 +180,27 @@ private:
       Value _4 = i32_val(4);
       Value _8 = i32_val(8);
       Value _16 = i32_val(16);
+      // The rows and columns of the tiles, after the batch of batched dots
+      unsigned rowDim = rank - 2, colDim = rank - 1;
       if (mmaLayout.isAmpere() || mmaLayout.isHopper()) {
-        multiDimWarpId[0] =
-            urem(multiDimWarpId[0],
-                 i32_val(ceil<unsigned>(shapePerCTA[0], instrShape[0])));
-        multiDimWarpId[1] =
-            urem(multiDimWarpId[1],
-                 i32_val(ceil<unsigned>(shapePerCTA[1], instrShape[1])));
+        multiDimWarpId[rowDim] = urem(
+            multiDimWarpId[rowDim],
+            i32_val(ceil<unsigned>(shapePerCTA[rowDim], instrShape[rowDim])));
+        multiDimWarpId[colDim] = urem(
+            multiDimWarpId[colDim],
+            i32_val(ceil<unsigned>(shapePerCTA[colDim], instrShape[colDim])));
 
         Value mmaGrpId = udiv(laneId, _4);
         Value mmaGrpIdP8 = add(mmaGrpId, _8);
         Value mmaThreadIdInGrp = urem(laneId, _4);
         Value mmaThreadIdInGrpM2 = mul(mmaThreadIdInGrp, _2);
         Value mmaThreadIdInGrpM2P1 = add(mmaThreadIdInGrpM2, _1);
-        Value rowWarpOffset = mul(multiDimWarpId[0], i32_val(instrShape[0]));
+        Value rowWarpOffset =
+            mul(multiDimWarpId[rowDim], i32_val(instrShape[rowDim]));
         mmaRowIdx[0] = add(mmaGrpId, rowWarpOffset);
         mmaRowIdx[1] = add(mmaGrpIdP8, rowWarpOffset);
-        Value colWarpOffset = mul(multiDimWarpId[1], i32_val(instrShape[1]));
+        Value colWarpOffset =
+            mul(multiDimWarpId[colDim], i32_val(instrShape[colDim]));
         mmaColIdx[0] = add(mmaThreadIdInGrpM2, colWarpOffset);
         mmaColIdx[1] = add(mmaThreadIdInGrpM2P1, colWarpOffset);
       } else if (mmaLayout.isVolta()) {
@@ -202,7 +209,7 @@ private:
         llvm_unreachable("Unexpected MMALayout version");
       }
 
-      assert(rank == 2);
+      assert(rank == 2 || (rank == 3 && mmaLayout.isAmpere()));
       SmallVector<Value> multiDimOffset(rank);
       if (mmaLayout.isHopper()) {
         unsigned elemIdRem4 = elemId % 4;
@@ -217,14 +224,18 @@ private:
             add(multiDimOffset[1],
                 i32_val(multiDimCTAInRepId[1] * shapePerCTATile[1]));
       } else if (mmaLayout.isAmpere()) {
-        multiDimOffset[0] = elemId < 2 ? mmaRowIdx[0] : mmaRowIdx[1];
-        multiDimOffset[1] = elemId % 2 == 0 ? mmaColIdx[0] : mmaColIdx[1];
-        multiDimOffset[0] =
-            add(multiDimOffset[0],
-                i32_val(multiDimCTAInRepId[0] * shapePerCTATile[0]));
-        multiDimOffset[1] =
-            add(multiDimOffset[1],
-                i32_val(multiDimCTAInRepId[1] * shapePerCTATile[1]));
+        multiDimOffset[rowDim] = elemId < 2 ? mmaRowIdx[0] : mmaRowIdx[1];
+        multiDimOffset[colDim] =
+            elemId % 2 == 0 ? mmaColIdx[0] : mmaColIdx[1];
+        for (unsigned d : {rowDim, colDim})
+          multiDimOffset[d] =
+              add(multiDimOffset[d],
+                  i32_val(multiDimCTAInRepId[d] * shapePerCTATile[d]));
+        // The warps past the batch of a batched dot hold its entries again
+        if (rank == 3)
+          multiDimOffset[0] =
+              add(urem(multiDimWarpId[0], i32_val(shapePerCTA[0])),
+                  i32_val(multiDimCTAInRepId[0] * shapePerCTATile[0]));
       } else if (mmaLayout.isVolta()) {
         auto [isARow, isBRow, isAVec4, isBVec4, _] =
             mmaLayout.decodeVoltaLayoutStates();
@@ -678,6 +689,11 @@ private:
           processReplicaForMMAV1(loc, rewriter, /*stNotRd*/ false, dstTy,
                                  multiDimRepId, outVec, paddedRepShape, outOrd,
                                  outVals, smemBase, shape, /*isDestMma=*/true);
+        else if (isStMatrixCompatible(dstTy) && accumNumReplicates == 1 &&
+                 outOrd[0] == 1 && paddedRepShape[1] % 8 == 0)
+          loadDistributedFromSharedWithLdMatrix(dstTy, outVals, smemBase,
+                                                paddedRepShape, origRepShape,
+                                                loc, rewriter);
         else
           processReplica(loc, rewriter, /*stNotRd*/ false, dstTy,
                          outNumCTAsEachRep, multiDimRepId, outVec,
@@ -707,7 +723,7 @@ private:
     auto srcShape = srcTy.getShape();
     auto dstTy = dst.getType().cast<RankedTensorType>();
     auto dstShape = dstTy.getShape();
-    assert(dstShape.size() == 2 &&
+    assert((dstShape.size() == 2 || dstShape.size() == 3) &&
            "Unexpected rank of ConvertLayout(shared->blocked)");
     auto srcSharedLayout = srcTy.getEncoding().cast<SharedEncodingAttr>();
     auto dstLayout = dstTy.getEncoding();
@@ -768,10 +784,39 @@ private:
     rewriter.create<triton::nvgpu::StoreMatrixOp>(loc, addr, inputs);
   }
 
-  void storeDistributedToSharedWithStMatrix(
-      RankedTensorType tensorTy, Value llvmSrc, Value smemBase,
-      ArrayRef<unsigned> paddedRepShape, ArrayRef<unsigned> origRepShape,
-      Location loc, ConversionPatternRewriter &rewriter) const {
+  void ldMatrixm8n8x4(Value offset, SmallVector<Value> &vals, int indexOffset,
+                      Value smemBase, Type elemTy, Location loc,
+                      ConversionPatternRewriter &rewriter) const {
+    Type llvmElemTy = getTypeConverter()->convertType(elemTy);
+    Value addr = gep(smemBase.getType(), llvmElemTy, smemBase, offset);
+    PTXBuilder builder;
+    // ldmatrix.m8n8.x4 returns 4x2x16bit elements for a thread
+    auto resArgs = builder.newListOperand(4, "=r");
+    auto addrArg = builder.newAddrOperand(addr, "r");
+    auto ldmatrix = builder.create("ldmatrix.sync.aligned.m8n8.x4.shared.b16");
+    ldmatrix(resArgs, addrArg);
+    auto resTy = LLVM::LLVMStructType::getLiteral(rewriter.getContext(),
+                                                  SmallVector<Type>(4, i32_ty));
+    Value res = builder.launch(rewriter, loc, resTy);
+    // Unpack the 2xf16 of each output
+    Type packedTy = vec_ty(llvmElemTy, 2);
+    for (int i = 0; i < 4; i++) {
+      Value packed = bitcast(extract_val(i32_ty, res, i), packedTy);
+      for (int j = 0; j < 2; j++) {
+        vals[indexOffset + i * 2 + j] =
+            extract_element(llvmElemTy, packed, i32_val(j));
+      }
+    }
+  }
+
+  // Returns the offsets of the 16x16 tiles stored by stmatrix.x4 or loaded by
+  // ldmatrix.x4 for each lane, in the order of the registers of the mma
+  // layout: each tile holds 8 registers.
+  SmallVector<Value>
+  getMatrixX4Offsets(RankedTensorType tensorTy,
+                     ArrayRef<unsigned> paddedRepShape,
+                     ArrayRef<unsigned> origRepShape, Location loc,
+                     ConversionPatternRewriter &rewriter) const {
     auto shapePerCTA = getShapePerCTA(tensorTy);
     auto mmaLayout = tensorTy.getEncoding().cast<NvidiaMmaEncodingAttr>();
     auto order = triton::gpu::getOrder(mmaLayout);
@@ -792,7 +837,6 @@ private:
     SmallVector<Value> multiDimWarpId =
         delinearize(rewriter, loc, warp, warpsPerCTA);
 
-    auto inVals = getTypeConverter()->unpackLLElements(loc, llvmSrc, rewriter);
     // Compute the relative offset for each lane.
     Value stMatrixLaneOffset =
         computeStMatrixAddr(lane, paddedRepShape[1], loc, rewriter);
@@ -804,21 +848,42 @@ private:
     Value relativeOffset =
         linearize(rewriter, loc, multiDimOffsetWrapped, paddedRepShape, order);
     relativeOffset = add(relativeOffset, stMatrixLaneOffset);
-    int indexOffset = 0;
+    SmallVector<Value> offsets;
     int m8n8x4Stride = 16;
     int numNChunk = mmaShape[1] / m8n8x4Stride;
     for (int m = 0; m < numRep[0]; m++) {
       for (int n = 0; n < numRep[1]; n++) {
         for (int k = 0; k < numNChunk; k++) {
-          Value addr =
+          offsets.push_back(
               add(relativeOffset, i32_val(k * m8n8x4Stride + n * instrN +
-                                          m * instrM * paddedRepShape[1]));
-          stMatrixm8n8x4(addr, inVals, indexOffset, smemBase,
-                         tensorTy.getElementType(), loc, rewriter);
-          indexOffset += 8;
+                                          m * instrM * paddedRepShape[1])));
         }
       }
     }
+    return offsets;
+  }
+
+  void storeDistributedToSharedWithStMatrix(
+      RankedTensorType tensorTy, Value llvmSrc, Value smemBase,
+      ArrayRef<unsigned> paddedRepShape, ArrayRef<unsigned> origRepShape,
+      Location loc, ConversionPatternRewriter &rewriter) const {
+    auto inVals = getTypeConverter()->unpackLLElements(loc, llvmSrc, rewriter);
+    auto offsets = getMatrixX4Offsets(tensorTy, paddedRepShape, origRepShape,
+                                      loc, rewriter);
+    for (unsigned i = 0; i < offsets.size(); ++i)
+      stMatrixm8n8x4(offsets[i], inVals, i * 8, smemBase,
+                     tensorTy.getElementType(), loc, rewriter);
+  }
+
+  void loadDistributedFromSharedWithLdMatrix(
+      RankedTensorType tensorTy, SmallVector<Value> &outVals, Value smemBase,
+      ArrayRef<unsigned> paddedRepShape, ArrayRef<unsigned> origRepShape,
+      Location loc, ConversionPatternRewriter &rewriter) const {
+    auto offsets = getMatrixX4Offsets(tensorTy, paddedRepShape, origRepShape,
+                                      loc, rewriter);
+    for (unsigned i = 0; i < offsets.size(); ++i)
+      ldMatrixm8n8x4(offsets[i], outVals, i * 8, smemBase,
+                     tensorTy.getElementType(), loc, rewriter);
   }
 
   bool isStMatrixCompatible(RankedTensorType tensorTy) const {
@@ -827,6 +892,9 @@ private:
       return false;
     if (tensorTy.getElementType().getIntOrFloatBitWidth() != 16)
       return false;
+    // Each 4xm8n8 covers 16 columns of the instruction
+    if (mmaLayout.getInstrShape()[1] % 16 != 0)
+      return false;
     return true;
   }
 
@@ -843,7 +911,7 @@ private:
     auto srcShape = srcTy.getShape();
     auto dstTy = dst.getType().cast<RankedTensorType>();
     auto dstShapePerCTA = triton::gpu::getShapePerCTA(dstTy);
-    assert(srcShape.size() == 2 &&
+    assert((srcShape.size() == 2 || srcShape.size() == 3) &&
            "Unexpected rank of ConvertLayout(blocked->shared)");
     auto srcLayout = srcTy.getEncoding();
     auto dstSharedLayout = dstTy.getEncoding().cast<SharedEncodingAttr>();
@@ -857,11 +925,22 @@ private:
     int32_t elemSize = elemTy.getIntOrFloatBitWidth();
     auto mmaLayout = srcLayout.dyn_cast<NvidiaMmaEncodingAttr>();
     unsigned numElems = triton::gpu::getTotalElemsPerThread(srcTy);
-    auto dstStrides =
-        getStridesFromShapeAndOrder(dstShapePerCTA, outOrd, loc, rewriter);
-    auto srcIndices = emitIndices(loc, rewriter, srcLayout, srcTy, false);
-    storeDistributedToShared(src, adaptor.getSrc(), dstStrides, srcIndices, dst,
-                             smemBase, elemTy, loc, rewriter);
+    // Hopper mma accumulators of 16 bits are stored a 16x16 tile per warp
+    // with stmatrix when the rows aren't swizzled
+    if (isStMatrixCompatible(srcTy) && dstSharedLayout.getMaxPhase() == 1 &&
+        !dstSharedLayout.getHasLeadingOffset() && outOrd[0] == 1 &&
+        triton::gpu::getNumCTAs(srcLayout) == 1 &&
+        dstShapePerCTA[1] % 8 == 0) {
+      auto repShape = convertType<unsigned, int64_t>(dstShapePerCTA);
+      storeDistributedToSharedWithStMatrix(srcTy, adaptor.getSrc(), smemBase,
+                                           repShape, repShape, loc, rewriter);
+    } else {
+      auto dstStrides =
+          getStridesFromShapeAndOrder(dstShapePerCTA, outOrd, loc, rewriter);
+      auto srcIndices = emitIndices(loc, rewriter, srcLayout, srcTy, false);
+      storeDistributedToShared(src, adaptor.getSrc(), dstStrides, srcIndices,
+                               dst, smemBase, elemTy, loc, rewriter);
+    }
     auto smemObj = SharedMemoryObject(smemBase, elemTy, dstShapePerCTA, outOrd,
                                       loc, rewriter);
     auto retVal = getStructFromSharedMemoryObject(loc, smemObj, rewriter);
@@ -884,7 +963,10 @@ private:
 
     bool isOuter{};
     int K{};
-    if (dotOperandLayout.getOpIdx() == 0) // $a
+    unsigned rank = dstTensorTy.getRank();
+    if (rank == 3) // batched $a [B, M, K] or $b [B, K, N]
+      K = dstTensorTy.getShape()[dotOperandLayout.getOpIdx() == 0 ? 2 : 1];
+    else if (dotOperandLayout.getOpIdx() == 0) // $a
       K = dstTensorTy.getShape()[sharedLayout.getOrder()[0]];
     else // $b
       K = dstTensorTy.getShape()[sharedLayout.getOrder()[1]];
@@ -985,6 +1067,33 @@ private:
     return failure();
   }
 
+  // blocked/mma/slice -> blocked/mma/slice within the warps, without going
+  // through shared memory or synchronizing the CTA, see convertWithinWarp.
+  LogicalResult
+  lowerDistributedWithinWarp(triton::gpu::ConvertLayoutOp op,
+                             OpAdaptor adaptor,
+                             ConversionPatternRewriter &rewriter,
+                             const triton::WarpLocalConversion &cvt) const {
+    auto loc = op.getLoc();
+    auto dstTy = op.getResult().getType().cast<RankedTensorType>();
+    if (cvt.isNoop()) {
+      rewriter.replaceOp(op, adaptor.getSrc());
+      return success();
+    }
+    auto vals =
+        getTypeConverter()->unpackLLElements(loc, adaptor.getSrc(), rewriter);
+    auto outVals = triton::convertWithinWarp(
+        loc, rewriter, vals, cvt,
+        [&]() { return getThreadId(rewriter, loc); },
+        [&](Value val, Value srcLane) {
+          return shflIdxSync(loc, rewriter, val, srcLane);
+        });
+    Value view =
+        getTypeConverter()->packLLElements(loc, outVals, rewriter, dstTy);
+    rewriter.replaceOp(op, view);
+    return success();
+  }
+
   // mma -> mma
   LogicalResult lowerMmaToMma(triton::gpu::ConvertLayoutOp op,
                               OpAdaptor adaptor,
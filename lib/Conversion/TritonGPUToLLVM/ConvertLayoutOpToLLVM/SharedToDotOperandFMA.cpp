@@ -89,6 +89,36 @@ ValueTable getValueTableFromStruct(Value val, int K, int n0, int shapePerCTA,
   return res;
 }
 
+// Returns how many elements along a dimension of `size` elements, contiguous
+// in shared memory, are loaded at once: up to 4 in at most 16 bytes, within a
+// swizzled vector of `layout`. The 8-bit operands of dp4a are loaded 4 bytes
+// at a time along k.
+static int getVecWidth(SharedEncodingAttr layout, Type elemTy, int size) {
+  int width = 4;
+  while (width > 1 &&
+         (size % width != 0 ||
+          width * elemTy.getIntOrFloatBitWidth() > 128 ||
+          (layout.getMaxPhase() > 1 && width > layout.getVec())))
+    width /= 2;
+  return width;
+}
+
+// Loads the elements from (`mn`, `k`) at `ptr` into `vals`, `kWidth` of them
+// along k or `mnWidth` along m or n.
+static void loadVector(ValueTable &vals, int mn, int k, int kWidth,
+                       int mnWidth, Value ptr, Type elemTy, Location loc,
+                       ConversionPatternRewriter &rewriter) {
+  int width = kWidth * mnWidth;
+  if (width == 1) {
+    vals[{mn, k}] = load(elemTy, ptr);
+    return;
+  }
+  Value vec = load(vec_ty(elemTy, width), ptr);
+  for (int i = 0; i < width; ++i)
+    vals[{mn + (mnWidth > 1 ? i : 0), k + (kWidth > 1 ? i : 0)}] =
+        extract_element(elemTy, vec, i32_val(i));
+}
+
 Value loadAFMA(Value A, Value llA, BlockedEncodingAttr dLayout, Value thread,
                Location loc, TritonGPUToLLVMTypeConverter *typeConverter,
                ConversionPatternRewriter &rewriter) {
@@ -143,15 +173,23 @@ Value loadAFMA(Value A, Value llA, BlockedEncodingAttr dLayout, Value thread,
   int mShapePerCTATile = getShapePerCTATileForMN(dLayout, true /*isM*/);
   int mSizePerThread = getSizePerThreadForMN(dLayout, true /*isM*/);
 
-  for (unsigned k = 0; k < K; ++k)
+  // Vectorize along the dimension contiguous in shared memory
+  int kWidth = isARow ? getVecWidth(aLayout, elemTy, K) : 1;
+  int mWidth = isARow ? 1 : getVecWidth(aLayout, elemTy, mSizePerThread);
+  ValueTable vals;
+  for (unsigned k = 0; k < K; k += kWidth)
     for (unsigned m = 0; m < M; m += mShapePerCTATile)
-      for (unsigned mm = 0; mm < mSizePerThread; ++mm) {
+      for (unsigned mm = 0; mm < mSizePerThread; mm += mWidth) {
         Value offset =
             add(mul(i32_val(m + mm), strideAM), mul(i32_val(k), strideAK));
         Value pa = gep(ptrTy, elemTy, aPtrs[0], offset);
-        Value va = load(elemTy, pa);
-        vas.emplace_back(va);
+        loadVector(vals, m + mm, k, kWidth, mWidth, pa, elemTy, loc,
+                   rewriter);
       }
+  for (unsigned k = 0; k < K; ++k)
+    for (unsigned m = 0; m < M; m += mShapePerCTATile)
+      for (unsigned mm = 0; mm < mSizePerThread; ++mm)
+        vas.emplace_back(vals[{m + mm, k}]);
 
   return getStructFromValueTable(vas, rewriter, loc, typeConverter, elemTy);
 }
@@ -210,15 +248,22 @@ Value loadBFMA(Value B, Value llB, BlockedEncodingAttr dLayout, Value thread,
   int nShapePerCTATile = getShapePerCTATileForMN(dLayout, false /*isM*/);
   int nSizePerThread = getSizePerThreadForMN(dLayout, false /*isM*/);
 
-  for (unsigned k = 0; k < K; ++k)
+  int kWidth = isBRow ? 1 : getVecWidth(bLayout, elemTy, K);
+  int nWidth = isBRow ? getVecWidth(bLayout, elemTy, nSizePerThread) : 1;
+  ValueTable vals;
+  for (unsigned k = 0; k < K; k += kWidth)
     for (unsigned n = 0; n < N; n += nShapePerCTATile)
-      for (unsigned nn = 0; nn < nSizePerThread; ++nn) {
+      for (unsigned nn = 0; nn < nSizePerThread; nn += nWidth) {
         Value offset =
             add(mul(i32_val(n + nn), strideBN), mul(i32_val(k), strideBK));
         Value pb = gep(ptrTy, elemTy, bPtrs[0], offset);
-        Value vb = load(elemTy, pb);
-        vbs.emplace_back(vb);
+        loadVector(vals, n + nn, k, kWidth, nWidth, pb, elemTy, loc,
+                   rewriter);
       }
+  for (unsigned k = 0; k < K; ++k)
+    for (unsigned n = 0; n < N; n += nShapePerCTATile)
+      for (unsigned nn = 0; nn < nSizePerThread; ++nn)
+        vbs.emplace_back(vals[{n + nn, k}]);
 
   return getStructFromValueTable(vbs, rewriter, loc, typeConverter, elemTy);
 }
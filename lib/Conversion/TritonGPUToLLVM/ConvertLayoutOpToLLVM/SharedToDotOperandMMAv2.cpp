@@ -469,18 +469,21 @@ Type getSharedMemTy(Type argType) {
     llvm::report_fatal_error("mma16816 data type not supported");
 }
 
+// The values of the batch entries of a batched dot follow each other, those
+// of a 2D dot are in a single table.
 Value composeValuesToDotOperandLayoutStruct(
-    const ValueTable &vals, int n0, int n1,
+    ArrayRef<ValueTable> batchVals, int n0, int n1,
     TritonGPUToLLVMTypeConverter *typeConverter, Location loc,
     ConversionPatternRewriter &rewriter) {
   std::vector<Value> elems;
-  for (int m = 0; m < n0; ++m)
-    for (int k = 0; k < n1; ++k) {
-      elems.push_back(vals.at({2 * m, 2 * k}));
-      elems.push_back(vals.at({2 * m, 2 * k + 1}));
-      elems.push_back(vals.at({2 * m + 1, 2 * k}));
-      elems.push_back(vals.at({2 * m + 1, 2 * k + 1}));
-    }
+  for (const ValueTable &vals : batchVals)
+    for (int m = 0; m < n0; ++m)
+      for (int k = 0; k < n1; ++k) {
+        elems.push_back(vals.at({2 * m, 2 * k}));
+        elems.push_back(vals.at({2 * m, 2 * k + 1}));
+        elems.push_back(vals.at({2 * m + 1, 2 * k}));
+        elems.push_back(vals.at({2 * m + 1, 2 * k + 1}));
+      }
 
   assert(!elems.empty());
 
@@ -492,16 +495,18 @@ Value composeValuesToDotOperandLayoutStruct(
   return result;
 }
 
+// Loads the matrix of `smemObj`, of shape `shapePerCTA` in the shared memory
+// `order`, which is a batch entry of `tensor` for batched dots.
 std::function<void(int, int)>
 getLoadMatrixFn(Value tensor, const SharedMemoryObject &smemObj,
-                NvidiaMmaEncodingAttr mmaLayout, int warpsPerTile,
+                ArrayRef<int64_t> shapePerCTA, ArrayRef<unsigned> order,
+                ArrayRef<unsigned> warpsPerCTA, int warpsPerTile,
                 uint32_t kOrder, int kWidth, SmallVector<int> instrShape,
                 SmallVector<int> matShape, Value warpId, Value lane,
                 ValueTable &vals, bool isA,
                 TritonGPUToLLVMTypeConverter *typeConverter,
                 ConversionPatternRewriter &rewriter, Location loc) {
   auto tensorTy = tensor.getType().cast<RankedTensorType>();
-  auto shapePerCTA = getShapePerCTA(tensorTy);
   Type eltTy = tensorTy.getElementType();
   // We assumes that the input operand of Dot should be from shared layout.
   // TODO(Superjomn) Consider other layouts if needed later.
@@ -510,19 +515,20 @@ getLoadMatrixFn(Value tensor, const SharedMemoryObject &smemObj,
   const int maxPhase = sharedLayout.getMaxPhase();
   const int vecPhase = sharedLayout.getVec();
   const int elemBytes = tensorTy.getElementTypeBitWidth() / 8;
-  auto order = sharedLayout.getOrder();
 
   if (kWidth != (4 / elemBytes))
     assert(vecPhase == 1 || vecPhase == 4 * kWidth);
 
-  int nPerWarp =
-      std::max<int>(shapePerCTA[1] / mmaLayout.getWarpsPerCTA()[1], 8);
+  int nPerWarp = std::max<int>(shapePerCTA[1] / warpsPerCTA[1], 8);
 
   // (a, b) is the coordinate.
-  auto load = [=, &rewriter, &vals](int a, int b) {
-    MMA16816SmemLoader loader(nPerWarp, warpsPerTile, sharedLayout.getOrder(),
-                              mmaLayout.getWarpsPerCTA(), kOrder, kWidth,
-                              smemObj.strides, shapePerCTA /*tileShape*/,
+  auto load = [=, &rewriter, &vals,
+               shapePerCTA = SmallVector<int64_t>(shapePerCTA),
+               order = SmallVector<unsigned>(order),
+               warpsPerCTA = SmallVector<unsigned>(warpsPerCTA)](int a, int b) {
+    MMA16816SmemLoader loader(nPerWarp, warpsPerTile, order, warpsPerCTA,
+                              kOrder, kWidth, smemObj.strides,
+                              shapePerCTA /*tileShape*/,
                               instrShape, matShape, perPhase, maxPhase,
                               elemBytes, rewriter, typeConverter, loc);
     // Offset of a slice within the original tensor in shared memory
@@ -570,8 +576,10 @@ Value loadArg(ConversionPatternRewriter &rewriter, Location loc, Value tensor,
   auto shapePerCTA = getShapePerCTA(tensorTy);
   int bitwidth = tensorTy.getElementTypeBitWidth();
   auto mmaLayout = encoding.getParent().cast<NvidiaMmaEncodingAttr>();
+  unsigned rank = shapePerCTA.size();
+  // The rows and columns of the matrices, after the batch of batched dots
+  unsigned rowDim = rank - 2, colDim = rank - 1;
 
-  ValueTable vals;
   int mmaInstrM = 16, mmaInstrN = 8, mmaInstrK = 4 * 64 / bitwidth;
   int matShapeM = 8, matShapeN = 8, matShapeK = 2 * 64 / bitwidth;
 
@@ -586,41 +594,80 @@ Value loadArg(ConversionPatternRewriter &rewriter, Location loc, Value tensor,
 
   SmallVector<Value> multiDimWarpId =
       delinearize(rewriter, loc, warp, warpsPerCTA, order);
-  Value warpM = urem(multiDimWarpId[0], i32_val(shapePerCTA[0] / 16));
-  Value warpN = urem(multiDimWarpId[1], i32_val(shapePerCTA[1] / 8));
+  Value warpM =
+      urem(multiDimWarpId[rowDim], i32_val(shapePerCTA[rowDim] / 16));
+  Value warpN = urem(multiDimWarpId[colDim], i32_val(shapePerCTA[colDim] / 8));
 
   int warpsPerTile;
   if (isA)
-    warpsPerTile = std::min<int>(warpsPerCTA[0], shapePerCTA[0] / 16);
+    warpsPerTile =
+        std::min<int>(warpsPerCTA[rowDim], shapePerCTA[rowDim] / 16);
   else
-    warpsPerTile = std::min<int>(warpsPerCTA[1], shapePerCTA[1] / 16);
+    warpsPerTile =
+        std::min<int>(warpsPerCTA[colDim], shapePerCTA[colDim] / 16);
+
+  // A batched operand is loaded one matrix at a time: the batch is the
+  // slowest dimension of its shared memory, and the matrices aren't swizzled
+  // across each other.
+  auto sharedOrder =
+      tensorTy.getEncoding().cast<SharedEncodingAttr>().getOrder();
+  assert((rank == 2 || sharedOrder.back() == 0) &&
+         "the batch must be the slowest dimension");
+  SmallVector<int64_t> matShapePerCTA(shapePerCTA.end() - 2,
+                                      shapePerCTA.end());
+  SmallVector<unsigned> matWarpsPerCTA(warpsPerCTA.end() - 2,
+                                       warpsPerCTA.end());
+  SmallVector<unsigned> matOrder;
+  for (unsigned d : sharedOrder.drop_back(rank - 2))
+    matOrder.push_back(d - (rank - 2));
+
+  int numRepBatch = numRep[0];
+  int numRepOuter = isA ? numRep[1] : std::max<int>(numRep[2] / 2, 1);
+  int numRepK = isA ? numRep[2] : numRep[1];
+  SmallVector<ValueTable> batchVals(numRepBatch);
+  for (int b = 0; b < numRepBatch; ++b) {
+    SharedMemoryObject matObj = smemObj;
+    if (rank == 3) {
+      // The warps past the batch load its entries again
+      Value batch = add(i32_val(b * warpsPerCTA[0]),
+                        urem(multiDimWarpId[0], i32_val(shapePerCTA[0])));
+      Value base = gep(smemObj.base.getType(), smemObj.baseElemType,
+                       smemObj.base, mul(batch, smemObj.strides[0]));
+      matObj = SharedMemoryObject(
+          base, smemObj.baseElemType,
+          ArrayRef<Value>(smemObj.strides).drop_front(),
+          ArrayRef<Value>(smemObj.offsets).drop_front());
+    }
 
-  std::function<void(int, int)> loadFn;
-  if (isA)
-    loadFn = getLoadMatrixFn(
-        tensor, smemObj, mmaLayout, warpsPerTile /*warpsPerTile*/, 1 /*kOrder*/,
-        kWidth, {mmaInstrM, mmaInstrK} /*instrShape*/,
-        {matShapeM, matShapeK} /*matShape*/, warpM /*warpId*/, lane /*laneId*/,
-        vals /*vals*/, isA /*isA*/, typeConverter /* typeConverter */,
-        rewriter /*rewriter*/, loc /*loc*/);
-  else
-    loadFn = getLoadMatrixFn(
-        tensor, smemObj, mmaLayout, warpsPerTile /*warpsPerTile*/, 0 /*kOrder*/,
-        kWidth, {mmaInstrK, mmaInstrN} /*instrShape*/,
-        {matShapeK, matShapeN} /*matShape*/, warpN /*warpId*/, lane /*laneId*/,
-        vals /*vals*/, isA /*isA*/, typeConverter /* typeConverter */,
-        rewriter /*rewriter*/, loc /*loc*/);
-
-  // Perform loading.
-  int numRepOuter = isA ? numRep[0] : std::max<int>(numRep[1] / 2, 1);
-  int numRepK = isA ? numRep[1] : numRep[0];
-  for (int m = 0; m < numRepOuter; ++m)
-    for (int k = 0; k < numRepK; ++k)
-      loadFn(2 * m, 2 * k);
+    std::function<void(int, int)> loadFn;
+    if (isA)
+      loadFn = getLoadMatrixFn(
+          tensor, matObj, matShapePerCTA, matOrder, matWarpsPerCTA,
+          warpsPerTile /*warpsPerTile*/, 1 /*kOrder*/, kWidth,
+          {mmaInstrM, mmaInstrK} /*instrShape*/,
+          {matShapeM, matShapeK} /*matShape*/, warpM /*warpId*/,
+          lane /*laneId*/, batchVals[b] /*vals*/, isA /*isA*/,
+          typeConverter /* typeConverter */, rewriter /*rewriter*/,
+          loc /*loc*/);
+    else
+      loadFn = getLoadMatrixFn(
+          tensor, matObj, matShapePerCTA, matOrder, matWarpsPerCTA,
+          warpsPerTile /*warpsPerTile*/, 0 /*kOrder*/, kWidth,
+          {mmaInstrK, mmaInstrN} /*instrShape*/,
+          {matShapeK, matShapeN} /*matShape*/, warpN /*warpId*/,
+          lane /*laneId*/, batchVals[b] /*vals*/, isA /*isA*/,
+          typeConverter /* typeConverter */, rewriter /*rewriter*/,
+          loc /*loc*/);
+
+    // Perform loading.
+    for (int m = 0; m < numRepOuter; ++m)
+      for (int k = 0; k < numRepK; ++k)
+        loadFn(2 * m, 2 * k);
+  }
 
   // Format the values to LLVM::Struct to passing to mma codegen.
-  return composeValuesToDotOperandLayoutStruct(vals, numRepOuter, numRepK,
-                                               typeConverter, loc, rewriter);
+  return composeValuesToDotOperandLayoutStruct(
+      batchVals, numRepOuter, numRepK, typeConverter, loc, rewriter);
 }
 
 namespace SharedToDotOperandMMAv2 {
@@ -25,6 +25,12 @@ LogicalResult convertMMA16816(triton::DotOp op, triton::DotOp::Adaptor adaptor,
                               TritonGPUToLLVMTypeConverter *typeConverter,
                               ConversionPatternRewriter &rewriter);
 
+LogicalResult convertSparseMMA16832(triton::gpu::SparseDotOp op,
+                                    triton::gpu::SparseDotOp::Adaptor adaptor,
+                                    TritonGPUToLLVMTypeConverter *typeConverter,
+                                    ConversionPatternRewriter &rewriter,
+                                    Value thread);
+
 LogicalResult convertWGMMA(triton::DotOp op, triton::DotOp::Adaptor adaptor,
                            TritonGPUToLLVMTypeConverter *typeConverter,
                            ConversionPatternRewriter &rewriter, Value thread);
@@ -49,7 +55,7 @@ struct DotOpConversion : public ConvertTritonGPUOpToLLVMPattern<triton::DotOp> {
 
     // Here we assume the DotOp's operands always comes from shared memory.
     auto AShapePerCTA = getShapePerCTA(A.getType());
-    size_t reduceAxis = 1;
+    size_t reduceAxis = AShapePerCTA.size() - 1;
     unsigned K = AShapePerCTA[reduceAxis];
     bool isOuter = K == 1;
 
@@ -72,6 +78,10 @@ struct DotOpConversion : public ConvertTritonGPUOpToLLVMPattern<triton::DotOp> {
           "Unsupported MMA kind found when converting DotOp to LLVM.");
     }
 
+    if (AShapePerCTA.size() == 3)
+      return op.emitError("batched dots are only lowered to the mma.sync "
+                          "tensor cores of sm75+");
+
     if (D.getType()
             .cast<RankedTensorType>()
             .getEncoding()
@@ -83,6 +93,28 @@ struct DotOpConversion : public ConvertTritonGPUOpToLLVMPattern<triton::DotOp> {
   }
 };
 
+struct SparseDotOpConversion
+    : public ConvertTritonGPUOpToLLVMPattern<triton::gpu::SparseDotOp> {
+  using ConvertTritonGPUOpToLLVMPattern<
+      triton::gpu::SparseDotOp>::ConvertTritonGPUOpToLLVMPattern;
+
+  LogicalResult
+  matchAndRewrite(triton::gpu::SparseDotOp op, OpAdaptor adaptor,
+                  ConversionPatternRewriter &rewriter) const override {
+    NvidiaMmaEncodingAttr mmaLayout = op.getD()
+                                          .getType()
+                                          .cast<RankedTensorType>()
+                                          .getEncoding()
+                                          .dyn_cast<NvidiaMmaEncodingAttr>();
+    if (mmaLayout && mmaLayout.isAmpere())
+      return convertSparseMMA16832(op, adaptor, getTypeConverter(), rewriter,
+                                   getThreadId(rewriter, op.getLoc()));
+
+    llvm::report_fatal_error(
+        "Unsupported SparseDotOp found when converting TritonGPU to LLVM.");
+  }
+};
+
 struct DotAsyncOpConversion
     : public ConvertTritonGPUOpToLLVMPattern<triton::nvidia_gpu::DotAsyncOp> {
   using ConvertTritonGPUOpToLLVMPattern<
@@ -190,6 +222,7 @@ void mlir::triton::populateDotOpToLLVMPatterns(
     int numWarps, ModuleAxisInfoAnalysis &axisInfoAnalysis,
     ModuleAllocation &allocation, PatternBenefit benefit) {
   patterns.add<DotOpConversion>(typeConverter, allocation, benefit);
+  patterns.add<SparseDotOpConversion>(typeConverter, allocation, benefit);
   patterns.add<DotAsyncOpConversion>(typeConverter, allocation, benefit);
   patterns.add<DotWaitOpConversion>(typeConverter, allocation, benefit);
 }
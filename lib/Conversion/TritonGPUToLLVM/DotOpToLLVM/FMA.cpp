@@ -26,6 +26,27 @@ static ValueTableFMA getValueTableFromStructFMA(
   return res;
 }
 
+// Packs the 4 8-bit integers of `vals` from (`mn`, `k`) along k into an i32.
+static Value packAlongK(ValueTableFMA &vals, int mn, int k,
+                        ConversionPatternRewriter &rewriter, Location loc) {
+  Value packed = undef(vec_ty(i8_ty, 4));
+  for (int i = 0; i < 4; ++i)
+    packed = insert_element(vec_ty(i8_ty, 4), packed, vals[{mn, k + i}],
+                            i32_val(i));
+  return bitcast(packed, i32_ty);
+}
+
+// Returns `c` plus the dot product of the 4 packed signed bytes of `a` and `b`.
+static Value callDp4a(Value a, Value b, Value c,
+                      ConversionPatternRewriter &rewriter, Location loc) {
+  PTXBuilder builder;
+  auto &dp4a = *builder.create("dp4a.s32.s32");
+  auto res = builder.newOperand("=r");
+  dp4a(res, builder.newOperand(a, "r"), builder.newOperand(b, "r"),
+       builder.newOperand(c, "r"));
+  return builder.launch(rewriter, loc, i32_ty, false);
+}
+
 LogicalResult convertFMADot(triton::DotOp op, triton::DotOp::Adaptor adaptor,
                             TritonGPUToLLVMTypeConverter *typeConverter,
                             ConversionPatternRewriter &rewriter) {
@@ -78,7 +99,27 @@ LogicalResult convertFMADot(triton::DotOp op, triton::DotOp::Adaptor adaptor,
   SmallVector<Value> ret = cc;
   bool isCRow = order[0] == 1;
 
-  for (unsigned k = 0; k < K; k++) {
+  // The 8-bit integer dots multiply-add 4 elements along k at a time with
+  // dp4a, the other integer dots one at a time in i32.
+  bool isInt = dTensorTy.getElementType().isInteger(32);
+  bool useDp4a = isInt && aTensorTy.getElementType().isInteger(8) &&
+                 bTensorTy.getElementType().isInteger(8) && K % 4 == 0;
+  ValueTableFMA packedA, packedB;
+  if (useDp4a) {
+    for (unsigned k = 0; k < K; k += 4) {
+      for (unsigned m = 0; m < M; m += mShapePerCTATile)
+        for (unsigned mm = 0; mm < mSizePerThread; ++mm)
+          packedA[{m + mm, k}] = packAlongK(has, m + mm, k, rewriter, loc);
+      for (unsigned n = 0; n < N; n += nShapePerCTATile)
+        for (unsigned nn = 0; nn < nSizePerThread; ++nn)
+          packedB[{n + nn, k}] = packAlongK(hbs, n + nn, k, rewriter, loc);
+    }
+  }
+  auto toI32 = [&](Value v) -> Value {
+    return v.getType().isInteger(32) ? v : sext(i32_ty, v);
+  };
+
+  for (unsigned k = 0; k < K; k += useDp4a ? 4 : 1) {
     for (unsigned m = 0; m < M; m += mShapePerCTATile)
       for (unsigned n = 0; n < N; n += nShapePerCTATile)
         for (unsigned mm = 0; mm < mSizePerThread; ++mm)
@@ -89,8 +130,16 @@ LogicalResult convertFMADot(triton::DotOp op, triton::DotOp::Adaptor adaptor,
             int z = isCRow
                         ? mIdx * N / nShapePerCTATile * mSizePerThread + nIdx
                         : nIdx * M / mShapePerCTATile * nSizePerThread + mIdx;
-            ret[z] = rewriter.create<LLVM::FMulAddOp>(loc, has[{m + mm, k}],
-                                                      hbs[{n + nn, k}], ret[z]);
+            if (useDp4a)
+              ret[z] = callDp4a(packedA[{m + mm, k}], packedB[{n + nn, k}],
+                                ret[z], rewriter, loc);
+            else if (isInt)
+              ret[z] = add(mul(toI32(has[{m + mm, k}]),
+                               toI32(hbs[{n + nn, k}])),
+                           ret[z]);
+            else
+              ret[z] = rewriter.create<LLVM::FMulAddOp>(
+                  loc, has[{m + mm, k}], hbs[{n + nn, k}], ret[z]);
           }
   }
 
@@ -4,6 +4,8 @@
 using namespace mlir;
 using namespace mlir::triton;
 
+using ::mlir::LLVM::delinearize;
+using ::mlir::LLVM::getSharedMemoryObjectFromStruct;
 using ::mlir::triton::gpu::DotOperandEncodingAttr;
 using ::mlir::triton::gpu::NvidiaMmaEncodingAttr;
 
@@ -53,23 +55,27 @@ Value loadC(Value tensor, Value llTensor,
   return llTensor;
 }
 
-ValueTableV2 getValuesFromDotOperandLayoutStruct(
+// Returns the values of each of the `numBatch` matrices of a batched operand,
+// or of the single matrix of a 2D one.
+SmallVector<ValueTableV2> getValuesFromDotOperandLayoutStruct(
     TritonGPUToLLVMTypeConverter *typeConverter, Location loc,
-    ConversionPatternRewriter &rewriter, Value value, int n0, int n1,
-    RankedTensorType type) {
+    ConversionPatternRewriter &rewriter, Value value, int numBatch, int n0,
+    int n1, RankedTensorType type) {
 
   auto elems = typeConverter->unpackLLElements(loc, value, rewriter);
   int offset{};
-  ValueTableV2 vals;
-  for (int i = 0; i < n0; ++i) {
-    for (int j = 0; j < n1; j++) {
-      vals[{2 * i, 2 * j}] = elems[offset++];
-      vals[{2 * i, 2 * j + 1}] = elems[offset++];
-      vals[{2 * i + 1, 2 * j}] = elems[offset++];
-      vals[{2 * i + 1, 2 * j + 1}] = elems[offset++];
+  SmallVector<ValueTableV2> batchVals(numBatch);
+  for (ValueTableV2 &vals : batchVals) {
+    for (int i = 0; i < n0; ++i) {
+      for (int j = 0; j < n1; j++) {
+        vals[{2 * i, 2 * j}] = elems[offset++];
+        vals[{2 * i, 2 * j + 1}] = elems[offset++];
+        vals[{2 * i + 1, 2 * j}] = elems[offset++];
+        vals[{2 * i + 1, 2 * j + 1}] = elems[offset++];
+      }
     }
   }
-  return vals;
+  return batchVals;
 }
 
 enum class TensorCoreType : uint8_t {
@@ -294,16 +300,16 @@ LogicalResult convertDot(TritonGPUToLLVMTypeConverter *typeConverter,
   auto repB = dotOpB.getParent().cast<NvidiaMmaEncodingAttr>().getMMAv2Rep(
       bShapePerCTA, bitwidth, dotOpB.getOpIdx());
 
-  assert(repA[1] == repB[0]);
-  int repM = repA[0], repN = repB[1], repK = repA[1];
+  assert(repA[0] == repB[0] && repA[2] == repB[1]);
+  int repBatch = repA[0], repM = repA[1], repN = repB[2], repK = repA[2];
 
   // shape / shape_per_cta
-  auto ha = getValuesFromDotOperandLayoutStruct(typeConverter, loc, rewriter,
-                                                loadedA, repM, repK, aTensorTy);
-  auto hb = getValuesFromDotOperandLayoutStruct(typeConverter, loc, rewriter,
-                                                loadedB, std::max(repN / 2, 1),
-                                                repK, bTensorTy);
-  auto fc = typeConverter->unpackLLElements(loc, loadedC, rewriter);
+  auto haBatch = getValuesFromDotOperandLayoutStruct(
+      typeConverter, loc, rewriter, loadedA, repBatch, repM, repK, aTensorTy);
+  auto hbBatch = getValuesFromDotOperandLayoutStruct(
+      typeConverter, loc, rewriter, loadedB, repBatch, std::max(repN / 2, 1),
+      repK, bTensorTy);
+  auto fcBatch = typeConverter->unpackLLElements(loc, loadedC, rewriter);
   auto numMmaRets = dTensorTy.getElementType().getIntOrFloatBitWidth() / 8;
   int numCPackedElem = 4 / numMmaRets;
 
@@ -312,7 +318,9 @@ LogicalResult convertDot(TritonGPUToLLVMTypeConverter *typeConverter,
   const auto &mmaInstructions =
       isTuring ? mmaInstrPtxTuring : mmaInstrPtxAmpere;
 
-  auto callMma = [&](unsigned m, unsigned n, unsigned k) {
+  SmallVector<Value> fc;
+  auto callMma = [&](ValueTableV2 &ha, ValueTableV2 &hb, unsigned m,
+                     unsigned n, unsigned k) {
     unsigned colsPerThread = repN * 2;
     PTXBuilder builder;
     auto &mma = *builder.create(mmaInstructions.at(mmaType));
@@ -342,10 +350,19 @@ LogicalResult convertDot(TritonGPUToLLVMTypeConverter *typeConverter,
     }
   };
 
-  for (int k = 0; k < repK; ++k)
-    for (int m = 0; m < repM; ++m)
-      for (int n = 0; n < repN; ++n)
-        callMma(2 * m, n, 2 * k);
+  // The matrices of the batch entries of a batched dot are multiplied one
+  // after the other, their accumulators follow each other.
+  size_t fcPerBatch = fcBatch.size() / repBatch;
+  for (int b = 0; b < repBatch; ++b) {
+    auto fcBegin = fcBatch.begin() + b * fcPerBatch;
+    fc.assign(fcBegin, fcBegin + fcPerBatch);
+    for (int k = 0; k < repK; ++k)
+      for (int m = 0; m < repM; ++m)
+        for (int n = 0; n < repN; ++n)
+          callMma(haBatch[b], hbBatch[b], 2 * m, n, 2 * k);
+    std::copy(fc.begin(), fc.end(), fcBegin);
+  }
+  fc = std::move(fcBatch);
 
   Type resElemTy = dTensorTy.getElementType();
 
@@ -412,3 +429,107 @@ LogicalResult convertMMA16816(triton::DotOp op, triton::DotOp::Adaptor adaptor,
                               ConversionPatternRewriter &rewriter) {
   return convertMMA(op, adaptor, typeConverter, rewriter, false /*isTuring*/);
 }
+
+// Convert to mma.sp.m16n8k32. The compressed $a holds the values of a dense
+// $a of its shape, so each instruction takes the registers of one k-step of
+// it and of two k-steps of $b. With the sparsity selector 0, the first and
+// second thread of each quad provide the metadata of the rows groupID and
+// groupID + 8, which they read from shared memory.
+LogicalResult convertSparseMMA16832(triton::gpu::SparseDotOp op,
+                                    triton::gpu::SparseDotOp::Adaptor adaptor,
+                                    TritonGPUToLLVMTypeConverter *typeConverter,
+                                    ConversionPatternRewriter &rewriter,
+                                    Value thread) {
+  Location loc = op.getLoc();
+  MLIRContext *ctx = op.getContext();
+  auto aTensorTy = op.getA().getType().cast<RankedTensorType>();
+  auto bTensorTy = op.getB().getType().cast<RankedTensorType>();
+  auto dTensorTy = op.getD().getType().cast<RankedTensorType>();
+  auto mmaLayout = dTensorTy.getEncoding().cast<NvidiaMmaEncodingAttr>();
+  auto dShapePerCTA = triton::gpu::getShapePerCTA(dTensorTy);
+
+  int bitwidth = aTensorTy.getElementType().getIntOrFloatBitWidth();
+  auto repA = mmaLayout.getMMAv2Rep(triton::gpu::getShapePerCTA(aTensorTy),
+                                    bitwidth, 0);
+  auto repB = mmaLayout.getMMAv2Rep(triton::gpu::getShapePerCTA(bTensorTy),
+                                    bitwidth, 1);
+  assert(2 * repA[2] == repB[1]);
+  int repM = repA[1], repN = repB[2], repK = repA[2];
+
+  auto ha = getValuesFromDotOperandLayoutStruct(typeConverter, loc, rewriter,
+                                                adaptor.getA(), 1, repM, repK,
+                                                aTensorTy)
+                .front();
+  auto hb = getValuesFromDotOperandLayoutStruct(
+                typeConverter, loc, rewriter, adaptor.getB(), 1,
+                std::max(repN / 2, 1), repB[1], bTensorTy)
+                .front();
+  Value loadedC =
+      loadC(op.getC(), adaptor.getC(), typeConverter, loc, rewriter);
+  auto fc = typeConverter->unpackLLElements(loc, loadedC, rewriter);
+
+  auto smemObj = getSharedMemoryObjectFromStruct(loc, adaptor.getAMeta(),
+                                                 i16_ty, rewriter);
+  auto warpsPerCTA = mmaLayout.getWarpsPerCTA();
+  Value warp = udiv(thread, i32_val(32));
+  Value lane = urem(thread, i32_val(32));
+  SmallVector<Value> multiDimWarpId = delinearize(
+      rewriter, loc, warp, warpsPerCTA, triton::gpu::getOrder(mmaLayout));
+  Value warpM = urem(multiDimWarpId[0], i32_val(dShapePerCTA[0] / 16));
+  int warpsPerTileM = std::min<int>(warpsPerCTA[0], dShapePerCTA[0] / 16);
+  Value rowInTile =
+      add(udiv(lane, i32_val(4)), mul(urem(lane, i32_val(2)), i32_val(8)));
+  // The two i16 of the metadata of row tile `m` for the k-step `k`
+  auto loadMeta = [&](int m, int k) -> Value {
+    Value row = add(mul(add(i32_val(m * warpsPerTileM), warpM), i32_val(16)),
+                    rowInTile);
+    Value offset = add(mul(row, smemObj.strides[0]),
+                       mul(i32_val(2 * k), smemObj.strides[1]));
+    Value ptr = gep(ptr_ty(ctx, 3), i16_ty, smemObj.base, offset);
+    return load(i32_ty, ptr);
+  };
+
+  std::string mmaInstr =
+      aTensorTy.getElementType().isBF16()
+          ? "mma.sp.sync.aligned.m16n8k32.row.col.f32.bf16.bf16.f32"
+          : "mma.sp.sync.aligned.m16n8k32.row.col.f32.f16.f16.f32";
+  Type retTy = getMmaRetType(TensorCoreType::FP32_FP16_FP16_FP32, ctx);
+  for (int k = 0; k < repK; ++k)
+    for (int m = 0; m < repM; ++m) {
+      Value meta = loadMeta(m, k);
+      for (int n = 0; n < repN; ++n) {
+        PTXBuilder builder;
+        auto &mma = *builder.create(mmaInstr);
+        int cOffset = 4 * (m * repN + n);
+        auto retArgs = builder.newListOperand(4, "=f");
+        auto cArgs = builder.newListOperand();
+        for (int i = 0; i < 4; ++i)
+          cArgs->listAppend(
+              builder.newOperand(fc[cOffset + i], std::to_string(i)));
+        auto aArgs = builder.newListOperand({
+            {ha[{2 * m, 2 * k}], "r"},
+            {ha[{2 * m + 1, 2 * k}], "r"},
+            {ha[{2 * m, 2 * k + 1}], "r"},
+            {ha[{2 * m + 1, 2 * k + 1}], "r"},
+        });
+        auto bArgs = builder.newListOperand({
+            {hb[{n, 4 * k}], "r"},
+            {hb[{n, 4 * k + 1}], "r"},
+            {hb[{n, 4 * k + 2}], "r"},
+            {hb[{n, 4 * k + 3}], "r"},
+        });
+        auto metaArg = builder.newOperand(meta, "r");
+        auto selectorArg = builder.newConstantOperand(0);
+        mma(retArgs, aArgs, bArgs, cArgs, metaArg, selectorArg);
+        Value mmaOut = builder.launch(rewriter, loc, retTy);
+        for (int i = 0; i < 4; ++i)
+          fc[cOffset + i] = extract_val(f32_ty, mmaOut, i);
+      }
+    }
+
+  Type structTy = LLVM::LLVMStructType::getLiteral(
+      ctx, SmallVector<Type>(fc.size(), f32_ty));
+  Value res = typeConverter->packLLElements(loc, fc, rewriter, structTy);
+  rewriter.replaceOp(op, res);
+  return success();
+}
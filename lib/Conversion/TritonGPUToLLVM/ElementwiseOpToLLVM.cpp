@@ -1,4 +1,6 @@
 #include "PatternTritonGPUOpToLLVM.h"
+#include "mlir/IR/Matchers.h"
+#include "llvm/ADT/StringSwitch.h"
 
 using namespace mlir;
 using namespace mlir::triton;
@@ -56,9 +58,9 @@ static const Fp8ConversionDesc Fp8E5M2_to_Fp16(bool hasNativeFP) {
   return ret;
 }
 
-static const Fp8ConversionDesc Fp8E5M2_to_Bf16(bool hasNativeFP) {
+static const Fp8ConversionDesc Fp8E5M2_to_Bf16(bool hasBf16x2FMA) {
   Fp8ConversionDesc ret;
-  if (!hasNativeFP) {
+  if (!hasBf16x2FMA) {
     ret = {
         "{                                        \n"
         ".reg .b32 a<2>, b<2>, c<4>, d<4>, e112;  \n" // if input = 0xf1f2f3f4
@@ -89,9 +91,11 @@ static const Fp8ConversionDesc Fp8E5M2_to_Bf16(bool hasNativeFP) {
     ret = {
         "{                                       \n"
         ".reg .b32 a<2>, b<2>;                  \n" // if input = 0xf1f2f3f4
-        ".reg .b32 e112;                        \n"
+        ".reg .b32 e112, nz;                    \n"
         "mov.u32 e112, 0x77807780;              \n" // 2**112 represented as
                                                     // bf16x2
+        "mov.u32 nz, 0x80008000;                \n" // -0.0 as bf16x2, sm80
+                                                    // has no mul.bf16x2
         "prmt.b32 a0, 0, $2, 0x5140;            \n" // a0 = 0xf300f400
         "prmt.b32 a1, 0, $2, 0x7362;            \n" // a1 = 0xf100f200
         "lop3.b32 b0, a0, 0x7fff7fff, 0, 0xc0;  \n" // b0 = a0 & 0x7fff7fff
@@ -100,8 +104,8 @@ static const Fp8ConversionDesc Fp8E5M2_to_Bf16(bool hasNativeFP) {
         "shr.b32  b1, b1, 3;                    \n" // shift into bf16 position
         "lop3.b32 b0, b0, 0x80008000, a0, 0xf8; \n" // out0 = b0|(0x80008000&a0)
         "lop3.b32 b1, b1, 0x80008000, a1, 0xf8; \n" // (restore sign)
-        "mul.rn.bf16x2 $0, b0, e112;            \n" // b0.exp += 2**7-2**4
-        "mul.rn.bf16x2 $1, b1, e112;            \n" // exponent compensate = 112
+        "fma.rn.bf16x2 $0, b0, e112, nz;        \n" // b0.exp += 2**7-2**4
+        "fma.rn.bf16x2 $1, b1, e112, nz;        \n" // exponent compensate = 112
         "}",
         32, 32, 4};
   }
@@ -275,6 +279,59 @@ static const Fp8ConversionDesc Fp16_to_Fp8E4M3Nv = {
     "}",
     32, 16, 2};
 
+// Fp8E4M3 (x4) -> Fp16 (x4), without the cvt of sm89: the exponent and
+// mantissa are shifted into place and the bias is compensated by an exact
+// multiplication, also for the subnormals. The NaNs, 0x7f and 0xff, are
+// detected on the input bytes.
+static const Fp8ConversionDesc Fp8E4M3Nv_to_Fp16_Emulated = {
+    "{                                      \n"
+    ".reg .b32 a<2>, b<2>, n, m<2>, e8;     \n" // if input = 0xf1f2f3f4
+    "mov.u32 e8, 0x5c005c00;                \n" // 2**8 as f16x2
+    "prmt.b32 a0, 0, $2, 0x5140;            \n" // a0 = 0xf300f400
+    "prmt.b32 a1, 0, $2, 0x7362;            \n" // a1 = 0xf100f200
+    "shr.b32 b0, a0, 1;                     \n" // b0 = (a0 >> 1) & 0x3f803f80
+    "shr.b32 b1, a1, 1;                     \n" // (shift into fp16 position,
+    "and.b32 b0, b0, 0x3f803f80;            \n" // strip sign)
+    "and.b32 b1, b1, 0x3f803f80;            \n"
+    "lop3.b32 b0, b0, 0x80008000, a0, 0xf8; \n" // b0 |= 0x80008000 & a0
+    "lop3.b32 b1, b1, 0x80008000, a1, 0xf8; \n" // (restore sign)
+    "mul.rn.f16x2 b0, b0, e8;               \n" // exponent compensate = 8
+    "mul.rn.f16x2 b1, b1, e8;               \n"
+    "and.b32 n, $2, 0x7f7f7f7f;             \n" // bit 7 of each byte of n
+    "add.u32 n, n, 0x01010101;              \n" // is set for the NaNs
+    "prmt.b32 m0, n, 0, 0x9988;             \n" // m0 = 0xffff for the NaNs
+    "prmt.b32 m1, n, 0, 0xbbaa;             \n" // (replicate bit 7)
+    "or.b32 $0, b0, m0;                     \n"
+    "or.b32 $1, b1, m1;                     \n"
+    "}",
+    32, 32, 4};
+
+// Fp8E4M3 (x4) -> Bf16 (x4), as above with a multiplication by 2**120, from
+// sm80 for the bf16x2 fma.
+static const Fp8ConversionDesc Fp8E4M3Nv_to_Bf16_Emulated = {
+    "{                                      \n"
+    ".reg .b32 a<2>, b<2>, n, m<2>, e120, nz; \n" // if input = 0xf1f2f3f4
+    "mov.u32 e120, 0x7b807b80;              \n" // 2**120 as bf16x2
+    "mov.u32 nz, 0x80008000;                \n" // -0.0 as bf16x2
+    "prmt.b32 a0, 0, $2, 0x5140;            \n" // a0 = 0xf300f400
+    "prmt.b32 a1, 0, $2, 0x7362;            \n" // a1 = 0xf100f200
+    "shr.b32 b0, a0, 4;                     \n" // b0 = (a0 >> 4) & 0x07f007f0
+    "shr.b32 b1, a1, 4;                     \n" // (shift into bf16 position,
+    "and.b32 b0, b0, 0x07f007f0;            \n" // strip sign)
+    "and.b32 b1, b1, 0x07f007f0;            \n"
+    "lop3.b32 b0, b0, 0x80008000, a0, 0xf8; \n" // b0 |= 0x80008000 & a0
+    "lop3.b32 b1, b1, 0x80008000, a1, 0xf8; \n" // (restore sign)
+    "fma.rn.bf16x2 b0, b0, e120, nz;        \n" // exponent compensate = 120
+    "fma.rn.bf16x2 b1, b1, e120, nz;        \n"
+    "and.b32 n, $2, 0x7f7f7f7f;             \n" // bit 7 of each byte of n
+    "add.u32 n, n, 0x01010101;              \n" // is set for the NaNs
+    "prmt.b32 m0, n, 0, 0x9988;             \n" // m0 = 0xffff for the NaNs
+    "prmt.b32 m1, n, 0, 0xbbaa;             \n" // (replicate bit 7)
+    "or.b32 $0, b0, m0;                     \n"
+    "or.b32 $1, b1, m1;                     \n"
+    "}",
+    32, 32, 4};
+
 // Fp8E4M3 (x2) -> Fp16 (x2) (packed)
 static const Fp8ConversionDesc Fp8E4M3Nv_to_Bf16 = {
     "{                                       \n"
@@ -321,6 +378,39 @@ static const std::string S8_to_Bf16 =
     "prmt.b32 $1, f2, f3, 0x7632;                \n" //
     "}";
 
+/* ----- Packed integer to FP16 ------ */
+enum class PackedInt { Byte, LowNibble, HighNibble };
+
+// Converts four 8-bit integers, or the 4-bit ones in their low or high
+// nibbles, to fp16 with magic numbers: each biased unsigned value becomes the
+// low mantissa byte of 0x6400 = 1024, from which 1024 and the bias are then
+// subtracted two elements at a time.
+static std::string getIntToFp16Ptx(bool isSigned, PackedInt packing) {
+  std::string ptx = "{                                           \n"
+                    ".reg .b32 a, m;                             \n";
+  if (packing == PackedInt::Byte) {
+    ptx += isSigned ? "xor.b32 a, $2, 0x80808080;                  \n"
+                    : "mov.b32 a, $2;                              \n";
+    ptx += isSigned ? "mov.b32 m, 0x64806480;                      \n"
+                    : "mov.b32 m, 0x64006400;                      \n";
+  } else {
+    ptx += packing == PackedInt::HighNibble
+               ? "shr.b32 a, $2, 4;                           \n"
+               : "mov.b32 a, $2;                              \n";
+    // a = (a & 0x0f0f0f0f) ^ bias
+    ptx += isSigned ? "lop3.b32 a, a, 0x0f0f0f0f, 0x08080808, 0x6a;\n"
+                    : "lop3.b32 a, a, 0x0f0f0f0f, 0, 0x6a;         \n";
+    ptx += isSigned ? "mov.b32 m, 0x64086408;                      \n"
+                    : "mov.b32 m, 0x64006400;                      \n";
+  }
+  ptx += "prmt.b32 $0, a, 0x64646464, 0x4140;         \n" // 0x64a1 0x64a0
+         "prmt.b32 $1, a, 0x64646464, 0x4342;         \n" // 0x64a3 0x64a2
+         "sub.f16x2 $0, $0, m;                        \n"
+         "sub.f16x2 $1, $1, m;                        \n"
+         "}";
+  return ptx;
+}
+
 // MMA encoding has a different order depending on the element's bit width;
 // reorder if we're in this case.
 static SmallVector<Value> reorderValues(const SmallVector<Value> &values,
@@ -668,6 +758,97 @@ public:
     return dedupResultVals;
   }
 
+  // Whether the elements of `op` are converted by a loop, see
+  // kAttrRolledLoopsName. The ops nested in other regions than the function
+  // body, which can't be split, are unrolled.
+  bool isRolled(SourceOp op, unsigned numElems) const {
+    auto mod = op->template getParentOfType<ModuleOp>();
+    auto minElems = mod->template getAttrOfType<IntegerAttr>(
+        kAttrRolledLoopsName);
+    return minElems && minElems.getInt() > 0 &&
+           static_cast<int64_t>(numElems) >= minElems.getInt() &&
+           op->getNumOperands() > 0 &&
+           isa<LLVM::LLVMFuncOp>(op->getParentOp());
+  }
+
+  // Emits ConcreteT::createDestOps once, in a loop over the elements stored
+  // to local arrays, instead of once per element. The arrays are promoted
+  // back to registers if LLVM unrolls the loop.
+  LogicalResult
+  createRolledDestOps(SourceOp op, OpAdaptor adaptor,
+                      ConversionPatternRewriter &rewriter, Type elemTy,
+                      ArrayRef<SmallVector<Value>> allOperands, Location loc,
+                      SmallVector<Value> &resultVals) const {
+    // createDestOps is given this many elements, and consumes up to them
+    constexpr unsigned kMaxVecWidth = 8;
+    MLIRContext *ctx = rewriter.getContext();
+    unsigned numElems = allOperands.size();
+    // The last iteration reads and writes the elements past the end
+    unsigned arraySize = numElems + kMaxVecWidth;
+    Block &entryBlock =
+        op->template getParentOfType<LLVM::LLVMFuncOp>().getBody().front();
+    auto createArray = [&](Type type) -> Value {
+      OpBuilder::InsertionGuard guard(rewriter);
+      rewriter.setInsertionPointToStart(&entryBlock);
+      return rewriter.create<LLVM::AllocaOp>(loc, ptr_ty(ctx), type,
+                                             i32_val(arraySize),
+                                             /*alignment=*/0);
+    };
+    SmallVector<Value> operandArrays;
+    for (Value operand : allOperands[0])
+      operandArrays.push_back(createArray(operand.getType()));
+    for (unsigned i = 0; i < numElems; ++i)
+      for (auto [array, operand] : llvm::zip(operandArrays, allOperands[i]))
+        store(operand, gep(ptr_ty(ctx), operand.getType(), array, i32_val(i)));
+
+    Block *prevBlock = rewriter.getInsertionBlock();
+    Block *afterLoop =
+        rewriter.splitBlock(prevBlock, rewriter.getInsertionPoint());
+    Block *header = rewriter.createBlock(afterLoop, {i32_ty}, {loc});
+    Block *body = rewriter.createBlock(afterLoop);
+    rewriter.setInsertionPointToEnd(prevBlock);
+    rewriter.create<LLVM::BrOp>(loc, ValueRange{i32_val(0)}, header);
+    rewriter.setInsertionPointToStart(header);
+    Value iv = header->getArgument(0);
+    rewriter.create<LLVM::CondBrOp>(loc, icmp_slt(iv, i32_val(numElems)),
+                                    body, afterLoop);
+
+    rewriter.setInsertionPointToStart(body);
+    SmallVector<SmallVector<Value>> elems(kMaxVecWidth);
+    for (unsigned k = 0; k < kMaxVecWidth; ++k) {
+      Value idx = add(iv, i32_val(k));
+      for (auto [array, operand] : llvm::zip(operandArrays, allOperands[0]))
+        elems[k].push_back(
+            load(operand.getType(),
+                 gep(ptr_ty(ctx), operand.getType(), array, idx)));
+    }
+    auto curr = static_cast<const ConcreteT *>(this)->createDestOps(
+        op, adaptor, rewriter, elemTy,
+        MultipleOperandsRange(elems.begin(), elems.end()), loc);
+    if (curr.size() == 0)
+      return failure();
+    SmallVector<Value> currVals;
+    for (auto v : curr) {
+      if (!static_cast<bool>(v))
+        return failure();
+      currVals.push_back(v);
+    }
+    Type resultElemTy = currVals[0].getType();
+    Value resultArray = createArray(resultElemTy);
+    for (unsigned k = 0; k < currVals.size(); ++k)
+      store(currVals[k], gep(ptr_ty(ctx), resultElemTy, resultArray,
+                             add(iv, i32_val(k))));
+    rewriter.create<LLVM::BrOp>(
+        loc, ValueRange{add(iv, i32_val(currVals.size()))}, header);
+
+    rewriter.setInsertionPointToStart(afterLoop);
+    for (unsigned i = 0; i < numElems; ++i)
+      resultVals.push_back(load(
+          resultElemTy, gep(ptr_ty(ctx), resultElemTy, resultArray,
+                            i32_val(i))));
+    return success();
+  }
+
   LogicalResult
   matchAndRewrite(SourceOp op, OpAdaptor adaptor,
                   ConversionPatternRewriter &rewriter) const override {
@@ -691,17 +872,25 @@ public:
       allOperands.push_back({});
 
     SmallVector<Value> resultVals;
-    for (auto it = allOperands.begin(), end = allOperands.end(); it != end;) {
-      auto curr = static_cast<const ConcreteT *>(this)->createDestOps(
-          op, adaptor, rewriter, elemTy, MultipleOperandsRange(it, end), loc);
-      if (curr.size() == 0)
+    if (isRolled(op, allOperands.size())) {
+      if (failed(createRolledDestOps(op, adaptor, rewriter, elemTy,
+                                     allOperands, loc, resultVals)))
         return failure();
-      for (auto v : curr) {
-        if (!static_cast<bool>(v))
+    } else {
+      for (auto it = allOperands.begin(), end = allOperands.end();
+           it != end;) {
+        auto curr = static_cast<const ConcreteT *>(this)->createDestOps(
+            op, adaptor, rewriter, elemTy, MultipleOperandsRange(it, end),
+            loc);
+        if (curr.size() == 0)
           return failure();
-        resultVals.push_back(v);
+        for (auto v : curr) {
+          if (!static_cast<bool>(v))
+            return failure();
+          resultVals.push_back(v);
+        }
+        it += curr.size();
       }
-      it += curr.size();
     }
     if (op->getNumOperands() > 0) {
       auto argTy = op->getOperand(0).getType();
@@ -790,6 +979,8 @@ struct FpToFpOpConversion
     case RoundingMode::RTZ:
       ptx = "cvt.rz.bf16.f32";
       break;
+    default:
+      llvm_unreachable("unsupported rounding mode for f32->bf16 conversion");
     }
     auto &cvt = *builder.create(ptx.str());
     auto res = builder.newOperand("=h");
@@ -825,6 +1016,23 @@ struct FpToFpOpConversion
     return builder.launch(rewriter, loc, f16_ty, false);
   }
 
+  // Adds the low `droppedBits` of `rbits` to the magnitude of `v`, so that
+  // truncating them rounds `v` up with a probability proportional to its
+  // distance to the value below. NaNs are kept as they are.
+  static Value addRandomBits(Location loc, ConversionPatternRewriter &rewriter,
+                             Value v, Value rbits, unsigned droppedBits) {
+    unsigned bitwidth = v.getType().getIntOrFloatBitWidth();
+    Type intTy = int_ty(bitwidth);
+    if (bitwidth < 32)
+      rbits = trunc(intTy, rbits);
+    Value mask = int_val(bitwidth, (1ull << droppedBits) - 1);
+    Value rounded =
+        bitcast(add(bitcast(v, intTy), and_(rbits, mask)), v.getType());
+    Value isNan = rewriter.create<LLVM::FCmpOp>(
+        loc, i1_ty, LLVM::FCmpPredicate::uno, v, v);
+    return select(isNan, v, rounded);
+  }
+
   std::pair<ConverterT, size_t>
   getConversionFunc(Type srcTy, Type dstTy,
                     std::optional<RoundingMode> roundingMode) const {
@@ -839,12 +1047,15 @@ struct FpToFpOpConversion
 
     auto undefRounding = static_cast<RoundingMode>(-1);
 
-    static DenseMap<std::tuple<TypeID, TypeID, RoundingMode>, Fp8ConversionDesc>
+    // Not cached, the entries depend on the compute capability of the pattern
+    DenseMap<std::tuple<TypeID, TypeID, RoundingMode>, Fp8ConversionDesc>
         srcMap = {
             // F8 -> F16
             {{F8E4M3B15TyID, F16TyID, undefRounding}, Fp8E4M3B15_to_Fp16},
             {{F8E4M3FNTyID, F16TyID, undefRounding}, Fp8E4M3B15x4_to_Fp16},
-            {{F8E4M3TyID, F16TyID, undefRounding}, Fp8E4M3Nv_to_Fp16},
+            {{F8E4M3TyID, F16TyID, undefRounding},
+             computeCapability >= 89 ? Fp8E4M3Nv_to_Fp16
+                                     : Fp8E4M3Nv_to_Fp16_Emulated},
             {{F8E5M2TyID, F16TyID, undefRounding},
              Fp8E5M2_to_Fp16(computeCapability >= 90)},
             // F16 -> F8
@@ -857,8 +1068,10 @@ struct FpToFpOpConversion
             {{F16TyID, F8E5M2TyID, RoundingMode::RTZ}, Fp16_to_Fp8E5M2_RTZ},
             // F8 -> BF16
             {{F8E5M2TyID, BF16TyID, undefRounding},
-             Fp8E5M2_to_Bf16(computeCapability >= 90)},
-            {{F8E4M3TyID, BF16TyID, undefRounding}, Fp8E4M3Nv_to_Bf16},
+             Fp8E5M2_to_Bf16(computeCapability >= 80)},
+            {{F8E4M3TyID, BF16TyID, undefRounding},
+             computeCapability >= 90 ? Fp8E4M3Nv_to_Bf16
+                                     : Fp8E4M3Nv_to_Bf16_Emulated},
             // BF16 -> F8
             {{BF16TyID, F8E5M2TyID, RoundingMode::RTNE},
              Bf16_to_Fp8E5M2(computeCapability >= 90)},
@@ -879,10 +1092,10 @@ struct FpToFpOpConversion
       llvm::errs() << "\n";
       llvm::report_fatal_error("Unsupported rounding mode for conversion.");
     }
-    if (computeCapability < 90 &&
-        (srcTy.isFloat8E4M3FNUZ() || dstTy.isFloat8E4M3FNUZ())) {
-      llvm::errs() << "Conversion from/to f8e4m3nv is only supported on "
-                      "compute capability >= 90"
+    // The conversions from f8e4m3nv are emulated on older GPUs
+    if (computeCapability < 89 && dstTy.isFloat8E4M3FNUZ()) {
+      llvm::errs() << "Conversion to f8e4m3nv is only supported on "
+                      "compute capability >= 89"
                    << "\n";
       llvm_unreachable("");
     }
@@ -902,13 +1115,29 @@ struct FpToFpOpConversion
     auto dstElementType = getElementType(op.getResult());
     auto roundingMode = op.getRounding();
 
+    // The source of element `i`, with its random bits added if stochastically
+    // rounded, after which the conversion truncates
+    unsigned droppedBits = 0;
+    if (roundingMode == RoundingMode::RS) {
+      droppedBits = srcElementType.getFPMantissaWidth() -
+                    dstElementType.getFPMantissaWidth();
+      roundingMode = RoundingMode::RTZ;
+    }
+    auto getSrc = [&](unsigned i) {
+      if (droppedBits == 0)
+        return operands[i][0];
+      return addRandomBits(loc, rewriter, operands[i][0], operands[i][1],
+                           droppedBits);
+    };
+
     if (dstElementType.isFloat8E5M2() || dstElementType.isFloat8E4M3FNUZ()) {
       assert(roundingMode.has_value() &&
              "Rounding mode must be specified for convertsions to fp8");
 
-      // For now only RTNE is supported for conversions from fp16 to fp8
+      // For now only RTNE is supported for conversions from fp16 to fp8,
+      // besides the stochastic rounding to fp8e5
       if (!srcElementType.isF32() &&
-          roundingMode.value() != RoundingMode::RTNE) {
+          roundingMode.value() != RoundingMode::RTNE && droppedBits == 0) {
         llvm::errs() << "Unsupported rounding mode for conversion to fp8: "
                      << stringifyRoundingMode(roundingMode.value()) << "\n";
         llvm_unreachable("");
@@ -918,23 +1147,15 @@ struct FpToFpOpConversion
     if (srcElementType.isF32() && dstElementType.isF16()) {
       assert(roundingMode.has_value() &&
              "rounding mode must be specified for fp32->fp16 conversion");
-      SmallVector<Value> outVals;
-      for (Value v : operands[0]) {
-        outVals.push_back(
-            convertFp32ToFp16(loc, rewriter, v, roundingMode.value()));
-      }
-      return outVals;
+      return {convertFp32ToFp16(loc, rewriter, getSrc(0),
+                                roundingMode.value())};
     }
 
     if (srcElementType.isF32() && dstElementType.isBF16()) {
       assert(roundingMode.has_value() &&
              "rounding mode must be specified for fp32->bf16 conversion");
-      SmallVector<Value> outVals;
-      for (Value v : operands[0]) {
-        outVals.push_back(
-            convertFp32ToBf16(loc, rewriter, v, roundingMode.value()));
-      }
-      return outVals;
+      return {convertFp32ToBf16(loc, rewriter, getSrc(0),
+                                roundingMode.value())};
     }
 
     bool useFP16IntermediateSrc =
@@ -949,7 +1170,7 @@ struct FpToFpOpConversion
         getConversionFunc(srcType, dstType, roundingMode);
     SmallVector<Value> inVals;
     for (unsigned i = 0; i < std::min(numElements, operands.size()); i++) {
-      inVals.push_back(operands[i][0]);
+      inVals.push_back(getSrc(i));
     }
     if (useFP16IntermediateSrc)
       for (Value &v : inVals)
@@ -1312,6 +1533,43 @@ struct ElementwiseInlineAsmOpConversion
   }
 };
 
+// Returns true if the first two sets of `operands` can be computed at once on
+// 16-bit floats packed in 32-bit registers.
+static bool isPackable16BitFloat(Type elemTy, MultipleOperandsRange operands) {
+  Type scalarTy = getElementTypeOrSelf(elemTy);
+  return operands.size() >= 2 && (scalarTy.isF16() || scalarTy.isBF16());
+}
+
+// Emits `ptxAsm` on the first two sets of `operands`, each operand packing
+// its two elements in an f16x2 or bf16x2 register after `predicate`, if set.
+// Returns the results of both sets.
+static SmallVector<Value> emitPacked16BitOp(ConversionPatternRewriter &rewriter,
+                                            Location loc, Type elemTy,
+                                            MultipleOperandsRange operands,
+                                            StringRef ptxAsm,
+                                            Value predicate = Value()) {
+  Type packedTy = vec_ty(elemTy, 2);
+  auto pack = [&](Value lo, Value hi) -> Value {
+    Value vec = undef(packedTy);
+    vec = insert_element(packedTy, vec, lo, i32_val(0));
+    vec = insert_element(packedTy, vec, hi, i32_val(1));
+    return bitcast(vec, i32_ty);
+  };
+  PTXBuilder builder;
+  auto &instr = *builder.create<PTXInstr>(ptxAsm.str());
+  SmallVector<PTXBuilder::Operand *> args = {builder.newOperand("=r")};
+  if (predicate)
+    args.push_back(builder.newOperand(predicate, "b"));
+  for (unsigned i = 0; i < operands[0].size(); ++i)
+    args.push_back(
+        builder.newOperand(pack(operands[0][i], operands[1][i]), "r"));
+  instr(args, /*onlyAttachMLIRArgs=*/true);
+  Value packed =
+      bitcast(builder.launch(rewriter, loc, i32_ty, false), packedTy);
+  return {extract_element(elemTy, packed, i32_val(0)),
+          extract_element(elemTy, packed, i32_val(1))};
+}
+
 struct FDivOpConversion
     : ElementwiseOpConversionBase<mlir::arith::DivFOp, FDivOpConversion> {
   using Base =
@@ -1359,6 +1617,15 @@ struct FMulOpConversion
                                    Location loc) const {
     auto lhsElemTy = getElementType(op.getLhs());
     auto rhsElemTy = getElementType(op.getRhs());
+    if (isPackable16BitFloat(lhsElemTy, operands)) {
+      if (lhsElemTy.isF16())
+        return emitPacked16BitOp(rewriter, loc, elemTy, operands,
+                                 "mul.rn.f16x2 $0, $1, $2;");
+      return emitPacked16BitOp(rewriter, loc, elemTy, operands,
+                               "{ .reg .b32 c;             \n"
+                               "  mov.b32 c, 0x80008000U;  \n" // -0.0
+                               "  fma.rn.bf16x2 $0, $1, $2, c; }");
+    }
     if (lhsElemTy.isBF16() && rhsElemTy.isBF16()) {
       PTXBuilder builder;
       auto ptxAsm = " { .reg .b16 c;        \n"
@@ -1390,6 +1657,15 @@ struct FAddOpConversion
                                    Location loc) const {
     auto lhsElemTy = getElementType(op.getLhs());
     auto rhsElemTy = getElementType(op.getRhs());
+    if (isPackable16BitFloat(lhsElemTy, operands)) {
+      if (lhsElemTy.isF16())
+        return emitPacked16BitOp(rewriter, loc, elemTy, operands,
+                                 "add.rn.f16x2 $0, $1, $2;");
+      return emitPacked16BitOp(rewriter, loc, elemTy, operands,
+                               "{ .reg .b32 c;             \n"
+                               "  mov.b32 c, 0x3f803f80U;  \n" // 1.0
+                               "  fma.rn.bf16x2 $0, $1, c, $2; }");
+    }
     if (lhsElemTy.isBF16() && rhsElemTy.isBF16()) {
       PTXBuilder builder;
       auto ptxAsm = "{ .reg .b16 c;         \n"
@@ -1421,6 +1697,15 @@ struct FSubOpConversion
                                    Location loc) const {
     auto lhsElemTy = getElementType(op.getLhs());
     auto rhsElemTy = getElementType(op.getRhs());
+    if (isPackable16BitFloat(lhsElemTy, operands)) {
+      if (lhsElemTy.isF16())
+        return emitPacked16BitOp(rewriter, loc, elemTy, operands,
+                                 "sub.rn.f16x2 $0, $1, $2;");
+      return emitPacked16BitOp(rewriter, loc, elemTy, operands,
+                               "{ .reg .b32 c;             \n"
+                               "  mov.b32 c, 0xbf80bf80U;  \n" // -1.0
+                               "  fma.rn.bf16x2 $0, $2, c, $1; }");
+    }
     if (lhsElemTy.isBF16() && rhsElemTy.isBF16()) {
       PTXBuilder builder;
       auto ptxAsm = " { .reg .b16 c;         \n"
@@ -1439,6 +1724,82 @@ struct FSubOpConversion
   }
 };
 
+static bool isShiftBy4(Value value) {
+  APInt shift;
+  return matchPattern(value, m_ConstantInt(&shift)) && shift == 4;
+}
+
+// Returns the bytes the 4-bit integers of `value` are extracted from, as
+// `(x << 4) >> 4` or `x & 0xf` for the low nibbles and `x >> 4` for the high
+// ones, and sets `packing` accordingly.
+static Value getPackedNibbles(Value value, bool isSigned, PackedInt &packing) {
+  Operation *op = value.getDefiningOp();
+  if (!op)
+    return {};
+  APInt mask;
+  if (!isSigned && isa<arith::AndIOp>(op) &&
+      matchPattern(op->getOperand(1), m_ConstantInt(&mask)) && mask == 0xf) {
+    packing = PackedInt::LowNibble;
+    return op->getOperand(0);
+  }
+  bool isShift = isSigned ? isa<arith::ShRSIOp>(op) : isa<arith::ShRUIOp>(op);
+  if (!isShift || !isShiftBy4(op->getOperand(1)))
+    return {};
+  Value src = op->getOperand(0);
+  auto shlOp = src.getDefiningOp<arith::ShLIOp>();
+  if (shlOp && isShiftBy4(shlOp.getRhs())) {
+    packing = PackedInt::LowNibble;
+    return shlOp.getLhs();
+  }
+  packing = PackedInt::HighNibble;
+  return src;
+}
+
+// Converts the 4-bit integers extracted from bytes to fp16 straight from the
+// bytes, four at a time, rather than converting each extracted element. The
+// extraction is left dead.
+template <typename SourceOp>
+static LogicalResult
+convertPackedNibblesToFp16(SourceOp op, bool isSigned,
+                           TritonGPUToLLVMTypeConverter *typeConverter,
+                           ConversionPatternRewriter &rewriter) {
+  if (!getElementType(op.getIn()).isInteger(8) ||
+      !getElementType(op.getOut()).isF16())
+    return failure();
+  PackedInt packing;
+  Value packed = getPackedNibbles(op.getIn(), isSigned, packing);
+  if (!packed)
+    return failure();
+  // The bytes must have been converted already
+  Value llPacked = rewriter.getRemappedValue(packed);
+  if (!llPacked ||
+      llPacked.getType() != typeConverter->convertType(packed.getType()))
+    return failure();
+
+  Location loc = op.getLoc();
+  Type srcTy = op.getIn().getType();
+  Type dstTy = op.getOut().getType();
+  SmallVector<Value> bytes = unpackI32(
+      typeConverter->unpackLLElements(loc, llPacked, rewriter), srcTy,
+      rewriter, loc, typeConverter);
+  if (bytes.size() % 4 != 0)
+    return failure();
+  auto cvtFunc = makeConverterFromPtx(getIntToFp16Ptx(isSigned, packing),
+                                      i8_ty, f16_ty);
+  SmallVector<Value> resultVals;
+  for (size_t i = 0; i < bytes.size(); i += 4) {
+    SmallVector<Value> inVals = {bytes[i], bytes[i + 1], bytes[i + 2],
+                                 bytes[i + 3]};
+    auto outVals = cvtFunc(loc, rewriter, inVals);
+    resultVals.append(outVals.begin(), outVals.end());
+  }
+  resultVals = reorderValues(resultVals, srcTy, dstTy);
+  resultVals = packI32(resultVals, dstTy, rewriter, loc, typeConverter);
+  Value view = typeConverter->packLLElements(loc, resultVals, rewriter, dstTy);
+  rewriter.replaceOp(op, view);
+  return success();
+}
+
 // Uses inline ptx to convert s8/u8 to bf16, since the
 struct SIToFPOpConversion
     : ElementwiseOpConversionBase<mlir::arith::SIToFPOp, SIToFPOpConversion> {
@@ -1447,6 +1808,15 @@ struct SIToFPOpConversion
   using Base::Base;
   using Adaptor = typename Base::OpAdaptor;
 
+  LogicalResult
+  matchAndRewrite(mlir::arith::SIToFPOp op, OpAdaptor adaptor,
+                  ConversionPatternRewriter &rewriter) const override {
+    if (succeeded(convertPackedNibblesToFp16(op, /*isSigned=*/true,
+                                             getTypeConverter(), rewriter)))
+      return success();
+    return Base::matchAndRewrite(op, adaptor, rewriter);
+  }
+
   SmallVector<Value> createDestOps(mlir::arith::SIToFPOp op, OpAdaptor adaptor,
                                    ConversionPatternRewriter &rewriter,
                                    Type elemTy, MultipleOperandsRange operands,
@@ -1462,6 +1832,17 @@ struct SIToFPOpConversion
       auto outVals = cvtFunc(loc, rewriter, inVals);
       assert(outVals.size() == 4);
       return outVals;
+    } else if (outElemTy.isF16() && inElemTy.isInteger(8) &&
+               operands.size() >= 4) {
+      auto cvtFunc = makeConverterFromPtx(
+          getIntToFp16Ptx(/*isSigned=*/true, PackedInt::Byte),
+          getTypeConverter()->convertType(inElemTy),
+          getTypeConverter()->convertType(outElemTy));
+      SmallVector<Value> inVals = {operands[0][0], operands[1][0],
+                                   operands[2][0], operands[3][0]};
+      auto outVals = cvtFunc(loc, rewriter, inVals);
+      assert(outVals.size() == 4);
+      return outVals;
     } else if (outElemTy.isBF16()) {
       auto value = rewriter.create<LLVM::SIToFPOp>(loc, f32_ty, operands[0][0]);
       return {FpToFpOpConversion::convertFp32ToBf16(loc, rewriter, value,
@@ -1472,6 +1853,44 @@ struct SIToFPOpConversion
   }
 };
 
+// Uses inline ptx to convert u8 to f16 four elements at a time.
+struct UIToFPOpConversion
+    : ElementwiseOpConversionBase<mlir::arith::UIToFPOp, UIToFPOpConversion> {
+  using Base =
+      ElementwiseOpConversionBase<mlir::arith::UIToFPOp, UIToFPOpConversion>;
+  using Base::Base;
+  using Adaptor = typename Base::OpAdaptor;
+
+  LogicalResult
+  matchAndRewrite(mlir::arith::UIToFPOp op, OpAdaptor adaptor,
+                  ConversionPatternRewriter &rewriter) const override {
+    if (succeeded(convertPackedNibblesToFp16(op, /*isSigned=*/false,
+                                             getTypeConverter(), rewriter)))
+      return success();
+    return Base::matchAndRewrite(op, adaptor, rewriter);
+  }
+
+  SmallVector<Value> createDestOps(mlir::arith::UIToFPOp op, OpAdaptor adaptor,
+                                   ConversionPatternRewriter &rewriter,
+                                   Type elemTy, MultipleOperandsRange operands,
+                                   Location loc) const {
+    Type inElemTy = getElementType(op.getIn());
+    Type outElemTy = getElementType(op.getOut());
+    if (outElemTy.isF16() && inElemTy.isInteger(8) && operands.size() >= 4) {
+      auto cvtFunc = makeConverterFromPtx(
+          getIntToFp16Ptx(/*isSigned=*/false, PackedInt::Byte),
+          getTypeConverter()->convertType(inElemTy),
+          getTypeConverter()->convertType(outElemTy));
+      SmallVector<Value> inVals = {operands[0][0], operands[1][0],
+                                   operands[2][0], operands[3][0]};
+      auto outVals = cvtFunc(loc, rewriter, inVals);
+      assert(outVals.size() == 4);
+      return outVals;
+    }
+    return {rewriter.create<LLVM::UIToFPOp>(loc, elemTy, operands[0][0])};
+  }
+};
+
 struct FPToSIOpConversion
     : ElementwiseOpConversionBase<mlir::arith::FPToSIOp, FPToSIOpConversion> {
   using Base =
@@ -1568,6 +1987,130 @@ struct ExpOpConversionApprox
   }
 };
 
+// An SFU instruction approximating a function of f32, and the factor its
+// result is multiplied by. The error bounds are those of the PTX ISA.
+struct ApproxF32Instr {
+  const char *name;
+  double scale;
+};
+
+// log(x) = lg2(x) * ln(2): 2^-22.6 absolute error for x in [0.5, 2], 2^-22
+// relative error elsewhere
+constexpr ApproxF32Instr approxLog = {"lg2.approx.f32", 0.6931471805599453};
+constexpr ApproxF32Instr approxLog2 = {"lg2.approx.f32", 1.0};
+// 2^-20.9 absolute error for x in [-pi, pi], growing with |x| beyond
+constexpr ApproxF32Instr approxSin = {"sin.approx.f32", 1.0};
+constexpr ApproxF32Instr approxCos = {"cos.approx.f32", 1.0};
+// 2^-22.9 relative error
+constexpr ApproxF32Instr approxRsqrt = {"rsqrt.approx.f32", 1.0};
+// 2^-11 relative error, from sm75
+constexpr ApproxF32Instr approxTanh = {"tanh.approx.f32", 1.0};
+
+static Value emitApproxF32(ConversionPatternRewriter &rewriter, Location loc,
+                           ApproxF32Instr approx, Value x) {
+  PTXBuilder ptxBuilder;
+  auto &instr = *ptxBuilder.create<PTXInstr>(approx.name);
+  auto output = ptxBuilder.newOperand("=f");
+  auto input = ptxBuilder.newOperand(x, "f");
+  instr(output, input);
+  Value ret = ptxBuilder.launch(rewriter, loc, f32_ty, false);
+  if (approx.scale != 1.0)
+    ret = fmul(f32_ty, ret, f32_val(approx.scale));
+  return ret;
+}
+
+// Fast-math lowering of the f32 `SourceOp` to an SFU instruction. Other types
+// fail to match and keep their precise lowering.
+template <typename SourceOp>
+struct ApproxOpConversion
+    : ElementwiseOpConversionBase<SourceOp, ApproxOpConversion<SourceOp>> {
+  using Base =
+      ElementwiseOpConversionBase<SourceOp, ApproxOpConversion<SourceOp>>;
+  using Adaptor = typename Base::OpAdaptor;
+
+  explicit ApproxOpConversion(TritonGPUToLLVMTypeConverter &typeConverter,
+                              ModuleAxisInfoAnalysis &axisAnalysisPass,
+                              ApproxF32Instr approx, PatternBenefit benefit = 1)
+      : Base(typeConverter, axisAnalysisPass, benefit), approx(approx) {}
+
+  SmallVector<Value> createDestOps(SourceOp op, Adaptor adaptor,
+                                   ConversionPatternRewriter &rewriter,
+                                   Type elemTy, MultipleOperandsRange operands,
+                                   Location loc) const {
+    if (!elemTy.isF32())
+      return {};
+    return {emitApproxF32(rewriter, loc, approx, operands[0][0])};
+  }
+
+private:
+  ApproxF32Instr approx;
+};
+
+// Fast-math lowering of the libdevice functions of f32 that have an SFU
+// instruction, the other calls keep going to libdevice.
+struct ExternElementwiseOpConversionApprox
+    : ElementwiseOpConversionBase<ExternElementwiseOp,
+                                  ExternElementwiseOpConversionApprox> {
+  using Base = ElementwiseOpConversionBase<ExternElementwiseOp,
+                                           ExternElementwiseOpConversionApprox>;
+  using Adaptor = typename Base::OpAdaptor;
+
+  explicit ExternElementwiseOpConversionApprox(
+      TritonGPUToLLVMTypeConverter &typeConverter,
+      ModuleAxisInfoAnalysis &axisAnalysisPass, int computeCapability,
+      PatternBenefit benefit = 1)
+      : ElementwiseOpConversionBase(typeConverter, axisAnalysisPass, benefit),
+        computeCapability(computeCapability) {}
+
+  SmallVector<Value> createDestOps(ExternElementwiseOp op, OpAdaptor adaptor,
+                                   ConversionPatternRewriter &rewriter,
+                                   Type elemTy, MultipleOperandsRange operands,
+                                   Location loc) const {
+    std::optional<ApproxF32Instr> approx =
+        llvm::StringSwitch<std::optional<ApproxF32Instr>>(op.getSymbol())
+            .Case("__nv_logf", approxLog)
+            .Case("__nv_log2f", approxLog2)
+            .Case("__nv_sinf", approxSin)
+            .Case("__nv_cosf", approxCos)
+            .Case("__nv_rsqrtf", approxRsqrt)
+            .Case("__nv_tanhf", computeCapability >= 75
+                                    ? std::optional(approxTanh)
+                                    : std::nullopt)
+            .Default(std::nullopt);
+    if (!approx || !elemTy.isF32())
+      return {};
+    return {emitApproxF32(rewriter, loc, *approx, operands[0][0])};
+  }
+
+private:
+  int computeCapability;
+};
+
+// Fast-math division of f32, a * (1 / b): 2 ulp error for |b| in
+// [2^-126, 2^126], 0 beyond. Shortens sigmoid, 1 / (1 + exp(-x)).
+struct FDivOpConversionApprox
+    : ElementwiseOpConversionBase<mlir::arith::DivFOp, FDivOpConversionApprox> {
+  using Base =
+      ElementwiseOpConversionBase<mlir::arith::DivFOp, FDivOpConversionApprox>;
+  using Base::Base;
+  using Adaptor = typename Base::OpAdaptor;
+
+  SmallVector<Value> createDestOps(mlir::arith::DivFOp op, OpAdaptor adaptor,
+                                   ConversionPatternRewriter &rewriter,
+                                   Type elemTy, MultipleOperandsRange operands,
+                                   Location loc) const {
+    if (!elemTy.isF32())
+      return {};
+    PTXBuilder ptxBuilder;
+    auto &fdiv = ptxBuilder.create<PTXInstr>("div")->o("approx").o("f32");
+    auto res = ptxBuilder.newOperand("=f");
+    auto lhs = ptxBuilder.newOperand(operands[0][0], "f");
+    auto rhs = ptxBuilder.newOperand(operands[0][1], "f");
+    fdiv(res, lhs, rhs);
+    return {ptxBuilder.launch(rewriter, loc, f32_ty, false)};
+  }
+};
+
 struct AbsIOpConversion
     : ElementwiseOpConversionBase<mlir::math::AbsIOp, AbsIOpConversion> {
   using Base =
@@ -1644,6 +2187,15 @@ struct MinMaxFOpConversion
                                    Type elemTy, MultipleOperandsRange operands,
                                    Location loc) const {
     if (computeCapability >= 80) {
+      Type inElemTy = getElementType(op.getLhs());
+      if (isPackable16BitFloat(inElemTy, operands)) {
+        std::string ptxAsm = std::is_same<OpTy, arith::MinimumFOp>::value
+                                 ? "min.NaN."
+                                 : "max.NaN.";
+        ptxAsm += inElemTy.isF16() ? "f16x2" : "bf16x2";
+        return emitPacked16BitOp(rewriter, loc, elemTy, operands,
+                                 ptxAsm + " $0, $1, $2;");
+      }
       return {rewriter.create<DestOpNanProp>(loc, elemTy, operands[0][0],
                                              operands[0][1])};
     }
@@ -1834,6 +2386,13 @@ struct SelectOpConversion
                                    Type elemTy, MultipleOperandsRange operands,
                                    Location loc) const {
     std::array<Value, 3> llvmOperands;
+    if (operands[0].size() == 2 &&
+        isPackable16BitFloat(getElementType(op.getTrueValue()), operands)) {
+      // A scalar condition selects both halves of the packed registers
+      return emitPacked16BitOp(rewriter, loc, elemTy, operands,
+                               "selp.b32 $0, $2, $3, $1;",
+                               adaptor.getCondition());
+    }
     if (operands[0].size() == 2) {
       // Case of scalar condition with tensor operands.
       assert(op.getCondition().getType().isInteger(1));
@@ -1890,7 +2449,6 @@ void mlir::triton::populateElementwiseOpToLLVMPatterns(
   POPULATE_UNARY_OP(arith::ExtSIOp, LLVM::SExtOp)
   POPULATE_UNARY_OP(arith::ExtUIOp, LLVM::ZExtOp)
   POPULATE_UNARY_OP(arith::FPToUIOp, LLVM::FPToUIOp)
-  POPULATE_UNARY_OP(arith::UIToFPOp, LLVM::UIToFPOp)
   POPULATE_UNARY_OP(math::LogOp, math::LogOp)
   POPULATE_UNARY_OP(math::CosOp, math::CosOp)
   POPULATE_UNARY_OP(math::SinOp, math::SinOp)
@@ -1916,6 +2474,7 @@ void mlir::triton::populateElementwiseOpToLLVMPatterns(
   patterns.add<TruncFOpConversion>(typeConverter, axisInfoAnalysis, benefit);
   patterns.add<FPToSIOpConversion>(typeConverter, axisInfoAnalysis, benefit);
   patterns.add<SIToFPOpConversion>(typeConverter, axisInfoAnalysis, benefit);
+  patterns.add<UIToFPOpConversion>(typeConverter, axisInfoAnalysis, benefit);
   patterns.add<IndexCastOpLowering>(typeConverter, axisInfoAnalysis, benefit);
 
   patterns.add<FpToFpOpConversion>(typeConverter, axisInfoAnalysis,
@@ -1936,3 +2495,19 @@ void mlir::triton::populateElementwiseOpToLLVMPatterns(
   patterns.add<MinMaxFOpConversion<arith::MaximumFOp>>(
       typeConverter, axisInfoAnalysis, computeCapability, benefit);
 }
+
+void mlir::triton::populateFastMathOpToLLVMPatterns(
+    TritonGPUToLLVMTypeConverter &typeConverter, RewritePatternSet &patterns,
+    ModuleAxisInfoAnalysis &axisInfoAnalysis, int computeCapability,
+    PatternBenefit benefit) {
+  patterns.add<ApproxOpConversion<math::LogOp>>(typeConverter, axisInfoAnalysis,
+                                                approxLog, benefit);
+  patterns.add<ApproxOpConversion<math::SinOp>>(typeConverter, axisInfoAnalysis,
+                                                approxSin, benefit);
+  patterns.add<ApproxOpConversion<math::CosOp>>(typeConverter, axisInfoAnalysis,
+                                                approxCos, benefit);
+  patterns.add<ExternElementwiseOpConversionApprox>(
+      typeConverter, axisInfoAnalysis, computeCapability, benefit);
+  patterns.add<FDivOpConversionApprox>(typeConverter, axisInfoAnalysis,
+                                       benefit);
+}
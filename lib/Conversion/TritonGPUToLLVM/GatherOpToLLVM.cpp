@@ -0,0 +1,182 @@
+#include "PatternTritonGPUOpToLLVM.h"
+#include "TritonGPUToLLVMBase.h"
+#include "triton/Analysis/Utility.h"
+
+using namespace mlir;
+using namespace mlir::triton;
+
+using ::mlir::LLVM::shflIdxSync;
+
+namespace {
+// Lowering of gathers along an axis. When the layouts keep the gathered
+// elements within the warps, each element is picked from the registers of its
+// thread with selects, or read from the lane that holds it with a shuffle.
+// Otherwise the source goes through shared memory.
+struct GatherOpConversion
+    : public ConvertTritonGPUOpToLLVMPattern<triton::GatherOp> {
+public:
+  using ConvertTritonGPUOpToLLVMPattern<
+      triton::GatherOp>::ConvertTritonGPUOpToLLVMPattern;
+
+  LogicalResult
+  matchAndRewrite(triton::GatherOp op, OpAdaptor adaptor,
+                  ConversionPatternRewriter &rewriter) const override {
+    auto mod = op->getParentOfType<ModuleOp>();
+    if (triton::gpu::TritonGPUDialect::getNumCTAs(mod) > 1)
+      return op.emitError("gathers across CTAs are not supported");
+    Location loc = op.getLoc();
+    SmallVector<Value> srcVals =
+        getTypeConverter()->unpackLLElements(loc, adaptor.getSrc(), rewriter);
+    SmallVector<Value> indices = getTypeConverter()->unpackLLElements(
+        loc, adaptor.getIndices(), rewriter);
+    // The indices wrap around the axis, which has a power of two size
+    auto srcTy = op.getSrc().getType().cast<RankedTensorType>();
+    unsigned axis = op.getAxis();
+    Value axisMask = i32_val(srcTy.getDimSize(axis) - 1);
+    for (Value &index : indices) {
+      unsigned bitWidth = index.getType().getIntOrFloatBitWidth();
+      if (bitWidth > 32)
+        index = trunc(i32_ty, index);
+      else if (bitWidth < 32)
+        index = sext(i32_ty, index);
+      index = and_(index, axisMask);
+    }
+
+    SmallVector<Value> results;
+    if (auto gather = getWarpLocalGather(op))
+      results = gatherWithinWarp(loc, rewriter, *gather, srcVals, indices);
+    else
+      results = gatherThroughShared(op, loc, rewriter, srcVals, indices);
+    Value result = getTypeConverter()->packLLElements(
+        loc, results, rewriter, op.getResult().getType());
+    rewriter.replaceOp(op, result);
+    return success();
+  }
+
+private:
+  // Returns the XOR of `bases[i]` for each bit `i` set in `value`.
+  Value applyBases(Location loc, ConversionPatternRewriter &rewriter,
+                   Value value, ArrayRef<unsigned> bases) const {
+    Value ret = i32_val(0);
+    for (unsigned i = 0; i < bases.size(); ++i) {
+      if (bases[i] == 0)
+        continue;
+      Value bit = and_(lshr(value, i32_val(i)), i32_val(1));
+      ret = xor_(ret, mul(bit, i32_val(bases[i])));
+    }
+    return ret;
+  }
+
+  SmallVector<Value> gatherWithinWarp(Location loc,
+                                      ConversionPatternRewriter &rewriter,
+                                      const triton::WarpLocalGather &gather,
+                                      ArrayRef<Value> srcVals,
+                                      ArrayRef<Value> indices) const {
+    bool isThreadLocal = gather.isThreadLocal();
+    Value laneIdLanes;
+    if (!isThreadLocal) {
+      Value laneId = urem(getThreadId(rewriter, loc),
+                          i32_val(1u << gather.laneBases.size()));
+      laneIdLanes = applyBases(loc, rewriter, laneId, gather.laneBases);
+    }
+    // The registers an element may be read from differ in the bits the
+    // index can flip.
+    unsigned dynamicRegs = 0;
+    for (unsigned regs : gather.indexRegBases)
+      dynamicRegs |= regs;
+    SmallVector<unsigned> dynamicRegBits;
+    for (unsigned bit = 0; (1u << bit) <= dynamicRegs; ++bit)
+      if (dynamicRegs & (1u << bit))
+        dynamicRegBits.push_back(bit);
+
+    Type type = srcVals[0].getType();
+    bool isPointer = type.isa<LLVM::LLVMPointerType>();
+    SmallVector<Value> results;
+    for (unsigned r = 0; r < indices.size(); ++r) {
+      Value index = indices[r];
+      Value srcLane;
+      if (!isThreadLocal) {
+        srcLane = xor_(laneIdLanes, i32_val(gather.srcLanes[r]));
+        srcLane = xor_(srcLane,
+                       applyBases(loc, rewriter, index, gather.indexLaneBases));
+      }
+      // The candidates, in the order of the bits of dynamicRegBits
+      SmallVector<Value> candidates;
+      for (unsigned i = 0; i < (1u << dynamicRegBits.size()); ++i) {
+        unsigned reg = gather.srcRegisters[r];
+        for (unsigned j = 0; j < dynamicRegBits.size(); ++j)
+          if (i & (1u << j))
+            reg ^= 1u << dynamicRegBits[j];
+        Value val = srcVals[reg];
+        if (!isThreadLocal) {
+          // Pointers are shuffled as integers
+          if (isPointer)
+            val = ptrtoint(i64_ty, val);
+          val = shflIdxSync(loc, rewriter, val, srcLane);
+          if (isPointer)
+            val = inttoptr(type, val);
+        }
+        candidates.push_back(val);
+      }
+      // Pick the candidate with a tree of selects over the register bits
+      Value srcReg = applyBases(loc, rewriter, index, gather.indexRegBases);
+      for (unsigned bit : dynamicRegBits) {
+        Value isSet = icmp_ne(and_(srcReg, i32_val(1u << bit)), i32_val(0));
+        SmallVector<Value> picked;
+        for (unsigned i = 0; i < candidates.size(); i += 2)
+          picked.push_back(select(isSet, candidates[i + 1], candidates[i]));
+        candidates = std::move(picked);
+      }
+      results.push_back(candidates[0]);
+    }
+    return results;
+  }
+
+  SmallVector<Value> gatherThroughShared(triton::GatherOp op, Location loc,
+                                         ConversionPatternRewriter &rewriter,
+                                         ArrayRef<Value> srcVals,
+                                         ArrayRef<Value> indices) const {
+    auto srcTy = op.getSrc().getType().cast<RankedTensorType>();
+    auto indicesTy = op.getIndices().getType().cast<RankedTensorType>();
+    unsigned axis = op.getAxis();
+    Type elemTy = getTypeConverter()->convertType(srcTy.getElementType());
+    Value smemBase = getSharedMemoryBase(loc, rewriter, op.getOperation());
+    Type smemPtrTy = ptr_ty(rewriter.getContext(), 3);
+    // The source is stored in row-major order, the threads holding the same
+    // element all storing it.
+    auto srcShape = srcTy.getShape();
+    auto linearize = [&](ArrayRef<Value> offsets) {
+      Value offset = i32_val(0);
+      for (unsigned d = 0; d < offsets.size(); ++d)
+        offset = add(mul(offset, i32_val(srcShape[d])), offsets[d]);
+      return offset;
+    };
+    auto srcOffsets = emitIndices(loc, rewriter, srcTy.getEncoding(), srcTy);
+    for (unsigned i = 0; i < srcVals.size(); ++i) {
+      Value ptr = gep(smemPtrTy, elemTy, smemBase, linearize(srcOffsets[i]));
+      store(srcVals[i], ptr);
+    }
+    barrier();
+    auto dstOffsets =
+        emitIndices(loc, rewriter, indicesTy.getEncoding(), indicesTy);
+    SmallVector<Value> results;
+    for (unsigned i = 0; i < indices.size(); ++i) {
+      SmallVector<Value> offsets = dstOffsets[i];
+      offsets[axis] = indices[i];
+      Value ptr = gep(smemPtrTy, elemTy, smemBase, linearize(offsets));
+      results.push_back(load(elemTy, ptr));
+    }
+    return results;
+  }
+};
+} // namespace
+
+void mlir::triton::populateGatherOpToLLVMPatterns(
+    TritonGPUToLLVMTypeConverter &typeConverter, RewritePatternSet &patterns,
+    int numWarps, ModuleAxisInfoAnalysis &axisInfoAnalysis,
+    ModuleAllocation &allocation,
+    ConvertTritonGPUOpToLLVMPatternBase::IndexCacheInfo &indexCacheInfo,
+    PatternBenefit benefit) {
+  patterns.add<GatherOpConversion>(typeConverter, allocation, indexCacheInfo,
+                                   benefit);
+}
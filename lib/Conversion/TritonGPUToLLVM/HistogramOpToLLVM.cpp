@@ -133,6 +133,53 @@ static SmallVector<Value> computeCrossWarpHistogram(
   return histogramValues;
 }
 
+// Compute a histogram with one sub-histogram per warp in shared memory, or one
+// per `numCopies` warps, merged when loading the results. Unlike the ballots
+// this neither needs a power of two number of bins nor costs more per value
+// as the bins grow. `isUnique` is false where the values are replicated, they
+// and the values out of the bins count zero.
+static SmallVector<Value> computePrivatizedHistogram(
+    Location loc, ConversionPatternRewriter &rewriter, Value baseSharedMemPtr,
+    const SmallVector<Value> &srcValues, Value isUnique, int numBins,
+    int numCopies, const SmallVector<Value> &indices, Value threadId,
+    int numThreadPerWarp, int numWarps) {
+  // Initialize the sub-histograms with zeros.
+  int64_t numThreads = numThreadPerWarp * numWarps;
+  int64_t numEntries = numBins * numCopies;
+  for (int64_t i = 0; i < ceil<int64_t>(numEntries, numThreads); ++i) {
+    Value offset = add(threadId, i32_val(i * numThreads));
+    offset = urem(offset, i32_val(numEntries));
+    Value sharedMemPtr =
+        gep(baseSharedMemPtr.getType(), i32_ty, baseSharedMemPtr, offset);
+    store(i32_val(0), sharedMemPtr);
+  }
+  barrier();
+  Value warpId = udiv(threadId, i32_val(numThreadPerWarp));
+  Value copyOffset = mul(urem(warpId, i32_val(numCopies)), i32_val(numBins));
+  for (Value value : srcValues) {
+    Value inBins = icmp_ult(value, i32_val(numBins));
+    Value bin = select(inBins, value, i32_val(0));
+    Value count = zext(i32_ty, and_(isUnique, inBins));
+    Value sharedMemPtr = gep(baseSharedMemPtr.getType(), i32_ty,
+                             baseSharedMemPtr, add(copyOffset, bin));
+    atomicAdd(sharedMemPtr, count, loc, rewriter);
+  }
+  barrier();
+  // Merge the sub-histograms while loading the histogram to registers.
+  SmallVector<Value> histogramValues;
+  for (Value index : indices) {
+    Value sum = i32_val(0);
+    for (int i = 0; i < numCopies; ++i) {
+      Value sharedMemPtr =
+          gep(baseSharedMemPtr.getType(), i32_ty, baseSharedMemPtr,
+              add(index, i32_val(i * numBins)));
+      sum = add(sum, load(i32_ty, sharedMemPtr));
+    }
+    histogramValues.push_back(sum);
+  }
+  return histogramValues;
+}
+
 namespace {
 struct HistogramOpConversion
     : public ConvertTritonGPUOpToLLVMPattern<triton::HistogramOp> {
@@ -150,20 +197,8 @@ public:
     int numBins =
         op.getResult().getType().cast<RankedTensorType>().getDimSize(0);
     int numThreadsPerWarp = 32;
-    // Pad out the bins so that we have at least one bin per thread within a
-    // warp.
-    numBins = std::max(numBins, numThreadsPerWarp);
     Value threadId = getThreadId(rewriter, loc);
     auto srcType = op.getInput().getType().cast<RankedTensorType>();
-    // First compute a warp local histogram based on values owned by each warps.
-    SmallVector<Value> warpLevelHistogram =
-        computeWarpLevelHistogram(loc, srcType, srcValues, numBins,
-                                  numThreadsPerWarp, threadId, rewriter);
-
-    // Then use atomic to update the histogram in shared memory.
-    // TODO: we could skip this for cases with num_warps=1 as long as we can
-    // generate the right layout. Currently the warp level histogram generates
-    // data in the default blocked layout.
     Value baseSharedMemPtr =
         getSharedMemoryBase(loc, rewriter, op.getOperation());
     auto dstType = op.getResult().getType().cast<RankedTensorType>();
@@ -174,6 +209,30 @@ public:
     SmallVector<Value> innerDimIndices;
     for (int i = 0; i < indices.size(); ++i)
       innerDimIndices.push_back(indices[i][0]);
+
+    if (unsigned numCopies = getNumPrivatizedHistograms(op)) {
+      Value isUnique = getMask(srcType, rewriter, loc);
+      SmallVector<Value> histogramValue = computePrivatizedHistogram(
+          loc, rewriter, baseSharedMemPtr, srcValues, isUnique, numBins,
+          numCopies, innerDimIndices, threadId, numThreadsPerWarp, numWarps);
+      Value results = getTypeConverter()->packLLElements(
+          loc, histogramValue, rewriter, op.getResult().getType());
+      rewriter.replaceOp(op, results);
+      return success();
+    }
+
+    // Pad out the bins so that we have at least one bin per thread within a
+    // warp.
+    numBins = std::max(numBins, numThreadsPerWarp);
+    // First compute a warp local histogram based on values owned by each warps.
+    SmallVector<Value> warpLevelHistogram =
+        computeWarpLevelHistogram(loc, srcType, srcValues, numBins,
+                                  numThreadsPerWarp, threadId, rewriter);
+
+    // Then use atomic to update the histogram in shared memory.
+    // TODO: we could skip this for cases with num_warps=1 as long as we can
+    // generate the right layout. Currently the warp level histogram generates
+    // data in the default blocked layout.
     SmallVector<Value> histogramValue = computeCrossWarpHistogram(
         loc, rewriter, srcType, baseSharedMemPtr, warpLevelHistogram, numBins,
         numThreadsPerWarp, innerDimIndices, threadId, numWarps);
@@ -38,8 +38,10 @@ static CUtensorMapDataType getCUtensorMapDataType(Type ty) {
 namespace {
 // Contains some helper functions for both Load and Store conversions.
 struct LoadStoreConversionBase {
-  explicit LoadStoreConversionBase(ModuleAxisInfoAnalysis &axisAnalysisPass)
-      : axisAnalysisPass(axisAnalysisPass) {}
+  explicit LoadStoreConversionBase(ModuleAxisInfoAnalysis &axisAnalysisPass,
+                                   int computeCapability = 0)
+      : axisAnalysisPass(axisAnalysisPass),
+        computeCapability(computeCapability) {}
 
   unsigned getContiguity(Value ptr) const {
     auto tensorTy = ptr.getType().dyn_cast<RankedTensorType>();
@@ -62,8 +64,37 @@ struct LoadStoreConversionBase {
     return axisAnalysisPass.getMaskAlignment(mask);
   }
 
+  // Masks that are proven always true, e.g. by the bounds of the loop they
+  // are in, don't need to predicate the access.
+  bool isMaskAlwaysTrue(Value mask) const {
+    auto *axisInfo = axisAnalysisPass.getAxisInfo(mask);
+    return axisInfo && axisInfo->getConstantValue() == 1;
+  }
+
+  // Creates the L2 cache policy of an access evicted first or last, which
+  // keeps its L2 lines with the same priority as its L1 ones, e.g. for
+  // streamed activations or reused KV-cache blocks. Returns a null value if
+  // the access has no L2 policy, they need sm80.
+  Value createL2CachePolicy(ConversionPatternRewriter &rewriter, Location loc,
+                            triton::EvictionPolicy evict) const {
+    std::string priority;
+    if (evict == triton::EvictionPolicy::EVICT_FIRST)
+      priority = "L2::evict_first";
+    else if (evict == triton::EvictionPolicy::EVICT_LAST)
+      priority = "L2::evict_last";
+    if (priority.empty() || computeCapability < 80)
+      return Value();
+    PTXBuilder ptxBuilder;
+    auto &createPolicy =
+        ptxBuilder.create<>("createpolicy")->o("fractional").o(priority).b(64);
+    createPolicy(ptxBuilder.newOperand("=l"),
+                 ptxBuilder.newConstantOperand("1.0"));
+    return ptxBuilder.launch(rewriter, loc, i64_ty, /*hasSideEffect*/ false);
+  }
+
 protected:
   ModuleAxisInfoAnalysis &axisAnalysisPass;
+  int computeCapability;
 };
 
 struct LoadOpConversion
@@ -74,9 +105,9 @@ struct LoadOpConversion
 
   LoadOpConversion(TritonGPUToLLVMTypeConverter &converter,
                    ModuleAxisInfoAnalysis &axisAnalysisPass,
-                   PatternBenefit benefit)
+                   int computeCapability, PatternBenefit benefit)
       : ConvertTritonGPUOpToLLVMPattern<triton::LoadOp>(converter, benefit),
-        LoadStoreConversionBase(axisAnalysisPass) {}
+        LoadStoreConversionBase(axisAnalysisPass, computeCapability) {}
 
   LogicalResult
   matchAndRewrite(triton::LoadOp op, OpAdaptor adaptor,
@@ -95,6 +126,11 @@ struct LoadOpConversion
     Value llPtr = adaptor.getPtr();
     Value llMask = adaptor.getMask();
     Value llOther = adaptor.getOther();
+    if (mask && isMaskAlwaysTrue(mask)) {
+      // `other` is never selected either
+      mask = llMask = Value();
+      other = llOther = Value();
+    }
 
     // Determine the vectorization size
     Type valueTy = op.getResult().getType();
@@ -138,6 +174,11 @@ struct LoadOpConversion
         std::max(8u, valueElemTy.getIntOrFloatBitWidth());
     const int numVecs = numElems / vec;
 
+    // Volatile loads take no cache hint
+    Value l2Policy;
+    if (!op.getIsVolatile())
+      l2Policy = createL2CachePolicy(rewriter, loc, op.getEvict());
+
     SmallVector<Value> loadedVals;
     for (size_t vecStart = 0; vecStart < numElems; vecStart += vec) {
       // TODO: optimization when ptr is GEP with constant offset
@@ -151,10 +192,6 @@ struct LoadOpConversion
       const size_t movWidth = width < 16 ? 16 : width;
       assert(wordNElems * nWords * numVecs == numElems);
 
-      // TODO(Superjomn) Add cache policy fields to StoreOp.
-      // TODO(Superjomn) Deal with cache policy here.
-      const bool hasL2EvictPolicy = false;
-
       PTXBuilder ptxBuilder;
 
       Value pred = mask ? maskElems[vecStart] : int_val(1, 1);
@@ -185,15 +222,15 @@ struct LoadOpConversion
                         op.getEvict() == triton::EvictionPolicy::EVICT_FIRST)
                      .o("L1::evict_last",
                         op.getEvict() == triton::EvictionPolicy::EVICT_LAST)
-                     .o("L1::cache_hint", hasL2EvictPolicy)
+                     .o("L1::no_allocate",
+                        op.getEvict() == triton::EvictionPolicy::NO_ALLOCATE)
+                     .o("L2::cache_hint", bool(l2Policy))
                      .v(nWords)
                      .b(width);
 
       PTXBuilder::Operand *evictOpr{};
-
-      // Here lack a mlir::Value to bind to this operation, so disabled.
-      // if (has_l2_evict_policy)
-      //   evictOpr = ptxBuilder.newOperand(l2Evict, "l");
+      if (l2Policy)
+        evictOpr = ptxBuilder.newOperand(l2Policy, "l");
 
       if (!evictOpr)
         ld(dstsOpr, addrOpr).predicate(pred, "b");
@@ -237,10 +274,6 @@ struct LoadOpConversion
                        ? LLVM::LLVMStructType::getLiteral(getContext(), retTys)
                        : retTys[0];
 
-      // TODO: if (has_l2_evict_policy)
-      // auto asmDialectAttr =
-      // LLVM::AsmDialectAttr::get(rewriter.getContext(),
-      //                                                 LLVM::AsmDialect::AD_ATT);
       Value ret = ptxBuilder.launch(rewriter, loc, retTy);
 
       // Extract and store return values
@@ -281,9 +314,9 @@ struct StoreOpConversion
 
   StoreOpConversion(TritonGPUToLLVMTypeConverter &converter,
                     ModuleAxisInfoAnalysis &axisAnalysisPass,
-                    PatternBenefit benefit)
+                    int computeCapability, PatternBenefit benefit)
       : ConvertTritonGPUOpToLLVMPattern<triton::StoreOp>(converter, benefit),
-        LoadStoreConversionBase(axisAnalysisPass) {}
+        LoadStoreConversionBase(axisAnalysisPass, computeCapability) {}
 
   LogicalResult
   matchAndRewrite(triton::StoreOp op, OpAdaptor adaptor,
@@ -294,6 +327,8 @@ struct StoreOpConversion
     Value llPtr = adaptor.getPtr();
     Value llMask = adaptor.getMask();
     Value llValue = adaptor.getValue();
+    if (llMask && isMaskAlwaysTrue(op.getMask()))
+      llMask = Value();
 
     auto loc = op->getLoc();
     MLIRContext *ctx = rewriter.getContext();
@@ -327,6 +362,7 @@ struct StoreOpConversion
     const size_t valueElemNBits = dtsize * 8;
 
     const int numVecs = elemsPerThread / vec;
+    Value l2Policy = createL2CachePolicy(rewriter, loc, op.getEvict());
     for (size_t vecStart = 0; vecStart < elemsPerThread; vecStart += vec) {
       // TODO: optimization when ptr is AddPtr with constant offset
       size_t in_off = 0;
@@ -338,9 +374,6 @@ struct StoreOpConversion
       const size_t wordNElems = width / valueElemNBits;
       assert(wordNElems * nWords * numVecs == elemsPerThread);
 
-      // TODO(Superjomn) Add cache policy fields to StoreOp.
-      // TODO(Superjomn) Deal with cache policy here.
-
       Type valArgTy = IntegerType::get(ctx, width);
       auto wordTy = vec_ty(valueElemTy, wordNElems);
 
@@ -385,9 +418,17 @@ struct StoreOpConversion
                  op.getEvict() == triton::EvictionPolicy::EVICT_FIRST)
               .o("L1::evict_last",
                  op.getEvict() == triton::EvictionPolicy::EVICT_LAST)
+              .o("L1::no_allocate",
+                 op.getEvict() == triton::EvictionPolicy::NO_ALLOCATE)
+              .o("L2::cache_hint", bool(l2Policy))
               .v(nWords)
               .b(width);
-      ptxStoreInstr(asmAddr, asmArgList).predicate(maskVal, "b");
+      if (l2Policy)
+        ptxStoreInstr(asmAddr, asmArgList,
+                      ptxBuilder.newOperand(l2Policy, "l"))
+            .predicate(maskVal, "b");
+      else
+        ptxStoreInstr(asmAddr, asmArgList).predicate(maskVal, "b");
 
       Type boolTy = getTypeConverter()->convertType(rewriter.getIntegerType(1));
       llvm::SmallVector<Type> argTys({boolTy, ptr.getType()});
@@ -401,6 +442,63 @@ struct StoreOpConversion
     return success();
   }
 };
+
+// Prefetches the lines of each vector of contiguous elements of a thread into
+// L2, the replicated elements of the layout being prefetched by one thread.
+// A line is larger than a vector, so the bulk prefetch of sm90, which
+// prefetches a range, isn't needed.
+struct PrefetchOpConversion
+    : public ConvertTritonGPUOpToLLVMPattern<triton::PrefetchOp>,
+      public LoadStoreConversionBase {
+  using ConvertTritonGPUOpToLLVMPattern<
+      triton::PrefetchOp>::ConvertTritonGPUOpToLLVMPattern;
+
+  PrefetchOpConversion(TritonGPUToLLVMTypeConverter &converter,
+                       ModuleAxisInfoAnalysis &axisAnalysisPass,
+                       int computeCapability, PatternBenefit benefit)
+      : ConvertTritonGPUOpToLLVMPattern<triton::PrefetchOp>(converter,
+                                                            benefit),
+        LoadStoreConversionBase(axisAnalysisPass, computeCapability) {}
+
+  LogicalResult
+  matchAndRewrite(triton::PrefetchOp op, OpAdaptor adaptor,
+                  ConversionPatternRewriter &rewriter) const override {
+    auto loc = op->getLoc();
+    Value ptr = op.getPtr();
+    Value llMask = adaptor.getMask();
+    if (llMask && isMaskAlwaysTrue(op.getMask()))
+      llMask = Value();
+
+    unsigned vec = getVectorSize(ptr);
+    unsigned numElems = getTotalElemsPerThread(ptr.getType());
+    auto ptrElems =
+        getTypeConverter()->unpackLLElements(loc, adaptor.getPtr(), rewriter);
+    assert(ptrElems.size() == numElems);
+    SmallVector<Value> maskElems;
+    if (llMask) {
+      maskElems = getTypeConverter()->unpackLLElements(loc, llMask, rewriter);
+      assert(maskElems.size() == numElems);
+      vec = std::min(vec, getMaskAlignment(op.getMask()));
+    }
+
+    Value mask = getMask(ptr.getType(), rewriter, loc);
+    // The prefetched lines only take an eviction priority from sm80
+    bool evictLast = op.getEvict() == triton::EvictionPolicy::EVICT_LAST &&
+                     computeCapability >= 80;
+    for (size_t vecStart = 0; vecStart < numElems; vecStart += vec) {
+      PTXBuilder ptxBuilder;
+      auto &prefetch = ptxBuilder.create<>("prefetch")->global().o(
+          evictLast ? "L2::evict_last" : "L2");
+      auto *addrOpr = ptxBuilder.newAddrOperand(ptrElems[vecStart], "l");
+      Value pred = llMask ? and_(mask, maskElems[vecStart]) : mask;
+      prefetch(addrOpr).predicate(pred, "b");
+      ptxBuilder.launch(rewriter, loc, void_ty(getContext()));
+    }
+    rewriter.eraseOp(op);
+    return success();
+  }
+};
+
 // TODO: refactor to save common logic with insertsliceasyncv2
 struct StoreAsyncTMAOpConversion : public ConvertTritonGPUOpToLLVMPattern<
                                        triton::nvidia_gpu::StoreAsyncTMAOp> {
@@ -1061,10 +1159,112 @@ struct AtomicRMWOpConversion
   AtomicRMWOpConversion(TritonGPUToLLVMTypeConverter &converter,
                         ModuleAllocation &allocation,
                         ModuleAxisInfoAnalysis &axisAnalysisPass,
-                        PatternBenefit benefit)
+                        int computeCapability, PatternBenefit benefit)
       : ConvertTritonGPUOpToLLVMPattern<triton::AtomicRMWOp>(
             converter, allocation, benefit),
-        LoadStoreConversionBase(axisAnalysisPass) {}
+        LoadStoreConversionBase(axisAnalysisPass, computeCapability) {}
+
+  // Returns the most elements of `elemTy` an atomic `rmwOp` updates at once:
+  // two packed 16-bit floats, bf16 ones from sm90, and from sm90 the 128 bits
+  // of the vectorized reductions, which don't return the old values.
+  unsigned getMaxAtomicVectorSize(RMWOp rmwOp, Type elemTy,
+                                  bool isReduction) const {
+    if (rmwOp != RMWOp::FADD)
+      return 1;
+    unsigned bits = elemTy.getIntOrFloatBitWidth();
+    if (isReduction && computeCapability >= 90 && bits <= 32)
+      return 128 / bits;
+    if (bits != 16 || (elemTy.isBF16() && computeCapability < 90))
+      return 1;
+    return 2;
+  }
+
+  // Whether the lanes of a warp updating the same address should first
+  // combine their values, so that one atomic per address is issued: if
+  // requested by `tt.warp_aggregate` or if the pointers are constant across
+  // the lanes.
+  bool shouldAggregateInWarp(triton::AtomicRMWOp op) const {
+    if (computeCapability < 70)
+      return false;
+    if (op->hasAttr("tt.warp_aggregate"))
+      return true;
+    auto tensorTy = op.getPtr().getType().cast<RankedTensorType>();
+    AxisInfo *axisInfo = axisAnalysisPass.getAxisInfo(op.getPtr());
+    if (!axisInfo)
+      return false;
+    auto sizePerThread = triton::gpu::getSizePerThread(tensorTy.getEncoding());
+    for (unsigned d = 0; d < tensorTy.getRank(); ++d)
+      if (axisInfo->getConstancy(d) > sizePerThread[d])
+        return true;
+    return false;
+  }
+
+  // Combines `val` across the lanes whose `pred` is true and that update the
+  // same `ptr`. The lanes matching each address are found by match.any, and
+  // their values are reduced as a tree over their ranks, each lane reading
+  // the one `s` ranks above it with fns, whose base lane counts as the first
+  // match. `pred` is left true on the lowest lane of each address only, which
+  // holds the combined value.
+  Value aggregateInWarp(ConversionPatternRewriter &rewriter, Location loc,
+                        RMWOp rmwOp, Value val, Value ptr, Value &pred) const {
+    Value key = select(pred, ptrtoint(i64_ty, ptr), int_val(64, 0));
+    PTXBuilder matchBuilder;
+    auto &match = matchBuilder.create<>("match")->o("any").o("sync").o("b64");
+    match(matchBuilder.newOperand("=r"), matchBuilder.newOperand(key, "l"),
+          matchBuilder.newConstantOperand("0xffffffff"));
+    Value peers = matchBuilder.launch(rewriter, loc, i32_ty, false);
+    Value laneId = getSRegValue(rewriter, loc, "%laneid");
+    Value lanesBelow = getSRegValue(rewriter, loc, "%lanemask_lt");
+    Value rank =
+        rewriter.create<LLVM::CtPopOp>(loc, i32_ty, and_(peers, lanesBelow));
+    for (int s = 1; s < 32; s *= 2) {
+      PTXBuilder fnsBuilder;
+      auto &fns = fnsBuilder.create<>("fns")->o("b32");
+      fns(fnsBuilder.newOperand("=r"), fnsBuilder.newOperand(peers, "r"),
+          fnsBuilder.newOperand(laneId, "r"),
+          fnsBuilder.newConstantOperand(std::to_string(s + 1)));
+      Value srcLane = fnsBuilder.launch(rewriter, loc, i32_ty, false);
+      Value other = shflIdxSync(loc, rewriter, val, srcLane);
+      Value hasOther =
+          and_(icmp_ne(srcLane, i32_val(-1)),
+               icmp_eq(and_(rank, i32_val(2 * s - 1)), i32_val(0)));
+      Value combined;
+      switch (rmwOp) {
+      case RMWOp::FADD:
+        combined = fadd(val, other);
+        break;
+      case RMWOp::ADD:
+        combined = add(val, other);
+        break;
+      case RMWOp::AND:
+        combined = and_(val, other);
+        break;
+      case RMWOp::OR:
+        combined = or_(val, other);
+        break;
+      case RMWOp::XOR:
+        combined = xor_(val, other);
+        break;
+      case RMWOp::MAX:
+        combined = smax(val, other);
+        break;
+      case RMWOp::MIN:
+        combined = smin(val, other);
+        break;
+      case RMWOp::UMAX:
+        combined = umax(val, other);
+        break;
+      case RMWOp::UMIN:
+        combined = umin(val, other);
+        break;
+      default:
+        llvm_unreachable("unexpected atomic to aggregate");
+      }
+      val = select(hasOther, combined, val);
+    }
+    pred = and_(pred, icmp_eq(rank, i32_val(0)));
+    return val;
+  }
 
   LogicalResult
   matchAndRewrite(triton::AtomicRMWOp op, OpAdaptor adaptor,
@@ -1100,42 +1300,80 @@ struct AtomicRMWOpConversion
         tensorTy ? getTypeConverter()->convertType(tensorTy.getElementType())
                  : valueTy;
     const size_t valueElemNBits = valueElemTy.getIntOrFloatBitWidth();
+    bool isBF16 = valueElemTy.isBF16();
+    if (isBF16 && atomicRmwAttr == RMWOp::FADD && computeCapability < 90)
+      return op.emitError("bf16 atomic adds need compute capability 90");
     auto elemsPerThread = getTotalElemsPerThread(val.getType());
+    // The atomics whose result is unused are reductions, which don't return
+    // the old values. They have no exchange and no acquire semantics.
+    MemSemantic sem = op.getSem();
+    bool isReduction =
+        op.getResult().use_empty() && atomicRmwAttr != RMWOp::XCHG &&
+        (sem == MemSemantic::RELAXED || sem == MemSemantic::RELEASE);
+    // Only the atomics whose result is unused are aggregated, the lanes
+    // would otherwise need the old values of the lanes below them. The
+    // combined lanes are ordered by the atomic of the one issuing it.
+    bool aggregate = op.getResult().use_empty() &&
+                     atomicRmwAttr != RMWOp::XCHG && tensorTy &&
+                     shouldAggregateInWarp(op);
     // vec = 1, numElements = 1 for scalar
     auto vec = getVectorSize(ptr);
     int numElems = 1;
     // tensor
     if (tensorTy) {
-      auto valTy = val.getType().cast<RankedTensorType>();
-      vec = std::min<unsigned>(vec, valTy.getElementType().isF16() ? 2 : 1);
+      vec = std::min(vec, getMaxAtomicVectorSize(atomicRmwAttr, valueElemTy,
+                                                 isReduction));
+      if (llMask)
+        vec = std::min(vec, getMaskAlignment(op.getMask()));
+      if (aggregate)
+        vec = 1;
       // mask
       numElems = tensorTy.getNumElements();
     }
     Value mask = getMask(valueTy, rewriter, loc);
 
+    // Pairs of 16-bit floats are packed in a word, the words of a vector
+    // reduction are passed by a list operand.
+    unsigned packed = (valueElemNBits == 16 && vec >= 2) ? 2 : 1;
+    unsigned nWords = vec / packed;
+    size_t wordNBits = valueElemNBits * packed;
+    std::string tyId =
+        wordNBits == 64 ? "l" : (wordNBits == 32 ? "r" : "h");
     auto vecTy = vec_ty(valueElemTy, vec);
+    auto wordTy = packed == 2 ? vec_ty(valueElemTy, 2) : valueElemTy;
     SmallVector<Value> resultVals(elemsPerThread);
     for (size_t i = 0; i < elemsPerThread; i += vec) {
-      Value rmwVal = undef(vecTy);
-      for (int ii = 0; ii < vec; ++ii) {
-        Value iiVal = createIndexAttrConstant(
-            rewriter, loc, getTypeConverter()->getIndexType(), ii);
-        rmwVal = insert_element(vecTy, rmwVal, valElements[i + ii], iiVal);
+      SmallVector<std::pair<Value, std::string>> rmwWords;
+      for (unsigned w = 0; w < nWords; ++w) {
+        Value word = valElements[i + w * packed];
+        if (packed == 2) {
+          word = undef(wordTy);
+          for (unsigned ii = 0; ii < packed; ++ii)
+            word = insert_element(wordTy, word,
+                                  valElements[i + w * packed + ii],
+                                  i32_val(ii));
+        }
+        rmwWords.emplace_back(word, tyId);
       }
 
       Value rmwPtr = ptrElements[i];
       Value rmwMask = llMask ? and_(mask, maskElements[i]) : mask;
+      if (aggregate)
+        rmwWords[0].first = aggregateInWarp(rewriter, loc, atomicRmwAttr,
+                                            rmwWords[0].first, rmwPtr, rmwMask);
       std::string sTy;
       PTXBuilder ptxBuilderAtomicRMW;
-      std::string tyId = valueElemNBits * vec == 64
-                             ? "l"
-                             : (valueElemNBits * vec == 32 ? "r" : "h");
       auto *dstOpr = ptxBuilderAtomicRMW.newOperand("=" + tyId, /*init=*/true);
       auto *ptrOpr = ptxBuilderAtomicRMW.newAddrOperand(rmwPtr, "l");
-      auto *valOpr = ptxBuilderAtomicRMW.newOperand(rmwVal, tyId);
+      PTXBuilder::Operand *valOpr =
+          nWords > 1
+              ? ptxBuilderAtomicRMW.newListOperand(rmwWords)
+              : ptxBuilderAtomicRMW.newOperand(rmwWords[0].first, tyId);
 
       auto scope = stringifyMemSyncScope(op.getScope()).str();
-      auto &atom = ptxBuilderAtomicRMW.create<>("atom")->global().o(scope);
+      auto &atom = ptxBuilderAtomicRMW.create<>(isReduction ? "red" : "atom")
+                       ->global()
+                       .o(scope);
       auto rmwOp = stringifyRMWOp(atomicRmwAttr).str();
       auto sBits = std::to_string(valueElemNBits);
       switch (atomicRmwAttr) {
@@ -1154,8 +1392,8 @@ struct AtomicRMWOpConversion
       case RMWOp::FADD:
         rmwOp = "add";
         rmwOp += (valueElemNBits == 16 ? ".noftz" : "");
-        sTy = "f" + sBits;
-        sTy += (vec == 2 && valueElemNBits == 16) ? "x2" : "";
+        sTy = isBF16 ? "bf16" : "f" + sBits;
+        sTy += packed == 2 ? "x2" : "";
         break;
       case RMWOp::MAX:
         sTy = "s" + sBits;
@@ -1180,8 +1418,17 @@ struct AtomicRMWOpConversion
       std::string semStr;
       llvm::raw_string_ostream os(semStr);
       os << op.getSem();
-      atom.o(semStr).o(rmwOp).o(sTy);
-      if (tensorTy) {
+      atom.o(semStr).o(rmwOp).v(nWords).o(sTy);
+      if (isReduction) {
+        atom(ptrOpr, valOpr).predicate(rmwMask);
+        ptxBuilderAtomicRMW.launch(rewriter, loc, void_ty(ctx));
+        if (!tensorTy) {
+          rewriter.replaceOp(op, {undef(valueElemTy)});
+          return success();
+        }
+        for (unsigned ii = 0; ii < vec; ++ii)
+          resultVals[i + ii] = undef(valueElemTy);
+      } else if (tensorTy) {
         atom(dstOpr, ptrOpr, valOpr).predicate(rmwMask);
         auto retType = vec == 1 ? valueElemTy : vecTy;
         auto ret = ptxBuilderAtomicRMW.launch(rewriter, loc, retType);
@@ -1190,7 +1437,6 @@ struct AtomicRMWOpConversion
               vec == 1 ? ret : extract_element(valueElemTy, ret, i32_val(ii));
         }
       } else {
-        auto ASMReturnTy = void_ty(ctx);
         atom(dstOpr, ptrOpr, valOpr).predicate(rmwMask);
         auto old = ptxBuilderAtomicRMW.launch(rewriter, loc, valueElemTy);
         if (op->user_begin() == op->user_end()) {
@@ -1631,10 +1877,12 @@ struct InsertSliceTMAOpConversion : public ConvertTritonGPUOpToLLVMPattern<
     uint32_t elemsPerSlice = std::accumulate(
         shapePerCTA.begin(), shapePerCTA.end(), 1, std::multiplies{});
     Value dstOffsetCommon = mul(llIndex, i32_val(elemsPerSlice));
-    // [benzh] sliceCoord should be higher dimension's multiplier accumulate.
-    // currently only support rank == 2.
+    // The slices are along the highest order dimension, each of its rows is a
+    // box of the lower order dimensions
+    uint32_t elemsPerSliceRow = std::accumulate(
+        boxDims.begin(), boxDims.end() - 1, 1, std::multiplies{});
     dstOffsetCommon =
-        add(dstOffsetCommon, mul(sliceCoord, i32_val(boxDims[0])));
+        add(dstOffsetCommon, mul(sliceCoord, i32_val(elemsPerSliceRow)));
     auto dstPtrTy = ptr_ty(rewriter.getContext(), 3);
 
     Value tmaDesc =
@@ -1823,13 +2071,19 @@ void mlir::triton::populateLoadStoreOpToLLVMPatterns(
     ModuleAllocation &allocation,
     ConvertTritonGPUOpToLLVMPatternBase::IndexCacheInfo &indexCacheInfo,
     mlir::triton::gpu::TMAMetadataTy *tmaMetadata,
-    const TensorPtrMapT *tensorPtrMap, PatternBenefit benefit) {
-  patterns.add<LoadOpConversion>(typeConverter, axisInfoAnalysis, benefit);
-  patterns.add<StoreOpConversion>(typeConverter, axisInfoAnalysis, benefit);
+    const TensorPtrMapT *tensorPtrMap, int computeCapability,
+    PatternBenefit benefit) {
+  patterns.add<LoadOpConversion>(typeConverter, axisInfoAnalysis,
+                                 computeCapability, benefit);
+  patterns.add<StoreOpConversion>(typeConverter, axisInfoAnalysis,
+                                  computeCapability, benefit);
+  patterns.add<PrefetchOpConversion>(typeConverter, axisInfoAnalysis,
+                                     computeCapability, benefit);
   patterns.add<AtomicCASOpConversion>(typeConverter, allocation,
                                       axisInfoAnalysis, benefit);
   patterns.add<AtomicRMWOpConversion>(typeConverter, allocation,
-                                      axisInfoAnalysis, benefit);
+                                      axisInfoAnalysis, computeCapability,
+                                      benefit);
   patterns.add<InsertSliceOpConversion>(typeConverter, allocation,
                                         indexCacheInfo, benefit);
   patterns.add<InsertSliceAsyncOpConversion>(
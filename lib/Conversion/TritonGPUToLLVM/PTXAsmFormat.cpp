@@ -2,6 +2,7 @@
 #include "mlir/Dialect/LLVMIR/LLVMDialect.h"
 #include "mlir/Transforms/DialectConversion.h"
 #include "triton/Conversion/TritonGPUToLLVM/AsmFormat.h"
+#include "llvm/Support/StringSaver.h"
 #include "llvm/Support/raw_ostream.h"
 // TODO(Superjomn): unify to llvm::raw_string_ostream
 #include <sstream>
@@ -9,12 +10,20 @@
 namespace mlir {
 namespace triton {
 
+StringRef PTXBuilder::internConstraint(StringRef constraint) {
+  // Per thread, so that the builders of parallel compilations don't contend.
+  thread_local llvm::BumpPtrAllocator allocator;
+  thread_local llvm::UniqueStringSaver saver(allocator);
+  return saver.save(constraint);
+}
+
 PTXInstr::Operand *
 PTXBuilder::newOperand(mlir::Value value, StringRef constraint,
                        std::function<std::string(int)> formatter) {
-  argArchive.emplace_back(std::make_unique<Operand>(value, constraint));
-  auto *opr = argArchive.back().get();
-  opr->repr = formatter;
+  auto *opr = newOperand();
+  opr->value = value;
+  opr->constraint = internConstraint(constraint);
+  opr->repr = std::move(formatter);
   opr->idx = oprCounter++;
   return opr;
 }
@@ -29,7 +38,7 @@ void PTXBuilder::initOperand(Operand *opr) {
   else if (opr->constraint[1] == 'l')
     numBits = 64;
   else
-    llvm_unreachable(("Unknown constraint: " + opr->constraint).c_str());
+    llvm_unreachable(("Unknown constraint: " + opr->constraint).str().c_str());
   // If numBits is less than 16, we use 16 as default because PTX does not
   // support 8-bit mov.
   numBits = numBits < 16 ? 16 : numBits;
@@ -43,7 +52,7 @@ PTXBuilder::Operand *PTXBuilder::newOperand(StringRef constraint, bool init) {
   assert(constraint.size() == 2 && constraint[0] == '=');
   auto *opr = newOperand();
   opr->idx = oprCounter++;
-  opr->constraint = constraint;
+  opr->constraint = internConstraint(constraint);
   if (init) {
     initOperand(opr);
   }
@@ -54,14 +63,14 @@ PTXBuilder::Operand *PTXBuilder::newOperand(unsigned operandIndex) {
   assert(operandIndex < oprCounter && "operand index out of range");
   auto *opr = newOperand();
   opr->idx = oprCounter++;
-  opr->constraint = std::to_string(operandIndex);
+  opr->constraint = internConstraint(std::to_string(operandIndex));
   return opr;
 }
 
 PTXBuilder::Operand *PTXBuilder::newConstantOperand(const std::string &v) {
-  argArchive.emplace_back(std::make_unique<Operand>());
-  argArchive.back()->repr = [v](int idx) { return v; };
-  return argArchive.back().get();
+  auto *opr = newOperand();
+  opr->repr = [v](int idx) { return v; };
+  return opr;
 }
 
 PTXBuilder::Operand *PTXBuilder::newConstantOperand(int64_t v) {
@@ -71,11 +80,12 @@ PTXBuilder::Operand *PTXBuilder::newConstantOperand(int64_t v) {
 }
 
 std::string PTXBuilder::getConstraints() const {
-  auto args = getAllArgs();
-  llvm::SmallVector<std::string, 4> argReprs;
-  for (auto arg : args)
-    argReprs.push_back(arg->constraint);
-  return strJoin(argReprs, ",");
+  std::string constraints;
+  llvm::raw_string_ostream os(constraints);
+  llvm::interleave(
+      getAllArgs(), os, [&](Operand *arg) { os << arg->constraint; }, ",");
+  os.flush();
+  return constraints;
 }
 
 llvm::SmallVector<Value, 4> PTXBuilder::getAllMLIRArgs() const {
@@ -91,7 +101,7 @@ SmallVector<PTXBuilder::Operand *, 4> PTXBuilder::getAllArgs() const {
   llvm::SmallVector<Operand *, 4> res;
   for (auto &x : argArchive)
     if (!x->isList())
-      res.push_back(x.get());
+      res.push_back(x);
   return res;
 }
 
@@ -138,12 +148,13 @@ PTXInstr::Operand *PTXBuilder::newAddrOperand(mlir::Value addr,
 }
 
 std::string PTXBuilder::dump() const {
-  llvm::SmallVector<std::string> lines;
-  for (auto &exec : executions) {
-    lines.push_back(exec->dump());
-  }
-
-  return strJoin(lines, "\n\t");
+  std::string osStr;
+  llvm::raw_string_ostream os(osStr);
+  llvm::interleave(
+      executions, os, [&](PTXInstrExecution *exec) { os << exec->dump(); },
+      "\n\t");
+  os.flush();
+  return osStr;
 }
 
 PTXInstrExecution &PTXInstrCommon::call(ArrayRef<Operand *> oprs,
@@ -157,12 +168,19 @@ PTXInstrExecution &PTXInstrCommon::call(ArrayRef<Operand *> oprs,
     builder->reorderArgArchive(oprs);
   }
 
-  builder->executions.emplace_back(
-      std::make_unique<PTXInstrExecution>(this, oprs, onlyAttachMLIRArgs));
+  builder->executions.push_back(new (builder->executionAllocator.Allocate())
+                                    PTXInstrExecution(this, oprs,
+                                                      onlyAttachMLIRArgs));
 
   return *builder->executions.back();
 }
 
+StringRef PTXInstrCommon::getRepr() const {
+  if (repr.empty())
+    repr = strJoin(instrParts, ".");
+  return repr;
+}
+
 PTXInstrExecution &PTXInstrCommon::operator()(ArrayRef<Operand *> oprs,
                                               bool onlyAttachMLIRArgs) {
   return call(oprs, onlyAttachMLIRArgs);
@@ -172,9 +190,9 @@ std::string PTXInstrExecution::dump() const {
   std::string osStr;
   llvm::raw_string_ostream os(osStr);
 
-  std::string instrRepr = strJoin(instr->instrParts, ".");
+  StringRef instrRepr = instr->getRepr();
   if (onlyAttachMLIRArgs)
-    return instrRepr;
+    return instrRepr.str();
 
   if (pred) {
     if (!pred->repr)
@@ -183,14 +201,10 @@ std::string PTXInstrExecution::dump() const {
       os << pred->repr(pred->idx) << " ";
   }
 
-  llvm::SmallVector<std::string, 4> argReprs;
-  for (auto *arg : argsInOrder) {
-    argReprs.push_back(arg->dump());
-  }
-
-  std::string argsRepr = strJoin(argReprs, ", ");
-
-  os << instrRepr << " " << argsRepr << ";";
+  os << instrRepr << " ";
+  llvm::interleaveComma(argsInOrder, os,
+                        [&](Operand *arg) { os << arg->dump(); });
+  os << ";";
   os.flush();
   return osStr;
 }
@@ -15,6 +15,59 @@ using ::mlir::LLVM::storeShared;
 using ::mlir::triton::gpu::getOrder;
 using ::mlir::triton::gpu::getTotalElemsPerThread;
 
+// Shuffle `values` by `offset` lanes. The values narrower than 32 bits are
+// packed in words so that a shuffle moves several of them, like two f16
+// accumulators.
+static SmallVector<Value> packedShflSync(Location loc,
+                                         ConversionPatternRewriter &rewriter,
+                                         ArrayRef<Value> values, int offset) {
+  SmallVector<Value> results(values.size());
+  SmallVector<unsigned> word;
+  unsigned wordBits = 0;
+  auto shflWord = [&]() {
+    if (word.size() == 1) {
+      results[word[0]] = shflSync(loc, rewriter, values[word[0]], offset);
+    } else if (!word.empty()) {
+      Value packed = i32_val(0);
+      unsigned shift = 0;
+      for (unsigned i : word) {
+        Value bitsVal = values[i];
+        unsigned bits = bitsVal.getType().getIntOrFloatBitWidth();
+        if (!bitsVal.getType().isInteger(bits))
+          bitsVal = bitcast(bitsVal, int_ty(bits));
+        bitsVal = zext(i32_ty, bitsVal);
+        packed = or_(packed, shl(bitsVal, i32_val(shift)));
+        shift += bits;
+      }
+      packed = shflSync(loc, rewriter, packed, offset);
+      shift = 0;
+      for (unsigned i : word) {
+        Type type = values[i].getType();
+        unsigned bits = type.getIntOrFloatBitWidth();
+        Value bitsVal = trunc(int_ty(bits), lshr(packed, i32_val(shift)));
+        results[i] = type.isInteger(bits) ? bitsVal : bitcast(bitsVal, type);
+        shift += bits;
+      }
+    }
+    word.clear();
+    wordBits = 0;
+  };
+  for (unsigned i = 0; i < values.size(); ++i) {
+    Type type = values[i].getType();
+    unsigned bits = type.isIntOrFloat() ? type.getIntOrFloatBitWidth() : 32;
+    if (bits >= 32) {
+      results[i] = shflSync(loc, rewriter, values[i], offset);
+      continue;
+    }
+    if (wordBits + bits > 32)
+      shflWord();
+    word.push_back(i);
+    wordBits += bits;
+  }
+  shflWord();
+  return results;
+}
+
 namespace {
 struct ReduceOpConversion
     : public ConvertTritonGPUReduceScanToLLVMPattern<triton::ReduceOp> {
@@ -44,7 +97,7 @@ public:
     // Then reduce across threads within a warp.
     reduceWithinWarps(helper, accs, rewriter);
 
-    if (helper.isWarpSynchronous()) {
+    if (helper.isWarpSynchronous() && helper.isReduceWithinCTA()) {
       // If all the values to be reduced are within the same warp there is
       // nothing left to do.
       packResults(helper, accs, rewriter);
@@ -214,47 +267,70 @@ private:
   void warpReduce(ConversionPatternRewriter &rewriter, Location loc,
                   SmallVector<Value> &acc, triton::ReduceOp op,
                   unsigned numLaneToReduce, unsigned interleave) const {
+    SmallVector<SmallVector<Value> *> accs = {&acc};
+    warpReduce(rewriter, loc, accs, op, numLaneToReduce, interleave);
+  }
+
+  // Apply the warp reduction to several independent accumulators at once, so
+  // that their narrow values can share the shuffles.
+  void warpReduce(ConversionPatternRewriter &rewriter, Location loc,
+                  ArrayRef<SmallVector<Value> *> accs, triton::ReduceOp op,
+                  unsigned numLaneToReduce, unsigned interleave) const {
     if (auto kind = matchReduxKind(op)) {
       // Based on benchmarking on A100 redux op gives a speed up only when doing
       // a single reduction (not partitioned) and when the mask is static.
       // Therefore we currently only enable it to reduce across all the lanes.
       if (numLaneToReduce == 32) {
-        assert(acc.size() == 1);
-        Value mask = i32_val(0xFFFFFFFF);
-        // Even though we currently don't use redux for partitioned reduction
-        // the code below supports it in case we want to tweak the heuristic.
-        if (numLaneToReduce < 32) {
-          // For partitioned reduction we need to calculate the mask so that
-          // each group of numLaneToReduce threads has the correct mask.
-          unsigned bitmask = (1 << numLaneToReduce) - 1;
-          Value threadId = getThreadId(rewriter, loc);
-          Value laneId = urem(threadId, i32_val(32));
-          mask = shl(i32_val(bitmask),
-                     and_(laneId, i32_val(~(numLaneToReduce - 1))));
-        }
-        for (unsigned i = 0; i < acc.size(); ++i) {
-          unsigned bitwidth = acc[i].getType().cast<IntegerType>().getWidth();
-          if (bitwidth < 32) {
-            if (*kind == NVVM::ReduxKind::MIN || *kind == NVVM::ReduxKind::MAX)
-              acc[i] = sext(i32_ty, acc[i]);
-            else
-              acc[i] = zext(i32_ty, acc[i]);
-          }
-          acc[i] = rewriter.create<NVVM::ReduxOp>(loc, acc[i].getType(), acc[0],
-                                                  *kind, mask);
-          if (bitwidth < 32)
-            acc[i] = trunc(int_ty(bitwidth), acc[i]);
-        }
+        for (SmallVector<Value> *acc : accs)
+          reduxAcc(rewriter, loc, *acc, *kind, numLaneToReduce);
         return;
       }
     }
 
     for (unsigned N = numLaneToReduce / 2; N > 0; N >>= 1) {
-      SmallVector<Value> shfl(acc.size());
-      for (unsigned i = 0; i < acc.size(); ++i) {
-        shfl[i] = shflSync(loc, rewriter, acc[i], N * interleave);
+      SmallVector<Value> values;
+      for (SmallVector<Value> *acc : accs)
+        values.append(acc->begin(), acc->end());
+      SmallVector<Value> shfl =
+          packedShflSync(loc, rewriter, values, N * interleave);
+      ArrayRef<Value> shflRef = shfl;
+      for (SmallVector<Value> *acc : accs) {
+        accumulate(rewriter, op.getCombineOp(), *acc,
+                   shflRef.take_front(acc->size()), false);
+        shflRef = shflRef.drop_front(acc->size());
       }
-      accumulate(rewriter, op.getCombineOp(), acc, shfl, false);
+    }
+  }
+
+  // Reduce `acc` across `numLaneToReduce` lanes with a redux op of `kind`.
+  void reduxAcc(ConversionPatternRewriter &rewriter, Location loc,
+                SmallVector<Value> &acc, NVVM::ReduxKind kind,
+                unsigned numLaneToReduce) const {
+    assert(acc.size() == 1);
+    Value mask = i32_val(0xFFFFFFFF);
+    // Even though we currently don't use redux for partitioned reduction
+    // the code below supports it in case we want to tweak the heuristic.
+    if (numLaneToReduce < 32) {
+      // For partitioned reduction we need to calculate the mask so that
+      // each group of numLaneToReduce threads has the correct mask.
+      unsigned bitmask = (1 << numLaneToReduce) - 1;
+      Value threadId = getThreadId(rewriter, loc);
+      Value laneId = urem(threadId, i32_val(32));
+      mask = shl(i32_val(bitmask),
+                 and_(laneId, i32_val(~(numLaneToReduce - 1))));
+    }
+    for (unsigned i = 0; i < acc.size(); ++i) {
+      unsigned bitwidth = acc[i].getType().cast<IntegerType>().getWidth();
+      if (bitwidth < 32) {
+        if (kind == NVVM::ReduxKind::MIN || kind == NVVM::ReduxKind::MAX)
+          acc[i] = sext(i32_ty, acc[i]);
+        else
+          acc[i] = zext(i32_ty, acc[i]);
+      }
+      acc[i] = rewriter.create<NVVM::ReduxOp>(loc, acc[i].getType(), acc[0],
+                                              kind, mask);
+      if (bitwidth < 32)
+        acc[i] = trunc(int_ty(bitwidth), acc[i]);
     }
   }
 
@@ -267,12 +343,11 @@ private:
     unsigned sizeIntraWarps = helper.getIntraWarpSizeWithUniqueData();
     unsigned threadOffsetOnReductionAxis =
         helper.getThreadOffsetOnReductionAxis();
-    for (auto it : accs) {
-      const SmallVector<unsigned> &key = it.first;
-      SmallVector<Value> &acc = accs[key];
-      warpReduce(rewriter, op.getLoc(), acc, op, sizeIntraWarps,
-                 threadOffsetOnReductionAxis);
-    }
+    SmallVector<SmallVector<Value> *> accList;
+    for (auto &it : accs)
+      accList.push_back(&it.second);
+    warpReduce(rewriter, op.getLoc(), accList, op, sizeIntraWarps,
+               threadOffsetOnReductionAxis);
   }
 
   // Pack the accumulator values and replace the reduce op with the result.
@@ -435,45 +510,108 @@ private:
     }
   }
 
+  // Returns the ids of the CTAs of the cluster holding the parts of the
+  // reduction axis of the current CTA, in order.
+  SmallVector<Value>
+  getCTAIdsOnReductionAxis(ReduceOpHelper &helper,
+                           ConversionPatternRewriter &rewriter) const {
+    triton::ReduceOp op = helper.getOperation();
+    Location loc = op.getLoc();
+    auto srcLayout = helper.getSrcLayout();
+    auto CTAsPerCGA = triton::gpu::getCTAsPerCGA(srcLayout);
+    auto CTAOrder = triton::gpu::getCTAOrder(srcLayout);
+    Value clusterCTAId = getClusterCTAId(rewriter, loc);
+    SmallVector<Value> multiDimCTAId =
+        delinearize(rewriter, loc, clusterCTAId, CTAsPerCGA, CTAOrder);
+    SmallVector<Value> ctaIds;
+    for (unsigned k = 0; k < helper.getCTASplitNumOnReductionAxis(); ++k) {
+      multiDimCTAId[op.getAxis()] = i32_val(k);
+      ctaIds.push_back(
+          linearize(rewriter, loc, multiDimCTAId, CTAsPerCGA, CTAOrder));
+    }
+    return ctaIds;
+  }
+
+  void clusterSync(ConversionPatternRewriter &rewriter, Location loc) const {
+    rewriter.create<triton::nvidia_gpu::ClusterArriveOp>(loc, false);
+    rewriter.create<triton::nvidia_gpu::ClusterWaitOp>(loc);
+  }
+
   // Load the final reduction from shared memory and replace the reduce result
-  // with it.
+  // with it. When the reduction axis is split between the CTAs of the cluster,
+  // each CTA combines the partial reductions of all of them from distributed
+  // shared memory, in the same order so that they get the same results.
   void loadReductionAndPackResult(ReduceOpHelper &helper,
                                   SmallVector<unsigned> smemShape,
                                   SmallVector<Value> &smemBases,
                                   ConversionPatternRewriter &rewriter) const {
     triton::ReduceOp op = helper.getOperation();
     Location loc = op.getLoc();
-    auto srcLayout = helper.getSrcLayout();
-    auto axis = op.getAxis();
     auto smemOrder = helper.getOrderWithAxisAtBeginning();
-    SmallVector<Value> results(op.getNumOperands());
-    for (unsigned i = 0; i < op.getNumOperands(); ++i) {
-      auto elemTy = getElementType(op, i);
-      if (auto resultTy =
-              op.getResult()[i].getType().dyn_cast<RankedTensorType>()) {
-        // nd-tensor where n >= 1
-        auto resultLayout = resultTy.getEncoding().cast<SliceEncodingAttr>();
-        unsigned resultElems = getTotalElemsPerThread(resultTy);
-        auto resultIndices = emitIndices(loc, rewriter, resultLayout, resultTy);
-        assert(resultIndices.size() == resultElems);
-
-        SmallVector<Value> resultVals(resultElems);
-        for (size_t j = 0; j < resultElems; ++j) {
-          SmallVector<Value> readIdx = resultIndices[j];
-          readIdx.insert(readIdx.begin() + op.getAxis(), i32_val(0));
-          Value readOffset =
-              linearize(rewriter, loc, readIdx, smemShape, smemOrder);
-          Value readPtr = gep(ptr_ty(rewriter.getContext(), 3), elemTy,
-                              smemBases[i], readOffset);
-          resultVals[j] = load(elemTy, readPtr);
-        }
+    unsigned numOperands = op.getNumOperands();
 
-        results[i] = getTypeConverter()->packLLElements(loc, resultVals,
-                                                        rewriter, resultTy);
-      } else {
-        // 0d-tensor -> scalar
-        results[i] = load(elemTy, smemBases[i]);
+    SmallVector<Value> ctaIds;
+    if (!helper.isReduceWithinCTA()) {
+      // Wait for the partial reductions of the other CTAs
+      clusterSync(rewriter, loc);
+      ctaIds = getCTAIdsOnReductionAxis(helper, rewriter);
+    }
+    auto loadReduction = [&](Value readOffset) {
+      SmallVector<Value> acc(numOperands);
+      SmallVector<Value> readPtrs(numOperands);
+      for (unsigned i = 0; i < numOperands; ++i)
+        readPtrs[i] = gep(ptr_ty(rewriter.getContext(), 3),
+                          getElementType(op, i), smemBases[i], readOffset);
+      if (ctaIds.empty()) {
+        for (unsigned i = 0; i < numOperands; ++i)
+          acc[i] = load(getElementType(op, i), readPtrs[i]);
+        return acc;
+      }
+      for (auto [k, ctaId] : llvm::enumerate(ctaIds)) {
+        SmallVector<Value> cur(numOperands);
+        for (unsigned i = 0; i < numOperands; ++i)
+          cur[i] = load_dsmem(readPtrs[i], ctaId, getElementType(op, i));
+        accumulate(rewriter, op.getCombineOp(), acc, cur, k == 0);
       }
+      return acc;
+    };
+
+    SmallVector<SmallVector<Value>> resultVals(numOperands);
+    if (auto resultTy =
+            op.getResult()[0].getType().dyn_cast<RankedTensorType>()) {
+      // nd-tensor where n >= 1
+      auto resultLayout = resultTy.getEncoding().cast<SliceEncodingAttr>();
+      unsigned resultElems = getTotalElemsPerThread(resultTy);
+      auto resultIndices = emitIndices(loc, rewriter, resultLayout, resultTy);
+      assert(resultIndices.size() == resultElems);
+
+      for (size_t j = 0; j < resultElems; ++j) {
+        SmallVector<Value> readIdx = resultIndices[j];
+        readIdx.insert(readIdx.begin() + op.getAxis(), i32_val(0));
+        Value readOffset =
+            linearize(rewriter, loc, readIdx, smemShape, smemOrder);
+        SmallVector<Value> vals = loadReduction(readOffset);
+        for (unsigned i = 0; i < numOperands; ++i)
+          resultVals[i].push_back(vals[i]);
+      }
+    } else {
+      // 0d-tensor -> scalar
+      SmallVector<Value> vals = loadReduction(i32_val(0));
+      for (unsigned i = 0; i < numOperands; ++i)
+        resultVals[i].push_back(vals[i]);
+    }
+    // The other CTAs may still read the shared memory of this one
+    if (!ctaIds.empty())
+      clusterSync(rewriter, loc);
+
+    SmallVector<Value> results(numOperands);
+    for (unsigned i = 0; i < numOperands; ++i) {
+      if (auto resultTy =
+              op.getResult()[i].getType().dyn_cast<RankedTensorType>())
+        results[i] = getTypeConverter()->packLLElements(loc, resultVals[i],
+                                                        rewriter, resultTy);
+      else
+        results[i] = resultVals[i][0];
     }
     rewriter.replaceOp(op, results);
   }
@@ -100,18 +100,38 @@ static void warpScan(SmallVector<SmallVector<Value>> &srcValues,
   }
 }
 
+// Return the index of the accumulator of `chunkId` among the chunks of its
+// block along the axis, and that block in `axisBlockId`.
+static unsigned getChunkAccumulatorIndex(ScanLoweringHelper &helper,
+                                         unsigned chunkId,
+                                         unsigned &axisBlockId) {
+  unsigned parallelElementsPerThread = helper.getNonAxisNumElementsPerThread();
+  unsigned numScanBlocks = helper.getAxisNumBlocks();
+  unsigned blockStride = helper.getAxisBlockStride();
+  unsigned blockId = chunkId / parallelElementsPerThread;
+  unsigned parallelBlockId =
+      blockId % blockStride +
+      ((blockId / blockStride) / numScanBlocks) * blockStride;
+  axisBlockId = (blockId / blockStride) % numScanBlocks;
+  return chunkId % parallelElementsPerThread +
+         parallelBlockId * parallelElementsPerThread;
+}
+
 // For each set of contiguous elements within a thread we store the partial
 // reduction into shared memory. Each parallel scan and each warp will store its
 // own partial reductions. The shared memory is organized as follow:
 //          -----------------------------------------------------------------
 // chunk 0: | acc[0] warp 0 | acc[1] warp 0 | acc[0] warp 1 | acc[1] warp 1 |
 // chunk 1: | acc[0] warp 0 | acc[1] warp 0 | acc[0] warp 1 | acc[1] warp 1 |
+// If `axisBlock` is set, only the chunks of that block along the axis are
+// stored, indexed by their accumulator.
 static void storeWarpAccumulator(SmallVector<SmallVector<Value>> &srcValues,
                                  ConversionPatternRewriter &rewriter,
                                  ScanLoweringHelper &helper, Value laneId,
                                  Value warpId, SmallVector<Value> smemBases,
                                  SmallVector<Type> smemTypes,
-                                 Value parallelLaneId) {
+                                 Value parallelLaneId,
+                                 std::optional<unsigned> axisBlock) {
   Location loc = helper.getLoc();
   unsigned scanElementsPerThreads = helper.getAxisNumElementsPerThread();
   unsigned scanDim = helper.getAxisNumThreadsPerWarpWithUniqueData();
@@ -124,10 +144,18 @@ static void storeWarpAccumulator(SmallVector<SmallVector<Value>> &srcValues,
     // Only consider the last element of each contiguous chunk of elements.
     if (elementIdx != scanElementsPerThreads - 1)
       continue;
+    unsigned axisBlockId;
+    unsigned slot = getChunkAccumulatorIndex(helper, chunkId, axisBlockId);
+    if (axisBlock && axisBlockId != *axisBlock) {
+      chunkId++;
+      continue;
+    }
+    if (!axisBlock)
+      slot = chunkId;
     auto lastElement = srcValues[srcIndex];
     Value mask = icmp_eq(laneId, i32_val(scanDim - 1));
     Value index = add(parallelLaneId, mul(warpId, i32_val(numParallelLane)));
-    index = add(index, i32_val(chunkId * numParallelLane * axisNumWarps));
+    index = add(index, i32_val(slot * numParallelLane * axisNumWarps));
 
     for (unsigned i = 0; i < lastElement.size(); ++i) {
       Value writePtr = gep(ptr_ty(rewriter.getContext(), 3), smemTypes[i],
@@ -138,17 +166,30 @@ static void storeWarpAccumulator(SmallVector<SmallVector<Value>> &srcValues,
   }
 }
 
+namespace {
+// The running prefix of a parallel scan across the blocks along the axis.
+struct ScanAccumulator {
+  SmallVector<Value> acc;
+  SmallVector<Value> maskedAcc;
+};
+} // namespace
+
 // Read the partial reductions from shared memory from each chunk of contiguous
 // elements for each warp and parallel scan. Then combine the partial reduction
 // with the right elements. Within a given contiguous element chunk we update
 // all the elements by accumulating the value from the last element of the
 // reduced value from the previous lane.
+// If `axisBlock` is set, only the chunks of that block along the axis are
+// read, as stored by storeWarpAccumulator, and `accumulators` carries the
+// prefix of the previous blocks.
 static void AddPartialReduce(SmallVector<SmallVector<Value>> &srcValues,
                              ConversionPatternRewriter &rewriter,
                              ScanLoweringHelper &helper,
                              SmallVector<Value> smemBases,
                              SmallVector<Type> smemTypes, Value warpId,
-                             Value laneIdAxis, Value parallelLaneId) {
+                             Value laneIdAxis, Value parallelLaneId,
+                             SmallVector<ScanAccumulator> &accumulators,
+                             std::optional<unsigned> axisBlock) {
   Location loc = helper.getLoc();
   unsigned numParallelLane = helper.getNonAxisNumThreadsPerCTA();
   unsigned scanElementsPerThreads = helper.getAxisNumElementsPerThread();
@@ -159,19 +200,13 @@ static void AddPartialReduce(SmallVector<SmallVector<Value>> &srcValues,
   Value maskFirstWarp = icmp_eq(warpId, i32_val(0));
   Value maskFirstLane = icmp_eq(laneIdAxis, i32_val(0));
   Value maskFirstThread = and_(maskFirstWarp, maskFirstLane);
-  struct Accumulator {
-    SmallVector<Value> acc;
-    SmallVector<Value> maskedAcc;
-  };
   unsigned numScanBlocks = helper.getAxisNumBlocks();
   unsigned numParallelBlocks = helper.getNonAxisNumBlocks();
   assert(numScanBlocks * numParallelBlocks * parallelElementsPerThread *
              scanElementsPerThreads ==
          srcValues.size());
-  SmallVector<Accumulator> accumulators(numParallelBlocks *
-                                        parallelElementsPerThread);
+  assert(accumulators.size() == numParallelBlocks * parallelElementsPerThread);
   unsigned chunkId = 0;
-  unsigned blockStride = helper.getAxisBlockStride();
   for (unsigned srcIndex = 0; srcIndex < srcValues.size(); srcIndex++) {
     unsigned elementIdx = (srcIndex / elementStride) % scanElementsPerThreads;
     // Only consider the last element of each contiguous chunk of elements.
@@ -180,17 +215,18 @@ static void AddPartialReduce(SmallVector<SmallVector<Value>> &srcValues,
     // Accumulate the partial reduction from shared memory. Decide which
     // accumulator to combine based on whether the elements belong to the same
     // dimension along axis.
-    unsigned blockId = chunkId / parallelElementsPerThread;
-    unsigned parallelBlockId =
-        blockId % blockStride +
-        ((blockId / blockStride) / numScanBlocks) * blockStride;
-    unsigned accumulatorIndex = chunkId % parallelElementsPerThread +
-                                parallelBlockId * parallelElementsPerThread;
-    Accumulator &accumulator = accumulators[accumulatorIndex];
-    unsigned axisBlockId = (blockId / blockStride) % numScanBlocks;
+    unsigned axisBlockId;
+    unsigned accumulatorIndex =
+        getChunkAccumulatorIndex(helper, chunkId, axisBlockId);
+    if (axisBlock && axisBlockId != *axisBlock) {
+      chunkId++;
+      continue;
+    }
+    unsigned slot = axisBlock ? accumulatorIndex : chunkId;
+    ScanAccumulator &accumulator = accumulators[accumulatorIndex];
     for (unsigned i = 0; i < axisNumWarps; ++i) {
       Value index = add(parallelLaneId, i32_val(numParallelLane *
-                                                (i + chunkId * axisNumWarps)));
+                                                (i + slot * axisNumWarps)));
       SmallVector<Value> partialReduce(helper.getNumOperands());
       for (unsigned j = 0; j < helper.getNumOperands(); ++j) {
         auto elemTy = smemTypes[j];
@@ -274,20 +310,15 @@ static void AddPartialReduceOneWarp(SmallVector<SmallVector<Value>> &srcValues,
   SmallVector<SmallVector<Value>> accumulators(numParallelBlocks *
                                                parallelElementsPerThread);
   unsigned chunkId = 0;
-  unsigned blockStride = helper.getAxisBlockStride();
   for (unsigned srcIndex = 0; srcIndex < srcValues.size(); srcIndex++) {
     unsigned elementIdx = (srcIndex / elementStride) % scanElementsPerThreads;
     // Only consider the last element of each contiguous chunk of elements.
     if (elementIdx != scanElementsPerThreads - 1)
       continue;
-    unsigned blockId = chunkId / parallelElementsPerThread;
-    unsigned parallelBlockId =
-        blockId % blockStride +
-        ((blockId / blockStride) / numScanBlocks) * blockStride;
-    unsigned accumulatorIndex = chunkId % parallelElementsPerThread +
-                                parallelBlockId * parallelElementsPerThread;
+    unsigned axisBlockId;
+    unsigned accumulatorIndex =
+        getChunkAccumulatorIndex(helper, chunkId, axisBlockId);
     auto &accumulator = accumulators[accumulatorIndex];
-    unsigned axisBlockId = (blockId / blockStride) % numScanBlocks;
     if (axisBlockId == 0) // First chunk and first block
       accumulator = srcValues[srcIndex];
     else
@@ -478,15 +509,31 @@ ScanOpConversion::emitFastScan(triton::ScanOp op, triton::ScanOpAdaptor adaptor,
       smemTypes[i] = getElementType(op, i);
     }
 
-    // Store the partial reducing for each warp into shared memory.
-    storeWarpAccumulator(srcValues, rewriter, helper, laneIdAxis, warpIdAxis,
-                         smemBases, smemTypes, flatIdParallel);
-    barrier();
-    // Read back the partial reduction of each warp and accumulate them based on
-    // warpId. Then update each chunk of contiguous elements by adding the
-    // accumulated value from the previous lane.
-    AddPartialReduce(srcValues, rewriter, helper, smemBases, smemTypes,
-                     warpIdAxis, laneIdAxis, flatIdParallel);
+    SmallVector<ScanAccumulator> accumulators(
+        helper.getNonAxisNumBlocks() * helper.getNonAxisNumElementsPerThread());
+    // A long axis is scanned one block at a time, reusing the shared memory
+    // and carrying the prefix of the previous blocks in the accumulators.
+    SmallVector<std::optional<unsigned>> axisBlocks = {std::nullopt};
+    if (helper.isChunked()) {
+      axisBlocks.clear();
+      for (unsigned i = 0; i < helper.getAxisNumBlocks(); ++i)
+        axisBlocks.push_back(i);
+    }
+    for (std::optional<unsigned> axisBlock : axisBlocks) {
+      // The previous block must have been read back.
+      if (axisBlock.value_or(0) > 0)
+        barrier();
+      // Store the partial reducing for each warp into shared memory.
+      storeWarpAccumulator(srcValues, rewriter, helper, laneIdAxis, warpIdAxis,
+                           smemBases, smemTypes, flatIdParallel, axisBlock);
+      barrier();
+      // Read back the partial reduction of each warp and accumulate them based
+      // on warpId. Then update each chunk of contiguous elements by adding the
+      // accumulated value from the previous lane.
+      AddPartialReduce(srcValues, rewriter, helper, smemBases, smemTypes,
+                       warpIdAxis, laneIdAxis, flatIdParallel, accumulators,
+                       axisBlock);
+    }
   } else if (srcValues.size() > 1) {
     // Fast path for the case where there is only one warp with unique data on
     // the axis.
@@ -0,0 +1,131 @@
+#include "PatternTritonGPUOpToLLVM.h"
+#include "TritonGPUToLLVMBase.h"
+#include "triton/Analysis/Utility.h"
+
+#include <map>
+
+using namespace mlir;
+using namespace mlir::triton;
+
+using ::mlir::LLVM::linearize;
+using ::mlir::LLVM::shflSync;
+
+namespace {
+// Lowering of sorts to bitonic networks. Each step of the network compares
+// the elements `distance` apart along the axis and keeps the smaller or the
+// larger one depending on their position, so that the sequences of the next
+// size are bitonic. The exchanges stay in the registers of a thread as long
+// as they can, then go through warp shuffles, and only use shared memory
+// across warps.
+struct SortOpConversion
+    : public ConvertTritonGPUOpToLLVMPattern<triton::SortOp> {
+public:
+  using ConvertTritonGPUOpToLLVMPattern<
+      triton::SortOp>::ConvertTritonGPUOpToLLVMPattern;
+
+  LogicalResult
+  matchAndRewrite(triton::SortOp op, OpAdaptor adaptor,
+                  ConversionPatternRewriter &rewriter) const override {
+    SortLoweringHelper helper(op);
+    if (!helper.isSupported())
+      return failure();
+    Location loc = op.getLoc();
+    auto srcTy = op.getSrc().getType().cast<RankedTensorType>();
+    unsigned axis = helper.getAxis();
+    SmallVector<Value> values =
+        getTypeConverter()->unpackLLElements(loc, adaptor.getSrc(), rewriter);
+    auto indices = emitIndices(loc, rewriter, srcTy.getEncoding(), srcTy,
+                               /*withCTAOffset=*/false);
+    // The register of each offset from the first element of the thread
+    auto offsets = emitOffsetForLayout(srcTy.getEncoding(), srcTy);
+    std::map<SmallVector<unsigned>, unsigned> regIds;
+    for (unsigned i = 0; i < offsets.size(); ++i)
+      regIds[offsets[i]] = i;
+
+    bool isFloat = srcTy.getElementType().isa<FloatType>();
+    unsigned size = helper.getAxisSize();
+    for (unsigned k = 2; k <= size; k *= 2) {
+      for (unsigned distance = k / 2; distance > 0; distance /= 2) {
+        SmallVector<Value> partners(values.size());
+        if (helper.isAcrossLanes(distance)) {
+          unsigned laneMask = distance / helper.getAxisSizePerThread() *
+                              helper.getAxisLaneStride();
+          for (unsigned i = 0; i < values.size(); ++i)
+            partners[i] = shflSync(loc, rewriter, values[i], laneMask);
+        } else if (helper.isAcrossWarps(distance)) {
+          partners = exchangeAcrossWarps(op, values, indices, distance,
+                                         rewriter);
+        } else {
+          for (unsigned i = 0; i < values.size(); ++i) {
+            SmallVector<unsigned> offset = offsets[i];
+            offset[axis] ^= distance;
+            assert(regIds.count(offset) && "partner not held by the thread");
+            partners[i] = values[regIds[offset]];
+          }
+        }
+        // The lower element of a pair keeps the smaller one if its sequence
+        // of size k is ascending
+        for (unsigned i = 0; i < values.size(); ++i) {
+          Value coord = indices[i][axis];
+          Value isLower = icmp_eq(and_(coord, i32_val(distance)), i32_val(0));
+          Value ascending = icmp_eq(and_(coord, i32_val(k)), i32_val(0));
+          Value keepMin = op.getDescending() ? icmp_ne(isLower, ascending)
+                                             : icmp_eq(isLower, ascending);
+          Value isLess = isFloat ? Value(fcmp_olt(values[i], partners[i]))
+                                 : Value(icmp_slt(values[i], partners[i]));
+          values[i] =
+              select(icmp_eq(isLess, keepMin), values[i], partners[i]);
+        }
+      }
+    }
+
+    Value result =
+        getTypeConverter()->packLLElements(loc, values, rewriter, srcTy);
+    rewriter.replaceOp(op, result);
+    return success();
+  }
+
+private:
+  // Returns the elements `distance` apart along the axis from `values`,
+  // stored to and read back from shared memory.
+  SmallVector<Value>
+  exchangeAcrossWarps(triton::SortOp op, ArrayRef<Value> values,
+                      ArrayRef<SmallVector<Value>> indices, unsigned distance,
+                      ConversionPatternRewriter &rewriter) const {
+    Location loc = op.getLoc();
+    auto srcTy = op.getSrc().getType().cast<RankedTensorType>();
+    unsigned axis = op.getAxis();
+    Value smemBase = getSharedMemoryBase(loc, rewriter, op.getOperation());
+    Type elemTy = getTypeConverter()->convertType(srcTy.getElementType());
+    Type ptrTy = ptr_ty(rewriter.getContext(), 3);
+    auto shapePerCTA = triton::gpu::getShapePerCTA(srcTy);
+    SmallVector<unsigned> shape(shapePerCTA.begin(), shapePerCTA.end());
+    auto order = triton::gpu::getOrder(srcTy.getEncoding());
+    for (unsigned i = 0; i < values.size(); ++i) {
+      Value offset = linearize(rewriter, loc, indices[i], shape, order);
+      store(values[i], gep(ptrTy, elemTy, smemBase, offset));
+    }
+    barrier();
+    SmallVector<Value> partners(values.size());
+    for (unsigned i = 0; i < values.size(); ++i) {
+      SmallVector<Value> index = indices[i];
+      index[axis] = xor_(index[axis], i32_val(distance));
+      Value offset = linearize(rewriter, loc, index, shape, order);
+      partners[i] = load(elemTy, gep(ptrTy, elemTy, smemBase, offset));
+    }
+    // The next exchange overwrites the shared memory
+    barrier();
+    return partners;
+  }
+};
+} // namespace
+
+void mlir::triton::populateSortOpToLLVMPatterns(
+    TritonGPUToLLVMTypeConverter &typeConverter, RewritePatternSet &patterns,
+    int numWarps, ModuleAxisInfoAnalysis &axisInfoAnalysis,
+    ModuleAllocation &allocation,
+    ConvertTritonGPUOpToLLVMPatternBase::IndexCacheInfo &indexCacheInfo,
+    PatternBenefit benefit) {
+  patterns.add<SortOpConversion>(typeConverter, allocation, indexCacheInfo,
+                                 benefit);
+}
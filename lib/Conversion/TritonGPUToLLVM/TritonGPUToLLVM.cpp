@@ -1,6 +1,7 @@
 #include "PatternTritonGPUOpToLLVM.h"
 #include "Utility.h"
 #include "mlir/Dialect/ControlFlow/IR/ControlFlowOps.h"
+#include <limits>
 
 namespace {
 
@@ -29,6 +30,16 @@ Value llGetPid(int axis, Location loc, ModuleOp moduleOp,
   return getSRegValue(rewriter, loc, sreg);
 }
 
+// The index of the CTA in the grid, with x the fastest varying dimension
+Value getLinearCTAId(ConversionPatternRewriter &rewriter, Location loc) {
+  Value x = getSRegValue(rewriter, loc, "%ctaid.x");
+  Value y = getSRegValue(rewriter, loc, "%ctaid.y");
+  Value z = getSRegValue(rewriter, loc, "%ctaid.z");
+  Value nx = getSRegValue(rewriter, loc, "%nctaid.x");
+  Value ny = getSRegValue(rewriter, loc, "%nctaid.y");
+  return add(x, mul(nx, add(y, mul(ny, z))));
+}
+
 struct ReturnOpConversion : public ConvertOpToLLVMPattern<triton::ReturnOp> {
   using ConvertOpToLLVMPattern<triton::ReturnOp>::ConvertOpToLLVMPattern;
 
@@ -125,14 +136,19 @@ struct PrintOpConversion
   matchAndRewrite(triton::PrintOp op, OpAdaptor adaptor,
                   ConversionPatternRewriter &rewriter) const override {
     auto loc = op->getLoc();
-    Value prefixStr =
-        LLVM::addStringToModule(loc, rewriter, "printfPrefix_", op.getPrefix());
-
-    auto getPid = [&](int axis) {
-      return llGetPid(axis, loc, op->getParentOfType<ModuleOp>(), rewriter);
-    };
+    auto mod = op->getParentOfType<ModuleOp>();
+    auto getPid = [&](int axis) { return llGetPid(axis, loc, mod, rewriter); };
     std::array<Value, 3> pid = {getPid(0), getPid(1), getPid(2)};
 
+    if (auto format =
+            op->getAttrOfType<IntegerAttr>("triton_gpu.print-format")) {
+      writeRecords(op, adaptor, format.getInt(), pid, rewriter);
+      rewriter.eraseOp(op);
+      return success();
+    }
+
+    Value prefixStr =
+        LLVM::addStringToModule(loc, rewriter, "printfPrefix_", op.getPrefix());
     // Simple printf of a string without any tensors.
     if (op.getNumOperands() == 0) {
       std::string formatStr;
@@ -182,6 +198,98 @@ struct PrintOpConversion
     return success();
   }
 
+  // Writes a record per element of each operand of `op` to the print buffer,
+  // with the format `format` plus the operand: the format, the program id,
+  // the index of the element and its value over two words. The records of
+  // each thread are reserved at once, the oldest records are overwritten when
+  // the buffer is full.
+  void writeRecords(triton::PrintOp op, OpAdaptor adaptor, int64_t format,
+                    std::array<Value, 3> pid,
+                    ConversionPatternRewriter &rewriter) const {
+    Location loc = op.getLoc();
+    MLIRContext *ctx = rewriter.getContext();
+    auto mod = op->getParentOfType<ModuleOp>();
+    int64_t numRecords =
+        mod->getAttrOfType<IntegerAttr>("triton_gpu.print-buffer").getInt();
+    int64_t recordWords =
+        mod->getAttrOfType<IntegerAttr>("triton_gpu.print-record-words")
+            .getInt();
+    auto global = mod.lookupSymbol<LLVM::GlobalOp>("triton_print_buffer");
+    if (!global) {
+      // The number of records written so far, as an u64, then the records
+      OpBuilder::InsertionGuard guard(rewriter);
+      rewriter.setInsertionPointToStart(mod.getBody());
+      int64_t size = 2 + numRecords * recordWords;
+      global = rewriter.create<LLVM::GlobalOp>(
+          UnknownLoc::get(ctx), LLVM::LLVMArrayType::get(i32_ty, size),
+          /*isConstant=*/false, LLVM::Linkage::External,
+          "triton_print_buffer",
+          rewriter.getZeroAttr(RankedTensorType::get({size}, i32_ty)),
+          /*alignment=*/8, /*addrSpace=*/1);
+    }
+    Value base = rewriter.create<LLVM::AddressOfOp>(loc, global);
+    Value data = gep(ptr_ty(ctx, 1), i32_ty, base, i32_val(2));
+
+    auto write = [&](ArrayRef<SmallVector<Value>> records) {
+      if (records.empty())
+        return;
+      Value first = rewriter.create<LLVM::AtomicRMWOp>(
+          loc, LLVM::AtomicBinOp::add, base, int_val(64, records.size()),
+          LLVM::AtomicOrdering::monotonic);
+      for (unsigned i = 0; i < records.size(); ++i) {
+        Value slot = trunc(i32_ty, and_(add(first, int_val(64, i)),
+                                        int_val(64, numRecords - 1)));
+        Value record =
+            gep(ptr_ty(ctx, 1), i32_ty, data, mul(slot, i32_val(recordWords)));
+        for (unsigned j = 0; j < records[i].size(); ++j)
+          store(records[i][j], gep(ptr_ty(ctx, 1), i32_ty, record, i32_val(j)));
+      }
+    };
+    SmallVector<Value> header = {i32_val(format), pid[0], pid[1], pid[2]};
+    if (op.getNumOperands() == 0) {
+      write({header});
+      return;
+    }
+    for (unsigned i = 0; i < op.getNumOperands(); ++i) {
+      auto elems = getTypeConverter()->unpackLLElements(
+          loc, adaptor.getOperands()[i], rewriter);
+      SmallVector<SmallVector<Value>> indices;
+      if (auto rankedTy =
+              op.getOperand(i).getType().dyn_cast<RankedTensorType>())
+        indices = emitIndices(loc, rewriter, rankedTy.getEncoding(), rankedTy);
+      else
+        indices.push_back({});
+      SmallVector<SmallVector<Value>> records;
+      for (unsigned j = 0; j < elems.size(); ++j) {
+        SmallVector<Value> words = header;
+        words[0] = i32_val(format + i);
+        words.append(indices[j].begin(), indices[j].end());
+        auto [low, high] = getValueWords(elems[j], rewriter);
+        words.push_back(low);
+        words.push_back(high);
+        records.push_back(words);
+      }
+      write(records);
+    }
+  }
+
+  // Returns the low and high 32 bits of `value`.
+  static std::pair<Value, Value>
+  getValueWords(Value value, ConversionPatternRewriter &rewriter) {
+    Location loc = value.getLoc();
+    Type type = value.getType();
+    if (type.isa<LLVM::LLVMPointerType>())
+      value = ptrtoint(i64_ty, value);
+    else if (type.isa<FloatType>())
+      value = bitcast(value, int_ty(type.getIntOrFloatBitWidth()));
+    unsigned width = value.getType().getIntOrFloatBitWidth();
+    if (width < 32)
+      return {zext(i32_ty, value), i32_val(0)};
+    if (width == 32)
+      return {value, i32_val(0)};
+    return {trunc(i32_ty, value), trunc(i32_ty, lshr(value, int_val(64, 32)))};
+  }
+
   void printTensor(Value prefixStr, size_t operand, size_t numOperands,
                    ArrayRef<Value> elems, std::array<Value, 3> pid,
                    ArrayRef<SmallVector<Value>> indices,
@@ -623,6 +731,201 @@ struct GetClusterCTAIdOpConversion
   }
 };
 
+struct ProfileCounterOpConversion
+    : public ConvertTritonGPUOpToLLVMPattern<triton::gpu::ProfileCounterOp> {
+  using ConvertTritonGPUOpToLLVMPattern<
+      triton::gpu::ProfileCounterOp>::ConvertTritonGPUOpToLLVMPattern;
+
+  LogicalResult
+  matchAndRewrite(triton::gpu::ProfileCounterOp op, OpAdaptor adaptor,
+                  ConversionPatternRewriter &rewriter) const override {
+    Location loc = op.getLoc();
+    MLIRContext *ctx = rewriter.getContext();
+    auto mod = op->getParentOfType<ModuleOp>();
+    auto numCounters =
+        mod->getAttrOfType<IntegerAttr>("triton_gpu.num-branch-counters");
+    if (!numCounters)
+      return failure();
+    auto global = mod.lookupSymbol<LLVM::GlobalOp>("triton_branch_counters");
+    if (!global) {
+      // Externally visible, so that the runtime can look it up in the
+      // loaded module
+      OpBuilder::InsertionGuard guard(rewriter);
+      rewriter.setInsertionPointToStart(mod.getBody());
+      int64_t size = numCounters.getInt();
+      global = rewriter.create<LLVM::GlobalOp>(
+          UnknownLoc::get(ctx), LLVM::LLVMArrayType::get(i64_ty, size),
+          /*isConstant=*/false, LLVM::Linkage::External,
+          "triton_branch_counters",
+          rewriter.getZeroAttr(RankedTensorType::get({size}, i64_ty)),
+          /*alignment=*/8, /*addrSpace=*/1);
+    }
+    Value base = rewriter.create<LLVM::AddressOfOp>(loc, global);
+    Value counter =
+        gep(ptr_ty(ctx, 1), i64_ty, base, i32_val(op.getIndex()));
+    // Counted once per program
+    Value pred = icmp_eq(getThreadId(rewriter, loc), i32_val(0));
+    PTXBuilder ptxBuilder;
+    auto &red = *ptxBuilder.create<>("red.global.add.u64");
+    red(ptxBuilder.newAddrOperand(counter, "l"),
+        ptxBuilder.newConstantOperand(1))
+        .predicate(pred, "b");
+    ptxBuilder.launch(rewriter, loc, void_ty(ctx));
+    rewriter.eraseOp(op);
+    return success();
+  }
+};
+
+struct ProfileMarkOpConversion
+    : public ConvertTritonGPUOpToLLVMPattern<triton::ProfileMarkOp> {
+  using ConvertTritonGPUOpToLLVMPattern<
+      triton::ProfileMarkOp>::ConvertTritonGPUOpToLLVMPattern;
+
+  // The u64 fields of the record of a region, per program and warp
+  enum Field { Begin, Cycles, Count, FirstBegin, LastEnd, NumFields };
+
+  LogicalResult
+  matchAndRewrite(triton::ProfileMarkOp op, OpAdaptor adaptor,
+                  ConversionPatternRewriter &rewriter) const override {
+    Location loc = op.getLoc();
+    MLIRContext *ctx = rewriter.getContext();
+    auto mod = op->getParentOfType<ModuleOp>();
+    auto numPrograms =
+        mod->getAttrOfType<IntegerAttr>("triton_gpu.profile-programs");
+    auto regions = mod->getAttrOfType<ArrayAttr>("triton_gpu.profile-regions");
+    if (!numPrograms || !regions) {
+      // Not profiled
+      rewriter.eraseOp(op);
+      return success();
+    }
+    int64_t region = llvm::find(regions, op.getNameAttr()) - regions.begin();
+    int numWarps = triton::gpu::TritonGPUDialect::getNumWarps(mod);
+    if (auto warpGroups = mod->getAttrOfType<IntegerAttr>(
+            "triton_gpu.num-warp-groups-per-cta"))
+      numWarps *= warpGroups.getInt();
+    int64_t numRecords = numPrograms.getInt() * numWarps * regions.size();
+
+    auto global = mod.lookupSymbol<LLVM::GlobalOp>("triton_profile_records");
+    if (!global) {
+      OpBuilder::InsertionGuard guard(rewriter);
+      rewriter.setInsertionPointToStart(mod.getBody());
+      int64_t size = numRecords * NumFields;
+      global = rewriter.create<LLVM::GlobalOp>(
+          UnknownLoc::get(ctx), LLVM::LLVMArrayType::get(i64_ty, size),
+          /*isConstant=*/false, LLVM::Linkage::External,
+          "triton_profile_records",
+          rewriter.getZeroAttr(RankedTensorType::get({size}, i64_ty)),
+          /*alignment=*/8, /*addrSpace=*/1);
+    }
+    // The record of the region for the CTA and warp
+    Value program = getLinearCTAId(rewriter, loc);
+    Value tid = getThreadId(rewriter, loc);
+    Value warp = udiv(tid, i32_val(32));
+    Value record = add(mul(add(mul(program, i32_val(numWarps)), warp),
+                           i32_val(static_cast<int>(regions.size()))),
+                       i32_val(region));
+    Value base = rewriter.create<LLVM::AddressOfOp>(loc, global);
+    Value ptr = gep(ptr_ty(ctx, 1), i64_ty, base,
+                    mul(record, i32_val(NumFields)));
+    Value pred = and_(icmp_eq(urem(tid, i32_val(32)), i32_val(0)),
+                      icmp_slt(program, i32_val(numPrograms.getInt())));
+
+    // The first begin is only recorded while its field is still zero
+    const char *beginAsm = "{\n"
+                           ".reg .u64 t;\n"
+                           "mov.u64 t, %clock64;\n"
+                           "@$1 st.global.u64 [$0], t;\n"
+                           "mov.u64 t, %globaltimer;\n"
+                           "@$1 atom.global.cas.b64 t, [$0+24], 0, t;\n"
+                           "}";
+    const char *endAsm = "{\n"
+                         ".reg .u64 t, b;\n"
+                         "mov.u64 t, %clock64;\n"
+                         "@$1 ld.global.u64 b, [$0];\n"
+                         "sub.u64 t, t, b;\n"
+                         "@$1 red.global.add.u64 [$0+8], t;\n"
+                         "@$1 red.global.add.u64 [$0+16], 1;\n"
+                         "mov.u64 t, %globaltimer;\n"
+                         "@$1 st.global.u64 [$0+32], t;\n"
+                         "}";
+    PTXBuilder ptxBuilder;
+    SmallVector<PTXBuilder::Operand *> operands = {
+        ptxBuilder.newOperand(ptr, "l"), ptxBuilder.newOperand(pred, "b")};
+    auto &mark = *ptxBuilder.create(op.getEnd() ? endAsm : beginAsm);
+    mark(operands, /*onlyAttachMLIRArgs=*/true);
+    ptxBuilder.launch(rewriter, loc, void_ty(ctx));
+    rewriter.eraseOp(op);
+    return success();
+  }
+};
+
+struct GridSyncOpConversion
+    : public ConvertTritonGPUOpToLLVMPattern<triton::GridSyncOp> {
+  using ConvertTritonGPUOpToLLVMPattern<
+      triton::GridSyncOp>::ConvertTritonGPUOpToLLVMPattern;
+
+  // The first thread of each CTA adds to a counter in global memory, and the
+  // CTAs wait until its high bit flips: the first CTA adds 0x80000000 minus
+  // one per other CTA, so that the bit flips once all of them arrived. The
+  // other bits are back to their value, so the counter is reused by the next
+  // synchronization and the next launch.
+  LogicalResult
+  matchAndRewrite(triton::GridSyncOp op, OpAdaptor adaptor,
+                  ConversionPatternRewriter &rewriter) const override {
+    Location loc = op.getLoc();
+    MLIRContext *ctx = rewriter.getContext();
+    auto mod = op->getParentOfType<ModuleOp>();
+    auto global = mod.lookupSymbol<LLVM::GlobalOp>("triton_grid_sync_counter");
+    if (!global) {
+      OpBuilder::InsertionGuard guard(rewriter);
+      rewriter.setInsertionPointToStart(mod.getBody());
+      global = rewriter.create<LLVM::GlobalOp>(
+          UnknownLoc::get(ctx), i32_ty, /*isConstant=*/false,
+          LLVM::Linkage::External, "triton_grid_sync_counter",
+          rewriter.getI32IntegerAttr(0), /*alignment=*/4, /*addrSpace=*/1);
+    }
+    Value counter = rewriter.create<LLVM::AddressOfOp>(loc, global);
+    Value numCTAs = mul(getSRegValue(rewriter, loc, "%nctaid.x"),
+                        mul(getSRegValue(rewriter, loc, "%nctaid.y"),
+                            getSRegValue(rewriter, loc, "%nctaid.z")));
+    Value first = icmp_eq(getLinearCTAId(rewriter, loc), i32_val(0));
+    Value highBit = i32_val(std::numeric_limits<int32_t>::min());
+    Value increment =
+        select(first, sub(highBit, sub(numCTAs, i32_val(1))), i32_val(1));
+    Value pred = icmp_eq(getThreadId(rewriter, loc), i32_val(0));
+
+    // The writes of the CTA are made visible before it arrives, and the
+    // writes of the other CTAs are visible to it after the wait
+    const char *syncAsm = "{\n"
+                          ".reg .u32 old, cur;\n"
+                          ".reg .pred p;\n"
+                          "@!$2 bra DONE;\n"
+                          "membar.gl;\n"
+                          "atom.global.add.u32 old, [$0], $1;\n"
+                          "WAIT:\n"
+                          "ld.volatile.global.u32 cur, [$0];\n"
+                          "xor.b32 cur, cur, old;\n"
+                          "and.b32 cur, cur, 0x80000000;\n"
+                          "setp.eq.u32 p, cur, 0;\n"
+                          "@p bra WAIT;\n"
+                          "membar.gl;\n"
+                          "DONE:\n"
+                          "}";
+    barrier();
+    PTXBuilder ptxBuilder;
+    SmallVector<PTXBuilder::Operand *> operands = {
+        ptxBuilder.newOperand(counter, "l"),
+        ptxBuilder.newOperand(increment, "r"),
+        ptxBuilder.newOperand(pred, "b")};
+    auto &sync = *ptxBuilder.create(syncAsm);
+    sync(operands, /*onlyAttachMLIRArgs=*/true);
+    ptxBuilder.launch(rewriter, loc, void_ty(ctx));
+    barrier();
+    rewriter.eraseOp(op);
+    return success();
+  }
+};
+
 struct AddPtrOpConversion
     : public ConvertTritonGPUOpToLLVMPattern<triton::AddPtrOp> {
   using ConvertTritonGPUOpToLLVMPattern<
@@ -887,6 +1190,9 @@ void mlir::triton::populateTritonGPUToLLVMPatterns(
   patterns.add<GetCanonicalWarpIdConversion>(typeConverter, benefit);
   patterns.add<GetClusterCTAIdOpConversion>(typeConverter, benefit);
   patterns.add<MakeRangeOpConversion>(typeConverter, indexCacheInfo, benefit);
+  patterns.add<ProfileCounterOpConversion>(typeConverter, benefit);
+  patterns.add<ProfileMarkOpConversion>(typeConverter, benefit);
+  patterns.add<GridSyncOpConversion>(typeConverter, benefit);
   patterns.add<ReturnOpConversion>(typeConverter, benefit);
   patterns.add<PrintOpConversion>(typeConverter, benefit);
   patterns.add<AssertOpConversion>(typeConverter, benefit);
@@ -23,6 +23,11 @@ constexpr ::llvm::StringLiteral kAttrNumTMALoadDescsName =
     "triton_gpu.num-tma-load";
 constexpr ::llvm::StringLiteral kAttrNumTMAStoreDescsName =
     "triton_gpu.num-tma-store";
+// The minimum number of elements per thread of the elementwise ops lowered
+// to a loop over them rather than unrolled, which bounds the size of the IR
+// of large tensors. Set from the `rolled-loops` option of the conversion.
+constexpr ::llvm::StringLiteral kAttrRolledLoopsName =
+    "triton_gpu.rolled-loops";
 using namespace mlir;
 using namespace mlir::triton;
 
@@ -145,45 +150,51 @@ protected:
   }
 };
 
+// The indices only depend on the layout and the shape, not on the element
+// type, so tensors of different types share them
 struct IndexCacheKeyT {
   Attribute layout;
-  RankedTensorType type;
+  ArrayRef<int64_t> shape;
   bool withCTAOffset;
+  // The function at the entry of which the indices are emitted
+  Operation *func;
 };
 
 struct CacheKeyDenseMapInfo {
   static IndexCacheKeyT getEmptyKey() {
     auto *pointer = llvm::DenseMapInfo<void *>::getEmptyKey();
     return {mlir::Attribute(static_cast<mlir::Attribute::ImplType *>(pointer)),
-            RankedTensorType{}, true};
+            {}, true, nullptr};
   }
   static IndexCacheKeyT getTombstoneKey() {
     auto *pointer = llvm::DenseMapInfo<void *>::getTombstoneKey();
-    auto tombstone = llvm::DenseMapInfo<RankedTensorType>::getTombstoneKey();
     return {mlir::Attribute(static_cast<mlir::Attribute::ImplType *>(pointer)),
-            tombstone, true};
+            {}, true, nullptr};
   }
   static unsigned getHashValue(IndexCacheKeyT key) {
-    return llvm::hash_combine(mlir::hash_value(key.layout),
-                              mlir::hash_value(key.type),
-                              llvm::hash_value(key.withCTAOffset));
+    return llvm::hash_combine(
+        mlir::hash_value(key.layout),
+        llvm::hash_combine_range(key.shape.begin(), key.shape.end()),
+        llvm::hash_value(key.withCTAOffset), llvm::hash_value(key.func));
   }
   static bool isEqual(IndexCacheKeyT LHS, IndexCacheKeyT RHS) {
-    return LHS.layout == RHS.layout && LHS.type == RHS.type &&
-           LHS.withCTAOffset == RHS.withCTAOffset;
+    return LHS.layout == RHS.layout && LHS.shape == RHS.shape &&
+           LHS.withCTAOffset == RHS.withCTAOffset && LHS.func == RHS.func;
   }
 };
 
 class ConvertTritonGPUOpToLLVMPatternBase {
 public:
   // Two levels of value cache in emitting indices calculation:
-  // Key: {layout, shape, withCTAOffset}
+  // Key: {layout, shape, withCTAOffset, function}
+  // The values are emitted at the entry of each function, after the ones
+  // already cached there, so that all the ops of the function can use them.
   struct IndexCacheInfo {
     DenseMap<IndexCacheKeyT, SmallVector<Value>, CacheKeyDenseMapInfo>
         *baseIndexCache = nullptr;
     DenseMap<IndexCacheKeyT, SmallVector<SmallVector<Value>>,
              CacheKeyDenseMapInfo> *indexCache = nullptr;
-    OpBuilder::InsertPoint *indexInsertPoint = nullptr;
+    DenseMap<Operation *, OpBuilder::InsertPoint> *indexInsertPoints = nullptr;
   };
 
   explicit ConvertTritonGPUOpToLLVMPatternBase(
@@ -375,7 +386,7 @@ public:
       auto idx = srcIndices[elemIdx];
       Value idxCol = idx[outOrder[0]]; // contiguous dimension
       Value idxRow, strideRow;
-      if (outOrder.size() == 2) {
+      if (outOrder.size() >= 2) {
         idxRow = idx[outOrder[1]]; // discontiguous dimension
         strideRow = srcStrides[outOrder[1]];
       } else {
@@ -432,11 +443,14 @@ public:
       Value colOff = add(colOffSwizzled, colOffOrdered);
       // compute non-immediate offset
       offset = add(offset, add(rowOff, mul(colOff, strideCol)));
+      // the matrices of a batch are not swizzled across each other
+      if (outOrder.size() == 3)
+        offset = add(offset, mul(idx[outOrder[2]], srcStrides[outOrder[2]]));
       Value currPtr = gep(dstPtrTy, getTypeConverter()->convertType(resElemTy),
                           dstPtrBase, offset);
       // compute immediate offset
       Value immediateOff;
-      if (outOrder.size() == 2) {
+      if (outOrder.size() >= 2) {
         immediateOff =
             add(mul(i32_val(immedateOffRow), srcStrides[outOrder[1]]),
                 i32_val(immedateOffCol));
@@ -457,7 +471,7 @@ public:
                           ConversionPatternRewriter &rewriter) const {
     auto dstTy = dst.getType().cast<RankedTensorType>();
     auto dstShape = dstTy.getShape();
-    assert(dstShape.size() == 2 &&
+    assert((dstShape.size() == 2 || dstShape.size() == 3) &&
            "Unexpected rank of loadSharedToDistributed");
     auto srcTy = src.getType().cast<RankedTensorType>();
     auto dstDistributedLayout = dstTy.getEncoding();
@@ -479,7 +493,7 @@ public:
     unsigned inVec = srcSharedLayout.getVec();
     unsigned minVec = std::min(outVec, inVec);
     unsigned outElems = triton::gpu::getTotalElemsPerThread(dstTy);
-    SmallVector<Value> offsetVals = {i32_val(0), i32_val(0)};
+    SmallVector<Value> offsetVals(dstShape.size(), i32_val(0));
     assert(outElems == dstIndices.size());
 
     DenseMap<unsigned, Value> sharedPtrs =
@@ -509,7 +523,7 @@ public:
                                 ConversionPatternRewriter &rewriter) const {
     auto srcTy = src.getType().cast<RankedTensorType>();
     auto srcShape = srcTy.getShape();
-    assert(srcShape.size() == 2 &&
+    assert((srcShape.size() == 2 || srcShape.size() == 3) &&
            "Unexpected rank of storeDistributedToShared");
     auto dstTy = dst.getType().cast<RankedTensorType>();
     auto srcDistributedLayout = srcTy.getEncoding();
@@ -535,8 +549,8 @@ public:
     auto wordTy = vec_ty(elemTy, minVec);
     Value word;
 
-    SmallVector<Value> srcStrides = {dstStrides[0], dstStrides[1]};
-    SmallVector<Value> offsetVals = {i32_val(0), i32_val(0)};
+    SmallVector<Value> srcStrides(dstStrides.begin(), dstStrides.end());
+    SmallVector<Value> offsetVals(srcShape.size(), i32_val(0));
     SharedMemoryObject smemObj(smemBase, elemTy, srcStrides, offsetVals);
 
     DenseMap<unsigned, Value> sharedPtrs =
@@ -697,9 +711,9 @@ public:
                                             RankedTensorType type,
                                             bool withCTAOffset) const {
     auto shape = type.getShape();
-    IndexCacheKeyT key{layout, type, withCTAOffset};
+    IndexCacheKeyT key{layout, shape, withCTAOffset,
+                       getIndexCacheScope(rewriter)};
     auto cache = indexCacheInfo.baseIndexCache;
-    auto insertPt = indexCacheInfo.indexInsertPoint;
 
     SmallVector<Value> baseIndex;
     if (cache && cache->count(key) > 0) {
@@ -707,7 +721,7 @@ public:
     } else {
       ConversionPatternRewriter::InsertionGuard guard(rewriter);
       if (cache)
-        restoreInsertionPointIfSet(insertPt, rewriter);
+        restoreInsertionPointIfSet(key.func, rewriter);
       SmallVector<Value> result;
       if (auto blockedLayout = layout.dyn_cast<BlockedEncodingAttr>()) {
         result = emitBaseIndexWithinCTAForBlockedLayout(loc, rewriter,
@@ -740,7 +754,8 @@ public:
       }
       if (cache) {
         cache->insert(std::make_pair(key, result));
-        *insertPt = rewriter.saveInsertionPoint();
+        (*indexCacheInfo.indexInsertPoints)[key.func] =
+            rewriter.saveInsertionPoint();
       }
       return result;
     }
@@ -769,15 +784,15 @@ public:
   SmallVector<SmallVector<Value>>
   emitIndices(Location loc, ConversionPatternRewriter &b, Attribute layout,
               RankedTensorType type, bool withCTAOffset = true) const {
-    IndexCacheKeyT key{layout, type, withCTAOffset};
+    IndexCacheKeyT key{layout, type.getShape(), withCTAOffset,
+                       getIndexCacheScope(b)};
     auto cache = indexCacheInfo.indexCache;
-    auto insertPt = indexCacheInfo.indexInsertPoint;
     if (cache && cache->count(key) > 0) {
       return cache->lookup(key);
     } else {
       ConversionPatternRewriter::InsertionGuard guard(b);
       if (cache)
-        restoreInsertionPointIfSet(insertPt, b);
+        restoreInsertionPointIfSet(key.func, b);
       SmallVector<SmallVector<Value>> result;
       if (auto blocked = layout.dyn_cast<BlockedEncodingAttr>()) {
         result = emitIndicesForDistributedLayout(loc, b, blocked, type,
@@ -795,22 +810,30 @@ public:
       }
       if (cache) {
         cache->insert(std::make_pair(key, result));
-        *insertPt = b.saveInsertionPoint();
+        (*indexCacheInfo.indexInsertPoints)[key.func] = b.saveInsertionPoint();
       }
       return result;
     }
   }
 
 private:
-  void restoreInsertionPointIfSet(OpBuilder::InsertPoint *insertPt,
+  // The function of the insertion point of `rewriter`, if any
+  static Operation *getIndexCacheScope(ConversionPatternRewriter &rewriter) {
+    Operation *parent = rewriter.getInsertionBlock()->getParentOp();
+    if (!parent || isa<LLVM::LLVMFuncOp>(parent))
+      return parent;
+    return parent->getParentOfType<LLVM::LLVMFuncOp>();
+  }
+
+  void restoreInsertionPointIfSet(Operation *func,
                                   ConversionPatternRewriter &rewriter) const {
-    if (insertPt->isSet()) {
-      rewriter.restoreInsertionPoint(*insertPt);
-    } else {
-      auto func =
-          rewriter.getInsertionPoint()->getParentOfType<LLVM::LLVMFuncOp>();
-      rewriter.setInsertionPointToStart(&func.getBody().front());
-    }
+    OpBuilder::InsertPoint insertPt =
+        indexCacheInfo.indexInsertPoints->lookup(func);
+    if (insertPt.isSet())
+      rewriter.restoreInsertionPoint(insertPt);
+    else
+      rewriter.setInsertionPointToStart(
+          &cast<LLVM::LLVMFuncOp>(func).getBody().front());
   }
 
   // -----------------------------------------------------------------------
@@ -1021,16 +1044,29 @@ private:
                            RankedTensorType type) const {
     auto shape = type.getShape();
     auto shapePerCTA = getShapePerCTA(mmaLayout, shape);
+    auto shapePerCTATile = getShapePerCTATile(mmaLayout);
+    unsigned rank = shape.size();
     SmallVector<SmallVector<unsigned>> ret;
 
-    for (unsigned i = 0; i < shapePerCTA[0];
-         i += getShapePerCTATile(mmaLayout)[0]) {
-      for (unsigned j = 0; j < shapePerCTA[1];
-           j += getShapePerCTATile(mmaLayout)[1]) {
-        ret.push_back({i, j});
-        ret.push_back({i, j + 1});
-        ret.push_back({i + 8, j});
-        ret.push_back({i + 8, j + 1});
+    // The tiles of the batch entries of a batched dot follow each other
+    unsigned numBatch = rank == 3 ? shapePerCTA[0] : 1;
+    unsigned batchStep = rank == 3 ? shapePerCTATile[0] : 1;
+    for (unsigned b = 0; b < numBatch; b += batchStep) {
+      auto push = [&](unsigned i, unsigned j) {
+        if (rank == 3)
+          ret.push_back({b, i, j});
+        else
+          ret.push_back({i, j});
+      };
+      for (unsigned i = 0; i < shapePerCTA[rank - 2];
+           i += shapePerCTATile[rank - 2]) {
+        for (unsigned j = 0; j < shapePerCTA[rank - 1];
+             j += shapePerCTATile[rank - 1]) {
+          push(i, j);
+          push(i, j + 1);
+          push(i + 8, j);
+          push(i + 8, j + 1);
+        }
       }
     }
     return ret;
@@ -1041,11 +1077,15 @@ private:
       const NvidiaMmaEncodingAttr &mmaLayout, RankedTensorType type) const {
     auto shape = type.getShape();
     auto _warpsPerCTA = mmaLayout.getWarpsPerCTA();
-    assert(_warpsPerCTA.size() == 2);
+    unsigned rank = shape.size();
+    assert(_warpsPerCTA.size() == rank &&
+           (rank == 2 || (rank == 3 && mmaLayout.isAmpere())));
+    // The rows and columns of the tiles, after the batch of batched dots
+    unsigned rowDim = rank - 2, colDim = rank - 1;
     auto order = triton::gpu::getOrder(mmaLayout);
     ArrayRef<unsigned int> instrShape = mmaLayout.getInstrShape();
-    SmallVector<Value> warpsPerCTA = {i32_val(_warpsPerCTA[0]),
-                                      i32_val(_warpsPerCTA[1])};
+    SmallVector<Value> warpsPerCTA = {i32_val(_warpsPerCTA[rowDim]),
+                                      i32_val(_warpsPerCTA[colDim])};
     auto shapePerCTA = getShapePerCTA(mmaLayout, shape);
 
     Value threadId = getThreadId(rewriter, loc);
@@ -1053,20 +1093,22 @@ private:
     Value laneId = urem(threadId, warpSize);
     Value warpId = udiv(threadId, warpSize);
 
-    uint32_t repM = (_warpsPerCTA[0] * instrShape[0]) / shapePerCTA[0];
-    uint32_t repN = (_warpsPerCTA[1] * instrShape[1]) / shapePerCTA[1];
+    uint32_t repM =
+        (_warpsPerCTA[rowDim] * instrShape[rowDim]) / shapePerCTA[rowDim];
+    uint32_t repN =
+        (_warpsPerCTA[colDim] * instrShape[colDim]) / shapePerCTA[colDim];
 
     uint32_t warpsM;
     if (repM > 1)
-      warpsM = _warpsPerCTA[0] / repM;
+      warpsM = _warpsPerCTA[rowDim] / repM;
     else
-      warpsM = shape[0] / instrShape[0];
+      warpsM = shape[rowDim] / instrShape[rowDim];
 
     uint32_t warpsN;
     if (repN > 1)
-      warpsN = _warpsPerCTA[1] / repN;
+      warpsN = _warpsPerCTA[colDim] / repN;
     else
-      warpsN = shape[1] / instrShape[1];
+      warpsN = shape[colDim] / instrShape[colDim];
 
     SmallVector<Value> multiDimWarpId(2);
     if (mmaLayout.isHopper()) {
@@ -1080,15 +1122,20 @@ private:
     } else {
       multiDimWarpId = delinearize(rewriter, loc, warpId, _warpsPerCTA, order);
     }
-    Value warpId0 = urem(multiDimWarpId[0], i32_val(warpsM));
-    Value warpId1 = urem(multiDimWarpId[1], i32_val(warpsN));
+    Value warpId0 = urem(multiDimWarpId[rowDim], i32_val(warpsM));
+    Value warpId1 = urem(multiDimWarpId[colDim], i32_val(warpsN));
 
-    Value offWarp0 = mul(warpId0, i32_val(instrShape[0]));
-    Value offWarp1 = mul(warpId1, i32_val(instrShape[1]));
+    Value offWarp0 = mul(warpId0, i32_val(instrShape[rowDim]));
+    Value offWarp1 = mul(warpId1, i32_val(instrShape[colDim]));
 
-    SmallVector<Value> multiDimBase(2);
-    multiDimBase[0] = add(udiv(laneId, i32_val(4)), offWarp0);
-    multiDimBase[1] = add(mul(i32_val(2), urem(laneId, i32_val(4))), offWarp1);
+    SmallVector<Value> multiDimBase(rank);
+    // Each warp of a batched dot starts at its batch entry, the warps past
+    // the batch hold the same entries again
+    if (rank == 3)
+      multiDimBase[0] = urem(multiDimWarpId[0], i32_val(shapePerCTA[0]));
+    multiDimBase[rowDim] = add(udiv(laneId, i32_val(4)), offWarp0);
+    multiDimBase[colDim] =
+        add(mul(i32_val(2), urem(laneId, i32_val(4))), offWarp1);
     return multiDimBase;
   }
 
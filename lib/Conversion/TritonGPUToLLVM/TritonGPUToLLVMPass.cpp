@@ -366,8 +366,10 @@ struct ConvertTritonGPUToLLVM
   }
 
   ConvertTritonGPUToLLVM(int32_t computeCapability, Target target,
-                         mlir::triton::gpu::TMAMetadataTy *tmaMetadata)
-      : ConvertTritonGPUToLLVMBase({computeCapability, target}),
+                         mlir::triton::gpu::TMAMetadataTy *tmaMetadata,
+                         bool fastMath, int32_t rolledLoops)
+      : ConvertTritonGPUToLLVMBase(
+            {computeCapability, target, fastMath, rolledLoops}),
         tmaMetadata(tmaMetadata) {}
 
   void runOnOperation() override {
@@ -380,6 +382,10 @@ struct ConvertTritonGPUToLLVM
     int numWarps = triton::gpu::TritonGPUDialect::getNumWarps(mod);
     int numCTAs = triton::gpu::TritonGPUDialect::getNumCTAs(mod);
     int threadsPerWarp = triton::gpu::TritonGPUDialect::getThreadsPerWarp(mod);
+    if (rolledLoops > 0)
+      mod->setAttr(kAttrRolledLoopsName,
+                   IntegerAttr::get(IntegerType::get(context, 32),
+                                    rolledLoops.getValue()));
 
     // Hack: WSMaterialization may have changed the effective number of warps,
     // in a way that isn't reflected in triton_gpu.num-warps.  If so, we have to
@@ -389,6 +395,9 @@ struct ConvertTritonGPUToLLVM
     }
 
     // Preprocess
+    numberProfileRegions(mod);
+    numberPrintFormats(mod);
+    markCooperative(mod);
     decomposeFp8e4b15Convert(mod);
     decomposeSplatToSharedLayout(mod, numWarps, threadsPerWarp, numCTAs);
     decomposeMmaToDotOperand(mod, numWarps, threadsPerWarp, numCTAs);
@@ -397,7 +406,7 @@ struct ConvertTritonGPUToLLVM
 
     // Allocate shared memory and set barrier
     ModuleAllocation allocation(mod);
-    ModuleMembarAnalysis membarPass(&allocation);
+    ModuleMembarAnalysis membarPass(&allocation, /*useNamedBarriers=*/true);
     membarPass.run();
 
     /* Get tensorPtrMap before conversion */
@@ -477,13 +486,11 @@ struct ConvertTritonGPUToLLVM
     // other values will be DCEed if not used hereafter.
     bool isWarpSpecialization =
         ttng::TritonNvidiaGPUDialect::getWSSupportedAttr(mod);
-    OpBuilder::InsertPoint indexInsertPoint;
+    baseIndexCache.clear();
+    indexCache.clear();
+    DenseMap<Operation *, OpBuilder::InsertPoint> indexInsertPoints;
     ConvertTritonGPUOpToLLVMPatternBase::IndexCacheInfo indexCacheInfo{
-        &baseIndexCache, &indexCache, &indexInsertPoint};
-    // TODO: enable index cache if there are multiple functions
-    if (axisInfoAnalysis.getNumFunctions() > 1) {
-      indexCacheInfo = {nullptr, nullptr, nullptr};
-    }
+        &baseIndexCache, &indexCache, &indexInsertPoints};
 
     // tmaMetadata is absent in a triton-opt unit test, in this case, create a
     // local one and dump it after this pass is done.
@@ -507,7 +514,7 @@ struct ConvertTritonGPUToLLVM
     auto populatePatterns3 = [&](auto populateFunc) {
       populateFunc(typeConverter, patterns, numWarps, axisInfoAnalysis,
                    allocation, indexCacheInfo, tmaMetadata, &tensorPtrMap,
-                   /*benefit*/ 10);
+                   computeCapability, /*benefit*/ 10);
     };
 
     auto populatePatterns4 = [&](auto populateFunc) {
@@ -520,15 +527,22 @@ struct ConvertTritonGPUToLLVM
     populatePatterns1(populateConvertLayoutOpToLLVMPatterns);
     populatePatterns2(populateDotOpToLLVMPatterns);
     populatePatterns4(populateElementwiseOpToLLVMPatterns);
+    // The approximations take precedence over the precise lowerings
+    if (fastMath)
+      populateFastMathOpToLLVMPatterns(typeConverter, patterns,
+                                       axisInfoAnalysis, computeCapability,
+                                       /*benefit*/ 11);
     populatePatterns3(populateLoadStoreOpToLLVMPatterns);
     populatePatterns4(populateReduceOpToLLVMPatterns);
     populatePatterns1(populateScanOpToLLVMPatterns);
+    populatePatterns1(populateSortOpToLLVMPatterns);
     populatePatterns2(populateViewOpToLLVMPatterns);
     populatePatterns2(populateBarrierOpToLLVMPatterns);
     populatePatterns2(populateTensorPtrOpsToLLVMPatterns);
     populatePatterns2(populateClusterOpsToLLVMPatterns);
     populatePatterns2(populateRegReallocOpToLLVMPatterns);
     populatePatterns1(populateHistogramOpToLLVMPatterns);
+    populatePatterns1(populateGatherOpToLLVMPatterns);
 
     // TODO(thomas): this should probably be done in a separate step to not
     // interfere with our own lowering of arith ops. Add arith/math's patterns
@@ -592,6 +606,69 @@ private:
                                         allocation.getSharedMemorySize()));
   }
 
+  // Records the names of the profiled regions of the module, in the order
+  // they first appear, which index their records.
+  void numberProfileRegions(ModuleOp mod) const {
+    llvm::SetVector<Attribute> names;
+    mod.walk(
+        [&](triton::ProfileMarkOp op) { names.insert(op.getNameAttr()); });
+    if (!names.empty())
+      mod->setAttr("triton_gpu.profile-regions",
+                   ArrayAttr::get(mod.getContext(), names.getArrayRef()));
+  }
+
+  // Kernels synchronizing their grid must be launched cooperatively, so that
+  // all their CTAs run at once.
+  void markCooperative(ModuleOp mod) const {
+    if (mod.walk([](triton::GridSyncOp) { return WalkResult::interrupt(); })
+            .wasInterrupted())
+      mod->setAttr("triton_gpu.cooperative",
+                   IntegerAttr::get(IntegerType::get(mod.getContext(), 32), 1));
+  }
+
+  // Numbers the formats of the device prints of the module, one per printed
+  // operand, when they write to the print buffer. Each format is described by
+  // "<element type>;<rank>;<operand>;<number of operands>;<prefix>" for the
+  // runtime, which decodes the records, sized for the highest rank.
+  void numberPrintFormats(ModuleOp mod) const {
+    if (!mod->hasAttr("triton_gpu.print-buffer"))
+      return;
+    MLIRContext *ctx = mod.getContext();
+    auto i32Ty = IntegerType::get(ctx, 32);
+    SmallVector<Attribute> formats;
+    int64_t maxRank = 0;
+    mod.walk([&](triton::PrintOp op) {
+      op->setAttr("triton_gpu.print-format",
+                  IntegerAttr::get(i32Ty, formats.size()));
+      auto describe = [&](Type type, int64_t rank, unsigned operand) {
+        std::string format;
+        llvm::raw_string_ostream os(format);
+        if (type && type.isa<triton::PointerType>())
+          os << "ptr";
+        else if (type)
+          type.print(os);
+        os << ";" << rank << ";" << operand << ";" << op.getNumOperands()
+           << ";" << op.getPrefix();
+        formats.push_back(StringAttr::get(ctx, os.str()));
+      };
+      if (op.getNumOperands() == 0)
+        describe(Type(), 0, 0);
+      for (unsigned i = 0; i < op.getNumOperands(); ++i) {
+        Type type = op.getOperand(i).getType();
+        int64_t rank = 0;
+        if (auto tensorTy = type.dyn_cast<RankedTensorType>()) {
+          rank = tensorTy.getRank();
+          type = tensorTy.getElementType();
+        }
+        maxRank = std::max(maxRank, rank);
+        describe(type, rank, i);
+      }
+    });
+    mod->setAttr("triton_gpu.print-formats", ArrayAttr::get(ctx, formats));
+    mod->setAttr("triton_gpu.print-record-words",
+                 IntegerAttr::get(i32Ty, 4 + maxRank + 2));
+  }
+
   void decomposeFp8e4b15Convert(ModuleOp mod) const {
     mod.walk([&](triton::gpu::ConvertLayoutOp cvtOp) -> void {
       OpBuilder builder(cvtOp);
@@ -711,6 +788,12 @@ private:
   }
 
   void decomposeInsertSliceAsyncOp(ModuleOp mod) const {
+    // Don't run the axis info analysis over the whole module for nothing
+    if (!mod.walk([](triton::gpu::InsertSliceAsyncOp) {
+              return WalkResult::interrupt();
+            })
+             .wasInterrupted())
+      return;
     ModuleAxisInfoAnalysis axisInfoAnalysis(mod);
     // TODO(Keren): This is a hacky knob that may cause performance regression
     // when decomposition has been performed. We should remove this knob once we
@@ -841,9 +924,10 @@ std::unique_ptr<OperationPass<ModuleOp>> createConvertTritonGPUToLLVMPass() {
 }
 std::unique_ptr<OperationPass<ModuleOp>> createConvertTritonGPUToLLVMPass(
     int32_t computeCapability, Target target,
-    mlir::triton::gpu::TMAMetadataTy *tmaMetadata) {
-  return std::make_unique<ConvertTritonGPUToLLVM>(computeCapability, target,
-                                                  tmaMetadata);
+    mlir::triton::gpu::TMAMetadataTy *tmaMetadata, bool fastMath,
+    int32_t rolledLoops) {
+  return std::make_unique<ConvertTritonGPUToLLVM>(
+      computeCapability, target, tmaMetadata, fastMath, rolledLoops);
 }
 
 } // namespace triton
@@ -26,9 +26,13 @@ TritonGPUTypeConverter::TritonGPUTypeConverter(MLIRContext *context,
     if (tensorType.getEncoding())
       return tensorType;
     ArrayRef<int64_t> shape = tensorType.getShape();
-    triton::gpu::BlockedEncodingAttr encoding =
-        getDefaultBlockedEncoding(this->context, shape, this->numWarps,
-                                  this->threadsPerWarp, this->numCTAs);
+    auto it =
+        this->encodings.find(SmallVector<int64_t>(shape.begin(), shape.end()));
+    Attribute encoding =
+        it != this->encodings.end()
+            ? it->second
+            : getDefaultBlockedEncoding(this->context, shape, this->numWarps,
+                                        this->threadsPerWarp, this->numCTAs);
     return RankedTensorType::get(shape, tensorType.getElementType(), encoding);
   });
 
@@ -6,6 +6,7 @@
 #include "mlir/Dialect/Index/IR/IndexDialect.h"
 #include "mlir/Pass/Pass.h"
 #include "mlir/Transforms/DialectConversion.h"
+#include "triton/Analysis/AxisInfo.h"
 #include "triton/Analysis/Utility.h"
 #include "triton/Dialect/Triton/IR/Dialect.h"
 #include "triton/Dialect/TritonGPU/IR/Dialect.h"
@@ -13,6 +14,7 @@
 #include "triton/Target/PTX/TmaMetadata.h"
 #include "llvm/ADT/APSInt.h"
 #include <numeric>
+#include <set>
 
 using namespace mlir;
 using namespace mlir::triton;
@@ -208,6 +210,31 @@ private:
   }
 };
 
+// The encoding of the result of a dot of shape `shape`
+static Attribute getDotEncoding(MLIRContext *context, ArrayRef<int64_t> shape,
+                                int numWarps, int threadsPerWarp,
+                                int numCTAs) {
+  // The FMA dots read 4 contiguous elements of their row-major B operand
+  // from shared memory at once when each thread has 4 columns of the result
+  SmallVector<unsigned> sizePerThread = {1, 1};
+  int64_t numElemsPerThread =
+      product<int64_t>(shape) / (numWarps * threadsPerWarp);
+  if (numElemsPerThread >= 4)
+    sizePerThread = {2, 2};
+  if (numElemsPerThread >= 8)
+    sizePerThread = {2, 4};
+  if (numElemsPerThread >= 16)
+    sizePerThread = {4, 4};
+  SmallVector<unsigned> order = {1, 0};
+  // The batch of batched dots is the slowest dimension
+  if (shape.size() == 3) {
+    sizePerThread.insert(sizePerThread.begin(), 1);
+    order = {2, 1, 0};
+  }
+  return triton::gpu::BlockedEncodingAttr::get(
+      context, shape, sizePerThread, order, numWarps, threadsPerWarp, numCTAs);
+}
+
 struct TritonDotPattern : public OpConversionPattern<triton::DotOp> {
   using OpConversionPattern<triton::DotOp>::OpConversionPattern;
 
@@ -217,19 +244,9 @@ struct TritonDotPattern : public OpConversionPattern<triton::DotOp> {
     RankedTensorType origType = op.getType().cast<RankedTensorType>();
     auto origShape = origType.getShape();
     auto typeConverter = getTypeConverter<TritonGPUTypeConverter>();
-    int numWarps = typeConverter->getNumWarps();
-    int threadsPerWarp = typeConverter->getThreadsPerWarp();
-    int numCTAs = typeConverter->getNumCTAs();
-
-    SmallVector<unsigned> retSizePerThread = {1, 1};
-    if (origShape[0] * origShape[1] / (numWarps * threadsPerWarp) >= 4)
-      retSizePerThread = {2, 2};
-    if (origShape[0] * origShape[1] / (numWarps * threadsPerWarp) >= 16)
-      retSizePerThread = {4, 4};
-    SmallVector<unsigned> retOrder = {1, 0};
-    Attribute dEncoding = triton::gpu::BlockedEncodingAttr::get(
-        getContext(), origShape, retSizePerThread, retOrder, numWarps,
-        threadsPerWarp, numCTAs);
+    Attribute dEncoding = getDotEncoding(
+        getContext(), origShape, typeConverter->getNumWarps(),
+        typeConverter->getThreadsPerWarp(), typeConverter->getNumCTAs());
     RankedTensorType retType =
         RankedTensorType::get(origShape, origType.getElementType(), dEncoding);
     // a & b must be of smem layout
@@ -357,6 +374,56 @@ struct TritonInterleaveOpPattern
   }
 };
 
+struct TritonJoinOpPattern : public OpConversionPattern<triton::JoinOp> {
+  using OpConversionPattern::OpConversionPattern;
+
+  LogicalResult matchAndRewrite(JoinOp op, OpAdaptor adaptor,
+                                ConversionPatternRewriter &rewriter) const {
+    // Simply rely on type inference for this op.  (Notably, GenericOpPattern
+    // does not do this, instead it assigns the default layout to the ins and
+    // outs.)
+    addNamedAttrs(rewriter.replaceOpWithNewOp<triton::JoinOp>(
+                      op, adaptor.getLhs(), adaptor.getRhs()),
+                  adaptor.getAttributes());
+    return success();
+  }
+};
+
+struct TritonSplitOpPattern : public OpConversionPattern<triton::SplitOp> {
+  using OpConversionPattern::OpConversionPattern;
+
+  LogicalResult matchAndRewrite(SplitOp op, OpAdaptor adaptor,
+                                ConversionPatternRewriter &rewriter) const {
+    // The split dimension has to be the most minor one and live in the
+    // registers of each thread, which the default layout of the operand
+    // doesn't give.  Convert the operand to the layout a join of two tensors
+    // of the default layout would have.
+    auto src = adaptor.getSrc();
+    auto srcTy = src.getType().cast<RankedTensorType>();
+    auto typeConverter = getTypeConverter<TritonGPUTypeConverter>();
+    auto defaultEnc = triton::gpu::getDefaultBlockedEncoding(
+        getContext(), srcTy.getShape().drop_back(),
+        typeConverter->getNumWarps(), typeConverter->getThreadsPerWarp(),
+        typeConverter->getNumCTAs());
+
+    Attribute srcEnc;
+    if (cast<DialectInferLayoutInterface>(&defaultEnc.getDialect())
+            ->inferJoinOpEncoding(defaultEnc, srcEnc, op.getLoc())
+            .failed())
+      return failure();
+    if (srcTy.getEncoding() != srcEnc) {
+      src = rewriter.create<triton::gpu::ConvertLayoutOp>(
+          op.getLoc(),
+          RankedTensorType::get(srcTy.getShape(), srcTy.getElementType(),
+                                srcEnc),
+          src);
+    }
+    addNamedAttrs(rewriter.replaceOpWithNewOp<triton::SplitOp>(op, src),
+                  adaptor.getAttributes());
+    return success();
+  }
+};
+
 struct TritonTransPattern : public OpConversionPattern<triton::TransOp> {
 
   using OpConversionPattern<triton::TransOp>::OpConversionPattern;
@@ -369,6 +436,16 @@ struct TritonTransPattern : public OpConversionPattern<triton::TransOp> {
     Attribute srcEncoding = srcType.getEncoding();
     if (!srcEncoding)
       return failure();
+    // Transposes that don't feed a dot stay in registers, where they are
+    // renames of the values.
+    bool feedsDot = llvm::any_of(op->getUsers(), [](Operation *user) {
+      return isa<triton::DotOp>(user);
+    });
+    if (!feedsDot && srcEncoding.isa<triton::gpu::BlockedEncodingAttr>()) {
+      addNamedAttrs(rewriter.replaceOpWithNewOp<triton::TransOp>(op, src),
+                    adaptor.getAttributes());
+      return success();
+    }
     if (!srcEncoding.isa<triton::gpu::SharedEncodingAttr>()) {
       // TODO: end-to-end correctness is broken if
       // the input is blocked and the output is shared
@@ -510,14 +587,18 @@ void populateTritonPatterns(TritonGPUTypeConverter &typeConverter,
       GenericOpPattern<triton::FpToFpOp>, GenericOpPattern<triton::IntToPtrOp>,
       GenericOpPattern<triton::PtrToIntOp>, GenericOpPattern<triton::SplatOp>,
       TritonBroadcastPattern, GenericOpPattern<triton::AddPtrOp>,
-      TritonCatPattern, TritonInterleaveOpPattern,
+      TritonCatPattern, TritonInterleaveOpPattern, TritonJoinOpPattern,
+      TritonSplitOpPattern,
       GenericOpPattern<triton::ClampFOp>,
       GenericOpPattern<triton::ElementwiseInlineAsmOp>, TritonReducePattern,
       GenericOpPattern<triton::ReduceReturnOp>, TritonScanPattern,
       GenericOpPattern<triton::ScanReturnOp>,
       GenericOpPattern<triton::MakeRangeOp>, TritonExpandDimsPattern,
       TritonTransPattern, TritonDotPattern, GenericOpPattern<triton::LoadOp>,
-      GenericOpPattern<triton::StoreOp>, GenericOpPattern<triton::HistogramOp>,
+      GenericOpPattern<triton::StoreOp>, GenericOpPattern<triton::PrefetchOp>,
+      GenericOpPattern<triton::HistogramOp>,
+      GenericOpPattern<triton::GatherOp>,
+      GenericOpPattern<triton::SortOp>,
       GenericOpPattern<triton::ExternElementwiseOp>,
       GenericOpPattern<triton::PrintOp>, GenericOpPattern<triton::AssertOp>,
       GenericOpPattern<triton::AtomicCASOp>,
@@ -714,6 +795,110 @@ void populateCFPatterns(TritonGPUTypeConverter &typeConverter,
 }
 //
 
+// Gives the tensors of the shapes of the anchor ops the layouts these ops
+// prefer. The default layout holds one element per thread along the most
+// minor dimension; the Coalesce and RemoveLayoutConversions passes would
+// otherwise rewrite the anchors and the ops around them to their layouts
+// later on, through conversions they then have to remove:
+//  - the loads and stores vectorize along the most contiguous dimension of
+//    their pointers, as Coalesce would have them do,
+//  - the dots keep the layout TritonDotPattern gives their result,
+//  - the reductions keep their axis within the warps.
+// The memory accesses come first, then the dots and the reductions. The
+// shapes of the reshapes that can't reorder elements keep the default layout,
+// which their lowering expects.
+static void setAnchorEncodings(ModuleOp mod,
+                               TritonGPUTypeConverter &typeConverter) {
+  MLIRContext *context = mod.getContext();
+  int numWarps = typeConverter.getNumWarps();
+  int threadsPerWarp = typeConverter.getThreadsPerWarp();
+  int numCTAs = typeConverter.getNumCTAs();
+  int numThreads = numWarps * threadsPerWarp;
+  using Shape = SmallVector<int64_t>;
+  auto getShape = [](Value value) {
+    ArrayRef<int64_t> shape =
+        value.getType().cast<RankedTensorType>().getShape();
+    return Shape(shape.begin(), shape.end());
+  };
+
+  std::set<Shape> defaultShapes;
+  mod.walk([&](triton::ReshapeOp op) {
+    if (op.getAllowReorder())
+      return;
+    defaultShapes.insert(getShape(op.getSrc()));
+    defaultShapes.insert(getShape(op.getResult()));
+  });
+
+  // The order and the elements per thread of the first access to each shape,
+  // widened by the later accesses in the same order
+  std::map<Shape, std::pair<SmallVector<unsigned, 4>, unsigned>> accesses;
+  ModuleAxisInfoAnalysis axisInfoAnalysis(mod);
+  mod.walk([&](Operation *op) {
+    Value ptr;
+    if (auto load = dyn_cast<triton::LoadOp>(op))
+      ptr = load.getPtr();
+    else if (auto store = dyn_cast<triton::StoreOp>(op))
+      ptr = store.getPtr();
+    if (!ptr || !ptr.getType().isa<RankedTensorType>())
+      return;
+    AxisInfo *axisInfo = axisInfoAnalysis.getAxisInfo(ptr);
+    if (!axisInfo)
+      return;
+    Shape shape = getShape(ptr);
+    SmallVector<unsigned, 4> order =
+        getContiguityOrder(axisInfo->getContiguity(), shape);
+    unsigned elemNumBits = triton::getPointeeBitWidth(
+        ptr.getType().cast<RankedTensorType>());
+    unsigned elemNumBytes = std::max(elemNumBits / 8, 1u);
+    unsigned maxMultiple = std::max<int64_t>(
+        axisInfo->getDivisibility(order[0]) / elemNumBytes, 1);
+    unsigned maxContig =
+        std::min(axisInfo->getContiguity(order[0]), shape[order[0]]);
+    unsigned perThread =
+        std::min({maxMultiple, maxContig, std::max(128 / elemNumBits, 1u)});
+    auto [it, inserted] =
+        accesses.try_emplace(shape, std::make_pair(order, perThread));
+    if (!inserted && it->second.first == order)
+      it->second.second = std::max(it->second.second, perThread);
+  });
+
+  std::set<Shape> anchoredShapes;
+  auto setEncoding = [&](const Shape &shape, Attribute encoding) {
+    if (defaultShapes.count(shape) || !anchoredShapes.insert(shape).second)
+      return;
+    typeConverter.setEncoding(shape, encoding);
+  };
+  for (auto &[shape, access] : accesses) {
+    auto &[order, perThread] = access;
+    int64_t numElemsPerThread = std::max<int64_t>(
+        product<int64_t>(shape) / numThreads, 1);
+    SmallVector<unsigned> sizePerThread(shape.size(), 1);
+    sizePerThread[order[0]] = std::min<int64_t>(perThread, numElemsPerThread);
+    setEncoding(shape, triton::gpu::BlockedEncodingAttr::get(
+                           context, shape, sizePerThread, order, numWarps,
+                           threadsPerWarp, numCTAs));
+  }
+  mod.walk([&](Operation *op) {
+    if (auto dot = dyn_cast<triton::DotOp>(op)) {
+      Shape shape = getShape(dot.getResult());
+      setEncoding(shape, getDotEncoding(context, shape, numWarps,
+                                        threadsPerWarp, numCTAs));
+    } else if (auto reduce = dyn_cast<triton::ReduceOp>(op)) {
+      // The threads of a warp go along the axis first
+      Shape shape = getShape(reduce.getOperands()[0]);
+      int axis = reduce.getAxis();
+      SmallVector<unsigned> order(1, axis);
+      for (int d = shape.size() - 1; d >= 0; --d)
+        if (d != axis)
+          order.push_back(d);
+      SmallVector<unsigned> sizePerThread(shape.size(), 1);
+      setEncoding(shape, triton::gpu::BlockedEncodingAttr::get(
+                             context, shape, sizePerThread, order, numWarps,
+                             threadsPerWarp, numCTAs));
+    }
+  });
+}
+
 class ConvertTritonToTritonGPU
     : public ConvertTritonToTritonGPUBase<ConvertTritonToTritonGPU> {
 public:
@@ -733,6 +918,7 @@ public:
     // type converter
     TritonGPUTypeConverter typeConverter(context, numWarps, threadsPerWarp,
                                          numCTAs);
+    setAnchorEncodings(mod, typeConverter);
     TritonGPUConversionTarget target(*context, typeConverter);
     // rewrite patterns
     RewritePatternSet patterns(context);
@@ -2,6 +2,7 @@
 #include "mlir/IR/BuiltinAttributes.h"
 #include "mlir/IR/BuiltinTypes.h"
 #include "mlir/IR/OperationSupport.h"
+#include "mlir/IR/TypeUtilities.h"
 #include "mlir/Interfaces/FunctionImplementation.h"
 #include "mlir/Interfaces/FunctionInterfaces.h"
 #include "triton/Dialect/Triton/IR/Dialect.h"
@@ -358,6 +359,18 @@ void triton::StoreOp::getCanonicalizationPatterns(RewritePatternSet &results,
   results.add<CanonicalizeMaskedStorePattern>(context);
 }
 
+//-- PrefetchOp --
+// The write keeps the prefetches, which only read memory, from being erased
+// as dead.
+void PrefetchOp::getEffects(
+    SmallVectorImpl<SideEffects::EffectInstance<MemoryEffects::Effect>>
+        &effects) {
+  effects.emplace_back(MemoryEffects::Read::get(), getPtr(),
+                       SideEffects::DefaultResource::get());
+  effects.emplace_back(MemoryEffects::Write::get(),
+                       SideEffects::DefaultResource::get());
+}
+
 //-- TransOp --
 mlir::LogicalResult mlir::triton::TransOp::inferReturnTypes(
     MLIRContext *context, std::optional<Location> location, ValueRange operands,
@@ -417,6 +430,13 @@ LogicalResult mlir::triton::DotOp::verify() {
       bTy.getElementType().getIntOrFloatBitWidth())
     return emitError(
         "element types of operands A and B must have same bit width");
+  // Batched dots multiply the matrices of a leading batch dimension
+  auto aShape = aTy.getShape(), bShape = bTy.getShape();
+  if (aTy.getRank() != bTy.getRank() ||
+      (aTy.getRank() != 2 && aTy.getRank() != 3))
+    return emitError("operands A and B must both be 2D, or both be 3D");
+  if (aTy.getRank() == 3 && aShape[0] != bShape[0])
+    return emitError("operands A and B must have the same batch size");
   auto aEncoding = aTy.getEncoding();
   auto bEncoding = bTy.getEncoding();
   if (!aEncoding && !bEncoding)
@@ -430,6 +450,30 @@ LogicalResult mlir::triton::DotOp::verify() {
                                                      bEncoding);
 }
 
+//-- DotScaledOp --
+LogicalResult mlir::triton::DotScaledOp::verify() {
+  auto aTy = getA().getType().cast<RankedTensorType>();
+  auto bTy = getB().getType().cast<RankedTensorType>();
+  auto cTy = getC().getType().cast<RankedTensorType>();
+  auto aScaleTy = getAScale().getType().cast<RankedTensorType>();
+  auto bScaleTy = getBScale().getType().cast<RankedTensorType>();
+  if (aTy.getElementType().getIntOrFloatBitWidth() !=
+      bTy.getElementType().getIntOrFloatBitWidth())
+    return emitError(
+        "element types of operands A and B must have same bit width");
+  if (aScaleTy.getElementType() != cTy.getElementType() ||
+      bScaleTy.getElementType() != cTy.getElementType())
+    return emitError("scales must have the element type of the accumulator");
+  if (cTy.getRank() != 2)
+    return emitError("accumulator must be a 2D tensor");
+  int64_t M = cTy.getShape()[0], N = cTy.getShape()[1];
+  if (aScaleTy.getShape() != ArrayRef<int64_t>({M, 1}))
+    return emitError("scales of A must have shape M x 1");
+  if (bScaleTy.getShape() != ArrayRef<int64_t>({1, N}))
+    return emitError("scales of B must have shape 1 x N");
+  return success();
+}
+
 //-- MakeRangeOp --
 OpFoldResult MakeRangeOp::fold(FoldAdaptor adaptor) {
   // make_range(start, start + 1) -> constant(start)
@@ -667,6 +711,16 @@ llvm::SmallVector<Type> ScanOp::getElementTypes() {
 
 unsigned ScanOp::getNumOperands() { return this->getOperands().size(); }
 
+//-- SortOp --
+mlir::LogicalResult mlir::triton::SortOp::verify() {
+  auto srcTy = getSrc().getType().cast<RankedTensorType>();
+  if (getAxis() >= srcTy.getRank())
+    return emitOpError() << "axis " << getAxis() << " is out of range";
+  if (!llvm::isPowerOf2_64(srcTy.getDimSize(getAxis())))
+    return emitOpError() << "the size of the axis must be a power of two";
+  return success();
+}
+
 //-- SplatOp --
 OpFoldResult SplatOp::fold(FoldAdaptor adaptor) {
   auto value = adaptor.getSrc();
@@ -822,12 +876,24 @@ mlir::LogicalResult mlir::triton::ReshapeOp::verify() {
 //-- FpToFpOp --
 mlir::LogicalResult mlir::triton::FpToFpOp::verify() {
   auto dstType = getType().cast<RankedTensorType>().getElementType();
-  auto srcType =
-      getOperand().getType().cast<RankedTensorType>().getElementType();
+  auto srcType = getFrom().getType().cast<RankedTensorType>().getElementType();
   if ((dstType.getIntOrFloatBitWidth() < srcType.getIntOrFloatBitWidth()) &&
       (!getRounding().has_value())) {
     return emitError("Rounding mode is required for FP downcast");
   }
+  bool isStochastic = getRounding() == RoundingMode::RS;
+  if (isStochastic != static_cast<bool>(getRbits()))
+    return emitError("Random bits are required for stochastic rounding, and "
+                     "only for it");
+  if (!isStochastic)
+    return mlir::success();
+  if (!getElementTypeOrSelf(getRbits().getType()).isInteger(32))
+    return emitError("Random bits must be i32");
+  if (!(srcType.isF32() &&
+        (dstType.isF16() || dstType.isBF16() || dstType.isFloat8E5M2())) &&
+      !(srcType.isF16() && dstType.isFloat8E5M2()))
+    return emitError("Stochastic rounding is only supported from fp32 to "
+                     "fp16, bf16 and fp8e5, and from fp16 to fp8e5");
   return mlir::success();
 }
 
@@ -1055,6 +1121,98 @@ LogicalResult triton::ExperimentalInterleaveOp::verify() {
   return success();
 }
 
+// -- JoinOp --
+LogicalResult
+JoinOp::inferReturnTypes(MLIRContext *context, std::optional<Location> location,
+                         ValueRange operands, DictionaryAttr attributes,
+                         OpaqueProperties properties, RegionRange regions,
+                         SmallVectorImpl<Type> &inferredReturnTypes) {
+  // These should have been checked by tablegen-generated code.
+  assert(operands.size() == 2);
+  assert(operands[0].getType() == operands[1].getType());
+  assert(operands[0].getType().isa<RankedTensorType>());
+  assert(operands[1].getType().isa<RankedTensorType>());
+
+  Value lhs = operands[0];
+  auto srcTy = lhs.getType().cast<RankedTensorType>();
+
+  SmallVector<int64_t> retShape(srcTy.getShape());
+  retShape.push_back(2);
+
+  Attribute srcEnc = srcTy.getEncoding();
+  Attribute retEnc;
+  if (srcEnc) {
+    if (dyn_cast<DialectInferLayoutInterface>(&srcEnc.getDialect())
+            ->inferJoinOpEncoding(srcEnc, retEnc, location)
+            .failed()) {
+      return failure();
+    }
+  }
+  inferredReturnTypes.push_back(
+      RankedTensorType::get(retShape, srcTy.getElementType(), retEnc));
+  return success();
+}
+
+// -- SplitOp --
+LogicalResult SplitOp::inferReturnTypes(
+    MLIRContext *context, std::optional<Location> location, ValueRange operands,
+    DictionaryAttr attributes, OpaqueProperties properties, RegionRange regions,
+    SmallVectorImpl<Type> &inferredReturnTypes) {
+  // These should have been checked by tablegen-generated code.
+  assert(operands.size() == 1);
+  assert(operands[0].getType().isa<RankedTensorType>());
+
+  Value src = operands[0];
+  auto srcTy = src.getType().cast<RankedTensorType>();
+  auto srcShape = srcTy.getShape();
+
+  if (srcShape.empty() || srcShape.back() != 2) {
+    return emitOptionalError(location,
+                             "last dimension of input tensor must be 2");
+  }
+  ArrayRef<int64_t> retShape(srcShape.begin(), srcShape.end() - 1);
+
+  Attribute srcEnc = srcTy.getEncoding();
+  Attribute retEnc;
+  if (srcEnc) {
+    if (dyn_cast<DialectInferLayoutInterface>(&srcEnc.getDialect())
+            ->inferSplitOpEncoding(srcEnc, retEnc, location)
+            .failed()) {
+      return failure();
+    }
+  }
+  auto retTy = RankedTensorType::get(retShape, srcTy.getElementType(), retEnc);
+  inferredReturnTypes.push_back(retTy);
+  inferredReturnTypes.push_back(retTy);
+  return success();
+}
+
+// -- GatherOp --
+LogicalResult GatherOp::verify() {
+  auto srcTy = getSrc().getType().cast<RankedTensorType>();
+  auto indicesTy = getIndices().getType().cast<RankedTensorType>();
+  auto resultTy = getResult().getType().cast<RankedTensorType>();
+  if (srcTy.getElementType() != resultTy.getElementType())
+    return emitOpError("result and source must have the same element type");
+  if (indicesTy.getShape() != resultTy.getShape())
+    return emitOpError("result and indices must have the same shape");
+  if (indicesTy.getRank() != srcTy.getRank())
+    return emitOpError("indices and source must have the same rank");
+  unsigned axis = getAxis();
+  if (axis >= srcTy.getRank())
+    return emitOpError("axis ") << axis << " is out of range";
+  for (unsigned d = 0; d < srcTy.getRank(); ++d) {
+    if (d != axis && indicesTy.getDimSize(d) != srcTy.getDimSize(d))
+      return emitOpError("indices and source must have the same size in "
+                         "dimension ")
+             << d << " (" << indicesTy.getDimSize(d) << " vs "
+             << srcTy.getDimSize(d) << ")";
+  }
+  if (indicesTy.getEncoding() != resultTy.getEncoding())
+    return emitOpError("result and indices must have the same encoding");
+  return success();
+}
+
 // -- ElementwiseInlineAsmOp --
 void ElementwiseInlineAsmOp::getEffects(
     SmallVectorImpl<SideEffects::EffectInstance<MemoryEffects::Effect>>
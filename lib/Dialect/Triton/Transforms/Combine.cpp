@@ -56,6 +56,8 @@ using FastMathFlags = arith::FastMathFlags;
 
 // select(cond, load(ptrs, broadcast(cond), ???), other)
 //   => load(ptrs, broadcast(cond), other)
+// select(mask, load(ptrs, mask, ???), other)
+//   => load(ptrs, mask, other)
 class CombineSelectMaskedLoadPattern : public mlir::RewritePattern {
 public:
   CombineSelectMaskedLoadPattern(mlir::MLIRContext *context)
@@ -82,15 +84,17 @@ public:
     if (!mask)
       return mlir::failure();
 
-    auto *broadcastOpCandidate = mask.getDefiningOp();
-    auto broadcastOp =
-        llvm::dyn_cast_or_null<triton::BroadcastOp>(broadcastOpCandidate);
-    if (!broadcastOp)
-      return mlir::failure();
+    if (mask != condSelect) {
+      auto *broadcastOpCandidate = mask.getDefiningOp();
+      auto broadcastOp =
+          llvm::dyn_cast_or_null<triton::BroadcastOp>(broadcastOpCandidate);
+      if (!broadcastOp)
+        return mlir::failure();
 
-    auto broadcastCond = broadcastOp.getSrc();
-    if (broadcastCond != condSelect)
-      return mlir::failure();
+      auto broadcastCond = broadcastOp.getSrc();
+      if (broadcastCond != condSelect)
+        return mlir::failure();
+    }
 
     rewriter.replaceOpWithNewOp<triton::LoadOp>(
         op, loadOp.getPtr(), loadOp.getMask(), falseValue,
@@ -188,6 +192,273 @@ public:
   }
 };
 
+// dot_scaled(a, b, c, aScale, bScale)
+// -> c + broadcast(aScale) * broadcast(bScale) * dot(a, b, 0)
+// The dot of the raw operands runs at the throughput of their type, and only
+// its partial accumulator is scaled.
+class DecomposeScaledDotPattern
+    : public mlir::OpRewritePattern<triton::DotScaledOp> {
+public:
+  using OpRewritePattern<triton::DotScaledOp>::OpRewritePattern;
+
+  mlir::LogicalResult
+  matchAndRewrite(triton::DotScaledOp op,
+                  mlir::PatternRewriter &rewriter) const override {
+    Location loc = op.getLoc();
+    auto cType = op.getC().getType().cast<RankedTensorType>();
+    auto aType = op.getA().getType().cast<RankedTensorType>();
+    // The integer dots accumulate in i32
+    Type partialElType = cType.getElementType();
+    if (aType.getElementType().isa<IntegerType>())
+      partialElType = rewriter.getI32Type();
+    auto partialType = RankedTensorType::get(
+        cType.getShape(), partialElType, cType.getEncoding());
+    Value zero = rewriter.create<arith::ConstantOp>(
+        loc, partialType, rewriter.getZeroAttr(partialType));
+    Value partial = rewriter.create<triton::DotOp>(
+        loc, partialType, op.getA(), op.getB(), zero, op.getAllowTF32(),
+        op.getMaxNumImpreciseAcc());
+    if (partialElType != cType.getElementType())
+      partial = rewriter.create<arith::SIToFPOp>(loc, cType, partial);
+    Value aScale =
+        rewriter.create<triton::BroadcastOp>(loc, cType, op.getAScale());
+    Value bScale =
+        rewriter.create<triton::BroadcastOp>(loc, cType, op.getBScale());
+    Value scale = rewriter.create<arith::MulFOp>(loc, aScale, bScale);
+    Value scaled = rewriter.create<arith::MulFOp>(loc, partial, scale);
+    rewriter.replaceOpWithNewOp<arith::AddFOp>(op, op.getC(), scaled);
+    return mlir::success();
+  }
+};
+
+// dot(a * splat(s), b, 0) -> dot(a, b, 0) * splat(s)
+// dot(a, b * splat(s), 0) -> dot(a, b, 0) * splat(s)
+// Scaling the result rather than an operand leaves the operand as loaded,
+// which keeps it on the direct path from memory to the dot.
+class HoistDotScalePattern : public mlir::OpRewritePattern<triton::DotOp> {
+public:
+  using OpRewritePattern<triton::DotOp>::OpRewritePattern;
+
+  mlir::LogicalResult
+  matchAndRewrite(triton::DotOp op,
+                  mlir::PatternRewriter &rewriter) const override {
+    if (!isZero(op.getC()))
+      return mlir::failure();
+    auto resultType = op.getType().cast<RankedTensorType>();
+    auto resultElType = resultType.getElementType().dyn_cast<FloatType>();
+    if (!resultElType)
+      return mlir::failure();
+    Value a = op.getA(), b = op.getB();
+    Value scale;
+    if ((scale = getScale(a, resultElType)))
+      a = getUnscaled(a);
+    else if ((scale = getScale(b, resultElType)))
+      b = getUnscaled(b);
+    else
+      return mlir::failure();
+
+    Location loc = op.getLoc();
+    Value scaleTensor;
+    DenseElementsAttr attr;
+    if (matchPattern(scale, m_Constant(&attr))) {
+      APFloat value = attr.getSplatValue<APFloat>();
+      bool losesInfo;
+      value.convert(resultElType.getFloatSemantics(),
+                    APFloat::rmNearestTiesToEven, &losesInfo);
+      scaleTensor = rewriter.create<arith::ConstantOp>(
+          loc, resultType,
+          DenseElementsAttr::get(resultType,
+                                 rewriter.getFloatAttr(resultElType, value)));
+    } else {
+      if (scale.getType() != resultElType)
+        scale = rewriter.create<arith::ExtFOp>(loc, resultElType, scale);
+      scaleTensor = rewriter.create<triton::SplatOp>(loc, resultType, scale);
+    }
+    Value dot = rewriter.create<triton::DotOp>(
+        loc, resultType, a, b, op.getC(), op.getAllowTF32(),
+        op.getMaxNumImpreciseAcc());
+    rewriter.replaceOpWithNewOp<arith::MulFOp>(op, dot, scaleTensor);
+    return mlir::success();
+  }
+
+private:
+  // The operand of `mulOp` that is a splat of a scalar, or null
+  static Value getScaleOperand(arith::MulFOp mulOp) {
+    for (Value operand : {mulOp.getRhs(), mulOp.getLhs()}) {
+      if (operand.getDefiningOp<triton::SplatOp>())
+        return operand;
+      DenseElementsAttr attr;
+      if (matchPattern(operand, m_Constant(&attr)) && attr.isSplat())
+        return operand;
+    }
+    return Value();
+  }
+
+  static Value getUnscaled(Value operand) {
+    auto mulOp = operand.getDefiningOp<arith::MulFOp>();
+    return mulOp.getRhs() == getScaleOperand(mulOp) ? mulOp.getLhs()
+                                                      : mulOp.getRhs();
+  }
+
+  // The scalar `s`, or the splat constant `s`, when `operand` is scaled by it
+  // and `s` widens exactly to the type of the result of the dot.
+  static Value getScale(Value operand, FloatType resultElType) {
+    auto mulOp = operand.getDefiningOp<arith::MulFOp>();
+    if (!mulOp || !mulOp->hasOneUse())
+      return Value();
+    Value scale = getScaleOperand(mulOp);
+    if (!scale)
+      return Value();
+    auto elType = getElementTypeOrSelf(scale).dyn_cast<FloatType>();
+    if (!elType)
+      return Value();
+    // Only the widenings of the arith dialect are emitted for the scale
+    if (elType != resultElType &&
+        !(elType.getWidth() < resultElType.getWidth() &&
+          (elType.isF16() || elType.isBF16() || elType.isF32())))
+      return Value();
+    if (auto splat = scale.getDefiningOp<triton::SplatOp>())
+      return splat.getSrc();
+    return scale;
+  }
+};
+
+// Returns true if every value of the floating point type `from` is exactly
+// representable in `to`.
+static bool holdsExactly(Type from, Type to) {
+  auto fromType = from.dyn_cast<FloatType>();
+  auto toType = to.dyn_cast<FloatType>();
+  if (!fromType || !toType)
+    return false;
+  const llvm::fltSemantics &fromSem = fromType.getFloatSemantics();
+  const llvm::fltSemantics &toSem = toType.getFloatSemantics();
+  return APFloat::semanticsPrecision(toSem) >=
+             APFloat::semanticsPrecision(fromSem) &&
+         APFloat::semanticsMaxExponent(toSem) >=
+             APFloat::semanticsMaxExponent(fromSem) &&
+         APFloat::semanticsMinExponent(toSem) <=
+             APFloat::semanticsMinExponent(fromSem);
+}
+
+// cast(widen(x)) -> x, when the cast goes back to the type of x
+// cast(widen(x)) -> widen(x), when the cast still holds x exactly
+// The widenings are the `arith.extf` and `tt.fp_to_fp` ops whose result type
+// holds their source exactly, so that the value the cast sees is x itself.
+template <typename OpTy>
+class CombineFpCastChainPattern : public mlir::OpRewritePattern<OpTy> {
+public:
+  using mlir::OpRewritePattern<OpTy>::OpRewritePattern;
+
+  mlir::LogicalResult
+  matchAndRewrite(OpTy op, mlir::PatternRewriter &rewriter) const override {
+    Operation *widenOp = op->getOperand(0).getDefiningOp();
+    if (!isa_and_nonnull<arith::ExtFOp, triton::FpToFpOp>(widenOp))
+      return mlir::failure();
+    Value src = widenOp->getOperand(0);
+    Type srcElType = getElementTypeOrSelf(src);
+    Type dstElType = getElementTypeOrSelf(op.getType());
+    if (!holdsExactly(srcElType, getElementTypeOrSelf(widenOp->getResult(0))))
+      return mlir::failure();
+    if (srcElType == dstElType) {
+      rewriter.replaceOp(op, src);
+      return mlir::success();
+    }
+    if (!holdsExactly(srcElType, dstElType))
+      return mlir::failure();
+    // tt.fp_to_fp converts between the fp8 types and the others, and
+    // arith.extf between the others.
+    auto isFp8 = [](Type type) { return type.getIntOrFloatBitWidth() == 8; };
+    if (isFp8(srcElType) != isFp8(dstElType))
+      rewriter.replaceOpWithNewOp<triton::FpToFpOp>(op, op.getType(), src);
+    else if (!isFp8(srcElType))
+      rewriter.replaceOpWithNewOp<arith::ExtFOp>(op, op.getType(), src);
+    else
+      return mlir::failure();
+    return mlir::success();
+  }
+};
+
+// reduce(broadcast(x), axis), with x of size 1 along axis
+//   -> reduce(x, axis) for max, min, and, or
+//   -> reduce(x, axis) * n for add, n being the size of the axis
+// and reduce(x, axis) is y when x is expand_dims(y, axis). The sizes of the
+// tensors are powers of two, so the floating point sums of the n copies are
+// exact.
+class SimplifyReduceOfBroadcastPattern
+    : public mlir::OpRewritePattern<triton::ReduceOp> {
+public:
+  using OpRewritePattern<triton::ReduceOp>::OpRewritePattern;
+
+  mlir::LogicalResult
+  matchAndRewrite(triton::ReduceOp op,
+                  mlir::PatternRewriter &rewriter) const override {
+    if (op.getNumOperands() != 1)
+      return mlir::failure();
+    unsigned axis = op.getAxis();
+    auto broadcastOp = op.getOperand(0).getDefiningOp<triton::BroadcastOp>();
+    if (!broadcastOp)
+      return mlir::failure();
+    Value x = broadcastOp.getSrc();
+    auto xType = x.getType().dyn_cast<RankedTensorType>();
+    if (!xType || xType.getDimSize(axis) != 1)
+      return mlir::failure();
+    int64_t n = broadcastOp.getType().cast<RankedTensorType>().getDimSize(axis);
+
+    Block &combine = op.getCombineOp().front();
+    if (combine.getOperations().size() != 2)
+      return mlir::failure();
+    Operation *combineOp = &combine.front();
+    if (combineOp->getNumOperands() != 2 ||
+        !llvm::all_of(combineOp->getOperands(), [&](Value operand) {
+          return isa<BlockArgument>(operand) &&
+                 operand.getParentBlock() == &combine;
+        }))
+      return mlir::failure();
+    bool isSum = isa<arith::AddFOp, arith::AddIOp>(combineOp);
+    bool isIdempotent =
+        isa<arith::MaximumFOp, arith::MaxNumFOp, arith::MinimumFOp,
+            arith::MinNumFOp, arith::MaxSIOp, arith::MaxUIOp, arith::MinSIOp,
+            arith::MinUIOp, arith::AndIOp, arith::OrIOp>(combineOp);
+    if (!isSum && !isIdempotent)
+      return mlir::failure();
+
+    Location loc = op.getLoc();
+    Type resultType = op.getResult()[0].getType();
+    Type elType = getElementTypeOrSelf(resultType);
+    Value nValue;
+    if (isSum) {
+      TypedAttr nAttr = elType.isa<FloatType>()
+                            ? TypedAttr(rewriter.getFloatAttr(elType, n))
+                            : TypedAttr(rewriter.getIntegerAttr(elType, n));
+      if (auto tensorType = resultType.dyn_cast<RankedTensorType>())
+        nAttr = cast<TypedAttr>(
+            DenseElementsAttr::get(tensorType, ArrayRef<Attribute>(nAttr)));
+      nValue = rewriter.create<arith::ConstantOp>(loc, nAttr);
+    }
+    Value result;
+    auto expandDimsOp = x.getDefiningOp<triton::ExpandDimsOp>();
+    if (expandDimsOp && expandDimsOp.getAxis() == axis &&
+        expandDimsOp.getSrc().getType() == resultType) {
+      result = expandDimsOp.getSrc();
+    } else {
+      auto newReduce =
+          rewriter.create<triton::ReduceOp>(loc, ValueRange{x}, axis);
+      Region &newCombine = newReduce.getCombineOp();
+      rewriter.cloneRegionBefore(op.getCombineOp(), newCombine,
+                                 newCombine.end());
+      result = newReduce.getResult()[0];
+    }
+    if (isSum) {
+      if (elType.isa<FloatType>())
+        result = rewriter.create<arith::MulFOp>(loc, result, nValue);
+      else
+        result = rewriter.create<arith::MulIOp>(loc, result, nValue);
+    }
+    rewriter.replaceOp(op, result);
+    return mlir::success();
+  }
+};
+
 #define GEN_PASS_CLASSES
 #include "triton/Dialect/Triton/Transforms/Passes.h.inc"
 
@@ -208,6 +479,12 @@ public:
     // patterns.add<CombineAddPtrPattern>(context);
     patterns.add<CombineBroadcastConstantPattern>(context);
     patterns.add<CombineBroadcastMulReducePattern>(context);
+    patterns.add<DecomposeScaledDotPattern>(context);
+    patterns.add<HoistDotScalePattern>(context);
+    patterns.add<CombineFpCastChainPattern<triton::FpToFpOp>,
+                 CombineFpCastChainPattern<arith::TruncFOp>,
+                 CombineFpCastChainPattern<arith::ExtFOp>>(context);
+    patterns.add<SimplifyReduceOfBroadcastPattern>(context);
 
     if (applyPatternsAndFoldGreedily(m, std::move(patterns)).failed())
       signalPassFailure();
@@ -0,0 +1,129 @@
+#include "mlir/Dialect/SCF/IR/SCF.h"
+#include "mlir/IR/IRMapping.h"
+#include "mlir/Pass/Pass.h"
+#include "triton/Dialect/Triton/IR/Dialect.h"
+#include "triton/Dialect/Triton/Transforms/Passes.h"
+#include "triton/Dialect/Triton/Transforms/ProgramIds.h"
+
+#include <array>
+#include <memory>
+
+//===----------------------------------------------------------------------===//
+// This pass fuses the kernels of a module, written for independent grids,
+// into a single kernel launched on a 1D grid of all their programs. Program
+// `pid` runs the body of the kernel whose range of programs holds it, with the
+// program ids and the number of programs of the grid of that kernel, so a
+// launch of several small kernels fills the device at once.
+//
+// The fused kernel takes the arguments of the kernels in order, followed by
+// the grid of each kernel along x, y and z in i32 arguments: the ranges of
+// programs follow the grids the launcher passes, the programs of the first
+// kernel first.
+//===----------------------------------------------------------------------===//
+
+using namespace mlir;
+
+#define GEN_PASS_CLASSES
+#include "triton/Dialect/Triton/Transforms/Passes.h.inc"
+
+namespace {
+
+triton::FuncOp fuseKernels(ModuleOp m, ArrayRef<triton::FuncOp> kernels,
+                           StringRef name) {
+  MLIRContext *context = m.getContext();
+  OpBuilder builder(context);
+  Type i32Ty = builder.getI32Type();
+  SmallVector<Location> locs;
+  SmallVector<Type> argTypes;
+  SmallVector<DictionaryAttr> argAttrs;
+  for (triton::FuncOp funcOp : kernels) {
+    locs.push_back(funcOp.getLoc());
+    for (unsigned i = 0; i < funcOp.getNumArguments(); ++i) {
+      argTypes.push_back(funcOp.getArgument(i).getType());
+      argAttrs.push_back(DictionaryAttr::get(context, funcOp.getArgAttrs(i)));
+    }
+  }
+  unsigned numArgs = argTypes.size();
+  argTypes.append(3 * kernels.size(), i32Ty);
+  argAttrs.append(3 * kernels.size(), DictionaryAttr::get(context));
+
+  Location loc = builder.getFusedLoc(locs);
+  builder.setInsertionPointToEnd(m.getBody());
+  auto fused = builder.create<triton::FuncOp>(
+      loc, name, builder.getFunctionType(argTypes, {}),
+      ArrayRef<NamedAttribute>{}, argAttrs);
+  Block *entry = fused.addEntryBlock();
+  builder.setInsertionPointToStart(entry);
+  Value pid = builder.create<triton::GetProgramIdOp>(
+      loc, i32Ty,
+      triton::ProgramIDDimAttr::get(context, triton::ProgramIDDim::X));
+  Value start = builder.create<arith::ConstantIntOp>(loc, 0, 32);
+
+  unsigned argIndex = 0;
+  for (auto [i, funcOp] : llvm::enumerate(kernels)) {
+    Location kernelLoc = funcOp.getLoc();
+    std::array<Value, 3> grid;
+    for (unsigned axis = 0; axis < 3; ++axis)
+      grid[axis] = entry->getArgument(numArgs + 3 * i + axis);
+    Value numPrograms = builder.create<arith::MulIOp>(
+        kernelLoc, builder.create<arith::MulIOp>(kernelLoc, grid[0], grid[1]),
+        grid[2]);
+    Value end = builder.create<arith::AddIOp>(kernelLoc, start, numPrograms);
+    Value afterStart = builder.create<arith::CmpIOp>(
+        kernelLoc, arith::CmpIPredicate::sge, pid, start);
+    Value beforeEnd = builder.create<arith::CmpIOp>(
+        kernelLoc, arith::CmpIPredicate::slt, pid, end);
+    Value inRange =
+        builder.create<arith::AndIOp>(kernelLoc, afterStart, beforeEnd);
+    auto ifOp = builder.create<scf::IfOp>(kernelLoc, inRange,
+                                          /*withElseRegion=*/false);
+
+    OpBuilder::InsertionGuard guard(builder);
+    builder.setInsertionPoint(ifOp.thenYield());
+    Value index = builder.create<arith::SubIOp>(kernelLoc, pid, start);
+    auto programIds = triton::getProgramIds(builder, kernelLoc, index, grid);
+    IRMapping mapping;
+    for (BlockArgument arg : funcOp.getArguments())
+      mapping.map(arg, entry->getArgument(argIndex + arg.getArgNumber()));
+    argIndex += funcOp.getNumArguments();
+    for (Operation &op : funcOp.getBody().front().without_terminator())
+      builder.clone(op, mapping);
+    triton::replaceProgramIds(ifOp, programIds, grid);
+    start = end;
+  }
+  builder.create<triton::ReturnOp>(loc);
+  return fused;
+}
+
+} // anonymous namespace
+
+class FuseKernelsPass : public TritonFuseKernelsBase<FuseKernelsPass> {
+public:
+  FuseKernelsPass(const std::string &kernelName) {
+    this->kernelName = kernelName;
+  }
+
+  void runOnOperation() override {
+    ModuleOp m = getOperation();
+    SmallVector<triton::FuncOp> kernels;
+    for (auto funcOp : m.getOps<triton::FuncOp>())
+      if (funcOp.isPublic())
+        kernels.push_back(funcOp);
+    if (kernels.empty())
+      return;
+    for (triton::FuncOp funcOp : kernels) {
+      if (!triton::canRemapProgramIds(funcOp)) {
+        funcOp.emitError("cannot fuse a kernel with calls or several blocks");
+        return signalPassFailure();
+      }
+    }
+    fuseKernels(m, kernels, kernelName);
+    for (triton::FuncOp funcOp : kernels)
+      funcOp.erase();
+  }
+};
+
+std::unique_ptr<Pass>
+mlir::triton::createFuseKernelsPass(const std::string &kernelName) {
+  return std::make_unique<FuseKernelsPass>(kernelName);
+}
@@ -0,0 +1,114 @@
+#include "mlir/Dialect/SCF/IR/SCF.h"
+#include "mlir/Pass/Pass.h"
+#include "triton/Dialect/Triton/IR/Dialect.h"
+#include "triton/Dialect/Triton/Transforms/Passes.h"
+#include "triton/Dialect/Triton/Transforms/ProgramIds.h"
+
+#include <memory>
+
+//===----------------------------------------------------------------------===//
+// This pass makes kernels persistent: their body becomes a loop over the
+// tiles of the grid they were written for, each program running every
+// `num_programs`-th tile. The grid is passed in three trailing i32 arguments
+// and replaces the program ids and the number of programs in the body, so the
+// kernel only runs as many programs as fit on the device. The launcher passes
+// the grid when the module has the `tt.persistent` attribute.
+//
+// The tiles are visited in the order of the launch, x first, or in groups of
+// `group-size` ids along x swept along y so that the programs running at the
+// same time share their operands in L2. On GPUs made of chiplets with an L2
+// each, which get the programs round-robin, the programs of a chiplet take
+// consecutive tiles of each round instead of every `num-xcds`-th tile.
+//===----------------------------------------------------------------------===//
+
+using namespace mlir;
+
+#define GEN_PASS_CLASSES
+#include "triton/Dialect/Triton/Transforms/Passes.h.inc"
+
+namespace {
+
+// Returns the first tile of program `pid` such that the programs dispatched to
+// each of the `numXcds` chiplets take consecutive tiles of each round of
+// `numPrograms` tiles. Program `pid` runs on chiplet `pid % numXcds`, and the
+// first `numPrograms % numXcds` chiplets run one more program than the others.
+Value getFirstTile(OpBuilder &builder, Location loc, Value pid,
+                   Value numPrograms, int numXcds) {
+  if (numXcds <= 1)
+    return pid;
+  Value cstXcds = builder.create<arith::ConstantIntOp>(loc, numXcds, 32);
+  Value xcd = builder.create<arith::RemSIOp>(loc, pid, cstXcds);
+  Value idInXcd = builder.create<arith::DivSIOp>(loc, pid, cstXcds);
+  Value perXcd = builder.create<arith::DivSIOp>(loc, numPrograms, cstXcds);
+  Value numLarger = builder.create<arith::RemSIOp>(loc, numPrograms, cstXcds);
+  Value firstOfXcd = builder.create<arith::AddIOp>(
+      loc, builder.create<arith::MulIOp>(loc, xcd, perXcd),
+      builder.create<arith::MinSIOp>(loc, xcd, numLarger));
+  return builder.create<arith::AddIOp>(loc, firstOfXcd, idInXcd);
+}
+
+void makePersistent(triton::FuncOp funcOp, int groupSize, int numXcds) {
+  Location loc = funcOp.getLoc();
+  OpBuilder builder(funcOp.getContext());
+  Type i32Ty = builder.getI32Type();
+  SmallVector<Value> grid;
+  for (int i = 0; i < 3; ++i) {
+    unsigned index = funcOp.getNumArguments();
+    funcOp.insertArgument(index, i32Ty, DictionaryAttr(), loc);
+    grid.push_back(funcOp.getArgument(index));
+  }
+  Block &body = funcOp.getBody().front();
+  builder.setInsertionPointToStart(&body);
+  Value pid = builder.create<triton::GetProgramIdOp>(
+      loc, i32Ty,
+      triton::ProgramIDDimAttr::get(builder.getContext(),
+                                    triton::ProgramIDDim::X));
+  Value numPrograms = builder.create<triton::GetNumProgramsOp>(loc, i32Ty, 0);
+  Value numTiles = builder.create<arith::MulIOp>(
+      loc, builder.create<arith::MulIOp>(loc, grid[0], grid[1]), grid[2]);
+  Value firstTile = getFirstTile(builder, loc, pid, numPrograms, numXcds);
+  auto forOp =
+      builder.create<scf::ForOp>(loc, firstTile, numTiles, numPrograms);
+  Block *loopBody = forOp.getBody();
+  loopBody->getOperations().splice(loopBody->getTerminator()->getIterator(),
+                                   body.getOperations(),
+                                   std::next(forOp->getIterator()),
+                                   body.getTerminator()->getIterator());
+
+  builder.setInsertionPointToStart(loopBody);
+  auto tileIds = triton::getProgramIds(builder, loc, forOp.getInductionVar(),
+                                       grid, groupSize);
+  triton::replaceProgramIds(forOp, tileIds, grid);
+}
+
+} // anonymous namespace
+
+class MakePersistentPass
+    : public TritonMakePersistentBase<MakePersistentPass> {
+public:
+  MakePersistentPass(int groupSize, int numXcds) {
+    this->groupSize = groupSize;
+    this->numXcds = numXcds;
+  }
+
+  void runOnOperation() override {
+    ModuleOp m = getOperation();
+    SmallVector<triton::FuncOp> kernels;
+    for (auto funcOp : m.getOps<triton::FuncOp>())
+      if (funcOp.isPublic())
+        kernels.push_back(funcOp);
+    // The launcher passes the grid to every kernel of the module or to none
+    if (kernels.empty() || !llvm::all_of(kernels, triton::canRemapProgramIds))
+      return;
+    for (triton::FuncOp funcOp : kernels)
+      makePersistent(funcOp, groupSize, numXcds);
+    m->setAttr("tt.persistent",
+               IntegerAttr::get(IntegerType::get(m.getContext(), 32),
+                                groupSize));
+  }
+};
+
+std::unique_ptr<Pass> mlir::triton::createMakePersistentPass(int groupSize,
+                                                            int numXcds) {
+  return std::make_unique<MakePersistentPass>(groupSize, numXcds);
+}
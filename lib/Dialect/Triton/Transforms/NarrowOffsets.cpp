@@ -0,0 +1,430 @@
+#include "mlir/Dialect/SCF/IR/SCF.h"
+#include "mlir/IR/Matchers.h"
+#include "mlir/Interfaces/SideEffectInterfaces.h"
+#include "mlir/Pass/Pass.h"
+#include "triton/Dialect/Triton/IR/Dialect.h"
+#include "triton/Dialect/Triton/Transforms/Passes.h"
+#include "llvm/ADT/SetVector.h"
+#include "llvm/Support/MathExtras.h"
+
+#include <limits>
+#include <memory>
+
+//===----------------------------------------------------------------------===//
+// This pass narrows the 64-bit offsets of `tt.addptr` to 32 bits. Sums,
+// differences, products and bitwise operations only depend on the low 32 bits
+// of their operands for the low 32 bits of their result, so the offset is
+// recomputed in i32 from its 64-bit leaves truncated. The result is the same
+// when the offset fits in 32 bits, which is the case when:
+// - a range analysis of the offset bounds it within i32, or
+// - the pointer is computed from an argument of the function and the
+//   `max-numel` hint, of at most 2^31, says that the pointers computed from
+//   the arguments stay within that many elements of them.
+// Offsets of loads and stores masked out may be wrong since they are never
+// dereferenced.
+//===----------------------------------------------------------------------===//
+
+using namespace mlir;
+
+#define GEN_PASS_CLASSES
+#include "triton/Dialect/Triton/Transforms/Passes.h.inc"
+
+namespace {
+
+constexpr int64_t kMaxInt64 = std::numeric_limits<int64_t>::max();
+constexpr int64_t kMinInt64 = std::numeric_limits<int64_t>::min();
+
+unsigned getIntBitWidth(Value value) {
+  auto intTy = getElementTypeOrSelf(value.getType()).dyn_cast<IntegerType>();
+  return intTy ? intTy.getWidth() : 64;
+}
+
+// The signed interval [min, max] of the values an integer, or the elements
+// of an integer tensor, may take.
+struct Range {
+  int64_t min;
+  int64_t max;
+
+  static Range full(unsigned bitWidth) {
+    if (bitWidth >= 64)
+      return {kMinInt64, kMaxInt64};
+    return {-(int64_t(1) << (bitWidth - 1)),
+            (int64_t(1) << (bitWidth - 1)) - 1};
+  }
+
+  bool fitsIn(unsigned bitWidth) const {
+    Range bounds = full(bitWidth);
+    return min >= bounds.min && max <= bounds.max;
+  }
+
+  bool isNonNegative() const { return min >= 0; }
+
+  Range unionWith(const Range &other) const {
+    return {std::min(min, other.min), std::max(max, other.max)};
+  }
+};
+
+// Computes the ranges of integers from the constants, the program ids and
+// the ranges they are built from. The ranges are computed exactly, a result
+// that does not fit in its type taking the full range of the type since the
+// operation wraps.
+class RangeAnalysis {
+public:
+  Range getRange(Value value) {
+    auto it = ranges.find(value);
+    if (it != ranges.end())
+      return it->second;
+    unsigned bitWidth = getIntBitWidth(value);
+    Range range = Range::full(bitWidth);
+    if (auto computed = computeRange(value))
+      if (computed->fitsIn(bitWidth))
+        range = *computed;
+    ranges.try_emplace(value, range);
+    return range;
+  }
+
+private:
+  std::optional<Range> computeRange(Value value);
+  std::optional<Range> computeBinaryRange(Operation *op, Range lhs,
+                                          Range rhs);
+
+  DenseMap<Value, Range> ranges;
+};
+
+std::optional<Range> getConstantRange(Attribute attr) {
+  if (auto intAttr = attr.dyn_cast<IntegerAttr>()) {
+    int64_t value = intAttr.getValue().getSExtValue();
+    return Range{value, value};
+  }
+  auto denseAttr = attr.dyn_cast<DenseIntElementsAttr>();
+  if (!denseAttr)
+    return std::nullopt;
+  if (denseAttr.isSplat()) {
+    int64_t value = denseAttr.getSplatValue<APInt>().getSExtValue();
+    return Range{value, value};
+  }
+  std::optional<Range> range;
+  for (const APInt &element : denseAttr.getValues<APInt>()) {
+    int64_t value = element.getSExtValue();
+    range = range ? range->unionWith({value, value}) : Range{value, value};
+  }
+  return range;
+}
+
+// Whether `op` moves the elements of its operands around without changing
+// them, as splats, broadcasts and layout conversions do.
+bool isDataMovement(Operation *op) {
+  return op->getNumResults() == 1 && op->getNumOperands() > 0 &&
+         op->getNumRegions() == 0 && !op->hasTrait<OpTrait::Elementwise>() &&
+         op->hasTrait<OpTrait::SameOperandsAndResultElementType>() &&
+         isMemoryEffectFree(op);
+}
+
+std::optional<Range> RangeAnalysis::computeRange(Value value) {
+  if (auto blockArg = value.dyn_cast<BlockArgument>()) {
+    // The induction variable of a loop stays within its bounds
+    auto forOp =
+        dyn_cast_or_null<scf::ForOp>(blockArg.getOwner()->getParentOp());
+    if (!forOp || forOp.getInductionVar() != value)
+      return std::nullopt;
+    Range lb = getRange(forOp.getLowerBound());
+    Range ub = getRange(forOp.getUpperBound());
+    return Range{lb.min, std::max(lb.min, ub.max - 1)};
+  }
+
+  Operation *op = value.getDefiningOp();
+  Attribute constAttr;
+  if (matchPattern(op, m_Constant(&constAttr)))
+    return getConstantRange(constAttr);
+  if (auto makeRange = dyn_cast<triton::MakeRangeOp>(op))
+    return Range{makeRange.getStart(), int64_t(makeRange.getEnd()) - 1};
+  // The grid has at most 2^31 - 1 programs along x and 65535 along y and z
+  if (auto programId = dyn_cast<triton::GetProgramIdOp>(op))
+    return Range{0, programId.getAxisAsInt() == 0 ? (int64_t(1) << 31) - 2
+                                                  : 65534};
+  if (auto numPrograms = dyn_cast<triton::GetNumProgramsOp>(op))
+    return Range{1,
+                 numPrograms.getAxis() == 0 ? (int64_t(1) << 31) - 1 : 65535};
+  if (isDataMovement(op)) {
+    Range range = getRange(op->getOperand(0));
+    for (Value operand : op->getOperands().drop_front())
+      range = range.unionWith(getRange(operand));
+    return range;
+  }
+  if (isa<arith::ExtSIOp>(op))
+    return getRange(op->getOperand(0));
+  if (isa<arith::ExtUIOp>(op)) {
+    Value src = op->getOperand(0);
+    Range range = getRange(src);
+    if (range.isNonNegative())
+      return range;
+    unsigned srcBitWidth = getIntBitWidth(src);
+    if (srcBitWidth >= 64)
+      return std::nullopt;
+    return Range{0, (int64_t(1) << srcBitWidth) - 1};
+  }
+  if (isa<arith::TruncIOp>(op))
+    return getRange(op->getOperand(0));
+  if (auto selectOp = dyn_cast<arith::SelectOp>(op))
+    return getRange(selectOp.getTrueValue())
+        .unionWith(getRange(selectOp.getFalseValue()));
+  if (op->getNumOperands() == 2 && op->getNumResults() == 1)
+    return computeBinaryRange(op, getRange(op->getOperand(0)),
+                              getRange(op->getOperand(1)));
+  return std::nullopt;
+}
+
+std::optional<Range> RangeAnalysis::computeBinaryRange(Operation *op,
+                                                       Range lhs, Range rhs) {
+  // The extrema of a monotonic `fn` over the corners of the operand ranges,
+  // if it does not overflow
+  auto corners =
+      [&](function_ref<bool(int64_t, int64_t, int64_t &)> fn)
+      -> std::optional<Range> {
+    std::optional<Range> range;
+    for (int64_t a : {lhs.min, lhs.max}) {
+      for (int64_t b : {rhs.min, rhs.max}) {
+        int64_t result;
+        if (fn(a, b, result))
+          return std::nullopt;
+        range = range ? range->unionWith({result, result})
+                      : Range{result, result};
+      }
+    }
+    return range;
+  };
+
+  if (isa<arith::AddIOp>(op))
+    return corners([](int64_t a, int64_t b, int64_t &result) {
+      return llvm::AddOverflow(a, b, result);
+    });
+  if (isa<arith::SubIOp>(op))
+    return corners([](int64_t a, int64_t b, int64_t &result) {
+      return llvm::SubOverflow(a, b, result);
+    });
+  if (isa<arith::MulIOp>(op))
+    return corners([](int64_t a, int64_t b, int64_t &result) {
+      return llvm::MulOverflow(a, b, result);
+    });
+  if (isa<arith::MinSIOp>(op))
+    return Range{std::min(lhs.min, rhs.min), std::min(lhs.max, rhs.max)};
+  if (isa<arith::MaxSIOp>(op))
+    return Range{std::max(lhs.min, rhs.min), std::max(lhs.max, rhs.max)};
+  // Unsigned operations match the signed ones on non-negative operands
+  bool isUnsigned = isa<arith::DivUIOp, arith::RemUIOp>(op);
+  if (isUnsigned && !(lhs.isNonNegative() && rhs.isNonNegative()))
+    return std::nullopt;
+  if (isa<arith::DivSIOp, arith::DivUIOp>(op) && rhs.min > 0)
+    return corners([](int64_t a, int64_t b, int64_t &result) {
+      result = a / b;
+      return false;
+    });
+  if (isa<arith::RemSIOp, arith::RemUIOp>(op) && rhs.min > 0) {
+    int64_t maxRem = rhs.max - 1;
+    return Range{lhs.isNonNegative() ? 0 : std::max(lhs.min, -maxRem),
+                 std::max<int64_t>(std::min(lhs.max, maxRem), 0)};
+  }
+  if (isa<arith::AndIOp>(op)) {
+    if (lhs.isNonNegative() && rhs.isNonNegative())
+      return Range{0, std::min(lhs.max, rhs.max)};
+    if (lhs.isNonNegative() || rhs.isNonNegative())
+      return Range{0, lhs.isNonNegative() ? lhs.max : rhs.max};
+    return std::nullopt;
+  }
+  // Shifts by a constant amount
+  if (rhs.min != rhs.max || rhs.min < 0 || rhs.min >= 63)
+    return std::nullopt;
+  int64_t shift = rhs.min;
+  if (isa<arith::ShLIOp>(op))
+    return corners([&](int64_t a, int64_t b, int64_t &result) {
+      return llvm::MulOverflow(a, int64_t(1) << shift, result);
+    });
+  if (isa<arith::ShRSIOp>(op) ||
+      (isa<arith::ShRUIOp>(op) && lhs.isNonNegative()))
+    return Range{lhs.min >> shift, lhs.max >> shift};
+  return std::nullopt;
+}
+
+Type getI32Type(Type type) {
+  auto i32Ty = IntegerType::get(type.getContext(), 32);
+  if (auto tensorTy = type.dyn_cast<RankedTensorType>())
+    return RankedTensorType::get(tensorTy.getShape(), i32Ty,
+                                 tensorTy.getEncoding());
+  return i32Ty;
+}
+
+// Recomputes 64-bit integers in 32 bits, exact in their low 32 bits.
+class OffsetNarrower {
+public:
+  Value narrow(OpBuilder &builder, Value value) {
+    if (getIntBitWidth(value) <= 32)
+      return value;
+    auto it = narrowed.find(value);
+    if (it != narrowed.end())
+      return it->second;
+    OpBuilder::InsertionGuard guard(builder);
+    if (Operation *op = value.getDefiningOp())
+      builder.setInsertionPointAfter(op);
+    else
+      builder.setInsertionPointToStart(
+          value.cast<BlockArgument>().getOwner());
+    Value result = narrowOp(builder, value);
+    narrowed.try_emplace(value, result);
+    return result;
+  }
+
+private:
+  Value narrowOp(OpBuilder &builder, Value value);
+
+  DenseMap<Value, Value> narrowed;
+};
+
+Value OffsetNarrower::narrowOp(OpBuilder &builder, Value value) {
+  Location loc = value.getLoc();
+  Type i32Ty = getI32Type(value.getType());
+  Operation *op = value.getDefiningOp();
+  if (!op)
+    return builder.create<arith::TruncIOp>(loc, i32Ty, value);
+
+  Attribute constAttr;
+  if (matchPattern(op, m_Constant(&constAttr))) {
+    if (auto intAttr = constAttr.dyn_cast<IntegerAttr>())
+      return builder.create<arith::ConstantOp>(
+          loc, IntegerAttr::get(i32Ty, intAttr.getValue().trunc(32)));
+    if (auto denseAttr = constAttr.dyn_cast<DenseIntElementsAttr>()) {
+      auto truncate = [](const APInt &element) { return element.trunc(32); };
+      auto shapedTy = i32Ty.cast<ShapedType>();
+      auto newAttr =
+          denseAttr.isSplat()
+              ? DenseElementsAttr::get(
+                    shapedTy, truncate(denseAttr.getSplatValue<APInt>()))
+              : denseAttr.mapValues(shapedTy.getElementType(), truncate);
+      return builder.create<arith::ConstantOp>(loc, i32Ty, newAttr);
+    }
+  }
+  if (isa<arith::ExtSIOp, arith::ExtUIOp>(op)) {
+    Value src = op->getOperand(0);
+    if (getIntBitWidth(src) == 32)
+      return src;
+    if (getIntBitWidth(src) < 32) {
+      if (isa<arith::ExtSIOp>(op))
+        return builder.create<arith::ExtSIOp>(loc, i32Ty, src);
+      return builder.create<arith::ExtUIOp>(loc, i32Ty, src);
+    }
+  }
+  if (isa<arith::AddIOp, arith::SubIOp, arith::MulIOp, arith::AndIOp,
+          arith::OrIOp, arith::XOrIOp>(op)) {
+    // The overflow flags of the 64-bit operation do not hold in 32 bits
+    Value lhs = narrow(builder, op->getOperand(0));
+    Value rhs = narrow(builder, op->getOperand(1));
+    OperationState state(loc, op->getName());
+    state.addOperands({lhs, rhs});
+    state.addTypes(i32Ty);
+    return builder.create(state)->getResult(0);
+  }
+  if (auto selectOp = dyn_cast<arith::SelectOp>(op))
+    return builder.create<arith::SelectOp>(
+        loc, selectOp.getCondition(),
+        narrow(builder, selectOp.getTrueValue()),
+        narrow(builder, selectOp.getFalseValue()));
+  if (isDataMovement(op)) {
+    SmallVector<Value> operands;
+    for (Value operand : op->getOperands())
+      operands.push_back(narrow(builder, operand));
+    OperationState state(loc, op->getName());
+    state.addOperands(operands);
+    state.addTypes(i32Ty);
+    state.addAttributes(op->getAttrs());
+    return builder.create(state)->getResult(0);
+  }
+  return builder.create<arith::TruncIOp>(loc, i32Ty, value);
+}
+
+// Returns the pointer `ptr` is splat or broadcast from, looking through data
+// movements.
+Value getSourcePointer(Value ptr) {
+  while (Operation *op = ptr.getDefiningOp()) {
+    if (!isDataMovement(op) || op->getNumOperands() != 1)
+      break;
+    ptr = op->getOperand(0);
+  }
+  return ptr;
+}
+
+bool isFunctionArgument(Value value) {
+  auto blockArg = value.dyn_cast<BlockArgument>();
+  return blockArg && blockArg.getOwner()->isEntryBlock() &&
+         isa<triton::FuncOp>(blockArg.getOwner()->getParentOp());
+}
+
+} // anonymous namespace
+
+class NarrowOffsetsPass : public TritonNarrowOffsetsBase<NarrowOffsetsPass> {
+public:
+  explicit NarrowOffsetsPass(int64_t maxNumel) { this->maxNumel = maxNumel; }
+
+  void runOnOperation() override {
+    ModuleOp m = getOperation();
+    SmallVector<triton::AddPtrOp> addPtrOps;
+    m.walk([&](triton::AddPtrOp op) {
+      if (getIntBitWidth(op.getOffset()) > 32)
+        addPtrOps.push_back(op);
+    });
+
+    RangeAnalysis rangeAnalysis;
+    OffsetNarrower narrower;
+    OpBuilder builder(m.getContext());
+    llvm::SetVector<Operation *> maybeDead;
+    bool hasHint = maxNumel > 0 && maxNumel <= (int64_t(1) << 31);
+    for (triton::AddPtrOp op : addPtrOps) {
+      // The offsets from the pointer the chain of addptr starts from
+      Value ptr = op.getPtr();
+      SmallVector<Value> offsets;
+      if (rangeAnalysis.getRange(op.getOffset()).fitsIn(32)) {
+        offsets.push_back(op.getOffset());
+      } else if (hasHint) {
+        offsets.push_back(op.getOffset());
+        while (auto addPtrOp = ptr.getDefiningOp<triton::AddPtrOp>()) {
+          offsets.push_back(addPtrOp.getOffset());
+          ptr = addPtrOp.getPtr();
+        }
+        if (!isFunctionArgument(getSourcePointer(ptr)))
+          continue;
+      } else {
+        continue;
+      }
+
+      builder.setInsertionPoint(op);
+      Value offset;
+      for (Value chainOffset : offsets) {
+        Value narrowed = narrower.narrow(builder, chainOffset);
+        if (getIntBitWidth(narrowed) < 32)
+          narrowed = builder.create<arith::ExtSIOp>(
+              op.getLoc(), getI32Type(narrowed.getType()), narrowed);
+        offset = offset ? builder.create<arith::AddIOp>(op.getLoc(), offset,
+                                                        narrowed)
+                        : narrowed;
+      }
+      for (Value operand : op->getOperands())
+        if (Operation *def = operand.getDefiningOp())
+          maybeDead.insert(def);
+      op->setOperand(0, ptr);
+      op->setOperand(1, offset);
+    }
+
+    // Remove the 64-bit computations left unused
+    while (!maybeDead.empty()) {
+      Operation *op = maybeDead.pop_back_val();
+      if (!isOpTriviallyDead(op))
+        continue;
+      for (Value operand : op->getOperands())
+        if (Operation *def = operand.getDefiningOp())
+          maybeDead.insert(def);
+      op->erase();
+    }
+  }
+};
+
+std::unique_ptr<Pass> mlir::triton::createNarrowOffsetsPass(int64_t maxNumel) {
+  return std::make_unique<NarrowOffsetsPass>(maxNumel);
+}
@@ -0,0 +1,56 @@
+#include "triton/Dialect/Triton/Transforms/ProgramIds.h"
+
+using namespace mlir;
+
+bool triton::canRemapProgramIds(triton::FuncOp funcOp) {
+  if (funcOp.getNumResults() != 0 || !funcOp.getBody().hasOneBlock())
+    return false;
+  auto result =
+      funcOp.walk([](triton::CallOp) { return WalkResult::interrupt(); });
+  return !result.wasInterrupted();
+}
+
+std::array<Value, 3> triton::getProgramIds(OpBuilder &builder, Location loc,
+                                           Value index, ArrayRef<Value> grid,
+                                           int groupSize) {
+  auto cst = [&](int32_t value) -> Value {
+    return builder.create<arith::ConstantIntOp>(loc, value, 32);
+  };
+  Value gridXY = builder.create<arith::MulIOp>(loc, grid[0], grid[1]);
+  Value z = builder.create<arith::DivSIOp>(loc, index, gridXY);
+  Value indexXY = builder.create<arith::RemSIOp>(loc, index, gridXY);
+  if (groupSize <= 0) {
+    Value x = builder.create<arith::RemSIOp>(loc, indexXY, grid[0]);
+    Value y = builder.create<arith::DivSIOp>(loc, indexXY, grid[0]);
+    return {x, y, z};
+  }
+  // The last group may have fewer than `groupSize` ids along x
+  Value numInGroup =
+      builder.create<arith::MulIOp>(loc, cst(groupSize), grid[1]);
+  Value group = builder.create<arith::DivSIOp>(loc, indexXY, numInGroup);
+  Value firstX = builder.create<arith::MulIOp>(loc, group, cst(groupSize));
+  Value sizeX = builder.create<arith::MinSIOp>(
+      loc, builder.create<arith::SubIOp>(loc, grid[0], firstX), cst(groupSize));
+  Value indexInGroup = builder.create<arith::RemSIOp>(loc, indexXY, numInGroup);
+  Value x = builder.create<arith::AddIOp>(
+      loc, firstX, builder.create<arith::RemSIOp>(loc, indexInGroup, sizeX));
+  Value y = builder.create<arith::DivSIOp>(loc, indexInGroup, sizeX);
+  return {x, y, z};
+}
+
+void triton::replaceProgramIds(Operation *op, ArrayRef<Value> programIds,
+                               ArrayRef<Value> grid) {
+  SmallVector<Operation *> replaced;
+  op->walk([&](Operation *nested) {
+    if (auto pidOp = dyn_cast<triton::GetProgramIdOp>(nested)) {
+      pidOp.replaceAllUsesWith(programIds[pidOp.getAxisAsInt()]);
+      replaced.push_back(nested);
+    } else if (auto numProgramsOp =
+                   dyn_cast<triton::GetNumProgramsOp>(nested)) {
+      numProgramsOp.replaceAllUsesWith(grid[numProgramsOp.getAxis()]);
+      replaced.push_back(nested);
+    }
+  });
+  for (Operation *nested : replaced)
+    nested->erase();
+}
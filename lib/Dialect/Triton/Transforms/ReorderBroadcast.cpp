@@ -37,6 +37,28 @@ bool isSplat(Operation *op) {
   return (matchPattern(op, m_Constant(&constAttr)) && constAttr.isSplat());
 }
 
+// Returns `operand`, the result of a broadcast from `shape` or of a splat, as
+// a tensor of `shape`.
+Value getUnbroadcastOperand(PatternRewriter &rewriter, Location loc,
+                            Value operand, ArrayRef<int64_t> shape,
+                            Attribute encoding) {
+  auto definingOp = operand.getDefiningOp();
+  if (auto broadcastSrcOp = llvm::dyn_cast<triton::BroadcastOp>(definingOp))
+    return broadcastSrcOp.getSrc();
+  auto elemTy = operand.getType().dyn_cast<RankedTensorType>().getElementType();
+  auto newTy = RankedTensorType::get(shape, elemTy, encoding);
+  if (auto splatOp = llvm::dyn_cast<triton::SplatOp>(definingOp))
+    return rewriter.create<triton::SplatOp>(loc, newTy, splatOp.getSrc());
+  DenseElementsAttr constAttr;
+  if (matchPattern(definingOp, m_Constant(&constAttr)) &&
+      constAttr.isSplat()) {
+    auto scalarValue = constAttr.getSplatValue<Attribute>();
+    auto splatValue = SplatElementsAttr::get(newTy, scalarValue);
+    return rewriter.create<arith::ConstantOp>(loc, newTy, splatValue);
+  }
+  llvm_unreachable("Expected broadcast or splat");
+}
+
 // elementwise(splat(a), splat(b), ...) => splat(elementwise(a, b, ...))
 struct MoveSplatAfterElementwisePattern
     : public mlir::OpTraitRewritePattern<mlir::OpTrait::Elementwise> {
@@ -160,34 +182,9 @@ struct MoveBroadcastAfterElementwisePattern
 
     // Reshape operands to match srcShape
     llvm::SmallVector<Value, 4> newOperands;
-    for (auto operand : operands) {
-      auto definingOp = operand.getDefiningOp();
-      if (auto broadcastSrcOp =
-              llvm::dyn_cast<triton::BroadcastOp>(definingOp)) {
-        newOperands.push_back(broadcastSrcOp.getSrc());
-        continue;
-      }
-      auto elemTy =
-          operand.getType().dyn_cast<RankedTensorType>().getElementType();
-      auto newTy = RankedTensorType::get(srcShape, elemTy, srcEncoding);
-      if (auto splatOp = llvm::dyn_cast<triton::SplatOp>(definingOp)) {
-        auto newSplat =
-            rewriter.create<triton::SplatOp>(loc, newTy, splatOp.getSrc());
-        newOperands.push_back(newSplat);
-        continue;
-      }
-      DenseElementsAttr constAttr;
-      if (matchPattern(definingOp, m_Constant(&constAttr)) &&
-          constAttr.isSplat()) {
-        auto scalarValue = constAttr.getSplatValue<Attribute>();
-        auto splatValue = SplatElementsAttr::get(newTy, scalarValue);
-        auto newConstant =
-            rewriter.create<arith::ConstantOp>(loc, newTy, splatValue);
-        newOperands.push_back(newConstant);
-        continue;
-      }
-      llvm_unreachable("Expected broadcast or splat");
-    }
+    for (auto operand : operands)
+      newOperands.push_back(
+          getUnbroadcastOperand(rewriter, loc, operand, srcShape, srcEncoding));
 
     // Reshape results to match srcShape
     llvm::SmallVector<Type, 4> newResultTypes;
@@ -209,6 +206,59 @@ struct MoveBroadcastAfterElementwisePattern
   }
 };
 
+// load(broadcast(ptr), broadcast(mask), broadcast(other))
+//   => broadcast(load(ptr, mask, other))
+// The mask and other may also be splat-like. Loading the un-broadcast pointers
+// reads each address once, instead of once per copy.
+struct MoveBroadcastAfterLoadPattern
+    : public mlir::OpRewritePattern<triton::LoadOp> {
+
+  MoveBroadcastAfterLoadPattern(mlir::MLIRContext *context)
+      : OpRewritePattern(context) {}
+
+  mlir::LogicalResult
+  matchAndRewrite(triton::LoadOp loadOp,
+                  mlir::PatternRewriter &rewriter) const override {
+    // Volatile loads must be issued for every element
+    if (loadOp.getIsVolatile())
+      return mlir::failure();
+    auto broadcastOp = loadOp.getPtr().getDefiningOp<triton::BroadcastOp>();
+    if (!broadcastOp)
+      return mlir::failure();
+    auto srcTy = broadcastOp.getSrc().getType().cast<RankedTensorType>();
+    for (Value operand : {loadOp.getMask(), loadOp.getOther()}) {
+      if (!operand)
+        continue;
+      auto definingOp = operand.getDefiningOp();
+      if (!definingOp)
+        return mlir::failure();
+      if (auto operandBroadcast =
+              llvm::dyn_cast<triton::BroadcastOp>(definingOp)) {
+        auto operandSrcTy =
+            operandBroadcast.getSrc().getType().cast<RankedTensorType>();
+        if (operandSrcTy.getShape() != srcTy.getShape())
+          return mlir::failure();
+      } else if (!isSplat(definingOp)) {
+        return mlir::failure();
+      }
+    }
+
+    auto loc = loadOp.getLoc();
+    llvm::SmallVector<Value, 4> newOperands;
+    for (auto operand : loadOp->getOperands())
+      newOperands.push_back(getUnbroadcastOperand(
+          rewriter, loc, operand, srcTy.getShape(), srcTy.getEncoding()));
+    auto resultTy = loadOp.getType().cast<RankedTensorType>();
+    Type newResultTy = RankedTensorType::get(
+        srcTy.getShape(), resultTy.getElementType(), srcTy.getEncoding());
+    auto newLoad = cloneWithNewArgsAndResultTypes(rewriter, loadOp, newOperands,
+                                                  newResultTy);
+    rewriter.replaceOpWithNewOp<triton::BroadcastOp>(loadOp, resultTy,
+                                                     newLoad->getResult(0));
+    return mlir::success();
+  }
+};
+
 template <typename OpType>
 class CanonicalizePattern : public mlir::OpRewritePattern<OpType> {
 public:
@@ -235,6 +285,8 @@ public:
     patterns.add<MoveBroadcastAfterElementwisePattern>(context);
     // elementwise(splat(a), splat(b), ...) => splat(elementwise(a, b, ...))
     patterns.add<MoveSplatAfterElementwisePattern>(context);
+    // load(broadcast(ptr), ...) => broadcast(load(ptr, ...))
+    patterns.add<MoveBroadcastAfterLoadPattern>(context);
 
     if (applyPatternsAndFoldGreedily(m, std::move(patterns)).failed())
       signalPassFailure();
@@ -0,0 +1,130 @@
+#include "mlir/IR/SymbolTable.h"
+#include "mlir/Pass/Pass.h"
+#include "triton/Analysis/AxisInfo.h"
+#include "triton/Dialect/Triton/IR/Dialect.h"
+#include "triton/Dialect/Triton/Transforms/Passes.h"
+
+#include <memory>
+
+//===----------------------------------------------------------------------===//
+// This pass clones the `noinline` functions that are called with arguments of
+// different AxisInfo, so that each call site reaches a function that is only
+// called with arguments like its own. The AxisInfo of the arguments of a
+// function is the join of that of all its call sites, so a helper called with
+// both aligned and unaligned pointers would otherwise only get scalar loads
+// and stores, whichever the call.
+//===----------------------------------------------------------------------===//
+
+using namespace mlir;
+
+#define GEN_PASS_CLASSES
+#include "triton/Dialect/Triton/Transforms/Passes.h.inc"
+
+namespace {
+
+constexpr StringLiteral kAxisInfoAttrNames[] = {
+    "tt.contiguity", "tt.divisibility", "tt.constancy"};
+
+// The AxisInfo of the arguments of a call, as set on the arguments of the
+// callee by ModuleAxisInfoAnalysis
+typedef SmallVector<int64_t> SignatureT;
+
+bool isNoInline(triton::FuncOp funcOp) {
+  auto attr = funcOp->getAttrOfType<BoolAttr>("noinline");
+  return attr && attr.getValue();
+}
+
+std::optional<SignatureT> getSignature(triton::CallOp callOp,
+                                       ModuleAxisInfoAnalysis &analysis) {
+  SignatureT signature;
+  for (Value operand : callOp.getOperands()) {
+    AxisInfo *axisInfo = analysis.getAxisInfo(operand);
+    if (!axisInfo || axisInfo->getRank() != 1)
+      return std::nullopt;
+    signature.push_back(axisInfo->getContiguity(0));
+    signature.push_back(axisInfo->getDivisibility(0));
+    signature.push_back(axisInfo->getConstancy(0));
+  }
+  return signature;
+}
+
+} // anonymous namespace
+
+class SpecializeCallsPass
+    : public TritonSpecializeCallsBase<SpecializeCallsPass> {
+public:
+  explicit SpecializeCallsPass(int maxClones) { this->maxClones = maxClones; }
+
+  void runOnOperation() override {
+    ModuleOp m = getOperation();
+    SymbolTable symbolTable(m);
+    // The function each clone was made from, and the number of its clones
+    DenseMap<Operation *, triton::FuncOp> origins;
+    DenseMap<Operation *, int> numClones;
+
+    // Cloning the callers of a function gives it new call sites, so repeat
+    // until every group of call sites reaches its own function, or the
+    // functions are out of clones.
+    bool changed = true;
+    while (changed) {
+      changed = false;
+      MapVector<triton::FuncOp, SmallVector<triton::CallOp>> callSites;
+      m.walk([&](triton::CallOp callOp) {
+        auto callee = symbolTable.lookup<triton::FuncOp>(callOp.getCallee());
+        if (callee && isNoInline(callee))
+          callSites[callee].push_back(callOp);
+      });
+      // The analysis joins the AxisInfo of the call sites into the argument
+      // attributes of the callees, so drop the ones left by the previous
+      // iteration, which may have had other call sites.
+      for (auto &[callee, calls] : callSites)
+        for (unsigned i = 0; i < callee.getNumArguments(); ++i)
+          for (StringRef name : kAxisInfoAttrNames)
+            callee.removeArgAttr(i, name);
+      ModuleAxisInfoAnalysis analysis(m);
+
+      for (auto &[callee, calls] : callSites) {
+        // Groups of call sites of the same signature, in the order of the
+        // first call of each. The first group keeps calling `callee`.
+        SmallVector<std::pair<SignatureT, SmallVector<triton::CallOp>>> groups;
+        bool isKnown = true;
+        for (triton::CallOp callOp : calls) {
+          auto signature = getSignature(callOp, analysis);
+          if (!signature) {
+            isKnown = false;
+            break;
+          }
+          auto it = llvm::find_if(
+              groups, [&](auto &group) { return group.first == *signature; });
+          if (it == groups.end())
+            groups.push_back({*signature, {callOp}});
+          else
+            it->second.push_back(callOp);
+        }
+        if (!isKnown)
+          continue;
+        triton::FuncOp origin = origins.lookup(callee);
+        if (!origin)
+          origin = callee;
+        Operation *insertAfter = callee;
+        for (auto &group : llvm::drop_begin(groups)) {
+          if (numClones[origin] >= maxClones)
+            break;
+          auto clone = callee.clone();
+          clone.setName(
+              (origin.getName() + "__" + Twine(++numClones[origin])).str());
+          symbolTable.insert(clone, std::next(insertAfter->getIterator()));
+          insertAfter = clone;
+          origins[clone] = origin;
+          for (triton::CallOp callOp : group.second)
+            callOp.setCalleeFromCallable(SymbolRefAttr::get(clone));
+          changed = true;
+        }
+      }
+    }
+  }
+};
+
+std::unique_ptr<Pass> mlir::triton::createSpecializeCallsPass(int maxClones) {
+  return std::make_unique<SpecializeCallsPass>(maxClones);
+}
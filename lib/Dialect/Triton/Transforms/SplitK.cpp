@@ -0,0 +1,241 @@
+#include "mlir/Dialect/SCF/IR/SCF.h"
+#include "mlir/IR/Matchers.h"
+#include "mlir/IR/TypeUtilities.h"
+#include "mlir/Pass/Pass.h"
+#include "triton/Dialect/Triton/IR/Dialect.h"
+#include "triton/Dialect/Triton/Transforms/Passes.h"
+
+#include <memory>
+
+//===----------------------------------------------------------------------===//
+// This pass splits the reduction loop of a matmul kernel across the programs
+// of a new grid dimension. Each program runs a contiguous share of the
+// iterations and atomically adds its partial accumulator to the output, so
+// skinny GEMMs with a long K loop fill the GPU without rewriting the kernel.
+//
+// The loop must accumulate a tt.dot from zero, only carry pointers advanced
+// by loop-invariant offsets besides, and its accumulator must only be cast
+// and stored. The launcher multiplies the third dimension of the grid by the
+// factor recorded in the `tt.split_k` module attribute.
+//===----------------------------------------------------------------------===//
+
+using namespace mlir;
+
+#define GEN_PASS_CLASSES
+#include "triton/Dialect/Triton/Transforms/Passes.h.inc"
+
+namespace {
+
+bool isZero(Value value) {
+  return matchPattern(value, m_Zero()) || matchPattern(value, m_AnyZeroFloat());
+}
+
+std::optional<triton::RMWOp> getAtomicAdd(Type elementType) {
+  if (elementType.isF32() || elementType.isF16())
+    return triton::RMWOp::FADD;
+  if (elementType.isInteger(32))
+    return triton::RMWOp::ADD;
+  return std::nullopt;
+}
+
+// Collects the stores `value` reaches through casts, which commute with the
+// sum of the partial accumulators up to rounding. Fails on any other use.
+bool collectStores(Value value, SmallVector<triton::StoreOp> &stores) {
+  for (OpOperand &use : value.getUses()) {
+    Operation *user = use.getOwner();
+    if (auto storeOp = dyn_cast<triton::StoreOp>(user)) {
+      auto boundaryCheck = storeOp.getBoundaryCheck();
+      if (use.get() != storeOp.getValue() ||
+          triton::isTensorPointerType(storeOp.getPtr().getType()) ||
+          (boundaryCheck && !boundaryCheck->empty()) ||
+          !getAtomicAdd(getElementTypeOrSelf(storeOp.getValue().getType())))
+        return false;
+      stores.push_back(storeOp);
+      continue;
+    }
+    if (!isa<arith::TruncFOp, arith::ExtFOp, triton::FpToFpOp>(user) ||
+        !collectStores(user->getResult(0), stores))
+      return false;
+  }
+  return true;
+}
+
+// Whether the iteration argument `arg` only moves by a loop-invariant step.
+bool isInductionPointer(scf::ForOp forOp, BlockArgument arg, Value next) {
+  if (next == arg)
+    return true;
+  if (auto addPtrOp = next.getDefiningOp<triton::AddPtrOp>())
+    return addPtrOp.getPtr() == arg &&
+           forOp.isDefinedOutsideOfLoop(addPtrOp.getOffset());
+  if (auto advanceOp = next.getDefiningOp<triton::AdvanceOp>())
+    return advanceOp.getPtr() == arg &&
+           llvm::all_of(advanceOp.getOffsets(), [&](Value offset) {
+             return forOp.isDefinedOutsideOfLoop(offset);
+           });
+  return false;
+}
+
+// Returns the indices of the accumulators of `forOp`, or an empty list if the
+// loop can't be split.
+SmallVector<unsigned> getAccumulators(scf::ForOp forOp) {
+  SmallVector<unsigned> accumulators;
+  auto yieldOp = cast<scf::YieldOp>(forOp.getBody()->getTerminator());
+  for (auto [i, arg] : llvm::enumerate(forOp.getRegionIterArgs())) {
+    Value next = yieldOp.getOperand(i);
+    if (auto dotOp = next.getDefiningOp<triton::DotOp>();
+        dotOp && dotOp.getC() == arg && arg.hasOneUse() && next.hasOneUse() &&
+        isZero(forOp.getTiedLoopInit(arg)->get())) {
+      accumulators.push_back(i);
+      continue;
+    }
+    if (!isInductionPointer(forOp, arg, next) ||
+        !forOp.getResult(i).use_empty())
+      return {};
+  }
+  return accumulators;
+}
+
+// Casts the integer `value` to the type of `type`, splatted if it's a tensor.
+Value castTo(OpBuilder &builder, Location loc, Value value, Type type) {
+  Type elementType = getElementTypeOrSelf(type);
+  if (elementType.isIndex())
+    value = builder.create<arith::IndexCastOp>(loc, elementType, value);
+  else if (value.getType().isIndex())
+    value = builder.create<arith::IndexCastOp>(loc, elementType, value);
+  else if (elementType.getIntOrFloatBitWidth() >
+           value.getType().getIntOrFloatBitWidth())
+    value = builder.create<arith::ExtSIOp>(loc, elementType, value);
+  else if (elementType.getIntOrFloatBitWidth() <
+           value.getType().getIntOrFloatBitWidth())
+    value = builder.create<arith::TruncIOp>(loc, elementType, value);
+  if (isa<RankedTensorType>(type))
+    value = builder.create<triton::SplatOp>(loc, type, value);
+  return value;
+}
+
+void splitLoop(scf::ForOp forOp, ArrayRef<triton::StoreOp> stores,
+               int splitK) {
+  OpBuilder builder(forOp);
+  Location loc = forOp.getLoc();
+  Value lb = forOp.getLowerBound();
+  Value ub = forOp.getUpperBound();
+  Value step = forOp.getStep();
+  Type type = lb.getType();
+
+  // Program `z` runs iterations [z * perSplit, (z + 1) * perSplit)
+  Value pid = builder.create<triton::GetProgramIdOp>(
+      loc, builder.getI32Type(),
+      triton::ProgramIDDimAttr::get(builder.getContext(),
+                                    triton::ProgramIDDim::Z));
+  Value numIters = builder.create<arith::CeilDivSIOp>(
+      loc, builder.create<arith::SubIOp>(loc, ub, lb), step);
+  Value numSplits = builder.create<arith::ConstantOp>(
+      loc, builder.getIntegerAttr(type, splitK));
+  Value perSplit =
+      builder.create<arith::CeilDivSIOp>(loc, numIters, numSplits);
+  Value skipped = builder.create<arith::MulIOp>(
+      loc, castTo(builder, loc, pid, type), perSplit);
+  Value newLb = builder.create<arith::AddIOp>(
+      loc, lb, builder.create<arith::MulIOp>(loc, skipped, step));
+  Value newUb = builder.create<arith::MinSIOp>(
+      loc, ub,
+      builder.create<arith::AddIOp>(
+          loc, newLb, builder.create<arith::MulIOp>(loc, perSplit, step)));
+  forOp.setLowerBound(newLb);
+  forOp.setUpperBound(newUb);
+
+  // Move the pointers to the first iteration of the program
+  auto yieldOp = cast<scf::YieldOp>(forOp.getBody()->getTerminator());
+  for (auto [i, arg] : llvm::enumerate(forOp.getRegionIterArgs())) {
+    OpOperand *init = forOp.getTiedLoopInit(arg);
+    Value next = yieldOp.getOperand(i);
+    if (auto addPtrOp = next.getDefiningOp<triton::AddPtrOp>()) {
+      Value offset = addPtrOp.getOffset();
+      Value skippedOffset = builder.create<arith::MulIOp>(
+          loc, offset, castTo(builder, loc, skipped, offset.getType()));
+      init->set(builder.create<triton::AddPtrOp>(loc, init->get().getType(),
+                                                 init->get(), skippedOffset));
+    } else if (auto advanceOp = next.getDefiningOp<triton::AdvanceOp>()) {
+      Value skippedI32 = castTo(builder, loc, skipped, builder.getI32Type());
+      SmallVector<Value> offsets;
+      for (Value offset : advanceOp.getOffsets())
+        offsets.push_back(
+            builder.create<arith::MulIOp>(loc, offset, skippedI32));
+      init->set(builder.create<triton::AdvanceOp>(
+          loc, init->get().getType(), init->get(), offsets));
+    }
+  }
+
+  // Add the partial accumulators to the output
+  for (triton::StoreOp storeOp : stores) {
+    builder.setInsertionPoint(storeOp);
+    Value value = storeOp.getValue();
+    auto rmwOp = getAtomicAdd(getElementTypeOrSelf(value.getType()));
+    builder.create<triton::AtomicRMWOp>(
+        storeOp.getLoc(), value.getType(), *rmwOp, storeOp.getPtr(), value,
+        storeOp.getMask(), triton::MemSemantic::RELAXED,
+        triton::MemSyncScope::GPU);
+    storeOp.erase();
+  }
+}
+
+// Whether the programs of a split kernel neither tell each other apart nor
+// run side effects that don't bear being repeated.
+bool isSplittable(triton::FuncOp funcOp) {
+  auto result = funcOp.walk([](Operation *op) {
+    if (auto pidOp = dyn_cast<triton::GetProgramIdOp>(op))
+      if (pidOp.getAxis() == triton::ProgramIDDim::Z)
+        return WalkResult::interrupt();
+    if (auto numOp = dyn_cast<triton::GetNumProgramsOp>(op))
+      if (numOp.getAxis() == 2)
+        return WalkResult::interrupt();
+    if (isa<triton::CallOp, triton::AtomicRMWOp, triton::AtomicCASOp>(op))
+      return WalkResult::interrupt();
+    return WalkResult::advance();
+  });
+  return !result.wasInterrupted();
+}
+
+} // anonymous namespace
+
+class SplitKPass : public TritonSplitKBase<SplitKPass> {
+public:
+  explicit SplitKPass(int splitK) { this->splitK = splitK; }
+
+  void runOnOperation() override {
+    ModuleOp m = getOperation();
+    if (splitK <= 1)
+      return;
+    bool changed = false;
+    for (auto funcOp : m.getOps<triton::FuncOp>()) {
+      if (!funcOp.isPublic() || !isSplittable(funcOp))
+        continue;
+      // Only the reduction loop of the kernel is split: with several
+      // candidates, the programs of a split would redo the others.
+      SmallVector<scf::ForOp> loops;
+      funcOp.walk([&](scf::ForOp forOp) { loops.push_back(forOp); });
+      if (loops.size() != 1 ||
+          loops.front()->getParentOp() != funcOp.getOperation())
+        continue;
+      scf::ForOp forOp = loops.front();
+      SmallVector<unsigned> accumulators = getAccumulators(forOp);
+      if (accumulators.empty())
+        continue;
+      SmallVector<triton::StoreOp> stores;
+      if (!llvm::all_of(accumulators, [&](unsigned i) {
+            return collectStores(forOp.getResult(i), stores);
+          }))
+        continue;
+      splitLoop(forOp, stores, splitK);
+      changed = true;
+    }
+    if (changed)
+      m->setAttr("tt.split_k",
+                 IntegerAttr::get(IntegerType::get(m.getContext(), 32),
+                                  splitK));
+  }
+};
+
+std::unique_ptr<Pass> mlir::triton::createSplitKPass(int splitK) {
+  return std::make_unique<SplitKPass>(splitK);
+}
@@ -0,0 +1,295 @@
+#include "mlir/Dialect/SCF/IR/SCF.h"
+#include "mlir/IR/Matchers.h"
+#include "mlir/IR/TypeUtilities.h"
+#include "mlir/Interfaces/SideEffectInterfaces.h"
+#include "mlir/Pass/Pass.h"
+#include "triton/Dialect/Triton/IR/Dialect.h"
+#include "triton/Dialect/Triton/Transforms/Passes.h"
+#include "llvm/ADT/SetVector.h"
+
+#include <memory>
+
+//===----------------------------------------------------------------------===//
+// This pass turns the pointers a loop recomputes from its induction variable,
+// as in `ptr + (k * BLOCK_K + offs_k)[:, None] * stride`, into pointers
+// carried by the loop and advanced by a splat of `step * BLOCK_K * stride`
+// every iteration. The offset must be the sum of a loop-invariant tensor and
+// of the induction variable times a uniform factor, built from additions,
+// subtractions, multiplications by uniform values, splats, broadcasts and
+// expand_dims. The increment being a splat, AxisInfo keeps the contiguity of
+// the pointers across iterations, and the loop takes the form the pipeliner
+// and the split-K pass expect.
+//
+// The addresses are the same unless the 32-bit offsets of the original loop
+// overflow.
+//===----------------------------------------------------------------------===//
+
+using namespace mlir;
+
+#define GEN_PASS_CLASSES
+#include "triton/Dialect/Triton/Transforms/Passes.h.inc"
+
+namespace {
+
+// `base + iv * factor`, where `base` (0 if null) is a value of the type of
+// the offset and `factor` (0 if null) a scalar, both defined before the loop.
+struct AffineOffset {
+  Value base;
+  Value factor;
+};
+
+class AffineOffsetBuilder {
+public:
+  AffineOffsetBuilder(scf::ForOp forOp) : forOp(forOp), builder(forOp) {}
+
+  // Whether `value` is an affine function of the induction variable that
+  // `build` can rebuild before the loop.
+  bool isAffine(Value value) {
+    if (forOp.isDefinedOutsideOfLoop(value) ||
+        value == forOp.getInductionVar())
+      return true;
+    Operation *op = value.getDefiningOp();
+    if (!op || !isMemoryEffectFree(op))
+      return false;
+    if (isa<arith::AddIOp, arith::SubIOp>(op))
+      return isAffine(op->getOperand(0)) && isAffine(op->getOperand(1));
+    if (isa<arith::MulIOp>(op))
+      return (isInvariantUniform(op->getOperand(0)) &&
+              isAffine(op->getOperand(1))) ||
+             (isInvariantUniform(op->getOperand(1)) &&
+              isAffine(op->getOperand(0)));
+    if (isa<triton::SplatOp, triton::BroadcastOp, triton::ExpandDimsOp>(op))
+      return isAffine(op->getOperand(0));
+    return false;
+  }
+
+  // Rebuilds the affine function `value` of the induction variable before
+  // the loop.
+  AffineOffset build(Value value) {
+    if (forOp.isDefinedOutsideOfLoop(value))
+      return {value, nullptr};
+    Value iv = forOp.getInductionVar();
+    Location loc = value.getLoc();
+    if (value == iv)
+      return {nullptr, builder.create<arith::ConstantOp>(
+                           loc, builder.getIntegerAttr(iv.getType(), 1))};
+    Operation *op = value.getDefiningOp();
+    if (isa<arith::AddIOp>(op)) {
+      AffineOffset lhs = build(op->getOperand(0));
+      AffineOffset rhs = build(op->getOperand(1));
+      return {add(loc, lhs.base, rhs.base), add(loc, lhs.factor, rhs.factor)};
+    }
+    if (isa<arith::SubIOp>(op)) {
+      AffineOffset lhs = build(op->getOperand(0));
+      AffineOffset rhs = build(op->getOperand(1));
+      return {sub(loc, lhs.base, rhs.base), sub(loc, lhs.factor, rhs.factor)};
+    }
+    if (isa<arith::MulIOp>(op)) {
+      Value lhs = op->getOperand(0);
+      Value rhs = op->getOperand(1);
+      if (!isInvariantUniform(lhs) || !isAffine(rhs))
+        std::swap(lhs, rhs);
+      AffineOffset affine = build(rhs);
+      return {mul(loc, lhs, affine.base),
+              mul(loc, getUniformScalar(lhs), affine.factor)};
+    }
+    // Splats, broadcasts and expand_dims of the base, the factor is uniform
+    AffineOffset src = build(op->getOperand(0));
+    if (!src.base)
+      return {nullptr, src.factor};
+    OperationState state(loc, op->getName());
+    state.addOperands(src.base);
+    state.addTypes(value.getType());
+    state.addAttributes(op->getAttrs());
+    return {builder.create(state)->getResult(0), src.factor};
+  }
+
+  // Returns `base + splat(scalar * factor)` of the type of `type`.
+  Value getOffsetAt(Location loc, const AffineOffset &affine, Value scalar,
+                    Type type) {
+    Value offset = mul(loc, scalar, affine.factor);
+    if (offset && isa<RankedTensorType>(type))
+      offset = builder.create<triton::SplatOp>(loc, type, offset);
+    if (!offset && !affine.base)
+      return builder.create<arith::ConstantOp>(loc, builder.getZeroAttr(type));
+    return add(loc, affine.base, offset);
+  }
+
+private:
+  // Whether `value` is defined before the loop and has the same value in all
+  // its elements.
+  bool isInvariantUniform(Value value) {
+    if (!forOp.isDefinedOutsideOfLoop(value))
+      return false;
+    if (!isa<RankedTensorType>(value.getType()))
+      return true;
+    DenseElementsAttr constAttr;
+    if (matchPattern(value, m_Constant(&constAttr)))
+      return constAttr.isSplat();
+    Operation *op = value.getDefiningOp();
+    if (isa_and_nonnull<triton::SplatOp>(op))
+      return true;
+    if (isa_and_nonnull<triton::BroadcastOp, triton::ExpandDimsOp>(op))
+      return isInvariantUniform(op->getOperand(0));
+    return false;
+  }
+
+  // Returns the scalar all the elements of `value` are equal to.
+  Value getUniformScalar(Value value) {
+    if (!isa<RankedTensorType>(value.getType()))
+      return value;
+    DenseElementsAttr constAttr;
+    if (matchPattern(value, m_Constant(&constAttr)))
+      return builder.create<arith::ConstantOp>(
+          value.getLoc(),
+          constAttr.getSplatValue<Attribute>().cast<TypedAttr>());
+    Operation *op = value.getDefiningOp();
+    if (isa<triton::SplatOp>(op))
+      return op->getOperand(0);
+    return getUniformScalar(op->getOperand(0));
+  }
+
+  Value add(Location loc, Value lhs, Value rhs) {
+    if (!lhs || !rhs)
+      return lhs ? lhs : rhs;
+    return builder.create<arith::AddIOp>(loc, lhs, rhs);
+  }
+
+  Value sub(Location loc, Value lhs, Value rhs) {
+    if (!rhs)
+      return lhs;
+    if (!lhs)
+      lhs = builder.create<arith::ConstantOp>(loc, builder.getZeroAttr(
+                                                       rhs.getType()));
+    return builder.create<arith::SubIOp>(loc, lhs, rhs);
+  }
+
+  Value mul(Location loc, Value lhs, Value rhs) {
+    if (!lhs || !rhs)
+      return nullptr;
+    return builder.create<arith::MulIOp>(loc, lhs, rhs);
+  }
+
+  scf::ForOp forOp;
+  OpBuilder builder;
+};
+
+// Returns `forOp` with additional iteration arguments starting from
+// `newInitArgs`, the body of `forOp` moved to it.
+scf::ForOp appendIterArgs(OpBuilder &builder, scf::ForOp forOp,
+                          ValueRange newInitArgs) {
+  auto initArgs = llvm::to_vector(forOp.getInitArgs());
+  initArgs.append(newInitArgs.begin(), newInitArgs.end());
+  builder.setInsertionPoint(forOp);
+  auto newForOp = builder.create<scf::ForOp>(
+      forOp.getLoc(), forOp.getLowerBound(), forOp.getUpperBound(),
+      forOp.getStep(), initArgs);
+  newForOp.getBody()->erase();
+  newForOp.getRegion().getBlocks().splice(
+      newForOp.getRegion().getBlocks().begin(),
+      forOp.getRegion().getBlocks());
+  for (Value initArg : newInitArgs)
+    newForOp.getBody()->addArgument(initArg.getType(), initArg.getLoc());
+  forOp->replaceAllUsesWith(
+      newForOp.getResults().take_front(forOp.getNumResults()));
+  forOp.erase();
+  return newForOp;
+}
+
+void strengthReducePointers(scf::ForOp forOp) {
+  Value iv = forOp.getInductionVar();
+  if (!iv.getType().isa<IntegerType>())
+    return;
+  AffineOffsetBuilder affineBuilder(forOp);
+  SmallVector<triton::AddPtrOp> addPtrOps;
+  for (auto addPtrOp : forOp.getBody()->getOps<triton::AddPtrOp>()) {
+    Value offset = addPtrOp.getOffset();
+    if (forOp.isDefinedOutsideOfLoop(addPtrOp.getPtr()) &&
+        !forOp.isDefinedOutsideOfLoop(offset) &&
+        getElementTypeOrSelf(offset.getType()) == iv.getType() &&
+        affineBuilder.isAffine(offset))
+      addPtrOps.push_back(addPtrOp);
+  }
+  if (addPtrOps.empty())
+    return;
+
+  // The pointers at the first iteration and their increments
+  SmallVector<Value> initPtrs;
+  SmallVector<Value> increments;
+  for (triton::AddPtrOp addPtrOp : addPtrOps) {
+    Location loc = addPtrOp.getLoc();
+    Value offset = addPtrOp.getOffset();
+    AffineOffset affine = affineBuilder.build(offset);
+    if (!affine.factor) {
+      // The induction variable cancels out, the offset is loop-invariant
+      initPtrs.push_back(nullptr);
+      increments.push_back(affineBuilder.getOffsetAt(
+          loc, affine, forOp.getLowerBound(), offset.getType()));
+      continue;
+    }
+    Value initOffset = affineBuilder.getOffsetAt(
+        loc, affine, forOp.getLowerBound(), offset.getType());
+    OpBuilder builder(forOp);
+    initPtrs.push_back(builder.create<triton::AddPtrOp>(
+        loc, addPtrOp.getType(), addPtrOp.getPtr(), initOffset));
+    increments.push_back(affineBuilder.getOffsetAt(
+        loc, {nullptr, affine.factor}, forOp.getStep(), offset.getType()));
+  }
+
+  SmallVector<Value> newInitArgs;
+  for (Value initPtr : initPtrs)
+    if (initPtr)
+      newInitArgs.push_back(initPtr);
+  OpBuilder builder(forOp);
+  unsigned firstNewArg = forOp.getNumRegionIterArgs();
+  scf::ForOp newForOp = appendIterArgs(builder, forOp, newInitArgs);
+
+  auto yieldOp = cast<scf::YieldOp>(newForOp.getBody()->getTerminator());
+  builder.setInsertionPoint(yieldOp);
+  llvm::SetVector<Operation *> maybeDead;
+  SmallVector<Value> nextPtrs;
+  unsigned argIdx = firstNewArg;
+  for (auto [addPtrOp, initPtr, increment] :
+       llvm::zip(addPtrOps, initPtrs, increments)) {
+    if (Operation *def = addPtrOp.getOffset().getDefiningOp())
+      maybeDead.insert(def);
+    if (!initPtr) {
+      addPtrOp->setOperand(1, increment);
+      continue;
+    }
+    Value ptr = newForOp.getRegionIterArgs()[argIdx++];
+    addPtrOp.getResult().replaceAllUsesWith(ptr);
+    addPtrOp.erase();
+    nextPtrs.push_back(builder.create<triton::AddPtrOp>(
+        yieldOp.getLoc(), ptr.getType(), ptr, increment));
+  }
+  yieldOp->insertOperands(yieldOp->getNumOperands(), nextPtrs);
+
+  // Remove the recomputations of the offsets
+  while (!maybeDead.empty()) {
+    Operation *op = maybeDead.pop_back_val();
+    if (!isOpTriviallyDead(op))
+      continue;
+    for (Value operand : op->getOperands())
+      if (Operation *def = operand.getDefiningOp())
+        maybeDead.insert(def);
+    op->erase();
+  }
+}
+
+} // anonymous namespace
+
+class StrengthReducePointersPass
+    : public TritonStrengthReducePointersBase<StrengthReducePointersPass> {
+public:
+  void runOnOperation() override {
+    SmallVector<scf::ForOp> forOps;
+    getOperation().walk([&](scf::ForOp forOp) { forOps.push_back(forOp); });
+    for (scf::ForOp forOp : forOps)
+      strengthReducePointers(forOp);
+  }
+};
+
+std::unique_ptr<Pass> mlir::triton::createStrengthReducePointersPass() {
+  return std::make_unique<StrengthReducePointersPass>();
+}
@@ -37,6 +37,14 @@ namespace gpu {
 // so that all distributed layouts implement
 // these utilities
 
+// The properties of the blocked layouts are read from their parameters, the
+// others are derived once per layout (and shape) and memoized in the dialect.
+static LayoutCache &getLayoutCache(Attribute layout) {
+  return layout.getContext()
+      ->getLoadedDialect<TritonGPUDialect>()
+      ->getLayoutCache();
+}
+
 unsigned getTotalElemsPerThread(Attribute layout, ArrayRef<int64_t> shape,
                                 Type eltTy) {
   if (auto tritonGPUAttr = layout.dyn_cast<TritonGPU_AttrTrait>()) {
@@ -147,8 +155,13 @@ getWarpsPerCTAWithUniqueData(Attribute layout, ArrayRef<int64_t> tensorShape) {
 }
 
 SmallVector<unsigned> getSizePerThread(Attribute layout) {
-  if (auto distributedLayout = layout.dyn_cast<DistributedEncodingTrait>()) {
-    return distributedLayout.getSizePerThread();
+  if (auto blockedLayout = layout.dyn_cast<BlockedEncodingAttr>()) {
+    return blockedLayout.getSizePerThread();
+  } else if (auto distributedLayout =
+                 layout.dyn_cast<DistributedEncodingTrait>()) {
+    return getLayoutCache(layout).get(
+        LayoutCache::Query::SizePerThread, layout, {},
+        [&] { return distributedLayout.getSizePerThread(); });
   } else {
     llvm::report_fatal_error("getSizePerThread not implemented");
     return {};
@@ -156,14 +169,18 @@ SmallVector<unsigned> getSizePerThread(Attribute layout) {
 }
 
 SmallVector<unsigned> getContigPerThread(Attribute layout) {
+  if (auto sliceLayout = layout.dyn_cast<SliceEncodingAttr>()) {
+    return getLayoutCache(layout).get(
+        LayoutCache::Query::ContigPerThread, layout, {},
+        [&] { return getContigPerThread(sliceLayout.getParent()); });
+  }
   if (auto mmaLayout = layout.dyn_cast<NvidiaMmaEncodingAttr>()) {
     assert(mmaLayout.isVolta() || mmaLayout.isAmpere() || mmaLayout.isHopper());
-    return {1, 2};
+    SmallVector<unsigned> contigPerThread(mmaLayout.getWarpsPerCTA().size(), 1);
+    contigPerThread.back() = 2;
+    return contigPerThread;
   } else if (layout.isa<MfmaEncodingAttr>()) {
     return {1, 1};
-  } else if (auto sliceLayout = layout.dyn_cast<SliceEncodingAttr>()) {
-    auto parentLayout = sliceLayout.getParent();
-    return getContigPerThread(parentLayout);
   } else {
     return getSizePerThread(layout);
   }
@@ -174,13 +191,16 @@ SmallVector<unsigned> getUniqueContigPerThread(Attribute layout,
   // If slice layout, call recursively on parent layout, and drop
   // sliced dim
   if (auto sliceLayout = layout.dyn_cast<SliceEncodingAttr>()) {
-    auto parentLayout = sliceLayout.getParent();
-    auto parentShape = sliceLayout.paddedShape(shape);
-    auto parentUniqueContigPerThread =
-        getUniqueContigPerThread(parentLayout, parentShape);
-    parentUniqueContigPerThread.erase(parentUniqueContigPerThread.begin() +
-                                      sliceLayout.getDim());
-    return parentUniqueContigPerThread;
+    return getLayoutCache(layout).get(
+        LayoutCache::Query::UniqueContigPerThread, layout, shape, [&] {
+          auto parentLayout = sliceLayout.getParent();
+          auto parentShape = sliceLayout.paddedShape(shape);
+          auto parentUniqueContigPerThread =
+              getUniqueContigPerThread(parentLayout, parentShape);
+          parentUniqueContigPerThread.erase(
+              parentUniqueContigPerThread.begin() + sliceLayout.getDim());
+          return parentUniqueContigPerThread;
+        });
   }
   // Base case
   auto rank = shape.size();
@@ -195,8 +215,13 @@ SmallVector<unsigned> getUniqueContigPerThread(Attribute layout,
 
 SmallVector<unsigned> getShapePerCTATile(Attribute layout,
                                          ArrayRef<int64_t> tensorShape) {
-  if (auto distributedLayout = layout.dyn_cast<DistributedEncodingTrait>()) {
-    return distributedLayout.getShapePerCTATile(tensorShape);
+  if (auto blockedLayout = layout.dyn_cast<BlockedEncodingAttr>()) {
+    return blockedLayout.getShapePerCTATile(tensorShape);
+  } else if (auto distributedLayout =
+                 layout.dyn_cast<DistributedEncodingTrait>()) {
+    return getLayoutCache(layout).get(
+        LayoutCache::Query::ShapePerCTATile, layout, tensorShape,
+        [&] { return distributedLayout.getShapePerCTATile(tensorShape); });
   } else {
     llvm::report_fatal_error("getThreadsPerWarp not implemented");
     return SmallVector<unsigned>();
@@ -226,16 +251,27 @@ SmallVector<unsigned> eraseOrder(ArrayRef<unsigned> order, unsigned dim) {
   return resOrder;
 }
 
+// The order of the matrix layouts of rank `rank`: the columns first, then the
+// rows and, for batched dots, the batch.
+SmallVector<unsigned> getMatrixOrder(unsigned rank) {
+  SmallVector<unsigned> order(rank);
+  for (unsigned d = 0; d < rank; ++d)
+    order[d] = rank - 1 - d;
+  return order;
+}
+
 } // namespace
 
 SmallVector<unsigned> getOrder(Attribute layout) {
   if (auto blockedLayout = layout.dyn_cast<BlockedEncodingAttr>()) {
     return SmallVector<unsigned>(blockedLayout.getOrder().begin(),
                                  blockedLayout.getOrder().end());
+  } else if (auto mmaLayout = layout.dyn_cast<NvidiaMmaEncodingAttr>()) {
+    return getMatrixOrder(mmaLayout.getWarpsPerCTA().size());
   } else if (auto mmaLayout = layout.dyn_cast<MmaEncodingTrait>()) {
     return {1, 0};
   } else if (auto dotLayout = layout.dyn_cast<DotOperandEncodingAttr>()) {
-    return {1, 0};
+    return getMatrixOrder(getCTASplitNum(dotLayout.getParent()).size());
   } else if (auto sliceLayout = layout.dyn_cast<SliceEncodingAttr>()) {
     SmallVector<unsigned> parentOrder = getOrder(sliceLayout.getParent());
     unsigned dim = sliceLayout.getDim();
@@ -620,10 +656,12 @@ SmallVector<unsigned> BlockedEncodingAttr::getSizePerThread() const {
 }
 SmallVector<unsigned>
 BlockedEncodingAttr::getShapePerCTATile(ArrayRef<int64_t> tensorShape) const {
+  ArrayRef<unsigned> sizePerThread = getSizePerThread__();
+  ArrayRef<unsigned> threadsPerWarp = getThreadsPerWarp__();
+  ArrayRef<unsigned> warpsPerCTA = getWarpsPerCTA__();
   SmallVector<unsigned> shape;
   for (unsigned d = 0, n = getOrder().size(); d < n; ++d)
-    shape.push_back(getSizePerThread()[d] * getThreadsPerWarp()[d] *
-                    getWarpsPerCTA()[d]);
+    shape.push_back(sizePerThread[d] * threadsPerWarp[d] * warpsPerCTA[d]);
   return shape;
 }
 
@@ -773,7 +811,8 @@ SmallVector<unsigned>
 NvidiaMmaEncodingAttr::getElemsPerThread(ArrayRef<int64_t> shape,
                                          Type eltTy) const {
   size_t rank = shape.size();
-  assert(rank == 2 && "Unexpected rank of mma layout");
+  assert((rank == 2 || (rank == 3 && isAmpere())) &&
+         "Unexpected rank of mma layout");
   assert((isVolta() || isAmpere() || isHopper()) &&
          "For NvidiaMmaEncodingAttr only version 1~3 is supported");
 
@@ -796,12 +835,16 @@ NvidiaMmaEncodingAttr::getElemsPerThread(ArrayRef<int64_t> shape,
     elemsPerThread[0] = resM;
     elemsPerThread[1] = resN;
   } else if (isAmpere()) {
+    auto warpsPerCTA = getWarpsPerCTA();
+    // The warps of a batched dot each hold the tiles of whole batch entries
+    if (rank == 3)
+      elemsPerThread[0] = ceil<unsigned>(shapePerCTA[0], warpsPerCTA[0]);
     unsigned elemsRow =
-        ceil<unsigned>(shapePerCTA[0], 16 * getWarpsPerCTA()[0]) * 2;
+        ceil<unsigned>(shapePerCTA[rank - 2], 16 * warpsPerCTA[rank - 2]) * 2;
     unsigned elemsCol =
-        ceil<unsigned>(shapePerCTA[1], 8 * getWarpsPerCTA()[1]) * 2;
-    elemsPerThread[0] = elemsRow;
-    elemsPerThread[1] = elemsCol;
+        ceil<unsigned>(shapePerCTA[rank - 1], 8 * warpsPerCTA[rank - 1]) * 2;
+    elemsPerThread[rank - 2] = elemsRow;
+    elemsPerThread[rank - 1] = elemsCol;
   } else if (isHopper()) {
     auto wpt = getWarpsPerCTA();
     auto instrMNK = getInstrShape();
@@ -914,10 +957,11 @@ SmallVector<unsigned> DotOperandEncodingAttr::getCTAOrder() const {
 }
 SmallVector<unsigned> DotOperandEncodingAttr::getCTASplitNum() const {
   SmallVector<unsigned> res = ::getCTASplitNum(getParent());
-  assert(res.size() == 2 && "Invalid dotLayout");
+  unsigned rank = res.size();
+  assert((rank == 2 || rank == 3) && "Invalid dotLayout");
 
   // Do not split CTA in K dimension
-  getOpIdx() == 0 ? res[1] = 1 : res[0] = 1;
+  getOpIdx() == 0 ? res[rank - 1] = 1 : res[rank - 2] = 1;
   return res;
 }
 SmallVector<unsigned> DotOperandEncodingAttr::getWarpsPerCTA() const {
@@ -1432,6 +1476,8 @@ SmallVector<unsigned> NvidiaMmaEncodingAttr::getWarpOrder() const {
 SmallVector<unsigned> NvidiaMmaEncodingAttr::getThreadsPerWarp() const {
   if (isVolta())
     return {4, 8};
+  if (isAmpere() && getWarpsPerCTA().size() == 3)
+    return {1, 8, 4};
   if (isAmpere())
     return {8, 4};
   if (isHopper())
@@ -1443,7 +1489,9 @@ SmallVector<unsigned> NvidiaMmaEncodingAttr::getThreadOrder() const {
   return ::getOrder(*this);
 }
 SmallVector<unsigned> NvidiaMmaEncodingAttr::getSizePerThread() const {
-  if (isAmpere()) {
+  if (isAmpere() && getWarpsPerCTA().size() == 3) {
+    return {1, 2, 2};
+  } else if (isAmpere()) {
     return {2, 2};
   } else if (isVolta()) {
     return {1, 2};
@@ -1457,8 +1505,11 @@ SmallVector<unsigned> NvidiaMmaEncodingAttr::getSizePerThread() const {
 }
 SmallVector<unsigned>
 NvidiaMmaEncodingAttr::getShapePerCTATile(ArrayRef<int64_t> tensorShape) const {
+  auto warpsPerCTA = getWarpsPerCTA();
+  if (isAmpere() && warpsPerCTA.size() == 3)
+    return {warpsPerCTA[0], 16 * warpsPerCTA[1], 8 * warpsPerCTA[2]};
   if (isAmpere())
-    return {16 * getWarpsPerCTA()[0], 8 * getWarpsPerCTA()[1]};
+    return {16 * warpsPerCTA[0], 8 * warpsPerCTA[1]};
   if (isVolta()) {
     assert(!tensorShape.empty() && "Volta needs the tensorShape");
     if (tensorShape.size() == 1) // must be SliceEncoding
@@ -1539,14 +1590,22 @@ SmallVector<int64_t> NvidiaMmaEncodingAttr::getMMAv2Rep(ArrayRef<int64_t> shape,
   SmallVector<int> shapePerWarp = {16, 8, 4 * 64 / bitwidth};
   auto warpsPerCTA = getWarpsPerCTA();
   assert(isAmpere());
+  unsigned rank = shape.size();
+  assert(warpsPerCTA.size() == rank && "Unexpected rank of the operand");
+  // The batch entries of the warps of a batched dot, 1 otherwise
+  int64_t numRepBatch =
+      rank == 3 ? std::max<int64_t>(1, shape[0] / warpsPerCTA[0]) : 1;
+  int64_t rows = shape[rank - 2], cols = shape[rank - 1];
   if (opIdx == 0)
-    return {std::max<int64_t>(1, shape[0] / (shapePerWarp[0] * warpsPerCTA[0])),
-            std::max<int64_t>(1, shape[1] / shapePerWarp[2])};
+    return {numRepBatch,
+            std::max<int64_t>(
+                1, rows / (shapePerWarp[0] * warpsPerCTA[rank - 2])),
+            std::max<int64_t>(1, cols / shapePerWarp[2])};
   else {
     assert(opIdx == 1);
-    return {
-        std::max<int64_t>(1, shape[0] / shapePerWarp[2]),
-        std::max<int64_t>(1, shape[1] / (shapePerWarp[1] * warpsPerCTA[1]))};
+    return {numRepBatch, std::max<int64_t>(1, rows / shapePerWarp[2]),
+            std::max<int64_t>(
+                1, cols / (shapePerWarp[1] * warpsPerCTA[rank - 1]))};
   }
 }
 unsigned NvidiaMmaEncodingAttr::getTotalElemsPerThreadForOperands(
@@ -1563,9 +1622,9 @@ unsigned NvidiaMmaEncodingAttr::getTotalElemsPerThreadForOperands(
   if (isAmpere()) {
     auto rep = getMMAv2Rep(shapePerCTA, eltTy.getIntOrFloatBitWidth(), opIdx);
     if (opIdx == 0)
-      return 4 * rep[0] * rep[1];
+      return 4 * rep[0] * rep[1] * rep[2];
     if (opIdx == 1)
-      return 4 * rep[0] * std::max<int>(rep[1] / 2, 1);
+      return 4 * rep[0] * rep[1] * std::max<int>(rep[2] / 2, 1);
   }
   // V100
   if (isVolta()) {
@@ -1634,10 +1693,15 @@ NvidiaMmaEncodingAttr::getShapePerCTATileForDotOperands(ArrayRef<int64_t> shape,
                                                         int opIdx) const {
   assert(isAmpere() && "mmaLayout version = 1 is not implemented yet");
   auto parentShapePerCTATile = getShapePerCTATile(shape);
+  unsigned rank = parentShapePerCTATile.size();
   if (opIdx == 0) {
-    return {parentShapePerCTATile[0], 16};
+    auto shapePerCTATile = parentShapePerCTATile;
+    shapePerCTATile[rank - 1] = 16;
+    return shapePerCTATile;
   } else if (opIdx == 1) {
-    return {16, parentShapePerCTATile[1]};
+    auto shapePerCTATile = parentShapePerCTATile;
+    shapePerCTATile[rank - 2] = 16;
+    return shapePerCTATile;
   } else {
     llvm::report_fatal_error("DotOperandEncodingAttr opIdx must be 0 or 1");
   }
@@ -1645,9 +1709,14 @@ NvidiaMmaEncodingAttr::getShapePerCTATileForDotOperands(ArrayRef<int64_t> shape,
 SmallVector<unsigned>
 NvidiaMmaEncodingAttr::getSizePerThreadForOperands(unsigned opIdx) const {
   assert(isAmpere() && "mmaLayout version = 1 is not implemented yet");
+  bool isBatched = getWarpsPerCTA().size() == 3;
   if (opIdx == 0) {
+    if (isBatched)
+      return {1, 2, 4};
     return {2, 4};
   } else if (opIdx == 1) {
+    if (isBatched)
+      return {1, 4, 1};
     return {4, 1};
   } else {
     llvm::report_fatal_error("DotOperandEncodingAttr opIdx must be 0 or 1");
@@ -1819,6 +1888,33 @@ struct TritonGPUInferLayoutInterface
 
   LogicalResult inferTransOpEncoding(Attribute operandEncoding,
                                      Attribute &resultEncoding) const override {
+    // Reversing the dimensions of a blocked layout along with its order
+    // leaves each element in the same register of the same thread, so that
+    // the transpose is a rename of the values.
+    if (auto blocked = operandEncoding.dyn_cast<BlockedEncodingAttr>()) {
+      auto *ctx = getDialect()->getContext();
+      unsigned rank = blocked.getOrder().size();
+      auto reverse = [](ArrayRef<unsigned> values) {
+        return SmallVector<unsigned>(values.rbegin(), values.rend());
+      };
+      auto reverseOrder = [&](ArrayRef<unsigned> order) {
+        SmallVector<unsigned> retOrder;
+        for (unsigned d : order)
+          retOrder.push_back(rank - 1 - d);
+        return retOrder;
+      };
+      auto CTALayout = blocked.getCTALayout();
+      auto retCTALayout = CTALayoutAttr::get(
+          ctx, reverse(CTALayout.getCTAsPerCGA()),
+          reverse(CTALayout.getCTASplitNum()),
+          reverseOrder(CTALayout.getCTAOrder()));
+      resultEncoding = BlockedEncodingAttr::get(
+          ctx, reverse(blocked.getSizePerThread()),
+          reverse(blocked.getThreadsPerWarp()),
+          reverse(blocked.getWarpsPerCTA()), reverseOrder(blocked.getOrder()),
+          retCTALayout);
+      return success();
+    }
     SharedEncodingAttr sharedEncoding =
         operandEncoding.dyn_cast<SharedEncodingAttr>();
     if (!sharedEncoding)
@@ -1895,6 +1991,83 @@ struct TritonGPUInferLayoutInterface
       return op->emitError("mismatching kWidth between A and B operands");
     return success();
   }
+
+  // The new dimension of a join is the most minor one and lives entirely in
+  // the registers of each thread, so that the join and split ops only move
+  // values around within a thread.
+  LogicalResult
+  inferJoinOpEncoding(Attribute srcEnc, Attribute &dstEnc,
+                      std::optional<Location> loc) const override {
+    auto enc = srcEnc.dyn_cast<BlockedEncodingAttr>();
+    if (!enc)
+      return emitOptionalError(loc,
+                               "JoinOp can only operate on BlockedEncoding");
+
+    auto append = [](ArrayRef<unsigned> vals, unsigned val) {
+      SmallVector<unsigned> ret(vals.begin(), vals.end());
+      ret.push_back(val);
+      return ret;
+    };
+    auto appendMinorDim = [](ArrayRef<unsigned> order) {
+      SmallVector<unsigned> ret(order.begin(), order.end());
+      ret.insert(ret.begin(), ret.size());
+      return ret;
+    };
+
+    auto CTALayout = enc.getCTALayout();
+    auto retCTALayout = CTALayoutAttr::get(
+        enc.getContext(), append(CTALayout.getCTAsPerCGA(), 1),
+        append(CTALayout.getCTASplitNum(), 1),
+        appendMinorDim(CTALayout.getCTAOrder()));
+    dstEnc = BlockedEncodingAttr::get(
+        enc.getContext(), append(enc.getSizePerThread(), 2),
+        append(enc.getThreadsPerWarp(), 1), append(enc.getWarpsPerCTA(), 1),
+        appendMinorDim(enc.getOrder()), retCTALayout);
+    return success();
+  }
+
+  LogicalResult
+  inferSplitOpEncoding(Attribute srcEnc, Attribute &dstEnc,
+                       std::optional<Location> loc) const override {
+    auto enc = srcEnc.dyn_cast<BlockedEncodingAttr>();
+    if (!enc)
+      return emitOptionalError(loc,
+                               "SplitOp can only operate on BlockedEncoding");
+
+    // The last dim must be the split dim, and it must be entirely in the
+    // registers of a thread, as the most minor dim.
+    unsigned rank = enc.getOrder().size();
+    auto CTALayout = enc.getCTALayout();
+    if (enc.getSizePerThread().back() != 2 ||
+        enc.getThreadsPerWarp().back() != 1 ||
+        enc.getWarpsPerCTA().back() != 1 || enc.getOrder()[0] != rank - 1 ||
+        CTALayout.getCTAsPerCGA().back() != 1 ||
+        CTALayout.getCTASplitNum().back() != 1 ||
+        CTALayout.getCTAOrder()[0] != rank - 1) {
+      return emitOptionalError(
+          loc,
+          "SplitOp requires the last dimension of its operand to be the most "
+          "minor one, with 2 elements per thread, got ",
+          srcEnc);
+    }
+
+    auto dropLast = [](ArrayRef<unsigned> vals) {
+      return SmallVector<unsigned>(vals.begin(), vals.end() - 1);
+    };
+    auto dropMinorDim = [](ArrayRef<unsigned> order) {
+      return SmallVector<unsigned>(order.begin() + 1, order.end());
+    };
+
+    auto retCTALayout = CTALayoutAttr::get(
+        enc.getContext(), dropLast(CTALayout.getCTAsPerCGA()),
+        dropLast(CTALayout.getCTASplitNum()),
+        dropMinorDim(CTALayout.getCTAOrder()));
+    dstEnc = BlockedEncodingAttr::get(
+        enc.getContext(), dropLast(enc.getSizePerThread()),
+        dropLast(enc.getThreadsPerWarp()), dropLast(enc.getWarpsPerCTA()),
+        dropMinorDim(enc.getOrder()), retCTALayout);
+    return success();
+  }
 };
 
 //===----------------------------------------------------------------------===//
@@ -2186,6 +2359,27 @@ void TritonGPUDialect::initialize() {
 #define GET_OP_CLASSES
 #include "triton/Dialect/TritonGPU/IR/Ops.cpp.inc"
 
+LogicalResult SparseDotOp::verify() {
+  auto aTy = getA().getType().cast<RankedTensorType>();
+  auto bTy = getB().getType().cast<RankedTensorType>();
+  auto cTy = getC().getType().cast<RankedTensorType>();
+  auto metaTy = getAMeta().getType().cast<RankedTensorType>();
+  if (aTy.getRank() != 2 || bTy.getRank() != 2 || metaTy.getRank() != 2)
+    return emitOpError("operands must be 2D tensors");
+  if (aTy.getElementType() != bTy.getElementType())
+    return emitOpError("operands A and B must have the same element type");
+  if (!metaTy.getElementType().isInteger(16))
+    return emitOpError("metadata must be a tensor of i16");
+  int64_t M = cTy.getShape()[0], N = cTy.getShape()[1];
+  int64_t K = bTy.getShape()[0];
+  if (K % 16 != 0 || aTy.getShape()[0] != M || aTy.getShape()[1] != K / 2 ||
+      bTy.getShape()[1] != N)
+    return emitOpError("operand A must be compressed to M x K/2");
+  if (metaTy.getShape()[0] != M || metaTy.getShape()[1] != K / 16)
+    return emitOpError("metadata must have shape M x K/16");
+  return success();
+}
+
 // verify TritonGPU ops
 LogicalResult TritonGPUDialect::verifyOperationAttribute(Operation *op,
                                                          NamedAttribute attr) {
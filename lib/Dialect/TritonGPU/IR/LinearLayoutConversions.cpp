@@ -0,0 +1,254 @@
+#include "triton/Dialect/TritonGPU/IR/LinearLayoutConversions.h"
+#include "triton/Dialect/TritonGPU/IR/Dialect.h"
+#include "llvm/Support/MathExtras.h"
+
+namespace mlir {
+namespace triton {
+namespace gpu {
+
+using BasisT = LinearLayout::BasisT;
+using BasesT = LinearLayout::BasesT;
+
+// The bases of the registers, lanes and warps of a layout. The offsets may be
+// out of the shape along the dimensions dropped by slices.
+using LayoutBases = std::array<BasesT, LinearLayout::kNumInDims>;
+
+static BasisT getUnitBasis(unsigned rank, unsigned dim, int64_t offset) {
+  BasisT basis(rank, 0);
+  basis[dim] = static_cast<int32_t>(offset);
+  return basis;
+}
+
+static bool isPowerOf2(ArrayRef<unsigned> values) {
+  return llvm::all_of(
+      values, [](unsigned value) { return llvm::isPowerOf2_32(value); });
+}
+
+// Follows emitOffsetForBlockedLayout and
+// emitBaseIndexWithinCTAForBlockedLayout: the registers hold the elements of
+// sizePerThread, then the repetitions of the CTA tile, both in `order`. Lanes
+// and warps wrap around the shape.
+static std::optional<LayoutBases>
+getBlockedBases(BlockedEncodingAttr layout, ArrayRef<int64_t> shape) {
+  auto sizePerThread = layout.getSizePerThread();
+  auto threadsPerWarp = layout.getThreadsPerWarp();
+  auto warpsPerCTA = layout.getWarpsPerCTA();
+  auto order = layout.getOrder();
+  if (!isPowerOf2(sizePerThread) || !isPowerOf2(threadsPerWarp) ||
+      !isPowerOf2(warpsPerCTA))
+    return std::nullopt;
+  unsigned rank = shape.size();
+  LayoutBases bases;
+  auto &[registers, lanes, warps] = bases;
+  for (unsigned d : order)
+    for (unsigned size = 1; size < sizePerThread[d]; size *= 2)
+      registers.push_back(getUnitBasis(rank, d, size));
+  for (unsigned d : order) {
+    int64_t tile = sizePerThread[d] * threadsPerWarp[d] * warpsPerCTA[d];
+    for (int64_t offset = tile; offset < shape[d]; offset *= 2)
+      registers.push_back(getUnitBasis(rank, d, offset));
+  }
+  for (unsigned d : order) {
+    for (unsigned i = 0; (1u << i) < threadsPerWarp[d]; ++i) {
+      int64_t offset = int64_t(sizePerThread[d]) << i;
+      lanes.push_back(getUnitBasis(rank, d, offset < shape[d] ? offset : 0));
+    }
+  }
+  for (unsigned d : order) {
+    for (unsigned i = 0; (1u << i) < warpsPerCTA[d]; ++i) {
+      int64_t offset = int64_t(sizePerThread[d] * threadsPerWarp[d]) << i;
+      warps.push_back(getUnitBasis(rank, d, offset < shape[d] ? offset : 0));
+    }
+  }
+  return bases;
+}
+
+// Follows emitOffsetForMmaLayoutV2 and
+// emitBaseIndexWithinCTAForMmaLayoutV2V3: each lane holds two pairs of
+// adjacent elements of a 16x8 tile, eight rows apart, and the registers then
+// repeat the CTA tile along the columns first. The registers of a batched
+// layout repeat the tiles over the batch entries last.
+static std::optional<LayoutBases>
+getMmaV2Bases(NvidiaMmaEncodingAttr layout, ArrayRef<int64_t> shape) {
+  auto warpsPerCTA = layout.getWarpsPerCTA();
+  if (!isPowerOf2(warpsPerCTA))
+    return std::nullopt;
+  unsigned rank = shape.size();
+  unsigned rowDim = rank - 2, colDim = rank - 1;
+  LayoutBases bases;
+  auto &[registers, lanes, warps] = bases;
+  registers.push_back(getUnitBasis(rank, colDim, 1));
+  registers.push_back(getUnitBasis(rank, rowDim, 8));
+  for (int64_t offset = 8 * warpsPerCTA[colDim]; offset < shape[colDim];
+       offset *= 2)
+    registers.push_back(getUnitBasis(rank, colDim, offset));
+  for (int64_t offset = 16 * warpsPerCTA[rowDim]; offset < shape[rowDim];
+       offset *= 2)
+    registers.push_back(getUnitBasis(rank, rowDim, offset));
+  if (rank == 3)
+    for (int64_t offset = warpsPerCTA[0]; offset < shape[0]; offset *= 2)
+      registers.push_back(getUnitBasis(rank, 0, offset));
+  for (int64_t offset : {2, 4})
+    lanes.push_back(getUnitBasis(rank, colDim, offset));
+  for (int64_t offset : {1, 2, 4})
+    lanes.push_back(getUnitBasis(rank, rowDim, offset));
+  // The warps are ordered along the columns first
+  for (unsigned i = 0; (1u << i) < warpsPerCTA[colDim]; ++i) {
+    int64_t offset = int64_t(8) << i;
+    warps.push_back(
+        getUnitBasis(rank, colDim, offset < shape[colDim] ? offset : 0));
+  }
+  for (unsigned i = 0; (1u << i) < warpsPerCTA[rowDim]; ++i) {
+    int64_t offset = int64_t(16) << i;
+    warps.push_back(
+        getUnitBasis(rank, rowDim, offset < shape[rowDim] ? offset : 0));
+  }
+  if (rank == 3)
+    for (unsigned i = 0; (1u << i) < warpsPerCTA[0]; ++i) {
+      int64_t offset = int64_t(1) << i;
+      warps.push_back(getUnitBasis(rank, 0, offset < shape[0] ? offset : 0));
+    }
+  return bases;
+}
+
+static std::optional<LayoutBases> getBases(Attribute layout,
+                                           ArrayRef<int64_t> shape) {
+  if (auto blocked = layout.dyn_cast<BlockedEncodingAttr>())
+    return getBlockedBases(blocked, shape);
+  if (auto mma = layout.dyn_cast<NvidiaMmaEncodingAttr>()) {
+    if (mma.isAmpere())
+      return getMmaV2Bases(mma, shape);
+    return std::nullopt;
+  }
+  if (auto slice = layout.dyn_cast<SliceEncodingAttr>()) {
+    unsigned dim = slice.getDim();
+    auto parentBases = getBases(slice.getParent(), slice.paddedShape(shape));
+    if (!parentBases)
+      return std::nullopt;
+    // The sliced dimension is dropped, and only the first of the registers
+    // holding the same element is kept: the ones whose basis becomes zero go
+    // away.
+    LayoutBases bases;
+    for (unsigned inDim = 0; inDim < LinearLayout::kNumInDims; ++inDim) {
+      for (BasisT basis : (*parentBases)[inDim]) {
+        basis.erase(basis.begin() + dim);
+        bool isZero = llvm::all_of(basis, [](int32_t o) { return o == 0; });
+        if (inDim == static_cast<unsigned>(LinearLayout::InDim::Register) &&
+            isZero)
+          continue;
+        bases[inDim].push_back(basis);
+      }
+    }
+    return bases;
+  }
+  return std::nullopt;
+}
+
+std::optional<LinearLayout> toLinearLayout(RankedTensorType type) {
+  Attribute layout = type.getEncoding();
+  if (!layout || !isaDistributedLayout(layout))
+    return std::nullopt;
+  auto shape = type.getShape();
+  if (!llvm::all_of(shape, [](int64_t size) {
+        return size > 0 && llvm::isPowerOf2_64(size);
+      }))
+    return std::nullopt;
+  if (getNumCTAs(layout) != 1)
+    return std::nullopt;
+  auto bases = getBases(layout, shape);
+  if (!bases)
+    return std::nullopt;
+  // Layouts with more elements per thread than the tensor has along some
+  // dimension aren't linear
+  for (const BasesT &inDimBases : *bases)
+    for (const BasisT &basis : inDimBases)
+      for (unsigned d = 0; d < shape.size(); ++d)
+        if (basis[d] >= shape[d])
+          return std::nullopt;
+  auto &[registers, lanes, warps] = *bases;
+  LinearLayout linearLayout(shape, registers, lanes, warps);
+  // The registers merged by slices must give the number of values lowered
+  if (linearLayout.getNumRegisters() != getTotalElemsPerThread(type))
+    return std::nullopt;
+  return linearLayout;
+}
+
+bool isReshapeRename(RankedTensorType srcType, RankedTensorType dstType) {
+  auto src = toLinearLayout(srcType);
+  auto dst = toLinearLayout(dstType);
+  return src && dst && src->reshape(dstType.getShape()) == *dst;
+}
+
+// Reads the parameters of a blocked encoding off the bases of `layout`, each
+// of which has to move along a single dimension. The lanes and warps give the
+// order; the registers give sizePerThread, and the repetitions of the CTA tile
+// when they continue it. The caller checks the result.
+static std::optional<BlockedEncodingAttr>
+guessBlockedEncoding(MLIRContext *ctx, const LinearLayout &layout) {
+  using InDim = LinearLayout::InDim;
+  unsigned rank = layout.getRank();
+  SmallVector<unsigned> sizePerThread(rank, 1);
+  SmallVector<unsigned> threadsPerWarp(rank, 1);
+  SmallVector<unsigned> warpsPerCTA(rank, 1);
+  SmallVector<unsigned> order;
+  auto addToOrder = [&](unsigned d) {
+    if (!llvm::is_contained(order, d))
+      order.push_back(d);
+  };
+  auto getDim = [&](const BasisT &basis) -> std::optional<unsigned> {
+    std::optional<unsigned> dim;
+    for (unsigned d = 0; d < rank; ++d) {
+      if (basis[d] == 0)
+        continue;
+      if (dim)
+        return std::nullopt;
+      dim = d;
+    }
+    return dim;
+  };
+  for (auto [inDim, sizes] : {std::make_pair(InDim::Lane, &threadsPerWarp),
+                              std::make_pair(InDim::Warp, &warpsPerCTA)}) {
+    for (const BasisT &basis : layout.getBases(inDim)) {
+      auto d = getDim(basis);
+      if (!d)
+        return std::nullopt;
+      (*sizes)[*d] *= 2;
+      addToOrder(*d);
+    }
+  }
+  for (const BasisT &basis : layout.getBases(InDim::Register)) {
+    auto d = getDim(basis);
+    if (!d)
+      return std::nullopt;
+    if (basis[*d] == sizePerThread[*d])
+      sizePerThread[*d] *= 2;
+    addToOrder(*d);
+  }
+  for (unsigned d = rank; d > 0; --d)
+    addToOrder(d - 1);
+  SmallVector<unsigned> ones(rank, 1);
+  auto CTALayout = CTALayoutAttr::get(ctx, ones, ones, order);
+  return BlockedEncodingAttr::get(ctx, sizePerThread, threadsPerWarp,
+                                  warpsPerCTA, order, CTALayout);
+}
+
+std::optional<Attribute>
+inferReshapeRenameEncoding(RankedTensorType srcType,
+                           ArrayRef<int64_t> dstShape) {
+  auto src = toLinearLayout(srcType);
+  if (!src)
+    return std::nullopt;
+  LinearLayout dst = src->reshape(dstShape);
+  auto encoding = guessBlockedEncoding(srcType.getContext(), dst);
+  if (!encoding)
+    return std::nullopt;
+  auto dstType =
+      RankedTensorType::get(dstShape, srcType.getElementType(), *encoding);
+  if (toLinearLayout(dstType) != dst)
+    return std::nullopt;
+  return *encoding;
+}
+
+} // namespace gpu
+} // namespace triton
+} // namespace mlir
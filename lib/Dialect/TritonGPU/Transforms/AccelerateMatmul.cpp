@@ -1,6 +1,7 @@
 #include "mlir/IR/TypeUtilities.h"
 #include "mlir/Support/LogicalResult.h"
 #include "mlir/Transforms/GreedyPatternRewriteDriver.h"
+#include "triton/Analysis/RegisterPressure.h"
 #include "triton/Analysis/Utility.h"
 #include "triton/Dialect/TritonGPU/IR/Dialect.h"
 #include "triton/Dialect/TritonGPU/Transforms/Passes.h"
@@ -8,6 +9,8 @@
 #include "triton/Tools/Sys/GetEnv.hpp"
 #include "llvm/Support/Debug.h"
 #include <memory>
+#include <optional>
+#include <tuple>
 
 using namespace mlir;
 namespace tt = mlir::triton;
@@ -43,8 +46,11 @@ static int getMMAVersionSafe(int computeCapability, tt::DotOp op) {
   return 0;
 }
 
-SmallVector<unsigned, 2>
-warpsPerTileV2(tt::DotOp dotOp, const ArrayRef<int64_t> shape, int numWarps) {
+// Returns the split of the warps of `dotOp` if it is chained with another
+// dot, whose layouts must match.
+std::optional<SmallVector<unsigned, 2>>
+getChainedWarpsPerTileV2(tt::DotOp dotOp, const ArrayRef<int64_t> shape,
+                         int numWarps) {
   auto filter = [&dotOp](Operation *op) {
     return op->getParentRegion() == dotOp->getParentRegion() &&
            !isa<tt::TransOp>(op);
@@ -66,12 +72,16 @@ warpsPerTileV2(tt::DotOp dotOp, const ArrayRef<int64_t> shape, int numWarps) {
   }
   if (hasChainedDot) {
     if (shape[0] >= shape[1]) {
-      return {(unsigned)numWarps, 1};
+      return SmallVector<unsigned, 2>{(unsigned)numWarps, 1};
     } else {
-      return {1, (unsigned)numWarps};
+      return SmallVector<unsigned, 2>{1, (unsigned)numWarps};
     }
   }
+  return std::nullopt;
+}
 
+SmallVector<unsigned, 2> warpsPerTileV2(const ArrayRef<int64_t> shape,
+                                        int numWarps) {
   SmallVector<unsigned, 2> ret = {1, 1};
   SmallVector<int64_t, 2> shapePerWarp = {16, 8};
   // TODO (@daadaada): double-check.
@@ -94,15 +104,19 @@ warpsPerTileV2(tt::DotOp dotOp, const ArrayRef<int64_t> shape, int numWarps) {
   return ret;
 }
 
-SmallVector<unsigned, 2>
-warpsPerTileV3(tt::DotOp dotOp, const ArrayRef<int64_t> shape, int numWarps,
-               const SmallVector<unsigned, 3> &instrShape) {
+std::optional<SmallVector<unsigned, 2>>
+getChainedWarpsPerTileV3(tt::DotOp dotOp, int numWarps) {
   SetVector<Operation *> slices;
   mlir::getForwardSlice(dotOp.getResult(), &slices);
   if (llvm::find_if(slices, [](Operation *op) { return isa<tt::DotOp>(op); }) !=
       slices.end())
-    return {(unsigned)numWarps, 1};
+    return SmallVector<unsigned, 2>{(unsigned)numWarps, 1};
+  return std::nullopt;
+}
 
+SmallVector<unsigned, 2>
+warpsPerTileV3(tt::DotOp dotOp, const ArrayRef<int64_t> shape, int numWarps,
+               const SmallVector<unsigned, 3> &instrShape) {
   // For MMAv3, the smallest indivisible unit of warp shape is (4, 1).
   SmallVector<unsigned, 2> ret = {4, 1};
   SmallVector<int64_t, 2> shapePerWarp = {16, instrShape[1]};
@@ -118,6 +132,67 @@ warpsPerTileV3(tt::DotOp dotOp, const ArrayRef<int64_t> shape, int numWarps,
   return ret;
 }
 
+// The cost of an MMA encoding of a dot, compared lexicographically: the
+// registers a thread needs past the register file, the number of result
+// elements computed by more than one warp, and the number of operand elements
+// read per step along k.
+using MMACost = std::tuple<int64_t, int64_t, int64_t>;
+
+// `getRegisters` returns the registers a thread needs for the dot when its
+// warps are split as `warpsPerTile` and run `instrShape` instructions.
+MMACost getMMACost(
+    int version, const ArrayRef<int64_t> shape, ArrayRef<unsigned> warpsPerTile,
+    ArrayRef<unsigned> instrShape,
+    function_ref<unsigned(ArrayRef<unsigned>, ArrayRef<unsigned>)>
+        getRegisters) {
+  // The warps of an MMAv3 instruction run it as a group of 4 along M, and
+  // read their operands from shared memory together
+  int64_t warpsPerGroup = version == 3 ? 4 : 1;
+  int64_t groupsM = warpsPerTile[0] / warpsPerGroup;
+  int64_t tileM = std::max<int64_t>(instrShape[0] * warpsPerGroup,
+                                    shape[0] / groupsM);
+  int64_t tileN = std::max<int64_t>(instrShape[1], shape[1] / warpsPerTile[1]);
+  int64_t numTiles = groupsM * warpsPerTile[1];
+  // Each group reads the rows of a and the columns of b of its tile
+  int64_t registers = getRegisters(warpsPerTile, instrShape);
+  return {std::max<int64_t>(0, registers - kMaxRegistersPerThread),
+          numTiles * tileM * tileN - shape[0] * shape[1],
+          numTiles * (tileM + tileN)};
+}
+
+// Picks the split of the warps of a dot and, for MMAv3, its instruction shape
+// with the lowest cost. The candidates split the warps along M, in groups of
+// 4 for MMAv3, and along N, where each MMAv3 group runs the widest
+// instruction that divides its columns. The split of the heuristic above
+// wins ties.
+void chooseMMAEncoding(
+    int version, const ArrayRef<int64_t> shape, int numWarps,
+    RankedTensorType aType, SmallVector<unsigned, 3> &warpsPerTile,
+    SmallVector<unsigned, 3> &instrShape,
+    function_ref<unsigned(ArrayRef<unsigned>, ArrayRef<unsigned>)>
+        getRegisters) {
+  MMACost minCost =
+      getMMACost(version, shape, warpsPerTile, instrShape, getRegisters);
+  unsigned warpsPerGroup = version == 3 ? 4 : 1;
+  for (unsigned warpsM = warpsPerGroup; warpsM <= numWarps; warpsM *= 2) {
+    SmallVector<unsigned, 3> candidate = {warpsM, numWarps / warpsM};
+    SmallVector<unsigned, 3> candidateInstrShape = instrShape;
+    if (version == 3) {
+      if (shape[1] % candidate[1] != 0 || (shape[1] / candidate[1]) % 8 != 0)
+        continue;
+      candidateInstrShape = mmaVersionToInstrShape(
+          version, {shape[0], shape[1] / candidate[1]}, aType);
+    }
+    MMACost cost = getMMACost(version, shape, candidate, candidateInstrShape,
+                              getRegisters);
+    if (cost < minCost) {
+      minCost = cost;
+      warpsPerTile = candidate;
+      instrShape = candidateInstrShape;
+    }
+  }
+}
+
 class BlockedToMMA : public mlir::RewritePattern {
   int computeCapability;
   mutable int mmaV1Counter{}; // used to generate ID for MMAv1 encoding
@@ -171,16 +246,41 @@ public:
 
   static SmallVector<unsigned, 3>
   getWarpsPerTile(tt::DotOp dotOp, const ArrayRef<int64_t> shape, int version,
-                  int numWarps, const SmallVector<unsigned, 3> &instrShape) {
+                  int numWarps, RankedTensorType aType,
+                  SmallVector<unsigned, 3> &instrShape,
+                  function_ref<unsigned(ArrayRef<unsigned>, ArrayRef<unsigned>)>
+                      getRegisters) {
+    std::optional<SmallVector<unsigned, 2>> chained;
+    SmallVector<unsigned, 3> ret;
+    if (shape.size() == 3) {
+      // The warps of a batched dot take separate batch entries first, the
+      // ones left split each matrix
+      assert(version == 2 && "batched dots only lower to MMAv2");
+      unsigned warpsPerBatch = std::min<int64_t>(numWarps, shape[0]);
+      ret = warpsPerTileV2(shape.drop_front(), numWarps / warpsPerBatch);
+      ret.insert(ret.begin(), warpsPerBatch);
+      return ret;
+    }
     switch (version) {
     case 2:
-      return warpsPerTileV2(dotOp, shape, numWarps);
+      chained = getChainedWarpsPerTileV2(dotOp, shape, numWarps);
+      if (chained)
+        return *chained;
+      ret = warpsPerTileV2(shape, numWarps);
+      break;
     case 3:
-      return warpsPerTileV3(dotOp, shape, numWarps, instrShape);
+      chained = getChainedWarpsPerTileV3(dotOp, numWarps);
+      if (chained)
+        return *chained;
+      ret = warpsPerTileV3(dotOp, shape, numWarps, instrShape);
+      break;
     default:
       assert(false && "not supported version");
       return {0, 0};
     }
+    chooseMMAEncoding(version, shape, numWarps, aType, ret, instrShape,
+                      getRegisters);
+    return ret;
   }
 
   static Value getMMAv3Operand(Value v, mlir::PatternRewriter &rewriter,
@@ -285,8 +385,29 @@ public:
           isARow, isBRow, mmaV1Counter++);
     } else if (versionMajor == 2 || versionMajor == 3) {
       int versionMinor = computeCapability == 75 ? 1 : 0;
-      auto warpsPerTile = getWarpsPerTile(dotOp, retShapePerCTA, versionMajor,
-                                          numWarps, instrShape);
+      auto getRegisters = [&](ArrayRef<unsigned> warpsPerTile,
+                              ArrayRef<unsigned> instrShape) {
+        auto enc = ttg::NvidiaMmaEncodingAttr::get(
+            oldRetType.getContext(), versionMajor, versionMinor, warpsPerTile,
+            CTALayout, instrShape);
+        unsigned registers = getNumRegisters(RankedTensorType::get(
+            oldRetType.getShape(), oldRetType.getElementType(), enc));
+        // The operands of MMAv3 are read from shared memory
+        if (versionMajor == 3)
+          return registers;
+        RankedTensorType operandTypes[] = {oldAType, oldBType};
+        for (unsigned opIdx = 0; opIdx < 2; ++opIdx) {
+          RankedTensorType type = operandTypes[opIdx];
+          auto operandEnc = DotOperandEncodingAttr::get(
+              oldRetType.getContext(), opIdx, enc, type.getElementType());
+          registers += getNumRegisters(RankedTensorType::get(
+              type.getShape(), type.getElementType(), operandEnc));
+        }
+        return registers;
+      };
+      auto warpsPerTile =
+          getWarpsPerTile(dotOp, retShapePerCTA, versionMajor, numWarps,
+                          AType, instrShape, getRegisters);
       mmaEnc = ttg::NvidiaMmaEncodingAttr::get(
           oldRetType.getContext(), versionMajor, versionMinor, warpsPerTile,
           CTALayout, instrShape);
@@ -332,6 +453,82 @@ public:
     return success();
   }
 };
+
+// Converts the sparse dots to mma.sp on an MMAv2 layout. The compressed
+// operand a has the layout of a dense one of its shape, and b the layout of
+// the dense operand of the same k. The metadata is read by each thread from
+// shared memory.
+class SparseBlockedToMMA : public mlir::RewritePattern {
+  int computeCapability;
+
+public:
+  SparseBlockedToMMA(mlir::MLIRContext *context, int computeCapability)
+      : mlir::RewritePattern(ttg::SparseDotOp::getOperationName(), 2, context),
+        computeCapability(computeCapability) {}
+
+  mlir::LogicalResult
+  matchAndRewrite(mlir::Operation *op,
+                  mlir::PatternRewriter &rewriter) const override {
+    if (computeCapability < 80)
+      return failure();
+    auto dotOp = cast<ttg::SparseDotOp>(op);
+    auto ctx = op->getContext();
+    Location loc = dotOp.getLoc();
+    auto oldRetType = dotOp.getD().getType().cast<RankedTensorType>();
+    if (!oldRetType.getEncoding() ||
+        oldRetType.getEncoding().isa<ttg::NvidiaMmaEncodingAttr>())
+      return failure();
+    auto oldAType = dotOp.getA().getType().cast<RankedTensorType>();
+    auto oldBType = dotOp.getB().getType().cast<RankedTensorType>();
+    Type eltType = oldAType.getElementType();
+    if (!(eltType.isF16() || eltType.isBF16()) ||
+        !oldRetType.getElementType().isF32())
+      return failure();
+    // Each mma.sp computes 16x8 elements over 32 along k
+    auto retShapePerCTA = ttg::getShapePerCTA(oldRetType);
+    if (retShapePerCTA[0] % 16 != 0 || retShapePerCTA[1] % 8 != 0 ||
+        oldBType.getShape()[0] % 32 != 0)
+      return failure();
+
+    auto mod = op->getParentOfType<mlir::ModuleOp>();
+    int numWarps = ttg::TritonGPUDialect::getNumWarps(mod);
+    auto CTALayout = ttg::getCTALayout(oldRetType.getEncoding());
+    SmallVector<unsigned, 2> warpsPerTile =
+        warpsPerTileV2(retShapePerCTA, numWarps);
+    auto mmaEnc = ttg::NvidiaMmaEncodingAttr::get(
+        ctx, /*versionMajor=*/2, /*versionMinor=*/0, warpsPerTile, CTALayout,
+        /*instrShape=*/{16, 8});
+    auto newRetType = RankedTensorType::get(
+        oldRetType.getShape(), oldRetType.getElementType(), mmaEnc);
+    Value newAcc =
+        rewriter.create<ttg::ConvertLayoutOp>(loc, newRetType, dotOp.getC());
+    auto convertOperand = [&](Value operand, unsigned opIdx) -> Value {
+      auto type = operand.getType().cast<RankedTensorType>();
+      auto encoding = DotOperandEncodingAttr::get(ctx, opIdx, mmaEnc,
+                                                  type.getElementType());
+      return rewriter.create<ttg::ConvertLayoutOp>(
+          loc,
+          RankedTensorType::get(type.getShape(), type.getElementType(),
+                                encoding),
+          operand);
+    };
+    Value a = convertOperand(dotOp.getA(), 0);
+    Value b = convertOperand(dotOp.getB(), 1);
+    auto metaType = dotOp.getAMeta().getType().cast<RankedTensorType>();
+    auto metaEncoding = ttg::SharedEncodingAttr::get(
+        ctx, 1, 1, 1, {1, 0}, ttg::getCTALayout(metaType.getEncoding()));
+    Value meta = rewriter.create<ttg::ConvertLayoutOp>(
+        loc,
+        RankedTensorType::get(metaType.getShape(), metaType.getElementType(),
+                              metaEncoding),
+        dotOp.getAMeta());
+    auto newDot =
+        rewriter.create<ttg::SparseDotOp>(loc, newRetType, a, b, newAcc, meta);
+    rewriter.replaceOpWithNewOp<ttg::ConvertLayoutOp>(op, oldRetType,
+                                                      newDot.getResult());
+    return success();
+  }
+};
 } // namespace
 
 static Value promoteOperand(OpBuilder &builder, Location loc, Value operand,
@@ -368,7 +565,8 @@ static void decomposeMixedModeDotOp(ModuleOp mod) {
       Type AElType =
           dotOp.getA().getType().cast<RankedTensorType>().getElementType();
       Type DElType = D.getType().cast<RankedTensorType>().getElementType();
-      if (AElType == DElType)
+      // The int8 dots are lowered to dp4a on their packed operands
+      if (AElType == DElType || AElType.isInteger(8))
         return;
       promoteType = DElType;
     }
@@ -380,6 +578,91 @@ static void decomposeMixedModeDotOp(ModuleOp mod) {
   });
 }
 
+// The lowering of a fp8 MMAv3 dot adds its accumulation to a separate fp32
+// accumulator every `maxNumImpreciseAcc` elements along k, which only covers
+// the k of the dot. When they are more, the accumulator of the loop the dot is
+// carried by is promoted every `maxNumImpreciseAcc / k` iterations instead:
+// the dots accumulate in a partial accumulator, added to it and reset then.
+static void promoteImpreciseAccumulator(tt::DotOp dotOp) {
+  auto dType = dotOp.getType().cast<RankedTensorType>();
+  auto mmaEnc = dType.getEncoding().dyn_cast<NvidiaMmaEncodingAttr>();
+  auto aType = dotOp.getA().getType().cast<RankedTensorType>();
+  Type aElType = aType.getElementType();
+  if (!mmaEnc || !mmaEnc.isHopper() || !dType.getElementType().isF32() ||
+      !(aElType.isFloat8E5M2() || aElType.isFloat8E4M3FNUZ()))
+    return;
+  int64_t K = aType.getShape()[1];
+  uint32_t maxNumImpreciseAcc = dotOp.getMaxNumImpreciseAcc();
+  // The default of the front end, 2**30, never promotes
+  if (maxNumImpreciseAcc <= K || maxNumImpreciseAcc >= (1u << 30))
+    return;
+  auto forOp = dyn_cast<scf::ForOp>(dotOp->getParentOp());
+  if (!forOp)
+    return;
+  // The accumulator is carried by the loop, possibly in another layout
+  auto skipCvt = [](Value v) {
+    if (auto cvtOp = v.getDefiningOp<ConvertLayoutOp>())
+      return cvtOp.getSrc();
+    return v;
+  };
+  auto iterArg = skipCvt(dotOp.getC()).dyn_cast<BlockArgument>();
+  if (!iterArg || iterArg.getOwner() != forOp.getBody() ||
+      iterArg.getArgNumber() < forOp.getNumInductionVars())
+    return;
+  unsigned index = iterArg.getArgNumber() - forOp.getNumInductionVars();
+  auto yieldOp = cast<scf::YieldOp>(forOp.getBody()->getTerminator());
+  if (skipCvt(yieldOp.getOperand(index)) != dotOp.getResult())
+    return;
+
+  Location loc = dotOp.getLoc();
+  OpBuilder builder(forOp);
+  Value zero = builder.create<arith::ConstantOp>(loc, dType,
+                                                 builder.getZeroAttr(dType));
+  scf::ForOp newLoop = replaceForOpWithNewSignature(builder, forOp, {zero});
+  forOp.erase();
+  Value partial = newLoop.getBody()->getArguments().back();
+  Value acc = dotOp.getC();
+  dotOp.getCMutable().assign(partial);
+
+  // Promoted on the iterations `period - 1`, `2 * period - 1`, ...
+  builder.setInsertionPointAfter(dotOp);
+  int64_t period = maxNumImpreciseAcc / K;
+  Value iv = newLoop.getInductionVar();
+  auto cst = [&](int64_t value) -> Value {
+    return builder.create<arith::ConstantOp>(
+        loc, builder.getIntegerAttr(iv.getType(), value));
+  };
+  Value iter = builder.create<arith::DivSIOp>(
+      loc, builder.create<arith::SubIOp>(loc, iv, newLoop.getLowerBound()),
+      newLoop.getStep());
+  Value promote = builder.create<arith::CmpIOp>(
+      loc, arith::CmpIPredicate::eq,
+      builder.create<arith::RemSIOp>(loc, iter, cst(period)),
+      cst(period - 1));
+  promote = builder.create<tt::SplatOp>(
+      loc,
+      RankedTensorType::get(dType.getShape(), builder.getI1Type(), mmaEnc),
+      promote);
+  Value sum = builder.create<arith::AddFOp>(loc, acc, dotOp.getResult());
+  Value newAcc = builder.create<arith::SelectOp>(loc, promote, sum, acc);
+  Value newPartial =
+      builder.create<arith::SelectOp>(loc, promote, zero, dotOp.getResult());
+  dotOp.getResult().replaceAllUsesExcept(
+      newAcc, SmallPtrSet<Operation *, 2>{sum.getDefiningOp(),
+                                          newPartial.getDefiningOp()});
+  auto newYieldOp = cast<scf::YieldOp>(newLoop.getBody()->getTerminator());
+  newYieldOp->insertOperands(newYieldOp->getNumOperands(), newPartial);
+
+  // The iterations since the last promotion
+  builder.setInsertionPointAfter(newLoop);
+  Value result = newLoop.getResult(index);
+  Value rest = newLoop.getResults().back();
+  if (rest.getType() != result.getType())
+    rest = builder.create<ConvertLayoutOp>(loc, result.getType(), rest);
+  Value finalAcc = builder.create<arith::AddFOp>(loc, result, rest);
+  result.replaceAllUsesExcept(finalAcc, finalAcc.getDefiningOp());
+}
+
 #define GEN_PASS_CLASSES
 #include "triton/Dialect/TritonGPU/Transforms/Passes.h.inc"
 
@@ -396,12 +679,18 @@ public:
 
     mlir::RewritePatternSet patterns(context);
     patterns.add<::BlockedToMMA>(context, computeCapability);
+    patterns.add<::SparseBlockedToMMA>(context, computeCapability);
     if (applyPatternsAndFoldGreedily(m, std::move(patterns)).failed()) {
       signalPassFailure();
     }
     // now that we pick the mma type decompose dot that are not natively
     // supported.
     decomposeMixedModeDotOp(m);
+
+    SmallVector<tt::DotOp> dotOps;
+    m.walk([&](tt::DotOp dotOp) { dotOps.push_back(dotOp); });
+    for (tt::DotOp dotOp : dotOps)
+      promoteImpreciseAccumulator(dotOp);
   }
 };
 
@@ -0,0 +1,102 @@
+#include "mlir/Dialect/LLVMIR/LLVMDialect.h"
+#include "mlir/Dialect/SCF/IR/SCF.h"
+#include "triton/Dialect/TritonGPU/IR/Dialect.h"
+#include "triton/Dialect/TritonGPU/Transforms/Passes.h"
+
+#include <algorithm>
+
+//===----------------------------------------------------------------------===//
+// Profile-guided branch weights. An instrumented build counts, once per
+// program, how often each `scf.if` is reached and how often its then region
+// runs. The runtime reads the counters back and saves them as the branch
+// profile of the kernel, which a later build of the same module attaches to
+// the conditions of the branches as `llvm.intr.expect.with.probability`.
+//
+// The branches are numbered in walk order, so both passes have to run on the
+// same module, at the same point of the pipeline.
+//===----------------------------------------------------------------------===//
+
+using namespace mlir;
+namespace ttg = triton::gpu;
+
+#define GEN_PASS_CLASSES
+#include "triton/Dialect/TritonGPU/Transforms/Passes.h.inc"
+
+namespace {
+
+SmallVector<scf::IfOp> getBranches(ModuleOp mod) {
+  SmallVector<scf::IfOp> branches;
+  mod.walk<WalkOrder::PreOrder>(
+      [&](scf::IfOp ifOp) { branches.push_back(ifOp); });
+  return branches;
+}
+
+} // anonymous namespace
+
+class TritonGPUInstrumentBranchesPass
+    : public TritonGPUInstrumentBranchesBase<TritonGPUInstrumentBranchesPass> {
+public:
+  TritonGPUInstrumentBranchesPass() = default;
+
+  void runOnOperation() override {
+    ModuleOp mod = getOperation();
+    SmallVector<scf::IfOp> branches = getBranches(mod);
+    for (unsigned i = 0; i < branches.size(); ++i) {
+      scf::IfOp ifOp = branches[i];
+      OpBuilder builder(ifOp);
+      builder.create<ttg::ProfileCounterOp>(ifOp.getLoc(), 2 * i);
+      builder.setInsertionPointToStart(ifOp.thenBlock());
+      builder.create<ttg::ProfileCounterOp>(ifOp.getLoc(), 2 * i + 1);
+    }
+    mod->setAttr("triton_gpu.num-branch-counters",
+                 IntegerAttr::get(IntegerType::get(mod.getContext(), 32),
+                                  2 * branches.size()));
+  }
+};
+
+class TritonGPUApplyBranchProfilePass
+    : public TritonGPUApplyBranchProfileBase<TritonGPUApplyBranchProfilePass> {
+public:
+  TritonGPUApplyBranchProfilePass() = default;
+  TritonGPUApplyBranchProfilePass(ArrayRef<int64_t> counts) {
+    this->counts = counts;
+  }
+
+  void runOnOperation() override {
+    ModuleOp mod = getOperation();
+    SmallVector<scf::IfOp> branches = getBranches(mod);
+    // A profile of another module
+    if (counts.size() != 2 * branches.size()) {
+      mod.emitWarning("branch profile of ")
+          << counts.size() << " counters doesn't match the "
+          << branches.size() << " branches of the module, ignoring it";
+      return;
+    }
+    for (unsigned i = 0; i < branches.size(); ++i) {
+      scf::IfOp ifOp = branches[i];
+      int64_t reached = counts[2 * i];
+      int64_t taken = counts[2 * i + 1];
+      if (reached <= 0)
+        continue;
+      double probability =
+          std::clamp(static_cast<double>(taken) / reached, 0.0, 1.0);
+      OpBuilder builder(ifOp);
+      Location loc = ifOp.getLoc();
+      Value cond = ifOp.getCondition();
+      Value expected = builder.create<arith::ConstantIntOp>(loc, 1, 1);
+      Value weighted = builder.create<LLVM::ExpectWithProbabilityOp>(
+          loc, cond.getType(), cond, expected,
+          builder.getF64FloatAttr(probability));
+      ifOp.getConditionMutable().assign(weighted);
+    }
+  }
+};
+
+std::unique_ptr<Pass> mlir::triton::gpu::createInstrumentBranchesPass() {
+  return std::make_unique<TritonGPUInstrumentBranchesPass>();
+}
+
+std::unique_ptr<Pass>
+mlir::triton::gpu::createApplyBranchProfilePass(ArrayRef<int64_t> counts) {
+  return std::make_unique<TritonGPUApplyBranchProfilePass>(counts);
+}
@@ -1,9 +1,12 @@
 #include "mlir/Analysis/SliceAnalysis.h"
+#include "mlir/IR/Threading.h"
 #include "triton/Analysis/AxisInfo.h"
 #include "triton/Analysis/Utility.h"
 #include "triton/Dialect/TritonGPU/IR/Dialect.h"
 #include "triton/Dialect/TritonGPU/Transforms/Passes.h"
+#include "triton/Dialect/TritonGPU/Transforms/Utility.h"
 #include "llvm/Support/Debug.h"
+#include <algorithm>
 #include <iterator>
 #include <numeric>
 
@@ -17,14 +20,6 @@ using namespace mlir::triton;
 #define GEN_PASS_CLASSES
 #include "triton/Dialect/TritonGPU/Transforms/Passes.h.inc"
 
-template <class T> SmallVector<unsigned, 4> argSort(const T &arr) {
-  SmallVector<unsigned, 4> ret(arr.size());
-  std::iota(ret.begin(), ret.end(), 0);
-  std::stable_sort(ret.begin(), ret.end(),
-                   [&](unsigned x, unsigned y) { return arr[x] > arr[y]; });
-  return ret;
-}
-
 // Type of val can be either Tensor Pointer or Tensor.
 static RankedTensorType getTensorType(const Value &val) {
   auto valType = val.getType();
@@ -54,6 +49,8 @@ static Value getMemAccessPtr(Operation *op) {
     return insert.getSrc();
   if (auto store = dyn_cast<triton::StoreOp>(op))
     return store.getPtr();
+  if (auto prefetch = dyn_cast<triton::PrefetchOp>(op))
+    return prefetch.getPtr();
   return nullptr;
 }
 
@@ -98,7 +95,7 @@ struct CoalescePass : public TritonGPUCoalesceBase<CoalescePass> {
     } else {
       // Normal cases
       auto contiguity = axisInfoAnalysis.getAxisInfo(ptr)->getContiguity();
-      order = argSort(contiguity);
+      order = getContiguityOrder(contiguity, refTensorType.getShape());
       LLVM_DEBUG({
         DBGS() << "contiguity is: ";
         for (const auto &O : contiguity) {
@@ -135,8 +132,9 @@ struct CoalescePass : public TritonGPUCoalesceBase<CoalescePass> {
         Value val = getMemAccessPtr(use);
         if (!val || !matchesShape(val) || memAccessesSameOrder.contains(use))
           continue;
-        auto currOrder =
-            argSort(axisInfoAnalysis.getAxisInfo(val)->getContiguity());
+        auto currOrder = getContiguityOrder(
+            axisInfoAnalysis.getAxisInfo(val)->getContiguity(),
+            refTensorType.getShape());
         if (order == currOrder) {
           LDBG("multi-root-slice: insert to memAccessesSameOrder " << *use);
           memAccessesSameOrder.insert(use);
@@ -265,15 +263,12 @@ struct CoalescePass : public TritonGPUCoalesceBase<CoalescePass> {
     op->erase();
   }
 
-  void runOnOperation() override {
-    // Run axis info analysis
-    ModuleOp moduleOp = getOperation();
-    ModuleAxisInfoAnalysis axisInfoAnalysis(moduleOp);
-
+  void coalesceFunc(ModuleAxisInfoAnalysis &axisInfoAnalysis,
+                    triton::FuncOp funcOp, int numWarps, int threadsPerWarp) {
     // For each i/o operation, we determine what layout
     // the pointers should have for best memory coalescing
     llvm::MapVector<Operation *, Attribute> layoutMap;
-    moduleOp.walk([&](Operation *curr) {
+    funcOp.walk([&](Operation *curr) {
       Value ptr = getMemAccessPtr(curr);
       if (!ptr)
         return;
@@ -285,10 +280,6 @@ struct CoalescePass : public TritonGPUCoalesceBase<CoalescePass> {
         isTensorPointer = ptrType.getPointeeType().isa<RankedTensorType>();
       if (!isPtrTensor && !isTensorPointer)
         return;
-      auto mod = curr->getParentOfType<ModuleOp>();
-      int numWarps = triton::gpu::TritonGPUDialect::getNumWarps(mod);
-      int threadsPerWarp =
-          triton::gpu::TritonGPUDialect::getThreadsPerWarp(mod);
       setCoalescedEncoding(axisInfoAnalysis, curr, numWarps, threadsPerWarp,
                            layoutMap);
     });
@@ -304,6 +295,25 @@ struct CoalescePass : public TritonGPUCoalesceBase<CoalescePass> {
       coalesceOp(kv.second, kv.first);
     }
   }
+
+  void runOnOperation() override {
+    // Run axis info analysis, unless the previous passes preserved it. It is
+    // inter-procedural, so it has to run on the whole module, but it is only
+    // read from then on.
+    ModuleOp moduleOp = getOperation();
+    ModuleAxisInfoAnalysis &axisInfoAnalysis =
+        getAnalysis<ModuleAxisInfoAnalysis>();
+    int numWarps = triton::gpu::TritonGPUDialect::getNumWarps(moduleOp);
+    int threadsPerWarp =
+        triton::gpu::TritonGPUDialect::getThreadsPerWarp(moduleOp);
+
+    // Functions are rewritten independently of each other, in parallel when
+    // the context allows it.
+    SmallVector<triton::FuncOp> funcOps(moduleOp.getOps<triton::FuncOp>());
+    parallelForEach(&getContext(), funcOps, [&](triton::FuncOp funcOp) {
+      coalesceFunc(axisInfoAnalysis, funcOp, numWarps, threadsPerWarp);
+    });
+  }
 };
 
 std::unique_ptr<Pass> mlir::triton::gpu::createCoalescePass() {
@@ -28,8 +28,8 @@ public:
   TritonGPUDecomposeConversionsPass() = default;
 
   void runOnOperation() override {
-    ModuleOp mod = getOperation();
-    mod.walk([&](triton::gpu::ConvertLayoutOp cvtOp) -> void {
+    triton::FuncOp funcOp = getOperation();
+    funcOp.walk([&](triton::gpu::ConvertLayoutOp cvtOp) -> void {
       OpBuilder builder(cvtOp);
       auto srcType = cvtOp.getOperand().getType().cast<RankedTensorType>();
       auto dstType = cvtOp.getType().cast<RankedTensorType>();
@@ -44,14 +44,15 @@ public:
               srcEncoding.dyn_cast<triton::gpu::NvidiaMmaEncodingAttr>()) {
 
         if (srcMmaEncoding.getVersionMajor() == 1 ||
-            (srcMmaEncoding.getWarpsPerCTA()[1] == 1 &&
+            (srcType.getRank() == 2 &&
+             srcMmaEncoding.getWarpsPerCTA()[1] == 1 &&
              dstDotOp.getParent() == srcMmaEncoding))
           return;
       }
       auto tmpType = RankedTensorType::get(
           dstType.getShape(), dstType.getElementType(),
           triton::gpu::SharedEncodingAttr::get(
-              mod.getContext(), dstDotOp, srcType.getShape(),
+              funcOp.getContext(), dstDotOp, srcType.getShape(),
               triton::gpu::getOrder(srcEncoding),
               triton::gpu::getCTALayout(srcEncoding),
               srcType.getElementType()));
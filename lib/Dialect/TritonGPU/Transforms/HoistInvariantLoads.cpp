@@ -0,0 +1,219 @@
+#include "mlir/Dialect/SCF/IR/SCF.h"
+#include "mlir/Interfaces/SideEffectInterfaces.h"
+#include "triton/Analysis/AxisInfo.h"
+#include "triton/Analysis/BankConflicts.h"
+#include "triton/Analysis/RegisterPressure.h"
+#include "triton/Dialect/TritonGPU/IR/Dialect.h"
+#include "triton/Dialect/TritonGPU/Transforms/Passes.h"
+
+//===----------------------------------------------------------------------===//
+// This pass hoists the loads of a loop whose pointers, masks and other values
+// are loop-invariant, like the scales of a dequantization or a bias vector:
+// LICM doesn't move them as they read memory. They are only hoisted when the
+// loop doesn't write memory, so that every iteration would load the same
+// values. Unless the ranges of the bounds show that the loop runs, the
+// hoisted loads are masked by its trip count.
+//
+// The hoisted values are kept in registers across the loop, or staged in
+// shared memory and read back where they were loaded when the registers of
+// the loop would exceed the register file.
+//===----------------------------------------------------------------------===//
+
+using namespace mlir;
+namespace ttg = triton::gpu;
+
+#define GEN_PASS_CLASSES
+#include "triton/Dialect/TritonGPU/Transforms/Passes.h.inc"
+
+namespace {
+
+// Whether no iteration of `forOp` writes memory or synchronizes.
+bool isReadOnly(scf::ForOp forOp) {
+  auto result = forOp.getBody()->walk([](Operation *op) {
+    // The nested ops are visited on their own, the prefetches only change
+    // the timing of the loads
+    if (op->hasTrait<OpTrait::HasRecursiveMemoryEffects>() ||
+        isMemoryEffectFree(op) || isa<triton::PrefetchOp>(op))
+      return WalkResult::advance();
+    auto memInterface = dyn_cast<MemoryEffectOpInterface>(op);
+    if (memInterface && memInterface.onlyHasEffect<MemoryEffects::Read>())
+      return WalkResult::advance();
+    return WalkResult::interrupt();
+  });
+  return !result.wasInterrupted();
+}
+
+// Whether the ranges of the bounds of `forOp` show that it runs.
+bool runsAtLeastOnce(scf::ForOp forOp,
+                     ModuleAxisInfoAnalysis &axisInfoAnalysis) {
+  AxisInfo *lbInfo = axisInfoAnalysis.getAxisInfo(forOp.getLowerBound());
+  AxisInfo *ubInfo = axisInfoAnalysis.getAxisInfo(forOp.getUpperBound());
+  if (!lbInfo || !ubInfo || !lbInfo->getRange() || !ubInfo->getRange())
+    return false;
+  return lbInfo->getRange()->second < ubInfo->getRange()->first;
+}
+
+// Masks the hoisted `loadOp` by `runs`, true if its loop runs.
+void maskByTripCount(triton::LoadOp loadOp, Value runs) {
+  OpBuilder builder(loadOp);
+  Location loc = loadOp.getLoc();
+  Value mask = runs;
+  if (auto tensorTy = loadOp.getType().dyn_cast<RankedTensorType>())
+    mask = builder.create<triton::SplatOp>(
+        loc,
+        RankedTensorType::get(tensorTy.getShape(), builder.getI1Type(),
+                              tensorTy.getEncoding()),
+        runs);
+  if (Value oldMask = loadOp.getMask())
+    mask = builder.create<arith::AndIOp>(loc, oldMask, mask);
+  loadOp.getMaskMutable().assign(mask);
+}
+
+// Returns the MMAv2 dot operand layout all the uses of `value` are converted
+// to, if any.
+ttg::DotOperandEncodingAttr getMMAv2OperandEncoding(Value value) {
+  ttg::DotOperandEncodingAttr dotOpEnc;
+  for (Operation *user : value.getUsers()) {
+    auto cvtOp = dyn_cast<ttg::ConvertLayoutOp>(user);
+    if (!cvtOp)
+      return {};
+    auto enc = cvtOp.getType()
+                   .cast<RankedTensorType>()
+                   .getEncoding()
+                   .dyn_cast<ttg::DotOperandEncodingAttr>();
+    auto mmaEnc =
+        enc ? enc.getParent().dyn_cast<ttg::NvidiaMmaEncodingAttr>() : nullptr;
+    if (!mmaEnc || !mmaEnc.isAmpere() || (dotOpEnc && enc != dotOpEnc))
+      return {};
+    dotOpEnc = enc;
+  }
+  return dotOpEnc;
+}
+
+// Whether a use of `value` is converted to a dot operand layout, which can
+// only be read from the shared layouts of the dot.
+bool feedsDotOperand(Value value) {
+  return llvm::any_of(value.getUsers(), [](Operation *user) {
+    auto cvtOp = dyn_cast<ttg::ConvertLayoutOp>(user);
+    return cvtOp && cvtOp.getType()
+                        .cast<RankedTensorType>()
+                        .getEncoding()
+                        .isa<ttg::DotOperandEncodingAttr>();
+  });
+}
+
+// Stages the hoisted `loadOp` in shared memory and reads it back at
+// `readPoint`, where it was loaded. Returns false if its layout can't be.
+bool stageInSharedMemory(triton::LoadOp loadOp, Operation *readPoint) {
+  auto ty = loadOp.getType().dyn_cast<RankedTensorType>();
+  if (!ty || !ty.getEncoding() || !ttg::isaDistributedLayout(ty.getEncoding()))
+    return false;
+  auto order = ttg::getOrder(ty.getEncoding());
+  auto CTALayout = ttg::getCTALayout(ty.getEncoding());
+  ttg::SharedEncodingAttr sharedEnc;
+  ttg::DotOperandEncodingAttr dotOpEnc = getMMAv2OperandEncoding(loadOp);
+  if (dotOpEnc)
+    sharedEnc = ttg::SharedEncodingAttr::get(
+        ty.getContext(), dotOpEnc, ty.getShape(), order, CTALayout,
+        ty.getElementType().getIntOrFloatBitWidth(), /*needTrans=*/false);
+  else if (!feedsDotOperand(loadOp))
+    sharedEnc = chooseSharedEncoding(ty, {ty}, order, CTALayout);
+  if (!sharedEnc)
+    return false;
+
+  OpBuilder builder(loadOp);
+  builder.setInsertionPointAfter(loadOp);
+  Location loc = loadOp.getLoc();
+  auto sharedTy =
+      RankedTensorType::get(ty.getShape(), ty.getElementType(), sharedEnc);
+  Value shared = builder.create<ttg::ConvertLayoutOp>(loc, sharedTy, loadOp);
+  if (dotOpEnc) {
+    // Read the dot operands straight from shared memory
+    for (Operation *user : llvm::to_vector(loadOp->getUsers()))
+      user->setOperand(0, shared);
+    return true;
+  }
+  builder.setInsertionPoint(readPoint);
+  Value value = builder.create<ttg::ConvertLayoutOp>(loc, ty, shared);
+  loadOp.getResult().replaceAllUsesExcept(value, shared.getDefiningOp());
+  return true;
+}
+
+// Hoists the invariant loads of `forOp`. `loopRegisters` is the estimated
+// register pressure of the loop, updated with the hoisted values kept in
+// registers.
+void hoistInvariantLoads(scf::ForOp forOp, unsigned &loopRegisters,
+                         ModuleAxisInfoAnalysis &axisInfoAnalysis) {
+  if (!isReadOnly(forOp))
+    return;
+  SmallVector<triton::LoadOp> loadOps;
+  // Only the loads running on every iteration, which can't fault past the
+  // masks of their first one
+  for (auto loadOp : forOp.getBody()->getOps<triton::LoadOp>())
+    if (!loadOp.getIsVolatile() &&
+        llvm::all_of(loadOp->getOperands(), [&](Value operand) {
+          return forOp.isDefinedOutsideOfLoop(operand);
+        }))
+      loadOps.push_back(loadOp);
+  if (loadOps.empty())
+    return;
+
+  Value runs;
+  if (!runsAtLeastOnce(forOp, axisInfoAnalysis)) {
+    // The tensor pointers of a loop that doesn't run may be out of bounds,
+    // and their loads have no mask
+    llvm::erase_if(loadOps, [](triton::LoadOp loadOp) {
+      return triton::isTensorPointerType(loadOp.getPtr().getType());
+    });
+    if (loadOps.empty())
+      return;
+    OpBuilder builder(forOp);
+    runs = builder.create<arith::CmpIOp>(
+        forOp.getLoc(), arith::CmpIPredicate::slt, forOp.getLowerBound(),
+        forOp.getUpperBound());
+  }
+  for (triton::LoadOp loadOp : loadOps) {
+    Operation *readPoint = loadOp->getNextNode();
+    loadOp->moveBefore(forOp);
+    if (runs)
+      maskByTripCount(loadOp, runs);
+    unsigned registers = getNumRegisters(loadOp.getType());
+    if (loopRegisters + registers > kMaxRegistersPerThread &&
+        stageInSharedMemory(loadOp, readPoint))
+      continue;
+    loopRegisters += registers;
+  }
+}
+
+} // anonymous namespace
+
+class TritonGPUHoistInvariantLoadsPass
+    : public TritonGPUHoistInvariantLoadsBase<
+          TritonGPUHoistInvariantLoadsPass> {
+public:
+  TritonGPUHoistInvariantLoadsPass() = default;
+
+  void runOnOperation() override {
+    ModuleOp m = getOperation();
+    ModuleAxisInfoAnalysis &axisInfoAnalysis =
+        getAnalysis<ModuleAxisInfoAnalysis>();
+    m.walk([&](triton::FuncOp funcOp) {
+      // Inner loops first, their hoisted loads may be invariant in the outer
+      // ones
+      SmallVector<scf::ForOp> loops;
+      funcOp.walk([&](scf::ForOp forOp) { loops.push_back(forOp); });
+      if (loops.empty())
+        return;
+      RegisterPressureAnalysis pressure(funcOp);
+      DenseMap<Operation *, unsigned> loopRegisters;
+      for (scf::ForOp forOp : loops)
+        loopRegisters[forOp] = pressure.getMaxRegisters(forOp);
+      for (scf::ForOp forOp : loops)
+        hoistInvariantLoads(forOp, loopRegisters[forOp], axisInfoAnalysis);
+    });
+  }
+};
+
+std::unique_ptr<Pass> mlir::triton::gpu::createHoistInvariantLoadsPass() {
+  return std::make_unique<TritonGPUHoistInvariantLoadsPass>();
+}
@@ -50,7 +50,9 @@ public:
     // encodings
     auto argEncoding = argType.getEncoding();
     auto XEncoding =
-        XType.getEncoding().cast<triton::gpu::SharedEncodingAttr>();
+        XType.getEncoding().dyn_cast<triton::gpu::SharedEncodingAttr>();
+    if (!XEncoding)
+      return mlir::failure();
     auto ZEncoding =
         ZType.getEncoding().dyn_cast<triton::gpu::DotOperandEncodingAttr>();
     if (!ZEncoding)
@@ -195,7 +197,9 @@ public:
     // encodings
     auto argEncoding = argType.getEncoding();
     auto XEncoding =
-        XType.getEncoding().cast<triton::gpu::SharedEncodingAttr>();
+        XType.getEncoding().dyn_cast<triton::gpu::SharedEncodingAttr>();
+    if (!XEncoding)
+      return mlir::failure();
     auto ZEncoding =
         ZType.getEncoding().dyn_cast<triton::gpu::SharedEncodingAttr>();
     if (!ZEncoding)
@@ -238,6 +242,11 @@ public:
   }
 };
 
+// Feeds operand A of a MMAv3 dot to wgmma from registers when it is computed
+// in them, like the probabilities of an attention or dequantized weights,
+// rather than storing it to shared memory and reading it back. An A that isn't
+// in a MMAv3 layout yet is converted to the one of a dot of its shape, which
+// the layout conversions can then propagate to its producers.
 struct MMAV3UseRegOperand : public OpRewritePattern<triton::DotOp> {
   using OpRewritePattern<triton::DotOp>::OpRewritePattern;
 
@@ -252,26 +261,47 @@ struct MMAV3UseRegOperand : public OpRewritePattern<triton::DotOp> {
     };
     if (!getEncoding(dotOp.getOperand(0)).isa<SharedEncodingAttr>())
       return failure();
-    auto srcEncoding =
-        getEncoding(convertLhs.getSrc()).dyn_cast<NvidiaMmaEncodingAttr>();
     auto dstEncoding =
         getEncoding(dotOp.getResult()).dyn_cast<NvidiaMmaEncodingAttr>();
-    if (!srcEncoding || srcEncoding.getVersionMajor() != 3 || !dstEncoding ||
-        dstEncoding.getVersionMajor() != 3)
+    if (!dstEncoding || dstEncoding.getVersionMajor() != 3)
       return failure();
     // We currently only support convert from f16 and bf16 mma to f16 and bf16
     // dot operand as the other types require shuffling data across threads.
     // TODO: extend it to more types.
-    auto srcType = convertLhs.getSrc().getType().cast<RankedTensorType>();
+    Value src = convertLhs.getSrc();
+    auto srcType = src.getType().cast<RankedTensorType>();
     if (!(srcType.getElementType().isF16() ||
           srcType.getElementType().isBF16()))
       return failure();
+    auto srcEncoding = srcType.getEncoding().dyn_cast<NvidiaMmaEncodingAttr>();
+    if (!srcEncoding) {
+      // The loaded operands are better read from shared memory, where the
+      // pipeliner copies them asynchronously
+      Operation *defOp = src.getDefiningOp();
+      if (!defOp || !defOp->hasTrait<OpTrait::Elementwise>() ||
+          !triton::gpu::isaDistributedLayout(srcType.getEncoding()))
+        return failure();
+      srcEncoding = NvidiaMmaEncodingAttr::get(
+          dotOp.getContext(), /*versionMajor=*/3, /*versionMinor=*/0,
+          dstEncoding.getWarpsPerCTA(), dstEncoding.getCTALayout(),
+          mmaVersionToInstrShape(3, triton::gpu::getShapePerCTA(srcType),
+                                 srcType));
+    } else if (srcEncoding.getVersionMajor() != 3) {
+      return failure();
+    }
+    auto mmaType = RankedTensorType::get(
+        srcType.getShape(), srcType.getElementType(), srcEncoding);
     auto dotOperandEncoding =
         DotOperandEncodingAttr::get(dotOp.getContext(), 0, srcEncoding, 0);
     auto newType = RankedTensorType::get(
         srcType.getShape(), srcType.getElementType(), dotOperandEncoding);
-    Value newOperand = rewriter.create<ConvertLayoutOp>(dotOp.getLoc(), newType,
-                                                        convertLhs.getSrc());
+    // Other conversions would go through shared memory anyway
+    if (!isMmaToDotShortcut(mmaType, newType))
+      return failure();
+    if (mmaType != srcType)
+      src = rewriter.create<ConvertLayoutOp>(convertLhs.getLoc(), mmaType, src);
+    Value newOperand =
+        rewriter.create<ConvertLayoutOp>(dotOp.getLoc(), newType, src);
     rewriter.updateRootInPlace(dotOp,
                                [&]() { dotOp.setOperand(0, newOperand); });
     return success();
@@ -21,6 +21,7 @@
  * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
  */
 
+#include "mlir/IR/IRMapping.h"
 #include "mlir/IR/Matchers.h"
 #include "mlir/IR/PatternMatch.h"
 #include "mlir/Pass/Pass.h"
@@ -28,7 +29,10 @@
 #include "mlir/Support/LogicalResult.h"
 #include "mlir/Transforms/GreedyPatternRewriteDriver.h"
 #include "mlir/Transforms/Passes.h"
+#include "triton/Analysis/AxisInfo.h"
+#include "triton/Analysis/BankConflicts.h"
 #include "triton/Dialect/TritonGPU/IR/Dialect.h"
+#include "triton/Dialect/TritonGPU/IR/LinearLayoutConversions.h"
 #include "triton/Dialect/TritonGPU/Transforms/Passes.h"
 #include "triton/Dialect/TritonGPU/Transforms/Utility.h"
 
@@ -36,6 +40,77 @@ using namespace mlir;
 
 namespace {
 
+// The bytes of the memory transactions of global stores
+constexpr unsigned kSectorBytes = 32;
+// The widest vector a thread stores with
+constexpr unsigned kMaxStoreBytes = 16;
+// Shared memory wavefronts a global store transaction costs about as much as
+constexpr unsigned kWavefrontsPerSector = 4;
+
+// Returns the number of sectors a warp stores the tensor `type` to, when its
+// elements are consecutive in memory in chunks of `contiguity` elements
+// along `dim`, and far apart otherwise. Returns std::nullopt if the layout of
+// `type` has no linear layout.
+std::optional<unsigned> getStoreSectors(RankedTensorType type, unsigned dim,
+                                        unsigned contiguity) {
+  std::optional<triton::LinearLayout> layout =
+      triton::gpu::toLinearLayout(type);
+  if (!layout)
+    return std::nullopt;
+  using InDim = triton::LinearLayout::InDim;
+  unsigned elemBytes = std::max(type.getElementTypeBitWidth() / 8, 1u);
+  // The first registers of a thread are stored together if they are
+  // consecutive along `dim`
+  unsigned vec = 1;
+  for (const auto &basis : layout->getBases(InDim::Register)) {
+    if (vec >= contiguity || vec * elemBytes >= kMaxStoreBytes)
+      break;
+    auto next = basis;
+    bool isNext = next[dim] == static_cast<int32_t>(vec);
+    next[dim] = 0;
+    if (!isNext || llvm::any_of(next, [](int32_t x) { return x != 0; }))
+      break;
+    vec *= 2;
+  }
+  unsigned elemsPerSector = std::max(kSectorBytes / elemBytes, 1u);
+  unsigned numLanes = 1u << layout->getNumBits(InDim::Lane);
+  unsigned sectors = 0;
+  SmallVector<SmallVector<int64_t>> keys;
+  for (unsigned reg = 0; reg < layout->getNumRegisters(); reg += vec) {
+    keys.clear();
+    for (unsigned lane = 0; lane < numLanes; ++lane) {
+      for (unsigned i = reg; i < reg + vec; ++i) {
+        auto coords = layout->apply(i, lane, 0);
+        SmallVector<int64_t> key(coords.begin(), coords.end());
+        int64_t offset = coords[dim] % contiguity;
+        key[dim] = coords[dim] / contiguity;
+        key.push_back(offset / elemsPerSector);
+        keys.push_back(std::move(key));
+      }
+    }
+    llvm::sort(keys);
+    sectors += std::unique(keys.begin(), keys.end()) - keys.begin();
+  }
+  return sectors;
+}
+
+// Returns the layout of shared memory to store `mmaTy` through to store
+// `valType` and the cost of the two, in wavefronts.
+std::optional<std::pair<triton::gpu::SharedEncodingAttr, unsigned>>
+getStagingCost(RankedTensorType mmaTy, RankedTensorType valType) {
+  auto sharedEnc = chooseSharedEncoding(
+      mmaTy, {valType}, triton::gpu::getOrder(valType.getEncoding()),
+      triton::gpu::getCTALayout(valType.getEncoding()));
+  if (!sharedEnc)
+    return std::nullopt;
+  auto storeCost = getSharedAccessCost(mmaTy, sharedEnc);
+  auto loadCost = getSharedAccessCost(valType, sharedEnc);
+  if (!storeCost || !loadCost)
+    return std::nullopt;
+  return std::make_pair(sharedEnc,
+                        storeCost->wavefronts + loadCost->wavefronts);
+}
+
 // convert(val) : mma -> blocked
 // tt.store(ptr, val, mask, ...) : blocked
 // ==>
@@ -43,12 +118,21 @@ namespace {
 // convert(mask) : blocked -> mma
 // tt.store(ptr, val, mask, ...) : mma
 //
-// Store with mma layout directly
+// Store with mma layout directly, unless the conversion is done with
+// stmatrix or the stores of the mma layout touch more sectors than staging
+// the tile in shared memory costs, as for transposed outputs. The tile is
+// then staged explicitly, in a swizzled layout:
+//
+// convert(val) : mma -> shared
+// convert(val) : shared -> blocked
+// tt.store(ptr, val, mask, ...) : blocked
 class BypassEpilogueSMEM : public mlir::RewritePattern {
 
 public:
-  explicit BypassEpilogueSMEM(mlir::MLIRContext *context)
-      : mlir::RewritePattern(triton::StoreOp::getOperationName(), 1, context) {}
+  BypassEpilogueSMEM(mlir::MLIRContext *context,
+                     ModuleAxisInfoAnalysis &axisInfoAnalysis)
+      : mlir::RewritePattern(triton::StoreOp::getOperationName(), 1, context),
+        axisInfoAnalysis(axisInfoAnalysis) {}
   mlir::LogicalResult
   matchAndRewrite(mlir::Operation *op,
                   mlir::PatternRewriter &rewriter) const override {
@@ -70,16 +154,34 @@ public:
     if (!cvtOp)
       return mlir::failure();
 
-    if (!cvtOp.getSrc()
-             .getType()
-             .cast<RankedTensorType>()
-             .getEncoding()
-             .isa<triton::gpu::NvidiaMmaEncodingAttr>())
+    auto mmaLayout = cvtOp.getSrc()
+                         .getType()
+                         .cast<RankedTensorType>()
+                         .getEncoding()
+                         .dyn_cast<triton::gpu::NvidiaMmaEncodingAttr>();
+    if (!mmaLayout)
+      return mlir::failure();
+
+    // 16-bit Hopper accumulators go through shared memory with stmatrix,
+    // which is cheaper than storing the mma layout to global memory
+    if (mmaLayout.isHopper() && valType.getElementTypeBitWidth() == 16)
       return mlir::failure();
 
     if (!cvtOp.getResult().hasOneUse())
       return mlir::failure();
 
+    auto mmaTy = cvtOp.getSrc().getType().cast<RankedTensorType>();
+    if (auto staging = getCheaperStaging(ptr, mmaTy, valType)) {
+      Value shared = rewriter.create<triton::gpu::ConvertLayoutOp>(
+          cvtOp.getLoc(),
+          RankedTensorType::get(mmaTy.getShape(), mmaTy.getElementType(),
+                                *staging),
+          cvtOp.getSrc());
+      rewriter.replaceOpWithNewOp<triton::gpu::ConvertLayoutOp>(
+          cvtOp, valType, shared);
+      return mlir::success();
+    }
+
     auto newEncoding =
         cvtOp.getOperand().getType().cast<RankedTensorType>().getEncoding();
 
@@ -103,6 +205,151 @@ public:
         stOp, newPtr, newVal, newMask, stOp.getCache(), stOp.getEvict());
     return mlir::success();
   }
+
+private:
+  // Returns the shared layout to stage the stores of `mmaTy` to `ptr`
+  // through, if it is cheaper than storing the mma layout.
+  std::optional<triton::gpu::SharedEncodingAttr>
+  getCheaperStaging(Value ptr, RankedTensorType mmaTy,
+                    RankedTensorType valType) const {
+    AxisInfo *axisInfo = axisInfoAnalysis.getAxisInfo(ptr);
+    if (!axisInfo)
+      return std::nullopt;
+    auto contiguity = axisInfo->getContiguity();
+    unsigned dim = llvm::max_element(contiguity) - contiguity.begin();
+    auto directSectors = getStoreSectors(mmaTy, dim, contiguity[dim]);
+    auto stagedSectors = getStoreSectors(valType, dim, contiguity[dim]);
+    auto staging = getStagingCost(mmaTy, valType);
+    if (!directSectors || !stagedSectors || !staging)
+      return std::nullopt;
+    if (*directSectors * kWavefrontsPerSector <=
+        *stagedSectors * kWavefrontsPerSector + staging->second)
+      return std::nullopt;
+    return staging->first;
+  }
+
+  ModuleAxisInfoAnalysis &axisInfoAnalysis;
+};
+
+// convert(acc) : mma -> blocked
+// %x = elementwise(convert(acc), splat(...), ...) : blocked
+// tt.reduce(%x) : blocked
+// ==>
+// %x = elementwise(acc, splat(...), ...) : mma
+// convert(tt.reduce(%x) : mma) : slice(mma) -> slice(blocked)
+//
+// Reduce the accumulators of dots in the mma layout, as for the per-row
+// statistics of the outputs of matmuls, instead of converting the whole tile
+// to the blocked layout through shared memory. Only the reduced values are
+// converted. The elementwise ops between the conversion and the reduction are
+// recomputed in the mma layout, the other users of the conversion keep it.
+class FuseEpilogueReduction : public mlir::OpRewritePattern<triton::ReduceOp> {
+public:
+  using OpRewritePattern<triton::ReduceOp>::OpRewritePattern;
+
+  mlir::LogicalResult
+  matchAndRewrite(triton::ReduceOp op,
+                  mlir::PatternRewriter &rewriter) const override {
+    auto srcTy = op.getOperands()[0].getType().cast<RankedTensorType>();
+    if (srcTy.getRank() != 2 ||
+        !srcTy.getEncoding().isa<triton::gpu::BlockedEncodingAttr>())
+      return mlir::failure();
+    triton::gpu::NvidiaMmaEncodingAttr mmaLayout;
+    SetVector<Operation *> chain;
+    for (Value operand : op.getOperands())
+      if (!collectChain(operand, mmaLayout, chain))
+        return mlir::failure();
+    // The partial reductions of the CTAs are combined through distributed
+    // shared memory in the blocked layout only.
+    unsigned axis = op.getAxis();
+    if (!mmaLayout || !mmaLayout.supportReduction() ||
+        triton::gpu::getCTASplitNum(mmaLayout)[axis] != 1)
+      return mlir::failure();
+
+    // Recompute the chain in the mma layout, whose ops are collected after
+    // their operands
+    IRMapping mapping;
+    auto getMmaType = [&](Type type) -> Type {
+      auto tensorTy = type.cast<RankedTensorType>();
+      return RankedTensorType::get(tensorTy.getShape(),
+                                   tensorTy.getElementType(), mmaLayout);
+    };
+    for (Operation *chainOp : chain) {
+      if (auto cvt = dyn_cast<triton::gpu::ConvertLayoutOp>(chainOp)) {
+        mapping.map(cvt.getResult(), cvt.getSrc());
+        continue;
+      }
+      Operation *newOp = rewriter.clone(*chainOp, mapping);
+      if (auto cst = dyn_cast<arith::ConstantOp>(newOp)) {
+        auto value = cst.getValue().cast<SplatElementsAttr>();
+        auto newTy = getMmaType(value.getType()).cast<ShapedType>();
+        cst.setValueAttr(cast<TypedAttr>(value.resizeSplat(newTy)));
+      }
+      for (Value result : newOp->getResults())
+        result.setType(getMmaType(result.getType()));
+    }
+
+    SmallVector<Value> operands;
+    for (Value operand : op.getOperands())
+      operands.push_back(mapping.lookup(operand));
+    auto newReduce =
+        rewriter.create<triton::ReduceOp>(op.getLoc(), operands, axis);
+    Region &newCombine = newReduce.getCombineOp();
+    rewriter.cloneRegionBefore(op.getCombineOp(), newCombine,
+                               newCombine.end());
+    SmallVector<Value> results;
+    for (auto [result, newResult] :
+         llvm::zip(op.getResults(), newReduce.getResults()))
+      results.push_back(rewriter.create<triton::gpu::ConvertLayoutOp>(
+          op.getLoc(), result.getType(), newResult));
+    rewriter.replaceOp(op, results);
+    return mlir::success();
+  }
+
+private:
+  // Collects in `chain` the ops computing `val` from the conversions of mma
+  // accumulators, which must all have the layout `mmaLayout`, through
+  // elementwise ops without other users and splats. Returns false if some
+  // other op computes `val`.
+  static bool collectChain(Value val,
+                           triton::gpu::NvidiaMmaEncodingAttr &mmaLayout,
+                           SetVector<Operation *> &chain) {
+    Operation *def = val.getDefiningOp();
+    if (!def)
+      return false;
+    if (chain.contains(def))
+      return true;
+    if (auto cvt = dyn_cast<triton::gpu::ConvertLayoutOp>(def)) {
+      auto layout = cvt.getSrc()
+                        .getType()
+                        .cast<RankedTensorType>()
+                        .getEncoding()
+                        .dyn_cast<triton::gpu::NvidiaMmaEncodingAttr>();
+      if (!layout || (mmaLayout && layout != mmaLayout))
+        return false;
+      mmaLayout = layout;
+      chain.insert(def);
+      return true;
+    }
+    // Splats are cheap to recompute whatever their other users
+    auto cst = dyn_cast<arith::ConstantOp>(def);
+    if (isa<triton::SplatOp>(def) ||
+        (cst && cst.getValue().isa<SplatElementsAttr>())) {
+      chain.insert(def);
+      return true;
+    }
+    if (!def->hasTrait<OpTrait::Elementwise>() || !isMemoryEffectFree(def) ||
+        def->getNumResults() != 1 || !def->getResult(0).hasOneUse())
+      return false;
+    for (Value operand : def->getOperands()) {
+      if (!operand.getType().isa<RankedTensorType>())
+        continue;
+      if (!collectChain(operand, mmaLayout, chain))
+        return false;
+    }
+    chain.insert(def);
+    return true;
+  }
 };
 
 } // namespace
@@ -122,7 +369,9 @@ public:
 
     mlir::RewritePatternSet patterns(context);
 
-    patterns.add<BypassEpilogueSMEM>(context);
+    ModuleAxisInfoAnalysis axisInfoAnalysis(m);
+    patterns.add<BypassEpilogueSMEM>(context, axisInfoAnalysis);
+    patterns.add<FuseEpilogueReduction>(context);
 
     if (applyPatternsAndFoldGreedily(m, std::move(patterns)).failed()) {
       signalPassFailure();
@@ -1,3 +1,4 @@
+#include "mlir/IR/TypeUtilities.h"
 #include "mlir/Pass/Pass.h"
 #include "mlir/Pass/PassManager.h"
 #include "mlir/Transforms/GreedyPatternRewriteDriver.h"
@@ -13,8 +14,8 @@
 using namespace mlir;
 namespace {
 // Change the destination layout of reshape ops allowing reorder when used by a
-// reduction in order to minimize the amount of cross thread communication for
-// the reduction.
+// reduction or a scan in order to minimize the amount of cross thread
+// communication along their axis.
 struct OptimizeReshapeLayoutPattern
     : public mlir::OpRewritePattern<triton::ReshapeOp> {
   OptimizeReshapeLayoutPattern(mlir::MLIRContext *context)
@@ -27,14 +28,16 @@ struct OptimizeReshapeLayoutPattern
       return failure();
     std::optional<int> reductionAxis;
     for (Operation *user : viewOp.getResult().getUsers()) {
-      if (auto reduceOp = dyn_cast<triton::ReduceOp>(user)) {
-        if (reductionAxis) {
-          if (reductionAxis != reduceOp.getAxis())
-            return failure();
-        } else {
-          reductionAxis = reduceOp.getAxis();
-        }
-      }
+      std::optional<int> axis;
+      if (auto reduceOp = dyn_cast<triton::ReduceOp>(user))
+        axis = reduceOp.getAxis();
+      else if (auto scanOp = dyn_cast<triton::ScanOp>(user))
+        axis = scanOp.getAxis();
+      if (!axis)
+        continue;
+      if (reductionAxis && reductionAxis != axis)
+        return failure();
+      reductionAxis = axis;
     }
     if (!reductionAxis)
       return failure();
@@ -84,6 +87,175 @@ struct OptimizeReshapeLayoutPattern
   }
 };
 
+// A multi-operand reduction in a loop, like an argmax, whose results are
+// combined into accumulators carried by the loop with a copy of its combine
+// region:
+//
+//   %acc:2 = scf.for ... iter_args(%v = %cst, %i = %cst_0) {
+//     %r:2 = tt.reduce(%x, %idx) {axis = 1}
+//     %next:2 = combine(%v, %i, %r#0, %r#1)
+//     scf.yield %next#0, %next#1
+//   }
+struct LoopAccumulation {
+  triton::ReduceOp reduce;
+  scf::ForOp forOp;
+  // The ops of the loop computing the combine region, in its order
+  SmallVector<Operation *> updateOps;
+  // The iteration arguments of the accumulators, in the order of the operands
+  // of the reduction
+  SmallVector<BlockArgument> accumulators;
+};
+
+// Whether `op` of the loop computes `regionOp` of the combine region, given
+// the values of the loop the region values are mapped to. The unmapped
+// accumulator arguments are mapped to the iteration arguments of `forOp` in
+// `newAccumulators`.
+bool isSameOp(Operation *regionOp, Operation *op, const IRMapping &mapping,
+              scf::ForOp forOp, unsigned numOperands,
+              SmallVectorImpl<std::pair<Value, Value>> &newAccumulators) {
+  if (op->getName() != regionOp->getName() ||
+      op->getNumOperands() != regionOp->getNumOperands() ||
+      op->getNumResults() != regionOp->getNumResults() ||
+      op->getNumRegions() != 0 ||
+      op->getAttrDictionary() != regionOp->getAttrDictionary())
+    return false;
+  newAccumulators.clear();
+  for (auto [regionOperand, operand] :
+       llvm::zip(regionOp->getOperands(), op->getOperands())) {
+    if (Value mapped = mapping.lookupOrNull(regionOperand)) {
+      if (mapped != operand)
+        return false;
+      continue;
+    }
+    auto regionArg = dyn_cast<BlockArgument>(regionOperand);
+    auto arg = dyn_cast<BlockArgument>(operand);
+    if (!regionArg || regionArg.getArgNumber() >= numOperands || !arg ||
+        arg.getOwner() != forOp.getBody() ||
+        arg.getArgNumber() < forOp.getNumInductionVars())
+      return false;
+    newAccumulators.push_back({regionOperand, operand});
+  }
+  return true;
+}
+
+std::optional<LoopAccumulation> getLoopAccumulation(triton::ReduceOp reduce) {
+  auto forOp = dyn_cast<scf::ForOp>(reduce->getParentOp());
+  if (!forOp)
+    return std::nullopt;
+  unsigned numOperands = reduce.getNumOperands();
+  Block &combine = reduce.getCombineOp().front();
+  LoopAccumulation accumulation{reduce, forOp};
+  // The accumulators are the left-hand side of the combine region, the
+  // results of the reduction its right-hand side
+  IRMapping mapping;
+  for (unsigned i = 0; i < numOperands; ++i)
+    mapping.map(combine.getArgument(numOperands + i), reduce.getResult(i));
+  SmallVector<std::pair<Value, Value>> newAccumulators;
+  for (Operation &regionOp : combine.without_terminator()) {
+    Value anchor;
+    for (Value operand : regionOp.getOperands())
+      if ((anchor = mapping.lookupOrNull(operand)))
+        break;
+    if (!anchor)
+      return std::nullopt;
+    Operation *match = nullptr;
+    for (Operation *user : anchor.getUsers()) {
+      if (user->getBlock() == forOp.getBody() &&
+          isSameOp(&regionOp, user, mapping, forOp, numOperands,
+                   newAccumulators)) {
+        match = user;
+        break;
+      }
+    }
+    if (!match)
+      return std::nullopt;
+    for (auto [regionArg, arg] : newAccumulators)
+      mapping.map(regionArg, arg);
+    mapping.map(regionOp.getResults(), match->getResults());
+    accumulation.updateOps.push_back(match);
+  }
+
+  // Each accumulator is updated with the result of the region for it
+  auto yieldOp = cast<scf::YieldOp>(forOp.getBody()->getTerminator());
+  Operation *terminator = combine.getTerminator();
+  for (unsigned i = 0; i < numOperands; ++i) {
+    auto arg = dyn_cast_or_null<BlockArgument>(
+        mapping.lookupOrNull(combine.getArgument(i)));
+    if (!arg || llvm::is_contained(accumulation.accumulators, arg))
+      return std::nullopt;
+    unsigned index = arg.getArgNumber() - forOp.getNumInductionVars();
+    if (yieldOp.getOperand(index) !=
+        mapping.lookupOrNull(terminator->getOperand(i)))
+      return std::nullopt;
+    accumulation.accumulators.push_back(arg);
+  }
+
+  // The values of the accumulation aren't used anywhere else
+  DenseSet<Operation *> updateOps(accumulation.updateOps.begin(),
+                                  accumulation.updateOps.end());
+  auto onlyUsedByUpdate = [&](Value value) {
+    return llvm::all_of(value.getUsers(), [&](Operation *user) {
+      return updateOps.contains(user);
+    });
+  };
+  if (!llvm::all_of(reduce->getResults(), onlyUsedByUpdate) ||
+      !llvm::all_of(accumulation.accumulators, onlyUsedByUpdate))
+    return std::nullopt;
+  for (Operation *op : accumulation.updateOps)
+    for (OpOperand &use : op->getUses())
+      if (!updateOps.contains(use.getOwner()) &&
+          (use.getOwner() != yieldOp ||
+           !llvm::is_contained(
+               accumulation.accumulators,
+               forOp.getRegionIterArg(use.getOperandNumber()))))
+        return std::nullopt;
+  return accumulation;
+}
+
+// Returns the splat value the accumulator `arg` of `forOp` is initialized
+// with, if it is a constant.
+TypedAttr getSplatInit(scf::ForOp forOp, BlockArgument arg) {
+  auto cstOp =
+      forOp.getTiedLoopInit(arg)->get().getDefiningOp<arith::ConstantOp>();
+  if (!cstOp)
+    return {};
+  auto denseAttr = cstOp.getValue().dyn_cast<DenseElementsAttr>();
+  if (!denseAttr || !denseAttr.isSplat())
+    return {};
+  return denseAttr.getSplatValue<TypedAttr>();
+}
+
+// Whether combining `values` with themselves in `combine` gives them back, so
+// that they can seed any number of partial accumulators.
+bool isIdempotent(Region &combine, ArrayRef<TypedAttr> values) {
+  Block &block = combine.front();
+  DenseMap<Value, Attribute> constants;
+  for (auto [i, arg] : llvm::enumerate(block.getArguments()))
+    constants[arg] = values[i % values.size()];
+  for (Operation &op : block.without_terminator()) {
+    SmallVector<Attribute> operands;
+    for (Value operand : op.getOperands())
+      operands.push_back(constants.lookup(operand));
+    SmallVector<OpFoldResult> results;
+    if (failed(op.fold(operands, results)) ||
+        results.size() != op.getNumResults())
+      return false;
+    for (auto [result, folded] : llvm::zip(op.getResults(), results)) {
+      Attribute attr = folded.dyn_cast<Attribute>();
+      if (!attr)
+        attr = constants.lookup(folded.get<Value>());
+      if (!attr)
+        return false;
+      constants[result] = attr;
+    }
+  }
+  for (auto [value, operand] :
+       llvm::zip(values, block.getTerminator()->getOperands()))
+    if (constants.lookup(operand) != value)
+      return false;
+  return true;
+}
+
 } // namespace
 
 class TritonGPUOptimizeThreadLocalityPass
@@ -101,10 +273,16 @@ class TritonGPUOptimizeThreadLocalityPass
     }
 
     DenseSet<triton::ReduceOp> reduceOps;
+    SmallVector<LoopAccumulation> accumulations;
     mod.walk([&](triton::ReduceOp reduce) -> void {
       auto srcType = reduce.getOperands()[0].getType().cast<RankedTensorType>();
       auto rank = srcType.getShape().size();
       auto srcEncoding = srcType.getEncoding();
+      if (reduce.getNumOperands() > 1) {
+        if (auto accumulation = getMultiOperandAccumulation(reduce))
+          accumulations.push_back(*accumulation);
+        return;
+      }
       auto reductionOp = getReductionOp(reduce);
       if (!reductionOp ||
           !isa<arith::AddFOp, arith::MulFOp, arith::MaximumFOp,
@@ -148,6 +326,9 @@ class TritonGPUOptimizeThreadLocalityPass
       reduceOps.insert(reduce);
     });
 
+    for (LoopAccumulation &accumulation : accumulations)
+      optimizeLoopAccumulation(accumulation);
+
     for (auto reduce : reduceOps) {
       OpBuilder builder(reduce);
       auto srcType = reduce.getOperands()[0].getType().cast<RankedTensorType>();
@@ -223,6 +404,142 @@ class TritonGPUOptimizeThreadLocalityPass
   };
 
 private:
+  std::optional<LoopAccumulation>
+  getMultiOperandAccumulation(triton::ReduceOp reduce) const {
+    auto srcType = reduce.getOperands()[0].getType().cast<RankedTensorType>();
+    // TODO: relax this restriction
+    if (!srcType.getEncoding().isa<triton::gpu::BlockedEncodingAttr>() ||
+        srcType.getRank() < 2)
+      return std::nullopt;
+    if (triton::gpu::getElemsPerThread(srcType)[reduce.getAxis()] == 1)
+      return std::nullopt;
+    // The indices of an argmax are usually computed, not loaded
+    if (llvm::none_of(reduce.getOperands(), [](Value operand) {
+          return operand.getDefiningOp<triton::LoadOp>();
+        }))
+      return std::nullopt;
+    auto accumulation = getLoopAccumulation(reduce);
+    if (!accumulation)
+      return std::nullopt;
+    SmallVector<TypedAttr> inits;
+    for (BlockArgument arg : accumulation->accumulators) {
+      inits.push_back(getSplatInit(accumulation->forOp, arg));
+      if (!inits.back())
+        return std::nullopt;
+    }
+    // The partial accumulators are all seeded with the initial values
+    if (!isIdempotent(reduce.getCombineOp(), inits))
+      return std::nullopt;
+    return accumulation;
+  }
+
+  // Same as the single operand case: the loop carries one accumulator per
+  // thread and element of the reduction axis it holds, which are combined
+  // with the original accumulators once after the loop.
+  void optimizeLoopAccumulation(LoopAccumulation &accumulation) const {
+    triton::ReduceOp reduce = accumulation.reduce;
+    // The loop may have been replaced by the optimization of another
+    // accumulation
+    auto forOp = cast<scf::ForOp>(reduce->getParentOp());
+    MLIRContext *ctx = reduce.getContext();
+    auto srcType = reduce.getOperands()[0].getType().cast<RankedTensorType>();
+    unsigned rank = srcType.getRank();
+    auto blocked3d = getThreadLocalityOptimizedEncoding(reduce);
+    auto viewShape = getThreadLocalityOptimizedShape(reduce);
+    auto slice2d = triton::gpu::SliceEncodingAttr::get(ctx, rank, blocked3d);
+    SmallVector<int64_t> accumShape(viewShape.begin(), viewShape.end() - 1);
+    auto getAccumType = [&](Type type) {
+      return RankedTensorType::get(accumShape, getElementTypeOrSelf(type),
+                                   slice2d);
+    };
+
+    OpBuilder builder(forOp);
+    SmallVector<Value> newInits;
+    for (BlockArgument arg : accumulation.accumulators) {
+      auto accumType = getAccumType(arg.getType());
+      newInits.push_back(builder.create<arith::ConstantOp>(
+          forOp.getLoc(), accumType,
+          DenseElementsAttr::get(accumType, getSplatInit(forOp, arg))));
+    }
+    unsigned numOperands = reduce.getNumOperands();
+    scf::ForOp newLoop = replaceForOpWithNewSignature(builder, forOp, newInits);
+    Block *body = newLoop.getBody();
+    auto newArgs = body->getArguments().take_back(numOperands);
+
+    // Thread local reduction, combined into the partial accumulators
+    builder.setInsertionPointAfter(reduce);
+    IRMapping mapping;
+    for (Value operand : reduce.getOperands()) {
+      auto viewOp = builder.create<triton::ReshapeOp>(
+          reduce.getLoc(),
+          RankedTensorType::get(viewShape, getElementTypeOrSelf(operand),
+                                blocked3d),
+          operand, /*allowReorder=*/true);
+      viewOp.setEfficientLayout(true);
+      mapping.map(operand, viewOp);
+    }
+    Operation *localReduce = builder.clone(*reduce, mapping);
+    localReduce->setAttr("axis", builder.getI32IntegerAttr(rank));
+    for (OpResult result : localReduce->getResults())
+      result.setType(getAccumType(result.getType()));
+    IRMapping updateMapping;
+    updateMapping.map(accumulation.accumulators, newArgs);
+    updateMapping.map(reduce->getResults(), localReduce->getResults());
+    for (Operation *op : accumulation.updateOps) {
+      Operation *newOp = builder.clone(*op, updateMapping);
+      for (OpResult result : newOp->getResults())
+        result.setType(getAccumType(result.getType()));
+    }
+    // The original accumulators are left as they are initialized
+    auto yieldOp = cast<scf::YieldOp>(body->getTerminator());
+    SmallVector<Value> yieldValues = llvm::to_vector(yieldOp.getOperands());
+    SmallVector<Value> oldNext;
+    for (BlockArgument arg : accumulation.accumulators) {
+      unsigned index = arg.getArgNumber() - newLoop.getNumInductionVars();
+      oldNext.push_back(yieldValues[index]);
+      yieldValues[index] = arg;
+      yieldValues.push_back(updateMapping.lookup(oldNext.back()));
+    }
+    builder.setInsertionPoint(yieldOp);
+    builder.create<scf::YieldOp>(yieldOp.getLoc(), yieldValues);
+    yieldOp.erase();
+
+    // Reduce the partial accumulators, and combine them with the original
+    // accumulators
+    builder.setInsertionPointAfter(newLoop);
+    IRMapping postMapping;
+    postMapping.map(reduce.getOperands(),
+                    newLoop.getResults().take_back(numOperands));
+    Operation *postReduce = builder.clone(*reduce, postMapping);
+    SmallVector<Type> postTypes;
+    if (failed(cast<InferTypeOpInterface>(postReduce).inferReturnTypes(
+            ctx, postReduce->getLoc(), postReduce->getOperands(),
+            postReduce->getAttrDictionary(), postReduce->getPropertiesStorage(),
+            postReduce->getRegions(), postTypes)))
+      llvm_unreachable("failed to infer the types of the reduction");
+    for (auto [result, type] : llvm::zip(postReduce->getResults(), postTypes))
+      result.setType(type);
+    IRMapping finalMapping;
+    for (auto [i, arg] : llvm::enumerate(accumulation.accumulators)) {
+      finalMapping.map(arg, newLoop.getTiedLoopInit(arg)->get());
+      finalMapping.map(reduce->getResult(i),
+                       builder.create<triton::gpu::ConvertLayoutOp>(
+                           reduce.getLoc(), arg.getType(),
+                           postReduce->getResult(i)));
+    }
+    for (Operation *op : accumulation.updateOps)
+      builder.clone(*op, finalMapping);
+    for (auto [arg, next] : llvm::zip(accumulation.accumulators, oldNext))
+      newLoop.getResult(arg.getArgNumber() - newLoop.getNumInductionVars())
+          .replaceAllUsesWith(finalMapping.lookup(next));
+
+    // cleanup
+    for (Operation *op : llvm::reverse(accumulation.updateOps))
+      op->erase();
+    reduce.erase();
+    forOp.erase();
+  }
+
   std::optional<Operation *> getReductionOp(triton::ReduceOp reduce) const {
     auto numRegions = reduce->getNumRegions();
     if (numRegions != 1)
@@ -0,0 +1,363 @@
+#include "mlir/Dialect/SCF/IR/SCF.h"
+#include "mlir/IR/Matchers.h"
+#include "mlir/IR/PatternMatch.h"
+#include "mlir/Transforms/GreedyPatternRewriteDriver.h"
+#include "triton/Analysis/AxisInfo.h"
+#include "triton/Dialect/TritonGPU/IR/Dialect.h"
+#include "triton/Dialect/TritonGPU/Transforms/Passes.h"
+#include "triton/Dialect/TritonGPU/Transforms/Utility.h"
+#include "llvm/Support/CheckedArithmetic.h"
+
+//===----------------------------------------------------------------------===//
+// This pass splits loops whose loads and stores are masked by a bound on the
+// induction variable, like the K-loop of a matmul:
+//
+//   for k in range(0, tl.cdiv(K, BLOCK_K)):
+//     a = tl.load(a_ptrs, mask=offs_k[None, :] < K - k * BLOCK_K)
+//
+// into a main loop over the iterations on which all these masks are true, and
+// the original loop over the remaining ones:
+//
+//   for k in range(0, K // BLOCK_K):
+//     a = tl.load(a_ptrs)
+//   for k in range(K // BLOCK_K, tl.cdiv(K, BLOCK_K)):
+//     a = tl.load(a_ptrs, mask=offs_k[None, :] < K - k * BLOCK_K)
+//
+// Masks are written as linear functions of the induction variable, so that the
+// split point can be computed before the loop. Loops are only split when the
+// ranges of the masks show that they are partial on a single iteration, which
+// is left in the tail loop and isn't pipelined.
+//===----------------------------------------------------------------------===//
+
+using namespace mlir;
+
+#define GEN_PASS_CLASSES
+#include "triton/Dialect/TritonGPU/Transforms/Passes.h.inc"
+
+namespace {
+
+typedef SmallVector<std::pair<Value, int64_t>> TermsT;
+
+// A value of a loop as `tile + ivCoeff * iv + sum(coeff * term)`, where `tile`
+// is a tensor of known range and the terms are loop-invariant scalars.
+struct LinearForm {
+  AxisInfo::RangeT tile = {0, 0};
+  int64_t ivCoeff = 0;
+  TermsT terms;
+};
+
+// The masks of an iteration are all true if
+// `ivCoeff * iv <= bound + sum(coeff * term)`
+struct IterationBound {
+  int64_t ivCoeff;
+  int64_t bound;
+  TermsT terms;
+};
+
+std::optional<LinearForm> scale(std::optional<LinearForm> form,
+                                int64_t factor) {
+  if (!form)
+    return std::nullopt;
+  auto min = llvm::checkedMul(form->tile.first, factor);
+  auto max = llvm::checkedMul(form->tile.second, factor);
+  auto ivCoeff = llvm::checkedMul(form->ivCoeff, factor);
+  if (!min || !max || !ivCoeff)
+    return std::nullopt;
+  LinearForm result;
+  result.tile = factor < 0 ? AxisInfo::RangeT{*max, *min}
+                           : AxisInfo::RangeT{*min, *max};
+  result.ivCoeff = *ivCoeff;
+  for (auto [term, coeff] : form->terms) {
+    auto scaled = llvm::checkedMul(coeff, factor);
+    if (!scaled)
+      return std::nullopt;
+    result.terms.push_back({term, *scaled});
+  }
+  return result;
+}
+
+std::optional<LinearForm> add(std::optional<LinearForm> lhs,
+                              std::optional<LinearForm> rhs) {
+  if (!lhs || !rhs)
+    return std::nullopt;
+  auto min = llvm::checkedAdd(lhs->tile.first, rhs->tile.first);
+  auto max = llvm::checkedAdd(lhs->tile.second, rhs->tile.second);
+  auto ivCoeff = llvm::checkedAdd(lhs->ivCoeff, rhs->ivCoeff);
+  if (!min || !max || !ivCoeff)
+    return std::nullopt;
+  LinearForm result{{*min, *max}, *ivCoeff, lhs->terms};
+  result.terms.append(rhs->terms.begin(), rhs->terms.end());
+  return result;
+}
+
+class MaskAnalysis {
+public:
+  MaskAnalysis(scf::ForOp forOp, int64_t step,
+               ModuleAxisInfoAnalysis &axisInfoAnalysis)
+      : forOp(forOp), step(step), axisInfoAnalysis(axisInfoAnalysis) {}
+
+  // Appends the bounds of the iterations on which `mask` is all true, and
+  // returns false if it can't be written as a conjunction of such bounds.
+  bool getIterationBounds(Value mask, SmallVector<IterationBound> &bounds) {
+    Operation *op = mask.getDefiningOp();
+    if (!op)
+      return false;
+    if (isa<triton::SplatOp, triton::BroadcastOp, triton::ExpandDimsOp,
+            triton::gpu::ConvertLayoutOp>(op))
+      return getIterationBounds(op->getOperand(0), bounds);
+    if (auto andOp = dyn_cast<arith::AndIOp>(op))
+      return getIterationBounds(andOp.getLhs(), bounds) &&
+             getIterationBounds(andOp.getRhs(), bounds);
+    auto cmpOp = dyn_cast<arith::CmpIOp>(op);
+    if (!cmpOp)
+      return false;
+    // The mask is all true if all the elements of `lhs - rhs` are negative, or
+    // also zero if the comparison isn't strict
+    Value lhs = cmpOp.getLhs();
+    Value rhs = cmpOp.getRhs();
+    bool isStrict = false;
+    switch (cmpOp.getPredicate()) {
+    case arith::CmpIPredicate::slt:
+      isStrict = true;
+      break;
+    case arith::CmpIPredicate::sle:
+      break;
+    case arith::CmpIPredicate::sgt:
+      isStrict = true;
+      std::swap(lhs, rhs);
+      break;
+    case arith::CmpIPredicate::sge:
+      std::swap(lhs, rhs);
+      break;
+    default:
+      return false;
+    }
+    auto diff = add(getLinearForm(lhs), scale(getLinearForm(rhs), -1));
+    // Masks that get true again with later iterations aren't a tail
+    if (!diff || diff->ivCoeff <= 0)
+      return false;
+    // The mask is partial on the iterations of a window of `spread / ivCoeff`
+    // values of the induction variable, so on at most one if that is smaller
+    // than the step
+    auto spread = llvm::checkedSub(diff->tile.second, diff->tile.first);
+    auto stride = llvm::checkedMul(diff->ivCoeff, step);
+    if (!spread || !stride || *spread >= *stride)
+      return false;
+    // ivCoeff * iv + max(tile) + sum(terms) <= (isStrict ? -1 : 0)
+    auto bound =
+        llvm::checkedSub<int64_t>(isStrict ? -1 : 0, diff->tile.second);
+    if (!bound)
+      return false;
+    IterationBound iterationBound{diff->ivCoeff, *bound, {}};
+    for (auto [term, coeff] : diff->terms) {
+      auto negated = llvm::checkedMul<int64_t>(coeff, -1);
+      if (!negated)
+        return false;
+      iterationBound.terms.push_back({term, *negated});
+    }
+    bounds.push_back(iterationBound);
+    return true;
+  }
+
+private:
+  std::optional<LinearForm> getLinearForm(Value value) {
+    Type ivType = forOp.getInductionVar().getType();
+    if (value == forOp.getInductionVar())
+      return LinearForm{{0, 0}, 1, {}};
+    if (forOp.isDefinedOutsideOfLoop(value) && value.getType() == ivType)
+      return LinearForm{{0, 0}, 0, {{value, 1}}};
+    Operation *op = value.getDefiningOp();
+    if (op && isa<triton::SplatOp, triton::BroadcastOp, triton::ExpandDimsOp,
+                  triton::gpu::ConvertLayoutOp>(op))
+      return getLinearForm(op->getOperand(0));
+    if (auto addOp = dyn_cast_or_null<arith::AddIOp>(op))
+      return add(getLinearForm(addOp.getLhs()),
+                 getLinearForm(addOp.getRhs()));
+    if (auto subOp = dyn_cast_or_null<arith::SubIOp>(op))
+      return add(getLinearForm(subOp.getLhs()),
+                 scale(getLinearForm(subOp.getRhs()), -1));
+    if (auto mulOp = dyn_cast_or_null<arith::MulIOp>(op)) {
+      APInt factor;
+      if (matchPattern(mulOp.getRhs(), m_ConstantInt(&factor)))
+        return scale(getLinearForm(mulOp.getLhs()), factor.getSExtValue());
+      if (matchPattern(mulOp.getLhs(), m_ConstantInt(&factor)))
+        return scale(getLinearForm(mulOp.getRhs()), factor.getSExtValue());
+    }
+    // Otherwise the range of the value over all the iterations of the loop
+    // bounds it, e.g. for `tl.arange`
+    AxisInfo *axisInfo = axisInfoAnalysis.getAxisInfo(value);
+    if (!axisInfo || !axisInfo->getRange())
+      return std::nullopt;
+    return LinearForm{*axisInfo->getRange(), 0, {}};
+  }
+
+  scf::ForOp forOp;
+  int64_t step;
+  ModuleAxisInfoAnalysis &axisInfoAnalysis;
+};
+
+struct PeelableLoop {
+  scf::ForOp forOp;
+  int64_t step;
+  SmallVector<IterationBound> bounds;
+  // The loads and stores whose masks are all true before the bounds
+  SmallVector<Operation *> maskedOps;
+};
+
+std::optional<PeelableLoop>
+getPeelableLoop(scf::ForOp forOp, ModuleAxisInfoAnalysis &axisInfoAnalysis) {
+  APInt step;
+  if (!matchPattern(forOp.getStep(), m_ConstantInt(&step)) ||
+      step.getSExtValue() <= 0)
+    return std::nullopt;
+  PeelableLoop loop{forOp, step.getSExtValue(), {}, {}};
+  MaskAnalysis analysis(forOp, loop.step, axisInfoAnalysis);
+  for (Operation &op : forOp.getBody()->without_terminator()) {
+    Value mask;
+    if (auto loadOp = dyn_cast<triton::LoadOp>(op))
+      mask = loadOp.getMask();
+    else if (auto storeOp = dyn_cast<triton::StoreOp>(op))
+      mask = storeOp.getMask();
+    if (!mask || !mask.getType().isa<RankedTensorType>())
+      continue;
+    SmallVector<IterationBound> bounds;
+    if (!analysis.getIterationBounds(mask, bounds))
+      continue;
+    loop.bounds.append(bounds.begin(), bounds.end());
+    loop.maskedOps.push_back(&op);
+  }
+  if (loop.maskedOps.empty())
+    return std::nullopt;
+  return loop;
+}
+
+// Returns the first value of the induction variable after the iterations
+// that satisfy `bound`.
+Value createSplitPoint(OpBuilder &builder, Location loc, scf::ForOp forOp,
+                       int64_t step, const IterationBound &bound) {
+  Type ivType = forOp.getInductionVar().getType();
+  auto createConstant = [&](int64_t value) -> Value {
+    return builder.create<arith::ConstantOp>(
+        loc, builder.getIntegerAttr(ivType, value));
+  };
+  Value limit = createConstant(bound.bound);
+  for (auto [term, coeff] : bound.terms) {
+    Value scaled =
+        builder.create<arith::MulIOp>(loc, term, createConstant(coeff));
+    limit = builder.create<arith::AddIOp>(loc, limit, scaled);
+  }
+  // The iterations lb + i * step such that
+  // ivCoeff * i * step <= limit - ivCoeff * lb
+  Value lb = forOp.getLowerBound();
+  Value slack = builder.create<arith::SubIOp>(
+      loc, limit,
+      builder.create<arith::MulIOp>(loc, lb, createConstant(bound.ivCoeff)));
+  Value numIters = builder.create<arith::AddIOp>(
+      loc,
+      builder.create<arith::DivSIOp>(loc, slack,
+                                     createConstant(bound.ivCoeff * step)),
+      createConstant(1));
+  Value isEmpty = builder.create<arith::CmpIOp>(
+      loc, arith::CmpIPredicate::slt, slack, createConstant(0));
+  numIters = builder.create<arith::SelectOp>(loc, isEmpty, createConstant(0),
+                                             numIters);
+  return builder.create<arith::AddIOp>(
+      loc, lb, builder.create<arith::MulIOp>(loc, numIters, forOp.getStep()));
+}
+
+void peelLoop(const PeelableLoop &loop) {
+  scf::ForOp forOp = loop.forOp;
+  Location loc = forOp.getLoc();
+  OpBuilder builder(forOp);
+  Value split = forOp.getUpperBound();
+  for (const IterationBound &bound : loop.bounds)
+    split = builder.create<arith::MinSIOp>(
+        loc, split, createSplitPoint(builder, loc, forOp, loop.step, bound));
+
+  // The main loop, on which the masks are all true
+  SmallVector<Value> trueMasks;
+  for (Operation *op : loop.maskedOps) {
+    Value mask = isa<triton::LoadOp>(op) ? cast<triton::LoadOp>(op).getMask()
+                                         : cast<triton::StoreOp>(op).getMask();
+    auto maskTy = mask.getType().cast<RankedTensorType>();
+    trueMasks.push_back(builder.create<arith::ConstantOp>(
+        loc, DenseElementsAttr::get(maskTy, true)));
+  }
+  auto mainLoop = cast<scf::ForOp>(builder.clone(*forOp));
+  mainLoop.setUpperBound(split);
+  DenseMap<Operation *, Operation *> clonedOps;
+  for (auto [op, clonedOp] :
+       llvm::zip(forOp.getBody()->without_terminator(),
+                 mainLoop.getBody()->without_terminator()))
+    clonedOps[&op] = &clonedOp;
+  for (auto [op, trueMask] : llvm::zip(loop.maskedOps, trueMasks)) {
+    Operation *clonedOp = clonedOps.lookup(op);
+    if (auto loadOp = dyn_cast<triton::LoadOp>(clonedOp))
+      loadOp.getMaskMutable().assign(trueMask);
+    else
+      cast<triton::StoreOp>(clonedOp).getMaskMutable().assign(trueMask);
+  }
+
+  // The original loop runs the tail
+  forOp.setLowerBound(split);
+  forOp.getInitsMutable().assign(mainLoop.getResults());
+  forOp->setAttr(kPeeledTailAttrName, builder.getUnitAttr());
+}
+
+} // anonymous namespace
+
+class TritonGPUPeelMaskedTailPass
+    : public TritonGPUPeelMaskedTailBase<TritonGPUPeelMaskedTailPass> {
+public:
+  TritonGPUPeelMaskedTailPass() = default;
+
+  void runOnOperation() override {
+    MLIRContext *context = &getContext();
+    ModuleOp m = getOperation();
+    ModuleAxisInfoAnalysis &axisInfoAnalysis =
+        getAnalysis<ModuleAxisInfoAnalysis>();
+
+    // Only peel innermost loops, like the pipeliner only pipelines them
+    SmallVector<PeelableLoop> loops;
+    m.walk([&](scf::ForOp forOp) {
+      if (forOp->hasAttr(kPeeledTailAttrName))
+        return;
+      bool hasInnerLoop = false;
+      forOp.getBody()->walk([&](Operation *op) {
+        if (isa<scf::ForOp, scf::WhileOp>(op))
+          hasInnerLoop = true;
+      });
+      if (hasInnerLoop)
+        return;
+      if (auto loop = getPeelableLoop(forOp, axisInfoAnalysis))
+        loops.push_back(*loop);
+    });
+    if (loops.empty()) {
+      markAllAnalysesPreserved();
+      return;
+    }
+    SetVector<FunctionOpInterface> funcOps;
+    for (const PeelableLoop &loop : loops) {
+      funcOps.insert(loop.forOp->getParentOfType<FunctionOpInterface>());
+      peelLoop(loop);
+    }
+
+    // Drop the masks that are now constant, and fold the split points
+    RewritePatternSet patterns(context);
+    triton::LoadOp::getCanonicalizationPatterns(patterns, context);
+    triton::StoreOp::getCanonicalizationPatterns(patterns, context);
+    FrozenRewritePatternSet frozenPatterns(std::move(patterns));
+    for (FunctionOpInterface funcOp : funcOps) {
+      if (applyPatternsAndFoldGreedily(funcOp, frozenPatterns).failed())
+        return signalPassFailure();
+      // Only the peeled functions have new values, and the AxisInfo of their
+      // calls is unchanged
+      axisInfoAnalysis.recompute(funcOp);
+    }
+    markAnalysesPreserved<ModuleAxisInfoAnalysis>();
+  }
+};
+
+std::unique_ptr<Pass> mlir::triton::gpu::createPeelMaskedTailPass() {
+  return std::make_unique<TritonGPUPeelMaskedTailPass>();
+}
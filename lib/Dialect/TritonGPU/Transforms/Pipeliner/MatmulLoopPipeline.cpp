@@ -1,13 +1,18 @@
-#include "PipelineExpander.h"
 #include "Schedule.h"
 #include "mlir/Dialect/Tensor/IR/Tensor.h"
+#include "mlir/Dialect/Utils/StaticValueUtils.h"
 #include "mlir/IR/IRMapping.h"
+#include "mlir/IR/Matchers.h"
 #include "mlir/IR/TypeUtilities.h"
 #include "mlir/Interfaces/SideEffectInterfaces.h"
+#include "mlir/Support/MathExtras.h"
 #include "triton/Analysis/AxisInfo.h"
+#include "triton/Analysis/BankConflicts.h"
+#include "triton/Analysis/RegisterPressure.h"
 #include "triton/Analysis/Utility.h"
 #include "triton/Dialect/TritonGPU/IR/Dialect.h"
 #include "triton/Dialect/TritonGPU/Transforms/Passes.h"
+#include "triton/Dialect/TritonGPU/Transforms/PipelineExpander.h"
 #include "triton/Dialect/TritonGPU/Transforms/Utility.h"
 #include "llvm/Support/Debug.h"
 
@@ -65,22 +70,28 @@ static void createAsyncCopy(scf::ForOp &forOp, tt::LoadOp loadOp, Value alloc,
   appendToYield(forOp, {insertOp});
 }
 
-static void createTMALoad(scf::ForOp &forOp, tt::LoadOp loadOp, Value alloc,
-                          Value insertIdx, Value extractIdx, Value phase) {
-  OpBuilder builder(forOp);
-  Location loc = loadOp.getLoc();
-  auto CTALayout = ttg::CTALayoutAttr::get(loadOp.getContext(),
+/// Allocate an array of `numBuffers` mbarrier objects, one per buffer, each
+/// expecting `count` arrivals.
+static Value createMBarrierArray(OpBuilder &builder, Location loc,
+                                 int64_t numBuffers, int count) {
+  auto CTALayout = ttg::CTALayoutAttr::get(builder.getContext(),
                                            /*CTAsPerCGA*/ {1},
                                            /*CTASplitNum*/ {1},
                                            /*CTAOrder*/ {0});
-  auto sharedEncoding = ttg::SharedEncodingAttr::get(loadOp.getContext(), 1, 1,
+  auto sharedEncoding = ttg::SharedEncodingAttr::get(builder.getContext(), 1, 1,
                                                      1, {0}, CTALayout, false);
-  int64_t numBuffers = alloc.getType().cast<RankedTensorType>().getShape()[0];
   auto mBarriersTy = RankedTensorType::get(
       {numBuffers}, builder.getIntegerType(64), sharedEncoding);
+  return builder.create<ttng::AllocMBarrierOp>(loc, mBarriersTy, count);
+}
+
+static void createTMALoad(scf::ForOp &forOp, tt::LoadOp loadOp, Value alloc,
+                          Value insertIdx, Value extractIdx, Value phase) {
+  OpBuilder builder(forOp);
+  Location loc = loadOp.getLoc();
+  int64_t numBuffers = alloc.getType().cast<RankedTensorType>().getShape()[0];
   // Allocate an array of mbarrier objects outside the loop.
-  Value barrierArray =
-      builder.create<ttng::AllocMBarrierOp>(loc, mBarriersTy, 1);
+  Value barrierArray = createMBarrierArray(builder, loc, numBuffers, 1);
   // extract the barrier and emit arriver/copy/wait/extract code sequence.
   builder.setInsertionPoint(loadOp);
   auto mBarTy = tt::PointerType::get(builder.getIntegerType(64), 3);
@@ -109,15 +120,18 @@ static void createTMALoad(scf::ForOp &forOp, tt::LoadOp loadOp, Value alloc,
       loadOp.getCache(), loadOp.getEvict(), loadOp.getIsVolatile(),
       /*axis*/ 0);
 
+  // The boxes of TMA loads may have up to 5 dimensions
+  auto sliceShape = allocType.getShape().drop_front();
   RankedTensorType sliceType = RankedTensorType::get(
-      {allocType.getShape()[1], allocType.getShape()[2]},
-      allocType.getElementType(), allocType.getEncoding());
+      sliceShape, allocType.getElementType(), allocType.getEncoding());
+  SmallVector<OpFoldResult> offsets(allocType.getRank(), int_attr(0));
+  offsets[0] = extractIdx;
+  SmallVector<OpFoldResult> sizes{int_attr(1)};
+  for (int64_t size : sliceShape)
+    sizes.push_back(int_attr(size));
+  SmallVector<OpFoldResult> strides(allocType.getRank(), int_attr(1));
   auto extract = builder.create<mlir::triton::gpu::ExtractSliceOp>(
-      loc, sliceType, insertOp.getResult(),
-      SmallVector<OpFoldResult>{extractIdx, int_attr(0), int_attr(0)},
-      SmallVector<OpFoldResult>{int_attr(1), int_attr(sliceType.getShape()[0]),
-                                int_attr(sliceType.getShape()[1])},
-      SmallVector<OpFoldResult>{int_attr(1), int_attr(1), int_attr(1)});
+      loc, sliceType, insertOp.getResult(), offsets, sizes, strides);
 
   Value barrierWait = builder.create<ttng::ExtractMBarrierOp>(
       loc, mBarTy, barrierArray, extractIdx);
@@ -152,6 +166,9 @@ struct LoadDotOperand {
   tt::LoadOp load;
   ttg::DotOperandEncodingAttr dotOperandEncoding;
   bool needTrans;
+  // Loads that don't feed a dot are staged through an unswizzled buffer and
+  // converted back to the layout they were loaded in.
+  bool feedsDot = true;
 };
 } // namespace
 
@@ -224,18 +241,64 @@ static std::optional<LoadDotOperand> loadDotOperand(tt::LoadOp loadOp,
   bool needTrans = false;
   ttg::DotOperandEncodingAttr attr =
       allTransitiveUsesHaveDotEncoding(loadOp.getResult(), needTrans);
-  if (!attr)
+  // The operands of batched dots are not pipelined
+  if (!attr || loadOp.getType().cast<RankedTensorType>().getRank() != 2)
     return std::nullopt;
   return LoadDotOperand(loadOp, attr, needTrans);
 }
 
+// Shared memory the buffers of the loads that don't feed a dot may take,
+// leaving room for the scratch buffers of the rest of the loop.
+static constexpr int64_t kMaxNonDotBufferBytes = 64 * 1024;
+
+// Return whether a load that doesn't feed a dot can be staged through shared
+// memory with cp.async. Its elements are read back with a convert_layout,
+// which only supports 2D tensors, and cp.async zero-fills the masked out
+// elements, so `other` has to be zero.
+static bool canPipelineNonDotLoad(scf::ForOp forOp, tt::LoadOp loadOp) {
+  // Loop invariant loads are left to be hoisted.
+  if (isLoadFromTensorPtr(loadOp) ||
+      forOp.isDefinedOutsideOfLoop(loadOp.getPtr()))
+    return false;
+  auto ty = loadOp.getType().cast<RankedTensorType>();
+  if (ty.getRank() != 2 || !ty.getEncoding().isa<ttg::BlockedEncodingAttr>())
+    return false;
+  Value other = loadOp.getOther();
+  return !other || matchPattern(other, m_Zero()) ||
+         matchPattern(other, m_PosZeroFloat());
+}
+
+// Shared memory the buffers of the loads of matmul loops that don't feed a dot
+// may take. Those are the loads of row or column vectors, like the scales of a
+// block-scaled dot, which would stall the loop as much as its operands.
+static constexpr int64_t kMaxMatmulNonDotBufferBytes = 8 * 1024;
+
+static bool isRowOrColumnVector(tt::LoadOp loadOp) {
+  auto shape = loadOp.getType().cast<RankedTensorType>().getShape();
+  return llvm::is_contained(shape, 1);
+}
+
+static int64_t getBufferBytes(tt::LoadOp loadOp) {
+  auto ty = loadOp.getType().cast<RankedTensorType>();
+  return ty.getNumElements() * ty.getElementTypeBitWidth() / 8;
+}
+
 /// Collect loads to pipeline. Return success if we can pipeline this loop
 static void collectOpsToPipeline(scf::ForOp forOp,
+                                 ModuleAxisInfoAnalysis &axisInfoAnalysis,
+                                 int numStages, int computeCapability,
                                  SmallVectorImpl<LoadDotOperand> &ops,
                                  bool &hasMMAV3) {
-  ModuleOp moduleOp = forOp->getParentOfType<ModuleOp>();
-  ModuleAxisInfoAnalysis axisInfoAnalysis(moduleOp);
-
+  // The loads of loops without dots, streaming data into reductions or
+  // elementwise ops, are prefetched too. The shared memory of matmul loops is
+  // left to the dot operands, but for small row or column vectors.
+  bool hasDot = forOp.getBody()
+                    ->walk([](tt::DotOp) { return WalkResult::interrupt(); })
+                    .wasInterrupted();
+  bool pipelineNonDotLoads = computeCapability >= 80;
+  int64_t maxNonDotBufferBytes =
+      hasDot ? kMaxMatmulNonDotBufferBytes : kMaxNonDotBufferBytes;
+  int64_t nonDotBufferBytes = 0;
   // We cannot use forOp.walk(...) here because we only want to visit the
   // operations in the loop body block. Nested blocks are handled separately.
   for (Operation &op : forOp) {
@@ -269,9 +332,22 @@ static void collectOpsToPipeline(scf::ForOp forOp,
         continue;
       std::optional<LoadDotOperand> loadWithDotOperand =
           loadDotOperand(loadOp, hasMMAV3);
-      if (!loadWithDotOperand.has_value())
+      if (loadWithDotOperand.has_value()) {
+        ops.push_back(loadWithDotOperand.value());
         continue;
-      ops.push_back(loadWithDotOperand.value());
+      }
+      if (!pipelineNonDotLoads || !canPipelineNonDotLoad(forOp, loadOp) ||
+          (hasDot && !isRowOrColumnVector(loadOp)))
+        continue;
+      // Prefetching is only worth it while the buffers fit next to the
+      // scratch buffers of the loop.
+      int64_t bytes = getBufferBytes(loadOp) * (numStages - 1);
+      if (nonDotBufferBytes + bytes > maxNonDotBufferBytes)
+        continue;
+      nonDotBufferBytes += bytes;
+      LoadDotOperand nonDotLoad(loadOp, nullptr);
+      nonDotLoad.feedsDot = false;
+      ops.push_back(nonDotLoad);
     }
   }
 }
@@ -279,12 +355,20 @@ static void collectOpsToPipeline(scf::ForOp forOp,
 // Create an allocation that can old distance number of loadOp shapes.
 static Value createAlloc(scf::ForOp &forOp, tt::LoadOp loadOp,
                          ttg::DotOperandEncodingAttr dotOpEnc,
-                         unsigned distance, bool needTrans) {
+                         unsigned distance, bool needTrans, bool feedsDot) {
   OpBuilder builder(forOp);
   auto ty = loadOp.getType().cast<RankedTensorType>();
   Attribute sharedEnc;
   auto CTALayout = ttg::getCTALayout(ty.getEncoding());
-  if (dotOpEnc) {
+  if (!feedsDot) {
+    // The buffer is read back in the layout it was written in, swizzled to
+    // avoid the bank conflicts of both accesses.
+    auto order = ttg::getOrder(ty.getEncoding());
+    sharedEnc = chooseSharedEncoding(ty, {ty}, order, CTALayout);
+    if (!sharedEnc)
+      sharedEnc = ttg::SharedEncodingAttr::get(ty.getContext(), 1, 1, 1, order,
+                                               CTALayout, false);
+  } else if (dotOpEnc) {
     unsigned bitWidth = ty.getElementType().getIntOrFloatBitWidth();
     // set needTrans to avoid unnecessary conversion between shared encodings.
     sharedEnc = ttg::SharedEncodingAttr::get(
@@ -307,9 +391,12 @@ static Value createAlloc(scf::ForOp &forOp, tt::LoadOp loadOp,
 
 // Convert load ops into their asyn version and apply multi-buffering based on
 // the number of stages.
+// With `useAsyncBarriers`, the async copies of each stage arrive on an
+// mbarrier of their buffer, which is waited on before the buffer is read.
 static SmallVector<Value> createAsynOps(scf::ForOp &forOp,
                                         ArrayRef<LoadDotOperand> loads,
-                                        int numStages, bool hasMMAV3) {
+                                        int numStages, bool hasMMAV3,
+                                        bool useAsyncBarriers) {
   struct AsyncLoad {
     AsyncLoad(tt::LoadOp loadOp, Value alloc) : loadOp(loadOp), alloc(alloc) {}
     tt::LoadOp loadOp;
@@ -329,7 +416,8 @@ static SmallVector<Value> createAsynOps(scf::ForOp &forOp,
   for (const LoadDotOperand &loadOperand : loads) {
     tt::LoadOp loadOp = loadOperand.load;
     Value alloc = createAlloc(forOp, loadOp, loadOperand.dotOperandEncoding,
-                              numBuffers, loadOperand.needTrans);
+                              numBuffers, loadOperand.needTrans,
+                              loadOperand.feedsDot);
     assert(alloc && "Failed to create alloc for the async load.");
     newOperands.push_back(alloc);
     allocs.push_back(alloc);
@@ -352,6 +440,17 @@ static SmallVector<Value> createAsynOps(scf::ForOp &forOp,
       builder.create<arith::ConstantIntOp>(loc, numBuffers, 32);
   newOperands.push_back(insertIdx);
   newOperands.push_back(extractIdx);
+  Value barrierArray;
+  if (useAsyncBarriers) {
+    // Every thread arrives once its own copies of the stage are done. The
+    // mbarriers are initialized by a single thread, before any arrives.
+    ModuleOp mod = forOp->getParentOfType<ModuleOp>();
+    int numThreads = ttg::TritonGPUDialect::getNumWarps(mod) *
+                     ttg::TritonGPUDialect::getThreadsPerWarp(mod);
+    barrierArray = createMBarrierArray(builder, loc, numBuffers, numThreads);
+    builder.create<mlir::gpu::BarrierOp>(loc);
+    needsMbarrierPhase = true;
+  }
   Value phase;
   if (needsMbarrierPhase) {
     phase = builder.create<arith::ConstantIntOp>(loc, 0, 1);
@@ -398,15 +497,37 @@ static SmallVector<Value> createAsynOps(scf::ForOp &forOp,
                     extractIdx, phase);
     firstLoad = false;
   }
-  // Insert a waitOp after the first async copy. This does make the assumption
-  // that the wait will be scheduled in a different stage that all the async
-  // copy but we cannot guarantee that one wait is enough otherwise.
-  for (auto &op : forOp.getBody()->without_terminator()) {
-    if (isa<ttg::InsertSliceAsyncOp>(op)) {
-      OpBuilder builder(op.getContext());
-      builder.setInsertionPointAfter(&op);
-      builder.create<ttg::AsyncWaitOp>(op.getLoc(), 0);
-      break;
+  if (useAsyncBarriers) {
+    // Arrive on the mbarrier of the stage after its last async copy, then wait
+    // for the stage being extracted. The wait is scheduled with the extracts.
+    Operation *lastCopy = nullptr;
+    for (auto &op : forOp.getBody()->without_terminator())
+      if (isa<ttg::AsyncCommitGroupOp>(op))
+        lastCopy = &op;
+    OpBuilder builder(lastCopy->getContext());
+    builder.setInsertionPointAfter(lastCopy);
+    Location copyLoc = lastCopy->getLoc();
+    auto mBarTy = tt::PointerType::get(builder.getIntegerType(64), 3);
+    Value barrier = builder.create<ttng::ExtractMBarrierOp>(
+        copyLoc, mBarTy, barrierArray, insertIdx);
+    builder.create<ttng::MBarrierArriveOp>(copyLoc, barrier, /*pred*/ nullptr,
+                                           /*remoteCtaId*/ nullptr,
+                                           /*trackAsyncOp*/ true, 0);
+    Value barrierWait = builder.create<ttng::ExtractMBarrierOp>(
+        copyLoc, mBarTy, barrierArray, extractIdx);
+    builder.create<ttng::MBarrierWaitOp>(copyLoc, barrierWait, phase);
+  } else {
+    // Insert a waitOp after the first async copy. This does make the
+    // assumption that the wait will be scheduled in a different stage that
+    // all the async copy but we cannot guarantee that one wait is enough
+    // otherwise.
+    for (auto &op : forOp.getBody()->without_terminator()) {
+      if (isa<ttg::InsertSliceAsyncOp>(op)) {
+        OpBuilder builder(op.getContext());
+        builder.setInsertionPointAfter(&op);
+        builder.create<ttg::AsyncWaitOp>(op.getLoc(), 0);
+        break;
+      }
     }
   }
   SmallVector<Value> newYieldOperands = {insertIdx, extractIdx};
@@ -460,6 +581,11 @@ static Operation *predicateOp(RewriterBase &rewriter, Operation *op,
     return op;
   }
   if (auto arriveOp = dyn_cast<ttng::MBarrierArriveOp>(op)) {
+    // The arrives of the async copies aren't predicated: the masked copies of
+    // the iterations past the end still complete their stage, which the
+    // prefetched waits of these iterations wait on.
+    if (arriveOp.getTrackAsyncOp())
+      return op;
     rewriter.setInsertionPoint(arriveOp);
     Value mask = getPredMask(rewriter, rewriter.getIntegerType(1),
                              arriveOp.getPred(), pred);
@@ -476,15 +602,156 @@ static Operation *predicateOp(RewriterBase &rewriter, Operation *op,
     loadOp.getMaskMutable().assign(mask);
     return op;
   }
+  if (auto prefetchOp = dyn_cast<tt::PrefetchOp>(op)) {
+    rewriter.setInsertionPoint(prefetchOp);
+    Value mask = getPredMask(rewriter, prefetchOp.getPtr().getType(),
+                             prefetchOp.getMask(), pred);
+    prefetchOp.getMaskMutable().assign(mask);
+    return op;
+  }
 
   assert("don't know how to predicate this op" && false);
   return op;
 }
 
+// The most ops copied to compute the addresses of a gather an iteration ahead.
+static constexpr unsigned kMaxPrefetchSliceOps = 32;
+
+// Collects into `slice` the ops of the body of `forOp` that `value` depends on
+// within an iteration. Returns false if one of them can't run an iteration
+// early: only the ops without effects and the loads of scalars or vectors,
+// like indices, which aren't pipelined themselves, can.
+static bool collectAddressSlice(scf::ForOp forOp, Value value,
+                                DenseSet<Operation *> &slice) {
+  Operation *op = value.getDefiningOp();
+  if (!op || op->getBlock() != forOp.getBody() || slice.contains(op))
+    return true;
+  if (op->getNumRegions() != 0)
+    return false;
+  if (auto loadOp = dyn_cast<tt::LoadOp>(op)) {
+    auto ty = loadOp.getType().dyn_cast<RankedTensorType>();
+    if (loadOp.getIsVolatile() || isLoadFromTensorPtr(loadOp) ||
+        (ty && ty.getRank() > 1))
+      return false;
+  } else if (!isMemoryEffectFree(op)) {
+    return false;
+  }
+  slice.insert(op);
+  if (slice.size() > kMaxPrefetchSliceOps)
+    return false;
+  return llvm::all_of(op->getOperands(), [&](Value operand) {
+    return collectAddressSlice(forOp, operand, slice);
+  });
+}
+
+// Inserts the prefetch of the next iteration of the gather `loadOp`, whose
+// address is computed by `slice`, in program order. The copy of the slice runs
+// as soon as the values yielded by the iteration that it uses are defined, its
+// loads and the prefetch being masked out past the last iteration.
+static void prefetchNextIteration(scf::ForOp forOp, tt::LoadOp loadOp,
+                                  ArrayRef<Operation *> slice) {
+  Block *body = forOp.getBody();
+  auto yieldOp = cast<scf::YieldOp>(body->getTerminator());
+  IRMapping mapping;
+  Operation *lastDef = nullptr;
+  auto mapIterArg = [&](Value value) {
+    auto arg = value.dyn_cast<BlockArgument>();
+    if (!arg || arg.getOwner() != body || arg.getArgNumber() == 0)
+      return;
+    Value next = yieldOp.getOperand(arg.getArgNumber() - 1);
+    mapping.map(arg, next);
+    Operation *def = next.getDefiningOp();
+    if (def && def->getBlock() == body &&
+        (!lastDef || lastDef->isBeforeInBlock(def)))
+      lastDef = def;
+  };
+  for (Operation *op : slice)
+    llvm::for_each(op->getOperands(), mapIterArg);
+  mapIterArg(loadOp.getPtr());
+  if (Value mask = loadOp.getMask())
+    mapIterArg(mask);
+
+  IRRewriter rewriter(forOp.getContext());
+  if (lastDef)
+    rewriter.setInsertionPointAfter(lastDef);
+  else
+    rewriter.setInsertionPointToStart(body);
+  Location loc = loadOp.getLoc();
+  Value nextIv = rewriter.create<arith::AddIOp>(loc, forOp.getInductionVar(),
+                                                forOp.getStep());
+  Value hasNext = rewriter.create<arith::CmpIOp>(
+      loc, arith::CmpIPredicate::slt, nextIv, forOp.getUpperBound());
+  mapping.map(forOp.getInductionVar(), nextIv);
+  for (Operation *op : slice) {
+    Operation *newOp = rewriter.clone(*op, mapping);
+    auto newLoadOp = dyn_cast<tt::LoadOp>(newOp);
+    if (!newLoadOp)
+      continue;
+    OpBuilder::InsertionGuard guard(rewriter);
+    rewriter.setInsertionPoint(newLoadOp);
+    newLoadOp.getMaskMutable().assign(getPredMask(
+        rewriter, newLoadOp.getPtr().getType(), newLoadOp.getMask(), hasNext));
+  }
+  Value ptr = mapping.lookupOrDefault(loadOp.getPtr());
+  Value mask = loadOp.getMask() ? mapping.lookupOrDefault(loadOp.getMask())
+                                : Value();
+  mask = getPredMask(rewriter, ptr.getType(), mask, hasNext);
+  rewriter.create<tt::PrefetchOp>(loc, ptr, mask, loadOp.getEvict());
+}
+
+bool mlir::triton::prefetchGathers(scf::ForOp forOp, int numStages,
+                                   ModuleAxisInfoAnalysis &axisInfoAnalysis,
+                                   int computeCapability) {
+  if (computeCapability < 80)
+    return false;
+  SmallVector<LoadDotOperand> pipelined;
+  bool hasMMAV3 = false;
+  collectOpsToPipeline(forOp, axisInfoAnalysis, numStages, computeCapability,
+                       pipelined, hasMMAV3);
+  DenseSet<Operation *> pipelinedLoads;
+  for (LoadDotOperand &load : pipelined)
+    pipelinedLoads.insert(load.load);
+
+  SmallVector<std::pair<tt::LoadOp, SmallVector<Operation *>>> gathers;
+  for (auto loadOp : forOp.getBody()->getOps<tt::LoadOp>()) {
+    if (pipelinedLoads.contains(loadOp) || loadOp.getIsVolatile() ||
+        isLoadFromTensorPtr(loadOp) ||
+        forOp.isDefinedOutsideOfLoop(loadOp.getPtr()))
+      continue;
+    DenseSet<Operation *> slice;
+    if (!collectAddressSlice(forOp, loadOp.getPtr(), slice))
+      continue;
+    if (Value mask = loadOp.getMask())
+      if (!collectAddressSlice(forOp, mask, slice))
+        continue;
+    // The addresses that don't depend on loaded values are left to the
+    // hardware prefetchers
+    if (llvm::none_of(slice, [](Operation *op) { return isa<tt::LoadOp>(op); }))
+      continue;
+    SmallVector<Operation *> orderedSlice;
+    for (Operation &op : forOp.getBody()->without_terminator())
+      if (slice.contains(&op))
+        orderedSlice.push_back(&op);
+    gathers.emplace_back(loadOp, std::move(orderedSlice));
+  }
+  for (auto &[loadOp, slice] : gathers)
+    prefetchNextIteration(forOp, loadOp, slice);
+  return !gathers.empty();
+}
+
 static void setWaitNum(Operation *op,
                        mlir::triton::PipeliningOption::PipelinerPart part,
-                       unsigned iteration, unsigned numLoadsInStage) {
+                       unsigned iteration, unsigned numLoadsInStage,
+                       unsigned numLoads) {
   if (auto waitOp = dyn_cast<ttg::AsyncWaitOp>(op)) {
+    // No copy is issued in a peeled epilogue, each part has one iteration
+    // less in flight.
+    if (part == mlir::triton::PipeliningOption::PipelinerPart::Epilogue) {
+      unsigned numDone = (iteration + 1) * numLoads;
+      waitOp.setNum(numLoadsInStage > numDone ? numLoadsInStage - numDone
+                                              : 0);
+      return;
+    }
     waitOp.setNum(numLoadsInStage);
   }
 }
@@ -537,6 +804,11 @@ static std::vector<std::pair<Operation *, unsigned>>
 createSchedule(scf::ForOp forOp, int numStages, bool prefetchExtract) {
   SmallVector<Operation *> insertOps;
   SmallVector<Operation *> extractOps;
+  // The mbarriers of the TMA loads are waited on in the last stage, their
+  // arrives being predicated. Those of the async copies aren't, they are
+  // waited on with the extracts like an async_wait.
+  bool hasTMALoad =
+      !llvm::empty(forOp.getBody()->getOps<ttng::InsertSliceTMAOp>());
   // Find the insert/extract ops that will go respectively in stage 0 and stage
   // `numStages - 2`. All the other operations will go in stage `numStages - 1`.
   for (Operation &op : forOp.getBody()->without_terminator()) {
@@ -544,7 +816,8 @@ createSchedule(scf::ForOp forOp, int numStages, bool prefetchExtract) {
             ttng::MBarrierArriveOp, ttng::InsertSliceTMAOp>(op))
       insertOps.emplace_back(&op);
     if (prefetchExtract) {
-      if (isa<ttg::ExtractSliceOp, ttg::AsyncWaitOp>(op))
+      if (isa<ttg::ExtractSliceOp, ttg::AsyncWaitOp>(op) ||
+          (isa<ttng::MBarrierWaitOp>(op) && !hasTMALoad))
         extractOps.emplace_back(&op);
     }
   }
@@ -611,25 +884,195 @@ createSchedule(scf::ForOp forOp, int numStages, bool prefetchExtract) {
   return schedule;
 }
 
+// Returns an estimate of the registers held by the values that ops scheduled
+// in stage 0, the dependencies of the pipelined loads and the loads with a
+// distance of 1, define for the later stages. The expander keeps one copy of
+// them per stage in flight, so they are counted `numStages - 1` times.
+static unsigned getCrossStageRegisters(scf::ForOp forOp,
+                                       ArrayRef<LoadDotOperand> loads,
+                                       int numStages) {
+  DenseSet<Operation *> stage0;
+  for (const LoadDotOperand &load : loads)
+    addDep(load.load, stage0, false);
+  SmallVector<Operation *> distanceOneLoads;
+  Operation *yieldOp = forOp.getBody()->getTerminator();
+  for (Operation *op : stage0) {
+    for (Value operand : op->getOperands()) {
+      auto arg = operand.dyn_cast<BlockArgument>();
+      if (!arg || arg.getArgNumber() == 0 || arg.getOwner() != op->getBlock())
+        continue;
+      Value v = yieldOp->getOperand(arg.getArgNumber() - 1);
+      if (auto loadOp = v.getDefiningOp<tt::LoadOp>())
+        if (!stage0.count(loadOp))
+          distanceOneLoads.push_back(loadOp);
+    }
+  }
+  for (Operation *op : distanceOneLoads)
+    addDep(op, stage0, true);
+
+  unsigned registers = 0;
+  for (Operation *op : stage0) {
+    // The pipelined loads write to shared memory
+    if (llvm::any_of(loads, [&](const LoadDotOperand &load) {
+          return load.load == op;
+        }))
+      continue;
+    for (Value result : op->getResults()) {
+      bool usedInLaterStage = llvm::any_of(result.getUsers(), [&](auto user) {
+        return user != yieldOp && user->getBlock() == forOp.getBody() &&
+               !stage0.count(user);
+      });
+      if (usedInLaterStage)
+        registers += getNumRegisters(result.getType());
+    }
+  }
+  return registers * (numStages - 1);
+}
+
+// Latencies, in cycles, of the ops that dominate a loop iteration.
+static constexpr unsigned kGlobalLoadLatency = 500;
+static constexpr unsigned kTMALoadLatency = 600;
+static constexpr unsigned kMMALatency = 32;
+static constexpr unsigned kSFULatency = 20;
+// Multiply-adds per cycle of the tensor cores of an SM sub-partition, and
+// elements per cycle of the special function and FP32 units of an SM.
+static constexpr unsigned kMMAv2FMAsPerCycle = 256;
+static constexpr unsigned kWGMMAFMAsPerCycle = 512;
+static constexpr unsigned kSFUElementsPerCycle = 16;
+static constexpr unsigned kALUElementsPerCycle = 128;
+static constexpr unsigned kNumSubPartitions = 4;
+
+unsigned mlir::triton::getOpLatency(Operation *op, unsigned numWarps) {
+  if (isa<ttng::InsertSliceTMAOp>(op))
+    return kTMALoadLatency;
+  if (isa<ttg::InsertSliceAsyncOp>(op))
+    return kGlobalLoadLatency;
+  if (auto loadOp = dyn_cast<tt::LoadOp>(op))
+    return isLoadFromTensorPtr(loadOp) ? kTMALoadLatency : kGlobalLoadLatency;
+  if (op->getNumResults() != 1)
+    return 1;
+  auto tensorTy = op->getResult(0).getType().dyn_cast<RankedTensorType>();
+  if (!tensorTy)
+    return 1;
+  int64_t numElements = tensorTy.getNumElements();
+  if (auto dotOp = dyn_cast<tt::DotOp>(op)) {
+    auto aTy = dotOp.getA().getType().cast<RankedTensorType>();
+    int64_t numFMAs = numElements * aTy.getShape().back();
+    auto mma = tensorTy.getEncoding().dyn_cast<ttg::NvidiaMmaEncodingAttr>();
+    if (!mma)
+      return numFMAs / kALUElementsPerCycle + 1;
+    unsigned fmasPerCycle =
+        (mma.isHopper() ? kWGMMAFMAsPerCycle : kMMAv2FMAsPerCycle) *
+        std::min(numWarps, kNumSubPartitions);
+    return kMMALatency + numFMAs / fmasPerCycle;
+  }
+  if (isa<math::ExpOp, math::Exp2Op, math::LogOp, math::Log2Op, math::SinOp,
+          math::CosOp, math::SqrtOp, math::RsqrtOp>(op))
+    return kSFULatency + numElements / kSFUElementsPerCycle;
+  return numElements / kALUElementsPerCycle + 1;
+}
+
+// The latency estimate only trims deep pipelines. Three stages, the default,
+// are always kept: the estimate ignores the memory bandwidth shared with the
+// other CTAs.
+static constexpr int kMinLatencyBoundStages = 3;
+
+// Returns the number of stages that hide the latency of the pipelined loads,
+// modulo scheduling the loop. A new iteration starts every `ii` cycles, the
+// time its ops keep the SM busy, the async copies only counting for their
+// issue. A copy issued in stage 0 is waited on `numStages - 2` iterations
+// later when the extracts are prefetched, `numStages - 1` otherwise. Further
+// stages only cost shared memory and registers.
+static int getLatencyBoundStages(scf::ForOp forOp,
+                                 ArrayRef<LoadDotOperand> loads,
+                                 bool prefetchExtract) {
+  unsigned numWarps = ttg::TritonGPUDialect::getNumWarps(
+      forOp->getParentOfType<ModuleOp>());
+  DenseSet<Operation *> asyncLoads;
+  unsigned latency = 0;
+  for (const LoadDotOperand &load : loads) {
+    asyncLoads.insert(load.load);
+    latency = std::max(latency, getOpLatency(load.load, numWarps));
+  }
+  uint64_t ii = 0;
+  for (Operation &op : forOp.getBody()->without_terminator())
+    ii += asyncLoads.count(&op) ? 1 : getOpLatency(&op, numWarps);
+  int numIterations = llvm::divideCeil(latency, std::max<uint64_t>(ii, 1));
+  return std::max(numIterations + (prefetchExtract ? 2 : 1),
+                  kMinLatencyBoundStages);
+}
+
+// Peeling the epilogue replaces the last `numStages - 1` iterations of the
+// kernel loop, which still compute the addresses and issue the masked copies
+// of the iterations past the end, with copies of the later stages only. It
+// pays off when those iterations are a large part of a short loop whose body
+// is small enough to be duplicated.
+static constexpr int64_t kMaxPeeledIterationsPerStage = 3;
+static constexpr unsigned kMaxPeeledBodyOps = 64;
+
+static bool shouldPeelEpilogue(scf::ForOp forOp, int numStages) {
+  std::optional<int64_t> lb = getConstantIntValue(forOp.getLowerBound());
+  std::optional<int64_t> ub = getConstantIntValue(forOp.getUpperBound());
+  std::optional<int64_t> step = getConstantIntValue(forOp.getStep());
+  if (!lb || !ub || !step || *step <= 0)
+    return false;
+  int64_t maxStage = numStages - 1;
+  int64_t numIterations = ceilDiv(*ub - *lb, *step);
+  if (numIterations <= maxStage ||
+      numIterations > kMaxPeeledIterationsPerStage * maxStage)
+    return false;
+  unsigned numOps = 0;
+  forOp.getBody()->walk([&](Operation *) { ++numOps; });
+  return numOps <= kMaxPeeledBodyOps;
+}
+
 bool mlir::triton::preProcessLoopAndGetSchedule(
-    scf::ForOp &forOp, int numStages, mlir::triton::PipeliningOption &options) {
+    scf::ForOp &forOp, int numStages, ModuleAxisInfoAnalysis &axisInfoAnalysis,
+    unsigned loopRegisters, int computeCapability, bool asyncBarriers,
+    mlir::triton::PipeliningOption &options) {
   // 1. First collect "interesting" operations with a stage where to schedule
   // them. This gives a coarse scheduling for the loop.
   SmallVector<LoadDotOperand> loads;
   bool hasMMAV3 = false;
-  collectOpsToPipeline(forOp, loads, hasMMAV3);
+  collectOpsToPipeline(forOp, axisInfoAnalysis, numStages, computeCapability,
+                       loads, hasMMAV3);
   if (loads.empty())
     return false;
+  // Use fewer stages rather than spilling. Two stages are kept: pipelining
+  // isn't what makes the loop itself need too many registers.
+  while (numStages > 2) {
+    unsigned crossStageRegisters =
+        getCrossStageRegisters(forOp, loads, numStages);
+    if (crossStageRegisters == 0 ||
+        loopRegisters + crossStageRegisters <= kMaxRegistersPerThread)
+      break;
+    --numStages;
+  }
+  bool prefetchExtract = !hasMMAV3;
+  numStages = std::min(numStages,
+                       getLatencyBoundStages(forOp, loads, prefetchExtract));
   bool hasAsynCp = llvm::any_of(loads, [](LoadDotOperand &load) {
     return !isLoadFromTensorPtr(load.load);
   });
+  bool hasTMALoad = llvm::any_of(loads, [](LoadDotOperand &load) {
+    return isLoadFromTensorPtr(load.load);
+  });
+  // The waits on the async dots and the TMA barriers are only placed for a
+  // predicated kernel loop.
+  bool peelEpilogue =
+      !hasMMAV3 && !hasTMALoad && shouldPeelEpilogue(forOp, numStages);
   // 2. Convert the loads into async loads and create the allocs.
-  SmallVector<Value> allocs = createAsynOps(forOp, loads, numStages, hasMMAV3);
+  // The mbarrier waits are only lowered from compute capability 90, and are
+  // scheduled with the extracts, which aren't prefetched for MMAv3.
+  bool useAsyncBarriers = asyncBarriers && computeCapability >= 90 &&
+                          hasAsynCp && !hasTMALoad && prefetchExtract;
+  SmallVector<Value> allocs =
+      createAsynOps(forOp, loads, numStages, hasMMAV3, useAsyncBarriers);
 
   // 3. Create the final schedule for the kernel loop. This will dictate the
   // stages and order of operations to the pipeline expander.
   std::vector<std::pair<Operation *, unsigned>> schedule =
-      createSchedule(forOp, numStages, /*prefetchExtract=*/!hasMMAV3);
+      createSchedule(forOp, numStages, prefetchExtract);
 
   // 4. Fill out the pipeline options.
   options.getScheduleFn =
@@ -637,26 +1080,185 @@ bool mlir::triton::preProcessLoopAndGetSchedule(
                  std::vector<std::pair<Operation *, unsigned>> &s) {
         s = std::move(schedule);
       };
-  options.peelEpilogue = false;
+  options.peelEpilogue = peelEpilogue;
   options.predicateFn = predicateOp;
   options.supportDynamicLoops = true;
-  unsigned numLoadsInStage = (numStages - 2) * loads.size();
+  unsigned numLoads = loads.size();
+  unsigned numLoadsInStage = (numStages - 2) * numLoads;
   options.annotateFn =
-      [numLoadsInStage](Operation *op,
-                        mlir::triton::PipeliningOption::PipelinerPart part,
-                        unsigned iteration) {
-        return setWaitNum(op, part, iteration, numLoadsInStage);
+      [numLoadsInStage, numLoads](
+          Operation *op, mlir::triton::PipeliningOption::PipelinerPart part,
+          unsigned iteration) {
+        return setWaitNum(op, part, iteration, numLoadsInStage, numLoads);
       };
 
-  if (hasAsynCp) {
-    // Insert a wait 0 after the loop
-    OpBuilder builder(forOp);
-    builder.setInsertionPointAfter(forOp);
+  // The buffers of the stages are dead once the last copies into them
+  // completed: free them so that the epilogue reuses their shared memory,
+  // and so that its conversions are sunk past them (see
+  // `tritongpu-reorder-instructions`). The TMA loads of the loop are all
+  // waited on inside it, but masked-off cp.async still write their zeros.
+  OpBuilder builder(forOp);
+  builder.setInsertionPointAfter(forOp);
+  if (hasAsynCp)
     builder.create<ttg::AsyncWaitOp>(forOp.getLoc(), 0);
-    // Explicitly deallocate allocated tensors after the wait op
-    for (auto alloc : allocs)
-      builder.create<ttg::DeallocTensorOp>(forOp.getLoc(), alloc);
+  for (auto alloc : allocs)
+    builder.create<ttg::DeallocTensorOp>(forOp.getLoc(), alloc);
+  return true;
+}
+
+// Shared memory the buffers of a pipelined inner loop may take once they are
+// kept live across the outer loop, leaving room for the scratch buffers of
+// the epilogue.
+static constexpr int64_t kMaxOuterLoopBufferBytes = 64 * 1024;
+
+bool mlir::triton::preProcessOuterLoopAndGetSchedule(
+    scf::ForOp &forOp, mlir::triton::PipeliningOption &options) {
+  Block *body = forOp.getBody();
+  // The body has to hold a single loop, pipelined with cp.async.
+  scf::ForOp innerLoop;
+  for (Operation &op : body->without_terminator()) {
+    if (auto loop = dyn_cast<scf::ForOp>(&op)) {
+      if (innerLoop)
+        return false;
+      innerLoop = loop;
+    }
+  }
+  if (!innerLoop)
+    return false;
+  bool hasNestedLoop =
+      forOp
+          ->walk([&](Operation *op) {
+            if (op != forOp.getOperation() && op != innerLoop.getOperation() &&
+                isa<scf::ForOp, scf::WhileOp>(op))
+              return WalkResult::interrupt();
+            return WalkResult::advance();
+          })
+          .wasInterrupted();
+  if (hasNestedLoop)
+    return false;
+  Operation *yieldOp = body->getTerminator();
+  if (llvm::any_of(yieldOp->getOperands(),
+                   [](Value operand) { return !operand.getDefiningOp(); }))
+    return false;
+
+  // The copies of the prologue of the inner loop, and their buffers.
+  SmallVector<Operation *> prologueCopies;
+  DenseSet<Operation *> allocs;
+  int64_t bufferBytes = 0;
+  for (Operation &op : body->without_terminator()) {
+    if (isa<ttng::InsertSliceTMAOp, ttng::MBarrierArriveOp,
+            ttng::AllocMBarrierOp>(op))
+      return false;
+    if (auto alloc = dyn_cast<ttg::AllocTensorOp>(&op)) {
+      auto ty = alloc.getType().cast<RankedTensorType>();
+      bufferBytes += ty.getNumElements() * ty.getElementTypeBitWidth() / 8;
+      allocs.insert(alloc);
+    }
+    if (op.isBeforeInBlock(innerLoop) &&
+        isa<ttg::InsertSliceAsyncOp, ttg::AsyncCommitGroupOp>(op))
+      prologueCopies.push_back(&op);
+  }
+  if (prologueCopies.empty() || bufferBytes > kMaxOuterLoopBufferBytes)
+    return false;
+  // The buffers must only be written by the copies and freed after the inner
+  // loop.
+  SmallVector<Operation *> deallocs;
+  for (Operation *alloc : allocs) {
+    for (Operation *user : alloc->getUsers()) {
+      if (isa<ttg::DeallocTensorOp>(user) && user->getBlock() == body)
+        deallocs.push_back(user);
+      else if (!isa<ttg::InsertSliceAsyncOp>(user))
+        return false;
+    }
+  }
+
+  // The inner loop is waited on and its buffers freed before the copies of
+  // the next iteration are issued. The ops following it are the epilogue
+  // the copies are hidden behind.
+  Operation *split = innerLoop;
+  for (Operation *next = split->getNextNode();
+       isa<ttg::AsyncWaitOp, ttg::DeallocTensorOp, ttng::DotWaitOp>(next);
+       next = next->getNextNode()) {
+    if (!isa<ttg::DeallocTensorOp>(next))
+      split = next;
+  }
+  bool hasEpilogue = llvm::any_of(
+      llvm::make_range(std::next(split->getIterator()),
+                       body->without_terminator().end()),
+      [](Operation &op) {
+        return !isMemoryEffectFree(&op) ||
+               llvm::any_of(op.getResultTypes(), [](Type type) {
+                 return type.isa<RankedTensorType>();
+               });
+      });
+  if (!hasEpilogue)
+    return false;
+
+  // Stage 0 holds the copies of the next iteration and their dependencies,
+  // stage 1 the rest of the body.
+  DenseSet<Operation *> stage0;
+  for (Operation *op : prologueCopies)
+    addDep(op, stage0, false, &allocs);
+  for (Operation *op : stage0) {
+    if (op->getNumRegions() != 0)
+      return false;
+    if (!isMemoryEffectFree(op) &&
+        !isa<ttg::InsertSliceAsyncOp, ttg::AsyncCommitGroupOp, tt::LoadOp>(op))
+      return false;
+  }
+  // The loop carried values the copies use are computed by the previous
+  // iteration before they are issued.
+  DenseSet<Operation *> carried;
+  for (Operation *op : stage0) {
+    for (Value operand : op->getOperands()) {
+      auto arg = operand.dyn_cast<BlockArgument>();
+      if (!arg || arg.getOwner() != body || arg.getArgNumber() == 0)
+        continue;
+      Operation *def =
+          yieldOp->getOperand(arg.getArgNumber() - 1).getDefiningOp();
+      if (def->getBlock() == body)
+        addDep(def, carried, false, &stage0);
+    }
   }
+  for (Operation *op : carried) {
+    if (split->isBeforeInBlock(op) &&
+        (!isMemoryEffectFree(op) || op->getNumRegions() != 0))
+      return false;
+  }
+
+  // Keep the buffers live across the outer loop so that the copies of the
+  // next iteration reuse them.
+  for (Operation *alloc : allocs)
+    alloc->moveBefore(forOp);
+  OpBuilder builder(forOp);
+  builder.setInsertionPointAfter(forOp);
+  builder.create<ttg::AsyncWaitOp>(forOp.getLoc(), 0);
+  for (Operation *dealloc : deallocs)
+    dealloc->moveBefore(builder.getInsertionBlock(),
+                        builder.getInsertionPoint());
+
+  std::vector<std::pair<Operation *, unsigned>> schedule;
+  bool beforeSplit = true;
+  for (Operation &op : body->without_terminator()) {
+    if (!stage0.count(&op) && (beforeSplit || carried.count(&op)))
+      schedule.emplace_back(&op, 1);
+    if (&op == split)
+      beforeSplit = false;
+  }
+  addOps(forOp, 0, schedule, [&](Operation *op) { return stage0.count(op); });
+  addOps(forOp, 1, schedule, [&](Operation *op) {
+    return split->isBeforeInBlock(op) && !stage0.count(op) &&
+           !carried.count(op);
+  });
+
+  options.getScheduleFn =
+      [schedule](scf::ForOp forOp,
+                 std::vector<std::pair<Operation *, unsigned>> &s) {
+        s = std::move(schedule);
+      };
+  options.peelEpilogue = false;
+  options.predicateFn = predicateOp;
+  options.supportDynamicLoops = true;
   return true;
 }
 
@@ -19,11 +19,13 @@
 // -Fix bug when a value yield is used outside the loop and the value def is not
 // in the last stage. If we are not peeling the epilgue we need to remap the
 // output correctly.
+// -Peel the epilogue of loops with constant bounds of a non-index type.
 
 #include "mlir/Dialect/Arith/IR/Arith.h"
 #include "mlir/Dialect/SCF/IR/SCF.h"
 #include "mlir/Dialect/SCF/Transforms/Patterns.h"
 #include "mlir/Dialect/SCF/Utils/Utils.h"
+#include "mlir/Dialect/Utils/StaticValueUtils.h"
 #include "mlir/IR/IRMapping.h"
 #include "mlir/IR/PatternMatch.h"
 #include "mlir/Support/MathExtras.h"
@@ -31,7 +33,7 @@
 #include "llvm/ADT/MapVector.h"
 #include "llvm/Support/Debug.h"
 
-#include "PipelineExpander.h"
+#include "triton/Dialect/TritonGPU/Transforms/PipelineExpander.h"
 
 #define DEBUG_TYPE "triton-loop-pipelining"
 #define DBGS() (llvm::dbgs() << "[" DEBUG_TYPE "]: ")
@@ -141,10 +143,6 @@ bool LoopPipelinerInternal::initializeLoopInfo(
     LDBG("--no epilogue or predicate set -> BAIL");
     return false;
   }
-  if (dynamicLoop && peelEpilogue) {
-    LDBG("--dynamic loop doesn't support epilogue yet -> BAIL");
-    return false;
-  }
   std::vector<std::pair<Operation *, unsigned>> schedule;
   options.getScheduleFn(forOp, schedule);
   if (schedule.empty()) {
@@ -159,6 +157,20 @@ bool LoopPipelinerInternal::initializeLoopInfo(
     opOrder.push_back(opSchedule.first);
   }
 
+  // The epilogue can still be peeled when the bounds are constants of a
+  // non-index type, as long as the loop runs more iterations than it has
+  // stages.
+  if (dynamicLoop && peelEpilogue) {
+    std::optional<int64_t> ubImm = getConstantIntValue(ub);
+    std::optional<int64_t> lbImm = getConstantIntValue(lb);
+    std::optional<int64_t> stepImm = getConstantIntValue(step);
+    if (!ubImm || !lbImm || !stepImm ||
+        ceilDiv(*ubImm - *lbImm, *stepImm) <= maxStage) {
+      LDBG("--dynamic loop doesn't support epilogue yet -> BAIL");
+      return false;
+    }
+  }
+
   // All operations need to have a stage.
   for (Operation &op : forOp.getBody()->without_terminator()) {
     if (!stages.contains(&op)) {
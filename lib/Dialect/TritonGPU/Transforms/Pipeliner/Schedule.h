@@ -1,21 +1,58 @@
 #ifndef TRITON_TRITONGPU_TRANSFORM_PIPELINE_SCHEDULE_H_
 #define TRITON_TRITONGPU_TRANSFORM_PIPELINE_SCHEDULE_H_
 
-#include "PipelineExpander.h"
 #include "mlir/Dialect/SCF/IR/SCF.h"
 #include "mlir/Support/LLVM.h"
+#include "triton/Dialect/TritonGPU/Transforms/PipelineExpander.h"
 #include "llvm/ADT/ArrayRef.h"
 #include <vector>
 
 namespace mlir {
+class ModuleAxisInfoAnalysis;
+
 namespace triton {
 
 /// This fill out the pipelining options including schedule and annotations for
 /// wait ops. This also does pre-processing by converting some of the loads into
-/// async loads so that the IR is ready to be pipelined.
+/// async loads so that the IR is ready to be pipelined. `loopRegisters` is the
+/// estimated register pressure of the loop, fewer stages are used when the
+/// values kept across stages would make it exceed the registers of a thread.
+/// The loads that don't feed a dot are only staged through shared memory from
+/// `computeCapability` 80, which has cp.async. With `asyncBarriers`, from
+/// `computeCapability` 90, the async copies of each stage arrive on an
+/// mbarrier which their consumers wait on instead of an async_wait followed by
+/// a CTA barrier.
 bool preProcessLoopAndGetSchedule(scf::ForOp &forOp, int numStages,
+                                  ModuleAxisInfoAnalysis &axisInfoAnalysis,
+                                  unsigned loopRegisters, int computeCapability,
+                                  bool asyncBarriers,
                                   mlir::triton::PipeliningOption &options);
 
+/// Prefetches into L2, an iteration ahead, the lines of the gathers of `forOp`
+/// that preProcessLoopAndGetSchedule doesn't stage through shared memory,
+/// whose addresses depend on values loaded in the iteration like the pages of
+/// a paged KV cache or the rows of an embedding table. The addresses of the
+/// next iteration are computed by a copy of their slice. Only done from
+/// `computeCapability` 80. Returns true if a prefetch was inserted.
+bool prefetchGathers(scf::ForOp forOp, int numStages,
+                     ModuleAxisInfoAnalysis &axisInfoAnalysis,
+                     int computeCapability);
+
+/// Fills out the pipelining options of an outer loop whose body holds a loop
+/// pipelined by preProcessLoopAndGetSchedule, such as the tile loop of a
+/// persistent kernel. The copies of the prologue of the inner loop are issued
+/// one iteration ahead, once the inner loop of the current iteration is done,
+/// to overlap with its epilogue. The buffers of the inner loop are hoisted out
+/// of the outer loop to be reused across its iterations.
+bool preProcessOuterLoopAndGetSchedule(scf::ForOp &forOp,
+                                       mlir::triton::PipeliningOption &options);
+
+/// Returns an estimate of the cycles `op` keeps an SM busy in a loop
+/// iteration or, for global loads and async copies, of the cycles until their
+/// data is available. It is used to pick the number of stages hiding
+/// the latency of the pipelined loads.
+unsigned getOpLatency(Operation *op, unsigned numWarps);
+
 /// This does post-processing on the pipelined loop to try to pipeline wgmma
 /// ops.
 // TODO: this should be included as part of the pipeline but currently the wgmma
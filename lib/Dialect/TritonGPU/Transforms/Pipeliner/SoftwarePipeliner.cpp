@@ -1,4 +1,3 @@
-#include "PipelineExpander.h"
 #include "Schedule.h"
 #include "mlir/Dialect/Tensor/IR/Tensor.h"
 #include "mlir/IR/IRMapping.h"
@@ -6,9 +5,11 @@
 #include "mlir/Interfaces/SideEffectInterfaces.h"
 #include "mlir/Transforms/GreedyPatternRewriteDriver.h"
 #include "triton/Analysis/AxisInfo.h"
+#include "triton/Analysis/RegisterPressure.h"
 #include "triton/Analysis/Utility.h"
 #include "triton/Dialect/TritonGPU/IR/Dialect.h"
 #include "triton/Dialect/TritonGPU/Transforms/Passes.h"
+#include "triton/Dialect/TritonGPU/Transforms/PipelineExpander.h"
 #include "triton/Dialect/TritonGPU/Transforms/Utility.h"
 #include "triton/Dialect/TritonNvidiaGPU/IR/Dialect.h"
 #include "triton/Tools/Sys/GetEnv.hpp"
@@ -39,6 +40,9 @@ bool preCondition(scf::ForOp forOp) {
                      return !def;
                    }))
     return false;
+  // Don't pipeline the tails left by the masked tail peeling.
+  if (forOp->hasAttr(kPeeledTailAttrName))
+    return false;
   // Don't pipeline outer loops.
   if (forOp
           ->walk([&](Operation *op) {
@@ -53,17 +57,31 @@ bool preCondition(scf::ForOp forOp) {
   return true;
 }
 
-static void pipelineLoop(scf::ForOp forOp, int numStages) {
+// Returns true if the loop was rewritten or its gathers prefetched.
+static bool pipelineLoop(scf::ForOp forOp, int numStages, int computeCapability,
+                         bool asyncBarriers,
+                         ModuleAxisInfoAnalysis &axisInfoAnalysis,
+                         const RegisterPressureAnalysis &pressure) {
   mlir::triton::PipeliningOption options;
   if (!preCondition(forOp))
-    return;
+    return false;
+
+  // The gathers that can't be staged through shared memory are prefetched
+  // into L2 instead.
+  bool prefetched = mlir::triton::prefetchGathers(
+      forOp, numStages, axisInfoAnalysis, computeCapability);
+  if (prefetched)
+    axisInfoAnalysis.recompute(
+        forOp->getParentOfType<FunctionOpInterface>());
 
   bool foundSchedule = false;
-  foundSchedule = preProcessLoopAndGetSchedule(forOp, numStages, options);
+  foundSchedule = preProcessLoopAndGetSchedule(
+      forOp, numStages, axisInfoAnalysis, pressure.getMaxRegisters(forOp),
+      computeCapability, asyncBarriers, options);
 
   // TODO: add more pipelines strategy.
   if (!foundSchedule)
-    return;
+    return prefetched;
 
   IRRewriter rewriter(forOp->getContext());
   rewriter.setInsertionPoint(forOp);
@@ -72,34 +90,76 @@ static void pipelineLoop(scf::ForOp forOp, int numStages) {
 
   if (succeeded(newForOp))
     mlir::triton::asyncLaunchDots(newForOp.value());
+  return true;
+}
+
+// Returns true if the outer loop was rewritten to issue the copies of the first
+// stages of its pipelined inner loop one iteration ahead, during the epilogue
+// of the previous iteration.
+static bool pipelineOuterLoop(scf::ForOp forOp) {
+  mlir::triton::PipeliningOption options;
+  if (!preProcessOuterLoopAndGetSchedule(forOp, options))
+    return false;
+
+  IRRewriter rewriter(forOp->getContext());
+  rewriter.setInsertionPoint(forOp);
+  (void)mlir::triton::pipelineForLoop(rewriter, forOp, options);
+  return true;
 }
 
 namespace {
 struct PipelinePass : public TritonGPUPipelineBase<PipelinePass> {
   PipelinePass() = default;
-  PipelinePass(int numStages, int numWarps, int numCTAs,
-               int computeCapability) {
+  PipelinePass(int numStages, int numWarps, int numCTAs, int computeCapability,
+               bool asyncBarriers) {
     this->numStages = numStages;
     this->numWarps = numWarps;
     this->numCTAs = numCTAs;
     this->computeCapability = computeCapability;
+    this->asyncBarriers = asyncBarriers;
   }
 
   void runOnOperation() override {
-    if (this->numStages <= 1)
+    if (this->numStages <= 1) {
+      markAllAnalysesPreserved();
       return;
+    }
+    ModuleAxisInfoAnalysis &axisInfoAnalysis =
+        getAnalysis<ModuleAxisInfoAnalysis>();
     SmallVector<scf::ForOp> loops;
     getOperation()->walk([&](scf::ForOp forOp) { loops.push_back(forOp); });
+    DenseMap<Operation *, std::unique_ptr<RegisterPressureAnalysis>>
+        pressures;
+    bool changed = false;
     for (scf::ForOp forOp : loops) {
-      pipelineLoop(forOp, numStages);
+      auto funcOp = forOp->getParentOfType<FunctionOpInterface>();
+      auto &pressure = pressures[funcOp.getOperation()];
+      if (!pressure)
+        pressure = std::make_unique<RegisterPressureAnalysis>(funcOp);
+      // The inner loops are visited first, so an outer loop sees its inner
+      // loop already pipelined.
+      if (!pipelineLoop(forOp, numStages, computeCapability, asyncBarriers,
+                        axisInfoAnalysis, *pressure) &&
+          !pipelineOuterLoop(forOp))
+        continue;
+      // The next loops may use the values of the rewritten one. Pipelining
+      // doesn't change the calls, so only its function goes stale.
+      axisInfoAnalysis.recompute(funcOp);
+      pressures.erase(funcOp.getOperation());
+      changed = true;
     }
+    if (!changed)
+      markAllAnalysesPreserved();
+    else
+      markAnalysesPreserved<ModuleAxisInfoAnalysis>();
   }
 };
 } // anonymous namespace
 
 std::unique_ptr<Pass>
 mlir::triton::gpu::createPipelinePass(int numStages, int numWarps, int numCTAs,
-                                      int computeCapability) {
+                                      int computeCapability,
+                                      bool asyncBarriers) {
   return std::make_unique<PipelinePass>(numStages, numWarps, numCTAs,
-                                        computeCapability);
+                                        computeCapability, asyncBarriers);
 }
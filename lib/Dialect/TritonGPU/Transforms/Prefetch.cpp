@@ -24,11 +24,20 @@
 //   ...
 //   scf.yield %next_a, ..., %a_prefetch_next
 // }
+//
+// Dots with a Hopper MMA layout (tt.dot and triton_nvidia_gpu.dot_async) only
+// prefetch their a operand into registers, as WGMMA reads b from shared
+// memory: b is sliced along k in shared memory. When the shared memory a is
+// loaded from is not a loop argument, as the pipeliner leaves it on Hopper, the
+// first slice isn't carried across iterations but the load of each next slice
+// still overlaps the WGMMA of the current one.
 //===----------------------------------------------------------------------===//
 
 #include "mlir/IR/IRMapping.h"
+#include "triton/Analysis/RegisterPressure.h"
 #include "triton/Dialect/TritonGPU/IR/Dialect.h"
 #include "triton/Dialect/TritonGPU/Transforms/Passes.h"
+#include "triton/Dialect/TritonNvidiaGPU/IR/Dialect.h"
 
 using namespace mlir;
 
@@ -42,12 +51,16 @@ class Prefetcher {
   scf::ForOp forOp;
   /// cache the YieldOp of this ForOp
   scf::YieldOp yieldOp;
+  /// register pressure of the function of this ForOp
+  const RegisterPressureAnalysis &pressure;
   ///
   // TODO: add a hook to infer prefetchWidth
   unsigned prefetchWidth = 32;
 
   /// dots to be prefetched
   SetVector<Value> dots;
+  /// dots with a Hopper MMA layout, whose b operand stays in shared memory
+  DenseSet<Value> mmaV3Dots;
   /// dot => dot operand
   DenseMap<Value, Value> dot2aLoopArg;
   DenseMap<Value, Value> dot2aHeaderDef;
@@ -62,18 +75,23 @@ class Prefetcher {
 
   LogicalResult isForOpOperand(Value v);
 
+  Attribute getOperandEncoding(Value dot, unsigned opIdx);
+
   Value generatePrefetch(Value v, unsigned opIdx, bool isPrologue,
-                         Attribute dotEncoding, OpBuilder &builder,
+                         Attribute operandEncoding, OpBuilder &builder,
                          std::optional<int64_t> offsetK = std::nullopt,
                          std::optional<int64_t> shapeK = std::nullopt);
 
   void cloneElementwiseOps(Value &bRem, const SmallVector<Value> &vals,
                            OpBuilder &builder);
 
+  unsigned getPrefetchRegisters(Operation *dot);
+
 public:
   Prefetcher() = delete;
 
-  Prefetcher(scf::ForOp forOp) : forOp(forOp) {
+  Prefetcher(scf::ForOp forOp, const RegisterPressureAnalysis &pressure)
+      : forOp(forOp), pressure(pressure) {
     yieldOp = cast<scf::YieldOp>(forOp.getBody()->getTerminator());
   }
 
@@ -102,8 +120,23 @@ void Prefetcher::cloneElementwiseOps(Value &ret, const SmallVector<Value> &vals,
     ret = mapping.lookup(vals.back());
 }
 
+/// Returns the layout the slices of operand `opIdx` of `dot` are loaded to, or
+/// null if they stay in shared memory.
+Attribute Prefetcher::getOperandEncoding(Value dot, unsigned opIdx) {
+  if (mmaV3Dots.contains(dot)) {
+    if (opIdx == 1)
+      return Attribute();
+    return dot2aVals[dot][1].getType().cast<RankedTensorType>().getEncoding();
+  }
+  Attribute dotEncoding = dot.getType().cast<RankedTensorType>().getEncoding();
+  return triton::gpu::DotOperandEncodingAttr::get(dot.getContext(), opIdx,
+                                                  dotEncoding,
+                                                  prefetchWidth / 8);
+}
+
 Value Prefetcher::generatePrefetch(Value v, unsigned opIdx, bool isPrologue,
-                                   Attribute dotEncoding, OpBuilder &builder,
+                                   Attribute operandEncoding,
+                                   OpBuilder &builder,
                                    std::optional<int64_t> offsetK,
                                    std::optional<int64_t> shapeK) {
   // opIdx: 0 => a, 1 => b
@@ -130,23 +163,41 @@ Value Prefetcher::generatePrefetch(Value v, unsigned opIdx, bool isPrologue,
       v, SmallVector<OpFoldResult>{intAttr(offset[0]), intAttr(offset[1])},
       SmallVector<OpFoldResult>{intAttr(shape[0]), intAttr(shape[1])},
       SmallVector<OpFoldResult>{intAttr(1), intAttr(1)});
+  if (!operandEncoding)
+    return newSmem;
 
-  auto dotOperandEnc = triton::gpu::DotOperandEncodingAttr::get(
-      builder.getContext(), opIdx, dotEncoding, prefetchWidth / 8);
   Value prefetchSlice = builder.create<triton::gpu::ConvertLayoutOp>(
-      v.getLoc(), RankedTensorType::get(shape, elementType, dotOperandEnc),
+      v.getLoc(), RankedTensorType::get(shape, elementType, operandEncoding),
       newSmem);
 
   return prefetchSlice;
 }
 
+/// Returns the registers holding the slices of the operands of `dot` that are
+/// prefetched, as they are carried to the next iteration.
+unsigned Prefetcher::getPrefetchRegisters(Operation *dot) {
+  Attribute dotEncoding =
+      dot->getResult(0).getType().cast<RankedTensorType>().getEncoding();
+  unsigned registers = 0;
+  for (unsigned opIdx : {0, 1}) {
+    auto type = dot->getOperand(opIdx).getType().cast<RankedTensorType>();
+    SmallVector<int64_t> shape{type.getShape().begin(), type.getShape().end()};
+    shape[opIdx == 0 ? 1 : 0] = prefetchWidth;
+    auto dotOperandEnc = triton::gpu::DotOperandEncodingAttr::get(
+        dot.getContext(), opIdx, dotEncoding, prefetchWidth / 8);
+    registers += getNumRegisters(
+        RankedTensorType::get(shape, type.getElementType(), dotOperandEnc));
+  }
+  return registers;
+}
+
 LogicalResult Prefetcher::initialize() {
   Block *loop = forOp.getBody();
 
-  SmallVector<triton::DotOp> dotsInFor;
+  SmallVector<Operation *> dotsInFor;
   for (Operation &op : *loop)
-    if (auto dotOp = dyn_cast<triton::DotOp>(op))
-      dotsInFor.push_back(dotOp);
+    if (isa<triton::DotOp, triton::nvidia_gpu::DotAsyncOp>(op))
+      dotsInFor.push_back(&op);
 
   if (dotsInFor.empty())
     return failure();
@@ -198,11 +249,54 @@ LogicalResult Prefetcher::initialize() {
     return yieldOp.getOperand(yieldIdx);
   };
 
-  for (triton::DotOp dot : dotsInFor) {
-    auto aType = dot.getA().getType().cast<RankedTensorType>();
-    auto bType = dot.getB().getType().cast<RankedTensorType>();
-    auto aEnc = aType.getEncoding().cast<triton::gpu::DotOperandEncodingAttr>();
-    auto bEnc = bType.getEncoding().cast<triton::gpu::DotOperandEncodingAttr>();
+  for (Operation *op : dotsInFor) {
+    Value dot = op->getResult(0);
+    auto aType = op->getOperand(0).getType().cast<RankedTensorType>();
+    auto bType = op->getOperand(1).getType().cast<RankedTensorType>();
+    auto aEnc =
+        aType.getEncoding().dyn_cast<triton::gpu::DotOperandEncodingAttr>();
+    // The slices along k are taken from matrices, not from batches of them
+    if (!aEnc || aType.getRank() != 2)
+      continue;
+    auto mmaEnc = dot.getType()
+                      .cast<RankedTensorType>()
+                      .getEncoding()
+                      .dyn_cast<triton::gpu::NvidiaMmaEncodingAttr>();
+    if (mmaEnc && mmaEnc.isHopper()) {
+      auto kSize = aType.getShape()[1];
+      // a WGMMA instruction spans 32 bytes along k
+      prefetchWidth = 256 / aType.getElementTypeBitWidth();
+      // Skip prefetching if a single slice covers k
+      if (kSize <= prefetchWidth || kSize % prefetchWidth != 0 ||
+          !triton::gpu::hasSharedEncoding(op->getOperand(1)))
+        continue;
+      auto aVals = getPrefetchSrc(op->getOperand(0));
+      if (aVals.empty())
+        continue;
+      Value aSmem = aVals.front();
+      Value aHeaderDef = getIncomingOp(aSmem);
+      // Only the first slice of a loop arg is carried across iterations
+      if (aHeaderDef) {
+        auto sliceType = RankedTensorType::get(
+            {aType.getShape()[0], prefetchWidth}, aType.getElementType(), aEnc);
+        if (pressure.getRegisters(yieldOp) + getNumRegisters(sliceType) >
+            kMaxRegistersPerThread)
+          continue;
+        dot2aHeaderDef[dot] = aHeaderDef;
+        dot2aYield[dot] = getYieldOp(aSmem);
+      }
+      dots.insert(dot);
+      mmaV3Dots.insert(dot);
+      dot2aVals[dot] = aVals;
+      dot2bVals[dot] = {op->getOperand(1)};
+      dot2aLoopArg[dot] = aSmem;
+      dot2bLoopArg[dot] = op->getOperand(1);
+      continue;
+    }
+    auto bEnc =
+        bType.getEncoding().dyn_cast<triton::gpu::DotOperandEncodingAttr>();
+    if (!bEnc)
+      continue;
     int aKWidth = aEnc.getKWidth();
     int bKWidth = bEnc.getKWidth();
     assert(aKWidth == bKWidth);
@@ -219,8 +313,13 @@ LogicalResult Prefetcher::initialize() {
     // Skip prefetching if kSize is less than prefetchWidth
     if (kSize < prefetchWidth)
       continue;
-    auto aVals = getPrefetchSrc(dot.getA());
-    auto bVals = getPrefetchSrc(dot.getB());
+    // Skip prefetching if the prefetched slices, live across iterations, would
+    // make the loop spill
+    if (pressure.getRegisters(yieldOp) + getPrefetchRegisters(op) >
+        kMaxRegistersPerThread)
+      continue;
+    auto aVals = getPrefetchSrc(op->getOperand(0));
+    auto bVals = getPrefetchSrc(op->getOperand(1));
 
     if (aVals.size() && bVals.size()) {
       Value aSmem = aVals.front();
@@ -249,19 +348,19 @@ void Prefetcher::emitPrologue() {
   OpBuilder builder(forOp);
 
   for (Value dot : dots) {
-    Attribute dotEncoding =
-        dot.getType().cast<RankedTensorType>().getEncoding();
-    Value aPrefetched =
-        generatePrefetch(dot2aHeaderDef[dot], 0, true, dotEncoding, builder);
-    cloneElementwiseOps(aPrefetched, dot2aVals[dot], builder);
-    Value bPrefetched =
-        generatePrefetch(dot2bHeaderDef[dot], 1, true, dotEncoding, builder);
-    cloneElementwiseOps(bPrefetched, dot2bVals[dot], builder);
-
-    operand2headPrefetch[dot.getDefiningOp<triton::DotOp>().getA()] =
-        aPrefetched;
-    operand2headPrefetch[dot.getDefiningOp<triton::DotOp>().getB()] =
-        bPrefetched;
+    Operation *dotOp = dot.getDefiningOp();
+    if (Value aHeaderDef = dot2aHeaderDef.lookup(dot)) {
+      Value aPrefetched = generatePrefetch(
+          aHeaderDef, 0, true, getOperandEncoding(dot, 0), builder);
+      cloneElementwiseOps(aPrefetched, dot2aVals[dot], builder);
+      operand2headPrefetch[dotOp->getOperand(0)] = aPrefetched;
+    }
+    if (Value bHeaderDef = dot2bHeaderDef.lookup(dot)) {
+      Value bPrefetched = generatePrefetch(
+          bHeaderDef, 1, true, getOperandEncoding(dot, 1), builder);
+      cloneElementwiseOps(bPrefetched, dot2bVals[dot], builder);
+      operand2headPrefetch[dotOp->getOperand(1)] = bPrefetched;
+    }
   }
 }
 
@@ -271,12 +370,11 @@ scf::ForOp Prefetcher::createNewForOp() {
   SmallVector<Value> loopArgs;
   for (auto v : forOp.getInitArgs())
     loopArgs.push_back(v);
-  for (Value dot : dots) {
-    loopArgs.push_back(
-        operand2headPrefetch[dot.getDefiningOp<triton::DotOp>().getA()]);
-    loopArgs.push_back(
-        operand2headPrefetch[dot.getDefiningOp<triton::DotOp>().getB()]);
-  }
+  for (Value dot : dots)
+    for (unsigned opIdx : {0, 1})
+      if (Value prefetched = operand2headPrefetch.lookup(
+              dot.getDefiningOp()->getOperand(opIdx)))
+        loopArgs.push_back(prefetched);
 
   auto newForOp = builder.create<scf::ForOp>(
       forOp.getLoc(), forOp.getLowerBound(), forOp.getUpperBound(),
@@ -290,23 +388,36 @@ scf::ForOp Prefetcher::createNewForOp() {
 
   for (Operation &op : forOp.getBody()->without_terminator()) {
     Operation *newOp = builder.clone(op, mapping);
-    auto dot = dyn_cast<triton::DotOp>(&op);
+    Value dot = op.getNumResults() == 1 ? op.getResult(0) : Value();
     if (dot && dots.contains(dot)) {
-      Attribute dotEncoding =
-          dot.getType().cast<RankedTensorType>().getEncoding();
       // prefetched dot
-      Operation *firstDot = builder.clone(*dot, mapping);
-      if (Value a = operand2headPrefetch.lookup(dot.getA()))
-        firstDot->setOperand(
-            0, newForOp.getTiedLoopRegionIterArg(&*a.use_begin()));
-      if (Value b = operand2headPrefetch.lookup(dot.getB()))
-        firstDot->setOperand(
-            1, newForOp.getTiedLoopRegionIterArg(&*b.use_begin()));
+      Operation *firstDot = builder.clone(op, mapping);
+      for (unsigned opIdx : {0, 1}) {
+        if (Value prefetched =
+                operand2headPrefetch.lookup(op.getOperand(opIdx))) {
+          firstDot->setOperand(
+              opIdx,
+              newForOp.getTiedLoopRegionIterArg(&*prefetched.use_begin()));
+          continue;
+        }
+        // the first slice of the operands that aren't carried is loaded
+        // right before the dot
+        auto insertionPoint = builder.saveInsertionPoint();
+        builder.setInsertionPoint(firstDot);
+        Value slice = generatePrefetch(
+            mapping.lookupOrDefault(opIdx == 0 ? dot2aLoopArg[dot]
+                                               : dot2bLoopArg[dot]),
+            opIdx, true, getOperandEncoding(dot, opIdx), builder);
+        cloneElementwiseOps(slice, opIdx == 0 ? dot2aVals[dot] : dot2bVals[dot],
+                            builder);
+        builder.restoreInsertionPoint(insertionPoint);
+        firstDot->setOperand(opIdx, slice);
+      }
 
       // remaining part
       int64_t kOff = prefetchWidth;
       int64_t kRem =
-          dot.getA().getType().cast<RankedTensorType>().getShape()[1] -
+          op.getOperand(0).getType().cast<RankedTensorType>().getShape()[1] -
           prefetchWidth;
       Operation *prevDot = firstDot;
       while (kRem != 0) {
@@ -314,16 +425,16 @@ scf::ForOp Prefetcher::createNewForOp() {
         int64_t kShape = prefetchWidth;
         auto insertionPoint = builder.saveInsertionPoint();
         builder.setInsertionPoint(prevDot);
-        Value aRem =
-            generatePrefetch(mapping.lookup(dot2aLoopArg[dot]), 0, false,
-                             dotEncoding, builder, kOff, kShape);
+        Value aRem = generatePrefetch(
+            mapping.lookupOrDefault(dot2aLoopArg[dot]), 0, false,
+            getOperandEncoding(dot, 0), builder, kOff, kShape);
         cloneElementwiseOps(aRem, dot2aVals[dot], builder);
-        Value bRem =
-            generatePrefetch(mapping.lookup(dot2bLoopArg[dot]), 1, false,
-                             dotEncoding, builder, kOff, kShape);
+        Value bRem = generatePrefetch(
+            mapping.lookupOrDefault(dot2bLoopArg[dot]), 1, false,
+            getOperandEncoding(dot, 1), builder, kOff, kShape);
         cloneElementwiseOps(bRem, dot2bVals[dot], builder);
         builder.restoreInsertionPoint(insertionPoint);
-        newOp = builder.clone(*dot, mapping);
+        newOp = builder.clone(op, mapping);
         newOp->setOperand(0, aRem);
         newOp->setOperand(1, bRem);
         newOp->setOperand(2, prevDot->getResult(0));
@@ -342,17 +453,19 @@ scf::ForOp Prefetcher::createNewForOp() {
   for (Value v : forOp.getBody()->getTerminator()->getOperands())
     yieldValues.push_back(mapping.lookupOrDefault(v));
   for (Value dot : dots) {
-    Attribute dotEncoding =
-        dot.getType().cast<RankedTensorType>().getEncoding();
-    Value aToYield = generatePrefetch(mapping.lookup(dot2aYield[dot]), 0, true,
-                                      dotEncoding, builder);
-    cloneElementwiseOps(aToYield, dot2aVals[dot], builder);
-    yieldValues.push_back(aToYield);
+    if (Value aYield = dot2aYield.lookup(dot)) {
+      Value aToYield = generatePrefetch(mapping.lookup(aYield), 0, true,
+                                        getOperandEncoding(dot, 0), builder);
+      cloneElementwiseOps(aToYield, dot2aVals[dot], builder);
+      yieldValues.push_back(aToYield);
+    }
     // bToYield
-    Value bToYield = generatePrefetch(mapping.lookup(dot2bYield[dot]), 1, true,
-                                      dotEncoding, builder);
-    cloneElementwiseOps(bToYield, dot2bVals[dot], builder);
-    yieldValues.push_back(bToYield);
+    if (Value bYield = dot2bYield.lookup(dot)) {
+      Value bToYield = generatePrefetch(mapping.lookup(bYield), 1, true,
+                                        getOperandEncoding(dot, 1), builder);
+      cloneElementwiseOps(bToYield, dot2bVals[dot], builder);
+      yieldValues.push_back(bToYield);
+    }
   }
   // Update ops of yield
   if (!yieldValues.empty())
@@ -362,20 +475,29 @@ scf::ForOp Prefetcher::createNewForOp() {
 
 struct PrefetchPass : public TritonGPUPrefetchBase<PrefetchPass> {
   void runOnOperation() override {
-    getOperation()->walk([&](scf::ForOp forOp) {
-      Prefetcher prefetcher(forOp);
-
-      if (prefetcher.initialize().failed())
-        return;
-
-      prefetcher.emitPrologue();
-
-      scf::ForOp newForOp = prefetcher.createNewForOp();
-
-      // replace the original loop
-      for (unsigned i = 0; i < forOp->getNumResults(); ++i)
-        forOp->getResult(i).replaceAllUsesWith(newForOp->getResult(i));
-      forOp->erase();
+    getOperation()->walk([&](triton::FuncOp funcOp) {
+      SmallVector<scf::ForOp> loops;
+      funcOp->walk([&](scf::ForOp forOp) { loops.push_back(forOp); });
+      std::optional<RegisterPressureAnalysis> pressure;
+      for (scf::ForOp forOp : loops) {
+        if (!pressure)
+          pressure.emplace(funcOp);
+        Prefetcher prefetcher(forOp, *pressure);
+
+        if (prefetcher.initialize().failed())
+          continue;
+
+        prefetcher.emitPrologue();
+
+        scf::ForOp newForOp = prefetcher.createNewForOp();
+
+        // replace the original loop
+        for (unsigned i = 0; i < forOp->getNumResults(); ++i)
+          forOp->getResult(i).replaceAllUsesWith(newForOp->getResult(i));
+        forOp->erase();
+        // the prefetched slices are live in the next loops
+        pressure.reset();
+      }
     });
   }
 };
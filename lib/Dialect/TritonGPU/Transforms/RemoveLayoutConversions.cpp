@@ -12,12 +12,14 @@
 #include "mlir/Transforms/GreedyPatternRewriteDriver.h"
 #include "mlir/Transforms/Passes.h"
 #include "mlir/Transforms/RegionUtils.h"
+#include "triton/Analysis/CostModel.h"
 #include "triton/Analysis/Utility.h"
 #include "triton/Dialect/TritonGPU/IR/Dialect.h"
 #include "triton/Dialect/TritonGPU/Transforms/Passes.h"
 #include "triton/Dialect/TritonGPU/Transforms/TritonGPUConversion.h"
 #include "triton/Dialect/TritonGPU/Transforms/Utility.h"
 #include <memory>
+#include <numeric>
 
 using namespace mlir;
 namespace {
@@ -87,7 +89,9 @@ public:
 //
 // 3. Resolve conflicts by deciding which of the multiple layouts the op should
 //    keep, inserting convert-layout ops to resolve conflicts.  After this
-//    stage, each value has only one layout associated with it.
+//    stage, each value has only one layout associated with it. In the global
+//    assignment mode the layouts are picked together, so as to minimize the
+//    estimated cost of the conversions left in the function.
 //
 // 4. Rewrite the IR by walking the function in dominance order. Since we
 //    assume the IR is structured we just need to process the regions in the
@@ -115,6 +119,9 @@ public:
                    SmallVector<Value> &changed, Operation *op);
   // Resolve cases where a value has multiple layouts associated to it.
   void resolveConflicts();
+  // Resolve the conflicts by minimizing the shared memory traffic of the
+  // conversions the rewrite will insert, weighted by how often they run.
+  void resolveConflictsByCost();
   // Rewrite the IR for the full module.
   void rewrite();
   // Rewrite the IR for a region.
@@ -195,8 +202,11 @@ static bool hasConvertToMMATransisitiveUse(Operation *op, Attribute encoding) {
 static bool isLayoutAnchor(Operation *op) {
   if (isa<triton::LoadOp, triton::StoreOp>(op))
     return isExpensiveLoadOrStore(op);
-  if (isa<triton::ReshapeOp, triton::DotOp, triton::AtomicRMWOp,
-          triton::AtomicCASOp>(op))
+  // Other reshapes take the layout propagated to their source when they can
+  // be renames in it.
+  if (auto reshape = dyn_cast<triton::ReshapeOp>(op))
+    return reshape.getEfficientLayout().has_value();
+  if (isa<triton::DotOp, triton::AtomicRMWOp, triton::AtomicCASOp>(op))
     return true;
   return false;
 }
@@ -221,6 +231,20 @@ void LayoutPropagation::initAnchorLayout() {
   });
 }
 
+// Return true if the layout of the operands of op can be propagated to its
+// results.
+static bool canPropagateThrough(Operation *op) {
+  // Transposes in shared memory feed dots, and stay there.
+  if (auto trans = dyn_cast<triton::TransOp>(op))
+    return !triton::gpu::hasSharedEncoding(trans.getSrc());
+  return op->hasTrait<mlir::OpTrait::SameOperandsAndResultEncoding>() ||
+         op->hasTrait<mlir::OpTrait::Elementwise>() ||
+         isa<triton::ReduceOp, triton::ExpandDimsOp,
+             triton::ExperimentalInterleaveOp, triton::JoinOp,
+             triton::SplitOp, triton::ReshapeOp, triton::CatOp,
+             triton::gpu::ConvertLayoutOp>(op);
+}
+
 void LayoutPropagation::setEncoding(ValueRange values, LayoutInfo &info,
                                     SmallVector<Value> &changed,
                                     Operation *op) {
@@ -281,11 +305,7 @@ SmallVector<Value> LayoutPropagation::propagateToUsers(Value value,
       setEncoding({afterArg, result}, info, changed, user);
       continue;
     }
-    if (user->hasTrait<mlir::OpTrait::SameOperandsAndResultEncoding>() ||
-        user->hasTrait<mlir::OpTrait::Elementwise>() ||
-        isa<triton::ReduceOp, triton::ExpandDimsOp,
-            triton::ExperimentalInterleaveOp, triton::gpu::ConvertLayoutOp>(
-            user)) {
+    if (canPropagateThrough(user)) {
       setEncoding(user->getResults(), info, changed, user);
       continue;
     }
@@ -307,26 +327,32 @@ void LayoutPropagation::propagateLayout() {
   }
 }
 
+// Pick one of the encodings associated to value.
+static Attribute pickEncoding(Value value,
+                              const LayoutPropagation::LayoutInfo &info) {
+  // Hacky resolve, prefer block encoding.
+  // TODO: add a proper heuristic.
+  Operation *op = value.getDefiningOp();
+  Attribute encoding = *info.encodings.begin();
+  bool isLoadOrStore =
+      op && isa<triton::LoadOp, triton::StoreOp, triton::AtomicRMWOp,
+                triton::AtomicCASOp>(op);
+  for (Attribute e : info.encodings) {
+    if ((isLoadOrStore && e.isa<triton::gpu::BlockedEncodingAttr>()) ||
+        (!isLoadOrStore && e.isa<triton::gpu::NvidiaMmaEncodingAttr>())) {
+      encoding = e;
+      break;
+    }
+  }
+  return encoding;
+}
+
 void LayoutPropagation::resolveConflicts() {
   for (auto &it : layouts) {
-    Operation *op = it.first.getDefiningOp();
     LayoutInfo &info = it.second;
     if (info.encodings.size() <= 1)
       continue;
-    // Hacky resolve, prefer block encoding.
-    // TODO: add a proper heuristic.
-    int maxSizePerThread = 1;
-    Attribute encoding = *info.encodings.begin();
-    bool isLoadOrStore =
-        op && isa<triton::LoadOp, triton::StoreOp, triton::AtomicRMWOp,
-                  triton::AtomicCASOp>(op);
-    for (Attribute e : info.encodings) {
-      if ((isLoadOrStore && e.isa<triton::gpu::BlockedEncodingAttr>()) ||
-          (!isLoadOrStore && e.isa<triton::gpu::NvidiaMmaEncodingAttr>())) {
-        encoding = e;
-        break;
-      }
-    }
+    Attribute encoding = pickEncoding(it.first, info);
     info.encodings.clear();
     info.encodings.insert(encoding);
   }
@@ -356,6 +382,557 @@ static bool reduceToScalar(Operation *op) {
          !op->getResultTypes()[0].isa<RankedTensorType>();
 }
 
+namespace {
+
+// Costs saturate at this value, which marks the assignments to avoid.
+constexpr int64_t kInfiniteCost = int64_t(1) << 40;
+// Iterations assumed for the loops whose trip count isn't known at compile
+// time.
+constexpr int64_t kDynamicTripCount = 16;
+// Bound of the number of sweeps over the labels of the alpha-expansion.
+constexpr unsigned kMaxExpansionSweeps = 8;
+
+int64_t addCost(int64_t a, int64_t b) { return std::min(a + b, kInfiniteCost); }
+
+int64_t mulCost(int64_t a, int64_t b) {
+  return b > 0 && a > kInfiniteCost / b ? kInfiniteCost : a * b;
+}
+
+// A flow network, to compute minimum cuts with shortest augmenting paths.
+class FlowGraph {
+public:
+  explicit FlowGraph(unsigned numNodes) : adjacency(numNodes) {}
+
+  void addEdge(unsigned from, unsigned to, int64_t capacity) {
+    adjacency[from].push_back(edges.size());
+    edges.push_back({to, capacity});
+    adjacency[to].push_back(edges.size());
+    edges.push_back({from, 0});
+  }
+
+  // Saturate a maximum flow from `source` to `sink` and return whether each
+  // node is on the source side of the minimum cut.
+  SmallVector<bool> getMinCut(unsigned source, unsigned sink) {
+    while (true) {
+      SmallVector<bool> visited(adjacency.size(), false);
+      SmallVector<unsigned> parentEdge(adjacency.size());
+      SmallVector<unsigned> queue = {source};
+      visited[source] = true;
+      for (unsigned i = 0; i < queue.size() && !visited[sink]; ++i) {
+        for (unsigned edge : adjacency[queue[i]]) {
+          unsigned to = edges[edge].to;
+          if (visited[to] || edges[edge].capacity <= 0)
+            continue;
+          visited[to] = true;
+          parentEdge[to] = edge;
+          queue.push_back(to);
+        }
+      }
+      if (!visited[sink])
+        return visited;
+      int64_t flow = kInfiniteCost;
+      for (unsigned node = sink; node != source;
+           node = edges[parentEdge[node] ^ 1].to)
+        flow = std::min(flow, edges[parentEdge[node]].capacity);
+      for (unsigned node = sink; node != source;
+           node = edges[parentEdge[node] ^ 1].to) {
+        edges[parentEdge[node]].capacity -= flow;
+        edges[parentEdge[node] ^ 1].capacity += flow;
+      }
+    }
+  }
+
+private:
+  struct Edge {
+    unsigned to;
+    int64_t capacity;
+  };
+  // Edges are stored next to their reverse edge, at index ^ 1.
+  SmallVector<Edge> edges;
+  SmallVector<SmallVector<unsigned>> adjacency;
+};
+
+// Minimize a sum of unary and pairwise costs over the labels of a set of
+// nodes, each having its own candidates. Connected components that are trees
+// are solved exactly by dynamic programming. The others are improved by
+// alpha-expansion: each move lets any subset of the nodes switch to a given
+// label and is solved as a minimum cut. Pairwise costs that don't fit a cut
+// are truncated when building the moves, which are only accepted if they
+// decrease the exact cost.
+class PairwiseCostSolver {
+public:
+  // Add a node taking one of the `labels`, and return its index. Costs refer
+  // to the position of the label in `labels`.
+  unsigned addNode(ArrayRef<unsigned> labels) {
+    nodes.push_back({SmallVector<unsigned>(labels),
+                     SmallVector<int64_t>(labels.size(), 0)});
+    neighbors.emplace_back();
+    return nodes.size() - 1;
+  }
+
+  void addUnaryCost(unsigned node, unsigned label, int64_t cost) {
+    int64_t &unary = nodes[node].unary[label];
+    unary = addCost(unary, cost);
+  }
+
+  void addPairwiseCost(unsigned a, unsigned labelA, unsigned b,
+                       unsigned labelB, int64_t cost) {
+    if (a == b) {
+      if (labelA == labelB)
+        addUnaryCost(a, labelA, cost);
+      return;
+    }
+    if (a > b) {
+      std::swap(a, b);
+      std::swap(labelA, labelB);
+    }
+    unsigned numLabelsB = nodes[b].labels.size();
+    auto [it, inserted] = pairwise.try_emplace({a, b});
+    if (inserted) {
+      it->second.assign(nodes[a].labels.size() * numLabelsB, 0);
+      neighbors[a].push_back(b);
+      neighbors[b].push_back(a);
+    }
+    int64_t &pair = it->second[labelA * numLabelsB + labelB];
+    pair = addCost(pair, cost);
+  }
+
+  // Return the label picked for each node. The result costs no more than
+  // `initial`, which breaks ties.
+  SmallVector<unsigned> solve(ArrayRef<unsigned> initial) const {
+    SmallVector<unsigned> labels(initial);
+    SmallVector<bool> visited(nodes.size(), false);
+    for (unsigned root = 0; root < nodes.size(); ++root) {
+      if (visited[root])
+        continue;
+      SmallVector<unsigned> component = {root};
+      visited[root] = true;
+      unsigned numEdges = 0;
+      for (unsigned i = 0; i < component.size(); ++i) {
+        numEdges += neighbors[component[i]].size();
+        for (unsigned neighbor : neighbors[component[i]]) {
+          if (visited[neighbor])
+            continue;
+          visited[neighbor] = true;
+          component.push_back(neighbor);
+        }
+      }
+      // Each edge was counted from both sides
+      if (numEdges / 2 + 1 == component.size())
+        solveTree(component, labels);
+      else
+        solveByExpansion(component, labels);
+    }
+    return labels;
+  }
+
+private:
+  int64_t getPairwiseCost(unsigned a, unsigned labelA, unsigned b,
+                          unsigned labelB) const {
+    if (a > b) {
+      std::swap(a, b);
+      std::swap(labelA, labelB);
+    }
+    auto it = pairwise.find({a, b});
+    if (it == pairwise.end())
+      return 0;
+    return it->second[labelA * nodes[b].labels.size() + labelB];
+  }
+
+  int64_t getCost(ArrayRef<unsigned> component,
+                  ArrayRef<unsigned> labels) const {
+    int64_t cost = 0;
+    for (unsigned node : component) {
+      cost = addCost(cost, nodes[node].unary[labels[node]]);
+      for (unsigned neighbor : neighbors[node])
+        if (node < neighbor)
+          cost = addCost(cost, getPairwiseCost(node, labels[node], neighbor,
+                                               labels[neighbor]));
+    }
+    return cost;
+  }
+
+  void solveTree(ArrayRef<unsigned> component,
+                 SmallVector<unsigned> &labels) const {
+    // `component` lists the nodes in breadth first order: the parent of each
+    // node is the neighbor that comes before it.
+    DenseMap<unsigned, unsigned> positions;
+    for (unsigned position = 0; position < component.size(); ++position)
+      positions[component[position]] = position;
+    // The cost of the subtree of each node for each of its labels, and the
+    // best label of each node for each label of its parent.
+    DenseMap<unsigned, SmallVector<int64_t>> subtreeCosts;
+    DenseMap<unsigned, SmallVector<unsigned>> bestLabels;
+    DenseMap<unsigned, unsigned> parents;
+    for (unsigned node : llvm::reverse(component)) {
+      SmallVector<int64_t> costs = nodes[node].unary;
+      for (unsigned child : neighbors[node]) {
+        if (positions[child] < positions[node])
+          continue;
+        parents[child] = node;
+        const SmallVector<int64_t> &childCosts = subtreeCosts[child];
+        SmallVector<unsigned> &childLabels = bestLabels[child];
+        childLabels.assign(costs.size(), 0);
+        for (unsigned label = 0; label < costs.size(); ++label) {
+          int64_t best = kInfiniteCost;
+          for (unsigned childLabel = 0; childLabel < childCosts.size();
+               ++childLabel) {
+            int64_t cost =
+                addCost(childCosts[childLabel],
+                        getPairwiseCost(node, label, child, childLabel));
+            if (cost < best) {
+              best = cost;
+              childLabels[label] = childLabel;
+            }
+          }
+          costs[label] = addCost(costs[label], best);
+        }
+      }
+      subtreeCosts[node] = std::move(costs);
+    }
+    SmallVector<unsigned> solution(labels);
+    unsigned root = component.front();
+    const SmallVector<int64_t> &rootCosts = subtreeCosts[root];
+    for (unsigned label = 0; label < rootCosts.size(); ++label)
+      if (rootCosts[label] < rootCosts[solution[root]])
+        solution[root] = label;
+    for (unsigned node : component.drop_front())
+      solution[node] = bestLabels[node][solution[parents[node]]];
+    // Keep the current labels on ties
+    if (getCost(component, solution) < getCost(component, labels))
+      labels = std::move(solution);
+  }
+
+  void solveByExpansion(ArrayRef<unsigned> component,
+                        SmallVector<unsigned> &labels) const {
+    llvm::SetVector<unsigned> alphas;
+    for (unsigned node : component)
+      alphas.insert(nodes[node].labels.begin(), nodes[node].labels.end());
+    int64_t cost = getCost(component, labels);
+    bool changed = true;
+    for (unsigned sweep = 0; changed && sweep < kMaxExpansionSweeps; ++sweep) {
+      changed = false;
+      for (unsigned alpha : alphas) {
+        SmallVector<unsigned> candidate(labels);
+        if (!expand(component, alpha, candidate))
+          continue;
+        int64_t newCost = getCost(component, candidate);
+        if (newCost >= cost)
+          continue;
+        cost = newCost;
+        labels = std::move(candidate);
+        changed = true;
+      }
+    }
+  }
+
+  // Apply the best move letting the nodes of `component` switch to the label
+  // `alpha`, and return false if none of them can.
+  bool expand(ArrayRef<unsigned> component, unsigned alpha,
+              SmallVector<unsigned> &labels) const {
+    // The nodes that can switch, and the position of alpha in their labels
+    DenseMap<unsigned, unsigned> variables;
+    SmallVector<unsigned> variableNodes;
+    SmallVector<unsigned> alphaLabels;
+    for (unsigned node : component) {
+      auto it = llvm::find(nodes[node].labels, alpha);
+      if (it == nodes[node].labels.end())
+        continue;
+      unsigned label = it - nodes[node].labels.begin();
+      if (label == labels[node])
+        continue;
+      variables[node] = variableNodes.size();
+      variableNodes.push_back(node);
+      alphaLabels.push_back(label);
+    }
+    if (variableNodes.empty())
+      return false;
+    // A variable on the sink side of the cut switches to alpha.
+    unsigned source = variableNodes.size();
+    unsigned sink = source + 1;
+    FlowGraph graph(sink + 1);
+    auto addUnary = [&](unsigned variable, int64_t keepCost,
+                        int64_t switchCost) {
+      if (switchCost > keepCost)
+        graph.addEdge(source, variable, switchCost - keepCost);
+      else if (keepCost > switchCost)
+        graph.addEdge(variable, sink, keepCost - switchCost);
+    };
+    for (unsigned variable = 0; variable < variableNodes.size(); ++variable) {
+      unsigned node = variableNodes[variable];
+      unsigned keep = labels[node];
+      unsigned alphaLabel = alphaLabels[variable];
+      int64_t keepCost = nodes[node].unary[keep];
+      int64_t switchCost = nodes[node].unary[alphaLabel];
+      for (unsigned neighbor : neighbors[node]) {
+        auto it = variables.find(neighbor);
+        if (it == variables.end()) {
+          keepCost = addCost(
+              keepCost,
+              getPairwiseCost(node, keep, neighbor, labels[neighbor]));
+          switchCost = addCost(
+              switchCost,
+              getPairwiseCost(node, alphaLabel, neighbor, labels[neighbor]));
+          continue;
+        }
+        if (neighbor < node)
+          continue;
+        unsigned neighborKeep = labels[neighbor];
+        unsigned neighborAlpha = alphaLabels[it->second];
+        int64_t a = getPairwiseCost(node, keep, neighbor, neighborKeep);
+        int64_t b = getPairwiseCost(node, keep, neighbor, neighborAlpha);
+        int64_t c = getPairwiseCost(node, alphaLabel, neighbor, neighborKeep);
+        int64_t d = getPairwiseCost(node, alphaLabel, neighbor, neighborAlpha);
+        // E(x, y) = a + (c - a) x + (d - c) y + (b + c - a - d) (1 - x) y
+        addUnary(variable, 0, c - a);
+        addUnary(it->second, 0, d - c);
+        if (b + c - a - d > 0)
+          graph.addEdge(variable, it->second, b + c - a - d);
+      }
+      addUnary(variable, keepCost, switchCost);
+    }
+    SmallVector<bool> sourceSide = graph.getMinCut(source, sink);
+    for (unsigned variable = 0; variable < variableNodes.size(); ++variable)
+      if (!sourceSide[variable])
+        labels[variableNodes[variable]] = alphaLabels[variable];
+    return true;
+  }
+
+  struct Node {
+    SmallVector<unsigned> labels;
+    SmallVector<int64_t> unary;
+  };
+  SmallVector<Node> nodes;
+  SmallVector<SmallVector<unsigned>> neighbors;
+  // Cost matrices of the pairs of nodes (a, b) with a < b, indexed by
+  // labelA * numLabels(b) + labelB.
+  DenseMap<std::pair<unsigned, unsigned>, SmallVector<int64_t>> pairwise;
+};
+
+} // namespace
+
+// Estimate how many times the ops of `block` run.
+static int64_t getExecutionCount(Block *block) {
+  int64_t count = 1;
+  for (Operation *op = block->getParentOp(); op && !isa<triton::FuncOp>(op);
+       op = op->getParentOp()) {
+    int64_t tripCount = 1;
+    if (auto forOp = dyn_cast<scf::ForOp>(op))
+      tripCount = getTripCount(forOp).value_or(kDynamicTripCount);
+    else if (isa<scf::WhileOp>(op))
+      tripCount = kDynamicTripCount;
+    count = mulCost(count, std::max<int64_t>(tripCount, 1));
+  }
+  return count;
+}
+
+// Estimate the shared memory bytes written and read to convert a tensor of
+// `type` from `srcEncoding` to `dstEncoding`.
+static int64_t getConversionBytes(RankedTensorType type, Attribute srcEncoding,
+                                  Attribute dstEncoding) {
+  auto srcTy = RankedTensorType::get(type.getShape(), type.getElementType(),
+                                     srcEncoding);
+  auto dstTy = RankedTensorType::get(type.getShape(), type.getElementType(),
+                                     dstEncoding);
+  if (srcEncoding.isa<NvidiaMmaEncodingAttr>() &&
+      dstEncoding.isa<DotOperandEncodingAttr>() &&
+      isMmaToDotShortcut(srcTy, dstTy))
+    return 0;
+  if (isMmaToMmaShortcut(srcTy, dstTy))
+    return 0;
+  Type elemTy = type.getElementType();
+  int64_t elemBytes =
+      elemTy.isa<triton::PointerType>()
+          ? 8
+          : std::max<int64_t>(8, elemTy.getIntOrFloatBitWidth()) / 8;
+  SmallVector<int64_t> shapePerCTA = triton::gpu::getShapePerCTA(srcTy);
+  int64_t bytes = std::accumulate(shapePerCTA.begin(), shapePerCTA.end(),
+                                  elemBytes, std::multiplies{});
+  // Conversions from and to shared memory only go through it once
+  if (srcEncoding.isa<triton::gpu::SharedEncodingAttr>() ||
+      dstEncoding.isa<triton::gpu::SharedEncodingAttr>())
+    return bytes;
+  return 2 * bytes;
+}
+
+void LayoutPropagation::resolveConflictsByCost() {
+  auto getIndex = [&](Value value) -> std::optional<unsigned> {
+    auto it = layouts.find(value);
+    if (it == layouts.end())
+      return std::nullopt;
+    return it - layouts.begin();
+  };
+  auto getOrigEncoding = [](Value value) {
+    return value.getType().cast<RankedTensorType>().getEncoding();
+  };
+  // Group the values whose encodings the rewrite keeps equal: the results of
+  // an op, and the results of a loop with its region arguments.
+  SmallVector<unsigned> leaders(layouts.size());
+  std::iota(leaders.begin(), leaders.end(), 0);
+  auto getLeader = [&](unsigned index) {
+    while (leaders[index] != index)
+      index = leaders[index] = leaders[leaders[index]];
+    return index;
+  };
+  auto tie = [&](Value a, Value b) {
+    auto indexA = getIndex(a);
+    auto indexB = getIndex(b);
+    if (indexA && indexB)
+      leaders[getLeader(*indexA)] = getLeader(*indexB);
+  };
+  for (auto &it : layouts) {
+    auto result = it.first.dyn_cast<OpResult>();
+    if (!result)
+      continue;
+    Operation *op = result.getOwner();
+    unsigned resultNumber = result.getResultNumber();
+    if (auto forOp = dyn_cast<scf::ForOp>(op))
+      tie(result, forOp.getRegionIterArg(resultNumber));
+    else if (auto whileOp = dyn_cast<scf::WhileOp>(op))
+      tie(result, whileOp.getAfterArguments()[resultNumber]);
+    else if (!isa<scf::IfOp>(op))
+      tie(result, op->getResult(0));
+  }
+  llvm::MapVector<unsigned, SmallVector<unsigned>> groups;
+  for (unsigned index = 0; index < layouts.size(); ++index)
+    groups[getLeader(index)].push_back(index);
+
+  // Each group is a node of the solver. Its candidates are the encodings
+  // propagated to its values, and the original one, which leaves the ops as
+  // they are.
+  PairwiseCostSolver solver;
+  SmallVector<SmallVector<Attribute>> candidates;
+  SmallVector<unsigned> initial;
+  SmallVector<unsigned> valueNodes(layouts.size());
+  DenseMap<Attribute, unsigned> labelIds;
+  for (auto &[leader, members] : groups) {
+    llvm::SetVector<Attribute> encodings;
+    for (unsigned index : members)
+      encodings.insert((layouts.begin() + index)->second.encodings.begin(),
+                       (layouts.begin() + index)->second.encodings.end());
+    Value value = (layouts.begin() + members.front())->first;
+    Attribute preferred =
+        pickEncoding(value, (layouts.begin() + members.front())->second);
+    encodings.insert(getOrigEncoding(value));
+    initial.push_back(llvm::find(encodings, preferred) - encodings.begin());
+    SmallVector<unsigned> labels;
+    for (Attribute encoding : encodings)
+      labels.push_back(labelIds.try_emplace(encoding, labelIds.size())
+                           .first->second);
+    unsigned node = solver.addNode(labels);
+    for (unsigned index : members)
+      valueNodes[index] = node;
+    candidates.emplace_back(encodings.begin(), encodings.end());
+  }
+  auto getNode = [&](Value value) -> std::optional<unsigned> {
+    if (auto index = getIndex(value))
+      return valueNodes[*index];
+    return std::nullopt;
+  };
+
+  // Each use of a tensor needs it in an encoding, which may depend on the
+  // encoding picked for the values its user defines. When the two differ the
+  // rewrite converts it.
+  funcOp.walk([&](Operation *user) {
+    if (reduceToScalar(user))
+      return;
+    for (OpOperand &use : user->getOpOperands()) {
+      Value value = use.get();
+      auto tensorType = value.getType().dyn_cast<RankedTensorType>();
+      if (!tensorType)
+        continue;
+      // The value whose encoding the use needs, through `inferOp` if set.
+      Value tied;
+      Operation *inferOp = nullptr;
+      unsigned operandNumber = use.getOperandNumber();
+      if (auto forOp = dyn_cast<scf::ForOp>(user)) {
+        tied = forOp.getTiedLoopResult(&use);
+      } else if (auto whileOp = dyn_cast<scf::WhileOp>(user)) {
+        tied = whileOp.getBeforeArguments()[operandNumber];
+      } else if (isa<scf::YieldOp>(user)) {
+        Operation *parent = user->getParentOp();
+        if (isa<scf::ForOp, scf::IfOp>(parent))
+          tied = parent->getResult(operandNumber);
+        else if (auto whileOp = dyn_cast<scf::WhileOp>(parent))
+          tied = whileOp.getBeforeArguments()[operandNumber];
+      } else if (isa<scf::ConditionOp>(user)) {
+        tied = user->getParentOp()->getResult(operandNumber - 1);
+      } else if (isa<ConvertLayoutOp>(user)) {
+        tied = user->getResult(0);
+      } else if (canPropagateThrough(user) && user->getNumResults() > 0 &&
+                 getIndex(user->getResult(0))) {
+        tied = user->getResult(0);
+        inferOp = user;
+      }
+      std::optional<unsigned> srcNode = getNode(value);
+      std::optional<unsigned> dstNode;
+      if (tied)
+        dstNode = getNode(tied);
+      if (!srcNode && !dstNode)
+        continue;
+      // Conversions are inserted next to the value, except for the ones
+      // folded into an existing conversion.
+      int64_t count = getExecutionCount(isa<ConvertLayoutOp>(user)
+                                            ? user->getBlock()
+                                            : value.getParentBlock());
+      auto getConversionCost = [&](Attribute srcEncoding,
+                                   std::optional<Attribute> dstEncoding) {
+        if (!dstEncoding)
+          return kInfiniteCost;
+        if (srcEncoding == *dstEncoding)
+          return int64_t(0);
+        // Count each conversion, so that ties favour fewer of them
+        int64_t bytes =
+            getConversionBytes(tensorType, srcEncoding, *dstEncoding) + 1;
+        return mulCost(count, bytes);
+      };
+      // The encoding the use needs when the tied value gets `dstEncoding`.
+      auto getNeededEncoding =
+          [&](Attribute dstEncoding) -> std::optional<Attribute> {
+        if (!inferOp)
+          return dstEncoding;
+        // The user isn't rewritten
+        if (dstEncoding == getOrigEncoding(tied))
+          return getOrigEncoding(value);
+        return inferSrcEncoding(inferOp, dstEncoding);
+      };
+      if (!dstNode) {
+        Attribute needed =
+            tied && !inferOp ? getOrigEncoding(tied) : getOrigEncoding(value);
+        ArrayRef<Attribute> srcEncodings = candidates[*srcNode];
+        for (unsigned label = 0; label < srcEncodings.size(); ++label)
+          solver.addUnaryCost(*srcNode, label,
+                              getConversionCost(srcEncodings[label], needed));
+        continue;
+      }
+      ArrayRef<Attribute> dstEncodings = candidates[*dstNode];
+      for (unsigned dstLabel = 0; dstLabel < dstEncodings.size(); ++dstLabel) {
+        std::optional<Attribute> needed =
+            getNeededEncoding(dstEncodings[dstLabel]);
+        if (!srcNode) {
+          solver.addUnaryCost(
+              *dstNode, dstLabel,
+              getConversionCost(getOrigEncoding(value), needed));
+          continue;
+        }
+        ArrayRef<Attribute> srcEncodings = candidates[*srcNode];
+        for (unsigned srcLabel = 0; srcLabel < srcEncodings.size(); ++srcLabel)
+          solver.addPairwiseCost(
+              *srcNode, srcLabel, *dstNode, dstLabel,
+              getConversionCost(srcEncodings[srcLabel], needed));
+      }
+    }
+  });
+
+  SmallVector<unsigned> solution = solver.solve(initial);
+  for (unsigned index = 0; index < layouts.size(); ++index) {
+    unsigned node = valueNodes[index];
+    LayoutInfo &info = (layouts.begin() + index)->second;
+    info.encodings.clear();
+    info.encodings.insert(candidates[node][solution[node]]);
+  }
+}
+
 void LayoutPropagation::rewriteRegion(Region &region) {
   SmallVector<Region *> queue = {&region};
   while (!queue.empty()) {
@@ -666,6 +1243,29 @@ Operation *LayoutPropagation::rewriteOp(Operation *op) {
     map(op->getResult(0), cvt.getResult());
     return cvt.getOperation();
   }
+  // The view ops are renames in the layouts inferred for them. When their
+  // source can't take one, they keep their layouts and convert the result.
+  if (isa<triton::ReshapeOp, triton::CatOp, triton::TransOp>(op)) {
+    if (inferSrcEncoding(op, encoding)) {
+      Operation *newOp = cloneElementwise(rewriter, op, encoding);
+      map(op->getResult(0), newOp->getResult(0));
+      return newOp;
+    }
+    Operation *newOp = rewriter.clone(*op);
+    for (OpOperand &operand : op->getOpOperands()) {
+      Attribute srcEncoding =
+          operand.get().getType().cast<RankedTensorType>().getEncoding();
+      newOp->setOperand(operand.getOperandNumber(),
+                        getValueAs(operand.get(), srcEncoding));
+    }
+    auto tensorType = op->getResult(0).getType().cast<RankedTensorType>();
+    auto newType = RankedTensorType::get(tensorType.getShape(),
+                                         tensorType.getElementType(), encoding);
+    auto cvt = rewriter.create<triton::gpu::ConvertLayoutOp>(
+        op->getLoc(), newType, newOp->getResult(0));
+    map(op->getResult(0), cvt.getResult());
+    return cvt.getOperation();
+  }
   if (canFoldIntoConversion(op, encoding)) {
     Operation *newOp = rewriter.clone(*op);
     auto tensorType = op->getResult(0).getType().cast<RankedTensorType>();
@@ -679,7 +1279,8 @@ Operation *LayoutPropagation::rewriteOp(Operation *op) {
   if (op->hasTrait<mlir::OpTrait::SameOperandsAndResultEncoding>() ||
       op->hasTrait<mlir::OpTrait::Elementwise>() ||
       isa<triton::ReduceOp, triton::ExpandDimsOp,
-          triton::ExperimentalInterleaveOp, triton::gpu::ConvertLayoutOp>(op)) {
+          triton::ExperimentalInterleaveOp, triton::JoinOp, triton::SplitOp,
+          triton::gpu::ConvertLayoutOp>(op)) {
     Operation *newOp = cloneElementwise(rewriter, op, encoding);
     for (auto [oldResult, newResult] :
          llvm::zip(op->getResults(), newOp->getResults()))
@@ -923,18 +1524,18 @@ static void hoistConvertOnTopOfExtOrBroadcast(ConvertLayoutOp convertOp) {
   rewriteSlice(slice, layout, convertOp, mapping);
 }
 
-static void backwardRematerialization(ModuleOp module) {
+static void backwardRematerialization(triton::FuncOp funcOp) {
   SmallVector<ConvertLayoutOp> convertOps;
-  module.walk(
+  funcOp.walk(
       [&](ConvertLayoutOp convertOp) { convertOps.push_back(convertOp); });
   for (ConvertLayoutOp convertOp : convertOps) {
     backwardRematerialization(convertOp);
   }
 }
 
-static void hoistConvert(ModuleOp module) {
+static void hoistConvert(triton::FuncOp funcOp) {
   SmallVector<ConvertLayoutOp> convertOps;
-  module.walk(
+  funcOp.walk(
       [&](ConvertLayoutOp convertOp) { convertOps.push_back(convertOp); });
   for (ConvertLayoutOp convertOp : convertOps) {
     hoistConvertOnTopOfExtOrBroadcast(convertOp);
@@ -949,19 +1550,23 @@ class TritonGPURemoveLayoutConversionsPass
           TritonGPURemoveLayoutConversionsPass> {
 public:
   TritonGPURemoveLayoutConversionsPass() = default;
+  TritonGPURemoveLayoutConversionsPass(bool globalAssignment) {
+    this->globalAssignment = globalAssignment;
+  }
 
   void runOnOperation() override {
     MLIRContext *context = &getContext();
-    ModuleOp m = getOperation();
+    triton::FuncOp m = getOperation();
 
     // 1. Propagate layout forward starting from "anchor" ops.
-    m.walk([](triton::FuncOp funcOp) {
-      LayoutPropagation layoutPropagation(funcOp);
-      layoutPropagation.initAnchorLayout();
-      layoutPropagation.propagateLayout();
+    LayoutPropagation layoutPropagation(m);
+    layoutPropagation.initAnchorLayout();
+    layoutPropagation.propagateLayout();
+    if (globalAssignment)
+      layoutPropagation.resolveConflictsByCost();
+    else
       layoutPropagation.resolveConflicts();
-      layoutPropagation.rewrite();
-    });
+    layoutPropagation.rewrite();
 
     mlir::RewritePatternSet cleanUpPatterns(context);
     ConvertLayoutOp::getCanonicalizationPatterns(cleanUpPatterns, context);
@@ -997,6 +1602,8 @@ public:
   }
 };
 
-std::unique_ptr<Pass> mlir::triton::gpu::createRemoveLayoutConversionsPass() {
-  return std::make_unique<TritonGPURemoveLayoutConversionsPass>();
+std::unique_ptr<Pass>
+mlir::triton::gpu::createRemoveLayoutConversionsPass(bool globalAssignment) {
+  return std::make_unique<TritonGPURemoveLayoutConversionsPass>(
+      globalAssignment);
 }
@@ -1,3 +1,4 @@
+#include "Pipeliner/Schedule.h"
 #include "mlir/Analysis/SliceAnalysis.h"
 #include "mlir/Dialect/SCF/IR/SCF.h"
 #include "mlir/IR/BuiltinAttributes.h"
@@ -13,8 +14,10 @@
 #include "mlir/Transforms/GreedyPatternRewriteDriver.h"
 #include "mlir/Transforms/Passes.h"
 #include "mlir/Transforms/RegionUtils.h"
+#include "triton/Analysis/RegisterPressure.h"
 #include "triton/Analysis/Utility.h"
 #include "triton/Dialect/TritonGPU/IR/Dialect.h"
+#include "triton/Dialect/TritonNvidiaGPU/IR/Dialect.h"
 #include "triton/Dialect/TritonGPU/Transforms/Passes.h"
 #include "triton/Dialect/TritonGPU/Transforms/TritonGPUConversion.h"
 #include "triton/Dialect/TritonGPU/Transforms/Utility.h"
@@ -36,11 +39,189 @@ willIncreaseRegisterPressure(triton::gpu::ConvertLayoutOp op) {
   return false;
 }
 
+//===----------------------------------------------------------------------===//
+// List scheduling
+//
+// With `schedule`, the ops of each block are list scheduled from the
+// latencies the pipeliner estimates: among the ops whose operands are ready,
+// the one heading the longest path to the end of the block issues first.
+// Global loads and async copies only occupy the issue slot for a cycle, so
+// the independent ones get hoisted above the math and the shared memory
+// traffic that can run while they are in flight.
+//===----------------------------------------------------------------------===//
+
+namespace {
+
+enum class MemoryAccess { None, Read, Write };
+
+// How `op` is ordered with the other ops touching memory. The values in
+// shared memory are read by pure ops once async copies and wgmma are done,
+// which only their waits tell without an SSA dependency, so the waits are
+// barriers and the ops with shared memory operands are reads.
+MemoryAccess getMemoryAccess(Operation *op) {
+  if (isa<triton::gpu::AsyncWaitOp, triton::gpu::AsyncCommitGroupOp,
+          triton::nvidia_gpu::DotWaitOp>(op))
+    return MemoryAccess::Write;
+  if (!isMemoryEffectFree(op)) {
+    auto memInterface = dyn_cast<MemoryEffectOpInterface>(op);
+    if (!memInterface)
+      return MemoryAccess::Write;
+    SmallVector<MemoryEffects::EffectInstance> effects;
+    memInterface.getEffects(effects);
+    for (MemoryEffects::EffectInstance &effect : effects)
+      if (!isa<MemoryEffects::Read>(effect.getEffect()))
+        return MemoryAccess::Write;
+    return MemoryAccess::Read;
+  }
+  for (Value operand : op->getOperands())
+    if (auto tensorTy = operand.getType().dyn_cast<RankedTensorType>())
+      if (tensorTy.getEncoding() &&
+          tensorTy.getEncoding().isa<triton::gpu::SharedEncodingAttr>())
+        return MemoryAccess::Read;
+  return MemoryAccess::None;
+}
+
+// Whether `op` only holds the issue slot for a cycle, its latency being
+// spent waiting for memory.
+bool isAsyncLatency(Operation *op) {
+  return isa<triton::LoadOp, triton::gpu::InsertSliceAsyncOp,
+             triton::nvidia_gpu::InsertSliceTMAOp>(op);
+}
+
+void scheduleBlock(Block *block, unsigned numWarps) {
+  if (!block->mightHaveTerminator())
+    return;
+  SmallVector<Operation *> ops;
+  for (Operation &op : block->without_terminator())
+    ops.push_back(&op);
+  unsigned numOps = ops.size();
+  if (numOps < 2)
+    return;
+  DenseMap<Operation *, unsigned> index;
+  for (auto [i, op] : llvm::enumerate(ops))
+    index[op] = i;
+
+  // The dependences of the ops, through their operands, the operands of the
+  // ops nested in them, and memory
+  SmallVector<SetVector<unsigned>> preds(numOps), succs(numOps);
+  auto addEdge = [&](unsigned from, unsigned to) {
+    if (from == to)
+      return;
+    preds[to].insert(from);
+    succs[from].insert(to);
+  };
+  std::optional<unsigned> lastWrite;
+  SmallVector<unsigned> readsSinceWrite;
+  for (auto [i, op] : llvm::enumerate(ops)) {
+    op->walk([&](Operation *nested) {
+      for (Value operand : nested->getOperands()) {
+        Operation *def = operand.getDefiningOp();
+        if (!def)
+          continue;
+        auto it = index.find(def);
+        if (it != index.end())
+          addEdge(it->second, i);
+      }
+    });
+    MemoryAccess access = getMemoryAccess(op);
+    if (access == MemoryAccess::None)
+      continue;
+    if (lastWrite)
+      addEdge(*lastWrite, i);
+    if (access == MemoryAccess::Read) {
+      readsSinceWrite.push_back(i);
+      continue;
+    }
+    for (unsigned read : readsSinceWrite)
+      addEdge(read, i);
+    readsSinceWrite.clear();
+    lastWrite = i;
+  }
+
+  SmallVector<unsigned> latency(numOps), height(numOps);
+  for (unsigned i = numOps; i > 0; --i) {
+    latency[i - 1] = triton::getOpLatency(ops[i - 1], numWarps);
+    unsigned succHeight = 0;
+    for (unsigned succ : succs[i - 1])
+      succHeight = std::max(succHeight, height[succ]);
+    height[i - 1] = latency[i - 1] + succHeight;
+  }
+
+  SmallVector<unsigned> numPendingPreds(numOps), readyAt(numOps, 0);
+  SmallVector<unsigned> candidates;
+  for (unsigned i = 0; i < numOps; ++i) {
+    numPendingPreds[i] = preds[i].size();
+    if (numPendingPreds[i] == 0)
+      candidates.push_back(i);
+  }
+  Operation *terminator = block->getTerminator();
+  unsigned cycle = 0;
+  while (!candidates.empty()) {
+    // Wait for the first op to be ready if none is
+    unsigned firstReady = readyAt[candidates.front()];
+    for (unsigned i : candidates)
+      firstReady = std::min(firstReady, readyAt[i]);
+    cycle = std::max(cycle, firstReady);
+    auto *best = candidates.end();
+    for (auto *it = candidates.begin(); it != candidates.end(); ++it) {
+      if (readyAt[*it] > cycle)
+        continue;
+      if (best == candidates.end() || height[*it] > height[*best] ||
+          (height[*it] == height[*best] && *it < *best))
+        best = it;
+    }
+    unsigned i = *best;
+    candidates.erase(best);
+    ops[i]->moveBefore(terminator);
+    for (unsigned succ : succs[i]) {
+      readyAt[succ] = std::max(readyAt[succ], cycle + latency[i]);
+      if (--numPendingPreds[succ] == 0)
+        candidates.push_back(succ);
+    }
+    cycle += isAsyncLatency(ops[i]) ? 1 : latency[i];
+  }
+}
+
+// Schedules the blocks of `funcOp`, unless it makes a thread need more
+// registers than it has.
+void scheduleFunction(triton::FuncOp funcOp) {
+  // The warp specialized roles are ordered by their own barriers
+  auto result = funcOp.walk([](Operation *op) {
+    return getWSRoleId(op) ? WalkResult::interrupt() : WalkResult::advance();
+  });
+  if (result.wasInterrupted())
+    return;
+  auto moduleOp = funcOp->getParentOfType<ModuleOp>();
+  unsigned numWarps = triton::gpu::TritonGPUDialect::getNumWarps(moduleOp);
+
+  SmallVector<std::pair<Block *, SmallVector<Operation *>>> originalOrders;
+  funcOp.walk([&](Block *block) {
+    SmallVector<Operation *> ops;
+    for (Operation &op : block->getOperations())
+      ops.push_back(&op);
+    originalOrders.emplace_back(block, std::move(ops));
+  });
+  unsigned registersBefore = RegisterPressureAnalysis(funcOp).getMaxRegisters();
+  for (auto &[block, ops] : originalOrders)
+    scheduleBlock(block, numWarps);
+  unsigned registersAfter = RegisterPressureAnalysis(funcOp).getMaxRegisters();
+  if (registersAfter <= std::max(registersBefore, kMaxRegistersPerThread))
+    return;
+  for (auto &[block, ops] : originalOrders)
+    for (Operation *op : ops)
+      op->moveBefore(block, block->end());
+}
+
+} // anonymous namespace
+
 class TritonGPUReorderInstructionsPass
     : public TritonGPUReorderInstructionsBase<
           TritonGPUReorderInstructionsPass> {
 public:
   TritonGPUReorderInstructionsPass() = default;
+  TritonGPUReorderInstructionsPass(bool schedule) {
+    this->schedule = schedule;
+  }
 
   Operation *getFirstUse(Operation *op) {
     std::vector<Operation *> users;
@@ -56,11 +237,11 @@ public:
   }
 
   void runOnOperation() override {
-    ModuleOp m = getOperation();
-    mlir::DominanceInfo dom(m);
+    triton::FuncOp funcOp = getOperation();
+    mlir::DominanceInfo dom(funcOp);
     // sink conversion after the last dealloc
     // before the first use ancestor in its block
-    m.walk([&](triton::gpu::ConvertLayoutOp op) {
+    funcOp.walk([&](triton::gpu::ConvertLayoutOp op) {
       auto curr = mlir::Block::iterator(op);
       for (; &*curr != getFirstUse(op); curr++)
         if (isa<triton::gpu::DeallocTensorOp>(&*curr))
@@ -75,7 +256,7 @@ public:
       if (lhsId == rhsId)
         lhs->moveAfter(rhs);
     };
-    m.walk([&](triton::gpu::ConvertLayoutOp op) {
+    funcOp.walk([&](triton::gpu::ConvertLayoutOp op) {
       if (!willIncreaseRegisterPressure(op))
         return;
       auto user_begin = op->user_begin();
@@ -90,7 +271,7 @@ public:
     for (auto &kv : opToMove)
       kv.first->moveBefore(kv.second);
     // Move convert(load) immediately after dependent load
-    m.walk([&](triton::gpu::ConvertLayoutOp op) {
+    funcOp.walk([&](triton::gpu::ConvertLayoutOp op) {
       auto dstType = op.getResult().getType().cast<RankedTensorType>();
       auto dstEncoding = dstType.getEncoding();
       if (!dstEncoding.isa<triton::gpu::SharedEncodingAttr>())
@@ -102,7 +283,7 @@ public:
     });
     // Move transpositions just after their definition
     opToMove.clear();
-    m.walk([&](triton::TransOp op) {
+    funcOp.walk([&](triton::TransOp op) {
       Operation *argOp = op.getOperand().getDefiningOp();
       if (!argOp)
         return;
@@ -110,7 +291,7 @@ public:
     });
     // Move `dot` operand so that conversions to opIdx=1 happens after
     // conversions to opIdx=0
-    m.walk([&](triton::gpu::ConvertLayoutOp op) {
+    funcOp.walk([&](triton::gpu::ConvertLayoutOp op) {
       auto dstType = op.getResult().getType().cast<RankedTensorType>();
       auto dstEncoding =
           dstType.getEncoding().dyn_cast<triton::gpu::DotOperandEncodingAttr>();
@@ -134,10 +315,12 @@ public:
         return;
       moveAfter(op, AOp);
     });
-    return;
+    if (schedule)
+      scheduleFunction(funcOp);
   }
 };
 
-std::unique_ptr<Pass> mlir::triton::gpu::createReorderInstructionsPass() {
-  return std::make_unique<TritonGPUReorderInstructionsPass>();
+std::unique_ptr<Pass>
+mlir::triton::gpu::createReorderInstructionsPass(bool schedule) {
+  return std::make_unique<TritonGPUReorderInstructionsPass>(schedule);
 }
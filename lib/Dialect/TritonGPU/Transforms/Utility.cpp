@@ -4,8 +4,11 @@
 #include "mlir/IR/IRMapping.h"
 #include "mlir/Transforms/GreedyPatternRewriteDriver.h"
 #include "triton/Dialect/TritonGPU/IR/Dialect.h"
+#include "triton/Dialect/TritonGPU/IR/LinearLayoutConversions.h"
 #include "triton/Dialect/TritonGPU/Transforms/Utility.h"
+#include <algorithm>
 #include <fstream>
+#include <numeric>
 
 namespace mlir {
 
@@ -15,7 +18,8 @@ SmallVector<unsigned, 3> mmaVersionToInstrShape(int version,
   if (version == 1)
     return {16, 16};
   else if (version == 2)
-    return {16, 8};
+    return shape.size() == 3 ? SmallVector<unsigned, 3>{1, 16, 8}
+                             : SmallVector<unsigned, 3>{16, 8};
   else if (version == 3) {
     unsigned k = 256 / type.getElementTypeBitWidth();
     if (shape[0] % 64 != 0 || shape[1] % 8 != 0) {
@@ -86,6 +90,18 @@ triton::gpu::SharedEncodingAttr getSharedEncoding(RankedTensorType tensorTy) {
       blockedLayout.getCTALayout(), tensorTy.getElementType());
 }
 
+SmallVector<unsigned, 4> getContiguityOrder(ArrayRef<int64_t> contiguity,
+                                            ArrayRef<int64_t> shape) {
+  SmallVector<unsigned, 4> order(contiguity.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [&](unsigned x, unsigned y) {
+    return contiguity[x] > contiguity[y];
+  });
+  std::stable_partition(order.begin(), order.end(),
+                        [&](unsigned d) { return shape[d] != 1; });
+  return order;
+}
+
 //===----------------------------------------------------------------------===//
 // GraphDumper
 //===----------------------------------------------------------------------===//
@@ -319,6 +335,71 @@ inferSrcEncoding(triton::ExperimentalInterleaveOp op, Attribute encoding) {
       enc.getOrder(), enc.getCTALayout());
 }
 
+// Reshapes are only propagated through when they are renames of the values,
+// which doesn't depend on whether they may reorder the elements. The ones
+// with `efficient_layout` keep their destination layout.
+static std::optional<Attribute> inferReshapeEncoding(triton::ReshapeOp op,
+                                                     Value from, Value to,
+                                                     Attribute encoding) {
+  if (op.getEfficientLayout())
+    return std::nullopt;
+  auto fromType = from.getType().cast<RankedTensorType>();
+  return triton::gpu::inferReshapeRenameEncoding(
+      RankedTensorType::get(fromType.getShape(), fromType.getElementType(),
+                            encoding),
+      to.getType().cast<RankedTensorType>().getShape());
+}
+
+// The values of the operands of a cat are concatenated in each thread, so a
+// blocked encoding works on both sides if it gives the result as many
+// elements per thread as the operands together.
+static std::optional<Attribute> inferCatEncoding(triton::CatOp op,
+                                                 Attribute encoding) {
+  if (!encoding.isa<triton::gpu::BlockedEncodingAttr>())
+    return std::nullopt;
+  auto getElemsPerThread = [&](Value value) {
+    auto type = value.getType().cast<RankedTensorType>();
+    return triton::gpu::getTotalElemsPerThread(encoding, type.getShape(),
+                                               type.getElementType());
+  };
+  if (getElemsPerThread(op.getResult()) !=
+      getElemsPerThread(op.getLhs()) + getElemsPerThread(op.getRhs()))
+    return std::nullopt;
+  return encoding;
+}
+
+// Transposing a blocked encoding twice gives it back, so this infers both
+// ways.
+static std::optional<Attribute> inferTransEncoding(Attribute encoding) {
+  if (!encoding.isa<triton::gpu::BlockedEncodingAttr>())
+    return std::nullopt;
+  auto *inferLayoutInterface =
+      cast<triton::DialectInferLayoutInterface>(&encoding.getDialect());
+  Attribute transEncoding;
+  if (failed(inferLayoutInterface->inferTransOpEncoding(encoding,
+                                                        transEncoding)))
+    return std::nullopt;
+  return transEncoding;
+}
+
+static std::optional<Attribute> inferJoinEncoding(Attribute encoding) {
+  Attribute dstEnc;
+  if (cast<triton::DialectInferLayoutInterface>(&encoding.getDialect())
+          ->inferJoinOpEncoding(encoding, dstEnc, /*loc=*/std::nullopt)
+          .succeeded())
+    return dstEnc;
+  return std::nullopt;
+}
+
+static std::optional<Attribute> inferSplitEncoding(Attribute encoding) {
+  Attribute dstEnc;
+  if (cast<triton::DialectInferLayoutInterface>(&encoding.getDialect())
+          ->inferSplitOpEncoding(encoding, dstEnc, /*loc=*/std::nullopt)
+          .succeeded())
+    return dstEnc;
+  return std::nullopt;
+}
+
 std::optional<Attribute> inferSrcEncoding(Operation *op, Attribute encoding) {
   if (auto reduceOp = dyn_cast<triton::ReduceOp>(op))
     return inferSrcEncoding(reduceOp, encoding);
@@ -326,8 +407,17 @@ std::optional<Attribute> inferSrcEncoding(Operation *op, Attribute encoding) {
     return inferSrcEncoding(expand, encoding);
   if (auto interleave = dyn_cast<triton::ExperimentalInterleaveOp>(op))
     return inferSrcEncoding(interleave, encoding);
-  if (isa<triton::ReshapeOp, triton::CatOp>(op))
-    return std::nullopt;
+  if (auto reshape = dyn_cast<triton::ReshapeOp>(op))
+    return inferReshapeEncoding(reshape, reshape.getResult(), reshape.getSrc(),
+                                encoding);
+  if (auto cat = dyn_cast<triton::CatOp>(op))
+    return inferCatEncoding(cat, encoding);
+  if (isa<triton::TransOp>(op))
+    return inferTransEncoding(encoding);
+  if (isa<triton::JoinOp>(op))
+    return inferSplitEncoding(encoding);
+  if (isa<triton::SplitOp>(op))
+    return inferJoinEncoding(encoding);
   return encoding;
 }
 
@@ -338,8 +428,17 @@ std::optional<Attribute> inferDstEncoding(Operation *op, Attribute encoding) {
     return inferDstEncoding(expand, encoding);
   if (auto interleave = dyn_cast<triton::ExperimentalInterleaveOp>(op))
     return inferDstEncoding(interleave, encoding);
-  if (isa<triton::ReshapeOp, triton::CatOp>(op))
-    return std::nullopt;
+  if (auto reshape = dyn_cast<triton::ReshapeOp>(op))
+    return inferReshapeEncoding(reshape, reshape.getSrc(), reshape.getResult(),
+                                encoding);
+  if (auto cat = dyn_cast<triton::CatOp>(op))
+    return inferCatEncoding(cat, encoding);
+  if (isa<triton::TransOp>(op))
+    return inferTransEncoding(encoding);
+  if (isa<triton::JoinOp>(op))
+    return inferJoinEncoding(encoding);
+  if (isa<triton::SplitOp>(op))
+    return inferSplitEncoding(encoding);
   return encoding;
 }
 
@@ -4,6 +4,7 @@
 #include "triton/Dialect/TritonNvidiaGPU/IR/Dialect.h"
 #include "triton/Dialect/TritonNvidiaGPU/Transforms/Passes.h"
 #include "triton/Tools/Sys/GetEnv.hpp"
+#include "llvm/ADT/SetVector.h"
 #include "llvm/Support/Debug.h"
 
 //===----------------------------------------------------------------------===//
@@ -43,79 +44,78 @@ public:
     if (::triton::tools::getBoolEnv("DISABLE_MMA_V3"))
       return;
     ModuleOp mod = getOperation();
+    // The generic proxy writes to shared memory read by the async proxy. They
+    // are fenced once, right after the write, rather than before each read: a
+    // buffer written before a loop isn't fenced on every iteration.
+    SetVector<Operation *> genericWrites;
     mod.walk([&](Operation *op) {
       if (isa<tt::DotOp, ttng::DotAsyncOp>(op)) {
-        OpBuilder builder(op);
-        auto a = op->getOperand(0);
-        auto b = op->getOperand(1);
         auto mmaEncoding = op->getResult(0)
                                .getType()
                                .cast<RankedTensorType>()
                                .getEncoding()
                                .dyn_cast<ttg::NvidiaMmaEncodingAttr>();
-        auto isHopperEncoding = mmaEncoding && mmaEncoding.isHopper();
-        if (isHopperEncoding &&
-            (dependOnSharedEncOperand(a) || dependOnSharedEncOperand(b))) {
-          builder.create<ttng::FenceAsyncSharedOp>(op->getLoc(),
-                                                   false /*bCluster*/);
+        if (!mmaEncoding || !mmaEncoding.isHopper())
+          return;
+        for (Value operand : op->getOperands().take_front(2)) {
+          visited.clear();
+          collectGenericWrites(operand, genericWrites);
         }
       }
     });
+    for (Operation *write : genericWrites) {
+      OpBuilder builder(write->getContext());
+      builder.setInsertionPointAfter(write);
+      builder.create<ttng::FenceAsyncSharedOp>(write->getLoc(),
+                                               false /*bCluster*/);
+    }
   }
 
 private:
-  bool dependOnSharedEncOperand(Value operand) {
-    static DenseSet<std::pair<Operation *, unsigned>> trace;
+  // The yields already traced, to avoid cycles
+  DenseSet<std::pair<Operation *, unsigned>> visited;
+
+  // Collects the generic proxy writes to shared memory `operand` depends on.
+  void collectGenericWrites(Value operand,
+                            SetVector<Operation *> &genericWrites) {
     auto op = operand.getDefiningOp();
-    // avoid redundant insertion
+    // the result of an async op is fenced through its own operands
     if (op && isa<tt::DotOp, ttng::DotAsyncOp>(op))
-      return false;
+      return;
     // reach convertlayout
-    if (op && isa<ttg::ConvertLayoutOp>(op) && ttg::hasSharedEncoding(operand))
-      return true;
-    // root and not BlockArgument
-    if (!op && !isa<BlockArgument>(operand))
-      return false;
+    if (op && isa<ttg::ConvertLayoutOp>(op) &&
+        ttg::hasSharedEncoding(operand)) {
+      genericWrites.insert(op);
+      return;
+    }
     // op and not BlockArgument
-    if (op && !isa<BlockArgument>(operand)) {
-      for (auto v : op->getOperands()) {
-        if (dependOnSharedEncOperand(v))
-          return true;
-      }
+    if (op) {
+      for (auto v : op->getOperands())
+        collectGenericWrites(v, genericWrites);
+      return;
     }
     // reach BlockArgument
     // TODO: support other scf ops, IfOp, WhileOp, etc.
-    if (BlockArgument arg = dyn_cast<BlockArgument>(operand)) {
-      unsigned argNum = arg.getArgNumber();
-      Operation *argOwner = arg.getOwner()->getParentOp();
-      // support ForOp only
-      if (auto forOp = dyn_cast<scf::ForOp>(argOwner)) {
-        // prologue
-        auto iterOperands = forOp.getInitArgs();
-        if (argNum == 0)
-          return false;
-        if (dependOnSharedEncOperand(iterOperands[argNum - 1]))
-          return true;
-        // yield
-        auto yieldOp = forOp.getBody()->getTerminator();
-        Value v = yieldOp->getOperand(argNum - 1);
-        auto entry = std::make_pair<Operation *, unsigned>(std::move(yieldOp),
-                                                           std::move(argNum));
-        // avoid cyclic
-        if (trace.contains(entry))
-          return false;
-        else
-          trace.insert(entry);
-
-        if (dependOnSharedEncOperand(v))
-          return true;
-      } else if (auto whileOp = dyn_cast<scf::WhileOp>(argOwner)) {
-        assert(false && "FenceInsertionPass does not supported WhileOp");
-      } else if (auto ifOp = dyn_cast<scf::IfOp>(argOwner)) {
-        assert(false && "FenceInsertionPass does not supported IfOp");
-      }
+    BlockArgument arg = cast<BlockArgument>(operand);
+    unsigned argNum = arg.getArgNumber();
+    Operation *argOwner = arg.getOwner()->getParentOp();
+    // support ForOp only
+    if (auto forOp = dyn_cast<scf::ForOp>(argOwner)) {
+      if (argNum == 0)
+        return;
+      // prologue
+      collectGenericWrites(forOp.getInitArgs()[argNum - 1], genericWrites);
+      // yield
+      auto yieldOp = forOp.getBody()->getTerminator();
+      // avoid cyclic
+      if (!visited.insert({yieldOp, argNum}).second)
+        return;
+      collectGenericWrites(yieldOp->getOperand(argNum - 1), genericWrites);
+    } else if (isa<scf::WhileOp>(argOwner)) {
+      assert(false && "FenceInsertionPass does not supported WhileOp");
+    } else if (isa<scf::IfOp>(argOwner)) {
+      assert(false && "FenceInsertionPass does not supported IfOp");
     }
-    return false;
   }
 };
 } // namespace
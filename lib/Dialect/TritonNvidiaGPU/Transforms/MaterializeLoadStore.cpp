@@ -52,6 +52,23 @@ using ::mlir::triton::gpu::SharedEncodingAttr;
 
 namespace {
 
+// Whether `store` is the only bulk async copy of the loop it's in, so that
+// waiting for all but the last bulk group to finish reading shared memory
+// waits for its previous iteration.
+bool isOnlyBulkStoreOfLoop(mlir::triton::StoreOp store) {
+  auto forOp = dyn_cast<scf::ForOp>(store->getParentOp());
+  if (!forOp)
+    return false;
+  auto result = forOp.walk([&](Operation *op) {
+    auto storeOp = dyn_cast<mlir::triton::StoreOp>(op);
+    if ((storeOp && storeOp != store && isStoreToTensorPtr(storeOp)) ||
+        isa<ttng::StoreAsyncTMAOp, ttg::AsyncBulkWaitOp>(op))
+      return WalkResult::interrupt();
+    return WalkResult::advance();
+  });
+  return !result.wasInterrupted();
+}
+
 struct MaterializeLoadStorePass
     : public MaterializeLoadStoreBase<MaterializeLoadStorePass> {
 
@@ -136,15 +153,15 @@ void MaterializeLoadStorePass::materializeLoadTilePtr(mlir::triton::LoadOp load,
       load.getEvict(), load.getIsVolatile(),
       /*axis*/ 0);
   auto extractedTy = RankedTensorType::get(loadShape, elemTy, sharedEncoding);
+  SmallVector<OpFoldResult> offsets(bufferShape.size(),
+                                    b.getI64IntegerAttr(0));
+  SmallVector<OpFoldResult> sizes;
+  for (int64_t size : bufferShape)
+    sizes.push_back(b.getI64IntegerAttr(size));
+  SmallVector<OpFoldResult> strides(bufferShape.size(),
+                                    b.getI64IntegerAttr(1));
   Value extracted = b.create<mlir::triton::gpu::ExtractSliceOp>(
-      loc, extractedTy, inserted,
-      SmallVector<OpFoldResult>{b.getI64IntegerAttr(0), b.getI64IntegerAttr(0),
-                                b.getI64IntegerAttr(0)},
-      SmallVector<OpFoldResult>{b.getI64IntegerAttr(1),
-                                b.getI64IntegerAttr(loadShape[0]),
-                                b.getI64IntegerAttr(loadShape[1])},
-      SmallVector<OpFoldResult>{b.getI64IntegerAttr(1), b.getI64IntegerAttr(1),
-                                b.getI64IntegerAttr(1)});
+      loc, extractedTy, inserted, offsets, sizes, strides);
   Value phase;
   if (auto forOp = load->getParentOfType<mlir::scf::ForOp>()) {
     phase = getPhase(forOp, true);
@@ -209,6 +226,41 @@ void MaterializeLoadStorePass::materializeStoreTilePtr(
                                                 ctaLayout, storeElemTy);
   auto bufferTy =
       RankedTensorType::get(bufferShape, storeElemTy, sharedEncoding);
+  if (storeTy.getEncoding().isa<BlockedEncodingAttr>() &&
+      isOnlyBulkStoreOfLoop(store)) {
+    // The iterations of the loop, like the tiles of a persistent kernel,
+    // alternate between two buffers: the next one runs while the TMA store
+    // of the previous one drains, it's only waited for two iterations later.
+    Value phase = getPhase(cast<scf::ForOp>(store->getParentOp()), true);
+    auto forOp = cast<scf::ForOp>(store->getParentOp());
+    SmallVector<int64_t> buffersShape(bufferShape.begin(), bufferShape.end());
+    buffersShape.insert(buffersShape.begin(), 2);
+    auto buffersTy =
+        RankedTensorType::get(buffersShape, storeElemTy, sharedEncoding);
+    builder.setInsertionPoint(forOp);
+    Value buffers = builder.create<ttg::AllocTensorOp>(loc, buffersTy);
+    builder.setInsertionPointAfter(forOp);
+    builder.create<ttg::AsyncBulkWaitOp>(loc, 0);
+
+    builder.setInsertionPoint(store);
+    Value index =
+        builder.create<arith::ExtUIOp>(loc, builder.getI32Type(), phase);
+    SmallVector<OpFoldResult> offsets(rank + 1, builder.getI64IntegerAttr(0));
+    offsets[0] = index;
+    SmallVector<OpFoldResult> sizes{builder.getI64IntegerAttr(1)};
+    for (int64_t size : bufferShape)
+      sizes.push_back(builder.getI64IntegerAttr(size));
+    SmallVector<OpFoldResult> strides(rank + 1, builder.getI64IntegerAttr(1));
+    builder.create<ttg::AsyncBulkWaitOp>(loc, 1);
+    Value inserted = builder.create<tensor::InsertSliceOp>(
+        loc, value, buffers, offsets, sizes, strides);
+    Value buffer = builder.create<ttg::ExtractSliceOp>(
+        loc, bufferTy, inserted, offsets, sizes, strides);
+    builder.create<ttng::StoreAsyncTMAOp>(loc, dst, buffer);
+    builder.create<ttg::AsyncBulkCommitGroupOp>(loc);
+    store->erase();
+    return;
+  }
   Value cvt = builder.create<ttg::ConvertLayoutOp>(loc, bufferTy, value);
   builder.create<ttng::StoreAsyncTMAOp>(loc, dst, cvt);
   builder.create<mlir::triton::gpu::AsyncBulkCommitGroupOp>(loc);
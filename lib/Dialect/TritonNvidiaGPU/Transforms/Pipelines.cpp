@@ -0,0 +1,122 @@
+#include "triton/Dialect/TritonNvidiaGPU/Transforms/Pipelines.h"
+#include "mlir/Pass/PassRegistry.h"
+#include "mlir/Transforms/Passes.h"
+#include "triton/Conversion/TritonToTritonGPU/TritonToTritonGPUPass.h"
+#include "triton/Dialect/Triton/IR/Dialect.h"
+#include "triton/Dialect/Triton/Transforms/Passes.h"
+#include "triton/Dialect/TritonGPU/Transforms/Passes.h"
+
+//===----------------------------------------------------------------------===//
+// The pass pipelines of the TTIR and TTGIR stages of the NVIDIA backend. The
+// backend runs them from Python and triton-opt registers them, so that the
+// compilation of a kernel can be reproduced and timed offline.
+//===----------------------------------------------------------------------===//
+
+using namespace mlir;
+namespace tt = mlir::triton;
+namespace ttg = mlir::triton::gpu;
+namespace ttng = mlir::triton::nvidia_gpu;
+
+void ttng::buildTTIRPipeline(OpPassManager &pm,
+                             const TTIRPipelineOptions &options) {
+  pm.addPass(createInlinerPass());
+  pm.addPass(tt::createCombineOpsPass());
+  pm.addPass(tt::createNarrowOffsetsPass(options.maxNumel));
+  pm.addPass(createCanonicalizerPass());
+  pm.addPass(tt::createReorderBroadcastPass());
+  pm.addPass(createCSEPass());
+  pm.addPass(createLoopInvariantCodeMotionPass());
+  // loop-carried pointers instead of addresses recomputed every iteration
+  pm.addPass(tt::createStrengthReducePointersPass());
+  pm.addPass(createCanonicalizerPass());
+  // at most 4 clones of each noinline function
+  pm.addPass(tt::createSpecializeCallsPass(4));
+  pm.addPass(createSymbolDCEPass());
+  pm.addPass(tt::createSplitKPass(options.splitK));
+  if (options.persistent) {
+    pm.addPass(tt::createMakePersistentPass(options.persistentGroupSize, 1));
+    pm.addPass(createLoopInvariantCodeMotionPass());
+  }
+}
+
+void ttng::buildTTGIRLayoutPipeline(OpPassManager &pm,
+                                    const TTGIRPipelineOptions &options,
+                                    ClusterInfo *clusterInfo) {
+  int capability = options.computeCapability;
+  bool globalAssignment = options.globalLayoutAssignment;
+  pm.addPass(tt::createConvertTritonToTritonGPUPass(options.numWarps, 32,
+                                                    options.numCTAs,
+                                                    capability));
+  pm.addPass(ttg::createCoalescePass());
+  // TODO(Qingyi): Move PlanCTAPass to the front of CoalescePass
+  pm.addPass(createTritonNvidiaGPUPlanCTAPass(clusterInfo));
+  pm.addPass(createTritonGPURewriteTensorPointerPass(capability));
+  // the offsets of the block pointers rewritten above are 64-bit
+  pm.addPass(tt::createNarrowOffsetsPass(options.maxNumel));
+  pm.addPass(createTritonNvidiaGPUPlanCTAPass(clusterInfo));
+  pm.addNestedPass<tt::FuncOp>(
+      ttg::createRemoveLayoutConversionsPass(globalAssignment));
+  pm.addPass(ttg::createOptimizeThreadLocalityPass());
+  pm.addPass(ttg::createAccelerateMatmulPass(capability));
+  pm.addNestedPass<tt::FuncOp>(
+      ttg::createRemoveLayoutConversionsPass(globalAssignment));
+  if (options.optimizeEpilogue)
+    pm.addPass(ttg::createOptimizeEpiloguePass());
+  pm.addPass(ttg::createOptimizeDotOperandsPass());
+  pm.addPass(createCSEPass());
+  if (options.warpSpecialization)
+    pm.addPass(createTritonNvidiaGPUWSFeasibilityCheckingPass(
+        capability, options.numStages, options.autoWarpSpecialization));
+}
+
+void ttng::buildTTGIRSchedulePipeline(OpPassManager &pm,
+                                      const TTGIRPipelineOptions &options) {
+  int capability = options.computeCapability;
+  if (options.warpSpecialization) {
+    pm.addPass(createTritonNvidiaGPUWSDecomposingPass(capability));
+    pm.addPass(createTritonNvidiaGPUWSPipelinePass(
+        options.numStages, options.numWarps, capability));
+    pm.addPass(createTritonNvidiaGPUWSMutexPass(capability));
+    pm.addPass(createTritonNvidiaGPUWSMaterializationPass(capability));
+    pm.addPass(createLoopInvariantCodeMotionPass());
+    pm.addPass(createCSEPass());
+  } else {
+    pm.addPass(ttg::createHoistInvariantLoadsPass());
+    pm.addPass(ttg::createPeelMaskedTailPass());
+    pm.addPass(ttg::createPipelinePass(options.numStages, options.numWarps,
+                                       options.numCTAs, capability,
+                                       options.asyncBarriers));
+  }
+  pm.addPass(createTritonNvidiaGPUMaterializeLoadStorePass(options.numWarps,
+                                                           capability));
+  pm.addPass(ttg::createPrefetchPass());
+  pm.addPass(ttg::createOptimizeDotOperandsPass());
+  // function passes: consecutive ones run as a single stage, in parallel over
+  // the functions of the kernel
+  pm.addNestedPass<tt::FuncOp>(
+      ttg::createRemoveLayoutConversionsPass(options.globalLayoutAssignment));
+  pm.addNestedPass<tt::FuncOp>(ttg::createDecomposeConversionsPass());
+  pm.addPass(createTritonNvidiaGPUWSFixupMissingAttrs());
+  pm.addNestedPass<tt::FuncOp>(
+      ttg::createReorderInstructionsPass(options.scheduleInstructions));
+  pm.addPass(createCSEPass());
+  pm.addPass(createSymbolDCEPass());
+  if (capability / 10 >= 9)
+    pm.addPass(createTritonNvidiaGPUFenceInsertionPass());
+  pm.addPass(createTritonNvidiaGPUWSFixupMissingAttrs());
+  pm.addPass(createCanonicalizerPass());
+}
+
+void ttng::registerTritonNvidiaGPUPipelines() {
+  PassPipelineRegistration<TTIRPipelineOptions>(
+      "triton-nvidia-ttir-pipeline",
+      "The passes of the TTIR stage of the NVIDIA backend",
+      buildTTIRPipeline);
+  PassPipelineRegistration<TTGIRPipelineOptions>(
+      "triton-nvidia-ttgir-pipeline",
+      "The passes of the TTGIR stage of the NVIDIA backend",
+      [](OpPassManager &pm, const TTGIRPipelineOptions &options) {
+        buildTTGIRLayoutPipeline(pm, options);
+        buildTTGIRSchedulePipeline(pm, options);
+      });
+}
@@ -38,6 +38,23 @@ namespace ttng = ::mlir::triton::nvidia_gpu;
 // TODO: use ConvertLayoutOp
 using CastOp = ::mlir::UnrealizedConversionCastOp;
 
+bool isLegalCTAChunk(unsigned chunk) { return chunk >= 64; }
+
+// Splits the M x N tile of a dot over `numCTAs` CTAs, as splitM x splitN.
+std::pair<unsigned, unsigned> getCTATiling(int64_t M, int64_t N, int64_t K,
+                                           unsigned numCTAs) {
+  // prefer a larger chunk size, at most 128; first assign splitM.
+  unsigned chunk_m = 128;
+  unsigned splitM, splitN;
+  for (; isLegalCTAChunk(chunk_m); chunk_m /= 2) {
+    splitM = std::clamp<unsigned>(M / chunk_m, 1, numCTAs);
+    splitN = numCTAs / splitM;
+    if (isLegalCTAChunk(N / splitN)) // chunk_n;
+      break;
+  }
+  return {splitM, splitN};
+}
+
 unsigned getNumUsers(Value value) {
   return std::distance(value.user_begin(), value.user_end());
 }
@@ -238,21 +255,6 @@ void CTAPlanner::setTiling(llvm::ArrayRef<unsigned> CTAsPerCGA) {
 
 bool CTAPlanner::processDot(triton::FuncOp &funcOp) {
   // TODO: This is a naive implementation and should be refactored
-  auto getCTATiling = [](int64_t M, int64_t N, int64_t K,
-                         unsigned numCTAs) -> std::pair<unsigned, unsigned> {
-    // prefer a larger chunk size, at most 128; first assign splitM.
-    unsigned chunk_m = 128;
-    auto isLegal = [](unsigned chunk) { return chunk >= 64; };
-    unsigned splitM, splitN;
-    for (; isLegal(chunk_m); chunk_m /= 2) {
-      splitM = std::clamp<unsigned>(M / chunk_m, 1, numCTAs);
-      splitN = numCTAs / splitM;
-      if (isLegal(N / splitN)) // chunk_n;
-        break;
-    }
-    return {splitM, splitN};
-  };
-
   funcOp.walk([&](triton::DotOp dot) {
     MLIRContext *ctx = dot.getContext();
 
@@ -334,13 +336,21 @@ bool CTAPlanner::processReduce(triton::FuncOp &funcOp) {
       }
     }
 
+    // If numCTAs > 1 and the only dimension is the reduced dimension, after the
+    // above two for-loops, CTAsPerCGA = [1] and remainingCTAs = numCTAs. The
+    // reduced dimension is then split between the CTAs, which combine their
+    // partial reductions through distributed shared memory.
+    if (rank == 1 && remainingCTAs > 1 &&
+        srcShape[axis] % (remainingCTAs * sizePerThread[axis]) == 0) {
+      CTAsPerCGA[axis] = remainingCTAs;
+      remainingCTAs = 1;
+    }
+
     llvm::SmallVector<unsigned> CTASplitNum = CTAsPerCGA;
 
-    // If numCTAs > 1 and the only dimension is the reduced dimension, after the
-    // above two for-loops, CTAsPerCGA = [0] and remainingCTAs = numCTAs. We set
-    // CTAsPerCGA[0] = numCTAs and keep CTASplitNum[0] = 1 to ensure that no
-    // cross-CTA reduction is required, although this will introduce duplicated
-    // calculation
+    // Otherwise we set CTAsPerCGA[0] = numCTAs and keep CTASplitNum[0] = 1 to
+    // ensure that no cross-CTA reduction is required, although this will
+    // introduce duplicated calculation
     if (remainingCTAs > 0)
       CTAsPerCGA[order[rank - 1]] *= remainingCTAs;
 
@@ -1018,6 +1028,45 @@ struct PlanCTAPass : public TritonGPUPlanCTAPassBase<PlanCTAPass> {
 
 } // namespace
 
+SmallVector<std::array<unsigned, 3>>
+ttng::proposeClusterDims(ModuleOp mod, unsigned maxNumCTAs) {
+  // PlanCTA tiles the CTAs for a single dot, the largest one decides.
+  triton::DotOp largest;
+  int64_t largestSize = 0;
+  mod.walk([&](triton::DotOp dot) {
+    auto dTy = dot.getD().getType().cast<RankedTensorType>();
+    if (dTy.getRank() == 2 && dTy.getNumElements() > largestSize) {
+      largest = dot;
+      largestSize = dTy.getNumElements();
+    }
+  });
+  if (!largest)
+    return {};
+  auto shape = largest.getD().getType().cast<RankedTensorType>().getShape();
+  int64_t M = shape[0], N = shape[1];
+  int64_t K = largest.getA().getType().cast<RankedTensorType>().getShape()[1];
+
+  SmallVector<std::pair<double, std::array<unsigned, 3>>> candidates;
+  for (unsigned numCTAs = 2; numCTAs <= maxNumCTAs; numCTAs *= 2) {
+    auto [splitM, splitN] = getCTATiling(M, N, K, numCTAs);
+    if (splitM * splitN != numCTAs || !isLegalCTAChunk(M / splitM) ||
+        !isLegalCTAChunk(N / splitN))
+      continue;
+    // As separate programs, the splitM x splitN tiles would load
+    // K * (M * splitN + N * splitM) elements of A and B; multicast within the
+    // cluster loads the K * (M + N) elements of its operands once.
+    double saved = 1.0 - double(M + N) / double(M * splitN + N * splitM);
+    candidates.push_back({saved, {splitM, splitN, 1}});
+  }
+  llvm::stable_sort(candidates, [](const auto &lhs, const auto &rhs) {
+    return lhs.first > rhs.first;
+  });
+  SmallVector<std::array<unsigned, 3>> clusterDims;
+  for (auto &candidate : candidates)
+    clusterDims.push_back(candidate.second);
+  return clusterDims;
+}
+
 std::unique_ptr<Pass>
 mlir::createTritonNvidiaGPUPlanCTAPass(ttng::ClusterInfo *clusterInfo) {
   return std::make_unique<PlanCTAPass>(clusterInfo);
@@ -83,19 +83,27 @@ bool shouldRemove(tt::MakeTensorPtrOp &op, int computeCapability) {
   auto ord = op.getOrder();
   auto stride = op.getStrides();
   auto shape = ttg::getShapePerCTA(resType);
-  // TMA load/store requires the box dimension to be more than 32 bytes.
-  // Because we only support 32B-swizzle, 64B-swizzle and 128B-swizzleon for
-  // now. Remove this constraint when we support non-swizzle smem.
-  bool boxDimSwizzle =
-      shape[ord[0]] >= (256 / elemType.getIntOrFloatBitWidth());
-  // we only support TMA load with 2D tensor for now.
-  // TMA load/store requires the stride to be divisible by 16 bytes.
-  bool strideDivisible = false;
-  if (stride.size() == 2)
-    strideDivisible =
-        isDivisible(stride[ord[1]], 128 / elemType.getIntOrFloatBitWidth());
-  bool enableTMA = ::triton::tools::getBoolEnv("ENABLE_TMA");
-  return !(boxDimSwizzle && strideDivisible && enableTMA);
+  unsigned rank = shape.size();
+  unsigned bitwidth = elemType.getIntOrFloatBitWidth();
+  // The TMA load/store lowerings only support 32B-swizzle, 64B-swizzle and
+  // 128B-swizzle boxes, so 1D tensors and boxes with less than 32 bytes along
+  // the contiguous dimension are left to the legacy pointers. Remove this
+  // constraint when we support non-swizzle smem.
+  if (rank < 2 || rank > 5 || shape[ord[0]] < 256 / bitwidth)
+    return true;
+  // The other box dimensions are limited to 256 elements
+  for (unsigned i = 1; i < rank; ++i)
+    if (shape[ord[i]] > 256)
+      return true;
+  // The swizzling of the shared layout restarts at every 2D matrix of a
+  // higher rank box, TMA swizzles by address.
+  if (rank > 2 && shape[ord[1]] % 8 != 0)
+    return true;
+  // TMA load/store requires the strides to be divisible by 16 bytes.
+  for (unsigned i = 1; i < rank; ++i)
+    if (!isDivisible(stride[ord[i]], 128 / bitwidth))
+      return true;
+  return false;
 }
 
 Value createCmpOp(OpBuilder &builder, Location loc, RankedTensorType type,
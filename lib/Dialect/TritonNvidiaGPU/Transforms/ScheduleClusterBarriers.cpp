@@ -0,0 +1,69 @@
+#include "mlir/Interfaces/SideEffectInterfaces.h"
+#include "triton/Dialect/NVGPU/IR/Dialect.h"
+#include "triton/Dialect/TritonNvidiaGPU/IR/Dialect.h"
+#include "triton/Dialect/TritonNvidiaGPU/Transforms/Passes.h"
+
+//===----------------------------------------------------------------------===//
+// This pass splits the cluster barriers made of an arrive right followed by a
+// wait: the arrive is hoisted above the ops before it and the wait sunk below
+// the ops after it, as long as they don't access memory, so that the threads
+// run them while the other CTAs of the cluster arrive. Only memory-effect free
+// ops, which can't observe the other CTAs, are moved across, within the block.
+//
+// The barriers are created both in TritonGPU IR, nvidia_gpu ops, and by the
+// lowering to LLVM, nvgpu ops, so the pass handles both.
+//===----------------------------------------------------------------------===//
+
+using namespace mlir;
+namespace ttng = ::mlir::triton::nvidia_gpu;
+namespace ttn = ::mlir::triton::nvgpu;
+
+#define GEN_PASS_CLASSES
+#include "triton/Dialect/TritonNvidiaGPU/Transforms/Passes.h.inc"
+
+namespace {
+
+// Whether `op` can be moved across one end of a cluster barrier.
+bool isIndependent(Operation *op) {
+  return !op->hasTrait<OpTrait::IsTerminator>() && op->getNumRegions() == 0 &&
+         isMemoryEffectFree(op);
+}
+
+template <typename ArriveOp, typename WaitOp> void split(ModuleOp mod) {
+  SmallVector<std::pair<ArriveOp, WaitOp>> barriers;
+  mod.walk([&](ArriveOp arriveOp) {
+    if (auto waitOp = dyn_cast_or_null<WaitOp>(arriveOp->getNextNode()))
+      barriers.push_back({arriveOp, waitOp});
+  });
+  for (auto [arriveOp, waitOp] : barriers) {
+    Operation *first = arriveOp;
+    while (first->getPrevNode() && isIndependent(first->getPrevNode()))
+      first = first->getPrevNode();
+    if (first != arriveOp.getOperation())
+      arriveOp->moveBefore(first);
+    Operation *last = waitOp;
+    while (last->getNextNode() && isIndependent(last->getNextNode()))
+      last = last->getNextNode();
+    if (last != waitOp.getOperation())
+      waitOp->moveAfter(last);
+  }
+}
+
+} // anonymous namespace
+
+class TritonNvidiaGPUScheduleClusterBarriersPass
+    : public TritonNvidiaGPUScheduleClusterBarriersBase<
+          TritonNvidiaGPUScheduleClusterBarriersPass> {
+public:
+  TritonNvidiaGPUScheduleClusterBarriersPass() = default;
+
+  void runOnOperation() override {
+    ModuleOp mod = getOperation();
+    split<ttng::ClusterArriveOp, ttng::ClusterWaitOp>(mod);
+    split<ttn::ClusterArriveOp, ttn::ClusterWaitOp>(mod);
+  }
+};
+
+std::unique_ptr<Pass> mlir::createTritonNvidiaGPUScheduleClusterBarriersPass() {
+  return std::make_unique<TritonNvidiaGPUScheduleClusterBarriersPass>();
+}
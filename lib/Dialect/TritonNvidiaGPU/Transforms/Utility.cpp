@@ -27,6 +27,8 @@
 #include "mlir/Dialect/SCF/IR/SCF.h"
 #include "mlir/IR/IRMapping.h"
 #include "mlir/Transforms/GreedyPatternRewriteDriver.h"
+#include "triton/Analysis/CostModel.h"
+#include "triton/Analysis/RegisterPressure.h"
 #include "triton/Analysis/Utility.h"
 #include "triton/Dialect/Triton/IR/Dialect.h"
 #include "triton/Dialect/TritonGPU/IR/Dialect.h"
@@ -66,7 +68,8 @@ bool knownSafeToIgnoreRegion(Operation *op) {
 bool hasUnsafeBarrier(triton::FuncOp funcOp) {
   return funcOp
       ->walk([](Operation *op) {
-        if (isa<triton::AtomicRMWOp, triton::AtomicCASOp>(op))
+        if (isa<triton::AtomicRMWOp, triton::AtomicCASOp,
+                triton::GridSyncOp>(op))
           return WalkResult::interrupt();
         return WalkResult::advance();
       })
@@ -503,6 +506,18 @@ bool isWSCandidateLoad(Operation *op) {
     if (isa<triton::DotOp, triton::LoadOp, triton::ReduceOp>(depOp))
       return false;
   }
+  // The tiles loaded once around a loop of candidate loads, like the queries
+  // of an attention kernel around the loop over its keys and values, are left
+  // to their consumers.
+  for (Operation &sibling : *op->getBlock())
+    if (isa<scf::ForOp, scf::WhileOp>(sibling) &&
+        sibling
+            .walk([](triton::LoadOp loadOp) {
+              return isWSCandidateLoad(loadOp) ? WalkResult::interrupt()
+                                               : WalkResult::advance();
+            })
+            .wasInterrupted())
+      return false;
   return op->getParentOfType<scf::ForOp>() ||
          op->getParentOfType<scf::WhileOp>();
 }
@@ -542,4 +557,69 @@ bool isWSSupported(ModuleOp mod, int computeCapability) {
   return true;
 }
 
+namespace {
+
+// The warp groups hand each stage over through mbarriers, which the MMAs of
+// the stage have to hide: 64 flops per byte loaded are tiles of at least
+// 128x128 16-bit elements.
+constexpr int64_t kMinWSFlopsPerByte = 64;
+// Shorter loops are mostly the prologue and the epilogue of the pipeline,
+// whichever warps run it.
+constexpr int64_t kMinWSTripCount = 8;
+// Registers of each thread the handoff needs on top of the values of the
+// kernel: the phases of the barriers, the indices of the stages.
+constexpr unsigned kWSRegisterSlack = 16;
+
+} // namespace
+
+bool isWSProfitable(ModuleOp mod, int computeCapability, int numStages) {
+  ModuleCostAnalysis costAnalysis(mod);
+  auto roots = costAnalysis.getRoots();
+  if (roots.size() != 1)
+    return false;
+  FunctionOpInterface funcOp = roots.front();
+  // The loops with a dynamic trip count are counted once, so for a GEMM this
+  // is the ratio of an iteration.
+  KernelCost *cost = costAnalysis.getCost(funcOp);
+  if (cost->mmaCount == 0 ||
+      cost->dotFlops < kMinWSFlopsPerByte * cost->globalLoadBytes)
+    return false;
+
+  // The candidate loads move to the producer warps, and their stages to
+  // shared memory either way.
+  int64_t stageBytes = 0;
+  bool hasLongLoop = false;
+  funcOp.walk([&](triton::LoadOp loadOp) {
+    if (!isWSCandidateLoad(loadOp))
+      return;
+    auto type = loadOp.getResult().getType().cast<RankedTensorType>();
+    stageBytes += type.getNumElements() * type.getElementTypeBitWidth() / 8;
+    std::optional<int64_t> tripCount;
+    if (auto forOp = loadOp->getParentOfType<scf::ForOp>())
+      tripCount = getTripCount(forOp);
+    if (!tripCount || *tripCount >= kMinWSTripCount)
+      hasLongLoop = true;
+  });
+  if (!hasLongLoop)
+    return false;
+
+  // The consumer warps keep the values of the loop, the accumulators first. A
+  // kernel that already runs out of registers spills more with the handoff.
+  RegisterPressureAnalysis pressure(funcOp);
+  if (pressure.getMaxRegisters() + kWSRegisterSlack > kMaxRegistersPerThread)
+    return false;
+
+  // The producer warp group doubles the threads of the CTA. When fewer CTAs
+  // fit on a SM, the plain kernel overlaps the loads of a CTA with the MMAs
+  // of the others instead.
+  int numWarps = ttg::TritonGPUDialect::getNumWarps(mod);
+  int threadsPerWarp = ttg::TritonGPUDialect::getThreadsPerWarp(mod);
+  size_t sharedMemory = costAnalysis.getSharedMemorySize() +
+                        std::max(numStages - 1, 0) * stageBytes;
+  return estimateOccupancy(computeCapability, 2 * numWarps, threadsPerWarp,
+                           sharedMemory) >=
+         estimateOccupancy(computeCapability, numWarps, threadsPerWarp,
+                           sharedMemory);
+}
+
 } // namespace mlir
@@ -40,14 +40,25 @@ class TritonGPUWSFeasibilityCheckingPass
           TritonGPUWSFeasibilityCheckingPass> {
 public:
   TritonGPUWSFeasibilityCheckingPass() = default;
-  TritonGPUWSFeasibilityCheckingPass(int computeCapability) {
+  TritonGPUWSFeasibilityCheckingPass(int computeCapability, int numStages,
+                                     bool onlyIfProfitable) {
     this->computeCapability = computeCapability;
+    this->numStages = numStages;
+    this->onlyIfProfitable = onlyIfProfitable;
   }
 
   void runOnOperation() override {
     ModuleOp mod = getOperation();
     int wsSupported = isWSSupported(mod, this->computeCapability);
     auto i32_ty = IntegerType::get(mod->getContext(), 32);
+    // The kernels the compiler decides for fall back silently
+    if (onlyIfProfitable) {
+      int wsEnabled =
+          wsSupported && isWSProfitable(mod, computeCapability, numStages);
+      mod->setAttr(ttng::TritonNvidiaGPUDialect::getWSSupportedAttrName(),
+                   IntegerAttr::get(i32_ty, llvm::APInt(32, wsEnabled)));
+      return;
+    }
     mod->setAttr(ttng::TritonNvidiaGPUDialect::getWSSupportedAttrName(),
                  IntegerAttr::get(i32_ty, llvm::APInt(32, wsSupported)));
     if (wsSupported == 0) {
@@ -63,9 +74,11 @@ public:
 } // namespace
 
 std::unique_ptr<Pass>
-createTritonNvidiaGPUWSFeasibilityCheckingPass(int computeCapability) {
+createTritonNvidiaGPUWSFeasibilityCheckingPass(int computeCapability,
+                                               int numStages,
+                                               bool onlyIfProfitable) {
   return std::make_unique<TritonGPUWSFeasibilityCheckingPass>(
-      computeCapability);
+      computeCapability, numStages, onlyIfProfitable);
 }
 
 } // namespace mlir
@@ -23,9 +23,11 @@
 
 #include "triton/Dialect/TritonNvidiaGPU/Transforms/Passes.h"
 
+#include <algorithm>
 #include <set>
 
 #include "mlir/IR/OperationSupport.h"
+#include "triton/Analysis/RegisterPressure.h"
 #include "triton/Analysis/Utility.h"
 #include "triton/Dialect/Triton/IR/Types.h"
 #include "triton/Dialect/TritonGPU/IR/Dialect.h"
@@ -622,10 +624,22 @@ void materializeMutexOperations(ModuleOp parentOp) {
   materializeMutexOperationsOthers(parentOp);
 }
 
+// Registers of the register file of a SM, split between the warp groups of
+// the CTA at launch.
+constexpr int kRegisterFileSize = 64 * 1024;
+constexpr int kThreadsPerWarpGroup = 4 * 32;
+// Registers of each thread an agent needs on top of the estimated pressure of
+// its values: addresses, loop counters, predicates and temporaries.
+constexpr int kRegisterSlack = 32;
+// setmaxnreg takes a multiple of 8 between 24 and 256.
+constexpr int kMinAgentRegisters = 24;
+constexpr int kMaxAgentRegisters = 256;
+
+// Gives the registers the load agents don't need to the mma agents, where the
+// accumulators live. The load agents keep their estimated register pressure,
+// the mma agents share the rest of the register file.
 // TODO: may also not support 8-warp kernel.
 void tryRegisterRealloc(ModuleOp mod) {
-  constexpr int LoadRegisterRequirement = 40;
-  constexpr int MmaRegisterRequirement = 232;
   OpBuilderWithAgentIds builder(mod.getContext());
 
   auto isLoadAgent = [](scf::IfOp ifOp) -> bool {
@@ -648,34 +662,74 @@ void tryRegisterRealloc(ModuleOp mod) {
         .wasInterrupted();
   };
 
-  // TODO: we need to make agent info more handy
-  SmallVector<scf::IfOp> agentOps;
-  mod->walk([&agentOps](triton::FuncOp funcOp) {
-    Block *block = &funcOp.getBody().front();
-    for (Operation &op : block->getOperations()) {
-      if (auto ifOp = dyn_cast<scf::IfOp>(&op)) {
-        if (getAgentIds(ifOp).size() == 1) {
-          agentOps.push_back(ifOp);
-        }
-      }
-    }
-  });
-  for (auto ifOp : agentOps) {
+  // An agent split in roles runs one warp group per role
+  auto getNumWarpGroups = [](scf::IfOp ifOp) -> int {
+    if (auto numRoles = ifOp->getAttrOfType<IntegerAttr>("agent.num-roles"))
+      return numRoles.getInt();
+    return 1;
+  };
+
+  auto insertRegOp = [&](scf::IfOp ifOp, int registers, bool alloc) {
     builder.setInsertionPointToStart(&(ifOp.getThenRegion().front()));
     builder.setAgentIdsFromOp(ifOp);
-    auto loc = ifOp.getLoc();
-    Type i32_ty = builder.getIntegerType(32);
-    // If an agent has both mma and load, do nothing.
-    if (isMmaAgent(ifOp) && isLoadAgent(ifOp))
-      continue;
-    if (isMmaAgent(ifOp)) {
-      builder.createWithAgentIds<ttng::RegAllocOp>(
-          loc, builder.getIntegerAttr(i32_ty, MmaRegisterRequirement));
-    } else if (isLoadAgent(ifOp)) {
-      builder.createWithAgentIds<ttng::RegDeallocOp>(
-          loc, builder.getIntegerAttr(i32_ty, LoadRegisterRequirement));
+    auto attr = builder.getI32IntegerAttr(registers);
+    if (alloc)
+      builder.createWithAgentIds<ttng::RegAllocOp>(ifOp.getLoc(), attr);
+    else
+      builder.createWithAgentIds<ttng::RegDeallocOp>(ifOp.getLoc(), attr);
+  };
+
+  mod->walk([&](triton::FuncOp funcOp) {
+    // TODO: we need to make agent info more handy
+    SmallVector<scf::IfOp> loadAgentOps, mmaAgentOps;
+    int numWarpGroups = 0;
+    for (auto ifOp : funcOp.getBody().front().getOps<scf::IfOp>()) {
+      if (getAgentIds(ifOp).size() != 1)
+        continue;
+      numWarpGroups += getNumWarpGroups(ifOp);
+      bool isMma = isMmaAgent(ifOp);
+      bool isLoad = isLoadAgent(ifOp);
+      // If an agent has both mma and load, do nothing.
+      if (isMma && !isLoad)
+        mmaAgentOps.push_back(ifOp);
+      else if (isLoad && !isMma)
+        loadAgentOps.push_back(ifOp);
     }
-  }
+    if (loadAgentOps.empty() || mmaAgentOps.empty())
+      return;
+
+    // The registers of each thread at launch, the whole register file split
+    // between the warp groups
+    int launchRegisters = std::min<int>(
+        kMaxRegistersPerThread,
+        kRegisterFileSize / (numWarpGroups * kThreadsPerWarpGroup));
+    launchRegisters = launchRegisters / 8 * 8;
+    int freeRegisters = launchRegisters * numWarpGroups;
+
+    RegisterPressureAnalysis pressure(funcOp);
+    SmallVector<int> loadRegisters;
+    for (auto ifOp : loadAgentOps) {
+      int registers = pressure.getMaxRegisters(ifOp) + kRegisterSlack;
+      registers = std::clamp<int>(llvm::alignTo(registers, 8),
+                                  kMinAgentRegisters, launchRegisters);
+      freeRegisters -= registers * getNumWarpGroups(ifOp);
+      loadRegisters.push_back(registers);
+    }
+
+    int numMmaWarpGroups = 0;
+    for (auto ifOp : mmaAgentOps)
+      numMmaWarpGroups += getNumWarpGroups(ifOp);
+    int mmaRegisters = std::min(kMaxAgentRegisters,
+                                freeRegisters / numMmaWarpGroups / 8 * 8);
+    // The load agents need what they have
+    if (mmaRegisters <= launchRegisters)
+      return;
+    for (auto [ifOp, registers] : llvm::zip(loadAgentOps, loadRegisters))
+      if (registers < launchRegisters)
+        insertRegOp(ifOp, registers, /*alloc=*/false);
+    for (auto ifOp : mmaAgentOps)
+      insertRegOp(ifOp, mmaRegisters, /*alloc=*/true);
+  });
 }
 
 // This pass adds top-level `if` statements to the module so that:
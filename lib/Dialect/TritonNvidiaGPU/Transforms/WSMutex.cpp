@@ -41,6 +41,26 @@ template <typename... T> int getKeyTypeIdWrapper(Operation *op) {
   return found ? id : -1;
 }
 
+// Returns the ops of the body of `persistentForOp` holding key operations, in
+// program order. Each one is a role, run under its own mutex: the key
+// operations nested in the same op, like the dots of the inner loop of an
+// attention kernel, can only be locked around it.
+SmallVector<Operation *>
+getRoleOps(scf::ForOp persistentForOp,
+           DenseMap<int, DenseSet<Operation *>> &keyTypeOpMap) {
+  Block *body = persistentForOp.getBody();
+  DenseSet<Operation *> ancestors;
+  for (auto &[id, ops] : keyTypeOpMap)
+    for (Operation *op : ops)
+      if (Operation *ancestor = body->findAncestorOpInBlock(*op))
+        ancestors.insert(ancestor);
+  SmallVector<Operation *> roleOps;
+  for (Operation &op : body->without_terminator())
+    if (ancestors.contains(&op))
+      roleOps.push_back(&op);
+  return roleOps;
+}
+
 bool isEligible(Operation *agent,
                 DenseMap<int, DenseSet<Operation *>> &keyTypeOpMap,
                 scf::ForOp &persistentForOp) {
@@ -89,33 +109,16 @@ bool isEligible(Operation *agent,
     return hasCommon;
   };
 
-  // Persistent agents with more than one key types are eligible.
-  return getPersistentFor(keyOperations, persistentForOp);
+  // Persistent agents with more than one key types, in more than one role,
+  // are eligible.
+  return getPersistentFor(keyOperations, persistentForOp) &&
+         getRoleOps(persistentForOp, keyTypeOpMap).size() > 1;
 }
 
 void mutexSync(ModuleOp &mod, scf::IfOp &ifOp, scf::ForOp &persistentForOp,
                DenseMap<int, DenseSet<Operation *>> &keyTypeOpMap) {
-  // Modify keyTypeOpMap: DenseMap<int, DenseSet<Operation *>> --> DenseMap<int,
-  // Operation *>. Conservetively, assign each key operation one mutex.
-  // =======================detail description (TODO: to be
-  // deleted)========================== because it's hard to check if two
-  // operations with same typeid can share same mutex, we assign each key
-  // operation one mutex. To illustrate the hardness of this analysis, say we
-  // have two operations with same typeid: a and b, if there is another
-  // operation (say c) of different typeid between a and b, and their locations
-  // are a -- c -- b, then if the dependency is:
-  //   * b depends on c, then a and b can NOT share the same mutex.
-  //   * otherwise, a and b can share after move b before c.
-  // It would be more complicated when there are more types and operations.
-  DenseMap<int, Operation *> ProxyKeyTypeOpMap;
-  for (auto &[id, ops] : keyTypeOpMap) {
-    for (auto itr = ops.begin(); itr != ops.end(); ++itr) {
-      auto op = *itr;
-      ProxyKeyTypeOpMap[ProxyKeyTypeOpMap.size()] = op;
-    }
-  }
-
-  int numRoles = ProxyKeyTypeOpMap.size();
+  SmallVector<Operation *> roleOps = getRoleOps(persistentForOp, keyTypeOpMap);
+  int numRoles = roleOps.size();
   auto loc = ifOp.getLoc();
   OpBuilderWithAgentIds builder(ifOp.getContext());
   // Set num-roles for wsmaterialization pass
@@ -180,74 +183,13 @@ void mutexSync(ModuleOp &mod, scf::IfOp &ifOp, scf::ForOp &persistentForOp,
       oldLB);
   Value cond = builder.create<arith::OrIOp>(loc, isNotTileId0, isNotRole0);
 
-  // Determine boundaries: get the largest exclusive op for each key op.
+  // Determine boundaries: each role is locked around its op, waiting for the
+  // role before it and released as early as possible.
   DenseMap<int, Operation *> lockLocs, unlockLocs;
-  DenseMap<int, SmallVector<Operation *>> parentOps;
-  for (int i = 0; i < numRoles; ++i) {
-    auto op = ProxyKeyTypeOpMap[i]->getParentOp();
-    while (op != persistentForOp->getParentOp()) {
-      parentOps[i].push_back(op);
-      op = op->getParentOp();
-    }
-  }
-
-  std::map<std::pair<int, int>, std::pair<SmallVector<Operation *>::iterator,
-                                          SmallVector<Operation *>::iterator>>
-      rangeMap;
-  for (auto &[i, opsI] : parentOps) {
-    // Check exlusiveness
-    auto op = ProxyKeyTypeOpMap[i];
-    for (auto &[j, opsJ] : parentOps) {
-      if (i == j)
-        continue;
-      auto pair = std::pair<int, int>(i, j);
-      auto pairConj = std::pair<int, int>(j, i);
-      auto end0 = rangeMap.count(pair) ? rangeMap[pair].first : opsI.end();
-      auto end1 = rangeMap.count(pair) ? rangeMap[pair].second : opsJ.end();
-      for (auto m = opsI.begin(); m != end0; ++m) {
-        auto itr = std::find(opsJ.begin(), end1, *m);
-        if (itr == end1) {
-          op = *m;
-          rangeMap[pair] = std::make_pair(m, itr);
-          rangeMap[pairConj] = rangeMap[pair];
-        } else
-          goto exit;
-      }
-    }
-  exit:;
-    lockLocs[i] = op;
-    unlockLocs[i] = op;
-  }
-
-  // Only cases where all lock/unlock locations are in same level make sense.
-  for (int i = 1; i < numRoles; ++i) {
-    if (lockLocs[i]->getParentOp() != lockLocs[i - 1]->getParentOp() ||
-        unlockLocs[i]->getParentOp() != unlockLocs[i - 1]->getParentOp()) {
-      llvm_unreachable("Only cases where all locl/unlock locations are in same "
-                       "level make sense");
-    }
-  }
-
-  // Extend boundaries: wait and release as early as possible
-  DenseMap<int, int> prevTypeIds;
-  int prevId = -1;
-  persistentForOp->walk<WalkOrder::PreOrder>([&](Operation *op) {
-    for (int i = 0; i < numRoles; ++i) {
-      if (lockLocs[i] == op) {
-        prevTypeIds[i] = prevId;
-        prevId = i;
-        break;
-      }
-    }
-  });
-
-  // Update lockLocs
-  for (int i = 0; i < numRoles; ++i) {
-    if (prevTypeIds[i] == -1)
-      lockLocs[i] = cond.getDefiningOp();
-    else
-      lockLocs[i] = unlockLocs[prevTypeIds[i]];
-  }
+  for (int i = 0; i < numRoles; ++i)
+    unlockLocs[i] = roleOps[i];
+  for (int i = 0; i < numRoles; ++i)
+    lockLocs[i] = i == 0 ? cond.getDefiningOp() : unlockLocs[i - 1];
 
   // Update lockLocs
   // ====================== IR after async launch dots ======================
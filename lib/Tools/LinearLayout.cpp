@@ -0,0 +1,321 @@
+#include "triton/Tools/LinearLayout.h"
+#include "llvm/Support/MathExtras.h"
+#include <cassert>
+
+namespace mlir {
+namespace triton {
+
+LinearLayout::LinearLayout(llvm::ArrayRef<int64_t> shape, BasesT registers,
+                           BasesT lanes, BasesT warps)
+    : shape(shape.begin(), shape.end()),
+      bases{std::move(registers), std::move(lanes), std::move(warps)} {
+  unsigned numBits = 0;
+  for (int64_t size : shape) {
+    assert(llvm::isPowerOf2_64(size) && "expected a power of two shape");
+    numBits += llvm::Log2_64(size);
+  }
+  assert(numBits <= 64 && "tensor too large for a linear layout");
+  for (const BasesT &inDimBases : bases)
+    for (const BasisT &basis : inDimBases) {
+      assert(basis.size() == shape.size() && "rank mismatch");
+      for (unsigned d = 0; d < basis.size(); ++d)
+        assert(basis[d] >= 0 && basis[d] < shape[d] && "offset out of range");
+    }
+}
+
+LinearLayout::BasisT LinearLayout::apply(unsigned reg, unsigned lane,
+                                         unsigned warp) const {
+  BasisT offsets(getRank(), 0);
+  std::array<unsigned, kNumInDims> indices = {reg, lane, warp};
+  for (unsigned inDim = 0; inDim < kNumInDims; ++inDim)
+    for (unsigned bit = 0; bit < bases[inDim].size(); ++bit)
+      if (indices[inDim] & (1u << bit))
+        for (unsigned d = 0; d < getRank(); ++d)
+          offsets[d] ^= bases[inDim][bit][d];
+  return offsets;
+}
+
+uint64_t LinearLayout::getPackedBasis(InDim inDim, unsigned bit) const {
+  const BasisT &basis = getBases(inDim)[bit];
+  uint64_t packed = 0;
+  unsigned shift = 0;
+  for (unsigned d = 0; d < getRank(); ++d) {
+    packed |= static_cast<uint64_t>(basis[d]) << shift;
+    shift += llvm::Log2_64(shape[d]);
+  }
+  return packed;
+}
+
+LinearLayout LinearLayout::reshape(llvm::ArrayRef<int64_t> newShape) const {
+  int64_t numElements = 1, newNumElements = 1;
+  for (int64_t size : shape)
+    numElements *= size;
+  for (int64_t size : newShape)
+    newNumElements *= size;
+  assert(numElements == newNumElements &&
+         "the shapes have different numbers of elements");
+  (void)numElements;
+  (void)newNumElements;
+  auto reshapeBasis = [&](const BasisT &basis) {
+    int64_t linear = 0;
+    for (unsigned d = 0; d < getRank(); ++d)
+      linear = linear * shape[d] + basis[d];
+    BasisT newBasis(newShape.size(), 0);
+    for (unsigned d = newShape.size(); d > 0; --d) {
+      newBasis[d - 1] = linear % newShape[d - 1];
+      linear /= newShape[d - 1];
+    }
+    return newBasis;
+  };
+  std::array<BasesT, kNumInDims> newBases;
+  for (unsigned inDim = 0; inDim < kNumInDims; ++inDim)
+    for (const BasisT &basis : bases[inDim])
+      newBases[inDim].push_back(reshapeBasis(basis));
+  auto &[registers, lanes, warps] = newBases;
+  return LinearLayout(newShape, registers, lanes, warps);
+}
+
+namespace {
+
+// Returns the packed bases of `inDim`.
+llvm::SmallVector<uint64_t> getPackedBases(const LinearLayout &layout,
+                                           LinearLayout::InDim inDim) {
+  llvm::SmallVector<uint64_t> packed;
+  for (unsigned bit = 0; bit < layout.getNumBits(inDim); ++bit)
+    packed.push_back(layout.getPackedBasis(inDim, bit));
+  return packed;
+}
+
+// Solves `target = XOR of vectors[i] for the bits i of the result` over GF(2)
+// by Gaussian elimination. Each vector is reduced by the previous rows and
+// becomes a row whose leading bit isn't set in the following ones.
+std::optional<uint64_t> solve(llvm::ArrayRef<uint64_t> vectors,
+                              uint64_t target) {
+  assert(vectors.size() <= 64 && "too many vectors");
+  // The reduced vectors, with the vectors they are the XOR of
+  llvm::SmallVector<std::pair<uint64_t, uint64_t>> rows;
+  auto reduce = [&](uint64_t &vector, uint64_t &combination) {
+    for (auto &row : rows) {
+      uint64_t leadingBit = uint64_t(1) << llvm::Log2_64(row.first);
+      if (vector & leadingBit) {
+        vector ^= row.first;
+        combination ^= row.second;
+      }
+    }
+  };
+  for (unsigned i = 0; i < vectors.size(); ++i) {
+    uint64_t vector = vectors[i];
+    uint64_t combination = uint64_t(1) << i;
+    reduce(vector, combination);
+    if (vector != 0)
+      rows.push_back({vector, combination});
+  }
+  uint64_t combination = 0;
+  reduce(target, combination);
+  if (target != 0)
+    return std::nullopt;
+  return combination;
+}
+
+} // namespace
+
+bool WarpLocalConversion::isRegisterPermutation() const {
+  for (unsigned srcLane : srcLanes)
+    if (srcLane != 0)
+      return false;
+  for (unsigned i = 0; i < laneBases.size(); ++i)
+    if (laneBases[i] != 1u << i)
+      return false;
+  return true;
+}
+
+bool WarpLocalConversion::isNoop() const {
+  if (!isRegisterPermutation() || srcRegisters.size() != numSrcRegisters)
+    return false;
+  for (unsigned r = 0; r < srcRegisters.size(); ++r)
+    if (srcRegisters[r] != r)
+      return false;
+  return true;
+}
+
+std::optional<WarpLocalConversion>
+getWarpLocalConversion(const LinearLayout &src, const LinearLayout &dst) {
+  using InDim = LinearLayout::InDim;
+  if (src.getShape() != dst.getShape() ||
+      src.getNumBits(InDim::Lane) != dst.getNumBits(InDim::Lane) ||
+      src.getBases(InDim::Warp) != dst.getBases(InDim::Warp))
+    return std::nullopt;
+
+  auto srcRegBases = getPackedBases(src, InDim::Register);
+  auto srcLaneBases = getPackedBases(src, InDim::Lane);
+  auto dstRegBases = getPackedBases(dst, InDim::Register);
+  auto dstLaneBases = getPackedBases(dst, InDim::Lane);
+  unsigned numSrcRegBits = srcRegBases.size();
+  llvm::SmallVector<uint64_t> srcRegAndLaneBases(srcRegBases);
+  srcRegAndLaneBases.append(srcLaneBases.begin(), srcLaneBases.end());
+
+  WarpLocalConversion cvt;
+  cvt.numSrcRegisters = src.getNumRegisters();
+  // The lanes of the destination are only mapped to lanes of the source: the
+  // register sent by a shuffle is picked by the sending lane, so it can't
+  // depend on the receiving one.
+  for (unsigned i = 0; i < dstLaneBases.size(); ++i) {
+    if (dstLaneBases[i] == srcLaneBases[i]) {
+      cvt.laneBases.push_back(1u << i);
+      continue;
+    }
+    auto lanes = solve(srcLaneBases, dstLaneBases[i]);
+    if (!lanes)
+      return std::nullopt;
+    cvt.laneBases.push_back(*lanes);
+  }
+
+  llvm::SmallVector<unsigned> regBasesToRegs, regBasesToLanes;
+  for (uint64_t basis : dstRegBases) {
+    auto combination = solve(srcRegBases, basis);
+    if (!combination)
+      combination = solve(srcRegAndLaneBases, basis);
+    if (!combination)
+      return std::nullopt;
+    uint64_t regMask = (uint64_t(1) << numSrcRegBits) - 1;
+    regBasesToRegs.push_back(*combination & regMask);
+    regBasesToLanes.push_back(*combination >> numSrcRegBits);
+  }
+  for (unsigned r = 0; r < dst.getNumRegisters(); ++r) {
+    unsigned srcRegister = 0;
+    unsigned srcLane = 0;
+    for (unsigned bit = 0; bit < regBasesToRegs.size(); ++bit) {
+      if (r & (1u << bit)) {
+        srcRegister ^= regBasesToRegs[bit];
+        srcLane ^= regBasesToLanes[bit];
+      }
+    }
+    cvt.srcRegisters.push_back(srcRegister);
+    cvt.srcLanes.push_back(srcLane);
+  }
+  return cvt;
+}
+
+bool WarpLocalGather::isThreadLocal() const {
+  for (unsigned srcLane : srcLanes)
+    if (srcLane != 0)
+      return false;
+  for (unsigned i = 0; i < laneBases.size(); ++i)
+    if (laneBases[i] != 1u << i)
+      return false;
+  for (unsigned lanes : indexLaneBases)
+    if (lanes != 0)
+      return false;
+  return true;
+}
+
+std::optional<WarpLocalGather> getWarpLocalGather(const LinearLayout &src,
+                                                  const LinearLayout &indices,
+                                                  unsigned axis) {
+  using InDim = LinearLayout::InDim;
+  auto srcShape = src.getShape();
+  if (indices.getRank() != src.getRank() || axis >= src.getRank() ||
+      indices.getNumBits(InDim::Lane) != src.getNumBits(InDim::Lane) ||
+      indices.getNumBits(InDim::Warp) != src.getNumBits(InDim::Warp))
+    return std::nullopt;
+  for (unsigned d = 0; d < src.getRank(); ++d)
+    if (d != axis && indices.getShape()[d] != srcShape[d])
+      return std::nullopt;
+
+  // The offsets of the indices are packed in the shape of the source, with
+  // their offset along the axis dropped: it is the index that gives it.
+  auto packIndexBasis = [&](const LinearLayout::BasisT &basis) {
+    uint64_t packed = 0;
+    unsigned shift = 0;
+    for (unsigned d = 0; d < src.getRank(); ++d) {
+      if (d != axis)
+        packed |= static_cast<uint64_t>(basis[d]) << shift;
+      shift += llvm::Log2_64(srcShape[d]);
+    }
+    return packed;
+  };
+  auto getPackedIndexBases = [&](InDim inDim) {
+    llvm::SmallVector<uint64_t> packed;
+    for (const auto &basis : indices.getBases(inDim))
+      packed.push_back(packIndexBasis(basis));
+    return packed;
+  };
+
+  // Each warp has to hold the rows it gathers from
+  for (const auto &basis : src.getBases(InDim::Warp))
+    if (basis[axis] != 0)
+      return std::nullopt;
+  if (getPackedBases(src, InDim::Warp) != getPackedIndexBases(InDim::Warp))
+    return std::nullopt;
+
+  auto srcRegBases = getPackedBases(src, InDim::Register);
+  auto srcLaneBases = getPackedBases(src, InDim::Lane);
+  unsigned numSrcRegBits = srcRegBases.size();
+  llvm::SmallVector<uint64_t> srcRegAndLaneBases(srcRegBases);
+  srcRegAndLaneBases.append(srcLaneBases.begin(), srcLaneBases.end());
+  uint64_t regMask = (uint64_t(1) << numSrcRegBits) - 1;
+
+  WarpLocalGather gather;
+  gather.numSrcRegisters = src.getNumRegisters();
+  // As for conversions, the lanes of the indices are only mapped to lanes of
+  // the source.
+  auto indexLaneBases = getPackedIndexBases(InDim::Lane);
+  for (unsigned i = 0; i < indexLaneBases.size(); ++i) {
+    if (indexLaneBases[i] == srcLaneBases[i]) {
+      gather.laneBases.push_back(1u << i);
+      continue;
+    }
+    auto lanes = solve(srcLaneBases, indexLaneBases[i]);
+    if (!lanes)
+      return std::nullopt;
+    gather.laneBases.push_back(*lanes);
+  }
+
+  // Registers are read from the same lane when possible
+  auto solveRegAndLane = [&](uint64_t target)
+      -> std::optional<std::pair<unsigned, unsigned>> {
+    auto combination = solve(srcRegBases, target);
+    if (!combination)
+      combination = solve(srcRegAndLaneBases, target);
+    if (!combination)
+      return std::nullopt;
+    return std::make_pair(unsigned(*combination & regMask),
+                          unsigned(*combination >> numSrcRegBits));
+  };
+
+  unsigned axisShift = 0;
+  for (unsigned d = 0; d < axis; ++d)
+    axisShift += llvm::Log2_64(srcShape[d]);
+  for (unsigned bit = 0; bit < llvm::Log2_64(srcShape[axis]); ++bit) {
+    auto combination = solveRegAndLane(uint64_t(1) << (axisShift + bit));
+    if (!combination)
+      return std::nullopt;
+    gather.indexRegBases.push_back(combination->first);
+    gather.indexLaneBases.push_back(combination->second);
+  }
+
+  llvm::SmallVector<unsigned> regBasesToRegs, regBasesToLanes;
+  for (uint64_t basis : getPackedIndexBases(InDim::Register)) {
+    auto combination = solveRegAndLane(basis);
+    if (!combination)
+      return std::nullopt;
+    regBasesToRegs.push_back(combination->first);
+    regBasesToLanes.push_back(combination->second);
+  }
+  for (unsigned r = 0; r < indices.getNumRegisters(); ++r) {
+    unsigned srcRegister = 0;
+    unsigned srcLane = 0;
+    for (unsigned bit = 0; bit < regBasesToRegs.size(); ++bit) {
+      if (r & (1u << bit)) {
+        srcRegister ^= regBasesToRegs[bit];
+        srcLane ^= regBasesToLanes[bit];
+      }
+    }
+    gather.srcRegisters.push_back(srcRegister);
+    gather.srcLanes.push_back(srcLane);
+  }
+  return gather;
+}
+
+} // namespace triton
+} // namespace mlir
@@ -0,0 +1,280 @@
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace py = pybind11;
+
+namespace {
+
+// Mirrors the `annotation` classification done by `KernelArg.signature_key`
+// in python/triton/runtime/jit.py. Keep both in sync.
+enum class ParamKind : int { Generic = 0, Tensor = 1, Bool = 2, Float = 3 };
+
+struct IntValue {
+  bool isUnsigned;
+  int64_t value;
+  uint64_t unsignedValue;
+};
+
+// Returns the value of a Python int if it fits in 64 bits (signed or
+// unsigned), and std::nullopt otherwise.
+std::optional<IntValue> getIntValue(PyObject *obj) {
+  int overflow = 0;
+  long long value = PyLong_AsLongLongAndOverflow(obj, &overflow);
+  if (overflow == 0) {
+    if (value == -1 && PyErr_Occurred()) {
+      PyErr_Clear();
+      return std::nullopt;
+    }
+    return IntValue{false, value, static_cast<uint64_t>(value)};
+  }
+  if (overflow < 0)
+    return std::nullopt;
+  unsigned long long unsignedValue = PyLong_AsUnsignedLongLong(obj);
+  if (PyErr_Occurred()) {
+    PyErr_Clear();
+    return std::nullopt;
+  }
+  return IntValue{true, 0, unsignedValue};
+}
+
+// Type strings used in signature keys. Leaked on purpose so that they are
+// never destroyed after the interpreter has been finalized.
+struct TypeStrs {
+  py::str i1{"i1"};
+  py::str i32{"i32"};
+  py::str i64{"i64"};
+  py::str u64{"u64"};
+  py::str fp32{"fp32"};
+};
+
+const TypeStrs &typeStrs() {
+  static auto *strs = new TypeStrs();
+  return *strs;
+}
+
+// Equivalent of `JITFunction._key_of`. Returns std::nullopt for types the
+// Python implementation rejects so that the error is raised from there.
+std::optional<py::object> keyOf(const py::handle &value) {
+  if (py::hasattr(value, "dtype"))
+    return py::object(value.attr("dtype"));
+  PyObject *obj = value.ptr();
+  if (PyBool_Check(obj))
+    return typeStrs().i1;
+  if (PyLong_Check(obj)) {
+    auto intValue = getIntValue(obj);
+    if (!intValue)
+      return typeStrs().i64;
+    if (!intValue->isUnsigned && intValue->value >= INT32_MIN &&
+        intValue->value <= INT32_MAX)
+      return typeStrs().i32;
+    if (intValue->isUnsigned && intValue->unsignedValue >= (1ull << 63))
+      return typeStrs().u64;
+    return typeStrs().i64;
+  }
+  if (PyFloat_Check(obj))
+    return typeStrs().fp32;
+  if (value.is_none())
+    return py::none();
+  return std::nullopt;
+}
+
+// Equivalent of `KernelArg.signature_key`.
+std::optional<py::object> signatureKey(const py::handle &value,
+                                       ParamKind kind) {
+  switch (kind) {
+  case ParamKind::Tensor:
+    if (!py::hasattr(value, "dtype"))
+      return std::nullopt;
+    return py::object(value.attr("dtype"));
+  case ParamKind::Bool:
+    return typeStrs().i1;
+  case ParamKind::Float:
+    return typeStrs().fp32;
+  case ParamKind::Generic:
+    break;
+  }
+  return keyOf(value);
+}
+
+// Equivalent of `KernelArg.specialization_key`.
+std::optional<py::tuple> specializationKey(const py::handle &value,
+                                           int64_t divisibility,
+                                           int64_t divisibility8) {
+  if (py::hasattr(value, "data_ptr")) {
+    py::object ptr = value.attr("data_ptr")();
+    if (!PyLong_Check(ptr.ptr()))
+      return std::nullopt;
+    unsigned long long addr = PyLong_AsUnsignedLongLong(ptr.ptr());
+    if (PyErr_Occurred()) {
+      PyErr_Clear();
+      return std::nullopt;
+    }
+    return py::make_tuple(addr % divisibility == 0);
+  }
+  PyObject *obj = value.ptr();
+  if (PyLong_Check(obj)) {
+    auto intValue = getIntValue(obj);
+    if (!intValue)
+      return std::nullopt;
+    if (intValue->isUnsigned)
+      return py::make_tuple(intValue->unsignedValue % divisibility == 0,
+                            intValue->unsignedValue % divisibility8 == 0,
+                            false);
+    return py::make_tuple(intValue->value % divisibility == 0,
+                          intValue->value % divisibility8 == 0,
+                          intValue->value == 1);
+  }
+  return py::make_tuple(false);
+}
+
+// Binds the positional and keyword arguments of a launch to the parameters of
+// a JITFunction, and computes the key under which its compiled kernels are
+// cached. `params` holds one `(kind, is_constexpr, do_not_specialize,
+// has_default, default)` tuple per parameter and `paramIndex` maps parameter
+// names to their position. Keyword arguments named in `optionNames` are
+// compiler options and are returned separately.
+//
+// Returns None whenever the launch needs the regular Python path (missing or
+// unknown arguments, unsupported argument types, ...), so that errors are
+// always reported from a single place.
+py::object bindAndKey(const py::tuple &params, const py::dict &paramIndex,
+                      const py::frozenset &optionNames, const py::tuple &args,
+                      const py::dict &kwargs, int64_t divisibility,
+                      int64_t divisibility8) {
+  size_t numParams = params.size();
+  size_t numArgs = args.size();
+  if (numArgs > numParams)
+    return py::none();
+
+  std::vector<py::handle> values(numParams);
+  for (size_t i = 0; i < numArgs; ++i)
+    values[i] = PyTuple_GET_ITEM(args.ptr(), i);
+
+  py::list optionItems;
+  for (auto item : kwargs) {
+    if (optionNames.contains(item.first)) {
+      optionItems.append(py::make_tuple(item.first, item.second));
+      continue;
+    }
+    if (!paramIndex.contains(item.first))
+      return py::none();
+    size_t idx = paramIndex[item.first].cast<size_t>();
+    if (idx < numArgs || values[idx])
+      return py::none();
+    values[idx] = item.second;
+  }
+
+  py::list boundValues(numParams);
+  py::list sigKey, constexprKey, specKey, launchArgs;
+  for (size_t i = 0; i < numParams; ++i) {
+    PyObject *param = PyTuple_GET_ITEM(params.ptr(), i);
+    auto kind = static_cast<ParamKind>(
+        PyLong_AsLong(PyTuple_GET_ITEM(param, 0)));
+    bool isConstexpr = PyObject_IsTrue(PyTuple_GET_ITEM(param, 1));
+    bool doNotSpecialize = PyObject_IsTrue(PyTuple_GET_ITEM(param, 2));
+    if (!values[i]) {
+      if (!PyObject_IsTrue(PyTuple_GET_ITEM(param, 3)))
+        return py::none();
+      values[i] = PyTuple_GET_ITEM(param, 4);
+    }
+    py::handle value = values[i];
+    boundValues[i] = value;
+    if (isConstexpr) {
+      constexprKey.append(value);
+    } else {
+      auto key = signatureKey(value, kind);
+      if (!key)
+        return py::none();
+      sigKey.append(*key);
+      launchArgs.append(value);
+    }
+    if (!doNotSpecialize) {
+      auto key = specializationKey(value, divisibility, divisibility8);
+      if (!key)
+        return py::none();
+      specKey.append(*key);
+    }
+  }
+
+  return py::make_tuple(boundValues, py::tuple(sigKey), py::tuple(constexprKey),
+                        py::tuple(specKey), py::tuple(optionItems),
+                        launchArgs);
+}
+
+using LaunchFn = PyObject *(*)(PyObject *self, PyObject *args);
+
+int gridDim(PyObject *grid, Py_ssize_t i) {
+  if (i >= PySequence_Fast_GET_SIZE(grid))
+    return 1;
+  long value = PyLong_AsLong(PySequence_Fast_GET_ITEM(grid, i));
+  if (value == -1 && PyErr_Occurred())
+    throw py::error_already_set();
+  return static_cast<int>(value);
+}
+
+// Equivalent of `JITFunction._launch` for the kernels whose
+// `CompiledKernel.direct_launch_config` is `config`: assembles the arguments
+// of `CompiledKernel.run` and calls the entry point of its launcher wrapped by
+// `capsule` (see `direct_launch_capsule` in python/triton/backends/driver.py)
+// without going through Python. `config` holds `(split_k, num_warps,
+// num_ctas, cluster_x, cluster_y, cluster_z, shared, function, metadata)`.
+void launch(const py::capsule &capsule, const py::handle &grid,
+            const py::handle &stream, const py::tuple &config,
+            const py::handle &enterHook, const py::handle &exitHook,
+            const py::handle &args) {
+  auto fn = reinterpret_cast<LaunchFn>(
+      PyCapsule_GetPointer(capsule.ptr(), "triton.launch"));
+  if (!fn)
+    throw py::error_already_set();
+  py::object gridSeq = py::reinterpret_steal<py::object>(
+      PySequence_Fast(grid.ptr(), "grid must be a sequence"));
+  py::object argSeq = py::reinterpret_steal<py::object>(
+      PySequence_Fast(args.ptr(), "args must be a sequence"));
+  if (!gridSeq || !argSeq)
+    throw py::error_already_set();
+  int gridX = gridDim(gridSeq.ptr(), 0);
+  int gridY = gridDim(gridSeq.ptr(), 1);
+  // split-K kernels share each reduction among `split_k` programs along the
+  // third dimension
+  int gridZ = gridDim(gridSeq.ptr(), 2) * config[0].cast<int>();
+
+  Py_ssize_t numArgs = PySequence_Fast_GET_SIZE(argSeq.ptr());
+  py::tuple launchArgs(14 + numArgs);
+  size_t i = 0;
+  auto set = [&](py::object value) {
+    PyTuple_SET_ITEM(launchArgs.ptr(), i++, value.release().ptr());
+  };
+  set(py::int_(gridX));
+  set(py::int_(gridY));
+  set(py::int_(gridZ));
+  // num_warps, num_ctas, the cluster dimensions and the shared memory
+  for (size_t j = 1; j < 7; ++j)
+    set(config[j]);
+  set(py::reinterpret_borrow<py::object>(stream));
+  set(config[7]);
+  set(py::reinterpret_borrow<py::object>(enterHook));
+  set(py::reinterpret_borrow<py::object>(exitHook));
+  set(config[8]);
+  for (Py_ssize_t j = 0; j < numArgs; ++j)
+    set(py::reinterpret_borrow<py::object>(
+        PySequence_Fast_GET_ITEM(argSeq.ptr(), j)));
+
+  auto *self = static_cast<PyObject *>(PyCapsule_GetContext(capsule.ptr()));
+  PyObject *ret = fn(self, launchArgs.ptr());
+  if (!ret)
+    throw py::error_already_set();
+  Py_DECREF(ret);
+}
+
+} // namespace
+
+void init_triton_dispatch(py::module &&m) {
+  m.def("bind_and_key", &bindAndKey,
+        "Bind launch arguments and compute the JITFunction cache key");
+  m.def("launch", &launch,
+        "Launch a cached kernel through the C entry point of its launcher");
+}
@@ -1,44 +1,351 @@
 #include <pybind11/numpy.h>
 #include <pybind11/pybind11.h>
 
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
 namespace py = pybind11;
 
+namespace {
+
+using PtrArray =
+    py::array_t<uint64_t, py::array::c_style | py::array::forcecast>;
+using MaskArray =
+    py::array_t<bool, py::array::c_style | py::array::forcecast>;
+
+// Elements are processed in chunks of this size, so that runs of consecutive
+// addresses can be detected within a chunk while chunks run in parallel.
+constexpr size_t kChunkSize = 4096;
+// Below this number of elements, threading costs more than it saves.
+constexpr size_t kParallelThreshold = 1 << 16;
+
+// Calls `fn(begin, end)` on consecutive chunks of [0, numel), in parallel for
+// large tensors when built with OpenMP.
+template <typename Fn> void forEachChunk(size_t numel, Fn fn) {
+  int64_t numChunks = (numel + kChunkSize - 1) / kChunkSize;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) if (numel >= kParallelThreshold)
+#endif
+  for (int64_t chunk = 0; chunk < numChunks; ++chunk) {
+    size_t begin = chunk * kChunkSize;
+    fn(begin, std::min(begin + kChunkSize, numel));
+  }
+}
+
+// Returns the end of the run of unmasked elements at consecutive addresses
+// starting at `begin`.
+size_t runEnd(const uint64_t *ptrs, const bool *masks, size_t begin,
+              size_t end, size_t itemsize) {
+  size_t i = begin + 1;
+  while (i < end && masks[i] && ptrs[i] == ptrs[i - 1] + itemsize)
+    ++i;
+  return i;
+}
+
+template <typename T>
+void gather(const uint64_t *ptrs, const bool *masks, const T *other, T *out,
+            size_t numel) {
+  forEachChunk(numel, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end;) {
+      if (!masks[i]) {
+        out[i] = other[i];
+        ++i;
+        continue;
+      }
+      size_t j = runEnd(ptrs, masks, i, end, sizeof(T));
+      if (j - i > 1)
+        memcpy(out + i, reinterpret_cast<const void *>(ptrs[i]),
+               (j - i) * sizeof(T));
+      else
+        out[i] = *reinterpret_cast<const T *>(ptrs[i]);
+      i = j;
+    }
+  });
+}
+
+template <typename T>
+void scatter(const uint64_t *ptrs, const bool *masks, const T *values,
+             size_t numel) {
+  // Like on the GPU, the value stored when several elements alias the same
+  // address is unspecified.
+  forEachChunk(numel, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end;) {
+      if (!masks[i]) {
+        ++i;
+        continue;
+      }
+      size_t j = runEnd(ptrs, masks, i, end, sizeof(T));
+      if (j - i > 1)
+        memcpy(reinterpret_cast<void *>(ptrs[i]), values + i,
+               (j - i) * sizeof(T));
+      else
+        *reinterpret_cast<T *>(ptrs[i]) = values[i];
+      i = j;
+    }
+  });
+}
+
+// Elements of any other size are copied byte-wise.
+void gatherBytes(const uint64_t *ptrs, const bool *masks, const char *other,
+                 char *out, size_t numel, size_t itemsize) {
+  forEachChunk(numel, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i)
+      memcpy(out + i * itemsize,
+             masks[i] ? reinterpret_cast<const char *>(ptrs[i])
+                      : other + i * itemsize,
+             itemsize);
+  });
+}
+
+void scatterBytes(const uint64_t *ptrs, const bool *masks, const char *values,
+                  size_t numel, size_t itemsize) {
+  forEachChunk(numel, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i)
+      if (masks[i])
+        memcpy(reinterpret_cast<void *>(ptrs[i]), values + i * itemsize,
+               itemsize);
+  });
+}
+
+void load(const uint64_t *ptrs, const bool *masks, const void *other,
+          void *out, size_t numel, size_t itemsize) {
+  switch (itemsize) {
+  case 1:
+    return gather(ptrs, masks, static_cast<const uint8_t *>(other),
+                  static_cast<uint8_t *>(out), numel);
+  case 2:
+    return gather(ptrs, masks, static_cast<const uint16_t *>(other),
+                  static_cast<uint16_t *>(out), numel);
+  case 4:
+    return gather(ptrs, masks, static_cast<const uint32_t *>(other),
+                  static_cast<uint32_t *>(out), numel);
+  case 8:
+    return gather(ptrs, masks, static_cast<const uint64_t *>(other),
+                  static_cast<uint64_t *>(out), numel);
+  default:
+    return gatherBytes(ptrs, masks, static_cast<const char *>(other),
+                       static_cast<char *>(out), numel, itemsize);
+  }
+}
+
+void store(const uint64_t *ptrs, const bool *masks, const void *values,
+           size_t numel, size_t itemsize) {
+  switch (itemsize) {
+  case 1:
+    return scatter(ptrs, masks, static_cast<const uint8_t *>(values), numel);
+  case 2:
+    return scatter(ptrs, masks, static_cast<const uint16_t *>(values), numel);
+  case 4:
+    return scatter(ptrs, masks, static_cast<const uint32_t *>(values), numel);
+  case 8:
+    return scatter(ptrs, masks, static_cast<const uint64_t *>(values), numel);
+  default:
+    return scatterBytes(ptrs, masks, static_cast<const char *>(values), numel,
+                        itemsize);
+  }
+}
+
+enum class RMWOp { ADD, FADD, AND, OR, XOR, XCHG, MAX, MIN, UMAX, UMIN };
+
+RMWOp getRMWOp(const std::string &name) {
+  static const std::map<std::string, RMWOp> ops = {
+      {"ADD", RMWOp::ADD},   {"FADD", RMWOp::FADD}, {"AND", RMWOp::AND},
+      {"OR", RMWOp::OR},     {"XOR", RMWOp::XOR},   {"XCHG", RMWOp::XCHG},
+      {"MAX", RMWOp::MAX},   {"MIN", RMWOp::MIN},   {"UMAX", RMWOp::UMAX},
+      {"UMIN", RMWOp::UMIN},
+  };
+  auto it = ops.find(name);
+  if (it == ops.end())
+    throw std::invalid_argument("atomic_rmw: unsupported operation " + name);
+  return it->second;
+}
+
+template <typename T> T applyRMW(RMWOp op, T old, T val) {
+  switch (op) {
+  case RMWOp::ADD:
+  case RMWOp::FADD:
+    return old + val;
+  case RMWOp::XCHG:
+    return val;
+  case RMWOp::MAX:
+    return std::max(old, val);
+  case RMWOp::MIN:
+    return std::min(old, val);
+  default:
+    break;
+  }
+  if constexpr (std::is_integral_v<T>) {
+    using U = std::make_unsigned_t<T>;
+    switch (op) {
+    case RMWOp::AND:
+      return old & val;
+    case RMWOp::OR:
+      return old | val;
+    case RMWOp::XOR:
+      return old ^ val;
+    case RMWOp::UMAX:
+      return static_cast<T>(std::max<U>(old, val));
+    case RMWOp::UMIN:
+      return static_cast<T>(std::min<U>(old, val));
+    default:
+      break;
+    }
+  }
+  throw std::invalid_argument("atomic_rmw: unsupported operation for type");
+}
+
+// Program instances may run concurrently (see `TRITON_INTERPRET_THREADS`), so
+// atomics are real host atomics: a compare-and-swap loop on each element.
+template <typename T>
+void atomicRMW(RMWOp op, const uint64_t *ptrs, const T *vals,
+               const bool *masks, T *out, size_t numel) {
+  for (size_t i = 0; i < numel; ++i) {
+    if (!masks[i]) {
+      out[i] = T();
+      continue;
+    }
+    T *addr = reinterpret_cast<T *>(ptrs[i]);
+    T old;
+    __atomic_load(addr, &old, __ATOMIC_SEQ_CST);
+    T desired;
+    do {
+      desired = applyRMW(op, old, vals[i]);
+    } while (!__atomic_compare_exchange(addr, &old, &desired, false,
+                                        __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST));
+    out[i] = old;
+  }
+}
+
+template <typename T>
+void atomicCAS(const uint64_t *ptrs, const T *cmps, const T *vals, T *out,
+               size_t numel) {
+  for (size_t i = 0; i < numel; ++i) {
+    T expected = cmps[i];
+    T desired = vals[i];
+    __atomic_compare_exchange(reinterpret_cast<T *>(ptrs[i]), &expected,
+                              &desired, false, __ATOMIC_SEQ_CST,
+                              __ATOMIC_SEQ_CST);
+    // on failure, `expected` holds the current value
+    out[i] = expected;
+  }
+}
+
+// Calls `fn` with a value of the C++ type of the numpy `dtype`.
+template <typename Fn> void dispatchAtomicType(const py::dtype &dtype, Fn fn) {
+  char kind = dtype.kind();
+  size_t size = dtype.itemsize();
+  if (kind == 'i' && size == 2)
+    return fn(int16_t());
+  if (kind == 'u' && size == 2)
+    return fn(uint16_t());
+  if (kind == 'i' && size == 4)
+    return fn(int32_t());
+  if (kind == 'u' && size == 4)
+    return fn(uint32_t());
+  if (kind == 'i' && size == 8)
+    return fn(int64_t());
+  if (kind == 'u' && size == 8)
+    return fn(uint64_t());
+  if (kind == 'f' && size == 4)
+    return fn(float());
+  if (kind == 'f' && size == 8)
+    return fn(double());
+  throw std::invalid_argument("atomics are not supported for dtype " +
+                              std::string(py::str(dtype)));
+}
+
+} // namespace
+
 void init_triton_interpreter(py::module &&m) {
   using ret = py::return_value_policy;
 
   m.def("load",
-        [](py::array_t<uint64_t> ptrs, py::array_t<bool> masks, py::array other,
+        [](PtrArray ptrs, MaskArray masks, py::array other,
            py::dtype ret_dtype) -> py::array {
-          int numel = ptrs.size();
+          size_t numel = ptrs.size();
           auto shape =
               std::vector<ptrdiff_t>(ptrs.shape(), ptrs.shape() + ptrs.ndim());
-          py::array ret(ret_dtype, py::array::ShapeContainer{numel});
-          py::array_t<uint64_t> reshaped_ptrs = ptrs.reshape({numel});
-          py::array_t<bool> reshaped_masks = masks.reshape({numel});
-          py::array reshaped_others = other.reshape({numel});
-          for (size_t i = 0; i < ptrs.size(); ++i) {
-            if (reshaped_masks.at(i))
-              memcpy(ret.mutable_data(i),
-                     reinterpret_cast<void *>(reshaped_ptrs.at(i)),
-                     ret_dtype.itemsize());
-            else
-              memcpy(ret.mutable_data(i), reshaped_others.data(i),
-                     ret_dtype.itemsize());
+          py::array ret(ret_dtype, shape);
+          if (!other.dtype().equal(ret_dtype))
+            other = other.attr("astype")(ret_dtype);
+          py::array others = py::array::ensure(other, py::array::c_style);
+          if (masks.size() != numel || others.size() != numel)
+            throw std::invalid_argument(
+                "load: pointers, mask and other must have the same shape");
+          const uint64_t *ptrData = ptrs.data();
+          const bool *maskData = masks.data();
+          const void *otherData = others.data();
+          void *retData = ret.mutable_data();
+          size_t itemsize = ret_dtype.itemsize();
+          {
+            py::gil_scoped_release release;
+            load(ptrData, maskData, otherData, retData, numel, itemsize);
           }
-          return ret.reshape(shape);
+          return ret;
         });
 
-  m.def("store", [](py::array_t<uint64_t> ptrs, py::array values,
-                    py::array_t<bool> mask) {
-    int numel = ptrs.size();
-    py::array_t<uint64_t> reshaped_ptrs = ptrs.reshape({numel});
-    py::array_t<int8_t> reshaped_masks = mask.reshape({numel});
-    py::array reshaped_values = values.reshape({numel});
-    for (size_t i = 0; i < ptrs.size(); ++i) {
-      if (reshaped_masks.at(i)) {
-        memcpy(reinterpret_cast<void *>(reshaped_ptrs.mutable_at(i)),
-               reshaped_values.data(i), values.dtype().itemsize());
-      }
-    }
+  m.def("store", [](PtrArray ptrs, py::array values, MaskArray mask) {
+    size_t numel = ptrs.size();
+    py::array contiguousValues =
+        py::array::ensure(values, py::array::c_style);
+    if (mask.size() != numel || contiguousValues.size() != numel)
+      throw std::invalid_argument(
+          "store: pointers, values and mask must have the same shape");
+    const uint64_t *ptrData = ptrs.data();
+    const bool *maskData = mask.data();
+    const void *valueData = contiguousValues.data();
+    size_t itemsize = values.dtype().itemsize();
+    py::gil_scoped_release release;
+    store(ptrData, maskData, valueData, numel, itemsize);
   });
+
+  m.def("atomic_rmw",
+        [](const std::string &opName, PtrArray ptrs, py::array values,
+           MaskArray mask) -> py::array {
+          RMWOp op = getRMWOp(opName);
+          size_t numel = ptrs.size();
+          py::array vals = py::array::ensure(values, py::array::c_style);
+          if (mask.size() != numel || vals.size() != numel)
+            throw std::invalid_argument("atomic_rmw: pointers, values and "
+                                        "mask must have the same shape");
+          auto shape =
+              std::vector<ptrdiff_t>(ptrs.shape(), ptrs.shape() + ptrs.ndim());
+          py::array ret(vals.dtype(), shape);
+          dispatchAtomicType(vals.dtype(), [&](auto type) {
+            using T = decltype(type);
+            const T *valData = static_cast<const T *>(vals.data());
+            T *retData = static_cast<T *>(ret.mutable_data());
+            py::gil_scoped_release release;
+            atomicRMW(op, ptrs.data(), valData, mask.data(), retData, numel);
+          });
+          return ret;
+        });
+
+  m.def("atomic_cas",
+        [](PtrArray ptrs, py::array cmp, py::array values) -> py::array {
+          size_t numel = ptrs.size();
+          py::array vals = py::array::ensure(values, py::array::c_style);
+          py::array cmps = py::array::ensure(
+              cmp.attr("astype")(vals.dtype()), py::array::c_style);
+          if (cmps.size() != numel || vals.size() != numel)
+            throw std::invalid_argument("atomic_cas: pointers, cmp and values "
+                                        "must have the same shape");
+          auto shape =
+              std::vector<ptrdiff_t>(ptrs.shape(), ptrs.shape() + ptrs.ndim());
+          py::array ret(vals.dtype(), shape);
+          dispatchAtomicType(vals.dtype(), [&](auto type) {
+            using T = decltype(type);
+            const T *cmpData = static_cast<const T *>(cmps.data());
+            const T *valData = static_cast<const T *>(vals.data());
+            T *retData = static_cast<T *>(ret.mutable_data());
+            py::gil_scoped_release release;
+            atomicCAS(ptrs.data(), cmpData, valData, retData, numel);
+          });
+          return ret;
+        });
 }
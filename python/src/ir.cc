@@ -10,27 +10,33 @@
 #include "mlir/IR/Verifier.h"
 #include "mlir/Parser/Parser.h"
 #include "mlir/Pass/Pass.h"
+#include "mlir/Pass/PassInstrumentation.h"
 #include "mlir/Pass/PassManager.h"
 #include "mlir/Support/FileUtilities.h"
 #include "mlir/Target/LLVMIR/Dialect/Builtin/BuiltinToLLVMIRTranslation.h"
 #include "mlir/Target/LLVMIR/Dialect/LLVMIR/LLVMToLLVMIRTranslation.h"
 #include "mlir/Transforms/Passes.h"
 #include "triton/Analysis/Allocation.h"
+#include "triton/Analysis/CostModel.h"
+#include "triton/Analysis/RegisterPressure.h"
 #include "triton/Dialect/Triton/IR/Dialect.h"
 #include "triton/Dialect/Triton/IR/Types.h"
 #include "triton/Tools/Sys/GetEnv.hpp"
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
 
+#include <chrono>
+#include <mutex>
+#include <sys/resource.h>
+
 namespace py = pybind11;
 
 // A custom op builder that keeps track of the last location
 class TritonOpBuilder {
 public:
-  TritonOpBuilder(mlir::MLIRContext *context) {
-    builder = std::make_unique<mlir::OpBuilder>(context);
-    lastLoc = std::make_unique<mlir::Location>(builder->getUnknownLoc());
-  }
+  TritonOpBuilder(mlir::MLIRContext *context)
+      : builder(std::make_unique<mlir::OpBuilder>(context)),
+        lastLoc(builder->getUnknownLoc()) {}
 
   mlir::OpBuilder &getBuilder() { return *builder; }
 
@@ -38,17 +44,31 @@ public:
 
   void setLastLoc(mlir::Location loc) {
     if (lineInfoEnabled)
-      lastLoc = std::make_unique<mlir::Location>(loc);
+      lastLoc = loc;
   }
 
   void setLastLoc(const std::string &fileName, int line, int column) {
-    auto context = builder->getContext();
-    setLastLoc(mlir::FileLineColLoc::get(context, fileName, line, column));
+    lastFile = builder->getStringAttr(fileName);
+    setLastLoc(mlir::FileLineColLoc::get(lastFile, line, column));
   }
 
-  mlir::Location getLastLoc() {
-    assert(lastLoc);
-    return *lastLoc;
+  mlir::Location getLastLoc() { return lastLoc; }
+
+  // The code generator saves the location around the visit of each node of
+  // the AST. Both sides are a single call, and the file name is that of the
+  // last location set by name. `pushLoc(line, column)` makes the location of
+  // the node the current one, and the one `popLoc` restores.
+  void pushLoc(int line, int column) {
+    if (lastFile)
+      setLastLoc(mlir::FileLineColLoc::get(lastFile, line, column));
+    locStack.push_back(lastLoc);
+  }
+
+  void pushLoc() { locStack.push_back(lastLoc); }
+
+  void popLoc() {
+    assert(!locStack.empty());
+    setLastLoc(locStack.pop_back_val());
   }
 
   void setInsertionPointToStart(mlir::Block &block) {
@@ -104,7 +124,9 @@ public:
 
 private:
   std::unique_ptr<mlir::OpBuilder> builder;
-  std::unique_ptr<mlir::Location> lastLoc;
+  mlir::Location lastLoc;
+  mlir::StringAttr lastFile;
+  llvm::SmallVector<mlir::Location> locStack;
   bool lineInfoEnabled = !triton::tools::getBoolEnv("TRITON_DISABLE_LINE_INFO");
 };
 
@@ -123,6 +145,103 @@ static void outputWarning(mlir::Location loc, const std::string &msg) {
                /*stack_level=*/2);
 }
 
+// Peak resident set size of the process so far, in bytes.
+static int64_t getPeakRSS() {
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0)
+    return 0;
+  // ru_maxrss is in kilobytes on Linux
+  return static_cast<int64_t>(usage.ru_maxrss) * 1024;
+}
+
+// Wall time spent in each pass run by a pass manager, and the peak resident
+// set size of the process once it completed, in completion order. Passes
+// nested in a pipeline may run concurrently on different functions.
+class PassTimings {
+public:
+  using Clock = std::chrono::steady_clock;
+
+  void start(mlir::Pass *pass, mlir::Operation *op) {
+    std::lock_guard<std::mutex> lock(mutex);
+    starts[{pass, op}] = Clock::now();
+  }
+
+  void stop(mlir::Pass *pass, mlir::Operation *op) {
+    auto end = Clock::now();
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = starts.find({pass, op});
+    if (it == starts.end())
+      return;
+    std::chrono::duration<double> elapsed = end - it->second;
+    starts.erase(it);
+    std::string name = pass->getArgument().str();
+    if (!mlir::isa<mlir::ModuleOp>(op)) {
+      // A pass nested under functions, possibly running on several of them
+      // in parallel: its time is summed over the functions, and reported
+      // once its pipeline adaptor is done.
+      auto nestedIt = llvm::find_if(
+          nested, [&](const auto &entry) { return entry.first == name; });
+      if (nestedIt == nested.end())
+        nested.emplace_back(name, elapsed.count());
+      else
+        nestedIt->second += elapsed.count();
+      return;
+    }
+    if (name.empty()) {
+      for (auto &[nestedName, seconds] : nested) {
+        timings.emplace_back(nestedName, seconds);
+        peakMemory.emplace_back(nestedName, getPeakRSS());
+      }
+      nested.clear();
+      return;
+    }
+    timings.emplace_back(name, elapsed.count());
+    peakMemory.emplace_back(name, getPeakRSS());
+  }
+
+  std::vector<std::pair<std::string, double>> get() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return timings;
+  }
+
+  std::vector<std::pair<std::string, int64_t>> getPeakMemory() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return peakMemory;
+  }
+
+private:
+  std::mutex mutex;
+  std::map<std::pair<mlir::Pass *, mlir::Operation *>, Clock::time_point>
+      starts;
+  std::vector<std::pair<std::string, double>> timings;
+  std::vector<std::pair<std::string, int64_t>> peakMemory;
+  // nested passes of the running pipeline adaptor, in pipeline order
+  std::vector<std::pair<std::string, double>> nested;
+};
+
+class PassTimingInstrumentation : public mlir::PassInstrumentation {
+public:
+  PassTimingInstrumentation(std::shared_ptr<PassTimings> timings)
+      : timings(std::move(timings)) {}
+
+  void runBeforePass(mlir::Pass *pass, mlir::Operation *op) override {
+    // Pipeline adaptors have no argument; their nested passes are reported
+    // individually when the adaptor is done.
+    timings->start(pass, op);
+  }
+
+  void runAfterPass(mlir::Pass *pass, mlir::Operation *op) override {
+    timings->stop(pass, op);
+  }
+
+  void runAfterPassFailed(mlir::Pass *pass, mlir::Operation *op) override {
+    timings->stop(pass, op);
+  }
+
+private:
+  std::shared_ptr<PassTimings> timings;
+};
+
 /*****************************************************************************/
 /* Python bindings for triton::ir                                            */
 /*****************************************************************************/
@@ -165,6 +284,7 @@ void init_triton_ir(py::module &&m) {
       .value("NORMAL", mlir::triton::EvictionPolicy::NORMAL)
       .value("EVICT_FIRST", mlir::triton::EvictionPolicy::EVICT_FIRST)
       .value("EVICT_LAST", mlir::triton::EvictionPolicy::EVICT_LAST)
+      .value("NO_ALLOCATE", mlir::triton::EvictionPolicy::NO_ALLOCATE)
       .export_values();
 
   py::enum_<mlir::triton::RMWOp>(m, "ATOMIC_OP", py::module_local())
@@ -181,14 +301,26 @@ void init_triton_ir(py::module &&m) {
 
   py::enum_<mlir::triton::RoundingMode>(m, "ROUNDING_MODE", py::module_local())
       .value("RTZ", mlir::triton::RoundingMode::RTZ)
-      .value("RTNE", mlir::triton::RoundingMode::RTNE);
+      .value("RTNE", mlir::triton::RoundingMode::RTNE)
+      .value("RS", mlir::triton::RoundingMode::RS);
 
   py::enum_<mlir::triton::PropagateNan>(m, "PROPAGATE_NAN", py::module_local())
       .value("NONE", mlir::triton::PropagateNan::NONE)
       .value("ALL", mlir::triton::PropagateNan::ALL);
 
-  py::class_<mlir::MLIRContext>(m, "context", py::module_local())
-      .def(py::init<>());
+  // dynamic_attr is used by the context pool to keep track of the uses of
+  // the contexts
+  py::class_<mlir::MLIRContext>(m, "context", py::module_local(),
+                                py::dynamic_attr())
+      .def(py::init([]() {
+        // function passes run in parallel over the functions of a module
+        // unless threading is disabled
+        auto threading =
+            ::triton::tools::getBoolEnv("MLIR_DISABLE_MULTITHREADING")
+                ? mlir::MLIRContext::Threading::DISABLED
+                : mlir::MLIRContext::Threading::ENABLED;
+        return std::make_unique<mlir::MLIRContext>(threading);
+      }));
 
   m.def("load_dialects", [](mlir::MLIRContext &context) {
     mlir::DialectRegistry registry;
@@ -388,6 +520,7 @@ void init_triton_ir(py::module &&m) {
   py::class_<mlir::ModuleOp, mlir::OpState>(m, "module", py::module_local(),
                                             py::dynamic_attr())
       .def("dump", &mlir::ModuleOp::dump)
+      .def("erase", [](mlir::ModuleOp &self) { self->erase(); })
       .def("str",
            [](mlir::ModuleOp &self) -> std::string {
              std::string str;
@@ -412,12 +545,98 @@ void init_triton_ir(py::module &&m) {
               std::string &funcName) -> mlir::triton::FuncOp {
              return self.lookupSymbol<mlir::triton::FuncOp>(funcName);
            })
+      // Prints the function alone in a module, with its locations.
+      .def("get_function_src",
+           [](mlir::ModuleOp &self, std::string &funcName) -> std::string {
+             auto func = self.lookupSymbol<mlir::triton::FuncOp>(funcName);
+             if (!func)
+               throw std::runtime_error("No function " + funcName);
+             mlir::OwningOpRef<mlir::ModuleOp> module =
+                 mlir::ModuleOp::create(self.getLoc());
+             module->push_back(func.clone());
+             std::string str;
+             llvm::raw_string_ostream os(str);
+             // the callees of the function are not in `module`
+             auto flags = mlir::OpPrintingFlags().enableDebugInfo();
+             module->print(os, flags.assumeVerified());
+             return str;
+           })
+      // Adds the function printed by `get_function_src`, e.g. in an earlier
+      // compilation in another context. Its callees may not have been added
+      // yet, so it is only verified with the rest of the module.
+      .def("link_function",
+           [](mlir::ModuleOp &self,
+              const std::string &src) -> mlir::triton::FuncOp {
+             mlir::ParserConfig config(self.getContext(),
+                                       /*verifyAfterParse=*/false);
+             mlir::OwningOpRef<mlir::ModuleOp> parsed =
+                 mlir::parseSourceString<mlir::ModuleOp>(src, config);
+             if (!parsed)
+               throw std::runtime_error("Failed to parse a cached function");
+             auto funcs = parsed->getOps<mlir::triton::FuncOp>();
+             if (std::distance(funcs.begin(), funcs.end()) != 1)
+               throw std::runtime_error("Expected a single cached function");
+             mlir::triton::FuncOp func = *funcs.begin();
+             func->remove();
+             self.push_back(func);
+             return func;
+           })
+      // Moves the kernel of `other`, e.g. to fuse it with the kernels of this
+      // module, renamed `name`. Its callees stay in `other`.
+      .def("append_kernel",
+           [](mlir::ModuleOp &self, mlir::ModuleOp &other,
+              const std::string &name) -> void {
+             mlir::triton::FuncOp kernel;
+             for (auto funcOp : other.getOps<mlir::triton::FuncOp>())
+               if (funcOp.isPublic())
+                 kernel = funcOp;
+             if (!kernel)
+               throw std::runtime_error("No kernel in the module");
+             kernel->remove();
+             kernel.setSymName(name);
+             self.push_back(kernel);
+           })
       .def("get_int_attr",
            [](mlir::ModuleOp &self, std::string name) -> py::object {
              auto ret = self->getAttrOfType<mlir::IntegerAttr>(name);
              if (!ret)
                return py::none();
              return py::int_(ret.getInt());
+           })
+      .def("get_str_array_attr",
+           [](mlir::ModuleOp &self, std::string name) -> py::object {
+             auto ret = self->getAttrOfType<mlir::ArrayAttr>(name);
+             if (!ret)
+               return py::none();
+             py::list strs;
+             for (auto str : ret.getAsValueRange<mlir::StringAttr>())
+               strs.append(str.str());
+             return strs;
+           })
+      .def("get_kernel_cost",
+           [](mlir::ModuleOp &self) -> py::object {
+             mlir::ModuleCostAnalysis costAnalysis(self);
+             auto roots = costAnalysis.getRoots();
+             if (roots.empty())
+               return py::none();
+             mlir::KernelCost *cost = costAnalysis.getCost(roots.front());
+             py::dict ret;
+             ret["global_load_bytes"] = cost->globalLoadBytes;
+             ret["global_store_bytes"] = cost->globalStoreBytes;
+             ret["global_load_accesses"] = cost->globalLoadAccesses;
+             ret["global_store_accesses"] = cost->globalStoreAccesses;
+             ret["shared_bytes"] = cost->sharedBytes;
+             ret["bank_conflicts"] = cost->maxBankConflicts;
+             ret["mma_count"] = cost->mmaCount;
+             ret["dot_flops"] = cost->dotFlops;
+             ret["barrier_count"] = cost->barrierCount;
+             ret["dynamic_loops"] = cost->hasDynamicLoops;
+             ret["llvm_size"] = cost->llvmSize;
+             ret["shared_memory"] = costAnalysis.getSharedMemorySize();
+             ret["occupancy"] = costAnalysis.getOccupancy();
+             mlir::RegisterPressureAnalysis pressure(roots.front());
+             ret["registers"] = pressure.getMaxRegisters();
+             return ret;
            });
 
   m.def("make_attr",
@@ -432,20 +651,23 @@ void init_triton_ir(py::module &&m) {
 
   m.def(
       "parse_mlir_module",
-      [](const std::string &inputFilename, mlir::MLIRContext &context) {
+      [](const std::string &inputFilename, mlir::MLIRContext &context,
+         bool keepLocations) {
         // parse module
         mlir::OwningOpRef<mlir::ModuleOp> module =
             mlir::parseSourceFile<mlir::ModuleOp>(inputFilename, &context);
         if (!module)
           throw std::runtime_error("Parse MLIR file failed.");
         // locations are incompatible with ptx < 7.5 !
-        module->walk([](mlir::Operation *op) {
-          op->setLoc(mlir::UnknownLoc::get(op->getContext()));
-        });
+        if (!keepLocations)
+          module->walk([](mlir::Operation *op) {
+            op->setLoc(mlir::UnknownLoc::get(op->getContext()));
+          });
 
         return module->clone();
       },
-      ret::take_ownership);
+      py::arg("input_filename"), py::arg("context"),
+      py::arg("keep_locations") = false, ret::take_ownership);
 
   py::class_<mlir::triton::FuncOp, mlir::OpState>(m, "function",
                                                   py::module_local())
@@ -555,6 +777,10 @@ void init_triton_ir(py::module &&m) {
            [](TritonOpBuilder &self, int32_t value) {
              return self.getBuilder().getI32IntegerAttr(value);
            })
+      .def("get_int64_attr",
+           [](TritonOpBuilder &self, int64_t value) {
+             return self.getBuilder().getI64IntegerAttr(value);
+           })
       // Use arith.ConstantOp to create constants
       // Constants
       .def("get_int1",
@@ -729,6 +955,10 @@ void init_triton_ir(py::module &&m) {
            [](TritonOpBuilder &self) -> mlir::Location {
              return self.getLastLoc();
            })
+      .def("push_loc", [](TritonOpBuilder &self, int line,
+                          int column) { self.pushLoc(line, column); })
+      .def("push_loc", [](TritonOpBuilder &self) { self.pushLoc(); })
+      .def("pop_loc", &TritonOpBuilder::popLoc)
 
       // Ops
       .def("get_or_insert_function",
@@ -841,12 +1071,21 @@ void init_triton_ir(py::module &&m) {
                -> mlir::Value {
              if (roundingMode.has_value())
                return self.create<mlir::triton::FpToFpOp>(
-                   dstType, src,
+                   dstType, src, /*rbits=*/mlir::Value(),
                    mlir::triton::RoundingModeAttr::get(
                        self.getBuilder().getContext(), roundingMode.value()));
              else
                return self.create<mlir::triton::FpToFpOp>(dstType, src);
            })
+      .def("create_stochastic_fp_to_fp",
+           [](TritonOpBuilder &self, mlir::Value &src, mlir::Type &dstType,
+              mlir::Value &rbits) -> mlir::Value {
+             return self.create<mlir::triton::FpToFpOp>(
+                 dstType, src, rbits,
+                 mlir::triton::RoundingModeAttr::get(
+                     self.getBuilder().getContext(),
+                     mlir::triton::RoundingMode::RS));
+           })
       // Conversions for standard LLVM builtin types
       .def("create_bitcast",
            [](TritonOpBuilder &self, mlir::Value &src,
@@ -1249,6 +1488,13 @@ void init_triton_ir(py::module &&m) {
                  ptrs, mask, other.value_or(mlir::Value()), cacheModifier,
                  evictionPolicy, isVolatile);
            })
+      .def("create_prefetch",
+           [](TritonOpBuilder &self, mlir::Value &ptrs,
+              std::optional<mlir::Value> &mask,
+              mlir::triton::EvictionPolicy evictionPolicy) -> void {
+             self.create<mlir::triton::PrefetchOp>(
+                 ptrs, mask.value_or(mlir::Value()), evictionPolicy);
+           })
       .def("create_masked_store",
            [](TritonOpBuilder &self, mlir::Value &ptrs, mlir::Value &val,
               mlir::Value &mask, mlir::triton::CacheModifier cacheModifier,
@@ -1301,6 +1547,17 @@ void init_triton_ir(py::module &&m) {
                  mlir::RankedTensorType::get(shape, aTy.getElementType()), a,
                  b);
            })
+      .def("create_join",
+           [](TritonOpBuilder &self, mlir::Value &a,
+              mlir::Value &b) -> mlir::Value {
+             return self.create<mlir::triton::JoinOp>(a, b);
+           })
+      .def("create_split",
+           [](TritonOpBuilder &self,
+              mlir::Value &a) -> std::tuple<mlir::Value, mlir::Value> {
+             auto op = self.create<mlir::triton::SplitOp>(a);
+             return std::tuple(op->getResult(0), op->getResult(1));
+           })
       .def("create_trans",
            [](TritonOpBuilder &self, mlir::Value &arg) -> mlir::Value {
              auto argType = arg.getType().dyn_cast<mlir::RankedTensorType>();
@@ -1404,6 +1661,14 @@ void init_triton_ir(py::module &&m) {
              return self.create<mlir::triton::DotOp>(
                  c.getType(), a, b, c, allowTF32, maxNumImpreciseAcc);
            })
+      .def("create_dot_scaled",
+           [](TritonOpBuilder &self, mlir::Value &a, mlir::Value &b,
+              mlir::Value &c, mlir::Value &aScale, mlir::Value &bScale,
+              bool allowTF32, int maxNumImpreciseAcc) -> mlir::Value {
+             return self.create<mlir::triton::DotScaledOp>(
+                 c.getType(), a, b, c, aScale, bScale, allowTF32,
+                 maxNumImpreciseAcc);
+           })
       .def("create_exp",
            [](TritonOpBuilder &self, mlir::Value &val) -> mlir::Value {
              return self.create<mlir::math::ExpOp>(val);
@@ -1506,11 +1771,33 @@ void init_triton_ir(py::module &&m) {
                                                  fileNameAttr, funcNameAttr,
                                                  lineNoAttr);
            })
+      .def("create_profile_mark",
+           [](TritonOpBuilder &self, const std::string &name,
+              bool end) -> void {
+             auto &builder = self.getBuilder();
+             self.create<mlir::triton::ProfileMarkOp>(
+                 builder.getStringAttr(name),
+                 end ? builder.getUnitAttr() : mlir::UnitAttr());
+           })
+      .def("create_grid_sync",
+           [](TritonOpBuilder &self) -> void {
+             self.create<mlir::triton::GridSyncOp>();
+           })
       // Undef
       .def("create_undef",
            [](TritonOpBuilder &self, mlir::Type &type) -> mlir::Value {
              return self.create<::mlir::LLVM::UndefOp>(type);
            })
+      .def("create_gather",
+           [](TritonOpBuilder &self, mlir::Value src, mlir::Value indices,
+              int axis) -> mlir::Value {
+             auto srcTy = src.getType().cast<mlir::RankedTensorType>();
+             auto indicesTy = indices.getType().cast<mlir::RankedTensorType>();
+             return self.create<mlir::triton::GatherOp>(
+                 mlir::RankedTensorType::get(indicesTy.getShape(),
+                                             srcTy.getElementType()),
+                 src, indices, axis);
+           })
       .def("create_histogram",
            [](TritonOpBuilder &self, mlir::Value operand,
               int numBins) -> mlir::OpState {
@@ -1520,6 +1807,13 @@ void init_triton_ir(py::module &&m) {
                      mlir::IntegerType::get(operand.getContext(), 32)),
                  operand);
            })
+      .def("create_sort",
+           [](TritonOpBuilder &self, mlir::Value operand, int axis,
+              bool descending) -> mlir::Value {
+             return self.create<mlir::triton::SortOp>(operand.getType(),
+                                                      operand, axis,
+                                                      descending);
+           })
       // Force GPU barrier
       .def("create_barrier",
            [](TritonOpBuilder &self) { self.create<mlir::gpu::BarrierOp>(); })
@@ -1542,22 +1836,40 @@ void init_triton_ir(py::module &&m) {
                                                          offsets);
            });
 
+  py::class_<PassTimings, std::shared_ptr<PassTimings>>(m, "pass_timings",
+                                                       py::module_local())
+      .def("get", &PassTimings::get)
+      .def("get_peak_memory", &PassTimings::getPeakMemory);
+
   py::class_<mlir::PassManager>(m, "pass_manager", py::module_local())
       .def(py::init<mlir::MLIRContext *>())
+      .def("enable_timing",
+           [](mlir::PassManager &self) {
+             auto timings = std::make_shared<PassTimings>();
+             self.addInstrumentation(
+                 std::make_unique<PassTimingInstrumentation>(timings));
+             return timings;
+           })
       .def("enable_debug",
            [](mlir::PassManager &self) {
              auto *context = self.getContext();
-             context->printOpOnDiagnostic(true);
-             context->printStackTraceOnDiagnostic(true);
-             context->disableMultithreading();
-             context->getDiagEngine().registerHandler(
-                 [](mlir::Diagnostic &diag) {
-                   llvm::outs() << diag << "\n";
-                   return mlir::success();
-                 });
+             // contexts are reused across compilations: register the handler
+             // once per context
+             if (!context->shouldPrintOpOnDiagnostic()) {
+               context->printOpOnDiagnostic(true);
+               context->printStackTraceOnDiagnostic(true);
+               context->getDiagEngine().registerHandler(
+                   [](mlir::Diagnostic &diag) {
+                     llvm::outs() << diag << "\n";
+                     return mlir::success();
+                   });
+             }
 
              if (!::triton::tools::getBoolEnv("MLIR_ENABLE_DUMP"))
                return;
+             // printing the whole module around nested passes requires
+             // running them one function at a time
+             context->disableMultithreading();
              auto printingFlags = mlir::OpPrintingFlags();
              printingFlags.elideLargeElementsAttrs(16);
              printingFlags.enableDebugInfo();
@@ -1582,6 +1894,9 @@ void init_triton_ir(py::module &&m) {
           mlir::makeReproducer(anchorName, passes, op, reproducerPath);
         }
 
+        // passes don't call back into Python; let other threads (e.g.
+        // concurrent autotuning compilations) make progress meanwhile
+        py::gil_scoped_release allow_threads;
         if (mlir::failed(self.run(mod.getOperation())))
           throw std::runtime_error("PassManager::run failed");
       });
@@ -3,6 +3,7 @@
 #include "mlir/Target/LLVMIR/ModuleTranslation.h"
 #include "triton/Tools/Sys/GetEnv.hpp"
 #include "llvm/ADT/SmallVector.h"
+#include "llvm/Bitcode/BitcodeReader.h"
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/LegacyPassManager.h"
 #include "llvm/IR/Module.h"
@@ -15,10 +16,13 @@
 #include "llvm/Passes/OptimizationLevel.h"
 #include "llvm/Passes/PassBuilder.h"
 #include "llvm/Support/CodeGen.h"
+#include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/TargetSelect.h"
 #include "llvm/Target/TargetMachine.h"
 #include "llvm/Transforms/IPO/AlwaysInliner.h"
 #include "llvm/Transforms/InstCombine/InstCombine.h"
+#include <map>
+#include <mutex>
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
 
@@ -92,6 +96,52 @@ std::string translateLLVMIRToASM(llvm::Module &module,
   return result;
 }
 
+// The contents of the external libraries, read once per process. Each kernel
+// has its own LLVM context, so the modules of the libraries are not shared,
+// but they are loaded lazily from these buffers: only the bodies of the
+// functions the kernel needs are materialized by the linker.
+static llvm::MemoryBufferRef getExternLibBuffer(const std::string &path) {
+  static std::mutex mutex;
+  static std::map<std::string, std::unique_ptr<llvm::MemoryBuffer>> buffers;
+  std::lock_guard<std::mutex> lock(mutex);
+  auto &buffer = buffers[path];
+  if (!buffer) {
+    auto fileOrErr = llvm::MemoryBuffer::getFile(path);
+    if (!fileOrErr) {
+      buffers.erase(path);
+      return llvm::MemoryBufferRef();
+    }
+    buffer = std::move(*fileOrErr);
+  }
+  return buffer->getMemBufferRef();
+}
+
+static std::unique_ptr<llvm::Module> loadExternLib(const std::string &path,
+                                                   llvm::LLVMContext &ctx) {
+  llvm::MemoryBufferRef buffer = getExternLibBuffer(path);
+  if (!buffer.getBufferStart())
+    return nullptr;
+  auto start = reinterpret_cast<const unsigned char *>(buffer.getBufferStart());
+  if (!llvm::isBitcode(start, start + buffer.getBufferSize())) {
+    llvm::SMDiagnostic err;
+    return llvm::parseIR(buffer, err, ctx);
+  }
+  auto modOrErr = llvm::getLazyBitcodeModule(buffer, ctx);
+  if (!modOrErr) {
+    llvm::consumeError(modOrErr.takeError());
+    return nullptr;
+  }
+  return std::move(*modOrErr);
+}
+
+// Whether the module calls functions it doesn't define, other than intrinsics
+static bool hasExternalCalls(llvm::Module &mod) {
+  for (llvm::Function &fn : mod)
+    if (fn.isDeclaration() && !fn.isIntrinsic() && !fn.use_empty())
+      return true;
+  return false;
+}
+
 using ret = py::return_value_policy;
 
 void init_triton_llvm(py::module &&m) {
@@ -147,51 +197,67 @@ void init_triton_llvm(py::module &&m) {
   m.def(
       "to_module",
       [](mlir::ModuleOp &mod, llvm::LLVMContext &ctx) {
+        py::gil_scoped_release allow_threads;
         return mlir::translateModuleToLLVMIR(mod, ctx);
       },
       py::keep_alive<0, 2>());
 
-  m.def("optimize_module", [](llvm::Module *mod,
-                              const llvm::OptimizationLevel &opt) {
-    if (triton::tools::getBoolEnv("DISABLE_LLVM_OPT"))
-      return;
-    using namespace llvm;
-    LoopAnalysisManager lam;
-    FunctionAnalysisManager fam;
-    CGSCCAnalysisManager cgam;
-    ModuleAnalysisManager mam;
-    PipelineTuningOptions tuningOptions;
-    tuningOptions.LoopUnrolling = true;
-    tuningOptions.LoopInterleaving = true;
-    tuningOptions.LoopVectorization = true;
-    // TODO: currently we run SLP vectorizer with an empty target machine. This
-    // cause the vectorizer to create larger vector which could be bad.
-    // Disabling it would currently cause regressions as this pass also applies
-    // some scheduling that helps performance in some cases. We should work on
-    // using NVPTX target instead and address the performance regressions with
-    // some scheduling solution.
-    tuningOptions.SLPVectorization = true;
-
-    PassBuilder pb(nullptr /*targetMachine*/, tuningOptions);
-
-    pb.registerModuleAnalyses(mam);
-    pb.registerCGSCCAnalyses(cgam);
-    pb.registerFunctionAnalyses(fam);
-    pb.registerLoopAnalyses(lam);
-    pb.crossRegisterProxies(lam, fam, cgam, mam);
-
-    ModulePassManager mpm;
-    pb.registerVectorizerStartEPCallback(
-        [&](llvm::FunctionPassManager &fpm, llvm::OptimizationLevel level) {
-          // Triton generates large structure of scalars which may pessimise
-          // optimizations, we run a pass to break up phi of struct to make sure
-          // all the struct are removed for the following passes.
-          fpm.addPass(BreakStructPhiNodesPass());
-          fpm.addPass(InstCombinePass());
-        });
-    mpm.addPass(pb.buildPerModuleDefaultPipeline(opt));
-    mpm.run(*mod, mam);
-  });
+  // `pipeline` is run after the default pipeline of `opt`, in the textual
+  // format of `opt -passes`, e.g. "function(loop-unroll<O3>)"
+  m.def(
+      "optimize_module",
+      [](llvm::Module *mod, const llvm::OptimizationLevel &opt,
+         const std::string &pipeline) {
+        if (triton::tools::getBoolEnv("DISABLE_LLVM_OPT"))
+          return;
+        using namespace llvm;
+        LoopAnalysisManager lam;
+        FunctionAnalysisManager fam;
+        CGSCCAnalysisManager cgam;
+        ModuleAnalysisManager mam;
+        PipelineTuningOptions tuningOptions;
+        tuningOptions.LoopUnrolling = true;
+        tuningOptions.LoopInterleaving = true;
+        tuningOptions.LoopVectorization = true;
+        // TODO: currently we run SLP vectorizer with an empty target machine.
+        // This cause the vectorizer to create larger vector which could be bad.
+        // Disabling it would currently cause regressions as this pass also
+        // applies some scheduling that helps performance in some cases. We
+        // should work on using NVPTX target instead and address the performance
+        // regressions with some scheduling solution.
+        tuningOptions.SLPVectorization = true;
+
+        PassBuilder pb(nullptr /*targetMachine*/, tuningOptions);
+
+        pb.registerModuleAnalyses(mam);
+        pb.registerCGSCCAnalyses(cgam);
+        pb.registerFunctionAnalyses(fam);
+        pb.registerLoopAnalyses(lam);
+        pb.crossRegisterProxies(lam, fam, cgam, mam);
+
+        ModulePassManager mpm;
+        pb.registerVectorizerStartEPCallback(
+            [&](llvm::FunctionPassManager &fpm, llvm::OptimizationLevel level) {
+              // Triton generates large structure of scalars which may pessimise
+              // optimizations, we run a pass to break up phi of struct to make
+              // sure all the struct are removed for the following passes.
+              fpm.addPass(BreakStructPhiNodesPass());
+              fpm.addPass(InstCombinePass());
+            });
+        if (opt == llvm::OptimizationLevel::O0)
+          mpm.addPass(pb.buildO0DefaultPipeline(opt));
+        else
+          mpm.addPass(pb.buildPerModuleDefaultPipeline(opt));
+        if (!pipeline.empty()) {
+          if (auto err = pb.parsePassPipeline(mpm, pipeline))
+            throw std::invalid_argument("invalid LLVM pass pipeline \"" +
+                                        pipeline +
+                                        "\": " + toString(std::move(err)));
+        }
+        py::gil_scoped_release allow_threads;
+        mpm.run(*mod, mam);
+      },
+      py::arg("mod"), py::arg("opt"), py::arg("pipeline") = "");
 
   m.def(
       "translate_to_asm",
@@ -232,9 +298,9 @@ void init_triton_llvm(py::module &&m) {
   });
 
   m.def("link_extern_lib", [](llvm::Module *mod, std::string path) {
-    llvm::SMDiagnostic err;
-    auto &ctx = mod->getContext();
-    auto extMod = llvm::parseIRFile(path, err, ctx);
+    if (!hasExternalCalls(*mod))
+      return;
+    auto extMod = loadExternLib(path, mod->getContext());
     if (!extMod) {
       llvm::errs() << "Failed to load " << path;
       return;
@@ -10,6 +10,7 @@
 #include "triton/Dialect/TritonGPU/Transforms/Passes.h"
 #include "triton/Target/LLVMIR/Passes.h"
 #include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
 
 namespace py = pybind11;
 
@@ -37,6 +38,15 @@ void init_triton_passes_ttir(py::module &&m) {
   ADD_PASS_WRAPPER_0("add_reorder_broadcast", createReorderBroadcastPass);
   ADD_PASS_WRAPPER_0("add_rewrite_tensor_pointer",
                      createRewriteTensorPointerPass);
+  ADD_PASS_WRAPPER_1("add_specialize_calls", createSpecializeCallsPass, int);
+  ADD_PASS_WRAPPER_1("add_split_k", createSplitKPass, int);
+  ADD_PASS_WRAPPER_2("add_make_persistent", createMakePersistentPass, int,
+                     int);
+  ADD_PASS_WRAPPER_1("add_fuse_kernels", createFuseKernelsPass,
+                     const std::string &);
+  ADD_PASS_WRAPPER_1("add_narrow_offsets", createNarrowOffsetsPass, int64_t);
+  ADD_PASS_WRAPPER_0("add_strength_reduce_pointers",
+                     createStrengthReducePointersPass);
   ADD_PASS_WRAPPER_4("add_convert_to_ttgpuir",
                      createConvertTritonToTritonGPUPass, int, int, int, int);
 }
@@ -46,16 +56,24 @@ void init_triton_passes_ttgpuir(py::module &&m) {
   ADD_PASS_WRAPPER_0("add_coalesce", createCoalescePass);
   ADD_PASS_WRAPPER_0("add_optimize_thread_locality",
                      createOptimizeThreadLocalityPass);
-  ADD_PASS_WRAPPER_4("add_pipeline", createPipelinePass, int, int, int, int);
+  ADD_PASS_WRAPPER_0("add_peel_masked_tail", createPeelMaskedTailPass);
+  ADD_PASS_WRAPPER_0("add_hoist_invariant_loads",
+                     createHoistInvariantLoadsPass);
+  ADD_PASS_WRAPPER_0("add_instrument_branches", createInstrumentBranchesPass);
+  ADD_PASS_WRAPPER_1("add_apply_branch_profile", createApplyBranchProfilePass,
+                     std::vector<int64_t>);
+  ADD_PASS_WRAPPER_5("add_pipeline", createPipelinePass, int, int, int, int,
+                     bool);
   ADD_PASS_WRAPPER_0("add_prefetch", createPrefetchPass);
   ADD_PASS_WRAPPER_1("add_accelerate_matmul", createAccelerateMatmulPass, int);
-  ADD_PASS_WRAPPER_0("add_reorder_instructions", createReorderInstructionsPass);
+  ADD_FUNC_PASS_WRAPPER_1("add_reorder_instructions",
+                          createReorderInstructionsPass, bool);
   ADD_PASS_WRAPPER_0("add_optimize_dot_operands",
                      createOptimizeDotOperandsPass);
-  ADD_PASS_WRAPPER_0("add_remove_layout_conversions",
-                     createRemoveLayoutConversionsPass);
-  ADD_PASS_WRAPPER_0("add_decompose_conversions",
-                     createDecomposeConversionsPass);
+  ADD_FUNC_PASS_WRAPPER_1("add_remove_layout_conversions",
+                          createRemoveLayoutConversionsPass, bool);
+  ADD_FUNC_PASS_WRAPPER_0("add_decompose_conversions",
+                          createDecomposeConversionsPass);
 }
 
 void init_triton_passes_convert(py::module &&m) {
@@ -18,3 +18,21 @@
 #define ADD_PASS_WRAPPER_4(name, builder, ty0, ty1, ty2, ty3)                  \
   m.def(name, [](mlir::PassManager &pm, ty0 val0, ty1 val1, ty2 val2,          \
                  ty3 val3) { pm.addPass(builder(val0, val1, val2, val3)); })
+
+#define ADD_PASS_WRAPPER_5(name, builder, ty0, ty1, ty2, ty3, ty4)             \
+  m.def(name, [](mlir::PassManager &pm, ty0 val0, ty1 val1, ty2 val2,          \
+                 ty3 val3, ty4 val4) {                                         \
+    pm.addPass(builder(val0, val1, val2, val3, val4));                         \
+  })
+
+// Function passes are nested under each `tt.func`, so that the pass manager
+// can run them on several functions in parallel
+#define ADD_FUNC_PASS_WRAPPER_0(name, builder)                                 \
+  m.def(name, [](mlir::PassManager &pm) {                                      \
+    pm.addNestedPass<mlir::triton::FuncOp>(builder());                         \
+  })
+
+#define ADD_FUNC_PASS_WRAPPER_1(name, builder, ty0)                            \
+  m.def(name, [](mlir::PassManager &pm, ty0 val0) {                            \
+    pm.addNestedPass<mlir::triton::FuncOp>(builder(val0));                     \
+  })
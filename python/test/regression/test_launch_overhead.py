@@ -0,0 +1,179 @@
+"""
+Host-side launch overhead of Triton kernels, in µs per launch.
+
+Every case launches an empty (or nearly empty) kernel in a loop and measures
+the host time it takes, so that it tracks the cost of `JITFunction.run`, the
+launcher and the launch hooks rather than the kernel itself. Results are
+printed, and appended as JSON lines to the file named by
+`TRITON_LAUNCH_OVERHEAD_OUTPUT` (or `--output` when run as a script) so that
+they can be tracked over time:
+
+    pytest python/test/regression/test_launch_overhead.py -s
+    python python/test/regression/test_launch_overhead.py --output overhead.jsonl
+"""
+
+import importlib.util
+import json
+import os
+import statistics
+import tempfile
+import textwrap
+import time
+
+import pytest
+import torch
+
+import triton
+import triton.language as tl
+from triton.compiler import CompiledKernel
+
+NUM_LAUNCHES = 1000
+NUM_ROUNDS = 5
+
+#######################
+# Kernels
+#######################
+
+
+def make_empty_kernel(num_args, num_constexprs=0):
+    # `triton.jit` needs the source of the kernel, so it can't be built with `exec`
+    args = [f"arg{i}" for i in range(num_args)] + [f"C{i}: tl.constexpr" for i in range(num_constexprs)]
+    src = f"""
+    import triton
+    import triton.language as tl
+
+    @triton.jit
+    def kernel({", ".join(args)}):
+        pass
+    """
+    path = os.path.join(tempfile.mkdtemp(), f"empty_{num_args}_{num_constexprs}.py")
+    with open(path, "w") as f:
+        f.write(textwrap.dedent(src))
+    spec = importlib.util.spec_from_file_location(f"empty_{num_args}_{num_constexprs}", path)
+    module = importlib.util.module_from_spec(spec)
+    spec.loader.exec_module(module)
+    return module.kernel
+
+
+@triton.autotune(configs=[triton.Config({'BLOCK': 128}), triton.Config({'BLOCK': 256})], key=['n'])
+@triton.jit
+def autotuned_kernel(x_ptr, n, BLOCK: tl.constexpr):
+    pass
+
+
+@triton.jit
+def block_ptr_kernel(x_ptr, M, N, stride_m, stride_n, BLOCK_M: tl.constexpr, BLOCK_N: tl.constexpr):
+    x_block = tl.make_block_ptr(base=x_ptr, shape=(M, N), strides=(stride_m, stride_n), offsets=(0, 0),
+                                block_shape=(BLOCK_M, BLOCK_N), order=(1, 0))
+    tl.store(x_block, tl.load(x_block))
+
+
+#######################
+# Cases
+#######################
+
+
+def case_empty(num_args):
+    kernel = make_empty_kernel(num_args)
+    args = [torch.empty(16, device='cuda') for _ in range(num_args)]
+    return lambda: kernel[(1, )](*args)
+
+
+def case_constexprs():
+    kernel = make_empty_kernel(1, num_constexprs=16)
+    x = torch.empty(16, device='cuda')
+    constexprs = {f"C{i}": i for i in range(16)}
+    return lambda: kernel[(1, )](x, **constexprs)
+
+
+def noop_hook(*args):
+    pass
+
+
+def case_autotuned():
+    x = torch.empty(1024, device='cuda')
+    return lambda: autotuned_kernel[(1, )](x, x.numel())
+
+
+def case_block_ptr():
+    # Lowered to TMA on Hopper
+    if torch.cuda.get_device_capability()[0] < 9:
+        pytest.skip("block pointers are only lowered to TMA on Hopper")
+    x = torch.empty((64, 64), device='cuda')
+    return lambda: block_ptr_kernel[(1, )](x, 64, 64, x.stride(0), x.stride(1), BLOCK_M=64, BLOCK_N=64)
+
+
+#######################
+# Measurement
+#######################
+
+
+def launch_overhead_us(launch, hooks=None):
+    """
+    Returns the median host time of `launch`, in µs, over `NUM_ROUNDS` rounds
+    of `NUM_LAUNCHES` launches. `hooks` are installed as the launch enter and
+    exit hooks while measuring.
+    """
+    # compile, and tune the autotuned kernels
+    launch()
+    torch.cuda.synchronize()
+    saved = (CompiledKernel.launch_enter_hook, CompiledKernel.launch_exit_hook)
+    if hooks is not None:
+        CompiledKernel.launch_enter_hook = CompiledKernel.launch_exit_hook = hooks
+    try:
+        rounds = []
+        for _ in range(NUM_ROUNDS):
+            start = time.perf_counter()
+            for _ in range(NUM_LAUNCHES):
+                launch()
+            rounds.append((time.perf_counter() - start) / NUM_LAUNCHES * 1e6)
+            # don't let the launch queue fill up
+            torch.cuda.synchronize()
+    finally:
+        CompiledKernel.launch_enter_hook, CompiledKernel.launch_exit_hook = saved
+    return statistics.median(rounds)
+
+
+def report(name, us, output=None):
+    print(f"{name}: {us:.2f} us/launch")
+    output = output or os.environ.get("TRITON_LAUNCH_OVERHEAD_OUTPUT")
+    if not output:
+        return
+    result = {
+        "name": name, "us_per_launch": us, "time": time.time(), "triton": triton.__version__, "device":
+        torch.cuda.get_device_name(), "num_launches": NUM_LAUNCHES
+    }
+    with open(output, "a") as f:
+        f.write(json.dumps(result) + "\n")
+
+
+def run_case(name, output=None):
+    if name == "hooks":
+        us = launch_overhead_us(case_empty(8), hooks=noop_hook)
+    elif name.startswith("empty_"):
+        us = launch_overhead_us(case_empty(int(name[len("empty_"):])))
+    else:
+        us = launch_overhead_us(globals()[f"case_{name}"]())
+    report(name, us, output)
+    return us
+
+
+CASES = ["empty_1", "empty_8", "empty_32", "constexprs", "hooks", "autotuned", "block_ptr"]
+
+
+@pytest.mark.parametrize("name", CASES)
+def test_launch_overhead(name):
+    assert run_case(name) > 0
+
+
+if __name__ == "__main__":
+    from argparse import ArgumentParser
+
+    parser = ArgumentParser(description="Measure the host-side launch overhead of Triton kernels")
+    parser.add_argument("--output", "-o", type=str, default=None, help="Append the results to this JSON lines file")
+    parser.add_argument("cases", nargs="*", default=CASES, help=f"Cases to run (default: {' '.join(CASES)})")
+    args = parser.parse_args()
+    for name in args.cases:
+        if name == "block_ptr" and torch.cuda.get_device_capability()[0] < 9:
+            continue
+        run_case(name, args.output)
@@ -254,8 +254,8 @@ def upcast_test(src_dtype, dst_dtype, exponent_bits, mantissa_bits, exponent_bia
 ])
 def test_typeconvert_upcast(src_dtype, dst_dtype):
 
-    if src_dtype == 'float8e4nv' and torch.cuda.get_device_capability(0) < (9, 0):
-        pytest.skip("float8e4nv upcast tests only supported on compute capability 9.0+")
+    if src_dtype == 'float8e4nv' and torch.cuda.get_device_capability(0) < (8, 0):
+        pytest.skip("float8e4nv upcast tests only supported on compute capability 8.0+")
 
     # dtype : (exponent_bits, mantissa_bits, exponent_bias, max_repr)
     stuff = {
@@ -268,6 +268,19 @@ def test_typeconvert_upcast(src_dtype, dst_dtype):
 
     upcast_test(getattr(tl, src_dtype), getattr(tl, dst_dtype), *stuff)
 
+# The upcasts of float8e4nv are emulated before sm89, 0x7f and 0xff are its NaNs
+@pytest.mark.parametrize("dst_dtype", ['float16', 'bfloat16'])
+def test_typeconvert_upcast_float8e4nv_nan(dst_dtype):
+
+    if torch.cuda.get_device_capability(0) < (8, 0):
+        pytest.skip("float8e4nv upcast tests only supported on compute capability 8.0+")
+
+    src = torch.tensor([0x7f, -0x01, 0x7e, -0x02], dtype=torch.int8, device='cuda').repeat(1024)
+    dst = launch_type_convert_triton(src, tl.float8e4nv, getattr(tl, dst_dtype))
+    dst = dst.view(getattr(torch, dst_dtype)).float().view(-1, 4)
+    assert torch.all(dst[:, :2].isnan())
+    assert torch.all(dst[:, 2] == 448) and torch.all(dst[:, 3] == -448)
+
 @pytest.mark.parametrize("src_dtype, dst_dtype, rounding, max_repr", [
     ('float32', 'float16', 'rtne', 0x477fe000),
     ('float32', 'float16', 'rtz', 0x477fe000),
@@ -303,3 +316,30 @@ def test_typeconvert_downcast(src_dtype, dst_dtype, rounding, max_repr):
 
     for i in range(256):
         downcast_test(getattr(tl, src_dtype), getattr(tl, dst_dtype), rounding, *stuff, max_repr, i)
+
+@pytest.mark.parametrize("src_dtype, dst_dtype, mantissa_bits", [
+    ('float32', 'float16', 10),
+    ('float32', 'bfloat16', 7),
+    ('float32', 'float8e5', 2),
+    ('float16', 'float8e5', 2),
+])
+def test_typeconvert_downcast_stochastic(src_dtype, dst_dtype, mantissa_bits):
+
+    @triton.jit
+    def stochastic_cast_kernel(src, dst, seed, DST_TYPE: tl.constexpr, N: tl.constexpr):
+        offs = tl.arange(0, N)
+        x = tl.load(src + offs)
+        y = x.to(DST_TYPE, fp_downcast_rounding='rs', rbits=tl.randint(seed, offs))
+        tl.store(dst + offs, y.to(tl.float32))
+
+    # A quarter of the way between the two closest values of the destination
+    # type, 1 and 1 + ulp, which are the only two results
+    N = 1 << 16
+    ulp = 2.0 ** -mantissa_bits
+    src = torch.full((N, ), 1 + ulp / 4, dtype=getattr(torch, src_dtype), device='cuda')
+    dst = torch.empty((N, ), dtype=torch.float32, device='cuda')
+    stochastic_cast_kernel[(1, )](src, dst, 42, getattr(tl, dst_dtype), N)
+    assert torch.all((dst == 1) | (dst == 1 + ulp))
+    # Unbiased: the number of round-ups is within 4 standard deviations of N/4
+    rounded_up = (dst == 1 + ulp).sum().item()
+    assert abs(rounded_up - N / 4) < 4 * (N * 3 / 16) ** 0.5
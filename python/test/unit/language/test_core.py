@@ -825,6 +825,43 @@ def test_math_op(dtype_x, expr, device, x):
     _test_unary(dtype_x, f'tl.{expr}({x})', f'np.{expr}({x}) ', device=device)
 
 
+@pytest.mark.parametrize("expr, np_expr, instr", [
+    ('tl.log(x)', 'np.log(x)', 'lg2.approx.f32'),
+    ('tl.sin(x)', 'np.sin(x)', 'sin.approx.f32'),
+    ('tl.cos(x)', 'np.cos(x)', 'cos.approx.f32'),
+    ('tl.math.rsqrt(x)', '1 / np.sqrt(x)', 'rsqrt.approx.f32'),
+    ('tl.math.tanh(x)', 'np.tanh(x)', 'tanh.approx.f32'),
+    ('tl.sigmoid(x)', '1 / (1 + np.exp(-x))', 'div.approx.f32'),
+])
+def test_fast_math(expr, np_expr, instr, device):
+    if is_hip():
+        pytest.skip("fast_math is only supported on CUDA")
+    if instr == 'tanh.approx.f32' and torch.cuda.get_device_capability() < (7, 5):
+        pytest.skip("tanh.approx needs sm75")
+
+    @triton.jit
+    def kernel(X, Z, SIZE: tl.constexpr):
+        off = tl.arange(0, SIZE)
+        x = tl.load(X + off)
+        z = GENERATE_TEST_HERE
+        tl.store(Z + off, z)
+
+    kernel = patch_kernel(kernel, {'GENERATE_TEST_HERE': expr})
+    # in [0.5, 2] and [-pi, pi], where the bounds of the approximations hold
+    rs = RandomState(17)
+    x = rs.uniform(0.5, 2, 128).astype(np.float32)
+    if expr in ('tl.sin(x)', 'tl.cos(x)'):
+        x = rs.uniform(-np.pi, np.pi, 128).astype(np.float32)
+    z_ref = eval(np_expr)
+    x_tri = to_triton(x, device=device)
+    z_tri = to_triton(np.empty_like(z_ref), device=device)
+    h = kernel[(1, )](x_tri, z_tri, SIZE=128, fast_math=True)
+    assert instr in h.asm["ptx"]
+    # tanh.approx has 2^-11 relative error, the others about 2^-20
+    rtol = 1e-3 if instr == 'tanh.approx.f32' else 1e-5
+    np.testing.assert_allclose(z_ref, to_numpy(z_tri), rtol=rtol, atol=1e-6)
+
+
 # ----------------
 # test abs
 # ----------------
@@ -1155,7 +1192,9 @@ def test_atomic_rmw(op, dtype_x_str, mode, sem, device):
     if is_hip():
         return
 
-    assert f"atom.global.gpu.{sem_str}" in h.asm["ptx"]
+    # The old value is unused, relaxed and release atomics are reductions
+    inst = "red" if sem_str in ["relaxed", "release"] else "atom"
+    assert f"{inst}.global.gpu.{sem_str}" in h.asm["ptx"]
 
 
 @pytest.mark.parametrize("num_ctas", num_ctas_list)
@@ -1230,6 +1269,27 @@ def test_tensor_atomic_rmw_block(num_ctas, device):
     assert torch.min(x).item() == 0.0
 
 
+@pytest.mark.parametrize("dtype_str", ['int32', 'float32'])
+def test_atomic_add_aggregate(dtype_str, device):
+    check_cuda_only(device)
+
+    @triton.jit
+    def kernel(X, Hist, N: tl.constexpr, NUM_BINS: tl.constexpr):
+        x = tl.load(X + tl.arange(0, N))
+        bins = x % NUM_BINS
+        tl.atomic_add(Hist + bins, tl.full([N], 1, Hist.dtype.element_ty), aggregate=True)
+
+    rs = RandomState(17)
+    x = rs.randint(0, 1024, size=(1024, )).astype('int32')
+    x_tri = to_triton(x, device=device)
+    hist_tri = to_triton(np.zeros((8, ), dtype=dtype_str), device=device)
+    h = kernel[(1, )](x_tri, hist_tri, N=1024, NUM_BINS=8)
+    hist_ref = np.bincount(x % 8, minlength=8).astype(dtype_str)
+    np.testing.assert_equal(hist_ref, to_numpy(hist_tri))
+    if torch.cuda.get_device_capability()[0] >= 7:
+        assert "match.any.sync.b64" in h.asm["ptx"]
+
+
 @pytest.mark.parametrize("sem", [None, 'acquire', 'release', 'acq_rel', 'relaxed'])
 @pytest.mark.parametrize("num_ctas", num_ctas_list)
 def test_atomic_cas(sem, num_ctas, device):
@@ -1266,6 +1326,39 @@ def test_atomic_cas(sem, num_ctas, device):
     assert f"atom.global.{sem_str}" in h.asm["ptx"]
 
 
+def test_grid_sync(device):
+    if is_hip():
+        pytest.skip("tl.grid_sync is only supported on NVIDIA GPUs")
+
+    @triton.jit
+    def rotate(X, Y, BLOCK: tl.constexpr):
+        pid = tl.program_id(0)
+        num_programs = tl.num_programs(0)
+        offsets = tl.arange(0, BLOCK)
+        tl.store(X + pid * BLOCK + offsets, pid + offsets)
+        tl.grid_sync()
+        # written by another program before the synchronization
+        x = tl.load(X + ((pid + 1) % num_programs) * BLOCK + offsets)
+        tl.grid_sync()
+        tl.store(X + pid * BLOCK + offsets, x)
+        tl.grid_sync()
+        tl.store(Y + pid * BLOCK + offsets, tl.load(X + ((pid + 1) % num_programs) * BLOCK + offsets))
+
+    BLOCK = 128
+    num_programs = torch.cuda.get_device_properties(device).multi_processor_count
+    x = torch.empty((num_programs, BLOCK), device=device, dtype=torch.int32)
+    y = torch.empty_like(x)
+    # the counter is reused by the synchronizations and the launches
+    for _ in range(2):
+        h = rotate[(num_programs, )](x, y, BLOCK=BLOCK)
+        pids = torch.arange(num_programs, device=device, dtype=torch.int32)[:, None]
+        ref = (pids + 2) % num_programs + torch.arange(BLOCK, device=device, dtype=torch.int32)
+        torch.testing.assert_close(y, ref)
+    assert h.metadata.cooperative
+    with pytest.raises(RuntimeError, match="tl.grid_sync"):
+        rotate[(h.max_resident_programs() + 1, )](x, y, BLOCK=BLOCK)
+
+
 @pytest.mark.parametrize("sem", [None, 'acquire', 'release', 'acq_rel', 'relaxed'])
 @pytest.mark.parametrize("num_ctas", num_ctas_list)
 def test_tensor_atomic_cas(sem, num_ctas, device):
@@ -1473,6 +1566,96 @@ def test_interleave_with_mma(device):
     torch.testing.assert_close(z, z_ref)
 
 
+def test_join(device):
+
+    @triton.jit
+    def kernel(X, Y, Z, N: tl.constexpr):
+        offs = tl.arange(0, N)
+        x = tl.load(X + offs)
+        y = tl.load(Y + offs)
+        z = tl.join(x, y)
+        tl.store(Z + offs[:, None] * 2 + tl.arange(0, 2)[None, :], z)
+
+    x = torch.arange(0, 128, device=device).to(torch.int32)
+    y = torch.arange(-128, 0, device=device).to(torch.int32)
+    z_ref = torch.stack([x, y], dim=-1)
+    z = torch.zeros_like(z_ref)
+    kernel[(1, )](x, y, z, N=128)
+
+    np.testing.assert_equal(to_numpy(z_ref), to_numpy(z))
+
+
+def test_split(device):
+
+    @triton.jit
+    def kernel(X, Z1, Z2, N: tl.constexpr):
+        offs = tl.arange(0, N)
+        x = tl.load(X + offs)
+        x1 = tl.reshape(x, (N // 2, 2))
+        z1, z2 = tl.split(x1)
+        tl.store(Z1 + tl.arange(0, N // 2), z1)
+        tl.store(Z2 + tl.arange(0, N // 2), z2)
+
+    x = torch.arange(0, 256, device=device).to(torch.int32).reshape((128, 2))
+    z1_ref, z2_ref = (x[:, 0], x[:, 1])
+    z1 = torch.zeros_like(z1_ref)
+    z2 = torch.zeros_like(z2_ref)
+    kernel[(1, )](x, z1, z2, N=256)
+
+    np.testing.assert_equal(to_numpy(z1_ref), to_numpy(z1))
+    np.testing.assert_equal(to_numpy(z2_ref), to_numpy(z2))
+
+
+@pytest.mark.parametrize("M, N", [(32, 16), (64, 32)])
+def test_join_split_roundtrip(M, N, device):
+    # Rotates (re, im) pairs the way rotary embeddings do, without leaving the
+    # registers.
+
+    @triton.jit
+    def kernel(X, Z, M: tl.constexpr, N: tl.constexpr):
+        offs = tl.arange(0, M)[:, None] * N + tl.arange(0, N)[None, :]
+        x = tl.load(X + offs)
+        re, im = tl.split(tl.reshape(x, (M, N // 2, 2)))
+        z = tl.interleave(-im, re)
+        tl.store(Z + offs, z)
+
+    x = torch.randn((M, N), device=device, dtype=torch.float32)
+    pairs = x.reshape((M, N // 2, 2))
+    z_ref = torch.stack([-pairs[..., 1], pairs[..., 0]], dim=-1).reshape((M, N))
+    z = torch.empty_like(x)
+    kernel[(1, )](x, z, M, N)
+
+    torch.testing.assert_close(z, z_ref)
+
+
+@pytest.mark.parametrize("src_shape, index_shape, axis", [
+    ([16], [128], 0),
+    ([64, 16], [64, 32], 1),
+    ([32, 8], [64, 8], 0),
+    ([128, 4], [128, 4], 0),
+])
+def test_gather(src_shape, index_shape, axis, device):
+
+    @triton.jit
+    def kernel(Src, Index, Out, SRC_ROWS: tl.constexpr, SRC_COLS: tl.constexpr, ROWS: tl.constexpr,
+               COLS: tl.constexpr, AXIS: tl.constexpr):
+        if COLS == 1:
+            src = tl.load(Src + tl.arange(0, SRC_ROWS))
+            offs = tl.arange(0, ROWS)
+        else:
+            src = tl.load(Src + tl.arange(0, SRC_ROWS)[:, None] * SRC_COLS + tl.arange(0, SRC_COLS)[None, :])
+            offs = tl.arange(0, ROWS)[:, None] * COLS + tl.arange(0, COLS)[None, :]
+        index = tl.load(Index + offs)
+        tl.store(Out + offs, tl.gather(src, index, AXIS))
+
+    src = torch.randn(src_shape, device=device)
+    index = torch.randint(0, src_shape[axis], index_shape, device=device, dtype=torch.int32)
+    out = torch.empty(index_shape, device=device)
+    shape2d = lambda shape: (shape[0], shape[1] if len(shape) > 1 else 1)
+    kernel[(1, )](src, index, out, *shape2d(src_shape), *shape2d(index_shape), axis)
+    torch.testing.assert_close(out, torch.gather(src, axis, index.to(torch.int64)))
+
+
 def convert_float_to_float32(fp: torch.tensor, dtype=None):
     if not dtype:
         dtype = getattr(tl, torch_dtype_name(fp.dtype))
@@ -1792,6 +1975,8 @@ scan_configs = [(op, type, shape, axis, num_warps)
                 for shape in scan2d_shapes
                 for op in ['cumsum', 'cumprod', 'get_first_element', 'linear_recurrence']]
 negative_config = [('cumsum', 'float32', (32, 32), -1, 4)]
+# the scan axis spans several blocks of the layout, scanned one at a time
+chunked_config = [(op, 'float32', (4, 8192), 1, 4) for op in ['cumsum', 'linear_recurrence']]
 
 
 @triton.jit
@@ -1806,7 +1991,7 @@ def linear_recurrence(a1, b1, a2, b2):
     return a1 * a2, b1 * a2 + b2
 
 
-@pytest.mark.parametrize("op, dtype_str, shape, axis, num_warps", scan_configs + negative_config)
+@pytest.mark.parametrize("op, dtype_str, shape, axis, num_warps", scan_configs + negative_config + chunked_config)
 def test_scan2d(op, dtype_str, shape, axis, num_warps, device):
     if is_hip():
         pytest.skip("test_scan2d is not supported in HIP")
@@ -1885,6 +2070,36 @@ def test_scan2d(op, dtype_str, shape, axis, num_warps, device):
         np.testing.assert_equal(z_ref, z_tri)
 
 
+@pytest.mark.parametrize("dtype_str", ['int32', 'float32'])
+def test_cumsum_look_back(dtype_str, device):
+    check_cuda_only(device)
+
+    @triton.jit
+    def kernel(X, Z, State, Counter, BLOCK: tl.constexpr):
+        # The tiles are numbered in the order the programs start
+        tile_id = tl.atomic_add(Counter, 1)
+        offs = tile_id * BLOCK + tl.arange(0, BLOCK)
+        x = tl.load(X + offs)
+        prefix = tl.cumsum_look_back(tl.sum(x, axis=0), tile_id, State)
+        tl.store(Z + offs, tl.cumsum(x, axis=0) + prefix)
+
+    num_tiles, block = 256, 512
+    rs = RandomState(17)
+    x = numpy_random((num_tiles * block, ), dtype_str=dtype_str, rs=rs)
+    if dtype_str == 'int32':
+        x = x % 16
+    x_tri = to_triton(x, device=device)
+    z_tri = torch.empty_like(x_tri)
+    state = torch.zeros((num_tiles, ), dtype=torch.int64, device=device)
+    counter = torch.zeros((1, ), dtype=torch.int32, device=device)
+    kernel[(num_tiles, )](x_tri, z_tri, state, counter, BLOCK=block)
+    z_ref = np.cumsum(x.astype('float64' if dtype_str == 'float32' else 'int64'))
+    if dtype_str == 'float32':
+        np.testing.assert_allclose(z_ref, to_numpy(z_tri), rtol=1e-3, atol=1e-1)
+    else:
+        np.testing.assert_equal(z_ref, to_numpy(z_tri))
+
+
 scan_layouts = [
     BlockedLayout([1, 4], [4, 8], [4, 1], [0, 1], [1, 1], [1, 1], [0, 1]),
     BlockedLayout([1, 4], [8, 4], [4, 1], [0, 1], [1, 1], [1, 1], [0, 1]),
@@ -1903,7 +2118,8 @@ scan_layouts = [
 # ---------------
 
 
-@pytest.mark.parametrize("M, N", [[2048, 2], [1024, 8], [1024, 128], [256, 512], [32, 512], [8, 512], [8, 2]])
+@pytest.mark.parametrize("M, N", [[2048, 2], [1024, 8], [1024, 128], [256, 512], [32, 512], [8, 512], [8, 2],
+                                  [1024, 1024], [64, 2048]])
 def test_histogram(M, N, device):
     if is_hip():
         pytest.skip(
@@ -2669,6 +2885,56 @@ def test_max_num_imprecise_acc(device):
     assert h.asm["ptx"].count("add.f32") == (M * N) // (32 * num_warps) * (K / MAX_NUM_IMPRECISE_ACC)
 
 
+@pytest.mark.parametrize("B, M, N, K, num_warps", [(B, M, N, K, num_warps)
+                                                   for B in [2, 4, 8]
+                                                   for M, N, K in [(16, 16, 16), (32, 16, 32), (16, 32, 16)]
+                                                   for num_warps in [4, 8]])
+@pytest.mark.parametrize("in_dtype", ["float16", "float32"])
+def test_dot3d(B, M, N, K, num_warps, in_dtype, device):
+    check_cuda_only(device)
+    if torch.cuda.get_device_capability()[0] < 8:
+        pytest.skip("batched dots of float32 need the tf32 tensor cores of sm >= 80")
+
+    @triton.jit
+    def kernel(x_ptr, y_ptr, z_ptr, B: tl.constexpr, M: tl.constexpr, N: tl.constexpr, K: tl.constexpr):
+        offs_b = tl.arange(0, B)[:, None, None]
+        offs_m = tl.arange(0, M)[None, :, None]
+        offs_n = tl.arange(0, N)[None, None, :]
+        offs_k = tl.arange(0, K)
+        x = tl.load(x_ptr + offs_b * M * K + offs_m * K + offs_k[None, None, :])
+        y = tl.load(y_ptr + offs_b * K * N + offs_k[None, :, None] * N + offs_n)
+        z = tl.dot(x, y)
+        tl.store(z_ptr + offs_b * M * N + offs_m * N + offs_n, z)
+
+    dtype = getattr(torch, in_dtype)
+    x = torch.randn((B, M, K), dtype=dtype, device=device)
+    y = torch.randn((B, K, N), dtype=dtype, device=device)
+    z = torch.empty((B, M, N), dtype=torch.float32, device=device)
+    h = kernel[(1, )](x, y, z, B, M, N, K, num_warps=num_warps)
+    z_ref = torch.matmul(x.float(), y.float())
+    # tf32 keeps 10 bits of the mantissa of the float32 inputs
+    torch.testing.assert_close(z, z_ref, atol=1e-2 * K, rtol=1e-2)
+    assert "mma.sync" in h.asm["ptx"]
+
+
+def test_dot3d_unsupported(device):
+    if not is_hip():
+        pytest.skip("batched dots are rejected on HIP only")
+
+    @triton.jit
+    def kernel(x_ptr, z_ptr):
+        offs_b = tl.arange(0, 2)[:, None, None]
+        offs_m = tl.arange(0, 16)[None, :, None]
+        offs = offs_b * 256 + offs_m * 16 + tl.arange(0, 16)[None, None, :]
+        x = tl.load(x_ptr + offs)
+        tl.store(z_ptr + offs, tl.dot(x, x))
+
+    x = torch.randn((2, 16, 16), dtype=torch.float16, device=device)
+    z = torch.empty((2, 16, 16), dtype=torch.float32, device=device)
+    with pytest.raises(triton.CompilationError, match="batched dots"):
+        kernel[(1, )](x, z)
+
+
 @pytest.mark.parametrize('in_dtype', ['float32'])
 def test_dot_mulbroadcastred(in_dtype, device):
     capability = torch.cuda.get_device_capability()
@@ -2993,6 +3259,65 @@ def test_vectorization_hints(has_hints, device):
         assert "ld.global.v4.b32" not in ptx
 
 
+def test_gather_prefetch(device):
+    table = torch.randn((16, 128), device=device)
+    idx = torch.randint(0, 16, (8, ), device=device, dtype=torch.int32)
+    dst = torch.empty(128, device=device)
+
+    @triton.jit
+    def _kernel(dst, table, idx, N):
+        offsets = tl.arange(0, 128)
+        acc = tl.zeros((128, ), dtype=tl.float32)
+        for i in range(0, N):
+            row = tl.load(idx + i)
+            acc += tl.load(table + row * 128 + offsets)
+        tl.prefetch(dst + offsets, mask=offsets < 64)
+        tl.store(dst + offsets, acc)
+
+    pgm = _kernel[(1, )](dst, table, idx, idx.shape[0])
+    torch.testing.assert_close(dst, table[idx.long()].sum(0))
+    if is_hip():
+        return
+
+    ptx = pgm.asm["ptx"]
+    assert "prefetch.global.L2" in ptx
+
+
+def test_load_rows(device):
+    M, N, K = 64, 64, 128
+    BLOCK_M, BLOCK_N, BLOCK_K = 32, 64, 32
+    a = torch.randn((256, K), device=device, dtype=torch.float16)
+    b = torch.randn((K, N), device=device, dtype=torch.float16)
+    # a row past the end of the index list is masked out
+    idx = torch.randint(0, a.shape[0], (M - 3, ), device=device, dtype=torch.int32)
+    c = torch.empty((M, N), device=device, dtype=torch.float32)
+
+    @triton.jit
+    def _kernel(a, b, c, idx, num_rows, stride_am, K, N, BLOCK_M: tl.constexpr, BLOCK_N: tl.constexpr,
+                BLOCK_K: tl.constexpr):
+        offs_m = tl.program_id(0) * BLOCK_M + tl.arange(0, BLOCK_M)
+        offs_n = tl.arange(0, BLOCK_N)
+        rows = tl.load(idx + offs_m, mask=offs_m < num_rows, other=0)
+        acc = tl.zeros((BLOCK_M, BLOCK_N), dtype=tl.float32)
+        for k in range(0, K, BLOCK_K):
+            offs_k = k + tl.arange(0, BLOCK_K)
+            x = tl.load_rows(a, rows, offs_k, stride_am, row_mask=offs_m < num_rows, other=0.0)
+            y = tl.load(b + offs_k[:, None] * N + offs_n[None, :])
+            acc += tl.dot(x, y)
+        tl.store(c + offs_m[:, None] * N + offs_n[None, :], acc)
+
+    pgm = _kernel[(M // BLOCK_M, )](a, b, c, idx, idx.shape[0], a.stride(0), K, N, BLOCK_M=BLOCK_M, BLOCK_N=BLOCK_N,
+                                    BLOCK_K=BLOCK_K)
+    ref = torch.zeros((M, N), device=device, dtype=torch.float32)
+    ref[:idx.shape[0]] = torch.matmul(a[idx.long()].float(), b.float())
+    torch.testing.assert_close(c, ref, atol=1e-2, rtol=1e-2)
+    if is_hip() or torch.cuda.get_device_capability()[0] < 8:
+        return
+
+    # the gathered rows are staged like the rows of a plain matrix
+    assert "insert_slice_async" in pgm.asm["ttgir"]
+
+
 # ---------------
 # test store
 # ---------------
@@ -4020,6 +4345,39 @@ def test_smid(device):
     assert h.asm["ptx"].count("%smid") == 1
 
 
+@pytest.mark.parametrize("dtype_str", ["int32", "float32", "int64"])
+def test_load_acquire_store_release(dtype_str, device):
+    if is_hip():
+        pytest.skip("test_load_acquire_store_release is not supported in HIP")
+    check_cuda_only(device)
+
+    @triton.jit
+    def message(Data, Flag, Out, BLOCK: tl.constexpr):
+        off = tl.arange(0, BLOCK)
+        if tl.program_id(0) == 0:
+            tl.store(Data + off, off.to(Data.dtype.element_ty) + 1)
+            tl.extra.cuda.store_release(Flag, 1, scope="sys")
+        else:
+            while tl.extra.cuda.load_acquire(Flag, scope="sys") == 0:
+                pass
+            # the masked out elements are not loaded
+            x = tl.extra.cuda.load_acquire(Data + off, mask=off < BLOCK // 2, scope="sys")
+            tl.extra.cuda.store_release(Out + off, x, mask=off < BLOCK - 1)
+
+    BLOCK = 128
+    dtype = getattr(torch, dtype_str)
+    data = torch.zeros(BLOCK, dtype=dtype, device=device)
+    flag = torch.zeros(1, dtype=torch.int32, device=device)
+    out = torch.full((BLOCK, ), -1, dtype=dtype, device=device)
+    h = message[(2, )](data, flag, out, BLOCK=BLOCK)
+    ref = torch.arange(BLOCK, device=device).to(dtype) + 1
+    ref[BLOCK // 2:] = 0
+    ref[-1] = -1
+    torch.testing.assert_close(out, ref)
+    assert "ld.global.acquire.sys" in h.asm["ptx"]
+    assert "st.global.release.sys" in h.asm["ptx"]
+
+
 # -----------------------
 # test layout conversions
 # -----------------------
@@ -4530,3 +4888,45 @@ def test_sort(M, N, descending, dtype_str, device):
     z = torch.empty_like(x)
     sort_kernel[(1, )](x, z, N, M, descending, num_warps=8)
     assert (y == z).all(), (y, z)
+
+
+@pytest.mark.parametrize("M, N", [[8, 64], [256, 16]])
+@pytest.mark.parametrize("descending", [False, True])
+@pytest.mark.parametrize("dtype_str", ['int32', 'float32'])
+def test_sort_dim0(M, N, descending, dtype_str, device):
+    if is_hip():
+        pytest.skip('test_sort_dim0 is not supported in HIP')
+
+    @triton.jit
+    def sort_kernel(X, Z, N: tl.constexpr, M: tl.constexpr, descending: tl.constexpr):
+        off2d = tl.arange(0, N)[None, :] + tl.arange(0, M)[:, None] * N
+        x = tl.load(X + off2d)
+        x = tl.sort(x, dim=0, descending=descending)
+        tl.store(Z + off2d, x)
+
+    x = numpy_random((M, N), dtype_str=dtype_str)
+    x = torch.from_numpy(x).to(device)
+    y = torch.sort(x, dim=0, descending=descending)[0]
+    z = torch.empty_like(x)
+    sort_kernel[(1, )](x, z, N, M, descending, num_warps=4)
+    assert (y == z).all(), (y, z)
+
+
+@pytest.mark.parametrize("M, N, K", [[1, 512, 8], [8, 64, 16], [16, 128, 128]])
+@pytest.mark.parametrize("dtype_str", ['int32', 'float16', 'float32'])
+def test_topk(M, N, K, dtype_str, device):
+    if is_hip():
+        pytest.skip('test_topk is not supported in HIP')
+
+    @triton.jit
+    def topk_kernel(X, Z, N: tl.constexpr, M: tl.constexpr, K: tl.constexpr):
+        x = tl.load(X + tl.arange(0, N)[None, :] + tl.arange(0, M)[:, None] * N)
+        z = tl.topk(x, K)
+        tl.store(Z + tl.arange(0, K)[None, :] + tl.arange(0, M)[:, None] * K, z)
+
+    x = numpy_random((M, N), dtype_str=dtype_str)
+    x = torch.from_numpy(x).to(device)
+    y = torch.topk(x.float() if dtype_str == 'float16' else x, K, dim=1)[0].to(x.dtype)
+    z = torch.empty((M, K), dtype=x.dtype, device=device)
+    topk_kernel[(1, )](x, z, N, M, K, num_warps=4)
+    assert (y == z).all(), (y, z)
@@ -143,6 +143,38 @@ def test_randint(size, seed, device, dtype):
     assert out_tri == out_ref
 
 
+# test generation of random uint32 with all the outputs of each round
+
+
+@pytest.mark.parametrize('size, seed, dtype', [(size, seed, dtype)
+                                               for size in ['10', '4,53', '400']
+                                               for seed in [0, 42, 0xffffffff, 0x0000000fcafeb0ba]
+                                               for dtype in ['int32', 'int64']])
+def test_randint_packed(size, seed, device, dtype):
+    size = list(map(int, size.split(',')))
+    torch_dtype = getattr(torch, dtype)
+    numpy_dtype = getattr(np, f"u{dtype}")
+    config = {'int32': PHILOX_32, 'int64': PHILOX_64}[dtype]
+
+    @triton.jit
+    def kernel(X, N, seed):
+        pid = tl.program_id(0).to(X.dtype.element_ty)
+        offset = pid * BLOCK + tl.arange(0, BLOCK)
+        rand = tl.randint_packed(seed, pid * (BLOCK // 4), BLOCK)
+        tl.store(X + offset, rand, mask=offset < N)
+
+    # triton result
+    x = torch.empty(size, dtype=torch_dtype, device=device)
+    N = x.numel()
+    grid = (triton.cdiv(N, BLOCK), )
+    kernel[grid](x, N, seed)
+    out_tri = x.cpu().numpy().astype(numpy_dtype).flatten().tolist()
+    # reference result, the four outputs of each counter in turn
+    gen = CustomPhilox(seed, config=config)
+    out_ref = [gen.random_raw() for _ in out_tri]
+    assert out_tri == out_ref
+
+
 # test uniform PRNG
 
 
@@ -193,6 +225,26 @@ def test_randn(size, seed, dtype, device):
     assert abs(x.std() - 1) < 1e-2
 
 
+@pytest.mark.parametrize('seed', [0, 42])
+def test_rand_packed(seed, device, size=100000):
+
+    @triton.jit
+    def kernel(X, Y, N, seed):
+        pid = tl.program_id(0)
+        offset = pid * BLOCK + tl.arange(0, BLOCK)
+        tl.store(X + offset, tl.rand_packed(seed, pid * (BLOCK // 4), BLOCK), mask=offset < N)
+        tl.store(Y + offset, tl.randn_packed(seed, pid * (BLOCK // 4), BLOCK), mask=offset < N)
+
+    x = torch.empty(size, dtype=torch.float32, device=device)
+    y = torch.empty(size, dtype=torch.float32, device=device)
+    grid = (triton.cdiv(size, BLOCK), )
+    kernel[grid](x, y, size, seed)
+    assert all((x >= 0) & (x <= 1))
+    assert scipy.stats.kstest(x.tolist(), 'uniform', args=(0, 1)).statistic < 0.01
+    assert abs(y.mean()) < 1e-2
+    assert abs(y.std() - 1) < 1e-2
+
+
 # tl.rand() should never produce >=1.0
 
 
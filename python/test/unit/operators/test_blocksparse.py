@@ -90,6 +90,30 @@ def test_matmul(MODE, TRANS_A, TRANS_B, BLOCK, DTYPE, Z=3, H=2, M=512, N=384, K=
     torch.testing.assert_close(db_ref, db_tri)
 
 
+
+@pytest.mark.parametrize("MODE", ["dds", "dsd"])
+@pytest.mark.parametrize("TRANS_A", [False, True])
+@pytest.mark.parametrize("BLOCK", [16, 64])
+def test_matmul_persistent(MODE, TRANS_A, BLOCK, Z=3, H=2, M=512, N=384, K=256):
+    torch.manual_seed(0)
+    # rows of uneven density, as in causal masks
+    a_shape = (Z, H, K, M) if TRANS_A else (Z, H, M, K)
+    shape = a_shape[2:] if MODE == "dsd" else (K, N)
+    layout = torch.tril(torch.ones((H, shape[0] // BLOCK, shape[1] // BLOCK), dtype=torch.int64))
+    layout[1, 3, :] = 0
+    a = torch.randn(a_shape, dtype=torch.float16, device="cuda")
+    b = torch.randn((Z, H, K, N), dtype=torch.float16, device="cuda")
+    if MODE == "dsd":
+        a = sparsify_tensor(a, layout, BLOCK)
+    else:
+        b = sparsify_tensor(b, layout, BLOCK)
+    ref_op = triton.ops.blocksparse.matmul(layout, BLOCK, MODE, trans_a=TRANS_A, device="cuda")
+    tri_op = triton.ops.blocksparse.matmul(layout, BLOCK, MODE, trans_a=TRANS_A, device="cuda", persistent=True)
+    # the ops of a layout share their look-up tables
+    assert tri_op.c_lut is ref_op.c_lut
+    torch.testing.assert_close(ref_op(a, b), tri_op(a, b))
+
+
 configs = [
     (16, 256),
     (32, 576),
@@ -39,3 +39,43 @@ def test_op(M, N, dtype, mode):
             torch.testing.assert_close(th_dx, tt_dx, rtol=0.001, atol=0.001)
         else:
             torch.testing.assert_close(th_dx, tt_dx)
+
+
+@pytest.mark.parametrize("N", [40000, 131079])
+@pytest.mark.parametrize("dtype", [torch.float16, torch.float32])
+def test_op_chunked(N, dtype, M=64):
+    # rows too long to be reduced at once
+    torch.manual_seed(0)
+    x = torch.randn(M, N, dtype=dtype, device='cuda', requires_grad=True)
+    idx = torch.randint(0, N, (M, ), dtype=torch.int64, device='cuda')
+    tt_y = triton.ops.cross_entropy(x, idx)
+    th_y = torch.nn.CrossEntropyLoss(reduction="none")(x.float(), idx).to(dtype)
+    torch.testing.assert_close(th_y, tt_y)
+    dy = torch.randn_like(tt_y)
+    tt_y.backward(dy)
+    tt_dx = x.grad.clone()
+    x.grad = None
+    th_y.backward(dy)
+    torch.testing.assert_close(x.grad, tt_dx, rtol=0.001, atol=0.001)
+
+
+@pytest.mark.parametrize("M, N, K", [(256, 32000, 256), (333, 50257, 128)])
+@pytest.mark.parametrize("dtype", [torch.float16, torch.bfloat16])
+def test_linear(M, N, K, dtype):
+    capability = torch.cuda.get_device_capability()
+    if capability[0] < 8 and dtype == torch.bfloat16:
+        pytest.skip("Only test bfloat16 on devices with sm >= 80")
+    torch.manual_seed(0)
+    x = (0.1 * torch.randn(M, K, device='cuda')).to(dtype).requires_grad_()
+    w = (0.1 * torch.randn(N, K, device='cuda')).to(dtype).requires_grad_()
+    idx = torch.randint(0, N, (M, ), dtype=torch.int64, device='cuda')
+    tt_y = triton.ops.linear_cross_entropy(x, w, idx)
+    dy = torch.randn_like(tt_y)
+    tt_y.backward(dy)
+    tt_dx, tt_dw = x.grad.clone(), w.grad.clone()
+    x.grad, w.grad = None, None
+    th_y = torch.nn.CrossEntropyLoss(reduction="none")(torch.matmul(x, w.t()).float(), idx)
+    th_y.backward(dy.float())
+    torch.testing.assert_close(th_y.to(dtype), tt_y, rtol=0.01, atol=0.01)
+    torch.testing.assert_close(x.grad, tt_dx, rtol=0.01, atol=0.01)
+    torch.testing.assert_close(w.grad, tt_dw, rtol=0.01, atol=0.01)
@@ -61,6 +61,107 @@ def test_op(Z, H, N_CTX, D_HEAD, dtype, causal, seq_par):
                                torch.nn.functional.normalize(torch.flatten(tri_dq), dim=0), atol=atol, rtol=0)
 
 
+def _varlen_reference(q, k, v, seqlens_q, seqlens_k, causal, sm_scale):
+    # attention of each sequence on its own, [T, H, D] layout
+    outs = []
+    q_start, k_start = 0, 0
+    groups = q.shape[1] // k.shape[1]
+    for seqlen_q, seqlen_k in zip(seqlens_q, seqlens_k):
+        qi = q[q_start:q_start + seqlen_q].transpose(0, 1).float()
+        ki = k[k_start:k_start + seqlen_k].transpose(0, 1).float().repeat_interleave(groups, dim=0)
+        vi = v[k_start:k_start + seqlen_k].transpose(0, 1).float().repeat_interleave(groups, dim=0)
+        p = torch.matmul(qi, ki.transpose(1, 2)) * sm_scale
+        if causal:
+            rows = torch.arange(seqlen_q, device=q.device)[:, None] + seqlen_k - seqlen_q
+            p = p.masked_fill(rows < torch.arange(seqlen_k, device=q.device)[None, :], float("-inf"))
+        p = torch.softmax(p, dim=-1).nan_to_num()
+        outs.append(torch.matmul(p, vi).transpose(0, 1).to(q.dtype))
+        q_start += seqlen_q
+        k_start += seqlen_k
+    return torch.cat(outs)
+
+
+@pytest.mark.parametrize('seqlens_q, seqlens_k', [
+    ([1, 17, 128, 300], [1, 17, 128, 300]),
+    ([1, 4, 1, 64], [250, 77, 33, 64]),
+])
+@pytest.mark.parametrize('H, H_KV, D_HEAD', [(4, 4, 64), (8, 2, 128)])
+@pytest.mark.parametrize('causal', [True, False])
+@pytest.mark.parametrize('page_size', [None, 16])
+def test_op_varlen(seqlens_q, seqlens_k, H, H_KV, D_HEAD, causal, page_size):
+    capability = torch.cuda.get_device_capability()
+    if capability[0] < 8:
+        pytest.skip("Flash attention only supported for compute capability >= 80")
+    torch.manual_seed(20)
+    dtype = torch.float16
+    sm_scale = 0.5
+    q = torch.empty((sum(seqlens_q), H, D_HEAD), dtype=dtype, device="cuda").normal_(mean=0., std=0.5)
+    k = torch.empty((sum(seqlens_k), H_KV, D_HEAD), dtype=dtype, device="cuda").normal_(mean=0., std=0.5)
+    v = torch.empty((sum(seqlens_k), H_KV, D_HEAD), dtype=dtype, device="cuda").normal_(mean=0., std=0.5)
+    ref_out = _varlen_reference(q, k, v, seqlens_q, seqlens_k, causal, sm_scale)
+    to_cu_seqlens = lambda seqlens: torch.tensor([0] + seqlens, device="cuda", dtype=torch.int32).cumsum(0).to(
+        torch.int32)
+    cu_seqlens_q = to_cu_seqlens(seqlens_q)
+    if page_size is None:
+        tri_out = triton.ops.attention_varlen(q, k, v, cu_seqlens_q, to_cu_seqlens(seqlens_k), max(seqlens_q), causal,
+                                              sm_scale)
+    else:
+        # scatter the keys and values of each sequence into shuffled pages
+        max_pages = max(triton.cdiv(seqlen, page_size) for seqlen in seqlens_k)
+        num_pages = max_pages * len(seqlens_k)
+        block_table = torch.randperm(num_pages, device="cuda").to(torch.int32).view(len(seqlens_k), max_pages)
+        k_cache = torch.zeros((num_pages, page_size, H_KV, D_HEAD), dtype=dtype, device="cuda")
+        v_cache = torch.zeros_like(k_cache)
+        start = 0
+        for i, seqlen in enumerate(seqlens_k):
+            for t in range(seqlen):
+                page = block_table[i, t // page_size]
+                k_cache[page, t % page_size] = k[start + t]
+                v_cache[page, t % page_size] = v[start + t]
+            start += seqlen
+        seqlens_k_t = torch.tensor(seqlens_k, device="cuda", dtype=torch.int32)
+        tri_out = triton.ops.paged_attention(q, k_cache, v_cache, cu_seqlens_q, seqlens_k_t, block_table,
+                                             max(seqlens_q), causal, sm_scale)
+    torch.testing.assert_close(ref_out, tri_out, atol=1e-2, rtol=0)
+
+
+
+@pytest.mark.parametrize('seqlens_k', [[1, 64, 1000], [4096]])
+@pytest.mark.parametrize('H, H_KV, D_HEAD', [(4, 4, 64), (8, 2, 128)])
+@pytest.mark.parametrize('num_splits', [None, 1, 7])
+@pytest.mark.parametrize('page_size', [None, 16])
+def test_op_decode(seqlens_k, H, H_KV, D_HEAD, num_splits, page_size):
+    capability = torch.cuda.get_device_capability()
+    if capability[0] < 8:
+        pytest.skip("Flash attention only supported for compute capability >= 80")
+    torch.manual_seed(20)
+    dtype = torch.float16
+    sm_scale = 0.5
+    batch = len(seqlens_k)
+    q = torch.empty((batch, H, D_HEAD), dtype=dtype, device="cuda").normal_(mean=0., std=0.5)
+    k = torch.empty((sum(seqlens_k), H_KV, D_HEAD), dtype=dtype, device="cuda").normal_(mean=0., std=0.5)
+    v = torch.empty((sum(seqlens_k), H_KV, D_HEAD), dtype=dtype, device="cuda").normal_(mean=0., std=0.5)
+    ref_out = _varlen_reference(q, k, v, [1] * batch, seqlens_k, False, sm_scale)
+    seqlens_k_t = torch.tensor(seqlens_k, device="cuda", dtype=torch.int32)
+    if page_size is None:
+        tri_out = triton.ops.attention_decode(q, k, v, seqlens_k_t, max(seqlens_k), sm_scale, num_splits=num_splits)
+    else:
+        max_pages = max(triton.cdiv(seqlen, page_size) for seqlen in seqlens_k)
+        block_table = torch.randperm(max_pages * batch, device="cuda").to(torch.int32).view(batch, max_pages)
+        k_cache = torch.zeros((max_pages * batch, page_size, H_KV, D_HEAD), dtype=dtype, device="cuda")
+        v_cache = torch.zeros_like(k_cache)
+        start = 0
+        for i, seqlen in enumerate(seqlens_k):
+            t = torch.arange(seqlen, device="cuda")
+            pages = block_table[i, t // page_size].long()
+            k_cache[pages, t % page_size] = k[start:start + seqlen]
+            v_cache[pages, t % page_size] = v[start:start + seqlen]
+            start += seqlen
+        tri_out = triton.ops.attention_decode(q, k_cache, v_cache, seqlens_k_t, max(seqlens_k), sm_scale,
+                                              block_table=block_table, num_splits=num_splits)
+    torch.testing.assert_close(ref_out, tri_out, atol=1e-2, rtol=0)
+
+
 try:
     from flash_attn.flash_attn_interface import flash_attn_func
     HAS_FLASH = True
@@ -0,0 +1,20 @@
+import pytest
+import torch
+
+import triton
+import triton.ops
+
+
+@pytest.mark.parametrize("sizes", [[128, 0, 77, 300], [1] * 16, [2048], [5, 1000, 0, 0, 33, 64, 17, 129]])
+@pytest.mark.parametrize("N, K", [(256, 128), (96, 200)])
+@pytest.mark.parametrize("dtype", [torch.float16, torch.float32])
+def test_op(sizes, N, K, dtype):
+    torch.manual_seed(0)
+    G, T = len(sizes), sum(sizes)
+    a = torch.randn((T, K), device="cuda", dtype=dtype)
+    b = torch.randn((G, K, N), device="cuda", dtype=dtype)
+    offsets = torch.tensor([0] + sizes, device="cuda", dtype=torch.int32).cumsum(0).to(torch.int32)
+    tri_c = triton.ops.grouped_matmul(a, b, offsets)
+    ref_c = torch.cat([torch.matmul(x, b[g]) for g, x in enumerate(a.split(sizes))])
+    atol = 1e-2 if dtype == torch.float16 else 1e-1
+    torch.testing.assert_close(ref_c, tri_c, atol=atol, rtol=1e-2)
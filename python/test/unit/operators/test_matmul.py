@@ -184,3 +184,29 @@ def test_op(BLOCK_M, BLOCK_N, BLOCK_K, SPLIT_K, NWARP, NSTAGE, M, N, K, AT, BT,
         torch.testing.assert_close(th_c, tt_c)
     except triton.OutOfResources as e:
         pytest.skip(str(e))
+
+
+@pytest.mark.parametrize("BLOCK_M, BLOCK_N, BLOCK_K, NWARP, NSTAGE, M, N, K, DTYPE", [
+    (64, 64, 32, 4, 2, 64, 64, 512, "float16"),
+    (64, 64, 32, 4, 2, 320, 448, 160, "float16"),
+    (64, 64, 32, 4, 2, 1000, 1000, 270, "float32"),
+    (128, 128, 32, 4, 3, 1536, 1664, 1024, "float16"),
+])
+def test_op_stream_k(BLOCK_M, BLOCK_N, BLOCK_K, NWARP, NSTAGE, M, N, K, DTYPE):
+    capability = torch.cuda.get_device_capability()
+    if capability[0] < 7:
+        pytest.skip("Only test tl.dot() on devices with sm >= 70")
+    torch.manual_seed(0)
+    kwargs = {'BLOCK_M': BLOCK_M, 'BLOCK_N': BLOCK_N, 'BLOCK_K': BLOCK_K, 'SPLIT_K': 1, 'STREAM_K': True}
+    configs = [
+        triton.Config(kwargs=kwargs, num_warps=NWARP, num_stages=NSTAGE, pre_hook=lambda nargs: nargs['C'].zero_())
+    ]
+    kernel = triton.ops._matmul.kernel
+    kernel.configs = configs
+    dtype = getattr(torch, DTYPE)
+    a = (2.**torch.randint(-10, 0, size=(M, K))).to(dtype).to("cuda")
+    b = (2.**torch.randint(-10, 0, size=(K, N))).to(dtype).to("cuda")
+    # the tiles that do not fill the last wave, if any, are split among the SMs
+    th_c = torch.matmul(a, b)
+    tt_c = triton.ops.matmul(a, b)
+    torch.testing.assert_close(th_c, tt_c)
@@ -1,3 +1,5 @@
+import json
+
 import torch
 
 import triton
@@ -79,3 +81,336 @@ def test_prune_configs(with_perf_model: bool):
         assert records['run_perf_model']
     else:
         assert records['run_early_config_prune']
+
+
+@pytest.mark.parametrize('compile_threads', [1, 4])
+def test_compile_threads(compile_threads: int):
+    N = 1024
+    src = torch.randn(N, device='cuda')
+    dst = torch.empty(N, device='cuda')
+
+    configs = [triton.Config(kwargs={'BLOCK_SIZE': 2**i}) for i in range(5, 10)]
+
+    @triton.autotune(configs=configs, key=['N'], warmup=1, rep=1, compile_threads=compile_threads)
+    @triton.jit
+    def _kernel(dst, src, N, BLOCK_SIZE: tl.constexpr):
+        offsets = tl.program_id(0) * BLOCK_SIZE + tl.arange(0, BLOCK_SIZE)
+        x = tl.load(src + offsets, mask=offsets < N)
+        tl.store(dst + offsets, x, mask=offsets < N)
+
+    grid = lambda META: (triton.cdiv(N, META['BLOCK_SIZE']), )
+    _kernel[grid](dst, src, N)
+    torch.testing.assert_close(src, dst)
+    assert list(_kernel.configs_timings.keys()) == configs
+    device = torch.cuda.current_device()
+    assert len(_kernel.fn.cache[device]) == len(configs)
+
+
+def test_prune_by_resources():
+    N = 1024
+    src = torch.randn(N, device='cuda')
+    dst = torch.empty(N, device='cuda')
+    # at most two CTAs of 32 warps fit on an SM
+    configs = [triton.Config(kwargs={'BLOCK_SIZE': 1024}, num_warps=w) for w in (1, 32)]
+
+    @triton.autotune(configs=configs, key=['N'], warmup=1, rep=1, prune_configs_by={'min_occupancy': 4})
+    @triton.jit
+    def _kernel(dst, src, N, BLOCK_SIZE: tl.constexpr):
+        offsets = tl.program_id(0) * BLOCK_SIZE + tl.arange(0, BLOCK_SIZE)
+        x = tl.load(src + offsets, mask=offsets < N)
+        tl.store(dst + offsets, x, mask=offsets < N)
+
+    grid = lambda META: (triton.cdiv(N, META['BLOCK_SIZE']), )
+    _kernel[grid](dst, src, N)
+    torch.testing.assert_close(src, dst)
+    timings = _kernel.configs_timings
+    assert timings[configs[0]][0] < float("inf")
+    assert timings[configs[1]] == [float("inf")] * 3
+    assert _kernel.best_config is configs[0]
+
+
+def test_successive_halving():
+    N = 1 << 20
+    src = torch.randn(N, device='cuda')
+    dst = torch.empty(N, device='cuda')
+    configs = [triton.Config(kwargs={'BLOCK_SIZE': 2**i}) for i in range(5, 13)]
+
+    @triton.autotune(configs=configs, key=['N'], warmup=1, rep=8, successive_halving=True)
+    @triton.jit
+    def _kernel(dst, src, N, BLOCK_SIZE: tl.constexpr):
+        offsets = tl.program_id(0) * BLOCK_SIZE + tl.arange(0, BLOCK_SIZE)
+        x = tl.load(src + offsets, mask=offsets < N)
+        tl.store(dst + offsets, x, mask=offsets < N)
+
+    grid = lambda META: (triton.cdiv(N, META['BLOCK_SIZE']), )
+    _kernel[grid](dst, src, N)
+    torch.testing.assert_close(src, dst)
+    assert list(_kernel.configs_timings.keys()) == configs
+    # 8 configs: 1ms for all, 2ms for 4, 4ms for 2 and the full 8ms for the last one
+    assert len(_kernel.race_finalists) == 1
+    assert _kernel.best_config is _kernel.race_finalists[0]
+
+
+@pytest.mark.skipif(torch.cuda.device_count() < 2, reason="requires two GPUs")
+def test_devices():
+    N = 1024
+    src = torch.randn(N, device='cuda')
+    dst = torch.empty(N, device='cuda')
+    configs = [triton.Config(kwargs={'BLOCK_SIZE': 2**i}) for i in range(5, 10)]
+
+    @triton.autotune(configs=configs, key=['N'], warmup=1, rep=1, restore_value=['dst'], devices="all")
+    @triton.jit
+    def _kernel(dst, src, N, BLOCK_SIZE: tl.constexpr):
+        offsets = tl.program_id(0) * BLOCK_SIZE + tl.arange(0, BLOCK_SIZE)
+        x = tl.load(src + offsets, mask=offsets < N)
+        tl.store(dst + offsets, x, mask=offsets < N)
+
+    grid = lambda META: (triton.cdiv(N, META['BLOCK_SIZE']), )
+    _kernel[grid](dst, src, N)
+    torch.testing.assert_close(src, dst)
+    assert list(_kernel.configs_timings.keys()) == configs
+    assert all(timing[0] < float("inf") for timing in _kernel.configs_timings.values())
+    # every device of the current one's model, the current one first
+    current = torch.cuda.current_device()
+    name = torch.cuda.get_device_name(current)
+    same_model = {d for d in range(torch.cuda.device_count()) if torch.cuda.get_device_name(d) == name}
+    devices = _kernel._bench_devices()
+    assert devices[0] == current and len(devices) == len(same_model) and set(devices) == same_model
+    # each of them compiled the share of the configs it benchmarked
+    assert {d for d, kernels in _kernel.fn.cache.items() if kernels} == set(devices[:len(configs)])
+
+
+def test_key_buckets():
+    src = torch.randn(1024, device='cuda')
+    dst = torch.empty(1024, device='cuda')
+    configs = [triton.Config(kwargs={'BLOCK_SIZE': 32}), triton.Config(kwargs={'BLOCK_SIZE': 128})]
+
+    @triton.autotune(configs=configs, key=['N'], warmup=1, rep=1, key_buckets={'N': 'pow2'})
+    @triton.jit
+    def _kernel(dst, src, N, BLOCK_SIZE: tl.constexpr):
+        offsets = tl.program_id(0) * BLOCK_SIZE + tl.arange(0, BLOCK_SIZE)
+        x = tl.load(src + offsets, mask=offsets < N)
+        tl.store(dst + offsets, x, mask=offsets < N)
+
+    grid = lambda META: (triton.cdiv(1024, META['BLOCK_SIZE']), )
+    for N in (513, 700, 1024, 300):
+        _kernel[grid](dst, src, N)
+        torch.testing.assert_close(src[:N], dst[:N])
+    assert {key[0] for key in _kernel.cache} == {1024, 512}
+    assert triton.runtime.autotuner.bucket_key_value(100, [64, 256]) == 256
+    assert triton.runtime.autotuner.bucket_key_value(300, [64, 256]) == float("inf")
+    with pytest.raises(ValueError, match="not part of the key"):
+        triton.autotune(configs=configs, key=['N'], key_buckets={'M': 'pow2'})(_kernel.fn)
+
+
+def test_cache_results(tmp_path, monkeypatch):
+    monkeypatch.setenv("TRITON_CACHE_DIR", str(tmp_path))
+    N = 1024
+    src = torch.randn(N, device='cuda')
+    dst = torch.empty(N, device='cuda')
+    calls = []
+
+    def make_kernel():
+        configs = [
+            triton.Config(kwargs={'BLOCK_SIZE': 32}, pre_hook=lambda nargs: calls.append(32)),
+            triton.Config(kwargs={'BLOCK_SIZE': 128}, pre_hook=lambda nargs: calls.append(128)),
+        ]
+
+        @triton.autotune(configs=configs, key=['N'], warmup=1, rep=1, cache_results=True)
+        @triton.jit
+        def _kernel(dst, src, N, BLOCK_SIZE: tl.constexpr):
+            offsets = tl.program_id(0) * BLOCK_SIZE + tl.arange(0, BLOCK_SIZE)
+            x = tl.load(src + offsets, mask=offsets < N)
+            tl.store(dst + offsets, x, mask=offsets < N)
+
+        return _kernel
+
+    grid = lambda META: (triton.cdiv(N, META['BLOCK_SIZE']), )
+    make_kernel()[grid](dst, src, N)
+    assert set(calls) == {32, 128}
+    best = calls[-1]
+    # a fresh autotuner (e.g. in another process) must reuse the stored decision
+    calls.clear()
+    make_kernel()[grid](dst, src, N)
+    assert calls == [best]
+    torch.testing.assert_close(src, dst)
+
+
+# warm-up manifests can only refer to kernels defined at module scope
+@triton.autotune(configs=[triton.Config(kwargs={'BLOCK_SIZE': 32}),
+                          triton.Config(kwargs={'BLOCK_SIZE': 128})], key=['N'], warmup=1, rep=1)
+@triton.jit
+def _manifest_kernel(dst, src, N, BLOCK_SIZE: tl.constexpr):
+    offsets = tl.program_id(0) * BLOCK_SIZE + tl.arange(0, BLOCK_SIZE)
+    x = tl.load(src + offsets, mask=offsets < N)
+    tl.store(dst + offsets, x, mask=offsets < N)
+
+
+def test_manifest(tmp_path):
+    from triton.runtime import manifest
+    N = 1024
+    src = torch.randn(N, device='cuda')
+    dst = torch.empty(N, device='cuda')
+    path = tmp_path / "manifest.jsonl"
+    grid = lambda META: (triton.cdiv(N, META['BLOCK_SIZE']), )
+    manifest.record(str(path))
+    try:
+        _manifest_kernel[grid](dst, src, N)
+    finally:
+        manifest.record(None)
+    # only the winning config is recorded
+    entries = [json.loads(line) for line in path.read_text().splitlines()]
+    assert [entry["kind"] for entry in entries] == ["autotune"]
+    assert len(entries[0]["kernels"]) == 1
+    best = _manifest_kernel.best_config
+    # simulate a fresh process
+    device = torch.cuda.current_device()
+    _manifest_kernel.cache.clear()
+    _manifest_kernel.fn.cache[device].clear()
+    assert manifest.replay(str(path)) == 1
+    assert str(_manifest_kernel.cache[(N, "torch.float32", "torch.float32")]) == str(best)
+    assert len(_manifest_kernel.fn.cache[device]) == 1
+    dst.zero_()
+    _manifest_kernel[grid](dst, src, N)
+    assert len(_manifest_kernel.fn.cache[device]) == 1
+    torch.testing.assert_close(src, dst)
+
+
+def test_export_heuristics(tmp_path, monkeypatch):
+    from triton.runtime.autotuner import heuristics_from_table
+    from triton.tools.export_heuristics import collect_decisions, make_tables
+    monkeypatch.setenv("TRITON_CACHE_DIR", str(tmp_path))
+    src = torch.randn(1024, device='cuda')
+    dst = torch.empty(1024, device='cuda')
+    configs = [triton.Config(kwargs={'BLOCK_SIZE': 32}), triton.Config(kwargs={'BLOCK_SIZE': 128}, num_warps=8)]
+
+    def body(dst, src, N, BLOCK_SIZE: tl.constexpr):
+        offsets = tl.program_id(0) * BLOCK_SIZE + tl.arange(0, BLOCK_SIZE)
+        x = tl.load(src + offsets, mask=offsets < N)
+        tl.store(dst + offsets, x, mask=offsets < N)
+
+    tuned = triton.autotune(configs=configs, key=['N'], warmup=1, rep=1, cache_results=True)(triton.jit(body))
+    grid = lambda META: (triton.cdiv(1024, META['BLOCK_SIZE']), )
+    for N in (256, 1024):
+        tuned[grid](dst, src, N)
+    [table] = make_tables(collect_decisions(tmp_path))
+    assert table["key_names"] == ["N"]
+    assert table["dtypes"] == ["torch.float32", "torch.float32"]
+    assert [row["key"] for row in table["rows"]] == [[1024], [256]]
+    # the heuristic replays the decisions, and extrapolates to the closest key
+    values = heuristics_from_table(table)
+    fixed = triton.heuristics(values=values)(triton.jit(body))
+    for N, tuned_N in ((256, 256), (1024, 1024), (300, 256)):
+        best = tuned.cache[(tuned_N, "torch.float32", "torch.float32")]
+        assert values["BLOCK_SIZE"]({"N": N}) == best.kwargs["BLOCK_SIZE"]
+        assert values["num_warps"]({"N": N}) == best.num_warps
+        dst.zero_()
+        fixed[grid](dst, src, N)
+        torch.testing.assert_close(src[:N], dst[:N])
+
+
+def test_select_config_rules():
+    import math
+    from triton.runtime.autotuner import select_config
+    from triton.tools.export_heuristics import rules_from_rows
+    table = {
+        "key_names": ["M", "K"], "rows": [
+            {"key": [128, 64], "config": 0},
+            {"key": [128, math.inf], "config": 1},
+            {"key": [1024, 64], "config": 2},
+        ]
+    }
+    # closest row in log2 space
+    assert select_config(table, [600, 64]) == 2
+    table["rules"] = rules_from_rows(table)
+    assert table["rules"][1] == {"ranges": {"M": [None, 129], "K": [65, None]}, "config": 1}
+    # values within a bucket pick its config
+    assert select_config(table, [600, 64]) == 2
+    assert select_config(table, [100, 4096]) == 1
+    # outside of all the rules, fall back to the closest row
+    assert select_config(table, [4096, 4096]) == 2
+    rules_only = {"key_names": ["M"], "rules": [{"ranges": {"M": [None, 64]}, "config": 1}], "default": 3}
+    assert select_config(rules_only, [32]) == 1
+    assert select_config(rules_only, [64]) == 3
+
+
+def test_fast_compile():
+    N = 1024
+    src = torch.randn(N, device='cuda')
+    dst = torch.empty(N, device='cuda')
+    configs = [triton.Config(kwargs={'BLOCK_SIZE': 32}), triton.Config(kwargs={'BLOCK_SIZE': 128})]
+
+    @triton.autotune(configs=configs, key=['N'], warmup=1, rep=1, fast_compile=True)
+    @triton.jit
+    def _kernel(dst, src, N, BLOCK_SIZE: tl.constexpr):
+        offsets = tl.program_id(0) * BLOCK_SIZE + tl.arange(0, BLOCK_SIZE)
+        x = tl.load(src + offsets, mask=offsets < N)
+        tl.store(dst + offsets, x, mask=offsets < N)
+
+    grid = lambda META: (triton.cdiv(N, META['BLOCK_SIZE']), )
+    _kernel[grid](dst, src, N)
+    torch.testing.assert_close(src, dst)
+    # the candidates are compiled at O1, the chosen config again at O3
+    kernels = _kernel.fn.cache[torch.cuda.current_device()].values()
+    levels = sorted(kernel.metadata.llvm_opt_level for kernel in kernels)
+    assert levels == [1, 1, 3]
+
+
+def test_compile_budget(tmp_path, monkeypatch):
+    monkeypatch.setenv("TRITON_CACHE_DIR", str(tmp_path))
+    N = 1024
+    src = torch.randn(N, device='cuda')
+    dst = torch.empty(N, device='cuda')
+    # the second config unrolls to thousands of instructions per thread
+    configs = [triton.Config(kwargs={'BLOCK_SIZE': 128}), triton.Config(kwargs={'BLOCK_SIZE': 1 << 17})]
+    budget = triton.compiler.CompileBudget(llvm_size=4096)
+
+    @triton.autotune(configs=configs, key=['N'], warmup=1, rep=1, compile_budget=budget)
+    @triton.jit
+    def _kernel(dst, src, N, BLOCK_SIZE: tl.constexpr):
+        offsets = tl.program_id(0) * BLOCK_SIZE + tl.arange(0, BLOCK_SIZE)
+        x = tl.load(src + offsets, mask=offsets < N)
+        tl.store(dst + offsets, x, mask=offsets < N)
+
+    grid = lambda META: (triton.cdiv(N, META['BLOCK_SIZE']), )
+    _kernel[grid](dst, src, N)
+    torch.testing.assert_close(src, dst)
+    assert _kernel.best_config.kwargs['BLOCK_SIZE'] == 128
+    assert _kernel.configs_timings[configs[1]][0] == float("inf")
+    # the budget also applies outside of tuning
+    with triton.compiler.compile_budget(budget):
+        with pytest.raises(triton.compiler.CompileBudgetExceeded, match="size budget"):
+            _kernel.fn[(1, )](dst, src, N, BLOCK_SIZE=1 << 16)
+
+
+@pytest.mark.skipif(torch.cuda.get_device_capability()[0] < 9, reason="requires clusters (SM90+)")
+def test_auto_num_ctas():
+    M = N = K = 512
+    a = torch.randn((M, K), device='cuda', dtype=torch.float16)
+    b = torch.randn((K, N), device='cuda', dtype=torch.float16)
+    c = torch.empty((M, N), device='cuda', dtype=torch.float32)
+    configs = [triton.Config(kwargs={'BLOCK_M': 128, 'BLOCK_N': 128, 'BLOCK_K': 64}, num_ctas="auto")]
+
+    @triton.autotune(configs=configs, key=['M', 'N', 'K'], warmup=1, rep=1)
+    @triton.jit
+    def _kernel(a, b, c, M, N, K, BLOCK_M: tl.constexpr, BLOCK_N: tl.constexpr, BLOCK_K: tl.constexpr):
+        offs_m = tl.program_id(0) * BLOCK_M + tl.arange(0, BLOCK_M)
+        offs_n = tl.program_id(1) * BLOCK_N + tl.arange(0, BLOCK_N)
+        offs_k = tl.arange(0, BLOCK_K)
+        acc = tl.zeros((BLOCK_M, BLOCK_N), dtype=tl.float32)
+        for k in range(0, K, BLOCK_K):
+            x = tl.load(a + offs_m[:, None] * K + (k + offs_k)[None, :])
+            y = tl.load(b + (k + offs_k)[:, None] * N + offs_n[None, :])
+            acc += tl.dot(x, y)
+        tl.store(c + offs_m[:, None] * N + offs_n[None, :], acc)
+
+    grid = lambda META: (triton.cdiv(M, META['BLOCK_M']), triton.cdiv(N, META['BLOCK_N']))
+    _kernel[grid](a, b, c, M, N, K)
+    torch.testing.assert_close(c, a.float() @ b.float(), atol=1e-2, rtol=1e-3)
+    # a 128x128 tile splits over 2x2 CTAs of 64x64, or 1x2 with less multicast
+    kernels = _kernel.fn.cache[torch.cuda.current_device()].values()
+    single = next(kernel for kernel in kernels if kernel.metadata.num_ctas == 1)
+    assert [list(dims) for dims in single.metadata.proposed_cluster_dims] == [[2, 2, 1], [1, 2, 1]]
+    tried = [config.num_ctas for config in _kernel.configs_timings]
+    assert tried[0] == 1 and set(tried) <= {1, 2, 4}
+    assert _kernel.best_config.num_ctas in tried
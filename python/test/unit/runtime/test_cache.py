@@ -1,7 +1,11 @@
 import importlib.util
 import os
 import shutil
+import subprocess
+import sys
 import tempfile
+import time
+from dataclasses import dataclass
 
 import pytest
 import torch
@@ -257,3 +261,397 @@ def test_memory_leak() -> None:
         x0 = xindex
         tmp0 = tl.load(in_ptr0 + (x0), xmask)
         tl.store(out_ptr0 + (x0 + tl.zeros([XBLOCK], tl.int32)), tmp0, xmask)
+
+
+def test_remote_cache_group(tmp_path, monkeypatch) -> None:
+    from triton.runtime import cache
+
+    store = {}
+
+    class DictBackend(cache.RemoteCacheBackend):
+
+        def __init__(self, key):
+            self.key = key
+
+        def get(self, filename):
+            return store.get((self.key, filename))
+
+        def put(self, filename, data):
+            store[(self.key, filename)] = data
+
+    monkeypatch.setattr(cache, "_remote_backend_cls", lambda: DictBackend)
+    monkeypatch.setenv("TRITON_CACHE_DIR", str(tmp_path / "host0"))
+    writer = cache.RemoteCacheManager("abc")
+    group = {name: writer.put(name.encode(), name) for name in ["k.cubin", "k.json"]}
+    writer.put_group("k.json", group)
+    assert len(store) == 1
+
+    # a second host with an empty local cache gets the whole group
+    monkeypatch.setenv("TRITON_CACHE_DIR", str(tmp_path / "host1"))
+    reader = cache.RemoteCacheManager("abc")
+    assert reader.get_file("k.json") is None
+    fetched = reader.get_group("k.json")
+    assert sorted(fetched) == ["k.cubin", "k.json"]
+    with open(fetched["k.cubin"], "rb") as f:
+        assert f.read() == b"k.cubin"
+    assert reader.get_file("k.json") == fetched["k.json"]
+    assert cache.RemoteCacheManager("other").get_group("k.json") is None
+
+
+def test_cache_size_limit(tmp_path, monkeypatch) -> None:
+    from triton.runtime.cache import FileCacheManager
+
+    monkeypatch.setenv("TRITON_CACHE_DIR", str(tmp_path))
+    monkeypatch.setenv("TRITON_CACHE_MAX_SIZE", "4K")
+    managers = [FileCacheManager(f"key{i}") for i in range(4)]
+    for i, manager in enumerate(managers[:3]):
+        group = {"k.bin": manager.put(b"x" * 1000, "k.bin")}
+        manager.put_group("k.bin", group)
+    # key0 is the least recently used directory once key1 is read again
+    assert managers[1].get_group("k.bin") is not None
+    managers[3].put(b"x" * 1000, "k.bin")
+    assert not (tmp_path / "key0").exists()
+    assert managers[0].get_group("k.bin") is None
+    for manager in managers[1:]:
+        assert manager.get_file("k.bin") is not None
+
+
+def test_group_with_missing_file(tmp_path, monkeypatch) -> None:
+    from triton.compiler.compiler import _load_cached_kernel
+    from triton.runtime.cache import FileCacheManager
+
+    monkeypatch.setenv("TRITON_CACHE_DIR", str(tmp_path))
+    manager = FileCacheManager("key")
+    group = {name: manager.put(name.encode("utf-8"), name) for name in ("k.json", "k.cubin")}
+    manager.put_group("k.json", group)
+    assert manager.get_group("k.json") == group
+    # e.g. removed by hand, or by a concurrent eviction: the lookup only reads
+    # the group file, and loading the kernel misses
+    os.remove(group["k.json"])
+    assert manager.get_group("k.json") == group
+    assert _load_cached_kernel(None, group) is None
+
+
+def test_triton_key_cached_on_disk(tmp_path, monkeypatch) -> None:
+    from triton.compiler import compiler
+
+    key = compiler.triton_key()
+    hashed = []
+    hash_file = compiler._hash_file
+    monkeypatch.setattr(compiler, "_hash_file", lambda path: hashed.append(path) or hash_file(path))
+    monkeypatch.setattr(compiler, "_triton_key_cache_paths", lambda: [str(tmp_path / "triton_key.json")])
+    compiler.triton_key.cache_clear()
+    try:
+        assert compiler.triton_key() == key
+        assert len(hashed) > 0
+        hashed.clear()
+        compiler.triton_key.cache_clear()
+        assert compiler.triton_key() == key
+        assert hashed == []
+    finally:
+        compiler.triton_key.cache_clear()
+
+
+def test_compile_timings(tmp_path, monkeypatch) -> None:
+    monkeypatch.setenv("TRITON_CACHE_DIR", str(tmp_path))
+
+    @triton.jit
+    def kernel_add(a, b, o, N: tl.constexpr):
+        idx = tl.arange(0, N)
+        tl.store(o + idx, tl.load(a + idx) + tl.load(b + idx))
+
+    triton.compiler.compile_timings(reset=True)
+    compiled = kernel_add.warmup(torch.float32, torch.float32, torch.float32, 32, grid=(1, ))
+    stage_timings = compiled.metadata.stage_timings
+    assert {"make_ir", "ttir", "ttgir", "llir"} <= set(stage_timings)
+    assert all(seconds >= 0 for seconds in stage_timings.values())
+    pass_timings = compiled.metadata.pass_timings
+    assert ["ttgir", "tritongpu-remove-layout-conversions"] in [entry[:2] for entry in pass_timings]
+    peak_memory = compiled.metadata.pass_peak_memory
+    assert ["ttgir", "tritongpu-remove-layout-conversions"] in [entry[:2] for entry in peak_memory]
+    assert all(peak > 0 for _, _, peak in peak_memory)
+    report = triton.compiler.compile_timings()
+    runs, seconds = report["passes"][("ttgir", "tritongpu-remove-layout-conversions")]
+    assert runs >= 2
+    assert report["stages"]["ttgir"] == pytest.approx(stage_timings["ttgir"])
+
+
+@pytest.mark.skipif(torch.version.hip is not None, reason="ptxas statistics are specific to CUDA")
+@pytest.mark.parametrize("in_process", ["0", "1"])
+def test_ptxas_info(in_process, tmp_path, monkeypatch) -> None:
+    monkeypatch.setenv("TRITON_CACHE_DIR", str(tmp_path))
+    monkeypatch.setenv("TRITON_PTX_IN_PROCESS", in_process)
+
+    @triton.jit
+    def kernel_add(a, b, o, N: tl.constexpr):
+        idx = tl.arange(0, N)
+        tl.store(o + idx, tl.load(a + idx) + tl.load(b + idx))
+
+    compiled = kernel_add.warmup(torch.float32, torch.float32, torch.float32, 32, grid=(1, ))
+    assert compiled.metadata.n_regs > 0
+    assert compiled.metadata.n_spills == 0
+    assert compiled.metadata.local_bytes == 0
+    compiled._init_handles()
+    assert compiled.metadata.n_regs == compiled.n_regs
+
+
+def test_stage_cache(tmp_path, monkeypatch) -> None:
+    from triton.compiler import compiler
+    monkeypatch.setenv("TRITON_CACHE_DIR", str(tmp_path))
+    codegen_calls = []
+    ast_to_ttir = compiler.ast_to_ttir
+    monkeypatch.setattr(compiler, "ast_to_ttir", lambda *args, **kwargs: codegen_calls.append(1) or ast_to_ttir(
+        *args, **kwargs))
+
+    @triton.jit
+    def kernel_add(a, b, o, N: tl.constexpr):
+        idx = tl.arange(0, N)
+        tl.store(o + idx, tl.load(a + idx) + tl.load(b + idx))
+
+    a = torch.randn(32, dtype=torch.float32, device="cuda")
+    o = torch.empty_like(a)
+    asm = dict()
+    for num_warps, num_stages, enable_fp_fusion in [(4, 3, True), (4, 2, True), (4, 2, False), (2, 2, False)]:
+        compiled = kernel_add[(1, )](a, a, o, 32, num_warps=num_warps, num_stages=num_stages,
+                                     enable_fp_fusion=enable_fp_fusion)
+        assert torch.equal(o, a + a)
+        assert compiled.metadata.num_warps == num_warps
+        asm[(num_warps, num_stages, enable_fp_fusion)] = compiled.asm
+    # of these options, TTIR only depends on num_warps, e.g. through `tl.extra.cuda.num_threads`
+    assert len(codegen_calls) == 2
+    assert len(set(asm[key]["ttir"] for key in [(4, 3, True), (4, 2, True), (4, 2, False)])) == 1
+    assert asm[(4, 2, True)]["ttgir"] == asm[(4, 2, False)]["ttgir"]
+
+
+def test_frontend_options() -> None:
+    from triton.compiler.code_generator import FrontendOptions
+
+    @dataclass(frozen=True)
+    class Options:
+        num_warps: int = 4
+        num_stages: int = 3
+
+    options = FrontendOptions(Options())
+    assert options.num_warps == 4
+    # an option missing from the TTIR cache key can't be read by the frontend
+    with pytest.raises(AttributeError, match="frontend_option_names"):
+        options.num_stages
+    # nor can the options a backend doesn't have
+    assert getattr(options, "profile_regions", 0) == 0
+
+
+def test_ptx_in_process(tmp_path, monkeypatch) -> None:
+    monkeypatch.setenv("TRITON_CACHE_DIR", str(tmp_path))
+
+    @triton.jit
+    def kernel_add(a, b, o, N: tl.constexpr):
+        idx = tl.arange(0, N)
+        tl.store(o + idx, tl.load(a + idx) + tl.load(b + idx))
+
+    a = torch.randn(32, dtype=torch.float32, device="cuda")
+    o = torch.empty_like(a)
+    monkeypatch.setenv("TRITON_PTX_IN_PROCESS", "1")
+    compiled = kernel_add[(1, )](a, a, o, 32)
+    assert torch.equal(o, a + a)
+    assert ["cubin", "ptx-jit"] in [entry[:2] for entry in compiled.metadata.pass_timings]
+    assert compiled.metadata.TRITON_PTX_IN_PROCESS
+
+
+def test_compile_stats(tmp_path, monkeypatch) -> None:
+    monkeypatch.setenv("TRITON_CACHE_DIR", str(tmp_path))
+    monkeypatch.setattr(JITFunction, "recompile_budget", 3)
+
+    @triton.jit
+    def kernel(X, n, BLOCK: tl.constexpr):
+        idx = tl.arange(0, BLOCK)
+        tl.store(X + idx, tl.load(X + idx) + n)
+
+    x = torch.zeros(64, device='cuda')
+    kernel[(1, )](x, 16, BLOCK=32)
+    kernel[(1, )](x, 32, BLOCK=32)
+    assert kernel.stats.as_dict() == {"compiles": 1, "cache_hits": 1, "changes": {}}
+    kernel[(1, )](x, 17, BLOCK=32)
+    kernel[(1, )](x, 17, BLOCK=64)
+    assert kernel.stats.changes == {"specialization:n": 1, "constexpr:BLOCK": 1}
+    assert not kernel.stats.warned
+    with pytest.warns(UserWarning, match="compiled 4 times"):
+        kernel[(1, )](x, 1, BLOCK=64)
+    stats = triton.runtime.compile_stats(reset=True)
+    assert stats[f"{kernel.module}:kernel"]["compiles"] == 4
+    assert kernel.stats.compiles == 0
+
+
+def test_compile_server(tmp_path, monkeypatch) -> None:
+    from triton.compiler import compiler
+    monkeypatch.setenv("TRITON_CACHE_DIR", str(tmp_path / "cache"))
+    path = str(tmp_path / "compile.sock")
+    server = subprocess.Popen([sys.executable, "-m", "triton.runtime.compile_server", path, "--workers", "2"])
+    try:
+        while not os.path.exists(path):
+            assert server.poll() is None
+            time.sleep(0.1)
+        monkeypatch.setenv("TRITON_COMPILE_SERVER", path)
+        # the client only lowers the kernel to Triton IR
+        backend_cls = type(compiler.make_backend(triton.runtime.driver.get_current_target()))
+        monkeypatch.setattr(backend_cls, "add_stages", lambda *args: pytest.fail("compiled locally"))
+
+        @triton.jit
+        def kernel_add(a, b, o, N: tl.constexpr):
+            idx = tl.arange(0, N)
+            tl.store(o + idx, tl.load(a + idx) + tl.load(b + idx))
+
+        a = torch.randn(32, dtype=torch.float32, device="cuda")
+        o = torch.empty_like(a)
+        kernel_add[(1, )](a, a, o, 32)
+        assert torch.equal(o, a + a)
+    finally:
+        server.terminate()
+        server.wait()
+
+
+def test_shared_memory_fallback(tmp_path, monkeypatch) -> None:
+    monkeypatch.setenv("TRITON_CACHE_DIR", str(tmp_path))
+
+    @triton.jit
+    def matmul(A, B, C, BLOCK: tl.constexpr, K: tl.constexpr):
+        offs = tl.arange(0, BLOCK)
+        offs_k = tl.arange(0, 64)
+        acc = tl.zeros((BLOCK, BLOCK), dtype=tl.float32)
+        for k in range(0, K, 64):
+            a = tl.load(A + offs[:, None] * K + (k + offs_k)[None, :])
+            b = tl.load(B + (k + offs_k)[:, None] * BLOCK + offs[None, :])
+            acc += tl.dot(a, b)
+        tl.store(C + offs[:, None] * BLOCK + offs[None, :], acc)
+
+    BLOCK, K = 128, 1024
+    a = torch.randn((BLOCK, K), dtype=torch.float16, device="cuda")
+    b = torch.randn((K, BLOCK), dtype=torch.float16, device="cuda")
+    c = torch.empty((BLOCK, BLOCK), dtype=torch.float32, device="cuda")
+    # 8 stages of 32 KB don't fit in the shared memory of any GPU
+    compiled = matmul[(1, )](a, b, c, BLOCK, K, num_warps=8, num_stages=8)
+    assert compiled.metadata.num_stages < 8
+    fallback = compiled.metadata.shared_memory_fallback
+    assert [entry["num_stages"] for entry in fallback] == list(range(8, compiled.metadata.num_stages, -1))
+    assert all(entry["shared"] > compiled.metadata.shared for entry in fallback)
+    torch.testing.assert_close(c, torch.matmul(a.float(), b.float()), atol=1e-2, rtol=1e-2)
+    # the result is cached under the options that were asked for
+    matmul.cache.clear()
+    assert matmul[(1, )](a, b, c, BLOCK, K, num_warps=8, num_stages=8).metadata == compiled.metadata
+
+
+def test_branch_profile(tmp_path, monkeypatch) -> None:
+    monkeypatch.setenv("TRITON_CACHE_DIR", str(tmp_path))
+    from triton.compiler.compiler import load_branch_profile
+
+    @triton.jit
+    def kernel(X, n):
+        pid = tl.program_id(0)
+        if pid < n:
+            tl.store(X + pid, 1)
+        else:
+            tl.store(X + pid, 2)
+
+    x = torch.zeros(8, dtype=torch.int32, device="cuda")
+    instrumented = kernel[(8, )](x, 6, branch_profile="instrument")
+    assert x.tolist() == [1] * 6 + [2] * 2
+    instrumented.save_branch_profile()
+    # reached by the 8 programs, taken by 6
+    assert load_branch_profile(instrumented.metadata.branch_profile_key) == [8, 6]
+    # the counters were reset
+    instrumented.save_branch_profile()
+    assert load_branch_profile(instrumented.metadata.branch_profile_key) == [8, 6]
+    x.zero_()
+    compiled = kernel[(8, )](x, 6, branch_profile="use")
+    assert x.tolist() == [1] * 6 + [2] * 2
+    assert compiled.metadata.branch_profile_key == instrumented.metadata.branch_profile_key
+    assert compiled.metadata.branch_profile_counts == [8, 6]
+    assert "branch_weights" in compiled.asm["llir"]
+
+
+def test_function_ir_reused(tmp_path, monkeypatch) -> None:
+    monkeypatch.setenv("TRITON_CACHE_DIR", str(tmp_path))
+    from triton.compiler import code_generator
+
+    class CountingCache(dict):
+        generated = 0
+
+        def __setitem__(self, key, value):
+            CountingCache.generated += 1
+            super().__setitem__(key, value)
+
+    monkeypatch.setattr(code_generator, "_function_cache", CountingCache())
+    x = torch.empty(1, dtype=torch.int32, device="cuda")
+    kernel[(1, )](x, 3, BLOCK=1)
+    assert x.item() == 6
+    assert CountingCache.generated == 2
+    # another specialization of the kernel links the IR of function_1 and
+    # function_2 instead of generating it again
+    x.zero_()
+    kernel[(1, )](x, 3, BLOCK=2)
+    assert x.item() == 6
+    assert CountingCache.generated == 2
+
+
+def test_function_ir_evicted(tmp_path, monkeypatch) -> None:
+    monkeypatch.setenv("TRITON_CACHE_DIR", str(tmp_path))
+    from triton.compiler import code_generator
+
+    class CountingCache(code_generator._LRUCache):
+        generated = 0
+
+        def __setitem__(self, key, value):
+            CountingCache.generated += 1
+            super().__setitem__(key, value)
+
+    monkeypatch.setattr(code_generator, "_function_cache", CountingCache(max_size=1))
+    x = torch.empty(1, dtype=torch.int32, device="cuda")
+    kernel[(1, )](x, 3, BLOCK=1)
+    assert x.item() == 6
+    assert CountingCache.generated == 2 and len(code_generator._function_cache) == 1
+    # function_2 was evicted by function_1, which can't be linked without it:
+    # both are generated again
+    x.zero_()
+    kernel[(1, )](x, 3, BLOCK=2)
+    assert x.item() == 6
+    assert CountingCache.generated == 4 and len(code_generator._function_cache) == 1
+
+
+def test_context_reused(tmp_path, monkeypatch) -> None:
+    monkeypatch.setenv("TRITON_CACHE_DIR", str(tmp_path))
+    from triton.compiler import compiler
+
+    class RecordingPool(compiler._ContextPool):
+        leased = []
+
+        def acquire(self, backend):
+            context = super().acquire(backend)
+            RecordingPool.leased.append(context)
+            return context
+
+    monkeypatch.setattr(compiler, "_context_pool", RecordingPool())
+    x = torch.empty(1, dtype=torch.int32, device="cuda")
+    for block in (1, 2, 4):
+        x.zero_()
+        kernel[(1, )](x, 3, BLOCK=block)
+        assert x.item() == 6
+    # the compilations run one after the other, so they all use the same
+    # context
+    assert len(RecordingPool.leased) == 3
+    assert all(context is RecordingPool.leased[0] for context in RecordingPool.leased)
+
+
+def test_binary_shared(tmp_path, monkeypatch) -> None:
+    monkeypatch.setenv("TRITON_CACHE_DIR", str(tmp_path))
+    x = torch.empty(1, dtype=torch.int32, device="cuda")
+    # BLOCK is not used by the kernel, so both specializations compile to the
+    # same binary
+    k1 = kernel[(1, )](x, 3, BLOCK=1)
+    k2 = kernel[(1, )](x, 3, BLOCK=2)
+    assert k1.metadata.hash != k2.metadata.hash
+    assert k1.metadata.binary_hash == k2.metadata.binary_hash
+    binaries = {kernel.metadata_group[f"{kernel.name}.cubin"] for kernel in (k1, k2)}
+    assert len(binaries) == 1
+    assert binaries.pop().startswith(str(tmp_path / "__blobs__"))
+    # loaded once
+    assert k1.function == k2.function
+    assert x.item() == 6
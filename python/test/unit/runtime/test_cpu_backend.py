@@ -0,0 +1,82 @@
+import os
+import subprocess
+import sys
+
+import pytest
+
+from triton.backends import backends
+
+# The driver is chosen once per process: the kernels run in a child process
+# with the CPU backend enabled
+KERNELS = """
+import torch
+import triton
+import triton.language as tl
+
+
+@triton.jit
+def add_kernel(x_ptr, y_ptr, out_ptr, n, BLOCK: tl.constexpr):
+    offsets = tl.program_id(0) * BLOCK + tl.arange(0, BLOCK)
+    mask = offsets < n
+    x = tl.load(x_ptr + offsets, mask=mask)
+    y = tl.load(y_ptr + offsets, mask=mask)
+    tl.store(out_ptr + offsets, x + y, mask=mask)
+
+
+@triton.jit
+def matmul_kernel(a_ptr, b_ptr, c_ptr, M: tl.constexpr, N: tl.constexpr, K: tl.constexpr):
+    rm = tl.arange(0, M)
+    rn = tl.arange(0, N)
+    rk = tl.arange(0, K)
+    a = tl.load(a_ptr + rm[:, None] * K + rk[None, :])
+    b = tl.load(b_ptr + rk[:, None] * N + rn[None, :])
+    tl.store(c_ptr + rm[:, None] * N + rn[None, :], tl.dot(a, b))
+
+
+@triton.jit
+def row_sum_kernel(x_ptr, out_ptr, N: tl.constexpr):
+    row = tl.program_id(0)
+    x = tl.load(x_ptr + row * N + tl.arange(0, N))
+    tl.store(out_ptr + row, tl.sum(x, axis=0))
+
+
+@triton.jit
+def load_rows_kernel(x_ptr, rows_ptr, out_ptr, N: tl.constexpr, ROWS: tl.constexpr):
+    rows = tl.load(rows_ptr + tl.arange(0, ROWS))
+    cols = tl.arange(0, N)
+    x = tl.load_rows(x_ptr, rows, cols, N)
+    tl.store(out_ptr + tl.arange(0, ROWS)[:, None] * N + cols[None, :], x)
+
+
+n = 1000
+x = torch.rand(n)
+y = torch.rand(n)
+out = torch.empty(n)
+add_kernel[(triton.cdiv(n, 128), )](x, y, out, n, BLOCK=128)
+torch.testing.assert_close(out, x + y)
+
+a = torch.rand(16, 32)
+b = torch.rand(32, 16)
+c = torch.empty(16, 16)
+matmul_kernel[(1, )](a, b, c, 16, 16, 32)
+torch.testing.assert_close(c, a @ b)
+
+x = torch.rand(64, 256)
+out = torch.empty(64)
+row_sum_kernel[(64, )](x, out, 256)
+torch.testing.assert_close(out, x.sum(1))
+
+# tl.load_rows is a tl.load of gathered rows: the columns of each row are
+# contiguous vector loads
+x = torch.rand(64, 32)
+rows = torch.randint(0, 64, (16, ), dtype=torch.int32)
+out = torch.empty(16, 32)
+load_rows_kernel[(1, )](x, rows, out, 32, 16)
+torch.testing.assert_close(out, x[rows.long()])
+"""
+
+
+@pytest.mark.skipif("cpu" not in backends, reason="the CPU backend is not built")
+def test_cpu_backend(tmp_path):
+    env = dict(os.environ, TRITON_CPU_BACKEND="1", TRITON_CACHE_DIR=str(tmp_path))
+    subprocess.run([sys.executable, "-c", KERNELS], env=env, check=True)
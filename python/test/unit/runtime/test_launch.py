@@ -7,6 +7,7 @@ import gc
 # import time
 import tracemalloc
 
+import pytest
 import torch
 
 import triton
@@ -43,6 +44,291 @@ def test_memory_leak() -> None:
         tracemalloc.stop()
 
 
+def test_cached_launch() -> None:
+
+    @triton.jit
+    def kernel(in_ptr0, out_ptr0, xnumel, XBLOCK: tl.constexpr):
+        xindex = tl.program_id(0) * XBLOCK + tl.arange(0, XBLOCK)
+        xmask = xindex < xnumel
+        tmp0 = tl.load(in_ptr0 + xindex, xmask)
+        tl.store(out_ptr0 + xindex, tmp0, xmask)
+
+    inp = torch.randn(100, device='cuda')
+    device = torch.cuda.current_device()
+    grid = lambda META: (triton.cdiv(META['xnumel'], META['XBLOCK']), )
+    # the first launch compiles, the following ones must hit the cache
+    # regardless of how arguments and options are passed
+    for launch in [
+            lambda out: kernel[grid](inp, out, 100, XBLOCK=16),
+            lambda out: kernel[grid](inp, out, 100, 16),
+            lambda out: kernel[grid](inp, out, xnumel=100, XBLOCK=16),
+            lambda out: kernel[grid](inp, out_ptr0=out, xnumel=100, XBLOCK=16, num_warps=4),
+    ]:
+        out = torch.zeros_like(inp)
+        launch(out)
+        torch.testing.assert_close(inp, out)
+        assert len(kernel.cache[device]) == 1
+    # a different specialization must not be served from the cache
+    out = torch.zeros_like(inp)
+    kernel[grid](inp, out, 100, XBLOCK=32)
+    torch.testing.assert_close(inp, out)
+    assert len(kernel.cache[device]) == 2
+
+
+def test_direct_launch(monkeypatch) -> None:
+
+    @triton.jit
+    def kernel(in_ptr0, out_ptr0, xnumel, XBLOCK: tl.constexpr):
+        xindex = tl.program_id(0) * XBLOCK + tl.arange(0, XBLOCK)
+        xmask = xindex < xnumel
+        tl.store(out_ptr0 + xindex, tl.load(in_ptr0 + xindex, xmask) + 1, xmask)
+
+    inp = torch.randn(100, device='cuda')
+    out = torch.zeros_like(inp)
+    compiled = kernel[(7, )](inp, out, 100, XBLOCK=16)
+
+    # cache hits call the C entry point of the launcher, not the launcher
+    def fail(*args, **kwargs):
+        raise AssertionError("launched through Python")
+
+    monkeypatch.setattr(type(compiled.run), "__call__", fail)
+    entered = []
+    monkeypatch.setattr(triton.compiler.CompiledKernel, "launch_enter_hook", lambda *args: entered.append(args))
+    out = torch.zeros_like(inp)
+    kernel[(7, )](inp, out, 100, XBLOCK=16)
+    torch.testing.assert_close(out, inp + 1)
+    assert len(entered) == 1 and entered[0][:3] == (7, 1, 1) and entered[0][13] is compiled.metadata
+
+
+def test_graph_capture() -> None:
+
+    @triton.jit
+    def add_one(in_ptr0, out_ptr0, xnumel, XBLOCK: tl.constexpr):
+        xindex = tl.program_id(0) * XBLOCK + tl.arange(0, XBLOCK)
+        xmask = xindex < xnumel
+        tmp0 = tl.load(in_ptr0 + xindex, xmask)
+        tl.store(out_ptr0 + xindex, tmp0 + 1, xmask)
+
+    x = torch.zeros(100, device='cuda')
+    y = torch.empty_like(x)
+    z = torch.empty_like(x)
+    grid = (7, )
+    # compile outside of the capture
+    add_one[grid](x, y, 100, XBLOCK=16)
+    stream = torch.cuda.Stream()
+    with torch.cuda.stream(stream):
+        with triton.runtime.driver.graph() as graph:
+            add_one[grid](x, y, 100, XBLOCK=16)
+            add_one[grid](y, z, 100, XBLOCK=16)
+        y.zero_()
+        z.zero_()
+        graph.replay()
+        stream.synchronize()
+        torch.testing.assert_close(z, x + 2)
+        # point the second launch at a different output
+        w = torch.zeros_like(x)
+        graph.update(1, y, w, 100)
+        graph.replay()
+        stream.synchronize()
+        torch.testing.assert_close(w, x + 2)
+
+
+def test_launch_batch() -> None:
+
+    @triton.jit
+    def add(in_ptr0, out_ptr0, xnumel, VALUE: tl.constexpr, XBLOCK: tl.constexpr):
+        xindex = tl.program_id(0) * XBLOCK + tl.arange(0, XBLOCK)
+        xmask = xindex < xnumel
+        tmp0 = tl.load(in_ptr0 + xindex, xmask)
+        tl.store(out_ptr0 + xindex, tmp0 + VALUE, xmask)
+
+    x = torch.zeros(100, device='cuda')
+    y = torch.empty_like(x)
+    z = torch.empty_like(x)
+    add_one = add.warmup(x, y, 100, VALUE=1, XBLOCK=16, grid=(1, ))
+    add_two = add.warmup(x, y, 100, VALUE=2, XBLOCK=16, grid=(1, ))
+    grid = (7, 1, 1)
+    triton.compiler.launch_batch([(add_one, grid, (x, y, 100)), (add_two, grid, (y, z, 100))])
+    torch.testing.assert_close(z, x + 3)
+
+
+
+@pytest.mark.parametrize("compiled_launcher", ["0", "1"])
+def test_launcher_arg_types(compiled_launcher, monkeypatch) -> None:
+    monkeypatch.setenv("TRITON_COMPILED_LAUNCHER", compiled_launcher)
+
+    @triton.jit
+    def kernel(out_ptr, a, b, c, d, e, BLOCK: tl.constexpr):
+        offs = tl.arange(0, BLOCK)
+        value = a.to(tl.float64) + b.to(tl.float64) + c.to(tl.float64) + d.to(tl.float64) + e.to(tl.float64)
+        tl.store(out_ptr + offs, value + tl.zeros([BLOCK], tl.float64))
+
+    out = torch.empty(16, dtype=torch.float64, device='cuda')
+    kernel[(1, )](out, 3, 2**40, 0.5, 7, 2**63 + 2**20, BLOCK=16)
+    torch.testing.assert_close(out, torch.full_like(out, 10.5 + 2**40 + 2**63 + 2**20))
+    kernel[(1, )](out, -3, -2**40, -0.5, 7, 2**63, BLOCK=16)
+    torch.testing.assert_close(out, torch.full_like(out, 3.5 - 2**40 + 2**63))
+    with pytest.raises(ValueError, match="cannot be accessed"):
+        kernel[(1, )](out.cpu(), 3, 2**40, 0.5, 7, 2**63, BLOCK=16)
+
+
+@pytest.mark.parametrize("compiled_launcher", ["0", "1"])
+def test_launcher_small_int_types(compiled_launcher, monkeypatch) -> None:
+    from triton.compiler import ASTSource
+    monkeypatch.setenv("TRITON_COMPILED_LAUNCHER", compiled_launcher)
+
+    @triton.jit
+    def kernel(out_ptr, a, b, c, d, BLOCK: tl.constexpr):
+        value = a.to(tl.int64) + b.to(tl.int64) + c.to(tl.int64) + d.to(tl.int64)
+        tl.store(out_ptr + tl.arange(0, BLOCK), value + tl.zeros([BLOCK], tl.int64))
+
+    # the JIT never specializes scalars to these types, only explicit signatures do
+    signature = {0: "*i64", 1: "i8", 2: "i16", 3: "u8", 4: "u16"}
+    compiled = triton.compile(ASTSource(fn=kernel, signature=signature, constants={5: 16}))
+    out = torch.empty(16, dtype=torch.int64, device='cuda')
+    compiled[(1, 1, 1)](out, -3, -300, 200, 60000)
+    torch.testing.assert_close(out, torch.full_like(out, -3 - 300 + 200 + 60000))
+
+
+def test_persistent_grid() -> None:
+
+    @triton.jit
+    def add_one(x_ptr, n_tiles, BLOCK: tl.constexpr):
+        for tile in range(tl.program_id(0), n_tiles, tl.num_programs(0)):
+            offsets = tile * BLOCK + tl.arange(0, BLOCK)
+            tl.store(x_ptr + offsets, tl.load(x_ptr + offsets) + 1)
+
+    x = torch.zeros(1 << 20, device='cuda')
+    n_tiles = x.numel() // 128
+    kernel = add_one[triton.runtime.PersistentGrid()](x, n_tiles, BLOCK=128)
+    torch.testing.assert_close(x, torch.ones_like(x))
+    occupancy = kernel.occupancy()
+    num_sms = torch.cuda.get_device_properties(x.device).multi_processor_count
+    assert occupancy["num_sms"] == num_sms
+    assert occupancy["max_active_ctas_per_sm"] >= 1
+    assert occupancy["max_active_clusters"] is None
+    assert kernel.max_resident_programs() == num_sms * occupancy["max_active_ctas_per_sm"]
+    # the grid never exceeds the amount of work
+    add_one[triton.runtime.PersistentGrid(lambda META: META['n_tiles'])](x, 3, BLOCK=128)
+    assert x[:3 * 128].eq(2).all() and x[3 * 128:].eq(1).all()
+    # a grid function may return a persistent grid, also on cache hits
+    for _ in range(2):
+        add_one[lambda META: triton.runtime.PersistentGrid(META['n_tiles'])](x, 3, BLOCK=128)
+    assert x[:3 * 128].eq(4).all() and x[3 * 128:].eq(1).all()
+
+
+def test_workspace() -> None:
+
+    # a row sum through partial sums in the workspace
+    @triton.heuristics({"partials": lambda args: triton.Workspace(args["n_rows"] * 16, torch.float32, zero=True)})
+    @triton.jit
+    def row_sum(x_ptr, out_ptr, partials, n_rows, BLOCK: tl.constexpr):
+        row = tl.program_id(0)
+        offsets = tl.arange(0, BLOCK)
+        partials += row * 4
+        for i in range(4):
+            x = tl.load(x_ptr + (row * 4 + i) * BLOCK + offsets)
+            # zeroed before the kernel runs
+            tl.store(partials + i, tl.load(partials + i) + tl.sum(x))
+        tl.store(out_ptr + row, tl.sum(tl.load(partials + tl.arange(0, 4))))
+
+    allocated = []
+
+    def allocator(nbytes, device, stream):
+        allocated.append(nbytes)
+        return torch.empty(nbytes, dtype=torch.uint8, device='cuda')
+
+    triton.set_workspace_allocator(allocator)
+    try:
+        for n_rows in [8, 4, 64]:
+            x = torch.randn((n_rows, 4 * 128), device='cuda')
+            out = torch.empty(n_rows, device='cuda')
+            row_sum[(n_rows, )](x, out, n_rows=n_rows, BLOCK=128)
+            torch.testing.assert_close(out, x.sum(1), rtol=1e-4, atol=1e-4)
+        # the buffer of the stream is reused until a larger workspace is needed
+        assert allocated == [256, 1024]
+    finally:
+        triton.set_workspace_allocator(None)
+
+
+@pytest.mark.skipif(torch.cuda.device_count() < 2, reason="requires two GPUs")
+def test_shared_across_devices() -> None:
+
+    @triton.jit
+    def copy(in_ptr0, out_ptr0, XBLOCK: tl.constexpr):
+        xindex = tl.arange(0, XBLOCK)
+        tl.store(out_ptr0 + xindex, tl.load(in_ptr0 + xindex))
+
+    if torch.cuda.get_device_capability(0) != torch.cuda.get_device_capability(1):
+        pytest.skip("requires two GPUs of the same architecture")
+    kernels = []
+    for device in range(2):
+        with torch.cuda.device(device):
+            x = torch.randn(16, device='cuda')
+            y = torch.empty_like(x)
+            kernels.append(copy[(1, )](x, y, XBLOCK=16))
+            torch.testing.assert_close(x, y)
+    # the second device reuses the binary but loads its own module
+    assert kernels[0] is not kernels[1]
+    assert kernels[0].asm is kernels[1].asm
+    assert kernels[0].module != kernels[1].module
+    assert len(copy.cache[0]) == len(copy.cache[1]) == 1
+
+
+def test_preload(tmp_path) -> None:
+    import concurrent.futures
+
+    @triton.jit
+    def add(in_ptr0, out_ptr0, xnumel, VALUE: tl.constexpr, XBLOCK: tl.constexpr):
+        xindex = tl.program_id(0) * XBLOCK + tl.arange(0, XBLOCK)
+        xmask = xindex < xnumel
+        tmp0 = tl.load(in_ptr0 + xindex, xmask)
+        tl.store(out_ptr0 + xindex, tmp0 + VALUE, xmask)
+
+    x = torch.zeros(100, device='cuda')
+    y = torch.empty_like(x)
+    kernels = [add.warmup(x, y, 100, VALUE=value, XBLOCK=16, grid=(1, )) for value in range(4)]
+    manifest = tmp_path / "manifest.json"
+    triton.compiler.write_preload_manifest(manifest, kernels)
+    futures = triton.compiler.preload(str(manifest))
+    concurrent.futures.wait(futures)
+    assert all(future.result() for future in futures)
+    # kernels re-created from the cache pick up the preloaded modules
+    device = torch.cuda.current_device()
+    add.cache[device].clear()
+    kernel = add.warmup(x, y, 100, VALUE=2, XBLOCK=16, grid=(1, ))
+    kernel._init_handles()
+    preloaded = triton.compiler.compiler._preloaded_handles[(kernel.metadata.hash, device)]
+    assert (kernel.module, kernel.function) == preloaded[:2]
+    add[(7, )](x, y, 100, VALUE=2, XBLOCK=16)
+    torch.testing.assert_close(y, x + 2)
+
+
+def test_do_bench_kernel_only() -> None:
+    import time
+
+    @triton.jit
+    def add_one(x_ptr, XBLOCK: tl.constexpr):
+        xindex = tl.program_id(0) * XBLOCK + tl.arange(0, XBLOCK)
+        tl.store(x_ptr + xindex, tl.load(x_ptr + xindex) + 1)
+
+    x = torch.zeros(1024, device='cuda')
+
+    def fn():
+        # host-side overhead between the launches
+        add_one[(8, )](x, XBLOCK=128)
+        time.sleep(2e-3)
+        add_one[(8, )](x, XBLOCK=128)
+
+    hooks = (triton.compiler.CompiledKernel.launch_enter_hook, triton.compiler.CompiledKernel.launch_exit_hook)
+    events_ms = triton.testing.do_bench(fn, warmup=1, rep=20)
+    kernel_ms = triton.testing.do_bench(fn, warmup=1, rep=20, measure="kernel")
+    assert events_ms >= 2
+    assert kernel_ms < 1
+    # the launch hooks are restored
+    assert (triton.compiler.CompiledKernel.launch_enter_hook, triton.compiler.CompiledKernel.launch_exit_hook) == hooks
+
+
 # LATENCY_THRESHOLD_US = 46
 
 # def test_kernel_launch_latency() -> None:
@@ -104,3 +390,102 @@ def test_memory_leak() -> None:
 
 #     # Run empty, which would run empty_kernel internally
 #     empty(*kernel_args)
+
+
+def test_compile_many() -> None:
+    from triton.compiler import ASTSource
+
+    @triton.jit
+    def add(in_ptr0, out_ptr0, xnumel, VALUE: tl.constexpr, XBLOCK: tl.constexpr):
+        xindex = tl.program_id(0) * XBLOCK + tl.arange(0, XBLOCK)
+        xmask = xindex < xnumel
+        tmp0 = tl.load(in_ptr0 + xindex, xmask)
+        tl.store(out_ptr0 + xindex, tmp0 + VALUE, xmask)
+
+    signature = {0: "*fp32", 1: "*fp32", 2: "i32"}
+    srcs = [ASTSource(fn=add, signature=signature, constants={3: value, 4: 16}) for value in range(4)]
+    kernels = triton.compiler.compile_many(srcs, options=[{"num_warps": 1}, {"num_warps": 2}, None, None])
+    assert [kernel.metadata.num_warps for kernel in kernels[:2]] == [1, 2]
+    x = torch.zeros(100, device='cuda')
+    for value, kernel in enumerate(kernels):
+        y = torch.empty_like(x)
+        kernel[(7, 1, 1)](x, y, 100)
+        torch.testing.assert_close(y, x + value)
+
+
+def test_async_compile() -> None:
+
+    @triton.jit
+    def add(in_ptr0, out_ptr0, xnumel, XBLOCK: tl.constexpr):
+        xindex = tl.program_id(0) * XBLOCK + tl.arange(0, XBLOCK)
+        xmask = xindex < xnumel
+        tl.store(out_ptr0 + xindex, tl.load(in_ptr0 + xindex, xmask) + 1, xmask)
+
+    add.set_async_compile()
+    x = torch.zeros(128, device='cuda')
+    y = torch.empty_like(x)
+    fallback = add[(8, )](x, y, 128, XBLOCK=16)
+    torch.testing.assert_close(y, x + 1)
+    device = torch.cuda.current_device()
+    # the generic kernel, without divisibility hints
+    assert [key[2][0] for key in add.cache[device]] == ["generic"]
+    for future in list(add._pending.values()):
+        future.result()
+    y.zero_()
+    kernel = add[(8, )](x, y, 128, XBLOCK=16)
+    torch.testing.assert_close(y, x + 1)
+    assert kernel is not fallback and len(add.cache[device]) == 2
+    # compiled kernels are launched directly
+    assert add[(8, )](x, y, 128, XBLOCK=16) is kernel
+
+    calls = []
+    add.set_async_compile(lambda *args, grid, **kwargs: calls.append(args))
+    add[(8, )](x, y, 100, XBLOCK=16)
+    assert len(calls) == 1
+
+
+def test_fused_launches() -> None:
+
+    @triton.jit
+    def scale(x_ptr, y_ptr, alpha, n, BLOCK: tl.constexpr):
+        offsets = tl.program_id(0) * BLOCK + tl.arange(0, BLOCK)
+        mask = offsets < n
+        tl.store(y_ptr + offsets, tl.load(x_ptr + offsets, mask=mask) * alpha, mask=mask)
+
+    @triton.jit
+    def row_sum(x_ptr, y_ptr, N: tl.constexpr):
+        row = tl.program_id(1) * tl.num_programs(0) + tl.program_id(0)
+        tl.store(y_ptr + row, tl.sum(tl.load(x_ptr + row * N + tl.arange(0, N)), axis=0))
+
+    a = torch.randn(1000, device='cuda')
+    b = torch.empty_like(a)
+    c = torch.randn((6, 64), device='cuda')
+    d = torch.empty(6, device='cuda')
+    e = torch.randn(1, device='cuda')
+    f = torch.empty_like(e)
+    device = torch.cuda.current_device()
+    for _ in range(2):
+        b.zero_()
+        d.zero_()
+        f.zero_()
+        with triton.fused_launches():
+            assert scale[(triton.cdiv(1000, 128), )](a, b, 2.0, 1000, BLOCK=128) is None
+            row_sum[(3, 2)](c, d, N=64)
+            # `n` is specialized as equal to 1
+            scale[(1, )](e, f, 3.0, 1, BLOCK=128)
+            # nothing runs until the block exits
+            assert not d.any()
+        torch.testing.assert_close(b, a * 2)
+        torch.testing.assert_close(d, c.sum(1))
+        torch.testing.assert_close(f, e * 3)
+    # one kernel, compiled once, instead of the three specializations
+    assert len(triton.runtime.fusion._fused_kernels[device]) == 1
+    assert not scale.cache[device] and not row_sum.cache[device]
+    # split-K and persistent kernels change their grid at launch, so they are not fused
+    for options in [{"split_k": 2}, {"persistent": True}]:
+        with pytest.raises(ValueError, match="can't be fused"):
+            with triton.fused_launches():
+                scale[(1, )](e, f, 3.0, 1, BLOCK=128, **options)
+    with pytest.raises(TypeError, match="can't be fused"):
+        with triton.fused_launches():
+            scale[triton.runtime.PersistentGrid()](e, f, 3.0, 1, BLOCK=128)
@@ -5,6 +5,7 @@ import sys
 import tempfile
 
 import numpy as np
+import pytest
 
 import triton
 from triton.backends.nvidia.driver import include_dir, library_dir
@@ -111,7 +112,9 @@ def gen_kernel_library(dir, libname):
     )
 
 
-def gen_test_bin(dir, M, N, K, exe="test", algo_id=0):
+def gen_test_bin(dir, M, N, K, exe="test", algo_id=0, load="all"):
+    # kernels are loaded on first use unless preloaded, all at once or one algo at a time
+    load_src = {"all": "load_matmul_fp16();", "algo": f"load_matmul_fp16_algo({algo_id});", "lazy": ""}[load]
     test_src = f"""
 int main(int argc, char **argv) {{
   int M = {M}, N = {N}, K = {K};
@@ -129,7 +132,7 @@ int main(int argc, char **argv) {{
   cuMemAlloc(&B, K * N * 2);
   cuMemAlloc(&C, M * N * 4);
   cuStreamCreate(&stream, 0);
-  load_matmul_fp16();
+  {load_src}
 
   // initialize input data
   int16_t hA[M*K];
@@ -205,7 +208,7 @@ def write_triton_kernels(dir, src, util_src):
     return kernel_path
 
 
-def _compile_kernel(dir, signature, kernel_name, out_name, out_path, num_warps, grid, kernel_path):
+def _compile_kernel(dir, signature, kernel_name, out_name, out_path, num_warps, grid, kernel_path, target=None):
     compiler_path = os.path.join(triton.tools.__path__[0], "compile.py")
 
     subprocess.run(
@@ -225,7 +228,7 @@ def _compile_kernel(dir, signature, kernel_name, out_name, out_path, num_warps,
             "-g",
             grid,
             kernel_path,
-        ],
+        ] + (["--target", target] if target is not None else []),
         check=True,
         cwd=dir,
     )
@@ -350,6 +353,45 @@ def test_compile_link_matmul():
         np.testing.assert_allclose(c_tri, c_ref * c_ref, atol=1e-4, rtol=0.0)
 
 
+def test_compile_link_matmul_multi_target():
+    np.random.seed(3)
+
+    with tempfile.TemporaryDirectory() as tmp_dir:
+        dtype = "fp16"
+        BM, BN, BK = 16, 16, 16
+
+        kernel_path = write_triton_kernels(tmp_dir, kernel_src, kernel_utils_src)
+        # an image for an older capability of the same major, and one for another major
+        _, capability = triton.runtime.driver.get_current_target()
+        targets = sorted({capability // 10 * 10, capability, 80 if capability >= 90 else 90})
+        sig = f"*fp32:16, *{dtype}:16, *{dtype}:16, i32, i32, i32, i32, i32:1, i32, i32:1, i32:16, i32:1, {BM}, {BN}, {BK}"
+        _compile_kernel(dir=tmp_dir, signature=sig, kernel_name="kernel", out_name=f"matmul_{dtype}",
+                        out_path=f"matmul_{dtype}", num_warps=1, grid=f"M/{BM}, N/{BN}, 1", kernel_path=kernel_path,
+                        target=",".join(map(str, targets)))
+        sources = glob.glob(os.path.join(tmp_dir, "matmul_*.c"))
+        assert all(f"_cubin_sm{cc}[" in open(sources[0]).read() for cc in targets)
+        link_aot_kernels(tmp_dir)
+
+        # compile test case
+        M, N, K = 16, 16, 16
+        gen_kernel_library(tmp_dir, "libkernel.so")
+        gen_test_bin(tmp_dir, M, N, K)
+
+        # initialize test data
+        a, b, a_path, b_path, c_path = generate_matmul_test_data(tmp_dir, M, N, K)
+
+        # run test case
+        env = os.environ.copy()
+        env["LD_LIBRARY_PATH"] = tmp_dir
+        subprocess.run(["./test", a_path, b_path, c_path], env=env, check=True, cwd=tmp_dir)
+
+        # read data and compare against reference
+        c = np.genfromtxt(c_path, delimiter=",", dtype=np.int32)
+        c_tri = c.reshape((M, N)).view(np.float32)
+        c_ref = np.matmul(a.astype(np.float32), b.astype(np.float32))
+        np.testing.assert_allclose(c_tri, c_ref * c_ref, atol=1e-4, rtol=0.0)
+
+
 def test_launcher_has_no_available_kernel():
     np.random.seed(3)
 
@@ -385,7 +427,8 @@ def test_launcher_has_no_available_kernel():
         assert "kernel launch failed" in result.stderr
 
 
-def test_compile_link_autotune_matmul():
+@pytest.mark.parametrize("load", ["all", "algo", "lazy"])
+def test_compile_link_autotune_matmul(load):
     np.random.seed(3)
 
     with tempfile.TemporaryDirectory() as tmp_dir:
@@ -417,7 +460,7 @@ def test_compile_link_autotune_matmul():
         for algo_id in range(len(tile_sizes)):
             # generate and run test case
             test_name = f"test_{algo_id}"
-            gen_test_bin(tmp_dir, M, N, K, exe=test_name, algo_id=algo_id)
+            gen_test_bin(tmp_dir, M, N, K, exe=test_name, algo_id=algo_id, load=load)
 
             env = os.environ.copy()
             env["LD_LIBRARY_PATH"] = tmp_dir
@@ -0,0 +1,22 @@
+import pytest
+
+import triton
+from triton.runtime.driver import driver
+from triton.tools import bench_layouts
+
+
+@pytest.mark.parametrize("name, kind, layouts, shape, dtype", list(bench_layouts.cases()))
+def test_bench_layouts(name, kind, layouts, shape, dtype, tmp_path):
+    result = bench_layouts.bench_case(kind, layouts, shape, dtype, 4, tmp_path)
+    assert result["us_per_iter"] > 0
+    assert result["bank_conflicts"] is None or result["bank_conflicts"] >= 1
+
+
+def test_make_kernel(tmp_path):
+    capability = driver.get_current_target()[1]
+    for _, kind, layouts, shape, dtype in bench_layouts.cases():
+        src, conversions, _ = bench_layouts.make_kernel(kind, layouts, shape, dtype, capability)
+        assert src.count("triton_gpu.convert_layout") >= conversions
+        path = tmp_path / "convert_layout.ttgir"
+        path.write_text(src)
+        assert "convert_layout" in triton.compile(str(path)).asm["ptx"]
@@ -0,0 +1,67 @@
+import json
+import subprocess
+import sys
+
+import pytest
+
+import triton
+from triton.tools import compare_perf
+
+
+def _bench(values):
+
+    @triton.testing.perf_report(
+        triton.testing.Benchmark(x_names=["N"], x_vals=[1, 2], line_arg="provider", line_vals=["a", "b"],
+                                 line_names=["A", "B"], plot_name="bench", args={}, ylabel="GB/s"))
+    def bench(N, provider):
+        value, low, high = values[provider]
+        return value * N, low * N, high * N
+
+    return bench
+
+
+def test_compare_perf(tmp_path):
+    baseline, current = tmp_path / "baseline.json", tmp_path / "current.json"
+    _bench({"a": (10, 9, 11), "b": (10, 9, 11)}).run(save_json=str(baseline))
+    # "b" is slower, but within noise
+    _bench({"a": (5, 4, 6), "b": (9, 8, 10)}).run(save_json=str(current))
+    report = json.loads(current.read_text())
+    assert report["environment"]["triton_key"]
+    assert len(report["benchmarks"][0]["results"]) == 4
+    regressions = triton.testing.compare_perf_reports(str(baseline), str(current))
+    assert sorted((r["line"], r["x"]["N"]) for r in regressions) == [("A", 1), ("A", 2)]
+    assert all(abs(r["change"] + 0.5) < 1e-6 for r in regressions)
+    assert not triton.testing.compare_perf_reports(str(current), str(baseline))
+    cmd = [sys.executable, compare_perf.__file__]
+    assert subprocess.run(cmd + [str(baseline), str(current)]).returncode == 1
+    assert subprocess.run(cmd + [str(current), str(baseline)]).returncode == 0
+
+
+def test_save_json_merges(tmp_path, monkeypatch):
+    path = tmp_path / "results.json"
+    monkeypatch.setenv("TRITON_BENCH_JSON", str(path))
+    _bench({"a": (1, 1, 1), "b": (1, 1, 1)}).run()
+    other = _bench({"a": (1, 1, 1), "b": (1, 1, 1)})
+    other.benchmarks.plot_name = "other"
+    other.run()
+    other.run()
+    assert sorted(bench["plot_name"] for bench in json.loads(path.read_text())["benchmarks"]) == ["bench", "other"]
+
+
+def test_roofline():
+    import torch
+
+    @triton.testing.perf_report(
+        triton.testing.Benchmark(x_names=["N"], x_vals=[1 << 20], line_arg="provider", line_vals=["copy"],
+                                 line_names=["Copy"], plot_name="", args={}, bytes_moved=lambda N, provider: 8 * N,
+                                 flops=lambda N, provider: N))
+    def bench(N, provider):
+        x = torch.randn(N, device="cuda")
+        return triton.testing.do_bench(lambda: x.clone(), quantiles=[0.5, 0.2, 0.8])
+
+    df = bench.run(return_df=True)
+    assert 0 < df["Copy-roofline"][0] < 100
+    ms = df["Copy"][0]
+    assert triton.testing.roofline_fraction(ms, 8 << 20) == pytest.approx(df["Copy-roofline"][0] / 100)
+    # the same work in half the time is twice as close to the roofline
+    assert triton.testing.roofline_fraction(ms / 2, 8 << 20) == pytest.approx(df["Copy-roofline"][0] / 50)
@@ -0,0 +1,32 @@
+import torch
+
+import triton
+import triton.language as tl
+from triton.tools import device_print
+
+
+@triton.jit
+def kernel(X, N: tl.constexpr):
+    offs = tl.arange(0, N)
+    x = tl.load(X + offs)
+    tl.device_print(" x: ", x)
+
+
+def test_device_print_buffer():
+    x = torch.arange(128, device="cuda", dtype=torch.float32)
+    compiled = kernel[(1, )](x, 128, num_warps=4, print_buffer=256)
+    torch.cuda.synchronize()
+    assert "vprintf" not in compiled.asm["llir"]
+    lines = device_print.decode(compiled)
+    expected = [f"pid (0, 0, 0) idx ({i}) x: {float(i):f}" for i in range(128)]
+    assert sorted(lines) == sorted(expected)
+    # the buffer was emptied
+    assert device_print.decode(compiled) == []
+
+
+def test_device_print_buffer_wraps():
+    x = torch.arange(128, device="cuda", dtype=torch.float32)
+    # only the last 64 of the 128 records are kept
+    compiled = kernel[(1, )](x, 128, num_warps=4, print_buffer=64)
+    torch.cuda.synchronize()
+    assert len(device_print.records(compiled)) == 64
@@ -0,0 +1,51 @@
+import pytest
+import torch
+
+import triton
+import triton.language as tl
+from triton.tools import line_profile
+
+
+@triton.jit
+def kernel(X, Y, N: tl.constexpr, ITERS: tl.constexpr):
+    offs = tl.program_id(0) * N + tl.arange(0, N)
+    x = tl.load(X + offs)
+    for _ in range(ITERS):
+        x = tl.exp(x) * 0.5
+    tl.store(Y + offs, x)
+
+
+def _lines(lines):
+    return {line.line for line in lines if line.file.endswith("test_line_profile.py")}
+
+
+def test_line_table():
+    compiled = kernel.warmup(torch.float32, torch.float32, 128, 16, grid=(1, ))
+    try:
+        table = line_profile.line_table(compiled.asm["cubin"])
+    except RuntimeError:
+        pytest.skip("nvdisasm is not available")
+    lines = {line for locations in table.values() for file, line in locations if file.endswith("test_line_profile.py")}
+    # the load, the loop and the store
+    assert {12, 14, 15} <= lines
+    compiled = kernel.warmup(torch.float32, torch.float32, 128, 16, grid=(1, ), line_info=False)
+    assert line_profile.line_table(compiled.asm["cubin"]) == {}
+
+
+def test_line_profile():
+    x = torch.randn(1024 * 128, device="cuda")
+    y = torch.empty_like(x)
+    compiled = kernel[(1024, )](x, y, 128, 64)
+    try:
+        with line_profile.Sampler(period=0) as sampler:
+            for _ in range(10):
+                kernel[(1024, )](x, y, 128, 64)
+    except RuntimeError as e:
+        pytest.skip(f"PC sampling is not available: {e}")
+    lines = line_profile.report(compiled, sampler)
+    assert sum(line.samples for line in lines) > 0
+    for line in lines:
+        assert sum(line.stalls.values()) == line.samples
+    # the samples of `tl.exp` go to the line of the loop calling it
+    assert 14 in _lines(lines)
+    assert "test_line_profile.py:14" in line_profile.format_lines(lines)
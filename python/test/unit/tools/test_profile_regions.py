@@ -0,0 +1,44 @@
+import torch
+
+import triton
+import triton.language as tl
+from triton.tools import profile_regions
+
+
+@triton.jit
+def kernel(X, Y, N: tl.constexpr, ITERS: tl.constexpr):
+    offs = tl.program_id(0) * N + tl.arange(0, N)
+    tl.profile_begin("load")
+    x = tl.load(X + offs)
+    tl.profile_end("load")
+    for _ in range(ITERS):
+        tl.profile_begin("math")
+        x = tl.exp(x) * 0.5
+        tl.profile_end("math")
+    tl.store(Y + offs, x)
+
+
+def test_profile_regions():
+    x = torch.randn(8 * 128, device="cuda")
+    y = torch.empty_like(x)
+    # only the first 4 of the 8 programs record
+    compiled = kernel[(8, )](x, y, 128, 3, num_warps=4, profile_regions=4)
+    assert compiled.metadata.profile_region_names == ["load", "math"]
+    regions = profile_regions.decode(compiled)
+    assert list(regions) == ["load", "math"]
+    assert regions["load"].warps == 4 * 4 and regions["load"].count == 4 * 4
+    assert regions["math"].warps == 4 * 4 and regions["math"].count == 4 * 4 * 3
+    for region in regions.values():
+        assert region.cycles > 0
+        assert 0 < region.start <= region.end
+    assert regions["load"].start <= regions["math"].start
+    # the records were reset
+    assert profile_regions.decode(compiled) == {}
+
+
+def test_profile_regions_off():
+    x = torch.randn(128, device="cuda")
+    y = torch.empty_like(x)
+    compiled = kernel[(1, )](x, y, 128, 1)
+    assert "profile_mark" not in compiled.asm["ttir"]
+    assert profile_regions.decode(compiled) == {}
@@ -0,0 +1,42 @@
+import subprocess
+import sys
+
+import torch
+
+import triton
+import triton.language as tl
+from triton.tools import reduce_perf
+
+
+@triton.jit
+def kernel(X, Y, N: tl.constexpr):
+    offs = tl.program_id(0) * N + tl.arange(0, N)
+    tl.store(Y + offs, tl.load(X + offs) * 2)
+
+
+def _interesting(path, *args):
+    cmd = [sys.executable, reduce_perf.__file__, *args, str(path)]
+    return subprocess.run(cmd).returncode == 1
+
+
+def test_reduce_perf(tmp_path):
+    x = torch.randn(1024, device="cuda")
+    y = torch.empty_like(x)
+    compiled = kernel[(8, )](x, y, 128)
+    path = tmp_path / "kernel.ttgir"
+    path.write_text(compiled.asm["ttgir"])
+    assert reduce_perf.measure(path, "shared", {}, [8], 1024, 0) == compiled.metadata.shared
+    assert reduce_perf.measure(path, "time", {}, [8], 1024, 0) > 0
+    assert _interesting(path, "--metric", "convert_layout", "--below", "1000")
+    assert not _interesting(path, "--metric", "convert_layout", "--above", "1000")
+    assert _interesting(path, "--metric", "time", "--above", "0", "--grid", "8", "--numel", "1024")
+    # candidates that don't compile are not interesting
+    path.write_text("tt.func @broken(")
+    assert not _interesting(path, "--metric", "shared", "--below", "1000")
+
+
+def test_is_interesting():
+    assert reduce_perf.is_interesting(3.0, None, 2.0, None)
+    assert not reduce_perf.is_interesting(3.0, 2.0, 2.0, None)
+    assert reduce_perf.is_interesting(5.0, 2.0, 2.0, 3.0)
+    assert not reduce_perf.is_interesting(1.0, 0.0, 0.5, None)
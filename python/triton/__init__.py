@@ -8,6 +8,7 @@ __version__ = '3.0.0'
 from .runtime import (
     autotune,
     Config,
+    fused_launches,
     heuristics,
     JITFunction,
     KernelInterface,
@@ -15,6 +16,8 @@ from .runtime import (
     TensorWrapper,
     OutOfResources,
     MockTensor,
+    Workspace,
+    set_workspace_allocator,
 )
 from .runtime.jit import jit
 from .compiler import compile, CompilationError
@@ -29,6 +32,7 @@ __all__ = [
     "CompilationError",
     "compile",
     "Config",
+    "fused_launches",
     "heuristics",
     "impl",
     "jit",
@@ -41,9 +45,11 @@ __all__ = [
     "OutOfResources",
     "reinterpret",
     "runtime",
+    "set_workspace_allocator",
     "TensorWrapper",
     "testing",
     "tools",
+    "Workspace",
 ]
 
 # -------------------------------------
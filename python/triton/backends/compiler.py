@@ -1,7 +1,194 @@
 from abc import ABCMeta, abstractmethod, abstractclassmethod
+from contextlib import contextmanager
+from dataclasses import dataclass
 import os
+import signal
 import subprocess
 import re
+import threading
+import time
+
+
+# The option fields the code generator and the builtins of `triton.language`
+# read through `builder.options`, which the TTIR of every backend depends on.
+# The code generator only lets the frontend read these, see `FrontendOptions`.
+frontend_option_names = ("debug", "num_warps", "allow_fp8e4nv", "allow_batched_dot", "max_num_imprecise_acc_default",
+                         "profile_regions")
+
+
+def record_pass_timing(metadata: dict, stage: str, name: str, seconds: float) -> None:
+    """Appends a `[stage, pass, seconds]` entry to `metadata["pass_timings"]`"""
+    metadata.setdefault("pass_timings", []).append([stage, name, seconds])
+
+
+def run_passes(pm, mod, metadata: dict, stage: str) -> None:
+    """
+    Runs the pass manager `pm` on `mod`, recording the wall time of each of its passes in `metadata`, and the peak
+    resident memory of the process after each of them in `metadata["pass_peak_memory"]` (as `[stage, pass, bytes]`)
+    """
+    timings = pm.enable_timing()
+    pm.run(mod)
+    for name, seconds in timings.get():
+        record_pass_timing(metadata, stage, name, seconds)
+    peak_memory = metadata.setdefault("pass_peak_memory", [])
+    for name, peak in timings.get_peak_memory():
+        peak_memory.append([stage, name, peak])
+
+
+class timed_pass:
+    """Context manager recording the wall time of a non-MLIR pass (LLVM optimization, assembler, ...)"""
+
+    def __init__(self, metadata: dict, stage: str, name: str):
+        self.metadata = metadata
+        self.stage = stage
+        self.name = name
+
+    def __enter__(self):
+        self.start = time.perf_counter()
+
+    def __exit__(self, *args):
+        record_pass_timing(self.metadata, self.stage, self.name, time.perf_counter() - self.start)
+
+
+class CompileBudgetExceeded(RuntimeError):
+    """Raised when a compilation runs out of one of the limits of its `CompileBudget`"""
+
+    def __init__(self, resource, used, limit, stage):
+        self.message = (f"compilation exceeded its {resource} budget in the {stage} stage: used {used}, limit "
+                        f"{limit}. Reducing block sizes may help.")
+        self.resource = resource
+        self.used = used
+        self.limit = limit
+        self.stage = stage
+        super().__init__(self.message)
+
+    def __reduce__(self):
+        return (type(self), (self.resource, self.used, self.limit, self.stage))
+
+
+def _env_number(name, type):
+    value = os.environ.get(name)
+    return type(value) if value else None
+
+
+@dataclass(frozen=True)
+class CompileBudget:
+    """
+    Limits on the resources of one compilation, past which it is aborted with `CompileBudgetExceeded`, None for no
+    limit. Stages running in the process can't be interrupted, so the limits are checked after each stage, and
+    before the lowering to LLVM for `llvm_size`; external tools like ptxas are stopped as soon as they exceed them.
+
+    - `seconds`: wall time of the compilation (`TRITON_COMPILE_TIME_LIMIT`)
+    - `memory_mb`: growth of the peak resident memory of the process, and address space of the external tools, in
+      MiB (`TRITON_COMPILE_MEMORY_LIMIT`)
+    - `llvm_size`: number of instructions the lowering to LLVM is estimated to emit, see `llvm_size` in the kernel
+      cost, computed once the layouts are optimized (`TRITON_COMPILE_SIZE_LIMIT`)
+    """
+    seconds: float = None
+    memory_mb: int = None
+    llvm_size: int = None
+
+    @staticmethod
+    def from_env():
+        return CompileBudget(_env_number("TRITON_COMPILE_TIME_LIMIT", float),
+                             _env_number("TRITON_COMPILE_MEMORY_LIMIT", int),
+                             _env_number("TRITON_COMPILE_SIZE_LIMIT", int))
+
+
+_budget_state = threading.local()
+
+
+@contextmanager
+def compile_budget(budget: CompileBudget):
+    """Sets the budget of the compilations of the current thread, instead of the one from the environment"""
+    previous = getattr(_budget_state, "budget", None)
+    _budget_state.budget = budget
+    try:
+        yield
+    finally:
+        _budget_state.budget = previous
+
+
+def current_compile_budget() -> CompileBudget:
+    budget = getattr(_budget_state, "budget", None)
+    return CompileBudget.from_env() if budget is None else budget
+
+
+def _peak_memory_mb():
+    import resource
+    # in KiB on Linux
+    return resource.getrusage(resource.RUSAGE_SELF).ru_maxrss / 1024
+
+
+class BudgetTracker:
+    """What a compilation has used of its budget"""
+
+    def __init__(self, budget: CompileBudget):
+        self.budget = budget
+        self.start = time.perf_counter()
+        self.start_memory_mb = _peak_memory_mb() if budget.memory_mb is not None else 0
+
+    def remaining_seconds(self):
+        if self.budget.seconds is None:
+            return None
+        return max(0.0, self.budget.seconds - (time.perf_counter() - self.start))
+
+    def check(self, stage: str, metadata: dict) -> None:
+        """Raises `CompileBudgetExceeded` if the compilation ran out of its budget by the end of `stage`"""
+        budget = self.budget
+        elapsed = time.perf_counter() - self.start
+        if budget.seconds is not None and elapsed > budget.seconds:
+            raise CompileBudgetExceeded("time", f"{elapsed:.1f}s", f"{budget.seconds}s", stage)
+        if budget.memory_mb is not None:
+            used = _peak_memory_mb() - self.start_memory_mb
+            if used > budget.memory_mb:
+                raise CompileBudgetExceeded("memory", f"{used:.0f} MiB", f"{budget.memory_mb} MiB", stage)
+        llvm_size = (metadata.get("cost") or {}).get("llvm_size")
+        if budget.llvm_size is not None and llvm_size is not None and llvm_size > budget.llvm_size:
+            raise CompileBudgetExceeded("size", f"{llvm_size} LLVM instructions (estimated)", budget.llvm_size, stage)
+
+
+@contextmanager
+def track_budget():
+    """Tracks the budget of the compilation running in the current thread, including the ones it starts"""
+    tracker = getattr(_budget_state, "tracker", None)
+    if tracker is not None:
+        yield tracker
+        return
+    _budget_state.tracker = BudgetTracker(current_compile_budget())
+    try:
+        yield _budget_state.tracker
+    finally:
+        _budget_state.tracker = None
+
+
+def run_with_budget(cmd, stage: str, shell=False):
+    """
+    Runs `cmd` like `subprocess.run(cmd, check=True)`, within what is left of the budget of the compilation running
+    in the current thread: it is killed when it runs out of time, and its address space is limited to the memory
+    budget.
+    """
+    tracker = getattr(_budget_state, "tracker", None)
+    if tracker is None or (tracker.budget.seconds is None and tracker.budget.memory_mb is None):
+        return subprocess.run(cmd, shell=shell, check=True)
+    memory_mb = tracker.budget.memory_mb
+
+    def limit_memory():
+        if memory_mb is not None:
+            import resource
+            resource.setrlimit(resource.RLIMIT_AS, (memory_mb << 20, memory_mb << 20))
+
+    # in its own process group, so that the children of the shell are killed as well
+    proc = subprocess.Popen(cmd, shell=shell, start_new_session=True, preexec_fn=limit_memory)
+    try:
+        returncode = proc.wait(timeout=tracker.remaining_seconds())
+    except subprocess.TimeoutExpired:
+        os.killpg(proc.pid, signal.SIGKILL)
+        proc.wait()
+        raise CompileBudgetExceeded("time", f"more than {tracker.budget.seconds}s", f"{tracker.budget.seconds}s",
+                                    stage)
+    if returncode != 0:
+        raise subprocess.CalledProcessError(returncode, cmd)
 
 
 class BaseBackend(metaclass=ABCMeta):
@@ -56,6 +243,37 @@ class BaseBackend(metaclass=ABCMeta):
         """
         raise NotImplementedError
 
+    def shared_memory_limit(self):
+        """
+        Returns the largest amount of shared memory, in bytes, a kernel compiled for this target can use, or `None`
+        if unknown. Kernels compiled over the limit are recompiled with fewer pipeline stages.
+        """
+        return None
+
+    # Option fields read by the passes of the `ttir` stage, on top of the
+    # `frontend_option_names` the code generator reads, and option fields only
+    # read after the `ttgir` stage. Backends that set them let `compile` cache
+    # TTIR and TTGIR under keys narrower than the full options hash, see
+    # `stage_cache_key`.
+    ttir_option_names = None
+    late_option_names = None
+
+    def stage_cache_key(self, stage: str, options: object):
+        """
+        Returns a key identifying the options that the output of `stage` depends on, or `None` if `stage` is not
+        cached on its own. Kernels that only differ in options outside of that key resume compilation from the
+        cached output of `stage`.
+        """
+        if stage == "ttir" and self.ttir_option_names is not None:
+            # the frontend reads the options a backend doesn't have with a default
+            names = [name for name in frontend_option_names if hasattr(options, name)]
+            names += self.ttir_option_names
+        elif stage == "ttgir" and self.late_option_names is not None:
+            names = [name for name in options.__dict__ if name not in self.late_option_names]
+        else:
+            return None
+        return '_'.join([f'{name}-{getattr(options, name)}' for name in names])
+
     @abstractmethod
     def load_dialects(self, context):
         """
@@ -14,6 +14,14 @@ class DriverBase(metaclass=ABCMeta):
     def __init__(self) -> None:
         pass
 
+    def direct_launch_capsule(self, launcher):
+        """
+        Returns the C entry point of `launcher`, the `run` attribute of a
+        CompiledKernel, that a launch can call instead of `launcher` itself, or
+        None if the launch must go through Python (see `dispatch.launch`).
+        """
+        return None
+
 
 class GPUDriver(DriverBase):
 
@@ -28,7 +36,17 @@ class GPUDriver(DriverBase):
             self.get_current_stream = lambda idx: torch.cuda.current_stream(idx).cuda_stream
         self.get_current_device = torch.cuda.current_device
         self.set_current_device = torch.cuda.set_device
+        self.get_device_name = torch.cuda.get_device_name
 
     # TODO: remove once TMA is cleaned up
     def assemble_tensormap_to_arg(self, tensormaps_info, args):
         return args
+
+    def launch_batch(self, launches):
+        """
+        Runs a list of `(launcher, args)` pairs, where `launcher` is the `run`
+        attribute of a CompiledKernel and `args` the tuple it would be called
+        with. Drivers can override this to avoid one Python call per launch.
+        """
+        for launcher, args in launches:
+            launcher(*args)
@@ -1,4 +1,10 @@
-from .compiler import CompiledKernel, ASTSource, compile, AttrsDescriptor, make_backend
+from .compiler import (CompiledKernel, ASTSource, FusedSource, compile, compile_many, AttrsDescriptor, make_backend,
+                       launch_batch, compile_timings, preload, write_preload_manifest)
+from ..backends.compiler import CompileBudget, CompileBudgetExceeded, compile_budget
 from .errors import CompilationError
 
-__all__ = ["compile", "make_backend", "ASTSource", "AttrsDescriptor", "CompiledKernel", "CompilationError"]
+__all__ = [
+    "compile", "compile_many", "make_backend", "ASTSource", "FusedSource", "AttrsDescriptor", "CompiledKernel", "CompilationError",
+    "launch_batch", "compile_timings", "preload", "write_preload_manifest", "CompileBudget", "CompileBudgetExceeded",
+    "compile_budget"
+]
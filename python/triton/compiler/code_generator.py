@@ -3,10 +3,12 @@ import inspect
 import re
 import sys
 import warnings
+from collections import OrderedDict
 from typing import Any, Callable, Dict, Optional, Tuple, Type, Union
 
 from .. import language
 from .._C.libtriton import ir
+from ..backends.compiler import frontend_option_names
 from ..language import constexpr, tensor
 # ideally we wouldn't need any runtime component
 from ..runtime import JITFunction
@@ -94,6 +96,77 @@ def _get_fn_file_line(fn):
 _condition_types = {bool, int, type(None)}  # Python types accepted for conditionals inside kernels
 
 
+class FrontendOptions:
+    """
+    The compile options as seen by the code generator and the builtins: only the
+    `frontend_option_names` can be read, so that every option the TTIR depends on
+    is part of its cache key.
+    """
+
+    def __init__(self, options):
+        self._options = options
+
+    def __getattr__(self, name):
+        if name not in frontend_option_names:
+            raise AttributeError(f"option `{name}` is read by the frontend but is not in frontend_option_names")
+        return getattr(self._options, name)
+
+    def hash(self):
+        return self._options.hash()
+
+class _LRUCache(OrderedDict):
+    """A dict keeping at most `max_size` items, evicting the least recently used."""
+
+    def __init__(self, max_size):
+        super().__init__()
+        self.max_size = max_size
+
+    def __getitem__(self, key):
+        value = super().__getitem__(key)
+        self.move_to_end(key)
+        return value
+
+    def __setitem__(self, key, value):
+        super().__setitem__(key, value)
+        self.move_to_end(key)
+        while len(self) > self.max_size:
+            self.popitem(last=False)
+
+
+# The functions generated for the @jit helpers called by kernels, by mangled
+# name, hash of the helper and of its dependencies, debug mode and options.
+# The IR is kept as printed, with its return type and the keys of the helpers
+# it calls, so that later compilations link it into their own context instead
+# of generating it again. The keys change with the specializations and the
+# options, so only the most recently used functions are kept.
+_function_cache: Dict[Tuple, Tuple[str, Any, Tuple]] = _LRUCache(max_size=1024)
+
+
+def _link_cached_function(module, key, function_ret_types):
+    """
+    Links the function of `key` and the helpers it calls into `module`.
+    Returns False, and links nothing, if any of them was evicted from
+    `_function_cache`.
+    """
+    entries = {}
+
+    def collect(key):
+        if key in entries or module.has_function(key[0]):
+            return
+        entries[key] = _function_cache[key]
+        for callee in entries[key][2]:
+            collect(callee)
+
+    try:
+        collect(key)
+    except KeyError:
+        return False
+    for (fn_name, *_), (src, ret_type, _) in entries.items():
+        module.link_function(src)
+        function_ret_types[fn_name] = ret_type
+    return True
+
+
 class enter_sub_region:
 
     def __init__(self, generator):
@@ -232,6 +305,8 @@ class CodeGenerator(ast.NodeVisitor):
         self.noinline = noinline
         self.scf_stack = []
         self.last_ret_type = None
+        # keys in `_function_cache` of the helpers called by the function
+        self.callees = []
         # SSA-construction
         # name => language.tensor
         self.local_defs: Dict[str, tensor] = {}
@@ -976,20 +1051,26 @@ class CodeGenerator(ast.NodeVisitor):
         arg_vals = [arg.handle for arg in args if arg is not None]
         arg_types = [arg.type for arg in args if arg is not None]
         fn_name = mangle_fn(fn.__name__, arg_types, constants)
+        # If the callee is not set, we use the same debug setting as the caller
+        debug = self.debug if fn.debug is None else fn.debug
+        options = self.builder.options
+        key = (fn_name, fn.cache_key, debug, options.hash() if hasattr(options, "hash") else repr(options))
+        self.callees.append(key)
         # generate function def if necessary
+        if not self.module.has_function(fn_name):
+            _link_cached_function(self.module, key, self.function_ret_types)
         if not self.module.has_function(fn_name):
             prototype = language.function_type([], arg_types)
             gscope = fn.__globals__
-            # If the callee is not set, we use the same debug setting as the caller
             file_name, begin_line = _get_fn_file_line(fn)
-            debug = self.debug if fn.debug is None else fn.debug
             generator = CodeGenerator(self.context, prototype, gscope, attributes, constants, module=self.module,
                                       function_name=fn_name, function_types=self.function_ret_types,
                                       noinline=fn.noinline, file_name=file_name, begin_line=begin_line,
-                                      options=self.builder.options, debug=debug)
-            generator.visit(fn.parse())
+                                      options=options, debug=debug)
+            generator.visit_root(fn.parse())
             callee_ret_type = generator.last_ret_type
             self.function_ret_types[fn_name] = callee_ret_type
+            _function_cache[key] = (self.module.get_function_src(fn_name), callee_ret_type, tuple(generator.callees))
         else:
             callee_ret_type = self.function_ret_types[fn_name]
         symbol = self.module.get_function(fn_name)
@@ -1093,21 +1174,25 @@ class CodeGenerator(ast.NodeVisitor):
     def visit(self, node):
         if node is None:
             return
+        self.last_node = node
+        # The location of the node, if any, is the current one during its
+        # visit, and again after it. Otherwise, the location before the visit
+        # is restored.
+        if hasattr(node, 'lineno') and hasattr(node, 'col_offset'):
+            self.builder.push_loc(self.begin_line + node.lineno, node.col_offset)
+        else:
+            self.builder.push_loc()
+        ret = super().visit(node)
+        self.builder.pop_loc()
+        return ret
+
+    def visit_root(self, node):
         with warnings.catch_warnings():
             # The ast library added visit_Constant and deprecated some other
             # methods but we can't move to that without breaking Python 3.6 and 3.7.
             warnings.simplefilter("ignore", DeprecationWarning)  # python 3.9
             warnings.simplefilter("ignore", PendingDeprecationWarning)  # python 3.8
-            self.last_node = node
-            last_loc = self.builder.get_loc()
-            if hasattr(node, 'lineno') and hasattr(node, 'col_offset'):
-                self.builder.set_loc(self.file_name, self.begin_line + node.lineno, node.col_offset)
-                last_loc = self.builder.get_loc()
-            ret = super().visit(node)
-            # Reset the location to the last one before the visit
-            if last_loc:
-                self.builder.set_loc(last_loc)
-            return ret
+            return self.visit(node)
 
     def generic_visit(self, node):
         raise UnsupportedLanguageConstruct(None, node, "unsupported AST node type: {}".format(type(node).__name__))
@@ -1216,9 +1301,9 @@ def ast_to_ttir(fn, specialization, context, options):
     prototype = language.function_type([], arg_types)
     generator = CodeGenerator(context, prototype, gscope=gscope, constants=all_constants, function_name=function_name,
                               attributes=new_attrs, is_kernel=True, file_name=file_name, begin_line=begin_line,
-                              options=options)
+                              options=FrontendOptions(options))
     try:
-        generator.visit(fn.parse())
+        generator.visit_root(fn.parse())
     except CompilationError as e:
         if e.src is None:
             e.set_source_code(fn.src)
@@ -1,20 +1,27 @@
 from __future__ import annotations
 import hashlib
 import json
-from .._C.libtriton import get_env_vars, ir
+from .._C.libtriton import get_env_vars, ir, passes
 from ..backends import backends
+from ..backends.compiler import compile_budget, current_compile_budget, track_budget
 from .. import __version__
 from ..runtime.autotuner import OutOfResources
 from ..runtime.cache import get_cache_manager, get_dump_manager, get_override_manager
+from ..runtime import compile_server
 from ..runtime.driver import driver
 # TODO: this shouldn't be here
 from ..backends.nvidia.compiler import InfoFromBackendForTensorMap
+import contextlib
+import dataclasses
 from dataclasses import dataclass
 from .code_generator import ast_to_ttir
 from pathlib import Path
 import re
+import struct
 import functools
 import os
+import threading
+import time
 
 
 @dataclass
@@ -156,35 +163,126 @@ class IRSource:
         return dict()
 
 
-@functools.lru_cache()
-def triton_key():
+class FusedSource:
+    """
+    The kernels of several `ASTSource`s fused into one kernel, launched on a
+    1D grid of all their programs (see the `triton-fuse-kernels` pass). The
+    fused kernel takes the non-constexpr arguments of the kernels in order,
+    then the grid of each of them along x, y and z.
+    """
+
+    def __init__(self, members):
+        self.members = list(members)
+        self.ext = "ttir"
+        self.name = f"fused_{self.members[0].name}_x{len(self.members)}"
+        self.signature = dict()
+        # the equal-to-1 and None arguments of the kernels
+        self.constants = dict()
+        for member in self.members:
+            for k, ty in member.signature.items():
+                if k in member.constants:
+                    self.constants[len(self.signature)] = member.constants[k]
+                self.signature[len(self.signature)] = ty
+        for _ in range(3 * len(self.members)):
+            self.signature[len(self.signature)] = "i32"
+
+    def hash(self):
+        key = "-".join(member.hash() for member in self.members)
+        return hashlib.md5(key.encode("utf-8")).hexdigest()
+
+    def make_ir(self, options, context):
+        module = ir.builder(context).create_module()
+        module.context = context
+        for i, member in enumerate(self.members):
+            # the helpers are inlined first, the pass only fuses kernels
+            # without calls
+            member_module = member.make_ir(options, context)
+            pm = ir.pass_manager(context)
+            pm.enable_debug()
+            passes.common.add_inliner(pm)
+            pm.run(member_module)
+            module.append_kernel(member_module, f"{member.name}_{i}")
+        pm = ir.pass_manager(context)
+        pm.enable_debug()
+        passes.ttir.add_fuse_kernels(pm, self.name)
+        pm.run(module)
+        return module
+
+    def metadata(self):
+        return {"ids_of_folded_args": tuple()}
+
+    def parse_options(self):
+        return dict()
+
+
+def _triton_key_sources():
     import pkgutil
     TRITON_PATH = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
-    contents = []
     # frontend
-    with open(__file__, "rb") as f:
-        contents += [hashlib.sha1(f.read()).hexdigest()]
+    paths = [__file__]
     # compiler
     compiler_path = os.path.join(TRITON_PATH, 'compiler')
     backends_path = os.path.join(TRITON_PATH, 'compiler', 'backends')
     for lib in pkgutil.iter_modules([compiler_path, backends_path]):
-        with open(lib.module_finder.find_spec(lib.name).origin, "rb") as f:
-            contents += [hashlib.sha1(f.read()).hexdigest()]
+        paths.append(lib.module_finder.find_spec(lib.name).origin)
     # backend
-    libtriton_hash = hashlib.sha1()
-    with open(os.path.join(TRITON_PATH, "_C/libtriton.so"), "rb") as f:
+    paths.append(os.path.join(TRITON_PATH, "_C/libtriton.so"))
+    # language
+    language_path = os.path.join(TRITON_PATH, 'language')
+    for lib in pkgutil.iter_modules([language_path]):
+        paths.append(lib.module_finder.find_spec(lib.name).origin)
+    return paths
+
+
+def _hash_file(path):
+    file_hash = hashlib.sha1()
+    with open(path, "rb") as f:
         while True:
             chunk = f.read(1024**2)
             if not chunk:
                 break
-            libtriton_hash.update(chunk)
-    contents.append(libtriton_hash.hexdigest())
-    # language
-    language_path = os.path.join(TRITON_PATH, 'language')
-    for lib in pkgutil.iter_modules([language_path]):
-        with open(lib.module_finder.find_spec(lib.name).origin, "rb") as f:
-            contents += [hashlib.sha1(f.read()).hexdigest()]
-    return f'{__version__}' + '-'.join(contents)
+            file_hash.update(chunk)
+    return file_hash.hexdigest()
+
+
+def _triton_key_cache_paths():
+    # Prefer a file next to libtriton, falling back to the user cache when
+    # the install location is read-only.
+    from ..runtime.cache import default_cache_dir
+    TRITON_PATH = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+    return [os.path.join(TRITON_PATH, "_C", "triton_key.json"), os.path.join(default_cache_dir(), "triton_key.json")]
+
+
+@functools.lru_cache()
+def triton_key():
+    paths = _triton_key_sources()
+    # Hashing the sources (libtriton in particular) is slow, so the result is
+    # cached on disk, keyed by the identity of every file that goes into it.
+    stats = [os.stat(path) for path in paths]
+    fingerprint = hashlib.sha1(
+        json.dumps([[path, st.st_ino, st.st_mtime_ns, st.st_size] for path, st in zip(paths, stats)]).encode())
+    fingerprint = f"{__version__}-{fingerprint.hexdigest()}"
+    cache_paths = _triton_key_cache_paths()
+    for cache_path in cache_paths:
+        try:
+            with open(cache_path) as f:
+                cached = json.load(f)
+            if cached.get("fingerprint") == fingerprint:
+                return cached["key"]
+        except (OSError, ValueError, AttributeError, KeyError):
+            pass
+    key = f'{__version__}' + '-'.join(_hash_file(path) for path in paths)
+    for cache_path in cache_paths:
+        temp_path = f"{cache_path}.tmp.pid_{os.getpid()}"
+        try:
+            os.makedirs(os.path.dirname(cache_path), exist_ok=True)
+            with open(temp_path, "w") as f:
+                json.dump({"fingerprint": fingerprint, "key": key}, f)
+            os.replace(temp_path, cache_path)
+            break
+        except OSError:
+            continue
+    return key
 
 
 def parse(full_name, ext):
@@ -199,6 +297,156 @@ def parse(full_name, ext):
         return Path(full_name).read_bytes()
 
 
+_compile_timings_lock = threading.Lock()
+_compile_timings = {"stages": dict(), "passes": dict()}
+
+
+class _ContextPool:
+    """
+    MLIR contexts with the dialects of a backend loaded, reused across
+    compilations. Creating a context and loading the dialects takes a
+    noticeable part of compiling small kernels, which adds up when autotuning
+    compiles many variants. A context is used by one compilation at a time;
+    the modules created in it are erased when it is given back. Types and
+    attributes are uniqued by the context for its whole lifetime, so contexts
+    are dropped after `max_uses` compilations to bound their memory.
+    """
+
+    def __init__(self, max_idle=8, max_uses=64):
+        self.max_idle = max_idle
+        self.max_uses = max_uses
+        self.lock = threading.Lock()
+        self.idle = dict()
+
+    @staticmethod
+    def _key(backend):
+        # dumping the IR disables the threading of the context
+        if os.environ.get("MLIR_ENABLE_DUMP", "0") == "1":
+            return None
+        return (type(backend), os.environ.get("MLIR_DISABLE_MULTITHREADING", "0") == "1")
+
+    def acquire(self, backend):
+        key = self._key(backend)
+        if key is not None:
+            with self.lock:
+                contexts = self.idle.get(key)
+                if contexts:
+                    return contexts.pop()
+        context = ir.context()
+        ir.load_dialects(context)
+        backend.load_dialects(context)
+        context.uses = 0
+        return context
+
+    def release(self, backend, context, modules):
+        erased = set()
+        for module in modules:
+            if id(module) not in erased and getattr(module, "context", None) is context:
+                erased.add(id(module))
+                module.erase()
+        context.uses += 1
+        key = self._key(backend)
+        if key is None or context.uses >= self.max_uses:
+            return
+        with self.lock:
+            contexts = self.idle.setdefault(key, [])
+            if len(contexts) < self.max_idle:
+                contexts.append(context)
+
+    @contextlib.contextmanager
+    def lease(self, backend):
+        """
+        Yields a context and the list the modules created in it are added to.
+        The context isn't reused if the compilation fails, as the modules may
+        still be referenced by the traceback.
+        """
+        context = self.acquire(backend)
+        modules = []
+        yield context, modules
+        self.release(backend, context, modules)
+
+
+_context_pool = _ContextPool()
+
+
+def _record_compile_timings(metadata):
+    with _compile_timings_lock:
+        stages = _compile_timings["stages"]
+        for stage, seconds in metadata["stage_timings"].items():
+            stages[stage] = stages.get(stage, 0.0) + seconds
+        passes = _compile_timings["passes"]
+        for stage, name, seconds in metadata.get("pass_timings", []):
+            count, total = passes.get((stage, name), (0, 0.0))
+            passes[(stage, name)] = (count + 1, total + seconds)
+
+
+def compile_timings(reset=False):
+    """
+    Returns the wall time spent by the kernels compiled in this process (cache
+    hits excluded), as `{"stages": {stage: seconds}, "passes": {(stage, pass):
+    (runs, seconds)}}`. The timings of a single kernel are available as
+    `stage_timings` and `pass_timings` in its metadata.
+    """
+    with _compile_timings_lock:
+        ret = {"stages": dict(_compile_timings["stages"]), "passes": dict(_compile_timings["passes"])}
+        if reset:
+            _compile_timings["stages"].clear()
+            _compile_timings["passes"].clear()
+    return ret
+
+
+# metadata entries describing a particular compilation rather than its output
+_stage_local_metadata = ("stage_timings", "pass_timings", "pass_peak_memory")
+
+
+def _stage_cache_manager(src, backend, ext, stage_key):
+    key = f"{triton_key()}-{src.hash()}-{backend.hash()}-{ext}-{stage_key}-{str(sorted(get_env_vars().items()))}"
+    return get_cache_manager(hashlib.md5(key.encode("utf-8")).hexdigest())
+
+
+def _store_stage(src, stage_names, ext, manager, initial_metadata, metadata, metadata_group):
+    # Cache the IR of every stage up to `ext`, along with the metadata entries
+    # they added or changed.
+    stage_group = dict()
+    for stage in stage_names[:stage_names.index(ext) + 1]:
+        ir_filename = f"{src.name}.{stage}"
+        stage_group[ir_filename] = manager.put(Path(metadata_group[ir_filename]).read_text(), ir_filename)
+    delta = {
+        k: v
+        for k, v in metadata.items()
+        if k not in _stage_local_metadata and (k not in initial_metadata or initial_metadata[k] != v)
+    }
+    delta_filename = f"{src.name}.{ext}.json"
+    stage_group[delta_filename] = manager.put(json.dumps(delta, default=vars), delta_filename, binary=False)
+    manager.put_group(delta_filename, stage_group)
+
+
+def _resume_from_stage(src, ext, stage_group, context, metadata, metadata_group, fn_cache_manager, fn_dump_manager):
+    delta_filename = f"{src.name}.{ext}.json"
+    for filename, path in stage_group.items():
+        if filename == delta_filename:
+            metadata.update(json.loads(Path(path).read_text()))
+            continue
+        text = Path(path).read_text()
+        metadata_group[filename] = fn_cache_manager.put(text, filename)
+        if fn_dump_manager is not None:
+            fn_dump_manager.put(text, filename)
+    module = ir.parse_mlir_module(stage_group[f"{src.name}.{ext}"], context, keep_locations=True)
+    module.context = context
+    return module
+
+
+def _load_cached_kernel(src, metadata_group):
+    """
+    Returns the kernel of a cached group, or `None` if one of its files was removed since the group was read,
+    e.g. by hand or by a concurrent eviction. Lookups only read the group file, so such a group is a miss here.
+    """
+    try:
+        return CompiledKernel(src, metadata_group)
+    except FileNotFoundError:
+        return None
+
+
 def compile(src, target=None, options=None):
     if target is None:
         target = driver.get_current_target()
@@ -209,8 +457,14 @@ def compile(src, target=None, options=None):
         src = IRSource(src)
     extra_options = src.parse_options()
     options = backend.parse_options(dict(options or dict(), **extra_options))
+    branch_profile = getattr(options, "branch_profile", "")
+    branch_profile_key = _branch_profile_key(src, backend, options) if branch_profile else None
+    branch_profile_counts = load_branch_profile(branch_profile_key) if branch_profile == "use" else None
     # create cache manager
     key = f"{triton_key()}-{src.hash()}-{backend.hash()}-{options.hash()}-{str(sorted(get_env_vars().items()))}"
+    if branch_profile_counts:
+        # kernels built from an older profile are stale
+        key += f"-{branch_profile_counts}"
     hash = hashlib.md5(key.encode("utf-8")).hexdigest()
     fn_cache_manager = get_cache_manager(hash)
     # For dumping/overriding only hash the source as we want it to be independent of triton
@@ -224,8 +478,10 @@ def compile(src, target=None, options=None):
     metadata_path = metadata_group.get(metadata_filename)
     if metadata_path is not None:
         # cache hit!
-        metadata = json.loads(Path(metadata_path).read_text())
-        return CompiledKernel(src, metadata_group)
+        kernel = _load_cached_kernel(src, metadata_group)
+        if kernel is not None:
+            return kernel
+        metadata_group = {}
     # initialize metadata
     metadata = {
         "hash": hash,
@@ -234,25 +490,82 @@ def compile(src, target=None, options=None):
         **get_env_vars(),
         **src.metadata(),
     }
+    if branch_profile_key is not None:
+        metadata["branch_profile_key"] = branch_profile_key
+    if branch_profile_counts:
+        metadata["branch_profile_counts"] = branch_profile_counts
+    # other processes may be compiling the same kernel: let the compile server, if any, do it once for all of them
+    server_path = compile_server.server_path()
+    if server_path is not None and isinstance(src, ASTSource) and not enable_override and not enable_ir_dump:
+        server_group = compile_server.request(server_path, src, backend, target, options, metadata, fn_cache_manager)
+        kernel = _load_cached_kernel(src, server_group) if server_group is not None else None
+        if kernel is not None:
+            return kernel
     # run compilation pipeline  and populate metadata
     stages = dict()
     backend.add_stages(stages, options)
     first_stage = list(stages.keys()).index(src.ext)
-    context = ir.context()
-    ir.load_dialects(context)
-    backend.load_dialects(context)
-    module = src.make_ir(options, context)
-    for ext, compile_ir in list(stages.items())[first_stage:]:
-        next_module = compile_ir(module, metadata)
-        ir_filename = f"{src.name}.{ext}"
-        metadata_group[ir_filename] = fn_cache_manager.put(next_module, ir_filename)
-        if fn_dump_manager is not None:
-            fn_dump_manager.put(next_module, ir_filename)
-        if (fn_override_manager is not None and fn_override_manager.has_file(ir_filename)):
-            print(f"\nOverriding kernel with file {ir_filename}")
-            full_name = fn_override_manager.get_file(ir_filename)
-            next_module = parse(full_name, ext)
-        module = next_module
+    with _context_pool.lease(backend) as (context, modules), track_budget() as budget:
+        stage_timings = metadata["stage_timings"] = dict()
+        # intermediate stages are also cached under narrower keys, so that kernels
+        # that only differ in later options (e.g. `num_stages`) resume from there
+        stage_cache_managers = dict()
+        if isinstance(src, ASTSource) and fn_override_manager is None:
+            for ext in stages:
+                stage_key = backend.stage_cache_key(ext, options)
+                if stage_key is not None:
+                    stage_cache_managers[ext] = _stage_cache_manager(src, backend, ext, stage_key)
+        initial_metadata = dict(metadata)
+        module = None
+        for ext in reversed(list(stage_cache_managers)):
+            stage_group = stage_cache_managers[ext].get_group(f"{src.name}.{ext}.json")
+            if not stage_group:
+                continue
+            try:
+                module = _resume_from_stage(src, ext, stage_group, context, metadata, metadata_group, fn_cache_manager,
+                                            fn_dump_manager)
+            except FileNotFoundError:
+                # a file of the group was removed since, see `_load_cached_kernel`
+                metadata.clear()
+                metadata.update(initial_metadata)
+                metadata_group.clear()
+                continue
+            first_stage = list(stages.keys()).index(ext) + 1
+            break
+        if module is None:
+            start = time.perf_counter()
+            module = src.make_ir(options, context)
+            stage_timings["make_ir"] = time.perf_counter() - start
+        modules.append(module)
+        shared_memory_limit = backend.shared_memory_limit()
+        for ext, compile_ir in list(stages.items())[first_stage:]:
+            start = time.perf_counter()
+            next_module = compile_ir(module, metadata)
+            stage_timings[ext] = time.perf_counter() - start
+            budget.check(ext, metadata)
+            if (shared_memory_limit is not None and metadata.get("shared", 0) > shared_memory_limit
+                    and isinstance(src, ASTSource) and getattr(options, "num_stages", 1) > 1):
+                # the kernel couldn't be launched: don't finish compiling it
+                return _compile_with_fewer_stages(src, target, options, metadata, fn_cache_manager)
+            ir_filename = f"{src.name}.{ext}"
+            if isinstance(next_module, bytes):
+                # the binary, shared with the specializations compiling to the same one
+                metadata["binary_hash"] = hashlib.sha256(next_module).hexdigest()
+                metadata_group[ir_filename] = fn_cache_manager.put_blob(next_module, ir_filename)
+            else:
+                metadata_group[ir_filename] = fn_cache_manager.put(next_module, ir_filename)
+            if fn_dump_manager is not None:
+                fn_dump_manager.put(next_module, ir_filename)
+            if (fn_override_manager is not None and fn_override_manager.has_file(ir_filename)):
+                print(f"\nOverriding kernel with file {ir_filename}")
+                full_name = fn_override_manager.get_file(ir_filename)
+                next_module = parse(full_name, ext)
+            if ext in stage_cache_managers:
+                _store_stage(src, list(stages.keys()), ext, stage_cache_managers[ext], initial_metadata, metadata,
+                             metadata_group)
+            module = next_module
+            modules.append(module)
+    _record_compile_timings(metadata)
     # write-back metadata
     metadata_group[metadata_filename] = fn_cache_manager.put(json.dumps(metadata, default=vars), metadata_filename,
                                                              binary=False)
@@ -261,6 +574,64 @@ def compile(src, target=None, options=None):
     return CompiledKernel(src, metadata_group)
 
 
+_BRANCH_PROFILE_FILENAME = "branch_profile.json"
+
+
+def _branch_profile_key(src, backend, options):
+    """
+    Returns the cache key of the branch profile of `src` compiled with
+    `options`. The branches are numbered on the TTGIR, which doesn't depend on
+    whether the kernel is instrumented or uses the profile.
+    """
+    options = dataclasses.replace(options, branch_profile="")
+    key = f"{triton_key()}-{src.hash()}-{backend.hash()}-{options.hash()}"
+    return hashlib.md5(key.encode("utf-8")).hexdigest()
+
+
+def load_branch_profile(key):
+    """
+    Returns the counters of the branch profile saved under `key`, or None.
+    """
+    path = get_cache_manager(key).get_file(_BRANCH_PROFILE_FILENAME)
+    if path is None:
+        return None
+    return json.loads(Path(path).read_text())
+
+
+def save_branch_profile(key, counts):
+    """
+    Adds `counts` to the counters of the branch profile saved under `key`.
+    """
+    saved = load_branch_profile(key)
+    if saved is not None and len(saved) == len(counts):
+        counts = [a + b for a, b in zip(saved, counts)]
+    get_cache_manager(key).put(json.dumps(list(counts)), _BRANCH_PROFILE_FILENAME, binary=False)
+
+
+def _compile_with_fewer_stages(src, target, options, metadata, fn_cache_manager):
+    """
+    Compiles `src` with one less pipeline stage than `options`, because it uses
+    more shared memory than the target has, and caches the result under the
+    key of `options`, so that later compilations with `options` get it too.
+    The abandoned attempts are recorded in the `shared_memory_fallback`
+    metadata entry.
+    """
+    kernel = compile(src, target, dict(options.__dict__, num_stages=options.num_stages - 1))
+    metadata_filename = f"{src.name}.json"
+    kernel_metadata = json.loads(Path(kernel.metadata_group[metadata_filename]).read_text())
+    fallback = [{"num_stages": options.num_stages, "shared": metadata["shared"]}]
+    fallback += kernel_metadata.get("shared_memory_fallback", [])
+    metadata_group = dict()
+    for filename, path in kernel.metadata_group.items():
+        if filename != metadata_filename:
+            metadata_group[filename] = fn_cache_manager.put(Path(path).read_bytes(), filename)
+    fallback_metadata = dict(kernel_metadata, hash=metadata["hash"], shared_memory_fallback=fallback)
+    metadata_group[metadata_filename] = fn_cache_manager.put(json.dumps(fallback_metadata, default=vars),
+                                                             metadata_filename, binary=False)
+    fn_cache_manager.put_group(metadata_filename, metadata_group)
+    return CompiledKernel(src, metadata_group)
+
+
 def make_backend(target):
     actives = [x.compiler for x in backends.values() if x.compiler.supports_target(target)]
     if len(actives) != 1:
@@ -287,6 +658,7 @@ class CompiledKernel:
         self.metadata["tensormaps_info"] = tuple(self.metadata["tensormaps_info"])
         KernelMetadata = namedtuple('KernelMetadata', sorted(list(self.metadata.keys())))
         self.metadata = KernelMetadata(**self.metadata)
+        self.metadata_group = metadata_group
 
         self.name = self.metadata.name
         # create launcher
@@ -303,11 +675,111 @@ class CompiledKernel:
         # (e.g., checking amount of shared memory on current device)
         self.module = None
         self.function = None
+        self._occupancy = None
+        self._direct_launch_config = None
+
+    def clone(self):
+        """
+        Returns a kernel sharing this one's binary, metadata and launcher, but
+        with its own (not yet loaded) driver handles, e.g. for use on another
+        device of the same architecture.
+        """
+        kernel = object.__new__(CompiledKernel)
+        kernel.__dict__.update(self.__dict__)
+        kernel.module = None
+        kernel.function = None
+        kernel._occupancy = None
+        kernel._direct_launch_config = None
+        return kernel
+
+    def occupancy(self):
+        """
+        Returns how many instances of this kernel can run concurrently on the
+        current device, given its shared memory, register and warp usage, as a
+        dict with keys `num_sms`, `max_active_ctas_per_sm` and
+        `max_active_clusters` (None unless the kernel uses clusters).
+        """
+        self._init_handles()
+        if self._occupancy is None:
+            md = self.metadata
+            ctas, clusters = driver.utils.occupancy(self.function, md.num_warps, md.shared, *md.cluster_dims)
+            num_sms = driver.utils.get_device_properties(driver.get_current_device())["multiprocessor_count"]
+            self._occupancy = {"num_sms": num_sms, "max_active_ctas_per_sm": ctas, "max_active_clusters": clusters}
+        return self._occupancy
+
+    def max_resident_programs(self):
+        """
+        Returns the grid size of a persistent launch of this kernel, i.e. the
+        number of programs that can all be resident at once.
+        """
+        occupancy = self.occupancy()
+        if occupancy["max_active_clusters"] is not None:
+            # each program of a cluster launch is a whole cluster
+            return occupancy["max_active_clusters"]
+        return occupancy["max_active_ctas_per_sm"] * occupancy["num_sms"]
+
+    def persistent_launch(self, grid, args):
+        """
+        Returns the grid and the arguments of a launch of `grid`. A kernel made
+        persistent by the `triton-make-persistent` pass runs as many programs
+        as can be resident at once, at most one per tile, that loop over the
+        tiles of `grid`, which is passed after the kernel's arguments. The
+        programs of a kernel calling `tl.grid_sync` must all be resident at
+        once, so its grid can't be larger.
+        """
+        if getattr(self.metadata, "persistent", False):
+            num_tiles = grid[0] * grid[1] * grid[2]
+            grid, args = (min(num_tiles, self.max_resident_programs()), 1, 1), (*args, *grid)
+        if getattr(self.metadata, "cooperative", False):
+            num_programs = grid[0] * grid[1] * grid[2]
+            if num_programs > self.max_resident_programs():
+                raise RuntimeError(f"{self.name} synchronizes its grid of {num_programs} programs with tl.grid_sync, "
+                                   f"but at most {self.max_resident_programs()} can be resident at once")
+        return grid, args
+
+    def direct_launch_config(self):
+        """
+        Returns the arguments of `run` that are the same for every launch of
+        this kernel, as expected by `dispatch.launch`, or False if its
+        launches need `persistent_launch` or tensor map arguments. The
+        handles must be loaded.
+        """
+        if self._direct_launch_config is None:
+            md = self.metadata
+            if md.tensormaps_info or getattr(md, "persistent", False) or getattr(md, "cooperative", False):
+                self._direct_launch_config = False
+            else:
+                self._direct_launch_config = (md.split_k, md.num_warps, md.num_ctas, *md.cluster_dims, md.shared,
+                                              self.function, md)
+        return self._direct_launch_config
+
+    def save_branch_profile(self):
+        """
+        Adds the branch outcomes counted by this kernel, compiled with
+        `branch_profile="instrument"`, since it was loaded or last saved to its
+        branch profile, which compiling it with `branch_profile="use"` turns
+        into branch weights. The counters are reset.
+        """
+        num_counters = getattr(self.metadata, "num_branch_counters", None)
+        if not num_counters:
+            return
+        self._init_handles()
+        data = driver.utils.read_global(self.module, "triton_branch_counters", True)
+        save_branch_profile(self.metadata.branch_profile_key, struct.unpack(f"{num_counters}Q", data))
 
     def _init_handles(self):
         if self.module is not None:
             return
         device = driver.get_current_device()
+        handles = _preloaded_handles.get((self.metadata.hash, device))
+        if handles is not None:
+            self.module, self.function, self.n_regs, self.n_spills = handles
+            return
+        binary_key = self._binary_key(device)
+        handles = _loaded_binaries.get(binary_key)
+        if handles is not None:
+            self.module, self.function, self.n_regs, self.n_spills = handles
+            return
         # not enough shared memory to run the kernel
         max_shared = driver.utils.get_device_properties(device)["max_shared_mem"]
         if self.metadata.shared > max_shared:
@@ -315,12 +787,32 @@ class CompiledKernel:
         # TODO: n_regs, n_spills should be metadata generated when calling `ptxas`
         self.module, self.function, self.n_regs, self.n_spills = driver.utils.load_binary(
             self.name, self.kernel, self.metadata.shared, device)
+        if binary_key is not None:
+            _loaded_binaries[binary_key] = (self.module, self.function, self.n_regs, self.n_spills)
+
+    def _binary_key(self, device):
+        # Kernels with the same binary share its module, unless they read back
+        # the globals of the module, which would then mix their records.
+        md = self.metadata
+        binary_hash = getattr(md, "binary_hash", None)
+        if binary_hash is None or any(
+                getattr(md, name, None) for name in ("num_branch_counters", "profile_region_names", "print_formats")):
+            return None
+        return (binary_hash, self.name, md.shared, device)
 
     def __getattribute__(self, name):
         if name == 'run':
             self._init_handles()
         return super().__getattribute__(name)
 
+    def _launch_args(self, grid, stream, args):
+        md = self.metadata
+        grid, args = self.persistent_launch((grid[0], grid[1], grid[2] * md.split_k), args)
+        args_expand = driver.assemble_tensormap_to_arg(md.tensormaps_info, args)
+        return (grid[0], grid[1], grid[2], md.num_warps, md.num_ctas, md.cluster_dims[0],
+                md.cluster_dims[1], md.cluster_dims[2], md.shared, stream, self.function,
+                CompiledKernel.launch_enter_hook, CompiledKernel.launch_exit_hook, md, *args_expand)
+
     def __getitem__(self, grid):
         self._init_handles()
 
@@ -328,10 +820,129 @@ class CompiledKernel:
             if stream is None:
                 device = driver.get_current_device()
                 stream = driver.get_current_stream(device)
-            md = self.metadata
-            args_expand = driver.assemble_tensormap_to_arg(md.tensormaps_info, args)
-            self.run(grid[0], grid[1], grid[2], md.num_warps, md.num_ctas, md.cluster_dims[0], md.cluster_dims[1],
-                     md.cluster_dims[2], md.shared, stream, self.function, CompiledKernel.launch_enter_hook,
-                     CompiledKernel.launch_exit_hook, md, *args_expand)
+            self.run(*self._launch_args(grid, stream, args))
 
         return runner
+
+
+def launch_batch(launches, stream=None):
+    """
+    Launches several compiled kernels back to back on the same stream with a
+    single call into the driver, amortizing the per-launch Python overhead.
+
+    :param launches: `(kernel, grid, args)` tuples, where `kernel` is a
+        CompiledKernel, `grid` a 3-tuple and `args` the kernel's
+        non-constexpr arguments, as they would be passed to `kernel[grid]`.
+    :param stream: the stream to launch on, defaults to the current one.
+    """
+    if stream is None:
+        device = driver.get_current_device()
+        stream = driver.get_current_stream(device)
+    batch = []
+    for kernel, grid, args in launches:
+        kernel._init_handles()
+        batch.append((kernel.run, kernel._launch_args(grid, stream, args)))
+    driver.launch_batch(batch)
+
+
+# Driver handles of binaries loaded ahead of time by `preload`, keyed by
+# (cache key, device) and shared by every CompiledKernel with that key.
+_preloaded_handles = dict()
+
+# Driver handles of the loaded binaries, keyed by `CompiledKernel._binary_key`
+# and shared by the kernels compiled to the same binary.
+_loaded_binaries = dict()
+
+
+def write_preload_manifest(path, kernels):
+    """
+    Writes the cache keys of `kernels` (CompiledKernels, e.g. the values of
+    `JITFunction.cache[device]`) to a manifest that `preload` can read back.
+    """
+    entries = sorted({(kernel.metadata.hash, kernel.name) for kernel in kernels})
+    Path(path).write_text(json.dumps([{"hash": hash, "name": name} for hash, name in entries]))
+
+
+def preload(manifest, device=None, max_workers=None):
+    """
+    Loads the binaries of previously compiled kernels into the driver on
+    background threads, so that the first launch of each of them does not
+    have to. Kernels that are not in the cache (anymore) are skipped.
+
+    :param manifest: path to a manifest written by `write_preload_manifest`,
+        or the list of its `{"hash": ..., "name": ...}` entries.
+    :param device: the device to load on, defaults to the current one.
+    :param max_workers: number of loading threads.
+    :return: a list of futures, one per kernel, resolving to whether it was
+        loaded; `concurrent.futures.wait` them to block until loading is done.
+    """
+    from concurrent.futures import ThreadPoolExecutor
+    if not isinstance(manifest, list):
+        manifest = json.loads(Path(manifest).read_text())
+    if device is None:
+        device = driver.get_current_device()
+    max_shared = driver.utils.get_device_properties(device)["max_shared_mem"]
+
+    def load(entry):
+        if (entry["hash"], device) in _preloaded_handles:
+            return True
+        group = get_cache_manager(entry["hash"]).get_group(f"{entry['name']}.json")
+        if not group or group.get(f"{entry['name']}.json") is None:
+            return False
+        binary = group.get(f"{entry['name']}.{driver.binary_ext}")
+        try:
+            metadata = json.loads(Path(group[f"{entry['name']}.json"]).read_text())
+            binary = Path(binary).read_bytes() if binary is not None else None
+        except FileNotFoundError:
+            # removed since the group was read, see `_load_cached_kernel`
+            return False
+        if binary is None or metadata["shared"] > max_shared:
+            return False
+        # the GIL is released while the driver loads the module
+        handles = driver.utils.load_binary(metadata["name"], binary, metadata["shared"], device)
+        _preloaded_handles[(entry["hash"], device)] = handles
+        return True
+
+    executor = ThreadPoolExecutor(max_workers=max_workers)
+    futures = [executor.submit(load, entry) for entry in manifest]
+    # lets the threads exit once the queue is drained, without waiting here
+    executor.shutdown(wait=False)
+    return futures
+
+
+def compile_many(srcs, targets=None, options=None, max_workers=None):
+    """
+    Compiles several kernels concurrently and returns their CompiledKernels,
+    in the order of `srcs`. The MLIR pass pipelines, the LLVM optimization and
+    code generation, and the assembler run without holding the GIL, so they
+    overlap across kernels; only the generation of the Triton IR from the AST
+    is serialized.
+
+    :param srcs: the sources, as `compile` takes them.
+    :param targets: a target for all the kernels or a list with one per
+        kernel, defaults to the current device.
+    :param options: a dict of options for all the kernels or a list with one
+        per kernel.
+    :param max_workers: number of compiling threads.
+    """
+    from concurrent.futures import ThreadPoolExecutor
+    srcs = list(srcs)
+    if targets is None:
+        # the current device is per thread
+        targets = driver.get_current_target()
+    if isinstance(targets, tuple) and isinstance(targets[0], str):
+        targets = [targets] * len(srcs)
+    if options is None or isinstance(options, dict):
+        options = [options] * len(srcs)
+    if len(targets) != len(srcs) or len(options) != len(srcs):
+        raise ValueError("compile_many expects as many targets and options as sources")
+    budget = current_compile_budget()
+
+    def compile_with_budget(*args):
+        # the budget is per thread
+        with compile_budget(budget):
+            return compile(*args)
+
+    with ThreadPoolExecutor(max_workers=max_workers) as executor:
+        futures = [executor.submit(compile_with_budget, *args) for args in zip(srcs, targets, options)]
+        return [future.result() for future in futures]
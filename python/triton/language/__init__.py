@@ -9,16 +9,18 @@ from .standard import (
     cdiv,
     cumprod,
     cumsum,
+    cumsum_look_back,
+    load_rows,
     max,
     maximum,
     min,
     minimum,
     sigmoid,
     softmax,
-    sort,
     sum,
     ravel,
     swizzle2d,
+    topk,
     xor_sum,
     zeros,
     zeros_like,
@@ -50,6 +52,7 @@ from .core import (
     device_assert,
     device_print,
     dot,
+    dot_scaled,
     dtype,
     exp,
     expand_dims,
@@ -63,6 +66,8 @@ from .core import (
     float8e4nv,
     float8e5,
     function_type,
+    gather,
+    grid_sync,
     histogram,
     inline_asm_elementwise,
     int1,
@@ -70,6 +75,8 @@ from .core import (
     int32,
     int64,
     int8,
+    interleave,
+    join,
     load,
     log,
     make_block_ptr,
@@ -79,10 +86,15 @@ from .core import (
     num_programs,
     pi32_t,
     pointer_type,
+    prefetch,
+    profile_begin,
+    profile_end,
     program_id,
     reduce,
     reshape,
     sin,
+    sort,
+    split,
     sqrt,
     static_assert,
     static_print,
@@ -107,10 +119,13 @@ from .random import (
     philox_impl,
     rand,
     rand4x,
+    rand_packed,
     randint,
     randint4x,
+    randint_packed,
     randn,
     randn4x,
+    randn_packed,
     uint_to_uniform_float,
 )
 
@@ -143,10 +158,12 @@ __all__ = [
     "cos",
     "cumprod",
     "cumsum",
+    "cumsum_look_back",
     "debug_barrier",
     "device_assert",
     "device_print",
     "dot",
+    "dot_scaled",
     "dtype",
     "exp",
     "expand_dims",
@@ -161,6 +178,8 @@ __all__ = [
     "float8e5",
     "full",
     "function_type",
+    "gather",
+    "grid_sync",
     "histogram",
     "inline_asm_elementwise",
     "int1",
@@ -168,9 +187,12 @@ __all__ = [
     "int32",
     "int64",
     "int8",
+    "interleave",
+    "join",
     "ir",
     "math",
     "load",
+    "load_rows",
     "log",
     "make_block_ptr",
     "max",
@@ -186,13 +208,19 @@ __all__ = [
     "philox_impl",
     "pi32_t",
     "pointer_type",
+    "prefetch",
+    "profile_begin",
+    "profile_end",
     "program_id",
     "rand",
     "rand4x",
+    "rand_packed",
     "randint",
     "randint4x",
+    "randint_packed",
     "randn",
     "randn4x",
+    "randn_packed",
     "ravel",
     "reduce",
     "reshape",
@@ -200,6 +228,7 @@ __all__ = [
     "sin",
     "softmax",
     "sort",
+    "split",
     "sqrt",
     "static_range",
     "static_assert",
@@ -208,6 +237,7 @@ __all__ = [
     "sum",
     "swizzle2d",
     "tensor",
+    "topk",
     "trans",
     "triton",
     "uint16",
@@ -780,18 +780,22 @@ class tensor:
         assert False, "Transposition must be created by the AST Visitor"
 
     @builtin
-    def to(self, dtype, fp_downcast_rounding: str = None, bitcast=False, _builder=None):
+    def to(self, dtype, fp_downcast_rounding: str = None, bitcast=False, rbits=None, _builder=None):
         """
         Casts the tensor to the given :code:`dtype`.
         :param dtype: The target data type.
         :type dtype: DType
         :param fp_downcast_rounding: The rounding mode for downcasting floating-point values. \
             This parameter is only used when self is a floating-point tensor and dtype is a floating-point type \
-            with a smaller bitwidth. Supported values are :code:`"rtne"` (round to nearest, ties to even) and \
-            :code:`"rtz"` (round towards zero).
+            with a smaller bitwidth. Supported values are :code:`"rtne"` (round to nearest, ties to even), \
+            :code:`"rtz"` (round towards zero) and :code:`"rs"` (stochastic rounding, from float32 to float16, \
+            bfloat16 and float8e5, and from float16 to float8e5).
         :type fp_downcast_rounding: str
         :param bitcast: If true, the tensor is bitcasted to the given :code:`dtype`, instead of being casted.
         :type bitcast: bool
+        :param rbits: The random bits of the stochastic rounding, an int32 or uint32 tensor broadcastable to \
+            the shape of self, e.g. :code:`tl.randint(seed, offsets)`. Only used with :code:`"rs"`.
+        :type rbits: tensor
         :param _builder: The IR builder.
         :type _builder: ir.builder
         """
@@ -799,7 +803,9 @@ class tensor:
             bitcast = bitcast.value
         if bitcast:
             return semantic.bitcast(self, dtype, _builder)
-        return semantic.cast(self, dtype, _builder, fp_downcast_rounding)
+        if isinstance(rbits, constexpr):
+            rbits = rbits.value
+        return semantic.cast(self, dtype, _builder, fp_downcast_rounding, rbits)
 
 
 # -----------------------
@@ -951,6 +957,77 @@ def cat(input, other, can_reorder=False, _builder=None):
     return semantic.cat(input, other, can_reorder, _builder)
 
 
+@builtin
+def join(a, b, _builder=None):
+    """
+    Join the given tensors in a new, minor dimension.
+
+    For example, given two tensors of shape (4,8), produces a new tensor of
+    shape (4,8,2).  Given two scalars, returns a tensor of shape (2).
+
+    The two inputs are broadcasted to be the same shape.
+
+    The new dimension lives in the registers of each thread, so this is free:
+    the elements of :code:`a` and :code:`b` aren't moved.
+
+    If you want to join more than two elements, you can use multiple calls to
+    this function.  This reflects the constraint in Triton that tensors must
+    have power-of-two sizes.
+
+    join is the inverse of split.
+
+    :param a: The first input tensor.
+    :type a: Tensor
+    :param b: The second input tensor.
+    :type b: Tensor
+    """
+    return semantic.join(a, b, _builder)
+
+
+@builtin
+def split(a, _builder=None) -> tuple[tensor, tensor]:
+    """
+    Split a tensor in two along its last dim, which must have size 2.
+
+    For example, given a tensor of shape (4,8,2), produces two tensors of shape
+    (4,8).  The input must be at least 2D, as the IR has no tensors of rank 0.
+
+    If you want to split into more than two pieces, you can use multiple calls
+    to this function (probably plus calling reshape).  This reflects the
+    constraint in Triton that tensors must have power-of-two sizes.
+
+    split is the inverse of join.
+
+    :param a: The tensor to split.
+    :type a: Tensor
+    """
+    return semantic.split(a, _builder)
+
+
+@builtin
+def interleave(a, b, _builder=None):
+    """
+    Interleave the given tensors in their minor dimension.
+
+    For example, given :code:`a=[1,2,3]` and :code:`b=[4,5,6]`, the result is
+    :code:`[1,4,2,5,3,6]`.
+
+    This is a join followed by a reshape that merges the new dimension into
+    the last one, so with a blocked layout whose last dimension is the most
+    minor one both steps stay in registers.
+
+    :param a: The first input tensor.
+    :type a: Tensor
+    :param b: The second input tensor.
+    :type b: Tensor
+    """
+    c = semantic.join(a, b, _builder)
+    if len(c.shape) == 1:
+        return c
+    shape = c.shape[:-2] + [2 * c.shape[-2]]
+    return semantic.reshape(c, [_constexpr_to_value(d) for d in shape], _builder)
+
+
 @builtin
 def _experimental_interleave(a, b, _builder=None):
     """
@@ -1049,12 +1126,20 @@ def dot(input, other, acc=None, allow_tf32=True, max_num_imprecise_acc=None, out
     """
     Returns the matrix product of two blocks.
 
-    The two blocks must be two-dimensional and have compatible inner dimensions.
+    The two blocks must be two-dimensional and have compatible inner dimensions. Batches of small matrices
+    are multiplied in one dot along a leading batch dimension: :code:`[B, M, K]` and :code:`[B, K, N]` blocks give a
+    :code:`[B, M, N]` block, whose batch entries are spread over the warps. Batched dots run on the :code:`mma.sync`
+    tensor cores of sm_75 and later, including on sm_90 where each matrix is too small for a warpgroup
+    instruction, and need :code:`allow_tf32` for :code:`float32` inputs.
 
     :param input: The first tensor to be multiplied.
-    :type input: 2D tensor of scalar-type in {:code:`float16`, :code:`bfloat16`, :code:`float32`}
+    :type input: 2D or 3D tensor of scalar-type in {:code:`float16`, :code:`bfloat16`, :code:`float32`}
     :param other: The second tensor to be multiplied.
-    :type other: 2D tensor of scalar-type in {:code:`float16`, :code:`bfloat16`, :code:`float32`}
+    :type other: 2D or 3D tensor of scalar-type in {:code:`float16`, :code:`bfloat16`, :code:`float32`}
+    :param max_num_imprecise_acc: For fp8 dots accumulating in float32 on sm_90, the number of products along k
+        the tensor cores accumulate in lower precision before they are added to a separate float32 accumulator,
+        across the iterations of the loop the accumulator is carried by. Defaults to never, the fastest mode.
+    :type max_num_imprecise_acc: int, optional
     """
     allow_tf32 = _constexpr_to_value(allow_tf32)
     out_dtype = _constexpr_to_value(out_dtype)
@@ -1062,6 +1147,31 @@ def dot(input, other, acc=None, allow_tf32=True, max_num_imprecise_acc=None, out
     return semantic.dot(input, other, acc, allow_tf32, max_num_imprecise_acc, out_dtype, _builder)
 
 
+@builtin
+def dot_scaled(input, other, input_scale, other_scale, acc=None, allow_tf32=True, max_num_imprecise_acc=None,
+               _builder=None):
+    """
+    Returns the matrix product of two blocks scaled by the scales of their block along k, added to :code:`acc`.
+
+    The scales apply to all the k of the product: a loop over k with one scale block per iteration applies
+    per-block scales, e.g. one scale per 32 elements along k with :code:`BLOCK_K = 32`. The product of the raw
+    blocks runs at the throughput of their type and only its float32 result is scaled.
+
+    :param input: The first tensor to be multiplied.
+    :type input: 2D tensor of scalar-type in {:code:`float8e4nv`, :code:`float8e5`, :code:`int8`, :code:`float16`, :code:`bfloat16`}
+    :param other: The second tensor to be multiplied.
+    :type other: 2D tensor of the scalar-type of :code:`input`
+    :param input_scale: The scales of the rows of :code:`input`, of shape :code:`[M, 1]`.
+    :type input_scale: 2D tensor of :code:`float32`
+    :param other_scale: The scales of the columns of :code:`other`, of shape :code:`[1, N]`.
+    :type other_scale: 2D tensor of :code:`float32`
+    """
+    allow_tf32 = _constexpr_to_value(allow_tf32)
+    max_num_imprecise_acc = _constexpr_to_value(max_num_imprecise_acc)
+    return semantic.dot_scaled(input, other, input_scale, other_scale, acc, allow_tf32, max_num_imprecise_acc,
+                               _builder)
+
+
 # -----------------------
 # Non-Atomic Memory Operations
 # -----------------------
@@ -1101,7 +1211,9 @@ def load(pointer, mask=None, other=None, boundary_check=tuple(), padding_option=
     :param padding_option: should be one of {"", "zero", "nan"}, do padding while out of bound
     :param cache_modifier: changes cache option in NVIDIA PTX
     :type cache_modifier: str, optional
-    :param eviction_policy: changes eviction policy in NVIDIA PTX
+    :param eviction_policy: changes eviction policy in NVIDIA PTX, should be one of {"", "evict_first", "evict_last",
+        "no_allocate"}. From sm80, "evict_first" and "evict_last" also apply to L2, e.g. for streamed activations and
+        reused KV-cache blocks, while "no_allocate" doesn't allocate L1 lines
     :type eviction_policy: str, optional
     :param volatile: changes volatile option in NVIDIA PTX
     :type volatile: bool, optional
@@ -1150,7 +1262,9 @@ def store(pointer, value, mask=None, boundary_check=(), cache_modifier="", evict
     :type boundary_check: tuple of ints, optional
     :param cache_modifier: changes cache option in NVIDIA PTX
     :type cache_modifier: str, optional
-    :param eviction_policy: changes eviction policy in NVIDIA PTX
+    :param eviction_policy: changes eviction policy in NVIDIA PTX, should be one of {"", "evict_first", "evict_last",
+        "no_allocate"}. From sm80, "evict_first" and "evict_last" also apply to L2, e.g. for streamed activations and
+        reused KV-cache blocks, while "no_allocate" doesn't allocate L1 lines
     :type eviction_policy: str, optional
     """
     # `value` can be constexpr
@@ -1162,6 +1276,26 @@ def store(pointer, value, mask=None, boundary_check=(), cache_modifier="", evict
     return semantic.store(pointer, value, mask, boundary_check, cache_modifier, eviction_policy, _builder)
 
 
+@builtin
+def prefetch(pointer, mask=None, eviction_policy="", _builder=None):
+    """
+    Prefetch the cache lines of the memory locations defined by `pointer` into L2, without waiting for them.
+    This hides the latency of loads whose addresses are known ahead of time but can't be pipelined, like gathers with
+    data-dependent indices. The pipeliner inserts prefetches for the next iteration of such loads on its own.
+
+    :param pointer: The memory locations to prefetch
+    :type pointer: `triton.PointerType`, or block of `dtype=triton.PointerType`
+    :param mask: If `mask[idx]` is false, do not prefetch `pointer[idx]`
+    :type mask: Block of triton.int1, optional
+    :param eviction_policy: "evict_last" keeps the prefetched lines longer in L2 from sm80
+    :type eviction_policy: str, optional
+    """
+    if _constexpr_to_value(mask) is not None:
+        mask = _to_tensor(mask, _builder)
+    eviction_policy = _constexpr_to_value(eviction_policy)
+    return semantic.prefetch(pointer, mask, eviction_policy, _builder)
+
+
 @builtin
 def make_block_ptr(base: tensor, shape, strides, offsets, block_shape, order, _builder=None):
     """
@@ -1193,7 +1327,7 @@ def advance(base: tensor, offsets, _builder=None):
 # -----------------------
 
 
-def _add_atomic_docstr(name: str, has_cmp: bool = False) -> Callable[[T], T]:
+def _add_atomic_docstr(name: str, has_cmp: bool = False, has_aggregate: bool = False) -> Callable[[T], T]:
 
     def _decorator(func: T) -> T:
         docstr = f"""
@@ -1215,7 +1349,15 @@ def _add_atomic_docstr(name: str, has_cmp: bool = False) -> Callable[[T], T]:
     :type sem: str
     :param scope: Scope of threads that observe synchronizing effect of the
         atomic operation ("GPU" (default), "CTA", or "SYSTEM")
-    :type scope: str
+    :type scope: str"""
+        if has_aggregate:
+            docstr += """
+    :param aggregate: If true, the lanes of a warp updating the same location
+        first combine their values, so that a single atomic is issued per
+        location. Useful when many lanes hit the same locations, like the
+        bins of a histogram. Only applies when the result is unused.
+    :type aggregate: bool"""
+        docstr += """
     """
         func.__doc__ = docstr
         return func
@@ -1243,12 +1385,13 @@ def atomic_xchg(pointer, val, mask=None, sem=None, scope=None, _builder=None):
 
 
 @builtin
-@_add_atomic_docstr("add")
-def atomic_add(pointer, val, mask=None, sem=None, scope=None, _builder=None):
+@_add_atomic_docstr("add", has_aggregate=True)
+def atomic_add(pointer, val, mask=None, sem=None, scope=None, aggregate=False, _builder=None):
     val = _to_tensor(val, _builder)
     sem = _constexpr_to_value(sem)
     scope = _constexpr_to_value(scope)
-    return semantic.atomic_add(pointer, val, mask, sem, scope, _builder)
+    aggregate = _constexpr_to_value(aggregate)
+    return semantic.atomic_add(pointer, val, mask, sem, scope, aggregate, _builder)
 
 
 @builtin
@@ -1622,6 +1765,48 @@ def histogram(input, num_bins, _builder=None, _generator=None):
     return semantic.histogram(input, num_bins, _builder)
 
 
+@builtin
+def gather(src, index, axis, _builder=None):
+    """
+    Gathers the elements of a tensor along an axis: for axis 0,
+    :code:`result[i, j] = src[index[i, j], j]`, and so on.
+
+    :code:`index` must have the rank of :code:`src` and its shape but along
+    :code:`axis`; the result has the shape of :code:`index`.  Indices wrap
+    around the size of :code:`src` along :code:`axis`.
+
+    The gather stays on-chip: it is lowered to selects between the registers of
+    a thread or to warp shuffles when the elements don't leave their warp, and
+    goes through shared memory otherwise.  Small lookup tables, like the
+    codebooks of a dequantization, are best kept 1D.
+
+    :param src: the tensor to gather from
+    :param index: the indices along :code:`axis`
+    :param axis: the axis to gather along
+    """
+    axis = _constexpr_to_value(axis)
+    return semantic.gather(src, index, axis, _builder)
+
+
+@builtin
+def sort(x, dim=None, descending=False, _builder=None):
+    """
+    Sorts a tensor along a dimension, with a bitonic network over the registers of the threads.
+
+    :param x: the input tensor
+    :type x: Block
+    :param dim: the dimension to sort along, the last one by default. Its size must be a power of two.
+    :type dim: int
+    :param descending: if set, sorts in descending order
+    :type descending: bool
+    """
+    dim = _constexpr_to_value(dim)
+    if dim is None:
+        dim = len(x.shape) - 1
+    dim = _wrap_axis(dim, len(x.shape))
+    return semantic.sort(x, dim, _constexpr_to_value(descending), _builder)
+
+
 # -----------------------
 # Compiler Hint Ops
 # -----------------------
@@ -1635,6 +1820,20 @@ def debug_barrier(_builder=None):
     return semantic.debug_barrier(_builder)
 
 
+@builtin
+def grid_sync(_builder=None):
+    '''
+    Insert a barrier to synchronize all the programs of the grid. The global memory writes of every program before the
+    barrier are visible to all the programs after it.
+
+    All the programs must run at once, so a kernel calling :code:`grid_sync` is launched cooperatively and its grid
+    can't have more programs than :code:`kernel.max_resident_programs()` of the compiled kernel: loop over the work
+    in each program instead, as in a persistent kernel. Concurrent launches of the same kernel share the barrier and
+    must not overlap. Not supported with warp specialization.
+    '''
+    return semantic.grid_sync(_builder)
+
+
 @builtin
 def multiple_of(input, values, _builder=None):
     """
@@ -1796,6 +1995,39 @@ def device_assert(cond, msg="", _builder=None):
     return semantic.device_assert(_to_tensor(cond, _builder), msg, file_name, func_name, lineno, _builder)
 
 
+@builtin
+def profile_begin(name, _builder=None):
+    '''
+    Begin the profiled region :code:`name`, ended by :code:`profile_end`. The regions are only compiled in with the
+    :code:`profile_regions` option, the number of programs whose warps record the cycles they spent in each region,
+    which :code:`triton.tools.profile_regions.decode` aggregates once the kernel ran.
+
+    .. highlight:: python
+    .. code-block:: python
+
+        tl.profile_begin("softmax")
+        p = tl.exp(qk - m[:, None])
+        tl.profile_end("softmax")
+
+    :param name: the name of the region. This is required to be a string literal.
+    '''
+    name = _constexpr_to_value(name)
+    assert isinstance(name, str), f"{name} is not string"
+    return semantic.profile_mark(name, False, _builder)
+
+
+@builtin
+def profile_end(name, _builder=None):
+    '''
+    End the profiled region :code:`name`, begun by :code:`profile_begin`.
+
+    :param name: the name of the region. This is required to be a string literal.
+    '''
+    name = _constexpr_to_value(name)
+    assert isinstance(name, str), f"{name} is not string"
+    return semantic.profile_mark(name, True, _builder)
+
+
 @builtin
 def inline_asm_elementwise(asm: str, constraints: str, args: Sequence, dtype: Union[dtype, Sequence[dtype]],
                            is_pure: bool, pack: int, _builder=None):
@@ -16,3 +16,124 @@ def smid(_builder=None):
 @core.builtin
 def num_threads(_builder=None):
     return core.constexpr(_builder.options.num_warps * 32)
+
+
+# Loads and stores ordering the memory accesses of peer GPUs, for kernels
+# communicating through peer pointers (e.g. a fused all-reduce over NVLink).
+# Signals are atomics at the system scope, e.g.
+# `tl.atomic_add(flag, 1, sem="release", scope="sys")`.
+
+_scopes = ("cta", "gpu", "sys")
+
+
+def _scope(scope):
+    scope = core._constexpr_to_value(scope)
+    if scope not in _scopes:
+        raise ValueError(f"scope must be one of {_scopes}, got {scope}")
+    return scope
+
+
+def _word(pointer, what):
+    # the values are moved as raw bits and bitcast to the element type
+    if not isinstance(pointer, core.tensor) or not pointer.type.scalar.is_ptr():
+        raise ValueError(f"{what} takes a pointer, got {pointer}")
+    ty = pointer.type.scalar.element_ty
+    if ty.primitive_bitwidth not in (32, 64):
+        raise ValueError(f"{what} only supports 32 and 64-bit elements, got {ty}")
+    if ty.primitive_bitwidth == 32:
+        return ty, core.int32, "r"
+    return ty, core.int64, "l"
+
+
+def _predicated(asm, mask, num_operands, _builder):
+    # the predicate is the last operand, as an int32
+    mask = core._constexpr_to_value(mask)
+    if mask is None:
+        return asm, [], ""
+    mask = core._to_tensor(mask, _builder).to(core.int32, _builder=_builder)
+    asm = f"{{ .reg .pred p; setp.ne.b32 p, ${num_operands}, 0; @p {asm} }}"
+    return asm, [mask], ",r"
+
+
+def _bits(value, ty, int_ty, _builder):
+    value = core._to_tensor(value, _builder).to(ty, _builder=_builder)
+    return value.to(int_ty, bitcast=True, _builder=_builder)
+
+
+@core.extern
+def load_acquire(pointer, mask=None, scope="gpu", _builder=None):
+    """
+    Loads :code:`pointer` with acquire semantics at :code:`scope` (:code:`"cta"`, :code:`"gpu"` or :code:`"sys"`):
+    the accesses after the load see the writes before a release at the same scope that it read from. Use
+    :code:`"sys"` for the writes of peer GPUs and of the host. Masked out elements are 0.
+    """
+    ty, int_ty, reg = _word(pointer, "load_acquire")
+    bits = ty.primitive_bitwidth
+    ld = f"ld.global.acquire.{_scope(scope)}.b{bits} $0, [$1];"
+    if core._constexpr_to_value(mask) is not None:
+        ld = f"mov.b{bits} $0, 0; {ld}"
+    asm, extra, constraints = _predicated(ld, mask, 2, _builder)
+    ret = core.inline_asm_elementwise(asm, f"={reg},l{constraints}", [pointer, *extra], dtype=int_ty, is_pure=False,
+                                      pack=1, _builder=_builder)
+    return ret.to(ty, bitcast=True, _builder=_builder)
+
+
+@core.extern
+def store_release(pointer, value, mask=None, scope="gpu", _builder=None):
+    """
+    Stores :code:`value` to :code:`pointer` with release semantics at :code:`scope` (:code:`"cta"`, :code:`"gpu"` or
+    :code:`"sys"`): the accesses before the store are visible to an acquire at the same scope that reads it.
+    """
+    ty, int_ty, reg = _word(pointer, "store_release")
+    st = f"st.global.release.{_scope(scope)}.b{ty.primitive_bitwidth} [$1], $2;"
+    asm, extra, constraints = _predicated(st, mask, 3, _builder)
+    # the asm must have a result, which is unused
+    core.inline_asm_elementwise(asm, f"=r,l,{reg}{constraints}", [pointer, _bits(value, ty, int_ty, _builder), *extra],
+                                dtype=core.int32, is_pure=False, pack=1, _builder=_builder)
+
+
+def _multimem_type(ty, op):
+    bits = ty.primitive_bitwidth
+    if ty.is_floating():
+        if op != "add":
+            raise ValueError(f"multimem reductions of {ty} only support add")
+        return f"f{bits}"
+    if op in ("and", "or", "xor"):
+        return f"b{bits}"
+    # like the atomics, signed additions are unsigned
+    return f"s{bits}" if ty.is_int_signed() and op != "add" else f"u{bits}"
+
+
+@core.extern
+def multimem_ld_reduce(pointer, op="add", mask=None, _builder=None):
+    """
+    Loads :code:`pointer`, a multicast address of an NVSwitch multicast object, from all the GPUs it is mapped on and
+    reduces the values with :code:`op` (:code:`"add"`, :code:`"min"`, :code:`"max"`, :code:`"and"`, :code:`"or"` or
+    :code:`"xor"`; only :code:`"add"` for floating-point elements). Requires compute capability 9.0. Masked out
+    elements are 0.
+    """
+    op = core._constexpr_to_value(op)
+    if op not in ("add", "min", "max", "and", "or", "xor"):
+        raise ValueError(f"unsupported multimem reduction {op}")
+    ty, int_ty, reg = _word(pointer, "multimem_ld_reduce")
+    bits = ty.primitive_bitwidth
+    ld = f"multimem.ld_reduce.relaxed.sys.global.{op}.{_multimem_type(ty, op)} $0, [$1];"
+    if core._constexpr_to_value(mask) is not None:
+        ld = f"mov.b{bits} $0, 0; {ld}"
+    asm, extra, constraints = _predicated(ld, mask, 2, _builder)
+    ret = core.inline_asm_elementwise(asm, f"={reg},l{constraints}", [pointer, *extra], dtype=int_ty, is_pure=False,
+                                      pack=1, _builder=_builder)
+    return ret.to(ty, bitcast=True, _builder=_builder)
+
+
+@core.extern
+def multimem_st(pointer, value, mask=None, _builder=None):
+    """
+    Stores :code:`value` to :code:`pointer`, a multicast address of an NVSwitch multicast object, on all the GPUs it is
+    mapped on. Requires compute capability 9.0.
+    """
+    ty, int_ty, reg = _word(pointer, "multimem_st")
+    st = f"multimem.st.relaxed.sys.global.{_multimem_type(ty, 'add')} [$1], $2;"
+    asm, extra, constraints = _predicated(st, mask, 3, _builder)
+    core.inline_asm_elementwise(asm, f"=r,l,{reg}{constraints}", [pointer, _bits(value, ty, int_ty, _builder), *extra],
+                                dtype=core.int32, is_pure=False, pack=1, _builder=_builder)
@@ -556,6 +556,47 @@ def interleave(a: tl.tensor, b: tl.tensor, builder: ir.builder) -> tl.tensor:
     return tl.tensor(builder.create_interleave(a.handle, b.handle), ret_type)
 
 
+def join(a: tl.tensor, b: tl.tensor, builder: ir.builder) -> tl.tensor:
+    a, b = broadcast_impl_value(a, b, builder)
+
+    # The IR can't handle joining two scalars, so upcast them to 1D tensors,
+    # then downcast the result.
+    was_rank_zero = False
+    if len(a.shape) == 0:
+        was_rank_zero = True
+        a = expand_dims(a, 0, builder)
+        b = expand_dims(b, 0, builder)
+
+    if isinstance(a.shape[-1], tl.constexpr):
+        two = tl.constexpr(2)
+    else:
+        two = 2
+    new_shape = a.shape + [two]
+
+    ret_type = tl.block_type(a.type.scalar, new_shape)
+    ret = tl.tensor(builder.create_join(a.handle, b.handle), ret_type)
+
+    if was_rank_zero:
+        ret = reshape(ret, [2], builder)
+
+    return ret
+
+
+def split(a: tl.tensor, builder: ir.builder) -> Tuple[tl.tensor, tl.tensor]:
+    if len(a.shape) < 2:
+        raise ValueError(f"split expects a tensor of rank at least 2, got shape {a.shape}")
+    if tl._constexpr_to_value(a.shape[-1]) != 2:
+        raise ValueError(f"split expects the last dimension to have size 2, got shape {a.shape}")
+
+    new_shape = a.shape[:-1]
+    ret_type = tl.block_type(a.type.scalar, new_shape)
+    outLHS, outRHS = builder.create_split(a.handle)
+    return (
+        tl.tensor(outLHS, ret_type),
+        tl.tensor(outRHS, ret_type),
+    )
+
+
 def trans(input: tl.tensor, builder: ir.builder) -> tl.tensor:
     if len(input.shape) != 2:
         raise ValueError("Only 2D tensors can be transposed")
@@ -648,7 +689,29 @@ def _str_to_rounding_mode(rounding_mode: str):
         return ir.ROUNDING_MODE.RTNE
     if rounding_mode == 'rtz':
         return ir.ROUNDING_MODE.RTZ
-    raise ValueError(f"Invalid rounding mode: {rounding_mode}. Supported rounding modes are 'rtne' and 'rtz'.")
+    if rounding_mode == 'rs':
+        return ir.ROUNDING_MODE.RS
+    raise ValueError(
+        f"Invalid rounding mode: {rounding_mode}. Supported rounding modes are 'rtne', 'rtz' and 'rs'.")
+
+
+def _stochastic_fp_downcast(input: tl.tensor, dst_ty: tl.dtype, rbits: tl.tensor, builder: ir.builder) -> tl.tensor:
+    src_sca_ty = input.type.scalar
+    dst_sca_ty = dst_ty.scalar
+    if not ((src_sca_ty.is_fp32() and (dst_sca_ty.is_fp16() or dst_sca_ty.is_bf16() or dst_sca_ty.is_fp8e5())) or
+            (src_sca_ty.is_fp16() and dst_sca_ty.is_fp8e5())):
+        raise ValueError("Stochastic rounding is only supported from fp32 to fp16, bf16 and fp8e5, "
+                         f"and from fp16 to fp8e5, not from {src_sca_ty} to {dst_sca_ty}")
+    if not isinstance(rbits, tl.tensor) or rbits.type.scalar not in (tl.int32, tl.uint32):
+        raise ValueError("Stochastic rounding requires a tensor of int32 or uint32 random bits as rbits")
+    if input.type.is_block():
+        if not rbits.type.is_block():
+            rbits = splat(rbits, input.type.get_block_shapes(), builder)
+        elif rbits.type.get_block_shapes() != input.type.get_block_shapes():
+            rbits = broadcast_impl_shape(rbits, input.type.get_block_shapes(), builder)
+    elif rbits.type.is_block():
+        raise ValueError("The random bits of a scalar must be a scalar")
+    return tl.tensor(builder.create_stochastic_fp_to_fp(input.handle, dst_ty.to_ir(builder), rbits.handle), dst_ty)
 
 
 def bitcast(input: tl.tensor, dst_ty: tl.dtype, builder: ir.builder) -> tl.tensor:
@@ -670,7 +733,8 @@ def bitcast(input: tl.tensor, dst_ty: tl.dtype, builder: ir.builder) -> tl.tenso
     return tl.tensor(builder.create_bitcast(input.handle, dst_ty.to_ir(builder)), dst_ty)
 
 
-def cast(input: tl.tensor, dst_ty: tl.dtype, builder: ir.builder, fp_downcast_rounding: str = None) -> tl.tensor:
+def cast(input: tl.tensor, dst_ty: tl.dtype, builder: ir.builder, fp_downcast_rounding: str = None,
+         rbits: tl.tensor = None) -> tl.tensor:
     src_ty = input.type
     if isinstance(dst_ty, tl.constexpr):
         dst_ty = dst_ty.value
@@ -687,6 +751,10 @@ def cast(input: tl.tensor, dst_ty: tl.dtype, builder: ir.builder, fp_downcast_ro
     # For fp downcasting default rounding mode should be RTNE, for all other conversions it should
     # not be set
     fp_downcast_rounding = _str_to_rounding_mode(fp_downcast_rounding)
+    if (fp_downcast_rounding == ir.ROUNDING_MODE.RS) != (rbits is not None):
+        raise ValueError("rbits should be set if and only if fp_downcast_rounding is 'rs'")
+    if fp_downcast_rounding == ir.ROUNDING_MODE.RS:
+        return _stochastic_fp_downcast(input, dst_ty, rbits, builder)
     use_custom_rounding = False
     if dst_sca_ty.is_floating() and src_sca_ty.is_floating(
     ) and dst_sca_ty.primitive_bitwidth < src_sca_ty.primitive_bitwidth:
@@ -697,7 +765,8 @@ def cast(input: tl.tensor, dst_ty: tl.dtype, builder: ir.builder, fp_downcast_ro
             raise ValueError("fp_downcast_rounding should be set only for truncating fp conversions. "
                              "Source scalar type is " + str(src_sca_ty) + " and destination type is " + str(dst_sca_ty))
 
-    if (src_sca_ty.is_fp8e4nv() or dst_sca_ty.is_fp8e4nv()):
+    # older GPUs emulate the upcasts from fp8e4nv
+    if dst_sca_ty.is_fp8e4nv() or (src_sca_ty.is_fp8e4nv() and not dst_sca_ty.is_floating()):
         assert builder.options.allow_fp8e4nv, "fp8e4nv data type is not supported on CUDA arch < 89"
 
     # Casting with customized floating types involved: fp8 <=> bf16, fp16, fp32, fp64
@@ -819,6 +888,8 @@ def _str_to_eviction_policy(eviction_policy):
             eviction = ir.EVICTION_POLICY.EVICT_LAST
         elif eviction_policy == "evict_first":
             eviction = ir.EVICTION_POLICY.EVICT_FIRST
+        elif eviction_policy == "no_allocate":
+            eviction = ir.EVICTION_POLICY.NO_ALLOCATE
         else:
             raise ValueError(f"Eviction policy {eviction_policy} not supported")
     return eviction
@@ -1061,6 +1132,20 @@ def store(ptr: tl.tensor, val: tl.tensor, mask: Optional[tl.tensor], boundary_ch
         return _store_legacy(ptr, val, mask, boundary_check, cache, eviction, builder)
 
 
+def prefetch(ptr: tl.tensor, mask: Optional[tl.tensor], eviction_policy: str, builder: ir.builder) -> tl.tensor:
+    if not ptr.type.scalar.is_ptr() or ptr.type.scalar.element_ty.is_block():
+        raise ValueError(f"Unsupported ptr type {ptr.type.__repr__()} in `tl.prefetch`")
+    eviction = _str_to_eviction_policy(eviction_policy)
+    if mask:
+        if not mask.type.scalar.is_bool():
+            raise ValueError("Mask must have boolean scalar type")
+        if not ptr.type.is_block() and mask.type.is_block():
+            raise ValueError("Mask argument cannot be block type if pointer argument is not a block")
+        if ptr.type.is_block():
+            mask = broadcast_impl_shape(mask, ptr.type.get_block_shapes(), builder)
+    return tl.tensor(builder.create_prefetch(ptr.handle, mask.handle if mask else None, eviction), tl.void)
+
+
 #########
 # atomic
 #########
@@ -1080,9 +1165,9 @@ def atom_red_typechecking_impl(ptr: tl.tensor, val: tl.tensor, mask: tl.tensor,
     if not ptr.type.scalar.is_ptr():
         raise ValueError("Pointer argument of store instruction is " + ptr.type.__repr__())
     element_ty = ptr.type.scalar.element_ty
-    if element_ty is tl.float16 and op != 'add':
-        raise ValueError("atomic_" + op + " does not support fp16")
-    if element_ty in [tl.int1, tl.int8, tl.int16, tl.bfloat16]:
+    if element_ty in [tl.float16, tl.bfloat16] and op != 'add':
+        raise ValueError("atomic_" + op + " does not support " + str(element_ty))
+    if element_ty in [tl.int1, tl.int8, tl.int16]:
         raise ValueError("atomic_" + op + " does not support " + str(element_ty))
     if ptr.type.is_block():
         if mask:
@@ -1172,13 +1257,17 @@ def atomic_min(ptr: tl.tensor, val: tl.tensor, mask: tl.tensor, sem: str, scope:
     return bitcast(ret, sca_ty, builder)
 
 
-def atomic_add(ptr: tl.tensor, val: tl.tensor, mask: tl.tensor, sem: str, scope: str, builder: ir.builder) -> tl.tensor:
+def atomic_add(ptr: tl.tensor, val: tl.tensor, mask: tl.tensor, sem: str, scope: str, aggregate: bool,
+               builder: ir.builder) -> tl.tensor:
     ptr, val, mask = atom_red_typechecking_impl(ptr, val, mask, 'add', builder)
     sem = _str_to_sem(sem)
     scope = _str_to_scope(scope)
     sca_ty = val.type.scalar
     op = ir.ATOMIC_OP.FADD if sca_ty.is_floating() else ir.ATOMIC_OP.ADD
-    return tl.tensor(builder.create_atomic_rmw(op, ptr.handle, val.handle, mask.handle, sem, scope), val.type)
+    ret = builder.create_atomic_rmw(op, ptr.handle, val.handle, mask.handle, sem, scope)
+    if aggregate:
+        ret.set_attr("tt.warp_aggregate", builder.get_bool_attr(True))
+    return tl.tensor(ret, val.type)
 
 
 def atomic_and(ptr: tl.tensor, val: tl.tensor, mask: tl.tensor, sem: str, scope: str, builder: ir.builder) -> tl.tensor:
@@ -1254,17 +1343,24 @@ def dot(lhs: tl.tensor, rhs: tl.tensor, acc: tl.tensor, allow_tf32: bool, max_nu
 
     assert_dtypes_valid(lhs.dtype, rhs.dtype, builder.options)
 
-    assert len(lhs.shape) == 2, f"First input shape ({lhs.shape}) is not two dimensional!"
-    assert len(rhs.shape) == 2, f"Second input shape ({rhs.shape}) is not two dimensional!"
-    assert lhs.shape[1].value == rhs.shape[
-        0].value, f"First input shape ({lhs.shape}) and second input shape {rhs.shape} are not compatible for matmul (second index of first shape ({lhs.shape[1].value}) must be equal to first index of second shape ({rhs.shape[0].value})"
-    assert lhs.shape[0].value >= 16 and lhs.shape[1].value >= 16 \
-        and rhs.shape[1].value >= 16, \
+    # batched dots multiply the matrices of a leading batch dimension
+    rank = len(lhs.shape)
+    assert rank in (2, 3), f"First input shape ({lhs.shape}) is not two or three dimensional!"
+    assert len(rhs.shape) == rank, f"Second input shape ({rhs.shape}) doesn't have the rank of the first ({lhs.shape})!"
+    if rank == 3:
+        assert builder.options.allow_batched_dot, "batched dots are only supported on NVIDIA GPUs of sm75+!"
+        assert lhs.shape[0].value == rhs.shape[0].value, \
+            f"First input shape ({lhs.shape}) and second input shape {rhs.shape} must have the same batch size!"
+        assert not (lhs.type.scalar.is_fp32() and not allow_tf32), "batched dots of float32 need allow_tf32!"
+    assert lhs.shape[-1].value == rhs.shape[
+        -2].value, f"First input shape ({lhs.shape}) and second input shape {rhs.shape} are not compatible for matmul (last index of first shape ({lhs.shape[-1].value}) must be equal to second-to-last index of second shape ({rhs.shape[-2].value})"
+    assert lhs.shape[-2].value >= 16 and lhs.shape[-1].value >= 16 \
+        and rhs.shape[-1].value >= 16, \
         f"All values in both first input shape ({lhs.shape}) and second input shape ({rhs.shape}) must be >= 16!"
     if lhs.type.scalar.is_int():
         assert lhs.type.scalar == tl.int8, "only int8 supported!"
         # TODO: This is CUDA specific, check if ROCm has the same limitation
-        assert lhs.shape[1].value >= 32, "small blocks not supported!"
+        assert lhs.shape[-1].value >= 32, "small blocks not supported!"
         _0 = builder.get_int32(0)
         ret_scalar_ty = tl.int32
     elif out_dtype.is_bf16():
@@ -1277,8 +1373,9 @@ def dot(lhs: tl.tensor, rhs: tl.tensor, acc: tl.tensor, allow_tf32: bool, max_nu
         _0 = builder.get_fp16(0) if out_dtype.is_fp16() else builder.get_fp32(0)
         ret_scalar_ty = out_dtype
 
-    M = lhs.type.shape[0]
-    N = rhs.type.shape[1]
+    M = lhs.type.shape[-2]
+    N = rhs.type.shape[-1]
+    batch = [lhs.type.shape[0]] if rank == 3 else []
 
     # Cast operands of types f16 and i8 for configurations where FMA only supported.
     # TODO: builder should contain target information
@@ -1304,9 +1401,9 @@ def dot(lhs: tl.tensor, rhs: tl.tensor, acc: tl.tensor, allow_tf32: bool, max_nu
     #     ret_ty = tl.block_type(ret_dot_scalar_ty, [M, N])
     #     ret = tl.tensor(builder.create_dot(lhs.handle, rhs.handle, _0, allow_tf32), ret_ty)
     #     return cast(ret, ret_scalar_ty, builder)
-    ret_ty = tl.block_type(ret_scalar_ty, [M, N])
+    ret_ty = tl.block_type(ret_scalar_ty, batch + [M, N])
     if acc is None:
-        acc_handle = builder.create_splat(_0, [M, N])
+        acc_handle = builder.create_splat(_0, batch + [M, N])
     else:
         acc_handle = acc.handle
         assert acc.type == ret_ty
@@ -1321,6 +1418,43 @@ def dot(lhs: tl.tensor, rhs: tl.tensor, acc: tl.tensor, allow_tf32: bool, max_nu
     return tl.tensor(builder.create_dot(lhs.handle, rhs.handle, acc_handle, allow_tf32, max_num_imprecise_acc), ret_ty)
 
 
+def dot_scaled(lhs: tl.tensor, rhs: tl.tensor, lhs_scale: tl.tensor, rhs_scale: tl.tensor, acc: tl.tensor,
+               allow_tf32: bool, max_num_imprecise_acc: int, builder: ir.builder) -> tl.tensor:
+    assert lhs.type.is_block() and rhs.type.is_block()
+    assert len(lhs.shape) == 2 and len(rhs.shape) == 2, "Both inputs must be two dimensional!"
+    assert lhs.dtype == rhs.dtype or (lhs.dtype.is_fp8() and rhs.dtype.is_fp8()), \
+        f"First input ({lhs.dtype}) and second input ({rhs.dtype}) must have the same dtype!"
+    M = lhs.shape[0].value
+    N = rhs.shape[1].value
+    assert lhs_scale.type.is_block() and [d.value for d in lhs_scale.shape] == [M, 1], \
+        f"First scale shape ({lhs_scale.shape}) must be [{M}, 1]!"
+    assert rhs_scale.type.is_block() and [d.value for d in rhs_scale.shape] == [1, N], \
+        f"Second scale shape ({rhs_scale.shape}) must be [1, {N}]!"
+    lhs_scale = cast(lhs_scale, tl.float32, builder)
+    rhs_scale = cast(rhs_scale, tl.float32, builder)
+    assert lhs.shape[1].value == rhs.shape[0].value, \
+        f"First input shape ({lhs.shape}) and second input shape {rhs.shape} are not compatible for matmul!"
+    assert M >= 16 and N >= 16 and lhs.shape[1].value >= 16, \
+        f"All values in both first input shape ({lhs.shape}) and second input shape ({rhs.shape}) must be >= 16!"
+    if lhs.dtype.is_int():
+        assert lhs.dtype == tl.int8, "only int8 supported!"
+        assert lhs.shape[1].value >= 32, "small blocks not supported!"
+    ret_ty = tl.block_type(tl.float32, [M, N])
+    if acc is None:
+        acc_handle = builder.create_splat(builder.get_fp32(0), [M, N])
+    else:
+        acc_handle = acc.handle
+        assert acc.type == ret_ty
+    if max_num_imprecise_acc is None:
+        if lhs.dtype.is_fp8() and rhs.dtype.is_fp8():
+            max_num_imprecise_acc = builder.options.max_num_imprecise_acc_default
+        else:
+            max_num_imprecise_acc = 0
+    return tl.tensor(
+        builder.create_dot_scaled(lhs.handle, rhs.handle, acc_handle, lhs_scale.handle, rhs_scale.handle, allow_tf32,
+                                  max_num_imprecise_acc), ret_ty)
+
+
 # ===----------------------------------------------------------------------===//
 #                               Indexing
 # ===----------------------------------------------------------------------===//
@@ -1410,6 +1544,20 @@ def associative_scan(inputs: Sequence[tl.tensor], axis: int, region_builder_fn,
 # ===----------------------------------------------------------------------===
 
 
+def sort(input: tl.tensor, dim: int, descending: bool, builder: ir.builder) -> tl.tensor:
+    size = input.shape[dim]
+    assert size & (size - 1) == 0, f"the size of the sorted dimension must be a power of two, got {size}"
+    scalar_ty = input.type.scalar
+    if not (scalar_ty.is_floating() or (scalar_ty.is_int() and not scalar_ty.is_bool())):
+        raise ValueError(f"sort only supports integers and floats, got {scalar_ty}")
+    if scalar_ty.is_int_unsigned():
+        # The sort compares signed integers, flipping the sign bit orders unsigned ones
+        sign_bit = full(input.shape, 1 << (scalar_ty.int_bitwidth - 1), scalar_ty, builder)
+        input = xor_(input, sign_bit, builder)
+        return xor_(sort(input, dim, descending, builder), sign_bit, builder)
+    return tl.tensor(builder.create_sort(input.handle, dim, descending), input.type)
+
+
 def histogram(input: tl.tensor, num_bins: int, builder: ir.builder) -> tl.tensor:
     assert len(input.shape) == 1, "histogram only supports 1D input"
     assert input.dtype.is_int(), "histogram only supports integer input"
@@ -1417,6 +1565,27 @@ def histogram(input: tl.tensor, num_bins: int, builder: ir.builder) -> tl.tensor
     return tl.tensor(histogram_op.get_result(0), tl.block_type(tl.int32, (num_bins, )))
 
 
+def gather(src: tl.tensor, index: tl.tensor, axis: int, builder: ir.builder) -> tl.tensor:
+    if not src.type.is_block() or not index.type.is_block():
+        raise ValueError("gather expects tensors for its source and indices")
+    if not index.dtype.is_int():
+        raise ValueError(f"gather expects integer indices, got {index.dtype}")
+    rank = len(src.shape)
+    if len(index.shape) != rank:
+        raise ValueError(f"gather expects its source and indices to have the same rank, got {src.shape} and "
+                         f"{index.shape}")
+    if axis < 0:
+        axis += rank
+    if not 0 <= axis < rank:
+        raise ValueError(f"gather axis {axis} is out of range for a tensor of rank {rank}")
+    for d in range(rank):
+        if d != axis and index.shape[d] != src.shape[d]:
+            raise ValueError(f"gather expects its source and indices to have the same shape but along the axis, got "
+                             f"{src.shape} and {index.shape}")
+    ret_ty = tl.block_type(src.type.scalar, index.shape)
+    return tl.tensor(builder.create_gather(src.handle, index.handle, axis), ret_ty)
+
+
 # ===----------------------------------------------------------------------===
 #                               Math
 # ===----------------------------------------------------------------------===
@@ -1526,6 +1695,11 @@ def debug_barrier(builder: ir.builder) -> tl.tensor:
     return tl.tensor(builder.create_barrier(), tl.void)
 
 
+def grid_sync(builder: ir.builder) -> tl.tensor:
+    builder.create_grid_sync()
+    return tl.tensor(None, tl.void)
+
+
 def device_print(prefix: str, args: List[tl.tensor], builder: ir.builder) -> tl.tensor:
     # It makes sense visually for prefix to end in ": "; make it so.  Also,
     # non-empty prefixes should start with " ".
@@ -1550,6 +1724,13 @@ def device_assert(cond: tl.tensor, msg: str, file_name: str, func_name, lineno:
     return tl.tensor(builder.create_assert(cond.handle, msg, file_name, func_name, lineno), tl.void)
 
 
+def profile_mark(name: str, end: bool, builder: ir.builder) -> tl.tensor:
+    # nothing is compiled in unless the kernel is profiled
+    if getattr(builder.options, "profile_regions", 0):
+        builder.create_profile_mark(name, end)
+    return tl.tensor(None, tl.void)
+
+
 def _convert_elem_to_ir_value(builder, elem, require_i64):
     if isinstance(elem, int):
         elem = tl.constexpr(elem)
@@ -297,120 +297,106 @@ def cumprod(input, axis=0):
     return core.associative_scan(input, axis, _prod_combine)
 
 
-# sort
+# cumsum across programs
 
 
 @jit
-def _indicator(n_dims: core.constexpr, idx: core.constexpr, pos: core.constexpr):
-    core.static_assert(idx < n_dims)
-    core.static_assert((pos == 0) or (pos == 1))
-    y = core.arange(0, 2)
-    if pos == 0:
-        y = 1 - y
+def cumsum_look_back(aggregate, tile_id, state_ptr):
+    """
+    Returns the sum of the :code:`aggregate` of the tiles before :code:`tile_id`, so that
+    a prefix sum over a whole array takes a single kernel: each program scans its tile
+    with :code:`cumsum` and adds the sum of the previous tiles.
 
-    for n in core.static_range(0, n_dims):
-        if n != n_dims - 1 - idx:
-            y = core.expand_dims(y, n)
-    return y
+    The tiles publish their aggregate in :code:`state_ptr`, then their inclusive prefix
+    once they know it, each with a status flag. A tile looks back at the previous tiles
+    until one has published its inclusive prefix, summing the aggregates on the way
+    (decoupled look-back).
 
+    The tile ids must follow the order the programs start in, like the ones returned by an
+    :code:`atomic_add` on a counter, or the programs may wait on tiles that haven't started.
 
-@jit
-def _cast_to_int(x):
-    y = x
-    if x.dtype.is_floating():
-        if core.constexpr(x.dtype.primitive_bitwidth) == 16:
-            dtype_int = core.int16
-        elif core.constexpr(x.dtype.primitive_bitwidth) == 32:
-            dtype_int = core.int32
-        elif core.constexpr(x.dtype.primitive_bitwidth) == 64:
-            dtype_int = core.int64
-        else:
-            raise ValueError("Unsupported dtype")
-        y = x.to(dtype_int, bitcast=True)
-    return y
+    :param aggregate: The sum of the tile, a 32-bit scalar
+    :param tile_id: The index of the tile
+    :param state_ptr: Pointer to one zero-initialized :code:`int64` per tile
+    """
+    core.static_assert(aggregate.dtype.primitive_bitwidth == 32, "cumsum_look_back only supports 32-bit values")
+    # The flag is 1 for an aggregate and 2 for an inclusive prefix, packed with the value in
+    # one word so that they are published at once
+    flag = core.where(tile_id == 0, 2, 1).to(core.int64)
+    bits = aggregate.to(core.uint32, bitcast=True).to(core.int64)
+    core.atomic_xchg(state_ptr + tile_id, (flag << 32) | bits, sem="release")
+    prefix = core.full([], 0, aggregate.dtype)
+    i = tile_id - 1
+    while i >= 0:
+        state = core.load(state_ptr + i, volatile=True)
+        flag = state >> 32
+        value = (state & 0xFFFFFFFF).to(core.uint32).to(aggregate.dtype, bitcast=True)
+        prefix = core.where(flag != 0, prefix + value, prefix)
+        i = core.where(flag == 2, -1, core.where(flag == 1, i - 1, i))
+    bits = (prefix + aggregate).to(core.uint32, bitcast=True).to(core.int64)
+    core.atomic_xchg(state_ptr + tile_id, (2 << 32) | bits, mask=tile_id > 0, sem="release")
+    return prefix
+
+
+# gathered rows
 
 
 @jit
-def _take_slice(x, n_dims: core.constexpr, idx: core.constexpr, pos: core.constexpr, keep_dim: core.constexpr = True):
-    y = sum(x * _indicator(n_dims, idx, pos).to(x.dtype), n_dims - 1 - idx)
-    if keep_dim:
-        y = core.expand_dims(y, n_dims - 1 - idx)
+def load_rows(pointer, rows, cols, row_stride, row_mask=None, col_mask=None, other=None,
+              eviction_policy: core.constexpr = ""):
+    """
+    Loads the rows :code:`rows` of a row-major matrix at the columns :code:`cols`: element
+    :code:`[i, j]` of the result is :code:`pointer[rows[i] * row_stride + cols[j]]`, like the
+    token rows the expert GEMMs of a mixture of experts read through an index list.
+
+    The columns are contiguous, so the load is coalesced along them whatever the rows, and
+    in a loop over the columns feeding :code:`dot` the pipeliner stages it through shared
+    memory with :code:`cp.async` copies as wide as the alignment of :code:`pointer` and
+    :code:`row_stride` allows, e.g. 16 bytes when :code:`row_stride` is a multiple of 16.
+    The row offsets are computed in 64 bits, once per loop.
+
+    :param pointer: Pointer to the first element of the matrix
+    :param rows: 1D tensor of the indices of the rows, e.g. loaded from an index list
+    :param cols: 1D tensor of contiguous column indices, e.g. :code:`k + tl.arange(0, BLOCK_K)`
+    :param row_stride: The number of elements between the starts of consecutive rows
+    :param row_mask: 1D mask of the rows to load, or None
+    :param col_mask: 1D mask of the columns to load, or None
+    :param other: The value of the masked-out elements
+    """
+    offsets = (rows.to(core.int64) * row_stride)[:, None] + cols[None, :]
+    mask = None
+    if row_mask is not None:
+        mask = row_mask[:, None]
+    if col_mask is not None:
+        if mask is None:
+            mask = col_mask[None, :]
+        else:
+            mask = mask & col_mask[None, :]
+    return core.load(pointer + offsets, mask=mask, other=other, eviction_policy=eviction_policy)
 
-    return y
 
+# top-k
 
-@jit
-def _compare_and_swap(x, desc_mask, n_dims: core.constexpr, idx: core.constexpr):
-    x_int = _cast_to_int(x)
-    l_int = _take_slice(x_int, n_dims, idx, 0)
-    r_int = _take_slice(x_int, n_dims, idx, 1)
-    l = l_int.to(x.dtype, bitcast=True)
-    r = r_int.to(x.dtype, bitcast=True)
 
-    desc_mask = desc_mask.to(x_int.dtype)
-    zero = zeros_like(x_int)
-    y = x_int ^ core.where((l > r) ^ desc_mask, l_int ^ r_int, zero)
-    y = y.to(x.dtype, bitcast=True)
-    return y
+def _get_topk_shape(shape, k):
+    shape = [core._constexpr_to_value(s) for s in shape]
+    k = core._constexpr_to_value(k)
+    assert k > 0 and (k & (k - 1)) == 0 and k <= shape[-1], \
+        f"k must be a power of two at most the size of the last dimension, got {k}"
+    return shape[:-1] + [shape[-1] // k, k]
 
 
 @jit
-def _bitonic_merge(x, n_dims: core.constexpr, active_dims: core.constexpr, order_type: core.constexpr):
-    '''
-    order_type 0 == ascending
-    order_type 1 == descending
-    order_type 2 == alternating
-    '''
-    core.static_assert(active_dims <= n_dims)
-
-    if order_type == 2:
-        desc_mask = _indicator(n_dims, active_dims, 1)
-    else:
-        desc_mask = order_type
-
-    for i in core.static_range(active_dims):
-        x = _compare_and_swap(x, desc_mask, n_dims, active_dims - 1 - i)
-
-    return x
-
-
-def _log2(i: core.constexpr):
-    log2 = 0
-    n = i.value
-    while n > 1:
-        n >>= 1
-        log2 += 1
-    return core.constexpr(log2)
-
-
-def _is_power_of_two(i: core.constexpr):
-    n = i.value
-    return core.constexpr((n & (n - 1)) == 0 and n != 0)
-
-
-def _unwrap_if_constexpr(o):
-    return o.value if isinstance(o, core.constexpr) else o
-
-
-def _get_sort_dim(dim, shape):
-    dim = _unwrap_if_constexpr(dim)
-    shape = _unwrap_if_constexpr(shape)
-    if dim is None:
-        dim = len(shape) - 1
-    assert dim == len(shape) - 1, "Currently only support sorting on the last dimension"
-    return core.constexpr(dim)
-
+def topk(x, k: core.constexpr):
+    """
+    Returns the :code:`k` largest elements of :code:`x` along its last dimension, in descending order.
 
-@jit
-def sort(x, dim=None, descending: core.constexpr = 0):
-    core.static_assert(_is_power_of_two(x.shape[_get_sort_dim(dim, x.shape)]))
-    core.static_assert(_is_power_of_two(x.numel))
-    # reshape the tensor to have all dimensions be 2.
-    # TODO: We shouldn't have to change the dimensions not sorted.
-    y = core.reshape(x, [2] * _log2(x.numel))
-    for i in core.static_range(1, _log2(x.shape[_get_sort_dim(dim, x.shape)]) + 1):
-        y = _bitonic_merge(y, _log2(x.numel), i, (descending if
-                                                  (i == _log2(x.shape[_get_sort_dim(dim, x.shape)])) else 2))
-
-    x = core.reshape(y, x.shape)
-    return x
+    :param x: the input tensor
+    :type x: Block
+    :param k: the number of elements to keep, a power of two
+    :type k: int
+    """
+    y = core.sort(x, descending=True)
+    # Each group of k sorted elements is smaller element-wise than the first one
+    y = core.reshape(y, _get_topk_shape(x.shape, k))
+    return max(y, -2).to(x.dtype)
@@ -1,7 +1,11 @@
 # from .conv import _conv, conv
 from . import blocksparse
-from .cross_entropy import _cross_entropy, cross_entropy
-from .flash_attention import attention
+from .cross_entropy import _cross_entropy, cross_entropy, linear_cross_entropy
+from .flash_attention import attention, attention_decode, attention_varlen, paged_attention
+from .grouped_matmul import grouped_matmul
 from .matmul import _matmul, get_higher_dtype, matmul
 
-__all__ = ["blocksparse", "_cross_entropy", "cross_entropy", "_matmul", "matmul", "attention", "get_higher_dtype"]
+__all__ = [
+    "blocksparse", "_cross_entropy", "cross_entropy", "linear_cross_entropy", "_matmul", "matmul", "attention",
+    "attention_decode", "attention_varlen", "paged_attention", "grouped_matmul", "get_higher_dtype"
+]
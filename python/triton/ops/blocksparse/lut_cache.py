@@ -0,0 +1,24 @@
+import hashlib
+
+import torch
+
+# look-up tables already on the device, by the function that built them, the
+# hash of the layout and the other arguments of the function
+_luts = {}
+
+
+def layout_hash(layout):
+    data = (layout != 0).to(device="cpu", dtype=torch.uint8).contiguous()
+    return hashlib.sha256(data.numpy().tobytes()).hexdigest()
+
+
+def cached_lut(make_lut, layout, *args):
+    """
+    Returns `make_lut(layout, *args)`, built once per layout and arguments.
+    The ops of the layers of a model that share a layout then share their
+    tables, which are only read by the kernels.
+    """
+    key = (make_lut.__qualname__, tuple(layout.shape), layout_hash(layout), args)
+    if key not in _luts:
+        _luts[key] = make_lut(layout, *args)
+    return _luts[key]
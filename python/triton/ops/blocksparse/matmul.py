@@ -2,6 +2,8 @@ import torch
 
 from ... import cdiv, heuristics, jit
 from ... import language as tl
+from ..matmul_perf_model import get_num_sms
+from .lut_cache import cached_lut
 
 # ********************************************************
 # --------------------------------------------------------
@@ -80,7 +82,7 @@ def _sdd_kernel(A, B, C,  #
     tl.store(pc, c, mask=True)
 
 
-def sdd_matmul(a, b, trans_a, trans_b, trans_c, spdims, block, lut, widths, out=None):
+def sdd_matmul(a, b, trans_a, trans_b, trans_c, spdims, block, lut, widths, out=None, persistent=False):
     if a.stride(2) != 1 and a.stride(3) != 1:
         a = a.contiguous()
     if b.stride(2) != 1 and b.stride(3) != 1:
@@ -128,23 +130,17 @@ def sdd_lut(layout, block, device):
 
 
 @jit
-def _dsd_kernel(A, B, C,  #
-                stride_az, stride_ha, stride_am, stride_ak,  #
-                stride_zb, stride_hb, stride_bk, stride_bn,  #
-                stride_zc, stride_hc, stride_cm, stride_cn,  #
-                DS0, DS1, lut,  #
-                TILE_M: tl.constexpr, TILE_N: tl.constexpr, TILE_K: tl.constexpr,  #
-                GROUP_SIZE_M: tl.constexpr, BLOCK: tl.constexpr  #
-                ):
+def _dsd_tile(A, B, C,  #
+              stride_az, stride_ha, stride_am, stride_ak,  #
+              stride_zb, stride_hb, stride_bk, stride_bn,  #
+              stride_zc, stride_hc, stride_cm, stride_cn,  #
+              DS0, lut, pid_n, pid_m, pidz,  #
+              TILE_M: tl.constexpr, TILE_N: tl.constexpr, TILE_K: tl.constexpr,  #
+              BLOCK: tl.constexpr  #
+              ):
     # ------------ #
     # - Prologue - #
     # ------------ #
-    pid_m = tl.program_id(0)
-    pid_n = tl.program_id(1)
-    num_pid_m = tl.num_programs(0)
-    num_pid_n = tl.num_programs(1)
-    pid_n, pid_m = tl.swizzle2d(pid_n, pid_m, num_pid_n, num_pid_m, GROUP_SIZE_M)
-    pidz = tl.program_id(2)
     header = lut + pid_n * 4
     offset = tl.load(header + 0)
     K = tl.load(header + 1)
@@ -202,7 +198,65 @@ def _dsd_kernel(A, B, C,  #
     tl.store(pc, c, mask=offs_cn[None, :] < DS0)
 
 
-def dsd_matmul(a, b, trans_a, trans_b, trans_c, spdims, block, lut, width, out=None):
+@jit
+def _dsd_kernel(A, B, C,  #
+                stride_az, stride_ha, stride_am, stride_ak,  #
+                stride_zb, stride_hb, stride_bk, stride_bn,  #
+                stride_zc, stride_hc, stride_cm, stride_cn,  #
+                DS0, DS1, lut,  #
+                TILE_M: tl.constexpr, TILE_N: tl.constexpr, TILE_K: tl.constexpr,  #
+                GROUP_SIZE_M: tl.constexpr, BLOCK: tl.constexpr  #
+                ):
+    pid_m = tl.program_id(0)
+    pid_n = tl.program_id(1)
+    num_pid_m = tl.num_programs(0)
+    num_pid_n = tl.num_programs(1)
+    pid_n, pid_m = tl.swizzle2d(pid_n, pid_m, num_pid_n, num_pid_m, GROUP_SIZE_M)
+    pidz = tl.program_id(2)
+    _dsd_tile(A, B, C,  #
+              stride_az, stride_ha, stride_am, stride_ak,  #
+              stride_zb, stride_hb, stride_bk, stride_bn,  #
+              stride_zc, stride_hc, stride_cm, stride_cn,  #
+              DS0, lut, pid_n, pid_m, pidz,  #
+              TILE_M, TILE_N, TILE_K, BLOCK)
+
+
+@jit
+def _dsd_kernel_persistent(A, B, C,  #
+                           stride_az, stride_ha, stride_am, stride_ak,  #
+                           stride_zb, stride_hb, stride_bk, stride_bn,  #
+                           stride_zc, stride_hc, stride_cm, stride_cn,  #
+                           DS0, DS1, lut,  #
+                           schedule_offset, width, num_pid_m, Z,  #
+                           TILE_M: tl.constexpr, TILE_N: tl.constexpr, TILE_K: tl.constexpr,  #
+                           BLOCK: tl.constexpr  #
+                           ):
+    # Each wave, the programs take one tile each, in the order of the rows of
+    # the sparse operand by decreasing number of blocks (the schedule at the
+    # end of the look-up table). The order of the programs alternates between
+    # waves, so that the programs that took the longest tile of a wave take
+    # the shortest of the next one.
+    pid = tl.program_id(0)
+    num_programs = tl.num_programs(0)
+    num_tiles = width * num_pid_m * Z
+    for wave in range(0, tl.cdiv(num_tiles, num_programs)):
+        if wave % 2 == 0:
+            tile = wave * num_programs + pid
+        else:
+            tile = wave * num_programs + num_programs - 1 - pid
+        if tile < num_tiles:
+            pid_n = tl.load(lut + schedule_offset + tile // (num_pid_m * Z))
+            pid_m = (tile // Z) % num_pid_m
+            pidz = tile % Z
+            _dsd_tile(A, B, C,  #
+                      stride_az, stride_ha, stride_am, stride_ak,  #
+                      stride_zb, stride_hb, stride_bk, stride_bn,  #
+                      stride_zc, stride_hc, stride_cm, stride_cn,  #
+                      DS0, lut, pid_n, pid_m, pidz,  #
+                      TILE_M, TILE_N, TILE_K, BLOCK)
+
+
+def dsd_matmul(a, b, trans_a, trans_b, trans_c, spdims, block, lut, width, out=None, persistent=False):
     if a.stride(2) != 1 and a.stride(3) != 1:
         a = a.contiguous()
     if b.stride(2) != 1 and b.stride(3) != 1:
@@ -226,13 +280,28 @@ def dsd_matmul(a, b, trans_a, trans_b, trans_c, spdims, block, lut, width, out=N
     # meta-parameter heuristics
     TILE_N = 128
     # compute output
-    grid = lambda meta: [cdiv(BS3, meta['TILE_N']), width, BS0]
-    _dsd_kernel[grid](
+    args = (
         a, b, c,  #
         a.stride(0), a.stride(1), a.stride(3 if trans_a else 2), a.stride(2 if trans_a else 3),  #
         b.stride(0), b.stride(1), b.stride(3 if trans_b else 2), b.stride(2 if trans_b else 3),  #
         c.stride(0), c.stride(1), c.stride(3 if trans_c else 2), c.stride(2 if trans_c else 3),  #
         BS3, AS1, lut,  #
+    )
+    if persistent:
+        # one program per SM, balanced over the rows of uneven density
+        num_pid_m = cdiv(BS3, TILE_N)
+        num_tiles = width * num_pid_m * BS0
+        grid = [max(min(get_num_sms(a.device.index), num_tiles), 1), 1, 1]
+        _dsd_kernel_persistent[grid](
+            *args,  #
+            lut.numel() - width, width, num_pid_m, BS0,  #
+            TILE_M=block, TILE_N=TILE_N, TILE_K=min(block, 32), BLOCK=block, num_stages=4,  #
+            num_warps=4  #
+        )
+        return c
+    grid = lambda meta: [cdiv(BS3, meta['TILE_N']), width, BS0]
+    _dsd_kernel[grid](
+        *args,  #
         TILE_M=block, TILE_N=TILE_N, TILE_K=min(block, 32), BLOCK=block, num_stages=4,  #
         num_warps=4, GROUP_SIZE_M=4  #
     )
@@ -259,6 +328,9 @@ def dsd_lut(layout, block, step, trans, device):
     which leads to increments table
     [0, 16, 16, 16, || 64, 16, 16, 16, 16, 16, || 160, 16, 16, 16]
 
+    The table ends with the rows by decreasing number of blocks, in the order
+    the persistent kernel visits them.
+
     Because B is dense, the offsets are
     [0, 16, 96, 112] <- row 0
     [32, 48, 64, 80]  <- row 1
@@ -330,8 +402,10 @@ def dsd_lut(layout, block, step, trans, device):
     # to accommodate pre-fetching inside the kernel
     pad = torch.zeros(20, device=incs.device, dtype=incs.dtype)
     incs = torch.cat((incs, pad))
+    # rows by decreasing number of blocks
+    schedule = torch.argsort(segments, descending=True, stable=True)
     # create lut
-    lut = torch.cat((header, incs))
+    lut = torch.cat((header, incs, schedule))
     lut = lut.type(torch.int32).to(device)
     # create locks
     return lut, width
@@ -343,8 +417,9 @@ def dsd_lut(layout, block, step, trans, device):
 # AB = (B^T A^T)^T
 
 
-def dds_matmul(a, b, trans_a, trans_b, trans_c, spdims, block, lut, width, out=None):
-    return dsd_matmul(b, a, not trans_b, not trans_a, not trans_c, spdims, block, lut, width, out=out)
+def dds_matmul(a, b, trans_a, trans_b, trans_c, spdims, block, lut, width, out=None, persistent=False):
+    return dsd_matmul(b, a, not trans_b, not trans_a, not trans_c, spdims, block, lut, width, out=out,
+                      persistent=persistent)
 
 
 ##############
@@ -358,8 +433,9 @@ class _matmul(torch.autograd.Function):
 
     @staticmethod
     def forward(ctx, a, b, trans_a, trans_b, trans_c, mode, spdims, block, c_lut, c_width, da_lut, da_width, db_lut,
-                db_width, out):
-        c = _matmul.fn[mode](a, b, trans_a, trans_b, trans_c, spdims, block, c_lut, c_width, out=out)
+                db_width, persistent, out):
+        c = _matmul.fn[mode](a, b, trans_a, trans_b, trans_c, spdims, block, c_lut, c_width, out=out,
+                             persistent=persistent)
         # save for backward
         ctx.save_for_backward(a, b)
         ctx.da_lut = da_lut
@@ -372,6 +448,7 @@ class _matmul(torch.autograd.Function):
         ctx.trans_a = trans_a
         ctx.trans_b = trans_b
         ctx.trans_c = trans_c
+        ctx.persistent = persistent
         ctx.has_out = out is not None
         return c
 
@@ -385,21 +462,21 @@ class _matmul(torch.autograd.Function):
         if ctx.needs_input_grad[0]:
             mode_da = mode[1] + mode[0] + mode[2]
             da = _matmul.fn[mode_da](dc, b, ctx.trans_c, not ctx.trans_b, ctx.trans_a, ctx.spdims, ctx.block,
-                                     ctx.da_lut, ctx.da_width)
+                                     ctx.da_lut, ctx.da_width, persistent=ctx.persistent)
         # gradients w.r.t. b
         if ctx.needs_input_grad[1]:
             mode_db = mode[2] + mode[1] + mode[0]
             db = _matmul.fn[mode_db](a, dc, not ctx.trans_a, ctx.trans_c, ctx.trans_b, ctx.spdims, ctx.block,
-                                     ctx.db_lut, ctx.db_width)
+                                     ctx.db_lut, ctx.db_width, persistent=ctx.persistent)
         dout = dc if ctx.has_out else None
         return da, db, None, None, None, \
             None, None, None, None, \
-            None, None, None, None, None, dout
+            None, None, None, None, None, None, dout
 
 
 class matmul:
 
-    def __init__(self, layout, block, mode, device, trans_a=False, trans_b=False, trans_c=False):
+    def __init__(self, layout, block, mode, device, trans_a=False, trans_b=False, trans_c=False, persistent=False):
         if mode not in ['sdd', 'dsd', 'dds']:
             raise NotImplementedError('Supported modes are: sdd, dsd, dds')
         self.block = block
@@ -407,26 +484,29 @@ class matmul:
         self.trans_a = trans_a
         self.trans_b = trans_b
         self.trans_c = trans_c
+        # dense outputs are computed by one program per SM, which balances
+        # layouts whose rows have uneven numbers of blocks
+        self.persistent = persistent
         self.layout = layout
         self.spdims = layout.shape
         step = min(block, 32)
         if self.mode == 'sdd':
-            self.c_lut, self.c_width = sdd_lut(layout, block, device)
-            self.da_lut, self.da_width = dsd_lut(layout, block, step, True, device)
-            self.db_lut, self.db_width = dsd_lut(layout, block, step, False, device)
+            self.c_lut, self.c_width = cached_lut(sdd_lut, layout, block, device)
+            self.da_lut, self.da_width = cached_lut(dsd_lut, layout, block, step, True, device)
+            self.db_lut, self.db_width = cached_lut(dsd_lut, layout, block, step, False, device)
         if self.mode == 'dsd':
-            self.c_lut, self.c_width = dsd_lut(layout, block, step, not self.trans_a, device)
-            self.da_lut, self.da_width = sdd_lut(layout, block, device)
-            self.db_lut, self.db_width = dsd_lut(layout, block, step, self.trans_a, device)
+            self.c_lut, self.c_width = cached_lut(dsd_lut, layout, block, step, not self.trans_a, device)
+            self.da_lut, self.da_width = cached_lut(sdd_lut, layout, block, device)
+            self.db_lut, self.db_width = cached_lut(dsd_lut, layout, block, step, self.trans_a, device)
         if self.mode == 'dds':
-            self.c_lut, self.c_width = dsd_lut(layout, block, step, self.trans_b, device)
-            self.da_lut, self.da_width = dsd_lut(layout, block, step, not self.trans_b, device)
-            self.db_lut, self.db_width = sdd_lut(layout, block, device)
+            self.c_lut, self.c_width = cached_lut(dsd_lut, layout, block, step, self.trans_b, device)
+            self.da_lut, self.da_width = cached_lut(dsd_lut, layout, block, step, not self.trans_b, device)
+            self.db_lut, self.db_width = cached_lut(sdd_lut, layout, block, device)
 
     def __call__(self, a, b, out=None):
         c = _matmul.apply(a, b, self.trans_a, self.trans_b, self.trans_c, self.mode, self.spdims, self.block,  #
                           self.c_lut, self.c_width,  #
                           self.da_lut, self.da_width,  #
                           self.db_lut, self.db_width,  #
-                          out)
+                          self.persistent, out)
         return c
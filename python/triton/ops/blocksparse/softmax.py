@@ -3,6 +3,7 @@ import torch
 from ... import jit
 from ... import language as tl
 from ... import next_power_of_2
+from .lut_cache import cached_lut
 
 
 def num_warps(n):
@@ -133,11 +134,8 @@ class _softmax(torch.autograd.Function):
 
     @staticmethod
     def make_lut(layout, block, device):
-        _empty = torch.tensor([], dtype=torch.int64, device=layout.device)
-        sizes = _empty.clone()
         # sizes along rows
-        for h in range(layout.shape[0]):
-            sizes = torch.cat((sizes, layout[h, :, :].sum(-1)))
+        sizes = layout.sum(-1).flatten().long()
         total_sizes = sizes * block
         # offsets in block format
         offsets = torch.zeros_like(sizes)
@@ -217,7 +215,7 @@ class softmax:
         self.spdims = layout.shape
         self.layout = layout
         self.block = block
-        self.lut, self.maxlut = _softmax.make_lut(self.layout, self.block, device)
+        self.lut, self.maxlut = cached_lut(_softmax.make_lut, self.layout, self.block, device)
         self.is_dense = is_dense
 
     def __call__(self, a, *, scale=1.0, rel_logits=None, is_causal=False):
@@ -1,9 +1,13 @@
 import torch
 
-from .. import heuristics, jit
+from .. import cdiv, heuristics, jit
 from .. import language as tl
 from .. import next_power_of_2
 
+# rows longer than this are reduced in chunks of CHUNK_SIZE
+MAX_FUSED_SIZE = 32768
+CHUNK_SIZE = 4096
+
 
 def num_warps(N):
     if N < 2048:
@@ -58,6 +62,81 @@ def _backward(PROBS, IDX, DPROBS, N, BLOCK: tl.constexpr):
     tl.store(PROBS, din.to(PROBS.dtype.element_ty), mask=cols < N)
 
 
+@jit
+def _forward_chunked(LOGITS, LSE, IDX, LOSS, N, BLOCK: tl.constexpr):
+    # online softmax over chunks of the row, so that the whole row does not
+    # have to fit in registers
+    row = tl.program_id(0).to(tl.int64)
+    idx = tl.load(IDX + row)
+    LOGITS = LOGITS + row * N
+    m = float('-inf')
+    l = 0.0
+    for start in range(0, N, BLOCK):
+        cols = start + tl.arange(0, BLOCK)
+        logits = tl.load(LOGITS + cols, mask=cols < N, other=-float('inf'))
+        logits = logits.to(tl.float32)
+        # every chunk has a column, so the maximum is finite
+        m_new = tl.maximum(m, tl.max(logits, 0))
+        l = l * tl.exp(m - m_new) + tl.sum(tl.exp(logits - m_new), 0)
+        m = m_new
+    lse = m + tl.log(l)
+    tl.store(LSE + row, lse)
+    tl.store(LOSS + row, lse - tl.load(LOGITS + idx).to(tl.float32))
+
+
+@jit
+def _backward_chunked(LOGITS, LSE, IDX, DLOSS, DLOGITS, N, BLOCK: tl.constexpr):
+    # DLOGITS may be LOGITS, each element is read before it is written
+    row = tl.program_id(0).to(tl.int64)
+    idx = tl.load(IDX + row)
+    lse = tl.load(LSE + row)
+    dout = tl.load(DLOSS + row).to(tl.float32)
+    LOGITS = LOGITS + row * N
+    DLOGITS = DLOGITS + row * N
+    for start in range(0, N, BLOCK):
+        cols = start + tl.arange(0, BLOCK)
+        logits = tl.load(LOGITS + cols, mask=cols < N, other=0.0)
+        probs = tl.exp(logits.to(tl.float32) - lse)
+        din = (probs - (cols == idx)) * dout
+        tl.store(DLOGITS + cols, din.to(DLOGITS.dtype.element_ty), mask=cols < N)
+
+
+@jit
+def _linear_forward(X, W, IDX, LSE, LOSS,  #
+                    M, N, K,  #
+                    stride_xm, stride_xk, stride_wn, stride_wk,  #
+                    BLOCK_M: tl.constexpr, BLOCK_N: tl.constexpr, BLOCK_K: tl.constexpr):
+    # The logits of BLOCK_M rows are computed one chunk of BLOCK_N columns at a
+    # time, and reduced by an online softmax right away, so that they are
+    # never written to memory.
+    pid = tl.program_id(0)
+    rm = pid * BLOCK_M + tl.arange(0, BLOCK_M)
+    rn = tl.arange(0, BLOCK_N)
+    rk = tl.arange(0, BLOCK_K)
+    idx = tl.load(IDX + rm, mask=rm < M, other=0)
+    X = X + rm[:, None].to(tl.int64) * stride_xm
+    m_i = tl.full([BLOCK_M], float('-inf'), dtype=tl.float32)
+    l_i = tl.zeros([BLOCK_M], dtype=tl.float32)
+    target = tl.zeros([BLOCK_M], dtype=tl.float32)
+    for start_n in range(0, N, BLOCK_N):
+        cols = start_n + rn
+        w_ptrs = W + cols[None, :].to(tl.int64) * stride_wn
+        acc = tl.zeros((BLOCK_M, BLOCK_N), dtype=tl.float32)
+        for start_k in range(0, K, BLOCK_K):
+            ks = start_k + rk
+            x = tl.load(X + ks[None, :] * stride_xk, mask=(rm[:, None] < M) & (ks[None, :] < K), other=0.)
+            w = tl.load(w_ptrs + ks[:, None] * stride_wk, mask=(cols[None, :] < N) & (ks[:, None] < K), other=0.)
+            acc += tl.dot(x, w)
+        acc = tl.where(cols[None, :] < N, acc, float('-inf'))
+        m_new = tl.maximum(m_i, tl.max(acc, 1))
+        l_i = l_i * tl.exp(m_i - m_new) + tl.sum(tl.exp(acc - m_new[:, None]), 1)
+        m_i = m_new
+        target += tl.sum(tl.where(cols[None, :] == idx[:, None], acc, 0.), 1)
+    lse = m_i + tl.log(l_i)
+    tl.store(LSE + rm, lse, mask=rm < M)
+    tl.store(LOSS + rm, (lse - target).to(LOSS.dtype.element_ty), mask=rm < M)
+
+
 class _cross_entropy(torch.autograd.Function):
 
     @classmethod
@@ -69,8 +148,15 @@ class _cross_entropy(torch.autograd.Function):
         n_cols = logits.shape[-1]
         # run the kernel
         result = torch.empty_like(indices, dtype=dtype, device=device)
-        neg_logprobs = torch.empty_like(logits, dtype=dtype, device=device)
         grid = lambda opt: (logits.numel() // n_cols, )
+        ctx.chunked = next_power_of_2(n_cols) > MAX_FUSED_SIZE
+        if ctx.chunked:
+            # only the log-sum-exp of each row is kept for backward
+            lse = torch.empty(indices.shape, dtype=torch.float32, device=device)
+            _forward_chunked[grid](logits, lse, indices, result, n_cols, BLOCK=CHUNK_SIZE, num_warps=8)
+            ctx.save_for_backward(logits, lse, indices)
+            return result
+        neg_logprobs = torch.empty_like(logits, dtype=dtype, device=device)
         _forward[grid](logits, neg_logprobs, indices, result, n_cols)
         # save for backward
         ctx.save_for_backward(neg_logprobs, indices)
@@ -83,6 +169,14 @@ class _cross_entropy(torch.autograd.Function):
         to get p[k], which is most of what we need...  neg_logprobs will be
         modified in place to become the gradient we want
         """
+        if ctx.chunked:
+            logits, lse, indices = ctx.saved_tensors
+            dlogits = torch.empty_like(logits)
+            n_cols = logits.shape[-1]
+            grid = lambda opt: (logits.numel() // n_cols, )
+            _backward_chunked[grid](logits, lse, indices, dneg_logprobs.contiguous(), dlogits, n_cols, BLOCK=CHUNK_SIZE,
+                                    num_warps=8)
+            return dlogits, None
         # load saved tensors
         neg_logprobs, indices = ctx.saved_tensors
         # run the kernel
@@ -94,3 +188,58 @@ class _cross_entropy(torch.autograd.Function):
 
 
 cross_entropy = _cross_entropy.apply
+
+
+class _linear_cross_entropy(torch.autograd.Function):
+    """
+    Cross-entropy of the logits `x @ weight.T`, e.g. of the final projection
+    of a language model onto its vocabulary, without the logits of all the
+    rows in memory at once. The forward does not write them at all, and the
+    backward recomputes them a chunk of rows at a time.
+    """
+
+    @classmethod
+    def forward(cls, ctx, x, weight, indices):
+        assert (indices.dtype == torch.int64), "Indices are expected to be of type long."
+        assert x.shape[-1] == weight.shape[-1], "incompatible dimensions"
+        shape = x.shape[:-1]
+        x = x.reshape(-1, x.shape[-1])
+        indices = indices.reshape(-1).contiguous()
+        M, K = x.shape
+        N = weight.shape[0]
+        loss = torch.empty((M, ), dtype=x.dtype, device=x.device)
+        lse = torch.empty((M, ), dtype=torch.float32, device=x.device)
+        BLOCK_M, BLOCK_N, BLOCK_K = 64, 128, 32
+        _linear_forward[(cdiv(M, BLOCK_M), )](
+            x, weight, indices, lse, loss,  #
+            M, N, K,  #
+            x.stride(0), x.stride(1), weight.stride(0), weight.stride(1),  #
+            BLOCK_M=BLOCK_M, BLOCK_N=BLOCK_N, BLOCK_K=BLOCK_K,  #
+            num_warps=4, num_stages=3)
+        ctx.save_for_backward(x, weight, indices, lse)
+        ctx.shape = shape
+        return loss.view(shape)
+
+    @classmethod
+    def backward(cls, ctx, dloss):
+        x, weight, indices, lse = ctx.saved_tensors
+        dloss = dloss.reshape(-1).contiguous()
+        M, K = x.shape
+        N = weight.shape[0]
+        dx = torch.empty_like(x)
+        dw = torch.zeros(weight.shape, dtype=torch.float32, device=weight.device)
+        # chunks of logits about as large as x
+        chunk = next_power_of_2(cdiv(M, cdiv(N, K)))
+        for start in range(0, M, chunk):
+            end = min(start + chunk, M)
+            x_chunk = x[start:end]
+            # the gradient of the logits is computed in place
+            grad = torch.matmul(x_chunk, weight.t())
+            _backward_chunked[(end - start, )](grad, lse[start:], indices[start:], dloss[start:], grad, N,
+                                               BLOCK=CHUNK_SIZE, num_warps=8)
+            dx[start:end] = torch.matmul(grad, weight)
+            dw += torch.matmul(grad.t(), x_chunk).float()
+        return dx.view(*ctx.shape, K), dw.to(weight.dtype), None
+
+
+linear_cross_entropy = _linear_cross_entropy.apply
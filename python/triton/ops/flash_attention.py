@@ -10,7 +10,8 @@ Sequence Parallel implementation inspired by HazyResearch
 
 import torch
 
-from .. import cdiv, jit
+from .. import cdiv, jit, next_power_of_2
+from ..runtime import driver
 from .. import language as tl
 
 
@@ -109,6 +110,191 @@ def _fwd_kernel(Q, K, V, sm_scale,  #
     tl.store(O_block_ptr, acc.to(K.dtype.element_ty))
 
 
+@jit
+def _fwd_kernel_varlen(Q, K, V, sm_scale,  #
+                       Out,  #
+                       Cu_seqlens_q, Cu_seqlens_k,  #
+                       Block_table,  #
+                       stride_qt, stride_qh, stride_qk,  #
+                       stride_kb, stride_kt, stride_kh, stride_kk,  #
+                       stride_vb, stride_vt, stride_vh, stride_vk,  #
+                       stride_ot, stride_oh, stride_on,  #
+                       stride_block_table,  #
+                       H, KV_GROUPS,  #
+                       BLOCK_M: tl.constexpr, BLOCK_DMODEL: tl.constexpr,  #
+                       BLOCK_N: tl.constexpr,  #
+                       IS_CAUSAL: tl.constexpr,  #
+                       PAGED: tl.constexpr, PAGE_SIZE: tl.constexpr  #
+                       ):
+    # The sequences of the batch are packed along the tokens, the i-th one
+    # spanning the tokens [Cu_seqlens[i], Cu_seqlens[i + 1]). With PAGED, the
+    # keys and values of the i-th sequence are instead stored in pages of
+    # PAGE_SIZE tokens, the j-th one at index Block_table[i, j] of the cache.
+    start_m = tl.program_id(0)
+    off_bh = tl.program_id(1)
+    off_b = off_bh // H
+    off_h = off_bh % H
+    # grouped-query attention: KV_GROUPS heads of q share a head of k and v
+    off_kv_h = off_h // KV_GROUPS
+    q_start = tl.load(Cu_seqlens_q + off_b)
+    seqlen_q = tl.load(Cu_seqlens_q + off_b + 1) - q_start
+    k_start = tl.load(Cu_seqlens_k + off_b)
+    seqlen_k = tl.load(Cu_seqlens_k + off_b + 1) - k_start
+    # the grid covers the longest sequence
+    if start_m * BLOCK_M < seqlen_q:
+        offs_m = start_m * BLOCK_M + tl.arange(0, BLOCK_M)
+        offs_n = tl.arange(0, BLOCK_N)
+        offs_k = tl.arange(0, BLOCK_DMODEL)
+        m_i = tl.zeros([BLOCK_M], dtype=tl.float32) - float("inf")
+        l_i = tl.zeros([BLOCK_M], dtype=tl.float32)
+        acc = tl.zeros([BLOCK_M, BLOCK_DMODEL], dtype=tl.float32)
+        qk_scale = sm_scale * 1.44269504
+        Q_ptrs = Q + (q_start + offs_m[:, None]) * stride_qt + off_h * stride_qh + offs_k[None, :] * stride_qk
+        q = tl.load(Q_ptrs, mask=offs_m[:, None] < seqlen_q, other=0.0)
+        q = (q * qk_scale).to(K.dtype.element_ty)
+        K += off_kv_h * stride_kh
+        V += off_kv_h * stride_vh
+        # with causal masking, the last query of each sequence sees all of its
+        # keys, i.e. the queries are aligned to the end of the keys
+        causal_shift = seqlen_k - seqlen_q
+        if IS_CAUSAL:
+            hi = tl.minimum(seqlen_k, causal_shift + (start_m + 1) * BLOCK_M)
+        else:
+            hi = seqlen_k
+        for start_n in range(0, hi, BLOCK_N):
+            offs_t = start_n + offs_n
+            if PAGED:
+                # gather the tokens of the tile from their pages
+                page = tl.load(Block_table + off_b * stride_block_table + offs_t // PAGE_SIZE,
+                               mask=offs_t < seqlen_k, other=0)
+                page = page.to(tl.int64)
+                offs_kt = page * stride_kb + (offs_t % PAGE_SIZE) * stride_kt
+                offs_vt = page * stride_vb + (offs_t % PAGE_SIZE) * stride_vt
+            else:
+                offs_kt = (k_start + offs_t) * stride_kt
+                offs_vt = (k_start + offs_t) * stride_vt
+            # -- load k, v --
+            k = tl.load(K + offs_kt[None, :] + offs_k[:, None] * stride_kk, mask=offs_t[None, :] < seqlen_k,
+                        other=0.0)
+            v = tl.load(V + offs_vt[:, None] + offs_k[None, :] * stride_vk, mask=offs_t[:, None] < seqlen_k,
+                        other=0.0)
+            # -- compute qk ---
+            qk = tl.zeros([BLOCK_M, BLOCK_N], dtype=tl.float32)
+            qk += tl.dot(q, k, allow_tf32=True)
+            mask = offs_t[None, :] < seqlen_k
+            if IS_CAUSAL:
+                mask = mask & (offs_m[:, None] + causal_shift >= offs_t[None, :])
+            qk = tl.where(mask, qk, float("-inf"))
+            # -- compute scaling constant ---
+            m_i_new = tl.maximum(m_i, tl.max(qk, 1))
+            # rows that see no key yet stay at zero
+            m_i_safe = tl.where(m_i_new == float("-inf"), 0.0, m_i_new)
+            alpha = tl.math.exp2(m_i - m_i_safe)
+            p = tl.math.exp2(qk - m_i_safe[:, None])
+            # -- scale and update acc --
+            acc *= alpha[:, None]
+            acc += tl.dot(p.to(V.dtype.element_ty), v, allow_tf32=True)
+            # -- update m_i and l_i --
+            l_i = l_i * alpha + tl.sum(p, 1)
+            m_i = m_i_new
+        # rows that see no key at all are zero
+        l_i = tl.where(l_i == 0.0, 1.0, l_i)
+        acc = acc / l_i[:, None]
+        O_ptrs = Out + (q_start + offs_m[:, None]) * stride_ot + off_h * stride_oh + offs_k[None, :] * stride_on
+        tl.store(O_ptrs, acc.to(Out.dtype.element_ty), mask=offs_m[:, None] < seqlen_q)
+
+
+@jit
+def _fwd_kernel_decode(Q, K, V, sm_scale,  #
+                       Out_partial, Lse_partial,  #
+                       Cu_seqlens_k,  #
+                       Block_table,  #
+                       stride_qb, stride_qh, stride_qk,  #
+                       stride_kb, stride_kt, stride_kh, stride_kk,  #
+                       stride_vb, stride_vt, stride_vh, stride_vk,  #
+                       stride_block_table,  #
+                       H, KV_GROUPS, SPLIT_LEN, NUM_SPLITS,  #
+                       BLOCK_DMODEL: tl.constexpr,  #
+                       BLOCK_N: tl.constexpr,  #
+                       PAGED: tl.constexpr, PAGE_SIZE: tl.constexpr  #
+                       ):
+    # Attention of the single query of each sequence over the split-th chunk
+    # of SPLIT_LEN of its keys, laid out as in `_fwd_kernel_varlen`. Writes the
+    # output normalized over the chunk and the log2 of its softmax
+    # denominator, which `_decode_reduce_kernel` combines across the chunks.
+    split = tl.program_id(0)
+    off_bh = tl.program_id(1)
+    off_b = off_bh // H
+    off_h = off_bh % H
+    off_kv_h = off_h // KV_GROUPS
+    k_start = tl.load(Cu_seqlens_k + off_b)
+    seqlen_k = tl.load(Cu_seqlens_k + off_b + 1) - k_start
+    lo = split * SPLIT_LEN
+    hi = tl.minimum(seqlen_k, lo + SPLIT_LEN)
+    offs_n = tl.arange(0, BLOCK_N)
+    offs_k = tl.arange(0, BLOCK_DMODEL)
+    qk_scale = sm_scale * 1.44269504
+    q = tl.load(Q + off_b * stride_qb + off_h * stride_qh + offs_k * stride_qk).to(tl.float32) * qk_scale
+    K += off_kv_h * stride_kh
+    V += off_kv_h * stride_vh
+    m_i = float("-inf")
+    l_i = 0.0
+    acc = tl.zeros([BLOCK_DMODEL], dtype=tl.float32)
+    for start_n in range(lo, hi, BLOCK_N):
+        offs_t = start_n + offs_n
+        mask = offs_t < hi
+        if PAGED:
+            page = tl.load(Block_table + off_b * stride_block_table + offs_t // PAGE_SIZE, mask=mask, other=0)
+            page = page.to(tl.int64)
+            offs_kt = page * stride_kb + (offs_t % PAGE_SIZE) * stride_kt
+            offs_vt = page * stride_vb + (offs_t % PAGE_SIZE) * stride_vt
+        else:
+            offs_kt = (k_start + offs_t) * stride_kt
+            offs_vt = (k_start + offs_t) * stride_vt
+        k = tl.load(K + offs_kt[:, None] + offs_k[None, :] * stride_kk, mask=mask[:, None], other=0.0)
+        v = tl.load(V + offs_vt[:, None] + offs_k[None, :] * stride_vk, mask=mask[:, None], other=0.0)
+        # a single row does not fill an MMA, so the products are reductions
+        qk = tl.sum(q[None, :] * k.to(tl.float32), 1)
+        qk = tl.where(mask, qk, float("-inf"))
+        # every tile has a key, so the maximum is finite
+        m_i_new = tl.maximum(m_i, tl.max(qk, 0))
+        alpha = tl.math.exp2(m_i - m_i_new)
+        p = tl.math.exp2(qk - m_i_new)
+        acc = acc * alpha + tl.sum(p[:, None] * v.to(tl.float32), 0)
+        l_i = l_i * alpha + tl.sum(p, 0)
+        m_i = m_i_new
+    # the chunks past the end of the sequence have no weight
+    off_partial = off_bh * NUM_SPLITS + split
+    tl.store(Out_partial + off_partial * BLOCK_DMODEL + offs_k, acc / tl.where(l_i == 0.0, 1.0, l_i))
+    tl.store(Lse_partial + off_partial, m_i + tl.math.log2(l_i))
+
+
+@jit
+def _decode_reduce_kernel(Out_partial, Lse_partial,  #
+                          Out,  #
+                          stride_ob, stride_oh, stride_ok,  #
+                          H, NUM_SPLITS,  #
+                          BLOCK_DMODEL: tl.constexpr,  #
+                          BLOCK_SPLITS: tl.constexpr  #
+                          ):
+    # Combines the outputs of the chunks of keys of each (sequence, head),
+    # weighted by their softmax denominators.
+    off_bh = tl.program_id(0)
+    offs_s = tl.arange(0, BLOCK_SPLITS)
+    offs_k = tl.arange(0, BLOCK_DMODEL)
+    mask = offs_s < NUM_SPLITS
+    lse = tl.load(Lse_partial + off_bh * NUM_SPLITS + offs_s, mask=mask, other=float("-inf"))
+    lse_max = tl.max(lse, 0)
+    weight = tl.math.exp2(lse - tl.where(lse_max == float("-inf"), 0.0, lse_max))
+    o = tl.load(Out_partial + (off_bh * NUM_SPLITS + offs_s)[:, None] * BLOCK_DMODEL + offs_k[None, :],
+                mask=mask[:, None], other=0.0)
+    denom = tl.sum(weight, 0)
+    out = tl.sum(weight[:, None] * o, 0) / tl.where(denom == 0.0, 1.0, denom)
+    off_b = off_bh // H
+    off_h = off_bh % H
+    tl.store(Out + off_b * stride_ob + off_h * stride_oh + offs_k * stride_ok, out.to(Out.dtype.element_ty))
+
+
 @jit
 def _bwd_preprocess(
     Out,
@@ -454,3 +640,153 @@ class _attention(torch.autograd.Function):
 
 
 attention = _attention.apply
+
+
+def _cu_seqlens(seqlens):
+    cu_seqlens = torch.zeros(seqlens.numel() + 1, device=seqlens.device, dtype=torch.int32)
+    torch.cumsum(seqlens, dim=0, out=cu_seqlens[1:])
+    return cu_seqlens
+
+
+def _varlen_forward(q, k, v, cu_seqlens_q, cu_seqlens_k, max_seqlen_q, causal, sm_scale, block_table=None):
+    capability = torch.cuda.get_device_capability()
+    if capability[0] < 8:
+        raise RuntimeError("Flash attention currently only supported for compute capability >= 80")
+    BLOCK_M = 64
+    BLOCK_N = 64
+    Lq, Lk, Lv = q.shape[-1], k.shape[-1], v.shape[-1]
+    assert Lq == Lk and Lk == Lv
+    assert Lk in {16, 32, 64, 128}
+    H, H_kv = q.shape[1], k.shape[-2]
+    assert H % H_kv == 0, "the number of heads of q must be a multiple of the one of k and v"
+    batch = cu_seqlens_q.numel() - 1
+    o = torch.empty_like(q)
+    paged = block_table is not None
+    if paged:
+        # [num_pages, page_size, H_kv, D]
+        page_size = k.shape[1]
+        stride_kb, stride_vb = k.stride(0), v.stride(0)
+        k_strides, v_strides = k.stride()[1:], v.stride()[1:]
+        block_table_stride = block_table.stride(0)
+    else:
+        # [total_k, H_kv, D]
+        page_size = 1
+        stride_kb, stride_vb = 0, 0
+        k_strides, v_strides = k.stride(), v.stride()
+        block_table, block_table_stride = cu_seqlens_k, 0
+    grid = (cdiv(max_seqlen_q, BLOCK_M), batch * H, 1)
+    num_warps = 4 if Lk <= 64 else 8
+    _fwd_kernel_varlen[grid](
+        q, k, v, sm_scale,  #
+        o,  #
+        cu_seqlens_q, cu_seqlens_k,  #
+        block_table,  #
+        q.stride(0), q.stride(1), q.stride(2),  #
+        stride_kb, *k_strides,  #
+        stride_vb, *v_strides,  #
+        o.stride(0), o.stride(1), o.stride(2),  #
+        block_table_stride,  #
+        H, H // H_kv,  #
+        BLOCK_M=BLOCK_M, BLOCK_N=BLOCK_N, BLOCK_DMODEL=Lk,  #
+        IS_CAUSAL=causal,  #
+        PAGED=paged, PAGE_SIZE=page_size,  #
+        num_warps=num_warps,  #
+        num_stages=3  #
+    )
+    return o
+
+
+def attention_varlen(q, k, v, cu_seqlens_q, cu_seqlens_k, max_seqlen_q, causal, sm_scale):
+    """
+    Forward attention over a batch of sequences of different lengths packed
+    along the tokens, without padding. `q` is [total_q, H, D] and `k` and `v`
+    are [total_k, H_kv, D], the i-th sequence spanning the tokens
+    [cu_seqlens[i], cu_seqlens[i + 1]). `cu_seqlens_q` and `cu_seqlens_k` are
+    int32 tensors of batch + 1 elements and `max_seqlen_q` is the length of
+    the longest query sequence. With `causal`, the queries are aligned to the
+    end of their keys. Each head of k and v is shared by H // H_kv heads of q.
+    """
+    return _varlen_forward(q, k, v, cu_seqlens_q, cu_seqlens_k, max_seqlen_q, causal, sm_scale)
+
+
+def paged_attention(q, k_cache, v_cache, cu_seqlens_q, seqlens_k, block_table, max_seqlen_q, causal, sm_scale):
+    """
+    Same as `attention_varlen`, for keys and values stored in a paged cache:
+    `k_cache` and `v_cache` are [num_pages, page_size, H_kv, D], and the
+    `seqlens_k[i]` keys and values of the i-th sequence are stored in the pages
+    `block_table[i, :cdiv(seqlens_k[i], page_size)]` of the int32 block table.
+    The kernel gathers the tokens of each tile of keys from their pages.
+    """
+    return _varlen_forward(q, k_cache, v_cache, cu_seqlens_q, _cu_seqlens(seqlens_k), max_seqlen_q, causal, sm_scale,
+                           block_table=block_table)
+
+
+def attention_decode(q, k, v, seqlens_k, max_seqlen_k, sm_scale, block_table=None, num_splits=None):
+    """
+    Forward attention of a single query per sequence, as when decoding, over
+    keys and values laid out as for `attention_varlen` or, with a
+    `block_table`, as for `paged_attention`. `q` is [batch, H, D]. The keys of
+    each sequence are split into `num_splits` chunks attended by programs of
+    their own, so that small batches with long contexts fill the GPU, and a
+    second kernel combines the partial results. By default, there are enough
+    chunks for two programs per SM.
+    """
+    capability = torch.cuda.get_device_capability()
+    if capability[0] < 8:
+        raise RuntimeError("Flash attention currently only supported for compute capability >= 80")
+    BLOCK_N = 64
+    Lq, Lk, Lv = q.shape[-1], k.shape[-1], v.shape[-1]
+    assert Lq == Lk and Lk == Lv
+    assert Lk in {16, 32, 64, 128}
+    batch, H = q.shape[0], q.shape[1]
+    H_kv = k.shape[-2]
+    assert H % H_kv == 0, "the number of heads of q must be a multiple of the one of k and v"
+    max_blocks = max(cdiv(max_seqlen_k, BLOCK_N), 1)
+    if num_splits is None:
+        num_sms = driver.utils.get_device_properties(q.device.index)["multiprocessor_count"]
+        num_splits = min(max_blocks, max(1, cdiv(2 * num_sms, batch * H)))
+    # whole tiles of keys per chunk
+    split_len = cdiv(max_blocks, num_splits) * BLOCK_N
+    num_splits = max(cdiv(max_seqlen_k, split_len), 1)
+    paged = block_table is not None
+    if paged:
+        page_size = k.shape[1]
+        stride_kb, stride_vb = k.stride(0), v.stride(0)
+        k_strides, v_strides = k.stride()[1:], v.stride()[1:]
+        block_table_stride = block_table.stride(0)
+    else:
+        page_size = 1
+        stride_kb, stride_vb = 0, 0
+        k_strides, v_strides = k.stride(), v.stride()
+    cu_seqlens_k = _cu_seqlens(seqlens_k)
+    if not paged:
+        block_table, block_table_stride = cu_seqlens_k, 0
+    o_partial = torch.empty((batch * H, num_splits, Lk), device=q.device, dtype=torch.float32)
+    lse_partial = torch.empty((batch * H, num_splits), device=q.device, dtype=torch.float32)
+    num_warps = 4 if Lk <= 64 else 8
+    _fwd_kernel_decode[(num_splits, batch * H, 1)](
+        q, k, v, sm_scale,  #
+        o_partial, lse_partial,  #
+        cu_seqlens_k,  #
+        block_table,  #
+        q.stride(0), q.stride(1), q.stride(2),  #
+        stride_kb, *k_strides,  #
+        stride_vb, *v_strides,  #
+        block_table_stride,  #
+        H, H // H_kv, split_len, num_splits,  #
+        BLOCK_N=BLOCK_N, BLOCK_DMODEL=Lk,  #
+        PAGED=paged, PAGE_SIZE=page_size,  #
+        num_warps=num_warps,  #
+        num_stages=3  #
+    )
+    o = torch.empty_like(q)
+    _decode_reduce_kernel[(batch * H, )](
+        o_partial, lse_partial,  #
+        o,  #
+        o.stride(0), o.stride(1), o.stride(2),  #
+        H, num_splits,  #
+        BLOCK_DMODEL=Lk,  #
+        BLOCK_SPLITS=next_power_of_2(num_splits),  #
+        num_warps=4  #
+    )
+    return o
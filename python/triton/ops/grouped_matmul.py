@@ -0,0 +1,106 @@
+import torch
+
+from .. import cdiv, jit, next_power_of_2
+from .. import language as tl
+from .matmul_perf_model import get_num_sms
+
+
+@jit
+def _grouped_kernel(A, B, C, Offsets,  #
+                    T, G, N, K,  #
+                    stride_am, stride_ak,  #
+                    stride_bg, stride_bk, stride_bn,  #
+                    stride_cm, stride_cn,  #
+                    BLOCK_M: tl.constexpr, BLOCK_N: tl.constexpr, BLOCK_K: tl.constexpr,  #
+                    BLOCK_PTR: tl.constexpr  #
+                    ):
+    # The programs take the tiles of all the problems in turn, one every
+    # num_programs, walking the problems in order. The rows of A of each
+    # problem, and hence its number of tiles, are read from Offsets.
+    tile_idx = tl.program_id(0)
+    num_programs = tl.num_programs(0)
+    num_n_tiles = tl.cdiv(N, BLOCK_N)
+    last_problem_end = 0
+    for g in range(G):
+        m_start = tl.load(Offsets + g).to(tl.int32)
+        m_end = tl.load(Offsets + g + 1).to(tl.int32)
+        num_tiles = tl.cdiv(m_end - m_start, BLOCK_M) * num_n_tiles
+        while (tile_idx >= last_problem_end and tile_idx < last_problem_end + num_tiles):
+            tile = tile_idx - last_problem_end
+            tile_m = tile // num_n_tiles
+            tile_n = tile % num_n_tiles
+            rm = m_start + tile_m * BLOCK_M + tl.arange(0, BLOCK_M)
+            rn = tile_n * BLOCK_N + tl.arange(0, BLOCK_N)
+            acc = tl.zeros((BLOCK_M, BLOCK_N), dtype=tl.float32)
+            if BLOCK_PTR:
+                # A and B are contiguous and K is a multiple of BLOCK_K, so the
+                # tiles are those of the whole tensors, which the Hopper
+                # pipeline loads with TMA. The rows of A past m_end are those
+                # of the next problems, and are not stored.
+                a_ptr = tl.make_block_ptr(A, shape=(T, K), strides=(stride_am, stride_ak),
+                                          offsets=(m_start + tile_m * BLOCK_M, 0), block_shape=(BLOCK_M, BLOCK_K),
+                                          order=(1, 0))
+                b_ptr = tl.make_block_ptr(B, shape=(G * K, N), strides=(stride_bk, stride_bn),
+                                          offsets=(g * K, tile_n * BLOCK_N), block_shape=(BLOCK_K, BLOCK_N),
+                                          order=(1, 0))
+                for k in range(0, K, BLOCK_K):
+                    a = tl.load(a_ptr, boundary_check=(0, 1))
+                    b = tl.load(b_ptr, boundary_check=(0, 1))
+                    acc += tl.dot(a, b)
+                    a_ptr = tl.advance(a_ptr, (0, BLOCK_K))
+                    b_ptr = tl.advance(b_ptr, (BLOCK_K, 0))
+            else:
+                rk = tl.arange(0, BLOCK_K)
+                a_ptrs = A + rm[:, None] * stride_am + rk[None, :] * stride_ak
+                b_ptrs = B + g.to(tl.int64) * stride_bg + rk[:, None] * stride_bk + rn[None, :] * stride_bn
+                for k in range(0, K, BLOCK_K):
+                    a = tl.load(a_ptrs, mask=(rm[:, None] < m_end) & (rk[None, :] < K - k), other=0.)
+                    b = tl.load(b_ptrs, mask=(rk[:, None] < K - k) & (rn[None, :] < N), other=0.)
+                    acc += tl.dot(a, b)
+                    a_ptrs += BLOCK_K * stride_ak
+                    b_ptrs += BLOCK_K * stride_bk
+            c = acc.to(C.dtype.element_ty)
+            c_ptrs = C + rm[:, None] * stride_cm + rn[None, :] * stride_cn
+            tl.store(c_ptrs, c, mask=(rm[:, None] < m_end) & (rn[None, :] < N))
+            tile_idx += num_programs
+        last_problem_end = last_problem_end + num_tiles
+
+
+def grouped_matmul(a, b, offsets, out=None):
+    """
+    Computes the G products of the ragged groups of rows of `a` [T, K] with
+    the matrices of `b` [G, K, N], as for the experts of a mixture of experts.
+    The rows of group g are `offsets[g]:offsets[g + 1]`, with `offsets` a
+    device tensor of G + 1 integers which is never read on the host, so that
+    the sizes of the groups can be computed on the device without a sync.
+    Returns the [T, N] tensor of the products.
+    """
+    assert a.dim() == 2 and b.dim() == 3, "expected a [T, K] and b [G, K, N]"
+    assert a.shape[1] == b.shape[1], "incompatible dimensions"
+    assert offsets.shape == (b.shape[0] + 1, ), "expected G + 1 offsets"
+    assert a.dtype == b.dtype, "incompatible dtypes"
+    T, K = a.shape
+    G, _, N = b.shape
+    if out is None:
+        out = torch.empty((T, N), device=a.device, dtype=a.dtype)
+    else:
+        assert out.shape == (T, N)
+    # tiles of about the average number of rows of a group
+    BLOCK_M = max(16, min(128, next_power_of_2(cdiv(T, max(G, 1)))))
+    BLOCK_N = 128 if N >= 128 else 64
+    BLOCK_K = 64 if a.element_size() <= 2 else 32
+    block_ptr = (torch.version.hip is None and torch.cuda.get_device_capability(a.device)[0] >= 9
+                 and a.is_contiguous() and b.is_contiguous() and K % BLOCK_K == 0)
+    # persistent: one program per SM, which walk the problems on the device
+    grid = (get_num_sms(a.device.index), )
+    _grouped_kernel[grid](
+        a, b, out, offsets,  #
+        T, G, N, K,  #
+        a.stride(0), a.stride(1),  #
+        b.stride(0), b.stride(1), b.stride(2),  #
+        out.stride(0), out.stride(1),  #
+        BLOCK_M=BLOCK_M, BLOCK_N=BLOCK_N, BLOCK_K=BLOCK_K,  #
+        BLOCK_PTR=block_ptr,  #
+        num_warps=4 if BLOCK_M * BLOCK_N <= 8192 else 8, num_stages=3  #
+    )
+    return out
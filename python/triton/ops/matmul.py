@@ -2,7 +2,7 @@ import torch
 
 from .. import Config, autotune, cdiv, heuristics, jit
 from .. import language as tl
-from .matmul_perf_model import early_config_prune, estimate_matmul_time
+from .matmul_perf_model import early_config_prune, estimate_matmul_time, get_num_sms, get_stream_k_tiles
 
 _ordered_datatypes = [torch.int8, torch.float16, torch.bfloat16, torch.float32]
 
@@ -51,8 +51,18 @@ def get_configs_io_bound():
     return configs
 
 
-@autotune(
-    configs=[
+def get_configs_stream_k(configs):
+    # the stream-k variants of the data-parallel configs: the tiles left over
+    # by the last full wave are shared among one program per SM, which
+    # accumulate their partial tiles into the zeroed output
+    return [
+        Config({**config.kwargs, 'STREAM_K': True}, num_stages=config.num_stages, num_warps=config.num_warps,
+               pre_hook=init_to_zero('C')) for config in configs if config.kwargs['SPLIT_K'] == 1
+    ]
+
+
+def get_configs_compute_bound():
+    return [
         # basic configs for compute-bound matmuls
         Config({'BLOCK_M': 128, 'BLOCK_N': 256, 'BLOCK_K': 32, 'SPLIT_K': 1}, num_stages=3, num_warps=8),
         Config({'BLOCK_M': 256, 'BLOCK_N': 128, 'BLOCK_K': 32, 'SPLIT_K': 1}, num_stages=3, num_warps=8),
@@ -73,50 +83,43 @@ def get_configs_io_bound():
         Config({'BLOCK_M': 64, 'BLOCK_N': 128, 'BLOCK_K': 64, 'SPLIT_K': 1}, num_stages=4, num_warps=4),
         Config({'BLOCK_M': 128, 'BLOCK_N': 32, 'BLOCK_K': 64, 'SPLIT_K': 1}, num_stages=4, num_warps=4),
         Config({'BLOCK_M': 64, 'BLOCK_N': 32, 'BLOCK_K': 64, 'SPLIT_K': 1}, num_stages=5, num_warps=2),
-    ] + get_configs_io_bound(),
-    key=['M', 'N', 'K'],
-    prune_configs_by={
-        'early_config_prune': early_config_prune,
-        'perf_model': estimate_matmul_time,
-        'top_k': 10,
-    },
-)
-@heuristics({
-    'EVEN_K': lambda args: args['K'] % (args['BLOCK_K'] * args['SPLIT_K']) == 0,
-})
+    ]
+
+
 @jit
-def _kernel(A, B, C, M, N, K,  #
-            stride_am, stride_ak,  #
-            stride_bk, stride_bn,  #
-            stride_cm, stride_cn,  #
-            acc_dtype: tl.constexpr,  #
-            allow_tf32: tl.constexpr,  #
-            fp8_fast_accum: tl.constexpr,  #
-            BLOCK_M: tl.constexpr, BLOCK_N: tl.constexpr, BLOCK_K: tl.constexpr,  #
-            GROUP_M: tl.constexpr, SPLIT_K: tl.constexpr, EVEN_K: tl.constexpr, AB_DTYPE: tl.constexpr  #
-            ):
-    # matrix multiplication
-    pid = tl.program_id(0)
-    pid_z = tl.program_id(1)
-    grid_m = tl.cdiv(M, BLOCK_M)
-    grid_n = tl.cdiv(N, BLOCK_N)
+def _tile_ids(tile, grid_m, grid_n, GROUP_M: tl.constexpr):
     # re-order program ID for better L2 performance
     width = GROUP_M * grid_n
-    group_id = pid // width
+    group_id = tile // width
     group_size = min(grid_m - group_id * GROUP_M, GROUP_M)
-    pid_m = group_id * GROUP_M + (pid % group_size)
-    pid_n = (pid % width) // (group_size)
-    # do matrix multiplication
+    pid_m = group_id * GROUP_M + (tile % group_size)
+    pid_n = (tile % width) // (group_size)
+    return pid_m, pid_n
+
+
+@jit
+def _accumulate(A, B, C, M, N, K,  #
+                stride_am, stride_ak,  #
+                stride_bk, stride_bn,  #
+                pid_m, pid_n, pid_z, k_start, k_end,  #
+                acc_dtype: tl.constexpr,  #
+                allow_tf32: tl.constexpr,  #
+                fp8_fast_accum: tl.constexpr,  #
+                BLOCK_M: tl.constexpr, BLOCK_N: tl.constexpr, BLOCK_K: tl.constexpr,  #
+                SPLIT_K: tl.constexpr, EVEN_K: tl.constexpr, AB_DTYPE: tl.constexpr  #
+                ):
+    # the product of the tile over the iterations [k_start, k_end) of the
+    # reduction loop
     rm = pid_m * BLOCK_M + tl.arange(0, BLOCK_M)
     rn = pid_n * BLOCK_N + tl.arange(0, BLOCK_N)
     ram = tl.max_contiguous(tl.multiple_of(rm % M, BLOCK_M), BLOCK_M)
     rbn = tl.max_contiguous(tl.multiple_of(rn % N, BLOCK_N), BLOCK_N)
     rk = pid_z * BLOCK_K + tl.arange(0, BLOCK_K)
     # pointers
-    A = A + (ram[:, None] * stride_am + rk[None, :] * stride_ak)
-    B = B + (rk[:, None] * stride_bk + rbn[None, :] * stride_bn)
+    A = A + (ram[:, None] * stride_am + (rk[None, :] + k_start * BLOCK_K * SPLIT_K) * stride_ak)
+    B = B + ((rk[:, None] + k_start * BLOCK_K * SPLIT_K) * stride_bk + rbn[None, :] * stride_bn)
     acc = tl.zeros((BLOCK_M, BLOCK_N), dtype=acc_dtype)
-    for k in range(0, tl.cdiv(K, BLOCK_K * SPLIT_K)):
+    for k in range(k_start, k_end):
         if EVEN_K:
             a = tl.load(A)
             b = tl.load(B)
@@ -134,6 +137,12 @@ def _kernel(A, B, C, M, N, K,  #
             acc += tl.dot(a, b, out_dtype=acc_dtype, allow_tf32=allow_tf32)
         A += BLOCK_K * SPLIT_K * stride_ak
         B += BLOCK_K * SPLIT_K * stride_bk
+    return acc
+
+
+@jit
+def _store(C, acc, M, N, stride_cm, stride_cn, pid_m, pid_n,  #
+           BLOCK_M: tl.constexpr, BLOCK_N: tl.constexpr, ATOMIC: tl.constexpr):
     acc = acc.to(C.dtype.element_ty)
     # rematerialize rm and rn to save registers
     rm = pid_m * BLOCK_M + tl.arange(0, BLOCK_M)
@@ -141,10 +150,82 @@ def _kernel(A, B, C, M, N, K,  #
     C = C + (rm[:, None] * stride_cm + rn[None, :] * stride_cn)
     mask = (rm < M)[:, None] & (rn < N)[None, :]
     # handles write-back with reduction-splitting
-    if SPLIT_K == 1:
+    if ATOMIC:
+        tl.atomic_add(C, acc, mask=mask)
+    else:
         tl.store(C, acc, mask=mask)
+
+
+@autotune(
+    configs=get_configs_compute_bound() + get_configs_stream_k(get_configs_compute_bound()) + get_configs_io_bound(),
+    key=['M', 'N', 'K'],
+    prune_configs_by={
+        'early_config_prune': early_config_prune,
+        'perf_model': estimate_matmul_time,
+        'top_k': 10,
+    },
+)
+@heuristics({
+    'EVEN_K': lambda args: args['K'] % (args['BLOCK_K'] * args['SPLIT_K']) == 0,
+})
+@jit
+def _kernel(A, B, C, M, N, K,  #
+            stride_am, stride_ak,  #
+            stride_bk, stride_bn,  #
+            stride_cm, stride_cn,  #
+            num_sms,  #
+            acc_dtype: tl.constexpr,  #
+            allow_tf32: tl.constexpr,  #
+            fp8_fast_accum: tl.constexpr,  #
+            BLOCK_M: tl.constexpr, BLOCK_N: tl.constexpr, BLOCK_K: tl.constexpr,  #
+            GROUP_M: tl.constexpr, SPLIT_K: tl.constexpr, EVEN_K: tl.constexpr, AB_DTYPE: tl.constexpr,  #
+            STREAM_K: tl.constexpr = False  #
+            ):
+    # matrix multiplication
+    pid = tl.program_id(0)
+    pid_z = tl.program_id(1)
+    grid_m = tl.cdiv(M, BLOCK_M)
+    grid_n = tl.cdiv(N, BLOCK_N)
+    num_iters = tl.cdiv(K, BLOCK_K * SPLIT_K)
+    if not STREAM_K:
+        pid_m, pid_n = _tile_ids(pid, grid_m, grid_n, GROUP_M)
+        acc = _accumulate(A, B, C, M, N, K, stride_am, stride_ak, stride_bk, stride_bn, pid_m, pid_n, pid_z, 0,
+                          num_iters, acc_dtype, allow_tf32, fp8_fast_accum, BLOCK_M, BLOCK_N, BLOCK_K, SPLIT_K, EVEN_K,
+                          AB_DTYPE)
+        _store(C, acc, M, N, stride_cm, stride_cn, pid_m, pid_n, BLOCK_M, BLOCK_N, SPLIT_K > 1)
     else:
-        tl.atomic_add(C, acc, mask=mask)
+        tl.static_assert(SPLIT_K == 1, "stream-k does not split the reduction loop")
+        # the first `num_sk_tiles` tiles are shared among the last `num_sms`
+        # programs, each running the same number of iterations of their
+        # reduction loops, and the other tiles are computed whole by one
+        # program each, see `get_stream_k_tiles`
+        num_tiles = grid_m * grid_n
+        num_sk_tiles = num_tiles % num_sms
+        if num_tiles < num_sms:
+            num_sk_tiles = num_tiles
+        num_dp_tiles = num_tiles - num_sk_tiles
+        if pid < num_dp_tiles:
+            pid_m, pid_n = _tile_ids(num_sk_tiles + pid, grid_m, grid_n, GROUP_M)
+            acc = _accumulate(A, B, C, M, N, K, stride_am, stride_ak, stride_bk, stride_bn, pid_m, pid_n, 0, 0,
+                              num_iters, acc_dtype, allow_tf32, fp8_fast_accum, BLOCK_M, BLOCK_N, BLOCK_K, 1, EVEN_K,
+                              AB_DTYPE)
+            _store(C, acc, M, N, stride_cm, stride_cn, pid_m, pid_n, BLOCK_M, BLOCK_N, False)
+        else:
+            sk_pid = pid - num_dp_tiles
+            num_sk_iters = num_sk_tiles * num_iters
+            start = sk_pid * num_sk_iters // num_sms
+            end = (sk_pid + 1) * num_sk_iters // num_sms
+            while start < end:
+                tile = start // num_iters
+                k_start = start - tile * num_iters
+                k_end = min(num_iters, k_start + end - start)
+                pid_m, pid_n = _tile_ids(tile, grid_m, grid_n, GROUP_M)
+                acc = _accumulate(A, B, C, M, N, K, stride_am, stride_ak, stride_bk, stride_bn, pid_m, pid_n, 0,
+                                  k_start, k_end, acc_dtype, allow_tf32, fp8_fast_accum, BLOCK_M, BLOCK_N, BLOCK_K, 1,
+                                  EVEN_K, AB_DTYPE)
+                # the partial tiles of a tile add up in the zeroed output
+                _store(C, acc, M, N, stride_cm, stride_cn, pid_m, pid_n, BLOCK_M, BLOCK_N, True)
+                start += k_end - k_start
 
 
 class _matmul(torch.autograd.Function):
@@ -198,12 +279,23 @@ class _matmul(torch.autograd.Function):
         if a.dtype in [tl.float8e4nv, tl.float8e5] and b.dtype in [tl.float8e4nv, tl.float8e5]:
             ab_dtype = None
         # launch kernel
-        grid = lambda META: (cdiv(M, META['BLOCK_M']) * cdiv(N, META['BLOCK_N']), META['SPLIT_K'])
+        num_sms = get_num_sms(device.index if device.index is not None else torch.cuda.current_device())
+
+        def grid(META):
+            num_tiles = cdiv(M, META['BLOCK_M']) * cdiv(N, META['BLOCK_N'])
+            if META.get('STREAM_K', False):
+                # one program per data-parallel tile, and one per SM for the
+                # stream-k tiles if there are any
+                num_sk_tiles = get_stream_k_tiles(num_tiles, num_sms)
+                return (num_tiles - num_sk_tiles + (num_sms if num_sk_tiles else 0), 1)
+            return (num_tiles, META['SPLIT_K'])
+
         _kernel[grid](
             a, b, c, M, N, K,  #
             a.stride(0), a.stride(1),  #
             b.stride(0), b.stride(1),  #
             c.stride(0), c.stride(1),  #
+            num_sms,  #
             acc_dtype=acc_dtype,  #
             allow_tf32=allow_tf32,  #
             fp8_fast_accum=fp8_fast_accum,  #
@@ -1,3 +1,4 @@
+import functools
 import heapq
 
 import torch
@@ -7,6 +8,20 @@ from ..runtime import driver
 from ..testing import (get_dram_gbps, get_max_simd_tflops, get_max_tensorcore_tflops, nvsmi)
 
 
+@functools.lru_cache
+def get_num_sms(device):
+    return driver.utils.get_device_properties(device)["multiprocessor_count"]
+
+
+def get_stream_k_tiles(num_tiles, num_sms):
+    ''' return the number of tiles a stream-k matmul shares among its SMs: those
+        left over by the last full wave, or all of them if there are fewer than
+        SMs '''
+    if num_tiles < num_sms:
+        return num_tiles
+    return num_tiles % num_sms
+
+
 def get_tensorcore_tflops(device, num_ctas, num_warps, dtype):
     ''' return compute throughput in TOPS '''
     total_warps = num_ctas * min(num_warps, 4)
@@ -38,7 +53,7 @@ def estimate_matmul_time(
         A, B, C,  #
         M, N, K,  #
         BLOCK_M, BLOCK_N, BLOCK_K, SPLIT_K,  #
-        debug=False, **kwargs  #
+        STREAM_K=False, debug=False, **kwargs  #
 ):
     ''' return estimated running time in ms
           = max(compute, loading) + store '''
@@ -50,6 +65,10 @@ def estimate_matmul_time(
     num_cta_n = cdiv(N, BLOCK_N)
     num_cta_k = SPLIT_K
     num_ctas = num_cta_m * num_cta_n * num_cta_k
+    num_sm = get_num_sms(device)
+    num_sk_tiles = get_stream_k_tiles(num_cta_m * num_cta_n, num_sm) if STREAM_K else 0
+    if num_sk_tiles:
+        num_ctas = num_cta_m * num_cta_n - num_sk_tiles + num_sm
 
     # If the input is smaller than the block size
     M, N = max(M, BLOCK_M), max(N, BLOCK_N)
@@ -58,9 +77,12 @@ def estimate_matmul_time(
     total_ops = 2 * M * N * K / (1024 * 1024 * 1024)  # GOPS
     tput = get_tflops(device, num_ctas, num_warps, dtype)
     compute_ms = total_ops / tput
+    # the last wave of tiles leaves SMs idle, unless stream-k shares it among
+    # all of them
+    if num_ctas > num_sm and not num_sk_tiles:
+        compute_ms *= cdiv(num_ctas, num_sm) * num_sm / num_ctas
 
     # time to load data
-    num_sm = driver.utils.get_device_properties(device)["multiprocessor_count"]
     active_cta_ratio = min(1, num_ctas / num_sm)
     active_cta_ratio_bw1 = min(1, num_ctas / 32)  # 32 active ctas are enough to saturate
     active_cta_ratio_bw2 = max(min(1, (num_ctas - 32) / (108 - 32)), 0)  # 32-108, remaining 5%
@@ -80,8 +102,15 @@ def estimate_matmul_time(
     # estimate storing time
     store_bw = dram_bw * 0.6  # :o
     store_c_dram = M * N * dtsize * SPLIT_K / (1024 * 1024)  # MB
-    if SPLIT_K == 1:
+    if SPLIT_K == 1 and not num_sk_tiles:
+        store_ms = store_c_dram / store_bw
+    elif num_sk_tiles:
+        # the stream-k programs add up to `num_sm - 1` more partial tiles to
+        # the zeroed output than there are tiles
+        store_c_dram += (num_sm - 1) * BLOCK_M * BLOCK_N * dtsize / (1024 * 1024)
         store_ms = store_c_dram / store_bw
+        zero_ms = M * N * 2 / (1024 * 1024) / store_bw
+        store_ms += zero_ms
     else:
         reduce_bw = store_bw
         store_ms = store_c_dram / reduce_bw
@@ -119,16 +148,34 @@ def early_config_prune(configs, named_args):
 
     # Some dtypes do not allow atomic_add
     if dtype not in [torch.float16, torch.float32]:
-        configs = [config for config in configs if config.kwargs['SPLIT_K'] == 1]
+        configs = [
+            config for config in configs
+            if config.kwargs['SPLIT_K'] == 1 and not config.kwargs.get('STREAM_K', False)
+        ]
+
+    # stream-k only differs from data-parallel when the tiles do not fill the
+    # last wave
+    num_sm = get_num_sms(device)
+    M, N = named_args['M'], named_args['N']
+    pruned_configs = []
+    for config in configs:
+        kw = config.kwargs
+        if kw.get('STREAM_K', False):
+            num_tiles = cdiv(M, kw['BLOCK_M']) * cdiv(N, kw['BLOCK_N'])
+            num_sk_tiles = get_stream_k_tiles(num_tiles, num_sm)
+            if num_sk_tiles == 0:
+                continue
+        pruned_configs.append(config)
+    configs = pruned_configs
 
-    # group configs by (BLOCK_M,_N,_K, SPLIT_K, num_warps)
+    # group configs by (BLOCK_M,_N,_K, SPLIT_K, STREAM_K, num_warps)
     configs_map = {}
     for config in configs:
         kw = config.kwargs
         BLOCK_M, BLOCK_N, BLOCK_K, SPLIT_K, num_warps, num_stages = \
             kw['BLOCK_M'], kw['BLOCK_N'], kw['BLOCK_K'], kw['SPLIT_K'], config.num_warps, config.num_stages
 
-        key = (BLOCK_M, BLOCK_N, BLOCK_K, SPLIT_K, num_warps)
+        key = (BLOCK_M, BLOCK_N, BLOCK_K, SPLIT_K, kw.get('STREAM_K', False), num_warps)
         if key in configs_map:
             configs_map[key].append((config, num_stages))
         else:
@@ -136,7 +183,7 @@ def early_config_prune(configs, named_args):
 
     pruned_configs = []
     for k, v in configs_map.items():
-        BLOCK_M, BLOCK_N, BLOCK_K, SPLIT_K, num_warps = k
+        BLOCK_M, BLOCK_N, BLOCK_K, SPLIT_K, STREAM_K, num_warps = k
         if capability[0] >= 8:
             # compute cycles (only works for ampere GPUs)
             mmas = BLOCK_M * BLOCK_N * BLOCK_K / (16 * 8 * 16)
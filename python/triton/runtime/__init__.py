@@ -1,6 +1,9 @@
 from .autotuner import (Autotuner, Config, Heuristics, OutOfResources, autotune, heuristics)
 from .driver import driver
-from .jit import JITFunction, KernelInterface, MockTensor, TensorWrapper, reinterpret
+from .fusion import fused_launches
+from .jit import (CompileStats, JITFunction, KernelInterface, MockTensor, PersistentGrid, TensorWrapper, compile_stats,
+                  reinterpret)
+from .workspace import Workspace, WorkspacePool, set_workspace_allocator, workspace_pool
 
 __all__ = [
     "driver",
@@ -14,5 +17,13 @@ __all__ = [
     "TensorWrapper",
     "OutOfResources",
     "MockTensor",
+    "PersistentGrid",
     "Autotuner",
+    "CompileStats",
+    "compile_stats",
+    "fused_launches",
+    "Workspace",
+    "WorkspacePool",
+    "set_workspace_allocator",
+    "workspace_pool",
 ]
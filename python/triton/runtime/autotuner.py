@@ -1,11 +1,24 @@
 from __future__ import annotations
 
+import bisect
 import builtins
+import contextlib
+import hashlib
+import json
+import math
+import os
+import threading
 import time
+from concurrent.futures import ThreadPoolExecutor, as_completed
+from pathlib import Path
 from typing import Dict
 
+from ..backends.compiler import CompileBudgetExceeded, compile_budget
 from ..testing import do_bench
-from .jit import KernelInterface
+from . import manifest
+from .cache import get_cache_manager
+from .driver import driver
+from .jit import JITFunction, KernelInterface
 
 
 class OutOfResources(Exception):
@@ -23,6 +36,26 @@ class OutOfResources(Exception):
         return (type(self), (self.required, self.limit, self.name))
 
 
+def bucket_key_value(value, bucket):
+    """
+    Maps the value of an autotuning key argument to its bucket:
+
+    - `None` keeps the value as is;
+    - `"pow2"` rounds positive ints up to the next power of two;
+    - a sorted list of bounds maps values to the smallest bound that is at
+      least as large, and values above the last bound to `math.inf`;
+    - any other callable is called on the value.
+    """
+    if bucket is None:
+        return value
+    if bucket == "pow2":
+        return 1 << (value - 1).bit_length() if isinstance(value, int) and value > 0 else value
+    if callable(bucket):
+        return bucket(value)
+    index = bisect.bisect_left(bucket, value)
+    return bucket[index] if index < len(bucket) else math.inf
+
+
 class Autotuner(KernelInterface):
 
     def __init__(
@@ -36,18 +69,51 @@ class Autotuner(KernelInterface):
         prune_configs_by: Dict = None,
         warmup=25,
         rep=100,
+        compile_threads=None,
+        cache_results=False,
+        successive_halving=False,
+        devices=None,
+        key_buckets=None,
+        fast_compile=False,
+        compile_budget=None,
     ):
         """
         :param prune_configs_by: a dict of functions that are used to prune configs, fields:
             'perf_model': performance model used to predicate running time with different configs, returns running time
             'top_k': number of configs to bench
             'prune_num_stages_by'(optional): a function used to prune num_stages. It takes configs:List[Config] as its input, and returns pruned configs.
+            'max_spills'(optional): configs whose kernel spills more bytes of registers than this are not benchmarked.
+            'min_occupancy'(optional): configs whose kernel can't have at least this many CTAs resident per SM are not benchmarked.
+            'cost_model'(optional): estimates the running time of a config from the static cost of its compiled
+            kernel, `kernel.metadata.cost`, as cost_model(cost, config). When there are more than `top_k` configs,
+            they are all compiled and only the `top_k` with the lowest estimates are benchmarked.
+            Configs needing more shared memory than the device has are never benchmarked.
+        :param compile_threads: number of threads used to compile configs before benchmarking them. Defaults to
+            the number of CPUs; 1 compiles each config lazily when it is first benchmarked.
+        :param cache_results: whether to persist the best config for each tuning key through the cache manager
+            (also enabled by `TRITON_CACHE_AUTOTUNING=1`).
+        :param successive_halving: whether to benchmark all configs briefly first, and to spend the full `rep`
+            budget only on the fastest ones (see `_race`).
+        :param devices: devices to spread the benchmarking of configs over, or "all"; only those of the same kind
+            as the current device are used. Defaults to the current device only.
+        :param key_buckets: a dict mapping names of `key` arguments to the bucketing applied to their value before
+            it is looked up in (or stored to) the tuning cache; see `bucket_key_value`.
+        :param fast_compile: whether to compile the benchmarked configs at the LLVM optimization level 1, the
+            chosen one being recompiled at the default level when it runs (CUDA only).
+        :param compile_budget: a `CompileBudget` for the compilation of each benchmarked config. Configs that
+            exceed it are skipped, as if they exceeded the resources of the device.
         """
         if not configs:
             self.configs = [Config({}, num_warps=4, num_stages=2, num_ctas=1)]
         else:
             self.configs = configs
+        self.key_names = list(key)
         self.key_idx = [arg_names.index(k) for k in key]
+        key_buckets = key_buckets or {}
+        unknown = key_buckets.keys() - set(key)
+        if unknown:
+            raise ValueError(f"key_buckets refers to arguments that are not part of the key: {', '.join(unknown)}")
+        self.key_buckets = [key_buckets.get(k) for k in key]
         self.cache = {}
         self.arg_names = arg_names
 
@@ -59,7 +125,9 @@ class Autotuner(KernelInterface):
         if restore_value is not None:
             self.restore_idx = [arg_names.index(k) for k in restore_value]
 
-        # Hook to reset or restore for required tensors
+        # Hook to reset or restore for required tensors (per thread, as
+        # configs may be benchmarked on several devices at once)
+        self._hook_state = threading.local()
         self.pre_hook = lambda args, reset_only=False: 0
         self.post_hook = lambda args: 0
         if len(self.reset_idx) > 0 or len(self.restore_idx) > 0:
@@ -68,31 +136,54 @@ class Autotuner(KernelInterface):
                 for i in self.reset_idx:
                     args[i].zero_()
                 if not reset_only:
-                    self.restore_copies = [args[i].clone() for i in self.restore_idx]
+                    self._hook_state.restore_copies = [args[i].clone() for i in self.restore_idx]
 
             self.pre_hook = _pre_hook
         if len(self.restore_idx) > 0:
 
             def _post_hook(args):
                 for i, j in enumerate(self.restore_idx):
-                    args[j].copy_(self.restore_copies[i])
-                self.restore_copies = []
+                    args[j].copy_(self._hook_state.restore_copies[i])
+                self._hook_state.restore_copies = []
 
             self.post_hook = _post_hook
 
         self.perf_model = None
         self.configs_top_k = 1.0
         self.early_config_prune = None
+        self.max_spills = None
+        self.min_occupancy = None
+        self.cost_model = None
         if prune_configs_by:
             self.perf_model = prune_configs_by.get("perf_model", self.perf_model)
             self.configs_top_k = prune_configs_by.get("top_k", self.configs_top_k)
             self.early_config_prune = prune_configs_by.get("early_config_prune", self.early_config_prune)
+            self.max_spills = prune_configs_by.get("max_spills", self.max_spills)
+            self.min_occupancy = prune_configs_by.get("min_occupancy", self.min_occupancy)
+            self.cost_model = prune_configs_by.get("cost_model", self.cost_model)
 
         self.fn = fn
         self.num_warmups = warmup
         self.num_reps = rep
+        self.compile_threads = compile_threads if compile_threads is not None else (os.cpu_count() or 1)
+        self.cache_results = True if os.environ.get("TRITON_CACHE_AUTOTUNING", "0") == "1" else cache_results
+        self.successive_halving = successive_halving
+        self.devices = devices
+        self.fast_compile = fast_compile
+        self.compile_budget = compile_budget
+        self.race_finalists = None
+        self._captured = {}
+
+    def _candidate_options(self, meta):
+        """
+        The compilation options of the benchmarked candidates, which may be
+        optimized less than the chosen config.
+        """
+        if not self.fast_compile or "llvm_opt_level" in meta or driver.get_current_target()[0] != "cuda":
+            return {}
+        return {"llvm_opt_level": 1}
 
-    def _bench(self, *args, config, **meta):
+    def _bench(self, *args, config, warmup=None, rep=None, nargs=None, **meta):
         # check for conflicts, i.e. meta-parameters both provided
         # as kwargs and by the autotuner
         conflicts = meta.keys() & config.kwargs.keys()
@@ -101,7 +192,8 @@ class Autotuner(KernelInterface):
                              " Make sure that you don't re-define auto-tuned symbols.")
         # augment meta-parameters with tunable ones
         current = dict(meta, **config.kwargs)
-        full_nargs = {**self.nargs, **current}
+        full_nargs = {**(self.nargs if nargs is None else nargs), **current}
+        options = self._candidate_options(meta)
 
         def kernel_call():
             if config.pre_hook:
@@ -116,37 +208,275 @@ class Autotuner(KernelInterface):
                 # TODO: Make it configurable
                 # enable_persistent=False,
                 **current,
+                **options,
             )
             self.post_hook(args)
 
         try:
-            return do_bench(kernel_call, warmup=self.num_warmups, rep=self.num_reps, quantiles=(0.5, 0.2, 0.8))
-        except OutOfResources:
+            with manifest.capture() as entries:
+                return do_bench(kernel_call, warmup=self.num_warmups if warmup is None else warmup,
+                                rep=self.num_reps if rep is None else rep, quantiles=(0.5, 0.2, 0.8))
+        except (OutOfResources, CompileBudgetExceeded):
             return [float("inf"), float("inf"), float("inf")]
+        finally:
+            self._captured.setdefault(config, []).extend(entries)
+
+    def _compile(self, *args, config, device, **meta):
+        # worker threads don't inherit the current device
+        driver.set_current_device(device)
+        current = dict(meta, **config.kwargs, **self._candidate_options(meta), warmup=True)
+        budget = contextlib.nullcontext() if self.compile_budget is None else compile_budget(self.compile_budget)
+        with manifest.capture() as entries, budget:
+            try:
+                kernel = self.fn.run(
+                    *args,
+                    num_warps=config.num_warps,
+                    num_stages=config.num_stages,
+                    num_ctas=config.num_ctas,
+                    enable_warp_specialization=config.enable_warp_specialization,
+                    **current,
+                )
+            except CompileBudgetExceeded:
+                # see `_exceeds_resources`
+                kernel = None
+        self._captured[config] = entries
+        return kernel
+
+    def _exceeds_resources(self, kernel):
+        """
+        Whether the compiled `kernel` can't run, or is not worth benchmarking
+        given the `max_spills` and `min_occupancy` limits. `kernel` is None
+        when its compilation exceeded the `compile_budget`.
+        """
+        if kernel is None:
+            return True
+        metadata = getattr(kernel, "metadata", None)
+        if metadata is None:
+            return False
+        max_shared = driver.utils.get_device_properties(driver.get_current_device())["max_shared_mem"]
+        if metadata.shared > max_shared:
+            return True
+        if self.max_spills is not None and getattr(metadata, "n_spills", 0) > self.max_spills:
+            return True
+        if self.min_occupancy is not None and hasattr(driver.utils, "occupancy"):
+            return kernel.occupancy()["max_active_ctas_per_sm"] < self.min_occupancy
+        return False
+
+    def _bench_all(self, *args, configs, **kwargs):
+        """
+        Benchmarks `configs`, compiling them concurrently first when allowed.
+        Configs are benchmarked in the order their compilation finishes, so
+        that the GPU is busy while the remaining ones are still compiling.
+        Configs whose kernel exceeds the resource limits get an infinite
+        timing without being run.
+        """
+        num_threads = builtins.min(self.compile_threads, len(configs))
+        device = driver.get_current_device()
+        timings = {}
+        budget = {}
+        if self.successive_halving and len(configs) > 1:
+            # first round of `_race`: the full budget split in halves as many
+            # times as there are rounds
+            rep = self.num_reps / 2**math.ceil(math.log2(len(configs)))
+            budget = {"warmup": builtins.min(self.num_warmups, rep), "rep": rep}
+
+        def bench(kernel, config):
+            if self._exceeds_resources(kernel):
+                timings[config] = [float("inf"), float("inf"), float("inf")]
+            else:
+                timings[config] = self._bench(*args, config=config, **budget, **kwargs)
+
+        devices = self._bench_devices()
+        if len(devices) > 1:
+            timings.update(self._bench_on_devices(*args, configs=configs, devices=devices, **budget, **kwargs))
+        elif num_threads <= 1:
+            for config in configs:
+                bench(self._compile(*args, config=config, device=device, **kwargs), config)
+        else:
+            with ThreadPoolExecutor(max_workers=num_threads) as executor:
+                futures = {
+                    executor.submit(self._compile, *args, config=config, device=device, **kwargs): config
+                    for config in configs
+                }
+                for future in as_completed(futures):
+                    bench(future.result(), futures[future])
+        if budget:
+            self._race(*args, timings=timings, rep=budget["rep"], **kwargs)
+        # report timings in the same order as `configs`
+        return {config: timings[config] for config in configs}
+
+    def _bench_devices(self):
+        """
+        Returns the devices configs are benchmarked on, the current one first.
+        Devices of another model than the current one are left out, as their
+        timings wouldn't be comparable.
+        """
+        device = driver.get_current_device()
+        if self.devices is None:
+            return [device]
+        devices = self.devices
+        if devices == "all":
+            import torch
+            devices = range(torch.cuda.device_count())
+        name = driver.get_device_name(device)
+        others = [d for d in devices if d != device and driver.get_device_name(d) == name]
+        return [device] + others
+
+    def _bench_on_devices(self, *args, configs, devices, warmup=None, rep=None, **kwargs):
+        """
+        Compiles and benchmarks `configs` on `devices`, one thread per device.
+        Each device gets its own stream and its own copy of the tensor
+        arguments, so that configs don't interfere with each other.
+        """
+        import torch
+
+        def to_device(value, device):
+            if isinstance(value, torch.Tensor) and value.device.type != "cpu":
+                return value.to(torch.device(value.device.type, device))
+            return value
+
+        def bench_on(device, device_configs):
+            driver.set_current_device(device)
+            dev_args = [to_device(arg, device) for arg in args]
+            dev_kwargs = {k: to_device(v, device) for k, v in kwargs.items()}
+            nargs = dict(zip(self.arg_names, dev_args))
+            timings = {}
+            with torch.cuda.stream(torch.cuda.Stream(device)):
+                for config in device_configs:
+                    kernel = self._compile(*dev_args, config=config, device=device, **dev_kwargs)
+                    if self._exceeds_resources(kernel):
+                        timings[config] = [float("inf"), float("inf"), float("inf")]
+                    else:
+                        timings[config] = self._bench(*dev_args, config=config, warmup=warmup, rep=rep, nargs=nargs,
+                                                      **dev_kwargs)
+                torch.cuda.synchronize(device)
+            return timings
+
+        timings = {}
+        with ThreadPoolExecutor(max_workers=len(devices)) as executor:
+            futures = [
+                executor.submit(bench_on, device, configs[i::len(devices)])
+                for i, device in enumerate(devices)
+            ]
+            for future in futures:
+                timings.update(future.result())
+        return timings
+
+    def _race(self, *args, timings, rep, **kwargs):
+        """
+        Successive halving: given `timings` measured with a `rep` budget,
+        re-benchmarks the faster half of the configs with twice the budget,
+        until a single config is left or the full budget is reached. Dropped
+        configs keep their last (shorter) timing, so the winner is picked
+        among the finalists only (see `race_finalists`).
+        """
+        alive = [config for config, timing in timings.items() if timing[0] < float("inf")]
+        while len(alive) > 1 and rep < self.num_reps:
+            alive = sorted(alive, key=lambda config: timings[config][0])[:math.ceil(len(alive) / 2)]
+            rep = builtins.min(2 * rep, self.num_reps)
+            warmup = self.num_warmups if rep == self.num_reps else builtins.min(self.num_warmups, rep)
+            for config in alive:
+                timings[config] = self._bench(*args, config=config, warmup=warmup, rep=rep, **kwargs)
+        self.race_finalists = alive
+
+    def _results_cache(self, key):
+        """
+        Returns the cache manager holding the tuning decision for `key`.
+        Decisions are invalidated whenever Triton, the kernel's source (or
+        that of its dependencies), the device or the list of configs changes.
+        """
+        from ..compiler.compiler import triton_key
+        fn = self.fn
+        while not isinstance(fn, JITFunction):
+            fn = fn.fn
+        device_name = driver.get_device_name(driver.get_current_device())
+        cache_key = [triton_key(), fn.cache_key, device_name, [str(k) for k in key], [str(c) for c in self.configs]]
+        return get_cache_manager(hashlib.md5(json.dumps(cache_key).encode("utf-8")).hexdigest())
+
+    def _load_best_config(self, key):
+        path = self._results_cache(key).get_file("autotune.json")
+        if path is None:
+            return None
+        best = json.loads(Path(path).read_text())["config"]
+        # the decision may have been made for a config that has since been
+        # edited in a way that doesn't change its string representation
+        return next((config for config in self._stored_configs() if str(config) == best), None)
+
+    def _stored_configs(self):
+        """
+        The configs a stored decision may name: a `num_ctas="auto"` config
+        stands for its variants with clusters of up to 8 CTAs.
+        """
+        for config in self.configs:
+            if config.num_ctas == "auto":
+                yield from (config.with_num_ctas(num_ctas) for num_ctas in (1, 2, 4, 8))
+            else:
+                yield config
+
+    def _store_best_config(self, key, config, timings):
+        fn = self.fn
+        while not isinstance(fn, JITFunction):
+            fn = fn.fn
+        num_keys = len(self.key_names)
+        data = {
+            "config": str(config), "timings": {str(c): t for c, t in timings.items()},
+            # what `triton.tools.export_heuristics` needs to turn decisions into a table
+            "fn": f"{fn.module}:{fn.__name__}", "device": driver.get_device_name(driver.get_current_device()),
+            "key_names": self.key_names, "key": list(key[:num_keys]), "dtypes": list(key[num_keys:]),
+            "config_fields": config.as_dict()
+        }
+        try:
+            json.dumps(data)
+        except (TypeError, ValueError):
+            # key values that aren't JSON-serializable can only be matched by their string
+            data["key"] = [str(k) for k in data["key"]]
+            data["config_fields"]["kwargs"] = {k: str(v) for k, v in config.kwargs.items()}
+        self._results_cache(key).put(json.dumps(data), "autotune.json", binary=False)
 
     def run(self, *args, **kwargs):
         self.nargs = dict(zip(self.arg_names, args))
-        if len(self.configs) > 1:
+        if len(self.configs) > 1 or self.configs[0].num_ctas == "auto":
             all_args = {**self.nargs, **kwargs}
             _args = []
             for name in self.arg_names:
                 if name in all_args:
                     _args.append(all_args[name])
             key = [_args[i] for i in self.key_idx]
+            if self.key_buckets:
+                key = [bucket_key_value(v, bucket) for v, bucket in zip(key, self.key_buckets)]
             for arg in _args:
                 if hasattr(arg, "dtype"):
                     key.append(str(arg.dtype))
             key = tuple(key)
+            if key not in self.cache and self.cache_results:
+                best_config = self._load_best_config(key)
+                if best_config is not None:
+                    self.cache[key] = best_config
+                    if manifest.recording():
+                        manifest.record_autotune(self, key, best_config, [])
             if key not in self.cache:
                 # prune configs
                 pruned_configs = self.prune_configs(kwargs)
                 bench_start = time.time()
-                timings = {config: self._bench(*args, config=config, **kwargs) for config in pruned_configs}
+                # kernels compiled while benchmarking are only recorded in the
+                # warm-up manifest if their config wins
+                self._captured = {}
+                self.race_finalists = None
+                pruned_configs = self._expand_cluster_shapes(*args, configs=pruned_configs, **kwargs)
+                pruned_configs = self._prune_by_cost(*args, configs=pruned_configs, **kwargs)
+                timings = self._bench_all(*args, configs=pruned_configs, **kwargs)
                 bench_end = time.time()
                 self.bench_time = bench_end - bench_start
-                self.cache[key] = builtins.min(timings, key=timings.get)
+                self.cache[key] = builtins.min(self.race_finalists or timings, key=timings.get)
                 self.pre_hook(args, reset_only=True)
                 self.configs_timings = timings
+                if self.cache_results:
+                    self._store_best_config(key, self.cache[key], timings)
+                if manifest.recording():
+                    # the candidates compiled faster are not the kernel that runs
+                    captured = [] if self.fast_compile else self._captured.get(self.cache[key], [])
+                    manifest.record_autotune(self, key, self.cache[key], captured)
+                self._captured = {}
             config = self.cache[key]
         else:
             config = self.configs[0]
@@ -193,22 +523,113 @@ class Autotuner(KernelInterface):
                 pruned_configs = sorted(est_timing.keys(), key=lambda x: est_timing[x])[:top_k]
         return pruned_configs
 
+    def _num_programs(self, kernel, config, kwargs):
+        # the number of programs a launch of `kernel` runs, None when it is
+        # only known once launched (e.g. persistent grids)
+        grid = kwargs.get("grid")
+        if callable(grid):
+            grid = grid({**self.nargs, **kwargs, **config.kwargs})
+        if not isinstance(grid, (tuple, list)):
+            return None
+        return math.prod(grid) * getattr(kernel.metadata, "split_k", 1)
+
+    def _expand_cluster_shapes(self, *args, configs, **kwargs):
+        """
+        Replaces the configs with `num_ctas="auto"` by their variant with a
+        single CTA per program and those with the cluster shapes the compiler
+        proposes for its kernel (see `proposed_cluster_dims` in the metadata
+        and `proposeClusterDims` in PlanCTA), on SM90+ only. A clustered
+        variant is dropped when its clusters can't be resident on the device
+        (`cuOccupancyMaxActiveClusters`), or when its grid would take more
+        waves than `num_ctas` times those of the single-CTA kernel, so that
+        it couldn't win even if its CTAs ran a program `num_ctas` times
+        faster.
+        """
+        if not any(config.num_ctas == "auto" for config in configs):
+            return configs
+        backend, capability = driver.get_current_target()[:2]
+        clusters = backend == "cuda" and capability >= 90 and hasattr(driver.utils, "occupancy")
+        device = driver.get_current_device()
+        expanded = []
+        for config in configs:
+            if config.num_ctas != "auto":
+                expanded.append(config)
+                continue
+            single = config.with_num_ctas(1)
+            expanded.append(single)
+            kernel = self._compile(*args, config=single, device=device, **kwargs)
+            if not clusters or self._exceeds_resources(kernel):
+                continue
+            num_programs = self._num_programs(kernel, single, kwargs)
+            resident = kernel.max_resident_programs()
+            waves = math.ceil(num_programs / resident) if num_programs is not None and resident else None
+            for cluster_dims in kernel.metadata.proposed_cluster_dims:
+                candidate = config.with_num_ctas(math.prod(cluster_dims))
+                clustered = self._compile(*args, config=candidate, device=device, **kwargs)
+                if self._exceeds_resources(clustered):
+                    continue
+                max_clusters = clustered.occupancy()["max_active_clusters"]
+                if not max_clusters:
+                    continue
+                if waves is not None and math.ceil(num_programs / max_clusters) > candidate.num_ctas * waves:
+                    continue
+                expanded.append(candidate)
+        return expanded
+
+    def _prune_by_cost(self, *args, configs, **kwargs):
+        """
+        Keeps the `top_k` configs with the lowest running time estimated by
+        `cost_model` from the static cost of their compiled kernel. Kernels
+        are cached once compiled, so benchmarking the remaining configs
+        doesn't compile them again.
+        """
+        if self.cost_model is None:
+            return configs
+        top_k = self.configs_top_k
+        if isinstance(top_k, float) and top_k <= 1.0:
+            top_k = builtins.max(1, int(len(self.configs) * top_k))
+        if len(configs) <= top_k:
+            return configs
+        device = driver.get_current_device()
+        est_timing = {}
+        for config in configs:
+            kernel = self._compile(*args, config=config, device=device, **kwargs)
+            if kernel is None:
+                # out of its compile budget
+                est_timing[config] = float("inf")
+                continue
+            cost = getattr(getattr(kernel, "metadata", None), "cost", None)
+            # configs without a cost are kept, ahead of the ranked ones
+            est_timing[config] = float("-inf") if cost is None else self.cost_model(cost, config)
+        return sorted(configs, key=est_timing.get)[:top_k]
+
     def warmup(self, *args, **kwargs):
         self.nargs = dict(zip(self.arg_names, args))
         ret = []
+
+        def warmup(config):
+            kernel = self.fn.warmup(
+                *args,
+                num_warps=config.num_warps,
+                num_ctas=config.num_ctas,
+                num_stages=config.num_stages,
+                enable_warp_specialization=config.enable_warp_specialization,
+                # TODO: Make it configurable
+                # enable_persistent=False,
+                **kwargs,
+                **config.kwargs,
+            )
+            ret.append(kernel)
+            return kernel
+
         for config in self.prune_configs(kwargs):
-            ret.append(
-                self.fn.warmup(
-                    *args,
-                    num_warps=config.num_warps,
-                    num_ctas=config.num_ctas,
-                    num_stages=config.num_stages,
-                    enable_warp_specialization=config.enable_warp_specialization,
-                    # TODO: Make it configurable
-                    # enable_persistent=False,
-                    **kwargs,
-                    **config.kwargs,
-                ))
+            if config.num_ctas != "auto":
+                warmup(config)
+                continue
+            # without the device to check them on, all the proposed shapes
+            kernel = warmup(config.with_num_ctas(1))
+            for cluster_dims in getattr(getattr(kernel, "metadata", None), "proposed_cluster_dims", []):
+                warmup(config.with_num_ctas(math.prod(cluster_dims)))
         self.nargs = None
         return ret
 
@@ -225,15 +646,19 @@ class Config:
     :type num_warps: int
     :ivar num_stages: the number of stages that the compiler should use when software-pipelining loops.
                        Mostly useful for matrix multiplication workloads on SM80+ GPUs.
-    :type num_ctas: int
-    :ivar num_ctas: number of blocks in a block cluster. SM90+ only.
+    :type num_ctas: int or str
+    :ivar num_ctas: number of blocks in a block cluster. SM90+ only. `"auto"` lets the autotuner try the
+                    cluster shapes the compiler proposes from the tile of the dot of the kernel, that fit
+                    on the device for the grid of the launch, alongside a single block.
     :type enable_warp_specialization: bool
     :ivar enable_warp_specialization: enable specialization (spatial partitioning) or not. See https://docs.nvidia.com/cuda/cuda-c-programming-guide/index.html#spatial-partitioning-also-known-as-warp-specialization
+                                      None lets the compiler decide, see the `ws_enabled` metadata of the
+                                      compiled kernels.
     :ivar pre_hook: a function that will be called before the kernel is called. Parameters of this
                     function are args.
     """
 
-    def __init__(self, kwargs, num_warps=4, num_stages=2, num_ctas=1, enable_warp_specialization=False, pre_hook=None):
+    def __init__(self, kwargs, num_warps=4, num_stages=2, num_ctas=1, enable_warp_specialization=None, pre_hook=None):
         self.kwargs = kwargs
         self.num_warps = num_warps
         self.num_ctas = num_ctas
@@ -243,6 +668,19 @@ class Config:
         self.enable_persistent = False
         self.pre_hook = pre_hook
 
+    def with_num_ctas(self, num_ctas):
+        """
+        Returns a copy of this config with clusters of `num_ctas` blocks.
+        """
+        return Config(self.kwargs, num_warps=self.num_warps, num_stages=self.num_stages, num_ctas=num_ctas,
+                      enable_warp_specialization=self.enable_warp_specialization, pre_hook=self.pre_hook)
+
+    def as_dict(self):
+        return {
+            "kwargs": dict(self.kwargs), "num_warps": self.num_warps, "num_stages": self.num_stages, "num_ctas":
+            self.num_ctas, "enable_warp_specialization": self.enable_warp_specialization
+        }
+
     def __str__(self):
         res = []
         for k, v in self.kwargs.items():
@@ -255,7 +693,9 @@ class Config:
         return ", ".join(res)
 
 
-def autotune(configs, key, prune_configs_by=None, reset_to_zero=None, restore_value=None, warmup=25, rep=100):
+def autotune(configs, key, prune_configs_by=None, reset_to_zero=None, restore_value=None, warmup=25, rep=100,
+             compile_threads=None, cache_results=False, successive_halving=False, devices=None, key_buckets=None,
+             fast_compile=False, compile_budget=None):
     """
     Decorator for auto-tuning a :code:`triton.jit`'d function.
 
@@ -284,6 +724,11 @@ def autotune(configs, key, prune_configs_by=None, reset_to_zero=None, restore_va
         'perf_model': performance model used to predicate running time with different configs, returns running time
         'top_k': number of configs to bench
         'early_config_prune'(optional): a function used to do early prune (eg, num_stages). It takes configs:List[Config] as its input, and returns pruned configs.
+        'max_spills'(optional): configs whose kernel spills more bytes of registers than this are not benchmarked.
+        'min_occupancy'(optional): configs whose kernel can't have at least this many CTAs resident per SM are not benchmarked.
+        'cost_model'(optional): estimates the running time of a config from the static cost of its compiled kernel,
+        `kernel.metadata.cost`, as cost_model(cost, config). When there are more than `top_k` configs, they are all
+        compiled and only the `top_k` with the lowest estimates are benchmarked.
     :param reset_to_zero: a list of argument names whose value will be reset to zero before evaluating any configs.
     :type reset_to_zero: list[str]
     :param restore_value: a list of argument names whose value will be restored after evaluating any configs.
@@ -292,10 +737,46 @@ def autotune(configs, key, prune_configs_by=None, reset_to_zero=None, restore_va
     :type warmup: int
     :param rep: Repetition time (in ms) to pass to benchmarking, defaults to 100.
     :type rep: int
+    :param compile_threads: Number of threads used to compile the configs concurrently before benchmarking them,
+        defaults to the number of CPUs. Set to 1 to compile each config when it is first benchmarked.
+    :type compile_threads: int
+    :param cache_results: Whether to persist the best config for each key value to the on-disk cache, so that
+        other processes can skip benchmarking. Stored decisions are keyed on the Triton version, the kernel source,
+        the device name and the list of configs, and are ignored as soon as any of these change; clearing the cache
+        directory (or pointing `TRITON_CACHE_DIR` elsewhere) forces re-tuning. Can also be enabled with
+        `TRITON_CACHE_AUTOTUNING=1`.
+    :type cache_results: bool
+    :param successive_halving: Whether to tune by successive halving: all configs are first benchmarked with a
+        fraction of `rep`, then only the faster half is benchmarked again with twice the budget, and so on, so that
+        only the last few configs get the full `rep`. Much faster for large search spaces, at the risk of dropping
+        a config whose first short timing was unrepresentative.
+    :type successive_halving: bool
+    :param devices: Devices to benchmark configs on concurrently, e.g. `"all"` for every visible device. Each device
+        benchmarks a share of the configs on copies of the arguments. Only devices of the same model as the current
+        one are used. Defaults to the current device only.
+    :type devices: list[int] or str
+    :param key_buckets: Bucketing of the values of `key` arguments, so that a single tuning decision (in memory and
+        in the on-disk cache) covers all the values of a bucket, e.g. `{'M': 'pow2'}` tunes once for M in 65..128.
+        Per argument, either `"pow2"`, a sorted list of upper bounds (values above the last one share a bucket),
+        or a function mapping a value to its bucket.
+    :type key_buckets: dict[str, str or list or callable]
+    :param fast_compile: Whether to compile the benchmarked configs at the LLVM optimization level 1 instead of 3,
+        which compiles large search spaces much faster. The chosen config is compiled again at the usual level for
+        the actual launches. Configs whose relative speed depends on the LLVM optimizations may be ranked wrongly.
+        Only used on CUDA.
+    :type fast_compile: bool
+    :param compile_budget: Limits on the time, the memory and the estimated code size of the compilation of each
+        benchmarked config, past which the config is skipped instead of stalling the tuning, e.g.
+        `triton.compiler.CompileBudget(seconds=60, memory_mb=8192)`. Defaults to the budget from the environment
+        (`TRITON_COMPILE_TIME_LIMIT`, `TRITON_COMPILE_MEMORY_LIMIT` and `TRITON_COMPILE_SIZE_LIMIT`), which also
+        applies outside of tuning.
+    :type compile_budget: triton.compiler.CompileBudget
     """
 
     def decorator(fn):
-        return Autotuner(fn, fn.arg_names, configs, key, reset_to_zero, restore_value, prune_configs_by, warmup, rep)
+        return Autotuner(fn, fn.arg_names, configs, key, reset_to_zero, restore_value, prune_configs_by, warmup, rep,
+                         compile_threads, cache_results, successive_halving, devices, key_buckets, fast_compile,
+                         compile_budget)
 
     return decorator
 
@@ -334,3 +815,84 @@ def heuristics(values):
         return Heuristics(fn, fn.arg_names, values)
 
     return decorator
+
+
+def _log2_key(value):
+    # keys above the last bound of a list of buckets are infinite
+    return math.log2(builtins.min(builtins.max(value, 1), 2**62))
+
+
+def _rule_matches(rule, names, key):
+    for name, (lo, hi) in rule.get("ranges", {}).items():
+        value = key[names.index(name)]
+        if (lo is not None and value < lo) or (hi is not None and value >= hi):
+            return False
+    return all(key[names.index(name)] == value for name, value in rule.get("values", {}).items())
+
+
+def select_config(table, key):
+    """
+    Returns the index (in `table["configs"]`) of the config a decision table
+    written by `triton.tools.export_heuristics` picks for the values `key` of
+    its `key_names`.
+
+    The optional `rules` of the table are tried first, in order: a rule
+    `{"ranges": {name: [lo, hi]}, "values": {name: value}, "config": i}`
+    matches when every named key value is in `[lo, hi)` (`None` meaning
+    unbounded), or equal to the given value. Otherwise it is the config of the
+    row with the same key if there is one, and that of the row closest to it,
+    distances being measured between the base-2 logarithms of the (numeric)
+    key values. `link.py --heuristics` generates the same selection in C.
+    """
+    key = list(key)
+    for rule in table.get("rules", []):
+        if _rule_matches(rule, table["key_names"], key):
+            return rule["config"]
+    best, best_distance = None, math.inf
+    for row in table.get("rows", []):
+        if row["key"] == key:
+            return row["config"]
+        distance = 0.0
+        for v, r in zip(key, row["key"]):
+            if isinstance(v, (int, float)) and isinstance(r, (int, float)):
+                distance += abs(_log2_key(v) - _log2_key(r))
+            elif v != r:
+                distance = math.inf
+                break
+        if distance < best_distance:
+            best, best_distance = row["config"], distance
+    return best if best is not None else table.get("default", 0)
+
+
+def heuristics_from_table(table):
+    """
+    Returns the `values` of a :code:`triton.heuristics` decorator applying
+    the decisions of `table` (a table written by
+    `triton.tools.export_heuristics`, or the path to one), so that a kernel
+    that was autotuned offline can run without benchmarking:
+
+    .. code-block:: python
+
+        @triton.heuristics(values=heuristics_from_table("matmul.json"))
+        @triton.jit
+        def matmul(a_ptr, b_ptr, c_ptr, M, N, K, BLOCK_M: tl.constexpr, ...):
+            ...
+    """
+    if not isinstance(table, dict):
+        table = json.loads(Path(table).read_text())
+    names = table["key_names"]
+    configs = table["configs"]
+    decisions = {}
+
+    def decide(args):
+        key = tuple(args[name] for name in names)
+        if key not in decisions:
+            config = configs[select_config(table, key)]
+            decisions[key] = {
+                **config["kwargs"], "num_warps": config["num_warps"], "num_stages": config["num_stages"], "num_ctas":
+                config["num_ctas"]
+            }
+        return decisions[key]
+
+    fields = set(configs[0]["kwargs"]) | {"num_warps", "num_stages", "num_ctas"} if configs else set()
+    return {field: (lambda args, field=field: decide(args)[field]) for field in fields}
@@ -1,10 +1,19 @@
+import base64
+import fcntl
 import json
+import mmap
 import os
 import random
+import shutil
+import struct
+import time
 from abc import ABC, abstractmethod
+from contextlib import contextmanager
 from pathlib import Path
 from typing import Dict, Optional
 import hashlib
+import urllib.error
+import urllib.request
 
 
 def default_cache_dir():
@@ -19,6 +28,10 @@ def default_dump_dir():
     return os.path.join(Path.home(), ".triton", "dump")
 
 
+# The directory of the cache for the binaries shared by several entries
+BLOB_DIR = "__blobs__"
+
+
 class CacheManager(ABC):
 
     def __init__(self, key):
@@ -44,12 +57,21 @@ class CacheManager(ABC):
     def put_group(self, filename: str, group: Dict[str, str]):
         pass
 
+    def put_blob(self, data: bytes, filename: str) -> str:
+        """
+        Like `put` for a binary that other cache entries may share, which
+        managers can store once by content.
+        """
+        return self.put(data, filename)
+
 
 class FileCacheManager(CacheManager):
 
     def __init__(self, key, override=False, dump=False):
         self.key = key
         self.lock_path = None
+        self.index = None
+        self.blob_dir = None
         if dump:
             self.cache_dir = default_dump_dir()
             self.cache_dir = os.path.join(self.cache_dir, self.key)
@@ -62,6 +84,8 @@ class FileCacheManager(CacheManager):
             # create cache directory if it doesn't exist
             self.cache_dir = os.getenv("TRITON_CACHE_DIR", "").strip() or default_cache_dir()
             if self.cache_dir:
+                self.index = _cache_index(self.cache_dir)
+                self.blob_dir = os.path.join(self.cache_dir, BLOB_DIR)
                 self.cache_dir = os.path.join(self.cache_dir, self.key)
                 self.lock_path = os.path.join(self.cache_dir, "lock")
                 os.makedirs(self.cache_dir, exist_ok=True)
@@ -78,26 +102,36 @@ class FileCacheManager(CacheManager):
 
     def get_file(self, filename) -> Optional[str]:
         if self.has_file(filename):
+            if self.index is not None:
+                self.index.touch(self.key)
             return self._make_path(filename)
         else:
             return None
 
     def get_group(self, filename: str) -> Optional[Dict[str, str]]:
-        grp_filename = f"__grp__{filename}"
-        if not self.has_file(grp_filename):
+        if not self.cache_dir:
+            raise RuntimeError("Could not create or locate cache dir")
+        # A group file is only written once all of its members are, and
+        # eviction removes group files first, so the group file is the only
+        # thing that needs to be read here. Members removed by hand or by a
+        # concurrent eviction fail to open when loaded, which the compiler
+        # takes as a miss.
+        try:
+            with open(self._make_path(f"__grp__{filename}")) as f:
+                grp_data = json.load(f)
+        except (FileNotFoundError, ValueError):
             return None
-        grp_filepath = self._make_path(grp_filename)
-        with open(grp_filepath) as f:
-            grp_data = json.load(f)
         child_paths = grp_data.get("child_paths", None)
         # Invalid group data.
         if child_paths is None:
             return None
-        result = {}
-        for c, p in child_paths.items():
-            if os.path.exists(p):
-                result[c] = p
-        return result
+        # Shared binaries are evicted on their own.
+        blobs = [path for path in child_paths.values() if self.blob_dir and path.startswith(self.blob_dir)]
+        if self.index is not None:
+            self.index.touch(self.key)
+            if blobs:
+                self.index.touch(BLOB_DIR)
+        return child_paths
 
     # Note a group of pushed files as being part of a group
     def put_group(self, filename: str, group: Dict[str, str]) -> str:
@@ -107,6 +141,23 @@ class FileCacheManager(CacheManager):
         grp_filename = f"__grp__{filename}"
         return self.put(grp_contents, grp_filename, binary=False)
 
+    def put_blob(self, data: bytes, filename: str) -> str:
+        # Specializations that only differ in dead code often compile to the
+        # same binary, which is then stored once, named by its hash.
+        if self.blob_dir is None:
+            return self.put(data, filename)
+        os.makedirs(self.blob_dir, exist_ok=True)
+        filepath = os.path.join(self.blob_dir, hashlib.sha256(data).hexdigest() + Path(filename).suffix)
+        if os.path.exists(filepath):
+            return filepath
+        temp_path = f"{filepath}.tmp.pid_{os.getpid()}_{random.randint(0, 1000000)}"
+        with open(temp_path, "wb") as f:
+            f.write(data)
+        os.replace(temp_path, filepath)
+        if self.index is not None:
+            self.index.add(BLOB_DIR, len(data))
+        return filepath
+
     def put(self, data, filename, binary=True) -> str:
         if not self.cache_dir:
             raise RuntimeError("Could not create or locate cache dir")
@@ -127,9 +178,257 @@ class FileCacheManager(CacheManager):
         # Replace is guaranteed to be atomic on POSIX systems if it succeeds
         # so filepath cannot see a partial write
         os.replace(temp_path, filepath)
+        if self.index is not None:
+            self.index.add(self.key, len(data))
         return filepath
 
 
+def _parse_size(size: str) -> int:
+    size = size.strip().upper()
+    units = {"K": 1 << 10, "M": 1 << 20, "G": 1 << 30, "T": 1 << 40}
+    if size and size[-1] in units:
+        return int(float(size[:-1]) * units[size[-1]])
+    return int(size or 0)
+
+
+class _CacheIndex:
+    """
+    Size and access-time bookkeeping for the cache directories under `root`,
+    used to bound the cache to `TRITON_CACHE_MAX_SIZE` bytes (e.g. `20G`).
+
+    The index is a file of fixed-size records -- directory name, bytes
+    stored, last access time -- that every process maps in memory. Hits only
+    update the access time in place; entries are appended under a file lock
+    and, once the cache grows past its cap, the least recently used
+    directories are removed and the index is compacted.
+    """
+
+    RECORD = struct.Struct("<64sQd")
+    ATIME_OFFSET = 72
+    # Evict down to this fraction of the cap, so that eviction does not run
+    # again on the very next compilation.
+    LOW_WATERMARK = 0.8
+
+    def __init__(self, root: str, max_size: int):
+        self.root = root
+        self.max_size = max_size
+        self.path = os.path.join(root, "__index__")
+        self.lock_path = os.path.join(root, "__index__.lock")
+        self.mm = None
+        self.file_id = None
+        self.slots: Dict[str, int] = {}
+
+    @contextmanager
+    def _locked(self):
+        with open(self.lock_path, "a") as f:
+            fcntl.flock(f, fcntl.LOCK_EX)
+            try:
+                yield
+            finally:
+                fcntl.flock(f, fcntl.LOCK_UN)
+
+    def _refresh(self):
+        # Other processes append to the index or replace it on compaction;
+        # remap whenever the file (or its size) changed.
+        try:
+            st = os.stat(self.path)
+        except FileNotFoundError:
+            st = None
+        file_id = None if st is None else (st.st_ino, st.st_size)
+        if file_id == self.file_id:
+            return
+        if self.mm is not None:
+            self.mm.close()
+        self.mm = None
+        self.slots = {}
+        self.file_id = file_id
+        if st is None or st.st_size < self.RECORD.size:
+            return
+        with open(self.path, "r+b") as f:
+            self.mm = mmap.mmap(f.fileno(), st.st_size - st.st_size % self.RECORD.size)
+        for slot, (name, _, _) in enumerate(self.RECORD.iter_unpack(self.mm)):
+            self.slots[name.rstrip(b"\0").decode()] = slot
+
+    def _records(self):
+        self._refresh()
+        if self.mm is None:
+            return []
+        return [(name.rstrip(b"\0").decode(), size, atime) for name, size, atime in self.RECORD.iter_unpack(self.mm)]
+
+    def touch(self, key: str):
+        self._refresh()
+        slot = self.slots.get(key)
+        if slot is None:
+            # Directories created before the cache was bounded.
+            size = sum(entry.stat().st_size for entry in os.scandir(os.path.join(self.root, key)) if entry.is_file())
+            return self.add(key, size)
+        struct.pack_into("<d", self.mm, slot * self.RECORD.size + self.ATIME_OFFSET, time.time())
+
+    def add(self, key: str, nbytes: int):
+        if len(key) > 64:
+            return
+        now = time.time()
+        with self._locked():
+            self._refresh()
+            slot = self.slots.get(key)
+            if slot is not None:
+                _, size, _ = self.RECORD.unpack_from(self.mm, slot * self.RECORD.size)
+                self.RECORD.pack_into(self.mm, slot * self.RECORD.size, key.encode(), size + nbytes, now)
+            else:
+                with open(self.path, "ab") as f:
+                    f.write(self.RECORD.pack(key.encode(), nbytes, now))
+            records = self._records()
+            if sum(size for _, size, _ in records) > self.max_size:
+                self._evict(records, keep=key)
+
+    def _evict(self, records, keep: str):
+        total = sum(size for _, size, _ in records)
+        survivors = []
+        for name, size, atime in sorted(records, key=lambda r: r[2]):
+            if name == keep or total <= self.max_size * self.LOW_WATERMARK:
+                survivors.append((name, size, atime))
+                continue
+            path = os.path.join(self.root, name)
+            # Groups go first so that readers never see a partial group.
+            for entry in os.scandir(path) if os.path.isdir(path) else []:
+                if entry.name.startswith("__grp__"):
+                    os.remove(entry.path)
+            shutil.rmtree(path, ignore_errors=True)
+            total -= size
+        tmp_path = f"{self.path}.tmp.pid_{os.getpid()}_{random.randint(0, 1000000)}"
+        with open(tmp_path, "wb") as f:
+            for name, size, atime in survivors:
+                f.write(self.RECORD.pack(name.encode(), size, atime))
+        os.replace(tmp_path, self.path)
+        self._refresh()
+
+
+__cache_indices: Dict[str, _CacheIndex] = {}
+
+
+def _cache_index(root: str) -> Optional[_CacheIndex]:
+    max_size = _parse_size(os.environ.get("TRITON_CACHE_MAX_SIZE", "0"))
+    if max_size <= 0:
+        return None
+    if root not in __cache_indices:
+        os.makedirs(root, exist_ok=True)
+        __cache_indices[root] = _CacheIndex(root, max_size)
+    return __cache_indices[root]
+
+
+class RemoteCacheBackend(ABC):
+    """
+    A key/value store shared by many processes (and hosts), used as the
+    second tier of `RemoteCacheManager`. Implementations should treat any
+    failure as a miss: a cache error must never fail a compilation.
+    """
+
+    def __init__(self, key: str):
+        pass
+
+    @abstractmethod
+    def get(self, filename: str) -> Optional[bytes]:
+        pass
+
+    @abstractmethod
+    def put(self, filename: str, data: bytes):
+        pass
+
+
+class HTTPRemoteCacheBackend(RemoteCacheBackend):
+    """
+    Stores blobs at `$TRITON_REMOTE_CACHE_URL/<key>/<filename>` using plain
+    HTTP GET and PUT requests, which is enough to talk to most object stores
+    (or a presigning proxy in front of them).
+    """
+
+    def __init__(self, key: str):
+        self.url = os.environ["TRITON_REMOTE_CACHE_URL"].rstrip("/") + "/" + key
+        self.timeout = float(os.environ.get("TRITON_REMOTE_CACHE_TIMEOUT", "10"))
+
+    def get(self, filename: str) -> Optional[bytes]:
+        try:
+            with urllib.request.urlopen(f"{self.url}/{filename}", timeout=self.timeout) as response:
+                return response.read()
+        except (urllib.error.URLError, OSError):
+            return None
+
+    def put(self, filename: str, data: bytes):
+        request = urllib.request.Request(f"{self.url}/{filename}", data=data, method="PUT")
+        try:
+            urllib.request.urlopen(request, timeout=self.timeout).close()
+        except (urllib.error.URLError, OSError):
+            pass
+
+
+class RemoteCacheManager(CacheManager):
+    """
+    Two-tier cache: a local `FileCacheManager` in front of a shared
+    `RemoteCacheBackend` (HTTP by default, or `module:Class` from
+    `TRITON_REMOTE_CACHE_BACKEND`). Enable with
+    `TRITON_CACHE_MANAGER=triton.runtime.cache:RemoteCacheManager`.
+
+    Groups are uploaded as a single bundle containing every member file, so
+    that readers on other hosts either see a complete group or nothing at
+    all; files that are never part of a group stay local.
+    """
+
+    def __init__(self, key, override=False, dump=False):
+        self.local = FileCacheManager(key, override=override, dump=dump)
+        # overrides and dumps are per-host debugging aids
+        self.backend = None if override or dump else _remote_backend_cls()(key)
+
+    def get_file(self, filename) -> Optional[str]:
+        return self.local.get_file(filename)
+
+    def has_file(self, filename) -> bool:
+        return self.local.has_file(filename)
+
+    def put(self, data, filename, binary=True) -> str:
+        return self.local.put(data, filename, binary=binary)
+
+    def get_group(self, filename: str) -> Optional[Dict[str, str]]:
+        group = self.local.get_group(filename)
+        if group is not None or self.backend is None:
+            return group
+        bundle = self.backend.get(f"__grp__{filename}")
+        if bundle is None:
+            return None
+        try:
+            files = json.loads(bundle)
+            group = {name: self.local.put(base64.b64decode(data), name) for name, data in files.items()}
+        except (ValueError, TypeError):
+            return None
+        self.local.put_group(filename, group)
+        return group
+
+    def put_group(self, filename: str, group: Dict[str, str]) -> str:
+        path = self.local.put_group(filename, group)
+        if self.backend is not None:
+            files = {}
+            for name, child_path in group.items():
+                with open(child_path, "rb") as f:
+                    files[name] = base64.b64encode(f.read()).decode("ascii")
+            self.backend.put(f"__grp__{filename}", json.dumps(files).encode("utf-8"))
+        return path
+
+
+__remote_backend_cls = None
+
+
+def _remote_backend_cls():
+    global __remote_backend_cls
+    if __remote_backend_cls is None:
+        user_backend = os.environ.get("TRITON_REMOTE_CACHE_BACKEND", None)
+        if user_backend is None:
+            __remote_backend_cls = HTTPRemoteCacheBackend
+        else:
+            import importlib
+            module_path, clz_nme = user_backend.split(":")
+            __remote_backend_cls = getattr(importlib.import_module(module_path), clz_nme)
+    return __remote_backend_cls
+
+
 __cache_cls = FileCacheManager
 __cache_cls_nme = "DEFAULT"
 
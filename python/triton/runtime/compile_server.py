@@ -0,0 +1,224 @@
+"""
+Local compile server.
+
+Processes on the same node (e.g. data-parallel ranks) tend to compile the
+same kernels at the same time on their first step. A compile server lets them
+share that work: clients lower their kernels to Triton IR and send it over a
+Unix socket, and the server runs the rest of the pipeline once per cache key,
+however many clients ask for it, on a pool of worker processes that keep
+their MLIR contexts (with all dialects loaded) from one kernel to the next:
+
+    python -m triton.runtime.compile_server /tmp/triton.sock --workers 8
+    TRITON_COMPILE_SERVER=/tmp/triton.sock torchrun train.py
+
+Results are written to the server's cache, where clients load them from, so
+the server and its clients must use the same `TRITON_CACHE_DIR` (or cache
+manager) and the same Triton install. Clients compile locally whenever the
+server can't be reached or fails to compile a kernel.
+"""
+
+from __future__ import annotations
+
+import json
+import os
+import signal
+import socket
+import socketserver
+import sys
+import tempfile
+import threading
+import warnings
+from concurrent.futures import ProcessPoolExecutor
+
+_warned = set()
+
+
+def server_path():
+    return os.environ.get("TRITON_COMPILE_SERVER") or None
+
+
+def _warn_once(path, message):
+    if path not in _warned:
+        _warned.add(path)
+        warnings.warn(f"compile server at {path}: {message}; compiling locally")
+
+
+#######################
+# Client
+#######################
+
+
+def request(path, src, backend, target, options, metadata, fn_cache_manager):
+    """
+    Asks the server at `path` to compile `src` into `fn_cache_manager`, and
+    returns the resulting metadata group, or None if the caller should compile
+    the kernel itself.
+    """
+    from .._C.libtriton import get_env_vars, ir
+    from ..compiler.compiler import triton_key
+    context = ir.context()
+    ir.load_dialects(context)
+    backend.load_dialects(context)
+    module = src.make_ir(options, context)
+    env = {name: os.environ.get(name) for name in get_env_vars()}
+    message = {
+        "triton_key": triton_key(), "key": metadata["hash"], "name": src.name, "ext": src.ext, "ir": module.str(),
+        "target": list(target), "options": options.__dict__, "metadata": metadata, "env": env
+    }
+    try:
+        with socket.socket(socket.AF_UNIX, socket.SOCK_STREAM) as sock:
+            sock.connect(path)
+            sock.sendall(json.dumps(message).encode() + b"\n")
+            reply = json.loads(sock.makefile("rb").readline() or b"{}")
+    except (OSError, ValueError) as e:
+        _warn_once(path, str(e))
+        return None
+    if "error" in reply:
+        # let the local compilation report the error the usual way
+        return None
+    return fn_cache_manager.get_group(f"{src.name}.json")
+
+
+#######################
+# Workers
+#######################
+
+_contexts = dict()
+
+
+def _init_worker():
+    from .._C.libtriton import ir
+    context = ir.context()
+    ir.load_dialects(context)
+    _contexts[None] = context
+
+
+def _context(backend):
+    # one context per backend, so that its dialects are only loaded once
+    name = type(backend).__name__
+    if name not in _contexts:
+        context = _contexts.pop(None)
+        backend.load_dialects(context)
+        _contexts[name] = context
+        _init_worker()
+    return _contexts[name]
+
+
+def _compile(message):
+    from .._C.libtriton import ir
+    from ..compiler.compiler import make_backend
+    from .cache import get_cache_manager
+    # the environment variables that change the output of the compiler
+    for name, value in message["env"].items():
+        if value is None:
+            os.environ.pop(name, None)
+        else:
+            os.environ[name] = value
+    target = tuple(message["target"])
+    backend = make_backend(target)
+    # JSON turned the tuples of the options into lists
+    options = {k: tuple(v) if isinstance(v, list) else v for k, v in message["options"].items()}
+    options = backend.parse_options(options)
+    name = message["name"]
+    metadata_filename = f"{name}.json"
+    fn_cache_manager = get_cache_manager(message["key"])
+    if fn_cache_manager.get_group(metadata_filename) is not None:
+        return
+    context = _context(backend)
+    with tempfile.NamedTemporaryFile("w", suffix=f".{message['ext']}") as f:
+        f.write(message["ir"])
+        f.flush()
+        module = ir.parse_mlir_module(f.name, context, keep_locations=True)
+    module.context = context
+    metadata = dict(message["metadata"], target=target)
+    stages = dict()
+    backend.add_stages(stages, options)
+    metadata_group = dict()
+    for ext, compile_ir in list(stages.items())[list(stages).index(message["ext"]):]:
+        module = compile_ir(module, metadata)
+        ir_filename = f"{name}.{ext}"
+        metadata_group[ir_filename] = fn_cache_manager.put(module, ir_filename)
+    metadata_group[metadata_filename] = fn_cache_manager.put(json.dumps(metadata, default=vars), metadata_filename,
+                                                             binary=False)
+    fn_cache_manager.put_group(metadata_filename, metadata_group)
+
+
+#######################
+# Server
+#######################
+
+
+class CompileServer(socketserver.ThreadingMixIn, socketserver.UnixStreamServer):
+    """
+    Serves compilation requests on the Unix socket at `path`. Requests for a
+    cache key that is already being compiled wait for that compilation rather
+    than starting another one.
+    """
+
+    daemon_threads = True
+
+    def __init__(self, path, workers=None):
+        import multiprocessing
+        from ..compiler.compiler import triton_key
+        self.triton_key = triton_key()
+        self.pool = ProcessPoolExecutor(workers, mp_context=multiprocessing.get_context("spawn"),
+                                        initializer=_init_worker)
+        self.lock = threading.Lock()
+        self.in_flight = dict()
+        if os.path.exists(path):
+            os.unlink(path)
+        super().__init__(path, _Handler)
+        # only the user running the server can submit kernels
+        os.chmod(path, 0o600)
+
+    def submit(self, message):
+        key = message["key"]
+        with self.lock:
+            future = self.in_flight.get(key)
+            if future is None:
+                future = self.pool.submit(_compile, message)
+                self.in_flight[key] = future
+                future.add_done_callback(lambda _: self._done(key))
+        return future
+
+    def _done(self, key):
+        # later requests find the kernel in the cache
+        with self.lock:
+            self.in_flight.pop(key, None)
+
+    def server_close(self):
+        super().server_close()
+        self.pool.shutdown()
+        if os.path.exists(self.server_address):
+            os.unlink(self.server_address)
+
+
+class _Handler(socketserver.StreamRequestHandler):
+
+    def handle(self):
+        try:
+            message = json.loads(self.rfile.readline())
+            if message["triton_key"] != self.server.triton_key:
+                raise RuntimeError("the client and the server run different versions of Triton")
+            self.server.submit(message).result()
+            reply = {"ok": True}
+        except Exception as e:
+            reply = {"error": f"{type(e).__name__}: {e}"}
+        self.wfile.write(json.dumps(reply).encode() + b"\n")
+
+
+if __name__ == "__main__":
+    from argparse import ArgumentParser
+
+    parser = ArgumentParser(description="Compile Triton kernels for the processes of this node")
+    parser.add_argument("path", type=str, help="Path of the Unix socket to listen on")
+    parser.add_argument("--workers", "-j", type=int, default=None,
+                        help="Number of worker processes (defaults to the number of CPUs)")
+    args = parser.parse_args()
+    # clean up the socket when terminated too
+    signal.signal(signal.SIGTERM, lambda *_: sys.exit(0))
+    with CompileServer(args.path, args.workers) as server:
+        try:
+            server.serve_forever()
+        except KeyboardInterrupt:
+            pass
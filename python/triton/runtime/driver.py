@@ -3,6 +3,9 @@ from ..backends import backends
 
 def _create_driver():
     actives = [x.driver for x in backends.values() if x.driver.is_active()]
+    # drivers only active on request, e.g. the CPU one, take over the others
+    opted_in = [x for x in actives if getattr(x, "opt_in", False)]
+    actives = opted_in or actives
     if len(actives) != 1:
         raise RuntimeError(f"{len(actives)} active drivers ({actives}). There should only be one.")
     return actives[0]()
@@ -0,0 +1,88 @@
+import contextlib
+import threading
+from collections import namedtuple
+
+from .driver import driver
+
+# A launch recorded by `fused_launches`: the JITFunction and the cache key of
+# its specialization (see `JITFunction.run`), its ASTSource, the options, the
+# 3D grid, the stream and the non-constexpr arguments.
+Launch = namedtuple("Launch", ["key", "source", "options", "grid", "stream", "args"])
+
+_local = threading.local()
+
+# The fused kernels, by device and by the keys of the specializations they fuse
+_fused_kernels = dict()
+
+
+def recording():
+    """
+    Returns the list the launches of the current thread are recorded in by
+    `fused_launches`, or None outside of a `fused_launches` block.
+    """
+    return getattr(_local, "launches", None)
+
+
+@contextlib.contextmanager
+def fused_launches():
+    """
+    Fuses the launches of `@triton.jit` kernels made in the `with` block into
+    a single kernel, launched on a 1D grid of all their programs when the
+    block exits, e.g. for the small kernels of a layer that each leave most
+    SMs idle:
+
+        with triton.fused_launches():
+            rms_norm[(num_heads, )](q, q_weight, HEAD_DIM=128)
+            rms_norm[(num_heads, )](k, k_weight, HEAD_DIM=128)
+            add[(triton.cdiv(n, 1024), )](x, y, out, n, BLOCK=1024)
+
+    Each program runs the kernel whose range of programs holds it, with the
+    program ids and the number of programs of its own grid, so the kernels
+    are written as usual. Their programs run in any order, so the kernels
+    must be independent, and they can't call `noinline` functions. The fused
+    kernel is compiled once per sequence of specializations, with their
+    options, which must be the same: they all run with the same `num_warps`.
+
+    The launches in the block return None. Their hooks, e.g. the `pre_hook`
+    of autotuning configs, run when they are recorded, and autotuned kernels
+    must already have a config for their key. Nothing is launched if the
+    block raises.
+    """
+    if recording() is not None:
+        raise RuntimeError("fused_launches blocks can't be nested")
+    launches = _local.launches = []
+    try:
+        yield
+    finally:
+        _local.launches = None
+    _launch(launches)
+
+
+def _launch(launches):
+    if not launches:
+        return
+    from ..compiler import FusedSource, compile
+    from .jit import JITFunction
+    options, stream = launches[0].options, launches[0].stream
+    if any(launch.options != options for launch in launches):
+        raise ValueError("fused launches must have the same options")
+    if any(launch.stream != stream for launch in launches):
+        raise ValueError("fused launches must be on the same stream")
+    if getattr(options, "split_k", 1) != 1:
+        raise ValueError("split-K kernels can't be fused")
+    if getattr(options, "persistent", False):
+        raise ValueError("persistent kernels can't be fused")
+    device = driver.get_current_device()
+    key = tuple(launch.key for launch in launches)
+    kernels = _fused_kernels.setdefault(device, dict())
+    kernel = kernels.get(key)
+    if kernel is None:
+        src = FusedSource([launch.source for launch in launches])
+        kernel = kernels[key] = compile(src, target=driver.get_current_target(), options=options.__dict__)
+    args = [arg for launch in launches for arg in launch.args]
+    num_programs = 0
+    for launch in launches:
+        args.extend(launch.grid)
+        num_programs += launch.grid[0] * launch.grid[1] * launch.grid[2]
+    if num_programs > 0:
+        JITFunction._launch(kernel, (num_programs, 1, 1), stream, args)
@@ -1,4 +1,8 @@
 import inspect
+import itertools
+import os
+import threading
+from concurrent.futures import ThreadPoolExecutor
 
 import numpy as np
 
@@ -90,21 +94,31 @@ class Builder:
 
     def __init__(self) -> None:
         self.arch = None
-        # pass
+        # program instances may run in several threads at once
+        self._local = threading.local()
+
+    @property
+    def grid_idx(self):
+        return getattr(self._local, "grid_idx", None)
+
+    @property
+    def grid_dim(self):
+        return getattr(self._local, "grid_dim", None)
 
     def set_grid_idx(self, x, y, z):
         assert x < self.grid_dim[0]
         assert y < self.grid_dim[1]
         assert z < self.grid_dim[2]
-        self.grid_idx = (x, y, z)
+        self._local.grid_idx = (x, y, z)
 
     def set_grid_dim(self, nx, ny, nz):
-        self.grid_dim = (nx, ny, nz)
+        self._local.grid_dim = (nx, ny, nz)
 
     def np_dtype(self, tt_dtype):
         if isinstance(tt_dtype, tl.pointer_type):
             return np.dtype(np.uint64)
         np_types = {
+            tl.int1: np.dtype(np.bool_),
             tl.float16: np.dtype(np.float16),
             tl.float32: np.dtype(np.float32),
             tl.float64: np.dtype(np.float64),
@@ -135,6 +149,9 @@ class Builder:
     def get_block_ty(self, dtype, shape):
         return tl.tensor(shape, dtype)
 
+    def get_int1(self, value):
+        return TensorHandle(np.array([value], dtype=np.bool_), tl.int1)
+
     def get_int32(self, value):
         return TensorHandle(np.array([value], dtype=np.int32), tl.int32)
 
@@ -179,6 +196,9 @@ class Builder:
     def create_masked_store(self, ptrs, value, mask, cache_modifier, eviction_policy):
         return _interpreter.store(ptrs.data, value.data, mask.data)
 
+    def create_prefetch(self, ptrs, mask, eviction_policy):
+        pass
+
     # casting ops
     def cast_impl(self, src, dst_type):
         if isinstance(dst_type, tl.tensor):
@@ -314,11 +334,11 @@ class Builder:
     def create_splat(self, arg, shape):
         return TensorHandle(np.full(shape, arg.data[0], dtype=self.np_dtype(arg.dtype)), arg.dtype)
 
-    # def create_atomic_cas(self, ptr, cmp, val, sem):
-    #     pass
+    def create_atomic_cas(self, ptr, cmp, val, sem, scope):
+        return TensorHandle(_interpreter.atomic_cas(ptr.data, cmp.data, val.data), val.dtype)
 
-    # def create_atomic_rmw(self, rmwOp, ptr, val, mask, sem):
-    #     pass
+    def create_atomic_rmw(self, rmwOp, ptr, val, mask, sem, scope):
+        return TensorHandle(_interpreter.atomic_rmw(rmwOp.name, ptr.data, val.data, mask.data), val.dtype)
 
     # def create_extern_elementwise(self, libName, libPath, symbol, argList, retType, isPure):
     #     pass
@@ -335,6 +355,16 @@ class Builder:
     # def create_scan_ret(self, args):
     #     pass
 
+    def create_sort(self, arg, dim, descending):
+        data = arg.data
+        if arg.dtype.is_int():
+            # Sorts as signed integers like the compiled kernels
+            data = data.view(np.dtype(f"int{arg.dtype.primitive_bitwidth}"))
+        data = np.sort(data, axis=dim)
+        if descending:
+            data = np.flip(data, axis=dim)
+        return TensorHandle(np.ascontiguousarray(data).view(arg.data.dtype), arg.dtype)
+
     # def create_ptr_to_int(self, val, type):
     #     pass
 
@@ -503,12 +533,22 @@ class GridExecutor:
         grid = self.grid(args) if callable(self.grid) else self.grid
         assert len(grid) <= 3
         grid = grid + (1, ) * (3 - len(grid))
-        builder.set_grid_dim(*grid)
-        for x in range(grid[0]):
-            for y in range(grid[1]):
-                for z in range(grid[2]):
-                    builder.set_grid_idx(x, y, z)
-                    self.fn(**args)
+
+        def run_program(idx):
+            builder.set_grid_dim(*grid)
+            builder.set_grid_idx(*idx)
+            self.fn(**args)
+
+        program_ids = itertools.product(range(grid[0]), range(grid[1]), range(grid[2]))
+        # program instances are independent, except through atomics
+        num_threads = int(os.environ.get("TRITON_INTERPRET_THREADS", "1"))
+        if num_threads > 1:
+            with ThreadPoolExecutor(num_threads) as executor:
+                for _ in executor.map(run_program, program_ids):
+                    pass
+        else:
+            for idx in program_ids:
+                run_program(idx)
         # copy arguments back to propagate side-effects
         for arg_dev, arg_hst in zip(args_dev, args_hst):
             if hasattr(arg_dev, "data_ptr"):
@@ -4,10 +4,15 @@ import hashlib
 import inspect
 import os
 import textwrap
+import warnings
+import weakref
 from collections import defaultdict, namedtuple
 from functools import cached_property
 from typing import Callable, Generic, Iterable, List, Optional, TypeVar, Union, cast, overload
+from .._C.libtriton import dispatch as _dispatch
 from ..runtime.driver import driver
+from . import fusion as _fusion
+from . import manifest as _manifest
 
 TRITON_MODULE = __name__[:-len(".runtime.jit")]
 
@@ -97,6 +102,18 @@ class KernelParam:
     def is_constexpr(self):
         return "constexpr" in self.annotation
 
+    @cached_property
+    def dispatch_kind(self):
+        # Must match `ParamKind` in python/src/dispatch.cc and stay consistent
+        # with `KernelArg.signature_key`.
+        if "Tensor" in self.annotation:
+            return 1
+        if self.annotation == "bool":
+            return 2
+        if self.annotation == "float":
+            return 3
+        return 0
+
     @property
     def default(self):
         return self._param.default
@@ -161,9 +178,108 @@ class KernelInterface(Generic[T]):
         # return cast(T, functools.partial(cast(Callable, self.run), grid=grid))
 
 
+class PersistentGrid:
+    """
+    Grid of a persistent kernel, i.e. one whose programs loop over the work:
+
+        kernel[PersistentGrid(lambda META: triton.cdiv(M, META['BLOCK_M']))](...)
+
+    launches as many programs as can be resident on the current device at
+    once (see `CompiledKernel.max_resident_programs`), and at most
+    `num_programs`, which is either an int or, like a regular grid, a function
+    of the kernel's arguments.
+    """
+
+    def __init__(self, num_programs=None):
+        self.num_programs = num_programs
+
+    def resolve(self, kernel, named_args):
+        size = kernel.max_resident_programs()
+        limit = self.num_programs
+        if callable(limit):
+            limit = limit(named_args)
+        if limit is not None:
+            size = min(size, limit)
+        return (max(size, 1), )
+
+
+_async_executor = None
+
+
+def _async_compile_executor():
+    # shared by the kernels compiling in the background, with
+    # `TRITON_ASYNC_COMPILE_WORKERS` threads
+    global _async_executor
+    if _async_executor is None:
+        from concurrent.futures import ThreadPoolExecutor
+        max_workers = int(os.environ.get("TRITON_ASYNC_COMPILE_WORKERS", "0")) or None
+        _async_executor = ThreadPoolExecutor(max_workers=max_workers, thread_name_prefix="triton-compile")
+    return _async_executor
+
+
+class CompileStats:
+    """
+    Compilation counters of a `JITFunction`. `changes` counts, over all the
+    compilations but the first, the parts of the cache key that differed from
+    the previous compilation: `"signature:<arg>"` (a different type),
+    `"specialization:<arg>"` (e.g. an integer that stopped being divisible by
+    16), `"constexpr:<arg>"` or `"options"`.
+    """
+
+    def __init__(self):
+        self.compiles = 0
+        self.cache_hits = 0
+        self.changes = defaultdict(int)
+        self.last_key = None
+        self.warned = False
+
+    def record_compile(self, key, args):
+        self.compiles += 1
+        if self.last_key is not None:
+            for change in _key_changes(self.last_key, key, args):
+                self.changes[change] += 1
+        self.last_key = key
+
+    def as_dict(self):
+        return {"compiles": self.compiles, "cache_hits": self.cache_hits, "changes": dict(self.changes)}
+
+
+def _key_changes(old, new, args):
+    old_sig, old_constexprs, old_spec, old_options = old
+    sig, constexprs, spec, options = new
+    changes = []
+    names = [arg.param.name for arg in args if not arg.param.is_constexpr]
+    changes += [f"signature:{n}" for n, a, b in zip(names, old_sig, sig) if a != b]
+    names = [arg.param.name for arg in args if not arg.param.do_not_specialize]
+    changes += [f"specialization:{n}" for n, a, b in zip(names, old_spec, spec) if a != b]
+    names = [arg.param.name for arg in args if arg.param.is_constexpr]
+    changes += [f"constexpr:{n}" for n, a, b in zip(names, old_constexprs, constexprs) if a != b]
+    if old_options != options:
+        changes.append("options")
+    return changes
+
+
+def compile_stats(reset=False):
+    """
+    Returns the `CompileStats.as_dict()` of every live `JITFunction` that was
+    launched or warmed up, keyed by `module:name`.
+    """
+    ret = dict()
+    for fn in list(JITFunction._instances):
+        if fn.stats.compiles or fn.stats.cache_hits:
+            ret[f"{fn.module}:{fn.__name__}"] = fn.stats.as_dict()
+        if reset:
+            fn.stats = CompileStats()
+    return ret
+
+
 class JITFunction(KernelInterface[T]):
     # Hook for inspecting compiled functions and modules
     cache_hook = None
+    # Number of compilations of a single function after which a warning is
+    # issued, e.g. because an argument keeps changing specialization
+    recompile_budget = int(os.environ.get("TRITON_RECOMPILE_BUDGET", "0")) or None
+    _instances = weakref.WeakSet()
     divisibility = 16
     # As Hopper TMA load and store primitive requires the tensor stride to be 16-byte aligned.
     # And we only support WGMMA with float16 dtype on Hopper for now.
@@ -331,8 +447,77 @@ class JITFunction(KernelInterface[T]):
             already_compiled=False,
         )
 
+    @staticmethod
+    def _launch(kernel, grid, stream, args):
+        from ..compiler import CompiledKernel
+        # `kernel.run` loads the handles the config refers to
+        capsule = driver.direct_launch_capsule(kernel.run)
+        if capsule is not None:
+            config = kernel.direct_launch_config()
+            if config:
+                # the arguments of `kernel.run` are assembled natively
+                _dispatch.launch(capsule, grid, stream, config, CompiledKernel.launch_enter_hook,
+                                 CompiledKernel.launch_exit_hook, args)
+                return
+        grid_size = len(grid)
+        grid_0 = grid[0]
+        grid_1 = grid[1] if grid_size > 1 else 1
+        grid_2 = grid[2] if grid_size > 2 else 1
+        metadata = kernel.metadata
+        # split-K kernels share each reduction among `split_k` programs along the third dimension
+        grid_2 *= metadata.split_k
+        (grid_0, grid_1, grid_2), args = kernel.persistent_launch((grid_0, grid_1, grid_2), args)
+        kernel.run(grid_0, grid_1, grid_2, metadata.num_warps,
+                   metadata.num_ctas,  # number of warps/ctas per instance
+                   metadata.cluster_dims[0], metadata.cluster_dims[1], metadata.cluster_dims[2],  # cluster
+                   metadata.shared, stream, kernel.function, CompiledKernel.launch_enter_hook,
+                   CompiledKernel.launch_exit_hook, metadata,
+                   *driver.assemble_tensormap_to_arg(metadata.tensormaps_info, args))
+
+    def _run_cached(self, grid, args, kwargs):
+        """
+        Launches an already compiled specialization without going through the
+        Python argument binding and keying done by `run`. Returns None if the
+        kernel isn't in the cache (or the arguments need the slow path), in
+        which case nothing has been launched.
+        """
+        bound = _dispatch.bind_and_key(self._dispatch_params, self._dispatch_index, self._option_names, args, kwargs,
+                                       JITFunction.divisibility, JITFunction.divisibility_8)
+        if bound is None:
+            return None
+        values, sig_key, constexpr_key, spec_key, option_items, launch_args = bound
+        device = driver.get_current_device()
+        target = driver.get_current_target()
+        try:
+            options = self._options_cache.get((target, self.debug, option_items))
+        except TypeError:
+            # unhashable option values (e.g. `extern_libs` passed as a dict)
+            return None
+        if options is None:
+            return None
+        kernel = self.cache[device].get((sig_key, constexpr_key, spec_key, options))
+        if kernel is None:
+            return None
+        self.stats.cache_hits += 1
+        named_args = dict(zip(self.arg_names, values))
+        # like in `run`, a grid function may return a persistent grid
+        if callable(grid):
+            grid = grid(named_args)
+        if isinstance(grid, PersistentGrid):
+            grid = grid.resolve(kernel, named_args)
+        self._launch(kernel, grid, driver.get_current_stream(device), launch_args)
+        return kernel
+
     def run(self, *args, grid, warmup, **kwargs):
-        from ..compiler import CompiledKernel, compile, ASTSource, make_backend
+        from ..compiler import ASTSource, compile, make_backend
+        # fast path: kernels that are already compiled are bound, keyed and
+        # launched natively (see python/src/dispatch.cc)
+        # the launches of a `fused_launches` block are recorded instead
+        recording = None if warmup else _fusion.recording()
+        if recording is None and not warmup and self._option_names is not None:
+            kernel = self._run_cached(grid, args, kwargs)
+            if kernel is not None:
+                return kernel
         # deprecated arguments
         assert "device_type" not in kwargs, "device_type option is deprecated; current target will be used"
         assert "device" not in kwargs, "device option is deprecated; current device will be used"
@@ -342,8 +527,18 @@ class JITFunction(KernelInterface[T]):
         stream = driver.get_current_stream(device)
         target = driver.get_current_target()
         backend = make_backend(target)
+        call_args = args
+        user_kwargs = dict(kwargs)
         kwargs["debug"] = self.debug
         options = backend.parse_options(kwargs)
+        # remember how options were spelled so that the fast path can find
+        # them again without calling into the backend
+        self._option_names = frozenset(options.__dict__)
+        option_items = tuple((k, v) for k, v in user_kwargs.items() if k in self._option_names)
+        try:
+            self._options_cache[(target, self.debug, option_items)] = options
+        except TypeError:
+            pass
         # bind non-reserved keyword args and set defaults
         kwargs = {k: v for k, v in kwargs.items() if not k in options.__dict__}
         bound_args = self.signature.bind(*args, **kwargs)
@@ -356,59 +551,162 @@ class JITFunction(KernelInterface[T]):
             # TODO(jlebar): In the new launch API, pass the compiler flags as a
             # second parameter to `grid`.
             grid = grid(dict(bound_args.arguments))
-        grid_size = len(grid)
-        grid_0 = grid[0]
-        grid_1 = grid[1] if grid_size > 1 else 1
-        grid_2 = grid[2] if grid_size > 2 else 1
         # compute cache key
         args = [KernelArg(arg_value, param) for (_, arg_value), param in zip(bound_args.arguments.items(), self.params)]
         sig_key = tuple(arg.signature_key() for arg in args if not arg.param.is_constexpr)
         spec_key = tuple(arg.specialization_key() for arg in args if not arg.param.do_not_specialize)
         constexpr_key = tuple(arg.value for arg in args if arg.param.is_constexpr)
         key = (sig_key, constexpr_key, spec_key, options)
+        if recording is not None:
+            if isinstance(grid, PersistentGrid):
+                raise TypeError("persistent grids can't be fused")
+            signature, constants, configs = self._specialize(args)
+            grid = tuple(grid) + (1, ) * (3 - len(grid))
+            recording.append(
+                _fusion.Launch((self, key), ASTSource(self, signature, constants, configs[0]), options, grid, stream,
+                               [arg.value for arg in args if not arg.param.is_constexpr]))
+            return None
+        self._device_targets[device] = target
+        # Kernel was compiled for another device with the same target; only
+        # its driver handles are per device (and are loaded on first use).
+        if key not in self.cache[device]:
+            for other, kernels in self.cache.items():
+                if other != device and self._device_targets.get(other) == target and key in kernels:
+                    self.cache[device][key] = kernels[key].clone()
+                    break
         # Kernel is not cached; we have to compile.
         if key not in self.cache[device]:
-            configs = (self._get_config(*[arg.value for arg in args]), )
-            constants = {
-                arg.param.num: arg.value
-                for arg in args
-                if arg.param.is_constexpr or arg.param.num in configs[0].equal_to_1 or arg.value is None
-            }
-            for i, arg in constants.items():
-                if callable(arg):
-                    raise TypeError(f"Callable constexpr at index {i} is not supported")
-
-            # Build kernel signature -- doesn't include constexpr arguments.
-            signature = {
-                arg.param.num: self._type_of(self._key_of(arg.value))
-                for arg in args
-                if not arg.param.is_constexpr
-            }
-
+            signature, constants, configs = self._specialize(args)
             if self._call_hook(key, signature, device, constants, options.num_warps, options.num_ctas,
                                options.num_stages, options.enable_warp_specialization, options.enable_fp_fusion,
                                options.extern_libs, configs):
                 return None
             # compile the kernel
             src = ASTSource(self, signature, constants, configs[0])
-            self.cache[device][key] = compile(
-                src,
-                target=target,
-                options=options.__dict__,
-            )
+            if self.async_fallback is not None and not warmup:
+                kernel, submitted = self._compile_async(device, key, src, target, options)
+                if submitted:
+                    if _manifest.recording():
+                        _manifest.record_jit(self, args, option_items)
+                    self._record_compile(key, args)
+                if kernel is None:
+                    return self._run_fallback(device, target, options, call_args, user_kwargs, args, grid, stream,
+                                              bound_args)
+            else:
+                self.cache[device][key] = compile(
+                    src,
+                    target=target,
+                    options=options.__dict__,
+                )
+                if _manifest.recording():
+                    _manifest.record_jit(self, args, option_items)
+                self._record_compile(key, args)
+        else:
+            self.stats.cache_hits += 1
 
         kernel = self.cache[device][key]
         if not warmup:
-            args = [arg.value for arg in args if not arg.param.is_constexpr]
-            metadata = kernel.metadata
-            kernel.run(grid_0, grid_1, grid_2, metadata.num_warps,
-                       metadata.num_ctas,  # number of warps/ctas per instance
-                       metadata.cluster_dims[0], metadata.cluster_dims[1], metadata.cluster_dims[2],  # cluster
-                       metadata.shared, stream, kernel.function, CompiledKernel.launch_enter_hook,
-                       CompiledKernel.launch_exit_hook, metadata,
-                       *driver.assemble_tensormap_to_arg(metadata.tensormaps_info, args))
+            if isinstance(grid, PersistentGrid):
+                grid = grid.resolve(kernel, dict(bound_args.arguments))
+            self._launch(kernel, grid, stream, [arg.value for arg in args if not arg.param.is_constexpr])
         return kernel
 
+    def _specialize(self, args):
+        # the signature, constants and configs `ASTSource` compiles for `args`
+        configs = (self._get_config(*[arg.value for arg in args]), )
+        constants = {
+            arg.param.num: arg.value
+            for arg in args
+            if arg.param.is_constexpr or arg.param.num in configs[0].equal_to_1 or arg.value is None
+        }
+        for i, arg in constants.items():
+            if callable(arg):
+                raise TypeError(f"Callable constexpr at index {i} is not supported")
+
+        # Build kernel signature -- doesn't include constexpr arguments.
+        signature = {arg.param.num: self._type_of(self._key_of(arg.value)) for arg in args if not arg.param.is_constexpr}
+        return signature, constants, configs
+
+    def set_async_compile(self, fallback="generic"):
+        """
+        Makes the launches that miss the cache compile the kernel in the
+        background instead of blocking, and run `fallback` meanwhile; the
+        kernel is launched by the first call after its compilation finished.
+        The errors of the compilation are raised by that call.
+
+        :param fallback: `"generic"` launches the specialization of the kernel
+            without divisibility and equal-to-1 hints, which is compiled once
+            per signature and constexpr values (in the calling thread), or a
+            callable, which is called with the arguments of the launch and the
+            grid, `fallback(*args, grid=grid, **kwargs)`. None compiles in the
+            calling thread again.
+        """
+        if fallback is not None and fallback != "generic" and not callable(fallback):
+            raise ValueError(f"fallback must be 'generic', a callable or None, got {fallback!r}")
+        self.async_fallback = fallback
+
+    def _compile_async(self, device, key, src, target, options):
+        """
+        Returns the kernel of `key` once its background compilation finished,
+        or None, and whether the compilation was submitted by this call.
+        """
+        future = self._pending.get((device, key))
+        if future is None:
+            from ..backends.compiler import compile_budget, current_compile_budget
+            from ..compiler import compile
+            budget = current_compile_budget()
+
+            def compile_in_background():
+                # the budget is per thread
+                with compile_budget(budget):
+                    return compile(src, target=target, options=options.__dict__)
+
+            self._pending[(device, key)] = _async_compile_executor().submit(compile_in_background)
+            return None, True
+        if not future.done():
+            return None, False
+        del self._pending[(device, key)]
+        self.cache[device][key] = future.result()
+        return self.cache[device][key], False
+
+    def _run_fallback(self, device, target, options, call_args, call_kwargs, args, grid, stream, bound_args):
+        fallback = self.async_fallback
+        if callable(fallback):
+            return fallback(*call_args, grid=grid, **call_kwargs)
+        from ..compiler import ASTSource, AttrsDescriptor, compile
+        sig_key = tuple(arg.signature_key() for arg in args if not arg.param.is_constexpr)
+        constexpr_key = tuple(arg.value for arg in args if arg.param.is_constexpr)
+        # no specialization on the values of the arguments but None
+        spec_key = tuple(arg.value is None for arg in args)
+        key = (sig_key, constexpr_key, ("generic", spec_key), options)
+        if key not in self.cache[device]:
+            none_args = tuple(arg.param.num for arg in args if arg.value is None and not arg.param.do_not_specialize)
+            config = AttrsDescriptor((), (), none_args, ())
+            constants = {arg.param.num: arg.value for arg in args if arg.param.is_constexpr or arg.value is None}
+            signature = {
+                arg.param.num: self._type_of(self._key_of(arg.value))
+                for arg in args
+                if not arg.param.is_constexpr
+            }
+            src = ASTSource(self, signature, constants, config)
+            self.cache[device][key] = compile(src, target=target, options=options.__dict__)
+        kernel = self.cache[device][key]
+        if isinstance(grid, PersistentGrid):
+            grid = grid.resolve(kernel, dict(bound_args.arguments))
+        self._launch(kernel, grid, stream, [arg.value for arg in args if not arg.param.is_constexpr])
+        return kernel
+
+    def _record_compile(self, key, args):
+        stats = self.stats
+        stats.record_compile(key, args)
+        budget = JITFunction.recompile_budget
+        if budget is not None and stats.compiles > budget and not stats.warned:
+            stats.warned = True
+            changes = sorted(stats.changes.items(), key=lambda item: -item[1])
+            summary = ", ".join(f"{change} ({count}x)" for change, count in changes[:5])
+            warnings.warn(f"{self} was compiled {stats.compiles} times (budget: {budget}); "
+                          f"most frequent key changes: {summary or 'none'}")
+
     def __init__(self, fn, version=None, do_not_specialize=None, debug=None, noinline=None):
         do_not_specialize = do_not_specialize if do_not_specialize else []
 
@@ -429,6 +727,22 @@ class JITFunction(KernelInterface[T]):
         self.src = self.src[self.src.find("def"):]
         # cache of just-in-time compiled kernels
         self.cache = defaultdict(dict)
+        # target of each device in `cache`, so that devices of the same
+        # architecture can share compiled kernels
+        self._device_targets = dict()
+        # state of the native launch fast path: parameter descriptions in the
+        # layout expected by `dispatch.bind_and_key`, and the options objects
+        # previously returned by the backend for a given set of keyword args
+        self._dispatch_params = tuple((p.dispatch_kind, p.is_constexpr, bool(p.do_not_specialize), p.has_default,
+                                       p.default) for p in self.params)
+        self._dispatch_index = {p.name: p.num for p in self.params}
+        self._option_names = None
+        self._options_cache = {}
+        self.stats = CompileStats()
+        # background compilation, see `set_async_compile`
+        self.async_fallback = None
+        self._pending = {}
+        JITFunction._instances.add(self)
         self.hash = None
         # JITFunction can be instantiated as kernel
         # when called with a grid using __getitem__
@@ -463,21 +777,26 @@ class JITFunction(KernelInterface[T]):
     # the user might want to monkey-patch self.src dynamically.
     # Our unit tests do this, for example.
     def parse(self):
-        tree = ast.parse(self.src)
-        assert isinstance(tree, ast.Module)
-        assert len(tree.body) == 1
-        assert isinstance(tree.body[0], ast.FunctionDef)
-        return tree
+        # the visitors of the tree do not modify it, so it is parsed once per
+        # `src`, instead of once per specialization and call site
+        if self._ast is None:
+            tree = ast.parse(self.src)
+            assert isinstance(tree, ast.Module)
+            assert len(tree.body) == 1
+            assert isinstance(tree.body[0], ast.FunctionDef)
+            self._ast = tree
+        return self._ast
 
     def __call__(self, *args, **kwargs):
         raise RuntimeError("Cannot call @triton.jit'd outside of the scope of a kernel")
 
     def __setattr__(self, name, value):
         super(JITFunction, self).__setattr__(name, value)
-        # - when `.src` attribute is set, cache path needs
-        #   to be reinitialized
+        # - when `.src` attribute is set, cache path and
+        #   parsed tree need to be reinitialized
         if name == "src":
             self.hash = None
+            self._ast = None
 
     def __repr__(self):
         return f"JITFunction({self.module}:{self.fn.__name__})"
@@ -0,0 +1,234 @@
+"""
+Warm-up manifests.
+
+A manifest lists the kernel specializations a process compiled, one JSON
+object per line, so that a later process can compile (or load from the cache)
+exactly those kernels before it serves its first request:
+
+    # while running a representative workload
+    TRITON_RECORD_MANIFEST=/path/to/manifest.jsonl python serve.py
+
+    # at startup
+    triton.runtime.manifest.replay("/path/to/manifest.jsonl")
+
+Kernels are looked up by the module and name they are defined under, so only
+kernels defined at module scope can be replayed.
+"""
+
+from __future__ import annotations
+
+import contextlib
+import importlib
+import json
+import os
+import threading
+import warnings
+from concurrent.futures import ThreadPoolExecutor
+
+from .driver import driver
+
+_record_path = os.environ.get("TRITON_RECORD_MANIFEST") or None
+_write_lock = threading.Lock()
+_local = threading.local()
+
+
+def record(path):
+    """
+    Appends the specializations compiled from now on to the manifest at `path`
+    (`None` stops recording). Same as setting `TRITON_RECORD_MANIFEST`.
+    """
+    global _record_path
+    _record_path = path
+
+
+def recording():
+    return _record_path is not None
+
+
+@contextlib.contextmanager
+def capture():
+    """
+    Collects the entries recorded by the current thread instead of writing
+    them, e.g. while the autotuner compiles configs it won't end up using.
+    """
+    entries = []
+    previous = getattr(_local, "entries", None)
+    _local.entries = entries
+    try:
+        yield entries
+    finally:
+        _local.entries = previous
+
+
+def write_entry(entry):
+    if _record_path is None:
+        return
+    entries = getattr(_local, "entries", None)
+    if entries is not None:
+        entries.append(entry)
+        return
+    line = json.dumps(entry) + "\n"
+    with _write_lock, open(_record_path, "a") as f:
+        f.write(line)
+
+
+def _qualified_name(fn):
+    fn = _unwrap(fn)
+    return f"{fn.module}:{fn.__name__}"
+
+
+def _encode_arg(arg):
+    value = arg.value
+    if arg.param.is_constexpr:
+        if value is None or isinstance(value, (bool, int, float, str)):
+            return {"constexpr": value}
+        return None
+    encoded = {}
+    if hasattr(value, "data_ptr"):
+        dtype = str(value.dtype)
+        if not dtype.startswith("torch."):
+            return None
+        encoded["tensor"] = dtype[len("torch."):]
+    else:
+        encoded["sig"] = arg.signature_key()
+    if not arg.param.do_not_specialize:
+        encoded["spec"] = list(arg.specialization_key())
+    return encoded
+
+
+def jit_entry(fn, args, option_items):
+    """
+    Describes the specialization of `fn` for the bound `KernelArg`s `args`, or
+    returns None if it can't be reproduced from a manifest.
+    """
+    encoded = [_encode_arg(arg) for arg in args]
+    if any(e is None for e in encoded):
+        return None
+    entry = {"kind": "jit", "fn": _qualified_name(fn), "args": encoded, "options": dict(option_items)}
+    try:
+        json.dumps(entry)
+    except (TypeError, ValueError):
+        return None
+    return entry
+
+
+def record_jit(fn, args, option_items):
+    entry = jit_entry(fn, args, option_items)
+    if entry is not None:
+        write_entry(entry)
+
+
+def record_autotune(fn, key, config, kernels):
+    """
+    Records that the autotuner `fn` picked `config` for the tuning `key`,
+    along with the `kernels` entries captured while compiling that config.
+    """
+    entry = {
+        "kind": "autotune", "fn": _qualified_name(fn), "key": list(key), "config": str(config), "kernels": kernels
+    }
+    try:
+        json.dumps(entry)
+    except (TypeError, ValueError):
+        return
+    write_entry(entry)
+
+
+def _resolve(name):
+    module, _, attr = name.partition(":")
+    return getattr(importlib.import_module(module), attr)
+
+
+def _unwrap(fn):
+    from .jit import JITFunction
+    while not isinstance(fn, JITFunction):
+        fn = fn.fn
+    return fn
+
+
+def _int_value(sig, spec):
+    # any value with the same signature and specialization keys will do
+    if spec is not None and spec[2]:
+        return 1
+    base = {"i32": 0, "i64": 1 << 40, "u64": 1 << 63}[sig]
+    if spec is None:
+        return base + 3
+    if spec[0]:
+        return base + 16
+    if spec[1]:
+        return base + 8
+    return base + 3
+
+
+def _decode_arg(encoded):
+    from .jit import MockTensor
+    if "constexpr" in encoded:
+        return encoded["constexpr"]
+    spec = encoded.get("spec")
+    if "tensor" in encoded:
+        import torch
+        tensor = MockTensor(getattr(torch, encoded["tensor"]))
+        # instance attribute shadows the (always aligned) static method
+        ptr = 16 if spec is None or spec[0] else 1
+        tensor.data_ptr = lambda: ptr
+        return tensor
+    sig = encoded["sig"]
+    if sig is None:
+        return None
+    if sig == "i1":
+        return bool(spec is not None and spec[2])
+    if sig == "fp32":
+        return 0.5
+    return _int_value(sig, spec)
+
+
+def _warm(entry, device):
+    driver.set_current_device(device)
+    fn = _unwrap(_resolve(entry["fn"]))
+    args = [_decode_arg(arg) for arg in entry["args"]]
+    kernel = fn.run(*args, grid=(1, ), warmup=True, **entry["options"])
+    if kernel is not None:
+        kernel._init_handles()
+    return kernel
+
+
+def replay(path, max_workers=None):
+    """
+    Compiles (or loads from the cache) the kernels listed in the manifest at
+    `path` for the current device, and restores the autotuning decisions it
+    records. Entries that can no longer be resolved are skipped with a warning.
+    Returns the number of kernels warmed up.
+    """
+    from .autotuner import Autotuner
+    entries = {}
+    with open(path) as f:
+        for line in f:
+            if line.strip():
+                entries.setdefault(line.strip(), json.loads(line))
+    kernels = {}
+    for entry in entries.values():
+        if entry["kind"] == "autotune":
+            try:
+                tuner = _resolve(entry["fn"])
+                while not isinstance(tuner, Autotuner):
+                    tuner = tuner.fn
+            except (ImportError, AttributeError) as e:
+                warnings.warn(f"skipping manifest entry for {entry['fn']}: {e}")
+                continue
+            config = next((c for c in tuner.configs if str(c) == entry["config"]), None)
+            if config is not None:
+                tuner.cache[tuple(entry["key"])] = config
+            for kernel in entry["kernels"]:
+                kernels.setdefault(json.dumps(kernel), kernel)
+        else:
+            kernels.setdefault(json.dumps(entry), entry)
+    device = driver.get_current_device()
+    warmed = 0
+    with ThreadPoolExecutor(max_workers=max_workers) as executor:
+        futures = {executor.submit(_warm, entry, device): entry for entry in kernels.values()}
+        for future, entry in futures.items():
+            try:
+                future.result()
+                warmed += 1
+            except (ImportError, AttributeError, KeyError) as e:
+                warnings.warn(f"skipping manifest entry for {entry['fn']}: {e}")
+    return warmed
@@ -0,0 +1,149 @@
+import threading
+
+from .driver import driver
+
+
+def _torch_allocator(nbytes, device, stream):
+    import torch
+    return torch.empty(nbytes, dtype=torch.uint8, device=torch.device("cuda", device))
+
+
+class WorkspacePool:
+    """
+    Device memory for the `Workspace` arguments of the kernels, one buffer per
+    device and stream. The launches of a stream run in order, so each reuses
+    the buffer of the previous one; the buffer only grows, to the next power
+    of two of the largest workspace requested on its stream.
+
+    The memory comes from the allocator, `fn(nbytes, device, stream)`, which
+    returns an object with a `data_ptr()` method that owns the memory until it
+    is garbage collected, e.g. a tensor of the caching allocator of a
+    framework. By default it is a `torch.empty` uint8 tensor.
+    """
+
+    def __init__(self, allocator=None):
+        self.allocator = allocator or _torch_allocator
+        self.buffers = {}
+        self.lock = threading.Lock()
+
+    def get(self, nbytes, device, stream):
+        """
+        Returns a buffer of at least `nbytes` bytes for `stream`, and its size.
+        """
+        with self.lock:
+            buffer, size = self.buffers.get((device, stream), (None, 0))
+            if size < nbytes:
+                size = 1 << max(nbytes - 1, 255).bit_length()
+                # workspaces still in use hold on to the previous buffer
+                buffer = self.allocator(size, device, stream)
+                self.buffers[(device, stream)] = (buffer, size)
+            return buffer, size
+
+    def clear(self):
+        """
+        Releases the buffers, e.g. after a peak in the workspaces requested.
+        """
+        with self.lock:
+            self.buffers.clear()
+
+
+workspace_pool = WorkspacePool()
+
+
+def set_workspace_allocator(allocator):
+    """
+    Makes the workspaces come from `allocator(nbytes, device, stream)` (see
+    `WorkspacePool`), or from the default allocator if it's None. The buffers
+    of the previous allocator are released.
+    """
+    workspace_pool.allocator = allocator or _torch_allocator
+    workspace_pool.clear()
+
+
+_zero_kernel = None
+
+
+def _zero(ptr, nbytes):
+    global _zero_kernel
+    if _zero_kernel is None:
+        from .jit import jit
+        from .. import language as tl
+
+        @jit
+        def zero(ptr, nbytes, BLOCK: tl.constexpr):
+            offsets = tl.program_id(0) * BLOCK + tl.arange(0, BLOCK)
+            tl.store(ptr + offsets, tl.zeros((BLOCK, ), tl.uint8), mask=offsets < nbytes)
+
+        _zero_kernel = zero
+    block = 4096
+    _zero_kernel[((nbytes + block - 1) // block, )](_Bytes(ptr), nbytes, BLOCK=block)
+
+
+class _Bytes:
+    # the memory of a workspace, as bytes
+
+    def __init__(self, ptr):
+        self.ptr = ptr
+
+    @property
+    def dtype(self):
+        import torch
+        return torch.uint8
+
+    def data_ptr(self):
+        return self.ptr
+
+
+class Workspace:
+    """
+    Global scratch memory of a launch, e.g. for the partial results of a
+    split-K kernel or the flags of a stream-K one, passed in place of a
+    pointer argument of `nbytes` bytes, to elements of `dtype` (a torch dtype,
+    uint8 by default):
+
+        kernel[grid](a, b, c, triton.Workspace(num_tiles * 4, torch.int32, zero=True))
+
+    The memory comes from `workspace_pool` when the launch binds the argument,
+    from the buffer of the current stream: it is only valid for the kernel
+    the workspace is passed to, and the workspaces of the launches on a stream
+    share the same memory. A kernel needing several buffers splits one
+    workspace. A kernel can declare its workspace with `triton.heuristics`,
+    so that callers don't pass it:
+
+        @triton.heuristics({"Flags": lambda args: triton.Workspace(args["num_tiles"] * 4, torch.int32, zero=True)})
+        @triton.jit
+        def kernel(a, b, c, Flags, num_tiles):
+            ...
+
+    With `zero`, the memory is zeroed on the stream before the kernel runs.
+    The memory is taken once, by the first launch the workspace is passed to:
+    use a new workspace for each launch.
+    """
+
+    def __init__(self, nbytes, dtype=None, zero=False):
+        self.nbytes = nbytes
+        self._dtype = dtype
+        self.zero = zero
+        self.buffer = None
+        self.ptr = None
+
+    @property
+    def dtype(self):
+        if self._dtype is None:
+            import torch
+            return torch.uint8
+        return self._dtype
+
+    def data_ptr(self):
+        if self.ptr is None:
+            device = driver.get_current_device()
+            stream = driver.get_current_stream(device)
+            # keeps the memory of captured launches alive with their graph
+            self.buffer, _ = workspace_pool.get(max(self.nbytes, 1), device, stream)
+            self.ptr = self.buffer.data_ptr()
+            if self.zero and self.nbytes > 0:
+                _zero(self.ptr, self.nbytes)
+        return self.ptr
+
+    def __repr__(self):
+        return f"Workspace({self.nbytes})"
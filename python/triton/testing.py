@@ -2,6 +2,8 @@ import functools
 import os
 import subprocess
 import sys
+import threading
+import time
 from contextlib import contextmanager
 from typing import Any, Dict, List
 from . import language as tl
@@ -76,8 +78,69 @@ def do_bench_cudagraph(fn, rep=20, grad_to_none=None):
     return torch.mean(torch.tensor(ret)).item()
 
 
-def do_bench(fn, warmup=25, rep=100, grad_to_none=None, quantiles=None, fast_flush=True, return_mode="mean"):
+_kernel_timer = threading.local()
+_kernel_hooks_lock = threading.Lock()
+_kernel_hooks_users = 0
+_kernel_hooks_saved = None
+
+
+def _kernel_enter_hook(*args):
+    enter, _ = _kernel_hooks_saved
+    if enter is not None:
+        enter(*args)
+    events = getattr(_kernel_timer, "events", None)
+    if events is not None:
+        import torch
+        start = torch.cuda.Event(enable_timing=True)
+        start.record()
+        events.append([start, None])
+
+
+def _kernel_exit_hook(*args):
+    _, exit = _kernel_hooks_saved
+    events = getattr(_kernel_timer, "events", None)
+    if events:
+        import torch
+        end = torch.cuda.Event(enable_timing=True)
+        end.record()
+        events[-1][1] = end
+    if exit is not None:
+        exit(*args)
+
+
+@contextmanager
+def _kernel_hooks():
+    # The launch hooks are global, but the benchmarked launches are collected
+    # per thread so that several devices can be benchmarked concurrently.
+    # Hooks that were already installed (e.g. by a profiler) keep being called.
+    global _kernel_hooks_users, _kernel_hooks_saved
+    from .compiler import CompiledKernel
+    with _kernel_hooks_lock:
+        if _kernel_hooks_users == 0:
+            _kernel_hooks_saved = (CompiledKernel.launch_enter_hook, CompiledKernel.launch_exit_hook)
+            CompiledKernel.launch_enter_hook = _kernel_enter_hook
+            CompiledKernel.launch_exit_hook = _kernel_exit_hook
+        _kernel_hooks_users += 1
+    try:
+        yield
+    finally:
+        with _kernel_hooks_lock:
+            _kernel_hooks_users -= 1
+            if _kernel_hooks_users == 0:
+                CompiledKernel.launch_enter_hook, CompiledKernel.launch_exit_hook = _kernel_hooks_saved
+
+
+def _sm_clock_khz():
+    from .runtime.driver import driver
+    return driver.utils.get_device_properties(driver.get_current_device())["sm_clock_rate"]
+
+
+def do_bench(fn, warmup=25, rep=100, grad_to_none=None, quantiles=None, fast_flush=True, return_mode="mean",
+             measure=None):
     assert return_mode in ["min", "max", "mean", "median"]
+    if measure is None:
+        measure = os.environ.get("TRITON_BENCH_MEASURE", "events")
+    assert measure in ["events", "kernel"]
     import torch
     """
     Benchmark the runtime of the provided function. By default, return the median runtime of :code:`fn` along with
@@ -95,6 +158,12 @@ def do_bench(fn, warmup=25, rep=100, grad_to_none=None, quantiles=None, fast_flu
     :type quantiles: list[float]
     :param fast_flush: Use faster kernel to flush L2 between measurements
     :type fast_flush: bool
+    :param measure: What to time. "events" (the default, or the value of `TRITON_BENCH_MEASURE`) times the whole
+        call to `fn`, launch overheads included. "kernel" only times the execution of the Triton kernels launched
+        by `fn`, by recording events around each launch while the GPU is kept busy, so that host-side overheads
+        and the gaps between launches don't count. Work that isn't a Triton kernel is then ignored, unless `fn`
+        doesn't launch any.
+    :type measure: str
     """
 
     fn()
@@ -111,13 +180,20 @@ def do_bench(fn, warmup=25, rep=100, grad_to_none=None, quantiles=None, fast_flu
     # Estimate the runtime of the function
     start_event = torch.cuda.Event(enable_timing=True)
     end_event = torch.cuda.Event(enable_timing=True)
+    host_start = time.perf_counter()
     start_event.record()
     for _ in range(5):
         cache.zero_()
         fn()
     end_event.record()
+    host_ms = (time.perf_counter() - host_start) * 1e3 / 5
     torch.cuda.synchronize()
     estimate_ms = start_event.elapsed_time(end_event) / 5
+    if measure == "kernel":
+        # Long enough for the host to enqueue a whole call to `fn` before the
+        # GPU gets to it, so that launches run back to back
+        sleep_cycles = int(2 * host_ms * _sm_clock_khz())
+        kernel_events = []
 
     # compute number of warmup and repeat
     n_warmup = max(1, int(warmup / estimate_ms))
@@ -137,13 +213,31 @@ def do_bench(fn, warmup=25, rep=100, grad_to_none=None, quantiles=None, fast_flu
                 x.grad = None
         # we clear the L2 cache before each run
         cache.zero_()
+        if measure == "kernel":
+            torch.cuda._sleep(sleep_cycles)
+            _kernel_timer.events = []
+            with _kernel_hooks():
+                try:
+                    start_event[i].record()
+                    fn()
+                    end_event[i].record()
+                finally:
+                    kernel_events.append(_kernel_timer.events)
+                    _kernel_timer.events = None
+            continue
         # record time of `fn`
         start_event[i].record()
         fn()
         end_event[i].record()
     # Record clocks
     torch.cuda.synchronize()
-    times = torch.tensor([s.elapsed_time(e) for s, e in zip(start_event, end_event)], dtype=torch.float)
+    times = [s.elapsed_time(e) for s, e in zip(start_event, end_event)]
+    if measure == "kernel":
+        times = [
+            sum(s.elapsed_time(e) for s, e in events if e is not None) if events else t
+            for t, events in zip(times, kernel_events)
+        ]
+    times = torch.tensor(times, dtype=torch.float)
     if quantiles is not None:
         ret = torch.quantile(times, torch.tensor(quantiles, dtype=torch.float)).tolist()
         if len(ret) == 1:
@@ -209,6 +303,10 @@ class Benchmark:
         y_log: bool = False,
         color=None,
         styles=None,
+        higher_is_better: bool = True,
+        bytes_moved=None,
+        flops=None,
+        flops_dtype=None,
     ):
         """
         Constructor.
@@ -239,6 +337,19 @@ class Benchmark:
         :type x_log: bool, optional
         :param y_log: Whether the y axis should be log scale.
         :type y_log: bool, optional
+        :param higher_is_better: Whether higher values of the benchmarked function are better (e.g. TFLOPS) or worse
+            (e.g. ms). Used by :code:`compare_perf_reports` to tell regressions from improvements.
+        :type higher_is_better: bool, optional
+        :param bytes_moved: Function of the arguments of the benchmarked function that returns the number of bytes
+            it moves to and from DRAM. With it or :code:`flops`, the benchmarked function must return run times in
+            ms (e.g. from :code:`do_bench`), and the results get a :code:`<line>-roofline` column with the percentage
+            of the roofline of the device they achieve (see :code:`roofline_fraction`).
+        :type bytes_moved: Callable, optional
+        :param flops: Function of the arguments of the benchmarked function that returns the number of floating
+            point operations it runs.
+        :type flops: Callable, optional
+        :param flops_dtype: dtype of the tensor core operations counted by :code:`flops`, or None for fp32 SIMD.
+        :type flops_dtype: torch.dtype, optional
         """
         self.x_names = x_names
         self.x_vals = x_vals
@@ -253,6 +364,10 @@ class Benchmark:
         self.ylabel = ylabel
         self.plot_name = plot_name
         self.args = args
+        self.higher_is_better = higher_is_better
+        self.bytes_moved = bytes_moved
+        self.flops = flops
+        self.flops_dtype = flops_dtype
 
 
 class Mark:
@@ -271,7 +386,10 @@ class Mark:
         y_min = [f'{x}-min' for x in bench.line_names]
         y_max = [f'{x}-max' for x in bench.line_names]
         x_names = list(bench.x_names)
+        with_roofline = bench.bytes_moved is not None or bench.flops is not None
         df = pd.DataFrame(columns=x_names + y_mean + y_min + y_max)
+        results = []
+        rooflines = []
         for x in bench.x_vals:
             # x can be a single value or a sequence of values.
             if not isinstance(x, (list, tuple)):
@@ -281,9 +399,10 @@ class Mark:
                 raise ValueError(f"Expected {len(x_names)} values, got {x}")
             x_args = dict(zip(x_names, x))
 
-            row_mean, row_min, row_max = [], [], []
-            for y in bench.line_vals:
-                ret = self.fn(**x_args, **{bench.line_arg: y}, **bench.args, **kwrags)
+            row_mean, row_min, row_max, row_roofline = [], [], [], []
+            for y, line_name in zip(bench.line_vals, bench.line_names):
+                fn_args = {**x_args, bench.line_arg: y, **bench.args}
+                ret = self.fn(**fn_args, **kwrags)
                 try:
                     y_mean, y_min, y_max = ret
                 except TypeError:
@@ -291,7 +410,14 @@ class Mark:
                 row_mean += [y_mean]
                 row_min += [y_min]
                 row_max += [y_max]
+                results.append({"x": _to_json(x_args), "line": line_name, **_json_quantiles(y_mean, y_min, y_max)})
+                if with_roofline:
+                    bytes_moved = bench.bytes_moved(**fn_args) if bench.bytes_moved else 0
+                    flops = bench.flops(**fn_args) if bench.flops else 0
+                    row_roofline += [100 * roofline_fraction(y_mean, bytes_moved, flops, bench.flops_dtype)]
+                    results[-1]["roofline"] = row_roofline[-1]
             df.loc[len(df)] = list(x) + row_mean + row_min + row_max
+            rooflines.append(row_roofline)
 
         if bench.plot_name:
             plt.figure()
@@ -321,6 +447,9 @@ class Mark:
         if diff_col and df.shape[1] == 2:
             col0, col1 = df.columns.tolist()
             df['Diff'] = df[col1] - df[col0]
+        if with_roofline:
+            for i, name in enumerate(bench.line_names):
+                df[f'{name}-roofline'] = [row[i] for row in rooflines]
 
         if print_data:
             print(bench.plot_name + ':')
@@ -328,24 +457,44 @@ class Mark:
         if save_path:
             df.to_csv(os.path.join(save_path, f"{bench.plot_name}.csv"), float_format=f"%.{save_precision}f",
                       index=False)
-        return df
+        report = {
+            "plot_name": bench.plot_name, "x_names": x_names, "line_names": list(bench.line_names), "ylabel":
+            bench.ylabel, "higher_is_better": bench.higher_is_better, "results": results
+        }
+        return df, report
+
+    def run(self, show_plots=False, print_data=False, save_path='', return_df=False, save_json=None, **kwargs):
+        """
+        Runs the benchmarks.
 
-    def run(self, show_plots=False, print_data=False, save_path='', return_df=False, **kwargs):
+        :param save_json: Path of a JSON file to write the results to, with the environment they were measured in, to
+            compare them with :code:`compare_perf_reports`. Defaults to the value of `TRITON_BENCH_JSON`. The results
+            of benchmarks already in the file under another :code:`plot_name` are kept, so that several scripts can
+            write to the same file.
+        :type save_json: str, optional
+        """
+        if save_json is None:
+            save_json = os.environ.get("TRITON_BENCH_JSON")
         has_single_bench = isinstance(self.benchmarks, Benchmark)
         benchmarks = [self.benchmarks] if has_single_bench else self.benchmarks
         result_dfs = []
+        reports = []
         if save_path:
             # Create directory if it doesn't exist
             os.makedirs(save_path, exist_ok=True)
             html = open(os.path.join(save_path, "results.html"), "w")
             html.write("<html><body>\n")
         for bench in benchmarks:
-            result_dfs.append(self._run(bench, save_path, show_plots, print_data, **kwargs))
+            df, report = self._run(bench, save_path, show_plots, print_data, **kwargs)
+            result_dfs.append(df)
+            reports.append(report)
             if save_path:
                 html.write(f"<image src=\"{bench.plot_name}.png\"/>\n")
         if save_path:
             html.write("</body></html>\n")
             html.close()
+        if save_json:
+            _save_perf_report(save_json, reports)
         if return_df:
             if has_single_bench:
                 return result_dfs[0]
@@ -354,6 +503,116 @@ class Mark:
         return None
 
 
+def _to_json(value):
+    # numpy and torch scalars, e.g. from the x values of a benchmark
+    if hasattr(value, "item"):
+        return value.item()
+    if isinstance(value, dict):
+        return {str(k): _to_json(v) for k, v in value.items()}
+    if isinstance(value, (list, tuple)):
+        return [_to_json(v) for v in value]
+    if value is None or isinstance(value, (bool, int, float, str)):
+        return value
+    return str(value)
+
+
+def _json_quantiles(value, low, high):
+    value, low, high = (None if v is None else float(_to_json(v)) for v in (value, low, high))
+    # the benchmarks return their quantiles in either order, e.g. the
+    # throughputs of the 20-th and 80-th percentile of the run time
+    if low is not None and high is not None and low > high:
+        low, high = high, low
+    return {"value": value, "low": low, "high": high}
+
+
+def _perf_environment():
+    import platform
+
+    import torch
+
+    from . import __version__
+    from .compiler.compiler import triton_key
+    from .runtime.driver import driver
+    env = {
+        "target": _to_json(driver.get_current_target()), "gpu": torch.cuda.get_device_name(), "host":
+        platform.node(), "runtime": torch.version.hip or torch.version.cuda, "torch": torch.__version__, "triton":
+        __version__, "triton_key": triton_key()
+    }
+    try:
+        cmd = ['nvidia-smi', '-i', '0', '--query-gpu=driver_version', '--format=csv,noheader']
+        env["driver"] = subprocess.check_output(cmd, stderr=subprocess.DEVNULL).decode().strip()
+    except (OSError, subprocess.CalledProcessError):
+        env["driver"] = None
+    return env
+
+
+def _save_perf_report(path, reports):
+    import json
+    benchmarks = []
+    if os.path.exists(path):
+        with open(path) as f:
+            benchmarks = json.load(f)["benchmarks"]
+    names = {report["plot_name"] for report in reports}
+    benchmarks = [bench for bench in benchmarks if bench["plot_name"] not in names] + reports
+    with open(path, "w") as f:
+        json.dump({"environment": _perf_environment(), "benchmarks": benchmarks}, f, indent=2)
+
+
+def compare_perf_reports(baseline, current, threshold=0.05):
+    """
+    Compares the results of two runs of benchmarks saved by :code:`Mark.run(save_json=...)`, and returns the
+    regressions from :code:`baseline` to :code:`current`, as a list of dictionaries with the :code:`plot_name`,
+    :code:`x` values and :code:`line` of the benchmark, the :code:`baseline` and :code:`current` values, and their
+    relative :code:`change` (negative is worse).
+
+    A result regresses when it is worse than the baseline by more than :code:`threshold`, and, if both runs saved the
+    quantiles returned by the benchmark (e.g. :code:`do_bench(..., quantiles=[0.5, 0.2, 0.8])`), the ranges between
+    these quantiles don't overlap: the difference is then larger than the run to run noise.
+
+    :param baseline: Path of the results to compare against, or the results loaded from it.
+    :param current: Path of the new results, or the results loaded from it.
+    :param threshold: Smallest relative change that counts as a regression.
+    :type threshold: float
+    """
+    import json
+
+    def load(report):
+        if isinstance(report, (str, os.PathLike)):
+            with open(report) as f:
+                return json.load(f)
+        return report
+
+    def key(bench, result):
+        return bench["plot_name"], result["line"], json.dumps(result["x"], sort_keys=True)
+
+    baseline, current = load(baseline), load(current)
+    reference = {
+        key(bench, result): result
+        for bench in baseline["benchmarks"]
+        for result in bench["results"]
+        if result["value"]
+    }
+    regressions = []
+    for bench in current["benchmarks"]:
+        sign = 1 if bench["higher_is_better"] else -1
+        for result in bench["results"]:
+            ref = reference.get(key(bench, result))
+            if ref is None or result["value"] is None:
+                continue
+            change = sign * (result["value"] - ref["value"]) / ref["value"]
+            if change >= -threshold:
+                continue
+            if None not in (ref["low"], ref["high"], result["low"], result["high"]):
+                overlap = result["high"] >= ref["low"] if sign > 0 else result["low"] <= ref["high"]
+                if overlap:
+                    continue
+            regressions.append({
+                "plot_name": bench["plot_name"], "x": result["x"], "line": result["line"], "baseline": ref["value"],
+                "current": result["value"], "change": change
+            })
+    return regressions
+
+
 def perf_report(benchmarks):
     """
     Mark a function for benchmarking. The benchmark can then be executed by using the :code:`.run` method on the return value.
@@ -403,6 +662,30 @@ def get_max_tensorcore_tflops(dtype, clock_rate, device=None):
     return tflops
 
 
+def roofline_fraction(ms, bytes_moved=0, flops=0, dtype=None, device=None):
+    """
+    Returns the fraction of the roofline of the device achieved by a run time of :code:`ms` milliseconds, for
+    moving :code:`bytes_moved` bytes to and from DRAM and running :code:`flops` floating point operations: the time
+    the device needs at its peak DRAM bandwidth or at its peak compute throughput, whichever is larger, over
+    :code:`ms`. The peak compute throughput is that of the tensor cores for :code:`dtype`, or of the SIMD units in
+    fp32 when :code:`dtype` is None.
+    """
+    import torch
+
+    from .runtime import driver
+    if not device:
+        device = torch.cuda.current_device()
+    ideal_ms = bytes_moved / (get_dram_gbps(device) * 1e9) * 1e3
+    if flops:
+        clock_rate = driver.utils.get_device_properties(device)["sm_clock_rate"]  # in kHz
+        if dtype is None:
+            tflops = get_max_simd_tflops(torch.float32, clock_rate, device)
+        else:
+            tflops = get_max_tensorcore_tflops(dtype, clock_rate, device)
+        ideal_ms = max(ideal_ms, flops / (tflops * 1e12) * 1e3)
+    return ideal_ms / ms
+
+
 # create decorator that wraps test function into
 # a cuda-memcheck system call
 
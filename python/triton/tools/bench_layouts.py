@@ -0,0 +1,308 @@
+import csv
+import io
+import json
+import subprocess
+import sys
+import tempfile
+from argparse import SUPPRESS, ArgumentParser
+from pathlib import Path
+
+desc = """
+Triton layout conversion benchmark:
+
+This program generates TTGIR kernels that convert tensors between common
+pairs of encodings (blocked to blocked, MMA to blocked, slice to blocked,
+blocked to dot operand through shared memory) at several shapes and dtypes,
+and reports for each of them:
+
+  us/iter    run time of one iteration of the conversion loop, in microseconds
+  GB/s       bytes converted per second over the whole device
+  conflicts  bank conflict factor of the shared memory accesses, as estimated
+             by the cost model (1 is conflict-free)
+
+With `--ncu`, each case is also profiled with Nsight Compute, which reports
+the bank conflicts counted by the hardware for loads and stores.
+
+The kernels start from TTGIR, so only the lowering to LLVM runs on them: the
+numbers follow the code emitted for the conversions (ConvertLayoutOpToLLVM),
+not the layouts the optimizer would pick. Each loop iteration converts the
+tensor to the destination encoding and back, except for dot operands, where
+the converted tensor feeds a `tt.dot`.
+
+python bench_layouts.py --filter mma -o layouts.json
+"""
+
+_types = {"fp16": ("f16", 2), "fp32": ("f32", 4)}
+
+
+def blocked(size_per_thread, threads_per_warp, warps_per_cta, order):
+    rank = len(order)
+    return (f"#triton_gpu.blocked<{{sizePerThread = {list(size_per_thread)}, "
+            f"threadsPerWarp = {list(threads_per_warp)}, warpsPerCTA = {list(warps_per_cta)}, order = {list(order)}, "
+            f"CTAsPerCGA = {[1] * rank}, "
+            f"CTASplitNum = {[1] * rank}, CTAOrder = {list(reversed(range(rank)))}}}>")
+
+
+def mma(warps_per_cta):
+    return (f"#triton_gpu.nvidia_mma<{{versionMajor = 2, warpsPerCTA = {list(warps_per_cta)}, CTAsPerCGA = [1, 1], "
+            f"CTASplitNum = [1, 1], CTAOrder = [1, 0], instrShape = [16, 8]}}>")
+
+
+def sliced(dim, parent):
+    return f"#triton_gpu.slice<{{dim = {dim}, parent = {parent}}}>"
+
+
+def shared(vec, per_phase, max_phase, order):
+    return (f"#triton_gpu.shared<{{vec = {vec}, perPhase = {per_phase}, maxPhase = {max_phase}, order = {list(order)}, "
+            f"CTAsPerCGA = [1, 1], CTASplitNum = [1, 1], CTAOrder = [1, 0]}}>")
+
+
+def dot_operand(op_idx, parent, k_width):
+    return f"#triton_gpu.dot_op<{{opIdx = {op_idx}, parent = {parent}, kWidth = {k_width}}}>"
+
+
+_row_major = blocked([1, 4], [8, 4], [4, 1], [1, 0])
+_col_major = blocked([4, 1], [4, 8], [1, 4], [0, 1])
+_mma = mma([2, 2])
+
+
+def cases():
+    """
+    Yields the `(name, kind, layouts, shape, dtype)` of the benchmarked
+    conversions. `layouts` maps the names of the encodings of the generated
+    kernel to their attributes.
+    """
+    for dtype in ("fp16", "fp32"):
+        for shape in ((64, 64), (128, 128)):
+            yield ("blocked->blocked", "round_trip", {"io": _row_major, "src": _row_major, "dst": _col_major}, shape,
+                   dtype)
+            yield ("mma->blocked", "round_trip", {"io": _row_major, "src": _mma, "dst": _row_major}, shape, dtype)
+        for n in (128, 1024):
+            parent = blocked([1, 4], [8, 4], [4, 1], [1, 0])
+            yield ("slice->blocked", "round_trip", {
+                "io": blocked([4], [32], [4], [0]), "src": sliced(0, parent), "dst": blocked([4], [32], [4], [0])
+            }, (n, ), dtype)
+    for swizzle, layout in (("swizzled", shared(8, 1, 8, [1, 0])), ("unswizzled", shared(1, 1, 1, [1, 0]))):
+        for shape in ((64, 32), (128, 64)):
+            yield (f"blocked->dot_operand ({swizzle})", "dot_operand", {
+                "io": _row_major, "shared": layout, "dot_a": dot_operand(0, _mma, 2), "dot_b": dot_operand(1, _mma, 2),
+                "mma": _mma
+            }, shape, "fp16")
+
+
+def _offsets(shape, layout, prefix=""):
+    """
+    Returns the TTGIR computing `%<prefix>offsets`, the row-major offsets of a
+    tensor of `shape` in `layout`.
+    """
+    if len(shape) == 1:
+        ty = f"tensor<{shape[0]}xi32, {layout}>"
+        return f"    %{prefix}offsets = tt.make_range {{end = {shape[0]} : i32, start = 0 : i32}} : {ty}\n"
+    m, n = shape
+    rows_ty = f"tensor<{m}xi32, {sliced(1, layout)}>"
+    cols_ty = f"tensor<{n}xi32, {sliced(0, layout)}>"
+    column_ty = f"tensor<{m}x1xi32, {layout}>"
+    row_ty = f"tensor<1x{n}xi32, {layout}>"
+    ty = f"tensor<{m}x{n}xi32, {layout}>"
+    lines = [
+        f"%rows = tt.make_range {{end = {m} : i32, start = 0 : i32}} : {rows_ty}",
+        f"%rows_2d = tt.expand_dims %rows {{axis = 1 : i32}} : ({rows_ty}) -> {column_ty}",
+        f"%stride = arith.constant dense<{n}> : {column_ty}",
+        f"%row_offsets = arith.muli %rows_2d, %stride : {column_ty}",
+        f"%cols = tt.make_range {{end = {n} : i32, start = 0 : i32}} : {cols_ty}",
+        f"%cols_2d = tt.expand_dims %cols {{axis = 0 : i32}} : ({cols_ty}) -> {row_ty}",
+        f"%row_offsets_b = tt.broadcast %row_offsets : ({column_ty}) -> {ty}",
+        f"%cols_b = tt.broadcast %cols_2d : ({row_ty}) -> {ty}",
+        f"%offsets = arith.addi %row_offsets_b, %cols_b : {ty}",
+    ]
+    return "".join("    " + line.replace("%", f"%{prefix}") + "\n" for line in lines)
+
+
+def _pointers(name, arg, elem, shape, layout, offsets="%offsets"):
+    dims = "x".join(map(str, shape))
+    return (f"    %{name}_base = tt.splat {arg} : (!tt.ptr<{elem}>) -> tensor<{dims}x!tt.ptr<{elem}>, {layout}>\n"
+            f"    %{name} = tt.addptr %{name}_base, {offsets} : tensor<{dims}x!tt.ptr<{elem}>, {layout}>, "
+            f"tensor<{dims}xi32, {layout}>\n")
+
+
+def _module(body, layouts, capability, in_elem, out_elem):
+    aliases = "".join(f"#{name} = {attr}\n" for name, attr in layouts.items())
+    return (f"{aliases}module attributes {{\"triton_gpu.compute-capability\" = {capability} : i32, "
+            f"\"triton_gpu.num-ctas\" = 1 : i32, \"triton_gpu.num-warps\" = 4 : i32, "
+            f"\"triton_gpu.threads-per-warp\" = 32 : i32}} {{\n"
+            f"  tt.func public @convert_layout(%in: !tt.ptr<{in_elem}> {{tt.divisibility = 16 : i32}}, "
+            f"%out: !tt.ptr<{out_elem}> {{tt.divisibility = 16 : i32}}, %iters: i32) {{\n"
+            f"    %c0 = arith.constant 0 : i32\n"
+            f"    %c1 = arith.constant 1 : i32\n"
+            f"{body}"
+            f"    tt.return\n"
+            f"  }}\n"
+            f"}}\n")
+
+
+def make_kernel(kind, layouts, shape, dtype, capability):
+    """
+    Returns the TTGIR of the kernel benchmarking the conversion, the number of
+    conversions one loop iteration runs, and the dtype of the output.
+    """
+    elem, _ = _types[dtype]
+    dims = "x".join(map(str, shape))
+    one = "1.000000e+00"
+    if kind == "round_trip":
+        ty = lambda layout: f"tensor<{dims}x{elem}, #{layout}>"
+        body = _offsets(shape, "#io") + _pointers("in_ptrs", "%in", elem, shape, "#io")
+        body += _pointers("out_ptrs", "%out", elem, shape, "#io")
+        body += "".join(f"    {line}\n" for line in [
+            f"%x = tt.load %in_ptrs {{cache = 1 : i32, evict = 1 : i32, isVolatile = false}} : {ty('io')}",
+            f"%x_src = triton_gpu.convert_layout %x : ({ty('io')}) -> {ty('src')}",
+            f"%one = arith.constant dense<{one}> : {ty('src')}",
+            f"%y = scf.for %i = %c0 to %iters step %c1 iter_args(%acc = %x_src) -> ({ty('src')}) : i32 {{",
+            f"  %d = triton_gpu.convert_layout %acc : ({ty('src')}) -> {ty('dst')}",
+            f"  %s = triton_gpu.convert_layout %d : ({ty('dst')}) -> {ty('src')}",
+            f"  %next = arith.addf %s, %one : {ty('src')}",
+            f"  scf.yield %next : {ty('src')}",
+            "}",
+            f"%y_io = triton_gpu.convert_layout %y : ({ty('src')}) -> {ty('io')}",
+            f"tt.store %out_ptrs, %y_io : {ty('io')}",
+        ])
+        return _module(body, layouts, capability, elem, elem), 2, dtype
+    m, k = shape
+    n = 64
+    a_ty = lambda layout: f"tensor<{m}x{k}x{elem}, #{layout}>"
+    c_ty = lambda layout: f"tensor<{m}x{n}xf32, #{layout}>"
+    body = _offsets(shape, "#io") + _pointers("in_ptrs", "%in", elem, shape, "#io")
+    body += "".join(f"    {line}\n" for line in [
+        f"%x = tt.load %in_ptrs {{cache = 1 : i32, evict = 1 : i32, isVolatile = false}} : {a_ty('io')}",
+        f"%one = arith.constant dense<{one}> : {a_ty('io')}",
+        f"%b = arith.constant dense<{one}> : tensor<{k}x{n}x{elem}, #dot_b>",
+        f"%zero = arith.constant dense<0.000000e+00> : {c_ty('mma')}",
+        f"%c, %x_last = scf.for %i = %c0 to %iters step %c1 iter_args(%acc = %zero, %xi = %x) -> ({c_ty('mma')}, "
+        f"{a_ty('io')}) : i32 {{",
+        f"  %s = triton_gpu.convert_layout %xi : ({a_ty('io')}) -> {a_ty('shared')}",
+        f"  %a = triton_gpu.convert_layout %s : ({a_ty('shared')}) -> {a_ty('dot_a')}",
+        f"  %next_acc = tt.dot %a, %b, %acc {{allowTF32 = true, maxNumImpreciseAcc = 0 : i32}} : {a_ty('dot_a')} * "
+        f"tensor<{k}x{n}x{elem}, #dot_b> -> {c_ty('mma')}",
+        f"  %next_x = arith.addf %xi, %one : {a_ty('io')}",
+        f"  scf.yield %next_acc, %next_x : {c_ty('mma')}, {a_ty('io')}",
+        "}",
+    ])
+    # the accumulator is stored in the layout of the input, with its own offsets
+    out_shape = (m, n)
+    body += _offsets(out_shape, "#io", prefix="c_")
+    body += _pointers("out_ptrs", "%out", "f32", out_shape, "#io", offsets="%c_offsets")
+    body += "".join(f"    {line}\n" for line in [
+        f"%c_io = triton_gpu.convert_layout %c : ({c_ty('mma')}) -> {c_ty('io')}",
+        f"tt.store %out_ptrs, %c_io : {c_ty('io')}",
+    ])
+    return _module(body, layouts, capability, elem, "f32"), 1, "fp32"
+
+
+def _bank_conflicts(path, target):
+    from triton._C.libtriton import ir
+    from triton.compiler.compiler import make_backend
+    backend = make_backend(target)
+    context = ir.context()
+    ir.load_dialects(context)
+    backend.load_dialects(context)
+    cost = ir.parse_mlir_module(str(path), context).get_kernel_cost()
+    return None if cost is None else cost["bank_conflicts"]
+
+
+def bench_case(kind, layouts, shape, dtype, iters, workdir):
+    """
+    Compiles and runs the kernel of a conversion, and returns its
+    `{"us_per_iter", "gbps", "bank_conflicts"}`.
+    """
+    import torch
+    import triton
+    import triton.testing
+    from triton.runtime.driver import driver
+
+    target = driver.get_current_target()
+    src, conversions, out_dtype = make_kernel(kind, layouts, shape, dtype, target[1])
+    path = Path(workdir) / "convert_layout.ttgir"
+    path.write_text(src)
+    kernel = triton.compile(str(path))
+    torch_dtype = {"fp16": torch.float16, "fp32": torch.float32}
+    numel = 1
+    for dim in shape:
+        numel *= dim
+    x = torch.randn(numel, dtype=torch_dtype[dtype], device="cuda")
+    out = torch.empty(max(numel, shape[0] * 64), dtype=torch_dtype[out_dtype], device="cuda")
+    device = driver.get_current_device()
+    num_ctas = driver.utils.get_device_properties(device)["multiprocessor_count"] * 4
+    # every CTA converts the same tile
+    launch = kernel[(num_ctas, 1, 1)]
+    ms = triton.testing.do_bench(lambda: launch(x, out, iters), return_mode="median")
+    converted = num_ctas * iters * conversions * numel * _types[dtype][1]
+    return {
+        "us_per_iter": ms * 1e3 / iters, "gbps": converted / (ms * 1e-3) / 1e9, "bank_conflicts":
+        _bank_conflicts(path, target)
+    }
+
+
+_ncu_metrics = {
+    "l1tex__data_bank_conflicts_pipe_lsu_mem_shared_op_ld.sum": "ncu_load_conflicts",
+    "l1tex__data_bank_conflicts_pipe_lsu_mem_shared_op_st.sum": "ncu_store_conflicts",
+}
+
+
+def _run_worker(index, args, ncu=False):
+    cmd = [sys.executable, __file__, "--worker", str(index), "--iters", str(args.iters)]
+    if ncu:
+        cmd = ["ncu", "--csv", "--kernel-name", "convert_layout", "--metrics", ",".join(_ncu_metrics)] + cmd
+    out = subprocess.run(cmd, check=True, stdout=subprocess.PIPE, text=True).stdout
+    if not ncu:
+        # the results are on the last line, after anything the compiler printed
+        return json.loads(out.strip().splitlines()[-1])
+    # the metrics of the last profiled launch of the kernel
+    lines = [line for line in out.splitlines() if line.startswith('"')]
+    results = dict()
+    for row in csv.DictReader(io.StringIO("\n".join(lines))):
+        if row.get("Metric Name") in _ncu_metrics:
+            results[_ncu_metrics[row["Metric Name"]]] = float(row["Metric Value"].replace(",", ""))
+    return results
+
+
+def _print_report(report):
+    print(f"{'conversion':<32} {'shape':>10} {'dtype':>5} {'us/iter':>9} {'GB/s':>9} {'conflicts':>9}")
+    for entry in report:
+        shape = "x".join(map(str, entry["shape"]))
+        print(f"{entry['name']:<32} {shape:>10} {entry['dtype']:>5} {entry['us_per_iter']:9.3f} {entry['gbps']:9.1f} "
+              f"{entry['bank_conflicts'] or '-':>9}" +
+              "".join(f" {name}={entry[name]:.0f}" for name in _ncu_metrics.values() if name in entry))
+
+
+if __name__ == "__main__":
+    parser = ArgumentParser(description=desc)
+    parser.add_argument("--filter", type=str, default="", help="Only run the conversions whose name contains this")
+    parser.add_argument("--iters", type=int, default=256, help="Number of conversions per kernel launch")
+    parser.add_argument("--ncu", action="store_true", help="Also count bank conflicts with Nsight Compute")
+    parser.add_argument("--out", "-o", type=Path, default=None, help="Write the results to this JSON file")
+    parser.add_argument("--worker", type=int, default=None, help=SUPPRESS)
+    args = parser.parse_args()
+
+    all_cases = list(cases())
+    if args.worker is not None:
+        _, kind, layouts, shape, dtype = all_cases[args.worker]
+        with tempfile.TemporaryDirectory() as workdir:
+            print(json.dumps(bench_case(kind, layouts, shape, dtype, args.iters, workdir)))
+        sys.exit(0)
+
+    report = []
+    for index, (name, kind, layouts, shape, dtype) in enumerate(all_cases):
+        if args.filter not in name:
+            continue
+        # each case runs in its own process, so that a conversion that fails to
+        # lower doesn't stop the others
+        try:
+            entry = {"name": name, "shape": list(shape), "dtype": dtype, **_run_worker(index, args)}
+            if args.ncu:
+                entry.update(_run_worker(index, args, ncu=True))
+        except subprocess.CalledProcessError as e:
+            print(f"{name} {shape} {dtype}: failed ({e})", file=sys.stderr)
+            continue
+        report.append(entry)
+    _print_report(report)
+    if args.out is not None:
+        args.out.write_text(json.dumps(report, indent=2))
@@ -0,0 +1,130 @@
+import json
+import resource
+import statistics
+import subprocess
+import sys
+from argparse import SUPPRESS, ArgumentParser
+from pathlib import Path
+
+desc = """
+Triton compiler pass benchmark:
+
+This program runs the compilation pipeline of the current (or given) target
+on a corpus of Triton IR files, up to and including the stage `--stage`
+(`ttgir` by default, i.e. the `make_ttgir` pipeline), and reports the wall
+time and the peak resident memory of each pass.
+
+Inputs are `.ttir` (or `.ttgir`) files, or directories searched recursively
+for them. A corpus can be dumped from any workload, e.g. the tutorials:
+
+TRITON_KERNEL_DUMP=1 python 06-fused-attention.py
+python bench_passes.py ~/.triton/dump --repeat 5 -o passes.json
+
+Each input is compiled in a separate process so that the peak memory of a
+pass isn't hidden by the peak of a previous input. The time of a pass is the
+median over `--repeat` runs.
+"""
+
+
+def _peak_rss():
+    # ru_maxrss is in kilobytes on Linux
+    return resource.getrusage(resource.RUSAGE_SELF).ru_maxrss * 1024
+
+
+def bench_file(path, target, options, stage, repeat):
+    """
+    Compiles the IR file at `path` up to `stage` `repeat` times, and returns one
+    `{"stage", "pass", "seconds", "peak_memory", "memory_increase"}` entry per pass run.
+    """
+    from triton._C.libtriton import ir
+    from triton.compiler.compiler import IRSource, make_backend
+
+    backend = make_backend(target)
+    src = IRSource(str(path))
+    opts = backend.parse_options(dict(options, **src.parse_options()))
+    stages = dict()
+    backend.add_stages(stages, opts)
+    names = list(stages)
+    pipeline = names[names.index(src.ext) + 1:names.index(stage) + 1]
+    baseline = _peak_rss()
+    runs = []
+    for _ in range(repeat):
+        context = ir.context()
+        ir.load_dialects(context)
+        backend.load_dialects(context)
+        module = src.make_ir(opts, context)
+        metadata = {"hash": src.hash(), "target": target, **opts.__dict__, **src.metadata()}
+        for ext in pipeline:
+            module = stages[ext](module, metadata)
+        runs.append(metadata)
+    results = []
+    previous = baseline
+    # the peak memory of later runs is hidden by the first one
+    for i, (pass_stage, name, peak) in enumerate(runs[0].get("pass_peak_memory", [])):
+        seconds = statistics.median(run["pass_timings"][i][2] for run in runs)
+        results.append({
+            "stage": pass_stage, "pass": name, "seconds": seconds, "peak_memory": peak, "memory_increase":
+            max(0, peak - previous)
+        })
+        previous = max(previous, peak)
+    return results
+
+
+def _run_worker(path, args):
+    cmd = [
+        sys.executable, __file__, "--worker", "--target", args.target, "--stage", args.stage, "--repeat",
+        str(args.repeat), "--options",
+        json.dumps(args.options),
+        str(path)
+    ]
+    out = subprocess.run(cmd, check=True, stdout=subprocess.PIPE, text=True).stdout
+    # the results are on the last line, after anything the compiler printed
+    return json.loads(out.strip().splitlines()[-1])
+
+
+def _inputs(paths):
+    for path in paths:
+        if path.is_dir():
+            yield from sorted(p for p in path.rglob("*") if p.suffix in (".ttir", ".ttgir"))
+        else:
+            yield path
+
+
+def _print_report(name, results):
+    print(f"{name}:")
+    for result in results:
+        print(f"  {result['stage']:>6} {result['pass']:<40} {result['seconds'] * 1e3:10.3f} ms "
+              f"{result['peak_memory'] / 2**20:10.1f} MiB (+{result['memory_increase'] / 2**20:.1f})")
+    print(f"  {'total':>6} {'':<40} {sum(r['seconds'] for r in results) * 1e3:10.3f} ms")
+
+
+if __name__ == "__main__":
+    parser = ArgumentParser(description=desc)
+    parser.add_argument("paths", nargs="+", type=Path, help="IR files, or directories containing them")
+    parser.add_argument("--target", type=str, default=None,
+                        help="Target as `backend:arch`, e.g. `cuda:90` (defaults to the current device)")
+    parser.add_argument("--stage", type=str, default="ttgir", help="Last stage to run")
+    parser.add_argument("--repeat", "-r", type=int, default=3, help="Number of times each input is compiled")
+    parser.add_argument("--options", type=json.loads, default={},
+                        help="Compiler options as a JSON object, e.g. '{\"num_warps\": 8}'")
+    parser.add_argument("--out", "-o", type=Path, default=None, help="Write the results to this JSON file")
+    parser.add_argument("--worker", action="store_true", help=SUPPRESS)
+    args = parser.parse_args()
+
+    if args.target is None:
+        from triton.runtime.driver import driver
+        backend, arch = driver.get_current_target()
+        args.target = f"{backend}:{arch}"
+
+    if args.worker:
+        backend, arch = args.target.split(":")
+        target = (backend, int(arch) if arch.isdigit() else arch)
+        print(json.dumps(bench_file(args.paths[0], target, args.options, args.stage, args.repeat)))
+        sys.exit(0)
+
+    report = dict()
+    for path in _inputs(args.paths):
+        report[str(path)] = _run_worker(path, args)
+        _print_report(path, report[str(path)])
+    if args.out is not None:
+        args.out.write_text(json.dumps(report, indent=2))
@@ -0,0 +1,42 @@
+import json
+import sys
+from argparse import ArgumentParser
+
+from triton.testing import compare_perf_reports
+
+desc = """
+Triton benchmark comparison:
+
+This program compares the results of two runs of benchmarks written by
+`triton.testing.perf_report`, e.g. the tutorials run with
+
+TRITON_BENCH_JSON=baseline.json python 03-matrix-multiplication.py
+
+on two versions of Triton, and prints the results that regressed by more than
+`--threshold` beyond the noise between the quantiles of the runs. It exits
+with code 1 if any did.
+
+python compare_perf.py baseline.json current.json --threshold 0.05
+"""
+
+if __name__ == "__main__":
+    parser = ArgumentParser(description=desc)
+    parser.add_argument("baseline", type=str, help="Results to compare against")
+    parser.add_argument("current", type=str, help="New results")
+    parser.add_argument("--threshold", type=float, default=0.05, help="Smallest relative change to report")
+    args = parser.parse_args()
+
+    with open(args.baseline) as f:
+        baseline = json.load(f)
+    with open(args.current) as f:
+        current = json.load(f)
+    for key in ("gpu", "driver", "runtime"):
+        old, new = baseline["environment"].get(key), current["environment"].get(key)
+        if old != new:
+            print(f"warning: {key} differs between the runs: {old} vs {new}", file=sys.stderr)
+    regressions = compare_perf_reports(baseline, current, args.threshold)
+    for r in regressions:
+        x = ", ".join(f"{name}={value}" for name, value in r["x"].items())
+        print(f"{r['plot_name']} [{r['line']}] {x}: {r['baseline']:.4g} -> {r['current']:.4g} ({r['change']:+.1%})")
+    print(f"{len(regressions)} regression(s)")
+    sys.exit(1 if regressions else 0)
@@ -3,6 +3,7 @@
 #include <stdint.h>
 #include <inttypes.h>
 #include <string.h>
+#include <pthread.h>
 #include <cuda.h>
 
 
@@ -25,43 +26,85 @@ static inline void gpuAssert(CUresult code, const char *file, int line) {{
 }}
 
 // globals
-#define CUBIN_NAME {kernel_name}_cubin
+{cubin_defs}
+static const int {kernel_name}_capabilities[{num_images}] = {{ {capabilities} }};
+static unsigned char *{kernel_name}_cubins[{num_images}] = {{ {cubins} }};
+static const int {kernel_name}_shared_sizes[{num_images}] = {{ {shared_sizes} }};
 CUmodule {kernel_name}_mod = NULL;
 CUfunction {kernel_name}_func = NULL;
-unsigned char CUBIN_NAME[{bin_size}] = {{ {bin_data} }};
+int {kernel_name}_shared = 0;
+// guards loading and unloading, so that the kernel can be loaded lazily by
+// the first launch of any thread
+static pthread_mutex_t {kernel_name}_mutex = PTHREAD_MUTEX_INITIALIZER;
 
 
 void unload_{kernel_name}(void) {{
-    CUDA_CHECK(cuModuleUnload({kernel_name}_mod));
+    pthread_mutex_lock(&{kernel_name}_mutex);
+    if ({kernel_name}_mod != NULL) {{
+      CUDA_CHECK(cuModuleUnload({kernel_name}_mod));
+      {kernel_name}_mod = NULL;
+      __atomic_store_n(&{kernel_name}_func, NULL, __ATOMIC_RELEASE);
+    }}
+    pthread_mutex_unlock(&{kernel_name}_mutex);
 }}
 
 // TODO: some code duplication with `runtime/backend/cuda.c`
-void load_{kernel_name}() {{
-    int dev = 0;
-    void *bin = (void *)&CUBIN_NAME;
-    int shared = {shared};
+static void {kernel_name}_load_locked(void) {{
+    CUdevice dev;
+    CUDA_CHECK(cuCtxGetDevice(&dev));
+    int major, minor;
+    CUDA_CHECK(cuDeviceGetAttribute(&major, CU_DEVICE_ATTRIBUTE_COMPUTE_CAPABILITY_MAJOR, dev));
+    CUDA_CHECK(cuDeviceGetAttribute(&minor, CU_DEVICE_ATTRIBUTE_COMPUTE_CAPABILITY_MINOR, dev));
+    // a cubin runs on devices of the same major and a higher or equal minor
+    // capability; pick the closest one
+    int image = -1;
+    for (int i = 0; i < {num_images}; i++) {{
+      int cc = {kernel_name}_capabilities[i];
+      if (cc / 10 == major && cc % 10 <= minor && (image < 0 || cc > {kernel_name}_capabilities[image]))
+        image = i;
+    }}
+    if (image < 0)
+      CUDA_CHECK(CUDA_ERROR_NO_BINARY_FOR_GPU);
+    void *bin = (void *){kernel_name}_cubins[image];
+    int shared = {kernel_name}_shared_sizes[image];
+    {kernel_name}_shared = shared;
+    CUfunction func;
     CUDA_CHECK(cuModuleLoadData(&{kernel_name}_mod, bin));
-    CUDA_CHECK(cuModuleGetFunction(&{kernel_name}_func, {kernel_name}_mod, "{triton_kernel_name}"));
+    CUDA_CHECK(cuModuleGetFunction(&func, {kernel_name}_mod, "{triton_kernel_name}"));
     // set dynamic shared memory if necessary
     int shared_optin;
     CUDA_CHECK(cuDeviceGetAttribute(&shared_optin, CU_DEVICE_ATTRIBUTE_MAX_SHARED_MEMORY_PER_BLOCK_OPTIN, dev));
     if (shared > 49152 && shared_optin > 49152) {{
-      CUDA_CHECK(cuFuncSetCacheConfig({kernel_name}_func, CU_FUNC_CACHE_PREFER_SHARED));
-      CUDA_CHECK(cuFuncSetAttribute({kernel_name}_func, CU_FUNC_ATTRIBUTE_MAX_DYNAMIC_SHARED_SIZE_BYTES, shared_optin))
+      CUDA_CHECK(cuFuncSetCacheConfig(func, CU_FUNC_CACHE_PREFER_SHARED));
+      CUDA_CHECK(cuFuncSetAttribute(func, CU_FUNC_ATTRIBUTE_MAX_DYNAMIC_SHARED_SIZE_BYTES, shared_optin))
     }}
+    // published last: launches that see it don't take the lock
+    __atomic_store_n(&{kernel_name}_func, func, __ATOMIC_RELEASE);
+}}
+
+// Loads the module if it isn't loaded yet. Launches load it on first use, so
+// this is only needed to move the loading cost out of the first launch.
+void load_{kernel_name}() {{
+    pthread_mutex_lock(&{kernel_name}_mutex);
+    if ({kernel_name}_func == NULL)
+      {kernel_name}_load_locked();
+    pthread_mutex_unlock(&{kernel_name}_mutex);
 }}
 
 /*
 {kernel_docstring}
 */
 CUresult {kernel_name}(CUstream stream, {signature}) {{
-    if ({kernel_name}_func == NULL)
-       load_{kernel_name}();
+    CUfunction func = __atomic_load_n(&{kernel_name}_func, __ATOMIC_ACQUIRE);
+    if (func == NULL) {{
+      load_{kernel_name}();
+      func = __atomic_load_n(&{kernel_name}_func, __ATOMIC_ACQUIRE);
+    }}
     unsigned int gX = {gridX};
     unsigned int gY = {gridY};
     unsigned int gZ = {gridZ};
     void *args[{num_args}] = {{ {arg_pointers} }};
     // TODO: shared memory
     if(gX * gY * gZ > 0)
-      return cuLaunchKernel({kernel_name}_func, gX, gY, gZ, {num_warps} * 32, 1, 1, {shared}, stream, args, NULL);
+      return cuLaunchKernel(func, gX, gY, gZ, {num_warps} * 32, 1, 1, {kernel_name}_shared, stream, args, NULL);
 }}
@@ -32,6 +32,10 @@ CUresult kernel_{specialization_suffix}(CUstream stream, unsigned gX, unsigned g
 
 Different such specialized entry points can be combined using the `linker.py` script.
 
+With `--target 80,90`, the kernel is compiled for each of the given compute capabilities, and the generated code
+embeds all the images. When the kernel is loaded, it picks the image of the highest capability with the same major
+version as the device and a lower or equal minor version.
+
 NOTE: when resolving the scope of /path/to/kernel.py, the file will be executed from within its parent directory with the python interpreter
 used to run this `compile.py` script
 """
@@ -51,6 +55,9 @@ if __name__ == "__main__":
     parser.add_argument("--out-path", "-o", type=Path, default=None, help="Out filename")
     parser.add_argument("--signature", "-s", type=str, help="Signature of the kernel", required=True)
     parser.add_argument("--grid", "-g", type=str, help="Launch grid of the kernel", required=True)
+    parser.add_argument(
+        "--target", "-t", type=str, default=None,
+        help="Comma-separated compute capabilities to compile for, e.g. `80,89,90` (defaults to the current device)")
     args = parser.parse_args()
 
     out_name = args.out_name if args.out_name else args.kernel_name
@@ -109,7 +116,11 @@ if __name__ == "__main__":
         constants.update({i: 1})
     src = triton.compiler.ASTSource(fn=kernel, constants=constants, signature=signature, attrs=attrs)
     opts = {"num_warps": args.num_warps, "num_stages": args.num_stages}
-    ccinfo = triton.compile(src, options=opts)
+    if args.target is None:
+        targets = [triton.runtime.driver.get_current_target()]
+    else:
+        targets = [("cuda", int(cc)) for cc in args.target.split(",")]
+    ccinfos = [triton.compile(src, target=target, options=opts) for target in targets]
     arg_names = []
     arg_types = []
     for i in signature.keys():
@@ -121,18 +132,25 @@ if __name__ == "__main__":
     suffix = kernel_suffix(signature.values(), attrs)
     func_name = '_'.join([out_name, sig_hash, suffix])
     triton_kernel_name = '_'.join([args.kernel_name, suffix])
-    hex_ = str(binascii.hexlify(ccinfo.asm["cubin"]))[2:-1]
+    # one image per compute capability, picked when the kernel is loaded
+    cubin_defs = []
+    for (_, cc), ccinfo in zip(targets, ccinfos):
+        hex_ = str(binascii.hexlify(ccinfo.asm["cubin"]))[2:-1]
+        bin_data = ", ".join([f"0x{x}{y}" for x, y in zip(hex_[::2], hex_[1::2])])
+        cubin_defs.append(f"static unsigned char {func_name}_cubin_sm{cc}[{len(hex_) // 2}] = {{ {bin_data} }};")
     params = {
         "kernel_name": func_name,
         "triton_kernel_name": triton_kernel_name,
-        "bin_size": len(hex_),
-        "bin_data": ", ".join([f"0x{x}{y}" for x, y in zip(hex_[::2], hex_[1::2])]),
+        "cubin_defs": "\n".join(cubin_defs),
+        "num_images": len(targets),
+        "capabilities": ", ".join([str(cc) for _, cc in targets]),
+        "cubins": ", ".join([f"{func_name}_cubin_sm{cc}" for _, cc in targets]),
+        "shared_sizes": ", ".join([str(ccinfo.metadata.shared) for ccinfo in ccinfos]),
         "signature": ", ".join([f"{ty_to_cpp(ty)} {name}" for name, ty in zip(arg_names, arg_types)]),
         "full_signature": ", ".join([f"{ty_to_cpp(signature[i])} {kernel.arg_names[i]}" for i in signature.keys()]),
         "arg_pointers": ", ".join([f"&{arg}" for arg in arg_names]),
         "num_args": len(arg_names),
         "kernel_docstring": doc_string,
-        "shared": ccinfo.metadata.shared,
         "num_warps": args.num_warps,
         "algo_info": '_'.join([const_sig, meta_sig]),
         "gridX": grid[0],
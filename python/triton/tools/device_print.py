@@ -0,0 +1,108 @@
+"""
+Decodes the `tl.device_print` records of a kernel compiled with the
+`print_buffer` option, which writes them to a ring buffer of the last
+`print_buffer` records instead of calling vprintf:
+
+    kernel = fn[grid](*args, print_buffer=1 << 16)
+    torch.cuda.synchronize()
+    print("\\n".join(device_print.decode(kernel)))
+
+Each record holds the format of the printed operand, the program id, the
+index of the element and its value.
+"""
+
+import struct
+from dataclasses import dataclass
+from typing import List, Tuple
+
+from ..runtime.driver import driver
+
+
+@dataclass
+class Format:
+    # the element type, "ptr", or "" for a print without operands
+    type: str
+    rank: int
+    operand: int
+    num_operands: int
+    prefix: str
+
+    @staticmethod
+    def parse(desc):
+        type, rank, operand, num_operands, prefix = desc.split(";", 4)
+        return Format(type, int(rank), int(operand), int(num_operands), prefix)
+
+
+@dataclass
+class Record:
+    format: Format
+    pid: Tuple[int, int, int]
+    idx: Tuple[int, ...]
+    value: object
+
+    def __str__(self):
+        if not self.format.num_operands:
+            return f"pid ({self.pid[0]}, {self.pid[1]}, {self.pid[2]}){self.format.prefix}"
+        line = f"pid ({self.pid[0]}, {self.pid[1]}, {self.pid[2]}) idx ({', '.join(map(str, self.idx))})"
+        line += self.format.prefix
+        if self.format.num_operands > 1:
+            line += f"(operand {self.format.operand}) "
+        if self.format.type == "ptr":
+            return line + hex(self.value)
+        if isinstance(self.value, float):
+            return line + f"{self.value:f}"
+        return line + str(self.value)
+
+
+def _decode_value(type, low, high):
+    bits = low | (high << 32)
+    if type == "f16":
+        return struct.unpack("<e", struct.pack("<H", low & 0xFFFF))[0]
+    if type == "bf16":
+        return struct.unpack("<f", struct.pack("<I", (low & 0xFFFF) << 16))[0]
+    if type == "f32":
+        return struct.unpack("<f", struct.pack("<I", low))[0]
+    if type == "f64":
+        return struct.unpack("<d", struct.pack("<Q", bits))[0]
+    if type.startswith("i"):
+        # signless, printed unsigned like vprintf does
+        return bits & ((1 << int(type[1:])) - 1)
+    return bits
+
+
+def records(kernel, reset=True) -> List[Record]:
+    """
+    Returns the records written by the kernel since it was loaded or last
+    read, oldest first, at most `print_buffer` of them. The buffer is emptied
+    if `reset`. The kernel must have completed, e.g. after a synchronization.
+    """
+    formats = getattr(kernel.metadata, "print_formats", None)
+    if not formats:
+        return []
+    formats = [Format.parse(desc) for desc in formats]
+    kernel._init_handles()
+    data = driver.utils.read_global(kernel.module, "triton_print_buffer", reset)
+    words = struct.unpack(f"<{len(data) // 4}I", data)
+    written = words[0] | (words[1] << 32)
+    num_records = kernel.metadata.print_buffer
+    record_words = kernel.metadata.print_record_words
+    ret = []
+    for i in range(max(0, written - num_records), written):
+        slot = i & (num_records - 1)
+        record = words[2 + slot * record_words:2 + (slot + 1) * record_words]
+        fmt = formats[record[0]]
+        pid = tuple(struct.unpack("<3i", struct.pack("<3I", *record[1:4])))
+        idx = tuple(record[4:4 + fmt.rank])
+        value = None
+        if fmt.num_operands:
+            low, high = record[4 + fmt.rank:6 + fmt.rank]
+            value = _decode_value(fmt.type, low, high)
+        ret.append(Record(fmt, pid, idx, value))
+    return ret
+
+
+def decode(kernel, reset=True) -> List[str]:
+    """
+    Returns the lines vprintf would have printed for the records of `kernel`.
+    """
+    return [str(record) for record in records(kernel, reset)]
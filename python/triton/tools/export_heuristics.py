@@ -0,0 +1,117 @@
+import json
+import os
+from argparse import ArgumentParser
+from collections import defaultdict
+from pathlib import Path
+
+desc = """
+Triton autotuning decision exporter:
+
+This program collects the autotuning decisions persisted by
+`triton.autotune(..., cache_results=True)` (or `TRITON_CACHE_AUTOTUNING=1`)
+in the cache directory, and writes them as decision tables: one per kernel,
+device and argument dtypes, mapping the values of the tuning key to a config.
+
+With `--ranges`, the decisions are also written as range rules, so that any
+value falling in a tuned bucket picks that bucket's config rather than the
+nearest tuned one.
+
+A table can be turned back into `triton.heuristics` values with
+`triton.runtime.autotuner.heuristics_from_table`, so that no benchmarking
+happens at runtime, or be passed to `link.py --heuristics` to generate a C
+entry point that picks the AOT-compiled kernel of the right config.
+
+Example usage:
+python export_heuristics.py --kernel my_module:matmul -o matmul.json
+"""
+
+
+def collect_decisions(cache_dir):
+    """
+    Returns the persisted autotuning decisions found in `cache_dir`. Decisions
+    stored by versions of Triton that didn't record their key are skipped.
+    """
+    decisions = []
+    for path in sorted(Path(cache_dir).glob("*/autotune.json")):
+        try:
+            data = json.loads(path.read_text())
+        except (OSError, ValueError):
+            continue
+        if "config_fields" in data:
+            decisions.append(data)
+    return decisions
+
+
+def make_tables(decisions):
+    """
+    Groups `decisions` into decision tables, keyed by (kernel, device, dtypes).
+    """
+    groups = defaultdict(list)
+    for data in decisions:
+        groups[(data["fn"], data["device"], tuple(data["dtypes"]))].append(data)
+    tables = []
+    for (fn, device, dtypes), entries in sorted(groups.items()):
+        configs, rows = [], {}
+        for data in entries:
+            if data["config_fields"] not in configs:
+                configs.append(data["config_fields"])
+            rows[json.dumps(data["key"])] = {"key": data["key"], "config": configs.index(data["config_fields"])}
+        tables.append({
+            "fn": fn, "device": device, "key_names": entries[0]["key_names"], "dtypes": list(dtypes), "configs":
+            configs, "rows": sorted(rows.values(), key=lambda row: json.dumps(row["key"]))
+        })
+    return tables
+
+
+def rules_from_rows(table):
+    """
+    Returns range rules (see `triton.runtime.autotuner.select_config`)
+    equivalent to the rows of `table`, assuming their keys were bucketed
+    (`key_buckets`): a row covers the values above the previous bucket of each
+    key, up to and including its own. Keys that aren't integers must match
+    exactly.
+    """
+    names = table["key_names"]
+    bounds = [sorted({row["key"][i] for row in table["rows"] if isinstance(row["key"][i], (int, float))})
+              for i in range(len(names))]
+    rules = []
+    for row in table["rows"]:
+        ranges, values = {}, {}
+        for i, (name, value) in enumerate(zip(names, row["key"])):
+            if not isinstance(value, (int, float)) or isinstance(value, bool):
+                values[name] = value
+                continue
+            index = bounds[i].index(value)
+            lo = None if index == 0 else bounds[i][index - 1] + 1
+            hi = None if value == float("inf") else value + 1
+            ranges[name] = [lo, hi]
+        rule = {"ranges": ranges, "config": row["config"]}
+        if values:
+            rule["values"] = values
+        rules.append(rule)
+    return rules
+
+
+if __name__ == "__main__":
+    from triton.runtime.cache import default_cache_dir
+
+    parser = ArgumentParser(description=desc)
+    parser.add_argument("--cache-dir", type=Path, default=None,
+                        help="Cache directory to read decisions from (defaults to $TRITON_CACHE_DIR)")
+    parser.add_argument("--kernel", "-k", type=str, default=None,
+                        help="Only export the decisions of this kernel, as `module:name`")
+    parser.add_argument("--out", "-o", type=Path, required=True, help="Out filename")
+    parser.add_argument("--ranges", action="store_true",
+                        help="Also write the decisions of bucketed keys as range rules covering each bucket")
+    args = parser.parse_args()
+
+    cache_dir = args.cache_dir or os.getenv("TRITON_CACHE_DIR", "").strip() or default_cache_dir()
+    tables = make_tables(collect_decisions(cache_dir))
+    if args.kernel is not None:
+        tables = [table for table in tables if table["fn"] == args.kernel]
+    if args.ranges:
+        for table in tables:
+            table["rules"] = rules_from_rows(table)
+    # a single table is written as is, so that it can be used directly
+    args.out.write_text(json.dumps(tables[0] if len(tables) == 1 else tables, indent=2))
+    print(f"exported {sum(len(table['rows']) for table in tables)} decisions in {len(tables)} table(s)")
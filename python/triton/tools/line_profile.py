@@ -0,0 +1,186 @@
+"""
+Attributes the samples of the PCs of the warps of a kernel, and the reasons
+they stalled, to the lines of its `@triton.jit` source. The PCs are sampled
+with CUPTI while the kernel runs, and mapped to the lines with the line
+tables of its cubin (see the `line_info` option):
+
+    with line_profile.Sampler() as sampler:
+        compiled = fn[grid](*args)
+    print(line_profile.format_lines(line_profile.report(compiled, sampler)))
+
+Sampling serializes the kernels of the context and slows them down, so the
+samples tell where the warps of a kernel spend their time, not how long it
+runs.
+"""
+
+import linecache
+import os
+import re
+import subprocess
+import tempfile
+from dataclasses import dataclass, field
+from typing import Dict, List
+
+# the stall reasons of CUPTI are the names of the counters of Nsight Compute
+_STALL_PREFIXES = ("smsp__pcsamp_warps_issue_stalled_", "smsp__pcsamp_")
+_SECTION_RE = re.compile(r"^\s*\.section\s+([^,\s]+)")
+_FILE_RE = re.compile(r'//## File "([^"]*)", line (\d+)')
+_LOCATION_RE = re.compile(r'"([^"]*)", line (\d+)')
+_OFFSET_RE = re.compile(r"/\*([0-9a-f]{4,})\*/")
+
+
+def _stall_name(name):
+    for prefix in _STALL_PREFIXES:
+        if name.startswith(prefix):
+            return name[len(prefix):]
+    return name
+
+
+@dataclass
+class Sample:
+    cubin_crc: int
+    function: str
+    pc: int
+    # samples per stall reason; "selected" are the samples of warps issuing
+    stalls: Dict[str, int]
+
+
+@dataclass
+class Line:
+    file: str
+    line: int
+    samples: int = 0
+    stalls: Dict[str, int] = field(default_factory=dict)
+
+    def top_stalls(self, n=3):
+        return sorted(self.stalls.items(), key=lambda item: -item[1])[:n]
+
+
+class Sampler:
+    """
+    Samples the PCs of the kernels launched on the current device within the
+    `with` block, every 2^(5 + `period`) cycles of each SM. CUPTI returns at
+    most `num_pcs` PCs at once; the kernels with more PCs are collected in
+    several rounds.
+    """
+
+    def __init__(self, period=5, num_pcs=4096):
+        self.period = period
+        self.num_pcs = num_pcs
+        self.samples: List[Sample] = []
+        self.total_samples = 0
+        self.dropped_samples = 0
+
+    def __enter__(self):
+        from triton.backends.nvidia.driver import pc_sampling
+        self._module = pc_sampling()
+        reasons = self._module.enable(self.period, self.num_pcs)
+        self._reasons = {index: _stall_name(name) for index, name in reasons.items()}
+        try:
+            self._module.start()
+        except BaseException:
+            self._module.disable()
+            raise
+        return self
+
+    def __exit__(self, *exc):
+        try:
+            samples, total, dropped = self._module.stop()
+        finally:
+            self._module.disable()
+        self.total_samples += total
+        self.dropped_samples += dropped
+        for crc, function, pc, stalls in samples:
+            stalls = {self._reasons.get(index, str(index)): count for index, count in stalls if count}
+            self.samples.append(Sample(crc, function, pc, stalls))
+        return False
+
+
+def line_table(cubin):
+    """
+    Returns the source locations of the instructions of `cubin`, as
+    `{(function, pc offset): [(file, line), ...]}`, innermost first, then the
+    lines the inlined functions were called from. Kernels compiled without
+    `line_info` have no locations.
+    """
+    from triton.backends.nvidia.compiler import _path_to_binary
+    nvdisasm, _ = _path_to_binary("nvdisasm")
+    fd, path = tempfile.mkstemp(suffix=".cubin")
+    try:
+        with open(fd, "wb") as f:
+            f.write(cubin)
+        asm = subprocess.check_output([nvdisasm, "-gi", "-c", path]).decode("utf-8")
+    finally:
+        os.remove(path)
+    table = dict()
+    function, locations = None, []
+    for text in asm.splitlines():
+        match = _SECTION_RE.match(text)
+        if match:
+            # the code of each function is in its own `.text.<name>` section
+            name = match.group(1)
+            function = name[len(".text."):] if name.startswith(".text.") else None
+            locations = []
+            continue
+        if _FILE_RE.search(text):
+            # the location holds until the next one
+            locations = [(file, int(line)) for file, line in _LOCATION_RE.findall(text)]
+            continue
+        match = _OFFSET_RE.search(text)
+        if match and function is not None and locations:
+            table[(function, int(match.group(1), 16))] = locations
+    return table
+
+
+def _attributed(locations, inlined):
+    if inlined:
+        return locations[0]
+    # the innermost line outside of `triton.language`, so that the samples of
+    # `tl.sum` or `tl.cdiv` go to the line of the kernel calling them
+    language = os.path.join(os.path.dirname(os.path.dirname(os.path.abspath(__file__))), "language", "")
+    for file, line in locations:
+        if not os.path.abspath(file).startswith(language):
+            return file, line
+    return locations[0]
+
+
+def report(kernel, sampler, inlined=False) -> List[Line]:
+    """
+    Aggregates the samples of `sampler` that hit `kernel` (a `CompiledKernel`)
+    per source line, the lines with the most samples first. The samples of a
+    line of a function of `triton.language` go to the line calling it, unless
+    `inlined`. The samples of PCs without a location go to the line
+    `("<unknown>", 0)`.
+    """
+    from triton.backends.nvidia.driver import pc_sampling
+    cubin = kernel.asm["cubin"]
+    crc = pc_sampling().cubin_crc(cubin)
+    table = line_table(cubin)
+    lines = dict()
+    for sample in sampler.samples:
+        if sample.cubin_crc != crc:
+            continue
+        locations = table.get((sample.function, sample.pc))
+        key = _attributed(locations, inlined) if locations else ("<unknown>", 0)
+        line = lines.get(key)
+        if line is None:
+            line = lines[key] = Line(*key)
+        for reason, count in sample.stalls.items():
+            line.samples += count
+            line.stalls[reason] = line.stalls.get(reason, 0) + count
+    return sorted(lines.values(), key=lambda line: -line.samples)
+
+
+def format_lines(lines: List[Line], top_stalls=3) -> str:
+    """
+    Formats the lines of `report` as a table of the share of the samples, the
+    location, the main stall reasons and the source of each line.
+    """
+    total = sum(line.samples for line in lines) or 1
+    rows = []
+    for line in lines:
+        stalls = ", ".join(f"{reason} {count / line.samples:.0%}" for reason, count in line.top_stalls(top_stalls))
+        source = linecache.getline(line.file, line.line).strip()
+        location = f"{os.path.basename(line.file)}:{line.line}"
+        rows.append(f"{line.samples / total:6.1%} {line.samples:8d}  {location:<24} {source:<48} {stalls}")
+    return "\n".join(rows)
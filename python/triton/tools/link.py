@@ -145,6 +145,7 @@ def make_global_decl(meta: KernelLinkerMeta) -> str:
 CUresult {meta.orig_kernel_name}_default(CUstream stream, {gen_signature_with_full_args(meta)});
 CUresult {meta.orig_kernel_name}(CUstream stream, {gen_signature_with_full_args(meta)}, int algo_id);
 void load_{meta.orig_kernel_name}();
+void load_{meta.orig_kernel_name}_algo(int algo_id);
 void unload_{meta.orig_kernel_name}();
     """
 
@@ -226,6 +227,16 @@ def make_kernel_load_def(names: str, meta: KernelLinkerMeta) -> str:
         for name in names:
             src += f"  {mode}_{name}();\n"
         src += "}\n\n"
+    # preloading a single algo, e.g. the one a heuristic picks for the expected shapes
+    src += "typedef void (*kernel_load_func_t)(void);\n"
+    src += f"kernel_load_func_t {meta.orig_kernel_name}_loaders[] = {{\n"
+    for name in names:
+        src += f"  load_{name},\n"
+    src += "};\n\n"
+    src += f"void load_{meta.orig_kernel_name}_algo(int algo_id){{\n"
+    src += f"  assert (algo_id < (int)(sizeof({meta.orig_kernel_name}_loaders) / sizeof(kernel_load_func_t)));\n"
+    src += f"  {meta.orig_kernel_name}_loaders[algo_id]();\n"
+    src += "}\n\n"
     return src
 
 
@@ -241,6 +252,83 @@ def make_get_num_algos_def(meta: KernelLinkerMeta) -> str:
     return src
 
 
+# generate declaration of the entry point picking the algo from a decision table
+def make_heuristic_decl(meta: KernelLinkerMeta, table: dict) -> str:
+    key_sig = ", ".join([f"int64_t {name}" for name in table["key_names"]])
+    return f"""
+int {meta.orig_kernel_name}_select_algo({key_sig});
+CUresult {meta.orig_kernel_name}_heuristic(CUstream stream, {gen_signature_with_full_args(meta)});
+    """
+
+
+# generate definition of the entry point picking the algo from a decision table
+# written by export_heuristics.py: the algo of the first rule whose ranges
+# contain the key, and otherwise that of the row with the closest key (in log2
+# space), as in `triton.runtime.autotuner.select_config`.
+# Config `i` of the table must be the i-th algo (i.e. header) given to the linker.
+def make_heuristic_def(meta: KernelLinkerMeta, table: dict) -> str:
+    names = table["key_names"]
+    for name in names:
+        if name not in meta.arg_names:
+            raise LinkerError(f"heuristic key {name} is not an argument of {meta.orig_kernel_name}")
+    rules = table.get("rules", [])
+    rows = table.get("rows", [])
+    if not rows and not rules:
+        raise LinkerError("the decision table is empty")
+    kernel = meta.orig_kernel_name
+    num_keys = len(names)
+    num_rows = len(rows)
+    src = ""
+    if rows:
+        key_values = [
+            ", ".join(["INFINITY" if v == float("inf") else repr(float(v)) for v in row["key"]]) for row in rows
+        ]
+        src += f"static const double {kernel}_heuristic_keys[{num_rows}][{num_keys}] = {{\n"
+        src += "".join([f"  {{{values}}},\n" for values in key_values])
+        src += "};\n"
+        src += f"static const int {kernel}_heuristic_algos[{num_rows}] = {{{', '.join(str(row['config']) for row in rows)}}};\n"
+        src += "\n"
+    src += f"int {kernel}_select_algo({', '.join([f'int64_t {name}' for name in names])}){{\n"
+    for rule in rules:
+        if rule.get("values"):
+            raise LinkerError(f"rule {rule} matches non-integer keys, which can't be dispatched on in C")
+        conds = []
+        for name, (lo, hi) in rule["ranges"].items():
+            if name not in names:
+                raise LinkerError(f"rule {rule} uses {name}, which is not a key of the table")
+            if lo is not None:
+                conds.append(f"{name} >= {int(lo)}")
+            if hi is not None:
+                conds.append(f"{name} < {int(hi)}")
+        src += f"  if ({' && '.join(conds) or '1'})\n"
+        src += f"    return {rule['config']};\n"
+    if not rows:
+        src += f"  return {table.get('default', 0)};\n"
+        src += "}\n"
+    else:
+        src += f"  const double key[{num_keys}] = {{{', '.join([f'log2({name} > 1 ? (double){name} : 1.0)' for name in names])}}};\n"
+        src += "  double best_distance = INFINITY;\n"
+        src += f"  int best = {rows[0]['config']};\n"
+        src += f"  for (int i = 0; i < {num_rows}; i++) {{\n"
+        src += "    double distance = 0;\n"
+        src += f"    for (int j = 0; j < {num_keys}; j++) {{\n"
+        src += f"      double k = {kernel}_heuristic_keys[i][j];\n"
+        src += "      distance += fabs(key[j] - log2(k > 1 ? (k < 0x1p62 ? k : 0x1p62) : 1.0));\n"
+        src += "    }\n"
+        src += "    if (distance < best_distance) {\n"
+        src += "      best_distance = distance;\n"
+        src += f"      best = {kernel}_heuristic_algos[i];\n"
+        src += "    }\n"
+        src += "  }\n"
+        src += "  return best;\n"
+        src += "}\n"
+    src += "\n"
+    src += f"CUresult {kernel}_heuristic(CUstream stream, {gen_signature_with_full_args(meta)}){{\n"
+    src += f"  return {kernel}(stream, {', '.join(meta.arg_names)}, {kernel}_select_algo({', '.join(names)}));\n"
+    src += "}\n"
+    return src
+
+
 desc = """
 Triton ahead-of-time linker:
 
@@ -250,6 +338,17 @@ kernel given the specializations that were compiled.
 
 Example usage:
 python link.py /path/to/headers/*.h -o kernel_name
+
+Kernels are loaded lazily, by the first launch that needs them (from any
+thread). Latency-critical callers can preload them instead, all at once with
+`load_kernel_name()` or one algo at a time with `load_kernel_name_algo(algo_id)`.
+
+With `--heuristics table.json` (a decision table written by
+export_heuristics.py), it also generates `kernel_name_heuristic`, which picks
+the algo from the values of the table's key arguments, using the table's range
+rules (e.g. M/N/K ranges) first and its closest tuned key otherwise. Config `i` of the table
+must then be compiled into the i-th header passed to the linker, and the
+result linked with -lm.
 """
 
 if __name__ == "__main__":
@@ -268,7 +367,15 @@ if __name__ == "__main__":
         default="",
         help="String to prefix kernel dispatcher names",
     )
+    parser.add_argument("--heuristics", type=Path, default=None,
+                        help="Decision table used to generate an entry point that picks the algo itself")
     args = parser.parse_args()
+    table = None
+    if args.heuristics is not None:
+        import json
+        table = json.loads(args.heuristics.read_text())
+        if isinstance(table, list):
+            raise LinkerError(f"{args.heuristics} holds several decision tables, export a single kernel")
 
     # metadata
     parser = HeaderParser()
@@ -292,6 +399,8 @@ if __name__ == "__main__":
         out += get_num_algos_decl
         out += "\n"
         out += global_decl
+        if table is not None:
+            out += make_heuristic_decl(meta, table)
         fp.write(out)
 
     # generate source
@@ -307,6 +416,8 @@ if __name__ == "__main__":
         out += "#include <cuda.h>\n"
         out += "#include <stdint.h>\n"
         out += "#include <assert.h>\n"
+        if table is not None:
+            out += "#include <math.h>\n"
         out += "\n"
         out += "\n".join(defs)
         out += "\n"
@@ -319,4 +430,7 @@ if __name__ == "__main__":
         out += load_unload_def
         out += "\n"
         out += default_algo_kernel
+        if table is not None:
+            out += "\n"
+            out += make_heuristic_def(meta, table)
         fp.write(out)
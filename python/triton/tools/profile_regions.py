@@ -0,0 +1,92 @@
+"""
+Decodes the records of the `tl.profile_begin`/`tl.profile_end` regions of a
+kernel compiled with the `profile_regions` option:
+
+    kernel = fn[grid](*args, profile_regions=64)
+    for name, region in profile_regions.decode(kernel).items():
+        print(name, region.cycles_per_run, region.start, region.end)
+
+The first lane of each warp of the first `profile_regions` programs records,
+per region, the `clock64` cycles it spent in the region, how often it ran it
+and the `globaltimer` (in ns) of its first begin and of its last end.
+"""
+
+import struct
+from dataclasses import dataclass
+from typing import Dict, List
+
+from ..runtime.driver import driver
+
+# the u64 fields of a record, see `ProfileMarkOpConversion`
+_NUM_FIELDS = 5
+
+
+@dataclass
+class Record:
+    program: int
+    warp: int
+    region: str
+    cycles: int
+    count: int
+    start: int
+    end: int
+
+
+@dataclass
+class Region:
+    name: str
+    # summed over the warps that ran the region
+    cycles: int
+    count: int
+    # the number of (program, warp) pairs that ran the region
+    warps: int
+    # the globaltimer of the first begin and of the last end of any warp
+    start: int
+    end: int
+
+    @property
+    def cycles_per_run(self):
+        return self.cycles / self.count if self.count else 0.0
+
+
+def records(kernel, reset=True) -> List[Record]:
+    """
+    Returns the records of the regions that ran, per program and warp, since
+    the kernel was loaded or last read. The records are zeroed if `reset`.
+    """
+    names = getattr(kernel.metadata, "profile_region_names", None)
+    if not names:
+        return []
+    kernel._init_handles()
+    data = driver.utils.read_global(kernel.module, "triton_profile_records", reset)
+    fields = struct.unpack(f"{len(data) // 8}Q", data)
+    num_warps = kernel.metadata.num_warps
+    ret = []
+    for i in range(len(fields) // _NUM_FIELDS):
+        _, cycles, count, start, end = fields[i * _NUM_FIELDS:(i + 1) * _NUM_FIELDS]
+        if count == 0:
+            continue
+        program, rest = divmod(i, num_warps * len(names))
+        warp, region = divmod(rest, len(names))
+        ret.append(Record(program, warp, names[region], cycles, count, start, end))
+    return ret
+
+
+def decode(kernel, reset=True) -> Dict[str, Region]:
+    """
+    Aggregates the records of `kernel` per region, in the order the regions
+    appear in the kernel.
+    """
+    regions = dict()
+    for record in records(kernel, reset):
+        region = regions.get(record.region)
+        if region is None:
+            regions[record.region] = Region(record.region, record.cycles, record.count, 1, record.start, record.end)
+            continue
+        region.cycles += record.cycles
+        region.count += record.count
+        region.warps += 1
+        region.start = min(region.start, record.start)
+        region.end = max(region.end, record.end)
+    names = kernel.metadata.profile_region_names
+    return {name: regions[name] for name in names if name in regions}
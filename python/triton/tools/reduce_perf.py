@@ -0,0 +1,141 @@
+import json
+import subprocess
+import sys
+from argparse import ArgumentParser
+from pathlib import Path
+
+desc = """
+Triton performance interestingness test:
+
+This program is an interestingness test for `triton-reduce`, to minimize the
+reproducer of a performance regression instead of a crash. It compiles the
+candidate `.ttir` or `.ttgir` file and measures `--metric` on it:
+
+  shared          shared memory of the kernel, in bytes
+  registers       registers per thread (loads the kernel on the device)
+  spills          spilled registers (loads the kernel on the device)
+  convert_layout  number of `triton_gpu.convert_layout` in the TTGIR
+  time            median run time in milliseconds
+
+The candidate is interesting (exit code 1) when the metric is above `--above`
+and/or below `--below`. With `--reference-python`, the thresholds are ratios
+to the metric measured by another Triton installation, e.g. the version
+before the regression, on the same candidate. Candidates that no longer
+compile are not interesting.
+
+To time a kernel, each pointer argument gets a zeroed buffer of `--numel`
+elements, each integer argument the value `--int-arg` and each float
+argument 1.0, and the kernel is launched on `--grid`. The reduction must keep
+the accesses of the kernel in bounds of these buffers: pick a `--numel` at
+least as large as what the original kernel accesses.
+
+The reducer passes the candidate as the last argument of its test, so the
+options go in a wrapper script, e.g. `interesting.sh`:
+
+#!/bin/sh
+exec python /path/to/reduce_perf.py --metric time --above 1.2 \\
+    --reference-python /path/to/old/venv/bin/python --grid 128 "$@"
+
+triton-reduce slow.ttgir -reduction-tree='traversal-mode=0 test=interesting.sh'
+"""
+
+_dtypes = {
+    "i1": "int8", "i8": "int8", "i16": "int16", "i32": "int32", "i64": "int64", "u8": "uint8", "fp16": "float16",
+    "f16": "float16", "bf16": "bfloat16", "fp32": "float32", "f32": "float32", "fp64": "float64", "f64": "float64"
+}
+
+
+def _make_args(signature, numel, int_arg):
+    import torch
+    args = []
+    for ty in signature.values():
+        if ty.startswith("*"):
+            # other element types (e.g. fp8) are read through a byte buffer
+            dtype = getattr(torch, _dtypes.get(ty[1:], "uint8"))
+            args.append(torch.zeros(numel, dtype=dtype, device="cuda"))
+        elif ty.startswith("f") or ty.startswith("bf"):
+            args.append(1.0)
+        else:
+            args.append(int_arg)
+    return args
+
+
+def measure(path, metric, options, grid, numel, int_arg):
+    """
+    Compiles the IR file at `path` with `options` and returns the value of
+    `metric` (see the description of the program) for it.
+    """
+    import triton
+    import triton.testing
+    from triton.compiler.compiler import IRSource
+
+    kernel = triton.compile(str(path), options=options)
+    if metric == "shared":
+        return kernel.metadata.shared
+    if metric == "convert_layout":
+        return kernel.asm["ttgir"].count("triton_gpu.convert_layout")
+    if metric in ("registers", "spills"):
+        kernel._init_handles()
+        return kernel.n_regs if metric == "registers" else kernel.n_spills
+    if metric == "time":
+        args = _make_args(IRSource(str(path)).signature, numel, int_arg)
+        launch = kernel[tuple(grid) + (1, ) * (3 - len(grid))]
+        return triton.testing.do_bench(lambda: launch(*args), return_mode="median")
+    raise ValueError(f"unknown metric {metric}")
+
+
+def _measure_with(python, path, args):
+    cmd = [python, __file__, "--print", "--metric", args.metric, "--options", json.dumps(args.options)]
+    cmd += ["--grid", ",".join(map(str, args.grid)), "--numel", str(args.numel), "--int-arg", str(args.int_arg)]
+    cmd.append(str(path))
+    out = subprocess.run(cmd, check=True, stdout=subprocess.PIPE, text=True).stdout
+    # the value is on the last line, after anything the compiler printed
+    return float(out.strip().splitlines()[-1])
+
+
+def is_interesting(value, reference, above, below):
+    if reference is not None:
+        # a metric that vanished on both sides can't tell the versions apart
+        if reference == 0:
+            return False
+        value = value / reference
+    return (above is None or value > above) and (below is None or value < below)
+
+
+if __name__ == "__main__":
+    parser = ArgumentParser(description=desc)
+    parser.add_argument("path", type=Path, help="The candidate IR file")
+    parser.add_argument("--metric", type=str, default="time",
+                        choices=["shared", "registers", "spills", "convert_layout", "time"])
+    parser.add_argument("--above", type=float, default=None, help="Interesting when the metric is above this")
+    parser.add_argument("--below", type=float, default=None, help="Interesting when the metric is below this")
+    parser.add_argument("--reference-python", type=str, default=None,
+                        help="Python interpreter of the Triton installation the thresholds are relative to")
+    parser.add_argument("--options", type=json.loads, default={},
+                        help="Compiler options as a JSON object, e.g. '{\"num_stages\": 3}'")
+    parser.add_argument("--grid", type=lambda s: [int(x) for x in s.split(",")], default=[1],
+                        help="Launch grid for `--metric time`, e.g. `128,4`")
+    parser.add_argument("--numel", type=int, default=1 << 20, help="Number of elements of the buffer arguments")
+    parser.add_argument("--int-arg", type=int, default=1 << 20, help="Value of the integer arguments")
+    parser.add_argument("--print", action="store_true", help="Print the metric instead of testing it")
+    args = parser.parse_args()
+
+    if args.above is None and args.below is None and not args.print:
+        parser.error("one of --above or --below is required")
+    try:
+        value = measure(args.path, args.metric, args.options, args.grid, args.numel, args.int_arg)
+        reference = None
+        if args.reference_python is not None:
+            reference = _measure_with(args.reference_python, args.path, args)
+    except Exception as e:
+        if args.print:
+            raise
+        # broken candidates are not interesting
+        print(f"{args.path}: {e}", file=sys.stderr)
+        sys.exit(0)
+    if args.print:
+        print(value)
+        sys.exit(0)
+    print(f"{args.path}: {args.metric} = {value}" + ("" if reference is None else f" (reference {reference})"),
+          file=sys.stderr)
+    sys.exit(1 if is_interesting(value, reference, args.above, args.below) else 0)
@@ -229,11 +229,11 @@ tt.func @cmp() {
   %1 = arith.constant dense<0> : tensor<128xi32>
   // CHECK-NEXT: contiguity = [1], divisibility = [1], constancy = [128], constant_value = <none>
   %2 = arith.cmpi eq, %0, %1 : tensor<128xi32>
-  // CHECK-NEXT: contiguity = [1], divisibility = [1], constancy = [128], constant_value = <none>
+  // CHECK-NEXT: contiguity = [1], divisibility = [1], constancy = [128], constant_value = 0
   %3 = arith.cmpi slt, %0, %1 : tensor<128xi32>
   // CHECK-NEXT: contiguity = [1], divisibility = [1], constancy = [1], constant_value = <none>
   %4 = arith.cmpi sle, %0, %1 : tensor<128xi32>
-  // CHECK-NEXT: contiguity = [1], divisibility = [1], constancy = [128], constant_value = <none>
+  // CHECK-NEXT: contiguity = [1], divisibility = [1], constancy = [128], constant_value = 1
   %5 = arith.cmpi sge, %0, %1 : tensor<128xi32>
   // CHECK-NEXT: contiguity = [1], divisibility = [8], constancy = [128], constant_value = 8
   %6 = arith.constant dense<8> : tensor<128xi32>
@@ -283,7 +283,7 @@ tt.func @select(%arg0 : i1, %arg1 : tensor<4xi1>) {
   %1 = arith.constant dense<0> : tensor<128xi32>
   // CHECK-NEXT: contiguity = [1], divisibility = [1], constancy = [128], constant_value = <none>
   %2 = arith.cmpi eq, %0, %1 : tensor<128xi32>
-  // CHECK-NEXT: contiguity = [1], divisibility = [1], constancy = [128], constant_value = <none>
+  // CHECK-NEXT: contiguity = [1], divisibility = [1], constancy = [128], constant_value = 0
   %3 = arith.cmpi slt, %0, %1 : tensor<128xi32>
   // CHECK-NEXT: contiguity = [1], divisibility = [4611686018427387904], constancy = [1], constant_value = 0
   %4 = arith.constant 0 : i1
@@ -295,7 +295,7 @@ tt.func @select(%arg0 : i1, %arg1 : tensor<4xi1>) {
   %8 = arith.select %7, %3, %2 : tensor<128xi1>, tensor<128xi1>
   // CHECK-NEXT: contiguity = [1, 1], divisibility = [1, 1], constancy = [128, 1], constant_value = <none>
   %9 = tt.expand_dims %2 {axis = 1 : i32} : (tensor<128xi1>) -> tensor<128x1xi1>
-  // CHECK-NEXT: contiguity = [1, 1], divisibility = [1, 1], constancy = [128, 1], constant_value = <none>
+  // CHECK-NEXT: contiguity = [1, 1], divisibility = [1, 4611686018427387904], constancy = [128, 1], constant_value = 0
   %10 = tt.expand_dims %3 {axis = 1 : i32} : (tensor<128xi1>) -> tensor<128x1xi1>
   // CHECK-NEXT: contiguity = [1, 1], divisibility = [1, 1], constancy = [128, 1], constant_value = <none>
   %11 = arith.select %arg0, %9, %10 : tensor<128x1xi1>
@@ -390,6 +390,66 @@ tt.func @for_dynamic(%lb: index {tt.divisibility = 16 : i32}, %step: index {tt.d
 
 // -----
 
+// CHECK-LABEL: @range
+tt.func @range() {
+  // CHECK: contiguity = [128], divisibility = [1073741824], constancy = [1], constant_value = <none>, range = [0, 127]
+  %0 = tt.make_range {end = 128 : i32, start = 0 : i32} : tensor<128xi32>
+  // CHECK-NEXT: constant_value = 2, range = [2, 2]
+  %1 = arith.constant dense<2> : tensor<128xi32>
+  // CHECK-NEXT: constant_value = <none>, range = [0, 254]
+  %2 = arith.muli %0, %1 : tensor<128xi32>
+  // CHECK-NEXT: constant_value = <none>, range = [-2, 252]
+  %3 = arith.subi %2, %1 : tensor<128xi32>
+  // CHECK-NEXT: constant_value = 256, range = [256, 256]
+  %4 = arith.constant dense<256> : tensor<128xi32>
+  // CHECK-NEXT: contiguity = [1], divisibility = [1], constancy = [128], constant_value = 1, range = <none>
+  %5 = arith.cmpi slt, %3, %4 : tensor<128xi32>
+  // CHECK-NEXT: contiguity = [1], divisibility = [1], constancy = [1], constant_value = <none>, range = <none>
+  %6 = arith.cmpi ult, %3, %4 : tensor<128xi32>
+  // CHECK-NEXT: constant_value = -1, range = [-1, -1]
+  %7 = arith.constant -1 : i64
+  // CHECK-NEXT: constant_value = 65536, range = [65536, 65536]
+  %8 = arith.constant dense<65536> : tensor<128xi32>
+  // The product overflows
+  // CHECK-NEXT: range = <none>
+  %9 = arith.muli %8, %8 : tensor<128xi32>
+  tt.return
+}
+
+// -----
+
+// CHECK-LABEL: @for_range
+tt.func @for_range() {
+  %c0_i32 = arith.constant 0 : i32
+  %c128_i32 = arith.constant 128 : i32
+  %c1000_i32 = arith.constant 1000 : i32
+  %c1024_i32 = arith.constant 1024 : i32
+  %0 = tt.make_range {end = 128 : i32, start = 0 : i32} : tensor<128xi32>
+  %1 = tt.splat %c1024_i32 : (i32) -> tensor<128xi32>
+  %2 = tt.splat %c1000_i32 : (i32) -> tensor<128xi32>
+  scf.for %k = %c0_i32 to %c1024_i32 step %c128_i32 : i32 {
+    // CHECK: tt.splat %{{.*}} => {{.*}}, range = [0, 896]
+    %3 = tt.splat %k : (i32) -> tensor<128xi32>
+    // CHECK-NEXT: range = [0, 1023]
+    %4 = arith.addi %3, %0 : tensor<128xi32>
+    // Full tiles are in bounds on every iteration
+    // CHECK-NEXT: contiguity = [1], divisibility = [1], constancy = [128], constant_value = 1
+    %5 = arith.cmpi slt, %4, %1 : tensor<128xi32>
+  }
+  scf.for %k = %c0_i32 to %c1000_i32 step %c128_i32 : i32 {
+    // CHECK: tt.splat %{{.*}} => {{.*}}, range = [0, 896]
+    %3 = tt.splat %k : (i32) -> tensor<128xi32>
+    // CHECK-NEXT: range = [0, 1023]
+    %4 = arith.addi %3, %0 : tensor<128xi32>
+    // The last tile is partial
+    // CHECK-NEXT: contiguity = [1], divisibility = [1], constancy = [8], constant_value = <none>
+    %5 = arith.cmpi slt, %4, %2 : tensor<128xi32>
+  }
+  tt.return
+}
+
+// -----
+
 // CHECK-LABEL: @permute_2d
 tt.func @permute_2d(%arg0: !tt.ptr<f32> {tt.divisibility = 16 : i32}, %arg1: i32 {tt.divisibility = 16 : i32}, %arg2: !tt.ptr<f32> {tt.divisibility = 16 : i32}, %arg3: i32 {tt.divisibility = 16 : i32}) {
   // CHECK: contiguity = [1, 1], divisibility = [1, 1], constancy = [128, 128], constant_value = 1
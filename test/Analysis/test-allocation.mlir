@@ -1,4 +1,5 @@
 // RUN: triton-opt %s -split-input-file --mlir-disable-threading -test-print-allocation 2>&1 | FileCheck %s
+// RUN: env TRITON_OPTIMAL_SMEM_ALLOCATION=1 triton-opt %s -split-input-file --mlir-disable-threading -test-print-allocation 2>&1 | FileCheck %s --check-prefix=OPT
 
 #AL = #triton_gpu.blocked<{sizePerThread = [1, 4], threadsPerWarp = [4, 8], warpsPerCTA = [4, 1], order = [1, 0], CTAsPerCGA = [1, 1], CTASplitNum = [1, 1], CTAOrder = [1, 0]}>
 #sliceAd0 = #triton_gpu.slice<{dim = 0, parent = #AL}>
@@ -111,6 +112,37 @@ tt.func @preallocate(%A : !tt.ptr<f16>) {
   // CHECK-NEXT: size = 12288
 }
 
+// The heuristic leaves holes the branch and bound search fills: it needs no
+// more than the largest amount of memory live at once
+// CHECK-LABEL: optimal_chain
+// OPT-LABEL: optimal_chain
+tt.func @optimal_chain(%A : !tt.ptr<f16>) {
+  // CHECK: offset = 0, size = 512
+  // OPT: offset = 1024, size = 512
+  %cst0 = arith.constant dense<0.000000e+00> : tensor<16x16xf16, #A_SHARED>
+  // CHECK-NEXT: offset = 1024, size = 512
+  // OPT-NEXT: offset = 2048, size = 512
+  %cst1 = arith.constant dense<0.000000e+00> : tensor<16x16xf16, #A_SHARED>
+  // CHECK-NEXT: offset = 2048, size = 1024
+  // OPT-NEXT: offset = 0, size = 1024
+  %a = tt.cat %cst0, %cst1 {axis = 0} : (tensor<16x16xf16, #A_SHARED>, tensor<16x16xf16, #A_SHARED>) -> tensor<32x16xf16, #A_SHARED>
+  // CHECK-NEXT: offset = 0, size = 1024
+  // OPT-NEXT: offset = 1024, size = 1024
+  %cst2 = arith.constant dense<0.000000e+00> : tensor<32x16xf16, #A_SHARED>
+  // CHECK-NEXT: offset = 5120, size = 2048
+  // OPT-NEXT: offset = 4096, size = 2048
+  %b = tt.cat %cst2, %a {axis = 0} : (tensor<32x16xf16, #A_SHARED>, tensor<32x16xf16, #A_SHARED>) -> tensor<64x16xf16, #A_SHARED>
+  // CHECK-NEXT: offset = 0, size = 2048
+  // OPT-NEXT: offset = 6144, size = 2048
+  %cst3 = arith.constant dense<0.000000e+00> : tensor<64x16xf16, #A_SHARED>
+  // CHECK-NEXT: offset = 11264, size = 4096
+  // OPT-NEXT: offset = 0, size = 4096
+  %c = tt.cat %cst3, %b {axis = 0} : (tensor<64x16xf16, #A_SHARED>, tensor<64x16xf16, #A_SHARED>) -> tensor<128x16xf16, #A_SHARED>
+  tt.return
+  // CHECK-NEXT: size = 15360
+  // OPT-NEXT: size = 8192
+}
+
 // Unused tensors are immediately released
 // CHECK-LABEL: unused
 tt.func @unused(%A : !tt.ptr<f16>) {
@@ -166,13 +198,13 @@ tt.func @multi_color(%A : !tt.ptr<f16>) {
   %cst_1 = arith.constant dense<0.000000e+00> : tensor<16x4xf16, #A_SHARED>
   %cst_2 = arith.constant dense<0.000000e+00> : tensor<16x32xf16, #AL>
   // CHECK-NEXT: scratch offset = 128, size = 1152
-  %0 = triton_gpu.convert_layout %cst_2 : (tensor<16x32xf16, #AL>) -> tensor<16x32xf16, #AL>
+  %0 = triton_gpu.convert_layout %cst_2 : (tensor<16x32xf16, #AL>) -> tensor<16x32xf16, #BL>
   %1 = triton_gpu.convert_layout %cst : (tensor<4x8xf16, #A_SHARED>) -> tensor<4x8xf16, #AL>
   // CHECK-NEXT: offset = 0, size = 128
   %cst_3 = arith.constant dense<0.000000e+00> : tensor<4x16xf16, #A_SHARED>
   %2 = triton_gpu.convert_layout %cst_0 : (tensor<4x4xf16, #A_SHARED>) -> tensor<4x4xf16, #AL>
   // CHECK-NEXT: scratch offset = 0, size = 1152
-  %3 = triton_gpu.convert_layout %cst_2 : (tensor<16x32xf16, #AL>) -> tensor<16x32xf16, #AL>
+  %3 = triton_gpu.convert_layout %cst_2 : (tensor<16x32xf16, #AL>) -> tensor<16x32xf16, #BL>
   // CHECK-NEXT: offset = 0, size = 256
   %cst_4 = arith.constant dense<0.000000e+00> : tensor<4x32xf16, #A_SHARED>
   // CHECK-NEXT: offset = 256, size = 64
@@ -193,7 +225,7 @@ tt.func @multi_color(%A : !tt.ptr<f16>) {
   %7 = triton_gpu.convert_layout %cst_1 : (tensor<16x4xf16, #A_SHARED>) -> tensor<16x4xf16, #AL>
   %8 = triton_gpu.convert_layout %cst_4 : (tensor<4x32xf16, #A_SHARED>) -> tensor<4x32xf16, #AL>
   // CHECK-NEXT: scratch offset = 0, size = 1152
-  %9 = triton_gpu.convert_layout %cst_2 : (tensor<16x32xf16, #AL>) -> tensor<16x32xf16, #AL>
+  %9 = triton_gpu.convert_layout %cst_2 : (tensor<16x32xf16, #AL>) -> tensor<16x32xf16, #BL>
   %cst_11 = arith.constant dense<0.000000e+00> : tensor<4x4xf16, #AL>
   %10 = triton_gpu.convert_layout %cst_7 : (tensor<2x32xf16, #A_SHARED>) -> tensor<2x32xf16, #AL>
   %cst_12 = arith.constant dense<0.000000e+00> : tensor<4x16xf16, #AL>
@@ -213,7 +245,7 @@ tt.func @multi_color_multi_rounds(%arg0: !tt.ptr<f16>) {
   %cst_1 = arith.constant dense<0.000000e+00> : tensor<1024x4xf16, #A_SHARED>
   %cst_2 = arith.constant dense<0.000000e+00> : tensor<16x32xf16, #AL>
   // CHECK-NEXT: scratch offset = 128, size = 1152
-  %0 = triton_gpu.convert_layout %cst_2 : (tensor<16x32xf16, #AL>) -> tensor<16x32xf16, #AL>
+  %0 = triton_gpu.convert_layout %cst_2 : (tensor<16x32xf16, #AL>) -> tensor<16x32xf16, #BL>
   %1 = triton_gpu.convert_layout %cst : (tensor<4x4xf16, #A_SHARED>) -> tensor<4x4xf16, #AL>
   // CHECK-NEXT: offset = 1152, size = 128
   %cst_3 = arith.constant dense<0.000000e+00> : tensor<2x32xf16, #A_SHARED>
@@ -223,7 +255,7 @@ tt.func @multi_color_multi_rounds(%arg0: !tt.ptr<f16>) {
   %3 = triton_gpu.convert_layout %cst_0 : (tensor<16x4xf16, #A_SHARED>) -> tensor<16x4xf16, #AL>
   %4 = triton_gpu.convert_layout %cst_1 : (tensor<1024x4xf16, #A_SHARED>) -> tensor<1024x4xf16, #AL>
   // CHECK-NEXT: scratch offset = 0, size = 1152
-  %5 = triton_gpu.convert_layout %cst_2 : (tensor<16x32xf16, #AL>) -> tensor<16x32xf16, #AL>
+  %5 = triton_gpu.convert_layout %cst_2 : (tensor<16x32xf16, #AL>) -> tensor<16x32xf16, #BL>
   %6 = triton_gpu.convert_layout %cst_3 : (tensor<2x32xf16, #A_SHARED>) -> tensor<2x32xf16, #AL>
   // CHECK-NEXT: size = 10240
   tt.return
@@ -253,6 +285,24 @@ tt.func @dealloc(%A : !tt.ptr<f16>) {
   // CHECK-NEXT: size = 2048
 }
 
+// The buffers of the pipeline stages are freed after the loop, so that the
+// epilogue reuses their shared memory
+// CHECK-LABEL: stages_reused_by_epilogue
+tt.func @stages_reused_by_epilogue(%lb : index, %ub : index, %step : index) {
+  // CHECK: offset = 0, size = 24576
+  %stages = triton_gpu.alloc_tensor : tensor<3x128x32xf16, #A_SHARED>
+  %cst = arith.constant dense<0.000000e+00> : tensor<128x32xf16, #AL>
+  %loop = scf.for %iv = %lb to %ub step %step iter_args(%buffers = %stages) -> (tensor<3x128x32xf16, #A_SHARED>) {
+    scf.yield %buffers : tensor<3x128x32xf16, #A_SHARED>
+  }
+  triton_gpu.async_wait {num = 0 : i32}
+  triton_gpu.dealloc_tensor %stages : tensor<3x128x32xf16, #A_SHARED>
+  // CHECK-NEXT: offset = 0, size = 8192
+  %epilogue = triton_gpu.convert_layout %cst : (tensor<128x32xf16, #AL>) -> tensor<128x32xf16, #A_SHARED>
+  tt.return
+  // CHECK-NEXT: size = 24576
+}
+
 // mbarrier's shared memory cannot be reused
 // CHECK-LABEL: alloc_m_barrier
 tt.func @alloc_m_barrier() {
@@ -580,4 +630,28 @@ tt.func @call_graph_2(%A : !tt.ptr<f16>, %cond : i1) {
   // CHECK-NEXT: size = 1024
 }
 
+// CHECK-LABEL: sequential_calls
+tt.func @sequential_calls(%A : !tt.ptr<f16>, %cond : i1) {
+  // CHECK: virtual offset = 0, size = 512
+  tt.call @alloc1(%A) : (!tt.ptr<f16>) -> ()
+  // CHECK-NEXT: virtual offset = 0, size = 1024
+  tt.call @alloc2(%A) : (!tt.ptr<f16>) -> ()
+  // CHECK-NEXT: virtual offset = 0, size = 1024
+  tt.call @alloc3(%cond) : (i1) -> ()
+  tt.return
+  // CHECK-NEXT: size = 1024
+}
+
+// CHECK-LABEL: call_alignment
+tt.func @call_alignment(%A : !tt.ptr<f16>) {
+  // CHECK: offset = 0, size = 512
+  %cst0 = triton_gpu.alloc_tensor : tensor<16x16xf16, #A_SHARED>
+  // The callee's buffer is 1024-byte aligned
+  // CHECK-NEXT: virtual offset = 1024, size = 512
+  tt.call @alloc1(%A) : (!tt.ptr<f16>) -> ()
+  %0 = triton_gpu.convert_layout %cst0 : (tensor<16x16xf16, #A_SHARED>) -> tensor<16x16xf16, #AL>
+  tt.return
+  // CHECK-NEXT: size = 1536
+}
+
 }
@@ -0,0 +1,58 @@
+// RUN: triton-opt %s -split-input-file --mlir-disable-threading -test-print-bank-conflicts 2>&1 | FileCheck %s
+
+#blocked = #triton_gpu.blocked<{sizePerThread = [1, 4], threadsPerWarp = [4, 8], warpsPerCTA = [4, 1], order = [1, 0], CTAsPerCGA = [1, 1], CTASplitNum = [1, 1], CTAOrder = [1, 0]}>
+#shared = #triton_gpu.shared<{vec = 4, perPhase = 1, maxPhase = 1, order = [1, 0], CTAsPerCGA = [1, 1], CTASplitNum = [1, 1], CTAOrder = [1, 0]}>
+#shared1 = #triton_gpu.shared<{vec = 1, perPhase = 1, maxPhase = 1, order = [1, 0], CTAsPerCGA = [1, 1], CTASplitNum = [1, 1], CTAOrder = [1, 0]}>
+module attributes {"triton_gpu.num-warps" = 4 : i32, "triton_gpu.num-ctas" = 1 : i32, "triton_gpu.threads-per-warp" = 32 : i32} {
+
+// Each quarter of the warp stores 128 contiguous bytes of a row
+// CHECK: store: wavefronts = 16, conflicts = 0
+// CHECK-NEXT: best: vec = 4, perPhase = 1, maxPhase = 1
+// CHECK-NEXT: load: wavefronts = 16, conflicts = 0
+tt.func @vectorized(%x: tensor<32x64xf32, #blocked>) -> tensor<32x64xf32, #blocked> {
+  %0 = triton_gpu.convert_layout %x : (tensor<32x64xf32, #blocked>) -> tensor<32x64xf32, #shared>
+  %1 = triton_gpu.convert_layout %0 : (tensor<32x64xf32, #shared>) -> tensor<32x64xf32, #blocked>
+  tt.return %1 : tensor<32x64xf32, #blocked>
+}
+
+// Scalar accesses: the 4 rows of the warp hit the same banks
+// CHECK: store: wavefronts = 64, conflicts = 48
+// CHECK-NEXT: best: vec = 4, perPhase = 1, maxPhase = 1
+// CHECK-NEXT: load: wavefronts = 64, conflicts = 48
+tt.func @scalar(%x: tensor<32x64xf32, #blocked>) -> tensor<32x64xf32, #blocked> {
+  %0 = triton_gpu.convert_layout %x : (tensor<32x64xf32, #blocked>) -> tensor<32x64xf32, #shared1>
+  %1 = triton_gpu.convert_layout %0 : (tensor<32x64xf32, #shared1>) -> tensor<32x64xf32, #blocked>
+  tt.return %1 : tensor<32x64xf32, #blocked>
+}
+
+}
+
+// -----
+
+#blocked = #triton_gpu.blocked<{sizePerThread = [1, 1], threadsPerWarp = [32, 1], warpsPerCTA = [4, 1], order = [1, 0], CTAsPerCGA = [1, 1], CTASplitNum = [1, 1], CTAOrder = [1, 0]}>
+#shared = #triton_gpu.shared<{vec = 1, perPhase = 1, maxPhase = 1, order = [1, 0], CTAsPerCGA = [1, 1], CTASplitNum = [1, 1], CTAOrder = [1, 0]}>
+#shared1 = #triton_gpu.shared<{vec = 1, perPhase = 2, maxPhase = 16, order = [1, 0], CTAsPerCGA = [1, 1], CTASplitNum = [1, 1], CTAOrder = [1, 0]}>
+module attributes {"triton_gpu.num-warps" = 4 : i32, "triton_gpu.num-ctas" = 1 : i32, "triton_gpu.threads-per-warp" = 32 : i32} {
+
+// Each lane accesses a row of 16 elements: the even and the odd rows of the
+// warp hit two banks. Swizzling each pair of rows apart spreads them over all
+// the banks.
+// CHECK: store: wavefronts = 256, conflicts = 240
+// CHECK-NEXT: best: vec = 1, perPhase = 2, maxPhase = 16
+// CHECK-NEXT: load: wavefronts = 256, conflicts = 240
+tt.func @column(%x: tensor<128x16xf32, #blocked>) -> tensor<128x16xf32, #blocked> {
+  %0 = triton_gpu.convert_layout %x : (tensor<128x16xf32, #blocked>) -> tensor<128x16xf32, #shared>
+  %1 = triton_gpu.convert_layout %0 : (tensor<128x16xf32, #shared>) -> tensor<128x16xf32, #blocked>
+  tt.return %1 : tensor<128x16xf32, #blocked>
+}
+
+// CHECK: store: wavefronts = 16, conflicts = 0
+// CHECK-NEXT: best: vec = 1, perPhase = 2, maxPhase = 16
+// CHECK-NEXT: load: wavefronts = 16, conflicts = 0
+tt.func @column_swizzled(%x: tensor<128x16xf32, #blocked>) -> tensor<128x16xf32, #blocked> {
+  %0 = triton_gpu.convert_layout %x : (tensor<128x16xf32, #blocked>) -> tensor<128x16xf32, #shared1>
+  %1 = triton_gpu.convert_layout %0 : (tensor<128x16xf32, #shared1>) -> tensor<128x16xf32, #blocked>
+  tt.return %1 : tensor<128x16xf32, #blocked>
+}
+
+}
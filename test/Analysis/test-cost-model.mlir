@@ -0,0 +1,87 @@
+// RUN: triton-opt %s -split-input-file --mlir-disable-threading -test-print-cost-model 2>&1 | FileCheck %s
+
+#blocked = #triton_gpu.blocked<{sizePerThread = [4], threadsPerWarp = [32], warpsPerCTA = [4], order = [0], CTAsPerCGA = [1], CTASplitNum = [1], CTAOrder = [0]}>
+module attributes {"triton_gpu.num-warps" = 4 : i32, "triton_gpu.num-ctas" = 1 : i32, "triton_gpu.threads-per-warp" = 32 : i32} {
+
+// 512 f32 in 16 byte vectors, 16 times
+// CHECK-LABEL: vector_copy
+// CHECK: global load bytes = 32768, accesses = 2048
+// CHECK: global store bytes = 32768, accesses = 2048
+// CHECK: shared bytes = 0, max bank conflicts = 1
+// CHECK: barriers = 0, dynamic loops = 0
+tt.func @vector_copy(%src: !tt.ptr<f32, 1> {tt.divisibility = 16 : i32}, %dst: !tt.ptr<f32, 1> {tt.divisibility = 16 : i32}) {
+  %c0 = arith.constant 0 : i32
+  %c1 = arith.constant 1 : i32
+  %c16 = arith.constant 16 : i32
+  %range = tt.make_range {end = 512 : i32, start = 0 : i32} : tensor<512xi32, #blocked>
+  %src_splat = tt.splat %src : (!tt.ptr<f32, 1>) -> tensor<512x!tt.ptr<f32, 1>, #blocked>
+  %src_ptrs = tt.addptr %src_splat, %range : tensor<512x!tt.ptr<f32, 1>, #blocked>, tensor<512xi32, #blocked>
+  %dst_splat = tt.splat %dst : (!tt.ptr<f32, 1>) -> tensor<512x!tt.ptr<f32, 1>, #blocked>
+  %dst_ptrs = tt.addptr %dst_splat, %range : tensor<512x!tt.ptr<f32, 1>, #blocked>, tensor<512xi32, #blocked>
+  scf.for %i = %c0 to %c16 step %c1 : i32 {
+    %x = tt.load %src_ptrs {cache = 1 : i32, evict = 1 : i32, isVolatile = false} : tensor<512xf32, #blocked>
+    tt.store %dst_ptrs, %x {cache = 1 : i32, evict = 1 : i32} : tensor<512xf32, #blocked>
+  }
+  tt.return
+}
+
+// Unaligned pointers are accessed one element at a time, and loops with
+// dynamic bounds are counted once
+// CHECK-LABEL: scalar_copy
+// CHECK: global load bytes = 2048, accesses = 512
+// CHECK: barriers = 0, dynamic loops = 1
+tt.func @scalar_copy(%src: !tt.ptr<f32, 1>, %dst: !tt.ptr<f32, 1>, %n: i32) {
+  %c0 = arith.constant 0 : i32
+  %c1 = arith.constant 1 : i32
+  %range = tt.make_range {end = 512 : i32, start = 0 : i32} : tensor<512xi32, #blocked>
+  %src_splat = tt.splat %src : (!tt.ptr<f32, 1>) -> tensor<512x!tt.ptr<f32, 1>, #blocked>
+  %src_ptrs = tt.addptr %src_splat, %range : tensor<512x!tt.ptr<f32, 1>, #blocked>, tensor<512xi32, #blocked>
+  %dst_splat = tt.splat %dst : (!tt.ptr<f32, 1>) -> tensor<512x!tt.ptr<f32, 1>, #blocked>
+  %dst_ptrs = tt.addptr %dst_splat, %range : tensor<512x!tt.ptr<f32, 1>, #blocked>, tensor<512xi32, #blocked>
+  scf.for %i = %c0 to %n step %c1 : i32 {
+    %x = tt.load %src_ptrs {cache = 1 : i32, evict = 1 : i32, isVolatile = false} : tensor<512xf32, #blocked>
+    tt.store %dst_ptrs, %x {cache = 1 : i32, evict = 1 : i32} : tensor<512xf32, #blocked>
+  }
+  tt.return
+}
+
+}
+
+// -----
+
+#row = #triton_gpu.blocked<{sizePerThread = [1, 4], threadsPerWarp = [1, 32], warpsPerCTA = [4, 1], order = [1, 0], CTAsPerCGA = [1, 1], CTASplitNum = [1, 1], CTAOrder = [1, 0]}>
+#col = #triton_gpu.blocked<{sizePerThread = [4, 1], threadsPerWarp = [32, 1], warpsPerCTA = [1, 4], order = [0, 1], CTAsPerCGA = [1, 1], CTASplitNum = [1, 1], CTAOrder = [1, 0]}>
+module attributes {"triton_gpu.num-warps" = 4 : i32, "triton_gpu.num-ctas" = 1 : i32, "triton_gpu.threads-per-warp" = 32 : i32, "triton_gpu.compute-capability" = 80 : i32} {
+
+// A transpose through shared memory: both sides are counted, and it needs a
+// barrier
+// CHECK-LABEL: transpose
+// CHECK: convert_layout: shared bytes = 131072, bank conflicts =
+// CHECK: shared bytes = 131072
+// CHECK: barriers = 1
+// CHECK: shared memory = {{[0-9]+}}, occupancy = {{[0-9]+}}
+tt.func @transpose(%arg0: tensor<128x128xf32, #row>) {
+  %0 = triton_gpu.convert_layout %arg0 : (tensor<128x128xf32, #row>) -> tensor<128x128xf32, #col>
+  tt.return
+}
+
+}
+
+// -----
+
+#blocked = #triton_gpu.blocked<{sizePerThread = [1, 4], threadsPerWarp = [2, 16], warpsPerCTA = [4, 1], order = [1, 0], CTAsPerCGA = [1, 1], CTASplitNum = [1, 1], CTAOrder = [1, 0]}>
+#mma = #triton_gpu.nvidia_mma<{versionMajor = 2, versionMinor = 0, warpsPerCTA = [2, 2], CTAsPerCGA = [1, 1], CTASplitNum = [1, 1], CTAOrder = [1, 0], instrShape = [16, 8]}>
+#dot0 = #triton_gpu.dot_op<{opIdx = 0, parent = #mma, kWidth = 2}>
+#dot1 = #triton_gpu.dot_op<{opIdx = 1, parent = #mma, kWidth = 2}>
+module attributes {"triton_gpu.num-warps" = 4 : i32, "triton_gpu.num-ctas" = 1 : i32, "triton_gpu.threads-per-warp" = 32 : i32} {
+
+// 64x64x32 f16 in m16n8k16 instructions
+// CHECK-LABEL: mma
+// CHECK: mma = 64, dot flops = 262144
+tt.func @mma(%a: tensor<64x32xf16, #dot0>, %b: tensor<32x64xf16, #dot1>) {
+  %cst = arith.constant dense<0.000000e+00> : tensor<64x64xf32, #mma>
+  %0 = tt.dot %a, %b, %cst {allowTF32 = true, maxNumImpreciseAcc = 0 : i32} : tensor<64x32xf16, #dot0> * tensor<32x64xf16, #dot1> -> tensor<64x64xf32, #mma>
+  tt.return
+}
+
+}
@@ -3,6 +3,8 @@
 #AL = #triton_gpu.blocked<{sizePerThread = [1, 4], threadsPerWarp = [4, 8], warpsPerCTA = [4, 1], order = [1, 0], CTAsPerCGA = [1, 1], CTASplitNum = [1, 1], CTAOrder = [1, 0]}>
 #sliceAd0 = #triton_gpu.slice<{dim = 0, parent = #AL}>
 #BL = #triton_gpu.blocked<{sizePerThread = [1, 4], threadsPerWarp = [1, 32], warpsPerCTA = [4, 1], order = [1, 0], CTAsPerCGA = [1, 1], CTASplitNum = [1, 1], CTAOrder = [1, 0]}>
+#AL_WARP = #triton_gpu.blocked<{sizePerThread = [2, 2], threadsPerWarp = [2, 16], warpsPerCTA = [4, 1], order = [1, 0], CTAsPerCGA = [1, 1], CTASplitNum = [1, 1], CTAOrder = [1, 0]}>
+#AL_GROUP = #triton_gpu.blocked<{sizePerThread = [1, 2], threadsPerWarp = [8, 4], warpsPerCTA = [2, 2], order = [1, 0], CTAsPerCGA = [1, 1], CTASplitNum = [1, 1], CTAOrder = [1, 0]}>
 #A_SHARED = #triton_gpu.shared<{vec = 2, perPhase = 2, maxPhase = 4, order = [1, 0], CTAsPerCGA = [1, 1], CTASplitNum = [1, 1], CTAOrder = [1, 0]}>
 #A_SHARED_T = #triton_gpu.shared<{vec = 2, perPhase = 2, maxPhase = 4, order = [0, 1], CTAsPerCGA = [1, 1], CTASplitNum = [1, 1], CTAOrder = [1, 0]}>
 #B_SHARED = #triton_gpu.shared<{vec = 2, perPhase = 2, maxPhase = 4, order = [1, 0], CTAsPerCGA = [1, 1], CTASplitNum = [1, 1], CTAOrder = [1, 0]}>
@@ -63,13 +65,65 @@ tt.func @war_single_block(%A : !tt.ptr<f16>) {
   %2 = triton_gpu.convert_layout %1 : (tensor<128x32xf16, #AL>) -> tensor<128x32xf16, #A_SHARED>
   // CHECK: gpu.barrier
   // CHECK-NEXT: triton_gpu.convert_layout
-  %3 = triton_gpu.convert_layout %2 : (tensor<128x32xf16, #A_SHARED>) -> tensor<128x32xf16, #AL>
+  %3 = triton_gpu.convert_layout %2 : (tensor<128x32xf16, #A_SHARED>) -> tensor<128x32xf16, #BL>
   // CHECK: gpu.barrier
   // CHECK-NEXT: %4 = triton_gpu.convert_layout
   %4 = triton_gpu.convert_layout %1 : (tensor<128x32xf16, #AL>) -> tensor<128x32xf16, #A_SHARED>
   tt.return
 }
 
+// Each thread only reads back the elements it wrote
+// CHECK-LABEL: convert_layout_round_trip
+tt.func @convert_layout_round_trip(%A : !tt.ptr<f16>) {
+  %cst1 = arith.constant dense<true> : tensor<128x32xi1, #AL>
+  %cst2 = arith.constant dense<0.000000e+00> : tensor<128x32xf16, #AL>
+  %0 = tt.broadcast %A : (!tt.ptr<f16>) -> tensor<128x32x!tt.ptr<f16>, #AL>
+  %1 = tt.load %0, %cst1, %cst2 {cache = 1 : i32, evict = 1 : i32, isVolatile = false} : tensor<128x32xf16, #AL>
+  // CHECK-NOT: gpu.barrier
+  %2 = triton_gpu.convert_layout %1 : (tensor<128x32xf16, #AL>) -> tensor<128x32xf16, #A_SHARED>
+  %3 = triton_gpu.convert_layout %2 : (tensor<128x32xf16, #A_SHARED>) -> tensor<128x32xf16, #AL>
+  %4 = triton_gpu.convert_layout %3 : (tensor<128x32xf16, #AL>) -> tensor<128x32xf16, #A_SHARED>
+  %5 = triton_gpu.convert_layout %4 : (tensor<128x32xf16, #A_SHARED>) -> tensor<128x32xf16, #AL>
+  // CHECK: tt.return
+  tt.return
+}
+
+// #AL and #AL_WARP give each row to the same warp
+// CHECK-LABEL: convert_layout_same_warp
+tt.func @convert_layout_same_warp(%A : !tt.ptr<f16>) {
+  %cst1 = arith.constant dense<true> : tensor<128x32xi1, #AL>
+  %cst2 = arith.constant dense<0.000000e+00> : tensor<128x32xf16, #AL>
+  %0 = tt.broadcast %A : (!tt.ptr<f16>) -> tensor<128x32x!tt.ptr<f16>, #AL>
+  %1 = tt.load %0, %cst1, %cst2 {cache = 1 : i32, evict = 1 : i32, isVolatile = false} : tensor<128x32xf16, #AL>
+  %2 = triton_gpu.convert_layout %1 : (tensor<128x32xf16, #AL>) -> tensor<128x32xf16, #A_SHARED>
+  // CHECK: gpu.barrier {warp_sync}
+  // CHECK-NEXT: triton_gpu.convert_layout
+  %3 = triton_gpu.convert_layout %2 : (tensor<128x32xf16, #A_SHARED>) -> tensor<128x32xf16, #AL_WARP>
+  // CHECK-NOT: gpu.barrier
+  %4 = triton_gpu.convert_layout %3 : (tensor<128x32xf16, #AL_WARP>) -> tensor<128x32xf16, #A_SHARED>
+  // CHECK: tt.return
+  tt.return
+}
+
+// Each row belongs to the same pair of warps in #AL and #AL_GROUP
+// CHECK-LABEL: convert_layout_same_warp_group
+tt.func @convert_layout_same_warp_group(%A : !tt.ptr<f16>) {
+  %cst1 = arith.constant dense<true> : tensor<128x32xi1, #AL>
+  %cst2 = arith.constant dense<0.000000e+00> : tensor<128x32xf16, #AL>
+  %0 = tt.broadcast %A : (!tt.ptr<f16>) -> tensor<128x32x!tt.ptr<f16>, #AL>
+  %1 = tt.load %0, %cst1, %cst2 {cache = 1 : i32, evict = 1 : i32, isVolatile = false} : tensor<128x32xf16, #AL>
+  %2 = triton_gpu.convert_layout %1 : (tensor<128x32xf16, #AL>) -> tensor<128x32xf16, #A_SHARED>
+  // CHECK: triton_nvidia_gpu.get_canonical_warp_id
+  // CHECK: triton_nvidia_gpu.bar_wait {{.*}} {warps_per_group = 2 : i32}
+  // CHECK-NEXT: triton_gpu.convert_layout
+  %3 = triton_gpu.convert_layout %2 : (tensor<128x32xf16, #A_SHARED>) -> tensor<128x32xf16, #AL_GROUP>
+  // CHECK-NOT: gpu.barrier
+  // CHECK-NOT: triton_nvidia_gpu.bar_wait
+  %4 = triton_gpu.convert_layout %3 : (tensor<128x32xf16, #AL_GROUP>) -> tensor<128x32xf16, #A_SHARED>
+  // CHECK: tt.return
+  tt.return
+}
+
 // CHECK-LABEL: scratch
 tt.func @scratch() {
   %cst0 = arith.constant dense<0.000000e+00> : tensor<16x16xf16, #A_SHARED>
@@ -149,6 +203,32 @@ tt.func @insert_slice_async_op(%A : !tt.ptr<f16>, %i1 : i1) {
   tt.return
 }
 
+// The copies are visible once the mbarrier they arrive on is waited on, not
+// the ones issued after the arrive.
+// CHECK-LABEL: insert_slice_async_mbarrier
+tt.func @insert_slice_async_mbarrier(%A : !tt.ptr<f16>, %i1 : i1) {
+  %a_ptr = tt.broadcast %A : (!tt.ptr<f16>) -> tensor<16x16x!tt.ptr<f16>, #AL>
+  %mask = tt.splat %i1 : (i1) -> tensor<16x16xi1, #AL>
+  %other = arith.constant dense<0.000000e+00> : tensor<16x16xf16, #AL>
+  %index = arith.constant 0 : i32
+  %false = arith.constant false
+  %mbar = triton_nvidia_gpu.alloc_mbarrier { count = 128 : i32 } : !tt.ptr<i64, 3>
+  %tensor0 = triton_gpu.alloc_tensor : tensor<1x16x16xf16, #A_SHARED>
+  %0 = triton_gpu.insert_slice_async %a_ptr, %tensor0, %index, %mask, %other {axis = 0 : i32, cache = 1 : i32, evict = 1 : i32, isVolatile = false} : tensor<16x16x!tt.ptr<f16>, #AL> -> tensor<1x16x16xf16, #A_SHARED>
+  triton_nvidia_gpu.mbarrier_arrive %mbar {trackAsyncOp = true} : !tt.ptr<i64, 3>
+  %tensor1 = triton_gpu.alloc_tensor : tensor<1x16x16xf16, #A_SHARED>
+  %1 = triton_gpu.insert_slice_async %a_ptr, %tensor1, %index, %mask, %other {axis = 0 : i32, cache = 1 : i32, evict = 1 : i32, isVolatile = false} : tensor<16x16x!tt.ptr<f16>, #AL> -> tensor<1x16x16xf16, #A_SHARED>
+  triton_nvidia_gpu.mbarrier_wait %mbar, %false : !tt.ptr<i64, 3>
+  // CHECK: triton_nvidia_gpu.mbarrier_wait
+  // CHECK-NOT: gpu.barrier
+  // CHECK: tt.cat
+  %2 = tt.cat %0, %0 {axis = 0} : (tensor<1x16x16xf16, #A_SHARED>, tensor<1x16x16xf16, #A_SHARED>) -> tensor<2x16x16xf16, #A_SHARED>
+  // CHECK: gpu.barrier
+  // CHECK-NEXT: tt.cat
+  %3 = tt.cat %1, %1 {axis = 0} : (tensor<1x16x16xf16, #A_SHARED>, tensor<1x16x16xf16, #A_SHARED>) -> tensor<2x16x16xf16, #A_SHARED>
+  tt.return
+}
+
 // CHECK-LABEL: insert_slice_op
 tt.func @insert_slice_op(%A : !tt.ptr<f16>, %i1 : i1) {
   %a_ptr = tt.broadcast %A : (!tt.ptr<f16>) -> tensor<16x16x!tt.ptr<f16>, #AL>
@@ -0,0 +1,49 @@
+// RUN: triton-opt %s -split-input-file --mlir-disable-threading -test-print-register-pressure 2>&1 | FileCheck %s
+
+#blocked = #triton_gpu.blocked<{sizePerThread = [4], threadsPerWarp = [32], warpsPerCTA = [4], order = [0], CTAsPerCGA = [1], CTASplitNum = [1], CTAOrder = [0]}>
+module attributes {"triton_gpu.num-warps" = 4 : i32, "triton_gpu.num-ctas" = 1 : i32, "triton_gpu.threads-per-warp" = 32 : i32} {
+
+// Peak at %y: the two 64-bit pointers, %range, %x and %y, as the tensors of
+// pointers only need one address per vector of 4 elements
+// CHECK: elementwise: max registers = 14
+tt.func @elementwise(%src: !tt.ptr<f32, 1>, %dst: !tt.ptr<f32, 1>) {
+  %range = tt.make_range {end = 512 : i32, start = 0 : i32} : tensor<512xi32, #blocked>
+  %src_splat = tt.splat %src : (!tt.ptr<f32, 1>) -> tensor<512x!tt.ptr<f32, 1>, #blocked>
+  %src_ptrs = tt.addptr %src_splat, %range : tensor<512x!tt.ptr<f32, 1>, #blocked>, tensor<512xi32, #blocked>
+  %x = tt.load %src_ptrs {cache = 1 : i32, evict = 1 : i32, isVolatile = false} : tensor<512xf32, #blocked>
+  %y = arith.addf %x, %x : tensor<512xf32, #blocked>
+  %dst_splat = tt.splat %dst : (!tt.ptr<f32, 1>) -> tensor<512x!tt.ptr<f32, 1>, #blocked>
+  %dst_ptrs = tt.addptr %dst_splat, %range : tensor<512x!tt.ptr<f32, 1>, #blocked>, tensor<512xi32, #blocked>
+  tt.store %dst_ptrs, %y {cache = 1 : i32, evict = 1 : i32} : tensor<512xf32, #blocked>
+  tt.return
+}
+
+// Values live across the loop are live in its body, constants aren't counted
+// CHECK: accumulate: max registers = 16
+// CHECK-NEXT: loop: max registers = 16
+tt.func @accumulate(%lb: i32, %ub: i32) {
+  %c1 = arith.constant 1 : i32
+  %zero = arith.constant dense<0.000000e+00> : tensor<512xf32, #blocked>
+  %range = tt.make_range {end = 512 : i32, start = 0 : i32} : tensor<512xi32, #blocked>
+  %r = scf.for %i = %lb to %ub step %c1 iter_args(%acc = %zero) -> (tensor<512xf32, #blocked>) : i32 {
+    %f = arith.sitofp %range : tensor<512xi32, #blocked> to tensor<512xf32, #blocked>
+    %next = arith.addf %acc, %f : tensor<512xf32, #blocked>
+    scf.yield %next : tensor<512xf32, #blocked>
+  }
+  tt.return
+}
+
+}
+
+// -----
+
+#mma = #triton_gpu.nvidia_mma<{versionMajor = 2, versionMinor = 0, warpsPerCTA = [4, 1], CTAsPerCGA = [1, 1], CTASplitNum = [1, 1], CTAOrder = [1, 0], instrShape = [16, 8]}>
+module attributes {"triton_gpu.num-warps" = 4 : i32, "triton_gpu.num-ctas" = 1 : i32, "triton_gpu.threads-per-warp" = 32 : i32} {
+
+// A 128x128 f32 accumulator over 128 threads
+// CHECK: mma_accumulator: max registers = 128
+tt.func @mma_accumulator(%acc: tensor<128x128xf32, #mma>) {
+  tt.return
+}
+
+}
@@ -11,6 +11,18 @@ tt.func @ops() {
 
 // -----
 
+// Each thread has 4 contiguous columns of the result of a FMA dot with 8
+// elements per thread.
+// CHECK: #[[BLOCKED:blocked[0-9]*]] = #triton_gpu.blocked<{sizePerThread = [2, 4]
+// CHECK-LABEL: tt.func @fma_dot
+// CHECK: tt.dot {{.*}} -> tensor<32x16xf32, #[[BLOCKED]]>
+tt.func @fma_dot(%a: tensor<32x8xf32>, %b: tensor<8x16xf32>, %c: tensor<32x16xf32>) -> tensor<32x16xf32> {
+  %0 = tt.dot %a, %b, %c {allowTF32 = false, maxNumImpreciseAcc = 0 : i32} : tensor<32x8xf32> * tensor<8x16xf32> -> tensor<32x16xf32>
+  tt.return %0 : tensor<32x16xf32>
+}
+
+// -----
+
 tt.func @load_ops(%ptr: !tt.ptr<f32> {tt.divisibility = 16 : i32}) {
   // Test if LoadOp is lowered properly (see #771)
   %ptrs = tt.splat %ptr : (!tt.ptr<f32>) -> tensor<128x!tt.ptr<f32>>
@@ -33,9 +45,10 @@ tt.func @load_ops(%ptr: !tt.ptr<f32> {tt.divisibility = 16 : i32}) {
 tt.func @reduce_ops(%ptr: !tt.ptr<f32> {tt.divisibility = 16 : i32}) {
   // Test if the total number of threadsPerWarp is 32
   // Test if the total number of warps is 2
-  // CHECK: #[[blocked0:.*]] = #triton_gpu.blocked<{sizePerThread = [1, 1], threadsPerWarp = [8, 4], warpsPerCTA = [2, 1], order = [1, 0], CTAsPerCGA = [1, 1], CTASplitNum = [1, 1], CTAOrder = [1, 0]}>
-  // CHECK: #[[blocked1:.*]] = #triton_gpu.blocked<{sizePerThread = [1, 1], threadsPerWarp = [16, 2], warpsPerCTA = [2, 1], order = [1, 0], CTAsPerCGA = [1, 1], CTASplitNum = [1, 1], CTAOrder = [1, 0]}>
-  // CHECK: #[[blocked2:.*]] = #triton_gpu.blocked<{sizePerThread = [1, 1], threadsPerWarp = [2, 16], warpsPerCTA = [2, 1], order = [1, 0], CTAsPerCGA = [1, 1], CTASplitNum = [1, 1], CTAOrder = [1, 0]}>
+  // Test if the threads of a warp go along the axis of the first reduction
+  // CHECK: #[[blocked0:.*]] = #triton_gpu.blocked<{sizePerThread = [1, 1], threadsPerWarp = [4, 8], warpsPerCTA = [1, 2], order = [0, 1], CTAsPerCGA = [1, 1], CTASplitNum = [1, 1], CTAOrder = [0, 1]}>
+  // CHECK: #[[blocked1:.*]] = #triton_gpu.blocked<{sizePerThread = [1, 1], threadsPerWarp = [8, 4], warpsPerCTA = [1, 2], order = [0, 1], CTAsPerCGA = [1, 1], CTASplitNum = [1, 1], CTAOrder = [0, 1]}>
+  // CHECK: #[[blocked2:.*]] = #triton_gpu.blocked<{sizePerThread = [1, 1], threadsPerWarp = [16, 2], warpsPerCTA = [1, 2], order = [0, 1], CTAsPerCGA = [1, 1], CTASplitNum = [1, 1], CTAOrder = [0, 1]}>
   // CHECK: module attributes {"triton_gpu.compute-capability" = 80 : i32, "triton_gpu.num-ctas" = 1 : i32, "triton_gpu.num-warps" = 2 : i32, "triton_gpu.threads-per-warp" = 32 : i32} {{.*}}
   %c0 = arith.constant dense<1.00e+00> : tensor<4x4xf32>
   %c1 = arith.constant dense<2.00e+00> : tensor<8x2xf32>
@@ -87,3 +100,43 @@ tt.func public @select_op(%arg0: !tt.ptr<f32> {tt.divisibility = 16 : i32}, %arg
   tt.store %6, %4 {cache = 1 : i32, evict = 1 : i32} : tensor<128xf32>
   tt.return
 }
+
+// -----
+
+// The load vectorizes along the contiguous dimension of its pointers, and the
+// other tensors of its shape take the same layout.
+// CHECK: #[[BLOCKED:.*]] = #triton_gpu.blocked<{sizePerThread = [1, 4], threadsPerWarp = [2, 16], warpsPerCTA = [2, 1], order = [1, 0], CTAsPerCGA = [1, 1], CTASplitNum = [1, 1], CTAOrder = [1, 0]}>
+// CHECK-LABEL: load_anchor
+tt.func @load_anchor(%arg0: !tt.ptr<f32> {tt.divisibility = 16 : i32}, %arg1: !tt.ptr<f32> {tt.divisibility = 16 : i32}) {
+  %0 = tt.make_range {end = 64 : i32, start = 0 : i32} : tensor<64xi32>
+  %1 = tt.expand_dims %0 {axis = 0 : i32} : (tensor<64xi32>) -> tensor<1x64xi32>
+  %2 = tt.broadcast %1 : (tensor<1x64xi32>) -> tensor<16x64xi32>
+  %3 = tt.splat %arg0 : (!tt.ptr<f32>) -> tensor<16x64x!tt.ptr<f32>>
+  %4 = tt.addptr %3, %2 : tensor<16x64x!tt.ptr<f32>>, tensor<16x64xi32>
+  // CHECK: %[[LOAD:.*]] = tt.load %{{.*}} : tensor<16x64xf32, #[[BLOCKED]]>
+  %5 = tt.load %4 {cache = 1 : i32, evict = 1 : i32, isVolatile = false} : tensor<16x64xf32>
+  // CHECK-NOT: triton_gpu.convert_layout
+  // CHECK: arith.addf %[[LOAD]], %[[LOAD]] : tensor<16x64xf32, #[[BLOCKED]]>
+  %6 = arith.addf %5, %5 : tensor<16x64xf32>
+  %7 = tt.splat %arg1 : (!tt.ptr<f32>) -> tensor<16x64x!tt.ptr<f32>>
+  %8 = tt.addptr %7, %2 : tensor<16x64x!tt.ptr<f32>>, tensor<16x64xi32>
+  // CHECK: tt.store %{{.*}}, %{{.*}} {{.*}} : tensor<16x64xf32, #[[BLOCKED]]>
+  tt.store %8, %6 {cache = 1 : i32, evict = 1 : i32} : tensor<16x64xf32>
+  tt.return
+}
+
+// -----
+
+// CHECK-DAG: [[$BLOCKED:#.*]] = #triton_gpu.blocked<{sizePerThread = [1], threadsPerWarp = [32], warpsPerCTA = [2], order = [0], CTAsPerCGA = [1], CTASplitNum = [1], CTAOrder = [0]}>
+// CHECK-DAG: [[$JOINED:#.*]] = #triton_gpu.blocked<{sizePerThread = [1, 2], threadsPerWarp = [32, 1], warpsPerCTA = [2, 1], order = [1, 0], CTAsPerCGA = [1, 1], CTASplitNum = [1, 1], CTAOrder = [1, 0]}>
+// CHECK-LABEL: join_split
+tt.func @join_split(%arg0: tensor<128xf32>, %arg1: tensor<128x2xf32>) -> (tensor<128x2xf32>, tensor<128xf32>) {
+  // CHECK: tt.join %{{.*}}, %{{.*}} : tensor<128xf32, [[$BLOCKED]]> -> tensor<128x2xf32, [[$JOINED]]>
+  %0 = tt.join %arg0, %arg0 : tensor<128xf32> -> tensor<128x2xf32>
+  // The operand of the split is converted so that its last dim is in registers
+  // CHECK: %[[CVT:.*]] = triton_gpu.convert_layout %{{.*}} : (tensor<128x2xf32, #{{.*}}>) -> tensor<128x2xf32, [[$JOINED]]>
+  // CHECK: tt.split %[[CVT]] : tensor<128x2xf32, [[$JOINED]]> -> tensor<128xf32, [[$BLOCKED]]>
+  %1, %2 = tt.split %arg1 : tensor<128x2xf32> -> tensor<128xf32>
+  %3 = arith.addf %1, %2 : tensor<128xf32>
+  tt.return %0, %3 : tensor<128x2xf32>, tensor<128xf32>
+}
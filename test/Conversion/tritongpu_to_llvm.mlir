@@ -85,13 +85,35 @@ module attributes {"triton_gpu.num-ctas" = 1 : i32, "triton_gpu.num-warps" = 8 :
 module attributes {"triton_gpu.num-ctas" = 1 : i32, "triton_gpu.num-warps" = 4 : i32} {
   // CHECK-LABEL: store_with_cache_attr
   tt.func @store_with_cache_attr(%a_ptr_init : tensor<256x!tt.ptr<f32>, #blocked0>, %cst : tensor<256xi1, #blocked0>, %cst_0 : tensor<256xf32, #blocked0>) {
+    //      CHECK: %[[POLICY:.*]] = llvm.inline_asm {{.*}}"createpolicy.fractional.L2::evict_last.b64 $0, 1.0;", "=l"
     //      CHECK: llvm.inline_asm
-    // CHECK-SAME: st.global.L1::evict_last.b32
+    // CHECK-SAME: st.global.L1::evict_last.L2::cache_hint.b32 [ ${{.*}} + 0 ], { ${{.*}} }, ${{.*}};
+    // CHECK-SAME: %[[POLICY]]
     //      CHECK: llvm.inline_asm
-    // CHECK-SAME: st.global.L1::evict_last.b32
+    // CHECK-SAME: st.global.L1::evict_last.L2::cache_hint.b32
     tt.store %a_ptr_init, %cst_0, %cst {cache = 1 : i32, evict = 3 : i32, isVolatile = false} : tensor<256xf32, #blocked0>
     tt.return
   }
+
+  // CHECK-LABEL: load_store_with_eviction_policy
+  tt.func @load_store_with_eviction_policy(%a_ptr_init : tensor<256x!tt.ptr<f32>, #blocked0>, %cst : tensor<256xi1, #blocked0>, %cst_0 : tensor<256xf32, #blocked0>) {
+    //      CHECK: createpolicy.fractional.L2::evict_first.b64
+    //      CHECK: ld.global.L1::evict_first.L2::cache_hint.b32
+    %0 = tt.load %a_ptr_init, %cst, %cst_0 {cache = 1 : i32, evict = 2 : i32, isVolatile = false} : tensor<256xf32, #blocked0>
+    // CHECK-NOT: createpolicy
+    //     CHECK: st.global.L1::no_allocate.b32
+    tt.store %a_ptr_init, %0, %cst {cache = 1 : i32, evict = 4 : i32, isVolatile = false} : tensor<256xf32, #blocked0>
+    tt.return
+  }
+
+  // CHECK-LABEL: prefetch
+  tt.func @prefetch(%a_ptr_init : tensor<256x!tt.ptr<f32>, #blocked0>, %cst : tensor<256xi1, #blocked0>) {
+    // CHECK: @${{.*}} prefetch.global.L2 [ ${{.*}} + 0 ];
+    tt.prefetch %a_ptr_init, %cst : tensor<256x!tt.ptr<f32>, #blocked0>
+    // CHECK: @${{.*}} prefetch.global.L2::evict_last [ ${{.*}} + 0 ];
+    tt.prefetch %a_ptr_init {evict = 3 : i32} : tensor<256x!tt.ptr<f32>, #blocked0>
+    tt.return
+  }
 }
 
 // -----
@@ -215,6 +237,31 @@ module attributes {"triton_gpu.num-ctas" = 1 : i32, "triton_gpu.num-warps" = 2 :
 
 // -----
 
+#blocked0 = #triton_gpu.blocked<{sizePerThread = [4], threadsPerWarp = [32], warpsPerCTA = [2], order = [0], CTAsPerCGA = [1], CTASplitNum = [1], CTAOrder = [0]}>
+// The mask is always true, so it neither restricts the vector width nor predicates the move of %other.
+module attributes {"triton_gpu.num-ctas" = 1 : i32, "triton_gpu.num-warps" = 2 : i32} {
+  // CHECK-LABEL: global_load_store_mask_in_bounds
+  tt.func @global_load_store_mask_in_bounds(%arg0: !tt.ptr<f32> {tt.divisibility = 16 : i32}, %arg1: !tt.ptr<f32> {tt.divisibility = 16 : i32}) {
+    %cst = arith.constant dense<256> : tensor<256xi32, #blocked0>
+    %other = arith.constant dense<1.000000e+00> : tensor<256xf32, #blocked0>
+    %0 = tt.make_range {end = 256 : i32, start = 0 : i32} : tensor<256xi32, #blocked0>
+    %mask = arith.cmpi slt, %0, %cst : tensor<256xi32, #blocked0>
+    %1 = tt.splat %arg0 : (!tt.ptr<f32>) -> tensor<256x!tt.ptr<f32>, #blocked0>
+    %2 = tt.addptr %1, %0 : tensor<256x!tt.ptr<f32>, #blocked0>, tensor<256xi32, #blocked0>
+    %3 = tt.splat %arg1 : (!tt.ptr<f32>) -> tensor<256x!tt.ptr<f32>, #blocked0>
+    %4 = tt.addptr %3, %0 : tensor<256x!tt.ptr<f32>, #blocked0>, tensor<256xi32, #blocked0>
+    // CHECK-NOT: @!$
+    // CHECK: ld.global.v4.b32
+    // CHECK-NOT: @!$
+    %5 = tt.load %2, %mask, %other {cache = 1 : i32, evict = 1 : i32, isVolatile = false} : tensor<256xf32, #blocked0>
+    // CHECK: st.global.v4.b32
+    tt.store %4, %5, %mask : tensor<256xf32, #blocked0>
+    tt.return
+  }
+}
+
+// -----
+
 #blocked0 = #triton_gpu.blocked<{sizePerThread = [8], threadsPerWarp = [32], warpsPerCTA = [1], order = [0], CTAsPerCGA = [1], CTASplitNum = [1], CTAOrder = [0]}>
 module attributes {"triton_gpu.num-ctas" = 1 : i32, "triton_gpu.num-warps" = 1 : i32} {
   // CHECK-LABEL: global_load_store_vec2
@@ -372,6 +419,47 @@ module attributes {"triton_gpu.num-ctas" = 1 : i32, "triton_gpu.num-warps" = 4 :
 
 // -----
 
+#blocked0 = #triton_gpu.blocked<{sizePerThread = [1, 4], threadsPerWarp = [2, 16], warpsPerCTA = [4, 1], order = [1, 0], CTAsPerCGA = [1, 1], CTASplitNum = [1, 1], CTAOrder = [1, 0]}>
+#blocked1 = #triton_gpu.blocked<{sizePerThread = [4, 1], threadsPerWarp = [16, 2], warpsPerCTA = [1, 4], order = [0, 1], CTAsPerCGA = [1, 1], CTASplitNum = [1, 1], CTAOrder = [0, 1]}>
+module attributes {"triton_gpu.num-ctas" = 1 : i32, "triton_gpu.num-warps" = 4 : i32} {
+  // CHECK-LABEL: basic_trans_registers
+  tt.func @basic_trans_registers(%arg : tensor<8x64xf32, #blocked0>) {
+    // CHECK-NOT: llvm.store
+    // CHECK-COUNT-4: llvm.extractvalue
+    // CHECK: llvm.mlir.undef
+    // CHECK-COUNT-4: llvm.insertvalue
+    // CHECK-NOT: llvm.store
+    %0 = tt.trans %arg : (tensor<8x64xf32, #blocked0>) -> tensor<64x8xf32, #blocked1>
+    tt.return
+  }
+}
+
+// -----
+
+#blocked0 = #triton_gpu.blocked<{sizePerThread = [1], threadsPerWarp = [32], warpsPerCTA = [4], order = [0], CTAsPerCGA = [1], CTASplitNum = [1], CTAOrder = [0]}>
+#blocked1 = #triton_gpu.blocked<{sizePerThread = [1, 2], threadsPerWarp = [32, 1], warpsPerCTA = [4, 1], order = [1, 0], CTAsPerCGA = [1, 1], CTASplitNum = [1, 1], CTAOrder = [1, 0]}>
+module attributes {"triton_gpu.num-ctas" = 1 : i32, "triton_gpu.num-warps" = 4 : i32} {
+  // CHECK-LABEL: basic_join_split
+  tt.func @basic_join_split(%arg0 : tensor<128xf32, #blocked0>, %arg1 : tensor<128xf32, #blocked0>) {
+    // The join and the split only move values within each thread
+    // CHECK-NOT: llvm.store
+    // CHECK: %[[A:.*]] = llvm.extractvalue %arg0[0]
+    // CHECK: %[[B:.*]] = llvm.extractvalue %arg1[0]
+    // CHECK: llvm.mlir.undef
+    // CHECK: %[[J0:.*]] = llvm.insertvalue %[[A]], %{{.*}}[0]
+    // CHECK: llvm.insertvalue %[[B]], %[[J0]][1]
+    %0 = tt.join %arg0, %arg1 : tensor<128xf32, #blocked0> -> tensor<128x2xf32, #blocked1>
+    // CHECK: llvm.extractvalue %{{.*}}[0]
+    // CHECK: llvm.extractvalue %{{.*}}[1]
+    // CHECK-COUNT-2: llvm.insertvalue
+    // CHECK-NOT: llvm.store
+    %1, %2 = tt.split %0 : tensor<128x2xf32, #blocked1> -> tensor<128xf32, #blocked0>
+    tt.return
+  }
+}
+
+// -----
+
 #blocked0 = #triton_gpu.blocked<{sizePerThread = [2], threadsPerWarp = [32], warpsPerCTA = [1], order = [0], CTAsPerCGA = [1], CTASplitNum = [1], CTAOrder = [0]}>
 module attributes {"triton_gpu.num-ctas" = 1 : i32, "triton_gpu.num-warps" = 1 : i32} {
   // CHECK-LABEL: basic_make_range
@@ -820,22 +908,8 @@ module attributes {"triton_gpu.num-ctas" = 1 : i32, "triton_gpu.num-warps" = 1 :
   // CHECK: llvm.mlir.global external @global_smem() {addr_space = 3 : i32} : !llvm.array<0 x i8>
   // CHECK-LABEL: convert_layout_blocked_blocked_multi_rep
   tt.func @convert_layout_blocked_blocked_multi_rep(%arg0: tensor<16x16xf32, #blocked0>) {
-    // CHECK: llvm.mlir.addressof @global_smem
-    // CHECK: llvm.store
-    // CHECK-SAME: !llvm.ptr<3>
-    // CHECK: nvvm.barrier0
-    // CHECK: llvm.load
-    // CHECK-SAME: !llvm.ptr<3>
-    // CHECK: llvm.load
-    // CHECK-SAME: !llvm.ptr<3>
-    // CHECK: nvvm.barrier0
-    // CHECK: llvm.store
-    // CHECK-SAME: !llvm.ptr<3>
-    // CHECK: nvvm.barrier0
-    // CHECK: llvm.load
-    // CHECK-SAME: !llvm.ptr<3>
-    // CHECK: llvm.load
-    // CHECK-SAME: !llvm.ptr<3>
+    // CHECK-NOT: nvvm.barrier0
+    // CHECK-COUNT-16: nvvm.shfl.sync idx
     %0 = triton_gpu.convert_layout %arg0 : (tensor<16x16xf32, #blocked0>) -> tensor<16x16xf32, #blocked1>
     tt.return
   }
@@ -843,6 +917,22 @@ module attributes {"triton_gpu.num-ctas" = 1 : i32, "triton_gpu.num-warps" = 1 :
 
 // -----
 
+#blocked0 = #triton_gpu.blocked<{sizePerThread = [1, 4], threadsPerWarp = [8, 4], warpsPerCTA = [1, 1], order = [1, 0], CTAsPerCGA = [1, 1], CTASplitNum = [1, 1], CTAOrder = [1, 0]}>
+#blocked1 = #triton_gpu.blocked<{sizePerThread = [1, 4], threadsPerWarp = [4, 8], warpsPerCTA = [1, 1], order = [1, 0], CTAsPerCGA = [1, 1], CTASplitNum = [1, 1], CTAOrder = [1, 0]}>
+module attributes {"triton_gpu.num-ctas" = 1 : i32, "triton_gpu.num-warps" = 1 : i32} {
+  // CHECK-LABEL: convert_layout_blocked_blocked_packed
+  tt.func @convert_layout_blocked_blocked_packed(%arg0: tensor<16x16xf16, #blocked0>) {
+    // Pairs of f16 read from the same lane share a shuffle
+    // CHECK-COUNT-8: nvvm.shfl.sync idx
+    // CHECK-NOT: nvvm.shfl.sync
+    // CHECK: llvm.return
+    %0 = triton_gpu.convert_layout %arg0 : (tensor<16x16xf16, #blocked0>) -> tensor<16x16xf16, #blocked1>
+    tt.return
+  }
+}
+
+// -----
+
 #blocked0 = #triton_gpu.blocked<{sizePerThread = [1, 4], threadsPerWarp = [8, 4], warpsPerCTA = [1, 1], order = [1, 0], CTAsPerCGA = [1, 1], CTASplitNum = [1, 1], CTAOrder = [1, 0]}>
 #shared0 = #triton_gpu.shared<{vec = 1, perPhase=2, maxPhase=8, order = [1, 0], CTAsPerCGA = [1, 1], CTASplitNum = [1, 1], CTAOrder = [1, 0]}>
 #mma0 = #triton_gpu.nvidia_mma<{versionMajor = 2, warpsPerCTA = [1, 1], CTAsPerCGA = [1, 1], CTASplitNum = [1, 1], CTAOrder = [0, 1], instrShape = [16, 8]}>
@@ -871,6 +961,34 @@ module attributes {"triton_gpu.num-ctas" = 1 : i32, "triton_gpu.num-warps" = 1 :
   }
 }
 
+#blocked0 = #triton_gpu.blocked<{sizePerThread = [1, 4], threadsPerWarp = [8, 4], warpsPerCTA = [1, 1], order = [1, 0], CTAsPerCGA = [1, 1], CTASplitNum = [1, 1], CTAOrder = [1, 0]}>
+#shared0 = #triton_gpu.shared<{vec = 1, perPhase=2, maxPhase=8, order = [1, 0], CTAsPerCGA = [1, 1], CTASplitNum = [1, 1], CTAOrder = [1, 0]}>
+#shared1 = #triton_gpu.shared<{vec = 1, perPhase=1, maxPhase=1, order = [1, 0], CTAsPerCGA = [1, 1], CTASplitNum = [1, 1], CTAOrder = [1, 0]}>
+#mma0 = #triton_gpu.nvidia_mma<{versionMajor = 2, warpsPerCTA = [1, 1], CTAsPerCGA = [1, 1], CTASplitNum = [1, 1], CTAOrder = [0, 1], instrShape = [16, 8]}>
+#dot_operand_a = #triton_gpu.dot_op<{opIdx=0, parent=#mma0, kWidth=2}>
+#dot_operand_b = #triton_gpu.dot_op<{opIdx=1, parent=#mma0, kWidth=2}>
+module attributes {"triton_gpu.num-ctas" = 1 : i32, "triton_gpu.num-warps" = 1 : i32} {
+  // CHECK-LABEL: convert_sparse_dot
+  tt.func @convert_sparse_dot(%A: tensor<16x16xf16, #blocked0>, %B: tensor<32x16xf16, #blocked0>, %M: tensor<16x2xi16, #blocked0>) {
+    %AA = triton_gpu.convert_layout %A : (tensor<16x16xf16, #blocked0>) -> tensor<16x16xf16, #shared0>
+    %BB = triton_gpu.convert_layout %B : (tensor<32x16xf16, #blocked0>) -> tensor<32x16xf16, #shared0>
+    %MM = triton_gpu.convert_layout %M : (tensor<16x2xi16, #blocked0>) -> tensor<16x2xi16, #shared1>
+    %AA_DOT = triton_gpu.convert_layout %AA : (tensor<16x16xf16, #shared0>) -> tensor<16x16xf16, #dot_operand_a>
+    %BB_DOT = triton_gpu.convert_layout %BB : (tensor<32x16xf16, #shared0>) -> tensor<32x16xf16, #dot_operand_b>
+    %cst0 = arith.constant dense<0.000000e+00> : tensor<16x16xf32, #mma0>
+
+    // CHECK: llvm.load {{.*}} -> i32
+    // CHECK: llvm.inline_asm
+    // CHECK-SAME: mma.sp.sync.aligned.m16n8k32.row.col.f32.f16.f16.f32
+    // CHECK: llvm.inline_asm
+    // CHECK-SAME: mma.sp.sync.aligned.m16n8k32.row.col.f32.f16.f16.f32
+    // CHECK-NOT: mma.sp.sync
+    %D = triton_gpu.sparse_dot %AA_DOT, %BB_DOT, %cst0, %MM : tensor<16x16xf16, #dot_operand_a> meta tensor<16x2xi16, #shared1> * tensor<32x16xf16, #dot_operand_b> -> tensor<16x16xf32, #mma0>
+
+    tt.return
+  }
+}
+
 // TODO: problems in MLIR's parser on slice layout
 // #blocked0 = #triton_gpu.blocked<{sizePerThread = [1, 4], threadsPerWarp = [8, 4], warpsPerCTA = [1, 1], order = [1, 0], CTAsPerCGA = [1, 1], CTASplitNum = [1, 1], CTAOrder = [1, 0]}>
 // module attributes {"triton_gpu.num-ctas" = 1 : i32, "triton_gpu.num-warps" = 1 : i32} {
@@ -947,7 +1065,7 @@ module attributes {"triton_gpu.num-ctas" = 1 : i32, "triton_gpu.num-warps" = 8 :
 module attributes {"triton_gpu.num-ctas" = 1 : i32, "triton_gpu.num-warps" = 1 : i32} {
   // CHECK-LABEL: convert_blocked1d_to_slice0
   tt.func @convert_blocked1d_to_slice0(%src:tensor<32xi32, #blocked0>) {
-    // CHECK-COUNT-4: llvm.load {{.*}} : !llvm.ptr<3>
+    // CHECK-COUNT-4: nvvm.shfl.sync idx
     %cvt = triton_gpu.convert_layout %src : (tensor<32xi32, #blocked0>) -> tensor<32xi32, #triton_gpu.slice<{dim = 0, parent = #blocked1}>>
     tt.return
   }
@@ -960,7 +1078,7 @@ module attributes {"triton_gpu.num-ctas" = 1 : i32, "triton_gpu.num-warps" = 1 :
 module attributes {"triton_gpu.num-ctas" = 1 : i32, "triton_gpu.num-warps" = 1 : i32} {
   // CHECK-LABEL: convert_blocked1d_to_slice1
   tt.func @convert_blocked1d_to_slice1(%src:tensor<32xi32, #blocked0>) {
-    // CHECK-COUNT-8: llvm.load {{.*}} : !llvm.ptr<3>
+    // CHECK-COUNT-8: nvvm.shfl.sync idx
     %cvt = triton_gpu.convert_layout %src : (tensor<32xi32, #blocked0>) -> tensor<32xi32, #triton_gpu.slice<{dim = 1, parent = #blocked1}>>
     tt.return
   }
@@ -974,8 +1092,7 @@ module attributes {"triton_gpu.num-ctas" = 1 : i32, "triton_gpu.num-warps" = 1 :
   // CHECK-LABEL: convert_blocked_to_blocked_ptr
   tt.func @convert_blocked_to_blocked_ptr(%src:tensor<32x!tt.ptr<f32>, #blocked0>) {
     // CHECK: llvm.ptrtoint
-    // CHECK: llvm.store
-    // CHECK: nvvm.barrier0
+    // CHECK: nvvm.shfl.sync idx
     // CHECK: llvm.inttoptr
     // CHECK-COUNT-4: llvm.insertvalue
     %cvt = triton_gpu.convert_layout %src : (tensor<32x!tt.ptr<f32>, #blocked0>) -> tensor<32x!tt.ptr<f32>, #blocked1>
@@ -1057,6 +1174,34 @@ module attributes {"triton_gpu.num-ctas" = 1 : i32, "triton_gpu.num-warps" = 4 :
 
 // -----
 
+#blocked = #triton_gpu.blocked<{sizePerThread = [1, 4], threadsPerWarp = [2, 16], warpsPerCTA = [1, 4], order = [1, 0], CTAsPerCGA = [1, 1], CTASplitNum = [1, 1], CTAOrder = [1, 0]}>
+#shared = #triton_gpu.shared<{vec = 1, perPhase = 1, maxPhase = 1, order = [1, 0], CTAsPerCGA = [1, 1], CTASplitNum = [1, 1], CTAOrder = [1, 0]}>
+#dot_operand_a = #triton_gpu.dot_op<{opIdx=0, parent=#blocked}>
+#dot_operand_b = #triton_gpu.dot_op<{opIdx=1, parent=#blocked}>
+module attributes {"triton_gpu.num-ctas" = 1 : i32, "triton_gpu.num-warps" = 4 : i32} {
+  // A is read 4 elements of a row at a time along k, B along the 4 columns
+  // of each thread.
+  // CHECK-LABEL: matmul_fmadot_vectorized
+  tt.func @matmul_fmadot_vectorized(%ptr:!tt.ptr<f32> {tt.divisibility = 16 : i32},
+  %a:tensor<32x16xf32, #shared>, %b:tensor<16x32xf32, #shared>) {
+    %cst = arith.constant dense<0.000000e+00> : tensor<32x32xf32, #blocked>
+    // CHECK-NOT: llvm.load {{.*}} -> f32
+    // CHECK: llvm.load {{.*}} -> vector<4xf32>
+    // CHECK-NOT: llvm.load {{.*}} -> f32
+    // CHECK: llvm.intr.fmuladd
+    %a_mat = triton_gpu.convert_layout %a : (tensor<32x16xf32, #shared>) -> tensor<32x16xf32, #dot_operand_a>
+    %b_mat = triton_gpu.convert_layout %b : (tensor<16x32xf32, #shared>) -> tensor<16x32xf32, #dot_operand_b>
+
+    %28 = tt.dot %a_mat, %b_mat, %cst {allowTF32 = false, maxNumImpreciseAcc = 0 : i32} : tensor<32x16xf32, #dot_operand_a> * tensor<16x32xf32, #dot_operand_b> -> tensor<32x32xf32, #blocked>
+    %30 = tt.splat %ptr : (!tt.ptr<f32>) -> tensor<32x1x!tt.ptr<f32>, #blocked>
+    %36 = tt.broadcast %30 : (tensor<32x1x!tt.ptr<f32>, #blocked>) -> tensor<32x32x!tt.ptr<f32>, #blocked>
+    tt.store %36, %28 : tensor<32x32xf32, #blocked>
+    tt.return
+  }
+}
+
+// -----
+
 #mma = #triton_gpu.nvidia_mma<{versionMajor=2, warpsPerCTA=[2, 2], CTAsPerCGA = [1, 1], CTASplitNum = [1, 1], CTAOrder = [0, 1], instrShape = [16, 8]}>
 #shared = #triton_gpu.shared<{vec = 1, perPhase = 1, maxPhase = 1, order = [1, 0], CTAsPerCGA = [1, 1], CTASplitNum = [1, 1], CTAOrder = [1, 0]}>
 #blocked = #triton_gpu.blocked<{sizePerThread = [1, 4], threadsPerWarp = [2, 16], warpsPerCTA = [1, 4], order = [1, 0], CTAsPerCGA = [1, 1], CTASplitNum = [1, 1], CTAOrder = [1, 0]}>
@@ -1101,9 +1246,9 @@ module attributes {"triton_gpu.num-ctas" = 1 : i32, "triton_gpu.num-warps" = 4 :
   // CHECK-LABEL: atomic_add_f32
   tt.func @atomic_add_f32(%arg0 : tensor<256x!tt.ptr<f32>, #blocked0>, %arg1 : tensor<256xi1, #blocked0>, %arg2 : tensor<256xf32, #blocked0>) {
     // CHECK: llvm.inline_asm
-    // CHECK-SAME: @$3 atom.global.gpu.relaxed.add.f32
+    // CHECK-SAME: @$2 red.global.gpu.relaxed.add.f32
     // CHECK: llvm.inline_asm
-    // CHECK-SAME: @$3 atom.global.gpu.relaxed.add.f32
+    // CHECK-SAME: @$2 red.global.gpu.relaxed.add.f32
     %0 = "tt.atomic_rmw" (%arg0, %arg2, %arg1) {atomic_rmw_op = 5 : i32, sem = 1 : i32, scope = 1 : i32} : (tensor<256x!tt.ptr<f32>, #blocked0>, tensor<256xf32, #blocked0>, tensor<256xi1, #blocked0>) -> tensor<256xf32, #blocked0>
     tt.return
   }
@@ -1116,7 +1261,7 @@ module attributes {"triton_gpu.num-ctas" = 1 : i32, "triton_gpu.num-warps" = 4 :
   tt.func @atomic_add_f32_scalar(%arg0 : !tt.ptr<f32>, %arg1 : i1, %arg2 : f32) {
     // CHECK: llvm.icmp "eq"
     // CHECK: llvm.inline_asm
-    // CHECK-SAME: @$3 atom.global.gpu.relaxed.add.f32
+    // CHECK-SAME: @$2 red.global.gpu.relaxed.add.f32
     %0 = "tt.atomic_rmw" (%arg0, %arg2, %arg1) {atomic_rmw_op = 5 : i32, sem = 1 : i32, scope = 1 : i32} : (!tt.ptr<f32>, f32, i1) -> f32
     tt.return
   }
@@ -1129,9 +1274,9 @@ module attributes {"triton_gpu.num-ctas" = 1 : i32, "triton_gpu.num-warps" = 4 :
   // CHECK-LABEL: atomic_add_f32
   tt.func @atomic_add_f32_sys_scope(%arg0 : tensor<256x!tt.ptr<f32>, #blocked0>, %arg1 : tensor<256xi1, #blocked0>, %arg2 : tensor<256xf32, #blocked0>) {
     // CHECK: llvm.inline_asm
-    // CHECK-SAME: @$3 atom.global.sys.relaxed.add.f32
+    // CHECK-SAME: @$2 red.global.sys.relaxed.add.f32
     // CHECK: llvm.inline_asm
-    // CHECK-SAME: @$3 atom.global.sys.relaxed.add.f32
+    // CHECK-SAME: @$2 red.global.sys.relaxed.add.f32
     %0 = "tt.atomic_rmw" (%arg0, %arg2, %arg1) {atomic_rmw_op = 5 : i32, sem = 1 : i32, scope = 3 : i32} : (tensor<256x!tt.ptr<f32>, #blocked0>, tensor<256xf32, #blocked0>, tensor<256xi1, #blocked0>) -> tensor<256xf32, #blocked0>
     tt.return
   }
@@ -1139,6 +1284,97 @@ module attributes {"triton_gpu.num-ctas" = 1 : i32, "triton_gpu.num-warps" = 4 :
 
 // -----
 
+#blocked0 = #triton_gpu.blocked<{sizePerThread = [1], threadsPerWarp = [32], warpsPerCTA = [4], order = [0], CTAsPerCGA = [1], CTASplitNum = [1], CTAOrder = [0]}>
+module attributes {"triton_gpu.num-ctas" = 1 : i32, "triton_gpu.num-warps" = 4 : i32} {
+  // The reductions have no acquire semantics.
+  // CHECK-LABEL: atomic_add_f32_acq_rel
+  tt.func @atomic_add_f32_acq_rel(%arg0 : tensor<256x!tt.ptr<f32>, #blocked0>, %arg1 : tensor<256xi1, #blocked0>, %arg2 : tensor<256xf32, #blocked0>) {
+    // CHECK: llvm.inline_asm
+    // CHECK-SAME: @$3 atom.global.gpu.acq_rel.add.f32
+    %0 = "tt.atomic_rmw" (%arg0, %arg2, %arg1) {atomic_rmw_op = 5 : i32, sem = 4 : i32, scope = 1 : i32} : (tensor<256x!tt.ptr<f32>, #blocked0>, tensor<256xf32, #blocked0>, tensor<256xi1, #blocked0>) -> tensor<256xf32, #blocked0>
+    tt.return
+  }
+}
+
+// -----
+
+#blocked0 = #triton_gpu.blocked<{sizePerThread = [1], threadsPerWarp = [32], warpsPerCTA = [4], order = [0], CTAsPerCGA = [1], CTASplitNum = [1], CTAOrder = [0]}>
+module attributes {"triton_gpu.num-ctas" = 1 : i32, "triton_gpu.num-warps" = 4 : i32} {
+  // The old values are used.
+  // CHECK-LABEL: atomic_add_f32_used
+  tt.func @atomic_add_f32_used(%arg0 : tensor<256x!tt.ptr<f32>, #blocked0>, %arg1 : tensor<256xi1, #blocked0>, %arg2 : tensor<256xf32, #blocked0>) {
+    // CHECK: llvm.inline_asm
+    // CHECK-SAME: @$3 atom.global.gpu.relaxed.add.f32
+    %0 = "tt.atomic_rmw" (%arg0, %arg2, %arg1) {atomic_rmw_op = 5 : i32, sem = 1 : i32, scope = 1 : i32} : (tensor<256x!tt.ptr<f32>, #blocked0>, tensor<256xf32, #blocked0>, tensor<256xi1, #blocked0>) -> tensor<256xf32, #blocked0>
+    tt.store %arg0, %0 : tensor<256xf32, #blocked0>
+    tt.return
+  }
+}
+
+// -----
+
+#blocked0 = #triton_gpu.blocked<{sizePerThread = [4], threadsPerWarp = [32], warpsPerCTA = [4], order = [0], CTAsPerCGA = [1], CTASplitNum = [1], CTAOrder = [0]}>
+module attributes {"triton_gpu.compute-capability" = 90 : i32, "triton_gpu.num-ctas" = 1 : i32, "triton_gpu.num-warps" = 4 : i32} {
+  // CHECK-LABEL: atomic_add_f32_vec
+  tt.func @atomic_add_f32_vec(%arg0 : !tt.ptr<f32> {tt.divisibility = 16 : i32}, %arg1 : tensor<512xf32, #blocked0>) {
+    %0 = tt.splat %arg0 : (!tt.ptr<f32>) -> tensor<512x!tt.ptr<f32>, #blocked0>
+    %1 = tt.make_range {end = 512 : i32, start = 0 : i32} : tensor<512xi32, #blocked0>
+    %2 = tt.addptr %0, %1 : tensor<512x!tt.ptr<f32>, #blocked0>, tensor<512xi32, #blocked0>
+    // CHECK: llvm.inline_asm
+    // CHECK-SAME: @$5 red.global.gpu.relaxed.add.v4.f32 [ $0 + 0 ], { $1, $2, $3, $4 };
+    // CHECK-NOT: llvm.inline_asm
+    %3 = "tt.atomic_rmw" (%2, %arg1) {atomic_rmw_op = 5 : i32, sem = 1 : i32, scope = 1 : i32} : (tensor<512x!tt.ptr<f32>, #blocked0>, tensor<512xf32, #blocked0>) -> tensor<512xf32, #blocked0>
+    tt.return
+  }
+}
+
+// -----
+
+#blocked0 = #triton_gpu.blocked<{sizePerThread = [8], threadsPerWarp = [32], warpsPerCTA = [4], order = [0], CTAsPerCGA = [1], CTASplitNum = [1], CTAOrder = [0]}>
+module attributes {"triton_gpu.compute-capability" = 90 : i32, "triton_gpu.num-ctas" = 1 : i32, "triton_gpu.num-warps" = 4 : i32} {
+  // CHECK-LABEL: atomic_add_bf16_vec
+  tt.func @atomic_add_bf16_vec(%arg0 : !tt.ptr<bf16> {tt.divisibility = 16 : i32}, %arg1 : tensor<1024xbf16, #blocked0>) {
+    %0 = tt.splat %arg0 : (!tt.ptr<bf16>) -> tensor<1024x!tt.ptr<bf16>, #blocked0>
+    %1 = tt.make_range {end = 1024 : i32, start = 0 : i32} : tensor<1024xi32, #blocked0>
+    %2 = tt.addptr %0, %1 : tensor<1024x!tt.ptr<bf16>, #blocked0>, tensor<1024xi32, #blocked0>
+    // CHECK: llvm.inline_asm
+    // CHECK-SAME: @$5 red.global.gpu.relaxed.add.noftz.v4.bf16x2 [ $0 + 0 ], { $1, $2, $3, $4 };
+    // CHECK-SAME: "l,r,r,r,r,b"
+    // CHECK-NOT: llvm.inline_asm
+    %3 = "tt.atomic_rmw" (%2, %arg1) {atomic_rmw_op = 5 : i32, sem = 1 : i32, scope = 1 : i32} : (tensor<1024x!tt.ptr<bf16>, #blocked0>, tensor<1024xbf16, #blocked0>) -> tensor<1024xbf16, #blocked0>
+    tt.return
+  }
+}
+
+// -----
+
+#blocked0 = #triton_gpu.blocked<{sizePerThread = [1], threadsPerWarp = [32], warpsPerCTA = [4], order = [0], CTAsPerCGA = [1], CTASplitNum = [1], CTAOrder = [0]}>
+module attributes {"triton_gpu.num-ctas" = 1 : i32, "triton_gpu.num-warps" = 4 : i32} {
+  // The lanes updating the same bin combine their values first.
+  // CHECK-LABEL: atomic_add_i32_aggregate
+  tt.func @atomic_add_i32_aggregate(%arg0 : tensor<128x!tt.ptr<i32>, #blocked0>, %arg1 : tensor<128xi32, #blocked0>) {
+    // CHECK: match.any.sync.b64 $0, $1, 0xffffffff;
+    // CHECK: llvm.intr.ctpop
+    // CHECK-COUNT-5: fns.b32
+    // CHECK: red.global.gpu.relaxed.add.u32
+    %0 = "tt.atomic_rmw" (%arg0, %arg1) {atomic_rmw_op = 4 : i32, sem = 1 : i32, scope = 1 : i32, tt.warp_aggregate = true} : (tensor<128x!tt.ptr<i32>, #blocked0>, tensor<128xi32, #blocked0>) -> tensor<128xi32, #blocked0>
+    tt.return
+  }
+
+  // The pointers are the same across the lanes.
+  // CHECK-LABEL: atomic_add_f32_splat_aggregate
+  tt.func @atomic_add_f32_splat_aggregate(%arg0 : !tt.ptr<f32>, %arg1 : tensor<128xf32, #blocked0>) {
+    %0 = tt.splat %arg0 : (!tt.ptr<f32>) -> tensor<128x!tt.ptr<f32>, #blocked0>
+    // CHECK: match.any.sync.b64
+    // CHECK: llvm.fadd
+    // CHECK: red.global.gpu.relaxed.add.f32
+    %1 = "tt.atomic_rmw" (%0, %arg1) {atomic_rmw_op = 5 : i32, sem = 1 : i32, scope = 1 : i32} : (tensor<128x!tt.ptr<f32>, #blocked0>, tensor<128xf32, #blocked0>) -> tensor<128xf32, #blocked0>
+    tt.return
+  }
+}
+
+// -----
+
 #blocked0 = #triton_gpu.blocked<{sizePerThread = [1], threadsPerWarp = [32], warpsPerCTA = [4], order = [0], CTAsPerCGA = [1], CTASplitNum = [1], CTAOrder = [0]}>
 module attributes {"triton_gpu.num-ctas" = 1 : i32, "triton_gpu.num-warps" = 4 : i32} {
   // CHECK-LABEL: store_f32
@@ -1389,6 +1625,59 @@ module attributes {"triton_gpu.num-ctas" = 1 : i32, "triton_gpu.num-warps" = 1 :
   }
 }
 
+// -----
+#mma = #triton_gpu.nvidia_mma<{versionMajor = 2, versionMinor = 0, warpsPerCTA = [1, 1], CTAsPerCGA = [1, 1], CTASplitNum = [1, 1], CTAOrder = [0, 1], instrShape = [16, 8]}>
+#dot = #triton_gpu.dot_op<{opIdx = 1, parent = #mma, kWidth = 4}>
+module attributes {"triton_gpu.num-ctas" = 1 : i32, "triton_gpu.num-warps" = 1 : i32} {
+  // CHECK-LABEL: test_s8_to_f16_vectorized_conversion
+  tt.func @test_s8_to_f16_vectorized_conversion(%in: tensor<16x16xi8, #dot>) {
+    // CHECK-NOT: llvm.sitofp
+    // CHECK: llvm.inline_asm {{.*}}xor.b32 a, $2, 0x80808080
+    // CHECK: llvm.inline_asm {{.*}}xor.b32 a, $2, 0x80808080
+    // CHECK-NOT: llvm.inline_asm
+    %out = arith.sitofp %in : tensor<16x16xi8, #dot> to tensor<16x16xf16, #dot>
+    tt.return
+  }
+}
+
+// -----
+#mma = #triton_gpu.nvidia_mma<{versionMajor = 2, versionMinor = 0, warpsPerCTA = [1, 1], CTAsPerCGA = [1, 1], CTASplitNum = [1, 1], CTAOrder = [0, 1], instrShape = [16, 8]}>
+#dot = #triton_gpu.dot_op<{opIdx = 1, parent = #mma, kWidth = 4}>
+module attributes {"triton_gpu.num-ctas" = 1 : i32, "triton_gpu.num-warps" = 1 : i32} {
+  // The nibbles are converted from the packed bytes, not from the shifts.
+  // CHECK-LABEL: test_s4_to_f16_conversion
+  tt.func @test_s4_to_f16_conversion(%in: tensor<16x16xi8, #dot>) {
+    // CHECK-NOT: llvm.sitofp
+    // CHECK: llvm.inline_asm {{.*}}mov.b32 a, $2;{{.*}}lop3.b32 a, a, 0x0f0f0f0f, 0x08080808, 0x6a
+    // CHECK: llvm.inline_asm {{.*}}mov.b32 a, $2;{{.*}}lop3.b32 a, a, 0x0f0f0f0f, 0x08080808, 0x6a
+    // CHECK: llvm.inline_asm {{.*}}shr.b32 a, $2, 4;{{.*}}lop3.b32 a, a, 0x0f0f0f0f, 0x08080808, 0x6a
+    // CHECK: llvm.inline_asm {{.*}}shr.b32 a, $2, 4;{{.*}}lop3.b32 a, a, 0x0f0f0f0f, 0x08080808, 0x6a
+    // CHECK-NOT: llvm.sitofp
+    %c4 = arith.constant dense<4> : tensor<16x16xi8, #dot>
+    %shl = arith.shli %in, %c4 : tensor<16x16xi8, #dot>
+    %lo = arith.shrsi %shl, %c4 : tensor<16x16xi8, #dot>
+    %hi = arith.shrsi %in, %c4 : tensor<16x16xi8, #dot>
+    %lo_f16 = arith.sitofp %lo : tensor<16x16xi8, #dot> to tensor<16x16xf16, #dot>
+    %hi_f16 = arith.sitofp %hi : tensor<16x16xi8, #dot> to tensor<16x16xf16, #dot>
+    tt.return
+  }
+}
+
+// -----
+#blocked = #triton_gpu.blocked<{sizePerThread = [4], threadsPerWarp = [32], warpsPerCTA = [1], order = [0], CTAsPerCGA = [1], CTASplitNum = [1], CTAOrder = [0]}>
+module attributes {"triton_gpu.num-ctas" = 1 : i32, "triton_gpu.num-warps" = 1 : i32} {
+  // CHECK-LABEL: test_u4_to_f16_conversion
+  tt.func @test_u4_to_f16_conversion(%in: tensor<128xi8, #blocked>) {
+    // CHECK-NOT: llvm.uitofp
+    // CHECK: llvm.inline_asm {{.*}}mov.b32 a, $2;{{.*}}lop3.b32 a, a, 0x0f0f0f0f, 0, 0x6a
+    // CHECK-NOT: llvm.uitofp
+    %c15 = arith.constant dense<15> : tensor<128xi8, #blocked>
+    %lo = arith.andi %in, %c15 : tensor<128xi8, #blocked>
+    %lo_f16 = arith.uitofp %lo : tensor<128xi8, #blocked> to tensor<128xf16, #blocked>
+    tt.return
+  }
+}
+
 // -----
 
 // CHECK-LABEL: sum_reduction
@@ -1427,6 +1716,24 @@ module attributes {"triton_gpu.compute-capability" = 80 : i32, "triton_gpu.num-c
   }
 }
 
+// -----
+
+#blocked = #triton_gpu.blocked<{sizePerThread = [2, 1], threadsPerWarp = [1, 32], warpsPerCTA = [4, 1], order = [1, 0], CTAsPerCGA = [1, 1], CTASplitNum = [1, 1], CTAOrder = [1, 0]}>
+module attributes {"triton_gpu.compute-capability" = 80 : i32, "triton_gpu.num-ctas" = 1 : i32, "triton_gpu.num-warps" = 4 : i32} {
+  // The two f16 rows of a thread share their shuffles.
+  // CHECK-LABEL: reduce_packed_f16
+  tt.func public @reduce_packed_f16(%arg0: tensor<8x32xf16, #blocked>) -> tensor<8xf16, #triton_gpu.slice<{dim = 1, parent = #blocked}>> {
+    // CHECK-COUNT-5: nvvm.shfl.sync bfly {{.*}} : i32 -> i32
+    // CHECK-NOT: nvvm.shfl.sync
+    %0 = "tt.reduce"(%arg0) <{axis = 1 : i32}> ({
+    ^bb0(%arg1: f16, %arg2: f16):
+      %1 = arith.maximumf %arg1, %arg2 : f16
+      tt.reduce.return %1 : f16
+    }) : (tensor<8x32xf16, #blocked>) -> tensor<8xf16, #triton_gpu.slice<{dim = 1, parent = #blocked}>>
+    tt.return %0 : tensor<8xf16, #triton_gpu.slice<{dim = 1, parent = #blocked}>>
+  }
+}
+
 // -----
 #blocked = #triton_gpu.blocked<{sizePerThread = [8, 1], threadsPerWarp = [32, 1], warpsPerCTA = [1, 2], order = [1, 0], CTAsPerCGA = [1, 1], CTASplitNum = [1, 1], CTAOrder = [1, 0]}>
 #slice = #triton_gpu.slice<{dim = 1, parent = #blocked}>
@@ -1515,3 +1822,298 @@ module attributes {"triton_gpu.compute-capability" = 70 : i32, "triton_gpu.num-c
     tt.return
   }
 }
+
+// -----
+
+#blocked = #triton_gpu.blocked<{sizePerThread = [1, 4], threadsPerWarp = [2, 16], warpsPerCTA = [1, 4], order = [1, 0], CTAsPerCGA = [1, 1], CTASplitNum = [1, 1], CTAOrder = [1, 0]}>
+#shared0 = #triton_gpu.shared<{vec = 1, perPhase = 1, maxPhase = 1, order = [1, 0], CTAsPerCGA = [1, 1], CTASplitNum = [1, 1], CTAOrder = [1, 0]}>
+#shared1 = #triton_gpu.shared<{vec = 1, perPhase = 1, maxPhase = 1, order = [0, 1], CTAsPerCGA = [1, 1], CTASplitNum = [1, 1], CTAOrder = [1, 0]}>
+#dot_operand_a = #triton_gpu.dot_op<{opIdx=0, parent=#blocked}>
+#dot_operand_b = #triton_gpu.dot_op<{opIdx=1, parent=#blocked}>
+module attributes {"triton_gpu.num-ctas" = 1 : i32, "triton_gpu.num-warps" = 4 : i32} {
+  // The operands contiguous along k are loaded 4 bytes at a time.
+  // CHECK-LABEL: matmul_int8_fmadot
+  tt.func @matmul_int8_fmadot(%ptr:!tt.ptr<i32> {tt.divisibility = 16 : i32},
+  %a:tensor<32x16xi8, #shared0>, %b:tensor<16x32xi8, #shared1>) {
+    %cst = arith.constant dense<0> : tensor<32x32xi32, #blocked>
+    // CHECK: llvm.load {{.*}} -> vector<4xi8>
+    // CHECK: llvm.load {{.*}} -> vector<4xi8>
+    // CHECK: llvm.inline_asm
+    // CHECK-SAME: dp4a.s32.s32
+    // CHECK-NOT: llvm.intr.fmuladd
+    %a_mat = triton_gpu.convert_layout %a : (tensor<32x16xi8, #shared0>) -> tensor<32x16xi8, #dot_operand_a>
+    %b_mat = triton_gpu.convert_layout %b : (tensor<16x32xi8, #shared1>) -> tensor<16x32xi8, #dot_operand_b>
+
+    %28 = tt.dot %a_mat, %b_mat, %cst {allowTF32 = false, maxNumImpreciseAcc = 0 : i32} : tensor<32x16xi8, #dot_operand_a> * tensor<16x32xi8, #dot_operand_b> -> tensor<32x32xi32, #blocked>
+    %30 = tt.splat %ptr : (!tt.ptr<i32>) -> tensor<32x1x!tt.ptr<i32>, #blocked>
+    %36 = tt.broadcast %30 : (tensor<32x1x!tt.ptr<i32>, #blocked>) -> tensor<32x32x!tt.ptr<i32>, #blocked>
+    tt.store %36, %28 : tensor<32x32xi32, #blocked>
+    tt.return
+  }
+}
+
+// -----
+
+#blocked = #triton_gpu.blocked<{sizePerThread = [1], threadsPerWarp = [32], warpsPerCTA = [4], order = [0], CTAsPerCGA = [1], CTASplitNum = [1], CTAOrder = [0]}>
+module attributes {"triton_gpu.num-ctas" = 1 : i32, "triton_gpu.num-warps" = 4 : i32} {
+  // The bins outnumber the threads, each warp counts its values in its own
+  // sub-histogram.
+  // CHECK-LABEL: histogram_privatized
+  tt.func @histogram_privatized(%arg0 : tensor<256xi32, #blocked>) -> tensor<1024xi32, #blocked> {
+    // CHECK-NOT: nvvm.vote.ballot
+    // CHECK: nvvm.barrier0
+    // CHECK: llvm.icmp "ult"
+    // CHECK: llvm.atomicrmw add {{.*}} monotonic
+    // CHECK: nvvm.barrier0
+    // CHECK-COUNT-4: llvm.load
+    %0 = tt.histogram %arg0 : tensor<256xi32, #blocked> -> tensor<1024xi32, #blocked>
+    tt.return %0 : tensor<1024xi32, #blocked>
+  }
+
+  // The ballots need a power of two number of bins.
+  // CHECK-LABEL: histogram_non_power_of_two
+  tt.func @histogram_non_power_of_two(%arg0 : tensor<256xi32, #blocked>) -> tensor<48xi32, #blocked> {
+    // CHECK-NOT: nvvm.vote.ballot
+    // CHECK: llvm.atomicrmw add {{.*}} monotonic
+    %0 = tt.histogram %arg0 : tensor<256xi32, #blocked> -> tensor<48xi32, #blocked>
+    tt.return %0 : tensor<48xi32, #blocked>
+  }
+}
+
+// -----
+
+#blocked = #triton_gpu.blocked<{sizePerThread = [4], threadsPerWarp = [32], warpsPerCTA = [4], order = [0], CTAsPerCGA = [1], CTASplitNum = [1], CTAOrder = [0]}>
+module attributes {"triton_gpu.num-ctas" = 1 : i32, "triton_gpu.num-warps" = 4 : i32} {
+  // The sort of 512 elements exchanges them within the threads, then across
+  // the lanes with shuffles, and across the warps through shared memory.
+  // CHECK-LABEL: sort_across_warps
+  tt.func @sort_across_warps(%arg0 : tensor<512xf32, #blocked>) -> tensor<512xf32, #blocked> {
+    // CHECK: llvm.fcmp "olt"
+    // CHECK: nvvm.shfl.sync bfly
+    // CHECK: llvm.store
+    // CHECK: nvvm.barrier0
+    // CHECK: llvm.load
+    %0 = tt.sort %arg0 {axis = 0 : i32, descending = false} : tensor<512xf32, #blocked>
+    tt.return %0 : tensor<512xf32, #blocked>
+  }
+
+  // The 128 elements fit in a warp, the warps hold copies of them.
+  // CHECK-LABEL: sort_within_warp
+  tt.func @sort_within_warp(%arg0 : tensor<128xi32, #blocked>) -> tensor<128xi32, #blocked> {
+    // CHECK: llvm.icmp "slt"
+    // CHECK: nvvm.shfl.sync bfly
+    // CHECK-NOT: nvvm.barrier0
+    // CHECK: llvm.return
+    %0 = tt.sort %arg0 {axis = 0 : i32, descending = true} : tensor<128xi32, #blocked>
+    tt.return %0 : tensor<128xi32, #blocked>
+  }
+}
+
+// -----
+
+#blocked = #triton_gpu.blocked<{sizePerThread = [4], threadsPerWarp = [32], warpsPerCTA = [4], order = [0], CTAsPerCGA = [1], CTASplitNum = [1], CTAOrder = [0]}>
+module attributes {"triton_gpu.compute-capability" = 80 : i32, "triton_gpu.num-ctas" = 1 : i32, "triton_gpu.num-warps" = 4 : i32} {
+  // The consecutive 16-bit elements of a thread are computed in pairs.
+  // CHECK-LABEL: packed_f16_arith
+  tt.func @packed_f16_arith(%arg0 : tensor<512xf16, #blocked>, %arg1 : tensor<512xf16, #blocked>, %cond : i1) -> tensor<512xf16, #blocked> {
+    // CHECK-COUNT-2: add.rn.f16x2 $0, $1, $2;
+    %0 = arith.addf %arg0, %arg1 : tensor<512xf16, #blocked>
+    // CHECK-COUNT-2: max.NaN.f16x2 $0, $1, $2;
+    %1 = arith.maximumf %0, %arg1 : tensor<512xf16, #blocked>
+    // CHECK-COUNT-2: selp.b32 $0, $2, $3, $1;
+    %2 = arith.select %cond, %1, %arg0 : tensor<512xf16, #blocked>
+    tt.return %2 : tensor<512xf16, #blocked>
+  }
+
+  // CHECK-LABEL: packed_bf16_arith
+  tt.func @packed_bf16_arith(%arg0 : tensor<512xbf16, #blocked>, %arg1 : tensor<512xbf16, #blocked>) -> tensor<512xbf16, #blocked> {
+    // CHECK-COUNT-2: fma.rn.bf16x2 $0, $1, $2, c;
+    %0 = arith.mulf %arg0, %arg1 : tensor<512xbf16, #blocked>
+    // CHECK-COUNT-2: fma.rn.bf16x2 $0, $2, c, $1;
+    %1 = arith.subf %0, %arg1 : tensor<512xbf16, #blocked>
+    tt.return %1 : tensor<512xbf16, #blocked>
+  }
+}
+
+// -----
+
+#blocked = #triton_gpu.blocked<{sizePerThread = [4], threadsPerWarp = [32], warpsPerCTA = [4], order = [0], CTAsPerCGA = [1], CTASplitNum = [1], CTAOrder = [0]}>
+module attributes {"triton_gpu.compute-capability" = 80 : i32, "triton_gpu.num-ctas" = 1 : i32, "triton_gpu.num-warps" = 4 : i32} {
+  // There is no cvt from e4m3 before sm89, the upcasts are emulated four
+  // elements at a time.
+  // CHECK-LABEL: emulated_fp8_upcast
+  tt.func @emulated_fp8_upcast(%in0 : tensor<512xf8E4M3FNUZ, #blocked>, %in1 : tensor<512xf8E5M2, #blocked>) {
+    // CHECK-NOT: cvt.rn.f16x2.e4m3x2
+    // CHECK: mul.rn.f16x2 b0, b0, e8;{{.*}}"=r,=r,r"
+    // CHECK-NOT: mul.rn.f16x2 b0, b0, e8
+    %0 = tt.fp_to_fp %in0 : tensor<512xf8E4M3FNUZ, #blocked> -> tensor<512xf16, #blocked>
+    // CHECK: fma.rn.bf16x2 b0, b0, e120, nz;{{.*}}"=r,=r,r"
+    %1 = tt.fp_to_fp %in0 : tensor<512xf8E4M3FNUZ, #blocked> -> tensor<512xbf16, #blocked>
+    // sm80 has the bf16x2 fma but no mul
+    // CHECK: fma.rn.bf16x2 $0, b0, e112, nz;
+    // CHECK-NOT: mul.f32 d0, c0, e112
+    %2 = tt.fp_to_fp %in1 : tensor<512xf8E5M2, #blocked> -> tensor<512xbf16, #blocked>
+    tt.return
+  }
+}
+
+// -----
+
+#blocked = #triton_gpu.blocked<{sizePerThread = [4], threadsPerWarp = [32], warpsPerCTA = [4], order = [0], CTAsPerCGA = [1], CTASplitNum = [1], CTAOrder = [0]}>
+module attributes {"triton_gpu.compute-capability" = 80 : i32, "triton_gpu.num-ctas" = 1 : i32, "triton_gpu.num-warps" = 4 : i32} {
+  // The 16 bits dropped by the conversion are randomized before truncating.
+  // CHECK-LABEL: stochastic_fp32_to_bf16
+  tt.func @stochastic_fp32_to_bf16(%in : tensor<512xf32, #blocked>, %rbits : tensor<512xi32, #blocked>) {
+    // CHECK: llvm.mlir.constant(65535 : i32)
+    // CHECK: llvm.and
+    // CHECK: llvm.add
+    // CHECK: llvm.fcmp "uno"
+    // CHECK: llvm.select
+    // CHECK: cvt.rz.bf16.f32
+    %0 = tt.fp_to_fp %in, %rbits {rounding = 2 : i32} : tensor<512xf32, #blocked>, tensor<512xi32, #blocked> -> tensor<512xbf16, #blocked>
+    tt.return
+  }
+}
+
+// -----
+
+#blocked = #triton_gpu.blocked<{sizePerThread = [8], threadsPerWarp = [32], warpsPerCTA = [4], order = [0], CTAsPerCGA = [1], CTASplitNum = [1], CTAOrder = [0]}>
+module attributes {"triton_gpu.compute-capability" = 80 : i32, "triton_gpu.num-ctas" = 1 : i32, "triton_gpu.num-warps" = 4 : i32, "triton_gpu.rolled-loops" = 8 : i32} {
+  // The 8 elements of each thread are added by a loop instead of 8 adds.
+  // CHECK-LABEL: rolled_elementwise
+  tt.func @rolled_elementwise(%a : tensor<1024xf32, #blocked>, %b : tensor<1024xf32, #blocked>) -> tensor<1024xf32, #blocked> {
+    // CHECK: llvm.alloca {{.*}} x f32
+    // CHECK: llvm.br ^[[HEADER:bb[0-9]+]]
+    // CHECK: ^[[HEADER]]({{.*}}: i32):
+    // CHECK: llvm.cond_br {{.*}}, ^[[BODY:bb[0-9]+]], ^[[AFTER:bb[0-9]+]]
+    // CHECK: ^[[BODY]]:
+    // CHECK: llvm.fadd
+    // CHECK-NOT: llvm.fadd
+    // CHECK: llvm.br ^[[HEADER]]
+    // CHECK: ^[[AFTER]]:
+    %0 = arith.addf %a, %b : tensor<1024xf32, #blocked>
+    tt.return %0 : tensor<1024xf32, #blocked>
+  }
+}
+
+// -----
+
+module attributes {"triton_gpu.compute-capability" = 80 : i32, "triton_gpu.num-ctas" = 1 : i32, "triton_gpu.num-warps" = 4 : i32, "triton_gpu.num-branch-counters" = 2 : i32} {
+  // The counters are incremented by the first thread of the program.
+  // CHECK: llvm.mlir.global external @triton_branch_counters(dense<0> : tensor<2xi64>) {addr_space = 1 : i32
+  // CHECK-LABEL: profile_counter
+  tt.func @profile_counter() {
+    // CHECK: llvm.mlir.addressof @triton_branch_counters
+    // CHECK: llvm.getelementptr {{.*}} -> !llvm.ptr<1>, i64
+    // CHECK: @${{.*}} red.global.add.u64 [ ${{.*}} + 0 ], 1;
+    triton_gpu.profile_counter {index = 1 : i32}
+    tt.return
+  }
+}
+
+// -----
+
+module attributes {"triton_gpu.compute-capability" = 80 : i32, "triton_gpu.num-ctas" = 1 : i32, "triton_gpu.num-warps" = 4 : i32, "triton_gpu.profile-programs" = 2 : i32} {
+  // 2 programs of 4 warps record 2 regions of 5 fields.
+  // CHECK: llvm.mlir.global external @triton_profile_records(dense<0> : tensor<80xi64>) {addr_space = 1 : i32
+  // CHECK-LABEL: profile_mark
+  tt.func @profile_mark() {
+    // CHECK: llvm.mlir.addressof @triton_profile_records
+    // CHECK: mov.u64 t, %clock64;
+    // CHECK-SAME: atom.global.cas.b64
+    tt.profile_mark "outer"
+    // CHECK: mov.u64 t, %clock64;
+    // CHECK-SAME: st.global.u64
+    tt.profile_mark "inner"
+    // CHECK: red.global.add.u64 [$0+8], t;
+    tt.profile_mark "inner" {end}
+    // CHECK: red.global.add.u64 [$0+8], t;
+    tt.profile_mark "outer" {end}
+    tt.return
+  }
+}
+
+// -----
+
+module attributes {"triton_gpu.compute-capability" = 80 : i32, "triton_gpu.num-ctas" = 1 : i32, "triton_gpu.num-warps" = 4 : i32} {
+  // CHECK: "triton_gpu.cooperative" = 1 : i32
+  // CHECK: llvm.mlir.global external @triton_grid_sync_counter(0 : i32) {addr_space = 1 : i32
+  // CHECK-LABEL: grid_sync
+  tt.func @grid_sync() {
+    // CHECK: nvvm.barrier0
+    // CHECK: atom.global.add.u32 old, [$0], $1;
+    // CHECK-SAME: ld.volatile.global.u32 cur, [$0];
+    // CHECK: nvvm.barrier0
+    tt.grid_sync
+    tt.return
+  }
+}
+
+// -----
+
+#blocked = #triton_gpu.blocked<{sizePerThread = [1], threadsPerWarp = [32], warpsPerCTA = [4], order = [0], CTAsPerCGA = [1], CTASplitNum = [1], CTAOrder = [0]}>
+module attributes {"triton_gpu.compute-capability" = 80 : i32, "triton_gpu.num-ctas" = 1 : i32, "triton_gpu.num-warps" = 4 : i32, "triton_gpu.print-buffer" = 4 : i32} {
+  // The print writes records of 7 words to the ring buffer instead of
+  // calling vprintf.
+  // CHECK: "triton_gpu.print-formats" = ["f32;1;0;1; x: "], "triton_gpu.print-record-words" = 7 : i32
+  // CHECK: llvm.mlir.global external @triton_print_buffer(dense<0> : tensor<30xi32>) {addr_space = 1 : i32
+  // CHECK-LABEL: print_buffer
+  tt.func @print_buffer(%x : tensor<128xf32, #blocked>) {
+    // CHECK-NOT: vprintf
+    // CHECK: llvm.atomicrmw add {{.*}} monotonic : !llvm.ptr<1>, i64
+    // CHECK: llvm.bitcast {{.*}} : f32 to i32
+    // CHECK-COUNT-7: llvm.store {{.*}} : i32, !llvm.ptr<1>
+    // CHECK-NOT: vprintf
+    tt.print " x: " : %x : tensor<128xf32, #blocked>
+    tt.return
+  }
+}
+
+// -----
+
+#blocked = #triton_gpu.blocked<{sizePerThread = [1, 16], threadsPerWarp = [32, 1], warpsPerCTA = [2, 1], order = [1, 0], CTAsPerCGA = [1, 1], CTASplitNum = [1, 1], CTAOrder = [1, 0]}>
+module attributes {"triton_gpu.num-ctas" = 1 : i32, "triton_gpu.num-warps" = 2 : i32} {
+  // CHECK-LABEL: gather_thread_local
+  tt.func @gather_thread_local(%src: tensor<64x16xf32, #blocked>, %idx: tensor<64x16xi32, #blocked>) {
+    // Each row is held by a single thread: the gather is a tree of selects
+    // CHECK-NOT: nvvm.shfl.sync
+    // CHECK-NOT: llvm.store
+    // CHECK: llvm.select
+    // CHECK-NOT: nvvm.shfl.sync
+    // CHECK-NOT: llvm.store
+    %0 = tt.gather %src[%idx] {axis = 1 : i32} : (tensor<64x16xf32, #blocked>, tensor<64x16xi32, #blocked>) -> tensor<64x16xf32, #blocked>
+    tt.return
+  }
+}
+
+// -----
+
+#blocked = #triton_gpu.blocked<{sizePerThread = [1], threadsPerWarp = [32], warpsPerCTA = [1], order = [0], CTAsPerCGA = [1], CTASplitNum = [1], CTAOrder = [0]}>
+module attributes {"triton_gpu.num-ctas" = 1 : i32, "triton_gpu.num-warps" = 1 : i32} {
+  // CHECK-LABEL: gather_warp_shuffle
+  tt.func @gather_warp_shuffle(%src: tensor<32xf32, #blocked>, %idx: tensor<128xi32, #blocked>) {
+    // The source stays within the warp: one shuffle per gathered element
+    // CHECK-NOT: llvm.store
+    // CHECK-COUNT-4: nvvm.shfl.sync idx
+    // CHECK-NOT: nvvm.shfl.sync
+    // CHECK-NOT: llvm.store
+    %0 = tt.gather %src[%idx] {axis = 0 : i32} : (tensor<32xf32, #blocked>, tensor<128xi32, #blocked>) -> tensor<128xf32, #blocked>
+    tt.return
+  }
+}
+
+// -----
+
+#blocked = #triton_gpu.blocked<{sizePerThread = [1, 1], threadsPerWarp = [4, 8], warpsPerCTA = [2, 1], order = [1, 0], CTAsPerCGA = [1, 1], CTASplitNum = [1, 1], CTAOrder = [1, 0]}>
+module attributes {"triton_gpu.num-ctas" = 1 : i32, "triton_gpu.num-warps" = 2 : i32} {
+  // CHECK-LABEL: gather_shared
+  tt.func @gather_shared(%src: tensor<32x8xf32, #blocked>, %idx: tensor<64x8xi32, #blocked>) {
+    // The gathered axis spans the warps: the source goes through shared memory
+    // CHECK-NOT: nvvm.shfl.sync
+    // CHECK: llvm.store {{.*}} : f32, !llvm.ptr<3>
+    // CHECK: nvvm.barrier0
+    // CHECK: llvm.load {{.*}} : !llvm.ptr<3> -> f32
+    %0 = tt.gather %src[%idx] {axis = 0 : i32} : (tensor<32x8xf32, #blocked>, tensor<64x8xi32, #blocked>) -> tensor<64x8xf32, #blocked>
+    tt.return
+  }
+}
@@ -0,0 +1,47 @@
+// RUN: triton-opt %s -split-input-file --convert-triton-gpu-to-llvm="target=nvvm fast-math=true" | FileCheck %s
+// RUN: triton-opt %s -split-input-file --convert-triton-gpu-to-llvm="target=nvvm" | FileCheck %s --check-prefix=PRECISE
+// RUN: triton-opt %s -split-input-file --convert-triton-gpu-to-llvm="target=nvvm fast-math=true compute-capability=70" | FileCheck %s --check-prefix=SM70
+
+#blocked = #triton_gpu.blocked<{sizePerThread = [1], threadsPerWarp = [32], warpsPerCTA = [4], order = [0], CTAsPerCGA = [1], CTASplitNum = [1], CTAOrder = [0]}>
+module attributes {"triton_gpu.compute-capability" = 80 : i32, "triton_gpu.num-ctas" = 1 : i32, "triton_gpu.num-warps" = 4 : i32} {
+  // CHECK-LABEL: fast_math_f32
+  // PRECISE-LABEL: fast_math_f32
+  tt.func @fast_math_f32(%arg0 : tensor<128xf32, #blocked>, %arg1 : tensor<128xf32, #blocked>) -> tensor<128xf32, #blocked> {
+    // CHECK: lg2.approx.f32 $0, $1;
+    // CHECK: llvm.fmul
+    // PRECISE-NOT: lg2.approx.f32
+    %0 = math.log %arg0 : tensor<128xf32, #blocked>
+    // CHECK: sin.approx.f32 $0, $1;
+    %1 = math.sin %0 : tensor<128xf32, #blocked>
+    // CHECK: cos.approx.f32 $0, $1;
+    %2 = math.cos %1 : tensor<128xf32, #blocked>
+    // CHECK: rsqrt.approx.f32 $0, $1;
+    // PRECISE: llvm.call @__nv_rsqrtf
+    %3 = tt.extern_elementwise %2 {libname = "libdevice", libpath = "", pure = true, symbol = "__nv_rsqrtf"} : (tensor<128xf32, #blocked>) -> tensor<128xf32, #blocked>
+    // CHECK: tanh.approx.f32 $0, $1;
+    // PRECISE: llvm.call @__nv_tanhf
+    // tanh.approx needs sm75
+    // SM70-NOT: tanh.approx.f32
+    // SM70: llvm.call @__nv_tanhf
+    %4 = tt.extern_elementwise %3 {libname = "libdevice", libpath = "", pure = true, symbol = "__nv_tanhf"} : (tensor<128xf32, #blocked>) -> tensor<128xf32, #blocked>
+    // CHECK: div.approx.f32 $0, $1, $2;
+    // PRECISE: div.full.f32 $0, $1, $2;
+    %5 = arith.divf %4, %arg1 : tensor<128xf32, #blocked>
+    // The functions without an SFU instruction still go to libdevice
+    // CHECK: llvm.call @__nv_erff
+    %6 = tt.extern_elementwise %5 {libname = "libdevice", libpath = "", pure = true, symbol = "__nv_erff"} : (tensor<128xf32, #blocked>) -> tensor<128xf32, #blocked>
+    tt.return %6 : tensor<128xf32, #blocked>
+  }
+
+  // Only f32 is approximated.
+  // CHECK-LABEL: fast_math_f64
+  // CHECK-NOT: approx
+  // CHECK: llvm.call @__nv_tanh
+  // CHECK: div.rn.f64
+  tt.func @fast_math_f64(%arg0 : tensor<128xf64, #blocked>) -> tensor<128xf64, #blocked> {
+    %0 = tt.extern_elementwise %arg0 {libname = "libdevice", libpath = "", pure = true, symbol = "__nv_tanh"} : (tensor<128xf64, #blocked>) -> tensor<128xf64, #blocked>
+    %1 = arith.divf %0, %arg0 : tensor<128xf64, #blocked>
+    tt.return %1 : tensor<128xf64, #blocked>
+  }
+}
+
@@ -1,4 +1,5 @@
 // RUN: triton-opt %s -split-input-file --convert-nv-gpu-to-llvm | FileCheck %s
+// RUN: triton-opt %s -split-input-file --convert-nv-gpu-to-llvm="mbarrier-suspend-time=0 mbarrier-backoff=64" | FileCheck %s --check-prefix=BACKOFF
 #SHARED = #triton_gpu.shared<{vec = 2, perPhase = 2, maxPhase = 4, order = [1, 0]}>
 module attributes {"triton_gpu.num-warps" = 4 : i32,  "triton_gpu.num-ctas" = 2 : i32} {
   tt.func @test_mbarrier() {
@@ -12,7 +13,9 @@ module attributes {"triton_gpu.num-warps" = 4 : i32,  "triton_gpu.num-ctas" = 2
     nvgpu.mbarrier_arrive %mbarrier, %pred {arriveType = 0 : i32}: !llvm.ptr<3>
     // CHECK: llvm.inline_asm
     nvgpu.mbarrier_arrive %mbarrier, %pred {arriveType = 2 : i32, txCount = 128 : i32}: !llvm.ptr<3>
-    // CHECK: llvm.inline_asm
+    // CHECK: llvm.inline_asm {{.*}}mbarrier.try_wait.parity.shared.b64 P1, [$0], $1, 10000000;
+    // CHECK-NOT: nanosleep
+    // BACKOFF: llvm.inline_asm {{.*}}mbarrier.try_wait.parity.shared.b64 P1, [$0], $1;{{.*}}@P1 bra.uni DONE;{{.*}}nanosleep.u32 64;{{.*}}bra.uni LAB_WAIT;
     nvgpu.mbarrier_wait %mbarrier, %pred : !llvm.ptr<3>, i1
     tt.return
   }
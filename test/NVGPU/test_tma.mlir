@@ -24,6 +24,16 @@ module attributes {"triton_gpu.num-warps" = 4 : i32,  "triton_gpu.num-ctas" = 2
     nvgpu.tma_load_tiled %dst, %mbarrier, %tmaDesc, %l2desc, %pred, %c0, %c1, %mask {operandSegmentSizes = array<i32: 1, 1, 1, 1, 1, 2, 1>}: !llvm.ptr<3>, !llvm.ptr<3>, !llvm.ptr<1>, i64, i1, i32, i32, i16
     nvgpu.tma_load_tiled %dst, %mbarrier, %tmaDesc, %l2desc, %pred, %c0, %c1, %c2, %c3 {operandSegmentSizes = array<i32: 1, 1, 1, 1, 1, 4, 0>}: !llvm.ptr<3>, !llvm.ptr<3>, !llvm.ptr<1>, i64, i1, i32, i32, i32, i32
 
+    // CHECK: llvm.inline_asm {{.*}} cp.async.bulk.tensor.3d.shared::cluster.global.mbarrier::complete_tx::bytes.multicast::cluster.L2::cache_hint [$0], [$1, {$2, $3, $4}], [$5], $6, $7;
+    // CHECK: llvm.inline_asm {{.*}} cp.async.bulk.tensor.4d.shared::cluster.global.mbarrier::complete_tx::bytes.multicast::cluster.L2::cache_hint [$0], [$1, {$2, $3, $4, $5}], [$6], $7, $8;
+    nvgpu.tma_load_tiled %dst, %mbarrier, %tmaDesc, %l2desc, %pred, %c0, %c1, %c2, %mask {operandSegmentSizes = array<i32: 1, 1, 1, 1, 1, 3, 1>}: !llvm.ptr<3>, !llvm.ptr<3>, !llvm.ptr<1>, i64, i1, i32, i32, i32, i16
+    nvgpu.tma_load_tiled %dst, %mbarrier, %tmaDesc, %l2desc, %pred, %c0, %c1, %c2, %c3, %mask {operandSegmentSizes = array<i32: 1, 1, 1, 1, 1, 4, 1>}: !llvm.ptr<3>, !llvm.ptr<3>, !llvm.ptr<1>, i64, i1, i32, i32, i32, i32, i16
+
+    // CHECK: llvm.inline_asm {{.*}} "@$5 cp.async.bulk.tensor.3d.global.shared::cta.bulk_group[$0, {$2, $3, $4}], [$1];"
+    // CHECK: llvm.inline_asm {{.*}} "@$7 cp.async.bulk.tensor.5d.global.shared::cta.bulk_group[$0, {$2, $3, $4, $5, $6}], [$1];"
+    nvgpu.tma_store_tiled %tmaDesc, %dst, %pred, %c0, %c1, %c2 : !llvm.ptr<1>, !llvm.ptr<3>, i1, i32, i32, i32
+    nvgpu.tma_store_tiled %tmaDesc, %dst, %pred, %c0, %c1, %c2, %c3, %c4 : !llvm.ptr<1>, !llvm.ptr<3>, i1, i32, i32, i32, i32, i32
+
     tt.return
   }
 } // end module
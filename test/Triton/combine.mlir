@@ -215,3 +215,129 @@ tt.func @test_fold_views() -> (tensor<16x8xf32>, tensor<16x128xf32>, tensor<1x1x
 
     tt.return %b, %c, %d : tensor<16x8xf32>, tensor<16x128xf32>, tensor<1x1x128xf32>
 }
+
+// -----
+
+// CHECK-LABEL: @test_decompose_scaled_dot
+tt.func @test_decompose_scaled_dot(%a: tensor<128x32xf8E5M2>, %b: tensor<32x64xf8E5M2>, %c: tensor<128x64xf32>,
+                                   %a_scale: tensor<128x1xf32>, %b_scale: tensor<1x64xf32>) -> tensor<128x64xf32> {
+    // CHECK: %[[ZERO:.*]] = arith.constant dense<0.000000e+00> : tensor<128x64xf32>
+    // CHECK: %[[PARTIAL:.*]] = tt.dot %{{.*}}, %{{.*}}, %[[ZERO]] {allowTF32 = true, maxNumImpreciseAcc = 1073741824 : i32}
+    // CHECK: %[[A_SCALE:.*]] = tt.broadcast %{{.*}} : (tensor<128x1xf32>) -> tensor<128x64xf32>
+    // CHECK: %[[B_SCALE:.*]] = tt.broadcast %{{.*}} : (tensor<1x64xf32>) -> tensor<128x64xf32>
+    // CHECK: %[[SCALE:.*]] = arith.mulf %[[A_SCALE]], %[[B_SCALE]]
+    // CHECK: %[[SCALED:.*]] = arith.mulf %[[PARTIAL]], %[[SCALE]]
+    // CHECK: %[[RES:.*]] = arith.addf %{{.*}}, %[[SCALED]]
+    // CHECK: tt.return %[[RES]]
+    %d = tt.dot_scaled %a, %b, %c, %a_scale, %b_scale {allowTF32 = true, maxNumImpreciseAcc = 1073741824 : i32} : tensor<128x32xf8E5M2> * tensor<32x64xf8E5M2> scale tensor<128x1xf32> * tensor<1x64xf32> -> tensor<128x64xf32>
+    tt.return %d : tensor<128x64xf32>
+}
+
+// CHECK-LABEL: @test_decompose_scaled_int_dot
+tt.func @test_decompose_scaled_int_dot(%a: tensor<128x32xi8>, %b: tensor<32x64xi8>, %c: tensor<128x64xf32>,
+                                       %a_scale: tensor<128x1xf32>, %b_scale: tensor<1x64xf32>) -> tensor<128x64xf32> {
+    // CHECK: %[[ZERO:.*]] = arith.constant dense<0> : tensor<128x64xi32>
+    // CHECK: %[[PARTIAL:.*]] = tt.dot %{{.*}}, %{{.*}}, %[[ZERO]]
+    // CHECK: arith.sitofp %[[PARTIAL]] : tensor<128x64xi32> to tensor<128x64xf32>
+    %d = tt.dot_scaled %a, %b, %c, %a_scale, %b_scale {allowTF32 = true, maxNumImpreciseAcc = 0 : i32} : tensor<128x32xi8> * tensor<32x64xi8> scale tensor<128x1xf32> * tensor<1x64xf32> -> tensor<128x64xf32>
+    tt.return %d : tensor<128x64xf32>
+}
+
+// -----
+
+// CHECK-LABEL: @test_hoist_dot_scale
+tt.func @test_hoist_dot_scale(%a: tensor<128x32xf16>, %b: tensor<32x64xf16>, %s: f16) -> tensor<128x64xf32> {
+    // CHECK: %[[EXT:.*]] = arith.extf %{{.*}} : f16 to f32
+    // CHECK: %[[SCALE:.*]] = tt.splat %[[EXT]] : (f32) -> tensor<128x64xf32>
+    // CHECK: %[[DOT:.*]] = tt.dot %arg0, %arg1, %{{.*}}
+    // CHECK: %[[RES:.*]] = arith.mulf %[[DOT]], %[[SCALE]] : tensor<128x64xf32>
+    // CHECK: tt.return %[[RES]]
+    %zero = arith.constant dense<0.0> : tensor<128x64xf32>
+    %0 = tt.splat %s : (f16) -> tensor<128x32xf16>
+    %1 = arith.mulf %a, %0 : tensor<128x32xf16>
+    %2 = tt.dot %1, %b, %zero {allowTF32 = true, maxNumImpreciseAcc = 0 : i32} : tensor<128x32xf16> * tensor<32x64xf16> -> tensor<128x64xf32>
+    tt.return %2 : tensor<128x64xf32>
+}
+
+// CHECK-LABEL: @test_hoist_dot_constant_scale
+tt.func @test_hoist_dot_constant_scale(%a: tensor<128x32xf16>, %b: tensor<32x64xf16>) -> tensor<128x64xf32> {
+    // CHECK-DAG: %[[SCALE:.*]] = arith.constant dense<2.000000e+00> : tensor<128x64xf32>
+    // CHECK: %[[DOT:.*]] = tt.dot %arg0, %arg1, %{{.*}}
+    // CHECK: %[[RES:.*]] = arith.mulf %[[DOT]], %[[SCALE]] : tensor<128x64xf32>
+    %zero = arith.constant dense<0.0> : tensor<128x64xf32>
+    %cst = arith.constant dense<2.0> : tensor<32x64xf16>
+    %0 = arith.mulf %b, %cst : tensor<32x64xf16>
+    %1 = tt.dot %a, %0, %zero {allowTF32 = true, maxNumImpreciseAcc = 0 : i32} : tensor<128x32xf16> * tensor<32x64xf16> -> tensor<128x64xf32>
+    tt.return %1 : tensor<128x64xf32>
+}
+
+// The scale can't be hoisted over a non-zero accumulator
+// CHECK-LABEL: @test_hoist_dot_scale_fail
+tt.func @test_hoist_dot_scale_fail(%a: tensor<128x32xf16>, %b: tensor<32x64xf16>, %c: tensor<128x64xf32>, %s: f16) -> tensor<128x64xf32> {
+    // CHECK: arith.mulf %{{.*}}, %{{.*}} : tensor<128x32xf16>
+    // CHECK: tt.dot
+    // CHECK-NOT: arith.mulf
+    %0 = tt.splat %s : (f16) -> tensor<128x32xf16>
+    %1 = arith.mulf %a, %0 : tensor<128x32xf16>
+    %2 = tt.dot %1, %b, %c {allowTF32 = true, maxNumImpreciseAcc = 0 : i32} : tensor<128x32xf16> * tensor<32x64xf16> -> tensor<128x64xf32>
+    tt.return %2 : tensor<128x64xf32>
+}
+
+// -----
+
+// CHECK-LABEL: @test_combine_fp_cast_chain
+tt.func @test_combine_fp_cast_chain(%x: tensor<8xf16>, %y: tensor<8xf8E5M2>, %z: tensor<8xf32>) -> (tensor<8xf16>, tensor<8xf8E5M2>, tensor<8xf32>, tensor<8xf16>) {
+    // Round trips through a wider type are the source
+    %0 = arith.extf %x : tensor<8xf16> to tensor<8xf32>
+    %1 = tt.fp_to_fp %0 {rounding = 1 : i32} : tensor<8xf32> -> tensor<8xf16>
+    %2 = tt.fp_to_fp %y : tensor<8xf8E5M2> -> tensor<8xf32>
+    %3 = tt.fp_to_fp %2 {rounding = 1 : i32} : tensor<8xf32> -> tensor<8xf8E5M2>
+    // Narrowing to a type that holds the source is a single widening
+    // CHECK: %[[WIDENED:.*]] = tt.fp_to_fp %arg1 : tensor<8xf8E5M2> -> tensor<8xf16>
+    %4 = arith.truncf %2 : tensor<8xf32> to tensor<8xf16>
+    // Rounding to a narrower type than the source stays
+    // CHECK: %[[NARROWED:.*]] = arith.truncf %{{.*}} : tensor<8xf{{.*}}> to tensor<8xf16>
+    %5 = arith.extf %z : tensor<8xf32> to tensor<8xf64>
+    %6 = arith.truncf %5 : tensor<8xf64> to tensor<8xf16>
+    // CHECK: tt.return %arg0, %arg1, %[[WIDENED]], %[[NARROWED]]
+    tt.return %1, %3, %4, %6 : tensor<8xf16>, tensor<8xf8E5M2>, tensor<8xf16>, tensor<8xf16>
+}
+
+// -----
+
+// CHECK-LABEL: @test_combine_select_masked_load_tensor_mask
+tt.func @test_combine_select_masked_load_tensor_mask(%ptr: tensor<8x!tt.ptr<f32>>, %mask: tensor<8xi1>) -> tensor<8xf32> {
+    %zero = arith.constant dense<0.0> : tensor<8xf32>
+    // CHECK: %[[RES:.*]] = tt.load %arg0, %arg1, %{{.*}} {cache = 1 : i32, evict = 1 : i32, isVolatile = false} : tensor<8xf32>
+    %x = tt.load %ptr, %mask {cache = 1 : i32, evict = 1 : i32, isVolatile = false} : tensor<8xf32>
+    // CHECK-NOT: arith.select
+    %0 = arith.select %mask, %x, %zero : tensor<8xi1>, tensor<8xf32>
+    // CHECK: tt.return %[[RES]]
+    tt.return %0 : tensor<8xf32>
+}
+
+// -----
+
+// CHECK-LABEL: @test_simplify_reduce_of_broadcast
+tt.func @test_simplify_reduce_of_broadcast(%x: tensor<16xf32>, %y: tensor<16x1xi32>) -> (tensor<16xf32>, tensor<16xi32>) {
+    // CHECK-DAG: %[[N:.*]] = arith.constant dense<32> : tensor<16xi32>
+    %0 = tt.expand_dims %x {axis = 1 : i32} : (tensor<16xf32>) -> tensor<16x1xf32>
+    %1 = tt.broadcast %0 : (tensor<16x1xf32>) -> tensor<16x32xf32>
+    // CHECK-NOT: tt.broadcast
+    %2 = "tt.reduce" (%1) ({
+    ^bb0(%arg0: f32, %arg1: f32):
+      %max = arith.maxnumf %arg0, %arg1 : f32
+      tt.reduce.return %max : f32
+    }) {axis = 1 : i32} : (tensor<16x32xf32>) -> tensor<16xf32>
+    %3 = tt.broadcast %y : (tensor<16x1xi32>) -> tensor<16x32xi32>
+    // CHECK: %[[SUM:.*]] = "tt.reduce"(%arg1) <{axis = 1 : i32}>
+    // CHECK: (tensor<16x1xi32>) -> tensor<16xi32>
+    %4 = "tt.reduce" (%3) ({
+    ^bb0(%arg0: i32, %arg1: i32):
+      %add = arith.addi %arg0, %arg1 : i32
+      tt.reduce.return %add : i32
+    }) {axis = 1 : i32} : (tensor<16x32xi32>) -> tensor<16xi32>
+    // CHECK: %[[RES:.*]] = arith.muli %[[SUM]], %[[N]] : tensor<16xi32>
+    // CHECK: tt.return %arg0, %[[RES]]
+    tt.return %2, %4 : tensor<16xf32>, tensor<16xi32>
+}
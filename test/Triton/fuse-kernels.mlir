@@ -0,0 +1,76 @@
+// RUN: triton-opt %s -split-input-file -triton-fuse-kernels=kernel-name=fused -verify-diagnostics | FileCheck %s
+
+// CHECK-NOT: @tile_kernel
+// CHECK-NOT: @row_kernel
+// CHECK-LABEL: tt.func public @fused
+// CHECK-SAME: (%[[PTR0:[^:]*]]: !tt.ptr<i32, 1> {tt.divisibility = 16 : i32}, %[[PTR1:[^:]*]]: !tt.ptr<f32, 1>, %[[N:[^:]*]]: i32,
+// CHECK-SAME: %[[GRID0_X:[^:]*]]: i32, %[[GRID0_Y:[^:]*]]: i32, %[[GRID0_Z:[^:]*]]: i32, %[[GRID1_X:[^:]*]]: i32, %[[GRID1_Y:[^:]*]]: i32, %[[GRID1_Z:[^:]*]]: i32)
+// CHECK: %[[PID:.*]] = tt.get_program_id x : i32
+// CHECK: %[[GRID0_XY:.*]] = arith.muli %[[GRID0_X]], %[[GRID0_Y]] : i32
+// CHECK: %[[NUM0:.*]] = arith.muli %[[GRID0_XY]], %[[GRID0_Z]] : i32
+// CHECK: %[[END0:.*]] = arith.addi %{{.*}}, %[[NUM0]] : i32
+// CHECK: %[[LT0:.*]] = arith.cmpi slt, %[[PID]], %[[END0]] : i32
+// CHECK: scf.if %{{.*}} {
+// CHECK:   %[[INDEX0:.*]] = arith.subi %[[PID]], %{{.*}} : i32
+// CHECK:   %[[XY0:.*]] = arith.remsi %[[INDEX0]], %{{.*}} : i32
+// CHECK:   %[[X0:.*]] = arith.remsi %[[XY0]], %[[GRID0_X]] : i32
+// CHECK:   %[[Y0:.*]] = arith.divsi %[[XY0]], %[[GRID0_X]] : i32
+// CHECK-NOT: tt.get_program_id
+// CHECK-NOT: tt.get_num_programs
+// CHECK:   %[[ROW0:.*]] = arith.muli %[[X0]], %[[GRID0_Y]] : i32
+// CHECK:   arith.addi %[[ROW0]], %[[Y0]] : i32
+// CHECK:   tt.addptr %[[PTR0]]
+// CHECK:   tt.store
+// CHECK: }
+// CHECK: %[[NUM1:.*]] = arith.muli %{{.*}}, %[[GRID1_Z]] : i32
+// CHECK: %[[END1:.*]] = arith.addi %[[END0]], %[[NUM1]] : i32
+// CHECK: arith.cmpi sge, %[[PID]], %[[END0]] : i32
+// CHECK: arith.cmpi slt, %[[PID]], %[[END1]] : i32
+// CHECK: scf.if %{{.*}} {
+// CHECK:   %[[INDEX1:.*]] = arith.subi %[[PID]], %[[END0]] : i32
+// CHECK:   %[[X1:.*]] = arith.remsi %{{.*}}, %[[GRID1_X]] : i32
+// CHECK-NOT: tt.get_program_id
+// CHECK:   arith.muli %[[X1]], %[[N]] : i32
+// CHECK:   tt.addptr %[[PTR1]]
+// CHECK:   tt.store
+// CHECK: }
+// CHECK: tt.return
+module {
+tt.func public @tile_kernel(%ptr : !tt.ptr<i32, 1> {tt.divisibility = 16 : i32}) {
+  %x = tt.get_program_id x : i32
+  %y = tt.get_program_id y : i32
+  %num_y = tt.get_num_programs {axis = 1 : i32} : i32
+  %row = arith.muli %x, %num_y : i32
+  %id = arith.addi %row, %y : i32
+  %addr = tt.addptr %ptr, %id : !tt.ptr<i32, 1>, i32
+  tt.store %addr, %id : i32
+  tt.return
+}
+
+tt.func public @row_kernel(%ptr : !tt.ptr<f32, 1>, %n : i32) {
+  %cst = arith.constant 1.000000e+00 : f32
+  %x = tt.get_program_id x : i32
+  %offset = arith.muli %x, %n : i32
+  %addr = tt.addptr %ptr, %offset : !tt.ptr<f32, 1>, i32
+  tt.store %addr, %cst : f32
+  tt.return
+}
+}
+
+// -----
+
+// The helpers would still see the program ids of the launch.
+module {
+tt.func private @helper(%ptr : !tt.ptr<i32, 1>) attributes {noinline = true} {
+  %x = tt.get_program_id x : i32
+  %addr = tt.addptr %ptr, %x : !tt.ptr<i32, 1>, i32
+  tt.store %addr, %x : i32
+  tt.return
+}
+
+// expected-error @+1 {{cannot fuse a kernel with calls or several blocks}}
+tt.func public @call_kernel(%ptr : !tt.ptr<i32, 1>) {
+  tt.call @helper(%ptr) : (!tt.ptr<i32, 1>) -> ()
+  tt.return
+}
+}
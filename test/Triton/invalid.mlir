@@ -113,3 +113,70 @@ tt.func public @fn(%arg0: tensor<32x32xf32, #blocked>) {
     tt.return
 }
 }  // end module
+
+// -----
+
+tt.func public @fn(%arg0: tensor<4x48xf32>) {
+    // expected-error @+1 {{power of two}}
+    %a = tt.sort %arg0 {axis = 1 : i32, descending = false} : tensor<4x48xf32>
+    tt.return
+}
+
+// -----
+
+tt.func public @fn(%arg0: tensor<32xf32>) {
+    // expected-error @+1 {{out of range}}
+    %a = tt.sort %arg0 {axis = 1 : i32, descending = false} : tensor<32xf32>
+    tt.return
+}
+
+// -----
+
+tt.func public @fn(%arg0: tensor<32xf32>) {
+    // expected-error @+1 {{Random bits are required}}
+    %a = tt.fp_to_fp %arg0 {rounding = 2 : i32} : tensor<32xf32> -> tensor<32xbf16>
+    tt.return
+}
+
+// -----
+
+tt.func public @fn(%arg0: tensor<32xf16>, %arg1: tensor<32xi32>) {
+    // expected-error @+1 {{only supported from fp32}}
+    %a = tt.fp_to_fp %arg0, %arg1 {rounding = 2 : i32} : tensor<32xf16>, tensor<32xi32> -> tensor<32xbf16>
+    tt.return
+}
+
+// -----
+
+tt.func public @fn(%arg0: tensor<32x4xf32>) {
+    // expected-error @+1 {{last dimension of input tensor must be 2}}
+    %a, %b = tt.split %arg0 : tensor<32x4xf32> -> tensor<32xf32>
+    tt.return
+}
+
+// -----
+
+#blocked = #triton_gpu.blocked<{sizePerThread = [1, 1], threadsPerWarp = [16, 2], warpsPerCTA = [1, 1], order = [1, 0]}>
+module attributes {"triton_gpu.num-warps" = 1 : i32, "triton_gpu.num-ctas" = 1 : i32, "triton_gpu.threads-per-warp" = 32 : i32} {
+tt.func public @fn(%arg0: tensor<16x2xf32, #blocked>) {
+    // expected-error @+1 {{SplitOp requires the last dimension of its operand to be the most minor one}}
+    %a, %b = tt.split %arg0 : tensor<16x2xf32, #blocked> -> tensor<16xf32>
+    tt.return
+}
+}
+
+// -----
+
+tt.func public @fn(%arg0: tensor<32x8xf32>, %arg1: tensor<64x4xi32>) {
+    // expected-error @+1 {{indices and source must have the same size in dimension 1}}
+    %a = tt.gather %arg0[%arg1] {axis = 0 : i32} : (tensor<32x8xf32>, tensor<64x4xi32>) -> tensor<64x4xf32>
+    tt.return
+}
+
+// -----
+
+tt.func public @fn(%arg0: tensor<32x8xf32>, %arg1: tensor<64x8xi32>) {
+    // expected-error @+1 {{axis 2 is out of range}}
+    %a = tt.gather %arg0[%arg1] {axis = 2 : i32} : (tensor<32x8xf32>, tensor<64x8xi32>) -> tensor<64x8xf32>
+    tt.return
+}
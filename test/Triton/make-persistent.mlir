@@ -0,0 +1,85 @@
+// RUN: triton-opt %s -split-input-file -triton-make-persistent | FileCheck %s
+// RUN: triton-opt %s -split-input-file -triton-make-persistent=group-size=8 | FileCheck %s --check-prefix=GROUPED
+// RUN: triton-opt %s -split-input-file -triton-make-persistent=num-xcds=8 | FileCheck %s --check-prefix=XCDS
+
+// CHECK: module attributes {tt.persistent = 0 : i32}
+// CHECK-LABEL: tt.func public @tile_kernel
+// CHECK-SAME: %[[GRID_X:[^:]*]]: i32, %[[GRID_Y:[^:]*]]: i32, %[[GRID_Z:[^:]*]]: i32)
+// CHECK: %[[PID:.*]] = tt.get_program_id x : i32
+// CHECK: %[[NUM_PROGRAMS:.*]] = tt.get_num_programs {axis = 0 : i32} : i32
+// CHECK: %[[GRID_XY:.*]] = arith.muli %[[GRID_X]], %[[GRID_Y]] : i32
+// CHECK: %[[NUM_TILES:.*]] = arith.muli %[[GRID_XY]], %[[GRID_Z]] : i32
+// CHECK: scf.for %[[TILE:.*]] = %[[PID]] to %[[NUM_TILES]] step %[[NUM_PROGRAMS]] : i32 {
+// CHECK:   %[[TILE_XY:.*]] = arith.remsi %[[TILE]], %{{.*}} : i32
+// CHECK:   %[[X:.*]] = arith.remsi %[[TILE_XY]], %[[GRID_X]] : i32
+// CHECK:   %[[Y:.*]] = arith.divsi %[[TILE_XY]], %[[GRID_X]] : i32
+// CHECK-NOT: tt.get_program_id
+// CHECK:   arith.muli %[[X]], %[[GRID_Y]] : i32
+// CHECK:   arith.addi %{{.*}}, %[[Y]] : i32
+// CHECK:   tt.store
+// CHECK: }
+// CHECK: tt.return
+
+// GROUPED-LABEL: tt.func public @tile_kernel
+// GROUPED: scf.for
+// GROUPED:   arith.minsi
+// GROUPED-NOT: tt.get_program_id
+// GROUPED:   tt.store
+module {
+tt.func public @tile_kernel(%ptr : !tt.ptr<i32, 1>) {
+  %x = tt.get_program_id x : i32
+  %y = tt.get_program_id y : i32
+  %num_y = tt.get_num_programs {axis = 1 : i32} : i32
+  %row = arith.muli %x, %num_y : i32
+  %id = arith.addi %row, %y : i32
+  %addr = tt.addptr %ptr, %id : !tt.ptr<i32, 1>, i32
+  tt.store %addr, %id : i32
+  tt.return
+}
+}
+
+// -----
+
+// The helpers would still see the program ids of the launch.
+// CHECK-NOT: tt.persistent
+// CHECK-LABEL: tt.func public @call_kernel
+// CHECK-NOT: scf.for
+module {
+tt.func private @helper(%ptr : !tt.ptr<i32, 1>) attributes {noinline = true} {
+  %x = tt.get_program_id x : i32
+  %addr = tt.addptr %ptr, %x : !tt.ptr<i32, 1>, i32
+  tt.store %addr, %x : i32
+  tt.return
+}
+
+tt.func public @call_kernel(%ptr : !tt.ptr<i32, 1>) {
+  tt.call @helper(%ptr) : (!tt.ptr<i32, 1>) -> ()
+  tt.return
+}
+}
+
+// -----
+
+// The programs of each of the 8 chiplets start at consecutive tiles.
+// CHECK-LABEL: tt.func public @xcd_kernel
+// XCDS-LABEL: tt.func public @xcd_kernel
+// XCDS: %[[PID:.*]] = tt.get_program_id x : i32
+// XCDS: %[[NUM_PROGRAMS:.*]] = tt.get_num_programs {axis = 0 : i32} : i32
+// XCDS: %[[C8:.*]] = arith.constant 8 : i32
+// XCDS: %[[XCD:.*]] = arith.remsi %[[PID]], %[[C8]] : i32
+// XCDS: %[[ID_IN_XCD:.*]] = arith.divsi %[[PID]], %[[C8]] : i32
+// XCDS: %[[PER_XCD:.*]] = arith.divsi %[[NUM_PROGRAMS]], %[[C8]] : i32
+// XCDS: %[[NUM_LARGER:.*]] = arith.remsi %[[NUM_PROGRAMS]], %[[C8]] : i32
+// XCDS: %[[START:.*]] = arith.muli %[[XCD]], %[[PER_XCD]] : i32
+// XCDS: %[[SKIPPED:.*]] = arith.minsi %[[XCD]], %[[NUM_LARGER]] : i32
+// XCDS: %[[FIRST_OF_XCD:.*]] = arith.addi %[[START]], %[[SKIPPED]] : i32
+// XCDS: %[[FIRST:.*]] = arith.addi %[[FIRST_OF_XCD]], %[[ID_IN_XCD]] : i32
+// XCDS: scf.for %{{.*}} = %[[FIRST]] to %{{.*}} step %[[NUM_PROGRAMS]] : i32
+module {
+tt.func public @xcd_kernel(%ptr : !tt.ptr<i32, 1>) {
+  %x = tt.get_program_id x : i32
+  %addr = tt.addptr %ptr, %x : !tt.ptr<i32, 1>, i32
+  tt.store %addr, %x : i32
+  tt.return
+}
+}
@@ -0,0 +1,64 @@
+// RUN: triton-opt %s -split-input-file -triton-narrow-offsets | FileCheck %s
+// RUN: triton-opt %s -split-input-file -triton-narrow-offsets=max-numel=1073741824 | FileCheck %s --check-prefix=HINT
+
+// The offsets of a program along y fit in 32 bits
+// CHECK-LABEL: @program_y
+// HINT-LABEL: @program_y
+tt.func public @program_y(%arg0: !tt.ptr<f32, 1>) {
+  %c128 = arith.constant 128 : i64
+  %pid = tt.get_program_id y : i32
+  %0 = arith.extsi %pid : i32 to i64
+  %1 = arith.muli %0, %c128 : i64
+  %2 = tt.splat %1 : (i64) -> tensor<128xi64>
+  %3 = tt.make_range {end = 128 : i32, start = 0 : i32} : tensor<128xi32>
+  %4 = arith.extsi %3 : tensor<128xi32> to tensor<128xi64>
+  %5 = arith.addi %2, %4 : tensor<128xi64>
+  %6 = tt.splat %arg0 : (!tt.ptr<f32, 1>) -> tensor<128x!tt.ptr<f32, 1>>
+  // CHECK-NOT: i64
+  // CHECK: %[[C128:.*]] = arith.constant 128 : i32
+  // CHECK: %[[PID:.*]] = tt.get_program_id y : i32
+  // CHECK: %[[MUL:.*]] = arith.muli %[[PID]], %[[C128]] : i32
+  // CHECK: %[[SPLAT:.*]] = tt.splat %[[MUL]] : (i32) -> tensor<128xi32>
+  // CHECK: %[[RANGE:.*]] = tt.make_range
+  // CHECK: %[[OFFSET:.*]] = arith.addi %[[SPLAT]], %[[RANGE]] : tensor<128xi32>
+  // CHECK: tt.addptr %{{.*}}, %[[OFFSET]] : tensor<128x!tt.ptr<f32, 1>>, tensor<128xi32>
+  // CHECK-NOT: i64
+  %7 = tt.addptr %6, %5 : tensor<128x!tt.ptr<f32, 1>>, tensor<128xi64>
+  %8 = tt.load %7 {cache = 1 : i32, evict = 1 : i32, isVolatile = false} : tensor<128xf32>
+  tt.store %7, %8 {cache = 1 : i32, evict = 1 : i32} : tensor<128xf32>
+  tt.return
+}
+
+// -----
+
+// The offsets of a program along x may not fit in 32 bits, unless the
+// pointers stay within `max-numel` elements of the arguments
+// CHECK-LABEL: @program_x
+// HINT-LABEL: @program_x
+// HINT: %[[ARG:.*]] = arith.trunci %arg1 : i64 to i32
+tt.func public @program_x(%arg0: !tt.ptr<f32, 1>, %arg1: i64) {
+  %c1024 = arith.constant 1024 : i64
+  %pid = tt.get_program_id x : i32
+  %0 = arith.extsi %pid : i32 to i64
+  %1 = arith.muli %0, %c1024 : i64
+  %2 = tt.splat %1 : (i64) -> tensor<1024xi64>
+  %3 = tt.make_range {end = 1024 : i32, start = 0 : i32} : tensor<1024xi32>
+  %4 = arith.extsi %3 : tensor<1024xi32> to tensor<1024xi64>
+  %5 = arith.addi %2, %4 : tensor<1024xi64>
+  %6 = tt.splat %arg0 : (!tt.ptr<f32, 1>) -> tensor<1024x!tt.ptr<f32, 1>>
+  // CHECK: tt.addptr %{{.*}}, %{{.*}} : tensor<1024x!tt.ptr<f32, 1>>, tensor<1024xi64>
+  // HINT: %[[SPLAT:.*]] = tt.splat %{{.*}} : (i32) -> tensor<1024xi32>
+  // HINT: %[[OFFSET:.*]] = arith.addi %[[SPLAT]], %{{.*}} : tensor<1024xi32>
+  // HINT: %[[PTR:.*]] = tt.addptr %{{.*}}, %[[OFFSET]] : tensor<1024x!tt.ptr<f32, 1>>, tensor<1024xi32>
+  %7 = tt.addptr %6, %5 : tensor<1024x!tt.ptr<f32, 1>>, tensor<1024xi64>
+  // The offsets of a chain of addptr are added up, the 64-bit argument
+  // truncated
+  // HINT: %[[SPLAT_ARG:.*]] = tt.splat %[[ARG]] : (i32) -> tensor<1024xi32>
+  // HINT: %[[SUM:.*]] = arith.addi %[[SPLAT_ARG]], %[[OFFSET]] : tensor<1024xi32>
+  // HINT: tt.addptr %{{.*}}, %[[SUM]] : tensor<1024x!tt.ptr<f32, 1>>, tensor<1024xi32>
+  %8 = tt.splat %arg1 : (i64) -> tensor<1024xi64>
+  %9 = tt.addptr %7, %8 : tensor<1024x!tt.ptr<f32, 1>>, tensor<1024xi64>
+  %10 = tt.load %9 {cache = 1 : i32, evict = 1 : i32, isVolatile = false} : tensor<1024xf32>
+  tt.store %7, %10 {cache = 1 : i32, evict = 1 : i32} : tensor<1024xf32>
+  tt.return
+}
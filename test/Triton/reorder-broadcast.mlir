@@ -65,3 +65,20 @@ tt.func @test_broadcast_mix_type_op_pattern(%arg0: tensor<128x1xf32>, %arg1: f32
 
     tt.return %sel : tensor<128x128xf32>
 }
+
+// CHECK-LABEL: @test_broadcast_load_pattern
+tt.func @test_broadcast_load_pattern(%arg0: tensor<1x128x!tt.ptr<f32>>, %arg1: tensor<1x128xi1>) -> (tensor<64x128xf32>, tensor<64x128xf32>) {
+    // CHECK-DAG: %[[other:.*]] = arith.constant dense<0.000000e+00> : tensor<1x128xf32>
+    // CHECK-DAG: %[[load:.*]] = tt.load %arg0, %arg1, %[[other]] {{.*}} : tensor<1x128xf32>
+    // CHECK: %{{.*}} = tt.broadcast %[[load]] : (tensor<1x128xf32>) -> tensor<64x128xf32>
+    %ptr = tt.broadcast %arg0 : (tensor<1x128x!tt.ptr<f32>>) -> tensor<64x128x!tt.ptr<f32>>
+    %mask = tt.broadcast %arg1 : (tensor<1x128xi1>) -> tensor<64x128xi1>
+    %other = arith.constant dense<0.0> : tensor<64x128xf32>
+    %a = tt.load %ptr, %mask, %other {cache = 1 : i32, evict = 1 : i32, isVolatile = false} : tensor<64x128xf32>
+
+    // Volatile loads are left alone
+    // CHECK: tt.load %{{.*}} {{.*}}isVolatile = true{{.*}} : tensor<64x128xf32>
+    %b = tt.load %ptr {cache = 1 : i32, evict = 1 : i32, isVolatile = true} : tensor<64x128xf32>
+
+    tt.return %a, %b : tensor<64x128xf32>, tensor<64x128xf32>
+}
@@ -0,0 +1,88 @@
+// RUN: triton-opt %s -split-input-file -triton-specialize-calls | FileCheck %s
+// RUN: triton-opt %s -split-input-file -triton-specialize-calls=max-clones=1 | FileCheck %s --check-prefix=BUDGET
+
+// CHECK-LABEL: tt.func private @helper(
+// CHECK-SAME: tt.divisibility = 16 : i64
+// CHECK-LABEL: tt.func private @helper__1
+// CHECK-SAME: tt.divisibility = 4 : i64
+// CHECK-LABEL: tt.func private @helper__2
+// CHECK-SAME: tt.divisibility = 8 : i64
+// CHECK-LABEL: tt.func public @kernel_div16
+// CHECK: tt.call @helper(
+// CHECK-LABEL: tt.func public @kernel_div4
+// CHECK: tt.call @helper__1(
+// CHECK: tt.call @helper__1(
+// CHECK-LABEL: tt.func public @kernel_div8
+// CHECK: tt.call @helper__2(
+
+// BUDGET-LABEL: tt.func private @helper(
+// BUDGET-SAME: tt.divisibility = 8 : i64
+// BUDGET-LABEL: tt.func private @helper__1
+// BUDGET-SAME: tt.divisibility = 4 : i64
+// BUDGET-NOT: @helper__2
+// BUDGET-LABEL: tt.func public @kernel_div16
+// BUDGET: tt.call @helper(
+// BUDGET-LABEL: tt.func public @kernel_div4
+// BUDGET: tt.call @helper__1(
+// BUDGET-LABEL: tt.func public @kernel_div8
+// BUDGET: tt.call @helper(
+module {
+tt.func private @helper(%arg0: !tt.ptr<f32, 1>) attributes {noinline = true} {
+  %range = tt.make_range {end = 128 : i32, start = 0 : i32} : tensor<128xi32>
+  %ptrs = tt.splat %arg0 : (!tt.ptr<f32, 1>) -> tensor<128x!tt.ptr<f32, 1>>
+  %offs = tt.addptr %ptrs, %range : tensor<128x!tt.ptr<f32, 1>>, tensor<128xi32>
+  %x = tt.load %offs {cache = 1 : i32, evict = 1 : i32, isVolatile = false} : tensor<128xf32>
+  tt.store %offs, %x {cache = 1 : i32, evict = 1 : i32} : tensor<128xf32>
+  tt.return
+}
+
+tt.func public @kernel_div16(%arg0: !tt.ptr<f32, 1> {tt.divisibility = 16 : i32}) {
+  tt.call @helper(%arg0) : (!tt.ptr<f32, 1>) -> ()
+  tt.return
+}
+
+tt.func public @kernel_div4(%arg0: !tt.ptr<f32, 1> {tt.divisibility = 16 : i32}) {
+  %c1 = arith.constant 1 : i32
+  %0 = tt.addptr %arg0, %c1 : !tt.ptr<f32, 1>, i32
+  tt.call @helper(%0) : (!tt.ptr<f32, 1>) -> ()
+  %c3 = arith.constant 3 : i32
+  %1 = tt.addptr %arg0, %c3 : !tt.ptr<f32, 1>, i32
+  tt.call @helper(%1) : (!tt.ptr<f32, 1>) -> ()
+  tt.return
+}
+
+tt.func public @kernel_div8(%arg0: !tt.ptr<f32, 1> {tt.divisibility = 8 : i32}) {
+  tt.call @helper(%arg0) : (!tt.ptr<f32, 1>) -> ()
+  tt.return
+}
+}
+
+// -----
+
+// Cloning a caller gives new call sites to its callees.
+// CHECK-LABEL: tt.func private @inner(
+// CHECK-SAME: tt.divisibility = 16 : i64
+// CHECK-LABEL: tt.func private @inner__1
+// CHECK-SAME: tt.divisibility = 4 : i64
+// CHECK-LABEL: tt.func private @outer(
+// CHECK: tt.call @inner(
+// CHECK-LABEL: tt.func private @outer__1
+// CHECK: tt.call @inner__1(
+module {
+tt.func private @inner(%arg0: !tt.ptr<f32, 1>) attributes {noinline = true} {
+  tt.return
+}
+
+tt.func private @outer(%arg0: !tt.ptr<f32, 1>) attributes {noinline = true} {
+  tt.call @inner(%arg0) : (!tt.ptr<f32, 1>) -> ()
+  tt.return
+}
+
+tt.func public @kernel(%arg0: !tt.ptr<f32, 1> {tt.divisibility = 16 : i32}) {
+  tt.call @outer(%arg0) : (!tt.ptr<f32, 1>) -> ()
+  %c1 = arith.constant 1 : i32
+  %0 = tt.addptr %arg0, %c1 : !tt.ptr<f32, 1>, i32
+  tt.call @outer(%0) : (!tt.ptr<f32, 1>) -> ()
+  tt.return
+}
+}
@@ -0,0 +1,65 @@
+// RUN: triton-opt %s -split-input-file -triton-split-k=split-k=4 | FileCheck %s
+
+// CHECK: module attributes {tt.split_k = 4 : i32}
+// CHECK-LABEL: tt.func public @matmul_kernel
+// CHECK: %[[PID:.*]] = tt.get_program_id z : i32
+// CHECK: %[[NUM_ITERS:.*]] = arith.ceildivsi
+// CHECK: %[[PER_SPLIT:.*]] = arith.ceildivsi %[[NUM_ITERS]], %{{.*}} : i32
+// CHECK: %[[SKIPPED:.*]] = arith.muli %[[PID]], %[[PER_SPLIT]] : i32
+// CHECK: %[[LB:.*]] = arith.addi
+// CHECK: %[[UB:.*]] = arith.minsi
+// CHECK: %[[A_INIT:.*]] = tt.addptr
+// CHECK: %[[B_INIT:.*]] = tt.addptr
+// CHECK: scf.for %{{.*}} = %[[LB]] to %[[UB]] step %{{.*}} iter_args(%{{.*}} = %{{.*}}, %{{.*}} = %[[A_INIT]], %{{.*}} = %[[B_INIT]])
+// CHECK: arith.truncf
+// CHECK: "tt.atomic_rmw"
+// CHECK-SAME: atomic_rmw_op = 5 : i32
+// CHECK-NOT: tt.store
+module {
+tt.func public @matmul_kernel(%a_ptr_init : tensor<32x32x!tt.ptr<f16, 1>>, %b_ptr_init : tensor<32x32x!tt.ptr<f16, 1>>,
+                              %c_ptr : tensor<32x32x!tt.ptr<f16, 1>>, %num_iters : i32, %a_step : tensor<32x32xi32>,
+                              %b_step : tensor<32x32xi32>) {
+  %c0_i32 = arith.constant 0 : i32
+  %c1_i32 = arith.constant 1 : i32
+  %acc_init = arith.constant dense<0.000000e+00> : tensor<32x32xf32>
+  %loop:3 = scf.for %iv = %c0_i32 to %num_iters step %c1_i32 iter_args(%acc = %acc_init, %a_ptr = %a_ptr_init, %b_ptr = %b_ptr_init) -> (tensor<32x32xf32>, tensor<32x32x!tt.ptr<f16, 1>>, tensor<32x32x!tt.ptr<f16, 1>>) : i32 {
+    %a = tt.load %a_ptr {cache = 1 : i32, evict = 1 : i32, isVolatile = false} : tensor<32x32xf16>
+    %b = tt.load %b_ptr {cache = 1 : i32, evict = 1 : i32, isVolatile = false} : tensor<32x32xf16>
+    %d = tt.dot %a, %b, %acc {allowTF32 = true, maxNumImpreciseAcc = 0 : i32} : tensor<32x32xf16> * tensor<32x32xf16> -> tensor<32x32xf32>
+    %next_a_ptr = tt.addptr %a_ptr, %a_step : tensor<32x32x!tt.ptr<f16, 1>>, tensor<32x32xi32>
+    %next_b_ptr = tt.addptr %b_ptr, %b_step : tensor<32x32x!tt.ptr<f16, 1>>, tensor<32x32xi32>
+    scf.yield %d, %next_a_ptr, %next_b_ptr : tensor<32x32xf32>, tensor<32x32x!tt.ptr<f16, 1>>, tensor<32x32x!tt.ptr<f16, 1>>
+  }
+  %c = arith.truncf %loop#0 : tensor<32x32xf32> to tensor<32x32xf16>
+  tt.store %c_ptr, %c : tensor<32x32xf16>
+  tt.return
+}
+}
+
+// -----
+
+// The bias isn't added once per split.
+// CHECK-NOT: tt.split_k
+// CHECK-LABEL: tt.func public @matmul_bias_kernel
+// CHECK-NOT: tt.get_program_id z
+// CHECK: tt.store
+module {
+tt.func public @matmul_bias_kernel(%a_ptr_init : tensor<32x32x!tt.ptr<f16, 1>>, %b_ptr_init : tensor<32x32x!tt.ptr<f16, 1>>,
+                                   %c_ptr : tensor<32x32x!tt.ptr<f32, 1>>, %num_iters : i32, %a_step : tensor<32x32xi32>,
+                                   %b_step : tensor<32x32xi32>, %bias : tensor<32x32xf32>) {
+  %c0_i32 = arith.constant 0 : i32
+  %c1_i32 = arith.constant 1 : i32
+  %acc_init = arith.constant dense<0.000000e+00> : tensor<32x32xf32>
+  %loop:3 = scf.for %iv = %c0_i32 to %num_iters step %c1_i32 iter_args(%acc = %acc_init, %a_ptr = %a_ptr_init, %b_ptr = %b_ptr_init) -> (tensor<32x32xf32>, tensor<32x32x!tt.ptr<f16, 1>>, tensor<32x32x!tt.ptr<f16, 1>>) : i32 {
+    %a = tt.load %a_ptr {cache = 1 : i32, evict = 1 : i32, isVolatile = false} : tensor<32x32xf16>
+    %b = tt.load %b_ptr {cache = 1 : i32, evict = 1 : i32, isVolatile = false} : tensor<32x32xf16>
+    %d = tt.dot %a, %b, %acc {allowTF32 = true, maxNumImpreciseAcc = 0 : i32} : tensor<32x32xf16> * tensor<32x32xf16> -> tensor<32x32xf32>
+    %next_a_ptr = tt.addptr %a_ptr, %a_step : tensor<32x32x!tt.ptr<f16, 1>>, tensor<32x32xi32>
+    %next_b_ptr = tt.addptr %b_ptr, %b_step : tensor<32x32x!tt.ptr<f16, 1>>, tensor<32x32xi32>
+    scf.yield %d, %next_a_ptr, %next_b_ptr : tensor<32x32xf32>, tensor<32x32x!tt.ptr<f16, 1>>, tensor<32x32x!tt.ptr<f16, 1>>
+  }
+  %c = arith.addf %loop#0, %bias : tensor<32x32xf32>
+  tt.store %c_ptr, %c : tensor<32x32xf32>
+  tt.return
+}
+}
@@ -0,0 +1,59 @@
+// RUN: triton-opt %s -split-input-file -triton-strength-reduce-pointers | FileCheck %s
+
+// The pointers recomputed from the induction variable become loop-carried
+// and are advanced by a splat
+// CHECK-LABEL: @loop_pointer
+tt.func @loop_pointer(%arg0: !tt.ptr<f16, 1>, %stride: i32, %num_iters: i32) -> tensor<32x64xf16> {
+  %c0_i32 = arith.constant 0 : i32
+  %c1_i32 = arith.constant 1 : i32
+  %c32_i32 = arith.constant 32 : i32
+  %acc_init = arith.constant dense<0.000000e+00> : tensor<32x64xf16>
+  %offs_k = tt.make_range {end = 32 : i32, start = 0 : i32} : tensor<32xi32>
+  %offs_n = tt.make_range {end = 64 : i32, start = 0 : i32} : tensor<64xi32>
+  %base = tt.splat %arg0 : (!tt.ptr<f16, 1>) -> tensor<32x64x!tt.ptr<f16, 1>>
+  %stride_k = tt.splat %stride : (i32) -> tensor<32x1xi32>
+  %offs_n_row = tt.expand_dims %offs_n {axis = 0 : i32} : (tensor<64xi32>) -> tensor<1x64xi32>
+  %offs_n_tile = tt.broadcast %offs_n_row : (tensor<1x64xi32>) -> tensor<32x64xi32>
+  // CHECK: %[[INIT:.*]] = tt.addptr %{{.*}}, %{{.*}} : tensor<32x64x!tt.ptr<f16, 1>>, tensor<32x64xi32>
+  // CHECK: %[[INC:.*]] = tt.splat %{{.*}} : (i32) -> tensor<32x64xi32>
+  // CHECK: scf.for {{.*}} iter_args(%{{.*}} = %{{.*}}, %[[PTR:.*]] = %[[INIT]])
+  // CHECK-NOT: arith.muli
+  // CHECK: tt.load %[[PTR]]
+  // CHECK: %[[NEXT:.*]] = tt.addptr %[[PTR]], %[[INC]]
+  // CHECK: scf.yield %{{.*}}, %[[NEXT]]
+  %loop = scf.for %k = %c0_i32 to %num_iters step %c1_i32 iter_args(%acc = %acc_init) -> (tensor<32x64xf16>) : i32 {
+    %0 = arith.muli %k, %c32_i32 : i32
+    %1 = tt.splat %0 : (i32) -> tensor<32xi32>
+    %2 = arith.addi %1, %offs_k : tensor<32xi32>
+    %3 = tt.expand_dims %2 {axis = 1 : i32} : (tensor<32xi32>) -> tensor<32x1xi32>
+    %4 = arith.muli %3, %stride_k : tensor<32x1xi32>
+    %5 = tt.broadcast %4 : (tensor<32x1xi32>) -> tensor<32x64xi32>
+    %6 = arith.addi %5, %offs_n_tile : tensor<32x64xi32>
+    %7 = tt.addptr %base, %6 : tensor<32x64x!tt.ptr<f16, 1>>, tensor<32x64xi32>
+    %8 = tt.load %7 {cache = 1 : i32, evict = 1 : i32, isVolatile = false} : tensor<32x64xf16>
+    %9 = arith.addf %acc, %8 : tensor<32x64xf16>
+    scf.yield %9 : tensor<32x64xf16>
+  }
+  tt.return %loop : tensor<32x64xf16>
+}
+
+// -----
+
+// Offsets that are not affine in the induction variable are left alone
+// CHECK-LABEL: @loop_square
+tt.func @loop_square(%arg0: !tt.ptr<f32, 1>, %num_iters: i32) {
+  %c0_i32 = arith.constant 0 : i32
+  %c1_i32 = arith.constant 1 : i32
+  %base = tt.splat %arg0 : (!tt.ptr<f32, 1>) -> tensor<32x!tt.ptr<f32, 1>>
+  // CHECK: scf.for
+  // CHECK: arith.muli
+  // CHECK: tt.addptr
+  scf.for %k = %c0_i32 to %num_iters step %c1_i32 : i32 {
+    %0 = arith.muli %k, %k : i32
+    %1 = tt.splat %0 : (i32) -> tensor<32xi32>
+    %2 = tt.addptr %base, %1 : tensor<32x!tt.ptr<f32, 1>>, tensor<32xi32>
+    %3 = tt.load %2 {cache = 1 : i32, evict = 1 : i32, isVolatile = false} : tensor<32xf32>
+    tt.store %2, %3 {cache = 1 : i32, evict = 1 : i32} : tensor<32xf32>
+  }
+  tt.return
+}
@@ -93,3 +93,104 @@ module attributes {"triton_gpu.compute-capability" = 80 : i32, "triton_gpu.num-c
     tt.return %d : tensor<64x64xf32, #blocked>
   }
 }
+
+// -----
+
+// The warp groups split the columns rather than both computing all of them.
+// CHECK: #[[MMA3:.+]] = #triton_gpu.nvidia_mma<{versionMajor = 3, versionMinor = 0, warpsPerCTA = [4, 2], CTAsPerCGA = [1, 1], CTASplitNum = [1, 1], CTAOrder = [1, 0], instrShape = [16, 128, 16]}>
+#blocked = #triton_gpu.blocked<{sizePerThread = [4, 4], threadsPerWarp = [1, 32], warpsPerCTA = [8, 1], order = [1, 0], CTAsPerCGA = [1, 1], CTASplitNum = [1, 1], CTAOrder = [1, 0]}>
+module attributes {"triton_gpu.compute-capability" = 90 : i32, "triton_gpu.num-ctas" = 1 : i32, "triton_gpu.num-warps" = 8 : i32, "triton_gpu.threads-per-warp" = 32 : i32} {
+  // CHECK-LABEL: wide_dot
+  tt.func public @wide_dot(
+    %arg0: tensor<64x64xf16, #triton_gpu.dot_op<{opIdx = 0, parent = #blocked}>>,
+    %arg1: tensor<64x256xf16, #triton_gpu.dot_op<{opIdx = 1, parent = #blocked}>>) -> tensor<64x256xf32, #blocked> {
+    %cst = arith.constant dense<0.000000e+00> : tensor<64x256xf32, #blocked>
+  // CHECK: tt.dot {{.*}} -> tensor<64x256xf32, #[[MMA3]]>
+    %d = tt.dot %arg0, %arg1, %cst {allowTF32 = true, maxNumImpreciseAcc = 0 : i32} :
+      tensor<64x64xf16, #triton_gpu.dot_op<{opIdx = 0, parent = #blocked}>> * tensor<64x256xf16, #triton_gpu.dot_op<{opIdx = 1, parent = #blocked}>> -> tensor<64x256xf32, #blocked>
+    tt.return %d : tensor<64x256xf32, #blocked>
+  }
+}
+
+// -----
+
+// The sparse dot uses mma.sp, its metadata is read from shared memory.
+// CHECK-80: #[[MMA:.+]] = #triton_gpu.nvidia_mma<{versionMajor = 2, versionMinor = 0, warpsPerCTA = {{.*}}, instrShape = [16, 8]}>
+// CHECK-80: #[[SHARED:.+]] = #triton_gpu.shared<{vec = 1, perPhase = 1, maxPhase = 1, order = [1, 0]
+#blocked = #triton_gpu.blocked<{sizePerThread = [4, 4], threadsPerWarp = [4, 8], warpsPerCTA = [4, 1], order = [1, 0], CTAsPerCGA = [1, 1], CTASplitNum = [1, 1], CTAOrder = [1, 0]}>
+module attributes {"triton_gpu.compute-capability" = 80 : i32, "triton_gpu.num-ctas" = 1 : i32, "triton_gpu.num-warps" = 4 : i32, "triton_gpu.threads-per-warp" = 32 : i32} {
+  // CHECK-80-LABEL: sparse_dot
+  tt.func public @sparse_dot(
+    %a: tensor<64x32xf16, #triton_gpu.dot_op<{opIdx = 0, parent = #blocked}>>,
+    %b: tensor<64x64xf16, #triton_gpu.dot_op<{opIdx = 1, parent = #blocked}>>,
+    %meta: tensor<64x4xi16, #blocked>) -> tensor<64x64xf32, #blocked> {
+    %cst = arith.constant dense<0.000000e+00> : tensor<64x64xf32, #blocked>
+  // CHECK-80: triton_gpu.convert_layout {{.*}} -> tensor<64x4xi16, #[[SHARED]]>
+  // CHECK-80: triton_gpu.sparse_dot {{.*}} -> tensor<64x64xf32, #[[MMA]]>
+    %d = triton_gpu.sparse_dot %a, %b, %cst, %meta :
+      tensor<64x32xf16, #triton_gpu.dot_op<{opIdx = 0, parent = #blocked}>> meta tensor<64x4xi16, #blocked> * tensor<64x64xf16, #triton_gpu.dot_op<{opIdx = 1, parent = #blocked}>> -> tensor<64x64xf32, #blocked>
+    tt.return %d : tensor<64x64xf32, #blocked>
+  }
+}
+
+// -----
+
+// The fp8 dots accumulate in a partial accumulator, added to the one of the
+// loop every 128 / 32 = 4 iterations and after it.
+// CHECK: #[[MMA:.+]] = #triton_gpu.nvidia_mma<{versionMajor = 3
+#blocked = #triton_gpu.blocked<{sizePerThread = [4, 4], threadsPerWarp = [2, 16], warpsPerCTA = [4, 1], order = [1, 0], CTAsPerCGA = [1, 1], CTASplitNum = [1, 1], CTAOrder = [1, 0]}>
+module attributes {"triton_gpu.compute-capability" = 90 : i32, "triton_gpu.num-ctas" = 1 : i32, "triton_gpu.num-warps" = 4 : i32, "triton_gpu.threads-per-warp" = 32 : i32} {
+  // CHECK-LABEL: fp8_dot_promotion
+  tt.func public @fp8_dot_promotion(
+    %a: tensor<128x32xf8E5M2, #triton_gpu.dot_op<{opIdx = 0, parent = #blocked}>>,
+    %b: tensor<32x128xf8E5M2, #triton_gpu.dot_op<{opIdx = 1, parent = #blocked}>>,
+    %ub: i32) -> tensor<128x128xf32, #blocked> {
+    %c0 = arith.constant 0 : i32
+    %c1 = arith.constant 1 : i32
+    %cst = arith.constant dense<0.000000e+00> : tensor<128x128xf32, #blocked>
+  // CHECK: %[[ZERO:.+]] = arith.constant dense<0.000000e+00> : tensor<128x128xf32, #[[MMA]]>
+  // CHECK: %[[LOOP:.+]]:2 = scf.for %[[IV:.+]] = %{{.*}} to %{{.*}} step %{{.*}} iter_args(%[[ACC:.+]] = %{{.*}}, %[[PARTIAL:.+]] = %[[ZERO]])
+  // CHECK:   %[[C:.+]] = triton_gpu.convert_layout %[[ACC]]
+  // CHECK:   %[[D:.+]] = tt.dot %{{.*}}, %{{.*}}, %[[PARTIAL]]
+  // CHECK:   %[[ITER:.+]] = arith.divsi
+  // CHECK:   %[[REM:.+]] = arith.remsi %[[ITER]], %{{.*}} : i32
+  // CHECK:   %[[PROMOTE:.+]] = arith.cmpi eq, %[[REM]]
+  // CHECK:   %[[PROMOTE_SPLAT:.+]] = tt.splat %[[PROMOTE]]
+  // CHECK:   %[[SUM:.+]] = arith.addf %[[C]], %[[D]]
+  // CHECK:   %[[NEW_ACC:.+]] = arith.select %[[PROMOTE_SPLAT]], %[[SUM]], %[[C]]
+  // CHECK:   %[[NEW_PARTIAL:.+]] = arith.select %[[PROMOTE_SPLAT]], %[[ZERO]], %[[D]]
+  // CHECK:   %[[NEXT:.+]] = triton_gpu.convert_layout %[[NEW_ACC]]
+  // CHECK:   scf.yield %[[NEXT]], %[[NEW_PARTIAL]]
+  // CHECK: %[[REST:.+]] = triton_gpu.convert_layout %[[LOOP]]#1
+  // CHECK: %[[FINAL:.+]] = arith.addf %[[LOOP]]#0, %[[REST]]
+  // CHECK: tt.return %[[FINAL]]
+    %acc = scf.for %k = %c0 to %ub step %c1 iter_args(%arg = %cst) -> (tensor<128x128xf32, #blocked>) : i32 {
+      %d = tt.dot %a, %b, %arg {allowTF32 = true, maxNumImpreciseAcc = 128 : i32} :
+        tensor<128x32xf8E5M2, #triton_gpu.dot_op<{opIdx = 0, parent = #blocked}>> * tensor<32x128xf8E5M2, #triton_gpu.dot_op<{opIdx = 1, parent = #blocked}>> -> tensor<128x128xf32, #blocked>
+      scf.yield %d : tensor<128x128xf32, #blocked>
+    }
+    tt.return %acc : tensor<128x128xf32, #blocked>
+  }
+}
+
+// -----
+
+// The warps of a batched dot take one batch entry each, with mma.sync on sm_90
+// as the matrices are too small for wgmma.
+// CHECK: #[[MMA:.+]] = #triton_gpu.nvidia_mma<{versionMajor = 2, versionMinor = 0, warpsPerCTA = [4, 1, 1], CTAsPerCGA = [1, 1, 1], CTASplitNum = [1, 1, 1], CTAOrder = [2, 1, 0], instrShape = [1, 16, 8]}>
+// CHECK-80: #[[MMA:.+]] = #triton_gpu.nvidia_mma<{versionMajor = 2, versionMinor = 0, warpsPerCTA = [4, 1, 1], CTAsPerCGA = [1, 1, 1], CTASplitNum = [1, 1, 1], CTAOrder = [2, 1, 0], instrShape = [1, 16, 8]}>
+#blocked = #triton_gpu.blocked<{sizePerThread = [1, 2, 2], threadsPerWarp = [1, 4, 8], warpsPerCTA = [4, 1, 1], order = [2, 1, 0], CTAsPerCGA = [1, 1, 1], CTASplitNum = [1, 1, 1], CTAOrder = [2, 1, 0]}>
+module attributes {"triton_gpu.compute-capability" = 90 : i32, "triton_gpu.num-ctas" = 1 : i32, "triton_gpu.num-warps" = 4 : i32, "triton_gpu.threads-per-warp" = 32 : i32} {
+  // CHECK-LABEL: batched_dot
+  // CHECK-80-LABEL: batched_dot
+  tt.func public @batched_dot(
+    %a: tensor<8x16x32xf16, #triton_gpu.dot_op<{opIdx = 0, parent = #blocked}>>,
+    %b: tensor<8x32x16xf16, #triton_gpu.dot_op<{opIdx = 1, parent = #blocked}>>) -> tensor<8x16x16xf32, #blocked> {
+    %cst = arith.constant dense<0.000000e+00> : tensor<8x16x16xf32, #blocked>
+  // CHECK: tt.dot {{.*}} -> tensor<8x16x16xf32, #[[MMA]]>
+  // CHECK-80: tt.dot {{.*}} -> tensor<8x16x16xf32, #[[MMA]]>
+    %d = tt.dot %a, %b, %cst {allowTF32 = true, maxNumImpreciseAcc = 0 : i32} :
+      tensor<8x16x32xf16, #triton_gpu.dot_op<{opIdx = 0, parent = #blocked}>> * tensor<8x32x16xf16, #triton_gpu.dot_op<{opIdx = 1, parent = #blocked}>> -> tensor<8x16x16xf32, #blocked>
+    tt.return %d : tensor<8x16x16xf32, #blocked>
+  }
+}
@@ -0,0 +1,34 @@
+// RUN: triton-opt %s -split-input-file -tritongpu-instrument-branches | FileCheck %s --check-prefix=INSTR
+// RUN: triton-opt %s -split-input-file -tritongpu-apply-branch-profile="counts=8,6,0,0" | FileCheck %s --check-prefix=APPLY
+
+module attributes {"triton_gpu.compute-capability" = 80 : i32, "triton_gpu.num-ctas" = 1 : i32, "triton_gpu.num-warps" = 4 : i32, "triton_gpu.threads-per-warp" = 32 : i32} {
+
+// Each branch counts how often it is reached and how often its then region
+// runs, the second one was never reached by the profile.
+// INSTR: module attributes {{.*}}"triton_gpu.num-branch-counters" = 4 : i32
+// INSTR-LABEL: tt.func @branches
+// INSTR: triton_gpu.profile_counter {index = 0 : i32}
+// INSTR-NEXT: scf.if
+// INSTR-NEXT: triton_gpu.profile_counter {index = 1 : i32}
+// INSTR: triton_gpu.profile_counter {index = 2 : i32}
+// INSTR-NEXT: scf.if
+// INSTR-NEXT: triton_gpu.profile_counter {index = 3 : i32}
+// APPLY-LABEL: tt.func @branches
+// APPLY: %[[COND:.*]] = arith.cmpi
+// APPLY: %[[TRUE:.*]] = arith.constant true
+// APPLY: %[[EXPECT:.*]] = llvm.intr.expect.with.probability %[[COND]], %[[TRUE]], 7.5{{.*}}
+// APPLY: scf.if %[[EXPECT]]
+// APPLY-NOT: llvm.intr.expect
+tt.func @branches(%ptr: !tt.ptr<i32, 1>, %a: i32, %b: i32) {
+  %0 = arith.cmpi slt, %a, %b : i32
+  scf.if %0 {
+    tt.store %ptr, %a {cache = 1 : i32, evict = 1 : i32} : i32
+  }
+  %1 = arith.cmpi eq, %a, %b : i32
+  scf.if %1 {
+    tt.store %ptr, %b {cache = 1 : i32, evict = 1 : i32} : i32
+  }
+  tt.return
+}
+
+}
@@ -137,3 +137,27 @@ tt.func public @load_tensors_two_types(%arg0: !tt.ptr<f32, 1> {tt.divisibility =
 }
 
 }
+
+// -----
+
+#blocked = #triton_gpu.blocked<{sizePerThread = [1, 1], threadsPerWarp = [1, 32], warpsPerCTA = [1, 4], order = [0, 1], CTAsPerCGA = [1, 1], CTASplitNum = [1, 1], CTAOrder = [1, 0]}>
+#slice = #triton_gpu.slice<{dim = 0, parent = #blocked}>
+module attributes {"triton_gpu.num-ctas" = 1 : i32, "triton_gpu.num-warps" = 4 : i32, "triton_gpu.threads-per-warp" = 32 : i32} {
+
+// The dimension of size 1 left by a load of un-broadcast pointers is not
+// picked as the most contiguous one, even though no dimension is contiguous.
+// CHECK: [[ROW_LAYOUT:#.*]] = #triton_gpu.blocked<{sizePerThread = [1, 1], threadsPerWarp = [1, 32], warpsPerCTA = [2, 2], order = [1, 0], CTAsPerCGA = [1, 1], CTASplitNum = [1, 1], CTAOrder = [1, 0]}>
+// CHECK-LABEL: load_row
+tt.func public @load_row(%arg0: !tt.ptr<f32, 1> {tt.divisibility = 16 : i32}, %arg1: i32) -> tensor<1x64xf32, #blocked> {
+    %0 = tt.make_range {end = 64 : i32, start = 0 : i32} : tensor<64xi32, #slice>
+    %1 = tt.expand_dims %0 {axis = 0 : i32} : (tensor<64xi32, #slice>) -> tensor<1x64xi32, #blocked>
+    %2 = tt.splat %arg1 : (i32) -> tensor<1x64xi32, #blocked>
+    %3 = arith.muli %1, %2 : tensor<1x64xi32, #blocked>
+    %4 = tt.splat %arg0 : (!tt.ptr<f32, 1>) -> tensor<1x64x!tt.ptr<f32, 1>, #blocked>
+    %5 = tt.addptr %4, %3 : tensor<1x64x!tt.ptr<f32, 1>, #blocked>, tensor<1x64xi32, #blocked>
+    // CHECK: tt.load {{.*}} : tensor<1x64xf32, [[ROW_LAYOUT]]>
+    %6 = tt.load %5 {cache = 1 : i32, evict = 1 : i32, isVolatile = false} : tensor<1x64xf32, #blocked>
+    tt.return %6 : tensor<1x64xf32, #blocked>
+}
+
+}
@@ -0,0 +1,107 @@
+// RUN: triton-opt %s -split-input-file -tritongpu-remove-layout-conversions=global-assignment=true 2>&1 | FileCheck %s
+
+#blocked = #triton_gpu.blocked<{sizePerThread = [4], threadsPerWarp = [32], warpsPerCTA = [4], order = [0], CTAsPerCGA = [1], CTASplitNum = [1], CTAOrder = [0]}>
+#blocked1 = #triton_gpu.blocked<{sizePerThread = [1], threadsPerWarp = [32], warpsPerCTA = [4], order = [0], CTAsPerCGA = [1], CTASplitNum = [1], CTAOrder = [0]}>
+module attributes {"triton_gpu.num-warps" = 4 : i32, "triton_gpu.num-ctas" = 1 : i32, "triton_gpu.threads-per-warp" = 32 : i32} {
+
+// Converting the f16 operand before the extension is cheaper than converting
+// the other operand and the result in f32.
+// CHECK-LABEL: keep_cheap_conversion
+//   CHECK-NOT:   triton_gpu.convert_layout {{.*}}f32
+//       CHECK:   triton_gpu.convert_layout {{.*}}tensor<1024xf16
+//   CHECK-NOT:   triton_gpu.convert_layout
+//       CHECK:   tt.return
+tt.func @keep_cheap_conversion(%px: !tt.ptr<f32> {tt.divisibility = 16 : i32}, %py: !tt.ptr<f16> {tt.divisibility = 16 : i32}, %ps: !tt.ptr<f32> {tt.divisibility = 16 : i32}) {
+  %range = tt.make_range {end = 1024 : i32, start = 0 : i32} : tensor<1024xi32, #blocked>
+  %range1 = tt.make_range {end = 1024 : i32, start = 0 : i32} : tensor<1024xi32, #blocked1>
+  %0 = tt.splat %px : (!tt.ptr<f32>) -> tensor<1024x!tt.ptr<f32>, #blocked>
+  %1 = tt.addptr %0, %range : tensor<1024x!tt.ptr<f32>, #blocked>, tensor<1024xi32, #blocked>
+  %2 = tt.splat %py : (!tt.ptr<f16>) -> tensor<1024x!tt.ptr<f16>, #blocked1>
+  %3 = tt.addptr %2, %range1 : tensor<1024x!tt.ptr<f16>, #blocked1>, tensor<1024xi32, #blocked1>
+  %4 = tt.splat %ps : (!tt.ptr<f32>) -> tensor<1024x!tt.ptr<f32>, #blocked>
+  %5 = tt.addptr %4, %range : tensor<1024x!tt.ptr<f32>, #blocked>, tensor<1024xi32, #blocked>
+  %x = tt.load %1 {cache = 1 : i32, evict = 1 : i32, isVolatile = false} : tensor<1024xf32, #blocked>
+  %y = tt.load %3 {cache = 1 : i32, evict = 1 : i32, isVolatile = false} : tensor<1024xf16, #blocked1>
+  %6 = triton_gpu.convert_layout %y : (tensor<1024xf16, #blocked1>) -> tensor<1024xf16, #blocked>
+  %7 = arith.extf %6 : tensor<1024xf16, #blocked> to tensor<1024xf32, #blocked>
+  %8 = arith.addf %x, %7 : tensor<1024xf32, #blocked>
+  tt.store %5, %8 {cache = 1 : i32, evict = 1 : i32} : tensor<1024xf32, #blocked>
+  tt.return
+}
+
+// Converting the operand defined outside of the loop once is cheaper than
+// converting the one loaded in the loop at each iteration, although it is
+// wider.
+// CHECK-LABEL: convert_outside_loop
+//       CHECK:   triton_gpu.convert_layout {{.*}}tensor<1024xf32
+//       CHECK:   scf.for
+//   CHECK-NOT:   triton_gpu.convert_layout
+//       CHECK:   scf.yield
+tt.func @convert_outside_loop(%px: !tt.ptr<f32> {tt.divisibility = 16 : i32}, %py: !tt.ptr<f16> {tt.divisibility = 16 : i32}) -> f32 {
+  %c0 = arith.constant 0 : i32
+  %c1 = arith.constant 1 : i32
+  %c16 = arith.constant 16 : i32
+  %zero = arith.constant 0.000000e+00 : f32
+  %range = tt.make_range {end = 1024 : i32, start = 0 : i32} : tensor<1024xi32, #blocked>
+  %range1 = tt.make_range {end = 1024 : i32, start = 0 : i32} : tensor<1024xi32, #blocked1>
+  %0 = tt.splat %px : (!tt.ptr<f32>) -> tensor<1024x!tt.ptr<f32>, #blocked>
+  %1 = tt.addptr %0, %range : tensor<1024x!tt.ptr<f32>, #blocked>, tensor<1024xi32, #blocked>
+  %2 = tt.splat %py : (!tt.ptr<f16>) -> tensor<1024x!tt.ptr<f16>, #blocked1>
+  %3 = tt.addptr %2, %range1 : tensor<1024x!tt.ptr<f16>, #blocked1>, tensor<1024xi32, #blocked1>
+  %x = tt.load %1 {cache = 1 : i32, evict = 1 : i32, isVolatile = false} : tensor<1024xf32, #blocked>
+  %r = scf.for %i = %c0 to %c16 step %c1 iter_args(%acc = %zero) -> (f32) : i32 {
+    %y = tt.load %3 {cache = 1 : i32, evict = 1 : i32, isVolatile = false} : tensor<1024xf16, #blocked1>
+    %4 = triton_gpu.convert_layout %y : (tensor<1024xf16, #blocked1>) -> tensor<1024xf16, #blocked>
+    %5 = arith.extf %4 : tensor<1024xf16, #blocked> to tensor<1024xf32, #blocked>
+    %6 = arith.addf %x, %5 : tensor<1024xf32, #blocked>
+    %7 = "tt.reduce"(%6) <{axis = 0 : i32}> ({
+    ^bb0(%lhs: f32, %rhs: f32):
+      %8 = arith.addf %lhs, %rhs : f32
+      tt.reduce.return %8 : f32
+    }) : (tensor<1024xf32, #blocked>) -> f32
+    %9 = arith.addf %acc, %7 : f32
+    scf.yield %9 : f32
+  }
+  tt.return %r : f32
+}
+
+// The values used in the loop form a cycle of the def-use graph: the initial
+// choice, which computes the extension in the layout of its load, is improved
+// by converting the f16 operand instead.
+// CHECK-LABEL: diamond
+//   CHECK-NOT:   triton_gpu.convert_layout {{.*}}f32
+//       CHECK:   triton_gpu.convert_layout {{.*}}tensor<1024xf16
+//       CHECK:   scf.for
+//   CHECK-NOT:   triton_gpu.convert_layout
+//       CHECK:   scf.yield
+tt.func @diamond(%px: !tt.ptr<f32> {tt.divisibility = 16 : i32}, %py: !tt.ptr<f16> {tt.divisibility = 16 : i32}) -> f32 {
+  %c0 = arith.constant 0 : i32
+  %c1 = arith.constant 1 : i32
+  %c16 = arith.constant 16 : i32
+  %zero = arith.constant 0.000000e+00 : f32
+  %range = tt.make_range {end = 1024 : i32, start = 0 : i32} : tensor<1024xi32, #blocked>
+  %range1 = tt.make_range {end = 1024 : i32, start = 0 : i32} : tensor<1024xi32, #blocked1>
+  %0 = tt.splat %px : (!tt.ptr<f32>) -> tensor<1024x!tt.ptr<f32>, #blocked>
+  %1 = tt.addptr %0, %range : tensor<1024x!tt.ptr<f32>, #blocked>, tensor<1024xi32, #blocked>
+  %2 = tt.splat %py : (!tt.ptr<f16>) -> tensor<1024x!tt.ptr<f16>, #blocked1>
+  %3 = tt.addptr %2, %range1 : tensor<1024x!tt.ptr<f16>, #blocked1>, tensor<1024xi32, #blocked1>
+  %y = tt.load %3 {cache = 1 : i32, evict = 1 : i32, isVolatile = false} : tensor<1024xf16, #blocked1>
+  %4 = triton_gpu.convert_layout %y : (tensor<1024xf16, #blocked1>) -> tensor<1024xf16, #blocked>
+  %5 = arith.extf %4 : tensor<1024xf16, #blocked> to tensor<1024xf32, #blocked>
+  %r = scf.for %i = %c0 to %c16 step %c1 iter_args(%acc = %zero) -> (f32) : i32 {
+    %x = tt.load %1 {cache = 1 : i32, evict = 1 : i32, isVolatile = false} : tensor<1024xf32, #blocked>
+    %6 = arith.addf %x, %5 : tensor<1024xf32, #blocked>
+    %7 = arith.mulf %x, %5 : tensor<1024xf32, #blocked>
+    %8 = arith.addf %6, %7 : tensor<1024xf32, #blocked>
+    %9 = "tt.reduce"(%8) <{axis = 0 : i32}> ({
+    ^bb0(%lhs: f32, %rhs: f32):
+      %10 = arith.addf %lhs, %rhs : f32
+      tt.reduce.return %10 : f32
+    }) : (tensor<1024xf32, #blocked>) -> f32
+    %11 = arith.addf %acc, %9 : f32
+    scf.yield %11 : f32
+  }
+  tt.return %r : f32
+}
+
+}
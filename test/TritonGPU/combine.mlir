@@ -2061,3 +2061,58 @@ module attributes {"triton_gpu.compute-capability" = 80 : i32, "triton_gpu.num-c
     tt.return %4 : tensor<1xi32, #triton_gpu.slice<{dim = 1, parent = #blocked}>>
   }
 }
+
+// -----
+
+// The view ops take the layouts propagated from the loads, in which they are
+// renames of the values.
+
+#blocked = #triton_gpu.blocked<{sizePerThread = [1, 4], threadsPerWarp = [2, 16], warpsPerCTA = [4, 1], order = [1, 0], CTAsPerCGA = [1, 1], CTASplitNum = [1, 1], CTAOrder = [1, 0]}>
+#blocked1 = #triton_gpu.blocked<{sizePerThread = [1, 1], threadsPerWarp = [1, 32], warpsPerCTA = [4, 1], order = [1, 0], CTAsPerCGA = [1, 1], CTASplitNum = [1, 1], CTAOrder = [1, 0]}>
+#blocked1t = #triton_gpu.blocked<{sizePerThread = [1, 1], threadsPerWarp = [32, 1], warpsPerCTA = [1, 4], order = [0, 1], CTAsPerCGA = [1, 1], CTASplitNum = [1, 1], CTAOrder = [0, 1]}>
+#blockedt = #triton_gpu.blocked<{sizePerThread = [4, 1], threadsPerWarp = [16, 2], warpsPerCTA = [1, 4], order = [0, 1], CTAsPerCGA = [1, 1], CTASplitNum = [1, 1], CTAOrder = [0, 1]}>
+#flat1 = #triton_gpu.blocked<{sizePerThread = [1], threadsPerWarp = [32], warpsPerCTA = [4], order = [0], CTAsPerCGA = [1], CTASplitNum = [1], CTAOrder = [0]}>
+#flat4 = #triton_gpu.blocked<{sizePerThread = [4], threadsPerWarp = [32], warpsPerCTA = [4], order = [0], CTAsPerCGA = [1], CTASplitNum = [1], CTAOrder = [0]}>
+module attributes {"triton_gpu.compute-capability" = 80 : i32, "triton_gpu.num-ctas" = 1 : i32, "triton_gpu.num-warps" = 4 : i32, "triton_gpu.threads-per-warp" = 32 : i32} {
+// CHECK-LABEL: @trans_rename
+//   CHECK-NOT:   triton_gpu.convert_layout
+//       CHECK:   tt.trans
+//   CHECK-NOT:   triton_gpu.convert_layout
+//       CHECK:   tt.return
+  tt.func @trans_rename(%arg0: tensor<32x64x!tt.ptr<f32, 1>, #blocked>, %arg1: tensor<64x32x!tt.ptr<f32, 1>, #blockedt>) {
+    %0 = tt.load %arg0 {cache = 1 : i32, evict = 1 : i32, isVolatile = false} : tensor<32x64xf32, #blocked>
+    %1 = triton_gpu.convert_layout %0 : (tensor<32x64xf32, #blocked>) -> tensor<32x64xf32, #blocked1>
+    %2 = tt.trans %1 : (tensor<32x64xf32, #blocked1>) -> tensor<64x32xf32, #blocked1t>
+    %3 = triton_gpu.convert_layout %2 : (tensor<64x32xf32, #blocked1t>) -> tensor<64x32xf32, #blockedt>
+    tt.store %arg1, %3 {cache = 1 : i32, evict = 1 : i32} : tensor<64x32xf32, #blockedt>
+    tt.return
+  }
+
+// CHECK-LABEL: @cat_rename
+//   CHECK-NOT:   triton_gpu.convert_layout
+//       CHECK:   tt.cat {{.*}} -> tensor<1024xf32, #[[$FLAT4:.+]]>
+//   CHECK-NOT:   triton_gpu.convert_layout
+//       CHECK:   tt.return
+  tt.func @cat_rename(%arg0: tensor<512x!tt.ptr<f32, 1>, #flat4>, %arg1: tensor<1024x!tt.ptr<f32, 1>, #flat4>) {
+    %0 = tt.load %arg0 {cache = 1 : i32, evict = 1 : i32, isVolatile = false} : tensor<512xf32, #flat4>
+    %1 = triton_gpu.convert_layout %0 : (tensor<512xf32, #flat4>) -> tensor<512xf32, #flat1>
+    %2 = tt.cat %1, %1 : (tensor<512xf32, #flat1>, tensor<512xf32, #flat1>) -> tensor<1024xf32, #flat1>
+    %3 = triton_gpu.convert_layout %2 : (tensor<1024xf32, #flat1>) -> tensor<1024xf32, #flat4>
+    tt.store %arg1, %3 {cache = 1 : i32, evict = 1 : i32} : tensor<1024xf32, #flat4>
+    tt.return
+  }
+
+// CHECK-LABEL: @reshape_rename
+//   CHECK-NOT:   triton_gpu.convert_layout
+//       CHECK:   tt.reshape {{.*}} {allow_reorder = false} : tensor<32x64xf32, #{{.+}}> -> tensor<2048xf32, #[[$FLAT4]]>
+//   CHECK-NOT:   triton_gpu.convert_layout
+//       CHECK:   tt.return
+  tt.func @reshape_rename(%arg0: tensor<32x64x!tt.ptr<f32, 1>, #blocked>, %arg1: tensor<2048x!tt.ptr<f32, 1>, #flat4>) {
+    %0 = tt.load %arg0 {cache = 1 : i32, evict = 1 : i32, isVolatile = false} : tensor<32x64xf32, #blocked>
+    %1 = triton_gpu.convert_layout %0 : (tensor<32x64xf32, #blocked>) -> tensor<32x64xf32, #blocked1>
+    %2 = tt.reshape %1 {allow_reorder = false} : tensor<32x64xf32, #blocked1> -> tensor<2048xf32, #flat1>
+    %3 = triton_gpu.convert_layout %2 : (tensor<2048xf32, #flat1>) -> tensor<2048xf32, #flat4>
+    tt.store %arg1, %3 {cache = 1 : i32, evict = 1 : i32} : tensor<2048xf32, #flat4>
+    tt.return
+  }
+}
@@ -0,0 +1,97 @@
+// RUN: triton-opt %s -split-input-file -tritongpu-hoist-invariant-loads | FileCheck %s
+
+#blocked = #triton_gpu.blocked<{sizePerThread = [1], threadsPerWarp = [32], warpsPerCTA = [4], order = [0]}>
+module attributes {"triton_gpu.compute-capability" = 80 : i32, "triton_gpu.num-ctas" = 1 : i32, "triton_gpu.num-warps" = 4 : i32, "triton_gpu.threads-per-warp" = 32 : i32} {
+
+// The loop may not run, the bias is only loaded if it does.
+// CHECK-LABEL: tt.func @hoist_bias
+// CHECK: %[[RUNS:.*]] = arith.cmpi slt, %{{.*}}, %{{.*}} : i32
+// CHECK: %[[RUNS_SPLAT:.*]] = tt.splat %[[RUNS]]
+// CHECK: %[[MASK:.*]] = arith.andi %{{.*}}, %[[RUNS_SPLAT]]
+// CHECK: %[[BIAS:.*]] = tt.load %{{.*}}, %[[MASK]], %{{.*}} {cache
+// CHECK: scf.for
+// CHECK-NOT: tt.load
+// CHECK:   arith.addf %{{.*}}, %[[BIAS]]
+// CHECK:   scf.yield
+tt.func @hoist_bias(%bias_ptr: !tt.ptr<f32, 1>, %N: i32, %ub: i32) -> tensor<128xf32, #blocked> {
+  %c0 = arith.constant 0 : i32
+  %c1 = arith.constant 1 : i32
+  %cst = arith.constant dense<0.000000e+00> : tensor<128xf32, #blocked>
+  %range = tt.make_range {end = 128 : i32, start = 0 : i32} : tensor<128xi32, #blocked>
+  %N_splat = tt.splat %N : (i32) -> tensor<128xi32, #blocked>
+  %mask = arith.cmpi slt, %range, %N_splat : tensor<128xi32, #blocked>
+  %splat = tt.splat %bias_ptr : (!tt.ptr<f32, 1>) -> tensor<128x!tt.ptr<f32, 1>, #blocked>
+  %ptrs = tt.addptr %splat, %range : tensor<128x!tt.ptr<f32, 1>, #blocked>, tensor<128xi32, #blocked>
+  %acc = scf.for %k = %c0 to %ub step %c1 iter_args(%arg = %cst) -> (tensor<128xf32, #blocked>) : i32 {
+    %bias = tt.load %ptrs, %mask, %cst {cache = 1 : i32, evict = 1 : i32, isVolatile = false} : tensor<128xf32, #blocked>
+    %next = arith.addf %arg, %bias : tensor<128xf32, #blocked>
+    scf.yield %next : tensor<128xf32, #blocked>
+  }
+  tt.return %acc : tensor<128xf32, #blocked>
+}
+
+// The loop runs, the load isn't masked.
+// CHECK-LABEL: tt.func @hoist_constant_bounds
+// CHECK-NOT: arith.cmpi
+// CHECK: tt.load %{{.*}} {cache
+// CHECK: scf.for
+// CHECK-NOT: tt.load
+// CHECK:   scf.yield
+tt.func @hoist_constant_bounds(%ptrs: tensor<128x!tt.ptr<f32, 1>, #blocked>) -> tensor<128xf32, #blocked> {
+  %c0 = arith.constant 0 : i32
+  %c1 = arith.constant 1 : i32
+  %c8 = arith.constant 8 : i32
+  %cst = arith.constant dense<0.000000e+00> : tensor<128xf32, #blocked>
+  %acc = scf.for %k = %c0 to %c8 step %c1 iter_args(%arg = %cst) -> (tensor<128xf32, #blocked>) : i32 {
+    %x = tt.load %ptrs {cache = 1 : i32, evict = 1 : i32, isVolatile = false} : tensor<128xf32, #blocked>
+    %next = arith.mulf %arg, %x : tensor<128xf32, #blocked>
+    scf.yield %next : tensor<128xf32, #blocked>
+  }
+  tt.return %acc : tensor<128xf32, #blocked>
+}
+
+// The stores of the loop may change the loaded values.
+// CHECK-LABEL: tt.func @no_hoist_store
+// CHECK: scf.for
+// CHECK:   tt.load
+// CHECK:   tt.store
+tt.func @no_hoist_store(%ptrs: tensor<128x!tt.ptr<f32, 1>, #blocked>, %out: tensor<128x!tt.ptr<f32, 1>, #blocked>) {
+  %c0 = arith.constant 0 : i32
+  %c1 = arith.constant 1 : i32
+  %c8 = arith.constant 8 : i32
+  scf.for %k = %c0 to %c8 step %c1 : i32 {
+    %x = tt.load %ptrs {cache = 1 : i32, evict = 1 : i32, isVolatile = false} : tensor<128xf32, #blocked>
+    tt.store %out, %x {cache = 1 : i32, evict = 1 : i32} : tensor<128xf32, #blocked>
+  }
+  tt.return
+}
+
+}
+
+// -----
+
+#blocked = #triton_gpu.blocked<{sizePerThread = [1, 4], threadsPerWarp = [4, 8], warpsPerCTA = [4, 1], order = [1, 0]}>
+module attributes {"triton_gpu.compute-capability" = 80 : i32, "triton_gpu.num-ctas" = 1 : i32, "triton_gpu.num-warps" = 4 : i32, "triton_gpu.threads-per-warp" = 32 : i32} {
+
+// The tile and the accumulator don't both fit in the registers of a thread,
+// the tile is read back from shared memory in the loop.
+// CHECK-LABEL: tt.func @stage_in_shared_memory
+// CHECK: %[[TILE:.*]] = tt.load
+// CHECK: %[[SHARED:.*]] = triton_gpu.convert_layout %[[TILE]] : {{.*}} -> tensor<128x128xf32, #shared>
+// CHECK: scf.for
+// CHECK:   %[[READ:.*]] = triton_gpu.convert_layout %[[SHARED]] : {{.*}} -> tensor<128x128xf32, #blocked>
+// CHECK:   arith.addf %{{.*}}, %[[READ]]
+tt.func @stage_in_shared_memory(%ptrs: tensor<128x128x!tt.ptr<f32, 1>, #blocked>) -> tensor<128x128xf32, #blocked> {
+  %c0 = arith.constant 0 : i32
+  %c1 = arith.constant 1 : i32
+  %c8 = arith.constant 8 : i32
+  %cst = arith.constant dense<0.000000e+00> : tensor<128x128xf32, #blocked>
+  %acc = scf.for %k = %c0 to %c8 step %c1 iter_args(%arg = %cst) -> (tensor<128x128xf32, #blocked>) : i32 {
+    %x = tt.load %ptrs {cache = 1 : i32, evict = 1 : i32, isVolatile = false} : tensor<128x128xf32, #blocked>
+    %next = arith.addf %arg, %x : tensor<128x128xf32, #blocked>
+    scf.yield %next : tensor<128x128xf32, #blocked>
+  }
+  tt.return %acc : tensor<128x128xf32, #blocked>
+}
+
+}
@@ -0,0 +1,75 @@
+// RUN: triton-opt %s -split-input-file -tritongpu-pipeline=num-stages=6 -canonicalize | FileCheck %s
+
+// The stages are trimmed to the ones hiding the latency of the loads: the
+// dot of a large tile makes an iteration longer than a global load.
+#AL = #triton_gpu.blocked<{sizePerThread = [1, 4], threadsPerWarp = [4, 8], warpsPerCTA = [4, 1], order = [1, 0], CTAsPerCGA = [1, 1], CTASplitNum = [1, 1], CTAOrder = [1, 0]}>
+#BL = #triton_gpu.blocked<{sizePerThread = [1, 4], threadsPerWarp = [1, 32], warpsPerCTA = [4, 1], order = [1, 0], CTAsPerCGA = [1, 1], CTASplitNum = [1, 1], CTAOrder = [1, 0]}>
+#ALs0 = #triton_gpu.slice<{parent=#AL, dim=0}>
+#BLs0 = #triton_gpu.slice<{parent=#BL, dim=0}>
+#C = #triton_gpu.nvidia_mma<{versionMajor = 2, warpsPerCTA = [4, 1], CTAsPerCGA = [1, 1], CTASplitNum = [1, 1], CTAOrder = [1, 0]}>
+#A = #triton_gpu.dot_op<{opIdx = 0, parent = #C, kWidth=2}>
+#B = #triton_gpu.dot_op<{opIdx = 1, parent = #C, kWidth=2}>
+
+// CHECK-LABEL: tt.func @large_tile_loop
+// CHECK: triton_gpu.alloc_tensor : tensor<2x128x64xf16
+// CHECK: triton_gpu.alloc_tensor : tensor<2x64x128xf16
+// CHECK: scf.for
+module attributes {"triton_gpu.num-warps" = 4 : i32, "triton_gpu.num-ctas" = 1 : i32, "triton_gpu.compute-capability" = 80} {
+tt.func @large_tile_loop(%lb : index, %ub : index, %step : index,
+                         %A : !tt.ptr<f16> {tt.divisibility = 16 : i32},
+                         %B : !tt.ptr<f16> {tt.divisibility = 16 : i32}) -> tensor<128x128xf32, #C> {
+  %a_ptr_splat = tt.splat %A : (!tt.ptr<f16>) -> tensor<128x64x!tt.ptr<f16>, #AL>
+  %a_tmp0 = tt.make_range {end = 64: i32, start = 0: i32} : tensor<64xi32, #ALs0>
+  %a_tmp1 = tt.expand_dims %a_tmp0 {axis = 0 : i32} : (tensor<64xi32, #ALs0>) -> tensor<1x64xi32, #AL>
+  %a_offs = tt.broadcast %a_tmp1 : (tensor<1x64xi32, #AL>) -> tensor<128x64xi32, #AL>
+  %a_ptr_init = tt.addptr %a_ptr_splat, %a_offs : tensor<128x64x!tt.ptr<f16>, #AL>, tensor<128x64xi32, #AL>
+  %b_ptr_splat = tt.splat %B : (!tt.ptr<f16>) -> tensor<64x128x!tt.ptr<f16>, #BL>
+  %b_tmp0 = tt.make_range {end = 128: i32, start = 0: i32} : tensor<128xi32, #BLs0>
+  %b_tmp1 = tt.expand_dims %b_tmp0 {axis = 0 : i32} : (tensor<128xi32, #BLs0>) -> tensor<1x128xi32, #BL>
+  %b_offs = tt.broadcast %b_tmp1 : (tensor<1x128xi32, #BL>) -> tensor<64x128xi32, #BL>
+  %b_ptr_init = tt.addptr %b_ptr_splat, %b_offs : tensor<64x128x!tt.ptr<f16>, #BL>, tensor<64x128xi32, #BL>
+  %a_off = arith.constant dense<64> : tensor<128x64xi32, #AL>
+  %b_off = arith.constant dense<64> : tensor<64x128xi32, #BL>
+  %c_init = arith.constant dense<0.00e+00> : tensor<128x128xf32, #C>
+  %loop:3 = scf.for %iv = %lb to %ub step %step iter_args(%a_ptr = %a_ptr_init, %b_ptr = %b_ptr_init, %prev_c = %c_init) -> (tensor<128x64x!tt.ptr<f16>, #AL>, tensor<64x128x!tt.ptr<f16>, #BL>, tensor<128x128xf32, #C>) {
+    %a_ = tt.load %a_ptr {cache = 1 : i32, evict = 1 : i32, isVolatile = false} : tensor<128x64xf16, #AL>
+    %a = triton_gpu.convert_layout %a_ : (tensor<128x64xf16, #AL>) -> tensor<128x64xf16, #A>
+    %b_ = tt.load %b_ptr {cache = 1 : i32, evict = 1 : i32, isVolatile = false} : tensor<64x128xf16, #BL>
+    %b = triton_gpu.convert_layout %b_ : (tensor<64x128xf16, #BL>) -> tensor<64x128xf16, #B>
+    %c = tt.dot %a, %b, %prev_c {allowTF32 = true, maxNumImpreciseAcc = 0 : i32} : tensor<128x64xf16, #A> * tensor<64x128xf16, #B> -> tensor<128x128xf32, #C>
+    %next_a_ptr = tt.addptr %a_ptr, %a_off : tensor<128x64x!tt.ptr<f16>, #AL>, tensor<128x64xi32, #AL>
+    %next_b_ptr = tt.addptr %b_ptr, %b_off : tensor<64x128x!tt.ptr<f16>, #BL>, tensor<64x128xi32, #BL>
+    scf.yield %next_a_ptr, %next_b_ptr, %c : tensor<128x64x!tt.ptr<f16>, #AL>, tensor<64x128x!tt.ptr<f16>, #BL>, tensor<128x128xf32, #C>
+  }
+  tt.return %loop#2: tensor<128x128xf32, #C>
+}
+}
+
+// -----
+
+// A short iteration needs all the requested stages.
+#AL = #triton_gpu.blocked<{sizePerThread = [1, 4], threadsPerWarp = [4, 8], warpsPerCTA = [4, 1], order = [1, 0], CTAsPerCGA = [1, 1], CTASplitNum = [1, 1], CTAOrder = [1, 0]}>
+#ALs0 = #triton_gpu.slice<{parent=#AL, dim=0}>
+
+// CHECK-LABEL: tt.func @short_loop
+// CHECK: triton_gpu.alloc_tensor : tensor<5x32x64xf32
+// CHECK: scf.for
+module attributes {"triton_gpu.num-warps" = 4 : i32, "triton_gpu.num-ctas" = 1 : i32, "triton_gpu.compute-capability" = 80} {
+tt.func @short_loop(%lb : index, %ub : index, %step : index,
+                    %A : !tt.ptr<f32> {tt.divisibility = 16 : i32}) -> tensor<32x64xf32, #AL> {
+  %a_ptr_splat = tt.splat %A : (!tt.ptr<f32>) -> tensor<32x64x!tt.ptr<f32>, #AL>
+  %a_tmp0 = tt.make_range {end = 64: i32, start = 0: i32} : tensor<64xi32, #ALs0>
+  %a_tmp1 = tt.expand_dims %a_tmp0 {axis = 0 : i32} : (tensor<64xi32, #ALs0>) -> tensor<1x64xi32, #AL>
+  %a_offs = tt.broadcast %a_tmp1 : (tensor<1x64xi32, #AL>) -> tensor<32x64xi32, #AL>
+  %a_ptr_init = tt.addptr %a_ptr_splat, %a_offs : tensor<32x64x!tt.ptr<f32>, #AL>, tensor<32x64xi32, #AL>
+  %a_off = arith.constant dense<64> : tensor<32x64xi32, #AL>
+  %acc_init = arith.constant dense<0.00e+00> : tensor<32x64xf32, #AL>
+  %loop:2 = scf.for %iv = %lb to %ub step %step iter_args(%a_ptr = %a_ptr_init, %acc = %acc_init) -> (tensor<32x64x!tt.ptr<f32>, #AL>, tensor<32x64xf32, #AL>) {
+    %a = tt.load %a_ptr {cache = 1 : i32, evict = 1 : i32, isVolatile = false} : tensor<32x64xf32, #AL>
+    %next_acc = arith.addf %acc, %a : tensor<32x64xf32, #AL>
+    %next_a_ptr = tt.addptr %a_ptr, %a_off : tensor<32x64x!tt.ptr<f32>, #AL>, tensor<32x64xi32, #AL>
+    scf.yield %next_a_ptr, %next_acc : tensor<32x64x!tt.ptr<f32>, #AL>, tensor<32x64xf32, #AL>
+  }
+  tt.return %loop#1: tensor<32x64xf32, #AL>
+}
+}
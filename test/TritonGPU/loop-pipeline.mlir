@@ -791,3 +791,277 @@ module attributes {"triton_gpu.compute-capability" = 86 : i32, "triton_gpu.num-c
     tt.return
   }
 }
+
+// -----
+
+// Loads that don't feed a dot are prefetched through an unswizzled buffer and
+// converted back to their layout.
+// CHECK-LABEL: tt.func @accumulate_loop
+// CHECK: %[[BUFFER:.*]] = triton_gpu.alloc_tensor : tensor<2x32x64xf32, #shared>
+// CHECK: triton_gpu.insert_slice_async
+// CHECK: triton_gpu.insert_slice_async
+// CHECK: triton_gpu.async_wait {num = 1 : i32}
+// CHECK: scf.for
+// CHECK:   triton_gpu.convert_layout %{{.*}} : (tensor<32x64xf32, #shared>) -> tensor<32x64xf32, #{{.*}}>
+// CHECK:   arith.addf
+// CHECK:   triton_gpu.insert_slice_async
+// CHECK:   triton_gpu.async_wait {num = 1 : i32}
+// CHECK:   scf.yield
+
+// Without a zero `other` the masked out elements can't be zero-filled.
+// CHECK-LABEL: tt.func @accumulate_loop_other
+// CHECK-NOT: triton_gpu.insert_slice_async
+// CHECK: scf.for
+// CHECK:   tt.load
+#AL = #triton_gpu.blocked<{sizePerThread = [1, 4], threadsPerWarp = [4, 8], warpsPerCTA = [4, 1], order = [1, 0], CTAsPerCGA = [1, 1], CTASplitNum = [1, 1], CTAOrder = [1, 0]}>
+#ALs0 = #triton_gpu.slice<{parent=#AL, dim=0}>
+module attributes {"triton_gpu.num-warps" = 4 : i32, "triton_gpu.num-ctas" = 1 : i32, "triton_gpu.compute-capability" = 80} {
+tt.func @accumulate_loop(%lb : index, %ub : index, %step : index,
+                         %A : !tt.ptr<f32> {tt.divisibility = 16 : i32}) -> tensor<32x64xf32, #AL> {
+  %a_ptr_splat = tt.splat %A : (!tt.ptr<f32>) -> tensor<32x64x!tt.ptr<f32>, #AL>
+  %a_tmp0 = tt.make_range {end = 64: i32, start = 0: i32} : tensor<64xi32, #ALs0>
+  %a_tmp1 = tt.expand_dims %a_tmp0 {axis = 0 : i32} : (tensor<64xi32, #ALs0>) -> tensor<1x64xi32, #AL>
+  %a_offs = tt.broadcast %a_tmp1 : (tensor<1x64xi32, #AL>) -> tensor<32x64xi32, #AL>
+  %a_ptr_init = tt.addptr %a_ptr_splat, %a_offs : tensor<32x64x!tt.ptr<f32>, #AL>, tensor<32x64xi32, #AL>
+  %a_off = arith.constant dense<64> : tensor<32x64xi32, #AL>
+  %acc_init = arith.constant dense<0.00e+00> : tensor<32x64xf32, #AL>
+  %loop:2 = scf.for %iv = %lb to %ub step %step iter_args(%a_ptr = %a_ptr_init, %acc = %acc_init) -> (tensor<32x64x!tt.ptr<f32>, #AL>, tensor<32x64xf32, #AL>) {
+    %a = tt.load %a_ptr {cache = 1 : i32, evict = 1 : i32, isVolatile = false} : tensor<32x64xf32, #AL>
+    %next_acc = arith.addf %acc, %a : tensor<32x64xf32, #AL>
+    %next_a_ptr = tt.addptr %a_ptr, %a_off : tensor<32x64x!tt.ptr<f32>, #AL>, tensor<32x64xi32, #AL>
+    scf.yield %next_a_ptr, %next_acc : tensor<32x64x!tt.ptr<f32>, #AL>, tensor<32x64xf32, #AL>
+  }
+  tt.return %loop#1: tensor<32x64xf32, #AL>
+}
+
+tt.func @accumulate_loop_other(%lb : index, %ub : index, %step : index,
+                               %A : !tt.ptr<f32> {tt.divisibility = 16 : i32}) -> tensor<32x64xf32, #AL> {
+  %a_ptr_splat = tt.splat %A : (!tt.ptr<f32>) -> tensor<32x64x!tt.ptr<f32>, #AL>
+  %a_tmp0 = tt.make_range {end = 64: i32, start = 0: i32} : tensor<64xi32, #ALs0>
+  %a_tmp1 = tt.expand_dims %a_tmp0 {axis = 0 : i32} : (tensor<64xi32, #ALs0>) -> tensor<1x64xi32, #AL>
+  %a_offs = tt.broadcast %a_tmp1 : (tensor<1x64xi32, #AL>) -> tensor<32x64xi32, #AL>
+  %a_ptr_init = tt.addptr %a_ptr_splat, %a_offs : tensor<32x64x!tt.ptr<f32>, #AL>, tensor<32x64xi32, #AL>
+  %a_off = arith.constant dense<64> : tensor<32x64xi32, #AL>
+  %a_mask = arith.constant dense<true> : tensor<32x64xi1, #AL>
+  %a_other = arith.constant dense<1.00e+00> : tensor<32x64xf32, #AL>
+  %acc_init = arith.constant dense<0.00e+00> : tensor<32x64xf32, #AL>
+  %loop:2 = scf.for %iv = %lb to %ub step %step iter_args(%a_ptr = %a_ptr_init, %acc = %acc_init) -> (tensor<32x64x!tt.ptr<f32>, #AL>, tensor<32x64xf32, #AL>) {
+    %a = tt.load %a_ptr, %a_mask, %a_other {cache = 1 : i32, evict = 1 : i32, isVolatile = false} : tensor<32x64xf32, #AL>
+    %next_acc = arith.addf %acc, %a : tensor<32x64xf32, #AL>
+    %next_a_ptr = tt.addptr %a_ptr, %a_off : tensor<32x64x!tt.ptr<f32>, #AL>, tensor<32x64xi32, #AL>
+    scf.yield %next_a_ptr, %next_acc : tensor<32x64x!tt.ptr<f32>, #AL>, tensor<32x64xf32, #AL>
+  }
+  tt.return %loop#1: tensor<32x64xf32, #AL>
+}
+
+// Short loops with constant bounds get a peeled epilogue rather than
+// predicated iterations.
+// CHECK-LABEL: tt.func @accumulate_loop_peeled
+// CHECK: scf.for
+// CHECK:   arith.addf
+// CHECK:   triton_gpu.insert_slice_async
+// CHECK:   triton_gpu.async_wait {num = 1 : i32}
+// CHECK:   scf.yield
+// CHECK-NOT: triton_gpu.insert_slice_async
+// CHECK: arith.addf
+// CHECK: triton_gpu.async_wait {num = 0 : i32}
+// CHECK: arith.addf
+// CHECK-NOT: arith.addf
+// CHECK: tt.return
+tt.func @accumulate_loop_peeled(%A : !tt.ptr<f32> {tt.divisibility = 16 : i32}) -> tensor<32x64xf32, #AL> {
+  %c0_i32 = arith.constant 0 : i32
+  %c1_i32 = arith.constant 1 : i32
+  %c4_i32 = arith.constant 4 : i32
+  %a_ptr_splat = tt.splat %A : (!tt.ptr<f32>) -> tensor<32x64x!tt.ptr<f32>, #AL>
+  %a_tmp0 = tt.make_range {end = 64: i32, start = 0: i32} : tensor<64xi32, #ALs0>
+  %a_tmp1 = tt.expand_dims %a_tmp0 {axis = 0 : i32} : (tensor<64xi32, #ALs0>) -> tensor<1x64xi32, #AL>
+  %a_offs = tt.broadcast %a_tmp1 : (tensor<1x64xi32, #AL>) -> tensor<32x64xi32, #AL>
+  %a_ptr_init = tt.addptr %a_ptr_splat, %a_offs : tensor<32x64x!tt.ptr<f32>, #AL>, tensor<32x64xi32, #AL>
+  %a_off = arith.constant dense<64> : tensor<32x64xi32, #AL>
+  %acc_init = arith.constant dense<0.00e+00> : tensor<32x64xf32, #AL>
+  %loop:2 = scf.for %iv = %c0_i32 to %c4_i32 step %c1_i32 iter_args(%a_ptr = %a_ptr_init, %acc = %acc_init) -> (tensor<32x64x!tt.ptr<f32>, #AL>, tensor<32x64xf32, #AL>) : i32 {
+    %a = tt.load %a_ptr {cache = 1 : i32, evict = 1 : i32, isVolatile = false} : tensor<32x64xf32, #AL>
+    %next_acc = arith.addf %acc, %a : tensor<32x64xf32, #AL>
+    %next_a_ptr = tt.addptr %a_ptr, %a_off : tensor<32x64x!tt.ptr<f32>, #AL>, tensor<32x64xi32, #AL>
+    scf.yield %next_a_ptr, %next_acc : tensor<32x64x!tt.ptr<f32>, #AL>, tensor<32x64xf32, #AL>
+  }
+  tt.return %loop#1: tensor<32x64xf32, #AL>
+}
+}
+
+// -----
+
+// The copies of the first stages of the next tile are issued after the inner
+// loop of the current tile, before its epilogue, into buffers that are kept
+// across the tile loop.
+// CHECK-LABEL: tt.func @persistent_matmul
+// CHECK: triton_gpu.alloc_tensor
+// CHECK: triton_gpu.alloc_tensor
+// CHECK: triton_gpu.insert_slice_async
+// CHECK: scf.for
+// CHECK:   triton_gpu.extract_slice
+// CHECK:   scf.for
+// CHECK:     tt.dot
+// CHECK:   triton_gpu.async_wait {num = 0 : i32}
+// CHECK:   triton_gpu.insert_slice_async
+// CHECK:   tt.store
+// CHECK:   scf.yield
+// CHECK: triton_gpu.async_wait {num = 0 : i32}
+// CHECK: triton_gpu.dealloc_tensor
+// CHECK: triton_gpu.dealloc_tensor
+#AL = #triton_gpu.blocked<{sizePerThread = [1, 4], threadsPerWarp = [4, 8], warpsPerCTA = [4, 1], order = [1, 0], CTAsPerCGA = [1, 1], CTASplitNum = [1, 1], CTAOrder = [1, 0]}>
+#BL = #triton_gpu.blocked<{sizePerThread = [1, 4], threadsPerWarp = [1, 32], warpsPerCTA = [4, 1], order = [1, 0], CTAsPerCGA = [1, 1], CTASplitNum = [1, 1], CTAOrder = [1, 0]}>
+#ALs0 = #triton_gpu.slice<{parent=#AL, dim=0}>
+#BLs0 = #triton_gpu.slice<{parent=#BL, dim=0}>
+#C = #triton_gpu.nvidia_mma<{versionMajor = 2, warpsPerCTA = [4, 1], CTAsPerCGA = [1, 1], CTASplitNum = [1, 1], CTAOrder = [1, 0]}>
+#A = #triton_gpu.dot_op<{opIdx = 0, parent = #C, kWidth=2}>
+#B = #triton_gpu.dot_op<{opIdx = 1, parent = #C, kWidth=2}>
+module attributes {"triton_gpu.num-warps" = 4 : i32, "triton_gpu.num-ctas" = 1 : i32, "triton_gpu.compute-capability" = 80} {
+tt.func @persistent_matmul(%tile_lb : index, %tile_ub : index, %tile_step : index,
+                           %lb : index, %ub : index, %step : index,
+                           %A : !tt.ptr<f16> {tt.divisibility = 16 : i32},
+                           %B : !tt.ptr<f16> {tt.divisibility = 16 : i32},
+                           %C : !tt.ptr<f32> {tt.divisibility = 16 : i32}) {
+  %a_ptr_splat = tt.splat %A : (!tt.ptr<f16>) -> tensor<128x32x!tt.ptr<f16>, #AL>
+  %a_tmp0 = tt.make_range {end = 32: i32, start = 0: i32} : tensor<32xi32, #ALs0>
+  %a_tmp1 = tt.expand_dims %a_tmp0 {axis = 0 : i32} : (tensor<32xi32, #ALs0>) -> tensor<1x32xi32, #AL>
+  %a_offs = tt.broadcast %a_tmp1 : (tensor<1x32xi32, #AL>) -> tensor<128x32xi32, #AL>
+  %a_ptr_base = tt.addptr %a_ptr_splat, %a_offs : tensor<128x32x!tt.ptr<f16>, #AL>, tensor<128x32xi32, #AL>
+  %b_ptr_splat = tt.splat %B : (!tt.ptr<f16>) -> tensor<32x128x!tt.ptr<f16>, #BL>
+  %b_tmp0 = tt.make_range {end = 128: i32, start = 0: i32} : tensor<128xi32, #BLs0>
+  %b_tmp1 = tt.expand_dims %b_tmp0 {axis = 0 : i32} : (tensor<128xi32, #BLs0>) -> tensor<1x128xi32, #BL>
+  %b_offs = tt.broadcast %b_tmp1 : (tensor<1x128xi32, #BL>) -> tensor<32x128xi32, #BL>
+  %b_ptr_init = tt.addptr %b_ptr_splat, %b_offs : tensor<32x128x!tt.ptr<f16>, #BL>, tensor<32x128xi32, #BL>
+  %c_ptr = tt.splat %C : (!tt.ptr<f32>) -> tensor<128x128x!tt.ptr<f32>, #C>
+  %c128_i32 = arith.constant 128 : i32
+  %a_off = arith.constant dense<4> : tensor<128x32xi32, #AL>
+  %b_off = arith.constant dense<4> : tensor<32x128xi32, #BL>
+  %c_init = arith.constant dense<0.00e+00> : tensor<128x128xf32, #C>
+  scf.for %tile = %tile_lb to %tile_ub step %tile_step {
+    %tile_i32 = arith.index_cast %tile : index to i32
+    %tile_off = arith.muli %tile_i32, %c128_i32 : i32
+    %tile_off_splat = tt.splat %tile_off : (i32) -> tensor<128x32xi32, #AL>
+    %a_ptr_init = tt.addptr %a_ptr_base, %tile_off_splat : tensor<128x32x!tt.ptr<f16>, #AL>, tensor<128x32xi32, #AL>
+    %loop:3 = scf.for %iv = %lb to %ub step %step iter_args(%a_ptr = %a_ptr_init, %b_ptr = %b_ptr_init, %prev_c = %c_init) -> (tensor<128x32x!tt.ptr<f16>, #AL>, tensor<32x128x!tt.ptr<f16>, #BL>, tensor<128x128xf32, #C>) {
+      %a_ = tt.load %a_ptr {cache = 1 : i32, evict = 1 : i32, isVolatile = false} : tensor<128x32xf16, #AL>
+      %a = triton_gpu.convert_layout %a_ : (tensor<128x32xf16, #AL>) -> tensor<128x32xf16, #A>
+      %b_ = tt.load %b_ptr {cache = 1 : i32, evict = 1 : i32, isVolatile = false} : tensor<32x128xf16, #BL>
+      %b = triton_gpu.convert_layout %b_ : (tensor<32x128xf16, #BL>) -> tensor<32x128xf16, #B>
+      %c = tt.dot %a, %b, %prev_c {allowTF32 = true, maxNumImpreciseAcc = 0 : i32} : tensor<128x32xf16, #A> * tensor<32x128xf16, #B> -> tensor<128x128xf32, #C>
+      %next_a_ptr = tt.addptr %a_ptr, %a_off : tensor<128x32x!tt.ptr<f16>, #AL>, tensor<128x32xi32, #AL>
+      %next_b_ptr = tt.addptr %b_ptr, %b_off : tensor<32x128x!tt.ptr<f16>, #BL>, tensor<32x128xi32, #BL>
+      scf.yield %next_a_ptr, %next_b_ptr, %c : tensor<128x32x!tt.ptr<f16>, #AL>, tensor<32x128x!tt.ptr<f16>, #BL>, tensor<128x128xf32, #C>
+    }
+    tt.store %c_ptr, %loop#2 {cache = 1 : i32, evict = 1 : i32} : tensor<128x128xf32, #C>
+  }
+  tt.return
+}
+}
+
+// -----
+
+// The small loads of the scales of a block-scaled matmul are prefetched along
+// with its operands.
+// CHECK-LABEL: tt.func @scaled_matmul
+// CHECK: triton_gpu.alloc_tensor : tensor<2x128x32xf16
+// CHECK: triton_gpu.alloc_tensor : tensor<2x32x128xf16
+// CHECK: triton_gpu.alloc_tensor : tensor<2x128x1xf32
+// CHECK: scf.for
+// CHECK:   tt.dot
+// CHECK:   triton_gpu.convert_layout %{{.*}} : (tensor<128x1xf32, #shared{{.*}}>) -> tensor<128x1xf32, #{{.*}}>
+// CHECK:   arith.mulf
+// CHECK:   triton_gpu.insert_slice_async
+// CHECK:   scf.yield
+#AL = #triton_gpu.blocked<{sizePerThread = [1, 4], threadsPerWarp = [4, 8], warpsPerCTA = [4, 1], order = [1, 0], CTAsPerCGA = [1, 1], CTASplitNum = [1, 1], CTAOrder = [1, 0]}>
+#BL = #triton_gpu.blocked<{sizePerThread = [1, 4], threadsPerWarp = [1, 32], warpsPerCTA = [4, 1], order = [1, 0], CTAsPerCGA = [1, 1], CTASplitNum = [1, 1], CTAOrder = [1, 0]}>
+#SL = #triton_gpu.blocked<{sizePerThread = [1, 1], threadsPerWarp = [32, 1], warpsPerCTA = [4, 1], order = [0, 1], CTAsPerCGA = [1, 1], CTASplitNum = [1, 1], CTAOrder = [1, 0]}>
+#ALs0 = #triton_gpu.slice<{parent=#AL, dim=0}>
+#BLs0 = #triton_gpu.slice<{parent=#BL, dim=0}>
+#SLs1 = #triton_gpu.slice<{parent=#SL, dim=1}>
+#C = #triton_gpu.nvidia_mma<{versionMajor = 2, warpsPerCTA = [4, 1], CTAsPerCGA = [1, 1], CTASplitNum = [1, 1], CTAOrder = [1, 0]}>
+#A = #triton_gpu.dot_op<{opIdx = 0, parent = #C, kWidth=2}>
+#B = #triton_gpu.dot_op<{opIdx = 1, parent = #C, kWidth=2}>
+module attributes {"triton_gpu.num-warps" = 4 : i32, "triton_gpu.num-ctas" = 1 : i32, "triton_gpu.compute-capability" = 80} {
+tt.func @scaled_matmul(%lb : index, %ub : index, %step : index,
+                       %A : !tt.ptr<f16> {tt.divisibility = 16 : i32},
+                       %B : !tt.ptr<f16> {tt.divisibility = 16 : i32},
+                       %S : !tt.ptr<f32> {tt.divisibility = 16 : i32}) -> tensor<128x128xf32, #C> {
+  %a_ptr_splat = tt.splat %A : (!tt.ptr<f16>) -> tensor<128x32x!tt.ptr<f16>, #AL>
+  %a_tmp0 = tt.make_range {end = 32: i32, start = 0: i32} : tensor<32xi32, #ALs0>
+  %a_tmp1 = tt.expand_dims %a_tmp0 {axis = 0 : i32} : (tensor<32xi32, #ALs0>) -> tensor<1x32xi32, #AL>
+  %a_offs = tt.broadcast %a_tmp1 : (tensor<1x32xi32, #AL>) -> tensor<128x32xi32, #AL>
+  %a_ptr_init = tt.addptr %a_ptr_splat, %a_offs : tensor<128x32x!tt.ptr<f16>, #AL>, tensor<128x32xi32, #AL>
+  %b_ptr_splat = tt.splat %B : (!tt.ptr<f16>) -> tensor<32x128x!tt.ptr<f16>, #BL>
+  %b_tmp0 = tt.make_range {end = 128: i32, start = 0: i32} : tensor<128xi32, #BLs0>
+  %b_tmp1 = tt.expand_dims %b_tmp0 {axis = 0 : i32} : (tensor<128xi32, #BLs0>) -> tensor<1x128xi32, #BL>
+  %b_offs = tt.broadcast %b_tmp1 : (tensor<1x128xi32, #BL>) -> tensor<32x128xi32, #BL>
+  %b_ptr_init = tt.addptr %b_ptr_splat, %b_offs : tensor<32x128x!tt.ptr<f16>, #BL>, tensor<32x128xi32, #BL>
+  %s_ptr_splat = tt.splat %S : (!tt.ptr<f32>) -> tensor<128x1x!tt.ptr<f32>, #SL>
+  %s_tmp0 = tt.make_range {end = 128: i32, start = 0: i32} : tensor<128xi32, #SLs1>
+  %s_offs = tt.expand_dims %s_tmp0 {axis = 1 : i32} : (tensor<128xi32, #SLs1>) -> tensor<128x1xi32, #SL>
+  %s_ptr_init = tt.addptr %s_ptr_splat, %s_offs : tensor<128x1x!tt.ptr<f32>, #SL>, tensor<128x1xi32, #SL>
+  %a_off = arith.constant dense<4> : tensor<128x32xi32, #AL>
+  %b_off = arith.constant dense<4> : tensor<32x128xi32, #BL>
+  %s_off = arith.constant dense<128> : tensor<128x1xi32, #SL>
+  %c_init = arith.constant dense<0.00e+00> : tensor<128x128xf32, #C>
+  %loop:4 = scf.for %iv = %lb to %ub step %step iter_args(%a_ptr = %a_ptr_init, %b_ptr = %b_ptr_init, %s_ptr = %s_ptr_init, %prev_c = %c_init) -> (tensor<128x32x!tt.ptr<f16>, #AL>, tensor<32x128x!tt.ptr<f16>, #BL>, tensor<128x1x!tt.ptr<f32>, #SL>, tensor<128x128xf32, #C>) {
+    %a_ = tt.load %a_ptr {cache = 1 : i32, evict = 1 : i32, isVolatile = false} : tensor<128x32xf16, #AL>
+    %a = triton_gpu.convert_layout %a_ : (tensor<128x32xf16, #AL>) -> tensor<128x32xf16, #A>
+    %b_ = tt.load %b_ptr {cache = 1 : i32, evict = 1 : i32, isVolatile = false} : tensor<32x128xf16, #BL>
+    %b = triton_gpu.convert_layout %b_ : (tensor<32x128xf16, #BL>) -> tensor<32x128xf16, #B>
+    %s_ = tt.load %s_ptr {cache = 1 : i32, evict = 1 : i32, isVolatile = false} : tensor<128x1xf32, #SL>
+    %partial = tt.dot %a, %b, %c_init {allowTF32 = true, maxNumImpreciseAcc = 0 : i32} : tensor<128x32xf16, #A> * tensor<32x128xf16, #B> -> tensor<128x128xf32, #C>
+    %s_c = triton_gpu.convert_layout %s_ : (tensor<128x1xf32, #SL>) -> tensor<128x1xf32, #C>
+    %s = tt.broadcast %s_c : (tensor<128x1xf32, #C>) -> tensor<128x128xf32, #C>
+    %scaled = arith.mulf %partial, %s : tensor<128x128xf32, #C>
+    %c = arith.addf %prev_c, %scaled : tensor<128x128xf32, #C>
+    %next_a_ptr = tt.addptr %a_ptr, %a_off : tensor<128x32x!tt.ptr<f16>, #AL>, tensor<128x32xi32, #AL>
+    %next_b_ptr = tt.addptr %b_ptr, %b_off : tensor<32x128x!tt.ptr<f16>, #BL>, tensor<32x128xi32, #BL>
+    %next_s_ptr = tt.addptr %s_ptr, %s_off : tensor<128x1x!tt.ptr<f32>, #SL>, tensor<128x1xi32, #SL>
+    scf.yield %next_a_ptr, %next_b_ptr, %next_s_ptr, %c : tensor<128x32x!tt.ptr<f16>, #AL>, tensor<32x128x!tt.ptr<f16>, #BL>, tensor<128x1x!tt.ptr<f32>, #SL>, tensor<128x128xf32, #C>
+  }
+  tt.return %loop#3 : tensor<128x128xf32, #C>
+}
+}
+
+// -----
+
+// The rows of a gather by loaded indices can't be staged through shared
+// memory. Those of the next iteration are prefetched into L2, the index of the
+// next iteration being loaded as soon as the iteration starts.
+// CHECK-LABEL: tt.func @gather_loop
+// CHECK: scf.for %[[IV:.*]] = %{{.*}} to %[[UB:.*]] step %[[STEP:.*]] iter_args
+// CHECK:   %[[NEXT_IV:.*]] = arith.addi %[[IV]], %[[STEP]] : i32
+// CHECK:   %[[HAS_NEXT:.*]] = arith.cmpi slt, %[[NEXT_IV]], %[[UB]] : i32
+// CHECK:   %[[NEXT_IDX_PTR:.*]] = tt.addptr %{{.*}}, %[[NEXT_IV]]
+// CHECK:   %[[NEXT_ROW:.*]] = tt.load %[[NEXT_IDX_PTR]], %[[HAS_NEXT]]
+// CHECK:   arith.muli %[[NEXT_ROW]]
+// CHECK:   %[[MASK:.*]] = tt.splat %[[HAS_NEXT]]
+// CHECK:   tt.prefetch %{{.*}}, %[[MASK]] {{.*}}: tensor<128x!tt.ptr<f32, 1>, #blocked>
+// CHECK:   %[[ROW:.*]] = tt.load %{{.*}} : i32
+// CHECK:   arith.muli %[[ROW]]
+// CHECK:   tt.load %{{.*}} : tensor<128xf32, #blocked>
+// CHECK-NOT: tt.prefetch
+// CHECK:   scf.yield
+#blocked = #triton_gpu.blocked<{sizePerThread = [4], threadsPerWarp = [32], warpsPerCTA = [1], order = [0], CTAsPerCGA = [1], CTASplitNum = [1], CTAOrder = [0]}>
+module attributes {"triton_gpu.compute-capability" = 80 : i32, "triton_gpu.num-ctas" = 1 : i32, "triton_gpu.num-warps" = 1 : i32, "triton_gpu.threads-per-warp" = 32 : i32} {
+tt.func @gather_loop(%idx_ptr : !tt.ptr<i32, 1>, %table : !tt.ptr<f32, 1>, %ub : i32) -> tensor<128xf32, #blocked> {
+  %c0 = arith.constant 0 : i32
+  %c1 = arith.constant 1 : i32
+  %c128 = arith.constant 128 : i32
+  %cst = arith.constant dense<0.000000e+00> : tensor<128xf32, #blocked>
+  %range = tt.make_range {end = 128 : i32, start = 0 : i32} : tensor<128xi32, #blocked>
+  %acc = scf.for %iv = %c0 to %ub step %c1 iter_args(%prev = %cst) -> (tensor<128xf32, #blocked>) : i32 {
+    %idx_ptrs = tt.addptr %idx_ptr, %iv : !tt.ptr<i32, 1>, i32
+    %row = tt.load %idx_ptrs {cache = 1 : i32, evict = 1 : i32, isVolatile = false} : i32
+    %off = arith.muli %row, %c128 : i32
+    %row_ptr = tt.addptr %table, %off : !tt.ptr<f32, 1>, i32
+    %splat = tt.splat %row_ptr : (!tt.ptr<f32, 1>) -> tensor<128x!tt.ptr<f32, 1>, #blocked>
+    %ptrs = tt.addptr %splat, %range : tensor<128x!tt.ptr<f32, 1>, #blocked>, tensor<128xi32, #blocked>
+    %x = tt.load %ptrs {cache = 1 : i32, evict = 1 : i32, isVolatile = false} : tensor<128xf32, #blocked>
+    %next = arith.addf %prev, %x : tensor<128xf32, #blocked>
+    scf.yield %next : tensor<128xf32, #blocked>
+  }
+  tt.return %acc : tensor<128xf32, #blocked>
+}
+}
@@ -63,3 +63,36 @@ module attributes {"triton_gpu.compute-capability" = 90 : i32, "triton_gpu.num-c
     tt.return
   }
 }
+
+// -----
+
+// The tiles of the loop alternate between two buffers, the TMA store of a
+// tile is only waited for by the store of two tiles later.
+// CHECK-LABEL: @store_loop
+#blocked = #triton_gpu.blocked<{sizePerThread = [1, 8], threadsPerWarp = [16, 2], warpsPerCTA = [4, 1], order = [1, 0], CTAsPerCGA = [1, 1], CTASplitNum = [1, 1], CTAOrder = [1, 0]}>
+module attributes {"triton_gpu.compute-capability" = 90 : i32, "triton_gpu.num-ctas" = 1 : i32, "triton_gpu.num-warps" = 4 : i32} {
+  tt.func public @store_loop(%C : !tt.ptr<f16, 1> {tt.divisibility = 16 : i32}, %n : i32, %x : tensor<64x16xf16, #blocked>) {
+    %c0 = arith.constant 0 : i32
+    %c1_i32 = arith.constant 1 : i32
+    %c1 = arith.constant 1 : i64
+    %c16 = arith.constant 16 : i64
+    %c64 = arith.constant 64 : i64
+    %ptr = tt.make_tensor_ptr %C, [%c64, %c16], [%c16, %c1], [%c0, %c0] {order = array<i32: 1, 0>} : <tensor<64x16xf16, #blocked>, 1>
+    // CHECK: %[[BUFFERS:.*]] = triton_gpu.alloc_tensor : tensor<2x64x16xf16, #shared>
+    // CHECK: scf.for {{.*}} iter_args(%[[PHASE:.*]] = %false)
+    // CHECK:   %[[INDEX:.*]] = arith.extui %[[PHASE]] : i1 to i32
+    // CHECK:   triton_gpu.async_bulk_wait {num = 1 : i32}
+    // CHECK:   %[[INSERT:.*]] = tensor.insert_slice %{{.*}} into %[[BUFFERS]][%[[INDEX]], 0, 0] [1, 64, 16] [1, 1, 1]
+    // CHECK:   %[[BUFFER:.*]] = triton_gpu.extract_slice %[[INSERT]][%[[INDEX]], 0, 0] [1, 64, 16] [1, 1, 1]
+    // CHECK:   triton_nvidia_gpu.store_async_tma %{{.*}}, %[[BUFFER]]
+    // CHECK:   triton_gpu.async_bulk_commit_group
+    // CHECK-NOT: triton_gpu.async_bulk_wait
+    // CHECK:   scf.yield
+    // CHECK: triton_gpu.async_bulk_wait {num = 0 : i32}
+    // CHECK: tt.return
+    scf.for %iv = %c0 to %n step %c1_i32 : i32 {
+      tt.store %ptr, %x {boundaryCheck = array<i32>, cache = 1 : i32, evict = 1 : i32} : !tt.ptr<tensor<64x16xf16, #blocked>, 1>, tensor<64x16xf16, #blocked>
+    }
+    tt.return
+  }
+}
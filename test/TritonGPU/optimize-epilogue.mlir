@@ -0,0 +1,107 @@
+// RUN: triton-opt %s -split-input-file -tritongpu-optimize-epilogue | FileCheck %s
+
+#blocked = #triton_gpu.blocked<{sizePerThread = [1, 8], threadsPerWarp = [4, 8], warpsPerCTA = [4, 1], order = [1, 0], CTAsPerCGA = [1, 1], CTASplitNum = [1, 1], CTAOrder = [1, 0]}>
+#mma = #triton_gpu.nvidia_mma<{versionMajor = 2, versionMinor = 0, warpsPerCTA = [4, 1], CTAsPerCGA = [1, 1], CTASplitNum = [1, 1], CTAOrder = [1, 0], instrShape = [16, 8]}>
+module attributes {"triton_gpu.num-ctas" = 1 : i32, "triton_gpu.num-warps" = 4 : i32} {
+  // CHECK-LABEL: store_mma_v2
+  tt.func @store_mma_v2(%ptr: tensor<64x64x!tt.ptr<f16>, #blocked>, %acc: tensor<64x64xf16, #mma>) {
+    // CHECK: %[[PTR:.*]] = triton_gpu.convert_layout %{{.*}} : (tensor<64x64x!tt.ptr<f16, 1>, #blocked>) -> tensor<64x64x!tt.ptr<f16, 1>, #mma>
+    // CHECK: tt.store %[[PTR]], %{{.*}} {{.*}} : tensor<64x64xf16, #mma>
+    %0 = triton_gpu.convert_layout %acc : (tensor<64x64xf16, #mma>) -> tensor<64x64xf16, #blocked>
+    tt.store %ptr, %0 {cache = 1 : i32, evict = 1 : i32} : tensor<64x64xf16, #blocked>
+    tt.return
+  }
+}
+
+// -----
+
+#blocked = #triton_gpu.blocked<{sizePerThread = [1, 8], threadsPerWarp = [4, 8], warpsPerCTA = [4, 1], order = [1, 0], CTAsPerCGA = [1, 1], CTASplitNum = [1, 1], CTAOrder = [1, 0]}>
+#mma = #triton_gpu.nvidia_mma<{versionMajor = 3, versionMinor = 0, warpsPerCTA = [4, 1], CTAsPerCGA = [1, 1], CTASplitNum = [1, 1], CTAOrder = [1, 0], instrShape = [16, 64, 16]}>
+module attributes {"triton_gpu.num-ctas" = 1 : i32, "triton_gpu.num-warps" = 4 : i32} {
+  // CHECK-LABEL: store_mma_v3_f16
+  tt.func @store_mma_v3_f16(%ptr: tensor<64x64x!tt.ptr<f16>, #blocked>, %acc: tensor<64x64xf16, #mma>) {
+    // CHECK: triton_gpu.convert_layout %{{.*}} : (tensor<64x64xf16, #mma>) -> tensor<64x64xf16, #blocked>
+    // CHECK: tt.store {{.*}} : tensor<64x64xf16, #blocked>
+    %0 = triton_gpu.convert_layout %acc : (tensor<64x64xf16, #mma>) -> tensor<64x64xf16, #blocked>
+    tt.store %ptr, %0 {cache = 1 : i32, evict = 1 : i32} : tensor<64x64xf16, #blocked>
+    tt.return
+  }
+}
+
+// -----
+
+// The output is column-major: the rows of the mma layout would be stored one
+// sector per element pair, the tile is staged in shared memory instead.
+#blocked = #triton_gpu.blocked<{sizePerThread = [8, 1], threadsPerWarp = [8, 4], warpsPerCTA = [1, 4], order = [0, 1], CTAsPerCGA = [1, 1], CTASplitNum = [1, 1], CTAOrder = [0, 1]}>
+#mma = #triton_gpu.nvidia_mma<{versionMajor = 2, versionMinor = 0, warpsPerCTA = [4, 1], CTAsPerCGA = [1, 1], CTASplitNum = [1, 1], CTAOrder = [1, 0], instrShape = [16, 8]}>
+module attributes {"triton_gpu.num-ctas" = 1 : i32, "triton_gpu.num-warps" = 4 : i32} {
+  // CHECK-LABEL: store_mma_v2_transposed
+  tt.func @store_mma_v2_transposed(%base: !tt.ptr<f16> {tt.divisibility = 16 : i32}, %stride: i32, %acc: tensor<64x64xf16, #mma>) {
+    // CHECK: %[[SHARED:.*]] = triton_gpu.convert_layout %{{.*}} : (tensor<64x64xf16, #mma>) -> tensor<64x64xf16, #shared>
+    // CHECK: %[[VAL:.*]] = triton_gpu.convert_layout %[[SHARED]] : (tensor<64x64xf16, #shared>) -> tensor<64x64xf16, #blocked>
+    // CHECK: tt.store %{{.*}}, %[[VAL]] {{.*}} : tensor<64x64xf16, #blocked>
+    %rows = tt.make_range {end = 64 : i32, start = 0 : i32} : tensor<64xi32, #triton_gpu.slice<{dim = 1, parent = #blocked}>>
+    %cols = tt.make_range {end = 64 : i32, start = 0 : i32} : tensor<64xi32, #triton_gpu.slice<{dim = 0, parent = #blocked}>>
+    %rows_2d = tt.expand_dims %rows {axis = 1 : i32} : (tensor<64xi32, #triton_gpu.slice<{dim = 1, parent = #blocked}>>) -> tensor<64x1xi32, #blocked>
+    %cols_2d = tt.expand_dims %cols {axis = 0 : i32} : (tensor<64xi32, #triton_gpu.slice<{dim = 0, parent = #blocked}>>) -> tensor<1x64xi32, #blocked>
+    %stride_splat = tt.splat %stride : (i32) -> tensor<1x64xi32, #blocked>
+    %col_offs = arith.muli %cols_2d, %stride_splat : tensor<1x64xi32, #blocked>
+    %rows_b = tt.broadcast %rows_2d : (tensor<64x1xi32, #blocked>) -> tensor<64x64xi32, #blocked>
+    %cols_b = tt.broadcast %col_offs : (tensor<1x64xi32, #blocked>) -> tensor<64x64xi32, #blocked>
+    %offs = arith.addi %rows_b, %cols_b : tensor<64x64xi32, #blocked>
+    %base_splat = tt.splat %base : (!tt.ptr<f16>) -> tensor<64x64x!tt.ptr<f16>, #blocked>
+    %ptr = tt.addptr %base_splat, %offs : tensor<64x64x!tt.ptr<f16>, #blocked>, tensor<64x64xi32, #blocked>
+    %0 = triton_gpu.convert_layout %acc : (tensor<64x64xf16, #mma>) -> tensor<64x64xf16, #blocked>
+    tt.store %ptr, %0 {cache = 1 : i32, evict = 1 : i32} : tensor<64x64xf16, #blocked>
+    tt.return
+  }
+}
+
+// -----
+
+#blocked = #triton_gpu.blocked<{sizePerThread = [1, 8], threadsPerWarp = [4, 8], warpsPerCTA = [4, 1], order = [1, 0], CTAsPerCGA = [1, 1], CTASplitNum = [1, 1], CTAOrder = [1, 0]}>
+#mma = #triton_gpu.nvidia_mma<{versionMajor = 2, versionMinor = 0, warpsPerCTA = [4, 1], CTAsPerCGA = [1, 1], CTASplitNum = [1, 1], CTAOrder = [1, 0], instrShape = [16, 8]}>
+module attributes {"triton_gpu.num-ctas" = 1 : i32, "triton_gpu.num-warps" = 4 : i32} {
+  // CHECK-LABEL: reduce_mma_v2
+  tt.func @reduce_mma_v2(%acc: tensor<64x64xf32, #mma>, %scale: f32) -> tensor<64xf32, #triton_gpu.slice<{dim = 1, parent = #blocked}>> {
+    // CHECK: %[[SCALE:.*]] = tt.splat %{{.*}} : (f32) -> tensor<64x64xf32, #mma>
+    // CHECK: %[[MUL:.*]] = arith.mulf %{{.*}}, %[[SCALE]] : tensor<64x64xf32, #mma>
+    // CHECK: %[[ABS:.*]] = math.absf %[[MUL]] : tensor<64x64xf32, #mma>
+    // CHECK: %[[MAX:.*]] = "tt.reduce"(%[[ABS]])
+    // CHECK: (tensor<64x64xf32, #mma>) -> tensor<64xf32, #triton_gpu.slice<{dim = 1, parent = #mma}>>
+    // CHECK: %[[CVT:.*]] = triton_gpu.convert_layout %[[MAX]] : (tensor<64xf32, #triton_gpu.slice<{dim = 1, parent = #mma}>>) -> tensor<64xf32, #triton_gpu.slice<{dim = 1, parent = #blocked}>>
+    // CHECK: tt.return %[[CVT]]
+    %0 = triton_gpu.convert_layout %acc : (tensor<64x64xf32, #mma>) -> tensor<64x64xf32, #blocked>
+    %1 = tt.splat %scale : (f32) -> tensor<64x64xf32, #blocked>
+    %2 = arith.mulf %0, %1 : tensor<64x64xf32, #blocked>
+    %3 = math.absf %2 : tensor<64x64xf32, #blocked>
+    %4 = "tt.reduce"(%3) <{axis = 1 : i32}> ({
+    ^bb0(%a: f32, %b: f32):
+      %m = arith.maximumf %a, %b : f32
+      tt.reduce.return %m : f32
+    }) : (tensor<64x64xf32, #blocked>) -> tensor<64xf32, #triton_gpu.slice<{dim = 1, parent = #blocked}>>
+    tt.return %4 : tensor<64xf32, #triton_gpu.slice<{dim = 1, parent = #blocked}>>
+  }
+}
+
+// -----
+
+#blocked = #triton_gpu.blocked<{sizePerThread = [1, 8], threadsPerWarp = [4, 8], warpsPerCTA = [4, 1], order = [1, 0], CTAsPerCGA = [1, 1], CTASplitNum = [1, 1], CTAOrder = [1, 0]}>
+#mma = #triton_gpu.nvidia_mma<{versionMajor = 2, versionMinor = 0, warpsPerCTA = [4, 1], CTAsPerCGA = [1, 1], CTASplitNum = [1, 1], CTAOrder = [1, 0], instrShape = [16, 8]}>
+module attributes {"triton_gpu.num-ctas" = 1 : i32, "triton_gpu.num-warps" = 4 : i32} {
+  // CHECK-LABEL: reduce_mma_v2_other_use
+  tt.func @reduce_mma_v2_other_use(%ptr: tensor<64x64x!tt.ptr<f32>, #blocked>, %acc: tensor<64x64xf32, #mma>) -> tensor<64xf32, #triton_gpu.slice<{dim = 1, parent = #blocked}>> {
+    // CHECK: %[[NEG:.*]] = arith.negf %{{.*}} : tensor<64x64xf32, #blocked>
+    // CHECK: "tt.reduce"(%[[NEG]])
+    // CHECK: (tensor<64x64xf32, #blocked>)
+    %0 = triton_gpu.convert_layout %acc : (tensor<64x64xf32, #mma>) -> tensor<64x64xf32, #blocked>
+    %1 = arith.negf %0 : tensor<64x64xf32, #blocked>
+    tt.store %ptr, %1 {cache = 1 : i32, evict = 1 : i32} : tensor<64x64xf32, #blocked>
+    %2 = "tt.reduce"(%1) <{axis = 1 : i32}> ({
+    ^bb0(%a: f32, %b: f32):
+      %s = arith.addf %a, %b : f32
+      tt.reduce.return %s : f32
+    }) : (tensor<64x64xf32, #blocked>) -> tensor<64xf32, #triton_gpu.slice<{dim = 1, parent = #blocked}>>
+    tt.return %2 : tensor<64xf32, #triton_gpu.slice<{dim = 1, parent = #blocked}>>
+  }
+}
@@ -595,3 +595,84 @@ module attributes {"triton_gpu.compute-capability" = 80 : i32, "triton_gpu.num-c
     tt.return %1 : tensor<64xf32, #triton_gpu.slice<{dim = 1, parent = #blocked1}>>
   }
 }
+
+// -----
+
+// CHECK-DAG: #[[$BLOCK1:.+]] = #triton_gpu.blocked<{sizePerThread = [1, 1], threadsPerWarp = [2, 16], warpsPerCTA = [2, 1], order = [1, 0], CTAsPerCGA = [1, 1], CTASplitNum = [1, 1], CTAOrder = [1, 0]}>
+// CHECK-DAG: #[[$BLOCK2:.+]] = #triton_gpu.blocked<{sizePerThread = [1, 1], threadsPerWarp = [32, 1], warpsPerCTA = [2, 1], order = [0, 1], CTAsPerCGA = [1, 1], CTASplitNum = [1, 1], CTAOrder = [0, 1]}>
+// CHECK-LABEL: optimize_view_layout_scan
+// CHECK: %[[R:.+]] = tt.reshape {{.*}} {allow_reorder = true, efficient_layout} : {{.*}} -> tensor<64x16xf32, #[[$BLOCK2]]>
+// CHECK: %[[C:.+]] = triton_gpu.convert_layout %[[R]] : (tensor<64x16xf32, #[[$BLOCK2]]>) -> tensor<64x16xf32, #[[$BLOCK1]]>
+// CHECK:  "tt.scan"(%[[C]])
+#blocked = #triton_gpu.blocked<{sizePerThread = [1, 16], threadsPerWarp = [4, 8], warpsPerCTA = [2, 1], order = [1, 0], CTAsPerCGA = [1, 1], CTASplitNum = [1, 1], CTAOrder = [1, 0]}>
+#blocked1 = #triton_gpu.blocked<{sizePerThread = [1, 1], threadsPerWarp = [2, 16], warpsPerCTA = [2, 1], order = [1, 0], CTAsPerCGA = [1, 1], CTASplitNum = [1, 1], CTAOrder = [1, 0]}>
+module attributes {"triton_gpu.compute-capability" = 80 : i32, "triton_gpu.num-ctas" = 1 : i32, "triton_gpu.num-warps" = 2 : i32, "triton_gpu.threads-per-warp" = 32 : i32} {
+  tt.func public @optimize_view_layout_scan(%arg0: tensor<8x128xf32, #blocked>) -> tensor<64x16xf32, #blocked1> {
+    %0 = tt.reshape %arg0 {allow_reorder = true} : tensor<8x128xf32, #blocked> -> tensor<64x16xf32, #blocked1>
+    %1 = "tt.scan"(%0) <{axis = 1 : i32}> ({
+    ^bb0(%arg1: f32, %arg2: f32):
+      %2 = arith.addf %arg1, %arg2 : f32
+      tt.scan.return %2 : f32
+    }) : (tensor<64x16xf32, #blocked1>) -> tensor<64x16xf32, #blocked1>
+    tt.return %1 : tensor<64x16xf32, #blocked1>
+  }
+}
+
+// -----
+
+// The (value, index) pairs of an argmax are accumulated per thread in the
+// loop, and reduced across threads once after it.
+// CHECK-LABEL: argmax_accumulator
+// CHECK: scf.for
+// CHECK: %[[LOAD:.*]] = tt.load
+// CHECK: tt.reshape %[[LOAD]] {allow_reorder = true, efficient_layout} : {{.*}} -> tensor<{{32x32x4xf32.*}}
+// CHECK: tt.reshape {{.*}} {allow_reorder = true, efficient_layout} : {{.*}} -> tensor<{{32x32x4xi32.*}}
+// CHECK-NEXT: "tt.reduce"({{.*}}) <{axis = 2 : i32}>
+// CHECK: arith.cmpf ogt
+// CHECK: arith.select
+// CHECK: arith.select
+// CHECK-NEXT: scf.yield
+// CHECK: %[[FINAL:.*]]:2 = "tt.reduce"({{.*}}) <{axis = 1 : i32}>
+// CHECK: triton_gpu.convert_layout %[[FINAL]]#0
+// CHECK: triton_gpu.convert_layout %[[FINAL]]#1
+// CHECK: arith.cmpf ogt
+// CHECK: tt.store
+#blocked = #triton_gpu.blocked<{sizePerThread = [1, 2], threadsPerWarp = [1, 32], warpsPerCTA = [4, 1], order = [1, 0], CTAsPerCGA = [1, 1], CTASplitNum = [1, 1], CTAOrder = [0, 1]}>
+module attributes {"triton_gpu.compute-capability" = 80 : i32, "triton_gpu.num-ctas" = 1 : i32, "triton_gpu.num-warps" = 4 : i32, "triton_gpu.threads-per-warp" = 32 : i32} {
+  tt.func public @argmax_accumulator(
+    %ptrs: tensor<32x128x!tt.ptr<f32, 1>, #blocked> {tt.divisibility = 16 : i32},
+    %ub: i32,
+    %out_v: tensor<32x!tt.ptr<f32, 1>, #triton_gpu.slice<{dim = 1, parent = #blocked}>>,
+    %out_i: tensor<32x!tt.ptr<i32, 1>, #triton_gpu.slice<{dim = 1, parent = #blocked}>>
+    ) attributes {noinline = false} {
+    %cst = arith.constant dense<0xFF800000> : tensor<32xf32, #triton_gpu.slice<{dim = 1, parent = #blocked}>>
+    %cst_0 = arith.constant dense<0> : tensor<32xi32, #triton_gpu.slice<{dim = 1, parent = #blocked}>>
+    %c0_i32 = arith.constant 0 : i32
+    %c1_i32 = arith.constant 1 : i32
+    %c128_i32 = arith.constant 128 : i32
+    %range = tt.make_range {end = 128 : i32, start = 0 : i32} : tensor<128xi32, #triton_gpu.slice<{dim = 0, parent = #blocked}>>
+    %res:2 = scf.for %k = %c0_i32 to %ub step %c1_i32 iter_args(%v = %cst, %i = %cst_0) -> (tensor<32xf32, #triton_gpu.slice<{dim = 1, parent = #blocked}>>, tensor<32xi32, #triton_gpu.slice<{dim = 1, parent = #blocked}>>) : i32 {
+      %start = arith.muli %k, %c128_i32 : i32
+      %start_splat = tt.splat %start : (i32) -> tensor<128xi32, #triton_gpu.slice<{dim = 0, parent = #blocked}>>
+      %offs = arith.addi %start_splat, %range : tensor<128xi32, #triton_gpu.slice<{dim = 0, parent = #blocked}>>
+      %offs_2d = tt.expand_dims %offs {axis = 0 : i32} : (tensor<128xi32, #triton_gpu.slice<{dim = 0, parent = #blocked}>>) -> tensor<1x128xi32, #blocked>
+      %idx = tt.broadcast %offs_2d : (tensor<1x128xi32, #blocked>) -> tensor<32x128xi32, #blocked>
+      %p = tt.addptr %ptrs, %idx : tensor<32x128x!tt.ptr<f32, 1>, #blocked>, tensor<32x128xi32, #blocked>
+      %x = tt.load %p {cache = 1 : i32, evict = 1 : i32, isVolatile = false} : tensor<32x128xf32, #blocked>
+      %r:2 = "tt.reduce"(%x, %idx) <{axis = 1 : i32}> ({
+      ^bb0(%a: f32, %ai: i32, %b: f32, %bi: i32):
+        %gt = arith.cmpf ogt, %a, %b : f32
+        %m = arith.select %gt, %a, %b : f32
+        %mi = arith.select %gt, %ai, %bi : i32
+        tt.reduce.return %m, %mi : f32, i32
+      }) : (tensor<32x128xf32, #blocked>, tensor<32x128xi32, #blocked>) -> (tensor<32xf32, #triton_gpu.slice<{dim = 1, parent = #blocked}>>, tensor<32xi32, #triton_gpu.slice<{dim = 1, parent = #blocked}>>)
+      %gt = arith.cmpf ogt, %v, %r#0 : tensor<32xf32, #triton_gpu.slice<{dim = 1, parent = #blocked}>>
+      %nv = arith.select %gt, %v, %r#0 : tensor<32xi1, #triton_gpu.slice<{dim = 1, parent = #blocked}>>, tensor<32xf32, #triton_gpu.slice<{dim = 1, parent = #blocked}>>
+      %ni = arith.select %gt, %i, %r#1 : tensor<32xi1, #triton_gpu.slice<{dim = 1, parent = #blocked}>>, tensor<32xi32, #triton_gpu.slice<{dim = 1, parent = #blocked}>>
+      scf.yield %nv, %ni : tensor<32xf32, #triton_gpu.slice<{dim = 1, parent = #blocked}>>, tensor<32xi32, #triton_gpu.slice<{dim = 1, parent = #blocked}>>
+    }
+    tt.store %out_v, %res#0 {cache = 1 : i32, evict = 1 : i32} : tensor<32xf32, #triton_gpu.slice<{dim = 1, parent = #blocked}>>
+    tt.store %out_i, %res#1 {cache = 1 : i32, evict = 1 : i32} : tensor<32xi32, #triton_gpu.slice<{dim = 1, parent = #blocked}>>
+    tt.return
+  }
+}
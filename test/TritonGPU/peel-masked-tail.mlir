@@ -0,0 +1,67 @@
+// RUN: triton-opt %s -split-input-file -tritongpu-peel-masked-tail | FileCheck %s
+
+#blocked = #triton_gpu.blocked<{sizePerThread = [1], threadsPerWarp = [32], warpsPerCTA = [1], order = [0], CTAsPerCGA = [1], CTASplitNum = [1], CTAOrder = [0]}>
+module attributes {"triton_gpu.compute-capability" = 80 : i32, "triton_gpu.num-ctas" = 1 : i32, "triton_gpu.num-warps" = 1 : i32, "triton_gpu.threads-per-warp" = 32 : i32} {
+
+// The mask `k * 32 + arange(0, 32) < K` is only partial on the last iteration.
+// CHECK-LABEL: tt.func @peel_tail
+// CHECK: %[[SPLIT:.*]] = arith.minsi
+// CHECK: %[[MAIN:.*]] = scf.for %{{.*}} = %{{.*}} to %[[SPLIT]]
+// CHECK:   tt.load %{{.*}} {cache
+// CHECK:   tt.store %{{.*}}, %{{.*}} {cache
+// CHECK: scf.for %{{.*}} = %[[SPLIT]] to %{{.*}} step %{{.*}} iter_args(%{{.*}} = %[[MAIN]])
+// CHECK:   tt.load %{{.*}}, %{{.*}}, %{{.*}} {cache
+// CHECK:   tt.store %{{.*}}, %{{.*}}, %{{.*}} {cache
+// CHECK: } {tt.peeled_tail}
+tt.func @peel_tail(%in: !tt.ptr<f32, 1>, %out: !tt.ptr<f32, 1>, %K: i32, %ub: i32) -> tensor<32xf32, #blocked> {
+  %c0 = arith.constant 0 : i32
+  %c1 = arith.constant 1 : i32
+  %c32 = arith.constant 32 : i32
+  %cst = arith.constant dense<0.000000e+00> : tensor<32xf32, #blocked>
+  %range = tt.make_range {end = 32 : i32, start = 0 : i32} : tensor<32xi32, #blocked>
+  %in_ptrs = tt.splat %in : (!tt.ptr<f32, 1>) -> tensor<32x!tt.ptr<f32, 1>, #blocked>
+  %out_ptrs = tt.splat %out : (!tt.ptr<f32, 1>) -> tensor<32x!tt.ptr<f32, 1>, #blocked>
+  %K_splat = tt.splat %K : (i32) -> tensor<32xi32, #blocked>
+  %acc = scf.for %k = %c0 to %ub step %c1 iter_args(%arg = %cst) -> (tensor<32xf32, #blocked>) : i32 {
+    %start = arith.muli %k, %c32 : i32
+    %start_splat = tt.splat %start : (i32) -> tensor<32xi32, #blocked>
+    %offs = arith.addi %start_splat, %range : tensor<32xi32, #blocked>
+    %mask = arith.cmpi slt, %offs, %K_splat : tensor<32xi32, #blocked>
+    %ptrs = tt.addptr %in_ptrs, %offs : tensor<32x!tt.ptr<f32, 1>, #blocked>, tensor<32xi32, #blocked>
+    %x = tt.load %ptrs, %mask, %cst {cache = 1 : i32, evict = 1 : i32, isVolatile = false} : tensor<32xf32, #blocked>
+    %dst = tt.addptr %out_ptrs, %offs : tensor<32x!tt.ptr<f32, 1>, #blocked>, tensor<32xi32, #blocked>
+    tt.store %dst, %x, %mask {cache = 1 : i32, evict = 1 : i32} : tensor<32xf32, #blocked>
+    %next = arith.addf %arg, %x : tensor<32xf32, #blocked>
+    scf.yield %next : tensor<32xf32, #blocked>
+  }
+  tt.return %acc : tensor<32xf32, #blocked>
+}
+
+// A tile of 64 elements advancing by 32 may be partial on two iterations.
+// CHECK-LABEL: tt.func @wide_tile
+// CHECK: scf.for
+// CHECK:   tt.load %{{.*}}, %{{.*}}, %{{.*}} {cache
+// CHECK-NOT: scf.for
+// CHECK-NOT: tt.peeled_tail
+tt.func @wide_tile(%in: !tt.ptr<f32, 1>, %K: i32, %ub: i32) -> tensor<64xf32, #blocked> {
+  %c0 = arith.constant 0 : i32
+  %c1 = arith.constant 1 : i32
+  %c32 = arith.constant 32 : i32
+  %cst = arith.constant dense<0.000000e+00> : tensor<64xf32, #blocked>
+  %range = tt.make_range {end = 64 : i32, start = 0 : i32} : tensor<64xi32, #blocked>
+  %in_ptrs = tt.splat %in : (!tt.ptr<f32, 1>) -> tensor<64x!tt.ptr<f32, 1>, #blocked>
+  %K_splat = tt.splat %K : (i32) -> tensor<64xi32, #blocked>
+  %acc = scf.for %k = %c0 to %ub step %c1 iter_args(%arg = %cst) -> (tensor<64xf32, #blocked>) : i32 {
+    %start = arith.muli %k, %c32 : i32
+    %start_splat = tt.splat %start : (i32) -> tensor<64xi32, #blocked>
+    %offs = arith.addi %start_splat, %range : tensor<64xi32, #blocked>
+    %mask = arith.cmpi slt, %offs, %K_splat : tensor<64xi32, #blocked>
+    %ptrs = tt.addptr %in_ptrs, %offs : tensor<64x!tt.ptr<f32, 1>, #blocked>, tensor<64xi32, #blocked>
+    %x = tt.load %ptrs, %mask, %cst {cache = 1 : i32, evict = 1 : i32, isVolatile = false} : tensor<64xf32, #blocked>
+    %next = arith.addf %arg, %x : tensor<64xf32, #blocked>
+    scf.yield %next : tensor<64xf32, #blocked>
+  }
+  tt.return %acc : tensor<64xf32, #blocked>
+}
+
+}
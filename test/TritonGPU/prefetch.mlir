@@ -68,3 +68,76 @@ tt.func @matmul_loop_mixed(%lb : index, %ub : index, %step : index, %A : !tt.ptr
   tt.return %loop#4 : tensor<128x128xf32, #C>
 }
 }  // end module
+
+// -----
+
+#A = #triton_gpu.shared<{vec = 2, perPhase = 2, maxPhase = 4, order = [1, 0]}>
+#B = #triton_gpu.shared<{vec = 2, perPhase = 2, maxPhase = 4, order = [1, 0]}>
+#C = #triton_gpu.nvidia_mma<{versionMajor = 2, warpsPerCTA = [4, 1]}>
+#A_OP = #triton_gpu.dot_op<{opIdx = 0, parent = #C, kWidth = 2}>
+#B_OP = #triton_gpu.dot_op<{opIdx = 1, parent = #C, kWidth = 2}>
+
+// The loop carries 226 registers, the prefetched slices would add 40.
+// CHECK-LABEL: tt.func @matmul_loop_register_pressure
+// CHECK-NOT: triton_gpu.extract_slice
+// CHECK: tt.return
+module attributes { "triton_gpu.num-warps" = 4 : i32 } {
+tt.func @matmul_loop_register_pressure(%lb : index, %ub : index, %step : index, %a_init : tensor<128x32xf16, #A>, %b_init : tensor<32x128xf16, #B>, %x_init : tensor<128x64xf32, #C>, %y_init : tensor<128x32xf32, #C>) -> (tensor<128x128xf32, #C>, tensor<128x64xf32, #C>, tensor<128x32xf32, #C>) {
+  %c_init = arith.constant dense<0.00e+00> : tensor<128x128xf32, #C>
+  %loop:5 = scf.for %iv = %lb to %ub step %step iter_args(%a = %a_init, %b = %b_init, %prev_c = %c_init, %x = %x_init, %y = %y_init) -> (tensor<128x32xf16, #A>, tensor<32x128xf16, #B>, tensor<128x128xf32, #C>, tensor<128x64xf32, #C>, tensor<128x32xf32, #C>) {
+    %a_op = triton_gpu.convert_layout %a : (tensor<128x32xf16, #A>) -> tensor<128x32xf16, #A_OP>
+    %b_op = triton_gpu.convert_layout %b : (tensor<32x128xf16, #B>) -> tensor<32x128xf16, #B_OP>
+    %c = tt.dot %a_op, %b_op, %prev_c {allowTF32 = true, maxNumImpreciseAcc = 0 : i32, transA = false, transB = false} : tensor<128x32xf16, #A_OP> * tensor<32x128xf16, #B_OP> -> tensor<128x128xf32, #C>
+    %next_x = arith.addf %x, %x : tensor<128x64xf32, #C>
+    %next_y = arith.addf %y, %y : tensor<128x32xf32, #C>
+    scf.yield %a, %b, %c, %next_x, %next_y : tensor<128x32xf16, #A>, tensor<32x128xf16, #B>, tensor<128x128xf32, #C>, tensor<128x64xf32, #C>, tensor<128x32xf32, #C>
+  }
+  tt.return %loop#2, %loop#3, %loop#4 : tensor<128x128xf32, #C>, tensor<128x64xf32, #C>, tensor<128x32xf32, #C>
+}
+}  // end module
+
+// -----
+
+#AL = #triton_gpu.blocked<{sizePerThread = [1, 4], threadsPerWarp = [4, 8], warpsPerCTA = [4, 1], order = [1, 0]}>
+#A = #triton_gpu.shared<{vec = 8, perPhase = 1, maxPhase = 8, order = [1, 0], hasLeadingOffset = true}>
+#B = #triton_gpu.shared<{vec = 8, perPhase = 1, maxPhase = 8, order = [1, 0], hasLeadingOffset = true}>
+#C = #triton_gpu.nvidia_mma<{versionMajor = 3, versionMinor = 0, warpsPerCTA = [4, 1], instrShape = [16, 128, 16]}>
+#A_OP = #triton_gpu.dot_op<{opIdx = 0, parent = #C, kWidth = 2}>
+
+// The a operand of WGMMA is dequantized in registers: the next slice of a is
+// loaded before each dot_async of the current one, b stays in shared memory.
+// CHECK-LABEL: tt.func @wgmma_loop_dequant
+// CHECK:     scf.for
+// CHECK:       %[[A_SMEM:.*]] = triton_gpu.convert_layout %{{.*}} : (tensor<64x64xi8, #{{.*}}>) -> tensor<64x64xi8, #[[SHARED:.*]]>
+// CHECK-DAG:   %[[A0_SMEM:.*]] = triton_gpu.extract_slice %[[A_SMEM]][0, 0] [64, 16]
+// CHECK-DAG:   %[[A0:.*]] = triton_gpu.convert_layout %[[A0_SMEM]]
+// CHECK-DAG:   %[[A0_F16:.*]] = arith.sitofp %[[A0]]
+// CHECK-DAG:   %[[B0:.*]] = triton_gpu.extract_slice %[[B_SMEM:.*]][0, 0] [16, 128]
+// CHECK-DAG:   %[[A1_SMEM:.*]] = triton_gpu.extract_slice %[[A_SMEM]][0, 16] [64, 16]
+// CHECK-DAG:   %[[A1:.*]] = triton_gpu.convert_layout %[[A1_SMEM]]
+// CHECK-DAG:   %[[A1_F16:.*]] = arith.sitofp %[[A1]]
+// CHECK-DAG:   %[[B1:.*]] = triton_gpu.extract_slice %[[B_SMEM]][16, 0] [16, 128]
+// CHECK:       %[[D0:.*]] = triton_nvidia_gpu.dot_async %[[A0_F16]], %[[B0]], %{{.*}}
+// CHECK:       %[[D1:.*]] = triton_nvidia_gpu.dot_async %[[A1_F16]], %[[B1]], %[[D0]]
+// CHECK:       %[[D2:.*]] = triton_nvidia_gpu.dot_async %{{.*}}, %{{.*}}, %[[D1]]
+// CHECK:       %[[D3:.*]] = triton_nvidia_gpu.dot_async %{{.*}}, %{{.*}}, %[[D2]]
+// CHECK:       triton_nvidia_gpu.dot_wait %[[D3]] {pendings = 1 : i32}
+// CHECK-NOT:   triton_nvidia_gpu.dot_async
+// CHECK:       scf.yield
+module attributes { "triton_gpu.num-warps" = 4 : i32 } {
+tt.func @wgmma_loop_dequant(%lb : index, %ub : index, %step : index, %a_ptr_init : tensor<64x64x!tt.ptr<i8>, #AL>, %b : tensor<64x128xf16, #B>) -> tensor<64x128xf32, #C> {
+  %c_init = arith.constant dense<0.00e+00> : tensor<64x128xf32, #C>
+  %a_off = arith.constant dense<64> : tensor<64x64xi32, #AL>
+  %loop:2 = scf.for %iv = %lb to %ub step %step iter_args(%a_ptr = %a_ptr_init, %prev_c = %c_init) -> (tensor<64x64x!tt.ptr<i8>, #AL>, tensor<64x128xf32, #C>) {
+    %a_ = tt.load %a_ptr {cache = 1 : i32, evict = 1 : i32, isVolatile = false} : tensor<64x64xi8, #AL>
+    %a = triton_gpu.convert_layout %a_ : (tensor<64x64xi8, #AL>) -> tensor<64x64xi8, #A>
+    %a_op_ = triton_gpu.convert_layout %a : (tensor<64x64xi8, #A>) -> tensor<64x64xi8, #A_OP>
+    %a_op = arith.sitofp %a_op_ : tensor<64x64xi8, #A_OP> to tensor<64x64xf16, #A_OP>
+    %c = triton_nvidia_gpu.dot_async %a_op, %b, %prev_c {allowTF32 = true, maxNumImpreciseAcc = 0 : i32} : tensor<64x64xf16, #A_OP> * tensor<64x128xf16, #B> -> tensor<64x128xf32, #C>
+    %c_wait = triton_nvidia_gpu.dot_wait %c {pendings = 1 : i32} : tensor<64x128xf32, #C>
+    %next_a_ptr = tt.addptr %a_ptr, %a_off : tensor<64x64x!tt.ptr<i8>, #AL>, tensor<64x64xi32, #AL>
+    scf.yield %next_a_ptr, %c_wait : tensor<64x64x!tt.ptr<i8>, #AL>, tensor<64x128xf32, #C>
+  }
+  tt.return %loop#1 : tensor<64x128xf32, #C>
+}
+}  // end module
@@ -1,4 +1,5 @@
 // RUN: triton-opt %s -split-input-file -tritongpu-reorder-instructions | FileCheck %s
+// RUN: triton-opt %s -split-input-file -tritongpu-reorder-instructions=schedule=true | FileCheck %s --check-prefix=SCHED
 
 // check that we don't hoist convert_layout above its operand definition.
 // CHECK-LABEL: convert_cannot_hoist
@@ -70,3 +71,31 @@ module attributes {"triton_gpu.num-warps" = 4 : i32, "triton_gpu.threads-per-war
     tt.return
   }
 }
+
+// -----
+
+// The second load is issued while the first one is in flight, the math
+// waits for the data. The store stays after the loads it may alias.
+// CHECK-LABEL: schedule_loads
+//       CHECK: tt.load
+//       CHECK: arith.mulf
+//       CHECK: tt.load
+// SCHED-LABEL: schedule_loads
+//       SCHED: %[[A:.+]] = tt.load %arg0
+//  SCHED-NEXT: %[[B:.+]] = tt.load %arg1
+//  SCHED-NEXT: arith.mulf %[[A]], %[[A]]
+//  SCHED-NEXT: arith.mulf %[[B]], %[[B]]
+//  SCHED-NEXT: arith.addf
+//  SCHED-NEXT: tt.store
+#blocked = #triton_gpu.blocked<{sizePerThread = [1, 1], threadsPerWarp = [32, 1], warpsPerCTA = [1, 4], order = [0, 1]}>
+module attributes {"triton_gpu.num-warps" = 4 : i32, "triton_gpu.threads-per-warp" = 32 : i32} {
+  tt.func public @schedule_loads(%arg0: tensor<32x32x!tt.ptr<f32>, #blocked>, %arg1: tensor<32x32x!tt.ptr<f32>, #blocked>) attributes {noinline = false} {
+    %0 = tt.load %arg0 {cache = 1 : i32, evict = 1 : i32, isVolatile = false} : tensor<32x32xf32, #blocked>
+    %1 = arith.mulf %0, %0 : tensor<32x32xf32, #blocked>
+    %2 = tt.load %arg1 {cache = 1 : i32, evict = 1 : i32, isVolatile = false} : tensor<32x32xf32, #blocked>
+    %3 = arith.mulf %2, %2 : tensor<32x32xf32, #blocked>
+    %4 = arith.addf %1, %3 : tensor<32x32xf32, #blocked>
+    tt.store %arg0, %4 {cache = 1 : i32, evict = 1 : i32} : tensor<32x32xf32, #blocked>
+    tt.return
+  }
+}
@@ -38,3 +38,23 @@ module attributes {"triton_gpu.compute-capability" = 90 : i32, "triton_gpu.num-c
     tt.return
   }
 }
+
+// -----
+
+#blocked = #triton_gpu.blocked<{sizePerThread = [1, 1, 8], threadsPerWarp = [1, 4, 8], warpsPerCTA = [4, 1, 1], order = [2, 1, 0], CTAsPerCGA = [1, 1, 1], CTASplitNum = [1, 1, 1], CTAOrder = [2, 1, 0]}>
+module attributes {"triton_gpu.compute-capability" = 90 : i32, "triton_gpu.num-ctas" = 1 : i32, "triton_gpu.num-warps" = 4 : i32, "triton_gpu.threads-per-warp" = 32 : i32} {
+  // CHECK-LABEL: @batched_kernel
+  tt.func public @batched_kernel(%arg0: !tt.ptr<f16, 1> {tt.divisibility = 16 : i32}, %arg1: i32 {tt.divisibility = 16 : i32, tt.max_divisibility = 16 : i32}, %arg2: i32 {tt.divisibility = 16 : i32, tt.max_divisibility = 16 : i32}) attributes {noinline = false} {
+    %c0_i32 = arith.constant 0 : i32
+    %c1_i64 = arith.constant 1 : i64
+    %0 = arith.extsi %arg1 : i32 to i64
+    %1 = arith.extsi %arg2 : i32 to i64
+    // The boxes of 3D tensors stay on TMA.
+    // CHECK: tt.make_tensor_ptr {{.*}} : <tensor<4x64x64xf16, #blocked>, 1>
+    %2 = tt.make_tensor_ptr %arg0, [%0, %0, %0], [%1, %0, %c1_i64], [%c0_i32, %c0_i32, %c0_i32] {order = array<i32: 2, 1, 0>} : <tensor<4x64x64xf16, #blocked>, 1>
+    // The 2D matrices of the box don't have whole swizzling patterns.
+    // CHECK-NOT: tt.make_tensor_ptr
+    %3 = tt.make_tensor_ptr %arg0, [%0, %0, %0], [%1, %0, %c1_i64], [%c0_i32, %c0_i32, %c0_i32] {order = array<i32: 2, 1, 0>} : <tensor<4x2x64xf16, #blocked>, 1>
+    tt.return
+  }
+}
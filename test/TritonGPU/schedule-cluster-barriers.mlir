@@ -0,0 +1,47 @@
+// RUN: triton-opt %s -split-input-file -triton-nvidia-gpu-schedule-cluster-barriers | FileCheck %s
+
+// The arrive is hoisted above the address computations before it and the wait
+// sunk below those after it, up to the memory accesses.
+// CHECK-LABEL: llvm.func @split_barrier
+// CHECK: llvm.store
+// CHECK-NEXT: nvgpu.cluster_arrive {relaxed = false}
+// CHECK-NEXT: llvm.add
+// CHECK-NEXT: llvm.mul
+// CHECK-NEXT: llvm.getelementptr
+// CHECK-NEXT: nvgpu.cluster_wait
+// CHECK-NEXT: llvm.load
+module attributes {"triton_gpu.num-ctas" = 2 : i32, "triton_gpu.num-warps" = 4 : i32} {
+  llvm.func @split_barrier(%ptr: !llvm.ptr<3>, %value: f32, %a: i32, %b: i32) -> f32 {
+    llvm.store %value, %ptr : f32, !llvm.ptr<3>
+    %0 = llvm.add %a, %b : i32
+    nvgpu.cluster_arrive {relaxed = false}
+    nvgpu.cluster_wait
+    %1 = llvm.mul %0, %b : i32
+    %2 = llvm.getelementptr %ptr[%1] : (!llvm.ptr<3>, i32) -> !llvm.ptr<3>, f32
+    %3 = llvm.load %2 : !llvm.ptr<3> -> f32
+    llvm.return %3 : f32
+  }
+}
+
+// -----
+
+// The barrier after the initialization of the mbarriers.
+// CHECK-LABEL: tt.func @split_barrier_ttgir
+// CHECK: triton_nvidia_gpu.alloc_mbarrier
+// CHECK-NEXT: triton_nvidia_gpu.cluster_arrive {relaxed = false}
+// CHECK-NEXT: tt.get_program_id
+// CHECK-NEXT: arith.muli
+// CHECK-NEXT: triton_nvidia_gpu.cluster_wait
+// CHECK-NEXT: triton_nvidia_gpu.mbarrier_arrive
+module attributes {"triton_gpu.num-ctas" = 2 : i32, "triton_gpu.num-warps" = 4 : i32} {
+  tt.func @split_barrier_ttgir(%pred: i1) -> i32 {
+    %c64 = arith.constant 64 : i32
+    %mbar = triton_nvidia_gpu.alloc_mbarrier {count = 1 : i32} : !tt.ptr<i64, 3>
+    triton_nvidia_gpu.cluster_arrive {relaxed = 0 : i1}
+    triton_nvidia_gpu.cluster_wait
+    %pid = tt.get_program_id x : i32
+    %offset = arith.muli %pid, %c64 : i32
+    triton_nvidia_gpu.mbarrier_arrive %mbar, %pred {operandSegmentSizes = array<i32: 1, 1, 0>, trackAsyncOp = false, txCount = 0 : i32} : !tt.ptr<i64, 3>, i1
+    tt.return %offset : i32
+  }
+}
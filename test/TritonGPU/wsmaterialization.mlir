@@ -159,9 +159,11 @@ module attributes {"async.num-agents" = 2 : i32, "triton_gpu.compute-capability"
 #shared = #triton_gpu.shared<{vec = 8, perPhase = 4, maxPhase = 2, order = [1, 0], CTAsPerCGA = [1, 1], CTASplitNum = [1, 1], CTAOrder = [0, 1], hasLeadingOffset = true}>
 #shared1 = #triton_gpu.shared<{vec = 8, perPhase = 4, maxPhase = 2, order = [0, 1], CTAsPerCGA = [1, 1], CTASplitNum = [1, 1], CTAOrder = [0, 1], hasLeadingOffset = true}>
 module attributes {"async.num-agents" = 2 : i32, "triton_gpu.compute-capability" = 90 : i32, "triton_gpu.enable-warp-specialization" = 1 : i32, "triton_gpu.num-ctas" = 1 : i32, "triton_gpu.num-warps" = 4 : i32, "triton_gpu.threads-per-warp" = 32 : i32} {
+  // The load agent frees the registers it doesn't need for the two mma roles.
   // CHECK-LABEL: @matmal_from_wsmutex
   // CHECK: triton_nvidia_gpu.alloc_mbarrier
   // CHECK: scf.if
+  // CHECK: triton_nvidia_gpu.reg_dealloc {{([2-9][0-9]|1[0-5][0-9]|160)}}
   // CHECK: scf.for
   // CHECK: triton_nvidia_gpu.extract_mbarrier
   // CHECK: triton_nvidia_gpu.mbarrier_wait
@@ -171,6 +173,7 @@ module attributes {"async.num-agents" = 2 : i32, "triton_gpu.compute-capability"
   // CHECK: triton_nvidia_gpu.mbarrier_arrive
   // CHECK: scf.yield
   // CHECK: scf.if
+  // CHECK: triton_nvidia_gpu.reg_alloc {{(17[6-9]|1[89][0-9]|2[0-5][0-9])}}
   // CHECK: triton_nvidia_gpu.bar_wait
   // CHECK: scf.for
   // CHECK: triton_nvidia_gpu.extract_mbarrier
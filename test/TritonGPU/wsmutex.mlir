@@ -1,4 +1,4 @@
-// RUN: triton-opt -triton-nvidia-gpu-ws-mutex='compute-capability=90' %s | FileCheck %s
+// RUN: triton-opt -split-input-file -triton-nvidia-gpu-ws-mutex='compute-capability=90' %s | FileCheck %s
 
 
 // CHECK: scf.if
@@ -164,3 +164,56 @@ module attributes {"async.num-agents" = 2 : i32, "triton_gpu.compute-capability"
     tt.return
   }
 }
+
+// -----
+
+// The two dots of the inner loop of an attention kernel take one mutex, the
+// consumers alternate between it and the epilogue.
+// CHECK-LABEL: @persistent_attention
+// CHECK: scf.if
+// CHECK: triton_nvidia_gpu.create_mutex
+// CHECK: triton_nvidia_gpu.create_mutex
+// CHECK-NOT: triton_nvidia_gpu.create_mutex
+// CHECK: scf.for
+// CHECK: triton_nvidia_gpu.lock
+// CHECK: scf.for
+// CHECK: tt.dot
+// CHECK: tt.dot
+// CHECK: agent.mutex_role = 0 : i32
+// CHECK: triton_nvidia_gpu.unlock
+// CHECK: triton_nvidia_gpu.lock
+// CHECK: tt.store
+// CHECK-SAME: agent.mutex_role = 1 : i32
+// CHECK: triton_nvidia_gpu.unlock
+#blocked = #triton_gpu.blocked<{sizePerThread = [1, 4], threadsPerWarp = [2, 16], warpsPerCTA = [4, 1], order = [1, 0], CTAsPerCGA = [1, 1], CTASplitNum = [1, 1], CTAOrder = [0, 1]}>
+#mma = #triton_gpu.nvidia_mma<{versionMajor = 3, versionMinor = 0, warpsPerCTA = [4, 1], CTAsPerCGA = [1, 1], CTASplitNum = [1, 1], CTAOrder = [1, 0], instrShape = [16, 64, 16]}>
+#shared = #triton_gpu.shared<{vec = 8, perPhase = 1, maxPhase = 8, order = [1, 0], CTAsPerCGA = [1, 1], CTASplitNum = [1, 1], CTAOrder = [0, 1], hasLeadingOffset = true}>
+#shared1 = #triton_gpu.shared<{vec = 8, perPhase = 1, maxPhase = 8, order = [0, 1], CTAsPerCGA = [1, 1], CTASplitNum = [1, 1], CTAOrder = [0, 1], hasLeadingOffset = true}>
+module attributes {"async.num-agents" = 2 : i32, "triton_gpu.compute-capability" = 90 : i32, "triton_gpu.enable-warp-specialization" = 1 : i32, "triton_gpu.num-ctas" = 1 : i32, "triton_gpu.num-warps" = 4 : i32} {
+  tt.func public @persistent_attention(%q: tensor<64x64xf16, #shared>, %k: tensor<64x64xf16, #shared1>, %v: tensor<64x64xf16, #shared>,
+                                       %out: tensor<64x64x!tt.ptr<f32, 1>, #blocked>, %num_tiles: i32, %num_kv: i32) {
+    %0 = triton_nvidia_gpu.get_agent_id : i32
+    %c1_i32 = arith.constant 1 : i32
+    %1 = arith.cmpi eq, %0, %c1_i32 : i32
+    scf.if %1 {
+      %cst = arith.constant {async_agent = dense<1> : vector<1xi32>} dense<0.000000e+00> : tensor<64x64xf32, #mma>
+      %c0_i32 = arith.constant {async_agent = dense<1> : vector<1xi32>} 0 : i32
+      %c1_i32_0 = arith.constant {async_agent = dense<1> : vector<1xi32>} 1 : i32
+      %2 = tt.get_program_id x {async_agent = dense<1> : vector<1xi32>, axis = 0 : i32} : i32
+      %3 = scf.for %arg0 = %2 to %num_tiles step %c1_i32_0 iter_args(%arg1 = %c0_i32) -> (i32)  : i32 {
+        %4 = scf.for %arg2 = %c0_i32 to %num_kv step %c1_i32_0 iter_args(%arg3 = %cst) -> (tensor<64x64xf32, #mma>)  : i32 {
+          %7 = tt.dot %q, %k, %cst {allowTF32 = true, maxNumImpreciseAcc = 0 : i32, async_agent = dense<1> : vector<1xi32>} : tensor<64x64xf16, #shared> * tensor<64x64xf16, #shared1> -> tensor<64x64xf32, #mma>
+          %8 = arith.truncf %7 {async_agent = dense<1> : vector<1xi32>} : tensor<64x64xf32, #mma> to tensor<64x64xf16, #mma>
+          %9 = triton_gpu.convert_layout %8 {async_agent = dense<1> : vector<1xi32>} : (tensor<64x64xf16, #mma>) -> tensor<64x64xf16, #shared>
+          %10 = tt.dot %9, %v, %arg3 {allowTF32 = true, maxNumImpreciseAcc = 0 : i32, async_agent = dense<1> : vector<1xi32>} : tensor<64x64xf16, #shared> * tensor<64x64xf16, #shared> -> tensor<64x64xf32, #mma>
+          scf.yield {async_agent = dense<1> : vector<1xi32>} %10 : tensor<64x64xf32, #mma>
+        } {async_agent = dense<1> : vector<1xi32>}
+        %5 = triton_gpu.convert_layout %4 {async_agent = dense<1> : vector<1xi32>} : (tensor<64x64xf32, #mma>) -> tensor<64x64xf32, #blocked>
+        tt.store %out, %5 {async_agent = dense<1> : vector<1xi32>, cache = 1 : i32, evict = 1 : i32} : tensor<64x64xf32, #blocked>
+        %6 = arith.addi %arg1, %c1_i32_0 {async_agent = dense<1> : vector<1xi32>} : i32
+        scf.yield {async_agent = dense<1> : vector<1xi32>} %6 : i32
+      } {async_agent = dense<1> : vector<1xi32>}
+    } {async_agent = dense<1> : vector<1xi32>}
+    tt.return
+  }
+}
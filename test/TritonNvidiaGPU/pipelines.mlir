@@ -0,0 +1,17 @@
+// RUN: triton-opt %s -triton-nvidia-ttir-pipeline -triton-nvidia-ttgir-pipeline="num-warps=8 num-stages=2 cc=90" | FileCheck %s
+
+// The pipelines of the backend take the options of the compilation.
+// CHECK: #[[BLOCKED:blocked[0-9]*]] = #triton_gpu.blocked<{sizePerThread = [4]
+// CHECK: module attributes {"triton_gpu.compute-capability" = 90 : i32, "triton_gpu.num-ctas" = 1 : i32, "triton_gpu.num-warps" = 8 : i32
+// CHECK-LABEL: tt.func public @copy
+// CHECK: tt.load {{.*}} : tensor<1024xf32, #[[BLOCKED]]>
+tt.func public @copy(%src: !tt.ptr<f32> {tt.divisibility = 16 : i32}, %dst: !tt.ptr<f32> {tt.divisibility = 16 : i32}) {
+  %offsets = tt.make_range {end = 1024 : i32, start = 0 : i32} : tensor<1024xi32>
+  %src_base = tt.splat %src : (!tt.ptr<f32>) -> tensor<1024x!tt.ptr<f32>>
+  %src_ptrs = tt.addptr %src_base, %offsets : tensor<1024x!tt.ptr<f32>>, tensor<1024xi32>
+  %dst_base = tt.splat %dst : (!tt.ptr<f32>) -> tensor<1024x!tt.ptr<f32>>
+  %dst_ptrs = tt.addptr %dst_base, %offsets : tensor<1024x!tt.ptr<f32>>, tensor<1024xi32>
+  %values = tt.load %src_ptrs {cache = 1 : i32, evict = 1 : i32, isVolatile = false} : tensor<1024xf32>
+  tt.store %dst_ptrs, %values : tensor<1024xf32>
+  tt.return
+}
@@ -1033,3 +1033,47 @@ module attributes {"triton_gpu.compute-capability" = 90 : i32, "triton_gpu.num-c
     tt.return
   }
 }
+
+// -----
+
+// The queries are loaded once per tile by the consumers, the keys and values
+// of the inner loop by the producer.
+#blocked = #triton_gpu.blocked<{sizePerThread = [1, 8], threadsPerWarp = [4, 8], warpsPerCTA = [4, 1], order = [1, 0], CTAsPerCGA = [1, 1], CTASplitNum = [1, 1], CTAOrder = [0, 1]}>
+#blocked1 = #triton_gpu.blocked<{sizePerThread = [8, 1], threadsPerWarp = [8, 4], warpsPerCTA = [1, 4], order = [0, 1], CTAsPerCGA = [1, 1], CTASplitNum = [1, 1], CTAOrder = [0, 1]}>
+#blocked2 = #triton_gpu.blocked<{sizePerThread = [1, 4], threadsPerWarp = [1, 32], warpsPerCTA = [4, 1], order = [1, 0], CTAsPerCGA = [1, 1], CTASplitNum = [1, 1], CTAOrder = [0, 1]}>
+#mma = #triton_gpu.nvidia_mma<{versionMajor = 3, versionMinor = 0, warpsPerCTA = [4, 1], CTAsPerCGA = [1, 1], CTASplitNum = [1, 1], CTAOrder = [1, 0], instrShape = [16, 64, 16]}>
+#shared = #triton_gpu.shared<{vec = 8, perPhase = 1, maxPhase = 8, order = [1, 0], CTAsPerCGA = [1, 1], CTASplitNum = [1, 1], CTAOrder = [0, 1], hasLeadingOffset = true}>
+#shared1 = #triton_gpu.shared<{vec = 8, perPhase = 1, maxPhase = 8, order = [0, 1], CTAsPerCGA = [1, 1], CTASplitNum = [1, 1], CTAOrder = [0, 1], hasLeadingOffset = true}>
+module attributes {"triton_gpu.compute-capability" = 90 : i32, "triton_gpu.num-ctas" = 1 : i32, "triton_gpu.num-warps" = 4 : i32} {
+  // CHECK: "triton_gpu.enable-warp-specialization" = 1 : i32
+  // CHECK-LABEL: @persistent_attention
+  tt.func public @persistent_attention(
+      %q_ptr: !tt.ptr<tensor<128x64xf16, #blocked>, 1>,
+      %k_ptr: !tt.ptr<tensor<64x64xf16, #blocked1>, 1>,
+      %v_ptr: !tt.ptr<tensor<64x64xf16, #blocked>, 1>,
+      %out: tensor<128x64x!tt.ptr<f32, 1>, #blocked2>,
+      %num_tiles: index, %num_kv: index
+  ) {
+    %cst = arith.constant dense<0.000000e+00> : tensor<128x64xf32, #mma>
+    %c0 = arith.constant 0 : index
+    %c1 = arith.constant 1 : index
+    scf.for %tile = %c0 to %num_tiles step %c1 iter_args() -> () {
+      %q = tt.load %q_ptr {boundaryCheck = array<i32>, cache = 1 : i32, evict = 1 : i32, isVolatile = false} : !tt.ptr<tensor<128x64xf16, #blocked>, 1> -> tensor<128x64xf16, #blocked>
+      %shm_q = triton_gpu.convert_layout %q : (tensor<128x64xf16, #blocked>) -> tensor<128x64xf16, #shared>
+      %acc = scf.for %kv = %c0 to %num_kv step %c1 iter_args(%prev = %cst) -> (tensor<128x64xf32, #mma>) {
+        %k = tt.load %k_ptr {boundaryCheck = array<i32>, cache = 1 : i32, evict = 1 : i32, isVolatile = false} : !tt.ptr<tensor<64x64xf16, #blocked1>, 1> -> tensor<64x64xf16, #blocked1>
+        %shm_k = triton_gpu.convert_layout %k : (tensor<64x64xf16, #blocked1>) -> tensor<64x64xf16, #shared1>
+        %qk = tt.dot %shm_q, %shm_k, %cst {allowTF32 = true, maxNumImpreciseAcc = 0 : i32} : tensor<128x64xf16, #shared> * tensor<64x64xf16, #shared1> -> tensor<128x64xf32, #mma>
+        %p = arith.truncf %qk : tensor<128x64xf32, #mma> to tensor<128x64xf16, #mma>
+        %shm_p = triton_gpu.convert_layout %p : (tensor<128x64xf16, #mma>) -> tensor<128x64xf16, #shared>
+        %v = tt.load %v_ptr {boundaryCheck = array<i32>, cache = 1 : i32, evict = 1 : i32, isVolatile = false} : !tt.ptr<tensor<64x64xf16, #blocked>, 1> -> tensor<64x64xf16, #blocked>
+        %shm_v = triton_gpu.convert_layout %v : (tensor<64x64xf16, #blocked>) -> tensor<64x64xf16, #shared>
+        %next = tt.dot %shm_p, %shm_v, %prev {allowTF32 = true, maxNumImpreciseAcc = 0 : i32} : tensor<128x64xf16, #shared> * tensor<64x64xf16, #shared> -> tensor<128x64xf32, #mma>
+        scf.yield %next : tensor<128x64xf32, #mma>
+      }
+      %o = triton_gpu.convert_layout %acc : (tensor<128x64xf32, #mma>) -> tensor<128x64xf32, #blocked2>
+      tt.store %out, %o {cache = 1 : i32, evict = 1 : i32} : tensor<128x64xf32, #blocked2>
+    }
+    tt.return
+  }
+}
@@ -0,0 +1,69 @@
+// RUN: triton-opt -split-input-file -triton-nvidia-gpu-ws-feasibility-checking='compute-capability=90 num-stages=3 only-if-profitable=1' %s 2>&1 | FileCheck %s
+
+// 128x128 tiles of f16: a stage feeds 64 flops per byte to the MMAs
+#blocked = #triton_gpu.blocked<{sizePerThread = [1, 8], threadsPerWarp = [8, 4], warpsPerCTA = [4, 1], order = [1, 0], CTAsPerCGA = [1, 1], CTASplitNum = [1, 1], CTAOrder = [1, 0]}>
+#mma = #triton_gpu.nvidia_mma<{versionMajor = 3, versionMinor = 0, warpsPerCTA = [4, 1], CTAsPerCGA = [1, 1], CTASplitNum = [1, 1], CTAOrder = [1, 0], instrShape = [16, 128, 16]}>
+#shared = #triton_gpu.shared<{vec = 8, perPhase = 2, maxPhase = 4, order = [1, 0], CTAsPerCGA = [1, 1], CTASplitNum = [1, 1], CTAOrder = [1, 0], hasLeadingOffset = true}>
+// CHECK-NOT: Warning
+// CHECK: "triton_gpu.enable-warp-specialization" = 1 : i32
+// CHECK-LABEL: @gemm_128x128
+module attributes {"triton_gpu.num-ctas" = 1 : i32, "triton_gpu.num-warps" = 4 : i32} {
+  tt.func public @gemm_128x128(%arg0: !tt.ptr<f16, 1> {tt.divisibility = 16 : i32}, %arg1: !tt.ptr<f16, 1> {tt.divisibility = 16 : i32}, %arg2: !tt.ptr<f32, 1> {tt.divisibility = 16 : i32}, %arg3: i32) {
+    %cst = arith.constant dense<0.000000e+00> : tensor<128x128xf32, #mma>
+    %cst_0 = arith.constant dense<32> : tensor<128x32xi32, #blocked>
+    %cst_1 = arith.constant dense<4096> : tensor<32x128xi32, #blocked>
+    %c0 = arith.constant 0 : index
+    %c1 = arith.constant 1 : index
+    %0 = tt.splat %arg0 : (!tt.ptr<f16, 1>) -> tensor<128x32x!tt.ptr<f16, 1>, #blocked>
+    %1 = tt.splat %arg1 : (!tt.ptr<f16, 1>) -> tensor<32x128x!tt.ptr<f16, 1>, #blocked>
+    %2 = arith.index_cast %arg3 : i32 to index
+    %3:3 = scf.for %arg4 = %c0 to %2 step %c1 iter_args(%arg5 = %cst, %arg6 = %0, %arg7 = %1) -> (tensor<128x128xf32, #mma>, tensor<128x32x!tt.ptr<f16, 1>, #blocked>, tensor<32x128x!tt.ptr<f16, 1>, #blocked>) {
+      %6 = tt.load %arg6 {cache = 1 : i32, evict = 1 : i32, isVolatile = false} : tensor<128x32xf16, #blocked>
+      %7 = tt.load %arg7 {cache = 1 : i32, evict = 1 : i32, isVolatile = false} : tensor<32x128xf16, #blocked>
+      %8 = triton_gpu.convert_layout %6 : (tensor<128x32xf16, #blocked>) -> tensor<128x32xf16, #shared>
+      %9 = triton_gpu.convert_layout %7 : (tensor<32x128xf16, #blocked>) -> tensor<32x128xf16, #shared>
+      %10 = tt.dot %8, %9, %arg5 {allowTF32 = true, maxNumImpreciseAcc = 0 : i32} : tensor<128x32xf16, #shared> * tensor<32x128xf16, #shared> -> tensor<128x128xf32, #mma>
+      %11 = tt.addptr %arg6, %cst_0 : tensor<128x32x!tt.ptr<f16, 1>, #blocked>, tensor<128x32xi32, #blocked>
+      %12 = tt.addptr %arg7, %cst_1 : tensor<32x128x!tt.ptr<f16, 1>, #blocked>, tensor<32x128xi32, #blocked>
+      scf.yield %10, %11, %12 : tensor<128x128xf32, #mma>, tensor<128x32x!tt.ptr<f16, 1>, #blocked>, tensor<32x128x!tt.ptr<f16, 1>, #blocked>
+    }
+    %4 = tt.splat %arg2 : (!tt.ptr<f32, 1>) -> tensor<128x128x!tt.ptr<f32, 1>, #mma>
+    tt.store %4, %3#0 {cache = 1 : i32, evict = 1 : i32} : tensor<128x128xf32, #mma>
+    tt.return
+  }
+}
+
+// -----
+
+// 64x64 tiles: the handoff of each stage costs as much as its MMAs save
+#blocked = #triton_gpu.blocked<{sizePerThread = [1, 8], threadsPerWarp = [8, 4], warpsPerCTA = [4, 1], order = [1, 0], CTAsPerCGA = [1, 1], CTASplitNum = [1, 1], CTAOrder = [1, 0]}>
+#mma = #triton_gpu.nvidia_mma<{versionMajor = 3, versionMinor = 0, warpsPerCTA = [4, 1], CTAsPerCGA = [1, 1], CTASplitNum = [1, 1], CTAOrder = [1, 0], instrShape = [16, 64, 16]}>
+#shared = #triton_gpu.shared<{vec = 8, perPhase = 2, maxPhase = 4, order = [1, 0], CTAsPerCGA = [1, 1], CTASplitNum = [1, 1], CTAOrder = [1, 0], hasLeadingOffset = true}>
+// CHECK-NOT: Warning
+// CHECK: "triton_gpu.enable-warp-specialization" = 0 : i32
+// CHECK-LABEL: @gemm_64x64
+module attributes {"triton_gpu.num-ctas" = 1 : i32, "triton_gpu.num-warps" = 4 : i32} {
+  tt.func public @gemm_64x64(%arg0: !tt.ptr<f16, 1> {tt.divisibility = 16 : i32}, %arg1: !tt.ptr<f16, 1> {tt.divisibility = 16 : i32}, %arg2: !tt.ptr<f32, 1> {tt.divisibility = 16 : i32}, %arg3: i32) {
+    %cst = arith.constant dense<0.000000e+00> : tensor<64x64xf32, #mma>
+    %cst_0 = arith.constant dense<32> : tensor<64x32xi32, #blocked>
+    %cst_1 = arith.constant dense<2048> : tensor<32x64xi32, #blocked>
+    %c0 = arith.constant 0 : index
+    %c1 = arith.constant 1 : index
+    %0 = tt.splat %arg0 : (!tt.ptr<f16, 1>) -> tensor<64x32x!tt.ptr<f16, 1>, #blocked>
+    %1 = tt.splat %arg1 : (!tt.ptr<f16, 1>) -> tensor<32x64x!tt.ptr<f16, 1>, #blocked>
+    %2 = arith.index_cast %arg3 : i32 to index
+    %3:3 = scf.for %arg4 = %c0 to %2 step %c1 iter_args(%arg5 = %cst, %arg6 = %0, %arg7 = %1) -> (tensor<64x64xf32, #mma>, tensor<64x32x!tt.ptr<f16, 1>, #blocked>, tensor<32x64x!tt.ptr<f16, 1>, #blocked>) {
+      %6 = tt.load %arg6 {cache = 1 : i32, evict = 1 : i32, isVolatile = false} : tensor<64x32xf16, #blocked>
+      %7 = tt.load %arg7 {cache = 1 : i32, evict = 1 : i32, isVolatile = false} : tensor<32x64xf16, #blocked>
+      %8 = triton_gpu.convert_layout %6 : (tensor<64x32xf16, #blocked>) -> tensor<64x32xf16, #shared>
+      %9 = triton_gpu.convert_layout %7 : (tensor<32x64xf16, #blocked>) -> tensor<32x64xf16, #shared>
+      %10 = tt.dot %8, %9, %arg5 {allowTF32 = true, maxNumImpreciseAcc = 0 : i32} : tensor<64x32xf16, #shared> * tensor<32x64xf16, #shared> -> tensor<64x64xf32, #mma>
+      %11 = tt.addptr %arg6, %cst_0 : tensor<64x32x!tt.ptr<f16, 1>, #blocked>, tensor<64x32xi32, #blocked>
+      %12 = tt.addptr %arg7, %cst_1 : tensor<32x64x!tt.ptr<f16, 1>, #blocked>, tensor<32x64xi32, #blocked>
+      scf.yield %10, %11, %12 : tensor<64x64xf32, #mma>, tensor<64x32x!tt.ptr<f16, 1>, #blocked>, tensor<32x64x!tt.ptr<f16, 1>, #blocked>
+    }
+    %4 = tt.splat %arg2 : (!tt.ptr<f32, 1>) -> tensor<64x64x!tt.ptr<f32, 1>, #mma>
+    tt.store %4, %3#0 {cache = 1 : i32, evict = 1 : i32} : tensor<64x64xf32, #mma>
+    tt.return
+  }
+}
@@ -0,0 +1,81 @@
+#include "mlir/Pass/Pass.h"
+#include "triton/Analysis/BankConflicts.h"
+#include "triton/Dialect/Triton/IR/Dialect.h"
+
+using namespace mlir;
+using namespace mlir::triton::gpu;
+
+namespace {
+
+struct TestBankConflictsPass
+    : public PassWrapper<TestBankConflictsPass, OperationPass<ModuleOp>> {
+
+  MLIR_DEFINE_EXPLICIT_INTERNAL_INLINE_TYPE_ID(TestBankConflictsPass);
+
+  StringRef getArgument() const final { return "test-print-bank-conflicts"; }
+  StringRef getDescription() const final {
+    return "print the expected bank conflicts of the shared memory accesses";
+  }
+
+  void runOnOperation() override {
+    auto &os = llvm::errs();
+    auto print = [&](StringRef kind, RankedTensorType type,
+                     RankedTensorType sharedType) {
+      auto sharedEnc = sharedType.getEncoding().cast<SharedEncodingAttr>();
+      os << kind << ": ";
+      if (auto cost = getSharedAccessCost(type, sharedEnc))
+        os << "wavefronts = " << cost->wavefronts
+           << ", conflicts = " << cost->conflicts << "\n";
+      else
+        os << "unknown\n";
+    };
+    getOperation().walk([&](Operation *op) {
+      if (auto insertOp = dyn_cast<InsertSliceAsyncOp>(op)) {
+        // The copies store the elements the pointers of `src` point to
+        auto ptrType = insertOp.getSrc().getType().cast<RankedTensorType>();
+        auto dstType = insertOp.getType().cast<RankedTensorType>();
+        print("store",
+              RankedTensorType::get(ptrType.getShape(),
+                                    dstType.getElementType(),
+                                    ptrType.getEncoding()),
+              dstType);
+        return;
+      }
+      auto cvtOp = dyn_cast<ConvertLayoutOp>(op);
+      if (!cvtOp)
+        return;
+      auto srcType = cvtOp.getSrc().getType().cast<RankedTensorType>();
+      auto dstType = cvtOp.getType().cast<RankedTensorType>();
+      bool srcShared = srcType.getEncoding().isa<SharedEncodingAttr>();
+      bool dstShared = dstType.getEncoding().isa<SharedEncodingAttr>();
+      if (srcShared && !dstShared &&
+          !dstType.getEncoding().isa<DotOperandEncodingAttr>())
+        print("load", dstType, srcType);
+      if (!dstShared || srcShared)
+        return;
+      print("store", srcType, dstType);
+      // The buffer layout that would serve the store and the loads best
+      SmallVector<RankedTensorType> readerTypes;
+      for (Operation *user : cvtOp->getUsers())
+        if (auto readOp = dyn_cast<ConvertLayoutOp>(user))
+          readerTypes.push_back(readOp.getType().cast<RankedTensorType>());
+      auto sharedEnc = dstType.getEncoding().cast<SharedEncodingAttr>();
+      if (auto best =
+              chooseSharedEncoding(srcType, readerTypes, sharedEnc.getOrder(),
+                                   sharedEnc.getCTALayout()))
+        os << "best: vec = " << best.getVec()
+           << ", perPhase = " << best.getPerPhase()
+           << ", maxPhase = " << best.getMaxPhase() << "\n";
+    });
+  }
+};
+
+} // namespace
+
+namespace mlir {
+namespace test {
+void registerTestBankConflictsPass() {
+  PassRegistration<TestBankConflictsPass>();
+}
+} // namespace test
+} // namespace mlir
@@ -0,0 +1,53 @@
+#include "mlir/Pass/Pass.h"
+#include "triton/Analysis/CostModel.h"
+
+using namespace mlir;
+
+namespace {
+
+struct TestCostModelPass
+    : public PassWrapper<TestCostModelPass, OperationPass<ModuleOp>> {
+
+  MLIR_DEFINE_EXPLICIT_INTERNAL_INLINE_TYPE_ID(TestCostModelPass);
+
+  StringRef getArgument() const final { return "test-print-cost-model"; }
+  StringRef getDescription() const final {
+    return "print the result of the kernel cost model";
+  }
+
+  void runOnOperation() override {
+    auto &os = llvm::errs();
+    ModuleOp moduleOp = getOperation();
+    ModuleCostAnalysis costAnalysis(moduleOp);
+    moduleOp.walk([&](triton::FuncOp funcOp) {
+      auto opName = SymbolTable::getSymbolName(funcOp).getValue().str();
+      os << opName << "\n";
+      funcOp.walk([&](triton::gpu::ConvertLayoutOp cvtOp) {
+        if (auto cost = costAnalysis.getConvertLayoutCost(cvtOp))
+          os << "convert_layout: shared bytes = " << cost->sharedBytes
+             << ", bank conflicts = " << cost->bankConflicts << "\n";
+      });
+      KernelCost *cost = costAnalysis.getCost(funcOp);
+      os << "global load bytes = " << cost->globalLoadBytes
+         << ", accesses = " << cost->globalLoadAccesses << "\n";
+      os << "global store bytes = " << cost->globalStoreBytes
+         << ", accesses = " << cost->globalStoreAccesses << "\n";
+      os << "shared bytes = " << cost->sharedBytes
+         << ", max bank conflicts = " << cost->maxBankConflicts << "\n";
+      os << "mma = " << cost->mmaCount << ", dot flops = " << cost->dotFlops
+         << "\n";
+      os << "barriers = " << cost->barrierCount
+         << ", dynamic loops = " << cost->hasDynamicLoops << "\n";
+    });
+    os << "shared memory = " << costAnalysis.getSharedMemorySize()
+       << ", occupancy = " << costAnalysis.getOccupancy() << "\n";
+  }
+};
+
+} // namespace
+
+namespace mlir {
+namespace test {
+void registerTestCostModelPass() { PassRegistration<TestCostModelPass>(); }
+} // namespace test
+} // namespace mlir
@@ -5,6 +5,7 @@
 #include "mlir/Transforms/DialectConversion.h"
 #include "triton/Analysis/Allocation.h"
 #include "triton/Analysis/Membar.h"
+#include "triton/Dialect/TritonNvidiaGPU/IR/Dialect.h"
 
 using namespace mlir;
 
@@ -20,12 +21,17 @@ struct TestMembarPass
     return "print the result of the allocation pass";
   }
 
+  void getDependentDialects(DialectRegistry &registry) const override {
+    // Named barriers
+    registry.insert<triton::nvidia_gpu::TritonNvidiaGPUDialect>();
+  }
+
   void runOnOperation() override {
     Operation *operation = getOperation();
     ModuleOp moduleOp = cast<ModuleOp>(operation);
     // Print all ops after membar pass
     ModuleAllocation allocation(moduleOp);
-    ModuleMembarAnalysis membarPass(&allocation);
+    ModuleMembarAnalysis membarPass(&allocation, /*useNamedBarriers=*/true);
     membarPass.run();
   }
 };
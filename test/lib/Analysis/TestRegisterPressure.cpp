@@ -0,0 +1,42 @@
+#include "mlir/Dialect/SCF/IR/SCF.h"
+#include "mlir/Pass/Pass.h"
+#include "triton/Analysis/RegisterPressure.h"
+#include "triton/Dialect/Triton/IR/Dialect.h"
+
+using namespace mlir;
+
+namespace {
+
+struct TestRegisterPressurePass
+    : public PassWrapper<TestRegisterPressurePass, OperationPass<ModuleOp>> {
+
+  MLIR_DEFINE_EXPLICIT_INTERNAL_INLINE_TYPE_ID(TestRegisterPressurePass);
+
+  StringRef getArgument() const final { return "test-print-register-pressure"; }
+  StringRef getDescription() const final {
+    return "print the estimated register pressure of each function";
+  }
+
+  void runOnOperation() override {
+    auto &os = llvm::errs();
+    getOperation().walk([&](triton::FuncOp funcOp) {
+      RegisterPressureAnalysis pressure(funcOp);
+      os << SymbolTable::getSymbolName(funcOp).getValue()
+         << ": max registers = " << pressure.getMaxRegisters() << "\n";
+      funcOp.walk<WalkOrder::PreOrder>([&](scf::ForOp forOp) {
+        os << "loop: max registers = " << pressure.getMaxRegisters(forOp)
+           << "\n";
+      });
+    });
+  }
+};
+
+} // namespace
+
+namespace mlir {
+namespace test {
+void registerTestRegisterPressurePass() {
+  PassRegistration<TestRegisterPressurePass>();
+}
+} // namespace test
+} // namespace mlir
@@ -1,4 +1,4 @@
-from triton.backends.compiler import BaseBackend
+from triton.backends.compiler import BaseBackend, run_passes, run_with_budget, timed_pass
 from triton._C.libtriton import ir, passes, llvm, amd
 from dataclasses import dataclass
 from typing import Any
@@ -13,6 +13,8 @@ from pathlib import Path
 @dataclass(frozen=True)
 class HIPOptions:
     num_warps: int = 4
+    # the lanes of the wavefronts, 32 only on RDNA (gfx10 and later)
+    warp_size: int = 64
     waves_per_eu: int = 1
     num_stages: int = 0
     num_ctas: int = 1
@@ -21,6 +23,8 @@ class HIPOptions:
     debug: bool = False
     arch: str = None
     allow_fp8e4nv: bool = False
+    # MFMA and FMA dots don't have a batch dimension
+    allow_batched_dot: bool = False
     # TODO: deprecate when hook interface has changed
     enable_warp_specialization: bool = False
     enable_fp_fusion: bool = True
@@ -29,13 +33,34 @@ class HIPOptions:
     matrix_core_version: int = 2
     matrix_inst_shape: int = 0
     max_num_imprecise_acc_default: int = 0
+    # share the reduction loop of matmul kernels among this many programs,
+    # see the `triton-split-k` pass
+    split_k: int = 1
+    # the pointers computed from the pointer arguments stay within this many
+    # elements of them (at most 2^31), which lets their offsets be computed in
+    # 32 bits, see the `triton-narrow-offsets` pass, and the masked loads and
+    # stores go through buffer instructions. 0 if unknown
+    max_numel: int = 0
+    # how the scheduler interleaves the LDS and global accesses of the loops
+    # with their MFMAs: none, iglp0, iglp1 or interleave, see the
+    # `tritonamdgpu-insert-sched-hints` pass
+    sched_hint: str = "none"
+    # loop the programs over the tiles of the grid, visited in groups of
+    # `persistent_group_size` along x if set, see the `triton-make-persistent`
+    # pass. With `persistent_num_xcds`, e.g. the `num_xcds` of
+    # `driver.utils.get_device_properties`, the programs of each XCD of MI300
+    # take neighboring tiles, which share their operands in its L2
+    persistent: bool = False
+    persistent_group_size: int = 0
+    persistent_num_xcds: int = 1
 
     def __post_init__(self):
         default_libdir = Path(__file__).parent / 'lib'
         extern_libs = dict() if self.extern_libs is None else dict(self.extern_libs)
         libs = [
             "cuda2gcn", "opencl", "ocml", "ockl", "oclc_finite_only_off", "oclc_daz_opt_off",
-            "oclc_correctly_rounded_sqrt_on", "oclc_unsafe_math_off", "oclc_wavefrontsize64_on", "oclc_abi_version_400"
+            "oclc_correctly_rounded_sqrt_on", "oclc_unsafe_math_off",
+            "oclc_wavefrontsize64_on" if self.warp_size == 64 else "oclc_wavefrontsize64_off", "oclc_abi_version_400"
         ]
         libs += ['oclc_isa_version_' + self.arch.replace('gfx', '')]
         for lib in libs:
@@ -43,6 +68,9 @@ class HIPOptions:
         object.__setattr__(self, 'extern_libs', tuple(extern_libs.items()))
         assert self.num_warps > 0 and (self.num_warps & (self.num_warps - 1)) == 0, \
                "num_warps must be a power of 2"
+        assert self.warp_size == 64 or (self.warp_size == 32 and self.arch.startswith("gfx1")), \
+               "warp_size must be 64, or 32 on RDNA targets"
+        assert self.persistent_num_xcds >= 1, "persistent_num_xcds must be positive"
 
     def hash(self):
         key = '_'.join([f'{name}-{val}' for name, val in self.__dict__.items()])
@@ -51,6 +79,9 @@ class HIPOptions:
 
 class HIPBackend(BaseBackend):
 
+    ttir_option_names = ("split_k", "persistent", "persistent_group_size", "persistent_num_xcds", "max_numel")
+    late_option_names = ("waves_per_eu", "enable_fp_fusion", "extern_libs", "sched_hint")
+
     @staticmethod
     def supports_target(target: tuple):
         return target[0] == 'hip'
@@ -79,12 +110,26 @@ class HIPBackend(BaseBackend):
         passes.common.add_inliner(pm)
         passes.ttir.add_rewrite_tensor_pointer(pm)
         passes.ttir.add_combine(pm)
+        passes.ttir.add_narrow_offsets(pm, opt.max_numel)
         passes.common.add_canonicalizer(pm)
         passes.ttir.add_reorder_broadcast(pm)
         passes.common.add_cse(pm)
         passes.common.add_licm(pm)
+        # loop-carried pointers instead of addresses recomputed every iteration
+        passes.ttir.add_strength_reduce_pointers(pm)
+        passes.common.add_canonicalizer(pm)
+        # at most 4 clones of each noinline function
+        passes.ttir.add_specialize_calls(pm, 4)
         passes.common.add_symbol_dce(pm)
-        pm.run(mod)
+        passes.ttir.add_split_k(pm, opt.split_k)
+        if opt.persistent:
+            passes.ttir.add_make_persistent(pm, opt.persistent_group_size, opt.persistent_num_xcds)
+            passes.common.add_licm(pm)
+        run_passes(pm, mod, metadata, "ttir")
+        # the factor the launcher multiplies the grid by
+        metadata["split_k"] = mod.get_int_attr("tt.split_k") or 1
+        # whether the launcher passes the grid to the kernel
+        metadata["persistent"] = mod.get_int_attr("tt.persistent") is not None
         return mod
 
     @staticmethod
@@ -92,8 +137,8 @@ class HIPBackend(BaseBackend):
         pm = ir.pass_manager(mod.context)
         pm.enable_debug()
         # TODO: capability
-        passes.ttir.add_convert_to_ttgpuir(pm, opt.num_warps, 64, opt.num_ctas, 90)
-        pm.run(mod)
+        passes.ttir.add_convert_to_ttgpuir(pm, opt.num_warps, opt.warp_size, opt.num_ctas, 90)
+        run_passes(pm, mod, metadata, "ttgir")
         pm = ir.pass_manager(mod.context)
         pm.enable_debug()
         passes.ttgpuir.add_coalesce(pm)
@@ -102,10 +147,17 @@ class HIPBackend(BaseBackend):
         amd.passes.ttgpuir.add_remove_layout_conversions(pm)
         # amd.passes.ttgpuir.add_optimize_epilogue(pm)
         passes.ttgpuir.add_optimize_dot_operands(pm)
-        if opt.num_stages == 0 and opt.matrix_core_version != 0:
-            amd.passes.ttgpuir.add_stream_pipeline(pm)
+        if opt.arch in ("gfx940", "gfx941", "gfx942") and opt.num_stages >= 2:
+            # the async copies of the pipeliner load to LDS directly, staging
+            # the operands in LDS only
+            passes.ttgpuir.add_pipeline(pm, opt.num_stages, opt.num_warps, opt.num_ctas, 0, False)
+            amd.passes.ttgpuir.add_direct_to_lds(pm)
+        elif opt.matrix_core_version != 0 and opt.num_stages != 1:
+            # num_stages = 0 picks the two-stage stream pipeline
+            amd.passes.ttgpuir.add_stream_pipeline(pm, max(opt.num_stages, 2))
             passes.common.add_canonicalizer(pm)
-        passes.ttgpuir.add_pipeline(pm, opt.num_stages, opt.num_warps, opt.num_ctas, 0)
+        else:
+            passes.ttgpuir.add_pipeline(pm, opt.num_stages, opt.num_warps, opt.num_ctas, 0, False)
         passes.ttgpuir.add_optimize_dot_operands(pm)
         amd.passes.ttgpuir.add_remove_layout_conversions(pm)
         amd.passes.ttgpuir.add_decompose_conversions(pm)
@@ -113,7 +165,9 @@ class HIPBackend(BaseBackend):
             amd.passes.ttgpuir.add_reorder_instructions(pm)
         passes.common.add_cse(pm)
         passes.common.add_symbol_dce(pm)
-        pm.run(mod)
+        run_passes(pm, mod, metadata, "ttgir")
+        # the MFMA instructions of the dots, tuned by matrix_inst_shape
+        metadata["mfma_instrs"] = mod.get_str_array_attr("triton_gpu.mfma-instrs") or []
         return mod
 
     @staticmethod
@@ -124,21 +178,27 @@ class HIPBackend(BaseBackend):
         pm.enable_debug()
         passes.convert.add_scf_to_cf(pm)
         passes.convert.add_index_to_llvmir(pm)
-        pm.run(mod)
+        run_passes(pm, mod, metadata, "llir")
+        # the masked loads and stores within max_numel elements of the pointer
+        # arguments go through buffer instructions, bounds checked in hardware
+        if options.max_numel:
+            mod.set_attr("triton_gpu.max-numel", ir.builder(mod.context).get_int64_attr(options.max_numel))
         pm = ir.pass_manager(mod.context)
         pm.enable_debug()
         amd.passes.ttgpuir.add_to_llvmir(pm)
-        pm.run(mod)
+        run_passes(pm, mod, metadata, "llir")
         pm = ir.pass_manager(mod.context)
         passes.convert.add_scf_to_cf(pm)
         passes.convert.add_cf_to_llvmir(pm)
         passes.convert.add_arith_to_llvmir(pm)
+        if options.sched_hint != "none":
+            amd.passes.ttgpuir.add_sched_hints(pm, options.arch, options.sched_hint)
         passes.common.add_canonicalizer(pm)
         passes.common.add_cse(pm)
         passes.common.add_symbol_dce(pm)
         if os.environ.get("TRITON_DISABLE_LINE_INFO", "0") == "0":
             passes.llvmir.add_di_scope(pm)
-        pm.run(mod)
+        run_passes(pm, mod, metadata, "llir")
         # LLVM-IR (MLIR) -> LLVM-IR (LLVM)
         llvm.init_targets()
         context = llvm.context()
@@ -146,12 +206,13 @@ class HIPBackend(BaseBackend):
         if options.extern_libs:
             for name, path in options.extern_libs:
                 llvm.link_extern_lib(llvm_mod, path)
-        llvm.optimize_module(llvm_mod, llvm.OPTIMIZE_O3)
+        with timed_pass(metadata, "llir", "llvm-optimize"):
+            llvm.optimize_module(llvm_mod, llvm.OPTIMIZE_O3)
         # Set kernel attributes
         kernels = [fn for fn in llvm_mod.get_functions() if fn.has_public_visibility() and not fn.is_declaration()]
         assert len(kernels) == 1
         kernels[0].set_calling_conv(amd.CALLING_CONV_AMDGPU_KERNEL)
-        kernels[0].add_fn_attr("amdgpu-flat-work-group-size", f"1, {options.num_warps*64}")
+        kernels[0].add_fn_attr("amdgpu-flat-work-group-size", f"1, {options.num_warps*options.warp_size}")
         kernels[0].add_fn_attr("amdgpu-waves-per-eu", f"{options.waves_per_eu}")
         kernels[0].add_fn_attr("denormal-fp-math-f32", "preserve-sign")
         # Get some metadata
@@ -168,14 +229,18 @@ class HIPBackend(BaseBackend):
         assert len(names) == 1
         metadata["name"] = names[0]
         # llvm -> hsaco
-        hsaco = llvm.translate_to_asm(src, 'amdgcn-amd-amdhsa', options.arch, '', [], options.enable_fp_fusion, True)
-        import subprocess
+        # RDNA targets run either wavefront size
+        features = f"+wavefrontsize{options.warp_size}" if options.arch.startswith("gfx1") else ''
+        with timed_pass(metadata, "hsaco", "llvm-codegen"):
+            hsaco = llvm.translate_to_asm(src, 'amdgcn-amd-amdhsa', options.arch, features, [],
+                                          options.enable_fp_fusion, True)
         rocm_path = HIPBackend.path_to_rocm_lld()
         with tempfile.NamedTemporaryFile() as tmp_out:
             with tempfile.NamedTemporaryFile() as tmp_in:
                 with open(tmp_in.name, 'wb') as fd_in:
                     fd_in.write(hsaco)
-                subprocess.check_call([rocm_path, '-flavor', 'gnu', '-shared', tmp_in.name, '-o', tmp_out.name])
+                with timed_pass(metadata, "hsaco", "ld.lld"):
+                    run_with_budget([rocm_path, '-flavor', 'gnu', '-shared', tmp_in.name, '-o', tmp_out.name], "hsaco")
             with open(tmp_out.name, 'rb') as fd_out:
                 ret = fd_out.read()
         return ret
@@ -4,6 +4,7 @@
 #include <Python.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 static inline void gpuAssert(hipError_t code, const char *file, int line) {
   {
@@ -29,6 +30,22 @@ static inline void gpuAssert(hipError_t code, const char *file, int line) {
       return NULL;                                                             \
   }
 
+// Returns the number of XCDs (accelerator complex dies) of the device, the
+// chiplets that have an L2 each and get the workgroups of a dispatch
+// round-robin. The HIP runtime does not report them, but all the XCDs of a
+// gfx94x part have 38 CUs, or 20 on MI308X. A partition of a single XCD is a
+// device of its own.
+static int getNumXcds(const hipDeviceProp_t *props) {
+  if (strncmp(props->gcnArchName, "gfx94", 5) != 0)
+    return 1;
+  int numCus = props->multiProcessorCount;
+  if (numCus % 38 == 0)
+    return numCus / 38;
+  if (numCus % 20 == 0)
+    return numCus / 20;
+  return 1;
+}
+
 static PyObject *getDeviceProperties(PyObject *self, PyObject *args) {
   int device_id;
   if (!PyArg_ParseTuple(args, "i", &device_id))
@@ -38,12 +55,34 @@ static PyObject *getDeviceProperties(PyObject *self, PyObject *args) {
   HIP_CHECK(hipGetDeviceProperties(&props, device_id));
 
   // create a struct to hold device properties
-  return Py_BuildValue("{s:i, s:i, s:i, s:i, s:i, s:s}", "max_shared_mem",
-                       props.sharedMemPerBlock, "multiprocessor_count",
-                       props.multiProcessorCount, "sm_clock_rate",
-                       props.clockRate, "mem_clock_rate", props.memoryClockRate,
-                       "mem_bus_width", props.memoryBusWidth, "arch",
-                       props.gcnArchName);
+  return Py_BuildValue(
+      "{s:i, s:i, s:i, s:i, s:i, s:s, s:i, s:i}", "max_shared_mem",
+      props.sharedMemPerBlock, "multiprocessor_count",
+      props.multiProcessorCount, "sm_clock_rate", props.clockRate,
+      "mem_clock_rate", props.memoryClockRate, "mem_bus_width",
+      props.memoryBusWidth, "arch", props.gcnArchName, "warp_size",
+      props.warpSize, "num_xcds", getNumXcds(&props));
+}
+
+// Returns how many workgroups of a kernel can be resident at once on each CU,
+// and None for the number of clusters, which AMD GPUs do not have. The
+// workgroup size is the maximum the kernel was compiled for, i.e. its number
+// of warps times its wavefront size.
+static PyObject *occupancy(PyObject *self, PyObject *args) {
+  hipFunction_t func;
+  int numWarps, sharedMemory;
+  int clusterDimX, clusterDimY, clusterDimZ;
+  if (!PyArg_ParseTuple(args, "Kiiiii", &func, &numWarps, &sharedMemory,
+                        &clusterDimX, &clusterDimY, &clusterDimZ)) {
+    return NULL;
+  }
+  int blockSize;
+  HIP_CHECK(hipFuncGetAttribute(
+      &blockSize, HIP_FUNC_ATTRIBUTE_MAX_THREADS_PER_BLOCK, func));
+  int numBlocks;
+  HIP_CHECK(hipModuleOccupancyMaxActiveBlocksPerMultiprocessor(
+      &numBlocks, func, blockSize, sharedMemory));
+  return Py_BuildValue("(iO)", numBlocks, Py_None);
 }
 
 static PyObject *loadBinary(PyObject *self, PyObject *args) {
@@ -75,9 +114,14 @@ static PyObject *loadBinary(PyObject *self, PyObject *args) {
   HIP_CHECK(hipModuleLoadDataEx(&mod, data, 5, opt, optval))
   HIP_CHECK(hipModuleGetFunction(&fun, mod, name));
 
-  // get allocated registers and spilled registers from the function
+  // get allocated registers and spilled registers from the function, once per
+  // module rather than on each launch
   int n_regs = 0;
   int n_spills = 0;
+  HIP_CHECK(hipFuncGetAttribute(&n_regs, HIP_FUNC_ATTRIBUTE_NUM_REGS, fun));
+  HIP_CHECK(hipFuncGetAttribute(&n_spills, HIP_FUNC_ATTRIBUTE_LOCAL_SIZE_BYTES,
+                                fun));
+  n_spills /= 4;
   if (PyErr_Occurred()) {
     return NULL;
   }
@@ -85,11 +129,121 @@ static PyObject *loadBinary(PyObject *self, PyObject *args) {
                        n_spills);
 }
 
+static PyObject *streamBeginCapture(PyObject *self, PyObject *args) {
+  hipStream_t stream;
+  if (!PyArg_ParseTuple(args, "K", &stream)) {
+    return NULL;
+  }
+  HIP_CHECK(hipStreamBeginCapture(stream, hipStreamCaptureModeThreadLocal));
+  Py_RETURN_NONE;
+}
+
+// Ends the capture on `stream` and returns the (graph, executable graph) pair.
+static PyObject *streamEndCapture(PyObject *self, PyObject *args) {
+  hipStream_t stream;
+  if (!PyArg_ParseTuple(args, "K", &stream)) {
+    return NULL;
+  }
+  hipGraph_t graph;
+  hipGraphExec_t graphExec;
+  HIP_CHECK(hipStreamEndCapture(stream, &graph));
+  HIP_CHECK(hipGraphInstantiate(&graphExec, graph, NULL, NULL, 0));
+  return Py_BuildValue("(KK)", (uint64_t)graph, (uint64_t)graphExec);
+}
+
+// Returns the node most recently captured on `stream`, or 0 if the stream is
+// not being captured.
+static PyObject *streamGetCaptureNode(PyObject *self, PyObject *args) {
+  hipStream_t stream;
+  if (!PyArg_ParseTuple(args, "K", &stream)) {
+    return NULL;
+  }
+  hipStreamCaptureStatus status;
+  unsigned long long id;
+  hipGraph_t graph;
+  const hipGraphNode_t *deps = NULL;
+  size_t numDeps = 0;
+  HIP_CHECK(hipStreamGetCaptureInfo_v2(stream, &status, &id, &graph, &deps,
+                                       &numDeps));
+  if (status != hipStreamCaptureStatusActive || numDeps != 1)
+    return PyLong_FromUnsignedLongLong(0);
+  return PyLong_FromUnsignedLongLong((uint64_t)deps[0]);
+}
+
+static PyObject *graphLaunch(PyObject *self, PyObject *args) {
+  hipGraphExec_t graphExec;
+  hipStream_t stream;
+  if (!PyArg_ParseTuple(args, "KK", &graphExec, &stream)) {
+    return NULL;
+  }
+  HIP_CHECK(hipGraphLaunch(graphExec, stream));
+  Py_RETURN_NONE;
+}
+
+static PyObject *graphDestroy(PyObject *self, PyObject *args) {
+  hipGraph_t graph;
+  hipGraphExec_t graphExec;
+  if (!PyArg_ParseTuple(args, "KK", &graph, &graphExec)) {
+    return NULL;
+  }
+  HIP_CHECK(hipGraphExecDestroy(graphExec));
+  HIP_CHECK(hipGraphDestroy(graph));
+  Py_RETURN_NONE;
+}
+
+typedef PyObject *(*launch_t)(PyObject *self, PyObject *args);
+
+// Runs a list of `(launch_capsule, args)` pairs back to back, where
+// `launch_capsule` wraps the `launch` entry point of a launcher and `args` is
+// the tuple that would otherwise be passed to it from Python. The context of
+// the capsule, if any, is passed to the entry point as `self`.
+static PyObject *launchBatch(PyObject *self, PyObject *args) {
+  PyObject *launches;
+  if (!PyArg_ParseTuple(args, "O!", &PyList_Type, &launches)) {
+    return NULL;
+  }
+  Py_ssize_t numLaunches = PyList_GET_SIZE(launches);
+  for (Py_ssize_t i = 0; i < numLaunches; i++) {
+    PyObject *item = PyList_GET_ITEM(launches, i);
+    if (!PyTuple_Check(item) || PyTuple_GET_SIZE(item) != 2 ||
+        !PyTuple_Check(PyTuple_GET_ITEM(item, 1))) {
+      PyErr_SetString(PyExc_TypeError,
+                      "launch_batch expects a list of (launcher, args) pairs");
+      return NULL;
+    }
+    PyObject *capsule = PyTuple_GET_ITEM(item, 0);
+    launch_t launch = (launch_t)PyCapsule_GetPointer(capsule, "triton.launch");
+    if (launch == NULL)
+      return NULL;
+    PyObject *ret = launch((PyObject *)PyCapsule_GetContext(capsule),
+                           PyTuple_GET_ITEM(item, 1));
+    if (ret == NULL)
+      return NULL;
+    Py_DECREF(ret);
+  }
+  Py_RETURN_NONE;
+}
+
 static PyMethodDef ModuleMethods[] = {
     {"load_binary", loadBinary, METH_VARARGS,
      "Load provided hsaco into HIP driver"},
     {"get_device_properties", getDeviceProperties, METH_VARARGS,
      "Get the properties for a given device"},
+    {"occupancy", occupancy, METH_VARARGS,
+     "Get the number of workgroups of a kernel that can be resident at once "
+     "on a CU"},
+    {"hipStreamBeginCapture", streamBeginCapture, METH_VARARGS,
+     "Begin capturing the work submitted to a stream into a graph"},
+    {"hipStreamEndCapture", streamEndCapture, METH_VARARGS,
+     "End the capture of a stream and instantiate the captured graph"},
+    {"get_capture_node", streamGetCaptureNode, METH_VARARGS,
+     "Get the node most recently captured on a stream"},
+    {"hipGraphLaunch", graphLaunch, METH_VARARGS,
+     "Launch an instantiated graph on a stream"},
+    {"graph_destroy", graphDestroy, METH_VARARGS,
+     "Destroy a graph and its instantiation"},
+    {"launch_batch", launchBatch, METH_VARARGS,
+     "Run a list of kernel launches without returning to Python"},
     {NULL, NULL, 0, NULL} // sentinel
 };
 
@@ -5,6 +5,7 @@ from pathlib import Path
 from triton.runtime.build import _build
 from triton.runtime.cache import get_cache_manager
 from triton.backends.driver import GPUDriver
+from triton._C.libtriton import amd
 
 dirname = os.path.dirname(os.path.realpath(__file__))
 include_dir = [os.path.join(dirname, "include")]
@@ -40,6 +41,13 @@ class HIPUtils(object):
         mod = compile_module_from_src(Path(os.path.join(dirname, "driver.c")).read_text(), "hip_utils")
         self.load_binary = mod.load_binary
         self.get_device_properties = mod.get_device_properties
+        self.occupancy = mod.occupancy
+        self.hipStreamBeginCapture = mod.hipStreamBeginCapture
+        self.hipStreamEndCapture = mod.hipStreamEndCapture
+        self.get_capture_node = mod.get_capture_node
+        self.hipGraphLaunch = mod.hipGraphLaunch
+        self.graph_destroy = mod.graph_destroy
+        self.launch_batch = mod.launch_batch
 
 # -------------------- Launcher ----------------------------
 def ty_to_cpp(ty):
@@ -51,6 +59,8 @@ def ty_to_cpp(ty):
         "i16": "int16_t",
         "i32": "int32_t",
         "i64": "int64_t",
+        "u8": "uint8_t",
+        "u16": "uint16_t",
         "u32": "uint32_t",
         "u64": "uint64_t",
         "fp16": "float",
@@ -61,18 +71,58 @@ def ty_to_cpp(ty):
     }[ty]
 
 
-def make_launcher(constants, signature, ids):
+def kernel_params(constants, signature, ids):
     start_desc = len(signature)
-    #signature = generate_cu_signature(constants, signature, ids)
+    folded_without_constexprs = [c for c in ids['ids_of_folded_args'] if c not in ids['ids_of_const_exprs']]
+    params = [
+        i for i in signature.keys() if i >= start_desc or (i not in constants and i not in folded_without_constexprs)
+    ]
+    return params
+
+
+def launcher_signature(constants, signature, ids):
+    """Describes the kernel arguments of a launcher to `amd.GenericLauncher`"""
+    params = kernel_params(constants, signature, ids)
+
+    def type_code(ty):
+        if ty[0] == '*':
+            return 'p'
+        return {
+            'i1': 'i',
+            'i8': 'b',
+            'i16': 'h',
+            'i32': 'i',
+            'i64': 'l',
+            'u8': 'B',
+            'u16': 'H',
+            'u32': 'I',
+            'u64': 'K',
+            'fp16': 'f',
+            'bf16': 'f',
+            'fp32': 'f',
+            'f32': 'f',
+            'fp64': 'd',
+        }[ty]
+
+    return ''.join(type_code(ty) if i in params else 'x' for i, ty in signature.items())
+
+
+def make_launcher(constants, signature, ids, warp_size):
+    params = kernel_params(constants, signature, ids)
     arg_decls = ', '.join(f"{ty_to_cpp(ty)} arg{i}" for i, ty in signature.items())
 
     def _extracted_type(ty):
         if ty[0] == '*':
             return "PyObject*"
         return {
+            # parsed as 32-bit integers, `_launch` narrows them
             'i1': 'int32_t',
+            'i8': 'int32_t',
+            'i16': 'int32_t',
             'i32': 'int32_t',
             'i64': 'int64_t',
+            'u8': 'uint32_t',
+            'u16': 'uint32_t',
             'u32': 'uint32_t',
             'u64': 'uint64_t',
             'fp16': 'float',
@@ -97,10 +147,28 @@ def make_launcher(constants, signature, ids):
     format = "iiiiiiiiiKKOOO" + ''.join([format_of(_extracted_type(ty)) for ty in signature.values()])
 
     # generate glue code
-    folded_without_constexprs = [c for c in ids['ids_of_folded_args'] if c not in ids['ids_of_const_exprs']]
-    params = [
-        i for i in signature.keys() if i >= start_desc or (i not in constants and i not in folded_without_constexprs)
-    ]
+    # pieces shared by every entry point that parses launch arguments
+    launch_arg_decls = f"""int gridX, gridY, gridZ;
+  uint64_t _stream;
+  uint64_t _function;
+  int num_warps;
+  int num_ctas;
+  int clusterDimX;
+  int clusterDimY;
+  int clusterDimZ;
+  int shared_memory;
+  PyObject *launch_enter_hook = NULL;
+  PyObject *launch_exit_hook = NULL;
+  PyObject *compiled_kernel = NULL;
+  {' '.join([f"{_extracted_type(ty)} _arg{i}; " for i, ty in signature.items()])}"""
+    launch_arg_refs = "&gridX, &gridY, &gridZ, &num_warps, &num_ctas, &clusterDimX, &clusterDimY, &clusterDimZ, &shared_memory, &_stream, &_function, &launch_enter_hook, &launch_exit_hook, &compiled_kernel" + (
+        ', ' + ', '.join(f"&_arg{i}" for i, ty in signature.items()) if len(signature) > 0 else '')
+    ptr_info_decls = "; ".join([
+        f"DevicePtrInfo ptr_info{i} = getPointer(_arg{i}, {i}); if (!ptr_info{i}.valid) return NULL;"
+        if ty[0] == "*" else "" for i, ty in signature.items()
+    ])
+    kernel_arg_values = ', ' + ', '.join(f"ptr_info{i}.dev_ptr" if ty[0] == "*" else f"_arg{i}"
+                                         for i, ty in signature.items()) if len(signature) > 0 else ''
     src = f"""
 #define __HIP_PLATFORM_AMD__
 #include <hip/hip_runtime.h>
@@ -116,7 +184,10 @@ static inline void gpuAssert(hipError_t code, const char *file, int line)
        const char* str = hipGetErrorString(code);
       char err[1024] = {{0}};
       snprintf(err, 1024, "%s Code: %d, Messsage: %s", prefix, code, str );
+      PyGILState_STATE gil_state;
+      gil_state = PyGILState_Ensure();
       PyErr_SetString(PyExc_RuntimeError, err);
+      PyGILState_Release(gil_state);
    }}
 }}
 
@@ -126,10 +197,26 @@ static void _launch(int gridX, int gridY, int gridZ, int num_warps, int num_ctas
   // printf("_launch hip kernel\\n");
   void *params[] = {{ {', '.join(f"&arg{i}" for i in params)} }};
   if (gridX*gridY*gridZ > 0) {{
-      HIP_CHECK(hipModuleLaunchKernel(function, gridX, gridY, gridZ, 64*num_warps, 1, 1, shared_memory, stream, params, 0));
+      HIP_CHECK(hipModuleLaunchKernel(function, gridX, gridY, gridZ, {warp_size}*num_warps, 1, 1, shared_memory, stream, params, 0));
     }}
   }}
 
+static void _set_graph_node_params(hipGraphExec_t graph_exec, hipGraphNode_t node, int gridX, int gridY, int gridZ, int num_warps, int shared_memory, hipFunction_t function{', ' + arg_decls if len(arg_decls) > 0 else ''}) {{
+  void *params[] = {{ {', '.join(f"&arg{i}" for i in params)} }};
+  hipKernelNodeParams node_params = {{0}};
+  node_params.func = (void *)function;
+  node_params.gridDim.x = gridX;
+  node_params.gridDim.y = gridY;
+  node_params.gridDim.z = gridZ;
+  node_params.blockDim.x = {warp_size}*num_warps;
+  node_params.blockDim.y = 1;
+  node_params.blockDim.z = 1;
+  node_params.sharedMemBytes = shared_memory;
+  node_params.kernelParams = params;
+  // parameters are copied, so `params` may go out of scope after this call
+  HIP_CHECK(hipGraphExecKernelNodeSetParams(graph_exec, node, &node_params));
+}}
+
 typedef struct _DevicePtrInfo {{
     hipDeviceptr_t dev_ptr;
     bool valid;
@@ -177,47 +264,59 @@ static inline DevicePtrInfo getPointer(PyObject *obj, int idx) {{
 }}
 
 static PyObject* launch(PyObject* self, PyObject* args) {{
-   // printf("launch\\n");
-  int gridX, gridY, gridZ;
-  uint64_t _stream;
-  uint64_t _function;
-  int num_warps;
-  int num_ctas;
-  int clusterDimX;
-  int clusterDimY;
-  int clusterDimZ;
-  int shared_memory;
-  PyObject *launch_enter_hook = NULL;
-  PyObject *launch_exit_hook = NULL;
-  PyObject *compiled_kernel = NULL;
-  {' '.join([f"{_extracted_type(ty)} _arg{i}; " for i, ty in signature.items()])}
-  if(!PyArg_ParseTuple(args, \"{format}\", &gridX, &gridY, &gridZ, &num_warps, &num_ctas, &clusterDimX, &clusterDimY, &clusterDimZ, &shared_memory, &_stream, &_function, &launch_enter_hook, &launch_exit_hook, &compiled_kernel{', ' + ', '.join(f"&_arg{i}" for i, ty in signature.items()) if len(signature) > 0 else ''})) {{
+  {launch_arg_decls}
+  if(!PyArg_ParseTuple(args, \"{format}\", {launch_arg_refs})) {{
     return NULL;
   }}
 
-  if (launch_enter_hook != Py_None) {{
-    PyObject_CallObject(launch_enter_hook, args);
+  if (launch_enter_hook != Py_None && !PyObject_CallObject(launch_enter_hook, args)) {{
+    return NULL;
   }}
 
 
   // raise exception asap
-  {"; ".join([f"DevicePtrInfo ptr_info{i} = getPointer(_arg{i}, {i}); if (!ptr_info{i}.valid) return NULL;" if ty[0] == "*" else "" for i, ty in signature.items()])};
-  _launch(gridX, gridY, gridZ, num_warps, num_ctas, clusterDimX, clusterDimY, clusterDimZ, shared_memory, (hipStream_t)_stream, (hipFunction_t)_function{', ' + ', '.join(f"ptr_info{i}.dev_ptr" if ty[0]=="*" else f"_arg{i}"for i, ty in signature.items()) if len(signature) > 0 else ''});
-
-  if (launch_exit_hook != Py_None) {{
-    PyObject_CallObject(launch_exit_hook, args);
+  {ptr_info_decls};
+  Py_BEGIN_ALLOW_THREADS;
+  _launch(gridX, gridY, gridZ, num_warps, num_ctas, clusterDimX, clusterDimY, clusterDimZ, shared_memory, (hipStream_t)_stream, (hipFunction_t)_function{kernel_arg_values});
+  Py_END_ALLOW_THREADS;
+  if (PyErr_Occurred()) {{
+    return NULL;
   }}
 
-  if(PyErr_Occurred()) {{
+  if (launch_exit_hook != Py_None && !PyObject_CallObject(launch_exit_hook, args)) {{
     return NULL;
   }}
+
   // return None
   Py_INCREF(Py_None);
   return Py_None;
 }}
 
+// Same arguments as `launch`, prefixed with an instantiated graph and one of
+// its kernel nodes. Instead of launching, updates the parameters of the node.
+static PyObject* set_graph_node_params(PyObject* self, PyObject* args) {{
+  uint64_t _graph_exec;
+  uint64_t _node;
+  {launch_arg_decls}
+  if(!PyArg_ParseTuple(args, \"KK{format}\", &_graph_exec, &_node, {launch_arg_refs})) {{
+    return NULL;
+  }}
+
+  {ptr_info_decls};
+  Py_BEGIN_ALLOW_THREADS;
+  _set_graph_node_params((hipGraphExec_t)_graph_exec, (hipGraphNode_t)_node, gridX, gridY, gridZ, num_warps, shared_memory, (hipFunction_t)_function{kernel_arg_values});
+  Py_END_ALLOW_THREADS;
+  if (PyErr_Occurred()) {{
+    return NULL;
+  }}
+
+  Py_INCREF(Py_None);
+  return Py_None;
+}}
+
 static PyMethodDef ModuleMethods[] = {{
   {{"launch", launch, METH_VARARGS, "Entry point for all kernels with this signature"}},
+  {{"set_graph_node_params", set_graph_node_params, METH_VARARGS, "Update the kernel node of a HIP graph"}},
   {{NULL, NULL, 0, NULL}} // sentinel
 }};
 
@@ -235,6 +334,13 @@ PyMODINIT_FUNC PyInit___triton_launcher(void) {{
     return NULL;
   }}
   PyModule_AddFunctions(m, ModuleMethods);
+  // lets `hip_utils.launch_batch` call `launch` without going through Python
+  PyObject *launch_capsule = PyCapsule_New((void *)launch, "triton.launch", NULL);
+  if (launch_capsule == NULL || PyModule_AddObject(m, "launch_capsule", launch_capsule) < 0) {{
+    Py_XDECREF(launch_capsule);
+    Py_DECREF(m);
+    return NULL;
+  }}
   return m;
 }}
 """
@@ -242,19 +348,109 @@ PyMODINIT_FUNC PyInit___triton_launcher(void) {{
 
 
 class HIPLauncher(object):
-    
+
     def __init__(self, src, metadata):
         ids = {
             "ids_of_folded_args": metadata.ids_of_folded_args,
             "ids_of_const_exprs": src.fn.constexprs if hasattr(src, "fn") else tuple()
         }
         constants = src.constants if hasattr(src, "constants") else dict()
-        src = make_launcher(constants, src.signature, ids)
-        mod = compile_module_from_src(src, "__triton_launcher")
-        self.launch = mod.launch
-    
+        signature = dict(src.signature)
+        if getattr(metadata, "persistent", False):
+            # the grid of the tiles follows the kernel's arguments, see
+            # `CompiledKernel.persistent_launch`
+            first = max([*signature, *constants], default=-1) + 1
+            signature.update({first + i: 'i32' for i in range(3)})
+        warp_size = getattr(metadata, "warp_size", 64)
+        if os.environ.get("TRITON_COMPILED_LAUNCHER", "0") == "1":
+            # a C extension specialized for this signature, slightly faster to
+            # call but built with the host compiler on first use
+            src = make_launcher(constants, signature, ids, warp_size)
+            mod = compile_module_from_src(src, "__triton_launcher")
+            self.launch = mod.launch
+            self.launch_capsule = mod.launch_capsule
+            self.set_graph_node_params = mod.set_graph_node_params
+        else:
+            launcher = amd.GenericLauncher(launcher_signature(constants, signature, ids), warp_size)
+            self.launch = launcher.launch
+            self.launch_capsule = launcher.launch_capsule
+            self.set_graph_node_params = launcher.set_graph_node_params
+
     def __call__(self, *args, **kwargs):
         self.launch(*args, **kwargs)
+        if HipGraph.capturing is not None:
+            HipGraph.capturing._record(self, args)
+
+
+# -------------------- Graphs ----------------------------
+class HipGraph:
+    """
+    Records the Triton kernels launched inside a `with` block into a HIP graph
+    that can then be replayed with a single `hipGraphLaunch`:
+
+        with torch.cuda.stream(s):
+            with driver.graph() as g:
+                kernel_a[grid](x, y)
+                kernel_b[grid](y, z)
+        g.replay()
+
+    Capture must happen on a non-default stream. The arguments of each
+    recorded launch (its "slot", in launch order) can be changed after
+    capture with `update`, which only rewrites the parameters of the
+    corresponding kernel node instead of re-capturing the graph.
+    """
+
+    # the graph currently being captured, if any
+    capturing = None
+
+    def __init__(self, driver):
+        self.driver = driver
+        self.utils = driver.utils
+        self.graph = None
+        self.graph_exec = None
+        self.stream = None
+        # (launcher, kernel node, launch arguments) for each recorded launch
+        self.slots = []
+
+    def __enter__(self):
+        assert HipGraph.capturing is None, "nested graph capture is not supported"
+        assert self.graph is None, "graph has already been captured"
+        self.stream = self.driver.get_current_stream(self.driver.get_current_device())
+        self.utils.hipStreamBeginCapture(self.stream)
+        HipGraph.capturing = self
+        return self
+
+    def __exit__(self, exc_type, exc_value, traceback):
+        HipGraph.capturing = None
+        self.graph, self.graph_exec = self.utils.hipStreamEndCapture(self.stream)
+
+    def _record(self, launcher, args):
+        # args[9] is the stream the kernel was launched on
+        if args[9] != self.stream:
+            return
+        node = self.utils.get_capture_node(self.stream)
+        if node:
+            self.slots.append((launcher, node, args))
+
+    def update(self, slot, *kernel_args):
+        """
+        Replaces the kernel arguments of the `slot`-th recorded launch (i.e.,
+        its non-constexpr arguments, in order) for subsequent replays.
+        """
+        launcher, node, args = self.slots[slot]
+        assert len(kernel_args) == len(args) - 14, "wrong number of kernel arguments"
+        args = args[:14] + tuple(kernel_args)
+        launcher.set_graph_node_params(self.graph_exec, node, *args)
+        self.slots[slot] = (launcher, node, args)
+
+    def replay(self, stream=None):
+        if stream is None:
+            stream = self.driver.get_current_stream(self.driver.get_current_device())
+        self.utils.hipGraphLaunch(self.graph_exec, stream)
+
+    def __del__(self):
+        if self.graph is not None:
+            self.utils.graph_destroy(self.graph, self.graph_exec)
 
 
 class HIPDriver(GPUDriver):
@@ -273,4 +469,17 @@ class HIPDriver(GPUDriver):
     def get_current_target(self):
         device = self.get_current_device()
         arch = self.utils.get_device_properties(device)['arch']
-        return ("hip", arch.split(':')[0])
\ No newline at end of file
+        return ("hip", arch.split(':')[0])
+
+    def graph(self):
+        return HipGraph(self)
+
+    def direct_launch_capsule(self, launcher):
+        # launches must go through `HIPLauncher.__call__` to be recorded
+        return None if HipGraph.capturing is not None else launcher.launch_capsule
+
+    def launch_batch(self, launches):
+        if HipGraph.capturing is not None:
+            # launches must go through `HIPLauncher.__call__` to be recorded
+            return super().launch_batch(launches)
+        self.utils.launch_batch([(launcher.launch_capsule, args) for launcher, args in launches])
@@ -11,6 +11,10 @@ namespace triton {
 
 std::unique_ptr<Pass> createConvertTritonAMDGPUToLLVMPass();
 
+std::unique_ptr<Pass>
+createTritonAMDGPUInsertSchedHintsPass(StringRef arch = "",
+                                       StringRef variant = "none");
+
 // #define GEN_PASS_REGISTRATION
 // #include "TritonAMDGPUToLLVM/Passes.h.inc"
 
@@ -11,7 +11,7 @@ std::unique_ptr<Pass> createTritonAMDGPUPipelinePass(int numStages = 3,
                                                   int numCTAs = 1,
                                                   int computeCapability = 80);
 
-std::unique_ptr<Pass> createTritonAMDGPUStreamPipelinePass();
+std::unique_ptr<Pass> createTritonAMDGPUStreamPipelinePass(int numStages = 2);
 
 std::unique_ptr<Pass>
 createTritonAMDGPUAccelerateMatmulPass(int matrixCoreVersion=0,
@@ -27,6 +27,8 @@ std::unique_ptr<Pass> createTritonAMDGPUReorderInstructionsPass();
 
 std::unique_ptr<Pass> createTritonAMDGPUDecomposeConversionsPass();
 
+std::unique_ptr<Pass> createTritonAMDGPUDirectToLdsPass();
+
 std::unique_ptr<Pass> createTritonAMDGPURemoveLayoutConversionsPass();
 
 std::unique_ptr<Pass> createTritonAMDGPUVerifier();
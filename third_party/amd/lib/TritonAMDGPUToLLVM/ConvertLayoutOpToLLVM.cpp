@@ -1,12 +1,14 @@
 #include "ConvertLayoutOpToLLVM.h"
 #include "Utility.h"
 #include "TritonGPUToLLVMBase.h"
+#include "triton/Conversion/TritonGPUToLLVM/WarpLocalConversion.h"
 #include "triton/Dialect/TritonGPU/Transforms/Utility.h"
 #include "triton/Dialect/TritonNvidiaGPU/Transforms/Utility.h"
 
 using ::mlir::LLVM::getSharedMemoryObjectFromStruct;
 using ::mlir::LLVM::getStridesFromShapeAndOrder;
 using ::mlir::LLVM::linearize;
+using ::mlir::LLVM::AMD::shflIdxSync;
 
 using ::mlir::LLVM::getSharedMemoryObjectFromStruct;
 using ::mlir::LLVM::getStridesFromShapeAndOrder;
@@ -105,6 +107,8 @@ public:
       }
     }
     if (isaDistributedLayout(srcLayout) && isaDistributedLayout(dstLayout)) {
+      if (auto cvt = getWarpLocalConversion(srcTy, dstTy))
+        return lowerDistributedWithinWarp(op, adaptor, rewriter, *cvt);
       return lowerDistributedToDistributed(op, adaptor, rewriter);
     }
 #ifdef USE_ROCM
@@ -1098,6 +1102,33 @@ private:
   }
 #endif
 
+  // blocked/mma/slice -> blocked/mma/slice within the warps, without going
+  // through shared memory or synchronizing the CTA, see convertWithinWarp.
+  LogicalResult
+  lowerDistributedWithinWarp(triton::gpu::ConvertLayoutOp op,
+                             OpAdaptor adaptor,
+                             ConversionPatternRewriter &rewriter,
+                             const triton::WarpLocalConversion &cvt) const {
+    auto loc = op.getLoc();
+    auto dstTy = op.getResult().getType().cast<RankedTensorType>();
+    if (cvt.isNoop()) {
+      rewriter.replaceOp(op, adaptor.getSrc());
+      return success();
+    }
+    auto vals =
+        getTypeConverter()->unpackLLElements(loc, adaptor.getSrc(), rewriter);
+    auto outVals = triton::convertWithinWarp(
+        loc, rewriter, vals, cvt,
+        [&]() { return getThreadId(rewriter, loc); },
+        [&](Value val, Value srcLane) {
+          return shflIdxSync(loc, rewriter, val, srcLane);
+        });
+    Value view =
+        getTypeConverter()->packLLElements(loc, outVals, rewriter, dstTy);
+    rewriter.replaceOp(op, view);
+    return success();
+  }
+
   // mma -> mma
   LogicalResult lowerMmaToMma(triton::gpu::ConvertLayoutOp op,
                               OpAdaptor adaptor,
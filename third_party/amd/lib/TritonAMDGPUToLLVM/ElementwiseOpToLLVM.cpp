@@ -1650,6 +1650,9 @@ struct FpToFpOpConversion
                                    ConversionPatternRewriter &rewriter,
                                    Type elemTy, MultipleOperandsRange operands,
                                    Location loc) const {
+    // Stochastic rounding isn't lowered on AMD GPUs yet
+    if (op.getRbits())
+      return {};
     auto srcElementType = getElementType(op.getFrom());
     auto dstElementType = getElementType(op.getResult());
 
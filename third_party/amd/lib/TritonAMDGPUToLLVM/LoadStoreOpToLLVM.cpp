@@ -1,3 +1,4 @@
+#include "mlir/Dialect/LLVMIR/ROCDLDialect.h"
 #include "mlir/IR/Matchers.h"
 #include "mlir/IR/TypeUtilities.h"
 
@@ -41,6 +42,93 @@ static CUtensorMapDataType getCUtensorMapDataType(Type ty) {
   }
 }
 
+// The size, in bytes, of the buffers the loads and stores go through, which
+// is also the offset the masked out elements are accessed at: the loads out
+// of the buffer return 0 and the stores out of it are dropped.
+constexpr uint32_t kBufferNumRecords = 0x80000000;
+// The third word of the gfx9 buffer resources: 32-bit float data
+constexpr uint32_t kBufferFlags = (7 << 12) | (4 << 15);
+
+// Whether the elements of an integer tensor are non-negative, from the ops
+// computing it. The sums and products are assumed not to wrap, the pointers
+// they offset being out of the tensors otherwise.
+bool isNonNegative(Value value) {
+  APInt intValue;
+  if (matchPattern(value, m_ConstantInt(&intValue)))
+    return intValue.isNonNegative();
+  DenseIntElementsAttr constAttr;
+  if (matchPattern(value, m_Constant(&constAttr)))
+    return llvm::all_of(constAttr.getValues<APInt>(),
+                        [](const APInt &v) { return v.isNonNegative(); });
+  Operation *op = value.getDefiningOp();
+  if (!op)
+    return false;
+  if (isa<triton::MakeRangeOp, triton::GetProgramIdOp,
+          triton::GetNumProgramsOp, arith::ExtUIOp>(op))
+    return true;
+  if (isa<triton::SplatOp, triton::BroadcastOp, triton::ExpandDimsOp,
+          triton::ReshapeOp, triton::gpu::ConvertLayoutOp, arith::ExtSIOp,
+          arith::DivSIOp, arith::RemSIOp>(op))
+    return isNonNegative(op->getOperand(0));
+  if (isa<arith::AndIOp, arith::MaxSIOp>(op))
+    return isNonNegative(op->getOperand(0)) ||
+           isNonNegative(op->getOperand(1));
+  if (isa<arith::AddIOp, arith::MulIOp, arith::MinSIOp, arith::OrIOp>(op))
+    return isNonNegative(op->getOperand(0)) &&
+           isNonNegative(op->getOperand(1));
+  if (auto select = dyn_cast<arith::SelectOp>(op))
+    return isNonNegative(select.getTrueValue()) &&
+           isNonNegative(select.getFalseValue());
+  return false;
+}
+
+// Creates the resource descriptor of a buffer of kBufferNumRecords bytes
+// starting at `base`, with no stride.
+Value createBufferResource(ConversionPatternRewriter &rewriter, Location loc,
+                           Value base) {
+  Value addr = ptrtoint(i64_ty, base);
+  Value lo = trunc(i32_ty, addr);
+  Value hi = trunc(i32_ty, lshr(addr, int_val(64, 32)));
+  // The stride is in the high half of the second word
+  hi = and_(hi, i32_val(0xffff));
+  Type rsrcTy = vec_ty(i32_ty, 4);
+  Value rsrc = undef(rsrcTy);
+  rsrc = insert_element(rsrcTy, rsrc, lo, i32_val(0));
+  rsrc = insert_element(rsrcTy, rsrc, hi, i32_val(1));
+  rsrc = insert_element(rsrcTy, rsrc, int_val(32, kBufferNumRecords),
+                        i32_val(2));
+  return insert_element(rsrcTy, rsrc, int_val(32, kBufferFlags), i32_val(3));
+}
+
+// The integer, or vector of i32, type the buffer instructions access
+// `numBits` with.
+Type getBufferAccessType(ConversionPatternRewriter &rewriter,
+                         unsigned numBits) {
+  if (numBits <= 32)
+    return int_ty(numBits);
+  return vec_ty(i32_ty, numBits / 32);
+}
+
+// Loads a dword from `srcPtr` in each lane to LDS, at `ldsBase` plus 4 bytes
+// per lane id. The lanes of a wave share `ldsBase`.
+void createGlobalLoadLds(ConversionPatternRewriter &rewriter, Location loc,
+                         Operation *op, Value srcPtr, Value ldsBase) {
+  MLIRContext *ctx = rewriter.getContext();
+  StringRef name = "llvm.amdgcn.global.load.lds";
+  auto funcOp = dyn_cast_or_null<LLVM::LLVMFuncOp>(
+      SymbolTable::lookupNearestSymbolFrom(op, StringAttr::get(ctx, name)));
+  if (!funcOp) {
+    auto funcTy = LLVM::LLVMFunctionType::get(
+        void_ty(ctx), {srcPtr.getType(), ldsBase.getType(), i32_ty, i32_ty,
+                       i32_ty});
+    OpBuilder builder(op->getParentOfType<LLVM::LLVMFuncOp>());
+    funcOp = builder.create<LLVM::LLVMFuncOp>(loc, name, funcTy);
+  }
+  // The size, the immediate offset and the cache policy
+  call(funcOp, ValueRange{srcPtr, ldsBase, i32_val(4), i32_val(0),
+                          i32_val(0)});
+}
+
 // Contains some helper functions for both Load and Store conversions.
 struct LoadStoreConversionBase {
   explicit LoadStoreConversionBase(ModuleAxisInfoAnalysis &axisAnalysisPass)
@@ -67,6 +155,43 @@ struct LoadStoreConversionBase {
     return axisAnalysisPass.getMaskAlignment(mask);
   }
 
+  // A tensor of pointers `tt.addptr(tt.splat(base), offsets)` accessed
+  // through a buffer resource starting at `base`.
+  struct BufferAccess {
+    Value base;
+    Value offsets;
+  };
+
+  // Returns the buffer access of the pointers when the bounds checks of the
+  // buffer instructions can replace the masks: the base is an argument of the
+  // function and its 32-bit offsets are non-negative and, by the
+  // `triton_gpu.max-numel` hint of the module, within the elements of the
+  // buffer.
+  std::optional<BufferAccess> getBufferAccess(Value ptr) const {
+    auto tensorTy = ptr.getType().dyn_cast<RankedTensorType>();
+    if (!tensorTy)
+      return std::nullopt;
+    auto addPtr = ptr.getDefiningOp<triton::AddPtrOp>();
+    if (!addPtr)
+      return std::nullopt;
+    auto splat = addPtr.getPtr().getDefiningOp<triton::SplatOp>();
+    if (!splat || !splat.getSrc().isa<BlockArgument>() ||
+        !isa<FunctionOpInterface>(
+            splat.getSrc().getParentBlock()->getParentOp()))
+      return std::nullopt;
+    Value offsets = addPtr.getOffset();
+    if (!getElementTypeOrSelf(offsets.getType()).isInteger(32) ||
+        !isNonNegative(offsets))
+      return std::nullopt;
+    auto mod = ptr.getParentRegion()->getParentOfType<ModuleOp>();
+    auto maxNumel = mod->getAttrOfType<IntegerAttr>("triton_gpu.max-numel");
+    unsigned elemBits = triton::getPointeeBitWidth(tensorTy);
+    if (!maxNumel || elemBits < 8 ||
+        maxNumel.getInt() * (elemBits / 8) > int64_t(kBufferNumRecords))
+      return std::nullopt;
+    return BufferAccess{splat.getSrc(), offsets};
+  }
+
 protected:
   ModuleAxisInfoAnalysis &axisAnalysisPass;
 };
@@ -87,6 +212,10 @@ struct LoadOpConversion
   matchAndRewrite(triton::LoadOp op, OpAdaptor adaptor,
                   ConversionPatternRewriter &rewriter) const override {
     auto loc = op->getLoc();
+#ifdef USE_ROCM
+    if (auto buffer = getBufferAccess(op.getPtr()))
+      return lowerToBufferLoad(op, adaptor, *buffer, rewriter);
+#endif
 
     // original values
     Value ptr = op.getPtr();
@@ -316,6 +445,72 @@ struct LoadOpConversion
 #endif
     } // end vec
 
+    Type llvmResultStructTy = getTypeConverter()->convertType(valueTy);
+    Value resultStruct = getTypeConverter()->packLLElements(
+        loc, loadedVals, rewriter, llvmResultStructTy);
+    rewriter.replaceOp(op, {resultStruct});
+    return success();
+  }
+
+private:
+  // Loads each vector with a buffer load, the masked out ones at an offset
+  // out of the buffer, which returns 0 without the branches around the
+  // global loads. `other` is selected afterwards unless it is 0.
+  LogicalResult lowerToBufferLoad(triton::LoadOp op, OpAdaptor adaptor,
+                                  const BufferAccess &buffer,
+                                  ConversionPatternRewriter &rewriter) const {
+    Location loc = op->getLoc();
+    Value ptr = op.getPtr();
+    Value mask = op.getMask();
+    Value other = op.getOther();
+
+    Type valueTy = op.getResult().getType();
+    Type valueElemTy =
+        typeConverter->convertType(getElementTypeOrSelf(valueTy));
+    unsigned vec = getVectorSize(ptr);
+    unsigned numElems = getTotalElemsPerThread(ptr.getType());
+    if (mask)
+      vec = std::min<size_t>(vec, getMaskAlignment(mask));
+
+    SmallVector<Value> offsetElems = getTypeConverter()->unpackLLElements(
+        loc, rewriter.getRemappedValue(buffer.offsets), rewriter,
+        buffer.offsets.getType());
+    assert(offsetElems.size() == numElems);
+    SmallVector<Value> maskElems;
+    if (mask)
+      maskElems = getTypeConverter()->unpackLLElements(
+          loc, adaptor.getMask(), rewriter, mask.getType());
+    bool otherIsZero = !other || matchPattern(other, m_Zero()) ||
+                       matchPattern(other, m_PosZeroFloat());
+    SmallVector<Value> otherElems;
+    if (!otherIsZero)
+      otherElems = getTypeConverter()->unpackLLElements(
+          loc, adaptor.getOther(), rewriter, other.getType());
+
+    Value rsrc = createBufferResource(
+        rewriter, loc, rewriter.getRemappedValue(buffer.base));
+    unsigned elemBytes = triton::getPointeeBitWidth(
+                             ptr.getType().cast<RankedTensorType>()) /
+                         8;
+    Type accessTy = getBufferAccessType(rewriter, elemBytes * 8 * vec);
+    Type vecTy = vec_ty(valueElemTy, vec);
+    SmallVector<Value> loadedVals;
+    for (size_t vecStart = 0; vecStart < numElems; vecStart += vec) {
+      Value offset = mul(offsetElems[vecStart], i32_val(elemBytes));
+      if (mask)
+        offset = select(maskElems[vecStart], offset,
+                        int_val(32, kBufferNumRecords));
+      Value loaded = rewriter.create<ROCDL::RawBufferLoadOp>(
+          loc, accessTy, rsrc, offset, i32_val(0), i32_val(0));
+      loaded = bitcast(loaded, vecTy);
+      for (size_t ii = 0; ii < vec; ++ii) {
+        Value elem = extract_element(valueElemTy, loaded, i32_val(ii));
+        if (mask && !otherIsZero)
+          elem = select(maskElems[vecStart], elem, otherElems[vecStart + ii]);
+        loadedVals.push_back(elem);
+      }
+    }
+
     Type llvmResultStructTy = getTypeConverter()->convertType(valueTy);
     Value resultStruct = getTypeConverter()->packLLElements(
         loc, loadedVals, rewriter, llvmResultStructTy);
@@ -339,6 +534,10 @@ struct StoreOpConversion
   LogicalResult
   matchAndRewrite(triton::StoreOp op, OpAdaptor adaptor,
                   ConversionPatternRewriter &rewriter) const override {
+#ifdef USE_ROCM
+    if (auto buffer = getBufferAccess(op.getPtr()))
+      return lowerToBufferStore(op, adaptor, *buffer, rewriter);
+#endif
     Value ptr = op.getPtr();
     Value value = op.getValue();
 
@@ -465,6 +664,62 @@ struct StoreOpConversion
     rewriter.eraseOp(op);
     return success();
   }
+
+private:
+  // Stores each vector with a buffer store, the masked out ones, and the ones
+  // of the threads holding copies of the elements, at an offset out of the
+  // buffer, where they are dropped.
+  LogicalResult lowerToBufferStore(triton::StoreOp op, OpAdaptor adaptor,
+                                   const BufferAccess &buffer,
+                                   ConversionPatternRewriter &rewriter) const {
+    Location loc = op->getLoc();
+    Value ptr = op.getPtr();
+    Value value = op.getValue();
+    Value mask = op.getMask();
+
+    Type valueTy = value.getType();
+    Type valueElemTy =
+        typeConverter->convertType(getElementTypeOrSelf(valueTy));
+    unsigned vec = getVectorSize(ptr);
+    unsigned elemsPerThread = getTotalElemsPerThread(ptr.getType());
+    if (mask)
+      vec = std::min(vec, getMaskAlignment(mask));
+
+    SmallVector<Value> offsetElems = getTypeConverter()->unpackLLElements(
+        loc, rewriter.getRemappedValue(buffer.offsets), rewriter,
+        buffer.offsets.getType());
+    SmallVector<Value> valueElems = getTypeConverter()->unpackLLElements(
+        loc, adaptor.getValue(), rewriter, valueTy);
+    assert(offsetElems.size() == valueElems.size());
+    SmallVector<Value> maskElems;
+    if (mask)
+      maskElems = getTypeConverter()->unpackLLElements(
+          loc, adaptor.getMask(), rewriter, mask.getType());
+    Value threadMask = getMask(valueTy, rewriter, loc);
+
+    Value rsrc = createBufferResource(
+        rewriter, loc, rewriter.getRemappedValue(buffer.base));
+    unsigned elemBytes = triton::getPointeeBitWidth(
+                             ptr.getType().cast<RankedTensorType>()) /
+                         8;
+    Type accessTy = getBufferAccessType(rewriter, elemBytes * 8 * vec);
+    Type vecTy = vec_ty(valueElemTy, vec);
+    for (size_t vecStart = 0; vecStart < elemsPerThread; vecStart += vec) {
+      Value data = undef(vecTy);
+      for (size_t ii = 0; ii < vec; ++ii) {
+        Value elem = bitcast(valueElems[vecStart + ii], valueElemTy);
+        data = insert_element(vecTy, data, elem, i32_val(ii));
+      }
+      data = bitcast(data, accessTy);
+      Value pred = mask ? and_(threadMask, maskElems[vecStart]) : threadMask;
+      Value offset = mul(offsetElems[vecStart], i32_val(elemBytes));
+      offset = select(pred, offset, int_val(32, kBufferNumRecords));
+      rewriter.create<ROCDL::RawBufferStoreOp>(loc, data, rsrc, offset,
+                                               i32_val(0), i32_val(0));
+    }
+    rewriter.eraseOp(op);
+    return success();
+  }
 };
 
 namespace {
@@ -1070,6 +1325,10 @@ struct InsertSliceAsyncOpConversion
   LogicalResult
   matchAndRewrite(triton::gpu::InsertSliceAsyncOp op, OpAdaptor adaptor,
                   ConversionPatternRewriter &rewriter) const override {
+#ifdef USE_ROCM
+    // The others are decomposed before the conversion
+    return lowerToDirectToLdsLoads(op, adaptor, rewriter);
+#else
     // insert_slice_async %src, %dst, %index, %mask, %other
     auto loc = op.getLoc();
     Value src = op.getSrc();
@@ -1209,11 +1468,182 @@ struct InsertSliceAsyncOpConversion
 
     rewriter.replaceOp(op, llDst);
     return success();
+#endif
+  }
+
+private:
+  // Loads each dword of the slice to LDS directly, the lanes of a wave writing
+  // consecutive dwords, see getNumDirectToLdsLoads. In a swizzled buffer,
+  // each lane loads the element swizzled to the dword it writes. The masked
+  // out dwords are zeroed with stores to LDS instead.
+  LogicalResult
+  lowerToDirectToLdsLoads(triton::gpu::InsertSliceAsyncOp op,
+                          OpAdaptor adaptor,
+                          ConversionPatternRewriter &rewriter) const {
+    if (!getNumDirectToLdsLoads(op, axisAnalysisPass))
+      return failure();
+    Location loc = op.getLoc();
+    Value src = op.getSrc();
+    Value mask = op.getMask();
+    auto srcTy = src.getType().cast<RankedTensorType>();
+    auto dstTy = op.getDst().getType().cast<RankedTensorType>();
+    auto sharedLayout = dstTy.getEncoding().cast<SharedEncodingAttr>();
+    Type elemTy = getTypeConverter()->convertType(dstTy.getElementType());
+    unsigned elemBytes = elemTy.getIntOrFloatBitWidth() / 8;
+    unsigned elemsPerDword = 4 / elemBytes;
+
+    auto srcElems = getTypeConverter()->unpackLLElements(
+        loc, adaptor.getSrc(), rewriter, srcTy);
+    SmallVector<Value> maskElems;
+    if (mask)
+      maskElems = getTypeConverter()->unpackLLElements(
+          loc, adaptor.getMask(), rewriter, mask.getType());
+
+    // The slice starts at the index along the first dimension of the buffer
+    auto smemObj = getSharedMemoryObjectFromStruct(loc, adaptor.getDst(),
+                                                   elemTy, rewriter);
+    Value sliceOffset = mul(adaptor.getIndex(), smemObj.strides[0]);
+    Type ldsPtrTy = ptr_ty(rewriter.getContext(), 3);
+    Value sliceBase = gep(ldsPtrTy, elemTy, smemObj.base, sliceOffset);
+
+    auto mod = op->getParentOfType<ModuleOp>();
+    unsigned threadsPerWarp =
+        triton::gpu::TritonGPUDialect::getThreadsPerWarp(mod);
+    Value laneId = urem(getThreadId(rewriter, loc), i32_val(threadsPerWarp));
+    Value laneBytes = mul(laneId, i32_val(4));
+
+    ArrayRef<int64_t> shape = srcTy.getShape();
+    auto order = triton::gpu::getOrder(srcTy.getEncoding());
+    unsigned rank = shape.size();
+    Value rowPitch = i32_val(shape[order[0]]);
+    unsigned vec = sharedLayout.getVec();
+    unsigned perPhase = sharedLayout.getPerPhase();
+    unsigned maxPhase = sharedLayout.getMaxPhase();
+    auto indices = emitIndices(loc, rewriter, srcTy.getEncoding(), srcTy);
+    for (unsigned elemIdx = 0; elemIdx < srcElems.size();
+         elemIdx += elemsPerDword) {
+      Value col = indices[elemIdx][order[0]];
+      Value row = rank == 2 ? indices[elemIdx][order[1]] : i32_val(0);
+      // The offset of the dword without swizzling, which is the one the lane
+      // writes
+      Value offset = add(mul(row, rowPitch), col);
+      Value ldsPtr = gep(ldsPtrTy, elemTy, sliceBase, offset);
+      Value ldsBase = gep(ldsPtrTy, i8_ty, ldsPtr, sub(i32_val(0), laneBytes));
+      Value srcPtr = srcElems[elemIdx];
+      if (maxPhase > 1) {
+        // The swizzling is an involution within the rows
+        Value phase =
+            urem(udiv(row, i32_val(perPhase)), i32_val(maxPhase));
+        Value swizzledCol =
+            add(mul(xor_(udiv(col, i32_val(vec)), phase), i32_val(vec)),
+                urem(col, i32_val(vec)));
+        srcPtr = gep(srcPtr.getType(), elemTy, srcPtr, sub(swizzledCol, col));
+      }
+      if (!mask) {
+        createGlobalLoadLds(rewriter, loc, op, srcPtr, ldsBase);
+        continue;
+      }
+      rewriter.create<scf::IfOp>(
+          loc, maskElems[elemIdx],
+          [&](OpBuilder &builder, Location loc) {
+            createGlobalLoadLds(rewriter, loc, op, srcPtr, ldsBase);
+            builder.create<scf::YieldOp>(loc);
+          },
+          [&](OpBuilder &builder, Location loc) {
+            store(i32_val(0), ldsPtr);
+            builder.create<scf::YieldOp>(loc);
+          });
+    }
+
+    rewriter.replaceOp(op, adaptor.getDst());
+    return success();
+  }
+};
+
+// The prefetches only change the timing of the loads, they are dropped.
+struct PrefetchOpConversion
+    : public ConvertTritonGPUOpToLLVMPattern<triton::PrefetchOp> {
+  using ConvertTritonGPUOpToLLVMPattern<
+      triton::PrefetchOp>::ConvertTritonGPUOpToLLVMPattern;
+
+  LogicalResult
+  matchAndRewrite(triton::PrefetchOp op, OpAdaptor adaptor,
+                  ConversionPatternRewriter &rewriter) const override {
+    rewriter.eraseOp(op);
+    return success();
   }
 };
 } // namespace
 
 namespace AMD {
+// The loads to LDS write the dword of each lane at consecutive addresses from
+// a base common to the wave. The lanes of a warp then have to hold a dword of
+// consecutive elements each, along a row of the slice or over whole rows. A
+// swizzled buffer is written by loading, in each lane, the element swizzled to
+// its dword, which takes contiguous pointers and a mask constant over the
+// swizzling groups.
+std::optional<unsigned>
+getNumDirectToLdsLoads(triton::gpu::InsertSliceAsyncOp op,
+                       ModuleAxisInfoAnalysis &axisInfoAnalysis) {
+  auto mod = op->getParentOfType<ModuleOp>();
+  if (!mod->hasAttr("triton_gpu.direct-to-lds") ||
+      triton::gpu::TritonGPUDialect::getNumCTAs(mod) != 1)
+    return std::nullopt;
+  auto srcTy = op.getSrc().getType().cast<RankedTensorType>();
+  auto dstTy = op.getDst().getType().cast<RankedTensorType>();
+  auto blocked =
+      srcTy.getEncoding().dyn_cast<triton::gpu::BlockedEncodingAttr>();
+  auto shared = dstTy.getEncoding().dyn_cast<SharedEncodingAttr>();
+  ArrayRef<int64_t> shape = srcTy.getShape();
+  unsigned rank = shape.size();
+  if (!blocked || !shared || shared.getHasLeadingOffset() || rank > 2 ||
+      op.getAxis() != 0 || dstTy.getShape().drop_front() != shape)
+    return std::nullopt;
+  // Masked out dwords are zeroed
+  Value other = op.getOther();
+  if (other && !matchPattern(other, m_Zero()) &&
+      !matchPattern(other, m_PosZeroFloat()))
+    return std::nullopt;
+  unsigned elemBits = triton::getPointeeBitWidth(srcTy);
+  if (elemBits < 8 || elemBits > 32)
+    return std::nullopt;
+  unsigned elemsPerDword = 32 / elemBits;
+
+  auto order = blocked.getOrder();
+  if (!llvm::equal(order, shared.getOrder()))
+    return std::nullopt;
+  auto sizePerThread = blocked.getSizePerThread();
+  auto threadsPerWarp = blocked.getThreadsPerWarp();
+  auto warpsPerCTA = blocked.getWarpsPerCTA();
+  auto shapePerCTATile = triton::gpu::getShapePerCTATile(blocked, shape);
+  for (unsigned d = 0; d < rank; ++d)
+    if (shapePerCTATile[d] > shape[d])
+      return std::nullopt;
+  unsigned inner = order[0];
+  if (sizePerThread[inner] != elemsPerDword)
+    return std::nullopt;
+  if (rank == 2) {
+    unsigned outer = order[1];
+    bool withinRow = threadsPerWarp[outer] == 1;
+    bool wholeRows = sizePerThread[outer] == 1 && warpsPerCTA[inner] == 1 &&
+                     elemsPerDword * threadsPerWarp[inner] == shape[inner];
+    if (!withinRow && !wholeRows)
+      return std::nullopt;
+  }
+
+  unsigned span = elemsPerDword;
+  if (shared.getMaxPhase() > 1) {
+    if (shared.getVec() < elemsPerDword)
+      return std::nullopt;
+    span = shared.getVec() * shared.getMaxPhase();
+  }
+  if (axisInfoAnalysis.getPtrContiguity(op.getSrc()) < span)
+    return std::nullopt;
+  if (op.getMask() && axisInfoAnalysis.getMaskAlignment(op.getMask()) < span)
+    return std::nullopt;
+  return triton::gpu::getTotalElemsPerThread(srcTy) / elemsPerDword;
+}
+
 void populateLoadStoreOpToLLVMPatterns(
     TritonGPUToLLVMTypeConverter &typeConverter, RewritePatternSet &patterns,
     int numWarps, ModuleAxisInfoAnalysis &axisInfoAnalysis,
@@ -1222,6 +1652,7 @@ void populateLoadStoreOpToLLVMPatterns(
     PatternBenefit benefit) {
   patterns.add<LoadOpConversion>(typeConverter, axisInfoAnalysis, benefit);
   patterns.add<StoreOpConversion>(typeConverter, axisInfoAnalysis, benefit);
+  patterns.add<PrefetchOpConversion>(typeConverter, benefit);
   patterns.add<AtomicCASOpConversion>(typeConverter, allocation,
                                       axisInfoAnalysis, benefit);
   patterns.add<AtomicRMWOpConversion>(typeConverter, allocation,
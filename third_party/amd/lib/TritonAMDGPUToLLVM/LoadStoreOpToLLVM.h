@@ -7,6 +7,13 @@ using namespace mlir;
 using namespace mlir::triton;
 
 namespace AMD{
+// Returns the number of loads from global memory to LDS each thread issues
+// for an insert_slice_async, or std::nullopt when it is decomposed into a
+// load and an insert_slice instead.
+std::optional<unsigned>
+getNumDirectToLdsLoads(triton::gpu::InsertSliceAsyncOp op,
+                       ModuleAxisInfoAnalysis &axisInfoAnalysis);
+
 void populateLoadStoreOpToLLVMPatterns(
     TritonGPUToLLVMTypeConverter &typeConverter, RewritePatternSet &patterns,
     int numWarps, ModuleAxisInfoAnalysis &axisInfoAnalysis,
@@ -397,8 +397,10 @@ private:
       ConversionPatternRewriter &rewriter) const {
     triton::ReduceOp op = helper.getOperation();
     Location loc = op.getLoc();
+    auto mod = op.getOperation()->getParentOfType<ModuleOp>();
     Value threadId = getThreadId(rewriter, loc);
-    Value warpSize = i32_val(32);
+    Value warpSize =
+        i32_val(triton::gpu::TritonGPUDialect::getThreadsPerWarp(mod));
     Value warpId = udiv(threadId, warpSize);
     Value laneId = urem(threadId, warpSize);
     auto srcLayout = helper.getSrcLayout();
@@ -449,15 +451,15 @@ private:
     unsigned sizeInterWarps = helper.getInterWarpSizeWithUniqueData();
     Location loc = op.getLoc();
 
+    auto mod = op.getOperation()->getParentOfType<ModuleOp>();
+    unsigned iWarpSize = triton::gpu::TritonGPUDialect::getThreadsPerWarp(mod);
     Value threadId = getThreadId(rewriter, loc);
-    Value warpSize = i32_val(32);
+    Value warpSize = i32_val(iWarpSize);
     Value laneId = urem(threadId, warpSize);
     Value zero = i32_val(0);
 
-    auto mod = op.getOperation()->getParentOfType<ModuleOp>();
     unsigned numThreads =
-        product<unsigned>(triton::gpu::getWarpsPerCTA(srcLayout)) *
-        triton::gpu::TritonGPUDialect::getThreadsPerWarp(mod);
+        product<unsigned>(triton::gpu::getWarpsPerCTA(srcLayout)) * iWarpSize;
     unsigned elemsPerThread = std::max<unsigned>(elems / numThreads, 1);
     Value threadIsNeeded = icmp_slt(threadId, i32_val(elems));
     Value readOffset = threadId;
@@ -7,6 +7,8 @@ using namespace mlir::triton;
 
 using ::mlir::LLVM::delinearize;
 using ::mlir::LLVM::linearize;
+using ::mlir::LLVM::AMD::dppRowBcastSync;
+using ::mlir::LLVM::AMD::dppShflUpSync;
 using ::mlir::LLVM::AMD::shflIdxSync;
 using ::mlir::LLVM::AMD::shflUpSync;
 using ::mlir::LLVM::AMD::storeShared;
@@ -71,6 +73,17 @@ static void warpScan(SmallVector<Value> &srcValues,
   unsigned elementStride = helper.getAxisElementStride();
   unsigned threadStride = helper.getAxisThreadStride();
   unsigned scanDim = helper.getAxisNumThreadsPerWarpWithUniqueData();
+  unsigned axisNumLanes =
+      triton::gpu::getThreadsPerWarp(helper.getEncoding())[helper.getAxis()];
+  auto mod = rewriter.getBlock()->getParentOp()->getParentOfType<ModuleOp>();
+  unsigned warpSize = triton::gpu::TritonGPUDialect::getThreadsPerWarp(mod);
+  // The lanes of a scan within a row of 16 lanes shift their values with DPP
+  // rather than through the LDS crossbar. The scans over whole rows of 64-wide
+  // waves scan the rows first, then broadcast the last lane of the rows to the
+  // next ones.
+  bool withinRows = axisNumLanes * threadStride <= 16;
+  bool overRows = warpSize == 64 && threadStride == 1 &&
+                  axisNumLanes == scanDim && (scanDim == 32 || scanDim == 64);
   for (unsigned srcIndex = 0; srcIndex < srcValues.size(); srcIndex++) {
     unsigned elementIdx = (srcIndex / elementStride) % scanElementsPerThreads;
     // Only consider the last element of each contiguous chunk of elements.
@@ -78,8 +91,27 @@ static void warpScan(SmallVector<Value> &srcValues,
       continue;
     // Reduce within warps.
     Value acc = srcValues[srcIndex];
+    if (overRows) {
+      Value laneIdRow = urem(laneIdAxis, i32_val(16));
+      for (unsigned i = 1; i < 16; i = i << 1) {
+        Value shfl = dppShflUpSync(loc, rewriter, acc, i);
+        Value tempAcc = accumulate(rewriter, helper.getCombineOp(), shfl, acc);
+        Value mask = icmp_slt(laneIdRow, i32_val(i));
+        acc = select(mask, acc, tempAcc);
+      }
+      for (unsigned rows = 1; rows < scanDim / 16; rows = rows << 1) {
+        Value shfl = dppRowBcastSync(loc, rewriter, acc, rows);
+        Value tempAcc = accumulate(rewriter, helper.getCombineOp(), shfl, acc);
+        Value mask = icmp_ne(and_(laneIdAxis, i32_val(16 * rows)), i32_val(0));
+        acc = select(mask, tempAcc, acc);
+      }
+      srcValues[srcIndex] = acc;
+      continue;
+    }
     for (unsigned i = 1; i <= (scanDim) / 2; i = i << 1) {
-      Value shfl = shflUpSync(loc, rewriter, acc, i * threadStride);
+      Value shfl = withinRows
+                       ? dppShflUpSync(loc, rewriter, acc, i * threadStride)
+                       : shflUpSync(loc, rewriter, acc, i * threadStride);
       Value tempAcc = accumulate(rewriter, helper.getCombineOp(), shfl, acc);
       Value mask = icmp_slt(laneIdAxis, i32_val(i));
       acc = select(mask, acc, tempAcc);
@@ -0,0 +1,188 @@
+#include "TritonAMDGPUToLLVM/Passes.h"
+#include "mlir/Dialect/LLVMIR/LLVMDialect.h"
+#include "mlir/IR/Builders.h"
+#include "mlir/Pass/Pass.h"
+#include "llvm/ADT/SmallPtrSet.h"
+
+namespace mlir {
+namespace triton {
+#define GEN_PASS_DECL_TRITONAMDGPUINSERTSCHEDHINTS
+#define GEN_PASS_DEF_TRITONAMDGPUINSERTSCHEDHINTS
+#include "TritonAMDGPUToLLVM/Passes.h.inc"
+} // namespace triton
+} // namespace mlir
+
+//===----------------------------------------------------------------------===//
+// This pass asks the AMDGPU scheduler to interleave the memory accesses of the
+// loops of the kernel with their MFMAs, on the LLVM dialect lowered from the
+// pipelined loops. The scheduler otherwise tends to issue the LDS reads of an
+// iteration ahead of its first MFMA, and the MFMAs wait for all of them.
+//===----------------------------------------------------------------------===//
+
+using namespace mlir;
+
+namespace {
+
+// The masks of the instruction classes of llvm.amdgcn.sched.group.barrier
+enum SchedGroupMask : int32_t {
+  kSchedMfma = 0x008,
+  kSchedVmemRead = 0x020,
+  kSchedDsRead = 0x100,
+  kSchedDsWrite = 0x200,
+};
+
+// The memory accesses each MFMA of the loops of an architecture hides. The
+// MFMAs of gfx90a take about twice the cycles of the ones of gfx94x.
+struct SchedPattern {
+  unsigned dsReadsPerMfma;
+  unsigned dsWritesPerMfma;
+  unsigned vmemReadsPerMfma;
+};
+
+SchedPattern getSchedPattern(StringRef arch) {
+  if (arch == "gfx90a")
+    return {2, 1, 1};
+  return {1, 1, 1};
+}
+
+struct LoopAccesses {
+  unsigned numMfmas = 0;
+  unsigned numDsReads = 0;
+  unsigned numDsWrites = 0;
+  unsigned numVmemReads = 0;
+};
+
+unsigned getAddressSpace(Value ptr) {
+  if (auto ptrTy = ptr.getType().dyn_cast<LLVM::LLVMPointerType>())
+    return ptrTy.getAddressSpace();
+  return 0;
+}
+
+LoopAccesses countAccesses(Block &block) {
+  LoopAccesses accesses;
+  for (Operation &op : block) {
+    StringRef opName = op.getName().getStringRef();
+    if (opName.starts_with("rocdl.mfma.")) {
+      ++accesses.numMfmas;
+    } else if (auto load = dyn_cast<LLVM::LoadOp>(op)) {
+      unsigned addrSpace = getAddressSpace(load.getAddr());
+      if (addrSpace == 3)
+        ++accesses.numDsReads;
+      else if (addrSpace == 1)
+        ++accesses.numVmemReads;
+    } else if (auto store = dyn_cast<LLVM::StoreOp>(op)) {
+      if (getAddressSpace(store.getAddr()) == 3)
+        ++accesses.numDsWrites;
+    } else if (opName.starts_with("rocdl.raw.buffer.load")) {
+      ++accesses.numVmemReads;
+    } else if (auto callOp = dyn_cast<LLVM::CallOp>(op)) {
+      if (callOp.getCallee() == "llvm.amdgcn.global.load.lds")
+        ++accesses.numVmemReads;
+    }
+  }
+  return accesses;
+}
+
+// Whether the block is part of a loop of its function
+bool isInLoop(Block *block) {
+  SmallVector<Block *> worklist(block->getSuccessors());
+  llvm::SmallPtrSet<Block *, 8> visited;
+  while (!worklist.empty()) {
+    Block *succ = worklist.pop_back_val();
+    if (succ == block)
+      return true;
+    if (!visited.insert(succ).second)
+      continue;
+    worklist.append(succ->succ_begin(), succ->succ_end());
+  }
+  return false;
+}
+
+void createIntrinsicCall(OpBuilder &builder, Location loc, ModuleOp mod,
+                         StringRef name, ArrayRef<int32_t> args) {
+  MLIRContext *ctx = builder.getContext();
+  auto i32Ty = IntegerType::get(ctx, 32);
+  auto funcOp = mod.lookupSymbol<LLVM::LLVMFuncOp>(name);
+  if (!funcOp) {
+    OpBuilder::InsertionGuard guard(builder);
+    builder.setInsertionPointToStart(mod.getBody());
+    auto funcTy = LLVM::LLVMFunctionType::get(
+        LLVM::LLVMVoidType::get(ctx), SmallVector<Type>(args.size(), i32Ty));
+    funcOp = builder.create<LLVM::LLVMFuncOp>(loc, name, funcTy);
+  }
+  SmallVector<Value> operands;
+  for (int32_t arg : args)
+    operands.push_back(builder.create<LLVM::ConstantOp>(
+        loc, i32Ty, builder.getI32IntegerAttr(arg)));
+  builder.create<LLVM::CallOp>(loc, funcOp, operands);
+}
+
+// Emits the groups of one MFMA followed by the accesses the pattern hides
+// behind it, for as long as the block has MFMAs and accesses left.
+void interleave(OpBuilder &builder, Location loc, ModuleOp mod,
+                LoopAccesses accesses, const SchedPattern &pattern) {
+  StringRef name = "llvm.amdgcn.sched.group.barrier";
+  auto addGroup = [&](int32_t mask, unsigned &left, unsigned perMfma) {
+    unsigned size = std::min(left, perMfma);
+    if (size == 0)
+      return;
+    createIntrinsicCall(builder, loc, mod, name, {mask, (int32_t)size, 0});
+    left -= size;
+  };
+  while (accesses.numMfmas > 0) {
+    createIntrinsicCall(builder, loc, mod, name, {kSchedMfma, 1, 0});
+    --accesses.numMfmas;
+    addGroup(kSchedDsRead, accesses.numDsReads, pattern.dsReadsPerMfma);
+    addGroup(kSchedDsWrite, accesses.numDsWrites, pattern.dsWritesPerMfma);
+    addGroup(kSchedVmemRead, accesses.numVmemReads, pattern.vmemReadsPerMfma);
+  }
+}
+
+} // namespace
+
+class TritonAMDGPUInsertSchedHintsPass
+    : public mlir::triton::impl::TritonAMDGPUInsertSchedHintsBase<
+          TritonAMDGPUInsertSchedHintsPass> {
+public:
+  TritonAMDGPUInsertSchedHintsPass() = default;
+  TritonAMDGPUInsertSchedHintsPass(StringRef arch, StringRef variant) {
+    this->arch = arch.str();
+    this->variant = variant.str();
+  }
+
+  void runOnOperation() override {
+    ModuleOp mod = getOperation();
+    if (variant == "none")
+      return;
+    if (variant != "iglp0" && variant != "iglp1" && variant != "interleave") {
+      mod.emitError("unknown scheduling hint variant ") << variant;
+      return signalPassFailure();
+    }
+    SchedPattern pattern = getSchedPattern(arch);
+    SmallVector<Block *> loops;
+    mod.walk([&](LLVM::LLVMFuncOp func) {
+      for (Block &block : func.getBody())
+        if (isInLoop(&block) && countAccesses(block).numMfmas > 0)
+          loops.push_back(&block);
+    });
+    OpBuilder builder(mod.getContext());
+    for (Block *block : loops) {
+      Location loc = block->getTerminator()->getLoc();
+      if (variant == "interleave") {
+        // The groups apply to the scheduling region before them
+        builder.setInsertionPoint(block->getTerminator());
+        interleave(builder, loc, mod, countAccesses(*block), pattern);
+      } else {
+        builder.setInsertionPointToStart(block);
+        createIntrinsicCall(builder, loc, mod, "llvm.amdgcn.iglp.opt",
+                            {variant == "iglp0" ? 0 : 1});
+      }
+    }
+  }
+};
+
+std::unique_ptr<Pass>
+mlir::triton::createTritonAMDGPUInsertSchedHintsPass(StringRef arch,
+                                                     StringRef variant) {
+  return std::make_unique<TritonAMDGPUInsertSchedHintsPass>(arch, variant);
+}
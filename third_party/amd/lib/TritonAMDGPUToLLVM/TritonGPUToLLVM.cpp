@@ -822,6 +822,15 @@ struct AsyncWaitOpConversion
   LogicalResult
   matchAndRewrite(triton::gpu::AsyncWaitOp op, OpAdaptor adaptor,
                   ConversionPatternRewriter &rewriter) const override {
+#ifdef USE_ROCM
+    // The wait is for all but `num` loads to LDS, see countAsyncWaitLoads,
+    // with the 6-bit counter of the memory instructions of gfx9
+    auto num = std::min<int64_t>(op.getNum(), 63);
+    GCNBuilder gcnBuilder;
+    gcnBuilder.create<>("s_waitcnt vmcnt(" + std::to_string(num) + ")")
+        ->operator()();
+    gcnBuilder.launch(rewriter, op.getLoc(), void_ty(op.getContext()));
+#else
     PTXBuilder ptxBuilder;
     auto &asyncWaitOp = *ptxBuilder.create<>("cp.async.wait_group");
     auto num = op->getAttrOfType<IntegerAttr>("num").getInt();
@@ -831,6 +840,7 @@ struct AsyncWaitOpConversion
     auto loc = op.getLoc();
     auto voidTy = void_ty(ctx);
     ptxBuilder.launch(rewriter, loc, voidTy);
+#endif
 
     // Safe to remove the op since it doesn't have any return value.
     rewriter.eraseOp(op);
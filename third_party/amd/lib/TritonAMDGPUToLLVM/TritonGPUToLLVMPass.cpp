@@ -869,7 +869,42 @@ private:
     });
   }
 
+  // The loads to LDS are waited on with the counter of the memory
+  // instructions, so the waits are translated from groups of async copies to
+  // loads: a wait for all but the `num` last groups waits for all but the
+  // loads they issue. The waits are for all the loads unless the groups all
+  // issue as many loads. The other memory instructions issued since then are
+  // only waited on longer, the counter decreasing in order.
+  void countAsyncWaitLoads(ModuleOp mod,
+                           ModuleAxisInfoAnalysis &axisInfoAnalysis) const {
+    std::optional<unsigned> groupLoads;
+    bool sameGroupLoads = true;
+    mod.walk([&](Block *block) {
+      unsigned loads = 0;
+      for (Operation &op : *block) {
+        if (auto insertOp = dyn_cast<triton::gpu::InsertSliceAsyncOp>(op)) {
+          loads += *AMD::getNumDirectToLdsLoads(insertOp, axisInfoAnalysis);
+        } else if (isa<triton::gpu::AsyncCommitGroupOp>(op)) {
+          if (groupLoads && *groupLoads != loads)
+            sameGroupLoads = false;
+          groupLoads = loads;
+          loads = 0;
+        }
+      }
+    });
+    unsigned loadsPerGroup = sameGroupLoads && groupLoads ? *groupLoads : 0;
+    mod.walk([&](triton::gpu::AsyncWaitOp waitOp) {
+      waitOp.setNum(waitOp.getNum() * loadsPerGroup);
+    });
+  }
+
   void decomposeInsertSliceAsyncOp(ModuleOp mod) const {
+    // Don't run the axis info analysis over the whole module for nothing
+    if (!mod.walk([](triton::gpu::InsertSliceAsyncOp) {
+              return WalkResult::interrupt();
+            })
+             .wasInterrupted())
+      return;
     ModuleAxisInfoAnalysis axisInfoAnalysis(mod);
     // TODO(Keren): This is a hacky knob that may cause performance regression
     // when decomposition has been performed. We should remove this knob once we
@@ -921,7 +956,10 @@ private:
 
       // If the load byte width is not eligible or the current compute
       // capability does not support async copy, then we do decompose
-#ifndef USE_ROCM
+#ifdef USE_ROCM
+      if (AMD::getNumDirectToLdsLoads(insertSliceAsyncOp, axisInfoAnalysis))
+        return;
+#else
       if (triton::gpu::InsertSliceAsyncOp::getEligibleLoadByteWidth(
               computeCapability)
               .contains(byteWidth)) {
@@ -963,6 +1001,14 @@ private:
       decomposed = true;
     });
 
+#ifdef USE_ROCM
+    bool hasDirectToLdsLoads =
+        mod.walk([](triton::gpu::InsertSliceAsyncOp) {
+             return WalkResult::interrupt();
+           })
+            .wasInterrupted();
+    countAsyncWaitLoads(mod, axisInfoAnalysis);
+#endif
     mod.walk([&](triton::gpu::AsyncCommitGroupOp asyncCommitGroupOp) -> void {
 #ifdef USE_ROCM
       asyncCommitGroupOp.erase();
@@ -974,8 +1020,10 @@ private:
 
     mod.walk([&](triton::gpu::AsyncWaitOp asyncWaitOp) -> void {
 #ifdef USE_ROCM
-      // AsyncWait is not supported for ROCM and should be removed
-      asyncWaitOp.erase();
+      // Without loads to LDS left, the waits are for plain loads, which are
+      // waited on where their results are used
+      if (!hasDirectToLdsLoads)
+        asyncWaitOp.erase();
 #else
       if (!triton::gpu::AsyncWaitOp::isSupported(computeCapability)) {
         // async wait is supported in Ampere and later
@@ -54,6 +54,75 @@ Value loadShared(ConversionPatternRewriter &rewriter, Location loc, Value ptr,
 #endif
 }
 
+#ifdef USE_ROCM
+// The DPP controls of gfx9 moving the dword of each lane from another lane of
+// its row of 16 lanes, or from the last lane of the previous rows
+enum DppCtrl : uint32_t {
+  kDppQuadPerm = 0x000,
+  kDppRowShr = 0x110,
+  kDppRowRor = 0x120,
+  kDppRowHalfMirror = 0x141,
+  kDppRowBcast15 = 0x142,
+  kDppRowBcast31 = 0x143,
+};
+
+// Lanes without a source, or out of the rows of rowMask, keep their own value.
+static Value dppMov(Location loc, ConversionPatternRewriter &rewriter,
+                    Value val, uint32_t ctrl, uint32_t rowMask = 0xf) {
+  auto valType = val.getType();
+  unsigned bits = valType.getIntOrFloatBitWidth();
+  if (bits == 64) {
+    Type vecTy = vec_ty(i32_ty, 2);
+    Value vec = bitcast(val, vecTy);
+    Value val0 = extract_element(i32_ty, vec, i32_val(0));
+    Value val1 = extract_element(i32_ty, vec, i32_val(1));
+    val0 = dppMov(loc, rewriter, val0, ctrl, rowMask);
+    val1 = dppMov(loc, rewriter, val1, ctrl, rowMask);
+    vec = undef(vecTy);
+    vec = insert_element(vecTy, vec, val0, i32_val(0));
+    vec = insert_element(vecTy, vec, val1, i32_val(1));
+    return bitcast(vec, valType);
+  }
+  if (!valType.isInteger(32)) {
+    Value dword = val;
+    if (!valType.isIntOrIndex())
+      dword = bitcast(dword, int_ty(bits));
+    if (bits < 32)
+      dword = zext(i32_ty, dword);
+    dword = dppMov(loc, rewriter, dword, ctrl, rowMask);
+    if (bits < 32)
+      dword = trunc(int_ty(bits), dword);
+    if (!valType.isIntOrIndex())
+      dword = bitcast(dword, valType);
+    return dword;
+  }
+  return rewriter.create<ROCDL::DPPUpdateOp>(loc, i32_ty, val, val, ctrl,
+                                             rowMask, /*bankMask=*/0xf,
+                                             /*boundCtrl=*/false);
+}
+
+// The butterfly shuffles within the rows don't go through the LDS crossbar.
+// The quad permutations swap the lanes of strides 1 and 2, the rotation of
+// the rows swaps their halves and the mirror of the half rows, followed by
+// the reversal of the quads, swaps the quads of stride 4.
+static Value dppBflySync(Location loc, ConversionPatternRewriter &rewriter,
+                         Value val, int strideInt) {
+  switch (strideInt) {
+  case 1:
+    return dppMov(loc, rewriter, val, kDppQuadPerm | 0xb1);
+  case 2:
+    return dppMov(loc, rewriter, val, kDppQuadPerm | 0x4e);
+  case 4:
+    val = dppMov(loc, rewriter, val, kDppRowHalfMirror);
+    return dppMov(loc, rewriter, val, kDppQuadPerm | 0x1b);
+  case 8:
+    return dppMov(loc, rewriter, val, kDppRowRor | 8);
+  default:
+    llvm_unreachable("Unsupported DPP butterfly stride");
+  }
+}
+#endif
+
 static Value commonShflSync(Location loc, ConversionPatternRewriter &rewriter,
                             Value val, Value i, int strideInt, NVVM::ShflKind mode,
                             Value clamp) {
@@ -110,6 +179,8 @@ static Value commonShflSync(Location loc, ConversionPatternRewriter &rewriter,
 
   switch (mode) {
   case NVVM::ShflKind::bfly:
+    if (strideInt <= 8)
+      return dppBflySync(loc, rewriter, val, strideInt);
     if (strideInt > 16) {
       Value threadId =
           rewriter
@@ -177,6 +248,22 @@ Value shflUpSync(Location loc, ConversionPatternRewriter &rewriter, Value val,
 		  i32_val(0x0));
 }
 
+#ifdef USE_ROCM
+Value dppShflUpSync(Location loc, ConversionPatternRewriter &rewriter,
+                    Value val, int i) {
+  assert(i > 0 && i < 16 && "Row shifts move values within rows of 16 lanes");
+  return dppMov(loc, rewriter, val, kDppRowShr | i);
+}
+
+Value dppRowBcastSync(Location loc, ConversionPatternRewriter &rewriter,
+                      Value val, int rows) {
+  assert((rows == 1 || rows == 2) && "Unsupported DPP row broadcast");
+  if (rows == 1)
+    return dppMov(loc, rewriter, val, kDppRowBcast15, /*rowMask=*/0xa);
+  return dppMov(loc, rewriter, val, kDppRowBcast31, /*rowMask=*/0xc);
+}
+#endif
+
 Value shflIdxSync(Location loc, ConversionPatternRewriter &rewriter, Value val,
                   int i) {
   return shflIdxSync(loc, rewriter, val, i32_val(i));
@@ -343,6 +343,18 @@ Value shflIdxSync(Location loc, ConversionPatternRewriter &rewriter, Value val,
                   int i);
 Value shflIdxSync(Location loc, ConversionPatternRewriter &rewriter, Value val,
                   Value i);
+#ifdef USE_ROCM
+/// Returns the value of lane - i of the row of 16 lanes of each lane, or the
+/// value of the lane itself for the first i lanes of the row.
+Value dppShflUpSync(Location loc, ConversionPatternRewriter &rewriter,
+                    Value val, int i);
+/// Broadcasts the last lane of the groups of \p rows rows of 16 lanes to the
+/// lanes of the next group: for 1, lane 15 to the second row and lane 47 to
+/// the fourth, for 2, lane 31 to the last two rows. The other lanes keep their
+/// own value.
+Value dppRowBcastSync(Location loc, ConversionPatternRewriter &rewriter,
+                      Value val, int rows);
+#endif
 }
 
 Value getSRegValue(OpBuilder &b, Location loc, const std::string &sRegStr);
@@ -1,4 +1,5 @@
 #include "ViewOpToLLVM.h"
+#include "triton/Dialect/TritonGPU/IR/LinearLayoutConversions.h"
 
 using namespace mlir;
 using namespace mlir::triton;
@@ -185,6 +186,85 @@ struct InterleaveOpConversion
   }
 };
 
+struct JoinOpConversion : public ConvertTritonGPUOpToLLVMPattern<JoinOp> {
+  using OpAdaptor = typename JoinOp::Adaptor;
+
+  explicit JoinOpConversion(TritonGPUToLLVMTypeConverter &typeConverter,
+                            PatternBenefit benefit = 1)
+      : ConvertTritonGPUOpToLLVMPattern<JoinOp>(typeConverter, benefit) {}
+
+  LogicalResult
+  matchAndRewrite(JoinOp op, OpAdaptor adaptor,
+                  ConversionPatternRewriter &rewriter) const override {
+    // We rely on the following invariants of this op (which are checked by
+    // its type inference):
+    //
+    // - The op has a blocked encoding.
+    // - The new dimension is the most minor one, with 2 elements per thread
+    //   and a single thread and warp.
+    // - The other dimensions of the result encoding are those of the input
+    //   encoding.
+    //
+    // With these invariants, join is trivial: We just return the i'th element
+    // from lhs, followed by the i'th elem from rhs.
+    Location loc = op->getLoc();
+    auto resultTy = op.getType().cast<RankedTensorType>();
+
+    SmallVector<Value> lhsVals = getTypeConverter()->unpackLLElements(
+        loc, adaptor.getLhs(), rewriter, op.getLhs().getType());
+    SmallVector<Value> rhsVals = getTypeConverter()->unpackLLElements(
+        loc, adaptor.getRhs(), rewriter, op.getRhs().getType());
+    assert(lhsVals.size() == rhsVals.size());
+
+    SmallVector<Value> joinedVals;
+    for (int i = 0; i < lhsVals.size(); i++) {
+      joinedVals.push_back(lhsVals[i]);
+      joinedVals.push_back(rhsVals[i]);
+    }
+
+    Value ret = getTypeConverter()->packLLElements(loc, joinedVals, rewriter,
+                                                   resultTy);
+    rewriter.replaceOp(op, ret);
+    return success();
+  }
+};
+
+struct SplitOpConversion : public ConvertTritonGPUOpToLLVMPattern<SplitOp> {
+  using OpAdaptor = typename SplitOp::Adaptor;
+
+  explicit SplitOpConversion(TritonGPUToLLVMTypeConverter &typeConverter,
+                             PatternBenefit benefit = 1)
+      : ConvertTritonGPUOpToLLVMPattern<SplitOp>(typeConverter, benefit) {}
+
+  LogicalResult
+  matchAndRewrite(SplitOp op, OpAdaptor adaptor,
+                  ConversionPatternRewriter &rewriter) const override {
+    // The inverse of join: the elements of the last dimension of the input
+    // are adjacent in the registers of each thread, so the even elements go
+    // to the lhs and the odd ones to the rhs.
+    Location loc = op->getLoc();
+    auto resultTy = op.getOutLHS().getType().cast<RankedTensorType>();
+
+    SmallVector<Value> srcVals = getTypeConverter()->unpackLLElements(
+        loc, adaptor.getSrc(), rewriter, op.getSrc().getType());
+    assert(srcVals.size() % 2 == 0);
+
+    SmallVector<Value> outLhsVals;
+    SmallVector<Value> outRhsVals;
+    for (int i = 0; i < srcVals.size(); i += 2) {
+      outLhsVals.push_back(srcVals[i]);
+      outRhsVals.push_back(srcVals[i + 1]);
+    }
+
+    Value outLhs = getTypeConverter()->packLLElements(loc, outLhsVals,
+                                                      rewriter, resultTy);
+    Value outRhs = getTypeConverter()->packLLElements(loc, outRhsVals,
+                                                      rewriter, resultTy);
+    rewriter.replaceOp(op, {outLhs, outRhs});
+    return success();
+  }
+};
+
 struct ReshapeOpConversion : public ConvertTritonGPUOpToLLVMPattern<ReshapeOp> {
   using OpAdaptor = typename ReshapeOp::Adaptor;
   explicit ReshapeOpConversion(TritonGPUToLLVMTypeConverter &typeConverter,
@@ -200,8 +280,9 @@ struct ReshapeOpConversion : public ConvertTritonGPUOpToLLVMPattern<ReshapeOp> {
            "expensive view not supported");
     auto resultTy = op.getType().template cast<RankedTensorType>();
     auto srcTy = op.getSrc().getType().template cast<RankedTensorType>();
-    if (!op.getAllowReorder()) {
-      // Only support trivial block layouts for now.
+    if (!op.getAllowReorder() &&
+        !triton::gpu::isReshapeRename(srcTy, resultTy)) {
+      // Only support trivial block layouts or renames for now.
       auto mod = op->getParentOfType<ModuleOp>();
       int numWarps = triton::gpu::TritonGPUDialect::getNumWarps(mod);
       int threadsPerWarp =
@@ -278,6 +359,16 @@ struct TransOpConversion
   matchAndRewrite(triton::TransOp op, OpAdaptor adaptor,
                   ConversionPatternRewriter &rewriter) const override {
     Location loc = op->getLoc();
+    // A transpose of a blocked layout is a rename of the values
+    auto resultTy = op.getType().cast<RankedTensorType>();
+    if (resultTy.getEncoding().isa<BlockedEncodingAttr>()) {
+      auto vals = getTypeConverter()->unpackLLElements(
+          loc, adaptor.getSrc(), rewriter, op.getOperand().getType());
+      Value ret =
+          getTypeConverter()->packLLElements(loc, vals, rewriter, resultTy);
+      rewriter.replaceOp(op, ret);
+      return success();
+    }
     auto llvmElemTy = getTypeConverter()->convertType(
         op.getType().cast<RankedTensorType>().getElementType());
     auto srcSmemObj = getSharedMemoryObjectFromStruct(loc, adaptor.getSrc(),
@@ -307,6 +398,8 @@ void populateViewOpToLLVMPatterns(TritonGPUToLLVMTypeConverter &typeConverter,
   patterns.add<ArithConstantSplatOpConversion>(typeConverter, benefit);
   patterns.add<CatOpConversion>(typeConverter, benefit);
   patterns.add<InterleaveOpConversion>(typeConverter, benefit);
+  patterns.add<JoinOpConversion>(typeConverter, benefit);
+  patterns.add<SplitOpConversion>(typeConverter, benefit);
   patterns.add<TransOpConversion>(typeConverter, benefit);
 }
 }
\ No newline at end of file
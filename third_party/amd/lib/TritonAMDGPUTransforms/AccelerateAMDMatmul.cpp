@@ -64,6 +64,11 @@ warpsPerTileMFMA(tt::DotOp dotOp, const ArrayRef<int64_t> shape, int numWarps) {
   return ret;
 }
 
+// Bytes of LDS a CU reads per cycle
+constexpr int64_t kLdsBytesPerCycle = 128;
+// Cycles of the shuffles and adds reducing the 16 blocks of an MFMA 4x4
+constexpr int64_t kSubBlockReduceCycles = 128;
+
 class BlockedToMFMA : public mlir::RewritePattern {
   int mfmaVersion;
   int enforcedNonKDim;
@@ -90,104 +95,124 @@ public:
     return false;
   }
 
-  /// @brief Choose MFMA instruction parameters
-  /// @param dot target dot operation
-  /// @return pair {nonKDim, kDim} sizes of one MFMA instruction arguments
-  std::pair<int64_t, int64_t> chooseMfmaDimensions(tt::DotOp dot) const {
-    // number of matrix elements along k dim per one MFMA intruction
-    int64_t kDim = -1;
-    auto opType = dot.getA().getType().cast<RankedTensorType>();
-    auto elemType = opType.getElementType();
-
-    auto resType = dot.getD().getType().cast<RankedTensorType>();
-    auto resShape = resType.getShape();
-
-    int64_t nonKDim = -1;
-    if (enforcedNonKDim != 0) {
-      nonKDim = enforcedNonKDim;
-    } else {
-      nonKDim = -1;
-      int minSize = std::min(resShape[0], resShape[1]);
-      if (minSize >= 32)
-        nonKDim = 32;
-      if (minSize >= 16 && minSize < 32)
-        nonKDim = 16;
-      if (minSize < 16)
-        nonKDim = 4;
-      assert(nonKDim != -1);
-    }
+  /// @brief Return the number of elements along k of one MFMA instruction
+  /// @param nonKDim M and N sizes of the instruction
+  /// @param elemType type of the operands
+  /// @return kDim, or std::nullopt if there is no such instruction
+  std::optional<int64_t> getMfmaKDim(int64_t nonKDim, Type elemType) const {
+    bool isFp8 = elemType.isFloat8E4M3FNUZ() || elemType.isFloat8E5M2FNUZ();
+    // fp8 instructions are only available from MI300, in 32x32 and 16x16
+    if (isFp8 && (mfmaVersion != 3 || nonKDim == 4))
+      return std::nullopt;
     switch (nonKDim) {
     case 32:
       if (elemType.isF32())
-        kDim = 2;
+        return 2;
       if (elemType.isF16())
-        kDim = 8;
-      if (elemType.isBF16()) {
-        if (mfmaVersion == 1)
-          kDim = 4;
-        if (mfmaVersion >= 2)
-          kDim = 8;
-      }
-      if (elemType.isFloat8E4M3FNUZ() || elemType.isFloat8E5M2FNUZ()) {
-        assert(mfmaVersion == 3);
-        kDim = 16;
-      }
-      if (elemType.isInteger(8)) {
-        if (mfmaVersion == 3) {
-          kDim = 16;
-        }
-        else {
-          kDim = 8;
-        }
-      }
+        return 8;
+      if (elemType.isBF16())
+        return mfmaVersion == 1 ? 4 : 8;
+      if (isFp8)
+        return 16;
+      if (elemType.isInteger(8))
+        return mfmaVersion == 3 ? 16 : 8;
       break;
     case 16:
       if (elemType.isF32())
-        kDim = 4;
+        return 4;
       if (elemType.isF16())
-        kDim = 16;
-      if (elemType.isBF16()) {
-        if (mfmaVersion == 1)
-          kDim = 8;
-        if (mfmaVersion >= 2)
-          kDim = 16;
-      }
-      if (elemType.isFloat8E4M3FNUZ() || elemType.isFloat8E5M2FNUZ()) {
-        assert(mfmaVersion == 3);
-        kDim = 32;
-      }
-      if (elemType.isInteger(8)) {
-        if (mfmaVersion == 3) {
-          kDim = 32;
-        }
-        else {
-          kDim = 16;
-        }
-      }
+        return 16;
+      if (elemType.isBF16())
+        return mfmaVersion == 1 ? 8 : 16;
+      if (isFp8)
+        return 32;
+      if (elemType.isInteger(8))
+        return mfmaVersion == 3 ? 32 : 16;
       break;
     case 4:
       if (elemType.isF32())
-        kDim = 16;
+        return 16;
       if (elemType.isF16())
-        kDim = 64;
-      if (elemType.isBF16()) {
-        if (mfmaVersion == 1)
-          kDim = 32;
-        if (mfmaVersion >= 2)
-          kDim = 64;
-      }
-      if (elemType.isInteger(8)) {
-        kDim = 64;
-      }
+        return 64;
+      if (elemType.isBF16())
+        return mfmaVersion == 1 ? 32 : 64;
+      if (elemType.isInteger(8))
+        return 64;
       break;
     default:
       llvm::report_fatal_error("unsupported nonKDim size in MFMA dot");
     }
-    assert(kDim != -1);
-    assert(nonKDim != -1);
-    assert(resShape[0] % nonKDim == 0 && resShape[1] % nonKDim == 0);
-    assert(opType.getShape()[1] % kDim == 0);
-    return {nonKDim, kDim};
+    return std::nullopt;
+  }
+
+  /// @brief Estimate the cycles a warp spends on `dot` with MFMA instructions
+  /// of the given sizes
+  ///
+  /// Counts the issue cycles of the instructions, including the ones
+  /// replicated when the tile of a warp is smaller than an instruction, the
+  /// reads of the operands from LDS and, for 4x4, the reduction of the 16
+  /// blocks of the instruction across the lanes.
+  int64_t estimateMfmaCycles(tt::DotOp dot, int64_t nonKDim, int64_t kDim,
+                             ArrayRef<unsigned> warpsPerTile) const {
+    auto opType = dot.getA().getType().cast<RankedTensorType>();
+    Type elemType = opType.getElementType();
+    auto resShape = dot.getD().getType().cast<RankedTensorType>().getShape();
+    int64_t tileM = std::max<int64_t>(resShape[0] / warpsPerTile[0], 1);
+    int64_t tileN = std::max<int64_t>(resShape[1] / warpsPerTile[1], 1);
+    int64_t repM = ceil<int64_t>(tileM, nonKDim);
+    int64_t repN = ceil<int64_t>(tileN, nonKDim);
+    int64_t repK = opType.getShape()[1] / kDim;
+    // MI300 doubles the rate of the 32x32 and 16x16 instructions, but for
+    // fp32
+    int64_t instrCycles = nonKDim == 32 ? 64 : nonKDim == 16 ? 32 : 8;
+    if (mfmaVersion == 3 && nonKDim != 4 && !elemType.isF32())
+      instrCycles /= 2;
+    int64_t cycles = repM * repN * repK * instrCycles;
+    int64_t operandBytes = (repM + repN) * nonKDim * opType.getShape()[1] *
+                           elemType.getIntOrFloatBitWidth() / 8;
+    cycles += operandBytes / kLdsBytesPerCycle;
+    if (nonKDim == 4)
+      cycles += repM * repN * kSubBlockReduceCycles;
+    return cycles;
+  }
+
+  /// @brief Choose MFMA instruction parameters
+  /// @param dot target dot operation
+  /// @param warpsPerTile the warps of the MFMA layout
+  /// @return pair {nonKDim, kDim} sizes of one MFMA instruction arguments, or
+  /// std::nullopt if no instruction fits the dot
+  std::optional<std::pair<int64_t, int64_t>>
+  chooseMfmaDimensions(tt::DotOp dot, ArrayRef<unsigned> warpsPerTile) const {
+    auto opType = dot.getA().getType().cast<RankedTensorType>();
+    auto elemType = opType.getElementType();
+    auto resShape = dot.getD().getType().cast<RankedTensorType>().getShape();
+    auto fits = [&](int64_t nonKDim) -> std::optional<int64_t> {
+      std::optional<int64_t> kDim = getMfmaKDim(nonKDim, elemType);
+      if (!kDim || resShape[0] % nonKDim != 0 || resShape[1] % nonKDim != 0 ||
+          opType.getShape()[1] % *kDim != 0)
+        return std::nullopt;
+      return kDim;
+    };
+    if (enforcedNonKDim != 0) {
+      std::optional<int64_t> kDim = fits(enforcedNonKDim);
+      if (!kDim)
+        return std::nullopt;
+      return std::make_pair(int64_t(enforcedNonKDim), *kDim);
+    }
+    // The cheapest instruction, the larger ones on ties
+    std::optional<std::pair<int64_t, int64_t>> best;
+    int64_t bestCycles = 0;
+    for (int64_t nonKDim : {32, 16, 4}) {
+      std::optional<int64_t> kDim = fits(nonKDim);
+      if (!kDim)
+        continue;
+      int64_t cycles = estimateMfmaCycles(dot, nonKDim, *kDim, warpsPerTile);
+      if (!best || cycles < bestCycles) {
+        best = std::make_pair(nonKDim, *kDim);
+        bestCycles = cycles;
+      }
+    }
+    return best;
   }
 
   mlir::LogicalResult
@@ -219,10 +244,13 @@ public:
 
     ttg::MfmaEncodingAttr mfmaEnc;
 
-    auto [nonKDim, kDim] = chooseMfmaDimensions(dotOp);
-
     auto warpsPerTile = warpsPerTileMFMA(dotOp, retShape, numWarps);
 
+    auto mfmaDims = chooseMfmaDimensions(dotOp, warpsPerTile);
+    if (!mfmaDims)
+      return failure();
+    auto [nonKDim, kDim] = *mfmaDims;
+
     bool isTransposed = isChainDot(dotOp);
     mfmaEnc = ttg::MfmaEncodingAttr::get(oldRetType.getContext(), nonKDim,
                                          warpsPerTile, isTransposed, CTALayout);
@@ -302,13 +330,47 @@ public:
     ModuleOp m = getOperation();
 
     mlir::RewritePatternSet patterns(context);
-    if (matrixCoreVersion == 1 || matrixCoreVersion == 2 ||
-        matrixCoreVersion == 3)
+    // MFMAs run on 64-wide wavefronts only
+    bool wave64 = ttg::TritonGPUDialect::getThreadsPerWarp(m) == 64;
+    if (wave64 && (matrixCoreVersion == 1 || matrixCoreVersion == 2 ||
+                   matrixCoreVersion == 3))
       patterns.add<::BlockedToMFMA>(context, matrixCoreVersion,
                                     matrixInstructionSize);
     if (applyPatternsAndFoldGreedily(m, std::move(patterns)).failed()) {
       signalPassFailure();
     }
+    recordMfmaInstructions(m);
+  }
+
+private:
+  // Lists the MFMA instructions picked for the dots of the module, as
+  // MxNxK strings followed by the operand type, in the kernel metadata so
+  // that matrixInstructionSize can be tuned against them.
+  static void recordMfmaInstructions(ModuleOp m) {
+    SmallVector<Attribute> instrs;
+    m.walk([&](tt::DotOp dot) {
+      auto mfmaEnc = dot.getD()
+                         .getType()
+                         .cast<RankedTensorType>()
+                         .getEncoding()
+                         .dyn_cast<ttg::MfmaEncodingAttr>();
+      if (!mfmaEnc)
+        return;
+      auto aType = dot.getA().getType().cast<RankedTensorType>();
+      unsigned kWidth =
+          aType.getEncoding().cast<ttg::DotOperandEncodingAttr>().getKWidth();
+      unsigned nonKDim = mfmaEnc.getNonKDim();
+      // The groups of elements along k of the lanes of an instruction
+      unsigned kGroups = nonKDim == 32 ? 2 : nonKDim == 16 ? 4 : 16;
+      std::string instr;
+      llvm::raw_string_ostream os(instr);
+      os << nonKDim << "x" << nonKDim << "x" << kWidth * kGroups << "_"
+         << aType.getElementType();
+      instrs.push_back(StringAttr::get(m.getContext(), os.str()));
+    });
+    if (!instrs.empty())
+      m->setAttr("triton_gpu.mfma-instrs",
+                 ArrayAttr::get(m.getContext(), instrs));
   }
 };
 
@@ -0,0 +1,130 @@
+#include "mlir/IR/Matchers.h"
+#include "mlir/Pass/Pass.h"
+#include "triton/Analysis/AxisInfo.h"
+#include "triton/Analysis/Utility.h"
+#include "triton/Dialect/TritonGPU/IR/Dialect.h"
+#define GEN_PASS_CLASSES
+#include "TritonAMDGPUTransforms/Passes.h"
+
+//===----------------------------------------------------------------------===//
+// This pass lays out the pointers of the async copies of the pipeliner for the
+// loads of gfx94x from global memory to LDS. The loads write the dword of
+// each lane at consecutive addresses from a base common to the wave, so the
+// lanes of each warp hold a dword of consecutive elements each, along a row
+// of the slice or over whole rows. The conversions to the new layouts are
+// rematerialized by the removal of layout conversions.
+//===----------------------------------------------------------------------===//
+
+using namespace mlir;
+namespace ttg = mlir::triton::gpu;
+
+namespace {
+
+// Returns the layout of the lanes writing consecutive dwords, or nullptr when
+// the copy can't load to LDS directly whatever the layout.
+ttg::BlockedEncodingAttr
+getDirectToLdsLayout(ttg::InsertSliceAsyncOp op,
+                     ModuleAxisInfoAnalysis &axisInfoAnalysis) {
+  auto srcTy = op.getSrc().getType().cast<RankedTensorType>();
+  auto dstTy = op.getDst().getType().cast<RankedTensorType>();
+  auto blocked = srcTy.getEncoding().dyn_cast<ttg::BlockedEncodingAttr>();
+  auto shared = dstTy.getEncoding().dyn_cast<ttg::SharedEncodingAttr>();
+  ArrayRef<int64_t> shape = srcTy.getShape();
+  unsigned rank = shape.size();
+  if (!blocked || !shared || shared.getHasLeadingOffset() || rank > 2 ||
+      op.getAxis() != 0 || dstTy.getShape().drop_front() != shape)
+    return nullptr;
+  // Masked out dwords are zeroed
+  Value other = op.getOther();
+  if (other && !matchPattern(other, m_Zero()) &&
+      !matchPattern(other, m_PosZeroFloat()))
+    return nullptr;
+  unsigned elemBits = triton::getPointeeBitWidth(srcTy);
+  if (elemBits < 8 || elemBits > 32)
+    return nullptr;
+  unsigned elemsPerDword = 32 / elemBits;
+  // Each lane loads the element swizzled to its dword
+  unsigned span = elemsPerDword;
+  if (shared.getMaxPhase() > 1) {
+    if (shared.getVec() < elemsPerDword)
+      return nullptr;
+    span = shared.getVec() * shared.getMaxPhase();
+  }
+  auto order = shared.getOrder();
+  if (!llvm::equal(order, blocked.getOrder()) ||
+      axisInfoAnalysis.getPtrContiguity(op.getSrc()) < span ||
+      (op.getMask() &&
+       axisInfoAnalysis.getMaskAlignment(op.getMask()) < span))
+    return nullptr;
+
+  auto mod = op->getParentOfType<ModuleOp>();
+  unsigned threadsPerWarp = ttg::TritonGPUDialect::getThreadsPerWarp(mod);
+  unsigned numWarps = ttg::TritonGPUDialect::getNumWarps(mod);
+  unsigned inner = order[0];
+  if (shape[inner] % elemsPerDword != 0)
+    return nullptr;
+  unsigned rowDwords = shape[inner] / elemsPerDword;
+  SmallVector<unsigned> sizePerThread(rank, 1);
+  SmallVector<unsigned> lanes(rank, 1);
+  SmallVector<unsigned> warps(rank, 1);
+  sizePerThread[inner] = elemsPerDword;
+  lanes[inner] = std::min(threadsPerWarp, rowDwords);
+  warps[inner] = std::max(1u, std::min(numWarps, rowDwords / threadsPerWarp));
+  if (rank == 2) {
+    unsigned outer = order[1];
+    lanes[outer] = threadsPerWarp / lanes[inner];
+    warps[outer] = numWarps / warps[inner];
+    if (lanes[outer] * warps[outer] > shape[outer])
+      return nullptr;
+  } else if (lanes[inner] * warps[inner] != threadsPerWarp * numWarps) {
+    return nullptr;
+  }
+  if (warps[inner] * lanes[inner] > rowDwords)
+    return nullptr;
+  return ttg::BlockedEncodingAttr::get(op.getContext(), sizePerThread, lanes,
+                                       warps, order, blocked.getCTALayout());
+}
+
+Value convertLayout(OpBuilder &builder, Value value, Attribute encoding) {
+  auto ty = value.getType().cast<RankedTensorType>();
+  if (ty.getEncoding() == encoding)
+    return value;
+  auto newTy =
+      RankedTensorType::get(ty.getShape(), ty.getElementType(), encoding);
+  return builder.create<ttg::ConvertLayoutOp>(value.getLoc(), newTy, value);
+}
+
+} // namespace
+
+class TritonAMDGPUDirectToLdsPass
+    : public TritonAMDGPUDirectToLdsBase<TritonAMDGPUDirectToLdsPass> {
+public:
+  TritonAMDGPUDirectToLdsPass() = default;
+
+  void runOnOperation() override {
+    ModuleOp mod = getOperation();
+    if (ttg::TritonGPUDialect::getNumCTAs(mod) != 1)
+      return;
+    ModuleAxisInfoAnalysis axisInfoAnalysis(mod);
+    SmallVector<std::pair<ttg::InsertSliceAsyncOp, ttg::BlockedEncodingAttr>>
+        copies;
+    mod.walk([&](ttg::InsertSliceAsyncOp op) {
+      if (auto layout = getDirectToLdsLayout(op, axisInfoAnalysis))
+        copies.emplace_back(op, layout);
+    });
+    for (auto [op, layout] : copies) {
+      OpBuilder builder(op);
+      op.getSrcMutable().assign(convertLayout(builder, op.getSrc(), layout));
+      if (Value mask = op.getMask())
+        op.getMaskMutable().assign(convertLayout(builder, mask, layout));
+      if (Value other = op.getOther())
+        op.getOtherMutable().assign(convertLayout(builder, other, layout));
+    }
+    // The lowering loads to LDS directly
+    mod->setAttr("triton_gpu.direct-to-lds", UnitAttr::get(&getContext()));
+  }
+};
+
+std::unique_ptr<Pass> mlir::createTritonAMDGPUDirectToLdsPass() {
+  return std::make_unique<TritonAMDGPUDirectToLdsPass>();
+}
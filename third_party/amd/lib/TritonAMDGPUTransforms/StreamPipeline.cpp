@@ -7,6 +7,7 @@
 #include "triton/Analysis/Utility.h"
 #include "triton/Dialect/TritonGPU/IR/Dialect.h"
 #include "TritonAMDGPUTransforms/Passes.h"
+#include "triton/Dialect/TritonGPU/Transforms/PipelineExpander.h"
 #include "triton/Dialect/TritonGPU/Transforms/Utility.h"
 #include "llvm/ADT/MapVector.h"
 
@@ -30,6 +31,12 @@
 //   - Store next tile into shared mem
 // - Epilogue: Peeled non-load loop body for last iteration
 //
+// With more than two stages, the loop is instead expanded by the pipeline
+// expander shared with the TritonGPU pipeliner. The loads of an iteration are
+// issued numStages - 2 iterations before their tile is stored to shared
+// memory, so that several tiles are in flight in registers, and the stores
+// ping-pong between the buffers of the loop-carried tiles.
+//
 //===----------------------------------------------------------------------===//
 
 using llvm::MapVector;
@@ -67,9 +74,9 @@ class LoopPipeliner {
   SmallVector<Value> nextBuffers;
   SmallVector<Value> yieldValues;
 
-  /// The number of stages in the pipeline is fixed to '2' for
-  /// analysis since there will be a current buffer stored in
-  /// shared mem and a next buffer stored in regs.
+  /// The number of stages in the pipeline. The two-stage pipeline keeps a
+  /// current buffer in shared mem and a next buffer in regs, which is also
+  /// the depth the dependencies of the loads are analyzed to.
   int numStages = 2;
 
   /// Arg indicies
@@ -167,6 +174,11 @@ public:
   /// Collect loads to pipeline. Return success if we can pipeline this loop
   LogicalResult initialize();
 
+  /// Convert the pipelined loads to shared memory and fill out the schedule
+  /// of `depth` stages for the pipeline expander. Return failure, without
+  /// modifying the loop, if it can't be expanded.
+  LogicalResult createSchedule(int depth, triton::PipeliningOption &options);
+
   /// Emit pipelined loads (before loop body)
   void emitPrologue();
 
@@ -511,6 +523,105 @@ bool LoopPipeliner::isLoadChain(Operation *op) const {
   return false;
 }
 
+// Mask the loads of the iterations past the end of the loop, the other ops
+// scheduled before the last stage have no side effects.
+static Operation *predicateOp(RewriterBase &rewriter, Operation *op,
+                              Value pred) {
+  OpBuilder::InsertionGuard guard(rewriter);
+  if (isMemoryEffectFree(op))
+    return op;
+  auto loadOp = dyn_cast<triton::LoadOp>(op);
+  if (!loadOp)
+    return nullptr;
+  rewriter.setInsertionPoint(loadOp);
+  Type maskType = triton::getI1SameShape(loadOp.getType());
+  Value mask = pred;
+  if (isa<RankedTensorType>(maskType))
+    mask = rewriter.create<triton::SplatOp>(loadOp.getLoc(), maskType, pred);
+  if (Value curMask = loadOp.getMask())
+    mask = rewriter.create<arith::AndIOp>(loadOp.getLoc(), mask, curMask);
+  loadOp.getMaskMutable().assign(mask);
+  return op;
+}
+
+LogicalResult LoopPipeliner::createSchedule(int depth,
+                                            triton::PipeliningOption &options) {
+  if (checkOpUses().failed())
+    return failure();
+  // The expander handles the values carried from the previous iteration only
+  if (llvm::any_of(yieldOp->getOperands(),
+                   [](Value v) { return !v.getDefiningOp(); }))
+    return failure();
+  if (forOp->walk([&](Operation *op) {
+             return isa<scf::ForOp, scf::WhileOp>(op) && op != forOp
+                        ? WalkResult::interrupt()
+                        : WalkResult::advance();
+           }).wasInterrupted())
+    return failure();
+  // The tiles are stored to shared memory by the conversion of the load
+  SetVector<Operation *> loadStage;
+  for (Operation *loadOp : validLoads) {
+    if (*loadOp->getUsers().begin() !=
+        convertMapping[loadOp->getResult(0)].getDefiningOp())
+      return failure();
+    SetVector<BlockArgument> args;
+    for (Value operand : loadOp->getOperands())
+      collectValueDep(operand, depth - 1, loadStage, args);
+  }
+  // The ops the loads depend on, also through the loop-carried values, run in
+  // the first stage, for the iterations past the end of the loop as well.
+  loadStage.insert(validLoads.begin(), validLoads.end());
+  for (Operation *op : loadStage) {
+    if (!validLoads.contains(op) && !isMemoryEffectFree(op) &&
+        !isa<triton::LoadOp>(op))
+      return failure();
+    // The dependencies too far from the loads weren't collected
+    for (Value operand : op->getOperands()) {
+      if (auto arg = operand.dyn_cast<BlockArgument>();
+          arg && arg.getOwner() == forOp.getBody() && arg.getArgNumber() > 0)
+        operand = yieldOp->getOperand(arg.getArgNumber() - 1);
+      Operation *def = operand.getDefiningOp();
+      if (def && def->getBlock() == forOp.getBody() && !loadStage.contains(def))
+        return failure();
+    }
+  }
+
+  createBufferTypes();
+  SmallVector<Operation *> stores;
+  for (Operation *loadOp : validLoads) {
+    OpBuilder builder(loadOp->getContext());
+    builder.setInsertionPointAfter(loadOp);
+    Value load = loadOp->getResult(0);
+    auto storeOp = builder.create<ttg::ConvertLayoutOp>(
+        loadOp->getLoc(), loadsBufferType[load], load);
+    convertMapping[load].getDefiningOp()->setOperand(0, storeOp);
+    stores.push_back(storeOp);
+  }
+
+  // The loads for the iterations ahead are issued first, then the compute of
+  // the current iteration, then the stores of the next tiles, as the
+  // two-stage pipeline does.
+  std::vector<std::pair<Operation *, unsigned>> schedule;
+  for (Operation &op : forOp.getBody()->without_terminator())
+    if (loadStage.contains(&op))
+      schedule.emplace_back(&op, 0);
+  for (Operation &op : forOp.getBody()->without_terminator())
+    if (!loadStage.contains(&op) && !llvm::is_contained(stores, &op))
+      schedule.emplace_back(&op, depth - 1);
+  for (Operation *storeOp : stores)
+    schedule.emplace_back(storeOp, depth - 2);
+
+  options.getScheduleFn =
+      [schedule](scf::ForOp forOp,
+                 std::vector<std::pair<Operation *, unsigned>> &s) {
+        s = std::move(schedule);
+      };
+  options.peelEpilogue = false;
+  options.predicateFn = predicateOp;
+  options.supportDynamicLoops = true;
+  return success();
+}
+
 void LoopPipeliner::emitPrologue() {
   /// forOp block args => forOp operands
   /// forOp iterator => lower bound
@@ -798,6 +909,7 @@ scf::ForOp LoopPipeliner::createNewForOp() {
 // Stream Pipeline
 struct PipelinePass : public TritonAMDGPUStreamPipelineBase<PipelinePass> {
   PipelinePass() = default;
+  PipelinePass(int numStages) { this->numStages = numStages; }
 
   void runOnOperation() override {
     // Pre-processing
@@ -812,8 +924,18 @@ struct PipelinePass : public TritonAMDGPUStreamPipelineBase<PipelinePass> {
 
     // Do the pipelining
     getOperation()->walk([&](scf::ForOp forOp) -> void {
-      LoopPipeliner pipeliner(forOp);
+      if (numStages > 2) {
+        triton::PipeliningOption options;
+        if (LoopPipeliner(forOp).createSchedule(numStages, options)
+                .succeeded()) {
+          IRRewriter rewriter(forOp->getContext());
+          rewriter.setInsertionPoint(forOp);
+          (void)triton::pipelineForLoop(rewriter, forOp, options);
+          return;
+        }
+      }
 
+      LoopPipeliner pipeliner(forOp);
       if (pipeliner.initialize().failed())
         return;
 
@@ -833,6 +955,7 @@ struct PipelinePass : public TritonAMDGPUStreamPipelineBase<PipelinePass> {
 };
 } // anonymous namespace
 
-std::unique_ptr<Pass> mlir::createTritonAMDGPUStreamPipelinePass() {
-  return std::make_unique<PipelinePass>();
+std::unique_ptr<Pass>
+mlir::createTritonAMDGPUStreamPipelinePass(int numStages) {
+  return std::make_unique<PipelinePass>(numStages);
 }
@@ -10,23 +10,31 @@
 
 namespace py = pybind11;
 
+void init_triton_amd_launcher(py::module &m);
+
 void init_triton_amd_passes_ttgpuir(py::module &&m) {
   using namespace mlir::triton;
   m.def("add_to_llvmir", [](mlir::PassManager &pm) {
     pm.addPass(createConvertTritonAMDGPUToLLVMPass());
   });
+  m.def("add_sched_hints", [](mlir::PassManager &pm, const std::string &arch,
+                              const std::string &variant) {
+    pm.addPass(createTritonAMDGPUInsertSchedHintsPass(arch, variant));
+  });
   ADD_PASS_WRAPPER_2("add_accelerate_matmul",
                      mlir::createTritonAMDGPUAccelerateMatmulPass, int, int);
   ADD_PASS_WRAPPER_0("add_decompose_conversions",
                      mlir::createTritonAMDGPUDecomposeConversionsPass);
+  ADD_PASS_WRAPPER_0("add_direct_to_lds",
+                     mlir::createTritonAMDGPUDirectToLdsPass);
   ADD_PASS_WRAPPER_0("add_optimize_epilogue",
                      mlir::createTritonAMDGPUOptimizeEpiloguePass);
   ADD_PASS_WRAPPER_0("add_remove_layout_conversions",
                      mlir::createTritonAMDGPURemoveLayoutConversionsPass);
   ADD_PASS_WRAPPER_0("add_reorder_instructions",
                      mlir::createTritonAMDGPUReorderInstructionsPass);
-  ADD_PASS_WRAPPER_0("add_stream_pipeline",
-                     mlir::createTritonAMDGPUStreamPipelinePass);
+  ADD_PASS_WRAPPER_1("add_stream_pipeline",
+                     mlir::createTritonAMDGPUStreamPipelinePass, int);
 }
 
 
@@ -35,6 +43,7 @@ void init_triton_amd(py::module &&m) {
   
   auto passes = m.def_submodule("passes");
   init_triton_amd_passes_ttgpuir(passes.def_submodule("ttgpuir"));
+  init_triton_amd_launcher(m);
 
   // load dialects
   m.def("load_dialects", [](mlir::MLIRContext &context) {
@@ -0,0 +1,140 @@
+from triton.backends.compiler import BaseBackend, run_passes, timed_pass
+from triton._C.libtriton import ir, passes, llvm, cpu
+from triton.runtime.build import _build
+from dataclasses import dataclass
+from typing import Any
+import hashlib
+import tempfile
+import os
+import re
+import functools
+
+
+@dataclass(frozen=True)
+class CPUOptions:
+    # a program runs on a single thread: the warps, CTAs and stages only exist
+    # for the frontend and the launcher
+    num_warps: int = 1
+    num_ctas: int = 1
+    num_stages: int = 1
+    cluster_dims: tuple = (1, 1, 1)
+    extern_libs: dict = None
+    debug: bool = False
+    allow_fp8e4nv: bool = False
+    # the dots are contractions of vectors of any rank
+    allow_batched_dot: bool = True
+    # TODO: deprecate when hook interface has changed
+    enable_warp_specialization: bool = False
+    enable_fp_fusion: bool = True
+    max_num_imprecise_acc_default: int = 0
+    # share the reduction loop of matmul kernels among this many programs,
+    # see the `triton-split-k` pass
+    split_k: int = 1
+
+    def hash(self):
+        key = '_'.join([f'{name}-{val}' for name, val in self.__dict__.items()])
+        return hashlib.md5(key.encode("utf-8")).hexdigest()
+
+
+class CPUBackend(BaseBackend):
+
+    @staticmethod
+    def supports_target(target: tuple):
+        return target[0] == 'cpu'
+
+    def __init__(self, target: tuple) -> None:
+        super().__init__(target)
+        # the triple, the name and the features of the host, which is the
+        # only CPU the kernels are compiled for
+        self.host_target = cpu.get_host_target()
+
+    def parse_options(self, opts) -> Any:
+        args = {k: opts[k] for k in CPUOptions.__dataclass_fields__.keys() if k in opts}
+        return CPUOptions(**args)
+
+    def load_dialects(self, ctx):
+        cpu.load_dialects(ctx)
+
+    @staticmethod
+    def make_ttir(mod, metadata, opt):
+        pm = ir.pass_manager(mod.context)
+        pm.enable_debug()
+        passes.common.add_inliner(pm)
+        passes.ttir.add_rewrite_tensor_pointer(pm)
+        passes.ttir.add_combine(pm)
+        passes.common.add_canonicalizer(pm)
+        passes.ttir.add_reorder_broadcast(pm)
+        passes.common.add_cse(pm)
+        passes.common.add_licm(pm)
+        passes.common.add_symbol_dce(pm)
+        passes.ttir.add_split_k(pm, opt.split_k)
+        run_passes(pm, mod, metadata, "ttir")
+        # the factor the launcher multiplies the grid by
+        metadata["split_k"] = mod.get_int_attr("tt.split_k") or 1
+        return mod
+
+    @staticmethod
+    def make_llir(src, metadata, options):
+        mod = src
+        # TritonIR -> vector -> LLVM-IR (MLIR)
+        pm = ir.pass_manager(mod.context)
+        pm.enable_debug()
+        cpu.passes.ttir.add_to_vector(pm)
+        passes.common.add_canonicalizer(pm)
+        passes.common.add_cse(pm)
+        passes.convert.add_scf_to_cf(pm)
+        cpu.passes.convert.add_math_to_llvmir(pm)
+        # the math functions without an LLVM intrinsic are called in libm
+        cpu.passes.convert.add_math_to_libm(pm)
+        cpu.passes.convert.add_vector_to_llvmir(pm)
+        passes.convert.add_arith_to_llvmir(pm)
+        passes.convert.add_index_to_llvmir(pm)
+        cpu.passes.convert.add_func_to_llvmir(pm)
+        passes.convert.add_cf_to_llvmir(pm)
+        cpu.passes.convert.add_reconcile_unrealized_casts(pm)
+        passes.common.add_canonicalizer(pm)
+        passes.common.add_cse(pm)
+        passes.common.add_symbol_dce(pm)
+        run_passes(pm, mod, metadata, "llir")
+        # LLVM-IR (MLIR) -> LLVM-IR (LLVM)
+        llvm.init_targets()
+        context = llvm.context()
+        llvm_mod = llvm.to_module(mod, context)
+        with timed_pass(metadata, "llir", "llvm-optimize"):
+            llvm.optimize_module(llvm_mod, llvm.OPTIMIZE_O3)
+        # a program has no shared memory
+        metadata["shared"] = 0
+        ret = str(llvm_mod)
+        return ret
+
+    def make_asm(self, src, metadata, options):
+        # the kernel is the only function with external linkage, see the
+        # `triton-cpu-convert-to-vector` pass
+        names = re.findall(r"^define void @([a-zA-Z_][a-zA-Z0-9_]*)", src, re.MULTILINE)
+        assert len(names) == 1
+        metadata["name"] = names[0]
+        triple, proc, features = self.host_target
+        with timed_pass(metadata, "asm", "llvm-codegen"):
+            ret = llvm.translate_to_asm(src, triple, proc, features, [], options.enable_fp_fusion, False)
+        return ret
+
+    @staticmethod
+    def make_so(src, metadata, options):
+        with tempfile.TemporaryDirectory() as tmpdir:
+            src_path = os.path.join(tmpdir, "kernel.s")
+            with open(src_path, "w") as f:
+                f.write(src)
+            with timed_pass(metadata, "so", "cc"):
+                so = _build("kernel", src_path, tmpdir, [], [], ["m"])
+            with open(so, "rb") as f:
+                return f.read()
+
+    def add_stages(self, stages, options):
+        stages["ttir"] = lambda src, metadata: self.make_ttir(src, metadata, options)
+        stages["llir"] = lambda src, metadata: self.make_llir(src, metadata, options)
+        stages["asm"] = lambda src, metadata: self.make_asm(src, metadata, options)
+        stages["so"] = lambda src, metadata: self.make_so(src, metadata, options)
+
+    @functools.lru_cache()
+    def hash(self):
+        return '-'.join(self.host_target)
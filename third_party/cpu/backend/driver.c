@@ -0,0 +1,196 @@
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#include <dlfcn.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+// Runs the program `(x, y, z)` of a launch, whose kernel and arguments are
+// in `args`
+typedef void (*ProgramFn)(void *args, int x, int y, int z, int gridX,
+                          int gridY, int gridZ);
+
+// The threads the programs of the launches are distributed to. The thread
+// launching the kernel runs programs too, then waits for the other threads to
+// finish theirs: a launch returns once all its programs ran.
+typedef struct {
+  pthread_mutex_t mutex;
+  pthread_cond_t start;
+  pthread_cond_t done;
+  // one launch at a time, from any Python thread
+  pthread_mutex_t launchMutex;
+  pthread_t *workers;
+  int numWorkers;
+  // incremented by each launch, which wakes up the workers
+  uint64_t generation;
+  // the launch running, if any
+  ProgramFn fn;
+  void *args;
+  int gridX, gridY, gridZ;
+  int64_t numPrograms;
+  // the next program to run, the programs are taken in order
+  _Atomic int64_t next;
+  // the workers running programs of the launch
+  int busy;
+} Pool;
+
+static Pool pool = {.mutex = PTHREAD_MUTEX_INITIALIZER,
+                    .start = PTHREAD_COND_INITIALIZER,
+                    .done = PTHREAD_COND_INITIALIZER,
+                    .launchMutex = PTHREAD_MUTEX_INITIALIZER};
+
+static void runPrograms(void) {
+  int64_t pid;
+  while ((pid = atomic_fetch_add(&pool.next, 1)) < pool.numPrograms) {
+    // x varies fastest, as on GPUs
+    int x = pid % pool.gridX;
+    int y = (pid / pool.gridX) % pool.gridY;
+    int z = pid / ((int64_t)pool.gridX * pool.gridY);
+    pool.fn(pool.args, x, y, z, pool.gridX, pool.gridY, pool.gridZ);
+  }
+}
+
+static void *workerMain(void *unused) {
+  uint64_t generation = 0;
+  for (;;) {
+    pthread_mutex_lock(&pool.mutex);
+    while (pool.generation == generation)
+      pthread_cond_wait(&pool.start, &pool.mutex);
+    generation = pool.generation;
+    pool.busy++;
+    pthread_mutex_unlock(&pool.mutex);
+    runPrograms();
+    pthread_mutex_lock(&pool.mutex);
+    if (--pool.busy == 0)
+      pthread_cond_signal(&pool.done);
+    pthread_mutex_unlock(&pool.mutex);
+  }
+  return NULL;
+}
+
+// Runs the programs of a grid on the pool, called by the launchers with the
+// GIL released
+static void parallelFor(ProgramFn fn, void *args, int gridX, int gridY,
+                        int gridZ) {
+  int64_t numPrograms = (int64_t)gridX * gridY * gridZ;
+  if (numPrograms == 0)
+    return;
+  pthread_mutex_lock(&pool.launchMutex);
+  pthread_mutex_lock(&pool.mutex);
+  // the workers woken up late by the previous launch find no program left,
+  // the launch is only replaced once they returned
+  while (pool.busy > 0)
+    pthread_cond_wait(&pool.done, &pool.mutex);
+  pool.fn = fn;
+  pool.args = args;
+  pool.gridX = gridX;
+  pool.gridY = gridY;
+  pool.gridZ = gridZ;
+  pool.numPrograms = numPrograms;
+  atomic_store(&pool.next, 0);
+  if (numPrograms > 1 && pool.numWorkers > 0) {
+    pool.generation++;
+    pthread_cond_broadcast(&pool.start);
+  }
+  pthread_mutex_unlock(&pool.mutex);
+  runPrograms();
+  pthread_mutex_lock(&pool.mutex);
+  while (pool.busy > 0)
+    pthread_cond_wait(&pool.done, &pool.mutex);
+  pthread_mutex_unlock(&pool.mutex);
+  pthread_mutex_unlock(&pool.launchMutex);
+}
+
+// Starts the pool once, with `numThreads` threads including the launching
+// one, and returns the address of `parallelFor` for the launchers
+static PyObject *initThreadPool(PyObject *self, PyObject *args) {
+  int numThreads;
+  if (!PyArg_ParseTuple(args, "i", &numThreads))
+    return NULL;
+  pthread_mutex_lock(&pool.launchMutex);
+  if (pool.workers == NULL && numThreads > 1) {
+    pool.workers = malloc(sizeof(pthread_t) * (numThreads - 1));
+    for (int i = 0; i < numThreads - 1; ++i) {
+      if (pthread_create(&pool.workers[i], NULL, workerMain, NULL) != 0)
+        break;
+      pthread_detach(pool.workers[i]);
+      pool.numWorkers++;
+    }
+  }
+  pthread_mutex_unlock(&pool.launchMutex);
+  return PyLong_FromUnsignedLongLong((uint64_t)(uintptr_t)parallelFor);
+}
+
+// Loads the shared library of a kernel and returns its handle and the
+// address of the kernel
+static PyObject *loadBinary(PyObject *self, PyObject *args) {
+  const char *name;
+  const char *data;
+  Py_ssize_t data_size;
+  int shared;
+  int device;
+  if (!PyArg_ParseTuple(args, "ss#ii", &name, &data, &data_size, &shared,
+                        &device))
+    return NULL;
+  // dlopen only loads files
+  char path[] = "/tmp/triton_cpu_XXXXXX";
+  int fd = mkstemp(path);
+  if (fd < 0) {
+    PyErr_SetFromErrno(PyExc_OSError);
+    return NULL;
+  }
+  Py_ssize_t written = 0;
+  while (written < data_size) {
+    ssize_t n = write(fd, data + written, data_size - written);
+    if (n < 0) {
+      close(fd);
+      unlink(path);
+      PyErr_SetFromErrno(PyExc_OSError);
+      return NULL;
+    }
+    written += n;
+  }
+  close(fd);
+  void *handle = dlopen(path, RTLD_NOW | RTLD_LOCAL);
+  unlink(path);
+  if (handle == NULL) {
+    PyErr_SetString(PyExc_RuntimeError, dlerror());
+    return NULL;
+  }
+  void *fn = dlsym(handle, name);
+  if (fn == NULL) {
+    PyErr_SetString(PyExc_RuntimeError, dlerror());
+    dlclose(handle);
+    return NULL;
+  }
+  // the kernels use no registers or spills the frontend knows of
+  return Py_BuildValue("(KKii)", (uint64_t)(uintptr_t)handle,
+                       (uint64_t)(uintptr_t)fn, 0, 0);
+}
+
+static PyMethodDef ModuleMethods[] = {
+    {"load_binary", loadBinary, METH_VARARGS,
+     "Load provided shared library into the process"},
+    {"init_thread_pool", initThreadPool, METH_VARARGS,
+     "Start the threads running the programs and return the address of the "
+     "function distributing them"},
+    {NULL, NULL, 0, NULL} // sentinel
+};
+
+static struct PyModuleDef ModuleDef = {PyModuleDef_HEAD_INIT, "cpu_utils",
+                                       NULL, // documentation
+                                       -1,   // size
+                                       ModuleMethods};
+
+PyMODINIT_FUNC PyInit_cpu_utils(void) {
+  PyObject *m = PyModule_Create(&ModuleDef);
+  if (m == NULL) {
+    return NULL;
+  }
+  PyModule_AddFunctions(m, ModuleMethods);
+  return m;
+}
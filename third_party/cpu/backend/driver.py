@@ -0,0 +1,334 @@
+import os
+import hashlib
+import tempfile
+from pathlib import Path
+from triton.runtime.build import _build
+from triton.runtime.cache import get_cache_manager
+from triton.backends.driver import DriverBase
+
+dirname = os.path.dirname(os.path.realpath(__file__))
+include_dir = []
+library_dir = []
+libraries = ['pthread', 'dl']
+
+def compile_module_from_src(src, name):
+    key = hashlib.md5(src.encode("utf-8")).hexdigest()
+    cache = get_cache_manager(key)
+    cache_path = cache.get_file(f"{name}.so")
+    if cache_path is None:
+        with tempfile.TemporaryDirectory() as tmpdir:
+            src_path = os.path.join(tmpdir, "main.c")
+            with open(src_path, "w") as f:
+                f.write(src)
+            so = _build(name, src_path, tmpdir, library_dir, include_dir, libraries)
+            with open(so, "rb") as f:
+                cache_path = cache.put(f.read(), f"{name}.so", binary=True)
+    import importlib.util
+    spec = importlib.util.spec_from_file_location(name, cache_path)
+    mod = importlib.util.module_from_spec(spec)
+    spec.loader.exec_module(mod)
+    return mod
+
+class CPUUtils(object):
+
+    def __new__(cls):
+        if not hasattr(cls, "instance"):
+            cls.instance = super(CPUUtils, cls).__new__(cls)
+        return cls.instance
+
+    def __init__(self):
+        mod = compile_module_from_src(Path(os.path.join(dirname, "driver.c")).read_text(), "cpu_utils")
+        self.load_binary = mod.load_binary
+        # the threads running the programs, TRITON_CPU_THREADS or one per core
+        self.num_threads = int(os.environ.get("TRITON_CPU_THREADS", 0)) or os.cpu_count()
+        self.parallel_for = mod.init_thread_pool(self.num_threads)
+
+    def get_device_properties(self, device):
+        # the programs have no shared memory, and run on `num_threads` threads
+        return {"max_shared_mem": 2**31 - 1, "multiprocessor_count": self.num_threads}
+
+    def occupancy(self, function, num_warps, shared, cluster_x, cluster_y, cluster_z):
+        # one program per thread at a time, without clusters
+        return 1, None
+
+# -------------------- Launcher ----------------------------
+def ty_to_cpp(ty):
+    if ty[0] == '*':
+        return "uint64_t"
+    if ty in ("fp16", "bf16"):
+        raise NotImplementedError(f"{ty} arguments are not supported by the CPU backend")
+    return {
+        "i1": "bool",
+        "i8": "int8_t",
+        "i16": "int16_t",
+        "i32": "int32_t",
+        "i64": "int64_t",
+        "u32": "uint32_t",
+        "u64": "uint64_t",
+        "fp32": "float",
+        "f32": "float",
+        "fp64": "double",
+    }[ty]
+
+
+def kernel_params(constants, signature, ids):
+    start_desc = len(signature)
+    folded_without_constexprs = [c for c in ids['ids_of_folded_args'] if c not in ids['ids_of_const_exprs']]
+    params = [
+        i for i in signature.keys() if i >= start_desc or (i not in constants and i not in folded_without_constexprs)
+    ]
+    return params
+
+
+def make_launcher(constants, signature, ids):
+    params = kernel_params(constants, signature, ids)
+    # the kernel takes the ids and the numbers of programs after its
+    # arguments, see the `triton-cpu-convert-to-vector` pass
+    kernel_arg_decls = ''.join(f"{ty_to_cpp(signature[i])}, " for i in params)
+
+    def _extracted_type(ty):
+        if ty[0] == '*':
+            return "PyObject*"
+        return {
+            'i1': 'int32_t',
+            'i8': 'int8_t',
+            'i16': 'int16_t',
+            'i32': 'int32_t',
+            'i64': 'int64_t',
+            'u32': 'uint32_t',
+            'u64': 'uint64_t',
+            # only parsed when folded, the kernel can't take them
+            'fp16': 'float',
+            'bf16': 'float',
+            'fp32': 'float',
+            'f32': 'float',
+            'fp64': 'double',
+        }[ty]
+
+    def format_of(ty):
+        return {
+            "PyObject*": "O",
+            "float": "f",
+            "double": "d",
+            "long": "l",
+            "int8_t": "b",
+            "int16_t": "h",
+            "uint32_t": "I",
+            "int32_t": "i",
+            "uint64_t": "K",
+            "int64_t": "L",
+        }[ty]
+
+    format = "iiiiiiiiiKKOOO" + ''.join([format_of(_extracted_type(ty)) for ty in signature.values()])
+
+    # generate glue code
+    src = f"""
+#include <Python.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef void (*KernelFn)({kernel_arg_decls}int32_t, int32_t, int32_t, int32_t, int32_t, int32_t);
+
+typedef struct {{
+  KernelFn fn;
+  {' '.join(f"{ty_to_cpp(signature[i])} arg{i};" for i in params)}
+}} Launch;
+
+typedef void (*ProgramFn)(void *args, int x, int y, int z, int gridX, int gridY, int gridZ);
+typedef void (*ParallelForFn)(ProgramFn fn, void *args, int gridX, int gridY, int gridZ);
+
+// `parallelFor` of the thread pool of `cpu_utils`
+static ParallelForFn parallelFor = NULL;
+
+static void runProgram(void *args, int x, int y, int z, int gridX, int gridY, int gridZ) {{
+  Launch *launch = (Launch *)args;
+  launch->fn({''.join(f"launch->arg{i}, " for i in params)}x, y, z, gridX, gridY, gridZ);
+}}
+
+typedef struct _DevicePtrInfo {{
+    uint64_t dev_ptr;
+    bool valid;
+}} DevicePtrInfo;
+
+static inline DevicePtrInfo getPointer(PyObject *obj, int idx) {{
+  DevicePtrInfo ptr_info;
+  ptr_info.dev_ptr = 0;
+  ptr_info.valid = true;
+  if (PyLong_Check(obj)) {{
+    ptr_info.dev_ptr = PyLong_AsUnsignedLongLong(obj);
+    return ptr_info;
+  }}
+  if (obj == Py_None) {{
+    // valid nullptr
+    return ptr_info;
+  }}
+  PyObject *is_cuda = PyObject_GetAttrString(obj, "is_cuda");
+  if (is_cuda) {{
+    int on_device = PyObject_IsTrue(is_cuda);
+    Py_DECREF(is_cuda);
+    if (on_device) {{
+      PyErr_Format(PyExc_ValueError,
+                   "Pointer argument (at %d) cannot be accessed from the CPU backend (device tensor?)", idx);
+      ptr_info.valid = false;
+      return ptr_info;
+    }}
+  }} else {{
+    PyErr_Clear();
+  }}
+  PyObject *ptr = PyObject_GetAttrString(obj, "data_ptr");
+  if(ptr){{
+    PyObject *empty_tuple = PyTuple_New(0);
+    PyObject *ret = PyObject_Call(ptr, empty_tuple, NULL);
+    Py_DECREF(empty_tuple);
+    Py_DECREF(ptr);
+    if (!PyLong_Check(ret)) {{
+      PyErr_SetString(PyExc_TypeError, "data_ptr method of Pointer object must return 64-bit int");
+      ptr_info.valid = false;
+      return ptr_info;
+    }}
+    ptr_info.dev_ptr = PyLong_AsUnsignedLongLong(ret);
+    Py_DECREF(ret);
+    return ptr_info;
+  }}
+  PyErr_SetString(PyExc_TypeError, "Pointer argument must be either uint64 or have data_ptr method");
+  ptr_info.valid = false;
+  return ptr_info;
+}}
+
+static PyObject* launch(PyObject* self, PyObject* args) {{
+  int gridX, gridY, gridZ;
+  uint64_t _stream;
+  uint64_t _function;
+  int num_warps;
+  int num_ctas;
+  int clusterDimX;
+  int clusterDimY;
+  int clusterDimZ;
+  int shared_memory;
+  PyObject *launch_enter_hook = NULL;
+  PyObject *launch_exit_hook = NULL;
+  PyObject *compiled_kernel = NULL;
+  {' '.join([f"{_extracted_type(ty)} _arg{i}; " for i, ty in signature.items()])}
+  if(!PyArg_ParseTuple(args, \"{format}\", &gridX, &gridY, &gridZ, &num_warps, &num_ctas, &clusterDimX, &clusterDimY, &clusterDimZ, &shared_memory, &_stream, &_function, &launch_enter_hook, &launch_exit_hook, &compiled_kernel{', ' + ', '.join(f"&_arg{i}" for i, ty in signature.items()) if len(signature) > 0 else ''})) {{
+    return NULL;
+  }}
+
+  if (launch_enter_hook != Py_None && !PyObject_CallObject(launch_enter_hook, args)) {{
+    return NULL;
+  }}
+
+
+  // raise exception asap
+  {"; ".join([f"DevicePtrInfo ptr_info{i} = getPointer(_arg{i}, {i}); if (!ptr_info{i}.valid) return NULL;" if ty[0] == "*" else "" for i, ty in signature.items()])};
+  Launch program_args;
+  program_args.fn = (KernelFn)_function;
+  {' '.join(f"program_args.arg{i} = {f'ptr_info{i}.dev_ptr' if signature[i][0] == '*' else f'_arg{i}'};" for i in params)}
+  Py_BEGIN_ALLOW_THREADS;
+  parallelFor(runProgram, &program_args, gridX, gridY, gridZ);
+  Py_END_ALLOW_THREADS;
+  if (PyErr_Occurred()) {{
+    return NULL;
+  }}
+
+  if (launch_exit_hook != Py_None && !PyObject_CallObject(launch_exit_hook, args)) {{
+    return NULL;
+  }}
+
+  // return None
+  Py_INCREF(Py_None);
+  return Py_None;
+}}
+
+static PyObject* set_parallel_for(PyObject* self, PyObject* args) {{
+  uint64_t _parallel_for;
+  if(!PyArg_ParseTuple(args, "K", &_parallel_for)) {{
+    return NULL;
+  }}
+  parallelFor = (ParallelForFn)_parallel_for;
+  Py_INCREF(Py_None);
+  return Py_None;
+}}
+
+static PyMethodDef ModuleMethods[] = {{
+  {{"launch", launch, METH_VARARGS, "Entry point for all kernels with this signature"}},
+  {{"set_parallel_for", set_parallel_for, METH_VARARGS, "Set the function running the programs of the launches"}},
+  {{NULL, NULL, 0, NULL}} // sentinel
+}};
+
+static struct PyModuleDef ModuleDef = {{
+  PyModuleDef_HEAD_INIT,
+  \"__triton_launcher\",
+  NULL, //documentation
+  -1, //size
+  ModuleMethods
+}};
+
+PyMODINIT_FUNC PyInit___triton_launcher(void) {{
+  PyObject *m = PyModule_Create(&ModuleDef);
+  if(m == NULL) {{
+    return NULL;
+  }}
+  PyModule_AddFunctions(m, ModuleMethods);
+  return m;
+}}
+"""
+    return src
+
+
+class CPULauncher(object):
+
+    def __init__(self, src, metadata):
+        ids = {
+            "ids_of_folded_args": metadata.ids_of_folded_args,
+            "ids_of_const_exprs": src.fn.constexprs if hasattr(src, "fn") else tuple()
+        }
+        constants = src.constants if hasattr(src, "constants") else dict()
+        signature = dict(src.signature)
+        src = make_launcher(constants, signature, ids)
+        mod = compile_module_from_src(src, "__triton_launcher")
+        mod.set_parallel_for(CPUUtils().parallel_for)
+        self.launch = mod.launch
+
+    def __call__(self, *args, **kwargs):
+        self.launch(*args, **kwargs)
+
+
+class CPUDriver(DriverBase):
+
+    # chosen over the GPU drivers when active, see `_create_driver`
+    opt_in = True
+
+    def __init__(self):
+        super().__init__()
+        self.utils = CPUUtils()
+        self.binary_ext = "so"
+        self.launcher_cls = CPULauncher
+
+    @staticmethod
+    def is_active():
+        # the kernels are only compiled for the CPU on request
+        return os.environ.get("TRITON_CPU_BACKEND", "0") == "1"
+
+    def get_current_device(self):
+        return 0
+
+    def set_current_device(self, device):
+        assert device == 0, "the CPU backend has a single device"
+
+    def get_current_stream(self, device=None):
+        return 0
+
+    def get_device_name(self, device=None):
+        return "cpu"
+
+    def get_current_target(self):
+        from triton._C.libtriton import cpu
+        return ("cpu", cpu.get_host_target()[1])
+
+    # TODO: remove once TMA is cleaned up
+    def assemble_tensormap_to_arg(self, tensormaps_info, args):
+        return args
+
+    def launch_batch(self, launches):
+        for launcher, args in launches:
+            launcher(*args)
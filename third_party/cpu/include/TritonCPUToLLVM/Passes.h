@@ -0,0 +1,17 @@
+#ifndef TRITONCPU_CONVERSION_PASSES_H
+#define TRITONCPU_CONVERSION_PASSES_H
+
+#include "mlir/IR/BuiltinOps.h"
+#include "mlir/Pass/Pass.h"
+
+namespace mlir {
+namespace triton {
+namespace cpu {
+
+std::unique_ptr<OperationPass<ModuleOp>> createConvertTritonToVectorPass();
+
+} // namespace cpu
+} // namespace triton
+} // namespace mlir
+
+#endif
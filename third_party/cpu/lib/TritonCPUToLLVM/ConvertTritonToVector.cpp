@@ -0,0 +1,1233 @@
+#include "TritonCPUToLLVM/Passes.h"
+
+#include "mlir/Dialect/Arith/IR/Arith.h"
+#include "mlir/Dialect/ControlFlow/IR/ControlFlowOps.h"
+#include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/Dialect/Func/Transforms/FuncConversions.h"
+#include "mlir/Dialect/LLVMIR/LLVMDialect.h"
+#include "mlir/Dialect/LLVMIR/LLVMTypes.h"
+#include "mlir/Dialect/Math/IR/Math.h"
+#include "mlir/Dialect/SCF/IR/SCF.h"
+#include "mlir/Dialect/SCF/Transforms/Patterns.h"
+#include "mlir/Dialect/Vector/IR/VectorOps.h"
+#include "mlir/Dialect/Vector/Transforms/LoweringPatterns.h"
+#include "mlir/Dialect/Vector/Transforms/VectorTransforms.h"
+#include "mlir/IR/IRMapping.h"
+#include "mlir/Pass/Pass.h"
+#include "mlir/Transforms/DialectConversion.h"
+#include "mlir/Transforms/GreedyPatternRewriteDriver.h"
+#include "triton/Analysis/AxisInfo.h"
+#include "triton/Dialect/Triton/IR/Dialect.h"
+#include "llvm/ADT/bit.h"
+
+namespace mlir {
+namespace triton {
+namespace cpu {
+#define GEN_PASS_DECL_CONVERTTRITONTOVECTOR
+#define GEN_PASS_DEF_CONVERTTRITONTOVECTOR
+#include "TritonCPUToLLVM/Passes.h.inc"
+} // namespace cpu
+} // namespace triton
+} // namespace mlir
+
+//===----------------------------------------------------------------------===//
+// This pass lowers the TTIR of a kernel for the host CPU, on which a program
+// is run by a single thread. Tensors become vectors of the same shape, which
+// the vector and LLVM dialects lower to the SIMD instructions of the host, and
+// pointers become i64 addresses. The accesses to the elements that are
+// contiguous along the innermost dimension are vectorized by the axis
+// analysis; the others are gathers and scatters. The ids and the numbers of
+// programs, which the launcher provides, are passed to every function after
+// its arguments.
+//===----------------------------------------------------------------------===//
+
+using namespace mlir;
+
+namespace {
+
+// The trailing arguments of the functions: the program ids along x, y and z,
+// then the numbers of programs along x, y and z
+constexpr unsigned kNumProgramArgs = 6;
+
+class TritonCPUTypeConverter : public TypeConverter {
+public:
+  TritonCPUTypeConverter() {
+    addConversion([](Type type) { return type; });
+    addConversion([](triton::PointerType type) -> Type {
+      return IntegerType::get(type.getContext(), 64);
+    });
+    addConversion([this](RankedTensorType type) -> Type {
+      return VectorType::get(type.getShape(),
+                             convertType(type.getElementType()));
+    });
+    auto materialize = [](OpBuilder &builder, Type type, ValueRange inputs,
+                          Location loc) -> std::optional<Value> {
+      return builder.create<UnrealizedConversionCastOp>(loc, type, inputs)
+          .getResult(0);
+    };
+    addSourceMaterialization(materialize);
+    addTargetMaterialization(materialize);
+    addArgumentMaterialization(materialize);
+  }
+};
+
+// How the loads and stores through a tensor of pointers access memory: runs
+// of `vecSize` contiguous elements along the innermost dimension, aligned to
+// `alignment` bytes. Runs of 1 element are gathered or scattered.
+struct AccessInfo {
+  unsigned vecSize = 1;
+  unsigned alignment = 1;
+};
+
+using AccessInfoMap = DenseMap<Operation *, AccessInfo>;
+
+unsigned getPointeeBytes(Type ptrType) {
+  Type pointeeType = getElementTypeOrSelf(ptrType)
+                         .cast<triton::PointerType>()
+                         .getPointeeType();
+  if (pointeeType.isa<triton::PointerType>())
+    return 8;
+  return std::max<unsigned>(pointeeType.getIntOrFloatBitWidth() / 8, 1);
+}
+
+AccessInfo getAccessInfo(ModuleAxisInfoAnalysis &axisInfoAnalysis, Value ptr) {
+  AccessInfo info;
+  info.alignment = getPointeeBytes(ptr.getType());
+  auto tensorType = ptr.getType().dyn_cast<RankedTensorType>();
+  AxisInfo *axisInfo = axisInfoAnalysis.getAxisInfo(ptr);
+  if (!tensorType || !axisInfo)
+    return info;
+  unsigned dim = tensorType.getRank() - 1;
+  int64_t contiguity = std::min<int64_t>(axisInfo->getContiguity(dim),
+                                         tensorType.getShape()[dim]);
+  info.vecSize = llvm::bit_floor<uint64_t>(std::max<int64_t>(contiguity, 1));
+  // The pointer divisibility is in bytes
+  int64_t runBytes = int64_t(info.vecSize) * info.alignment;
+  info.alignment = std::max<int64_t>(
+      info.alignment, std::min(axisInfo->getDivisibility(dim), runBytes));
+  return info;
+}
+
+Type getPointerType(MLIRContext *context) {
+  return LLVM::LLVMPointerType::get(context);
+}
+
+Value getProgramArg(Operation *op, unsigned index) {
+  auto funcOp = op->getParentOfType<func::FuncOp>();
+  return funcOp.getArguments().take_back(kNumProgramArgs)[index];
+}
+
+Value createZero(OpBuilder &builder, Location loc, Type type) {
+  return builder.create<arith::ConstantOp>(loc, builder.getZeroAttr(type));
+}
+
+Value createIndex(OpBuilder &builder, Location loc, int64_t value) {
+  return builder.create<arith::ConstantIndexOp>(loc, value);
+}
+
+// Reshapes `value` to `type`, which has the same number of elements, in
+// row-major order. Shape casts between vectors of any shapes go through 1-D.
+Value reshape(OpBuilder &builder, Location loc, Value value, VectorType type) {
+  auto srcType = value.getType().cast<VectorType>();
+  if (srcType == type)
+    return value;
+  if (srcType.getRank() != 1 && type.getRank() != 1)
+    value = builder.create<vector::ShapeCastOp>(
+        loc, VectorType::get(srcType.getNumElements(), type.getElementType()),
+        value);
+  return builder.create<vector::ShapeCastOp>(loc, type, value);
+}
+
+Value flatten(OpBuilder &builder, Location loc, Value value) {
+  auto type = value.getType().cast<VectorType>();
+  return reshape(builder, loc, value,
+                 VectorType::get(type.getNumElements(), type.getElementType()));
+}
+
+// Converts the elements of the vector `value` to `elemType`, of the same kind
+// (integer or float)
+Value castElements(OpBuilder &builder, Location loc, Value value,
+                   Type elemType) {
+  auto type = value.getType().cast<VectorType>();
+  Type srcElemType = type.getElementType();
+  if (srcElemType == elemType)
+    return value;
+  VectorType dstType = type.clone(elemType);
+  bool extend =
+      srcElemType.getIntOrFloatBitWidth() < elemType.getIntOrFloatBitWidth();
+  if (elemType.isa<FloatType>()) {
+    if (extend)
+      return builder.create<arith::ExtFOp>(loc, dstType, value);
+    return builder.create<arith::TruncFOp>(loc, dstType, value);
+  }
+  if (extend)
+    return builder.create<arith::ExtSIOp>(loc, dstType, value);
+  return builder.create<arith::TruncIOp>(loc, dstType, value);
+}
+
+//===----------------------------------------------------------------------===//
+// Arith and math
+//===----------------------------------------------------------------------===//
+
+// The elementwise ops of arith and math only change types
+struct ElementwiseOpConversion : public ConversionPattern {
+  ElementwiseOpConversion(TypeConverter &typeConverter, MLIRContext *context)
+      : ConversionPattern(typeConverter, MatchAnyOpTypeTag(), /*benefit=*/1,
+                          context) {}
+
+  LogicalResult
+  matchAndRewrite(Operation *op, ArrayRef<Value> operands,
+                  ConversionPatternRewriter &rewriter) const override {
+    if (!isa<arith::ArithDialect, math::MathDialect>(op->getDialect()) ||
+        isa<arith::ConstantOp>(op) || op->getNumRegions() != 0)
+      return failure();
+    SmallVector<Type> resultTypes;
+    if (failed(getTypeConverter()->convertTypes(op->getResultTypes(),
+                                                resultTypes)))
+      return failure();
+    OperationState state(op->getLoc(), op->getName().getStringRef(), operands,
+                         resultTypes, op->getAttrs());
+    rewriter.replaceOp(op, rewriter.create(state)->getResults());
+    return success();
+  }
+};
+
+struct ArithConstantConversion : public OpConversionPattern<arith::ConstantOp> {
+  using OpConversionPattern<arith::ConstantOp>::OpConversionPattern;
+
+  LogicalResult
+  matchAndRewrite(arith::ConstantOp op, OpAdaptor adaptor,
+                  ConversionPatternRewriter &rewriter) const override {
+    auto type =
+        getTypeConverter()->convertType(op.getType()).cast<VectorType>();
+    auto value = adaptor.getValue().cast<DenseElementsAttr>();
+    if (value.getElementType().isInteger(1) && value.isSplat())
+      // Workaround until https://reviews.llvm.org/D133743 is included.
+      value = DenseElementsAttr::get(type, value.getSplatValue<bool>());
+    else
+      value = value.reshape(type);
+    rewriter.replaceOpWithNewOp<arith::ConstantOp>(op, type, value);
+    return success();
+  }
+};
+
+//===----------------------------------------------------------------------===//
+// Functions and programs
+//===----------------------------------------------------------------------===//
+
+struct FuncOpConversion : public OpConversionPattern<triton::FuncOp> {
+  using OpConversionPattern<triton::FuncOp>::OpConversionPattern;
+
+  LogicalResult
+  matchAndRewrite(triton::FuncOp op, OpAdaptor adaptor,
+                  ConversionPatternRewriter &rewriter) const override {
+    const TypeConverter *converter = getTypeConverter();
+    FunctionType type = op.getFunctionType();
+    TypeConverter::SignatureConversion signature(type.getNumInputs());
+    SmallVector<Type> resultTypes;
+    if (failed(converter->convertSignatureArgs(type.getInputs(), signature)) ||
+        failed(converter->convertTypes(type.getResults(), resultTypes)))
+      return failure();
+    signature.addInputs(
+        SmallVector<Type>(kNumProgramArgs, rewriter.getI32Type()));
+    auto newOp = rewriter.create<func::FuncOp>(
+        op.getLoc(), op.getName(),
+        rewriter.getFunctionType(signature.getConvertedTypes(), resultTypes));
+    newOp.setVisibility(op.getVisibility());
+    // Only the kernel is exported by the shared library of the kernel
+    if (!op.isPublic())
+      newOp->setAttr("llvm.linkage",
+                     LLVM::LinkageAttr::get(getContext(),
+                                            LLVM::Linkage::Internal));
+    rewriter.inlineRegionBefore(op.getBody(), newOp.getBody(), newOp.end());
+    if (failed(rewriter.convertRegionTypes(&newOp.getBody(), *converter,
+                                           &signature)))
+      return failure();
+    rewriter.eraseOp(op);
+    return success();
+  }
+};
+
+struct CallOpConversion : public OpConversionPattern<triton::CallOp> {
+  using OpConversionPattern<triton::CallOp>::OpConversionPattern;
+
+  LogicalResult
+  matchAndRewrite(triton::CallOp op, OpAdaptor adaptor,
+                  ConversionPatternRewriter &rewriter) const override {
+    SmallVector<Type> resultTypes;
+    if (failed(getTypeConverter()->convertTypes(op.getResultTypes(),
+                                                resultTypes)))
+      return failure();
+    SmallVector<Value> operands(adaptor.getOperands());
+    for (unsigned i = 0; i < kNumProgramArgs; ++i)
+      operands.push_back(getProgramArg(op, i));
+    rewriter.replaceOpWithNewOp<func::CallOp>(op, op.getCallee(), resultTypes,
+                                              operands);
+    return success();
+  }
+};
+
+struct ReturnOpConversion : public OpConversionPattern<triton::ReturnOp> {
+  using OpConversionPattern<triton::ReturnOp>::OpConversionPattern;
+
+  LogicalResult
+  matchAndRewrite(triton::ReturnOp op, OpAdaptor adaptor,
+                  ConversionPatternRewriter &rewriter) const override {
+    rewriter.replaceOpWithNewOp<func::ReturnOp>(op, adaptor.getOperands());
+    return success();
+  }
+};
+
+struct GetProgramIdOpConversion
+    : public OpConversionPattern<triton::GetProgramIdOp> {
+  using OpConversionPattern<triton::GetProgramIdOp>::OpConversionPattern;
+
+  LogicalResult
+  matchAndRewrite(triton::GetProgramIdOp op, OpAdaptor adaptor,
+                  ConversionPatternRewriter &rewriter) const override {
+    rewriter.replaceOp(op, getProgramArg(op, op.getAxisAsInt()));
+    return success();
+  }
+};
+
+struct GetNumProgramsOpConversion
+    : public OpConversionPattern<triton::GetNumProgramsOp> {
+  using OpConversionPattern<triton::GetNumProgramsOp>::OpConversionPattern;
+
+  LogicalResult
+  matchAndRewrite(triton::GetNumProgramsOp op, OpAdaptor adaptor,
+                  ConversionPatternRewriter &rewriter) const override {
+    rewriter.replaceOp(op, getProgramArg(op, 3 + op.getAxis()));
+    return success();
+  }
+};
+
+//===----------------------------------------------------------------------===//
+// Shapes
+//===----------------------------------------------------------------------===//
+
+template <typename OpTy>
+struct BroadcastLikeOpConversion : public OpConversionPattern<OpTy> {
+  using OpConversionPattern<OpTy>::OpConversionPattern;
+
+  LogicalResult
+  matchAndRewrite(OpTy op, typename OpTy::Adaptor adaptor,
+                  ConversionPatternRewriter &rewriter) const override {
+    auto type = this->getTypeConverter()->convertType(op.getType());
+    rewriter.replaceOpWithNewOp<vector::BroadcastOp>(op, type,
+                                                     adaptor.getSrc());
+    return success();
+  }
+};
+
+template <typename OpTy>
+struct ReshapeLikeOpConversion : public OpConversionPattern<OpTy> {
+  using OpConversionPattern<OpTy>::OpConversionPattern;
+
+  LogicalResult
+  matchAndRewrite(OpTy op, typename OpTy::Adaptor adaptor,
+                  ConversionPatternRewriter &rewriter) const override {
+    auto type = this->getTypeConverter()
+                    ->convertType(op.getType())
+                    .template cast<VectorType>();
+    rewriter.replaceOp(op,
+                       reshape(rewriter, op.getLoc(), adaptor.getSrc(), type));
+    return success();
+  }
+};
+
+struct TransOpConversion : public OpConversionPattern<triton::TransOp> {
+  using OpConversionPattern<triton::TransOp>::OpConversionPattern;
+
+  LogicalResult
+  matchAndRewrite(triton::TransOp op, OpAdaptor adaptor,
+                  ConversionPatternRewriter &rewriter) const override {
+    int64_t rank = op.getType().getRank();
+    SmallVector<int64_t> permutation;
+    for (int64_t i = rank - 1; i >= 0; --i)
+      permutation.push_back(i);
+    rewriter.replaceOpWithNewOp<vector::TransposeOp>(op, adaptor.getSrc(),
+                                                     permutation);
+    return success();
+  }
+};
+
+struct MakeRangeOpConversion
+    : public OpConversionPattern<triton::MakeRangeOp> {
+  using OpConversionPattern<triton::MakeRangeOp>::OpConversionPattern;
+
+  LogicalResult
+  matchAndRewrite(triton::MakeRangeOp op, OpAdaptor adaptor,
+                  ConversionPatternRewriter &rewriter) const override {
+    auto type =
+        getTypeConverter()->convertType(op.getType()).cast<VectorType>();
+    SmallVector<int32_t> values;
+    for (int32_t i = op.getStart(); i < int32_t(op.getEnd()); ++i)
+      values.push_back(i);
+    rewriter.replaceOpWithNewOp<arith::ConstantOp>(
+        op, type, DenseElementsAttr::get(type, ArrayRef<int32_t>(values)));
+    return success();
+  }
+};
+
+// Shuffles the elements of the flattened `lhs` and `rhs`, indexed from `lhs`
+// then `rhs`, into a vector of `type`
+Value shuffle(OpBuilder &builder, Location loc, Value lhs, Value rhs,
+              ArrayRef<int64_t> mask, VectorType type) {
+  Value result = builder.create<vector::ShuffleOp>(
+      loc, flatten(builder, loc, lhs), flatten(builder, loc, rhs), mask);
+  return reshape(builder, loc, result, type);
+}
+
+// Joins and interleaves take the elements of their operands in turn
+template <typename OpTy>
+struct InterleaveLikeOpConversion : public OpConversionPattern<OpTy> {
+  using OpConversionPattern<OpTy>::OpConversionPattern;
+
+  LogicalResult
+  matchAndRewrite(OpTy op, typename OpTy::Adaptor adaptor,
+                  ConversionPatternRewriter &rewriter) const override {
+    auto type = this->getTypeConverter()
+                    ->convertType(op.getType())
+                    .template cast<VectorType>();
+    int64_t numElems = op.getLhs().getType().getNumElements();
+    SmallVector<int64_t> mask;
+    for (int64_t i = 0; i < numElems; ++i) {
+      mask.push_back(i);
+      mask.push_back(numElems + i);
+    }
+    rewriter.replaceOp(op, shuffle(rewriter, op.getLoc(), adaptor.getLhs(),
+                                   adaptor.getRhs(), mask, type));
+    return success();
+  }
+};
+
+struct SplitOpConversion : public OpConversionPattern<triton::SplitOp> {
+  using OpConversionPattern<triton::SplitOp>::OpConversionPattern;
+
+  LogicalResult
+  matchAndRewrite(triton::SplitOp op, OpAdaptor adaptor,
+                  ConversionPatternRewriter &rewriter) const override {
+    auto type = getTypeConverter()
+                    ->convertType(op.getOutLHS().getType())
+                    .cast<VectorType>();
+    SmallVector<Value> results;
+    for (int64_t half = 0; half < 2; ++half) {
+      SmallVector<int64_t> mask;
+      for (int64_t i = 0; i < type.getNumElements(); ++i)
+        mask.push_back(2 * i + half);
+      results.push_back(shuffle(rewriter, op.getLoc(), adaptor.getSrc(),
+                                adaptor.getSrc(), mask, type));
+    }
+    rewriter.replaceOp(op, results);
+    return success();
+  }
+};
+
+// Concatenates along the first dimension, which is the concatenation of the
+// flattened operands
+struct CatOpConversion : public OpConversionPattern<triton::CatOp> {
+  using OpConversionPattern<triton::CatOp>::OpConversionPattern;
+
+  LogicalResult
+  matchAndRewrite(triton::CatOp op, OpAdaptor adaptor,
+                  ConversionPatternRewriter &rewriter) const override {
+    auto type =
+        getTypeConverter()->convertType(op.getType()).cast<VectorType>();
+    auto mask = llvm::to_vector(llvm::seq<int64_t>(0, type.getNumElements()));
+    rewriter.replaceOp(op, shuffle(rewriter, op.getLoc(), adaptor.getLhs(),
+                                   adaptor.getRhs(), mask, type));
+    return success();
+  }
+};
+
+//===----------------------------------------------------------------------===//
+// Elementwise
+//===----------------------------------------------------------------------===//
+
+struct AddPtrOpConversion : public OpConversionPattern<triton::AddPtrOp> {
+  using OpConversionPattern<triton::AddPtrOp>::OpConversionPattern;
+
+  LogicalResult
+  matchAndRewrite(triton::AddPtrOp op, OpAdaptor adaptor,
+                  ConversionPatternRewriter &rewriter) const override {
+    Location loc = op.getLoc();
+    Type type = getTypeConverter()->convertType(op.getType());
+    Value offset = adaptor.getOffset();
+    if (getElementTypeOrSelf(offset.getType()).getIntOrFloatBitWidth() < 64)
+      offset = rewriter.create<arith::ExtSIOp>(loc, type, offset);
+    TypedAttr scale = rewriter.getI64IntegerAttr(getPointeeBytes(op.getType()));
+    if (auto vectorType = type.dyn_cast<VectorType>())
+      scale = SplatElementsAttr::get(vectorType, scale).cast<TypedAttr>();
+    offset = rewriter.create<arith::MulIOp>(
+        loc, offset, rewriter.create<arith::ConstantOp>(loc, scale));
+    rewriter.replaceOpWithNewOp<arith::AddIOp>(op, adaptor.getPtr(), offset);
+    return success();
+  }
+};
+
+// Pointers are i64 already
+template <typename OpTy>
+struct PtrCastOpConversion : public OpConversionPattern<OpTy> {
+  using OpConversionPattern<OpTy>::OpConversionPattern;
+
+  LogicalResult
+  matchAndRewrite(OpTy op, typename OpTy::Adaptor adaptor,
+                  ConversionPatternRewriter &rewriter) const override {
+    rewriter.replaceOp(op, adaptor.getFrom());
+    return success();
+  }
+};
+
+struct BitcastOpConversion : public OpConversionPattern<triton::BitcastOp> {
+  using OpConversionPattern<triton::BitcastOp>::OpConversionPattern;
+
+  LogicalResult
+  matchAndRewrite(triton::BitcastOp op, OpAdaptor adaptor,
+                  ConversionPatternRewriter &rewriter) const override {
+    Type type = getTypeConverter()->convertType(op.getType());
+    if (type == adaptor.getFrom().getType())
+      rewriter.replaceOp(op, adaptor.getFrom());
+    else
+      rewriter.replaceOpWithNewOp<arith::BitcastOp>(op, type,
+                                                    adaptor.getFrom());
+    return success();
+  }
+};
+
+// The conversions with a custom rounding or from and to fp8 are rejected
+// before the conversion
+struct FpToFpOpConversion : public OpConversionPattern<triton::FpToFpOp> {
+  using OpConversionPattern<triton::FpToFpOp>::OpConversionPattern;
+
+  LogicalResult
+  matchAndRewrite(triton::FpToFpOp op, OpAdaptor adaptor,
+                  ConversionPatternRewriter &rewriter) const override {
+    Type type = getTypeConverter()->convertType(op.getType());
+    unsigned srcBits =
+        getElementTypeOrSelf(op.getFrom().getType()).getIntOrFloatBitWidth();
+    unsigned dstBits = getElementTypeOrSelf(type).getIntOrFloatBitWidth();
+    if (srcBits < dstBits)
+      rewriter.replaceOpWithNewOp<arith::ExtFOp>(op, type, adaptor.getFrom());
+    else
+      rewriter.replaceOpWithNewOp<arith::TruncFOp>(op, type,
+                                                   adaptor.getFrom());
+    return success();
+  }
+};
+
+struct ClampFOpConversion : public OpConversionPattern<triton::ClampFOp> {
+  using OpConversionPattern<triton::ClampFOp>::OpConversionPattern;
+
+  LogicalResult
+  matchAndRewrite(triton::ClampFOp op, OpAdaptor adaptor,
+                  ConversionPatternRewriter &rewriter) const override {
+    Location loc = op.getLoc();
+    Value result;
+    if (op.getPropagateNan() == triton::PropagateNan::ALL) {
+      result = rewriter.create<arith::MaximumFOp>(loc, adaptor.getX(),
+                                                  adaptor.getMin());
+      result = rewriter.create<arith::MinimumFOp>(loc, result,
+                                                  adaptor.getMax());
+    } else {
+      result = rewriter.create<arith::MaxNumFOp>(loc, adaptor.getX(),
+                                                 adaptor.getMin());
+      result =
+          rewriter.create<arith::MinNumFOp>(loc, result, adaptor.getMax());
+    }
+    rewriter.replaceOp(op, result);
+    return success();
+  }
+};
+
+//===----------------------------------------------------------------------===//
+// Dots
+//===----------------------------------------------------------------------===//
+
+// Multiplies the matrices, or the batches of matrices, `a` and `b` into `c`.
+// The operands are converted to the element type of `c` first.
+Value createContraction(OpBuilder &builder, Location loc, Value a, Value b,
+                        Value c) {
+  Type elemType = c.getType().cast<VectorType>().getElementType();
+  a = castElements(builder, loc, a, elemType);
+  b = castElements(builder, loc, b, elemType);
+  MLIRContext *context = builder.getContext();
+  unsigned numBatchDims = c.getType().cast<VectorType>().getRank() - 2;
+  SmallVector<AffineExpr> batchDims;
+  for (unsigned i = 0; i < numBatchDims; ++i)
+    batchDims.push_back(getAffineDimExpr(i, context));
+  AffineExpr m = getAffineDimExpr(numBatchDims, context);
+  AffineExpr n = getAffineDimExpr(numBatchDims + 1, context);
+  AffineExpr k = getAffineDimExpr(numBatchDims + 2, context);
+  auto getExprs = [&](AffineExpr row, AffineExpr col) {
+    SmallVector<AffineExpr> exprs(batchDims);
+    exprs.push_back(row);
+    exprs.push_back(col);
+    return exprs;
+  };
+  SmallVector<AffineExpr> aExprs = getExprs(m, k);
+  SmallVector<AffineExpr> bExprs = getExprs(k, n);
+  SmallVector<AffineExpr> cExprs = getExprs(m, n);
+  SmallVector<vector::IteratorType> iteratorTypes(
+      numBatchDims + 2, vector::IteratorType::parallel);
+  iteratorTypes.push_back(vector::IteratorType::reduction);
+  return builder.create<vector::ContractionOp>(
+      loc, a, b, c, ArrayRef<ArrayRef<AffineExpr>>{aExprs, bExprs, cExprs},
+      iteratorTypes);
+}
+
+struct DotOpConversion : public OpConversionPattern<triton::DotOp> {
+  using OpConversionPattern<triton::DotOp>::OpConversionPattern;
+
+  LogicalResult
+  matchAndRewrite(triton::DotOp op, OpAdaptor adaptor,
+                  ConversionPatternRewriter &rewriter) const override {
+    rewriter.replaceOp(op,
+                       createContraction(rewriter, op.getLoc(), adaptor.getA(),
+                                         adaptor.getB(), adaptor.getC()));
+    return success();
+  }
+};
+
+//===----------------------------------------------------------------------===//
+// Reductions and scans
+//===----------------------------------------------------------------------===//
+
+// Applies the combine region of a reduction or a scan to the elements of the
+// vectors `lhs` and `rhs`, of the same shape, by cloning its ops on vectors.
+// The scalars the region uses, e.g. its constants, are broadcast. The regions
+// are checked to only hold arith and math ops before the conversion.
+SmallVector<Value> applyCombineOp(OpBuilder &builder, Location loc,
+                                  Region &combineOp, ValueRange lhs,
+                                  ValueRange rhs) {
+  auto type = lhs.front().getType().cast<VectorType>();
+  Block &block = combineOp.front();
+  IRMapping mapping;
+  mapping.map(block.getArguments().take_front(lhs.size()), lhs);
+  mapping.map(block.getArguments().drop_front(lhs.size()), rhs);
+  auto vectorize = [&](Value value) -> Value {
+    Value mapped = mapping.lookupOrDefault(value);
+    if (mapped.getType().isa<VectorType>())
+      return mapped;
+    return builder.create<vector::BroadcastOp>(
+        loc, type.clone(mapped.getType()), mapped);
+  };
+  for (Operation &op : block.without_terminator()) {
+    if (op.hasTrait<OpTrait::ConstantLike>()) {
+      builder.clone(op, mapping);
+      continue;
+    }
+    SmallVector<Value> operands;
+    for (Value operand : op.getOperands())
+      operands.push_back(vectorize(operand));
+    SmallVector<Type> resultTypes;
+    for (Type resultType : op.getResultTypes())
+      resultTypes.push_back(type.clone(resultType));
+    OperationState state(loc, op.getName().getStringRef(), operands,
+                         resultTypes, op.getAttrs());
+    mapping.map(op.getResults(), builder.create(state)->getResults());
+  }
+  SmallVector<Value> results;
+  for (Value result : block.getTerminator()->getOperands())
+    results.push_back(vectorize(result));
+  return results;
+}
+
+// Returns the permutation moving `axis` of a vector of `rank` dimensions to
+// `newAxis`, keeping the order of the other dimensions
+SmallVector<int64_t> getAxisPermutation(int64_t rank, int64_t axis,
+                                        int64_t newAxis) {
+  SmallVector<int64_t> permutation;
+  for (int64_t i = 0; i < rank; ++i)
+    if (i != axis)
+      permutation.push_back(i);
+  permutation.insert(permutation.begin() + newAxis, axis);
+  return permutation;
+}
+
+SmallVector<int64_t> invertPermutation(ArrayRef<int64_t> permutation) {
+  SmallVector<int64_t> inverse(permutation.size());
+  for (auto [i, dim] : llvm::enumerate(permutation))
+    inverse[dim] = i;
+  return inverse;
+}
+
+// Reduces along the axis by combining the two halves of the operands until
+// one element is left. The axis is moved to the front first, so that the
+// halves are slices of the leading dimension. Triton tensors always have a
+// power-of-two number of elements along each dimension.
+struct ReduceOpConversion : public OpConversionPattern<triton::ReduceOp> {
+  using OpConversionPattern<triton::ReduceOp>::OpConversionPattern;
+
+  LogicalResult
+  matchAndRewrite(triton::ReduceOp op, OpAdaptor adaptor,
+                  ConversionPatternRewriter &rewriter) const override {
+    Location loc = op.getLoc();
+    int64_t axis = op.getAxis();
+    SmallVector<Value> values(adaptor.getOperands());
+    auto type = values.front().getType().cast<VectorType>();
+    if (axis != 0) {
+      SmallVector<int64_t> permutation =
+          getAxisPermutation(type.getRank(), axis, 0);
+      for (Value &value : values)
+        value = rewriter.create<vector::TransposeOp>(loc, value, permutation);
+    }
+    for (int64_t size = type.getShape()[axis]; size > 1; size /= 2) {
+      SmallVector<Value> lhs, rhs;
+      for (Value value : values) {
+        lhs.push_back(rewriter.create<vector::ExtractStridedSliceOp>(
+            loc, value, ArrayRef<int64_t>{0}, ArrayRef<int64_t>{size / 2},
+            ArrayRef<int64_t>{1}));
+        rhs.push_back(rewriter.create<vector::ExtractStridedSliceOp>(
+            loc, value, ArrayRef<int64_t>{size / 2},
+            ArrayRef<int64_t>{size / 2}, ArrayRef<int64_t>{1}));
+      }
+      values = applyCombineOp(rewriter, loc, op.getCombineOp(), lhs, rhs);
+    }
+    SmallVector<Value> results;
+    for (Value value : values)
+      results.push_back(
+          rewriter.create<vector::ExtractOp>(loc, value, ArrayRef<int64_t>{0}));
+    rewriter.replaceOp(op, results);
+    return success();
+  }
+};
+
+// Scans along the axis in log2(size) steps, each combining the elements with
+// the ones `offset` positions before them along the axis (Hillis and Steele).
+// The axis is moved to the back first, so that the elements before are
+// shuffled from the flattened operands.
+struct ScanOpConversion : public OpConversionPattern<triton::ScanOp> {
+  using OpConversionPattern<triton::ScanOp>::OpConversionPattern;
+
+  LogicalResult
+  matchAndRewrite(triton::ScanOp op, OpAdaptor adaptor,
+                  ConversionPatternRewriter &rewriter) const override {
+    Location loc = op.getLoc();
+    int64_t axis = op.getAxis();
+    SmallVector<Value> values(adaptor.getOperands());
+    auto type = values.front().getType().cast<VectorType>();
+    int64_t rank = type.getRank();
+    SmallVector<int64_t> permutation =
+        getAxisPermutation(rank, axis, rank - 1);
+    if (axis != rank - 1)
+      for (Value &value : values)
+        value = rewriter.create<vector::TransposeOp>(loc, value, permutation);
+    SmallVector<VectorType> types;
+    for (Value &value : values) {
+      types.push_back(value.getType().cast<VectorType>());
+      value = flatten(rewriter, loc, value);
+    }
+    int64_t size = type.getShape()[axis];
+    int64_t numElems = type.getNumElements();
+    for (int64_t offset = 1; offset < size; offset *= 2) {
+      SmallVector<int64_t> mask;
+      SmallVector<bool> hasPrev;
+      for (int64_t i = 0; i < numElems; ++i) {
+        hasPrev.push_back(i % size >= offset);
+        mask.push_back(hasPrev.back() ? i - offset : i);
+      }
+      SmallVector<Value> prev;
+      for (Value value : values)
+        prev.push_back(
+            rewriter.create<vector::ShuffleOp>(loc, value, value, mask));
+      SmallVector<Value> combined =
+          applyCombineOp(rewriter, loc, op.getCombineOp(), prev, values);
+      auto condType = VectorType::get(numElems, rewriter.getI1Type());
+      Value cond = rewriter.create<arith::ConstantOp>(
+          loc, condType, DenseElementsAttr::get(condType, hasPrev));
+      for (auto [value, result] : llvm::zip(values, combined))
+        value = rewriter.create<arith::SelectOp>(loc, cond, result, value);
+    }
+    for (auto [value, valueType] : llvm::zip(values, types)) {
+      value = reshape(rewriter, loc, value, valueType);
+      if (axis != rank - 1)
+        value = rewriter.create<vector::TransposeOp>(
+            loc, value, invertPermutation(permutation));
+    }
+    rewriter.replaceOp(op, values);
+    return success();
+  }
+};
+
+//===----------------------------------------------------------------------===//
+// Loads and stores
+//===----------------------------------------------------------------------===//
+
+Value toPointer(OpBuilder &builder, Location loc, Value address) {
+  return builder.create<LLVM::IntToPtrOp>(
+      loc, getPointerType(builder.getContext()), address);
+}
+
+Value extractRun(OpBuilder &builder, Location loc, Value value, int64_t start,
+                 int64_t size) {
+  return builder.create<vector::ExtractStridedSliceOp>(
+      loc, value, ArrayRef<int64_t>{start}, ArrayRef<int64_t>{size},
+      ArrayRef<int64_t>{1});
+}
+
+Value createAllTrue(OpBuilder &builder, Location loc, int64_t numElems) {
+  auto type = VectorType::get(numElems, builder.getI1Type());
+  return builder.create<arith::ConstantOp>(loc, type,
+                                           DenseElementsAttr::get(type, true));
+}
+
+// Runs `createAccess`, which returns the loaded value or null, under `mask`
+// if any. Returns the loaded value, or `other` when masked off.
+Value createMaskedScalarAccess(OpBuilder &builder, Location loc, Value mask,
+                               Value other, Type type,
+                               function_ref<Value(OpBuilder &)> createAccess) {
+  if (!mask)
+    return createAccess(builder);
+  auto ifOp = builder.create<scf::IfOp>(
+      loc, type ? TypeRange{type} : TypeRange{}, mask,
+      [&](OpBuilder &builder, Location loc) {
+        Value value = createAccess(builder);
+        builder.create<scf::YieldOp>(loc, value ? ValueRange{value}
+                                                : ValueRange{});
+      },
+      [&](OpBuilder &builder, Location loc) {
+        builder.create<scf::YieldOp>(loc, type ? ValueRange{other}
+                                               : ValueRange{});
+      });
+  return type ? ifOp.getResult(0) : Value();
+}
+
+struct LoadOpConversion : public OpConversionPattern<triton::LoadOp> {
+  LoadOpConversion(TypeConverter &typeConverter, MLIRContext *context,
+                   const AccessInfoMap &accessInfo)
+      : OpConversionPattern<triton::LoadOp>(typeConverter, context),
+        accessInfo(accessInfo) {}
+
+  LogicalResult
+  matchAndRewrite(triton::LoadOp op, OpAdaptor adaptor,
+                  ConversionPatternRewriter &rewriter) const override {
+    Location loc = op.getLoc();
+    Type type = getTypeConverter()->convertType(op.getType());
+    Value mask = adaptor.getMask();
+    Value other = adaptor.getOther();
+    if (!other)
+      other = createZero(rewriter, loc, type);
+    AccessInfo info = accessInfo.lookup(op);
+    auto vectorType = type.dyn_cast<VectorType>();
+    if (!vectorType) {
+      rewriter.replaceOp(
+          op, createMaskedScalarAccess(
+                  rewriter, loc, mask, other, type, [&](OpBuilder &builder) {
+                    return builder.create<LLVM::LoadOp>(
+                        loc, type, toPointer(builder, loc, adaptor.getPtr()),
+                        info.alignment);
+                  }));
+      return success();
+    }
+    int64_t numElems = vectorType.getNumElements();
+    Type elemType = vectorType.getElementType();
+    Value ptr = flatten(rewriter, loc, adaptor.getPtr());
+    if (mask)
+      mask = flatten(rewriter, loc, mask);
+    Value result = flatten(rewriter, loc, other);
+    if (info.vecSize == 1) {
+      Value ptrs = rewriter.create<LLVM::IntToPtrOp>(
+          loc,
+          LLVM::getFixedVectorType(getPointerType(getContext()), numElems),
+          ptr);
+      result = rewriter.create<LLVM::masked_gather>(
+          loc, result.getType(), ptrs,
+          mask ? mask : createAllTrue(rewriter, loc, numElems),
+          ValueRange{result}, rewriter.getI32IntegerAttr(info.alignment));
+    } else {
+      auto runType = VectorType::get(info.vecSize, elemType);
+      Value passThru = result;
+      for (int64_t start = 0; start < numElems; start += info.vecSize) {
+        Value address = toPointer(
+            rewriter, loc,
+            rewriter.create<vector::ExtractOp>(loc, ptr,
+                                               ArrayRef<int64_t>{start}));
+        Value run;
+        if (mask)
+          run = rewriter.create<LLVM::MaskedLoadOp>(
+              loc, runType, address,
+              extractRun(rewriter, loc, mask, start, info.vecSize),
+              extractRun(rewriter, loc, passThru, start, info.vecSize),
+              info.alignment);
+        else
+          run = rewriter.create<LLVM::LoadOp>(loc, runType, address,
+                                              info.alignment);
+        result = rewriter.create<vector::InsertStridedSliceOp>(
+            loc, run, result, ArrayRef<int64_t>{start}, ArrayRef<int64_t>{1});
+      }
+    }
+    rewriter.replaceOp(op, reshape(rewriter, loc, result, vectorType));
+    return success();
+  }
+
+private:
+  const AccessInfoMap &accessInfo;
+};
+
+struct StoreOpConversion : public OpConversionPattern<triton::StoreOp> {
+  StoreOpConversion(TypeConverter &typeConverter, MLIRContext *context,
+                    const AccessInfoMap &accessInfo)
+      : OpConversionPattern<triton::StoreOp>(typeConverter, context),
+        accessInfo(accessInfo) {}
+
+  LogicalResult
+  matchAndRewrite(triton::StoreOp op, OpAdaptor adaptor,
+                  ConversionPatternRewriter &rewriter) const override {
+    Location loc = op.getLoc();
+    Value value = adaptor.getValue();
+    Value mask = adaptor.getMask();
+    AccessInfo info = accessInfo.lookup(op);
+    auto vectorType = value.getType().dyn_cast<VectorType>();
+    if (!vectorType) {
+      createMaskedScalarAccess(rewriter, loc, mask, Value(), Type(),
+                               [&](OpBuilder &builder) {
+                                 builder.create<LLVM::StoreOp>(
+                                     loc, value,
+                                     toPointer(builder, loc, adaptor.getPtr()),
+                                     info.alignment);
+                                 return Value();
+                               });
+      rewriter.eraseOp(op);
+      return success();
+    }
+    int64_t numElems = vectorType.getNumElements();
+    Value ptr = flatten(rewriter, loc, adaptor.getPtr());
+    value = flatten(rewriter, loc, value);
+    if (mask)
+      mask = flatten(rewriter, loc, mask);
+    if (info.vecSize == 1) {
+      Value ptrs = rewriter.create<LLVM::IntToPtrOp>(
+          loc,
+          LLVM::getFixedVectorType(getPointerType(getContext()), numElems),
+          ptr);
+      rewriter.create<LLVM::masked_scatter>(
+          loc, value, ptrs,
+          mask ? mask : createAllTrue(rewriter, loc, numElems),
+          rewriter.getI32IntegerAttr(info.alignment));
+    } else {
+      for (int64_t start = 0; start < numElems; start += info.vecSize) {
+        Value address = toPointer(
+            rewriter, loc,
+            rewriter.create<vector::ExtractOp>(loc, ptr,
+                                               ArrayRef<int64_t>{start}));
+        Value run = extractRun(rewriter, loc, value, start, info.vecSize);
+        if (mask)
+          rewriter.create<LLVM::MaskedStoreOp>(
+              loc, run, address,
+              extractRun(rewriter, loc, mask, start, info.vecSize),
+              info.alignment);
+        else
+          rewriter.create<LLVM::StoreOp>(loc, run, address, info.alignment);
+      }
+    }
+    rewriter.eraseOp(op);
+    return success();
+  }
+
+private:
+  const AccessInfoMap &accessInfo;
+};
+
+//===----------------------------------------------------------------------===//
+// Atomics
+//===----------------------------------------------------------------------===//
+
+LLVM::AtomicOrdering getOrdering(triton::MemSemantic sem) {
+  switch (sem) {
+  case triton::MemSemantic::RELAXED:
+    return LLVM::AtomicOrdering::monotonic;
+  case triton::MemSemantic::ACQUIRE:
+    return LLVM::AtomicOrdering::acquire;
+  case triton::MemSemantic::RELEASE:
+    return LLVM::AtomicOrdering::release;
+  case triton::MemSemantic::ACQUIRE_RELEASE:
+    return LLVM::AtomicOrdering::acq_rel;
+  }
+  llvm_unreachable("Invalid MemSemantic");
+}
+
+LLVM::AtomicBinOp getAtomicBinOp(triton::RMWOp op) {
+  switch (op) {
+  case triton::RMWOp::AND:
+    return LLVM::AtomicBinOp::_and;
+  case triton::RMWOp::OR:
+    return LLVM::AtomicBinOp::_or;
+  case triton::RMWOp::XOR:
+    return LLVM::AtomicBinOp::_xor;
+  case triton::RMWOp::ADD:
+    return LLVM::AtomicBinOp::add;
+  case triton::RMWOp::FADD:
+    return LLVM::AtomicBinOp::fadd;
+  case triton::RMWOp::MAX:
+    return LLVM::AtomicBinOp::max;
+  case triton::RMWOp::MIN:
+    return LLVM::AtomicBinOp::min;
+  case triton::RMWOp::UMAX:
+    return LLVM::AtomicBinOp::umax;
+  case triton::RMWOp::UMIN:
+    return LLVM::AtomicBinOp::umin;
+  case triton::RMWOp::XCHG:
+    return LLVM::AtomicBinOp::xchg;
+  }
+  llvm_unreachable("Invalid RMWOp");
+}
+
+// Runs the atomic `createAtomic(builder, ptr, operands)` on each element of
+// the tensor operands, under `mask` if any, and returns the old values. The
+// masked off elements are zero.
+Value createElementwiseAtomic(
+    OpBuilder &builder, Location loc, Type type, Value ptr,
+    ValueRange operands, Value mask,
+    function_ref<Value(OpBuilder &, Value, ValueRange)> createAtomic) {
+  Value zero = createZero(builder, loc, getElementTypeOrSelf(type));
+  auto vectorType = type.dyn_cast<VectorType>();
+  if (!vectorType)
+    return createMaskedScalarAccess(
+        builder, loc, mask, zero, type, [&](OpBuilder &builder) {
+          return createAtomic(builder, toPointer(builder, loc, ptr), operands);
+        });
+  ptr = flatten(builder, loc, ptr);
+  SmallVector<Value> flatOperands;
+  for (Value operand : operands)
+    flatOperands.push_back(flatten(builder, loc, operand));
+  if (mask)
+    mask = flatten(builder, loc, mask);
+  int64_t numElems = vectorType.getNumElements();
+  auto forOp = builder.create<scf::ForOp>(
+      loc, createIndex(builder, loc, 0), createIndex(builder, loc, numElems),
+      createIndex(builder, loc, 1),
+      ValueRange{createZero(builder, loc, VectorType::get(
+                                              numElems,
+                                              vectorType.getElementType()))},
+      [&](OpBuilder &builder, Location loc, Value i, ValueRange results) {
+        auto extract = [&](Value vector) -> Value {
+          return builder.create<vector::ExtractElementOp>(loc, vector, i);
+        };
+        SmallVector<Value> elemOperands;
+        for (Value operand : flatOperands)
+          elemOperands.push_back(extract(operand));
+        Value old = createMaskedScalarAccess(
+            builder, loc, mask ? extract(mask) : Value(), zero,
+            vectorType.getElementType(), [&](OpBuilder &builder) {
+              return createAtomic(builder,
+                                  toPointer(builder, loc, extract(ptr)),
+                                  elemOperands);
+            });
+        builder.create<scf::YieldOp>(
+            loc, ValueRange{builder.create<vector::InsertElementOp>(
+                     loc, old, results[0], i)});
+      });
+  return reshape(builder, loc, forOp.getResult(0), vectorType);
+}
+
+struct AtomicRMWOpConversion
+    : public OpConversionPattern<triton::AtomicRMWOp> {
+  using OpConversionPattern<triton::AtomicRMWOp>::OpConversionPattern;
+
+  LogicalResult
+  matchAndRewrite(triton::AtomicRMWOp op, OpAdaptor adaptor,
+                  ConversionPatternRewriter &rewriter) const override {
+    Type type = getTypeConverter()->convertType(op.getType());
+    LLVM::AtomicBinOp binOp = getAtomicBinOp(op.getAtomicRmwOp());
+    LLVM::AtomicOrdering ordering = getOrdering(op.getSem());
+    rewriter.replaceOp(
+        op, createElementwiseAtomic(
+                rewriter, op.getLoc(), type, adaptor.getPtr(),
+                ValueRange{adaptor.getVal()}, adaptor.getMask(),
+                [&](OpBuilder &builder, Value ptr, ValueRange operands) {
+                  return builder.create<LLVM::AtomicRMWOp>(
+                      op.getLoc(), binOp, ptr, operands[0], ordering);
+                }));
+    return success();
+  }
+};
+
+// cmpxchg only takes integers: floats are compared by their bits
+struct AtomicCASOpConversion
+    : public OpConversionPattern<triton::AtomicCASOp> {
+  using OpConversionPattern<triton::AtomicCASOp>::OpConversionPattern;
+
+  LogicalResult
+  matchAndRewrite(triton::AtomicCASOp op, OpAdaptor adaptor,
+                  ConversionPatternRewriter &rewriter) const override {
+    Location loc = op.getLoc();
+    Type type = getTypeConverter()->convertType(op.getType());
+    LLVM::AtomicOrdering ordering = getOrdering(op.getSem());
+    rewriter.replaceOp(
+        op,
+        createElementwiseAtomic(
+            rewriter, loc, type, adaptor.getPtr(),
+            ValueRange{adaptor.getCmp(), adaptor.getVal()}, Value(),
+            [&](OpBuilder &builder, Value ptr, ValueRange operands) -> Value {
+              Type elemType = operands[0].getType();
+              Type intType =
+                  builder.getIntegerType(elemType.getIntOrFloatBitWidth());
+              auto toInt = [&](Value value) -> Value {
+                if (elemType == intType)
+                  return value;
+                return builder.create<arith::BitcastOp>(loc, intType, value);
+              };
+              auto cmpxchg = builder.create<LLVM::AtomicCmpXchgOp>(
+                  loc, ptr, toInt(operands[0]), toInt(operands[1]), ordering,
+                  LLVM::AtomicOrdering::monotonic);
+              Value old = builder.create<LLVM::ExtractValueOp>(
+                  loc, cmpxchg, ArrayRef<int64_t>{0});
+              if (elemType == intType)
+                return old;
+              return builder.create<arith::BitcastOp>(loc, elemType, old);
+            }));
+    return success();
+  }
+};
+
+// Prefetches and profiling marks have no effect on the results
+template <typename OpTy>
+struct EraseOpConversion : public OpConversionPattern<OpTy> {
+  using OpConversionPattern<OpTy>::OpConversionPattern;
+
+  LogicalResult
+  matchAndRewrite(OpTy op, typename OpTy::Adaptor adaptor,
+                  ConversionPatternRewriter &rewriter) const override {
+    rewriter.eraseOp(op);
+    return success();
+  }
+};
+
+//===----------------------------------------------------------------------===//
+// Pass
+//===----------------------------------------------------------------------===//
+
+// Reports the ops this pass can't lower
+LogicalResult checkSupported(ModuleOp mod) {
+  WalkResult result = mod.walk([&](Operation *op) {
+    auto reject = [&](const Twine &what) {
+      op->emitError() << what << " is not supported by the CPU backend";
+      return WalkResult::interrupt();
+    };
+    if (isa<triton::PrintOp, triton::AssertOp, triton::HistogramOp,
+            triton::DotScaledOp, triton::GatherOp, triton::SortOp,
+            triton::ElementwiseInlineAsmOp, triton::ExternElementwiseOp,
+            triton::GridSyncOp, triton::MakeTensorPtrOp, triton::AdvanceOp>(op))
+      return reject(op->getName().getStringRef());
+    // e.g. the TritonGPU ops, such as triton_gpu.sparse_dot
+    Dialect *dialect = op->getDialect();
+    if (!dialect ||
+        !isa<BuiltinDialect, arith::ArithDialect, cf::ControlFlowDialect,
+             math::MathDialect, scf::SCFDialect, triton::TritonDialect>(
+            dialect))
+      return reject(op->getName().getStringRef());
+    for (Type type : llvm::concat<Type>(op->getOperandTypes(),
+                                        op->getResultTypes())) {
+      Type elemType = getElementTypeOrSelf(type);
+      if (auto ptrType = elemType.dyn_cast<triton::PointerType>())
+        elemType = getElementTypeOrSelf(ptrType.getPointeeType());
+      if (elemType.isa<FloatType>() && elemType.getIntOrFloatBitWidth() == 8)
+        return reject("fp8");
+    }
+    if (auto fpToFp = dyn_cast<triton::FpToFpOp>(op))
+      if (fpToFp.getRbits() ||
+          fpToFp.getRounding() == triton::RoundingMode::RTZ)
+        return reject("rounding " + op->getName().getStringRef() +
+                      " other than to nearest even");
+    if (isa<triton::ReduceOp, triton::ScanOp>(op)) {
+      for (Operation &combineOp : op->getRegion(0).front().without_terminator())
+        if (!isa<arith::ArithDialect, math::MathDialect>(
+                combineOp.getDialect()) ||
+            combineOp.getNumRegions() != 0)
+          return reject("combining with " +
+                        combineOp.getName().getStringRef());
+    }
+    return WalkResult::advance();
+  });
+  return failure(result.wasInterrupted());
+}
+
+class ConvertTritonToVector
+    : public mlir::triton::cpu::impl::ConvertTritonToVectorBase<
+          ConvertTritonToVector> {
+public:
+  void runOnOperation() override {
+    MLIRContext *context = &getContext();
+    ModuleOp mod = getOperation();
+    if (failed(checkSupported(mod)))
+      return signalPassFailure();
+
+    // The axis analysis runs on the TTIR, before the conversion
+    AccessInfoMap accessInfo;
+    {
+      ModuleAxisInfoAnalysis axisInfoAnalysis(mod);
+      mod.walk([&](Operation *op) {
+        if (auto load = dyn_cast<triton::LoadOp>(op))
+          accessInfo[op] = getAccessInfo(axisInfoAnalysis, load.getPtr());
+        else if (auto store = dyn_cast<triton::StoreOp>(op))
+          accessInfo[op] = getAccessInfo(axisInfoAnalysis, store.getPtr());
+      });
+    }
+
+    TritonCPUTypeConverter typeConverter;
+    ConversionTarget target(*context);
+    target.addLegalDialect<func::FuncDialect, LLVM::LLVMDialect,
+                           vector::VectorDialect>();
+    target.addIllegalDialect<triton::TritonDialect>();
+    target.addDynamicallyLegalDialect<arith::ArithDialect, math::MathDialect>(
+        [&](Operation *op) { return typeConverter.isLegal(op); });
+    target.addDynamicallyLegalDialect<cf::ControlFlowDialect>(
+        [&](Operation *op) {
+          return !isa<BranchOpInterface>(op) ||
+                 isLegalForBranchOpInterfaceTypeConversionPattern(
+                     op, typeConverter);
+        });
+
+    RewritePatternSet patterns(context);
+    patterns.add<ElementwiseOpConversion>(typeConverter, context);
+    patterns.add<
+        ArithConstantConversion, FuncOpConversion, CallOpConversion,
+        ReturnOpConversion, GetProgramIdOpConversion,
+        GetNumProgramsOpConversion, BroadcastLikeOpConversion<triton::SplatOp>,
+        BroadcastLikeOpConversion<triton::BroadcastOp>,
+        ReshapeLikeOpConversion<triton::ExpandDimsOp>,
+        ReshapeLikeOpConversion<triton::ReshapeOp>, TransOpConversion,
+        MakeRangeOpConversion, InterleaveLikeOpConversion<triton::JoinOp>,
+        InterleaveLikeOpConversion<triton::ExperimentalInterleaveOp>,
+        SplitOpConversion, CatOpConversion, AddPtrOpConversion,
+        PtrCastOpConversion<triton::IntToPtrOp>,
+        PtrCastOpConversion<triton::PtrToIntOp>, BitcastOpConversion,
+        FpToFpOpConversion, ClampFOpConversion, DotOpConversion,
+        ReduceOpConversion, ScanOpConversion, AtomicRMWOpConversion,
+        AtomicCASOpConversion, EraseOpConversion<triton::PrefetchOp>,
+        EraseOpConversion<triton::ProfileMarkOp>>(typeConverter, context);
+    patterns.add<LoadOpConversion, StoreOpConversion>(typeConverter, context,
+                                                      accessInfo);
+    scf::populateSCFStructuralTypeConversionsAndLegality(typeConverter,
+                                                         patterns, target);
+    populateBranchOpInterfaceTypeConversionPattern(patterns, typeConverter);
+    if (failed(applyPartialConversion(mod, target, std::move(patterns))))
+      return signalPassFailure();
+
+    // The rows of the results of the dots accumulate the outer products of
+    // the columns of `a` and the rows of `b`, which are FMAs of whole SIMD
+    // registers
+    RewritePatternSet contractPatterns(context);
+    vector::populateVectorContractLoweringPatterns(
+        contractPatterns,
+        vector::VectorTransformsOptions().setVectorTransformsOptions(
+            vector::VectorContractLowering::OuterProduct));
+    if (failed(applyPatternsAndFoldGreedily(mod, std::move(contractPatterns))))
+      return signalPassFailure();
+  }
+};
+
+} // namespace
+
+namespace mlir {
+namespace triton {
+namespace cpu {
+
+std::unique_ptr<OperationPass<ModuleOp>> createConvertTritonToVectorPass() {
+  return std::make_unique<ConvertTritonToVector>();
+}
+
+} // namespace cpu
+} // namespace triton
+} // namespace mlir
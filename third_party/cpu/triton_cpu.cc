@@ -0,0 +1,64 @@
+#include "TritonCPUToLLVM/Passes.h"
+#include "mlir/Conversion/FuncToLLVM/ConvertFuncToLLVMPass.h"
+#include "mlir/Conversion/MathToLLVM/MathToLLVM.h"
+#include "mlir/Conversion/MathToLibm/MathToLibm.h"
+#include "mlir/Conversion/ReconcileUnrealizedCasts/ReconcileUnrealizedCasts.h"
+#include "mlir/Conversion/VectorToLLVM/ConvertVectorToLLVMPass.h"
+#include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/Dialect/Vector/IR/VectorOps.h"
+#include "mlir/Pass/Pass.h"
+#include "mlir/Pass/PassManager.h"
+#include "passes.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/TargetParser/Host.h"
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+
+namespace py = pybind11;
+
+void init_triton_cpu_passes_ttir(py::module &&m) {
+  using namespace mlir::triton;
+  ADD_PASS_WRAPPER_0("add_to_vector", cpu::createConvertTritonToVectorPass);
+}
+
+void init_triton_cpu_passes_convert(py::module &&m) {
+  using namespace mlir;
+  ADD_PASS_WRAPPER_0("add_vector_to_llvmir", createConvertVectorToLLVMPass);
+  ADD_PASS_WRAPPER_0("add_math_to_llvmir", createConvertMathToLLVMPass);
+  ADD_PASS_WRAPPER_0("add_math_to_libm", createConvertMathToLibmPass);
+  ADD_PASS_WRAPPER_0("add_func_to_llvmir", createConvertFuncToLLVMPass);
+  ADD_PASS_WRAPPER_0("add_reconcile_unrealized_casts",
+                     createReconcileUnrealizedCastsPass);
+}
+
+void init_triton_cpu(py::module &&m) {
+  m.doc() = "Python bindings to the CPU Triton backend";
+
+  auto passes = m.def_submodule("passes");
+  init_triton_cpu_passes_ttir(passes.def_submodule("ttir"));
+  init_triton_cpu_passes_convert(passes.def_submodule("convert"));
+
+  // load dialects
+  m.def("load_dialects", [](mlir::MLIRContext &context) {
+    mlir::DialectRegistry registry;
+    registry.insert<mlir::func::FuncDialect, mlir::vector::VectorDialect>();
+    context.appendDialectRegistry(registry);
+    context.loadAllAvailableDialects();
+  });
+
+  // the triple, the name and the features of the host CPU, which the kernels
+  // are compiled for
+  m.def("get_host_target", []() {
+    llvm::StringMap<bool> features;
+    std::string featuresStr;
+    if (llvm::sys::getHostCPUFeatures(features))
+      for (auto &feature : features) {
+        if (!featuresStr.empty())
+          featuresStr += ",";
+        featuresStr +=
+            (feature.getValue() ? "+" : "-") + feature.getKey().str();
+      }
+    return py::make_tuple(llvm::sys::getProcessTriple(),
+                          llvm::sys::getHostCPUName().str(), featuresStr);
+  });
+}
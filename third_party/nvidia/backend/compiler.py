@@ -1,4 +1,5 @@
-from triton.backends.compiler import BaseBackend
+from triton.backends.compiler import (BaseBackend, CompileBudgetExceeded, current_compile_budget, run_passes,
+                                     run_with_budget, timed_pass)
 from triton._C.libtriton import ir, passes, llvm, nvidia
 from triton.runtime import driver
 from dataclasses import dataclass
@@ -253,7 +254,11 @@ class InfoFromBackendForTensorMap:
             return idx
 
     def tensormap(self, args):
-        return driver.utils.cuTensorMapEncodeTiled(
+        return driver.utils.cuTensorMapEncodeTiled(*self.tensormap_args(args))
+
+    # arguments of cuTensorMapEncodeTiled
+    def tensormap_args(self, args):
+        return (
             self.getTensorMapDataType(),
             self.getTensorRank(),
             self.getGlobalAddress(args),
@@ -327,6 +332,36 @@ def ptx_get_version(cuda_version) -> int:
     raise RuntimeError("Triton only support CUDA 10.0 or higher")
 
 
+def parse_ptxas_info(log, name):
+    '''
+    Extracts the resource usage of entry function `name` from the output of
+    `ptxas -v` (or of the driver's JIT compiler in verbose mode). Returns
+    `(n_regs, n_spills, local_bytes)`, with spills counted in bytes stored,
+    or None if `log` doesn't describe `name`.
+    '''
+    start = re.search(rf"Compiling entry function '{re.escape(name)}'", log)
+    if start is None:
+        return None
+    section = log[start.end():]
+    end = section.find("Compiling ")
+    if end >= 0:
+        section = section[:end]
+    regs = re.search(r"Used (\d+) registers", section)
+    spills = re.search(r"(\d+) bytes spill stores", section)
+    stack = re.search(r"(\d+) bytes stack frame", section)
+    if regs is None:
+        return None
+    n_spills = int(spills.group(1)) if spills else 0
+    local_bytes = int(stack.group(1)) if stack else 0
+    return int(regs.group(1)), n_spills, local_bytes
+
+
+def _record_ptxas_info(metadata, log):
+    info = parse_ptxas_info(log, metadata["name"])
+    if info is not None:
+        metadata["n_regs"], metadata["n_spills"], metadata["local_bytes"] = info
+
+
 @dataclass(frozen=True)
 class CUDAOptions:
     num_warps: int = 4
@@ -334,11 +369,80 @@ class CUDAOptions:
     num_stages: int = 3
     cluster_dims: tuple = (1, 1, 1)
     ptx_version: int = None
-    enable_warp_specialization: bool = False
+    # None lets the compiler specialize the warps of the kernels it expects to
+    # run faster, see `make_ttgir`
+    enable_warp_specialization: bool = None
     enable_persistent: bool = False
     optimize_epilogue: bool = False
+    # resolve layout conflicts with the conversion cost model
+    global_layout_assignment: bool = False
+    # share the reduction loop of matmul kernels among this many programs,
+    # see the `triton-split-k` pass
+    split_k: int = 1
+    # the pointers computed from the pointer arguments stay within this many
+    # elements of them (at most 2^31), which lets their offsets be computed in
+    # 32 bits, see the `triton-narrow-offsets` pass. 0 if unknown
+    max_numel: int = 0
+    # loop the programs over the tiles of the grid, visited in groups of
+    # `persistent_group_size` along x if set, see the `triton-make-persistent`
+    # pass
+    persistent: bool = False
+    persistent_group_size: int = 0
+    # list schedule the ops of each block to hide the latency of global loads,
+    # see the `schedule` option of `tritongpu-reorder-instructions`
+    schedule_instructions: bool = False
+    # time limit hint of the try_wait of mbarrier waits in nanoseconds, 0 for the
+    # system-dependent limit, and time the waiting threads sleep before trying
+    # again, 0 to spin, which lets warp-specialized producers issue meanwhile
+    mbarrier_suspend_time: int = 10000000
+    mbarrier_backoff: int = 0
+    # wait for the async copies of each pipeline stage on an mbarrier they
+    # arrive on instead of async_wait and a CTA barrier, from sm90, see the
+    # `async-barriers` option of `tritongpu-pipeline`
+    async_barriers: bool = False
+    # lower log, sin, cos, rsqrt, tanh (from sm75) and the division of fp32 to
+    # the approximate SFU instructions instead of libdevice and `div.full`.
+    # Errors: log 2^-22.6 absolute in [0.5, 2] and 2^-22 relative elsewhere,
+    # sin and cos 2^-20.9 absolute in [-pi, pi], growing with |x| beyond, rsqrt
+    # 2^-22.9 relative, tanh 2^-11 relative, division 2 ulp for divisors of
+    # magnitude in [2^-126, 2^126] and 0 beyond
+    fast_math: bool = False
+    # lower the elementwise ops with at least this many elements per thread
+    # to loops over them instead of unrolling them, which bounds the size of
+    # the IR and the compile times of large tiles. LLVM unrolls them again
+    # when it can afford it, otherwise their elements go through local memory.
+    # 0 unrolls them all
+    rolled_loops: int = 0
+    # the LLVM optimization level of the LLIR, from 0 to 3, and the passes
+    # run after its default pipeline, in the format of `opt -passes`, e.g.
+    # "function(loop-unroll<O3>)". The autotuner compiles the candidates at 1
+    # with `fast_compile`
+    llvm_opt_level: int = 3
+    llvm_pipeline: str = ""
+    # the target features of the PTX codegen, e.g. "+ptx80"
+    llvm_features: str = ""
+    # "instrument" counts how often the branches of the kernel are reached and
+    # taken, which `CompiledKernel.save_branch_profile` saves to the cache;
+    # "use" compiles the kernel with the saved profile as branch weights
+    branch_profile: str = ""
+    # compile in the `tl.profile_begin`/`tl.profile_end` regions, which the
+    # warps of this many programs time, see `triton.tools.profile_regions`.
+    # 0 drops them
+    profile_regions: int = 0
+    # write `tl.device_print` to a ring buffer of the last this many records
+    # (a power of 2) instead of calling vprintf, which serializes the warps,
+    # see `triton.tools.device_print`. 0 calls vprintf
+    print_buffer: int = 0
+    # compile in the line tables of the source, which `nvdisasm -g` and
+    # `triton.tools.line_profile` map the instructions back to the lines of
+    # the `@triton.jit` functions with. They are line tables only (no -G
+    # device debug info) and don't change the code of the kernel, so production
+    # kernels can keep them. None follows TRITON_DISABLE_LINE_INFO
+    line_info: bool = None
     enable_fp_fusion: bool = True
     allow_fp8e4nv: bool = False
+    # 3-D tt.dot is only lowered to the mma.sync of sm75+
+    allow_batched_dot: bool = False
     max_num_imprecise_acc_default: bool = None
     extern_libs: dict = None
     debug: bool = False
@@ -349,16 +453,67 @@ class CUDAOptions:
         if not extern_libs.get('libdevice', None):
             extern_libs['libdevice'] = str(default_libdir / 'libdevice.10.bc')
         object.__setattr__(self, 'extern_libs', tuple(extern_libs.items()))
+        if self.line_info is None:
+            object.__setattr__(self, 'line_info', os.environ.get("TRITON_DISABLE_LINE_INFO", "0") == "0")
         assert self.num_warps > 0 and (self.num_warps & (self.num_warps - 1)) == 0, \
                "num_warps must be a power of 2"
+        assert self.llvm_opt_level in (0, 1, 2, 3), "llvm_opt_level must be 0, 1, 2 or 3"
+        assert self.branch_profile in ("", "instrument", "use"), \
+               "branch_profile must be '', 'instrument' or 'use'"
+        assert self.print_buffer & (self.print_buffer - 1) == 0, "print_buffer must be a power of 2"
 
     def hash(self):
         key = '_'.join([f'{name}-{val}' for name, val in self.__dict__.items()])
         return hashlib.md5(key.encode("utf-8")).hexdigest()
 
 
+def _pipeline_options(options):
+    return " ".join(f"{name}={int(value)}" for name, value in options)
+
+
+def ttir_pipeline_options(opt):
+    """
+    Returns the options of `triton-nvidia-ttir-pipeline` for `opt`, as
+    `triton-opt --triton-nvidia-ttir-pipeline="..."` takes them.
+    """
+    return _pipeline_options([
+        ("max-numel", opt.max_numel),
+        ("split-k", opt.split_k),
+        ("persistent", opt.persistent),
+        ("persistent-group-size", opt.persistent_group_size),
+    ])
+
+
+def ttgir_pipeline_options(opt, capability, warp_specialization=False):
+    """
+    Returns the options of `triton-nvidia-ttgir-pipeline` for `opt`, as
+    `triton-opt --triton-nvidia-ttgir-pipeline="..."` takes them.
+    """
+    return _pipeline_options([
+        ("num-warps", opt.num_warps),
+        ("num-ctas", opt.num_ctas),
+        ("num-stages", opt.num_stages),
+        ("cc", capability),
+        ("max-numel", opt.max_numel),
+        ("global-layout-assignment", opt.global_layout_assignment),
+        ("optimize-epilogue", opt.optimize_epilogue),
+        ("async-barriers", opt.async_barriers),
+        ("schedule-instructions", opt.schedule_instructions),
+        ("warp-specialization", warp_specialization),
+        ("auto-warp-specialization", opt.enable_warp_specialization is None),
+    ])
+
+
 class CUDABackend(BaseBackend):
 
+    ttir_option_names = ("split_k", "persistent", "persistent_group_size", "max_numel")
+    late_option_names = ("ptx_version", "enable_fp_fusion", "extern_libs", "fast_math", "rolled_loops",
+                         "llvm_opt_level", "llvm_pipeline", "llvm_features", "branch_profile",
+                         "print_buffer")
+    # opt-in shared memory per block, by compute capability
+    shared_memory_limits = {70: 96 << 10, 72: 96 << 10, 75: 64 << 10, 80: 163 << 10, 86: 99 << 10, 87: 163 << 10,
+                            89: 99 << 10, 90: 227 << 10}
+
     @staticmethod
     def supports_target(target: tuple):
         return target[0] == 'cuda'
@@ -368,9 +523,13 @@ class CUDABackend(BaseBackend):
         self.capability = target[1]
         assert isinstance(self.capability, int)
 
+    def shared_memory_limit(self):
+        return self.shared_memory_limits.get(self.capability)
+
     def parse_options(self, opts) -> Any:
         args = {k: opts[k] for k in CUDAOptions.__dataclass_fields__.keys() if k in opts}
         args["allow_fp8e4nv"] = self.capability >= 89
+        args["allow_batched_dot"] = self.capability >= 75
         args["max_num_imprecise_acc_default"] = 2**30 if self.capability == 90 else 0
         return CUDAOptions(**args)
 
@@ -381,14 +540,17 @@ class CUDABackend(BaseBackend):
     def make_ttir(mod, metadata, opt):
         pm = ir.pass_manager(mod.context)
         pm.enable_debug()
-        passes.common.add_inliner(pm)
-        passes.ttir.add_combine(pm)
-        passes.common.add_canonicalizer(pm)
-        passes.ttir.add_reorder_broadcast(pm)
-        passes.common.add_cse(pm)
-        passes.common.add_licm(pm)
-        passes.common.add_symbol_dce(pm)
-        pm.run(mod)
+        nvidia.passes.add_ttir_pipeline(pm, ttir_pipeline_options(opt))
+        run_passes(pm, mod, metadata, "ttir")
+        if opt.profile_regions:
+            mod.set_attr("triton_gpu.profile-programs", ir.builder(mod.context).get_int32_attr(opt.profile_regions))
+        # the factor the launcher multiplies the grid by
+        metadata["split_k"] = mod.get_int_attr("tt.split_k") or 1
+        # whether the launcher passes the grid to the kernel
+        metadata["persistent"] = mod.get_int_attr("tt.persistent") is not None
+        # the cluster shapes `num_ctas="auto"` configs are tuned over, see `triton.Config`; 8 is the
+        # largest portable cluster size
+        metadata["proposed_cluster_dims"] = nvidia.passes.ttnvgpuir.propose_cluster_dims(mod, 8)
         return mod
 
     @staticmethod
@@ -399,61 +561,32 @@ class CUDABackend(BaseBackend):
             cluster_info.clusterDimY = opt.cluster_dims[1]
             cluster_info.clusterDimZ = opt.cluster_dims[2]
         # TTIR -> TTGIR
-        pm = ir.pass_manager(mod.context)
-        pm.enable_debug()
-        passes.ttir.add_convert_to_ttgpuir(pm, opt.num_warps, 32, opt.num_ctas, capability)
-        # optimize TTGIR
-        passes.ttgpuir.add_coalesce(pm)
-        # TODO(Qingyi): Move PlanCTAPass to the front of CoalescePass
-        nvidia.passes.ttnvgpuir.add_plan_cta(pm, cluster_info)
-        nvidia.passes.ttgpuir.add_rewrite_tensor_pointer(pm, capability)
-        nvidia.passes.ttnvgpuir.add_plan_cta(pm, cluster_info)
-        passes.ttgpuir.add_remove_layout_conversions(pm)
-        passes.ttgpuir.add_optimize_thread_locality(pm)
-        passes.ttgpuir.add_accelerate_matmul(pm, capability)
-        passes.ttgpuir.add_remove_layout_conversions(pm)
-        if opt.optimize_epilogue:
-            passes.ttgpuir.add_optimize_epilogue(pm)
-        passes.ttgpuir.add_optimize_dot_operands(pm)
-        passes.common.add_cse(pm)
         # `num_warps` does not mean the total number of warps of a CTA when
         # warp specialization is enabled.
         # it's the responsibility of the compiler to figure out the exact
         # `num_warps` to use.
         # TODO: support the case where `num_warps` from user is not 4.
+        # Unless the option forces it either way, the warps are specialized when
+        # the cost model expects it to beat the pipeliner, see `isWSProfitable`.
+        try_ws = capability // 10 >= 9 and opt.enable_warp_specialization is not False and opt.num_warps == 4
+        pm = ir.pass_manager(mod.context)
+        pm.enable_debug()
+        nvidia.passes.add_ttgir_layout_pipeline(pm, ttgir_pipeline_options(opt, capability, try_ws), cluster_info)
+        # whether the warps can be specialized is only known once the layouts are assigned
         ws_enabled = False
-        if capability // 10 >= 9 and opt.enable_warp_specialization and opt.num_warps == 4:
-            nvidia.passes.ttnvgpuir.add_wsfeasibility_checking(pm, capability)
-            pm.run(mod)
+        if try_ws:
+            run_passes(pm, mod, metadata, "ttgir")
             ws_enabled = nvidia.passes.ttnvgpuir.is_ws_supported(mod)
             pm = ir.pass_manager(mod.context)
             pm.enable_debug()
         metadata["ws_enabled"] = ws_enabled
-        if ws_enabled:
-            nvidia.passes.ttnvgpuir.add_wsdecomposing(pm, capability)
-            nvidia.passes.ttnvgpuir.add_wspipeline(pm, opt.num_stages, opt.num_warps, capability)
-            nvidia.passes.ttnvgpuir.add_wsmutex(pm, capability)
-            nvidia.passes.ttnvgpuir.add_wsmaterialization(pm, capability)
-            passes.common.add_licm(pm)
-            passes.common.add_cse(pm)
-        else:
-            passes.ttgpuir.add_pipeline(pm, opt.num_stages, opt.num_warps, opt.num_ctas, capability)
-        nvidia.passes.ttnvgpuir.add_materialize_load_store(pm, opt.num_warps, capability)
-        if capability // 10 <= 8:
-            passes.ttgpuir.add_prefetch(pm)
-        passes.ttgpuir.add_optimize_dot_operands(pm)
-        passes.ttgpuir.add_remove_layout_conversions(pm)
-        passes.ttgpuir.add_decompose_conversions(pm)
-        nvidia.passes.ttnvgpuir.add_wsfixup_missing_attrs(pm)
-        passes.ttgpuir.add_reorder_instructions(pm)
-        passes.common.add_cse(pm)
-        passes.common.add_symbol_dce(pm)
-        if capability // 10 >= 9:
-            nvidia.passes.ttnvgpuir.add_fence_insertion(pm)
-        nvidia.passes.ttnvgpuir.add_wsfixup_missing_attrs(pm)
-        passes.common.add_canonicalizer(pm)
-        pm.run(mod)
+        # whether the compiler made the decision, which `enable_warp_specialization` overrides
+        metadata["ws_auto"] = opt.enable_warp_specialization is None
+        nvidia.passes.add_ttgir_schedule_pipeline(pm, ttgir_pipeline_options(opt, capability, ws_enabled))
+        run_passes(pm, mod, metadata, "ttgir")
         metadata["cluster_dims"] = (cluster_info.clusterDimX, cluster_info.clusterDimY, cluster_info.clusterDimZ)
+        # static estimates used by the autotuner to rank configs, see `cost_model` in `triton.autotune`
+        metadata["cost"] = mod.get_kernel_cost()
         return mod
 
     @staticmethod
@@ -467,20 +600,39 @@ class CUDABackend(BaseBackend):
         tma_infos = nvidia.TMAInfos()
         pm = ir.pass_manager(mod.context)
         pm.enable_debug()
+        if options.branch_profile == "instrument":
+            passes.ttgpuir.add_instrument_branches(pm)
+        elif options.branch_profile == "use" and metadata.get("branch_profile_counts"):
+            passes.ttgpuir.add_apply_branch_profile(pm, metadata["branch_profile_counts"])
+        if options.print_buffer:
+            mod.set_attr("triton_gpu.print-buffer", ir.builder(mod.context).get_int32_attr(options.print_buffer))
         passes.convert.add_scf_to_cf(pm)
         passes.convert.add_index_to_llvmir(pm)
-        nvidia.passes.ttgpuir.add_to_llvmir(pm, capability, tma_infos)
+        nvidia.passes.ttgpuir.add_to_llvmir(pm, capability, tma_infos, options.fast_math, options.rolled_loops)
         if metadata["ws_enabled"]:
             passes.common.add_licm(pm)
             passes.common.add_cse(pm)
-        nvidia.passes.ttnvgpuir.add_nvgpu_to_llvm(pm)
+        if options.num_ctas > 1:
+            nvidia.passes.ttnvgpuir.add_schedule_cluster_barriers(pm)
+        nvidia.passes.ttnvgpuir.add_nvgpu_to_llvm(pm, options.mbarrier_suspend_time, options.mbarrier_backoff)
         passes.convert.add_arith_to_llvmir(pm)
         passes.common.add_canonicalizer(pm)
         passes.common.add_cse(pm)
         passes.common.add_symbol_dce(pm)
-        if os.environ.get("TRITON_DISABLE_LINE_INFO", "0") == "0":
+        if options.line_info:
             passes.llvmir.add_di_scope(pm)
-        pm.run(mod)
+        run_passes(pm, mod, metadata, "llir")
+        # `tl.grid_sync` requires all the programs to run at once
+        metadata["cooperative"] = mod.get_int_attr("triton_gpu.cooperative") is not None
+        if metadata["cooperative"] and metadata["ws_enabled"]:
+            raise RuntimeError("tl.grid_sync is not supported with warp specialization")
+        if options.branch_profile == "instrument":
+            metadata["num_branch_counters"] = mod.get_int_attr("triton_gpu.num-branch-counters")
+        if options.profile_regions:
+            metadata["profile_region_names"] = mod.get_str_array_attr("triton_gpu.profile-regions") or []
+        if options.print_buffer:
+            metadata["print_formats"] = mod.get_str_array_attr("triton_gpu.print-formats")
+            metadata["print_record_words"] = mod.get_int_attr("triton_gpu.print-record-words")
         # LLVM-IR (MLIR) -> LLVM-IR (LLVM)
         llvm.init_targets()
         context = llvm.context()
@@ -489,7 +641,9 @@ class CUDABackend(BaseBackend):
         if options.extern_libs:
             for name, path in options.extern_libs:
                 llvm.link_extern_lib(llvm_mod, path)
-        llvm.optimize_module(llvm_mod, llvm.OPTIMIZE_O3)
+        with timed_pass(metadata, "llir", "llvm-optimize"):
+            llvm.optimize_module(llvm_mod, getattr(llvm, f"OPTIMIZE_O{options.llvm_opt_level}"),
+                                 options.llvm_pipeline)
         # Get some metadata
         if len(tma_infos) > 0:
             metadata["tensormaps_info"] = parse_tma_info(tma_infos, metadata["ids_of_folded_args"])
@@ -505,8 +659,9 @@ class CUDABackend(BaseBackend):
     @staticmethod
     def make_ptx(src, metadata, opt, capability):
         proc = 'sm_90a' if capability == 90 else f'sm_{capability}'
-        ret = llvm.translate_to_asm(src, 'nvptx64-nvidia-cuda', proc, '', ['nvptx-short-ptr'], opt.enable_fp_fusion,
-                                    False)
+        with timed_pass(metadata, "ptx", "llvm-codegen"):
+            ret = llvm.translate_to_asm(src, 'nvptx64-nvidia-cuda', proc, opt.llvm_features, ['nvptx-short-ptr'],
+                                        opt.enable_fp_fusion, False)
         # Find kernel names (there should only be one)
         names = re.findall(r".visible .entry ([a-zA-Z_][a-zA-Z0-9_]*)", ret)
         assert len(names) == 1
@@ -522,8 +677,26 @@ class CUDABackend(BaseBackend):
         ret = re.sub(r",\s*debug|debug,\s*", "", ret)
         return ret
 
+    @staticmethod
+    def make_cubin_in_process(src, metadata, opt, capability):
+        # The driver's JIT compiler has no equivalent of `--fmad=false`.
+        if not opt.enable_fp_fusion:
+            return None
+        try:
+            with timed_pass(metadata, "cubin", "ptx-jit"):
+                cubin, log = driver.utils.compile_ptx(src, capability, opt.line_info, driver.get_current_device())
+        except RuntimeError:
+            # e.g. no device, or a PTX version newer than the driver: let ptxas report any genuine error
+            return None
+        _record_ptxas_info(metadata, log)
+        return cubin
+
     @staticmethod
     def make_cubin(src, metadata, opt, capability):
+        if os.environ.get("TRITON_PTX_IN_PROCESS", "0") == "1":
+            cubin = CUDABackend.make_cubin_in_process(src, metadata, opt, capability)
+            if cubin is not None:
+                return cubin
         ptxas, _ = _path_to_binary("ptxas")
         with tempfile.NamedTemporaryFile(delete=False, mode='w', suffix='.ptx') as fsrc, \
             tempfile.NamedTemporaryFile(delete=False, mode='r', suffix='.log') as flog:
@@ -531,16 +704,23 @@ class CUDABackend(BaseBackend):
             fsrc.flush()
             fbin = fsrc.name + '.o'
 
-            line_info = '' if os.environ.get('TRITON_DISABLE_LINE_INFO') else ' -lineinfo'
+            line_info = ' -lineinfo' if opt.line_info else ''
             fmad = '' if opt.enable_fp_fusion else ' --fmad=false'
             suffix = 'a ' if capability == 90 else ' '
             cmd = f'{ptxas}{line_info}{fmad} -v --gpu-name=sm_{capability}{suffix}{fsrc.name} -o {fbin} 2> {flog.name}'
 
             try:
-                subprocess.run(cmd, shell=True, check=True)
+                with timed_pass(metadata, "cubin", "ptxas"):
+                    run_with_budget(cmd, "cubin", shell=True)
+                with open(flog.name) as log_file:
+                    _record_ptxas_info(metadata, log_file.read())
             except subprocess.CalledProcessError as e:
                 with open(flog.name) as log_file:
                     log = log_file.read()
+                memory_mb = current_compile_budget().memory_mb
+                if memory_mb is not None and "out of memory" in log.lower():
+                    raise CompileBudgetExceeded("memory", "all of it (ptxas ran out of memory)", f"{memory_mb} MiB",
+                                                "cubin")
                 if e.returncode == 255:
                     raise RuntimeError(f'Internal Triton PTX codegen error: \n{log}')
                 elif e.returncode == 128 + signal.SIGSEGV:
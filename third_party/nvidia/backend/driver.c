@@ -1,6 +1,7 @@
 #include "cuda.h"
 #include <dlfcn.h>
 #include <stdbool.h>
+#include <string.h>
 #define PY_SSIZE_T_CLEAN
 #include <Python.h>
 
@@ -295,6 +296,37 @@ static PyObject *loadBinary(PyObject *self, PyObject *args) {
                        n_spills);
 }
 
+// Returns the contents of the global variable `name` of a loaded module, and
+// zeroes it if `reset` is set.
+static PyObject *readGlobal(PyObject *self, PyObject *args) {
+  uint64_t mod;
+  const char *name;
+  int reset;
+  if (!PyArg_ParseTuple(args, "Ksp", &mod, &name, &reset)) {
+    return NULL;
+  }
+  CUdeviceptr dptr;
+  size_t bytesize;
+  CUDA_CHECK_AND_RETURN_NULL(
+      cuModuleGetGlobal(&dptr, &bytesize, (CUmodule)mod, name));
+  PyObject *ret = PyBytes_FromStringAndSize(NULL, bytesize);
+  if (!ret) {
+    return NULL;
+  }
+  char *data = PyBytes_AsString(ret);
+  bool ok;
+  Py_BEGIN_ALLOW_THREADS;
+  ok = gpuAssert(cuMemcpyDtoH(data, dptr, bytesize), __FILE__, __LINE__) &&
+       (!reset ||
+        gpuAssert(cuMemsetD8(dptr, 0, bytesize), __FILE__, __LINE__));
+  Py_END_ALLOW_THREADS;
+  if (!ok) {
+    Py_DECREF(ret);
+    return NULL;
+  }
+  return ret;
+}
+
 static PyObject *memAlloc(PyObject *self, PyObject *args) {
   size_t bytesize;
   CUdeviceptr dptr;
@@ -454,6 +486,201 @@ static PyObject *tensorMapEncodeTiled(PyObject *self, PyObject *args) {
   return PyLong_FromUnsignedLongLong((unsigned long long)tensorMap);
 }
 
+// Device copies of tensor maps, keyed by everything that goes into encoding
+// them, so that launches with previously seen arguments neither re-encode
+// the descriptor nor copy it to the device again. The cache is bounded and
+// evicts the least recently used descriptor (see TRITON_TENSORMAP_CACHE_SIZE).
+#define TENSORMAP_MAX_RANK 5
+
+typedef struct {
+  CUcontext context;
+  void *globalAddress;
+  cuuint64_t globalDim[TENSORMAP_MAX_RANK];
+  cuuint64_t globalStrides[TENSORMAP_MAX_RANK];
+  cuuint32_t boxDim[TENSORMAP_MAX_RANK];
+  cuuint32_t elementStrides[TENSORMAP_MAX_RANK];
+  int tensorDataType, tensorRank, interleave, swizzle, l2Promotion, oobFill;
+} TensorMapKey;
+
+typedef struct TensorMapEntry {
+  TensorMapKey key;
+  CUdeviceptr devicePtr;
+  struct TensorMapEntry *prev, *next; // LRU order, most recent first
+  struct TensorMapEntry *chain;       // next entry in the same bucket
+} TensorMapEntry;
+
+static struct {
+  TensorMapEntry **buckets;
+  size_t numBuckets, size, capacity;
+  TensorMapEntry *head, *tail;
+} tensorMapCache;
+
+static uint64_t hashTensorMapKey(const TensorMapKey *key) {
+  // FNV-1a
+  const unsigned char *bytes = (const unsigned char *)key;
+  uint64_t hash = 14695981039346656037ull;
+  for (size_t i = 0; i < sizeof(TensorMapKey); i++)
+    hash = (hash ^ bytes[i]) * 1099511628211ull;
+  return hash;
+}
+
+static TensorMapEntry **findTensorMapEntry(const TensorMapKey *key) {
+  TensorMapEntry **entry = &tensorMapCache.buckets[hashTensorMapKey(key) &
+                                                   (tensorMapCache.numBuckets -
+                                                    1)];
+  while (*entry && memcmp(&(*entry)->key, key, sizeof(TensorMapKey)) != 0)
+    entry = &(*entry)->chain;
+  return entry;
+}
+
+static void unlinkTensorMapEntry(TensorMapEntry *entry) {
+  if (entry->prev)
+    entry->prev->next = entry->next;
+  else
+    tensorMapCache.head = entry->next;
+  if (entry->next)
+    entry->next->prev = entry->prev;
+  else
+    tensorMapCache.tail = entry->prev;
+}
+
+static void pushTensorMapEntry(TensorMapEntry *entry) {
+  entry->prev = NULL;
+  entry->next = tensorMapCache.head;
+  if (tensorMapCache.head)
+    tensorMapCache.head->prev = entry;
+  tensorMapCache.head = entry;
+  if (!tensorMapCache.tail)
+    tensorMapCache.tail = entry;
+}
+
+static bool initTensorMapCache(void) {
+  if (tensorMapCache.buckets)
+    return true;
+  size_t capacity = 4096;
+  const char *env = getenv("TRITON_TENSORMAP_CACHE_SIZE");
+  if (env && atol(env) > 0)
+    capacity = (size_t)atol(env);
+  size_t numBuckets = 1;
+  while (numBuckets < 2 * capacity)
+    numBuckets <<= 1;
+  tensorMapCache.buckets =
+      (TensorMapEntry **)calloc(numBuckets, sizeof(TensorMapEntry *));
+  if (!tensorMapCache.buckets) {
+    PyErr_NoMemory();
+    return false;
+  }
+  tensorMapCache.numBuckets = numBuckets;
+  tensorMapCache.capacity = capacity;
+  return true;
+}
+
+static bool listToArray64(PyObject *list, cuuint64_t *array) {
+  Py_ssize_t len = PyList_Size(list);
+  if (len > TENSORMAP_MAX_RANK) {
+    PyErr_SetString(PyExc_ValueError, "tensor map rank is too large");
+    return false;
+  }
+  for (Py_ssize_t i = 0; i < len; i++)
+    array[i] = (cuuint64_t)PyLong_AsUnsignedLongLong(PyList_GetItem(list, i));
+  return !PyErr_Occurred();
+}
+
+static bool listToArray32(PyObject *list, cuuint32_t *array) {
+  Py_ssize_t len = PyList_Size(list);
+  if (len > TENSORMAP_MAX_RANK) {
+    PyErr_SetString(PyExc_ValueError, "tensor map rank is too large");
+    return false;
+  }
+  for (Py_ssize_t i = 0; i < len; i++)
+    array[i] = (cuuint32_t)PyLong_AsUnsignedLong(PyList_GetItem(list, i));
+  return !PyErr_Occurred();
+}
+
+// Same arguments as cuTensorMapEncodeTiled; returns the address of a device
+// copy of the tensor map, valid in the current context.
+static PyObject *tensorMapDevice(PyObject *self, PyObject *args) {
+  TensorMapKey key;
+  // padding bytes are part of the hashed key
+  memset(&key, 0, sizeof(key));
+  PyObject *globalDimObj, *globalStridesObj, *boxDimObj, *elementStridesObj;
+  if (!PyArg_ParseTuple(args, "iiKO!O!O!O!iiii", &key.tensorDataType,
+                        &key.tensorRank, &key.globalAddress, &PyList_Type,
+                        &globalDimObj, &PyList_Type, &globalStridesObj,
+                        &PyList_Type, &boxDimObj, &PyList_Type,
+                        &elementStridesObj, &key.interleave, &key.swizzle,
+                        &key.l2Promotion, &key.oobFill))
+    return NULL;
+  if (!listToArray64(globalDimObj, key.globalDim) ||
+      !listToArray64(globalStridesObj, key.globalStrides) ||
+      !listToArray32(boxDimObj, key.boxDim) ||
+      !listToArray32(elementStridesObj, key.elementStrides))
+    return NULL;
+  CUDA_CHECK_AND_RETURN_NULL(cuCtxGetCurrent(&key.context));
+  if (!initTensorMapCache())
+    return NULL;
+
+  TensorMapEntry **slot = findTensorMapEntry(&key);
+  TensorMapEntry *entry = *slot;
+  if (entry) {
+    unlinkTensorMapEntry(entry);
+    pushTensorMapEntry(entry);
+    return PyLong_FromUnsignedLongLong((unsigned long long)entry->devicePtr);
+  }
+
+  static cuTensorMapEncodeTiled_t cuTensorMapEncodeTiledHandle = NULL;
+  if (cuTensorMapEncodeTiledHandle == NULL) {
+    cuTensorMapEncodeTiledHandle = getCuTensorMapEncodeTiledHandle();
+    if (cuTensorMapEncodeTiledHandle == NULL)
+      return NULL;
+  }
+  CUtensorMap tensorMap;
+  CUDA_CHECK_AND_RETURN_NULL(cuTensorMapEncodeTiledHandle(
+      &tensorMap, (CUtensorMapDataType)key.tensorDataType, key.tensorRank,
+      key.globalAddress, key.globalDim, key.globalStrides, key.boxDim,
+      key.elementStrides, (CUtensorMapInterleave)key.interleave,
+      (CUtensorMapSwizzle)key.swizzle,
+      (CUtensorMapL2promotion)key.l2Promotion,
+      (CUtensorMapFloatOOBfill)key.oobFill));
+
+  if (tensorMapCache.size == tensorMapCache.capacity) {
+    // cuMemFree synchronizes, so kernels still reading the descriptor are done
+    TensorMapEntry *victim = tensorMapCache.tail;
+    unlinkTensorMapEntry(victim);
+    TensorMapEntry **victimSlot = findTensorMapEntry(&victim->key);
+    *victimSlot = victim->chain;
+    CUcontext current = key.context;
+    CUDA_CHECK_AND_RETURN_NULL(cuCtxSetCurrent(victim->key.context));
+    CUresult err = cuMemFree(victim->devicePtr);
+    cuCtxSetCurrent(current);
+    free(victim);
+    tensorMapCache.size--;
+    CUDA_CHECK_AND_RETURN_NULL(err);
+    // the chain `slot` points into may have changed
+    slot = findTensorMapEntry(&key);
+  }
+
+  entry = (TensorMapEntry *)malloc(sizeof(TensorMapEntry));
+  if (!entry)
+    return PyErr_NoMemory();
+  entry->key = key;
+  entry->devicePtr = 0;
+  CUresult err = cuMemAlloc(&entry->devicePtr, sizeof(CUtensorMap));
+  if (err == CUDA_SUCCESS)
+    err = cuMemcpyHtoD(entry->devicePtr, &tensorMap, sizeof(CUtensorMap));
+  if (err != CUDA_SUCCESS) {
+    if (entry->devicePtr)
+      cuMemFree(entry->devicePtr);
+    free(entry);
+    CUDA_CHECK_AND_RETURN_NULL(err);
+  }
+  entry->chain = NULL;
+  *slot = entry;
+  pushTensorMapEntry(entry);
+  tensorMapCache.size++;
+  return PyLong_FromUnsignedLongLong((unsigned long long)entry->devicePtr);
+}
+
 static PyObject *occupancyMaxActiveClusters(PyObject *self, PyObject *args) {
   int clusterDimX = -1, clusterDimY = -1, clusterDimZ = -1,
       maxActiveClusters = -1;
@@ -503,18 +730,315 @@ static PyObject *occupancyMaxActiveClusters(PyObject *self, PyObject *args) {
   return PyLong_FromLong(maxActiveClusters);
 }
 
+// Returns how many CTAs of `func` launched with `numWarps` warps and `shared`
+// bytes of dynamic shared memory can be resident on one SM, and how many
+// clusters of the given shape can be resident on the whole device (None for
+// kernels without clusters).
+static PyObject *occupancy(PyObject *self, PyObject *args) {
+  CUfunction func;
+  int numWarps, shared, clusterDimX, clusterDimY, clusterDimZ;
+  if (!PyArg_ParseTuple(args, "Kiiiii", &func, &numWarps, &shared,
+                        &clusterDimX, &clusterDimY, &clusterDimZ))
+    return NULL;
+  int blockSize = numWarps * 32;
+  int maxActiveBlocks = 0;
+  int maxActiveClusters = -1;
+  int clusterSize = clusterDimX * clusterDimY * clusterDimZ;
+  static cuOccupancyMaxActiveClusters_t cuOccupancyMaxActiveClusters = NULL;
+  if (clusterSize > 1 && cuOccupancyMaxActiveClusters == NULL) {
+    cuOccupancyMaxActiveClusters = getCuOccupancyMaxActiveClustersHandle();
+    if (cuOccupancyMaxActiveClusters == NULL)
+      return NULL;
+  }
+  Py_BEGIN_ALLOW_THREADS;
+  CUDA_CHECK_AND_RETURN_NULL_ALLOW_THREADS(
+      cuOccupancyMaxActiveBlocksPerMultiprocessor(&maxActiveBlocks, func,
+                                                  blockSize, shared));
+  if (clusterSize > 1) {
+    CUlaunchAttribute launchAttr[1];
+    launchAttr[0].id = CU_LAUNCH_ATTRIBUTE_CLUSTER_DIMENSION;
+    launchAttr[0].value.clusterDim.x = clusterDimX;
+    launchAttr[0].value.clusterDim.y = clusterDimY;
+    launchAttr[0].value.clusterDim.z = clusterDimZ;
+    CUlaunchConfig config;
+    memset(&config, 0, sizeof(config));
+    config.gridDimX = clusterDimX;
+    config.gridDimY = clusterDimY;
+    config.gridDimZ = clusterDimZ;
+    config.blockDimX = blockSize;
+    config.blockDimY = 1;
+    config.blockDimZ = 1;
+    config.sharedMemBytes = shared;
+    config.numAttrs = 1;
+    config.attrs = launchAttr;
+    CUDA_CHECK_AND_RETURN_NULL_ALLOW_THREADS(
+        cuOccupancyMaxActiveClusters(&maxActiveClusters, func, &config));
+  }
+  Py_END_ALLOW_THREADS;
+  if (maxActiveClusters < 0)
+    return Py_BuildValue("(iO)", maxActiveBlocks, Py_None);
+  return Py_BuildValue("(ii)", maxActiveBlocks, maxActiveClusters);
+}
+
+// Sets the L2 access policy window of `stream`: the accesses of the kernels
+// launched on it to the `numBytes` bytes from `basePtr`, e.g. weights reused by
+// successive launches, persist in L2 with probability `hitRatio`. A window of
+// 0 bytes resets the policy. The window and the L2 set aside for persisting
+// accesses are clamped to the limits of the device, the latter is only grown.
+static PyObject *setAccessPolicyWindow(PyObject *self, PyObject *args) {
+  CUstream stream;
+  uint64_t basePtr;
+  uint64_t numBytes;
+  float hitRatio;
+  if (!PyArg_ParseTuple(args, "KKKf", &stream, &basePtr, &numBytes,
+                        &hitRatio))
+    return NULL;
+  CUstreamAttrValue value;
+  memset(&value, 0, sizeof(value));
+  if (numBytes > 0) {
+    CUdevice device;
+    int maxWindowBytes, maxPersistingBytes;
+    CUDA_CHECK_AND_RETURN_NULL(cuCtxGetDevice(&device));
+    CUDA_CHECK_AND_RETURN_NULL(cuDeviceGetAttribute(
+        &maxWindowBytes, CU_DEVICE_ATTRIBUTE_MAX_ACCESS_POLICY_WINDOW_SIZE,
+        device));
+    CUDA_CHECK_AND_RETURN_NULL(cuDeviceGetAttribute(
+        &maxPersistingBytes, CU_DEVICE_ATTRIBUTE_MAX_PERSISTING_L2_CACHE_SIZE,
+        device));
+    if (maxWindowBytes <= 0 || maxPersistingBytes <= 0) {
+      PyErr_SetString(PyExc_RuntimeError,
+                      "The device has no L2 access policy windows");
+      return NULL;
+    }
+    if (numBytes > (uint64_t)maxWindowBytes)
+      numBytes = maxWindowBytes;
+    size_t persistingBytes = numBytes < (uint64_t)maxPersistingBytes
+                                 ? numBytes
+                                 : maxPersistingBytes;
+    size_t setAsideBytes;
+    CUDA_CHECK_AND_RETURN_NULL(
+        cuCtxGetLimit(&setAsideBytes, CU_LIMIT_PERSISTING_L2_CACHE_SIZE));
+    if (setAsideBytes < persistingBytes)
+      CUDA_CHECK_AND_RETURN_NULL(
+          cuCtxSetLimit(CU_LIMIT_PERSISTING_L2_CACHE_SIZE, persistingBytes));
+    value.accessPolicyWindow.base_ptr = (void *)basePtr;
+    value.accessPolicyWindow.num_bytes = numBytes;
+    value.accessPolicyWindow.hitRatio = hitRatio;
+    value.accessPolicyWindow.hitProp = CU_ACCESS_PROPERTY_PERSISTING;
+    value.accessPolicyWindow.missProp = CU_ACCESS_PROPERTY_STREAMING;
+  }
+  CUDA_CHECK_AND_RETURN_NULL(cuStreamSetAttribute(
+      stream, CU_STREAM_ATTRIBUTE_ACCESS_POLICY_WINDOW, &value));
+  Py_RETURN_NONE;
+}
+
+static PyObject *streamBeginCapture(PyObject *self, PyObject *args) {
+  CUstream stream;
+  if (!PyArg_ParseTuple(args, "K", &stream)) {
+    return NULL;
+  }
+  Py_BEGIN_ALLOW_THREADS;
+  CUDA_CHECK_AND_RETURN_NULL_ALLOW_THREADS(
+      cuStreamBeginCapture(stream, CU_STREAM_CAPTURE_MODE_THREAD_LOCAL));
+  Py_END_ALLOW_THREADS;
+  Py_RETURN_NONE;
+}
+
+// Ends the capture on `stream` and returns the (graph, executable graph) pair.
+static PyObject *streamEndCapture(PyObject *self, PyObject *args) {
+  CUstream stream;
+  if (!PyArg_ParseTuple(args, "K", &stream)) {
+    return NULL;
+  }
+  CUgraph graph;
+  CUgraphExec graphExec;
+  Py_BEGIN_ALLOW_THREADS;
+  CUDA_CHECK_AND_RETURN_NULL_ALLOW_THREADS(cuStreamEndCapture(stream, &graph));
+  CUDA_CHECK_AND_RETURN_NULL_ALLOW_THREADS(
+      cuGraphInstantiate(&graphExec, graph, 0));
+  Py_END_ALLOW_THREADS;
+  return Py_BuildValue("(KK)", (uint64_t)graph, (uint64_t)graphExec);
+}
+
+// Returns the node most recently captured on `stream`, or 0 if the stream is
+// not being captured.
+static PyObject *streamGetCaptureNode(PyObject *self, PyObject *args) {
+  CUstream stream;
+  if (!PyArg_ParseTuple(args, "K", &stream)) {
+    return NULL;
+  }
+  CUstreamCaptureStatus status;
+  cuuint64_t id;
+  CUgraph graph;
+  const CUgraphNode *deps = NULL;
+  size_t numDeps = 0;
+  CUDA_CHECK_AND_RETURN_NULL(
+      cuStreamGetCaptureInfo(stream, &status, &id, &graph, &deps, &numDeps));
+  if (status != CU_STREAM_CAPTURE_STATUS_ACTIVE || numDeps != 1)
+    return PyLong_FromUnsignedLongLong(0);
+  return PyLong_FromUnsignedLongLong((uint64_t)deps[0]);
+}
+
+static PyObject *graphLaunch(PyObject *self, PyObject *args) {
+  CUgraphExec graphExec;
+  CUstream stream;
+  if (!PyArg_ParseTuple(args, "KK", &graphExec, &stream)) {
+    return NULL;
+  }
+  Py_BEGIN_ALLOW_THREADS;
+  CUDA_CHECK_AND_RETURN_NULL_ALLOW_THREADS(cuGraphLaunch(graphExec, stream));
+  Py_END_ALLOW_THREADS;
+  Py_RETURN_NONE;
+}
+
+static PyObject *graphDestroy(PyObject *self, PyObject *args) {
+  CUgraph graph;
+  CUgraphExec graphExec;
+  if (!PyArg_ParseTuple(args, "KK", &graph, &graphExec)) {
+    return NULL;
+  }
+  CUDA_CHECK_AND_RETURN_NULL(cuGraphExecDestroy(graphExec));
+  CUDA_CHECK_AND_RETURN_NULL(cuGraphDestroy(graph));
+  Py_RETURN_NONE;
+}
+
+typedef PyObject *(*launch_t)(PyObject *self, PyObject *args);
+
+// Runs a list of `(launch_capsule, args)` pairs back to back, where
+// `launch_capsule` wraps the `launch` entry point of a launcher and `args` is
+// the tuple that would otherwise be passed to it from Python. The context of
+// the capsule, if any, is passed to the entry point as `self`.
+static PyObject *launchBatch(PyObject *self, PyObject *args) {
+  PyObject *launches;
+  if (!PyArg_ParseTuple(args, "O!", &PyList_Type, &launches)) {
+    return NULL;
+  }
+  Py_ssize_t numLaunches = PyList_GET_SIZE(launches);
+  for (Py_ssize_t i = 0; i < numLaunches; i++) {
+    PyObject *item = PyList_GET_ITEM(launches, i);
+    if (!PyTuple_Check(item) || PyTuple_GET_SIZE(item) != 2 ||
+        !PyTuple_Check(PyTuple_GET_ITEM(item, 1))) {
+      PyErr_SetString(PyExc_TypeError,
+                      "launch_batch expects a list of (launcher, args) pairs");
+      return NULL;
+    }
+    PyObject *capsule = PyTuple_GET_ITEM(item, 0);
+    launch_t launch = (launch_t)PyCapsule_GetPointer(capsule, "triton.launch");
+    if (launch == NULL)
+      return NULL;
+    PyObject *ret = launch((PyObject *)PyCapsule_GetContext(capsule),
+                           PyTuple_GET_ITEM(item, 1));
+    if (ret == NULL)
+      return NULL;
+    Py_DECREF(ret);
+  }
+  Py_RETURN_NONE;
+}
+
+// Compiles PTX to a cubin with the JIT compiler of the driver, in-process and
+// without holding the GIL. Returns `(cubin, info_log)`.
+static PyObject *compilePtx(PyObject *self, PyObject *args) {
+  const char *ptx;
+  Py_ssize_t ptx_size;
+  int capability;
+  int line_info;
+  int device;
+  if (!PyArg_ParseTuple(args, "s#iii", &ptx, &ptx_size, &capability,
+                        &line_info, &device)) {
+    return NULL;
+  }
+  // sm_90a is needed for wgmma and setmaxnreg, as with ptxas
+  CUjit_target target = capability == 90 ? CU_TARGET_COMPUTE_90A
+                                         : (CUjit_target)capability;
+  char info_log[16384] = {0};
+  char error_log[16384] = {0};
+  CUjit_option options[] = {
+      CU_JIT_TARGET,           CU_JIT_GENERATE_LINE_INFO,
+      CU_JIT_INFO_LOG_BUFFER,  CU_JIT_INFO_LOG_BUFFER_SIZE_BYTES,
+      CU_JIT_ERROR_LOG_BUFFER, CU_JIT_ERROR_LOG_BUFFER_SIZE_BYTES,
+      CU_JIT_LOG_VERBOSE};
+  void *option_values[] = {(void *)(uintptr_t)target,
+                           (void *)(uintptr_t)line_info,
+                           info_log,
+                           (void *)(uintptr_t)sizeof(info_log),
+                           error_log,
+                           (void *)(uintptr_t)sizeof(error_log),
+                           (void *)(uintptr_t)1};
+  CUcontext pctx = 0;
+  CUlinkState state = NULL;
+  void *cubin = NULL;
+  size_t cubin_size = 0;
+  PyObject *ret = NULL;
+  CUresult err = CUDA_SUCCESS;
+
+  Py_BEGIN_ALLOW_THREADS;
+  err = cuCtxGetCurrent(&pctx);
+  if (err == CUDA_SUCCESS && !pctx) {
+    err = cuDevicePrimaryCtxRetain(&pctx, device);
+    if (err == CUDA_SUCCESS)
+      err = cuCtxSetCurrent(pctx);
+  }
+  if (err == CUDA_SUCCESS)
+    err = cuLinkCreate(sizeof(options) / sizeof(options[0]), options,
+                       option_values, &state);
+  if (err == CUDA_SUCCESS)
+    // the size includes the NUL terminator of the Python string
+    err = cuLinkAddData(state, CU_JIT_INPUT_PTX, (void *)ptx, ptx_size + 1,
+                        "triton.ptx", 0, NULL, NULL);
+  if (err == CUDA_SUCCESS)
+    err = cuLinkComplete(state, &cubin, &cubin_size);
+  Py_END_ALLOW_THREADS;
+
+  if (err == CUDA_SUCCESS) {
+    // the cubin is owned by `state`
+    ret = Py_BuildValue("(y#s)", (char *)cubin, (Py_ssize_t)cubin_size,
+                        info_log);
+  } else {
+    const char *str;
+    cuGetErrorString(err, &str);
+    PyErr_Format(PyExc_RuntimeError, "Triton Error [CUDA]: %s\n%s", str,
+                 error_log);
+  }
+  if (state)
+    cuLinkDestroy(state);
+  return ret;
+}
+
 static PyMethodDef ModuleMethods[] = {
     {"load_binary", loadBinary, METH_VARARGS,
      "Load provided cubin into CUDA driver"},
     {"get_device_properties", getDeviceProperties, METH_VARARGS,
      "Get the properties for a given device"},
+    {"read_global", readGlobal, METH_VARARGS,
+     "Read (and reset) a global variable of a loaded module"},
     {"cuMemAlloc", memAlloc, METH_VARARGS},
     {"cuMemcpyHtoD", memcpyHtoD, METH_VARARGS},
     {"cuMemFree", memFree, METH_VARARGS},
     {"cuTensorMapEncodeTiled", tensorMapEncodeTiled, METH_VARARGS,
      "Python interface for cuTensorMapEncodeTiled function"},
+    {"tensormap_device", tensorMapDevice, METH_VARARGS,
+     "Get a (cached) device copy of the tensor map with the given parameters"},
     {"cuOccupancyMaxActiveClusters", occupancyMaxActiveClusters, METH_VARARGS,
      "Python interface for cuOccupancyMaxActiveClusters function"},
+    {"occupancy", occupancy, METH_VARARGS,
+     "Get the number of CTAs (and clusters) of a kernel that can be resident "
+     "at once"},
+    {"set_access_policy_window", setAccessPolicyWindow, METH_VARARGS,
+     "Set the L2 access policy window of a stream for persisting accesses"},
+    {"cuStreamBeginCapture", streamBeginCapture, METH_VARARGS,
+     "Start capturing the work submitted to a stream into a CUDA graph"},
+    {"cuStreamEndCapture", streamEndCapture, METH_VARARGS,
+     "Stop capturing a stream and instantiate the captured CUDA graph"},
+    {"get_capture_node", streamGetCaptureNode, METH_VARARGS,
+     "Get the node most recently captured on a stream"},
+    {"cuGraphLaunch", graphLaunch, METH_VARARGS,
+     "Launch an instantiated CUDA graph"},
+    {"graph_destroy", graphDestroy, METH_VARARGS,
+     "Destroy a CUDA graph and its instantiation"},
+    {"launch_batch", launchBatch, METH_VARARGS,
+     "Run several generated launchers with a single call"},
+    {"compile_ptx", compilePtx, METH_VARARGS,
+     "Compile PTX to a cubin with the JIT compiler of the driver"},
     {NULL, NULL, 0, NULL} // sentinel
 };
 
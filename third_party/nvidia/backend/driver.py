@@ -1,3 +1,5 @@
+import ctypes
+import functools
 import os
 import hashlib
 import tempfile
@@ -5,6 +7,7 @@ from pathlib import Path
 from triton.runtime.build import _build
 from triton.runtime.cache import get_cache_manager
 from triton.backends.driver import GPUDriver
+from triton._C.libtriton import nvidia
 
 dirname = os.path.dirname(os.path.realpath(__file__))
 include_dir = [os.path.join(dirname, "include")]
@@ -12,8 +15,9 @@ library_dir = [os.path.join(dirname, "lib")]
 libraries = ['cuda']
 
 
-def compile_module_from_src(src, name):
-    key = hashlib.md5(src.encode("utf-8")).hexdigest()
+def compile_module_from_src(src, name, extra_include_dirs=(), extra_library_dirs=(), extra_libraries=()):
+    extra = (extra_include_dirs, extra_library_dirs, extra_libraries)
+    key = hashlib.md5((src + (repr(extra) if any(extra) else "")).encode("utf-8")).hexdigest()
     cache = get_cache_manager(key)
     cache_path = cache.get_file(f"{name}.so")
     if cache_path is None:
@@ -21,7 +25,8 @@ def compile_module_from_src(src, name):
             src_path = os.path.join(tmpdir, "main.c")
             with open(src_path, "w") as f:
                 f.write(src)
-            so = _build(name, src_path, tmpdir, library_dir, include_dir, libraries)
+            so = _build(name, src_path, tmpdir, library_dir + list(extra_library_dirs),
+                        include_dir + list(extra_include_dirs), libraries + list(extra_libraries))
             with open(so, "rb") as f:
                 cache_path = cache.put(f.read(), f"{name}.so", binary=True)
     import importlib.util
@@ -53,10 +58,58 @@ class CudaUtils(object):
         self.CUtensorMapL2promotion = mod.CUtensorMapL2promotion
         self.CUtensorMapFloatOOBfill = mod.CUtensorMapFloatOOBfill
         self.cuTensorMapEncodeTiled = mod.cuTensorMapEncodeTiled
+        self.tensormap_device = mod.tensormap_device
+        self.read_global = mod.read_global
         self.cuMemAlloc = mod.cuMemAlloc
         self.cuMemcpyHtoD = mod.cuMemcpyHtoD
         self.cuMemFree = mod.cuMemFree
         self.cuOccupancyMaxActiveClusters = mod.cuOccupancyMaxActiveClusters
+        self.occupancy = mod.occupancy
+        self.set_access_policy_window = mod.set_access_policy_window
+        self.cuStreamBeginCapture = mod.cuStreamBeginCapture
+        self.cuStreamEndCapture = mod.cuStreamEndCapture
+        self.get_capture_node = mod.get_capture_node
+        self.cuGraphLaunch = mod.cuGraphLaunch
+        self.graph_destroy = mod.graph_destroy
+        self.launch_batch = mod.launch_batch
+        self.compile_ptx = mod.compile_ptx
+
+
+def _cupti_dirs():
+    # CUPTI ships with the CUDA toolkit and in the nvidia-cuda-cupti wheel
+    roots = [os.environ.get("TRITON_CUPTI_PATH", "")]
+    for var in ("CUDA_HOME", "CUDA_PATH"):
+        if os.environ.get(var):
+            roots.append(os.path.join(os.environ[var], "extras", "CUPTI"))
+    roots.append("/usr/local/cuda/extras/CUPTI")
+    try:
+        import nvidia.cuda_cupti
+        roots += list(nvidia.cuda_cupti.__path__)
+    except ImportError:
+        pass
+    for root in roots:
+        if not os.path.exists(os.path.join(root, "include", "cupti.h")):
+            continue
+        for lib in ("lib64", "lib"):
+            lib_dir = os.path.join(root, lib)
+            names = sorted(os.listdir(lib_dir)) if os.path.isdir(lib_dir) else []
+            names = [name for name in names if name.startswith("libcupti.so")]
+            if names:
+                return os.path.join(root, "include"), lib_dir, names[0]
+    raise RuntimeError("Cannot find CUPTI; set TRITON_CUPTI_PATH to the directory with its include and lib64")
+
+
+@functools.lru_cache()
+def pc_sampling():
+    """
+    The CUPTI PC sampling module (pc_sampling.c), built on first use against
+    the CUPTI of the CUDA toolkit.
+    """
+    include, lib_dir, lib = _cupti_dirs()
+    # the module doesn't record where libcupti is
+    ctypes.CDLL(os.path.join(lib_dir, lib), mode=ctypes.RTLD_GLOBAL)
+    src = Path(os.path.join(dirname, "pc_sampling.c")).read_text()
+    return compile_module_from_src(src, "pc_sampling", [include], [lib_dir], [":" + lib])
 
 
 # ------------------------
@@ -73,6 +126,8 @@ def ty_to_cpp(ty):
         "i16": "int16_t",
         "i32": "int32_t",
         "i64": "int64_t",
+        "u8": "uint8_t",
+        "u16": "uint16_t",
         "u32": "uint32_t",
         "u64": "uint64_t",
         "fp16": "float",
@@ -92,19 +147,61 @@ def generate_cu_signature(constants, signature, ids):
     return signature, num_regular_signatures
 
 
-def make_launcher(constants, signature, ids):
+def kernel_params(constants, signature, ids):
     # Record the end of regular arguments;
     # subsequent arguments are architecture-specific descriptors, such as tensor descriptors for CUDA.
     signature, desc_start_idx = generate_cu_signature(constants, signature, ids)
+    folded_without_constexprs = [c for c in ids['ids_of_folded_args'] if c not in ids['ids_of_const_exprs']]
+    params = [
+        i for i in signature.keys()
+        if i >= desc_start_idx or (i not in constants and i not in folded_without_constexprs)
+    ]
+    return signature, params
+
+
+def launcher_signature(constants, signature, ids):
+    """Describes the kernel arguments of a launcher to `nvidia.GenericLauncher`"""
+    signature, params = kernel_params(constants, signature, ids)
+
+    def type_code(ty):
+        if ty[0] == '*':
+            return 'p'
+        return {
+            'i1': 'i',
+            'i8': 'b',
+            'i16': 'h',
+            'i32': 'i',
+            'i64': 'l',
+            'u8': 'B',
+            'u16': 'H',
+            'u32': 'I',
+            'u64': 'K',
+            'fp16': 'f',
+            'bf16': 'f',
+            'fp32': 'f',
+            'f32': 'f',
+            'fp64': 'd',
+        }[ty]
+
+    return ''.join(type_code(ty) if i in params else 'x' for i, ty in signature.items())
+
+
+def make_launcher(constants, signature, ids):
+    signature, params = kernel_params(constants, signature, ids)
     arg_decls = ', '.join(f"{ty_to_cpp(ty)} arg{i}" for i, ty in signature.items())
 
     def _extracted_type(ty):
         if ty[0] == '*':
             return "PyObject*"
         return {
+            # parsed as 32-bit integers, `_launch` narrows them
             'i1': 'int32_t',
+            'i8': 'int32_t',
+            'i16': 'int32_t',
             'i32': 'int32_t',
             'i64': 'int64_t',
+            'u8': 'uint32_t',
+            'u16': 'uint32_t',
             'u32': 'uint32_t',
             'u64': 'uint64_t',
             'fp16': 'float',
@@ -129,11 +226,28 @@ def make_launcher(constants, signature, ids):
     format = "iiiiiiiiiKKOOO" + ''.join([format_of(_extracted_type(ty)) for ty in signature.values()])
 
     # generate glue code
-    folded_without_constexprs = [c for c in ids['ids_of_folded_args'] if c not in ids['ids_of_const_exprs']]
-    params = [
-        i for i in signature.keys()
-        if i >= desc_start_idx or (i not in constants and i not in folded_without_constexprs)
-    ]
+    # pieces shared by every entry point that parses launch arguments
+    launch_arg_decls = f"""int gridX, gridY, gridZ;
+  uint64_t _stream;
+  uint64_t _function;
+  int num_warps;
+  int num_ctas;
+  int clusterDimX;
+  int clusterDimY;
+  int clusterDimZ;
+  int shared_memory;
+  PyObject *launch_enter_hook = NULL;
+  PyObject *launch_exit_hook = NULL;
+  PyObject *compiled_kernel = NULL;
+  {' '.join([f"{_extracted_type(ty)} _arg{i}; " for i, ty in signature.items()])}"""
+    launch_arg_refs = "&gridX, &gridY, &gridZ, &num_warps, &num_ctas, &clusterDimX, &clusterDimY, &clusterDimZ, &shared_memory, &_stream, &_function, &launch_enter_hook, &launch_exit_hook, &compiled_kernel" + (
+        ', ' + ', '.join(f"&_arg{i}" for i, ty in signature.items()) if len(signature) > 0 else '')
+    ptr_info_decls = "; ".join([
+        f"DevicePtrInfo ptr_info{i} = getPointer(_arg{i}, {i}); if (!ptr_info{i}.valid) return NULL;"
+        if ty[0] == "*" else "" for i, ty in signature.items()
+    ])
+    kernel_arg_values = ', ' + ', '.join(f"ptr_info{i}.dev_ptr" if ty[0] == "*" else f"_arg{i}"
+                                         for i, ty in signature.items()) if len(signature) > 0 else ''
     src = f"""
 #include \"cuda.h\"
 #include <stdbool.h>
@@ -213,6 +327,22 @@ static void _launch(int gridX, int gridY, int gridZ, int num_warps, int num_ctas
   }}
 }}
 
+static void _set_graph_node_params(CUgraphExec graph_exec, CUgraphNode node, int gridX, int gridY, int gridZ, int num_warps, int shared_memory, CUfunction function{', ' + arg_decls if len(arg_decls) > 0 else ''}) {{
+  void *params[] = {{ {', '.join(f"&arg{i}" for i in params)} }};
+  CUDA_KERNEL_NODE_PARAMS node_params = {{0}};
+  node_params.func = function;
+  node_params.gridDimX = gridX;
+  node_params.gridDimY = gridY;
+  node_params.gridDimZ = gridZ;
+  node_params.blockDimX = 32 * num_warps;
+  node_params.blockDimY = 1;
+  node_params.blockDimZ = 1;
+  node_params.sharedMemBytes = shared_memory;
+  node_params.kernelParams = params;
+  // parameters are copied, so `params` may go out of scope after this call
+  CUDA_CHECK(cuGraphExecKernelNodeSetParams(graph_exec, node, &node_params));
+}}
+
 typedef struct _DevicePtrInfo {{
     CUdeviceptr dev_ptr;
     bool valid;
@@ -261,20 +391,8 @@ static inline DevicePtrInfo getPointer(PyObject *obj, int idx) {{
 }}
 
 static PyObject* launch(PyObject* self, PyObject* args) {{
-  int gridX, gridY, gridZ;
-  uint64_t _stream;
-  uint64_t _function;
-  int num_warps;
-  int num_ctas;
-  int clusterDimX;
-  int clusterDimY;
-  int clusterDimZ;
-  int shared_memory;
-  PyObject *launch_enter_hook = NULL;
-  PyObject *launch_exit_hook = NULL;
-  PyObject *compiled_kernel = NULL;
-  {' '.join([f"{_extracted_type(ty)} _arg{i}; " for i, ty in signature.items()])}
-  if(!PyArg_ParseTuple(args, \"{format}\", &gridX, &gridY, &gridZ, &num_warps, &num_ctas, &clusterDimX, &clusterDimY, &clusterDimZ, &shared_memory, &_stream, &_function, &launch_enter_hook, &launch_exit_hook, &compiled_kernel{', ' + ', '.join(f"&_arg{i}" for i, ty in signature.items()) if len(signature) > 0 else ''})) {{
+  {launch_arg_decls}
+  if(!PyArg_ParseTuple(args, \"{format}\", {launch_arg_refs})) {{
     return NULL;
   }}
 
@@ -284,9 +402,9 @@ static PyObject* launch(PyObject* self, PyObject* args) {{
 
 
   // raise exception asap
-  {"; ".join([f"DevicePtrInfo ptr_info{i} = getPointer(_arg{i}, {i}); if (!ptr_info{i}.valid) return NULL;" if ty[0] == "*" else "" for i, ty in signature.items()])};
+  {ptr_info_decls};
   Py_BEGIN_ALLOW_THREADS;
-  _launch(gridX, gridY, gridZ, num_warps, num_ctas, clusterDimX, clusterDimY, clusterDimZ, shared_memory, (CUstream)_stream, (CUfunction)_function{', ' + ', '.join(f"ptr_info{i}.dev_ptr" if ty[0]=="*" else f"_arg{i}"for i, ty in signature.items()) if len(signature) > 0 else ''});
+  _launch(gridX, gridY, gridZ, num_warps, num_ctas, clusterDimX, clusterDimY, clusterDimZ, shared_memory, (CUstream)_stream, (CUfunction)_function{kernel_arg_values});
   Py_END_ALLOW_THREADS;
   if (PyErr_Occurred()) {{
     return NULL;
@@ -301,8 +419,35 @@ static PyObject* launch(PyObject* self, PyObject* args) {{
   return Py_None;
 }}
 
+// Same arguments as `launch`, prefixed with an instantiated graph and one of
+// its kernel nodes. Instead of launching, updates the parameters of the node.
+static PyObject* set_graph_node_params(PyObject* self, PyObject* args) {{
+  uint64_t _graph_exec;
+  uint64_t _node;
+  {launch_arg_decls}
+  if(!PyArg_ParseTuple(args, \"KK{format}\", &_graph_exec, &_node, {launch_arg_refs})) {{
+    return NULL;
+  }}
+  if (num_ctas != 1) {{
+    PyErr_SetString(PyExc_RuntimeError, "Updating graph nodes of kernels launched on clusters is not supported");
+    return NULL;
+  }}
+
+  {ptr_info_decls};
+  Py_BEGIN_ALLOW_THREADS;
+  _set_graph_node_params((CUgraphExec)_graph_exec, (CUgraphNode)_node, gridX, gridY, gridZ, num_warps, shared_memory, (CUfunction)_function{kernel_arg_values});
+  Py_END_ALLOW_THREADS;
+  if (PyErr_Occurred()) {{
+    return NULL;
+  }}
+
+  Py_INCREF(Py_None);
+  return Py_None;
+}}
+
 static PyMethodDef ModuleMethods[] = {{
   {{"launch", launch, METH_VARARGS, "Entry point for all kernels with this signature"}},
+  {{"set_graph_node_params", set_graph_node_params, METH_VARARGS, "Update the kernel node of a CUDA graph"}},
   {{NULL, NULL, 0, NULL}} // sentinel
 }};
 
@@ -320,6 +465,13 @@ PyMODINIT_FUNC PyInit___triton_launcher(void) {{
     return NULL;
   }}
   PyModule_AddFunctions(m, ModuleMethods);
+  // lets `cuda_utils.launch_batch` call `launch` without going through Python
+  PyObject *launch_capsule = PyCapsule_New((void *)launch, "triton.launch", NULL);
+  if (launch_capsule == NULL || PyModule_AddObject(m, "launch_capsule", launch_capsule) < 0) {{
+    Py_XDECREF(launch_capsule);
+    Py_DECREF(m);
+    return NULL;
+  }}
   return m;
 }}
 """
@@ -335,13 +487,110 @@ class CudaLauncher(object):
             "ids_of_const_exprs": src.fn.constexprs if hasattr(src, "fn") else tuple()
         }
         constants = src.constants if hasattr(src, "constants") else dict()
+        signature = dict(src.signature)
+        if metadata.persistent:
+            # the grid of the tiles follows the kernel's arguments, see
+            # `CompiledKernel.persistent_launch`
+            first = max([*signature, *constants], default=-1) + 1
+            signature.update({first + i: 'i32' for i in range(3)})
         enable_warp_specialization = False
-        src = make_launcher(constants, src.signature, ids)
-        mod = compile_module_from_src(src, "__triton_launcher")
-        self.launch = mod.launch
+        cooperative = getattr(metadata, "cooperative", False)
+        # only the generic launcher launches cooperative kernels
+        if os.environ.get("TRITON_COMPILED_LAUNCHER", "0") == "1" and not cooperative:
+            # a C extension specialized for this signature, slightly faster to
+            # call but built with the host compiler on first use
+            src = make_launcher(constants, signature, ids)
+            mod = compile_module_from_src(src, "__triton_launcher")
+            self.launch = mod.launch
+            self.launch_capsule = mod.launch_capsule
+            self.set_graph_node_params = mod.set_graph_node_params
+        else:
+            launcher = nvidia.GenericLauncher(launcher_signature(constants, signature, ids), cooperative)
+            self.launch = launcher.launch
+            self.launch_capsule = launcher.launch_capsule
+            self.set_graph_node_params = launcher.set_graph_node_params
 
     def __call__(self, *args, **kwargs):
         self.launch(*args, **kwargs)
+        if CudaGraph.capturing is not None:
+            CudaGraph.capturing._record(self, args)
+
+
+# ------------------------
+# Graphs
+# ------------------------
+
+
+class CudaGraph:
+    """
+    Records the Triton kernels launched inside a `with` block into a CUDA graph
+    that can then be replayed with a single `cuGraphLaunch`:
+
+        with torch.cuda.stream(s):
+            with driver.graph() as g:
+                kernel_a[grid](x, y)
+                kernel_b[grid](y, z)
+        g.replay()
+
+    Capture must happen on a non-default stream. The arguments of each
+    recorded launch (its "slot", in launch order) can be changed after
+    capture with `update`, which only rewrites the parameters of the
+    corresponding kernel node instead of re-capturing the graph.
+    """
+
+    # the graph currently being captured, if any
+    capturing = None
+
+    def __init__(self, driver):
+        self.driver = driver
+        self.utils = driver.utils
+        self.graph = None
+        self.graph_exec = None
+        self.stream = None
+        # (launcher, kernel node, launch arguments) for each recorded launch
+        self.slots = []
+
+    def __enter__(self):
+        assert CudaGraph.capturing is None, "nested graph capture is not supported"
+        assert self.graph is None, "graph has already been captured"
+        self.stream = self.driver.get_current_stream(self.driver.get_current_device())
+        self.utils.cuStreamBeginCapture(self.stream)
+        CudaGraph.capturing = self
+        return self
+
+    def __exit__(self, exc_type, exc_value, traceback):
+        CudaGraph.capturing = None
+        self.graph, self.graph_exec = self.utils.cuStreamEndCapture(self.stream)
+
+    def _record(self, launcher, args):
+        # args[9] is the stream the kernel was launched on
+        if args[9] != self.stream:
+            return
+        node = self.utils.get_capture_node(self.stream)
+        if node:
+            self.slots.append((launcher, node, args))
+
+    def update(self, slot, *kernel_args):
+        """
+        Replaces the kernel arguments of the `slot`-th recorded launch (i.e.,
+        its non-constexpr arguments, in order) for subsequent replays.
+        """
+        launcher, node, args = self.slots[slot]
+        metadata = args[13]
+        assert not metadata.tensormaps_info, "updating kernels with TMA descriptors is not supported"
+        assert len(kernel_args) == len(args) - 14, "wrong number of kernel arguments"
+        args = args[:14] + tuple(kernel_args)
+        launcher.set_graph_node_params(self.graph_exec, node, *args)
+        self.slots[slot] = (launcher, node, args)
+
+    def replay(self, stream=None):
+        if stream is None:
+            stream = self.driver.get_current_stream(self.driver.get_current_device())
+        self.utils.cuGraphLaunch(self.graph_exec, stream)
+
+    def __del__(self):
+        if self.graph is not None:
+            self.utils.graph_destroy(self.graph, self.graph_exec)
 
 
 # ------------------------
@@ -350,26 +599,17 @@ class CudaLauncher(object):
 
 
 class TensorMapManager:
+    """
+    Returns device copies of the tensor maps kernels take as arguments. The
+    copies are cached in `cuda_utils`, keyed by the encoded parameters.
+    """
 
     def __init__(self, utils):
-        self.tensormaps_device = {}
         self.utils = utils
 
     def __getitem__(self, key: tuple):
-        if key in self.tensormaps_device:
-            return int(self.tensormaps_device[key])
-        else:
-            (e, args) = key
-            t_tensormap = e.tensormap(args)
-            TENSORMAP_SIZE_IN_BYTES = 128
-            t_tensormap_device = self.utils.cuMemAlloc(TENSORMAP_SIZE_IN_BYTES)
-            self.utils.cuMemcpyHtoD(t_tensormap_device, t_tensormap, TENSORMAP_SIZE_IN_BYTES)
-            self.tensormaps_device[key] = t_tensormap_device
-            return int(self.tensormaps_device[key])
-
-    def __del__(self):
-        for _, v in self.tensormaps_device.items():
-            self.utils.cuMemFree(v)
+        (e, args) = key
+        return self.utils.tensormap_device(*e.tensormap_args(args))
 
 
 class CudaDriver(GPUDriver):
@@ -387,6 +627,19 @@ class CudaDriver(GPUDriver):
         capability = capability[0] * 10 + capability[1]
         return ("cuda", capability)
 
+    def graph(self):
+        return CudaGraph(self)
+
+    def direct_launch_capsule(self, launcher):
+        # launches must go through `CudaLauncher.__call__` to be recorded
+        return None if CudaGraph.capturing is not None else launcher.launch_capsule
+
+    def launch_batch(self, launches):
+        if CudaGraph.capturing is not None:
+            # launches must go through `CudaLauncher.__call__` to be recorded
+            return super().launch_batch(launches)
+        self.utils.launch_batch([(launcher.launch_capsule, args) for launcher, args in launches])
+
     @staticmethod
     def is_active():
         import torch
@@ -395,8 +648,7 @@ class CudaDriver(GPUDriver):
     def assemble_tensormap_to_arg(self, tensormaps_info, args):
         args_with_tma = list(args)
         if tensormaps_info is not None:
-            # tuple for hashable
-            args_ptr = tuple([arg.data_ptr() if hasattr(arg, 'data_ptr') else arg for arg in args])
+            args_ptr = [arg.data_ptr() if hasattr(arg, 'data_ptr') else arg for arg in args]
             for i, e in enumerate(tensormaps_info):
                 args_with_tma.append(self.tensormap_manager[(e, args_ptr)])
         return args_with_tma
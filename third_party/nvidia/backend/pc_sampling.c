@@ -0,0 +1,329 @@
+#include "cuda.h"
+#include <cupti.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+
+// CUPTI PC sampling of the kernels of the current context, for
+// `triton.tools.line_profile`. The kernels are serialized while sampling, and
+// the samples come out parsed per cubin, function and PC offset.
+
+static bool cuptiAssert(CUptiResult code) {
+  if (code == CUPTI_SUCCESS)
+    return true;
+  const char *str = NULL;
+  cuptiGetResultString(code, &str);
+  PyErr_Format(PyExc_RuntimeError, "Triton Error [CUPTI]: %s",
+               str ? str : "unknown error");
+  return false;
+}
+
+#define CUPTI_CHECK_AND_RETURN_NULL(ans)                                       \
+  do {                                                                         \
+    if (!cuptiAssert(ans))                                                     \
+      return NULL;                                                             \
+  } while (0)
+
+// The sampling state of the context PC sampling is enabled on
+static CUcontext context = NULL;
+static size_t numStallReasons = 0;
+static uint32_t *stallReasonIndices = NULL;
+static char **stallReasonNames = NULL;
+// CUPTI writes the samples here when sampling stops, and `getData` the ones
+// that didn't fit
+static CUpti_PCSamplingData samplingData;
+
+static void freeState(void) {
+  if (samplingData.pPcData) {
+    for (size_t i = 0; i < samplingData.collectNumPcs; ++i)
+      free(samplingData.pPcData[i].stallReason);
+    free(samplingData.pPcData);
+  }
+  memset(&samplingData, 0, sizeof(samplingData));
+  if (stallReasonNames) {
+    for (size_t i = 0; i < numStallReasons; ++i)
+      free(stallReasonNames[i]);
+    free(stallReasonNames);
+  }
+  stallReasonNames = NULL;
+  free(stallReasonIndices);
+  stallReasonIndices = NULL;
+  numStallReasons = 0;
+  context = NULL;
+}
+
+static bool allocState(size_t numPcs) {
+  stallReasonIndices = calloc(numStallReasons, sizeof(uint32_t));
+  stallReasonNames = calloc(numStallReasons, sizeof(char *));
+  samplingData.size = sizeof(CUpti_PCSamplingData);
+  samplingData.collectNumPcs = numPcs;
+  samplingData.pPcData = calloc(numPcs, sizeof(CUpti_PCSamplingPCData));
+  if (!stallReasonIndices || !stallReasonNames || !samplingData.pPcData)
+    return false;
+  for (size_t i = 0; i < numStallReasons; ++i) {
+    stallReasonNames[i] = calloc(CUPTI_STALL_REASON_STRING_SIZE, 1);
+    if (!stallReasonNames[i])
+      return false;
+  }
+  for (size_t i = 0; i < numPcs; ++i) {
+    samplingData.pPcData[i].size = sizeof(CUpti_PCSamplingPCData);
+    samplingData.pPcData[i].stallReason =
+        calloc(numStallReasons, sizeof(CUpti_PCSamplingStallReason));
+    if (!samplingData.pPcData[i].stallReason)
+      return false;
+  }
+  return true;
+}
+
+static bool configure(uint32_t samplingPeriod) {
+  CUpti_PCSamplingConfigurationInfo info[6];
+  memset(info, 0, sizeof(info));
+  info[0].attributeType =
+      CUPTI_PC_SAMPLING_CONFIGURATION_ATTR_TYPE_SAMPLING_PERIOD;
+  info[0].attributeData.samplingPeriodData.samplingPeriod = samplingPeriod;
+  info[1].attributeType =
+      CUPTI_PC_SAMPLING_CONFIGURATION_ATTR_TYPE_STALL_REASON;
+  info[1].attributeData.stallReasonData.stallReasonCount = numStallReasons;
+  info[1].attributeData.stallReasonData.pStallReasonIndex = stallReasonIndices;
+  // the samples of each kernel are complete when it returns
+  info[2].attributeType =
+      CUPTI_PC_SAMPLING_CONFIGURATION_ATTR_TYPE_COLLECTION_MODE;
+  info[2].attributeData.collectionModeData.collectionMode =
+      CUPTI_PC_SAMPLING_COLLECTION_MODE_KERNEL_SERIALIZED;
+  info[3].attributeType =
+      CUPTI_PC_SAMPLING_CONFIGURATION_ATTR_TYPE_ENABLE_START_STOP_CONTROL;
+  info[3].attributeData.enableStartStopControlData.enableStartStopControl = 1;
+  info[4].attributeType =
+      CUPTI_PC_SAMPLING_CONFIGURATION_ATTR_TYPE_OUTPUT_DATA_FORMAT;
+  info[4].attributeData.outputDataFormatData.outputDataFormat =
+      CUPTI_PC_SAMPLING_OUTPUT_DATA_FORMAT_PARSED;
+  info[5].attributeType =
+      CUPTI_PC_SAMPLING_CONFIGURATION_ATTR_TYPE_SAMPLING_DATA_BUFFER;
+  info[5].attributeData.samplingDataBufferData.samplingDataBuffer =
+      &samplingData;
+
+  CUpti_PCSamplingConfigurationInfoParams params;
+  memset(&params, 0, sizeof(params));
+  params.size = CUpti_PCSamplingConfigurationInfoParamsSize;
+  params.ctx = context;
+  params.numAttributes = sizeof(info) / sizeof(info[0]);
+  params.pPCSamplingConfigurationInfo = info;
+  return cuptiAssert(cuptiPCSamplingSetConfigurationAttribute(&params));
+}
+
+static PyObject *disableSampling(PyObject *self, PyObject *args);
+
+// enable(sampling_period, num_pcs) -> {stall reason index: name}
+// Enables PC sampling on the current context, sampling every
+// 2^(5 + sampling_period) cycles of each SM and keeping up to `num_pcs` PCs
+// per call to `getData`.
+static PyObject *enableSampling(PyObject *self, PyObject *args) {
+  unsigned int samplingPeriod;
+  Py_ssize_t numPcs;
+  if (!PyArg_ParseTuple(args, "In", &samplingPeriod, &numPcs))
+    return NULL;
+  if (context) {
+    PyErr_SetString(PyExc_RuntimeError, "PC sampling is already enabled");
+    return NULL;
+  }
+  CUcontext ctx = NULL;
+  cuCtxGetCurrent(&ctx);
+  if (!ctx) {
+    PyErr_SetString(PyExc_RuntimeError, "no current CUDA context");
+    return NULL;
+  }
+
+  CUpti_PCSamplingEnableParams enableParams;
+  memset(&enableParams, 0, sizeof(enableParams));
+  enableParams.size = CUpti_PCSamplingEnableParamsSize;
+  enableParams.ctx = ctx;
+  CUPTI_CHECK_AND_RETURN_NULL(cuptiPCSamplingEnable(&enableParams));
+  context = ctx;
+
+  CUpti_PCSamplingGetNumStallReasonsParams numParams;
+  memset(&numParams, 0, sizeof(numParams));
+  numParams.size = CUpti_PCSamplingGetNumStallReasonsParamsSize;
+  numParams.ctx = context;
+  numParams.numStallReasons = &numStallReasons;
+  if (!cuptiAssert(cuptiPCSamplingGetNumStallReasons(&numParams)))
+    goto error;
+  if (!allocState(numPcs)) {
+    PyErr_NoMemory();
+    goto error;
+  }
+  CUpti_PCSamplingGetStallReasonsParams reasonParams;
+  memset(&reasonParams, 0, sizeof(reasonParams));
+  reasonParams.size = CUpti_PCSamplingGetStallReasonsParamsSize;
+  reasonParams.ctx = context;
+  reasonParams.numStallReasons = numStallReasons;
+  reasonParams.stallReasonIndex = stallReasonIndices;
+  reasonParams.stallReasons = stallReasonNames;
+  if (!cuptiAssert(cuptiPCSamplingGetStallReasons(&reasonParams)) ||
+      !configure(samplingPeriod))
+    goto error;
+
+  PyObject *reasons = PyDict_New();
+  if (!reasons)
+    goto error;
+  for (size_t i = 0; i < numStallReasons; ++i) {
+    PyObject *index = PyLong_FromUnsignedLong(stallReasonIndices[i]);
+    PyObject *name = PyUnicode_FromString(stallReasonNames[i]);
+    int failed = !index || !name || PyDict_SetItem(reasons, index, name) < 0;
+    Py_XDECREF(index);
+    Py_XDECREF(name);
+    if (failed) {
+      Py_DECREF(reasons);
+      goto error;
+    }
+  }
+  return reasons;
+
+error:
+  // keep the error of the failing call
+  {
+    PyObject *type, *value, *traceback;
+    PyErr_Fetch(&type, &value, &traceback);
+    Py_XDECREF(disableSampling(self, NULL));
+    PyErr_Restore(type, value, traceback);
+  }
+  return NULL;
+}
+
+static PyObject *disableSampling(PyObject *self, PyObject *args) {
+  if (context) {
+    CUpti_PCSamplingDisableParams params;
+    memset(&params, 0, sizeof(params));
+    params.size = CUpti_PCSamplingDisableParamsSize;
+    params.ctx = context;
+    CUptiResult result = cuptiPCSamplingDisable(&params);
+    freeState();
+    CUPTI_CHECK_AND_RETURN_NULL(result);
+  }
+  Py_RETURN_NONE;
+}
+
+static PyObject *startSampling(PyObject *self, PyObject *args) {
+  CUpti_PCSamplingStartParams params;
+  memset(&params, 0, sizeof(params));
+  params.size = CUpti_PCSamplingStartParamsSize;
+  params.ctx = context;
+  CUPTI_CHECK_AND_RETURN_NULL(cuptiPCSamplingStart(&params));
+  Py_RETURN_NONE;
+}
+
+// Appends the samples of `samplingData` to `samples`, as
+// (cubin crc, function name, pc offset, ((stall reason index, samples), ...))
+static bool appendSamples(PyObject *samples) {
+  for (size_t i = 0; i < samplingData.totalNumPcs; ++i) {
+    CUpti_PCSamplingPCData *pc = &samplingData.pPcData[i];
+    PyObject *stalls = PyTuple_New(pc->stallReasonCount);
+    if (!stalls)
+      return false;
+    for (size_t j = 0; j < pc->stallReasonCount; ++j) {
+      CUpti_PCSamplingStallReason *stall = &pc->stallReason[j];
+      PyObject *item = Py_BuildValue(
+          "(II)", stall->pcSamplingStallReasonIndex, stall->samples);
+      if (!item) {
+        Py_DECREF(stalls);
+        return false;
+      }
+      PyTuple_SET_ITEM(stalls, j, item);
+    }
+    PyObject *sample =
+        Py_BuildValue("(KsKN)", (unsigned long long)pc->cubinCrc,
+                      pc->functionName ? pc->functionName : "",
+                      (unsigned long long)pc->pcOffset, stalls);
+    if (!sample || PyList_Append(samples, sample) < 0) {
+      Py_XDECREF(sample);
+      return false;
+    }
+    Py_DECREF(sample);
+  }
+  samplingData.totalNumPcs = 0;
+  return true;
+}
+
+// stop() -> (samples, total samples, dropped samples)
+// Stops sampling once the kernels of the context completed and returns the
+// samples taken since `start`.
+static PyObject *stopSampling(PyObject *self, PyObject *args) {
+  CUresult synced;
+  Py_BEGIN_ALLOW_THREADS;
+  synced = cuCtxSynchronize();
+  Py_END_ALLOW_THREADS;
+  if (synced != CUDA_SUCCESS) {
+    PyErr_SetString(PyExc_RuntimeError,
+                    "Triton Error [CUDA]: cuCtxSynchronize failed");
+    return NULL;
+  }
+  CUpti_PCSamplingStopParams stopParams;
+  memset(&stopParams, 0, sizeof(stopParams));
+  stopParams.size = CUpti_PCSamplingStopParamsSize;
+  stopParams.ctx = context;
+  CUPTI_CHECK_AND_RETURN_NULL(cuptiPCSamplingStop(&stopParams));
+
+  PyObject *samples = PyList_New(0);
+  if (!samples)
+    return NULL;
+  uint64_t total = 0, dropped = 0;
+  while (true) {
+    total += samplingData.totalSamples;
+    dropped += samplingData.droppedSamples;
+    if (!appendSamples(samples)) {
+      Py_DECREF(samples);
+      return NULL;
+    }
+    if (samplingData.remainingNumPcs == 0)
+      break;
+    CUpti_PCSamplingGetDataParams dataParams;
+    memset(&dataParams, 0, sizeof(dataParams));
+    dataParams.size = CUpti_PCSamplingGetDataParamsSize;
+    dataParams.ctx = context;
+    dataParams.pcSamplingData = &samplingData;
+    if (!cuptiAssert(cuptiPCSamplingGetData(&dataParams))) {
+      Py_DECREF(samples);
+      return NULL;
+    }
+  }
+  return Py_BuildValue("(NKK)", samples, (unsigned long long)total,
+                       (unsigned long long)dropped);
+}
+
+// cubin_crc(cubin) -> the CRC CUPTI identifies the samples of the cubin with
+static PyObject *cubinCrc(PyObject *self, PyObject *args) {
+  const char *data;
+  Py_ssize_t size;
+  if (!PyArg_ParseTuple(args, "y#", &data, &size))
+    return NULL;
+  CUpti_GetCubinCrcParams params;
+  memset(&params, 0, sizeof(params));
+  params.size = CUpti_GetCubinCrcParamsSize;
+  params.cubinSize = size;
+  params.cubin = data;
+  CUPTI_CHECK_AND_RETURN_NULL(cuptiGetCubinCrc(&params));
+  return PyLong_FromUnsignedLongLong(params.cubinCrc);
+}
+
+static PyMethodDef ModuleMethods[] = {
+    {"enable", enableSampling, METH_VARARGS,
+     "Enable PC sampling on the current context"},
+    {"disable", disableSampling, METH_NOARGS,
+     "Disable PC sampling and release its buffers"},
+    {"start", startSampling, METH_NOARGS, "Start taking samples"},
+    {"stop", stopSampling, METH_NOARGS,
+     "Stop taking samples and return the samples taken"},
+    {"cubin_crc", cubinCrc, METH_VARARGS,
+     "Get the CRC of a cubin the samples of its kernels refer to"},
+    {NULL, NULL, 0, NULL} // sentinel
+};
+
+static struct PyModuleDef ModuleDef = {PyModuleDef_HEAD_INIT, "pc_sampling",
+                                       NULL, // documentation
+                                       -1,   // size
+                                       ModuleMethods};
+
+PyMODINIT_FUNC PyInit_pc_sampling(void) {
+  return PyModule_Create(&ModuleDef);
+}
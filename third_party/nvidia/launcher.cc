@@ -0,0 +1,395 @@
+#include "cuda.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Support/ErrorHandling.h"
+#include <cstring>
+#include <dlfcn.h>
+#include <pybind11/pybind11.h>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+namespace py = pybind11;
+
+namespace {
+
+// Entry points of the driver API, resolved when the first kernel is launched
+// so that libtriton does not link against libcuda.
+struct CudaApi {
+  using cuLaunchKernel_t = CUresult (*)(CUfunction, unsigned, unsigned,
+                                        unsigned, unsigned, unsigned, unsigned,
+                                        unsigned, CUstream, void **, void **);
+  using cuLaunchKernelEx_t = CUresult (*)(const CUlaunchConfig *, CUfunction,
+                                          void **, void **);
+  using cuPointerGetAttribute_t = CUresult (*)(void *, CUpointer_attribute,
+                                               CUdeviceptr);
+  using cuGetErrorString_t = CUresult (*)(CUresult, const char **);
+  using cuGraphExecKernelNodeSetParams_t =
+      CUresult (*)(CUgraphExec, CUgraphNode, const CUDA_KERNEL_NODE_PARAMS *);
+
+  cuLaunchKernel_t launchKernel;
+  cuLaunchKernelEx_t launchKernelEx;
+  cuPointerGetAttribute_t pointerGetAttribute;
+  cuGetErrorString_t getErrorString;
+  cuGraphExecKernelNodeSetParams_t graphExecKernelNodeSetParams;
+
+  static const CudaApi &get() {
+    static const CudaApi api;
+    return api;
+  }
+
+private:
+  CudaApi() {
+    void *handle = dlopen("libcuda.so.1", RTLD_LAZY);
+    if (!handle)
+      handle = dlopen("libcuda.so", RTLD_LAZY);
+    if (!handle)
+      throw std::runtime_error("Failed to open libcuda.so");
+    auto lookup = [&](auto &fn, const char *name) {
+      fn = reinterpret_cast<std::remove_reference_t<decltype(fn)>>(
+          dlsym(handle, name));
+      if (!fn)
+        throw std::runtime_error(std::string("Failed to retrieve ") + name +
+                                 " from libcuda.so");
+    };
+    lookup(launchKernel, "cuLaunchKernel");
+    lookup(launchKernelEx, "cuLaunchKernelEx");
+    lookup(pointerGetAttribute, "cuPointerGetAttribute");
+    lookup(getErrorString, "cuGetErrorString");
+    // CUDA_KERNEL_NODE_PARAMS is the _v2 structure
+    lookup(graphExecKernelNodeSetParams, "cuGraphExecKernelNodeSetParams_v2");
+  }
+};
+
+void throwOnError(CUresult code) {
+  if (code == CUDA_SUCCESS)
+    return;
+  const char *str = "unknown error";
+  CudaApi::get().getErrorString(code, &str);
+  throw std::runtime_error(std::string("Triton Error [CUDA]: ") + str);
+}
+
+// Same conversion as `getPointer` in the generated launchers.
+CUdeviceptr getPointer(PyObject *obj, size_t idx) {
+  if (PyLong_Check(obj))
+    return PyLong_AsUnsignedLongLong(obj);
+  if (obj == Py_None)
+    return 0;
+  py::object dataPtr = py::reinterpret_steal<py::object>(
+      PyObject_GetAttrString(obj, "data_ptr"));
+  if (!dataPtr) {
+    PyErr_Clear();
+    throw py::type_error(
+        "Pointer argument must be either uint64 or have data_ptr method");
+  }
+  py::object ret = dataPtr();
+  if (!PyLong_Check(ret.ptr()))
+    throw py::type_error(
+        "data_ptr method of Pointer object must return 64-bit int");
+  CUdeviceptr ptr = PyLong_AsUnsignedLongLong(ret.ptr());
+  if (!ptr)
+    return ptr;
+  uint64_t devPtr;
+  if (CudaApi::get().pointerGetAttribute(
+          &devPtr, CU_POINTER_ATTRIBUTE_DEVICE_POINTER, ptr) ==
+      CUDA_ERROR_INVALID_VALUE)
+    throw py::value_error("Pointer argument (at " + std::to_string(idx) +
+                          ") cannot be accessed from Triton (cpu tensor?)");
+  return devPtr;
+}
+
+// The arguments every launcher takes before those of the kernel, as passed by
+// `CompiledKernel.run`.
+struct LaunchConfig {
+  int gridX, gridY, gridZ;
+  int numWarps, numCtas;
+  int clusterDimX, clusterDimY, clusterDimZ;
+  int sharedMemory;
+  CUstream stream;
+  CUfunction function;
+  PyObject *launchEnterHook;
+  PyObject *launchExitHook;
+};
+
+constexpr size_t kNumConfigArgs = 14;
+
+int asInt(PyObject *obj) {
+  long value = PyLong_AsLong(obj);
+  if (value == -1 && PyErr_Occurred())
+    throw py::error_already_set();
+  return static_cast<int>(value);
+}
+
+// Like the `K` format of PyArg_ParseTuple, does not check for overflow.
+uint64_t asUInt64(PyObject *obj) {
+  unsigned long long value = PyLong_AsUnsignedLongLongMask(obj);
+  if (value == (unsigned long long)-1 && PyErr_Occurred())
+    throw py::error_already_set();
+  return value;
+}
+
+LaunchConfig parseConfig(PyObject *args, size_t offset) {
+  auto item = [&](size_t i) { return PyTuple_GET_ITEM(args, offset + i); };
+  LaunchConfig config;
+  config.gridX = asInt(item(0));
+  config.gridY = asInt(item(1));
+  config.gridZ = asInt(item(2));
+  config.numWarps = asInt(item(3));
+  config.numCtas = asInt(item(4));
+  config.clusterDimX = asInt(item(5));
+  config.clusterDimY = asInt(item(6));
+  config.clusterDimZ = asInt(item(7));
+  config.sharedMemory = asInt(item(8));
+  config.stream = reinterpret_cast<CUstream>(asUInt64(item(9)));
+  config.function = reinterpret_cast<CUfunction>(asUInt64(item(10)));
+  config.launchEnterHook = item(11);
+  config.launchExitHook = item(12);
+  return config;
+}
+
+// A launcher that works for any kernel signature, so that launching a kernel
+// does not require building a C extension first. The signature has one
+// character per kernel argument of the launcher (see `launcher_signature` in
+// backend/driver.py): `p` for pointers, `b`/`B`, `h`/`H`, `i`/`I` and `l`/`K`
+// for 8/16/32/64-bit signed/unsigned integers, `f` and `d` for single and
+// double precision floats, and `x` for arguments that are not passed to the
+// kernel. Kernels synchronizing their grid with `tl.grid_sync` are launched
+// cooperatively.
+class GenericLauncher {
+public:
+  GenericLauncher(std::string signature, bool cooperative)
+      : signature(std::move(signature)), cooperative(cooperative) {
+    for (char c : this->signature)
+      if (!std::strchr("pbBhHiIlKfdx", c))
+        throw std::invalid_argument("Unsupported launcher signature: " +
+                                    this->signature);
+  }
+
+  void launch(py::args args) {
+    LaunchConfig config = parseArgs(args, 0);
+    if (config.launchEnterHook != Py_None &&
+        !py::reinterpret_steal<py::object>(
+            PyObject_CallObject(config.launchEnterHook, args.ptr())))
+      throw py::error_already_set();
+    ArgStorage storage;
+    llvm::SmallVector<void *, 16> params;
+    packKernelArgs(args, kNumConfigArgs, storage, params);
+    CUresult err = CUDA_SUCCESS;
+    {
+      py::gil_scoped_release allow_threads;
+      err = launchKernel(config, params.data());
+    }
+    throwOnError(err);
+    if (config.launchExitHook != Py_None &&
+        !py::reinterpret_steal<py::object>(
+            PyObject_CallObject(config.launchExitHook, args.ptr())))
+      throw py::error_already_set();
+  }
+
+  // Same arguments as `launch`, prefixed with an instantiated graph and one
+  // of its kernel nodes. Instead of launching, updates the parameters of the
+  // node.
+  void setGraphNodeParams(py::args args) {
+    if (args.size() < 2)
+      throw py::type_error("Expected a graph and a node");
+    auto graphExec =
+        reinterpret_cast<CUgraphExec>(asUInt64(PyTuple_GET_ITEM(args.ptr(), 0)));
+    auto node =
+        reinterpret_cast<CUgraphNode>(asUInt64(PyTuple_GET_ITEM(args.ptr(), 1)));
+    LaunchConfig config = parseArgs(args, 2);
+    if (config.numCtas != 1)
+      throw std::runtime_error("Updating graph nodes of kernels launched on "
+                               "clusters is not supported");
+    if (cooperative)
+      throw std::runtime_error("Updating graph nodes of cooperative kernels "
+                               "is not supported");
+    ArgStorage storage;
+    llvm::SmallVector<void *, 16> params;
+    packKernelArgs(args, 2 + kNumConfigArgs, storage, params);
+    CUDA_KERNEL_NODE_PARAMS nodeParams = {};
+    nodeParams.func = config.function;
+    nodeParams.gridDimX = config.gridX;
+    nodeParams.gridDimY = config.gridY;
+    nodeParams.gridDimZ = config.gridZ;
+    nodeParams.blockDimX = 32 * config.numWarps;
+    nodeParams.blockDimY = 1;
+    nodeParams.blockDimZ = 1;
+    nodeParams.sharedMemBytes = config.sharedMemory;
+    nodeParams.kernelParams = params.data();
+    // parameters are copied, so `storage` may go out of scope after this call
+    throwOnError(CudaApi::get().graphExecKernelNodeSetParams(graphExec, node,
+                                                              &nodeParams));
+  }
+
+private:
+  // Every kernel argument is stored in its own 8-byte slot.
+  using ArgStorage = llvm::SmallVector<uint64_t, 16>;
+
+  LaunchConfig parseArgs(const py::args &args, size_t offset) {
+    if (args.size() != offset + kNumConfigArgs + signature.size())
+      throw py::type_error("Expected " +
+                           std::to_string(kNumConfigArgs + signature.size()) +
+                           " launch arguments, got " +
+                           std::to_string(args.size() - offset));
+    return parseConfig(args.ptr(), offset);
+  }
+
+  template <typename T> static uint64_t toSlot(T value) {
+    uint64_t slot = 0;
+    std::memcpy(&slot, &value, sizeof(T));
+    return slot;
+  }
+
+  void packKernelArgs(const py::args &args, size_t offset, ArgStorage &storage,
+                      llvm::SmallVector<void *, 16> &params) {
+    storage.reserve(signature.size());
+    for (size_t i = 0; i < signature.size(); ++i) {
+      PyObject *obj = PyTuple_GET_ITEM(args.ptr(), offset + i);
+      uint64_t slot;
+      switch (signature[i]) {
+      case 'x':
+        continue;
+      case 'p':
+        slot = getPointer(obj, i);
+        break;
+      case 'b':
+        slot = toSlot<int8_t>(static_cast<int8_t>(asInt(obj)));
+        break;
+      case 'B':
+        slot = toSlot<uint8_t>(static_cast<uint8_t>(asUInt64(obj)));
+        break;
+      case 'h':
+        slot = toSlot<int16_t>(static_cast<int16_t>(asInt(obj)));
+        break;
+      case 'H':
+        slot = toSlot<uint16_t>(static_cast<uint16_t>(asUInt64(obj)));
+        break;
+      case 'i':
+        slot = toSlot<int32_t>(asInt(obj));
+        break;
+      case 'I':
+        slot = toSlot<uint32_t>(static_cast<uint32_t>(asUInt64(obj)));
+        break;
+      case 'l': {
+        long long value = PyLong_AsLongLong(obj);
+        if (value == -1 && PyErr_Occurred())
+          throw py::error_already_set();
+        slot = toSlot<int64_t>(value);
+        break;
+      }
+      case 'K':
+        slot = asUInt64(obj);
+        break;
+      case 'f':
+      case 'd': {
+        double value = PyFloat_AsDouble(obj);
+        if (value == -1.0 && PyErr_Occurred())
+          throw py::error_already_set();
+        slot = signature[i] == 'f' ? toSlot<float>(static_cast<float>(value))
+                                   : toSlot<double>(value);
+        break;
+      }
+      default:
+        llvm_unreachable("unexpected launcher signature");
+      }
+      storage.push_back(slot);
+    }
+    // `storage` does not grow anymore, so its addresses are stable
+    for (uint64_t &slot : storage)
+      params.push_back(&slot);
+  }
+
+  CUresult launchKernel(const LaunchConfig &config, void **params) const {
+    if (config.gridX * config.gridY * config.gridZ <= 0)
+      return CUDA_SUCCESS;
+    const CudaApi &api = CudaApi::get();
+    if (config.numCtas == 1 && !cooperative)
+      return api.launchKernel(config.function, config.gridX, config.gridY,
+                              config.gridZ, 32 * config.numWarps, 1, 1,
+                              config.sharedMemory, config.stream, params,
+                              nullptr);
+    CUlaunchAttribute launchAttr[3];
+    unsigned numAttrs = 0;
+    CUlaunchConfig launchConfig;
+    launchConfig.gridDimX = config.gridX;
+    launchConfig.gridDimY = config.gridY;
+    launchConfig.gridDimZ = config.gridZ;
+    if (config.numCtas != 1) {
+      launchAttr[numAttrs].id = CU_LAUNCH_ATTRIBUTE_CLUSTER_DIMENSION;
+      launchAttr[numAttrs].value.clusterDim.x = config.clusterDimX;
+      launchAttr[numAttrs].value.clusterDim.y = config.clusterDimY;
+      launchAttr[numAttrs].value.clusterDim.z = config.clusterDimZ;
+      ++numAttrs;
+      launchAttr[numAttrs].id =
+          CU_LAUNCH_ATTRIBUTE_CLUSTER_SCHEDULING_POLICY_PREFERENCE;
+      launchAttr[numAttrs].value.clusterSchedulingPolicyPreference =
+          CU_CLUSTER_SCHEDULING_POLICY_SPREAD;
+      ++numAttrs;
+      launchConfig.gridDimX *= config.clusterDimX;
+      launchConfig.gridDimY *= config.clusterDimY;
+      launchConfig.gridDimZ *= config.clusterDimZ;
+    }
+    // fails with CUDA_ERROR_COOPERATIVE_LAUNCH_TOO_LARGE rather than
+    // deadlocking when the CTAs can't all be resident at once
+    if (cooperative) {
+      launchAttr[numAttrs].id = CU_LAUNCH_ATTRIBUTE_COOPERATIVE;
+      launchAttr[numAttrs].value.cooperative = 1;
+      ++numAttrs;
+    }
+    launchConfig.blockDimX = 32 * config.numWarps;
+    launchConfig.blockDimY = 1;
+    launchConfig.blockDimZ = 1;
+    launchConfig.sharedMemBytes = config.sharedMemory;
+    launchConfig.hStream = config.stream;
+    launchConfig.attrs = launchAttr;
+    launchConfig.numAttrs = numAttrs;
+    return api.launchKernelEx(&launchConfig, config.function, params, nullptr);
+  }
+
+  std::string signature;
+  bool cooperative;
+};
+
+// The entry point wrapped by `GenericLauncher.launch_capsule`, called by
+// `cuda_utils.launch_batch` with the launcher as `self`.
+PyObject *launchFromCapsule(PyObject *self, PyObject *args) {
+  try {
+    py::handle(self).cast<GenericLauncher &>().launch(
+        py::reinterpret_borrow<py::args>(args));
+  } catch (py::error_already_set &e) {
+    e.restore();
+    return nullptr;
+  } catch (py::builtin_exception &e) {
+    e.set_error();
+    return nullptr;
+  } catch (const std::exception &e) {
+    PyErr_SetString(PyExc_RuntimeError, e.what());
+    return nullptr;
+  }
+  Py_RETURN_NONE;
+}
+
+// The capsule holds a reference to the launcher, released with it.
+void releaseLauncher(PyObject *capsule) {
+  Py_XDECREF(static_cast<PyObject *>(PyCapsule_GetContext(capsule)));
+}
+
+py::object makeLaunchCapsule(py::object launcher) {
+  PyObject *capsule =
+      PyCapsule_New(reinterpret_cast<void *>(launchFromCapsule),
+                    "triton.launch", releaseLauncher);
+  if (!capsule)
+    throw py::error_already_set();
+  PyCapsule_SetContext(capsule, launcher.release().ptr());
+  return py::reinterpret_steal<py::object>(capsule);
+}
+
+} // namespace
+
+void init_triton_nvidia_launcher(py::module &m) {
+  py::class_<GenericLauncher>(m, "GenericLauncher")
+      .def(py::init<std::string, bool>(), py::arg("signature"),
+           py::arg("cooperative") = false)
+      .def("launch", &GenericLauncher::launch)
+      .def("set_graph_node_params", &GenericLauncher::setGraphNodeParams)
+      .def_property_readonly("launch_capsule", &makeLaunchCapsule);
+}
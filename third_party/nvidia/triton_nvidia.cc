@@ -7,6 +7,7 @@
 #include "triton/Dialect/NVGPU/IR/Dialect.h"
 #include "triton/Dialect/TritonNvidiaGPU/IR/Dialect.h"
 #include "triton/Dialect/TritonNvidiaGPU/Transforms/Passes.h"
+#include "triton/Dialect/TritonNvidiaGPU/Transforms/Pipelines.h"
 #include "llvm/IR/Constants.h"
 #include "llvm/Support/TargetSelect.h"
 #include <pybind11/pybind11.h>
@@ -17,24 +18,30 @@ namespace py = pybind11;
 
 PYBIND11_MAKE_OPAQUE(mlir::triton::gpu::TMAMetadataTy);
 
+void init_triton_nvidia_launcher(py::module &m);
+
 void init_triton_nvidia_passes_ttgpuir(py::module &&m) {
   using namespace mlir::triton::gpu;
   ADD_PASS_WRAPPER_1("add_rewrite_tensor_pointer",
                      mlir::createTritonGPURewriteTensorPointerPass, int);
   // TODO: it is weird to pass mlir::triton::NVVM here since the conversion is
   // nvidia-specificontext
-  m.def("add_to_llvmir", [](mlir::PassManager &pm, int32_t capability,
-                            mlir::triton::gpu::TMAMetadataTy *tmaMetadata) {
-    pm.addPass(createConvertTritonGPUToLLVMPass(capability, mlir::triton::NVVM,
-                                                tmaMetadata));
-  });
+  m.def("add_to_llvmir",
+        [](mlir::PassManager &pm, int32_t capability,
+           mlir::triton::gpu::TMAMetadataTy *tmaMetadata, bool fastMath,
+           int32_t rolledLoops) {
+          pm.addPass(createConvertTritonGPUToLLVMPass(
+              capability, mlir::triton::NVVM, tmaMetadata, fastMath,
+              rolledLoops));
+        });
 }
 
 void init_triton_nvidia_passes_ttnvgpuir(py::module &&m) {
   ADD_PASS_WRAPPER_1("add_plan_cta", mlir::createTritonNvidiaGPUPlanCTAPass,
                      mlir::triton::nvidia_gpu::ClusterInfo *);
-  ADD_PASS_WRAPPER_1("add_wsfeasibility_checking",
-                     mlir::createTritonNvidiaGPUWSFeasibilityCheckingPass, int);
+  ADD_PASS_WRAPPER_3("add_wsfeasibility_checking",
+                     mlir::createTritonNvidiaGPUWSFeasibilityCheckingPass, int,
+                     int, bool);
   ADD_PASS_WRAPPER_1("add_wsdecomposing",
                      mlir::createTritonNvidiaGPUWSDecomposingPass, int);
   ADD_PASS_WRAPPER_1("add_wsmutex", mlir::createTritonNvidiaGPUWSMutexPass,
@@ -48,8 +55,11 @@ void init_triton_nvidia_passes_ttnvgpuir(py::module &&m) {
                      int);
   ADD_PASS_WRAPPER_0("add_fence_insertion",
                      mlir::createTritonNvidiaGPUFenceInsertionPass);
-  ADD_PASS_WRAPPER_0("add_nvgpu_to_llvm",
-                     mlir::triton::createConvertNVGPUToLLVMPass);
+  ADD_PASS_WRAPPER_0("add_schedule_cluster_barriers",
+                     mlir::createTritonNvidiaGPUScheduleClusterBarriersPass);
+  ADD_PASS_WRAPPER_2("add_nvgpu_to_llvm",
+                     mlir::triton::createConvertNVGPUToLLVMPass, int32_t,
+                     int32_t);
   ADD_PASS_WRAPPER_3("add_wspipeline",
                      mlir::createTritonNvidiaGPUWSPipelinePass, int, int, int);
 
@@ -57,12 +67,52 @@ void init_triton_nvidia_passes_ttnvgpuir(py::module &&m) {
     return mlir::triton::nvidia_gpu::TritonNvidiaGPUDialect::getWSSupportedAttr(
         mod);
   });
+  m.def("propose_cluster_dims", [](mlir::ModuleOp &mod, unsigned maxNumCTAs) {
+    auto clusterDims =
+        mlir::triton::nvidia_gpu::proposeClusterDims(mod, maxNumCTAs);
+    return std::vector<std::array<unsigned, 3>>(clusterDims.begin(),
+                                                clusterDims.end());
+  });
+}
+
+template <typename Options>
+std::unique_ptr<Options> parsePipelineOptions(const std::string &options) {
+  auto parsed = Options::createFromString(options);
+  if (!parsed)
+    throw std::invalid_argument("invalid pipeline options \"" + options +
+                                "\"");
+  return parsed;
+}
+
+// The pipelines take their options as triton-opt does, so that the options of
+// a compilation can be passed to triton-opt as they are.
+void init_triton_nvidia_passes_pipelines(py::module &m) {
+  using namespace mlir::triton::nvidia_gpu;
+  m.def("add_ttir_pipeline",
+        [](mlir::PassManager &pm, const std::string &options) {
+          buildTTIRPipeline(pm, *parsePipelineOptions<TTIRPipelineOptions>(
+                                    options));
+        });
+  m.def("add_ttgir_layout_pipeline",
+        [](mlir::PassManager &pm, const std::string &options,
+           ClusterInfo *clusterInfo) {
+          buildTTGIRLayoutPipeline(
+              pm, *parsePipelineOptions<TTGIRPipelineOptions>(options),
+              clusterInfo);
+        });
+  m.def("add_ttgir_schedule_pipeline",
+        [](mlir::PassManager &pm, const std::string &options) {
+          buildTTGIRSchedulePipeline(
+              pm, *parsePipelineOptions<TTGIRPipelineOptions>(options));
+        });
 }
 
 void init_triton_nvidia(py::module &&m){
   auto passes = m.def_submodule("passes");
   init_triton_nvidia_passes_ttgpuir(passes.def_submodule("ttgpuir"));
   init_triton_nvidia_passes_ttnvgpuir(passes.def_submodule("ttnvgpuir"));
+  init_triton_nvidia_passes_pipelines(passes);
+  init_triton_nvidia_launcher(m);
 
   // cluster info
   py::class_<mlir::triton::nvidia_gpu::ClusterInfo>(m, "ClusterInfo")
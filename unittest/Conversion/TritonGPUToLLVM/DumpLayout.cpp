@@ -37,6 +37,8 @@ namespace {
 
 class IndexEmitter {
 public:
+  using IndexCacheInfo = ConvertTritonGPUOpToLLVMPatternBase::IndexCacheInfo;
+
   struct Cache {
     llvm::DenseMap<IndexCacheKeyT, llvm::SmallVector<Value>,
                    CacheKeyDenseMapInfo>
@@ -44,26 +46,31 @@ public:
     llvm::DenseMap<IndexCacheKeyT, llvm::SmallVector<llvm::SmallVector<Value>>,
                    CacheKeyDenseMapInfo>
         indexCache;
-    OpBuilder::InsertPoint indexInsertPoint;
+    llvm::DenseMap<Operation *, OpBuilder::InsertPoint> indexInsertPoints;
   };
 
-  IndexEmitter(MLIRContext *context_)
+  IndexEmitter(MLIRContext *context_, bool useCache = true)
       : context(context_), option(context), typeConverter(context, option),
-        cacheInfo({&cache.baseIndexCache, &cache.indexCache,
-                   &cache.indexInsertPoint}),
+        cacheInfo(useCache ? IndexCacheInfo{&cache.baseIndexCache,
+                                            &cache.indexCache,
+                                            &cache.indexInsertPoints}
+                           : IndexCacheInfo{}),
         base(typeConverter, cacheInfo), rewriter(context),
         loc(UnknownLoc::get(context)) {
     rewriter.setInsertionPointToStart(&block);
-    cache.indexInsertPoint = rewriter.saveInsertionPoint();
+    // The block has no function, the indices are cached at its start
+    cache.indexInsertPoints[nullptr] = rewriter.saveInsertionPoint();
   }
 
   llvm::SmallVector<llvm::SmallVector<Value>>
-  emitIndices(Attribute layout, llvm::ArrayRef<int64_t> shape,
+  emitIndices(Attribute layout, llvm::ArrayRef<int64_t> shape, Type elemTy,
               bool withCTAOffset) {
-    auto type = RankedTensorType::get(shape, rewriter.getF16Type(), layout);
+    auto type = RankedTensorType::get(shape, elemTy, layout);
     return base.emitIndices(loc, rewriter, layout, type, withCTAOffset);
   }
 
+  unsigned getNumEmittedOps() { return block.getOperations().size(); }
+
   llvm::DenseMap<unsigned, Value>
   emitDistributedToShared(Attribute srcLayout, SharedEncodingAttr sharedLayout,
                           Type elemTy, llvm::ArrayRef<int64_t> shape,
@@ -91,7 +98,7 @@ private:
   LowerToLLVMOptions option;
   TritonGPUToLLVMTypeConverter typeConverter;
   Cache cache;
-  ConvertTritonGPUOpToLLVMPatternBase::IndexCacheInfo cacheInfo;
+  IndexCacheInfo cacheInfo;
   ConvertTritonGPUOpToLLVMPatternBase base;
   Block block;
   ConversionPatternRewriter rewriter;
@@ -206,7 +213,7 @@ std::string dumpDistributedLayout(Attribute layout,
     assert(numCTAs == 1 && "numCTAs must be 1 when multiCTA is false");
 
   IndexEmitter emitter(layout.getContext());
-  auto indices = emitter.emitIndices(layout, shape, multiCTA);
+  auto indices = emitter.emitIndices(layout, shape, f16Ty, multiCTA);
   assert(indices.size() == numElems && "Incorrect number of indices emitted");
 
   auto genStr = [multiCTA](int ctaid, int tid, int idx) -> std::string {
@@ -318,7 +325,8 @@ std::string dumpSharedLayout(Attribute layout, llvm::ArrayRef<int64_t> shape,
   int numElems = getTotalElemsPerThread(blockedLayout, shape, elemTy);
 
   IndexEmitter emitter(layout.getContext());
-  auto blockedIndices = emitter.emitIndices(blockedLayout, shape, multiCTA);
+  auto blockedIndices =
+      emitter.emitIndices(blockedLayout, shape, elemTy, multiCTA);
   auto sharedPtrs = emitter.emitDistributedToShared(blockedLayout, sharedLayout,
                                                     elemTy, shape, multiCTA);
 
@@ -378,6 +386,18 @@ std::string dumpSharedLayout(Attribute layout, llvm::ArrayRef<int64_t> shape,
   return oss.str();
 }
 
+//===----------------------------------------------------------------------===//
+// Count Index Ops
+//===----------------------------------------------------------------------===//
+
+unsigned countIndexOps(Attribute layout, llvm::ArrayRef<int64_t> shape,
+                       llvm::ArrayRef<Type> elemTys, bool useCache) {
+  IndexEmitter emitter(layout.getContext(), useCache);
+  for (Type elemTy : elemTys)
+    emitter.emitIndices(layout, shape, elemTy, /*withCTAOffset=*/false);
+  return emitter.getNumEmittedOps();
+}
+
 } // namespace gpu
 } // namespace triton
 } // namespace mlir
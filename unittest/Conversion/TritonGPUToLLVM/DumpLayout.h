@@ -36,6 +36,11 @@ std::string dumpDistributedLayout(Attribute layout,
 std::string dumpSharedLayout(Attribute layout, llvm::ArrayRef<int64_t> shape,
                              Type elemTy, bool multiCTA);
 
+// Returns the number of ops emitted for the indices of a tensor of each of
+// `elemTys`, with or without the index cache
+unsigned countIndexOps(Attribute layout, llvm::ArrayRef<int64_t> shape,
+                       llvm::ArrayRef<Type> elemTys, bool useCache);
+
 } // namespace gpu
 } // namespace triton
 } // namespace mlir
@@ -592,6 +592,38 @@ TEST_F(EmitIndicesTest, SharedLayout) {
                      /*elemTyStr=*/"F16", /*refStr=*/refStr);
 }
 
+//===----------------------------------------------------------------------===//
+// Tests for the index cache
+//===----------------------------------------------------------------------===//
+
+TEST_F(EmitIndicesTest, IndexCache_IRSize) {
+  // The tensors of the same layout and shape share their indices whatever
+  // their element type
+  llvm::SmallVector<unsigned> sizePerThread = {4, 4};
+  llvm::SmallVector<unsigned> threadsPerWarp = {4, 8};
+  llvm::SmallVector<unsigned> warpsPerCTA = {4, 1};
+  llvm::SmallVector<unsigned> order = {1, 0};
+  auto layout =
+      BlockedEncodingAttr::get(&context, sizePerThread, threadsPerWarp,
+                               warpsPerCTA, order, getSingleCTALayout2d());
+  llvm::SmallVector<int64_t> shape = {/*row=*/128, /*col=*/128};
+  llvm::SmallVector<Type> elemTys = {FloatType::getF16(&context),
+                                     FloatType::getF32(&context),
+                                     IntegerType::get(&context, 32)};
+
+  unsigned numOpsOnce = countIndexOps(layout, shape, elemTys[0],
+                                      /*useCache=*/true);
+  unsigned numOpsCached = countIndexOps(layout, shape, elemTys,
+                                        /*useCache=*/true);
+  unsigned numOpsUncached = countIndexOps(layout, shape, elemTys,
+                                          /*useCache=*/false);
+  llvm::outs() << "index ops of " << elemTys.size()
+               << " tensors: " << numOpsCached << " cached, "
+               << numOpsUncached << " uncached\n";
+  ASSERT_EQ(numOpsCached, numOpsOnce);
+  ASSERT_EQ(numOpsUncached, elemTys.size() * numOpsOnce);
+}
+
 //===----------------------------------------------------------------------===//
 // The following unittests are tools for Triton developers to visualize layouts.
 // You can modify parameters and shapes here to create your own layout and
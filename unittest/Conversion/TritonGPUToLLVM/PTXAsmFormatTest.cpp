@@ -122,6 +122,26 @@ TEST_F(PTXAsmFormatTest, MultiLinePTX) {
   EXPECT_EQ(values[1], v[2]); // $1 -> v[2]
 }
 
+TEST_F(PTXAsmFormatTest, repeatedInstruction) {
+  PTXBuilder builder;
+
+  auto *dst = builder.newOperand("=r");
+  auto *src = builder.newOperand(v[1], "r");
+  auto *tied = builder.newOperand(0u);
+
+  auto &add = builder.create("add")->o("s32");
+  add(dst, src, tied);
+  add(dst, dst, src);
+  EXPECT_EQ(builder.dump(), "add.s32 $0, $1, $2;\n\t"
+                            "add.s32 $0, $0, $1;");
+
+  // A suffix added later applies to all the executions.
+  add.o("sat");
+  EXPECT_EQ(builder.dump(), "add.s32.sat $0, $1, $2;\n\t"
+                            "add.s32.sat $0, $0, $1;");
+  EXPECT_EQ(builder.getConstraints(), "=r,r,0");
+}
+
 TEST_F(PTXAsmFormatTest, onlyAttachMLIRArgs) {
   PTXBuilder builder;
   const char *ptxCode =
@@ -0,0 +1,157 @@
+#include "triton/Dialect/TritonGPU/IR/LinearLayoutConversions.h"
+#include "triton/Dialect/TritonGPU/IR/Dialect.h"
+#include <gtest/gtest.h>
+
+using namespace mlir;
+using mlir::triton::LinearLayout;
+using InDim = mlir::triton::LinearLayout::InDim;
+using BasesT = mlir::triton::LinearLayout::BasesT;
+
+class LinearLayoutConversionsTest : public ::testing::Test {
+public:
+  void SetUp() { ctx.loadDialect<triton::gpu::TritonGPUDialect>(); }
+
+protected:
+  triton::gpu::CTALayoutAttr getCTALayout(unsigned rank) {
+    SmallVector<unsigned> ones(rank, 1);
+    SmallVector<unsigned> order;
+    for (unsigned d = rank; d > 0; --d)
+      order.push_back(d - 1);
+    return triton::gpu::CTALayoutAttr::get(&ctx, ones, ones, order);
+  }
+
+  Attribute blocked(ArrayRef<unsigned> sizePerThread,
+                    ArrayRef<unsigned> threadsPerWarp,
+                    ArrayRef<unsigned> warpsPerCTA, ArrayRef<unsigned> order) {
+    return triton::gpu::BlockedEncodingAttr::get(
+        &ctx, sizePerThread, threadsPerWarp, warpsPerCTA, order,
+        getCTALayout(order.size()));
+  }
+
+  Attribute mma(unsigned versionMajor, ArrayRef<unsigned> warpsPerCTA) {
+    return triton::gpu::NvidiaMmaEncodingAttr::get(
+        &ctx, versionMajor, 0, warpsPerCTA, getCTALayout(2), {16, 8});
+  }
+
+  Attribute slice(unsigned dim, Attribute parent) {
+    return triton::gpu::SliceEncodingAttr::get(&ctx, dim, parent);
+  }
+
+  RankedTensorType tensor(ArrayRef<int64_t> shape, Attribute layout) {
+    return RankedTensorType::get(shape, FloatType::getF32(&ctx), layout);
+  }
+
+  std::optional<triton::WarpLocalConversion>
+  convert(RankedTensorType srcTy, RankedTensorType dstTy) {
+    auto src = triton::gpu::toLinearLayout(srcTy);
+    auto dst = triton::gpu::toLinearLayout(dstTy);
+    if (!src || !dst)
+      return std::nullopt;
+    return triton::getWarpLocalConversion(*src, *dst);
+  }
+
+  MLIRContext ctx;
+};
+
+TEST_F(LinearLayoutConversionsTest, Blocked) {
+  auto layout = triton::gpu::toLinearLayout(
+      tensor({16, 32}, blocked({1, 4}, {4, 8}, {1, 1}, {1, 0})));
+  ASSERT_TRUE(layout.has_value());
+  EXPECT_EQ(layout->getBases(InDim::Register),
+            (BasesT{{0, 1}, {0, 2}, {4, 0}, {8, 0}}));
+  EXPECT_EQ(layout->getBases(InDim::Lane),
+            (BasesT{{0, 4}, {0, 8}, {0, 16}, {1, 0}, {2, 0}}));
+  EXPECT_TRUE(layout->getBases(InDim::Warp).empty());
+  EXPECT_EQ(layout->apply(5, 9, 0), (LinearLayout::BasisT{5, 5}));
+}
+
+TEST_F(LinearLayoutConversionsTest, BlockedBroadcast) {
+  // The lanes and warps past the shape hold the same elements
+  auto layout = triton::gpu::toLinearLayout(
+      tensor({64}, blocked({4}, {32}, {2}, {0})));
+  ASSERT_TRUE(layout.has_value());
+  EXPECT_EQ(layout->getBases(InDim::Register), (BasesT{{1}, {2}}));
+  EXPECT_EQ(layout->getBases(InDim::Lane),
+            (BasesT{{4}, {8}, {16}, {32}, {0}}));
+  EXPECT_EQ(layout->getBases(InDim::Warp), (BasesT{{0}}));
+}
+
+TEST_F(LinearLayoutConversionsTest, MmaV2) {
+  auto layout = triton::gpu::toLinearLayout(tensor({32, 16}, mma(2, {2, 1})));
+  ASSERT_TRUE(layout.has_value());
+  EXPECT_EQ(layout->getBases(InDim::Register),
+            (BasesT{{0, 1}, {8, 0}, {0, 8}}));
+  EXPECT_EQ(layout->getBases(InDim::Lane),
+            (BasesT{{0, 2}, {0, 4}, {1, 0}, {2, 0}, {4, 0}}));
+  EXPECT_EQ(layout->getBases(InDim::Warp), (BasesT{{16, 0}}));
+}
+
+TEST_F(LinearLayoutConversionsTest, Slice) {
+  auto parent = blocked({1, 4}, {4, 8}, {1, 1}, {1, 0});
+  auto layout = triton::gpu::toLinearLayout(tensor({32}, slice(0, parent)));
+  ASSERT_TRUE(layout.has_value());
+  EXPECT_EQ(layout->getBases(InDim::Register), (BasesT{{1}, {2}}));
+  EXPECT_EQ(layout->getBases(InDim::Lane),
+            (BasesT{{4}, {8}, {16}, {0}, {0}}));
+}
+
+TEST_F(LinearLayoutConversionsTest, Unsupported) {
+  EXPECT_FALSE(triton::gpu::toLinearLayout(tensor({16, 16}, mma(1, {1, 1}))));
+}
+
+TEST_F(LinearLayoutConversionsTest, Noop) {
+  auto type = tensor({16, 32}, blocked({1, 4}, {4, 8}, {4, 1}, {1, 0}));
+  auto cvt = convert(type, type);
+  ASSERT_TRUE(cvt.has_value());
+  EXPECT_TRUE(cvt->isNoop());
+}
+
+TEST_F(LinearLayoutConversionsTest, RegisterPermutation) {
+  // Both layouts give the same elements to each lane, in a different order
+  auto srcTy = tensor({64, 2}, blocked({2, 2}, {32, 1}, {1, 1}, {1, 0}));
+  auto dstTy = tensor({64, 2}, blocked({2, 2}, {32, 1}, {1, 1}, {0, 1}));
+  auto cvt = convert(srcTy, dstTy);
+  ASSERT_TRUE(cvt.has_value());
+  EXPECT_TRUE(cvt->isRegisterPermutation());
+  EXPECT_FALSE(cvt->isNoop());
+  EXPECT_EQ(cvt->srcRegisters, (SmallVector<unsigned>{0, 2, 1, 3}));
+}
+
+TEST_F(LinearLayoutConversionsTest, Shuffle) {
+  auto srcTy = tensor({32}, blocked({1}, {32}, {1}, {0}));
+  auto dstTy = tensor({32}, blocked({4}, {32}, {1}, {0}));
+  auto cvt = convert(srcTy, dstTy);
+  ASSERT_TRUE(cvt.has_value());
+  EXPECT_FALSE(cvt->isRegisterPermutation());
+  EXPECT_EQ(cvt->srcRegisters, (SmallVector<unsigned>{0, 0, 0, 0}));
+  EXPECT_EQ(cvt->srcLanes, (SmallVector<unsigned>{0, 1, 2, 3}));
+  EXPECT_EQ(cvt->laneBases, (SmallVector<unsigned>{4, 8, 16, 0, 0}));
+}
+
+TEST_F(LinearLayoutConversionsTest, AcrossWarps) {
+  auto srcTy = tensor({128}, blocked({1}, {32}, {4}, {0}));
+  auto dstTy = tensor({128}, blocked({4}, {32}, {4}, {0}));
+  EXPECT_FALSE(convert(srcTy, dstTy).has_value());
+}
+
+TEST_F(LinearLayoutConversionsTest, ReshapeRename) {
+  auto srcTy = tensor({16, 32}, blocked({1, 4}, {4, 8}, {1, 1}, {1, 0}));
+  EXPECT_TRUE(triton::gpu::isReshapeRename(
+      srcTy, tensor({32, 16}, blocked({1, 4}, {8, 4}, {1, 1}, {1, 0}))));
+  EXPECT_FALSE(triton::gpu::isReshapeRename(
+      srcTy, tensor({512}, blocked({1}, {32}, {1}, {0}))));
+}
+
+TEST_F(LinearLayoutConversionsTest, InferReshapeRenameEncoding) {
+  auto srcTy = tensor({16, 32}, blocked({1, 4}, {4, 8}, {1, 1}, {1, 0}));
+  auto flat = triton::gpu::inferReshapeRenameEncoding(srcTy, {512});
+  ASSERT_TRUE(flat.has_value());
+  EXPECT_EQ(*flat, blocked({4}, {32}, {1}, {0}));
+  auto back =
+      triton::gpu::inferReshapeRenameEncoding(tensor({512}, *flat), {16, 32});
+  ASSERT_TRUE(back.has_value());
+  EXPECT_EQ(*back, srcTy.getEncoding());
+  // The elements of a column-major layout aren't contiguous once flattened
+  auto colTy = tensor({32, 32}, blocked({4, 1}, {8, 4}, {1, 1}, {0, 1}));
+  EXPECT_FALSE(triton::gpu::inferReshapeRenameEncoding(colTy, {1024}));
+}